@@ -0,0 +1,23 @@
+#!/usr/bin/env bash
+
+# Lists ASSERT/ASSERTM (and their _CHEAP/_PARANOID tiers) whose condition calls
+# I/O or system functions or updates a variable. Those tiers are compiled out
+# below their ASSERT_LEVEL, taking the side effect with them; hoist the work
+# out of the assert or use ASSERTU/ASSERTUM. Exits nonzero if any are found.
+
+SCARAB_PATH="$(realpath $(dirname "${0}")/..)"
+
+CALLS='fread|fwrite|fopen|fclose|fgets|fscanf|fseek|read|write|pread|pwrite|open|close|rename|unlink|ftruncate|mmap|munmap|mkdir|system|attach|frontend_[a-z_]+|sched_[a-z_]+|pthread_[a-z_]+|[a-z_]*alloc|posix_memalign'
+PATTERN="\bASSERTM?(_CHEAP|_PARANOID)?\([^;]*(\b($CALLS)\(|\+\+|--[A-Za-z_]|[^=!<>+*/-]=[^=]|[+*/-]=)"
+
+found=0
+for src_file in `find $SCARAB_PATH/src -regextype posix-extended -regex "$SCARAB_PATH/src/(deps|ramulator|build)" -prune -o \( -name '*.c' -o -name '*.cpp' -o -name '*.cc' -o -name '*.h' \) -print`; do
+  [ "$src_file" = "$SCARAB_PATH/src/globals/assert.h" ] && continue
+  # string literals (the messages) are blanked so their '=' do not match
+  matches=$(sed 's/"\([^"\\]\|\\.\)*"/""/g' $src_file | grep -nE "$PATTERN")
+  if [ -n "$matches" ]; then
+    echo "$matches" | sed "s|^|$src_file:|"
+    found=1
+  fi
+done
+exit $found
@@ -0,0 +1,167 @@
+#  Copyright 2020 HPS/SAFARI Research Groups
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy of
+#  this software and associated documentation files (the "Software"), to deal in
+#  the Software without restriction, including without limitation the rights to
+#  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+#  of the Software, and to permit persons to whom the Software is furnished to do
+#  so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all
+#  copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+
+"""Converts the binary pipeview stream of a core (--pipeview 1 --pipeview_bin 1,
+documented at the top of src/debug/pipeview.c) into other formats:
+
+  python3 pipeview_convert.py pipeview.0.bin[.gz] [-f text|konata|o3] [-o out]
+
+  text    the text Scarab writes without --pipeview_bin (default)
+  konata  a Kanata 0004 log for the Konata pipeline viewer
+  o3      gem5 O3PipeView, for gem5's util/o3-pipeview.py (1000 ticks per cycle)
+"""
+
+import sys
+import gzip
+import struct
+import argparse
+
+PIPEVIEW_BIN_MAGIC = b"SCRBPIPE"
+PIPEVIEW_BIN_VERSION = 1
+PIPEVIEW_BIN_DISASM = 0
+PIPEVIEW_BIN_OP = 1
+PIPEVIEW_BIN_OFF_PATH = 0x1
+PIPEVIEW_BIN_NO_EVENT = 0xffffffff
+PIPEVIEW_BIN_MEM_MARKER = "\x01"
+
+# Must match Pipeview_Event in src/debug/pipeview.c
+EVENT_NAMES = ["fetch", "decode", "decode_done", "map", "map_done", "issue", "issue_done", "ready", "sched", "exec",
+               "dcache", "done", "retire", "end"]
+FETCH, DECODE, DECODE_DONE, MAP, MAP_DONE, ISSUE, ISSUE_DONE, READY, SCHED, EXEC, DCACHE, DONE, RETIRE, END = \
+  range(len(EVENT_NAMES))
+
+OP_FORMAT = "=QQQIIIB{}I".format(len(EVENT_NAMES))
+OP_SIZE = struct.calcsize(OP_FORMAT)
+O3_TICKS_PER_CYCLE = 1000
+
+# Konata stages and the event that starts each; a stage ends where the next
+# one that happened starts
+KONATA_STAGES = [(FETCH, "F"), (DECODE, "Dc"), (MAP, "Mp"), (ISSUE, "Is"), (SCHED, "Sc"), (EXEC, "X"),
+                 (DCACHE, "Mem"), (DONE, "Cm")]
+
+class PipeviewOp:
+  """One freed op. cycles[event] is the absolute cycle, or None if the event
+     is not printed."""
+  def __init__(self, values, disasms):
+    self.op_num, self.addr, self.fetch_cycle, disasm_id, self.mem_size, self.mem_va, self.flags = values[:7]
+    self.off_path = bool(self.flags & PIPEVIEW_BIN_OFF_PATH)
+    self.cycles = [None if delta == PIPEVIEW_BIN_NO_EVENT else self.fetch_cycle + delta for delta in values[7:]]
+    mem = " {}@{:08x}".format(self.mem_size, self.mem_va) if self.mem_size > 0 else ""
+    self.disasm = disasms[disasm_id].replace(PIPEVIEW_BIN_MEM_MARKER, mem)
+
+  def event_name(self, event):
+    if self.off_path and event == FETCH:
+      return "fetch_offpath"
+    if self.off_path and event == RETIRE:
+      return "flush"
+    return EVENT_NAMES[event]
+
+def read_ops(path):
+  """Yields the PipeviewOps of a stream in the order Scarab freed them. A
+     truncated final record (e.g. from a killed run) is ignored."""
+  opener = gzip.open if path.endswith(".gz") else open
+  with opener(path, "rb") as fp:
+    assert fp.read(len(PIPEVIEW_BIN_MAGIC)) == PIPEVIEW_BIN_MAGIC, "{} is not a Scarab pipeview stream".format(path)
+    version, proc_id = struct.unpack("=II", fp.read(8))
+    assert version == PIPEVIEW_BIN_VERSION, "Unsupported pipeview stream version {}".format(version)
+    disasms = {}
+    while True:
+      kind = fp.read(1)
+      if not kind:
+        return
+      if kind[0] == PIPEVIEW_BIN_DISASM:
+        head = fp.read(6)
+        if len(head) < 6:
+          return
+        disasm_id, length = struct.unpack("=IH", head)
+        disasms[disasm_id] = fp.read(length).decode()
+      else:
+        assert kind[0] == PIPEVIEW_BIN_OP, "Unknown pipeview record kind {}".format(kind[0])
+        buf = fp.read(OP_SIZE)
+        if len(buf) < OP_SIZE:
+          return
+        yield PipeviewOp(struct.unpack(OP_FORMAT, buf), disasms)
+
+def write_text(ops, out):
+  for op in ops:
+    out.write("O3PipeView:new:{}:{:x}:0:{}:{}\n".format(op.fetch_cycle, op.addr, op.op_num, op.disasm))
+    for event, cycle in enumerate(op.cycles):
+      if cycle is not None:
+        out.write("O3PipeView:{}:{}\n".format(op.event_name(event), cycle))
+
+def write_o3(ops, out):
+  def tick(cycle):
+    return cycle * O3_TICKS_PER_CYCLE if cycle is not None else 0
+
+  for op in ops:
+    c = op.cycles
+    out.write("O3PipeView:fetch:{}:0x{:08x}:0:{}:{}\n".format(tick(c[FETCH]), op.addr, op.op_num, op.disasm))
+    out.write("O3PipeView:decode:{}\n".format(tick(c[DECODE])))
+    out.write("O3PipeView:rename:{}\n".format(tick(c[MAP])))
+    out.write("O3PipeView:dispatch:{}\n".format(tick(c[ISSUE])))
+    out.write("O3PipeView:issue:{}\n".format(tick(c[SCHED])))
+    out.write("O3PipeView:complete:{}\n".format(tick(c[DONE])))
+    out.write("O3PipeView:retire:{}:store:0\n".format(0 if op.off_path else tick(c[RETIRE])))
+
+def write_konata(ops, out):
+  # Konata wants commands in cycle order, but ops are freed at retire/flush
+  commands = []
+  retire_id = 0
+  for file_id, op in enumerate(ops):
+    seq = len(commands)
+    commands.append((op.fetch_cycle, seq, "I\t{}\t{}\t0".format(file_id, op.op_num)))
+    commands.append((op.fetch_cycle, seq + 1, "L\t{}\t0\t{:x}: {}".format(file_id, op.addr, op.disasm)))
+    stages = [(op.cycles[event], name) for event, name in KONATA_STAGES if op.cycles[event] is not None]
+    for ii, (cycle, name) in enumerate(stages):
+      commands.append((cycle, seq + 2 + 2 * ii, "S\t{}\t0\t{}".format(file_id, name)))
+      end = stages[ii + 1][0] if ii + 1 < len(stages) else op.cycles[END]
+      commands.append((end, seq + 3 + 2 * ii, "E\t{}\t0\t{}".format(file_id, name)))
+    end = op.cycles[END]
+    commands.append((end, seq + 2 + 2 * len(stages), "R\t{}\t{}\t{}".format(file_id, retire_id, int(op.off_path))))
+    if not op.off_path:
+      retire_id += 1
+
+  commands.sort()
+  out.write("Kanata\t0004\n")
+  cycle = None
+  for command_cycle, _, line in commands:
+    if cycle is None:
+      out.write("C=\t{}\n".format(command_cycle))
+    elif command_cycle != cycle:
+      out.write("C\t{}\n".format(command_cycle - cycle))
+    cycle = command_cycle
+    out.write(line + "\n")
+
+WRITERS = {"text": write_text, "konata": write_konata, "o3": write_o3}
+
+def __main():
+  parser = argparse.ArgumentParser(description="Convert a Scarab binary pipeview stream.")
+  parser.add_argument('pipeview_bin', help="Stream written with --pipeview 1 --pipeview_bin 1.")
+  parser.add_argument('-f', '--format', choices=sorted(WRITERS), default="text", help="Output format.")
+  parser.add_argument('-o', '--output', default=None, help="Output file (default: stdout).")
+  args = parser.parse_args()
+
+  out = open(args.output, "w") if args.output else sys.stdout
+  WRITERS[args.format](read_ops(args.pipeview_bin), out)
+  if args.output:
+    out.close()
+
+if __name__ == "__main__":
+  __main()
@@ -0,0 +1,89 @@
+#  Copyright 2020 HPS/SAFARI Research Groups
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy of
+#  this software and associated documentation files (the "Software"), to deal in
+#  the Software without restriction, including without limitation the rights to
+#  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+#  of the Software, and to permit persons to whom the Software is furnished to do
+#  so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all
+#  copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+
+"""Converts a binary Ramulator command trace (--ramulator_record_cmd_trace on
+--ramulator_cmd_trace_format binary, documented at the top of
+src/ramulator/CmdTrace.h) into the DRAMPower 3.1 text format that the text
+trace format writes directly:
+
+  python3 ramulator_cmdtrace_convert.py cmd-trace-chan-0-rank-0.cmdtrace.bin[.gz] [-o out]
+
+Without -o, the text goes next to the input with the .bin[.gz] suffix dropped.
+"""
+
+import sys
+import gzip
+import struct
+import argparse
+
+CMD_TRACE_MAGIC = b"RAMCMDTR"
+CMD_TRACE_VERSION = 1
+RECORD_FORMAT = "=qii"
+RECORD_SIZE = struct.calcsize(RECORD_FORMAT)
+RECORDS_PER_READ = 1 << 16
+
+def read_commands(path):
+  """Yields (clk, name, bank) per command, bank is None for rank commands. A
+     truncated final record (e.g. from a killed run) is ignored."""
+  opener = gzip.open if path.endswith(".gz") else open
+  with opener(path, "rb") as fp:
+    assert fp.read(len(CMD_TRACE_MAGIC)) == CMD_TRACE_MAGIC, "{} is not a Ramulator command trace".format(path)
+    version, num_names = struct.unpack("=II", fp.read(8))
+    assert version == CMD_TRACE_VERSION, "Unsupported command trace version {}".format(version)
+    names = []
+    for _ in range(num_names):
+      length = fp.read(1)[0]
+      names.append(fp.read(length).decode())
+    while True:
+      buf = fp.read(RECORD_SIZE * RECORDS_PER_READ)
+      usable = len(buf) - len(buf) % RECORD_SIZE
+      for clk, cmd, bank in struct.iter_unpack(RECORD_FORMAT, buf[:usable]):
+        yield clk, names[cmd], None if bank < 0 else bank
+      if len(buf) < RECORD_SIZE * RECORDS_PER_READ:
+        return
+
+def write_text(commands, out):
+  for clk, name, bank in commands:
+    if bank is None:
+      out.write("{},{}\n".format(clk, name))
+    else:
+      out.write("{},{},{}\n".format(clk, name, bank))
+
+def __main():
+  parser = argparse.ArgumentParser(description="Convert a binary Ramulator command trace to DRAMPower text.")
+  parser.add_argument('cmd_trace_bin', help="Trace written with --ramulator_cmd_trace_format binary.")
+  parser.add_argument('-o', '--output', default=None, help="Output file ('-' for stdout).")
+  args = parser.parse_args()
+
+  output = args.output
+  if output is None:
+    output = args.cmd_trace_bin
+    for suffix in (".gz", ".bin"):
+      if output.endswith(suffix):
+        output = output[:-len(suffix)]
+    assert output != args.cmd_trace_bin, "Cannot derive an output name from {}, use -o".format(args.cmd_trace_bin)
+
+  out = sys.stdout if output == "-" else open(output, "w")
+  write_text(read_commands(args.cmd_trace_bin), out)
+  if out is not sys.stdout:
+    out.close()
+
+if __name__ == "__main__":
+  __main()
@@ -45,6 +45,7 @@ parser.add_argument('--base', default=None, help="Normalize all runs to this run
 parser.add_argument('--improvement', action='store_true', help="Use the improvement formula instead of speedup.")
 parser.add_argument('--amean', action='store_true', help="Print the arithmetic mean.")
 parser.add_argument('--gmean', action='store_true', help="Print the geometric mean.")
+parser.add_argument('--no_stat_index', action='store_true', help="Parse the stat files instead of the cached per-run stats index.")
 #parser.add_argument('--flat', action='store_true', help="Print all checkpoints equally.")
 args = parser.parse_args()
 
@@ -62,6 +63,8 @@ if args.gmean and not args.stat:
   print("Usage: --gmean is only valid with --stat option.")
 if args.export_stat_csv and not args.stat:
   print("Usage: --export_stat_csv is only valid with --stat option.")
+if args.no_stat_index and not args.stat:
+  print("Usage: --no_stat_index is only valid with --stat option.")
 
 
 ###############################################
@@ -89,6 +92,8 @@ def get_stats(stat_name, cores, results_dirs, base=None):
   if not cores:
     cores = [0]
 
+  scarab_stats.use_stat_index = not args.no_stat_index
+
   if not results_dirs:
     job_stat = scarab_run_manager.get_stats(flat=False)
   else:
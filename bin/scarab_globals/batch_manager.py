@@ -44,6 +44,9 @@ Interface:
 Types of BatchManagers:
   BatchManager: This will run jobs on locally on your machine. By default, BatchManager will greedily launch one job per core
           on your local system. Although this can be configured (see the constructor for BatchManager).
+  AffinityBatchManager: This will run jobs locally like BatchManager, but pins every simulation to its own pair of
+          sibling hardware threads (Scarab on one, PIN on the other) within one NUMA node, only admits a job once its
+          expected memory fits, skips jobs that already succeeded, and retries failed jobs.
   PBSBatchManager: This will launch jobs on a PBS system. All jobs will be launched at once, however the dependencies between
           jobs will be conveyed to PBS. See the constructor for PBSJobManager for more details.
   SBATCHJobManager: Coming Soon!
@@ -56,11 +59,15 @@ import multiprocessing
 import time
 from enum import Enum
 import shlex
+import glob
+import re
+import shutil
 
 sys.path.append(os.path.dirname((__file__)))
 from scarab_batch_types import *
 from command import *
 import object_manager
+import progress
 
 class JobDefaults:
   """A set of constant default values that BatchManager will use if no override is provided.
@@ -173,6 +180,228 @@ class BatchManager:
       with multiprocessing.Pool(self.processor_cores_per_node) as pool:
         pool.map(BatchManager.run_command, command_list)
 
+def parse_memory_size(size):
+  """Converts a size such as 4gb, 512MB or 1048576 to bytes."""
+  if size is None:
+    return None
+  if isinstance(size, (int, float)):
+    return int(size)
+  m = re.fullmatch(r"\s*([0-9.]+)\s*([kmgt]?)i?b?\s*", size.lower())
+  assert m, "Error: Cannot parse memory size: {}".format(size)
+  scale = {"": 1, "k": 1 << 10, "m": 1 << 20, "g": 1 << 30, "t": 1 << 40}[m.group(2)]
+  return int(float(m.group(1)) * scale)
+
+def parse_cpu_list(cpu_list):
+  """Converts a sysfs cpu list such as 0-3,8 to a list of ints."""
+  cpus = []
+  for item in cpu_list.strip().split(','):
+    if '-' in item:
+      first, last = item.split('-')
+      cpus += range(int(first), int(last) + 1)
+    elif item:
+      cpus.append(int(item))
+  return cpus
+
+class HostTopology:
+  """Hardware threads of the local machine, grouped into NUMA nodes and sibling pairs."""
+  def __init__(self):
+    online = set(os.sched_getaffinity(0))
+    self.nodes = {}
+    for node_dir in glob.glob("/sys/devices/system/node/node[0-9]*"):
+      with open(os.path.join(node_dir, "cpulist")) as f:
+        cpus = [cpu for cpu in parse_cpu_list(f.read()) if cpu in online]
+      if cpus:
+        self.nodes[int(os.path.basename(node_dir)[4:])] = cpus
+    if not self.nodes:
+      self.nodes = {None: sorted(online)}
+
+  @staticmethod
+  def _siblings(cpu):
+    path = "/sys/devices/system/cpu/cpu{}/topology/thread_siblings_list".format(cpu)
+    if not os.path.exists(path):
+      return [cpu]
+    with open(path) as f:
+      return parse_cpu_list(f.read())
+
+  def slots(self):
+    """
+    Returns (numa_node, scarab_cpu, pin_cpu) slots. Scarab and PIN share a physical
+    core when SMT is available, otherwise they get two cores of the same node. A
+    leftover CPU of a node becomes a slot on its own.
+    """
+    slots = []
+    for node, cpus in sorted(self.nodes.items(), key=lambda x: (x[0] is None, x[0])):
+      free = list(cpus)
+      while len(free) >= 2:
+        cpu = free.pop(0)
+        siblings = [sib for sib in self._siblings(cpu) if sib in free]
+        pair = siblings[0] if siblings else free[0]
+        free.remove(pair)
+        slots.append((node, cpu, pair))
+      if free:
+        slots.append((node, free[0], free[0]))
+    return slots
+
+def get_available_memory():
+  with open("/proc/meminfo") as f:
+    for line in f:
+      if line.startswith("MemAvailable:"):
+        return int(line.split()[1]) * 1024
+  return None
+
+def get_footprint_estimate(results_dir, footprint_file="scarab.stdout"):
+  """
+  Returns the simulator footprint (bytes) reported by an earlier run with
+  --report_mem_footprint 1 in results_dir, or None.
+  """
+  path = os.path.join(results_dir, footprint_file)
+  if not os.path.exists(path):
+    return None
+  with open(path, errors="replace") as f:
+    for line in f:
+      m = re.match(r"\*\* Footprint total\s+([0-9.]+) KB", line)
+      if m:
+        return int(float(m.group(1)) * 1024)
+  return None
+
+class AffinityBatchManager(BatchManager):
+  """Launches jobs on your local system, pinned to cores and admitted by memory.
+
+  Every job gets a slot of two hardware threads in one NUMA node: Scarab runs on one and the PIN
+  processes on its SMT sibling, with memory bound to the node. A job is only started once its expected
+  memory fits into the budget; the expectation is the job's memory_per_core, else the footprint total
+  reported by a previous run (--report_mem_footprint 1) plus pin_memory, else default_job_memory.
+  Jobs whose results directory already reports success are skipped, so rerunning resumes a batch, and
+  failed jobs are retried up to max_retries times.
+
+  Args:
+    phase_list: The ordered list of phases. Phases will be run sequentially in the provided order.
+    max_jobs: the maximum number of concurrent jobs (default: one per slot).
+    memory_budget: memory that running jobs may use, e.g. "200gb" (default: 90% of MemAvailable).
+    default_job_memory: the expected memory of a job without any other estimate.
+    pin_memory: memory added to a footprint estimate for the PIN processes.
+    max_retries: the number of times a failed job is rerun.
+    skip_successful: skip jobs whose results directory already reports success.
+  """
+  def __init__(self,
+               phase_list=[],
+               max_jobs=None,
+               memory_budget=None,
+               default_job_memory="4gb",
+               pin_memory="1gb",
+               max_retries=1,
+               skip_successful=True,
+               **kwargs
+              ):
+    super().__init__(phase_list, **kwargs)
+    self.max_jobs = max_jobs
+    self.memory_budget = parse_memory_size(memory_budget)
+    self.default_job_memory = parse_memory_size(default_job_memory)
+    self.pin_memory = parse_memory_size(pin_memory)
+    self.max_retries = max_retries
+    self.skip_successful = skip_successful
+
+  def _expected_memory(self, cmd):
+    if cmd.memory_per_core:
+      return parse_memory_size(cmd.memory_per_core)
+    footprint = get_footprint_estimate(cmd.results_dir)
+    if footprint:
+      return footprint + self.pin_memory
+    return self.default_job_memory
+
+  @staticmethod
+  def _pinned_command(cmd, slot):
+    node, scarab_cpu, pin_cpu = slot
+    if cmd.accepts_affinity_args:
+      cmd_str = cmd.cmd + " --scarab_cpus {} --pin_cpus {}".format(scarab_cpu, pin_cpu)
+      if node is not None and shutil.which("numactl"):
+        cmd_str += " --numa_node {}".format(node)
+    else:
+      cmd_str = "taskset -c {} {}".format(",".join(sorted({str(scarab_cpu), str(pin_cpu)})), cmd.cmd)
+    return cmd.copy_with_cmd(cmd_str)
+
+  def _already_succeeded(self, cmd):
+    if not self.skip_successful or not cmd.accepts_affinity_args:
+      return False
+    return progress.Progress(cmd.results_dir).status == progress.JobStatus.SUCCESS
+
+  def run_phase(self, command_list, slots, budget):
+    pending = [(cmd, 0) for cmd in command_list if not self._already_succeeded(cmd)]
+    skipped = len(command_list) - len(pending)
+    if skipped:
+      print("Skipping {} job(s) that already succeeded".format(skipped))
+
+    free_slots = list(slots)
+    running = []  # (pinned cmd, original cmd, attempt, slot, memory)
+    failed = []
+    used_memory = 0
+    while pending or running:
+      launched = False
+      for i, (cmd, attempt) in enumerate(pending):
+        if not free_slots:
+          break
+        memory = self._expected_memory(cmd)
+        # an oversized job still runs, alone
+        if running and used_memory + memory > budget:
+          continue
+        slot = free_slots.pop(0)
+        pinned = self._pinned_command(cmd, slot)
+        pinned.write_to_snapshot_log(0)
+        print("Launching on node {} cpus {},{} (expects {:.1f} GB): {}".format(
+          slot[0], slot[1], slot[2], memory / (1 << 30), pinned.cmd))
+        pinned.run_in_background()
+        running.append((pinned, cmd, attempt, slot, memory))
+        used_memory += memory
+        del pending[i]
+        launched = True
+        break
+      if launched:
+        continue
+
+      time.sleep(1)
+      for job in list(running):
+        pinned, cmd, attempt, slot, memory = job
+        pinned.poll()
+        if pinned.returncode is None:
+          continue
+        running.remove(job)
+        free_slots.append(slot)
+        used_memory -= memory
+        print("Finished command with return code: {}".format(pinned.returncode))
+        print(pinned)
+        if pinned.returncode != 0:
+          if attempt < self.max_retries:
+            print("Retrying ({}/{})".format(attempt + 1, self.max_retries))
+            pending.append((cmd, attempt + 1))
+          else:
+            failed.append(cmd)
+    return failed
+
+  def run(self):
+    topology = HostTopology()
+    slots = topology.slots()
+    assert slots, "Error: AffinityBatchManager found no available CPUs"
+    if self.max_jobs:
+      slots = slots[:self.max_jobs]
+    budget = self.memory_budget
+    if budget is None:
+      available = get_available_memory()
+      budget = int(available * 0.9) if available else float('inf')
+
+    phase_id = 0
+    failed = []
+    for phase in self.phase_list:
+      print("Starting Phase {}".format(phase.name if phase.name else phase_id))
+      phase_id += 1
+      command_list = phase.process_command_list()
+      print("Starting AffinityBatchManager: num_cmds={}, num_slots={}, memory_budget={:.1f} GB".format(
+        len(command_list), len(slots), budget / (1 << 30)))
+      failed += self.run_phase(command_list, slots, budget)
+
+    for cmd in failed:
+      print("Error: job failed after {} retries:\n{}".format(self.max_retries, cmd))
+    return len(failed)
+
 class PBSBatchManager(BatchManager):
   """Launches jobs on a PBS system. Jobs are all launched at once, but the job dependency information is conveyed to the PBS system.
 
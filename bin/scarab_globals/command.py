@@ -52,6 +52,9 @@ class Command:
     self.walltime        = CommandDefaults.walltime
     self.memory_per_core = CommandDefaults.memory_per_core
     self.cores           = CommandDefaults.cores
+    # True if cmd is a scarab_launch.py invocation that accepts --scarab_cpus,
+    # --pin_cpus and --numa_node. Other commands are pinned with a prefix.
+    self.accepts_affinity_args = False
 
     if self.stdout:
       self.stdout = os.path.join(self.results_dir, self.stdout)
@@ -107,9 +110,20 @@ class Command:
     self.__clean_up()
     return self.returncode
 
-  def run_in_background(self):
+  def copy_with_cmd(self, cmd_str):
+    """
+    Returns a shallow copy of this command that runs cmd_str instead.
+    """
+    copy = Command.__new__(Command)
+    copy.__dict__.update(self.__dict__)
+    copy.cmd = cmd_str
+    copy.process = None
+    return copy
+
+  def run_in_background(self, pass_fds=()):
     self.__prepare_to_run()
-    self.process = subprocess.Popen(shlex.split(self.cmd), stdin=None, stdout=self.stdout_fp, stderr=self.stderr_fp)
+    self.process = subprocess.Popen(shlex.split(self.cmd), stdin=None, stdout=self.stdout_fp, stderr=self.stderr_fp,
+                                    pass_fds=pass_fds)
     self.__clean_up()
     return self.process
 
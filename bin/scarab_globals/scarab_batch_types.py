@@ -405,4 +405,5 @@ def generate_run_command(job, results_dir, scarab_params):
   cmd.memory_per_core = scarab_params.memory_per_core
   cmd.cores = scarab_params.cores
   cmd.snapshot_log = scarab_params.snapshot_log
+  cmd.accepts_affinity_args = True
   return cmd
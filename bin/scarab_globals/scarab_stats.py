@@ -22,6 +22,7 @@ import os
 import sys
 import glob
 import re
+import json
 import argparse
 
 os.environ['OPENBLAS_NUM_THREADS'] = '1'
@@ -31,6 +32,7 @@ from scipy import stats
 
 sys.path.append(os.path.dirname(__file__))
 from scarab_utils import *
+import scarab_stats_bin
 
 parser = argparse.ArgumentParser(description="Scarab Batch")
 parser.add_argument('results_dir', help="Results directory to parse stats.")
@@ -44,6 +46,8 @@ class StatConfig:
   weight_header = "Weight"
   benchmark_header = "Benchmark"
   job_name_header = "Job Name"
+  stat_index_file = "stats.index.json"
+  stat_index_version = 1
 
   @staticmethod
   def get_core_header(core_id):
@@ -59,6 +63,10 @@ pd.set_option('display.float_format', "{:,.2f}".format)
 
 print_warnings = True
 
+# Cache the parsed stats of every results directory in a columnar index, so
+# later queries read one file per run instead of regex parsing every stat file.
+use_stat_index = True
+
 #####################################################################
 # Stat Hierarchy
 #####################################################################
@@ -379,6 +387,9 @@ class StatFileParser:
        3. Intersect results from other scarab batch runs (Remove results that do not exist in both runs)
        4. Apply weights to stats, accumulate with other StatFrames
   """
+  # Grabs all stat values from a line, compiled once since every line is matched
+  pattern_all_values = re.compile(r'^([^\s]+)\s+([0-9.]+)\s+([0-9.nan-]+)?[%]?\s+([0-9.]+)\s+([0-9.nan-]+)?[%]?')
+
   def __init__(self, results_dir):
     """Set up StatFrame Object:
     
@@ -404,22 +415,130 @@ class StatFileParser:
     
     Note: We assume that either all stats were generated or none were.
     """
-    stats_file_list = glob.glob(os.path.join(self.results_dir, "*.stat.*.out"))
+    stats_file_list = sorted(glob.glob(os.path.join(self.results_dir, "*.stat.*.out")))
+
+    # Runs with --dump_stats_text 0 leave only the binary stats stream
+    stats_bin_list = sorted(glob.glob(os.path.join(self.results_dir, "*stats.bin")))
+    if len(stats_file_list) == 0 and len(stats_bin_list) > 0:
+      stats_file_list = stats_bin_list[:1]
 
     # Check to see if any stats were generated
     if len(stats_file_list) == 0:
       if print_warnings:
         warn("No stat files for {} : Skipping...".format(self.results_dir))
+      return
+
+    sources = self._get_index_sources(stats_file_list)
+    if use_stat_index and self._read_stat_index(sources):
+      return
+
+    if stats_file_list[0].endswith("stats.bin"):
+      self._read_stats_bin(stats_file_list[0])
     else:
       self.no_stat_files = False
 
-    # Get core id from stat filename and parse all stats
+      # Get core id from stat filename and parse all stats
+      for stats_file in stats_file_list:
+        m = re.search('[.]stat[.]([0-9]+)[.]out', stats_file)
+        if m:
+          stats_file_name = os.path.join(self.results_dir, stats_file)
+          core_id = int(m.group(1))
+          self._parse_stats_file(stats_file_name, core_id)
+
+    if use_stat_index and not self.no_stat_files:
+      self._write_stat_index(sources)
+
+  def _get_index_sources(self, stats_file_list):
+    """Returns {file name: [size, mtime_ns]} for the files an index is built from.
+    The index is stale as soon as any of these change.
+    """
+    sources = {}
     for stats_file in stats_file_list:
-      m = re.search('[.]stat[.]([0-9]+)[.]out', stats_file)
-      if m:
-        stats_file_name = os.path.join(self.results_dir, stats_file)
-        core_id = int(m.group(1))
-        self._parse_stats_file(stats_file_name, core_id)
+      try:
+        st = os.stat(stats_file)
+        sources[os.path.basename(stats_file)] = [st.st_size, st.st_mtime_ns]
+      except OSError:
+        pass
+    return sources
+
+  def _read_stat_index(self, sources):
+    """Load the stats from the columnar index of the results directory.
+
+    The index holds one list of stat names and, per core, one list of values in
+    the same order. Missing values are stored as null.
+
+    Args:
+        sources (dict): The current sizes and mtimes of the stat files
+
+    Returns:
+        Boolean: True if an up to date index was found and loaded
+    """
+    index_file = os.path.join(self.results_dir, StatConfig.stat_index_file)
+    try:
+      with open(index_file) as fp:
+        index = json.load(fp)
+      if index["version"] != StatConfig.stat_index_version or index["sources"] != sources:
+        return False
+
+      names = index["stats"]
+      files = [ os.path.join(self.results_dir, f) for f in index["files"] ]
+      self.stat_names[StatConfig.stat_name_header] = names
+      self.stat_names[StatConfig.stat_file_header] = files
+      for core_id, values in index["cores"].items():
+        self.stat_values[int(core_id)] = {
+          stat: value for stat, value in zip(names, values) if value is not None
+        }
+    except Exception:
+      self.stat_values = {}
+      self.stat_names = {StatConfig.stat_name_header:[], StatConfig.stat_file_header:[]}
+      return False
+
+    self.no_stat_files = False
+    return True
+
+  def _write_stat_index(self, sources):
+    """Save the parsed stats as a columnar index next to the stat files.
+
+    Failing to write the index (e.g., read-only results) only costs the
+    speedup, so errors are ignored.
+    """
+    names = self.stat_names[StatConfig.stat_name_header]
+    index = {
+      "version": StatConfig.stat_index_version,
+      "sources": sources,
+      "stats": names,
+      "files": [ os.path.basename(f) for f in self.stat_names[StatConfig.stat_file_header] ],
+      "cores": {
+        str(core_id): [ values.get(stat) for stat in names ]
+        for core_id, values in sorted(self.stat_values.items())
+      },
+    }
+
+    index_file = os.path.join(self.results_dir, StatConfig.stat_index_file)
+    tmp_file = "{}.tmp.{}".format(index_file, os.getpid())
+    try:
+      with open(tmp_file, 'w') as fp:
+        json.dump(index, fp, separators=(',', ':'))
+      os.replace(tmp_file, index_file)
+    except OSError:
+      if os.path.exists(tmp_file):
+        os.remove(tmp_file)
+
+  def _read_stats_bin(self, stats_bin):
+    """Parse the final stats of every core out of a binary stats stream
+
+    Args:
+        stats_bin (string): Absolute path to the stream written with --dump_stats_bin 1
+    """
+    try:
+      reader = scarab_stats_bin.StatsBinReader(stats_bin)
+      for core_id, core_stats in sorted(reader.final_stats().items()):
+        for stat, value in core_stats.items():
+          self._add_stat(core_id, stat, value, stats_bin)
+      self.no_stat_files = False
+    except Exception as e:
+      if print_warnings:
+        warn("Unable to read stats stream {} : ".format(stats_bin) + str(e))
 
   def _parse_stats_file(self, statsfile, core_id):
     """Parse stats out of a single Scarab statsfile
@@ -434,9 +553,9 @@ class StatFileParser:
     try:
       with open(statsfile) as fp:
         for line in fp:
-          if self._is_stat_line(line):
-            stat, value = self._parse_stat(line)
-            self._add_stat(core_id, stat, value, statsfile)
+          m = self._is_stat_line(line)
+          if m:
+            self._add_stat(core_id, m.group(1), float(m.group(4)), statsfile)
     except Exception as e:
       if print_warnings:
         warn("Unable to read stats file {} : ".format(statsfile) + str(e))
@@ -469,12 +588,7 @@ class StatFileParser:
     Returns:
         RegEx Object: The Regex Object containing the parsed results
     """
-    # A slow regex that grabs all stat values from file:
-    pattern_all_values = '^([^\s]+)\s+([0-9.]+)\s+([0-9.nan-]+)?[%]?\s+([0-9.]+)\s+([0-9.nan-]+)?[%]?'
-
-    # If we only need the reset stats, then use the faster regex...
-    m = re.search(pattern_all_values, stat_str)
-    return m
+    return StatFileParser.pattern_all_values.search(stat_str)
 
   def _add_stat(self, core_id, stat, value, statsfile):
     if not core_id in self.stat_values:
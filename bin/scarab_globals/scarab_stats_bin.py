@@ -0,0 +1,504 @@
+#  Copyright 2020 HPS/SAFARI Research Groups
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy of
+#  this software and associated documentation files (the "Software"), to deal in
+#  the Software without restriction, including without limitation the rights to
+#  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+#  of the Software, and to permit persons to whom the Software is furnished to do
+#  so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all
+#  copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+
+"""Readers for Scarab's binary stat streams.
+
+The stats stream (--dump_stats_bin 1) is documented at the top of
+src/statistics.c. Run as a script, this module regenerates the .out and .csv
+stat files that dump_stats() would have written:
+
+  python3 scarab_stats_bin.py <results_dir>/stats.bin [-o <output_dir>]
+
+The stat sample time series (--stats_to_sample) is documented in
+src/stat_sample.c. Given that stream, the script prints it as tab-separated
+text instead:
+
+  python3 scarab_stats_bin.py <results_dir>/stats.samples
+
+The live stats page (--live_stats) is documented in src/stat_live.c. Given
+the page of a running simulation, the script asks it for a snapshot and
+prints the current totals:
+
+  python3 scarab_stats_bin.py <results_dir>/stats.live
+"""
+
+import os
+import re
+import struct
+import argparse
+import math
+import mmap
+import time
+
+STATS_BIN_MAGIC = b"SCARABST"
+STATS_BIN_VERSION = 1
+STATS_BIN_PERIODIC = 0x1
+STATS_BIN_WARMUP = 0x2
+STATS_BIN_ROI = 0x4
+STAT_SAMPLE_MAGIC = b"SCARABSS"
+STAT_SAMPLE_VERSION = 1
+STAT_LIVE_MAGIC = b"SCARABLV"
+STAT_LIVE_VERSION = 1
+
+# Must match Stat_Type in src/statistics.h
+COUNT_TYPE_STAT, FLOAT_TYPE_STAT, DIST_TYPE_STAT, PER_INST_TYPE_STAT, PER_1000_INST_TYPE_STAT, \
+  PER_1000_PRET_INST_TYPE_STAT, PER_CYCLE_TYPE_STAT, RATIO_TYPE_STAT, PERCENT_TYPE_STAT, LINE_TYPE_STAT = range(10)
+
+STATISTICS_CSV_NO_GROUP = 0
+LINE = "#" * 100 + "\n"
+STAR_LINE = "\n/" + "*" * 86 + "/\n"
+
+class StatInfo:
+  def __init__(self, stat_type, ratio_stat, name, file_name):
+    self.type = stat_type
+    self.ratio_stat = ratio_stat
+    self.name = name
+    self.file_name = file_name
+
+class StatRecord:
+  """One dump of stats [first_stat, first_stat + num_stats) of a core.
+
+     counts and totals are indexed by stat index. Float stats hold doubles,
+     all other stats hold unsigned integers.
+  """
+  def __init__(self, head, cycles, counts, totals):
+    self.proc_id, self.flags, self.first_stat, self.num_stats = head
+    (self.period_id, self.roi_id, self.cycle_count, self.inst_count, self.period_last_cycle_count,
+     self.period_last_inst_count, self.pret_inst_count, self.pret_inst_count_0) = cycles
+    self.counts = counts
+    self.totals = totals
+
+class StatsBinReader:
+  """Parses the header of a binary stats stream and iterates over its records."""
+  def __init__(self, path):
+    self.path = path
+    with open(path, "rb") as fp:
+      self.data = fp.read()
+    self.pos = 0
+
+    assert self._read(len(STATS_BIN_MAGIC)) == STATS_BIN_MAGIC, "{} is not a Scarab stats stream".format(path)
+    version, num_stats = self._unpack("<II")
+    assert version == STATS_BIN_VERSION, "Unsupported stats stream version {}".format(version)
+    self.file_tag = self._read_str()
+    self.stats = []
+    for ii in range(num_stats):
+      stat_type, ratio_stat = self._unpack("<II")
+      name = self._read_str()
+      file_name = self._read_str()
+      self.stats.append(StatInfo(stat_type, ratio_stat, name, file_name))
+
+  def _read(self, size):
+    buf = self.data[self.pos:self.pos + size]
+    self.pos += size
+    return buf
+
+  def _unpack(self, fmt):
+    values = struct.unpack_from(fmt, self.data, self.pos)
+    self.pos += struct.calcsize(fmt)
+    return values
+
+  def _read_str(self):
+    length, = self._unpack("<I")
+    return self._read(length).decode()
+
+  def _read_values(self, first_stat, num_stats):
+    ints = struct.unpack_from("<{}Q".format(num_stats), self.data, self.pos)
+    floats = struct.unpack_from("<{}d".format(num_stats), self.data, self.pos)
+    self.pos += 8 * num_stats
+    values = [0] * len(self.stats)
+    for ii in range(num_stats):
+      stat = first_stat + ii
+      values[stat] = floats[ii] if self.stats[stat].type == FLOAT_TYPE_STAT else ints[ii]
+    return values
+
+  def records(self):
+    """Yields the records in the order Scarab dumped them. A truncated final
+       record (e.g. from a killed run) is ignored."""
+    head_size = struct.calcsize("<4I8Q")
+    while self.pos + head_size <= len(self.data):
+      head = self._unpack("<4I")
+      cycles = self._unpack("<8Q")
+      if self.pos + 16 * head[3] > len(self.data):
+        break
+      counts = self._read_values(head[2], head[3])
+      totals = self._read_values(head[2], head[3])
+      yield StatRecord(head, cycles, counts, totals)
+
+  def final_stats(self):
+    """Returns {core_id: {stat_name: total}}, the values StatFileParser reads
+       from the .stat.<core>.out files of the run."""
+    values = {}
+    for record in self.records():
+      if record.flags & (STATS_BIN_PERIODIC | STATS_BIN_WARMUP | STATS_BIN_ROI):
+        continue
+      core_stats = values.setdefault(record.proc_id, {})
+      for stat in range(record.first_stat, record.first_stat + record.num_stats):
+        if self.stats[stat].type == LINE_TYPE_STAT:
+          continue
+        core_stats[self.stats[stat].name] = float(record.totals[stat])
+    return values
+
+class StatSamplesReader:
+  """Parses a stat sample stream. Each sample is a dict with the clock,
+     cycle_count, inst_count (per core) and for every sampled stat name the
+     per-core change since the previous sample."""
+  def __init__(self, path):
+    with open(path, "rb") as fp:
+      self.data = fp.read()
+    assert self.data[:len(STAT_SAMPLE_MAGIC)] == STAT_SAMPLE_MAGIC, "{} is not a Scarab stat sample stream".format(path)
+    self.pos = len(STAT_SAMPLE_MAGIC)
+    version, self.num_cores, num_stats = self._unpack("<3I")
+    assert version == STAT_SAMPLE_VERSION, "Unsupported stat sample version {}".format(version)
+    self.interval = self._read_str()
+    self.stats = []
+    for ii in range(num_stats):
+      stat_type, = self._unpack("<I")
+      self.stats.append(StatInfo(stat_type, None, self._read_str(), None))
+    self.sample_width = 2 + self.num_cores + num_stats * self.num_cores
+
+  def _unpack(self, fmt):
+    values = struct.unpack_from(fmt, self.data, self.pos)
+    self.pos += struct.calcsize(fmt)
+    return values
+
+  def _read_str(self):
+    length, = self._unpack("<I")
+    self.pos += length
+    return self.data[self.pos - length:self.pos].decode()
+
+  def samples(self):
+    """Yields the samples in order. A truncated final block is ignored."""
+    while self.pos + 4 <= len(self.data):
+      num_samples, = self._unpack("<I")
+      size = 8 * num_samples * self.sample_width
+      if self.pos + size > len(self.data):
+        break
+      for ii in range(num_samples):
+        ints = struct.unpack_from("<{}Q".format(self.sample_width), self.data, self.pos)
+        floats = struct.unpack_from("<{}d".format(self.sample_width), self.data, self.pos)
+        self.pos += 8 * self.sample_width
+        sample = {"clock": ints[0], "cycle_count": ints[1], "inst_count": list(ints[2:2 + self.num_cores])}
+        base = 2 + self.num_cores
+        for jj, stat in enumerate(self.stats):
+          values = floats if stat.type == FLOAT_TYPE_STAT else ints
+          sample[stat.name] = list(values[base + jj * self.num_cores:base + (jj + 1) * self.num_cores])
+        yield sample
+
+  def print_samples(self):
+    header = ["Clock", "Cycles"] + ["Instructions[{}]".format(p) for p in range(self.num_cores)]
+    for stat in self.stats:
+      header += ["{}[{}]".format(stat.name, p) for p in range(self.num_cores)]
+    print("\t".join(header))
+    for sample in self.samples():
+      row = [sample["clock"], sample["cycle_count"]] + sample["inst_count"]
+      for stat in self.stats:
+        row += sample[stat.name]
+      print("\t".join(str(value) for value in row))
+
+class StatsLiveReader:
+  """Reads snapshots from the live stats page of a running simulation."""
+  HEADER = "<8s4I8Q"
+  REQUEST_OFFSET = 24
+
+  def __init__(self, path):
+    self.fp = open(path, "r+b")
+    self.page = mmap.mmap(self.fp.fileno(), 0)
+    magic, version, self.num_cores, num_stats, self.data_offset = struct.unpack_from("<8s4I", self.page, 0)
+    assert magic == STAT_LIVE_MAGIC, "{} is not a Scarab live stats page".format(path)
+    assert version == STAT_LIVE_VERSION, "Unsupported live stats version {}".format(version)
+    pos = struct.calcsize(self.HEADER) + 8 * self.num_cores
+    self.stats = []
+    for ii in range(num_stats):
+      stat_type, length = struct.unpack_from("<2I", self.page, pos)
+      pos += 8 + length
+      self.stats.append(StatInfo(stat_type, None, self.page[pos - length:pos].decode(), None))
+
+  def _header(self):
+    return struct.unpack_from(self.HEADER, self.page, 0)
+
+  def snapshot(self, timeout=60.0):
+    """Asks for a fresh snapshot and returns it as a dict with cycle_count,
+       sim_time, host_ns, done, inst_count (per core) and for every stat name
+       a (totals, changes since the previous snapshot) pair of per-core lists.
+       Returns the last written snapshot if the simulation does not answer
+       within timeout seconds."""
+    served, done = self._header()[6], self._header()[8]
+    request = served + 1
+    struct.pack_into("<Q", self.page, self.REQUEST_OFFSET, request)
+    deadline = time.time() + timeout
+    while not done and served != request and time.time() < deadline:
+      time.sleep(0.05)
+      header = self._header()
+      served, done = header[6], header[8]
+    while True:
+      header = self._header()
+      seq = header[7]
+      if seq % 2:
+        continue
+      data = bytes(self.page)
+      if self._header()[7] == seq:
+        break
+    snapshot = {"done": bool(header[8]), "cycle_count": header[9], "sim_time": header[10], "host_ns": header[11]}
+    pos = struct.calcsize(self.HEADER)
+    snapshot["inst_count"] = list(struct.unpack_from("<{}Q".format(self.num_cores), data, pos))
+    pos = self.data_offset
+    width = 2 * self.num_cores
+    for stat in self.stats:
+      fmt = "<{}d" if stat.type == FLOAT_TYPE_STAT else "<{}Q"
+      values = struct.unpack_from(fmt.format(width), data, pos)
+      snapshot[stat.name] = (list(values[:self.num_cores]), list(values[self.num_cores:]))
+      pos += 8 * width
+    return snapshot
+
+  def print_snapshot(self):
+    snapshot = self.snapshot()
+    print("cycles: {}  time: {}  host: {:.1f}s{}".format(snapshot["cycle_count"], snapshot["sim_time"],
+                                                        snapshot["host_ns"] / 1e9, "  (done)" if snapshot["done"] else ""))
+    print("{:<40s} {}".format("instructions", " ".join(str(v) for v in snapshot["inst_count"])))
+    for stat in self.stats:
+      totals, changes = snapshot[stat.name]
+      print("{:<40s} {}    (+{})".format(stat.name, " ".join(str(v) for v in totals),
+                                         " ".join(str(v) for v in changes)))
+
+#####################################################################
+# Text output, mirrors dump_stats_text() in src/statistics.c
+
+# Python raises where C quietly produces an IEEE result. On x86 the default NaN
+# of an invalid operation has its sign bit set, which glibc prints as -nan.
+
+def _div(a, b):
+  a = float(a)
+  b = float(b)
+  if b == 0.0:
+    if math.isnan(a):
+      return a
+    if a == 0.0:
+      return -math.nan
+    return math.copysign(math.inf, a) * math.copysign(1.0, b)
+  return a / b
+
+def _sqrt(x):
+  if math.isnan(x):
+    return x
+  if x < 0.0:
+    return -math.nan
+  return math.sqrt(x)
+
+def _f(fmt, value):
+  """printf-style float formatting that prints NaNs the way glibc does."""
+  if math.isnan(value):
+    m = re.match(r"%(-?)(\d*)", fmt)
+    text = "-nan" if math.copysign(1.0, value) < 0 else "nan"
+    width = int(m.group(2)) if m.group(2) else 0
+    text = text.ljust(width) if m.group(1) else text.rjust(width)
+    return text + ("%" if fmt.endswith("%%") else "")
+  return fmt % value
+
+def _stat_file_name(reader, record, stat, csv):
+  name = stat.file_name[:-3] + str(record.proc_id) + (".csv" if csv else ".out")
+  if record.flags & STATS_BIN_PERIODIC:
+    name += ".period.{}".format(record.period_id)
+  if record.flags & STATS_BIN_WARMUP:
+    name += ".warmup"
+  if record.flags & STATS_BIN_ROI:
+    name += ".roi.{}".format(record.roi_id)
+  return reader.file_tag + name
+
+def _write_file_header(out, csv, record):
+  out.write("/* -*- Mode: c -*- */\n")
+  out.write(LINE)
+  out.write("Core {}\n".format(record.proc_id))
+  out.write(LINE)
+  out.write("Cumulative:        Cycles: %-20d  Instructions: %-20d  IPC: %s\n" %
+            (record.cycle_count, record.inst_count, _f("%.5f", _div(record.inst_count, record.cycle_count))))
+  out.write("\n")
+  period_cycles = (record.cycle_count - record.period_last_cycle_count) % 2**64
+  period_insts = (record.inst_count - record.period_last_inst_count) % 2**64
+  out.write("Periodic:          Cycles: %-20d  Instructions: %-20d  IPC: %s\n" %
+            (period_cycles, period_insts, _f("%.5f", _div(period_insts, period_cycles))))
+  out.write("\n")
+
+  csv.write("Core, %d, %d\n" % (STATISTICS_CSV_NO_GROUP, record.proc_id))
+  csv.write("Cumulative_Cycles, %d, %-20d\nCumulative_Instructions, %d, %-20d\n" %
+            (STATISTICS_CSV_NO_GROUP, record.cycle_count, STATISTICS_CSV_NO_GROUP, record.inst_count))
+  csv.write("Periodic_Cycles, %d, %-20d\nPeriodic_Instructions, %d, %-20d\n" %
+            (STATISTICS_CSV_NO_GROUP, period_cycles, STATISTICS_CSV_NO_GROUP, period_insts))
+
+def _write_ratio(out, csv, s, count, total, count_base, total_base, scale=1.0, pct=False):
+  """The shared output of the PER_*, RATIO and PERCENT stat types."""
+  fmt = "%12.3f%%" if pct else "%13.4f"
+  ratio = _div(scale * float(count), count_base)
+  total_ratio = _div(scale * float(total), total_base)
+  out.write("%13d %s    %13d %s\n" % (count, _f(fmt, ratio), total, _f(fmt, total_ratio)))
+  csv.write("%s_count, %d, %13d\n" % (s.name, STATISTICS_CSV_NO_GROUP, count))
+  csv.write("%s_pct, %d, %s\n" % (s.name, STATISTICS_CSV_NO_GROUP, _f("%12.3f", ratio)))
+  csv.write("%s_total_count, %d, %13d\n" % (s.name, STATISTICS_CSV_NO_GROUP, total))
+  csv.write("%s_total_pct, %d, %s\n" % (s.name, STATISTICS_CSV_NO_GROUP, _f("%12.3f", total_ratio)))
+
+def write_text(reader, record, output_dir):
+  """Writes the .out and .csv files of one record."""
+  stats = reader.stats
+  counts = record.counts
+  totals = record.totals
+  last_file_name = None
+  out = csv = None
+  in_dist = False
+  stat_groupname = 0
+  dist_sum = total_dist_sum = dist_vtotal = total_dist_vtotal = 0
+  dist_variance = total_dist_variance = 0.0
+
+  for ii in range(record.first_stat, record.first_stat + record.num_stats):
+    s = stats[ii]
+    count = counts[ii]
+    total = totals[ii]
+
+    if last_file_name is None or s.file_name != last_file_name:
+      if last_file_name is not None:
+        out.write("\n\n")
+        out.close()
+        csv.write("\n\n")
+        csv.close()
+      last_file_name = s.file_name
+      out = open(os.path.join(output_dir, _stat_file_name(reader, record, s, False)), "w")
+      csv = open(os.path.join(output_dir, _stat_file_name(reader, record, s, True)), "w")
+      _write_file_header(out, csv, record)
+
+    if s.type == LINE_TYPE_STAT:
+      out.write(STAR_LINE)
+
+    out.write("%-40s " % s.name)
+
+    if s.type == COUNT_TYPE_STAT:
+      if not in_dist:
+        out.write("%13d %13s    %13d %13s\n" % (count, "", total, ""))
+        csv.write("%s_count, %d, %13d\n" % (s.name, STATISTICS_CSV_NO_GROUP, count))
+        csv.write("%s_total_count, %d, %13d\n" % (s.name, STATISTICS_CSV_NO_GROUP, total))
+      else:
+        out.write("%13d %s    %13d %s" % (count, _f("%12.3f%%", _div(count, dist_sum) * 100), total,
+                                          _f("%12.3f%%", _div(total, total_dist_sum) * 100)))
+        csv.write("%s_count, %d, %13d\n" % (s.name, stat_groupname, count))
+        csv.write("%s_total_count, %d, %13d\n" % (s.name, stat_groupname, total))
+
+    elif s.type == FLOAT_TYPE_STAT:
+      assert not in_dist, "Distributions not supported for float stats"
+      out.write("%s %13s    %s %13s\n" % (_f("%13f", count), "", _f("%13f", total), ""))
+      csv.write("%s_value, %d, %s\n" % (s.name, STATISTICS_CSV_NO_GROUP, _f("%13f", count)))
+      csv.write("%s_total_value, %d, %s\n" % (s.name, STATISTICS_CSV_NO_GROUP, _f("%13f", total)))
+
+    elif s.type == DIST_TYPE_STAT:
+      if not in_dist:
+        stat_groupname += 1
+        in_dist = True
+        end = ii + 1
+        while stats[end].type != DIST_TYPE_STAT:
+          end += 1
+        members = range(ii + 1, end + 1)
+        dist_sum = count + sum(counts[jj] for jj in members)
+        total_dist_sum = total + sum(totals[jj] for jj in members)
+        dist_vtotal = sum((jj - ii) * counts[jj] for jj in members)
+        total_dist_vtotal = sum((jj - ii) * totals[jj] for jj in members)
+
+        mean = _div(dist_vtotal, dist_sum)
+        total_mean = _div(total_dist_vtotal, total_dist_sum)
+        dist_variance = (0.0 - mean)**2 * counts[end]
+        total_dist_variance = (0.0 - total_mean)**2 * totals[end]
+        for jj in members:
+          dist_variance += (jj - ii - mean)**2 * counts[jj]
+          total_dist_variance += (jj - ii - total_mean)**2 * totals[jj]
+        # the C code divides by an unsigned sum - 1
+        dist_variance = _div(dist_variance, (dist_sum - 1) % 2**64)
+        total_dist_variance = _div(total_dist_variance, (total_dist_sum - 1) % 2**64)
+
+        out.write("%13d %s    %13d %s" % (count, _f("%12.3f%%", _div(count, dist_sum) * 100), total,
+                                          _f("%12.3f%%", _div(total, total_dist_sum) * 100)))
+        csv.write("%s_count, %d, %13d\n" % (s.name, stat_groupname, count))
+        csv.write("%s_total_count, %d, %13d\n" % (s.name, stat_groupname, total))
+      else:
+        in_dist = False
+        out.write("%13d %s    %13d %s\n" % (count, _f("%12.3f%%", _div(count, dist_sum) * 100), total,
+                                            _f("%12.3f%%", _div(total, total_dist_sum) * 100)))
+        csv.write("%s_count, %d, %13d\n" % (s.name, stat_groupname, count))
+        csv.write("%s_total_count, %d, %13d\n" % (s.name, stat_groupname, total))
+        out.write("%-40s %13d %s    %13d %s\n" % ("", dist_sum, _f("%12.3f%%", _div(dist_sum, dist_sum) * 100),
+                                                  total_dist_sum,
+                                                  _f("%12.3f%%", _div(total_dist_sum, total_dist_sum) * 100)))
+        out.write("%-40s  %s %s      %s %s\n" % ("", _f("%12.2f", _div(dist_vtotal, dist_sum)),
+                                                 _f("%12.2f", _sqrt(dist_variance)),
+                                                 _f("%12.2f", _div(total_dist_vtotal, total_dist_sum)),
+                                                 _f("%12.2f", _sqrt(total_dist_variance))))
+
+    elif s.type == PER_INST_TYPE_STAT:
+      _write_ratio(out, csv, s, count, total, record.inst_count, record.inst_count)
+
+    elif s.type == PER_1000_INST_TYPE_STAT:
+      _write_ratio(out, csv, s, count, total, record.inst_count, record.inst_count, scale=1000.0)
+
+    elif s.type == PER_1000_PRET_INST_TYPE_STAT:
+      _write_ratio(out, csv, s, count, total, record.pret_inst_count, record.pret_inst_count_0, scale=1000.0)
+
+    elif s.type == PER_CYCLE_TYPE_STAT:
+      _write_ratio(out, csv, s, count, total, record.cycle_count, record.cycle_count)
+
+    elif s.type == RATIO_TYPE_STAT:
+      _write_ratio(out, csv, s, count, total, counts[s.ratio_stat], totals[s.ratio_stat])
+
+    elif s.type == PERCENT_TYPE_STAT:
+      _write_ratio(out, csv, s, count, total, counts[s.ratio_stat], totals[s.ratio_stat], scale=100.0, pct=True)
+
+    elif s.type == LINE_TYPE_STAT:
+      out.write(STAR_LINE)
+
+    else:
+      assert False, "Invalid statistic type {}".format(s.type)
+
+    out.write("\n")
+    csv.write("\n")
+
+  if last_file_name is not None:
+    out.write("\n\n")
+    out.close()
+    csv.write("\n\n")
+    csv.close()
+
+#####################################################################
+
+def __main():
+  parser = argparse.ArgumentParser(description="Convert a Scarab binary stats stream to the text and CSV stat files, "
+                                   "or print a stat sample stream or live stats page.")
+  parser.add_argument('stats_bin', help="Stream written with --dump_stats_bin 1 or --stats_to_sample, or a --live_stats page.")
+  parser.add_argument('-o', '--output_dir', default=None, help="Directory for the stat files (default: the stream's directory).")
+  args = parser.parse_args()
+
+  with open(args.stats_bin, "rb") as fp:
+    magic = fp.read(len(STAT_SAMPLE_MAGIC))
+  if magic == STAT_SAMPLE_MAGIC:
+    StatSamplesReader(args.stats_bin).print_samples()
+    return
+  if magic == STAT_LIVE_MAGIC:
+    StatsLiveReader(args.stats_bin).print_snapshot()
+    return
+
+  output_dir = args.output_dir if args.output_dir else os.path.dirname(os.path.abspath(args.stats_bin))
+  reader = StatsBinReader(args.stats_bin)
+  for record in reader.records():
+    write_text(reader, record, output_dir)
+
+if __name__ == "__main__":
+  __main()
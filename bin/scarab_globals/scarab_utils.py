@@ -45,6 +45,22 @@ def get_disable_aslr_prefix():
 
   return disable_aslr_cmd
 
+def get_affinity_prefix(cpus=None, numa_node=None):
+  """
+  Returns a command prefix that restricts a process to cpus (taskset list syntax)
+  and binds its memory to numa_node, or an empty string if neither is given.
+  """
+  if numa_node is not None:
+    if not shutil.which("numactl"):
+      error("--numa_node requires numactl")
+    prefix = "numactl --membind={node}".format(node=numa_node)
+    if cpus:
+      return prefix + " --physcpubind={cpus}".format(cpus=cpus)
+    return prefix + " --cpunodebind={node}".format(node=numa_node)
+  if cpus:
+    return "taskset -c {cpus}".format(cpus=cpus)
+  return ""
+
 def recursive_copy(src_dir, dest_dir):
   """
   Recursively copy each child of src_dir to the dest_dir.
@@ -21,6 +21,7 @@
 from __future__ import print_function
 import argparse
 import os
+import select
 import shutil
 import subprocess
 import sys
@@ -47,12 +48,16 @@ parser.add_argument('--pin_stdout', default=None, help="Path to redirect pins st
 parser.add_argument('--pin_stderr', default=None, help="Path to redirect pins stderr to. Default is stderr.")
 
 parser.add_argument('--enable_aslr', action='store_true', help="Enable ASLR for the application and pintool.")
+parser.add_argument('--scarab_cpus', default=None, help="CPU list (taskset syntax) to pin Scarab to.")
+parser.add_argument('--pin_cpus', default=None, help="Comma separated CPUs to pin the PIN processes to, one per simulated core (round robin).")
+parser.add_argument('--numa_node', default=None, help="NUMA node to bind the memory of Scarab and PIN to. Requires numactl.")
 
 parser.add_argument('--scarab', default=scarab_paths.scarab_bin, help="Path to the scarab binary. Defaults to src/scarab.")
 parser.add_argument('--pin', default=scarab_paths.pin_dir + "/pin", help="Path to the pin binary. Default is $PIN_ROOT/pin.")
 parser.add_argument('--frontend_pin_tool', default=scarab_paths.pin_bin, help="Path to the pin tool that will act as the frontend.")
 parser.add_argument('--checkpoint_loader', default=scarab_paths.checkpoint_loader_bin, help="Path to checkpoint loader executable.")
 parser.add_argument('--frontend', default="exec", choices=["exec", "trace"], help="Selects between the Trace fronend and the Exec-driven frontend.")
+parser.add_argument('--connect_timeout', default=0, type=float, help="Seconds to wait for all PIN processes to connect to Scarab before giving up (0: no limit).")
 
 args = parser.parse_args()
 
@@ -128,6 +133,9 @@ class Scarab:
       bin_dir=scarab_paths.bin_dir,
       additional_args=args.scarab_args
     )
+    affinity_prefix = scarab_utils.get_affinity_prefix(args.scarab_cpus, args.numa_node)
+    if affinity_prefix:
+      self.cmd = affinity_prefix + " " + self.cmd
     return self.cmd
 
   def launch(self):
@@ -149,6 +157,11 @@ class Pin:
     self.socket_path = os.path.abspath(socket_path)
     self.program_path = os.path.realpath(program_path)
     self.is_checkpoint = is_checkpoint
+    # The pintool writes its core id to this pipe once it has connected to Scarab
+    self.ready_fd, self.ready_write_fd = os.pipe()
+    self.cmd = None
+    self.process = None
+    self.launch_time = None
 
   def __get_pin_command(self):
     if self.is_checkpoint:
@@ -158,18 +171,27 @@ class Pin:
 
     if not args.enable_aslr:
       self.cmd = scarab_utils.get_disable_aslr_prefix() + " " + self.cmd
+
+    pin_cpu = None
+    if args.pin_cpus:
+      pin_cpu_list = args.pin_cpus.split(',')
+      pin_cpu = pin_cpu_list[int(self.core_id) % len(pin_cpu_list)]
+    affinity_prefix = scarab_utils.get_affinity_prefix(pin_cpu, args.numa_node)
+    if affinity_prefix:
+      self.cmd = affinity_prefix + " " + self.cmd
     
     print("{cmd}\n".format(cmd=self.cmd))
 
     return self.cmd
 
   def __get_pin_checkpoint_command(self):
-    self.cmd = '{checkpoint_loader} {checkpoint_path} {socket} {core_id} {pin_tool} -pintool_args="{pintool_args}"'.format(
+    self.cmd = '{checkpoint_loader} {checkpoint_path} {socket} {core_id} {pin_tool} -pintool_args="-ready_fd {ready_fd} {pintool_args}"'.format(
         checkpoint_loader=args.checkpoint_loader,
         checkpoint_path=self.program_path,
         socket=self.socket_path,
         core_id=self.core_id,
         pin_tool=args.frontend_pin_tool,
+        ready_fd=self.ready_write_fd,
         pintool_args=args.pintool_args,
       )
 
@@ -180,11 +202,12 @@ class Pin:
     return self.cmd
 
   def __get_pin_program_command(self):
-    self.cmd = "{pin} -mt 0 -t {pin_tool} -socket_path {socket} -core_id {core_id} {additional_args} -- {program_command}".format(
+    self.cmd = "{pin} -mt 0 -t {pin_tool} -socket_path {socket} -core_id {core_id} -ready_fd {ready_fd} {additional_args} -- {program_command}".format(
         pin=args.pin,
         pin_tool=args.frontend_pin_tool,
         socket=self.socket_path,
         core_id=self.core_id,
+        ready_fd=self.ready_write_fd,
         additional_args=args.pintool_args,
         program_command=self.program_path
       )
@@ -211,23 +234,75 @@ class Pin:
     self.__get_stderr()
 
     cmd = command.Command(self.cmd, run_dir=args.simdir, stdout=self.stdout, stderr=self.stderr)
-    cmd.run_in_background()
+    self.launch_time = time.time()
+    cmd.run_in_background(pass_fds=(self.ready_write_fd,))
+    # Only the PIN process keeps the write end, so the pipe reads EOF if it dies
+    os.close(self.ready_write_fd)
+    self.process = cmd
     return cmd
 
-def launch_programs(proc_list, core, socket_path):
+def launch_programs(proc_list, pins, core, socket_path):
   if (args.program):
     for program in args.program:
-      proc_list.push(Pin(core, socket_path, program, False).launch())
+      pin = Pin(core, socket_path, program, False)
+      proc_list.push(pin.launch())
+      pins.append(pin)
       core += 1
   return core
 
-def launch_checkpoints(proc_list, core, socket_path):
+def launch_checkpoints(proc_list, pins, core, socket_path):
   if (args.checkpoint):
     for checkpoint in args.checkpoint:
-      proc_list.push(Pin(core, socket_path, checkpoint, True).launch())
+      pin = Pin(core, socket_path, checkpoint, True)
+      proc_list.push(pin.launch())
+      pins.append(pin)
       core += 1
   return core
 
+def wait_for_socket(scarab_proc, socket_path):
+  """
+  Wait until Scarab is listening on socket_path, so the PIN clients do not spend their connection retries on it.
+  """
+  while not os.path.exists(socket_path):
+    scarab_proc.poll()
+    if scarab_proc.returncode is not None:
+      scarab_utils.error("Scarab exited with code {} before opening {}".format(scarab_proc.returncode, socket_path))
+    time.sleep(0.05)
+
+def wait_for_clients(scarab_proc, pins):
+  """
+  Wait for every PIN process, all started at once, to report that it connected to Scarab, printing the startup time of
+  each core. Exits as soon as Scarab or any client dies before all clients have connected.
+  """
+  start_time = time.time()
+  pending = {pin.ready_fd: pin for pin in pins}
+  while pending:
+    readable, _, _ = select.select(list(pending), [], [], 0.5)
+    for fd in readable:
+      pin = pending.pop(fd)
+      data = os.read(fd, 4)
+      os.close(fd)
+      if not data:
+        try:
+          pin.process.process.wait(timeout=1)
+        except subprocess.TimeoutExpired:
+          pass
+        pin.process.poll()
+        scarab_utils.error("Core {} exited with code {} before connecting to Scarab:\n{}".format(
+          pin.core_id, pin.process.returncode, pin.cmd))
+      print("Core {} connected to Scarab after {:.2f}s".format(pin.core_id, time.time() - pin.launch_time))
+
+    for proc in [scarab_proc] + [pin.process for pin in pending.values()]:
+      proc.poll()
+      if proc.returncode is not None:
+        scarab_utils.error("Exited with code {} while waiting for PIN clients to connect:\n{}".format(
+          proc.returncode, proc.cmd))
+    if args.connect_timeout and pending and time.time() - start_time > args.connect_timeout:
+      scarab_utils.error("Cores {} did not connect to Scarab within {}s".format(
+        ", ".join(pin.core_id for pin in pending.values()), args.connect_timeout))
+
+  print("All {} cores connected to Scarab after {:.2f}s\n".format(len(pins), time.time() - start_time))
+
 def main():
   frontend = determine_frontend()
   assert frontend in ['trace', 'exec_driven']
@@ -241,16 +316,19 @@ def main():
   try:
     if frontend == 'exec_driven':
       socket_path = scarab_utils.get_temp_socket_path()
-      proc_list.push(Scarab(frontend, socket_path=socket_path).launch())
+      scarab_proc = Scarab(frontend, socket_path=socket_path).launch()
+      proc_list.push(scarab_proc)
     elif frontend == 'trace':
       proc_list.push(Scarab(frontend, trace_list=args.trace).launch())
 
 
     if frontend == 'exec_driven':
-      time.sleep(1)
+      wait_for_socket(scarab_proc, socket_path)
+      pins = []
       core = 0
-      core = launch_programs(proc_list, core, socket_path)
-      core = launch_checkpoints(proc_list, core, socket_path)
+      core = launch_programs(proc_list, pins, core, socket_path)
+      core = launch_checkpoints(proc_list, pins, core, socket_path)
+      wait_for_clients(scarab_proc, pins)
 
     return_code = proc_list.wait_on_processes()
 
@@ -0,0 +1,216 @@
+#  Copyright 2020 HPS/SAFARI Research Groups
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy of
+#  this software and associated documentation files (the "Software"), to deal in
+#  the Software without restriction, including without limitation the rights to
+#  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+#  of the Software, and to permit persons to whom the Software is furnished to do
+#  so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all
+#  copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+
+"""Simulation throughput regression suite.
+
+Runs a fixed set of short workloads under each shipped PARAMS.* config and
+records wall time, KIPS, peak RSS and the HOST_PROF phase profile of every run
+in a JSON report:
+
+  python3 bin/scarab_perf_regress.py -o perf.json [--baseline old_perf.json]
+
+The default workload is src/test/simple_loop.trace.bz2. Memtrace snippets are
+added with --memtrace_dir: every subdirectory of it is run as one memtrace
+workload (this needs a Scarab built with SCARAB_ENABLE_PT_MEMTRACE). With
+--baseline, every run's KIPS is printed next to the baseline's, runs whose KIPS
+dropped by more than --threshold are listed, and the script exits with status 1.
+"""
+
+from __future__ import print_function
+
+import argparse
+import glob
+import json
+import os
+import re
+import shutil
+import socket
+import subprocess
+import sys
+import tempfile
+import time
+
+from scarab_globals import scarab_paths
+
+parser = argparse.ArgumentParser(description="Track Scarab simulation throughput across commits")
+parser.add_argument('--scarab', default=scarab_paths.scarab_bin, help="Path to the scarab binary. Defaults to src/scarab.")
+parser.add_argument('--params', default=None, action='append',
+                    help="PARAMS file to run under. Defaults to every src/PARAMS.* file.")
+parser.add_argument('--trace', default=None, action='append',
+                    help="Pin trace to run (--frontend trace). Defaults to src/test/simple_loop.trace.bz2.")
+parser.add_argument('--memtrace_dir', default=None, help="Directory whose subdirectories are memtrace snippets.")
+parser.add_argument('--inst_limit', default=10000000, type=int, help="Instructions simulated per run.")
+parser.add_argument('--repeat', default=3, type=int, help="Runs per workload and config; the fastest is reported.")
+parser.add_argument('--scarab_args', default="", help="Extra arguments passed to every scarab run.")
+parser.add_argument('-o', '--output', default="perf_report.json", help="Path of the JSON report.")
+parser.add_argument('--baseline', default=None, help="Earlier report to check this one against.")
+parser.add_argument('--threshold', default=0.05, type=float,
+                    help="Fractional KIPS drop against the baseline that counts as a regression.")
+parser.add_argument('--keep_runs', default=None, help="Keep the run directories under this path.")
+
+REPORT_VERSION = 1
+
+def get_workloads():
+  workloads = []
+  traces = args.trace if args.trace else [scarab_paths.src_dir + "/test/simple_loop.trace.bz2"]
+  for trace in traces:
+    name = os.path.basename(trace).split('.')[0]
+    workloads.append((name, "--frontend trace --fetch_off_path_ops 0 --cbp_trace_r0 " + os.path.abspath(trace)))
+  if args.memtrace_dir:
+    for trace_dir in sorted(glob.glob(os.path.join(args.memtrace_dir, "*"))):
+      if os.path.isdir(trace_dir):
+        workloads.append((os.path.basename(trace_dir),
+                          "--frontend memtrace --fetch_off_path_ops 0 --cbp_trace_r0 " + os.path.abspath(trace_dir)))
+  return workloads
+
+def get_configs():
+  params = args.params if args.params else sorted(glob.glob(scarab_paths.src_dir + "/PARAMS.*"))
+  return [(os.path.basename(p).replace("PARAMS.", ""), os.path.abspath(p)) for p in params]
+
+def read_stat_totals(path, prefix):
+  """Returns {stat: cumulative count} for the stats starting with prefix in a .stat.N.out file."""
+  totals = {}
+  if not os.path.exists(path):
+    return totals
+  with open(path) as f:
+    for line in f:
+      fields = line.split()
+      if len(fields) >= 3 and fields[0].startswith(prefix):
+        totals[fields[0]] = int(fields[-1])
+  return totals
+
+def read_insts(run_dir):
+  insts = 0
+  for path in glob.glob(os.path.join(run_dir, "core.stat.*.out")):
+    with open(path) as f:
+      match = re.search(r"Cumulative:\s+Cycles:\s+\d+\s+Instructions:\s+(\d+)", f.read())
+      if match:
+        insts += int(match.group(1))
+  return insts
+
+def read_host_profile(run_dir):
+  """Sums the HOST_PROF_<PHASE>_NS stats of all cores into {phase: seconds}."""
+  profile = {}
+  for path in glob.glob(os.path.join(run_dir, "host_prof.stat.*.out")):
+    for stat, value in read_stat_totals(path, "HOST_PROF_").items():
+      if stat.endswith("_NS"):
+        phase = stat[len("HOST_PROF_"):-len("_NS")]
+        profile[phase] = profile.get(phase, 0.0) + value * 1e-9
+  return profile
+
+def run_once(workload_args, params, run_dir):
+  shutil.copy2(params, os.path.join(run_dir, "PARAMS.in"))
+  cmd = "{scarab} {workload_args} --inst_limit {inst_limit} --host_prof 1 {extra}".format(
+    scarab=os.path.abspath(args.scarab), workload_args=workload_args, inst_limit=args.inst_limit,
+    extra=args.scarab_args)
+  with open(os.path.join(run_dir, "scarab.out"), "w") as out:
+    start = time.monotonic()
+    process = subprocess.Popen(cmd.split(), cwd=run_dir, stdout=out, stderr=subprocess.STDOUT)
+    _, status, rusage = os.wait4(process.pid, 0)
+    wall = time.monotonic() - start
+  if status != 0:
+    return {"error": "scarab exited with status {}, see {}".format(status, os.path.join(run_dir, "scarab.out"))}
+
+  insts = read_insts(run_dir)
+  return {
+    "wall_seconds": wall,
+    "user_seconds": rusage.ru_utime,
+    "sys_seconds": rusage.ru_stime,
+    "instructions": insts,
+    "kips": insts / wall / 1000 if wall > 0 else 0.0,
+    # ru_maxrss is in kilobytes on Linux
+    "peak_rss_bytes": rusage.ru_maxrss * 1024,
+    "host_profile_seconds": read_host_profile(run_dir),
+  }
+
+def run_suite():
+  runs_root = args.keep_runs if args.keep_runs else tempfile.mkdtemp(prefix="scarab_perf_")
+  results = []
+  for workload, workload_args in get_workloads():
+    for config, params in get_configs():
+      best = None
+      for ii in range(args.repeat):
+        run_dir = os.path.join(runs_root, "{}.{}.{}".format(workload, config, ii))
+        os.makedirs(run_dir, exist_ok=True)
+        result = run_once(workload_args, params, run_dir)
+        if "error" in result:
+          best = result
+          break
+        if best is None or result["wall_seconds"] < best["wall_seconds"]:
+          best = result
+      best.update({"workload": workload, "config": config})
+      print("{:24} {:16} {}".format(workload, config, best.get("error") or
+            "{:10.1f} KIPS {:8.2f} s {:8.1f} MB".format(best["kips"], best["wall_seconds"],
+                                                        best["peak_rss_bytes"] / 2**20)))
+      results.append(best)
+  if not args.keep_runs:
+    shutil.rmtree(runs_root)
+  return results
+
+def read_baseline():
+  with open(args.baseline) as f:
+    return {(r["workload"], r["config"]): r for r in json.load(f)["runs"] if "kips" in r}
+
+def print_comparison(results, baseline):
+  for r in results:
+    old = baseline.get((r["workload"], r["config"]))
+    if old and "kips" in r and old["kips"] > 0:
+      print("{:24} {:16} {:10.1f} KIPS vs {:10.1f} ({:+.1%})".format(r["workload"], r["config"], r["kips"],
+                                                                   old["kips"], r["kips"] / old["kips"] - 1))
+
+def find_regressions(results, baseline):
+  regressions = []
+  for r in results:
+    old = baseline.get((r["workload"], r["config"]))
+    if old and "kips" in r and r["kips"] < old["kips"] * (1 - args.threshold):
+      regressions.append("{} {}: {:.1f} KIPS, was {:.1f}".format(r["workload"], r["config"], r["kips"], old["kips"]))
+  return regressions
+
+def get_gitrev():
+  try:
+    return subprocess.check_output(["git", "rev-parse", "--short", "HEAD"], cwd=scarab_paths.sim_dir,
+                                   stderr=subprocess.DEVNULL).decode().strip()
+  except (OSError, subprocess.CalledProcessError):
+    return ""
+
+if __name__ == "__main__":
+  args = parser.parse_args()
+  results = run_suite()
+  report = {
+    "version": REPORT_VERSION,
+    "gitrev": get_gitrev(),
+    "host_name": socket.gethostname(),
+    "date": time.strftime("%Y-%m-%dT%H:%M:%S%z"),
+    "inst_limit": args.inst_limit,
+    "runs": results,
+  }
+  with open(args.output, "w") as f:
+    json.dump(report, f, indent=2, sort_keys=True)
+  print("Report written to " + args.output)
+
+  failed = any("error" in r for r in results)
+  if args.baseline:
+    baseline = read_baseline()
+    print_comparison(results, baseline)
+    regressions = find_regressions(results, baseline)
+    for regression in regressions:
+      print("REGRESSION: " + regression)
+    failed = failed or bool(regressions)
+  sys.exit(1 if failed else 0)
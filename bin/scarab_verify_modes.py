@@ -0,0 +1,207 @@
+#  Copyright 2020 HPS/SAFARI Research Groups
+#
+#  Permission is hereby granted, free of charge, to any person obtaining a copy of
+#  this software and associated documentation files (the "Software"), to deal in
+#  the Software without restriction, including without limitation the rights to
+#  use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+#  of the Software, and to permit persons to whom the Software is furnished to do
+#  so, subject to the following conditions:
+#
+#  The above copyright notice and this permission notice shall be included in all
+#  copies or substantial portions of the Software.
+#
+#  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+#  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+#  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+#  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+#  SOFTWARE.
+
+"""Checks that the accelerated simulation modes reproduce the serial loop.
+
+Runs one short workload in the serial loop and in every accelerated mode, then
+compares each accelerated run against the serial one:
+
+  python3 bin/scarab_verify_modes.py [--trace t.trace.bz2] [--num_cores 2]
+
+Two things are compared:
+- stats: every stat of every dump_stats() record in the binary stats stream
+  (--dump_stats_bin), with a periodic dump every --period instructions of
+  core 0. The first record that differs bounds the first divergent cycle.
+- retired ops: the RETIRE lines that --dump_retire_trace prints for every
+  retired op (print_func_op fields plus the retire cycle), core by core. The
+  first line that differs gives the first divergent cycle.
+
+Exact modes must match bit for bit. A relaxed mode (--mode
+name:tolerance:args with a nonzero tolerance, e.g. a SYNC_QUANTUM > 1) must
+retire the same ops in the same order, at any cycle, and its final stat
+totals must be within the given relative tolerance. The script exits with
+status 1 if any mode diverges.
+"""
+
+from __future__ import print_function
+
+import argparse
+import os
+import re
+import shutil
+import subprocess
+import sys
+import tempfile
+
+from scarab_globals import scarab_paths
+from scarab_globals.scarab_stats_bin import StatsBinReader, FLOAT_TYPE_STAT, LINE_TYPE_STAT
+
+parser = argparse.ArgumentParser(description="Compare accelerated Scarab modes against the serial loop")
+parser.add_argument('--scarab', default=scarab_paths.scarab_bin, help="Path to the scarab binary. Defaults to src/scarab.")
+parser.add_argument('--params', default=scarab_paths.src_dir + "/PARAMS.sunny_cove", help="PARAMS file to run under.")
+parser.add_argument('--trace', default=scarab_paths.src_dir + "/test/simple_loop.trace.bz2",
+                    help="Pin trace run on every core (--frontend trace).")
+parser.add_argument('--num_cores', default=2, type=int, help="Cores simulated, each running the trace.")
+parser.add_argument('--inst_limit', default=200000, type=int, help="Instructions simulated per core.")
+parser.add_argument('--period', default=20000, type=int, help="Instructions of core 0 between stat dumps.")
+parser.add_argument('--mode', default=None, action='append',
+                    help="Accelerated mode as name:tolerance:scarab args, e.g. 'q8:0.02:--sync_quantum 8'. "
+                         "{cores} in the args is replaced by --num_cores. Defaults to the modes in DEFAULT_MODES.")
+parser.add_argument('--ignore', default=r"^HOST_PROF_", help="Regex of stat names that are not compared.")
+parser.add_argument('--scarab_args', default="", help="Extra arguments passed to every scarab run.")
+parser.add_argument('--max_diffs', default=10, type=int, help="Differing stats listed per mode.")
+parser.add_argument('--keep_runs', default=None, help="Keep the run directories under this path.")
+
+# The serial loop: one host thread, lockstep uncore, every cycle and stage simulated
+SERIAL_ARGS = "--num_core_threads 1 --sync_quantum 1 --idle_skip 0 --fe_skip_stalled_stages 0"
+
+DEFAULT_MODES = [
+  "threads:0:--num_core_threads {cores}",
+  "idle_skip:0:--idle_skip 1",
+  "fe_skip:0:--fe_skip_stalled_stages 1",
+  "quantum8:0.02:--num_core_threads {cores} --sync_quantum 8",
+]
+
+def parse_mode(spec):
+  name, tolerance, mode_args = spec.split(":", 2)
+  return name, float(tolerance), mode_args.format(cores=args.num_cores)
+
+def run(name, mode_args, runs_root):
+  run_dir = os.path.join(runs_root, name)
+  os.makedirs(run_dir, exist_ok=True)
+  shutil.copy2(args.params, os.path.join(run_dir, "PARAMS.in"))
+  traces = " ".join("--cbp_trace_r{} {}".format(ii, os.path.abspath(args.trace)) for ii in range(args.num_cores))
+  cmd = ("{scarab} --frontend trace --fetch_off_path_ops 0 --num_cores {cores} {traces} --inst_limit {inst_limit} "
+         "--dump_stats_bin 1 --dump_stats_text 0 --periodic_dump 1 --heartbeat_interval {period} "
+         "--dump_retire_trace 1 --debug_inst_start 1 {serial} {mode} {extra}").format(
+           scarab=os.path.abspath(args.scarab), cores=args.num_cores, traces=traces, inst_limit=args.inst_limit,
+           period=args.period, serial=SERIAL_ARGS, mode=mode_args, extra=args.scarab_args)
+  with open(os.path.join(run_dir, "scarab.out"), "w") as out:
+    status = subprocess.call(cmd.split(), cwd=run_dir, stdout=out, stderr=subprocess.STDOUT)
+  if status != 0:
+    raise RuntimeError("{} run exited with status {}, see {}".format(name, status, os.path.join(run_dir, "scarab.out")))
+  return run_dir
+
+def read_stat_records(run_dir):
+  """Returns the stat names and {core: [StatRecord]} in dump order."""
+  reader = StatsBinReader(os.path.join(run_dir, "stats.bin"))
+  records = {}
+  for record in reader.records():
+    records.setdefault(record.proc_id, []).append(record)
+  return reader.stats, records
+
+def read_retired_ops(run_dir):
+  """Returns {core: [(retire cycle, op fields)]} from the RETIRE lines of the run."""
+  ops = {}
+  with open(os.path.join(run_dir, "scarab.out")) as f:
+    for line in f:
+      if not line.startswith("RETIRE "):
+        continue
+      _, cycle, fields = line.rstrip("\n").split(" ", 2)
+      ops.setdefault(int(fields.split()[0]), []).append((int(cycle), fields))
+  return ops
+
+def stat_differs(a, b, tolerance):
+  if tolerance == 0:
+    return a != b
+  return abs(a - b) > tolerance * max(abs(a), abs(b))
+
+def compare_stats(stats, serial, accel, tolerance):
+  """Returns (first divergent cycle or None, [descriptions])."""
+  ignore = re.compile(args.ignore)
+  compared = [ii for ii, s in enumerate(stats) if s.type != LINE_TYPE_STAT and not ignore.search(s.name)]
+  first_cycle, diffs = None, []
+  for core in sorted(set(serial) | set(accel)):
+    serial_records, accel_records = serial.get(core, []), accel.get(core, [])
+    if len(serial_records) != len(accel_records):
+      diffs.append("core {}: {} stat dumps, serial run has {}".format(core, len(accel_records), len(serial_records)))
+    if tolerance:
+      # relaxed modes only promise the same totals
+      pairs = [(serial_records[-1], accel_records[-1], "totals")] if serial_records and accel_records else []
+    else:
+      pairs = [(s, a, "counts") for s, a in zip(serial_records, accel_records)]
+    last_cycle = 0
+    for serial_record, accel_record, field in pairs:
+      differing = [ii for ii in compared
+                   if stat_differs(getattr(serial_record, field)[ii], getattr(accel_record, field)[ii], tolerance)]
+      if differing:
+        cycle = min(serial_record.cycle_count, accel_record.cycle_count)
+        where = ("final totals" if tolerance else
+                 "dump {} (cycles {}..{})".format(serial_records.index(serial_record), last_cycle, cycle))
+        diffs.append("core {} {}: {} stats differ".format(core, where, len(differing)))
+        for ii in differing[:args.max_diffs]:
+          diffs.append("    {:40} serial {:>16}  accelerated {:>16}".format(
+            stats[ii].name, getattr(serial_record, field)[ii], getattr(accel_record, field)[ii]))
+        if not tolerance:
+          first_cycle = last_cycle if first_cycle is None else min(first_cycle, last_cycle)
+        break
+      last_cycle = serial_record.cycle_count
+  return first_cycle, diffs
+
+def compare_retired_ops(serial, accel, tolerance):
+  """Returns (first divergent cycle or None, [descriptions])."""
+  first_cycle, diffs = None, []
+  for core in sorted(set(serial) | set(accel)):
+    serial_ops, accel_ops = serial.get(core, []), accel.get(core, [])
+    for ii in range(max(len(serial_ops), len(accel_ops))):
+      s = serial_ops[ii] if ii < len(serial_ops) else None
+      a = accel_ops[ii] if ii < len(accel_ops) else None
+      same = s and a and s[1] == a[1] and (tolerance or s[0] == a[0])
+      if same:
+        continue
+      cycle = min(op[0] for op in (s, a) if op)
+      first_cycle = cycle if first_cycle is None else min(first_cycle, cycle)
+      diffs.append("core {} retired op {} (cycle {}):".format(core, ii, cycle))
+      diffs.append("    serial:      " + ("RETIRE {} {}".format(*s) if s else "<none>"))
+      diffs.append("    accelerated: " + ("RETIRE {} {}".format(*a) if a else "<none>"))
+      break
+  return first_cycle, diffs
+
+def verify():
+  runs_root = args.keep_runs if args.keep_runs else tempfile.mkdtemp(prefix="scarab_verify_")
+  modes = [parse_mode(spec) for spec in (args.mode if args.mode else DEFAULT_MODES)]
+  serial_dir = run("serial", "", runs_root)
+  stats, serial_records = read_stat_records(serial_dir)
+  serial_ops = read_retired_ops(serial_dir)
+  print("serial: {} retired ops, {} stat dumps".format(sum(len(ops) for ops in serial_ops.values()),
+                                                        sum(len(r) for r in serial_records.values())))
+
+  failed = False
+  for name, tolerance, mode_args in modes:
+    accel_dir = run(name, mode_args, runs_root)
+    stats_cycle, stats_diffs = compare_stats(stats, serial_records, read_stat_records(accel_dir)[1], tolerance)
+    ops_cycle, ops_diffs = compare_retired_ops(serial_ops, read_retired_ops(accel_dir), tolerance)
+    kind = "tolerance {:g}".format(tolerance) if tolerance else "exact"
+    if not stats_diffs and not ops_diffs:
+      print("{:12} {:16} OK".format(name, kind))
+      continue
+    failed = True
+    cycles = [c for c in (stats_cycle, ops_cycle) if c is not None]
+    print("{:12} {:16} DIVERGED{}".format(name, kind,
+                                          " at cycle {}".format(min(cycles)) if cycles else ""))
+    for line in stats_diffs + ops_diffs:
+      print("  " + line)
+  if not args.keep_runs:
+    shutil.rmtree(runs_root)
+  return failed
+
+if __name__ == "__main__":
+  args = parser.parse_args()
+  sys.exit(1 if verify() else 0)
@@ -35,14 +35,42 @@
 
 #include "debug/debug_macros.h"
 
+#include "core.param.h"
 #include "memory/memory.param.h"
 #include "ramulator.param.h"
 
+#include "statistics.h"
+
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_ADDR_TRANS, ##args)
 
 DEFINE_ENUM(Addr_Translation, ADDR_TRANSLATION_LIST);
 
+/* A translated page, as remembered by the memo */
+typedef struct Addr_Trans_Memo_Entry_struct {
+  Flag valid;
+  Addr virt_page;
+  Addr phys_page;
+} Addr_Trans_Memo_Entry;
+
 static uns32 hsieh_hash(const char* data, int len);
+static Addr addr_translate_uncached(Addr virt_addr);
+
+/* The translation only depends on the virtual page, so it is remembered per core in a
+ * direct-mapped table indexed by the low bits of the page number */
+static Addr_Trans_Memo_Entry** addr_trans_memo = NULL;
+
+/**************************************************************************************/
+/* init_addr_trans: */
+
+void init_addr_trans() {
+  if (!ADDR_TRANS_MEMO_ENTRIES || ADDR_TRANSLATION == ADDR_TRANS_NONE)
+    return;
+  ASSERTM(0, (ADDR_TRANS_MEMO_ENTRIES & (ADDR_TRANS_MEMO_ENTRIES - 1)) == 0,
+          "ADDR_TRANS_MEMO_ENTRIES must be a power of 2\n");
+  addr_trans_memo = (Addr_Trans_Memo_Entry**)malloc(sizeof(Addr_Trans_Memo_Entry*) * NUM_CORES);
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    addr_trans_memo[proc_id] = (Addr_Trans_Memo_Entry*)calloc(ADDR_TRANS_MEMO_ENTRIES, sizeof(Addr_Trans_Memo_Entry));
+}
 
 /**************************************************************************************/
 /* addr_translate: translate virtual address to physical address */
@@ -50,7 +78,44 @@ static uns32 hsieh_hash(const char* data, int len);
 Addr addr_translate(Addr virt_addr) {
   if (ADDR_TRANSLATION == ADDR_TRANS_NONE)
     return virt_addr;
+  if (!addr_trans_memo)
+    return addr_translate_uncached(virt_addr);
+
+  uns proc_id = get_proc_id_from_cmp_addr(virt_addr);
+  Addr page_offset_mask = N_BIT_MASK(LOG2(VA_PAGE_SIZE_BYTES));
+  Addr virt_page = virt_addr & ~page_offset_mask;
+  Addr_Trans_Memo_Entry* entry = &addr_trans_memo[proc_id][(virt_page / VA_PAGE_SIZE_BYTES) &
+                                                           (ADDR_TRANS_MEMO_ENTRIES - 1)];
+
+  if (entry->valid && entry->virt_page == virt_page) {
+    STAT_EVENT(proc_id, ADDR_TRANS_MEMO_HIT);
+  } else {
+    STAT_EVENT(proc_id, ADDR_TRANS_MEMO_MISS);
+    entry->valid = TRUE;
+    entry->virt_page = virt_page;
+    entry->phys_page = addr_translate_uncached(virt_page);
+  }
+  return entry->phys_page | (virt_addr & page_offset_mask);
+}
+
+/**************************************************************************************/
+/* addr_translate_batch: translate num addresses, e.g. the candidates of a prefetcher.
+ * Runs of addresses in the same page are translated once. */
+
+void addr_translate_batch(const Addr* virt_addrs, Addr* phys_addrs, uns num) {
+  Addr page_offset_mask = N_BIT_MASK(LOG2(VA_PAGE_SIZE_BYTES));
+  for (uns ii = 0; ii < num; ii++) {
+    if (ii > 0 && ((virt_addrs[ii] ^ virt_addrs[ii - 1]) & ~page_offset_mask) == 0)
+      phys_addrs[ii] = (phys_addrs[ii - 1] & ~page_offset_mask) | (virt_addrs[ii] & page_offset_mask);
+    else
+      phys_addrs[ii] = addr_translate(virt_addrs[ii]);
+  }
+}
+
+/**************************************************************************************/
+/* addr_translate_uncached: */
 
+static Addr addr_translate_uncached(Addr virt_addr) {
   /* We fake the virtual->physical address translation by scrambling the addr
    * bits just above the page offset. However, aliasing during the scrambling
    * can end up mapping two distinct virtual pages to the same physical frame.
@@ -44,6 +44,8 @@ DECLARE_ENUM(Addr_Translation, ADDR_TRANSLATION_LIST, ADDR_TRANS_);
 /**************************************************************************************/
 /* Prototypes */
 
+void init_addr_trans(void);
 Addr addr_translate(Addr virt_addr);
+void addr_translate_batch(const Addr* virt_addrs, Addr* phys_addrs, uns num);
 
 #endif  // __ADDR_TRANS_H__
@@ -37,6 +37,7 @@
 #include "debug/debug.param.h"
 #include "debug/debug_macros.h"
 #include "debug/debug_print.h"
+#include "debug/host_prof.h"
 
 #include "bp/bp.param.h"
 #include "core.param.h"
@@ -51,6 +52,7 @@
 #include "frontend/pin_trace_fe.h"
 #include "isa/isa_macros.h"
 #include "libs/cache_lib.h"
+#include "libs/snapshot_lib.h"
 #include "prefetcher/branch_misprediction_table.h"
 #include "prefetcher/fdip.h"
 
@@ -81,8 +83,8 @@ extern void tc_do_stat(Op*, Flag);
 /******************************************************************************/
 /* Global Variables */
 
-Bp_Recovery_Info* bp_recovery_info = NULL;
-Bp_Data* g_bp_data = NULL;
+CORE_LOCAL Bp_Recovery_Info* bp_recovery_info = NULL;
+CORE_LOCAL Bp_Data* g_bp_data = NULL;
 Flag USE_LATE_BP = FALSE;
 extern List op_buf;
 extern uns operating_mode;
@@ -92,6 +94,10 @@ Hash_Table per_branch_stat;
 /******************************************************************************/
 // Local prototypes
 
+static void bp_spec_hist_init(Bp_Spec_Hist* hist, uns num_bits);
+static void bp_spec_hist_push(Bp_Spec_Hist* hist, Flag dir);
+static void bp_spec_hist_rewind(Bp_Spec_Hist* hist, uns32 head);
+
 /******************************************************************************/
 /* set_bp_data set the global bp_data pointer (so I don't have to pass it around
  * everywhere */
@@ -106,6 +112,55 @@ void set_bp_recovery_info(Bp_Recovery_Info* new_bp_recovery_info) {
   bp_recovery_info = new_bp_recovery_info;
 }
 
+/******************************************************************************/
+/* bp_spec_hist_init: allocates a speculative history of at least num_bits bits
+   (rounded up to a power of two of at least one word), all not taken */
+
+static void bp_spec_hist_init(Bp_Spec_Hist* hist, uns num_bits) {
+  uns size = 64;
+  while (size < num_bits)
+    size <<= 1;
+  hist->words = (uns64*)calloc(size / 64, sizeof(uns64));
+  hist->mask = size - 1;
+  hist->head = 0;
+}
+
+/******************************************************************************/
+/* bp_spec_hist_push: shifts a branch direction into the history */
+
+static void bp_spec_hist_push(Bp_Spec_Hist* hist, Flag dir) {
+  const uns32 pos = hist->head & hist->mask;
+  const uns64 bit = 0x1ULL << (pos & 63);
+  hist->words[pos >> 6] = dir ? hist->words[pos >> 6] | bit : hist->words[pos >> 6] & ~bit;
+  hist->head++;
+}
+
+/******************************************************************************/
+/* bp_spec_hist_rewind: drops every bit pushed after head. The bits older than
+   head are still in the buffer as long as it did not wrap around since head
+   was read, so recovery does not depend on how deep the wrong path went. */
+
+static void bp_spec_hist_rewind(Bp_Spec_Hist* hist, uns32 head) {
+  ASSERTM(0, (uns32)(hist->head - head) <= hist->mask + 1 - 64,
+          "Speculative history overwritten before recovery, increase BP_SPEC_HIST_LENGTH\n");
+  hist->head = head;
+}
+
+/******************************************************************************/
+/* bp_spec_hist_read: returns the num_bits (<= 64) most recent bits pushed
+   before head, newest in the most significant bit */
+
+uns64 bp_spec_hist_read(const Bp_Spec_Hist* hist, uns32 head, uns num_bits) {
+  ASSERT(0, num_bits > 0 && num_bits <= 64);
+  const uns32 pos = (head - num_bits) & hist->mask;
+  const uns32 word = pos >> 6;
+  const uns offset = pos & 63;
+  uns64 bits = hist->words[word] >> offset;
+  if (offset && offset + num_bits > 64)
+    bits |= hist->words[(word + 1) & (hist->mask >> 6)] << (64 - offset);
+  return num_bits == 64 ? bits : bits & N_BIT_MASK(num_bits);
+}
+
 /******************************************************************************/
 /*  init_bp_recovery_info */
 
@@ -250,6 +305,7 @@ void init_bp_data(uns8 proc_id, Bp_Data* bp_data) {
   memset(bp_data, 0, sizeof(Bp_Data));
 
   bp_data->proc_id = proc_id;
+  bp_spec_hist_init(&bp_data->spec_hist, BP_SPEC_HIST_LENGTH);
   /* initialize branch predictor */
   bp_data->bp = &bp_table[BP_MECH];
   bp_data->bp->init_func();
@@ -300,6 +356,33 @@ Flag bp_is_predictable(Bp_Data* bp_data, uns proc_id) {
   return !bp_data->bp->full_func(proc_id);
 }
 
+/******************************************************************************/
+/* bp_prefetch_ops: called with the ops of a fetch target before their cf ops
+   are predicted one by one. Each cf op but the last of a fetch target is
+   predicted not taken unless the target gets split, so the global history
+   each conditional branch will see is known up front. This only warms host
+   caches for the BTB and the direction predictor tables, predictions do not
+   change. */
+
+void bp_prefetch_ops(Bp_Data* bp_data, Op* const* ops, uns num_ops) {
+  uns32 hist = bp_data->global_hist;
+  uns ii;
+
+  for (ii = 0; ii < num_ops; ii++) {
+    const Op* op = ops[ii];
+    const Cf_Type cf_type = op->table_info->cf_type;
+    if (!cf_type)
+      continue;
+    if (!PERFECT_BTB)
+      bp_data->bp_btb->prefetch_func(bp_data, op->inst_info->addr);
+    if (cf_type == CF_CBR) {
+      if (bp_data->bp->prefetch_func)
+        bp_data->bp->prefetch_func(bp_data->proc_id, op->inst_info->addr, hist);
+      hist >>= 1;
+    }
+  }
+}
+
 /******************************************************************************/
 /* bp_predict_op:  predicts the target of a control flow instruction */
 
@@ -323,7 +406,7 @@ Addr bp_predict_op(Bp_Data* bp_data, Op* op, uns br_num, Addr fetch_addr) {
      overwritten by a prediction function that uses and
      speculatively updates global history */
   op->recovery_info.proc_id = op->proc_id;
-  op->recovery_info.pred_global_hist = bp_data->global_hist;
+  op->recovery_info.hist_head = bp_data->spec_hist.head;
   op->recovery_info.targ_hist = bp_data->targ_hist;
   op->recovery_info.new_dir = op->oracle_info.dir;
   op->recovery_info.crs_next = bp_data->crs.next;
@@ -395,7 +478,7 @@ Addr bp_predict_op(Bp_Data* bp_data, Op* op, uns br_num, Addr fetch_addr) {
   // btb.  btb_miss and pred_target are set appropriately.
   op->oracle_info.no_target = TRUE;
   op->oracle_info.misfetch = FALSE;
-  btb_target = bp_data->bp_btb->pred_func(bp_data, op);
+  HOST_PROF_SCOPE(bp_data->proc_id, HOST_PROF_BTB, btb_target = bp_data->bp_btb->pred_func(bp_data, op));
   if (btb_target) {
     // btb hit
     op->oracle_info.btb_miss = FALSE;
@@ -485,7 +568,8 @@ Addr bp_predict_op(Bp_Data* bp_data, Op* op, uns br_num, Addr fetch_addr) {
         }
       }
       // Update history used by the rest of Scarab.
-      bp_data->global_hist = (bp_data->global_hist >> 1) | (op->oracle_info.pred << 31);
+      bp_spec_hist_push(&bp_data->spec_hist, op->oracle_info.pred);
+      bp_data->global_hist = bp_spec_hist_read(&bp_data->spec_hist, bp_data->spec_hist.head, 32);
 
       if (op->oracle_info.btb_miss && op->oracle_info.pred == NOT_TAKEN)
         btb_miss_nt = TRUE;
@@ -897,8 +981,7 @@ void bp_target_known_op(Bp_Data* bp_data, Op* op) {
     // For jitted CF we want to update the BTB if the target changes, even on btb hit
     // or For indirects we want to update the BTB if the target changes, even on btb hit
     // The detection relies on the target stored in the btb
-    Addr line_addr;
-    Addr* btb_entry = (Addr*)cache_access(&bp_data->btb, op->oracle_info.pred_addr, &line_addr, FALSE);
+    Addr* btb_entry = bp_data->bp_btb->probe_func(bp_data, op->oracle_info.pred_addr);
     // The following assertion can fail (due to eviction?)
     // ASSERT(bp_data->proc_id, btb_entry);
     if (btb_entry && *btb_entry != op->oracle_info.target) {
@@ -953,6 +1036,23 @@ void bp_retire_op(Bp_Data* bp_data, Op* op) {
   }
 }
 
+/******************************************************************************/
+/* bp_retire_ops: bp_retire_op for the branches among n retiring ops, in program
+ * order
+ */
+
+void bp_retire_ops(Bp_Data* bp_data, Op** ops, uns n) {
+  uns ii;
+  for (ii = 0; ii < n; ii++)
+    if (ops[ii]->table_info->cf_type)
+      bp_data->bp->retire_func(ops[ii]);
+  if (USE_LATE_BP) {
+    for (ii = 0; ii < n; ii++)
+      if (ops[ii]->table_info->cf_type)
+        bp_data->late_bp->retire_func(ops[ii]);
+  }
+}
+
 /******************************************************************************/
 /* bp_recover_op: called on the last mispredicted op when the recovery happens
  */
@@ -961,11 +1061,11 @@ void bp_recover_op(Bp_Data* bp_data, Cf_Type cf_type, Recovery_Info* info) {
   STAT_EVENT(0, PERFORMED_EXEC_RECOVERIES);
   INC_STAT_EVENT(0, PERFORMED_RECOVERY_LAT, cycle_count - info->predict_cycle);
   /* always recover the global history */
+  bp_spec_hist_rewind(&bp_data->spec_hist, info->hist_head);
   if (cf_type == CF_CBR) {
-    bp_data->global_hist = (info->pred_global_hist >> 1) | (info->new_dir << 31);
-  } else {
-    bp_data->global_hist = info->pred_global_hist;
+    bp_spec_hist_push(&bp_data->spec_hist, info->new_dir);
   }
+  bp_data->global_hist = bp_spec_hist_read(&bp_data->spec_hist, bp_data->spec_hist.head, 32);
   bp_data->targ_hist = info->targ_hist;
 
   /* this event counts updates to BP, so it's really branch resolutions */
@@ -988,5 +1088,123 @@ void bp_recover_op(Bp_Data* bp_data, Cf_Type cf_type, Recovery_Info* info) {
     bp_data->br_conf->recover_func();
 
   if (FDIP_DUAL_PATH_PREF_UOC_ONLINE_ENABLE)
-    increment_branch_mispredictions(info->PC);
+    increment_branch_mispredictions(bp_data->proc_id, info->PC);
+}
+
+/******************************************************************************/
+/* bp_train_op: trains the predictors with a correct path cf op whose outcome is
+   already known, as functional warmup does. The op is predicted, resolved,
+   recovered if the prediction was wrong and retired at once, so nothing is
+   left in flight. */
+
+void bp_train_op(Bp_Data* bp_data, Op* op) {
+  bp_predict_op(bp_data, op, 1, op->inst_info->addr);
+  bp_target_known_op(bp_data, op);
+  bp_resolve_op(bp_data, op);
+  if (op->oracle_info.mispred || op->oracle_info.misfetch)
+    bp_recover_op(bp_data, op->table_info->cf_type, &op->recovery_info);
+  bp_data->bp->retire_func(op);
+}
+
+/******************************************************************************/
+/* bp_warmup_op: trains the predictors with a correct path cf op like
+   bp_train_op, but through the train functions of the direction predictors
+   when they all have one. Global history is built from the actual outcome, so
+   nothing is predicted, recovered or counted; the target predictors and the
+   CRS are trained as usual. Falls back to bp_train_op for configurations whose
+   side structures depend on the prediction. */
+
+void bp_warmup_op(Bp_Data* bp_data, Op* op) {
+  const Cf_Type cf_type = op->table_info->cf_type;
+
+  if (!BP_WARMUP_TRAIN || !bp_data->bp->train_func || (USE_LATE_BP && !bp_data->late_bp->train_func) ||
+      PERFECT_BP || BP_HASH_TOS || IBTB_HASH_TOS || ENABLE_BP_CONF || CONFIDENCE_ENABLE ||
+      FDIP_DUAL_PATH_PREF_UOC_ONLINE_ENABLE) {
+    bp_train_op(bp_data, op);
+    return;
+  }
+
+  ASSERT(bp_data->proc_id, bp_data->proc_id == op->proc_id);
+  ASSERT(bp_data->proc_id, cf_type);
+
+  op->oracle_info.pred_addr = op->inst_info->addr;
+  op->oracle_info.pred_global_hist = bp_data->global_hist;
+  op->recovery_info.proc_id = op->proc_id;
+  op->recovery_info.targ_hist = bp_data->targ_hist;
+
+  if (cf_type != CF_SYS) {
+    const Addr pc_plus_offset = ADDR_PLUS_OFFSET(op->inst_info->addr, op->inst_info->trace_info.inst_size);
+    Addr* btb_target = bp_data->bp_btb->pred_func(bp_data, op);
+    op->oracle_info.btb_miss = !btb_target && pc_plus_offset != op->oracle_info.target;
+    if (ENABLE_IBP && (cf_type == CF_IBR || cf_type == CF_ICALL))
+      bp_data->bp_ibtb->pred_func(bp_data, op);
+    if (ENABLE_CRS) {
+      if (cf_type == CF_ICO || cf_type == CF_RET) {
+        if (CRS_REALISTIC)
+          bp_crs_realistic_pop(bp_data, op);
+        else
+          bp_crs_pop(bp_data, op);
+      }
+      if (cf_type == CF_CALL || cf_type == CF_ICALL || cf_type == CF_ICO)
+        CRS_REALISTIC ? bp_crs_realistic_push(bp_data, op) : bp_crs_push(bp_data, op);
+    }
+    bp_target_known_op(bp_data, op);
+  }
+
+  if (cf_type == CF_CBR) {
+    bp_spec_hist_push(&bp_data->spec_hist, op->oracle_info.dir);
+    bp_data->global_hist = bp_spec_hist_read(&bp_data->spec_hist, bp_data->spec_hist.head, 32);
+  }
+
+  bp_data->bp->train_func(op);
+  if (USE_LATE_BP)
+    bp_data->late_bp->train_func(op);
+}
+
+/******************************************************************************/
+/* bp_snapshot: saves or restores the warmed state of the direction, target
+   and return address predictors of a core */
+
+void bp_snapshot(Bp_Data* bp_data, Snapshot* snap) {
+  snapshot_section(snap, "BP");
+  snapshot_check(snap, "BP_MECH", BP_MECH);
+  snapshot_check(snap, "LATE_BP_MECH", LATE_BP_MECH);
+  snapshot_check(snap, "BTB_MECH", BTB_MECH);
+  snapshot_check(snap, "IBTB_MECH", IBTB_MECH);
+
+  ASSERTM(bp_data->proc_id, bp_data->bp->snapshot_func, "Branch predictor %s does not support snapshots\n",
+          bp_data->bp->name);
+  bp_data->bp->snapshot_func(bp_data->proc_id, snap);
+  if (USE_LATE_BP) {
+    ASSERTM(bp_data->proc_id, bp_data->late_bp->snapshot_func, "Branch predictor %s does not support snapshots\n",
+            bp_data->late_bp->name);
+    bp_data->late_bp->snapshot_func(bp_data->proc_id, snap);
+  }
+
+  snapshot_check(snap, "BP_SPEC_HIST_LENGTH", bp_data->spec_hist.mask + 1);
+  snapshot_data(snap, bp_data->spec_hist.words, (bp_data->spec_hist.mask + 1) / 8);
+  SNAPSHOT_VAR(snap, bp_data->spec_hist.head);
+  SNAPSHOT_VAR(snap, bp_data->global_hist);
+  SNAPSHOT_VAR(snap, bp_data->targ_hist);
+  SNAPSHOT_VAR(snap, bp_data->targ_index);
+
+  snapshot_data(snap, bp_data->crs.entries, sizeof(Crs_Entry) * CRS_ENTRIES * 2);
+  snapshot_data(snap, bp_data->crs.off_path, sizeof(Flag) * CRS_ENTRIES);
+  SNAPSHOT_VAR(snap, bp_data->crs.depth);
+  SNAPSHOT_VAR(snap, bp_data->crs.head);
+  SNAPSHOT_VAR(snap, bp_data->crs.tail);
+  SNAPSHOT_VAR(snap, bp_data->crs.tail_save);
+  SNAPSHOT_VAR(snap, bp_data->crs.depth_save);
+  SNAPSHOT_VAR(snap, bp_data->crs.tos);
+  SNAPSHOT_VAR(snap, bp_data->crs.next);
+
+  bp_data->bp_btb->snapshot_func(bp_data, snap);
+
+  /* the tc tables are only allocated by the mechanisms that use them */
+  if (IBTB_MECH == TC_TAGGED_IBTB || IBTB_MECH == TC_HYBRID_IBTB)
+    cache_snapshot(&bp_data->tc_tagged, snap);
+  if (bp_data->tc_tagless)
+    snapshot_data(snap, bp_data->tc_tagless, sizeof(Addr) << IBTB_HIST_LENGTH);
+  if (bp_data->tc_selector)
+    snapshot_data(snap, bp_data->tc_selector, sizeof(uns8) << IBTB_HIST_LENGTH);
 }
@@ -127,6 +127,27 @@ typedef struct Perceptron_struct {
   int32* weights;
 } Perceptron;
 
+/* The speculative global direction history shared by all predictors. Bits are
+   kept in a circular buffer indexed by a running head, so a branch only
+   remembers the head at its prediction and recovery rewinds the head. */
+typedef struct Bp_Spec_Hist_struct {
+  uns64* words;
+  uns32 mask;  // buffer size in bits - 1
+  uns32 head;  // number of bits pushed, modulo 2^32
+} Bp_Spec_Hist;
+
+/* One level of the two-level BTB (bp_targ_mech.c): tags, targets and LRU
+   stamps of set-major entries, indexed by the branch address like the
+   generic BTB. A tag of 0 marks an invalid entry. */
+typedef struct Btb_Level_struct {
+  Addr* tags;
+  Addr* targets;
+  uns64* last_use;
+  uns* links; /* micro-BTB only: index of the main BTB entry each entry mirrors */
+  uns set_mask;
+  uns assoc;
+} Btb_Level;
+
 typedef struct Bp_Data_struct {
   uns proc_id;
   /* predictor data */
@@ -136,8 +157,12 @@ typedef struct Bp_Data_struct {
   struct Bp_Ibtb_struct* bp_ibtb;
   struct Br_Conf_struct* br_conf;
 
-  uns32 global_hist;
+  Bp_Spec_Hist spec_hist;
+  uns32 global_hist;  // the 32 most recent bits of spec_hist, newest in the MSB
   Cache btb;
+  Btb_Level ubtb;
+  Btb_Level main_btb;
+  uns64 btb_clock;
 
   struct {
     Crs_Entry* entries;
@@ -183,6 +208,7 @@ typedef enum Bp_Id_enum {
 
 typedef enum Btb_Id_enum {
   GENERIC_BTB,
+  TWO_LEVEL_BTB,
   NUM_BTB,
 } Btb_Id;
 
@@ -212,6 +238,12 @@ typedef struct Bp_struct {
                                          * updated after retirement*/
   void (*recover_func)(Recovery_Info*); /* called to recover the bp when a misprediction is realized */
   uns8 (*full_func)(uns);
+  void (*snapshot_func)(uns, struct Snapshot_struct*); /* called to save or restore the warmed state of the
+                                                        * predictor (may be NULL) */
+  void (*prefetch_func)(uns, Addr, uns32);             /* called with the address and the expected global history
+                                                        * of a branch before it is predicted (may be NULL) */
+  void (*train_func)(Op*); /* called instead of timestamp through retire to train the tables of a correct path
+                            * branch from its resolved outcome, with no speculative state left behind (may be NULL) */
 } Bp;
 
 typedef struct Bp_Btb_struct {
@@ -221,6 +253,9 @@ typedef struct Bp_Btb_struct {
   Addr* (*pred_func)(Bp_Data*, Op*);              /* called to predict the branch target */
   void (*update_func)(Bp_Data*, Op*);             /* */
   void (*recover_func)(Bp_Data*, Recovery_Info*); /* */
+  Addr* (*probe_func)(Bp_Data*, Addr);            /* called to look up a target without updating replacement */
+  void (*prefetch_func)(Bp_Data*, Addr);          /* called with the address of a branch before it is predicted */
+  void (*snapshot_func)(Bp_Data*, struct Snapshot_struct*); /* called to save or restore the warmed state */
 } Bp_Btb;
 
 typedef struct Bp_Ibtb_struct {
@@ -250,8 +285,8 @@ typedef struct Br_Conf_struct {
 extern Bp bp_table[];
 extern Bp_Btb bp_btb_table[];
 extern Bp_Ibtb bp_ibtb_table[];
-extern Bp_Data* g_bp_data;
-extern Bp_Recovery_Info* bp_recovery_info;
+extern CORE_LOCAL Bp_Data* g_bp_data;
+extern CORE_LOCAL Bp_Recovery_Info* bp_recovery_info;
 extern Br_Conf br_conf_table[];
 
 /**************************************************************************************/
@@ -267,11 +302,18 @@ void bp_sched_redirect(Bp_Recovery_Info*, Op*, Counter);
 void init_bp_data(uns8, Bp_Data*);
 Flag bp_is_predictable(Bp_Data*, uns);
 Addr bp_predict_op(Bp_Data*, Op*, uns, Addr);
+void bp_prefetch_ops(Bp_Data*, Op* const*, uns);
 Addr bp_predict_op_evaluate(Bp_Data* bp_data, Op* op, Addr prediction);
 void bp_target_known_op(Bp_Data*, Op*);
 void bp_resolve_op(Bp_Data*, Op*);
 void bp_retire_op(Bp_Data*, Op*);
+void bp_retire_ops(Bp_Data*, Op**, uns);
 void bp_recover_op(Bp_Data*, Cf_Type, Recovery_Info*);
+void bp_train_op(Bp_Data*, Op*);
+void bp_warmup_op(Bp_Data*, Op*);
+void bp_snapshot(Bp_Data*, struct Snapshot_struct*);
+
+uns64 bp_spec_hist_read(const Bp_Spec_Hist*, uns32, uns);
 
 void inc_bstat_fetched(Op* op);
 void inc_bstat_miss(Op* op);
@@ -0,0 +1,240 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : bp/bp_stream.c
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Branch stream recorder and reader. Each record is a flags
+ *                byte (cf_type in the low nibble, the direction above it), the
+ *                instruction size, and LEB128 varints of the instruction gap,
+ *                the zigzagged pc delta from the previous branch and the
+ *                zigzagged target delta from the pc. Streams are gzipped by an
+ *                Async_Writer, so recording stays off the simulation thread.
+ ***************************************************************************************/
+
+#include "bp/bp_stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_vars.h"
+
+#include "bp/bp.param.h"
+#include "core.param.h"
+#include "general.param.h"
+
+#include "libs/async_writer.h"
+
+/**************************************************************************************/
+/* Stream Format */
+
+#define BP_STREAM_MAGIC "SCARABBS"
+#define BP_STREAM_VERSION 1
+#define BP_STREAM_BUF_SIZE (1 << 20)
+#define BP_STREAM_MAX_RECORD (2 + 3 * 10)  // two bytes and three 64-bit varints
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Bp_Stream_Writer_struct {
+  Async_Writer* writer;
+  Addr last_pc;
+  uns64 inst_gap;
+} Bp_Stream_Writer;
+
+struct Bp_Stream_Reader_struct {
+  gzFile file;
+  uns8* buf;
+  uns pos;
+  uns len;
+  Flag eof;
+  Addr last_pc;
+};
+
+/**************************************************************************************/
+/* Global Variables */
+
+static Bp_Stream_Writer* writers;
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static void bp_stream_write(Bp_Stream_Writer* writer, uns8 cf_type, uns8 dir, uns8 inst_size, Addr pc, Addr target);
+static inline uns put_varint(uns8* buf, uns64 value);
+static inline uns64 get_varint(const uns8* buf, uns* pos);
+static inline uns64 zigzag(int64 value) {
+  return ((uns64)value << 1) ^ (uns64)(value >> 63);
+}
+static inline int64 unzigzag(uns64 value) {
+  return (int64)(value >> 1) ^ -(int64)(value & 1);
+}
+
+/**************************************************************************************/
+/* bp_stream_init: */
+
+void bp_stream_init(void) {
+  if (!BP_STREAM)
+    return;
+
+  writers = (Bp_Stream_Writer*)calloc(NUM_CORES, sizeof(Bp_Stream_Writer));
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    char name[MAX_STR_LENGTH + 1];
+    snprintf(name, MAX_STR_LENGTH, "%s/%sbp_stream.%u.gz", OUTPUT_DIR, FILE_TAG, proc_id);
+    writers[proc_id].writer = async_writer_open(name, BP_STREAM_BUF_SIZE, TRUE);
+    uns32 version = BP_STREAM_VERSION;
+    async_writer_write(writers[proc_id].writer, BP_STREAM_MAGIC, strlen(BP_STREAM_MAGIC));
+    async_writer_write(writers[proc_id].writer, &version, sizeof(version));
+  }
+}
+
+/**************************************************************************************/
+/* bp_stream_op: */
+
+void bp_stream_op(Op* op) {
+  Bp_Stream_Writer* writer = &writers[op->proc_id];
+  if (op->eom)
+    writer->inst_gap++;
+  if (op->table_info->cf_type == NOT_CF)
+    return;
+
+  bp_stream_write(writer, op->table_info->cf_type, op->oracle_info.dir, op->inst_info->trace_info.inst_size,
+                  op->inst_info->addr, op->oracle_info.target);
+}
+
+/**************************************************************************************/
+/* bp_stream_done: */
+
+void bp_stream_done(void) {
+  if (!writers)
+    return;
+
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Bp_Stream_Writer* writer = &writers[proc_id];
+    if (writer->inst_gap)
+      bp_stream_write(writer, NOT_CF, 0, 0, writer->last_pc, writer->last_pc);
+    async_writer_close(writer->writer);
+  }
+  free(writers);
+  writers = NULL;
+}
+
+/**************************************************************************************/
+/* bp_stream_write: */
+
+static void bp_stream_write(Bp_Stream_Writer* writer, uns8 cf_type, uns8 dir, uns8 inst_size, Addr pc, Addr target) {
+  uns8 buf[BP_STREAM_MAX_RECORD];
+  uns len = 0;
+  buf[len++] = cf_type | (dir ? 0x10 : 0);
+  buf[len++] = inst_size;
+  len += put_varint(buf + len, writer->inst_gap);
+  len += put_varint(buf + len, zigzag(pc - writer->last_pc));
+  len += put_varint(buf + len, zigzag(target - pc));
+  async_writer_write(writer->writer, buf, len);
+  writer->last_pc = pc;
+  writer->inst_gap = 0;
+}
+
+/**************************************************************************************/
+/* bp_stream_open: */
+
+Bp_Stream_Reader* bp_stream_open(const char* name) {
+  gzFile file = gzopen(name, "rb");
+  if (!file)
+    return NULL;
+  char magic[sizeof(BP_STREAM_MAGIC) - 1];
+  uns32 version;
+  if (gzread(file, magic, sizeof(magic)) != sizeof(magic) || memcmp(magic, BP_STREAM_MAGIC, sizeof(magic)) ||
+      gzread(file, &version, sizeof(version)) != sizeof(version) || version != BP_STREAM_VERSION) {
+    gzclose(file);
+    return NULL;
+  }
+  gzbuffer(file, BP_STREAM_BUF_SIZE);
+
+  Bp_Stream_Reader* reader = (Bp_Stream_Reader*)calloc(1, sizeof(Bp_Stream_Reader));
+  reader->file = file;
+  reader->buf = (uns8*)malloc(BP_STREAM_BUF_SIZE);
+  return reader;
+}
+
+/**************************************************************************************/
+/* bp_stream_read: FALSE at the end of the stream */
+
+Flag bp_stream_read(Bp_Stream_Reader* reader, Bp_Stream_Branch* branch) {
+  /* keep a whole record in the buffer */
+  if (reader->len - reader->pos < BP_STREAM_MAX_RECORD && !reader->eof) {
+    reader->len -= reader->pos;
+    memmove(reader->buf, reader->buf + reader->pos, reader->len);
+    reader->pos = 0;
+    int bytes = gzread(reader->file, reader->buf + reader->len, BP_STREAM_BUF_SIZE - reader->len);
+    ASSERTM(0, bytes >= 0, "Error reading the branch stream\n");
+    reader->len += bytes;
+    reader->eof = bytes == 0;
+  }
+  if (reader->pos == reader->len)
+    return FALSE;
+  ASSERTM(0, reader->len - reader->pos >= 5, "Truncated branch stream\n");
+
+  uns8 flags = reader->buf[reader->pos++];
+  branch->cf_type = flags & 0xF;
+  branch->dir = (flags >> 4) & 1;
+  branch->inst_size = reader->buf[reader->pos++];
+  branch->inst_gap = get_varint(reader->buf, &reader->pos);
+  branch->pc = reader->last_pc + unzigzag(get_varint(reader->buf, &reader->pos));
+  branch->target = branch->pc + unzigzag(get_varint(reader->buf, &reader->pos));
+  reader->last_pc = branch->pc;
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* bp_stream_close: */
+
+void bp_stream_close(Bp_Stream_Reader* reader) {
+  gzclose(reader->file);
+  free(reader->buf);
+  free(reader);
+}
+
+/**************************************************************************************/
+/* put_varint, get_varint: little-endian base 128 */
+
+static inline uns put_varint(uns8* buf, uns64 value) {
+  uns len = 0;
+  while (value >= 0x80) {
+    buf[len++] = (uns8)value | 0x80;
+    value >>= 7;
+  }
+  buf[len++] = (uns8)value;
+  return len;
+}
+
+static inline uns64 get_varint(const uns8* buf, uns* pos) {
+  uns64 value = 0;
+  for (uns shift = 0;; shift += 7) {
+    uns8 byte = buf[(*pos)++];
+    value |= (uns64)(byte & 0x7F) << shift;
+    if (!(byte & 0x80))
+      return value;
+  }
+}
@@ -0,0 +1,71 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : bp/bp_stream.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Correct path branch stream of each core (BP_STREAM), written
+ *                during warmup and the timed run, and read back by
+ *                scarab_bp_replay to drive the predictors without the pipeline
+ ***************************************************************************************/
+
+#ifndef __BP_STREAM_H__
+#define __BP_STREAM_H__
+
+#include "globals/global_types.h"
+
+#include "op.h"
+
+/**************************************************************************************/
+/* Types */
+
+/* One record of the stream. A record with cf_type NOT_CF only carries the
+   instructions after the last branch, at the end of the stream. */
+typedef struct Bp_Stream_Branch_struct {
+  Addr pc;
+  Addr target;
+  uns64 inst_gap;  // instructions since the previous record, this branch included
+  uns8 cf_type;
+  uns8 dir;
+  uns8 inst_size;
+} Bp_Stream_Branch;
+
+typedef struct Bp_Stream_Reader_struct Bp_Stream_Reader;
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Open OUTPUT_DIR/bp_stream.<proc_id>.gz for each core */
+void bp_stream_init(void);
+
+/* Call for every correct path op in program order, from warmup or retire */
+void bp_stream_op(Op* op);
+
+/* Write the trailing instructions and close the streams */
+void bp_stream_done(void);
+
+/* Reading: open returns NULL if the file is not a branch stream */
+Bp_Stream_Reader* bp_stream_open(const char* name);
+Flag bp_stream_read(Bp_Stream_Reader* reader, Bp_Stream_Branch* branch);
+void bp_stream_close(Bp_Stream_Reader* reader);
+
+#endif /* #ifndef __BP_STREAM_H__ */
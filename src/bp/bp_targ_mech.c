@@ -44,6 +44,7 @@
 #include "bp/bp.h"
 #include "isa/isa_macros.h"
 #include "libs/cache_lib.h"
+#include "libs/snapshot_lib.h"
 
 #include "statistics.h"
 
@@ -55,6 +56,9 @@
 #define DEBUGU_CRS(proc_id, args...) _DEBUGU(proc_id, DEBUG_CRS, ##args)
 #define DEBUG_BTB(proc_id, args...) _DEBUG(proc_id, DEBUG_BTB, ##args)
 
+/* associativity of the micro-BTB of the two-level BTB */
+#define UBTB_ASSOC 4
+
 /**************************************************************************************/
 /* bp_crs_push: */
 
@@ -290,6 +294,192 @@ void bp_btb_gen_update(Bp_Data* bp_data, Op* op) {
   }
 }
 
+/**************************************************************************************/
+/* bp_btb_gen_probe: */
+
+Addr* bp_btb_gen_probe(Bp_Data* bp_data, Addr addr) {
+  Addr line_addr;
+  return (Addr*)cache_access(&bp_data->btb, addr, &line_addr, FALSE);
+}
+
+/**************************************************************************************/
+/* bp_btb_gen_prefetch: */
+
+void bp_btb_gen_prefetch(Bp_Data* bp_data, Addr addr) {
+  cache_prefetch_set(&bp_data->btb, addr);
+}
+
+/**************************************************************************************/
+/* bp_btb_gen_snapshot: */
+
+void bp_btb_gen_snapshot(Bp_Data* bp_data, Snapshot* snap) {
+  cache_snapshot(&bp_data->btb, snap);
+}
+
+/**************************************************************************************/
+/* Two-level BTB: a small micro-BTB in front of the main BTB, both flat arrays of
+   tags and targets indexed by the branch address like the generic BTB, so a
+   lookup is one or two short tag scans instead of a cache_lib access. The
+   micro-BTB is inclusive and a hit in it also refreshes the LRU stamp of the
+   main entry it mirrors, so the two levels predict exactly what the main BTB
+   alone would. */
+
+static void btb_level_init(Btb_Level* level, uns entries, uns assoc, Flag linked) {
+  uns num_sets = entries / assoc;
+  ASSERTM(0, num_sets && num_sets * assoc == entries && !(num_sets & (num_sets - 1)),
+          "BTB of %u entries cannot have a power of 2 number of %u-way sets\n", entries, assoc);
+  level->tags = (Addr*)calloc(entries, sizeof(Addr));
+  level->targets = (Addr*)calloc(entries, sizeof(Addr));
+  level->last_use = (uns64*)calloc(entries, sizeof(uns64));
+  level->links = linked ? (uns*)calloc(entries, sizeof(uns)) : NULL;
+  level->set_mask = num_sets - 1;
+  level->assoc = assoc;
+}
+
+static inline int btb_find_way(const Addr* tags, uns assoc, Addr tag) {
+  for (uns ii = 0; ii < assoc; ii++) {
+    if (tags[ii] == tag)
+      return ii;
+  }
+  return -1;
+}
+
+/* returns the entry index of addr in the main BTB, or -1. The common
+   associativities get their own unrolled scan. */
+static inline int btb_main_find(Btb_Level* level, Addr addr) {
+  uns base = (addr & level->set_mask) * level->assoc;
+  int way;
+  switch (level->assoc) {
+    case 2:
+      way = btb_find_way(&level->tags[base], 2, addr);
+      break;
+    case 4:
+      way = btb_find_way(&level->tags[base], 4, addr);
+      break;
+    case 8:
+      way = btb_find_way(&level->tags[base], 8, addr);
+      break;
+    default:
+      way = btb_find_way(&level->tags[base], level->assoc, addr);
+      break;
+  }
+  return way < 0 ? -1 : (int)base + way;
+}
+
+static inline int btb_ubtb_find(Btb_Level* level, Addr addr) {
+  uns base = (addr & level->set_mask) * UBTB_ASSOC;
+  int way = btb_find_way(&level->tags[base], UBTB_ASSOC, addr);
+  return way < 0 ? -1 : (int)base + way;
+}
+
+/* an invalid entry of the set of addr if there is one, the LRU one otherwise */
+static uns btb_level_victim(Btb_Level* level, Addr addr) {
+  uns base = (addr & level->set_mask) * level->assoc;
+  uns victim = base;
+  for (uns ii = base; ii < base + level->assoc; ii++) {
+    if (!level->tags[ii])
+      return ii;
+    if (level->last_use[ii] < level->last_use[victim])
+      victim = ii;
+  }
+  return victim;
+}
+
+void bp_btb_2lvl_init(Bp_Data* bp_data) {
+  btb_level_init(&bp_data->main_btb, BTB_ENTRIES, BTB_ASSOC, FALSE);
+  btb_level_init(&bp_data->ubtb, UBTB_ENTRIES, UBTB_ASSOC, TRUE);
+  bp_data->btb_clock = 0;
+}
+
+Addr* bp_btb_2lvl_pred(Bp_Data* bp_data, Op* op) {
+  Btb_Level* ubtb = &bp_data->ubtb;
+  Btb_Level* main_btb = &bp_data->main_btb;
+  Addr addr = op->oracle_info.pred_addr;
+
+  if (PERFECT_BTB)
+    return &op->oracle_info.target;
+
+  int idx = btb_ubtb_find(ubtb, addr);
+  if (idx >= 0) {
+    STAT_EVENT(op->proc_id, BTB_UBTB_HIT);
+    ubtb->last_use[idx] = main_btb->last_use[ubtb->links[idx]] = ++bp_data->btb_clock;
+    return &ubtb->targets[idx];
+  }
+
+  int main_idx = btb_main_find(main_btb, addr);
+  if (main_idx < 0) {
+    STAT_EVENT(op->proc_id, BTB_LOOKUP_MISS);
+    return NULL;
+  }
+  STAT_EVENT(op->proc_id, BTB_MAIN_HIT);
+  main_btb->last_use[main_idx] = ++bp_data->btb_clock;
+
+  /* promote into the micro-BTB */
+  idx = btb_level_victim(ubtb, addr);
+  ubtb->tags[idx] = addr;
+  ubtb->targets[idx] = main_btb->targets[main_idx];
+  ubtb->links[idx] = main_idx;
+  ubtb->last_use[idx] = bp_data->btb_clock;
+  return &main_btb->targets[main_idx];
+}
+
+void bp_btb_2lvl_update(Bp_Data* bp_data, Op* op) {
+  Btb_Level* ubtb = &bp_data->ubtb;
+  Btb_Level* main_btb = &bp_data->main_btb;
+  Addr fetch_addr = op->oracle_info.pred_addr;
+
+  ASSERT(bp_data->proc_id, bp_data->proc_id == op->proc_id);
+  if (BTB_OFF_PATH_WRITES || !op->off_path) {
+    DEBUG_BTB(bp_data->proc_id, "Writing BTB  addr:0x%s  target:0x%s\n", hexstr64s(fetch_addr),
+              hexstr64s(op->oracle_info.target));
+    STAT_EVENT(op->proc_id, BTB_ON_PATH_WRITE + op->off_path);
+    ASSERT(bp_data->proc_id, fetch_addr);
+
+    int main_idx = btb_main_find(main_btb, fetch_addr);
+    if (main_idx < 0) {
+      main_idx = btb_level_victim(main_btb, fetch_addr);
+      if (main_btb->tags[main_idx]) {
+        /* keep the micro-BTB inclusive */
+        int evicted = btb_ubtb_find(ubtb, main_btb->tags[main_idx]);
+        if (evicted >= 0)
+          ubtb->tags[evicted] = 0;
+      }
+      main_btb->tags[main_idx] = fetch_addr;
+    }
+    main_btb->targets[main_idx] = op->oracle_info.target;
+    main_btb->last_use[main_idx] = ++bp_data->btb_clock;
+
+    int idx = btb_ubtb_find(ubtb, fetch_addr);
+    if (idx >= 0)
+      ubtb->targets[idx] = op->oracle_info.target;
+  }
+}
+
+Addr* bp_btb_2lvl_probe(Bp_Data* bp_data, Addr addr) {
+  int main_idx = btb_main_find(&bp_data->main_btb, addr);
+  return main_idx < 0 ? NULL : &bp_data->main_btb.targets[main_idx];
+}
+
+void bp_btb_2lvl_prefetch(Bp_Data* bp_data, Addr addr) {
+  __builtin_prefetch(&bp_data->main_btb.tags[(addr & bp_data->main_btb.set_mask) * bp_data->main_btb.assoc]);
+}
+
+void bp_btb_2lvl_snapshot(Bp_Data* bp_data, Snapshot* snap) {
+  Btb_Level* levels[] = {&bp_data->main_btb, &bp_data->ubtb};
+  snapshot_check(snap, "BTB_ENTRIES", BTB_ENTRIES);
+  snapshot_check(snap, "BTB_ASSOC", BTB_ASSOC);
+  snapshot_check(snap, "UBTB_ENTRIES", UBTB_ENTRIES);
+  for (uns ii = 0; ii < 2; ii++) {
+    uns entries = (levels[ii]->set_mask + 1) * levels[ii]->assoc;
+    snapshot_data(snap, levels[ii]->tags, entries * sizeof(Addr));
+    snapshot_data(snap, levels[ii]->targets, entries * sizeof(Addr));
+    snapshot_data(snap, levels[ii]->last_use, entries * sizeof(uns64));
+    if (levels[ii]->links)
+      snapshot_data(snap, levels[ii]->links, entries * sizeof(uns));
+  }
+  SNAPSHOT_VAR(snap, bp_data->btb_clock);
+}
+
 /**************************************************************************************/
 /* bp_tc_tagged_init: */
 
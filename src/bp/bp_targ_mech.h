@@ -45,6 +45,16 @@ void bp_crs_realistic_recover(Bp_Data*, Recovery_Info*);
 void bp_btb_gen_init(Bp_Data*);
 Addr* bp_btb_gen_pred(Bp_Data*, Op*);
 void bp_btb_gen_update(Bp_Data*, Op*);
+Addr* bp_btb_gen_probe(Bp_Data*, Addr);
+void bp_btb_gen_prefetch(Bp_Data*, Addr);
+void bp_btb_gen_snapshot(Bp_Data*, struct Snapshot_struct*);
+
+void bp_btb_2lvl_init(Bp_Data*);
+Addr* bp_btb_2lvl_pred(Bp_Data*, Op*);
+void bp_btb_2lvl_update(Bp_Data*, Op*);
+Addr* bp_btb_2lvl_probe(Bp_Data*, Addr);
+void bp_btb_2lvl_prefetch(Bp_Data*, Addr);
+void bp_btb_2lvl_snapshot(Bp_Data*, struct Snapshot_struct*);
 
 void bp_ibtb_tc_tagged_init(Bp_Data*);
 Addr bp_ibtb_tc_tagged_pred(Bp_Data*, Op*);
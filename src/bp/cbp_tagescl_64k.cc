@@ -1,5 +1,9 @@
 #include "cbp_tagescl_64k.h"
 
+extern "C" {
+#include "libs/mem_footprint.h"
+}
+
 TAGE64K::TAGE64K(void) {
   memset(SizeTable, 0, sizeof(SizeTable));
   memset(NOSKIP, 0, sizeof(NOSKIP));
@@ -47,6 +51,14 @@ TAGE64K::TAGE64K(void) {
   tage_component_tage = 0;
   tage_component_alt = 0;
   reinit();
+
+  // predictors are constructed in core order by CBP_To_Scarab_Intf::init
+  static uns num_instances = 0;
+  uns proc_id = num_instances++;
+  mem_footprint_add("tagescl64k.gtable_low", proc_id, sizeof(cbp64_gentry) * SizeTable[1]);
+  mem_footprint_add("tagescl64k.gtable_high", proc_id, sizeof(cbp64_gentry) * SizeTable[BORN]);
+  mem_footprint_add("tagescl64k.btable", proc_id, sizeof(cbp64_bentry) << LOGB);
+  mem_footprint_add("tagescl64k.state", proc_id, sizeof(TAGE64K));
   // #ifdef PRINTSIZE
   // predictorsize ();
   // #endif
@@ -90,8 +90,8 @@ class cbp64_bentry  // TAGE bimodal table entry
 class cbp64_gentry  // TAGE global table entry
 {
  public:
+  uint16_t tag;  // gtag() is at most TBITS + 4 bits wide; the entry packs into 4 bytes instead of 12
   int8_t ctr;
-  uint tag;
   int8_t u;
 
   cbp64_gentry() {
@@ -76,6 +76,20 @@ class CBP_To_Scarab_Intf {
   void recover(Recovery_Info*) { /* CBP Interface does not support speculative updates */ }
 
   Flag full(uns proc_id) { return cbp_predictors.at(proc_id).IsFull(); }
+
+  void train(Op* op) {
+    uns proc_id = op->proc_id;
+    OpType optype = scarab_to_cbp_optype(op->table_info->cf_type);
+
+    if (is_conditional_branch(op->table_info->cf_type)) {
+      bool pred = cbp_predictors.at(proc_id).GetPrediction(op->inst_info->addr, &op->bp_confidence);
+      cbp_predictors.at(proc_id).UpdatePredictor(op->inst_info->addr, optype, op->oracle_info.dir, pred,
+                                                 op->oracle_info.target);
+    } else {
+      cbp_predictors.at(proc_id).TrackOtherInst(op->inst_info->addr, optype, op->oracle_info.dir,
+                                                op->oracle_info.target);
+    }
+  }
 };
 
 // Specialization for TAGE64K
@@ -182,6 +196,30 @@ void CBP_To_Scarab_Intf<TAGE64K>::timestamp(Op* op) {
   op->recovery_info.branch_id = cbp_predictors.at(proc_id).KeyGeneration();
 }
 
+/* The histories are updated with the resolved direction, as a recovery would,
+ * and the saved states are retired at once, so no checkpoint is taken. */
+template <>
+void CBP_To_Scarab_Intf<TAGE64K>::train(Op* op) {
+  uns proc_id = op->proc_id;
+  auto& predictor = cbp_predictors.at(proc_id);
+  OpType optype = scarab_to_cbp_optype(op->table_info->cf_type);
+  Counter key = predictor.KeyGeneration();
+
+  if (is_conditional_branch(op->table_info->cf_type)) {
+    bool pred = predictor.GetPrediction(op->inst_info->addr, &op->bp_confidence, op);
+    predictor.SavePredictorStates(key);
+    predictor.SpecUpdateAtCond(op->inst_info->addr, op->oracle_info.dir, false);
+    predictor.SpecUpdate(op->inst_info->addr, optype, op->oracle_info.dir, op->oracle_info.target);
+    predictor.NonSpecUpdateAtCond(op->inst_info->addr, optype, op->oracle_info.dir, pred, op->oracle_info.target, key);
+  } else {
+    predictor.SavePredictorStates(key);
+    predictor.SpecUpdate(op->inst_info->addr, optype, op->oracle_info.dir, op->oracle_info.target);
+    predictor.TrackOtherInst(op->inst_info->addr, optype, op->oracle_info.dir, op->oracle_info.target);
+  }
+  if (SPEC_LEVEL != BP_PRED_ON)
+    predictor.RetireCheckpoint(key);
+}
+
 /******DO NOT MODIFY BELOW THIS POINT*****/
 
 /**
@@ -208,7 +246,8 @@ void CBP_To_Scarab_Intf<TAGE64K>::timestamp(Op* op) {
   SCARAB_BP_INTF_FUNC_IMPL(CBP_CLASS, update, , void, Op*, op)               \
   SCARAB_BP_INTF_FUNC_IMPL(CBP_CLASS, retire, , void, Op*, op)               \
   SCARAB_BP_INTF_FUNC_IMPL(CBP_CLASS, recover, , void, Recovery_Info*, info) \
-  SCARAB_BP_INTF_FUNC_IMPL(CBP_CLASS, full, return, Flag, uns, proc_id)
+  SCARAB_BP_INTF_FUNC_IMPL(CBP_CLASS, full, return, Flag, uns, proc_id)      \
+  SCARAB_BP_INTF_FUNC_IMPL(CBP_CLASS, train, , void, Op*, op)
 
 #include "cbp_table.def"
 
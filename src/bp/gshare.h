@@ -37,6 +37,9 @@ void bp_gshare_update(Op*);
 void bp_gshare_retire(Op*);
 void bp_gshare_recover(Recovery_Info*);
 uns8 bp_gshare_full(uns);
+void bp_gshare_snapshot(uns, struct Snapshot_struct*);
+void bp_gshare_prefetch(uns, Addr, uns32);
+void bp_gshare_train(Op*);
 
 #ifdef __cplusplus
 }
@@ -28,7 +28,6 @@ extern "C" {
 
 #include "bp/bp.param.h"
 
-#include "libs/cache_lib.h"
 #include "libs/hash_lib.h"
 
 #include "statistics.h"
@@ -49,11 +48,11 @@ struct Hybridgp_In_Flight_State {
 };
 
 struct Hybridgp_State {
-  Cache bht;
+  Lru_Tagged_Table<uns32> bht;
   Hash_Table bht_hash;
-  std::vector<uns8> hybspht;
-  std::vector<uns8> hybgpht;
-  std::vector<uns8> hybppht;
+  Packed_Counters hybspht;
+  Packed_Counters hybgpht;
+  Packed_Counters hybppht;
   Hash_Table hybgpht_hash;
   std::vector<uns32> filter;
 
@@ -78,8 +77,7 @@ uns32* get_local_history_entry(Hybridgp_State& hybridgp_state, const Addr addr)
     return local_hist_entry;
 
   } else {
-    Addr bht_line_addr;
-    return (uns32*)cache_access(&hybridgp_state.bht, addr, &bht_line_addr, TRUE);
+    return hybridgp_state.bht.lookup(addr);
   }
 }
 
@@ -99,9 +97,7 @@ void update_local_history(Hybridgp_State& hybridgp_state, const uns proc_id, con
     *local_history_entry |= new_dir << 31;
   } else {
     ASSERT(proc_id, INF_HYBRIDGP == FALSE);
-    Addr bht_line_addr, repl_line_addr;
-    uns32* bht_line = (uns32*)cache_insert(&hybridgp_state.bht, proc_id, addr, &bht_line_addr, &repl_line_addr);
-    *bht_line = new_dir << 31;
+    *hybridgp_state.bht.insert(addr) = new_dir << 31;
   }
 }
 
@@ -204,12 +200,10 @@ void update_loop_filter(Op* op, Hybridgp_State& hybridgp_state, const uns32 filt
 }
 
 bool get_spred(const Hybridgp_State& hybridgp_state, const uns32 spht_index) {
-  const auto spht_entry = hybridgp_state.hybspht[spht_index];
-  return spht_entry >> (PHT_CTR_BITS - 1);
+  return hybridgp_state.hybspht.msb(spht_index);
 }
 
 bool get_gpred(Op* op, Hybridgp_State& hybridgp_state, const Addr addr, const uns32 gpht_index) {
-  uns8 gpht_entry;
   if (INF_HYBRIDGP) {
     Flag new_entry;
     const int64 key = addr << 32 | (Addr)op->oracle_info.pred_global_hist;
@@ -217,41 +211,37 @@ bool get_gpred(Op* op, Hybridgp_State& hybridgp_state, const Addr addr, const un
     if (new_entry) {
       *entry = PHT_INIT_VALUE;
     }
-    gpht_entry = *entry;
     op->oracle_info.pred_gpht_entry = entry;  // need for update
-  } else {
-    gpht_entry = hybridgp_state.hybgpht[gpht_index];
+    return *entry >> (PHT_CTR_BITS - 1);
   }
-  return gpht_entry >> (PHT_CTR_BITS - 1);
+  return hybridgp_state.hybgpht.msb(gpht_index);
 }
 
 bool get_ppred(const Hybridgp_State& hybridgp_state, const uns32 ppht_index) {
-  const auto ppht_entry = hybridgp_state.hybppht[ppht_index];
-  return ppht_entry >> (PHT_CTR_BITS - 1);
+  return hybridgp_state.hybppht.msb(ppht_index);
 }
 
 void update_all_phts(const Op* op, Hybridgp_State& hybridgp_state, const Hybridgp_Indices& indices) {
-  uns8* gpht_entry = INF_HYBRIDGP ? op->oracle_info.pred_gpht_entry : &hybridgp_state.hybgpht[indices.gpht];
-  uns8* spht_entry = &hybridgp_state.hybspht[indices.spht];
-  uns8* ppht_entry = &hybridgp_state.hybppht[indices.ppht];
-
-  const uns8 gpred = USE_FILTER ? (*gpht_entry >> (PHT_CTR_BITS - 1)) : op->oracle_info.hybridgp_gpred;
-  const uns8 ppred = *ppht_entry >> (PHT_CTR_BITS - 1);
+  const Flag dir = op->oracle_info.dir;
+  uns8 gpred;
 
   DEBUG(op->proc_id, "Writing hybridgp PHT for op_num:%s\n", unsstr64(op->op_num));
 
-  if (op->oracle_info.dir) {
-    *gpht_entry = SAT_INC(*gpht_entry, N_BIT_MASK(PHT_CTR_BITS));
-    *ppht_entry = SAT_INC(*ppht_entry, N_BIT_MASK(PHT_CTR_BITS));
+  if (INF_HYBRIDGP) {
+    uns8* gpht_entry = op->oracle_info.pred_gpht_entry;
+    gpred = USE_FILTER ? (*gpht_entry >> (PHT_CTR_BITS - 1)) : op->oracle_info.hybridgp_gpred;
+    *gpht_entry = dir ? SAT_INC(*gpht_entry, N_BIT_MASK(PHT_CTR_BITS)) : SAT_DEC(*gpht_entry, 0);
   } else {
-    *gpht_entry = SAT_DEC(*gpht_entry, 0);
-    *ppht_entry = SAT_DEC(*ppht_entry, 0);
+    gpred = USE_FILTER ? hybridgp_state.hybgpht.msb(indices.gpht) : op->oracle_info.hybridgp_gpred;
+    hybridgp_state.hybgpht.update(indices.gpht, dir);
   }
+  const uns8 ppred = hybridgp_state.hybppht.msb(indices.ppht);
+  hybridgp_state.hybppht.update(indices.ppht, dir);
 
-  if ((gpred == op->oracle_info.dir) && (ppred != op->oracle_info.dir)) {
-    *spht_entry = SAT_INC(*spht_entry, N_BIT_MASK(PHT_CTR_BITS));
-  } else if ((gpred != op->oracle_info.dir) && (ppred == op->oracle_info.dir)) {
-    *spht_entry = SAT_DEC(*spht_entry, 0);
+  if ((gpred == dir) && (ppred != dir)) {
+    hybridgp_state.hybspht.update(indices.spht, true);
+  } else if ((gpred != dir) && (ppred == dir)) {
+    hybridgp_state.hybspht.update(indices.spht, false);
   }
 }
 
@@ -262,16 +252,16 @@ void bp_hybridgp_init() {
     hybridgp_state_all_cores.emplace_back(NODE_TABLE_SIZE);
   }
   for (auto& hybridgp_state : hybridgp_state_all_cores) {
-    hybridgp_state.hybspht.resize(1 << HYBRIDS_INDEX_LENGTH, PHT_INIT_VALUE);
-    hybridgp_state.hybppht.resize(1 << HYBRIDP_HIST_LENGTH, PHT_INIT_VALUE);
+    hybridgp_state.hybspht.init(1 << HYBRIDS_INDEX_LENGTH, PHT_CTR_BITS, PHT_INIT_VALUE);
+    hybridgp_state.hybppht.init(1 << HYBRIDP_HIST_LENGTH, PHT_CTR_BITS, PHT_INIT_VALUE);
     if (INF_HYBRIDGP) {
       // only the gpht and the bht are interference free
       init_hash_table(&hybridgp_state.bht_hash, "", 1 << 16, sizeof(uns32));
       init_hash_table(&hybridgp_state.hybgpht_hash, "", 1 << 16, sizeof(uns8));
     } else {
-      // line size for table set to 1
-      init_cache(&hybridgp_state.bht, "BHT", BHT_ENTRIES, BHT_ASSOC, 1, sizeof(Addr), REPL_TRUE_LRU);
-      hybridgp_state.hybgpht.resize(1 << HYBRIDG_HIST_LENGTH, PHT_INIT_VALUE);
+      // tagged with the whole branch address, like a cache with 1 byte lines
+      hybridgp_state.bht.init(BHT_ENTRIES, BHT_ASSOC);
+      hybridgp_state.hybgpht.init(1 << HYBRIDG_HIST_LENGTH, PHT_CTR_BITS, PHT_INIT_VALUE);
     }
 
     hybridgp_state.filter.resize(1 << FILTER_INDEX_LENGTH, 0);
@@ -394,8 +384,7 @@ void bp_hybridgp_recover(Recovery_Info* recovery_info) {
   uns32* local_history_entry = get_local_history_entry(hybridgp_state, addr);
   if (!local_history_entry) {
     ASSERT(proc_id, INF_HYBRIDGP == FALSE);
-    Addr bht_line_addr, repl_line_addr;
-    local_history_entry = (uns32*)cache_insert(&hybridgp_state.bht, proc_id, addr, &bht_line_addr, &repl_line_addr);
+    local_history_entry = hybridgp_state.bht.insert(addr);
   }
   *local_history_entry = (hybridgp_state.in_flight[branch_id].pred_phist >> 1) | (recovery_info->new_dir << 31);
 }
@@ -17,6 +17,11 @@
 
 #include "bp/bp.param.h"
 
+extern "C" {
+#include "libs/malloc_lib.h"
+#include "libs/mem_footprint.h"
+}
+
 // for my personal statistics
 int XX, YY, ZZ, TT;
 void PrintStat(double NUMINST) {
@@ -637,7 +642,6 @@ gentry::gentry() {
 }
 
 tage::tage() {
-  b = NULL;
   g = NULL;
   gi = NULL;
   postp = NULL;
@@ -697,13 +701,14 @@ void tage::init(const char* nm, int ng, int logb, int logg, int tagb, int ctrb,
   ctrbits = ctrb;
   postpbits = ppb;
   postpsize = 1 << (2 * ctrbits + 1);
-  b = new int8_t[bsize];
-  for (int i = 0; i < bsize; i++) {
-    b[i] = 0;
-  }
+  MTAGE_ASSERT(ctrbits == CTRBITS);
+  b.init(bsize);
+  // an all-zero gentry is the reset state, so the tagged tables come zeroed
+  // from lazy_calloc instead of being constructed, and only the entries a run
+  // allocates become resident
   g = new gentry*[numg];
   for (int i = 0; i < numg; i++) {
-    g[i] = new gentry[gsize];
+    g[i] = (gentry*)lazy_calloc(gsize, sizeof(gentry));
   }
   gi = new int[numg];
   postp = new int8_t[postpsize];
@@ -731,7 +736,7 @@ int tage::postp_index() {
   // post predictor index function
   int ctr[2];
   for (int i = 0; i < 2; i++) {
-    ctr[i] = (i < (int)hit.size()) ? getg(hit[i]).ctr : b[bi];
+    ctr[i] = (i < (int)hit.size()) ? getg(hit[i]).ctr : b.get(bi);
   }
   int v = 0;
   for (int i = 1; i >= 0; i--) {
@@ -761,8 +766,8 @@ bool tage::condbr_predict(uint64_t pc, subpath& p) {
     }
   }
 
-  predtaken = (hit.size() > 0) ? (getg(hit[0]).ctr >= 0) : (b[bi] >= 0);
-  altpredtaken = (hit.size() > 1) ? (getg(hit[1]).ctr >= 0) : (b[bi] >= 0);
+  predtaken = (hit.size() > 0) ? (getg(hit[0]).ctr >= 0) : (b.get(bi) >= 0);
+  altpredtaken = (hit.size() > 1) ? (getg(hit[1]).ctr >= 0) : (b.get(bi) >= 0);
   ppi = postp_index();
   MTAGE_ASSERT(ppi < postpsize);
   postpredtaken = (postp[ppi] >= 0);
@@ -805,7 +810,7 @@ void tage::aggressive_update(uint64_t pc, bool taken, subpath& p) {
         allsat &= ctrupdate(getg(hit[1]).ctr, taken, ctrbits);
       } else {
         Done = true;
-        allsat &= ctrupdate(b[bi], taken, ctrbits);
+        allsat &= b.sat_update(bi, taken);
       }
     }
 
@@ -819,10 +824,10 @@ void tage::aggressive_update(uint64_t pc, bool taken, subpath& p) {
         }
       }
     if (!Done)
-      if ((b[bi] >= 0) == inter)
-        allsat &= ctrupdate(b[bi], taken, ctrbits);
+      if ((b.get(bi) >= 0) == inter)
+        allsat &= b.sat_update(bi, taken);
   } else {
-    ctrupdate(b[bi], taken, ctrbits);
+    b.sat_update(bi, taken);
   }
 
   int i = (hit.size() > 0) ? hit[0] : numg;
@@ -846,11 +851,11 @@ void tage::careful_update(uint64_t pc, bool taken, subpath& p) {
       if (hit.size() > 1) {
         ctrupdate(getg(hit[1]).ctr, taken, ctrbits);
       } else {
-        ctrupdate(b[bi], taken, ctrbits);
+        b.sat_update(bi, taken);
       }
     }
   } else {
-    ctrupdate(b[bi], taken, ctrbits);
+    b.sat_update(bi, taken);
   }
 
   if (mispred) {
@@ -928,6 +933,47 @@ void folded_history::update(uint8_t* h, int PT) {
 /////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////
 
+// Halves the largest tagged or bimodal table until the tables of all the
+// tages fit in MTAGE_MAX_MB. Tables are never shrunk below 2^MIN_CAPPED_LOG
+// entries, so a cap that is too small only warns.
+#define MIN_CAPPED_LOG 10
+
+static uns64 tagged_bytes(int numg, int logg) {
+  return ((uns64)numg << logg) * sizeof(gentry);
+}
+
+static uns64 bimodal_bytes(int logb) {
+  return ((uns64)1 << logb) * CTRBITS / 8;
+}
+
+static void cap_table_sizes(const int numg[], int logb[], int logg[]) {
+  uns64 cap = (uns64)MTAGE_MAX_MB << 20;
+  while (true) {
+    uns64 total = 0;
+    uns64 largest = 0;
+    int* largest_log = NULL;
+    for (int i = 0; i < NPRED; i++) {
+      total += tagged_bytes(numg[i], logg[i]) + bimodal_bytes(logb[i]);
+      if (logg[i] > MIN_CAPPED_LOG && tagged_bytes(numg[i], logg[i]) > largest) {
+        largest = tagged_bytes(numg[i], logg[i]);
+        largest_log = &logg[i];
+      }
+      if (logb[i] > MIN_CAPPED_LOG && bimodal_bytes(logb[i]) > largest) {
+        largest = bimodal_bytes(logb[i]);
+        largest_log = &logb[i];
+      }
+    }
+    if (total <= cap)
+      return;
+    if (!largest_log) {
+      fprintf(stderr, "MTAGE tables need %llu MB at their minimum size, over MTAGE_MAX_MB\n",
+              (unsigned long long)(total >> 20));
+      return;
+    }
+    (*largest_log)--;
+  }
+}
+
 MTAGE::MTAGE(void) {
   // NUMG = number of tagged tables
   // LOGB = log2 of the number of entries of the tagless (bimodal) table
@@ -970,24 +1016,45 @@ MTAGE::MTAGE(void) {
     TAGBITS = 12;
   }
 
-  sp[0].init(P0_SPSIZE, P0_NUMG, P0_MINHIST, P0_MAXHIST, P0_LOGG, TAGBITS, PATHBITS, P0_HASHPARAM);
-  sp[1].init(P1_SPSIZE, P1_NUMG, P1_MINHIST, P1_MAXHIST, P1_LOGG, TAGBITS, PATHBITS, P1_HASHPARAM);
-  sp[2].init(P2_SPSIZE, P2_NUMG, P2_MINHIST, P2_MAXHIST, P2_LOGG, TAGBITS, PATHBITS, P2_HASHPARAM);
-  sp[3].init(P3_SPSIZE, P3_NUMG, P3_MINHIST, P3_MAXHIST, P3_LOGG, TAGBITS, PATHBITS, P3_HASHPARAM);
-  sp[4].init(P4_SPSIZE, P4_NUMG, P4_MINHIST, P4_MAXHIST, P4_LOGG, TAGBITS, PATHBITS, P4_HASHPARAM);
-  sp[5].init(P5_SPSIZE, P5_NUMG, P5_MINHIST, P5_MAXHIST, P5_LOGG, TAGBITS, PATHBITS, P5_HASHPARAM);
+  const int numg[NPRED] = {P0_NUMG, P1_NUMG, P2_NUMG, P3_NUMG, P4_NUMG, P5_NUMG};
+  int logb[NPRED] = {P0_LOGB, P1_LOGB, P2_LOGB, P3_LOGB, P4_LOGB, P5_LOGB};
+  int logg[NPRED] = {P0_LOGG, P1_LOGG, P2_LOGG, P3_LOGG, P4_LOGG, P5_LOGG};
+  if (MTAGE_MAX_MB)
+    cap_table_sizes(numg, logb, logg);
 
-  pred[0].init("G", P0_NUMG, P0_LOGB, P0_LOGG, TAGBITS, CTRBITS, POSTPBITS, P0_RAMPUP, CAPHIST);
-  pred[1].init("A", P1_NUMG, P1_LOGB, P1_LOGG, TAGBITS, CTRBITS, POSTPBITS, P1_RAMPUP, CAPHIST);
-  pred[2].init("S", P2_NUMG, P2_LOGB, P2_LOGG, TAGBITS, CTRBITS, POSTPBITS, P2_RAMPUP, CAPHIST);
-  pred[3].init("s", P3_NUMG, P3_LOGB, P3_LOGG, TAGBITS, CTRBITS, POSTPBITS, P3_RAMPUP, CAPHIST);
-  pred[4].init("F", P4_NUMG, P4_LOGB, P4_LOGG, TAGBITS, CTRBITS, POSTPBITS, P4_RAMPUP, CAPHIST);
+  sp[0].init(P0_SPSIZE, P0_NUMG, P0_MINHIST, P0_MAXHIST, logg[0], TAGBITS, PATHBITS, P0_HASHPARAM);
+  sp[1].init(P1_SPSIZE, P1_NUMG, P1_MINHIST, P1_MAXHIST, logg[1], TAGBITS, PATHBITS, P1_HASHPARAM);
+  sp[2].init(P2_SPSIZE, P2_NUMG, P2_MINHIST, P2_MAXHIST, logg[2], TAGBITS, PATHBITS, P2_HASHPARAM);
+  sp[3].init(P3_SPSIZE, P3_NUMG, P3_MINHIST, P3_MAXHIST, logg[3], TAGBITS, PATHBITS, P3_HASHPARAM);
+  sp[4].init(P4_SPSIZE, P4_NUMG, P4_MINHIST, P4_MAXHIST, logg[4], TAGBITS, PATHBITS, P4_HASHPARAM);
+  sp[5].init(P5_SPSIZE, P5_NUMG, P5_MINHIST, P5_MAXHIST, logg[5], TAGBITS, PATHBITS, P5_HASHPARAM);
 
-  pred[5].init("g", P5_NUMG, P5_LOGB, P5_LOGG, TAGBITS, CTRBITS, POSTPBITS, P5_RAMPUP, CAPHIST);
+  pred[0].init("G", P0_NUMG, logb[0], logg[0], TAGBITS, CTRBITS, POSTPBITS, P0_RAMPUP, CAPHIST);
+  pred[1].init("A", P1_NUMG, logb[1], logg[1], TAGBITS, CTRBITS, POSTPBITS, P1_RAMPUP, CAPHIST);
+  pred[2].init("S", P2_NUMG, logb[2], logg[2], TAGBITS, CTRBITS, POSTPBITS, P2_RAMPUP, CAPHIST);
+  pred[3].init("s", P3_NUMG, logb[3], logg[3], TAGBITS, CTRBITS, POSTPBITS, P3_RAMPUP, CAPHIST);
+  pred[4].init("F", P4_NUMG, logb[4], logg[4], TAGBITS, CTRBITS, POSTPBITS, P4_RAMPUP, CAPHIST);
+
+  pred[5].init("g", P5_NUMG, logb[5], logg[5], TAGBITS, CTRBITS, POSTPBITS, P5_RAMPUP, CAPHIST);
 
   bfreq.init(P4_SPSIZE);  // number of frequency bins = P4 spectrum size
 
   initSC();
+
+  // predictors are constructed in core order by CBP_To_Scarab_Intf::init
+  static uns num_instances = 0;
+  uns proc_id = num_instances++;
+  if (MTAGE_MAX_MB && proc_id == 0) {
+    printf("MTAGE tables capped at %u MB (log2 bimodal/tagged entries):", MTAGE_MAX_MB);
+    for (int i = 0; i < NPRED; i++)
+      printf(" %s %d/%d", pred[i].name.c_str(), logb[i], logg[i]);
+    printf("\n");
+  }
+  for (int i = 0; i < NPRED; i++) {
+    string prefix = "mtage." + pred[i].name;
+    mem_footprint_add((prefix + ".bimodal").c_str(), proc_id, pred[i].b.bytes());
+    mem_footprint_add((prefix + ".tagged").c_str(), proc_id, (uns64)pred[i].numg * pred[i].gsize * sizeof(gentry));
+  }
 }
 
 bool MTAGE::GetPrediction(UINT64 PC, int* bp_confidence) {
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "cbp_to_scarab.h"
+#include "libs/packed_array.h"
 #include "stdint.h"
 #include "stdio.h"
 
@@ -256,7 +257,7 @@ class tage {
  public:
   string name;
 
-  int8_t* b;   // tagless (bimodal) table
+  Packed_Ctr_Array<CTRBITS> b;  // tagless (bimodal) table
   gentry** g;  // tagged tables
   int bi;
   int* gi;
@@ -0,0 +1,218 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : bp/replay/bp_replay.cc
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : scarab_bp_replay: drives the branch predictor of each
+ *                configuration from a branch stream recorded with BP_STREAM,
+ *                the way warmup trains it (predict, resolve, recover on a
+ *                misprediction, retire), and reports its MPKI. Configurations
+ *                are Scarab parameter lists separated by "--"; each runs in
+ *                its own process, up to -j at a time:
+ *
+ *                  scarab_bp_replay -j 4 bp_stream.0.gz --bp_mech tage64k -- --bp_mech gshare
+ *
+ *                PARAMS.in in the working directory applies to every one.
+ ***************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+extern "C" {
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "bp/bp.param.h"
+#include "core.param.h"
+#include "general.param.h"
+
+#include "bp/bp.h"
+#include "bp/bp_stream.h"
+#include "param_parser.h"
+#include "sim.h"
+#include "statistics.h"
+}
+
+namespace {
+
+struct Replay_Result {
+  uint64_t insts = 0;
+  uint64_t branches = 0;
+  uint64_t cond_branches = 0;
+  uint64_t mispreds = 0;
+  uint64_t misfetches = 0;
+  double seconds = 0;
+};
+
+double wall_seconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/* One op, reused for every branch of the stream on core 0 */
+Replay_Result replay(const char* stream_name) {
+  Bp_Stream_Reader* reader = bp_stream_open(stream_name);
+  if (!reader) {
+    fprintf(stderr, "scarab_bp_replay: %s is not a branch stream\n", stream_name);
+    exit(1);
+  }
+  ASSERTM(0, !CONFIDENCE_ENABLE, "scarab_bp_replay does not support CONFIDENCE_ENABLE\n");
+
+  static Bp_Recovery_Info recovery_info;
+  static Bp_Data bp_data;
+  init_bp_recovery_info(0, &recovery_info);
+  set_bp_recovery_info(&recovery_info);
+  init_bp_data(0, &bp_data);
+
+  static Inst_Info inst_info;
+  static Table_Info table_info;
+  static Op op;
+  op.inst_info = &inst_info;
+  op.table_info = &table_info;
+  op.proc_id = 0;
+
+  Replay_Result result;
+  Bp_Stream_Branch branch;
+  double start = wall_seconds();
+  while (bp_stream_read(reader, &branch)) {
+    result.insts += branch.inst_gap;
+    if (branch.cf_type == NOT_CF)
+      continue;
+
+    inst_info.addr = branch.pc;
+    inst_info.trace_info.inst_size = branch.inst_size;
+    table_info.cf_type = (Cf_Type)branch.cf_type;
+    memset(&op.oracle_info, 0, sizeof(op.oracle_info));
+    op.oracle_info.dir = branch.dir;
+    op.oracle_info.target = branch.target;
+    op.oracle_info.npc = branch.dir ? branch.target : ADDR_PLUS_OFFSET(branch.pc, branch.inst_size);
+    op.op_num = op.unique_num = ++result.branches;
+    cycle_count = result.branches;
+
+    bp_train_op(&bp_data, &op);
+    result.cond_branches += table_info.cf_type == CF_CBR;
+    result.mispreds += op.oracle_info.mispred;
+    result.misfetches += op.oracle_info.misfetch;
+  }
+  result.seconds = wall_seconds() - start;
+  bp_stream_close(reader);
+  return result;
+}
+
+/* Runs in the child process of one configuration */
+void run_config(const char* prog, const char* stream_name, const std::vector<std::string>& config) {
+  std::vector<std::string> args = config;
+  std::vector<char*> argv;
+  argv.push_back((char*)prog);
+  for (std::string& arg : args)
+    argv.push_back(&arg[0]);
+  argv.push_back(NULL);
+
+  mystdout = stdout;
+  mystderr = stderr;
+  mystatus = NULL;
+  get_params(argv.size() - 1, argv.data());
+  init_global_counter();
+  init_global_stats_array();
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    init_global_stats(proc_id);
+
+  Replay_Result r = replay(stream_name);
+  std::string name;
+  for (const std::string& arg : config)
+    name += (name.empty() ? "" : " ") + arg;
+  printf("%-40s %14llu %12llu %12llu %10llu %10llu %8.3f %8.1f\n", name.empty() ? "(defaults)" : name.c_str(),
+         (unsigned long long)r.insts, (unsigned long long)r.branches, (unsigned long long)r.cond_branches,
+         (unsigned long long)r.mispreds, (unsigned long long)r.misfetches,
+         r.insts ? 1000.0 * r.mispreds / r.insts : 0.0, r.seconds > 0 ? r.branches / r.seconds * 1e-6 : 0.0);
+  fflush(stdout);
+}
+
+void usage(const char* prog) {
+  fprintf(stderr, "usage: %s [-j <jobs>] <bp_stream.N.gz> [<params>] [-- <params>]...\n", prog);
+  exit(1);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  int ii = 1;
+  long jobs = 1;
+  if (ii + 1 < argc && !strcmp(argv[ii], "-j")) {
+    jobs = strtol(argv[ii + 1], NULL, 10);
+    ii += 2;
+  }
+  if (ii >= argc || jobs < 1)
+    usage(argv[0]);
+  const char* stream_name = argv[ii++];
+
+  std::vector<std::vector<std::string>> configs(1);
+  for (; ii < argc; ii++) {
+    if (!strcmp(argv[ii], "--"))
+      configs.emplace_back();
+    else
+      configs.back().push_back(argv[ii]);
+  }
+
+  printf("%-40s %14s %12s %12s %10s %10s %8s %8s\n", "config", "insts", "branches", "cond", "mispred", "misfetch",
+         "MPKI", "Mbr/s");
+  fflush(stdout);
+
+  /* the parameters are globals, so each configuration gets a process */
+  long running = 0;
+  int failed = 0;
+  for (const std::vector<std::string>& config : configs) {
+    if (running == jobs) {
+      int status;
+      wait(&status);
+      failed |= !WIFEXITED(status) || WEXITSTATUS(status);
+      running--;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+      perror("fork");
+      return 1;
+    }
+    if (pid == 0) {
+      run_config(argv[0], stream_name, config);
+      exit(0);
+    }
+    running++;
+  }
+  for (; running; running--) {
+    int status;
+    wait(&status);
+    failed |= !WIFEXITED(status) || WEXITSTATUS(status);
+  }
+  return failed;
+}
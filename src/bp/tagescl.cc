@@ -30,6 +30,7 @@ extern "C" {
 #include "bp.param.h"
 #include "core.param.h"
 
+#include "libs/snapshot_lib.h"
 #include "table_info.h"
 }
 
@@ -68,6 +69,16 @@ Branch_Type get_branch_type(uns proc_id, Cf_Type cf_type) {
   }
   return br_type;
 }
+
+// Passes the predictor tables through a snapshot file.
+class Snapshot_Transfer : public State_Transfer {
+ public:
+  explicit Snapshot_Transfer(Snapshot* snap) : snap_(snap) {}
+  void operator()(void* data, size_t bytes) override { snapshot_data(snap_, data, bytes); }
+
+ private:
+  Snapshot* snap_;
+};
 }  // end of anonymous namespace
 
 void bp_tagescl_init() {
@@ -121,6 +132,29 @@ void bp_tagescl_recover(Recovery_Info* recovery_info) {
                                                                 recovery_info->new_dir, recovery_info->branchTarget);
 }
 
+/* Speculating with the resolved direction leaves the same histories as
+ * speculating with the prediction and flushing, and the prediction is still
+ * made so that commit_state updates the tables as it would after a recovery. */
+void bp_tagescl_train(Op* op) {
+  uns proc_id = op->proc_id;
+  auto& predictor = tagescl_predictors.at(proc_id);
+  const auto br_type = get_branch_type(proc_id, op->table_info->cf_type);
+  const int64_t branch_id = predictor->get_new_branch_id();
+
+  if (op->table_info->cf_type == CF_CBR)
+    predictor->get_prediction(branch_id, op->inst_info->addr);
+  predictor->update_speculative_state(branch_id, op->inst_info->addr, br_type, op->oracle_info.dir,
+                                      op->oracle_info.target);
+  predictor->commit_state(branch_id, op->inst_info->addr, br_type, op->oracle_info.dir);
+  predictor->commit_state_at_retire(branch_id, op->inst_info->addr, br_type, op->oracle_info.dir,
+                                    op->oracle_info.target);
+}
+
 uns8 bp_tagescl_full(uns proc_id) {
   return tagescl_predictors.at(proc_id)->is_full();
 }
+
+void bp_tagescl_snapshot(uns proc_id, Snapshot* snap) {
+  Snapshot_Transfer transfer(snap);
+  tagescl_predictors.at(proc_id)->transfer_state(transfer);
+}
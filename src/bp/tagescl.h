@@ -37,6 +37,8 @@ void bp_tagescl_update(Op* op);
 void bp_tagescl_retire(Op* op);
 void bp_tagescl_recover(Recovery_Info*);
 uns8 bp_tagescl_full(uns proc_id);
+void bp_tagescl_snapshot(uns proc_id, struct Snapshot_struct* snap);
+void bp_tagescl_train(Op* op);
 
 #ifdef __cplusplus
 }
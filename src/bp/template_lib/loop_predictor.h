@@ -22,8 +22,6 @@
 #ifndef __LOOP_PREDICTOR_H_
 #define __LOOP_PREDICTOR_H_
 
-#include <vector>
-
 #include "utils.h"
 
 struct Loop_Predictor_Indices {
@@ -45,8 +43,7 @@ struct Loop_Prediction_Info {
 template <class LOOP_CONFIG>
 class Loop_Predictor {
  public:
-  Loop_Predictor(Random_Number_Generator& random_number_gen)
-      : table_(1 << LOOP_CONFIG::LOG_NUM_ENTRIES), random_number_gen_(random_number_gen) {}
+  Loop_Predictor(Random_Number_Generator& random_number_gen) : table_(), random_number_gen_(random_number_gen) {}
 
   void get_prediction(uint64_t br_pc, Loop_Prediction_Info<LOOP_CONFIG>* prediction_info) const {
     prediction_info->valid = false;
@@ -198,6 +195,10 @@ class Loop_Predictor {
     prediction_info->hit_bank = -1;
   }
 
+  void transfer_state(State_Transfer& transfer) {
+    transfer.value(table_);
+  }
+
  private:
   struct LoopPredictorEntry {
     int16_t total_iterations = 0;                                                              // 10 bits
@@ -214,7 +215,10 @@ class Loop_Predictor {
   Loop_Predictor_Indices get_indices(uint64_t br_pc) const;
   int get_tag(uint64_t br_pc) const;
 
-  std::vector<LoopPredictorEntry> table_;
+  // The table is small (32 entries in the shipped configs), so it lives inline in the predictor rather than
+  // behind a heap pointer.
+  static constexpr int num_entries = 1 << LOOP_CONFIG::LOG_NUM_ENTRIES;
+  LoopPredictorEntry table_[num_entries];
 
   Random_Number_Generator& random_number_gen_;
 };
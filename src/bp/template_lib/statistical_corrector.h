@@ -93,22 +93,32 @@ class Gehl {
     }
   }
 
+  // Each counter c contributes 2c+1, so the sum is 2*sum(c)+num_histories.
   int get_prediction_sum(uint64_t br_pc, int64_t history) const {
     int sum = 0;
     for (int i = 0; i < num_histories; i++) {
-      int index = get_index(br_pc, history, i);
-      sum += (2 * tables_[i][index].get() + 1);
+      sum += tables_[i][get_index(br_pc, history, i)].get();
     }
-    return sum;
+    return 2 * sum + num_histories;
   }
 
   void update(uint64_t br_pc, int64_t history, bool resolve_dir) {
     for (int i = 0; i < num_histories; i++) {
-      int index = get_index(br_pc, history, i);
-      tables_[i][index].update(resolve_dir);
+      tables_[i][get_index(br_pc, history, i)].update(resolve_dir);
     }
   }
 
+  // Same as get_prediction_sum() followed by update(), hashing each index once.
+  int get_prediction_sum_and_update(uint64_t br_pc, int64_t history, bool resolve_dir) {
+    int sum = 0;
+    for (int i = 0; i < num_histories; i++) {
+      Counter_Type& counter = tables_[i][get_index(br_pc, history, i)];
+      sum += counter.get();
+      counter.update(resolve_dir);
+    }
+    return 2 * sum + num_histories;
+  }
+
  private:
   static constexpr int num_histories = sizeof(Histories::arr) / sizeof(Histories::arr[0]);
 
@@ -162,6 +172,38 @@ class Statistical_Corrector {
 
   void commit_state_at_retire() {}
 
+  void transfer_state(State_Transfer& transfer) {
+    transfer.value(global_history_);
+    transfer.value(path_);
+    transfer.value(first_local_history_table_);
+    transfer.value(second_local_history_table_);
+    transfer.value(third_local_history_table_);
+    transfer.value(imli_counter_);
+    transfer.value(imli_table_);
+    transfer.value(first_high_confidence_ctr_);
+    transfer.value(second_high_confidence_ctr_);
+    transfer.value(update_threshold_);
+    transfer.value(p_update_thresholds_);
+    transfer.value(global_history_gehl_);
+    transfer.value(path_gehl_);
+    transfer.value(first_local_gehl_);
+    transfer.value(second_local_gehl_);
+    transfer.value(third_local_gehl_);
+    transfer.value(first_imli_gehl_);
+    transfer.value(second_imli_gehl_);
+    transfer.value(global_history_threshold_table_);
+    transfer.value(path_threshold_table_);
+    transfer.value(first_local_threshold_table_);
+    transfer.value(second_local_threshold_table_);
+    transfer.value(third_local_threshold_table_);
+    transfer.value(first_imli_threshold_table_);
+    transfer.value(second_imli_threshold_table_);
+    transfer.value(bias_threshold_table_);
+    transfer.vector(bias_table_);
+    transfer.vector(bias_sk_table_);
+    transfer.vector(bias_bank_table_);
+  }
+
   void global_recover_speculative_state(const SC_Prediction_Info& prediction_info) {
     global_history_ = prediction_info.history_snapshot.global_history;
     path_ = prediction_info.history_snapshot.path;
@@ -213,8 +255,7 @@ class Statistical_Corrector {
   void update_gehl_and_threshold(Gehl<PRECISION, Gehl_Histories, gehl_log_table_size>* gehl,
                                  Threshold_Table<threshold_width, log_threshold_table_size>* threshold_table,
                                  uint64_t br_pc, int64_t history, bool resolve_dir, int total_prediction_sum) {
-    int gehl_sum = gehl->get_prediction_sum(br_pc, history);
-    gehl->update(br_pc, history, resolve_dir);
+    int gehl_sum = gehl->get_prediction_sum_and_update(br_pc, history, resolve_dir);
 
     if (CONFIG::SC::USE_VARIABLE_THRESHOLD) {
       int total_sum_without_doubled_gehl =
@@ -22,27 +22,32 @@
 #ifndef __TAGE_H_
 #define __TAGE_H_
 
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <vector>
 
 #include "utils.h"
 
 /* The main history register suitable for very large history. The history is
- * implemented as a circular buffer for efficiency. The API only allows
- * insertions of bits into the most recent position of the history and provides
- * an accessor for random access of individual bits. It also provides an API for
- * rewinding the history to support recovery from mispeculation */
+ * implemented as a circular buffer for efficiency, packed into 64-bit words so
+ * that runs of bits can be read at once. The API only allows insertions of
+ * bits into the most recent position of the history and provides accessors
+ * for random access of individual bits and of runs of bits. It also provides
+ * an API for rewinding the history to support recovery from mispeculation */
 template <int history_size>
 class Long_History_Register {
  public:
   // Buffer_size needs to be a power of 2. (buffer_size - history_size) should
   // be large enough to cover speculative branches that are not yet retired.
-  Long_History_Register(int max_in_flight_branches) : history_bits_() {
-    int log_buffer_size = get_min_num_bits_to_represent(history_size + max_in_flight_branches);
+  Long_History_Register(int max_in_flight_branches) : history_words_() {
+    int log_buffer_size =
+        std::max(get_min_num_bits_to_represent(history_size + max_in_flight_branches), log_bits_per_word_);
     buffer_size_ = 1 << log_buffer_size;
     buffer_access_mask_ = (1 << log_buffer_size) - 1;
     max_num_speculative_bits_ = buffer_size_ - history_size;
-    history_bits_.resize(buffer_size_);
+    history_words_.resize(buffer_size_ >> log_bits_per_word_);
   }
 
   // Pushes one bit into the history at the head. Increments
@@ -52,7 +57,10 @@ class Long_History_Register {
     // TODO: it will be cleaner to mask head_ with (size_ - 1) now. But I
     // want to keep it compatible with Seznec.
     head_ -= 1;
-    history_bits_[head_ & buffer_access_mask_] = bit;
+    int64_t pos = head_ & buffer_access_mask_;
+    uint64_t& word = history_words_[pos >> log_bits_per_word_];
+    int offset = pos & (bits_per_word_ - 1);
+    word = (word & ~(uint64_t{1} << offset)) | (static_cast<uint64_t>(bit) << offset);
 
     num_speculative_bits_ += 1;
     assert(num_speculative_bits_ <= max_num_speculative_bits_);
@@ -73,18 +81,42 @@ class Long_History_Register {
 
   // Random access interface, i=0 is the most recent branch (head).
   bool operator[](size_t i) const {
-    return history_bits_[(head_ + i) & buffer_access_mask_];
+    int64_t pos = (head_ + i) & buffer_access_mask_;
+    return (history_words_[pos >> log_bits_per_word_] >> (pos & (bits_per_word_ - 1))) & 1;
+  }
+
+  // Returns num_bits (< 64) bits starting at i: bit j of the result is
+  // (*this)[i + j].
+  uint64_t get_bits(size_t i, int num_bits) const {
+    assert(num_bits > 0 && num_bits < bits_per_word_);
+    int64_t pos = (head_ + i) & buffer_access_mask_;
+    size_t word_idx = pos >> log_bits_per_word_;
+    int offset = pos & (bits_per_word_ - 1);
+    uint64_t bits = history_words_[word_idx] >> offset;
+    if (offset + num_bits > bits_per_word_) {
+      bits |= history_words_[(word_idx + 1) & (history_words_.size() - 1)] << (bits_per_word_ - offset);
+    }
+    return bits & ((uint64_t{1} << num_bits) - 1);
   }
 
   int64_t head_idx() const {
     return head_;
   }
 
+  void transfer_state(State_Transfer& transfer) {
+    transfer.vector(history_words_);
+    transfer.value(num_speculative_bits_);
+    transfer.value(head_);
+  }
+
  private:
+  static constexpr int log_bits_per_word_ = 6;
+  static constexpr int bits_per_word_ = 1 << log_bits_per_word_;
+
   int num_speculative_bits_ = 0;  // keeps track of how many bits can be
                                   // discarded during a rewind without losing
                                   // bits in the most significant position.
-  std::vector<bool> history_bits_;
+  std::vector<uint64_t> history_words_;
   int64_t head_ = 0;
   int64_t buffer_size_;
   int64_t buffer_access_mask_;
@@ -92,10 +124,18 @@ class Long_History_Register {
 };
 
 /* Computes the a folded history of a large history, as bits are shifted into
- * the history. The caller should update the folded history everytime  */
+ * the history. The caller should update the folded history everytime.
+ *
+ * Shifting one bit in rotates the folded value left by one and xors in the
+ * new bit at position 0 and the bit leaving the original length at the
+ * outpoint. Shifting n <= compressed_length bits therefore rotates by n and
+ * xors in the n newest bits and, rotated by the outpoint, the n bits that
+ * left, which is how the bits of a branch are folded at once. */
 template <int history_size>
 class Folded_History {
  public:
+  Folded_History() : current_value_(0), original_length_(0), compressed_length_(1), outpoint_(0) {}
+
   Folded_History(int original_length, int compressed_length)
       : current_value_(0),
         original_length_(original_length),
@@ -106,6 +146,10 @@ class Folded_History {
     return current_value_;
   }
 
+  int original_length() const {
+    return original_length_;
+  }
+
   void update(const Long_History_Register<history_size>& history_register) {
     // Shift in the most recent GHR bit.
     current_value_ = (current_value_ << 1) ^ history_register[0];
@@ -120,6 +164,20 @@ class Folded_History {
     current_value_ &= (1 << compressed_length_) - 1;
   }
 
+  // Same as num_bits calls to update() as each of the num_bits most recent
+  // bits was pushed. new_bits holds history[0, num_bits) and old_bits holds
+  // history[original_length, original_length + num_bits), both taken after
+  // the pushes.
+  void update(uint64_t new_bits, uint64_t old_bits, int num_bits) {
+    if (num_bits <= compressed_length_) {
+      current_value_ = rotate_left(current_value_, num_bits) ^ new_bits ^ rotate_left(old_bits, outpoint_);
+      return;
+    }
+    for (int i = num_bits - 1; i >= 0; --i) {
+      current_value_ = rotate_left(current_value_, 1) ^ ((new_bits >> i) & 1) ^ (((old_bits >> i) & 1) << outpoint_);
+    }
+  }
+
   void update_reverse(const Long_History_Register<history_size>& history_register) {
     // Fold out the most recent GHR bit.
     current_value_ ^= history_register[0];
@@ -134,7 +192,31 @@ class Folded_History {
     current_value_ &= (1 << compressed_length_) - 1;
   }
 
+  // Same as num_bits calls to update_reverse(), each followed by a rewind of
+  // one bit, while the history register itself is not rewound yet.
+  void update_reverse(const Long_History_Register<history_size>& history_register, int num_bits) {
+    for (int done = 0; done < num_bits;) {
+      int chunk = std::min(num_bits - done, std::min(compressed_length_, 63));
+      uint64_t new_bits = history_register.get_bits(done, chunk);
+      uint64_t old_bits = history_register.get_bits(original_length_ + done, chunk);
+      current_value_ =
+          rotate_left(current_value_ ^ new_bits ^ rotate_left(old_bits, outpoint_), compressed_length_ - chunk);
+      done += chunk;
+    }
+  }
+
+  void transfer_state(State_Transfer& transfer) {
+    transfer.value(current_value_);
+  }
+
  private:
+  // Rotates a value of compressed_length_ bits (amount < compressed_length_).
+  int64_t rotate_left(int64_t value, int amount) const {
+    uint64_t bits = value;
+    uint64_t mask = (uint64_t{1} << compressed_length_) - 1;
+    return ((bits << amount) | (bits >> (compressed_length_ - amount))) & mask;
+  }
+
   int64_t current_value_;
   int original_length_;
   int compressed_length_;
@@ -262,19 +344,45 @@ class Tage_Histories {
 
       path_history_ = (path_history_ << 1) ^ (path_hash & 127);
       path_hash >>= 1;
+    }
 
-      for (int j = 0; j < TAGE_CONFIG::NUM_HISTORIES; ++j) {
-        folded_histories_for_indices_[j].update(history_register_);
-        folded_histories_for_tags_0_[j].update(history_register_);
-        folded_histories_for_tags_1_[j].update(history_register_);
-      }
+    // Fold all bits of the branch at once. The three folded histories of a
+    // table share its original length, and so the bits shifted out of it.
+    uint64_t new_bits = history_register_.get_bits(0, num_bit_inserts);
+    for (int j = 0; j < TAGE_CONFIG::NUM_HISTORIES; ++j) {
+      uint64_t old_bits = history_register_.get_bits(history_sizes_.arr[j], num_bit_inserts);
+      folded_histories_for_indices_[j].update(new_bits, old_bits, num_bit_inserts);
+      folded_histories_for_tags_0_[j].update(new_bits, old_bits, num_bit_inserts);
+      folded_histories_for_tags_1_[j].update(new_bits, old_bits, num_bit_inserts);
     }
 
     path_history_ = path_history_ & ((1 << TAGE_CONFIG::PATH_HISTORY_WIDTH) - 1);
   }
 
+  // Undoes the num_flushed_bits most recent pushes.
+  void rewind(int num_flushed_bits) {
+    for (int j = 0; j < TAGE_CONFIG::NUM_HISTORIES; ++j) {
+      folded_histories_for_indices_[j].update_reverse(history_register_, num_flushed_bits);
+      folded_histories_for_tags_0_[j].update_reverse(history_register_, num_flushed_bits);
+      folded_histories_for_tags_1_[j].update_reverse(history_register_, num_flushed_bits);
+    }
+    history_register_.rewind(num_flushed_bits);
+  }
+
   void intialize_folded_history(void);
 
+  void transfer_state(State_Transfer& transfer) {
+    history_register_.transfer_state(transfer);
+    for (int i = 0; i < TAGE_CONFIG::NUM_HISTORIES; ++i) {
+      folded_histories_for_indices_[i].transfer_state(transfer);
+      folded_histories_for_tags_0_[i].transfer_state(transfer);
+      folded_histories_for_tags_1_[i].transfer_state(transfer);
+    }
+    transfer.value(path_history_);
+    transfer.value(head_old_);
+    transfer.value(path_history_old_);
+  }
+
   // Hash function for the path history used in creating table indices.
   int64_t compute_path_hash(int64_t path_history, int max_width, int bank, int index_size) const;
 
@@ -285,9 +393,9 @@ class Tage_Histories {
 
   // Predictor State
   Long_History_Register<TAGE_CONFIG::MAX_HISTORY_SIZE> history_register_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>> folded_histories_for_indices_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>> folded_histories_for_tags_0_;
-  std::vector<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>> folded_histories_for_tags_1_;
+  std::array<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>, TAGE_CONFIG::NUM_HISTORIES> folded_histories_for_indices_;
+  std::array<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>, TAGE_CONFIG::NUM_HISTORIES> folded_histories_for_tags_0_;
+  std::array<Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>, TAGE_CONFIG::NUM_HISTORIES> folded_histories_for_tags_1_;
 
   int64_t path_history_;
   int64_t head_old_;
@@ -536,13 +644,8 @@ class Tage {
   void global_recover_speculative_state(const Tage_Prediction_Info<TAGE_CONFIG>& prediction_info) {
     int64_t num_flushed_bits =
         (prediction_info.global_history_head_checkpoint_ - tage_histories_.history_register_.head_idx());
-    for (int i = 0; i < num_flushed_bits; ++i) {
-      for (int j = 0; j < TAGE_CONFIG::NUM_HISTORIES; ++j) {
-        tage_histories_.folded_histories_for_indices_[j].update_reverse(tage_histories_.history_register_);
-        tage_histories_.folded_histories_for_tags_0_[j].update_reverse(tage_histories_.history_register_);
-        tage_histories_.folded_histories_for_tags_1_[j].update_reverse(tage_histories_.history_register_);
-      }
-      tage_histories_.history_register_.rewind(1);
+    if (num_flushed_bits > 0) {
+      tage_histories_.rewind(num_flushed_bits);
     }
     tage_histories_.path_history_ = prediction_info.path_history_checkpoint;
   }
@@ -553,6 +656,15 @@ class Tage {
     *prediction_info = {};
   }
 
+  void transfer_state(State_Transfer& transfer) {
+    tage_histories_.transfer_state(transfer);
+    transfer.value(bimodal_table_);
+    transfer.value(low_history_tagged_table_);
+    transfer.value(high_history_tagged_table_);
+    transfer.value(alt_selector_table_);
+    transfer.value(tick_);
+  }
+
  private:
   struct Bimodal_Entry {
     int8_t hysteresis = 1;
@@ -626,16 +738,11 @@ void Tage<TAGE_CONFIG>::initialize_table_sizes(void) {
 
 template <class TAGE_CONFIG>
 void Tage_Histories<TAGE_CONFIG>::intialize_folded_history(void) {
-  // insert dummy entries for the zeroth entry of the vector
+  using Folded = Folded_History<TAGE_CONFIG::MAX_HISTORY_SIZE>;
   for (int i = 0; i < TAGE_CONFIG::NUM_HISTORIES; i++) {
-    // For some reason I cannot pass LOG_ENTRIES_PER_BANK to emplace_bank()
-    // directly (gcc complains that variable is undefined), do not know why.
-    // REVISIT: since I got rid of LOG_ENTRIES_PER_BANK as a constant, this
-    // should be fine now.
-    const int LOG_ENTRIES_PER_BANK2 = TAGE_CONFIG::LOG_ENTRIES_PER_BANK;
-    folded_histories_for_indices_.emplace_back(history_sizes_.arr[i], LOG_ENTRIES_PER_BANK2);
-    folded_histories_for_tags_0_.emplace_back(history_sizes_.arr[i], tag_bits_.arr[i]);
-    folded_histories_for_tags_1_.emplace_back(history_sizes_.arr[i], tag_bits_.arr[i] - 1);
+    folded_histories_for_indices_[i] = Folded(history_sizes_.arr[i], TAGE_CONFIG::LOG_ENTRIES_PER_BANK);
+    folded_histories_for_tags_0_[i] = Folded(history_sizes_.arr[i], tag_bits_.arr[i]);
+    folded_histories_for_tags_1_[i] = Folded(history_sizes_.arr[i], tag_bits_.arr[i] - 1);
   }
 }
 
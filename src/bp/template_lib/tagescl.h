@@ -46,6 +46,7 @@ class Tage_SC_L_Base {
   virtual void flush_branch_and_repair_state(int64_t branch_id, uint64_t br_pc, Branch_Type br_type, bool resolve_dir,
                                              uint64_t br_target) = 0;
   virtual bool is_full() = 0;
+  virtual void transfer_state(State_Transfer& transfer) = 0;
 };
 
 /* Interface functions:
@@ -117,6 +118,16 @@ class Tage_SC_L : public Tage_SC_L_Base {
   void flush_branch_and_repair_state(int64_t branch_id, uint64_t br_pc, Branch_Type br_type, bool resolve_dir,
                                      uint64_t br_target) override;
 
+  // Passes the whole predictor state to transfer, see State_Transfer.
+  void transfer_state(State_Transfer& transfer) override {
+    random_number_gen_.transfer_state(transfer);
+    tage_.transfer_state(transfer);
+    statistical_corrector_.transfer_state(transfer);
+    loop_predictor_.transfer_state(transfer);
+    transfer.value(loop_predictor_beneficial_);
+    prediction_info_buffer_.transfer_state(transfer);
+  }
+
  private:
   Random_Number_Generator random_number_gen_;
   Tage<typename CONFIG::TAGE> tage_;
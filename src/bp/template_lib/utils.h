@@ -23,6 +23,9 @@
 #define __TAGE_SC_L_LIB_H_
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 inline int get_min_num_bits_to_represent(int x) {
   assert(x > 0);
@@ -37,6 +40,24 @@ inline int get_min_num_bits_to_represent(int x) {
   assert(false);
 }
 
+/* Receives every piece of a predictor's state, to either save it or overwrite
+ * it, so that a warmed up predictor can be snapshotted. The predictor must
+ * have no branches in flight. */
+class State_Transfer {
+ public:
+  virtual void operator()(void* data, size_t bytes) = 0;
+
+  template <typename T>
+  void value(T& x) {
+    (*this)(&x, sizeof(T));
+  }
+
+  template <typename T>
+  void vector(std::vector<T>& v) {
+    (*this)(v.data(), v.size() * sizeof(T));
+  }
+};
+
 /* Copying the implementation of std::conditional because PinCRT does not
  * include it*/
 template <bool B, class T, class F>
@@ -136,6 +157,10 @@ class Random_Number_Generator {
     return (seed_);
   }
 
+  void transfer_state(State_Transfer& transfer) {
+    transfer.value(seed_);
+  }
+
   int seed_ = 0;
   int64_t* phist_ptr_;
   int64_t* ptghist_ptr_;
@@ -193,6 +218,14 @@ class Circular_Buffer {
     return false;
   }
 
+  // Only the ids are kept, the buffer has to be empty.
+  void transfer_state(State_Transfer& transfer) {
+    assert(size_ == 0);
+    transfer.value(back_);
+    transfer.value(front_);
+    assert(size_ == 0 && front_ == back_ + 1);
+  }
+
  private:
   std::vector<T> buffer_;
   int64_t buffer_size_;
@@ -203,4 +236,132 @@ class Circular_Buffer {
   int64_t size_ = 0;
 };
 
+/* A table of unsigned saturating counters of 1, 2, 4 or 8 bits, packed into
+ * bytes so that a large PHT stays small in the host caches. The width is set
+ * at run time. */
+class Packed_Counters {
+ public:
+  void init(uint64_t num_counters, unsigned width, unsigned init_value) {
+    assert(width > 0 && 8 % width == 0);
+    assert(init_value < (1u << width));
+    width_ = width;
+    width_shift_ = 0;
+    while ((1u << width_shift_) < width) {
+      width_shift_ += 1;
+    }
+    index_shift_ = 3 - width_shift_;
+    counter_max_ = (1u << width) - 1;
+    uint8_t init_byte = 0;
+    for (unsigned ii = 0; ii < 8 / width; ii++) {
+      init_byte |= init_value << (ii * width);
+    }
+    bytes_.assign((num_counters + (8 / width) - 1) >> index_shift_, init_byte);
+  }
+
+  unsigned get(uint64_t index) const {
+    return bytes_[index >> index_shift_] >> bit_offset(index) & counter_max_;
+  }
+
+  // The most significant bit of the counter, i.e. the predicted direction.
+  bool msb(uint64_t index) const {
+    return get(index) >> (width_ - 1);
+  }
+
+  // If condition is true, increments the counter, otherwise, decrements the
+  // counter (saturating).
+  void update(uint64_t index, bool condition) {
+    const unsigned value = get(index);
+    if (condition ? value == counter_max_ : value == 0) {
+      return;
+    }
+    uint8_t& byte = bytes_[index >> index_shift_];
+    const unsigned offset = bit_offset(index);
+    byte = condition ? byte + (1u << offset) : byte - (1u << offset);
+  }
+
+  // The byte holding the counter, to prefetch it.
+  const uint8_t* byte_address(uint64_t index) const {
+    return &bytes_[index >> index_shift_];
+  }
+
+  std::vector<uint8_t>& bytes() {
+    return bytes_;
+  }
+
+ private:
+  unsigned bit_offset(uint64_t index) const {
+    return (index & ((1u << index_shift_) - 1)) << width_shift_;
+  }
+
+  std::vector<uint8_t> bytes_;
+  unsigned width_;
+  unsigned width_shift_;  // log2 of the width
+  unsigned index_shift_;  // log2 of the counters per byte
+  unsigned counter_max_;
+};
+
+/* A set-associative table of T tagged with the whole key, with true LRU
+ * replacement. The low bits of the key select one of num_entries / assoc
+ * sets, and every set keeps its ways in most recently used first order, so
+ * the least recently used way (or an invalid one) is always the last. */
+template <typename T>
+class Lru_Tagged_Table {
+ public:
+  void init(unsigned num_entries, unsigned assoc) {
+    assert(assoc > 0 && num_entries % assoc == 0);
+    const unsigned num_sets = num_entries / assoc;
+    assert(num_sets > 0 && (num_sets & (num_sets - 1)) == 0);
+    assoc_ = assoc;
+    set_mask_ = num_sets - 1;
+    keys_.resize(num_entries);
+    entries_.resize(num_entries);
+    fill_.assign(num_sets, 0);
+  }
+
+  // Returns the entry of key, making it the most recently used, or nullptr.
+  T* lookup(uint64_t key) {
+    const uint64_t set = key & set_mask_;
+    const uint64_t base = set * assoc_;
+    for (unsigned way = 0; way < fill_[set]; way++) {
+      if (keys_[base + way] == key) {
+        move_to_front(base, way);
+        return &entries_[base];
+      }
+    }
+    return nullptr;
+  }
+
+  // Inserts key as the most recently used entry of its set, replacing the
+  // least recently used one if the set is full. key must not be present.
+  T* insert(uint64_t key) {
+    const uint64_t set = key & set_mask_;
+    const uint64_t base = set * assoc_;
+    if (fill_[set] < assoc_) {
+      fill_[set] += 1;
+    }
+    move_to_front(base, fill_[set] - 1);
+    keys_[base] = key;
+    entries_[base] = T();
+    return &entries_[base];
+  }
+
+ private:
+  void move_to_front(uint64_t base, unsigned way) {
+    const uint64_t key = keys_[base + way];
+    const T entry = entries_[base + way];
+    for (unsigned ii = way; ii > 0; ii--) {
+      keys_[base + ii] = keys_[base + ii - 1];
+      entries_[base + ii] = entries_[base + ii - 1];
+    }
+    keys_[base] = key;
+    entries_[base] = entry;
+  }
+
+  std::vector<uint64_t> keys_;
+  std::vector<T> entries_;
+  std::vector<unsigned> fill_;  // valid ways of each set
+  unsigned assoc_;
+  uint64_t set_mask_;
+};
+
 #endif  // __TAGE_SC_L_LIB_H_
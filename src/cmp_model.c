@@ -35,6 +35,7 @@
 #include "debug/debug.param.h"
 #include "debug/debug_macros.h"
 #include "debug/debug_print.h"
+#include "debug/host_prof.h"
 
 #include "bp/bp.param.h"
 #include "core.param.h"
@@ -43,21 +44,29 @@
 #include "memory/memory.param.h"
 #include "prefetcher/pref.param.h"
 
+#include "bp/bp_stream.h"
 #include "dvfs/dvfs.h"
 #include "dvfs/perf_pred.h"
+#include "libs/snapshot_lib.h"
 #include "memory/cache_part.h"
+#include "memory/stack_dist.h"
+#include "memory/tlb.h"
 #include "prefetcher/D_JOLT.h"
 #include "prefetcher/FNL+MMA.h"
 #include "prefetcher/eip.h"
 #include "prefetcher/fdip.h"
 #include "prefetcher/pref_common.h"
 
+#include "cmp_threads.h"
 #include "decoupled_frontend.h"
+#include "frontend/frontend.h"
 #include "freq.h"
 #include "ft.h"
+#include "idle_skip.h"
 #include "idq_stage.h"
 #include "lsq.h"
 #include "map_rename.h"
+#include "node_issue_queue.h"
 #include "op_pool.h"
 #include "sim.h"
 #include "statistics.h"
@@ -70,6 +79,21 @@
 Cmp_Model cmp_model;
 Flag perf_pred_started = FALSE;
 
+/* Core cycles due since the last sync quantum boundary (SYNC_QUANTUM > 1) */
+static Counter quantum_first_cycle[MAX_NUM_PROCS];
+static uns quantum_num_cycles[MAX_NUM_PROCS];
+static uns quantum_uncore_cycles = 0;
+
+/* Where the last functional warmup of each core found its icache line, so the
+   other uops of an instruction skip the lookup and the next instructions on the
+   line check one way instead of searching the set. iway is -1 if unknown. */
+static struct {
+  Addr iline;
+  Counter itime;
+  uns iset;
+  int iway;
+} warmup_core[MAX_NUM_PROCS];
+
 /**************************************************************************************/
 /* Static prototypes */
 
@@ -78,6 +102,12 @@ static void cmp_redirect(void);
 static void cmp_measure_chip_util(void);
 static void cmp_istreams(void);
 static void cmp_cores(void);
+static void cmp_istream(uns8 proc_id);
+static void cmp_core(uns8 proc_id);
+static void cmp_istream_cycle(Core_Context* core);
+static void cmp_core_cycle(Core_Context* core);
+static void cmp_cycle_relaxed(void);
+static void cmp_core_quantum(uns8 proc_id);
 static void warmup_uncore(uns proc_id, Addr addr, Flag write);
 
 /**************************************************************************************/
@@ -88,8 +118,10 @@ void cmp_init(uns mode) {
     /* set repl to LRU for warming up, waiting for partition trigger to switch
      * it back  to REPL_PARTITION */
     if (L1_PART_ON && L1_PART_WARMUP) {
-      ASSERT(0, cmp_model.memory.uncores[0].l1->cache.repl_policy == REPL_PARTITION);
-      cmp_model.memory.uncores[0].l1->cache.repl_policy = REPL_TRUE_LRU;
+      for (uns slice = 0; slice < cmp_model.memory.num_l1_slices; slice++) {
+        ASSERT(0, cmp_model.memory.uncores[0].l1[slice].cache.repl_policy == REPL_PARTITION);
+        cmp_model.memory.uncores[0].l1[slice].cache.repl_policy = REPL_TRUE_LRU;
+      }
     }
     return;
   }
@@ -105,7 +137,15 @@ void cmp_init(uns mode) {
   freq_init();
   cmp_init_cmp_model();
 
+  for (proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    warmup_core[proc_id].iway = -1;
+
+  cmp_threads_init();
+
   for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    /* place the core's state on the host node of the thread simulating it */
+    cmp_threads_numa_core(proc_id);
+
     /* initialize the stages */
     cmp_set_all_stages(proc_id);
     cmp_init_thread_data(proc_id);
@@ -121,6 +161,7 @@ void cmp_init(uns mode) {
     init_exec_stage(proc_id, "EXEC");
     init_exec_ports(proc_id, "EXEC_PORTS");
     init_dcache_stage(proc_id, "DCACHE");
+    init_tlb(proc_id);
 
     /* initialize the common data structures */
     init_bp_recovery_info(proc_id, &cmp_model.bp_recovery_info[proc_id]);
@@ -134,6 +175,7 @@ void cmp_init(uns mode) {
     init_fnlmma(proc_id);
   }
 
+  cmp_threads_numa_shared();
   cmp_model.window_size = NODE_TABLE_SIZE;
 
   set_memory(&cmp_model.memory);
@@ -145,6 +187,10 @@ void cmp_init(uns mode) {
     dvfs_init();
 
   cache_part_init();
+  stack_dist_init();
+  cmp_threads_numa_default();
+
+  idle_skip_init();
 
   ASSERTM(0, !USE_LATE_BP || LATE_BP_LATENCY < (DECODE_CYCLES + MAP_CYCLES),
           "Late branch prediction latency should be less than the total "
@@ -175,83 +221,175 @@ void cmp_reset() {
 /* cmp_cycle: */
 
 void cmp_cycle() {
+  if (idle_skip_cycle_begin())
+    return;
+
+  if (SYNC_QUANTUM > 1) {
+    cmp_cycle_relaxed();
+    return;
+  }
+
   cmp_istreams();
 
   /* Frequency domain checking is inside this function, since it
    * handles both shared cache and memory */
   update_memory();
 
+  frontend_fill_op_buffers();
   cmp_cores();
 
   if (DVFS_ON)
     dvfs_cycle();
   cache_part_update();
+
+  idle_skip_cycle_end();
 }
 
-void cmp_istreams(void) {
-  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    if (DUMB_CORE_ON && DUMB_CORE == proc_id)
-      continue;
+/**************************************************************************************/
+/* cmp_cycle_relaxed: simulates the shared memory system for the current time
+   step and only records which cycles the cores are due. The cores catch up on
+   all of their pending cycles at once when SYNC_QUANTUM uncore cycles have
+   passed, so the cores are synchronized with each other and with the uncore
+   once per quantum instead of every cycle. Requests issued while catching up
+   are seen by the uncore at the next quantum boundary; the delay is reported
+   in the SYNC_QUANTUM_* stats. */
 
-    if (freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
-      cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+static void cmp_cycle_relaxed(void) {
+  update_memory_uncore();
 
-      set_bp_recovery_info(&cmp_model.bp_recovery_info[proc_id]);
-      if (cycle_count >= bp_recovery_info->recovery_cycle) {
-        set_bp_data(&cmp_model.bp_data[proc_id]);
-        cmp_set_all_stages(proc_id);
-        cmp_recover();
-      }
-      if (cycle_count >= bp_recovery_info->redirect_cycle) {
-        set_icache_stage(&cmp_model.icache_stage[proc_id]);
-        ASSERT(proc_id, proc_id == bp_recovery_info->redirect_op->proc_id);
-        ASSERT_PROC_ID_IN_ADDR(proc_id, bp_recovery_info->redirect_op->oracle_info.pred_npc);
-        cmp_redirect();
-      }
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if (freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
+      if (quantum_num_cycles[proc_id] == 0)
+        quantum_first_cycle[proc_id] = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+      quantum_num_cycles[proc_id]++;
     }
   }
+
+  if (freq_is_ready(FREQ_DOMAIN_L1) && ++quantum_uncore_cycles >= SYNC_QUANTUM) {
+    cmp_threads_for_each_core(cmp_core_quantum);
+    quantum_uncore_cycles = 0;
+    STAT_EVENT(0, SYNC_QUANTUM_SYNCS);
+  }
+
+  if (DVFS_ON)
+    dvfs_cycle();
+  cache_part_update();
+}
+
+void cmp_istreams(void) {
+  cmp_threads_for_each_core(cmp_istream);
+}
+
+static void cmp_istream(uns8 proc_id) {
+  if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+    return;
+
+  if (freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
+    cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+    cmp_istream_cycle(&cmp_model.core_context[proc_id]);
+  }
+}
+
+static void cmp_istream_cycle(Core_Context* core) {
+  set_bp_recovery_info(core->bp_recovery_info);
+  if (cycle_count >= core->bp_recovery_info->recovery_cycle) {
+    cmp_set_core_context(core);
+    cmp_recover();
+  }
+  if (cycle_count >= core->bp_recovery_info->redirect_cycle) {
+    set_icache_stage(core->icache_stage);
+    ASSERT(core->proc_id, core->proc_id == bp_recovery_info->redirect_op->proc_id);
+    ASSERT_PROC_ID_IN_ADDR(core->proc_id, bp_recovery_info->redirect_op->oracle_info.pred_npc);
+    cmp_redirect();
+  }
 }
 
 void cmp_cores(void) {
-  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    if (DUMB_CORE_ON && DUMB_CORE == proc_id)
-      continue;
+  cmp_threads_for_each_core(cmp_core);
+}
 
-    if (freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
-      cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
-
-      set_bp_data(&cmp_model.bp_data[proc_id]);
-      set_bp_recovery_info(&cmp_model.bp_recovery_info[proc_id]);
-      cmp_set_all_stages(proc_id);
-
-      /* Back-end pipeline */
-      update_dcache_stage(&exec->sd);
-      update_exec_stage(&node->sd);
-      update_node_stage(map->last_sd);
-      update_map_stage(idq_stage_get_stage_data());
-
-      if (UOP_CACHE_ENABLE) {
-        /* IDQ stage that bridges the front-end and back-end */
-        /* This stage can get uops from the uc->sd, cache queue, or decoder. */
-        update_idq_stage(dec->last_sd, &uc->sd, uop_queue_stage_get_latest_sd());
-
-        /* Front-end pipiline */
-        update_uop_queue_stage(&uc->sd);
-      } else {
-        update_idq_stage(dec->last_sd, NULL, NULL);
-        update_uop_queue_stage(NULL);
-      }
-      update_decode_stage(&ic->sd);
-      update_icache_stage();
+static void cmp_core(uns8 proc_id) {
+  if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+    return;
 
-      /* Decoupled branch prediction and prefetching */
+  if (freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
+    cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+    cmp_core_cycle(&cmp_model.core_context[proc_id]);
+  }
+}
+
+static void cmp_core_cycle(Core_Context* core) {
+  cmp_set_core_context(core);
+
+  uns proc_id = core->proc_id;
+
+  /* Back-end pipeline */
+  HOST_PROF_SCOPE(proc_id, HOST_PROF_DCACHE, update_dcache_stage(&core->exec_stage->sd));
+  HOST_PROF_SCOPE(proc_id, HOST_PROF_EXEC, update_exec_stage(&core->node_stage->sd));
+  HOST_PROF_SCOPE(proc_id, HOST_PROF_NODE, update_node_stage(core->map_stage->last_sd));
+  HOST_PROF_SCOPE(proc_id, HOST_PROF_MAP, update_map_stage(idq_stage_get_stage_data()));
+
+  if (UOP_CACHE_ENABLE) {
+    /* IDQ stage that bridges the front-end and back-end */
+    /* This stage can get uops from the uc->sd, cache queue, or decoder. */
+    HOST_PROF_SCOPE(
+        proc_id, HOST_PROF_IDQ,
+        update_idq_stage(core->decode_stage->last_sd, &core->uop_cache_stage->sd, uop_queue_stage_get_latest_sd()));
+
+    /* Front-end pipiline */
+    if (FE_SKIP_STALLED_STAGES && uop_queue_stage_next_event_cycle() == MAX_CTR)
+      skip_uop_queue_stage();
+    else
+      HOST_PROF_SCOPE(proc_id, HOST_PROF_UOP_QUEUE, update_uop_queue_stage(&core->uop_cache_stage->sd));
+  } else {
+    HOST_PROF_SCOPE(proc_id, HOST_PROF_IDQ, update_idq_stage(core->decode_stage->last_sd, NULL, NULL));
+    HOST_PROF_SCOPE(proc_id, HOST_PROF_UOP_QUEUE, update_uop_queue_stage(NULL));
+  }
+  /* A frontend stage that cannot move an op this cycle only counts its stall
+     stats; the IDQ always runs since it does the topdown accounting */
+  if (FE_SKIP_STALLED_STAGES && decode_stage_next_event_cycle(&core->icache_stage->sd) == MAX_CTR)
+    skip_decode_stage(&core->icache_stage->sd);
+  else
+    HOST_PROF_SCOPE(proc_id, HOST_PROF_DECODE, update_decode_stage(&core->icache_stage->sd));
+  if (FE_SKIP_STALLED_STAGES && icache_stage_next_event_cycle() == MAX_CTR)
+    skip_icache_stage();
+  else
+    HOST_PROF_SCOPE(proc_id, HOST_PROF_ICACHE, update_icache_stage());
+
+  /* Decoupled branch prediction and prefetching */
+  HOST_PROF_SCOPE(proc_id, HOST_PROF_DECOUPLED_FE, {
+    if (FE_SKIP_STALLED_STAGES && decoupled_fe_next_event_cycle() == MAX_CTR)
+      skip_decoupled_fe();
+    else
       update_decoupled_fe();
-      update_fdip();
-      update_eip();
+    update_fdip();
+    update_eip();
+  });
 
-      cmp_measure_chip_util();
-    }
+  cmp_measure_chip_util();
+}
+
+/**************************************************************************************/
+/* cmp_core_quantum: simulates the cycles a core was due during the last sync
+   quantum, in the same per-cycle order as the lockstep cmp_cycle() */
+
+static void cmp_core_quantum(uns8 proc_id) {
+  if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+    return;
+
+  Counter now = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+  for (uns ii = 0; ii < quantum_num_cycles[proc_id]; ii++) {
+    cycle_count = quantum_first_cycle[proc_id] + ii;
+    cmp_threads_sync_lag = now - cycle_count;
+    STAT_EVENT(proc_id, SYNC_QUANTUM_CORE_CYCLES);
+    INC_STAT_EVENT(proc_id, SYNC_QUANTUM_CORE_LAG, cmp_threads_sync_lag);
+
+    cmp_istream_cycle(&cmp_model.core_context[proc_id]);
+    update_memory_core(proc_id);
+    cmp_core_cycle(&cmp_model.core_context[proc_id]);
   }
+  cmp_threads_sync_lag = 0;
+  quantum_num_cycles[proc_id] = 0;
 }
 
 /**************************************************************************************/
@@ -285,12 +423,15 @@ void cmp_debug() {
 /* cmp_done: */
 
 void cmp_done() {
+  cmp_threads_done();
+
   if (PREF_FRAMEWORK_ON)
     pref_done();
   if (DVFS_ON)
     dvfs_done();
 
   finalize_memory();
+  stack_dist_done();
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     cmp_set_all_stages(proc_id);
   }
@@ -334,6 +475,7 @@ void cmp_wake(Op* src_op, Op* dep_op, uns8 rdy_bit) {
   }
 
   simple_wake(src_op, dep_op, rdy_bit);
+  node_issue_queue_ready_update(dep_op);
 
   if (dep_op->srcs_not_rdy_vector == 0x0 && cycle_count >= dep_op->issue_cycle && !dep_op->in_rdy_list) {
     _DEBUG(dep_op->proc_id, DEBUG_NODE_STAGE, "Adding to ready list  op_num:%s\n", unsstr64(dep_op->op_num));
@@ -416,7 +558,7 @@ void warmup_uncore(uns proc_id, Addr addr, Flag write) {
   Addr dummy_line_addr;
   ASSERTM(0, !MLC_PRESENT, "Warmup for MLC not implemented\n");
 
-  Cache* l1_cache = &(cmp_model.memory.uncores[proc_id].l1->cache);
+  Cache* l1_cache = &(cmp_model.memory.uncores[proc_id].l1[mem_l1_slice(addr)].cache);
   L1_Data* l1_data = cache_access(l1_cache, addr, &dummy_line_addr, TRUE);
   if (l1_data) {  // hit
     if (write)
@@ -438,80 +580,177 @@ void warmup_uncore(uns proc_id, Addr addr, Flag write) {
   }
   if (L1_PART_SHADOW_WARMUP)
     cache_part_l1_warmup(proc_id, addr);
+  stack_dist_access(proc_id, STACK_DIST_L1, addr, TRUE);
 }
 
 /**************************************************************************************/
-/* Warm up select microarchitectural structures: BP, icache, dcache,
- * and L1. No wrong path warmup. */
+/* warmup_icache, warmup_dcache: functional warmup of the first level caches
+   (and of the L1 behind them) for one access */
 
-void cmp_warmup(Op* op) {
-  uns proc_id = op->proc_id;
-  Addr ia = op->inst_info->addr;
-  Addr va = op->oracle_info.va;
-  Addr dummy_line_addr;
-  Addr dummy_line_addr2;
-  Icache_Data* line_info = NULL;
+static void warmup_icache(uns proc_id, Addr ia) {
+  Addr line_addr;
 
-  // Warmup caches for instructions
   Icache_Stage* ic = &(cmp_model.icache_stage[proc_id]);
   Cache* icache = &(ic->icache);
-  Inst_Info** ic_data = (Inst_Info**)cache_access(icache, ia, &dummy_line_addr, TRUE);
-  if (WP_COLLECT_STATS)
-    line_info = (Icache_Data*)cache_access(&ic->icache_line_info, ia, &dummy_line_addr2, TRUE);
+  Flag count_reads = WP_COLLECT_STATS && FDIP_ENABLE;
+
+  // every uop of an instruction fetches the same line at the same time, so only
+  // the first one changes the replacement state (unless reads are counted)
+  if (!count_reads && warmup_core[proc_id].itime == sim_time &&
+      warmup_core[proc_id].iline == (ia & ~icache->offset_mask))
+    return;
+
+  Inst_Info** ic_data = (Inst_Info**)cache_access_at(icache, ia, &line_addr, TRUE, warmup_core[proc_id].iset,
+                                                     warmup_core[proc_id].iway);
+  if (ic_data == NULL)
+    ic_data = (Inst_Info**)cache_access_way(icache, ia, &line_addr, TRUE, &warmup_core[proc_id].iset,
+                                            &warmup_core[proc_id].iway);
+  warmup_core[proc_id].iline = line_addr;
+  warmup_core[proc_id].itime = sim_time;
+  // with WP_COLLECT_STATS the icache line data is the line's Icache_Data
+  Icache_Data* line_info = (Icache_Data*)ic_data;
 
   if (ic_data == NULL) {
     warmup_uncore(proc_id, ia, FALSE);
     Addr repl_line_addr;
-    ic_data = (Inst_Info**)cache_insert(icache, proc_id, ia, &dummy_line_addr, &repl_line_addr);
+    ic_data = (Inst_Info**)cache_insert(icache, proc_id, ia, &line_addr, &repl_line_addr);
     if (WP_COLLECT_STATS) {
-      Addr repl_line_addr2;
-      line_info = (Icache_Data*)cache_insert(&ic->icache_line_info, proc_id, ia, &dummy_line_addr2, &repl_line_addr2);
-      if (repl_line_addr2 && !line_info->read_count[0])
-        inc_cnt_unuseful(proc_id, repl_line_addr2);
+      line_info = (Icache_Data*)ic_data;
+      if (repl_line_addr && !line_info->read_count[0])
+        inc_cnt_unuseful(proc_id, repl_line_addr);
       line_info->read_count[0] = 0;
     }
   } else {
-    if (WP_COLLECT_STATS && FDIP_ENABLE) {
-      ASSERT(proc_id, line_info);
-      inc_cnt_useful(proc_id, dummy_line_addr, FALSE);
+    if (count_reads) {
+      inc_cnt_useful(proc_id, line_addr, FALSE);
       line_info->read_count[0] += 1;
     }
   }
+}
+
+static void warmup_dcache(uns proc_id, Addr va, Flag is_store) {
+  Addr dummy_line_addr;
+  Flag is_load = !is_store;
+  Cache* dcache = &(cmp_model.dcache_stage[proc_id].dcache);
+  Dcache_Data* dc_data = cache_access(dcache, va, &dummy_line_addr, TRUE);
+  if (dc_data) {
+    // set some fields to meet expectations of the simulation mode
+    if (is_store)
+      dc_data->dirty = TRUE;
+    dc_data->read_count[0] += is_load;
+    dc_data->write_count[0] += is_store;
+  } else {
+    warmup_uncore(proc_id, va, FALSE);
+    Addr repl_line_addr;
+    dc_data = (Dcache_Data*)cache_insert(dcache, proc_id, va, &dummy_line_addr, &repl_line_addr);
+    if (dc_data->dirty)
+      warmup_uncore(proc_id, repl_line_addr, TRUE);
+    dc_data->dirty = is_store;
+    dc_data->read_count[0] = is_load;
+    dc_data->write_count[0] = is_store;
+  }
+}
 
-  // Warmup caches for data
+/**************************************************************************************/
+/* cmp_warmup_bp: trains the BP of the op's core (on the warmup thread with
+ * WARMUP_BP_THREAD) */
+
+static void cmp_warmup_bp(Op* op) {
+  bp_warmup_op(&(cmp_model.bp_data[op->proc_id]), op);
+}
+
+/**************************************************************************************/
+/* Warm up select microarchitectural structures: BP, icache, dcache,
+ * and L1. No wrong path warmup. */
+
+void cmp_warmup(Op* op) {
+  uns proc_id = op->proc_id;
+  Addr ia = op->inst_info->addr;
+  Addr va = op->oracle_info.va;
   Flag is_load = op->table_info->mem_type == MEM_LD;
   Flag is_store = op->table_info->mem_type == MEM_ST;
-  if (is_load || is_store) {
-    Cache* dcache = &(cmp_model.dcache_stage[proc_id].dcache);
-    Dcache_Data* dc_data = cache_access(dcache, va, &dummy_line_addr, TRUE);
-    if (dc_data) {
-      // set some fields to meet expectations of the simulation mode
-      if (is_store)
-        dc_data->dirty = TRUE;
-      dc_data->read_count[0] += is_load;
-      dc_data->write_count[0] += is_store;
-    } else {
-      warmup_uncore(proc_id, va, FALSE);
-      Addr repl_line_addr;
-      dc_data = (Dcache_Data*)cache_insert(dcache, proc_id, va, &dummy_line_addr, &repl_line_addr);
-      if (dc_data->dirty)
-        warmup_uncore(proc_id, repl_line_addr, TRUE);
-      dc_data->dirty = is_store;
-      dc_data->read_count[0] = is_load;
-      dc_data->write_count[0] = is_store;
-    }
-  }
+
+  // the instruction side and the BP do not touch the dcache, so its set is
+  // loaded while they are warmed
+  if (is_load || is_store)
+    cache_prefetch_set(&(cmp_model.dcache_stage[proc_id].dcache), va);
+
+  if (BP_STREAM)
+    bp_stream_op(op);
+
+  // Warmup caches for instructions
+  warmup_icache(proc_id, ia);
 
   // Warmup BP for CF instructions
   if (op->table_info->cf_type != NOT_CF) {
-    Bp_Data* bp_data = &(cmp_model.bp_data[proc_id]);
-    bp_predict_op(bp_data, op, 1, ia);
-    bp_target_known_op(bp_data, op);
-    bp_resolve_op(bp_data, op);
-    if (op->oracle_info.mispred || op->oracle_info.misfetch) {
-      bp_recover_op(bp_data, op->table_info->cf_type, &op->recovery_info);
+    if (WARMUP_BP_THREAD)
+      cmp_threads_warmup_post(op);
+    else
+      cmp_warmup_bp(op);
+  }
+
+  // Warmup caches for data
+  if (is_load || is_store)
+    warmup_dcache(proc_id, va, is_store);
+}
+
+/**************************************************************************************/
+/* cmp_warmup_op, cmp_warmup_done: with WARMUP_BP_THREAD, warmup ops are fetched
+ * into the slots of the warmup thread, so a branch can be handed to it as is.
+ * The BP is trained in branch order and the caches in op order, as without
+ * the thread; the end of the warmup waits for the BP to catch up. */
+
+Op* cmp_warmup_op(void) {
+  if (!WARMUP_BP_THREAD)
+    return NULL;
+  ASSERTM(0, !CONFIDENCE_ENABLE, "WARMUP_BP_THREAD does not support CONFIDENCE_ENABLE\n");
+  return cmp_threads_warmup_op(cmp_warmup_bp);
+}
+
+void cmp_warmup_done(void) {
+  cmp_threads_warmup_join();
+}
+
+/**************************************************************************************/
+/* cmp_warmup_skip: warms the caches like cmp_warmup for an instruction skipped
+ * by the frontend. Without ops there is nothing to train the BP with. The dcache
+ * sets of all its accesses are loaded before the first one is warmed. */
+
+void cmp_warmup_skip(uns proc_id, const Frontend_Skip_Inst* inst) {
+  Cache* dcache = &(cmp_model.dcache_stage[proc_id].dcache);
+  for (uns ii = 0; ii < inst->num_ld; ii++)
+    cache_prefetch_set(dcache, inst->ld_vaddr[ii]);
+  for (uns ii = 0; ii < inst->num_st; ii++)
+    cache_prefetch_set(dcache, inst->st_vaddr[ii]);
+
+  warmup_icache(proc_id, inst->addr);
+  for (uns ii = 0; ii < inst->num_ld; ii++)
+    warmup_dcache(proc_id, inst->ld_vaddr[ii], FALSE);
+  for (uns ii = 0; ii < inst->num_st; ii++)
+    warmup_dcache(proc_id, inst->st_vaddr[ii], TRUE);
+}
+
+/**************************************************************************************/
+/* cmp_snapshot: saves or restores the structures trained by cmp_warmup. The
+ * pipeline must be empty. */
+
+void cmp_snapshot(Snapshot* snap) {
+  ASSERTM(0, !L1_PART_SHADOW_WARMUP, "Snapshots do not support the L1 partitioning shadow tags\n");
+  snapshot_section(snap, "CMP");
+  snapshot_check(snap, "NUM_CORES", NUM_CORES);
+  snapshot_check(snap, "PRIVATE_L1", PRIVATE_L1);
+  snapshot_check(snap, "L1_SLICES", cmp_model.memory.num_l1_slices);
+
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Icache_Stage* ic = &(cmp_model.icache_stage[proc_id]);
+    cache_snapshot(&ic->icache, snap);
+    cache_snapshot(&(cmp_model.dcache_stage[proc_id].dcache), snap);
+    // a shared L1 is pointed to by every core
+    if (PRIVATE_L1 || proc_id == 0) {
+      for (uns slice = 0; slice < cmp_model.memory.num_l1_slices; slice++)
+        cache_snapshot(&(cmp_model.memory.uncores[proc_id].l1[slice].cache), snap);
     }
-    bp_data->bp->retire_func(op);
+    bp_snapshot(&(cmp_model.bp_data[proc_id]), snap);
   }
 }
 
@@ -30,6 +30,7 @@
 #define __CMP_MODEL_H__
 
 #include "bp/bp.h"
+#include "frontend/frontend_intf.h"
 #include "memory/memory.h"
 
 #include "cmp_model_support.h"
@@ -48,6 +49,24 @@
 /**************************************************************************************/
 /* cmp model data  */
 
+/* The state of one core. Stage code still reads the per-thread globals (td, node, ...); cmp_set_core_context()
+ * installs a core's state into them, so modules can be moved to take the context explicitly one at a time. */
+typedef struct Core_Context_struct {
+  uns8 proc_id;
+
+  Thread_Data* thread_data;
+  Bp_Recovery_Info* bp_recovery_info;
+  Bp_Data* bp_data;
+
+  Icache_Stage* icache_stage;
+  Decode_Stage* decode_stage;
+  Uop_Cache_Stage* uop_cache_stage;
+  Map_Stage* map_stage;
+  Node_Stage* node_stage;
+  Exec_Stage* exec_stage;
+  Dcache_Stage* dcache_stage;
+} Core_Context;
+
 typedef struct Cmp_Model_struct {
   /* cmp: one thread for each core,
    * "single_td" in sim.c is only for single core */
@@ -67,6 +86,8 @@ typedef struct Cmp_Model_struct {
   Exec_Stage* exec_stage;
   Dcache_Stage* dcache_stage;
 
+  Core_Context* core_context;  // one per core, pointing into the arrays above
+
   uns window_size;
 
 } Cmp_Model;
@@ -88,6 +109,10 @@ void cmp_done(void);
 void cmp_wake(Op*, Op*, uns8);
 void cmp_retire_hook(Op*);
 void cmp_warmup(Op*);
+void cmp_warmup_skip(uns, const Frontend_Skip_Inst*);
+Op* cmp_warmup_op(void);
+void cmp_warmup_done(void);
+void cmp_snapshot(struct Snapshot_struct*);
 
 /**************************************************************************************/
 
@@ -43,6 +43,7 @@
 #include "cmp_model.h"
 #include "lsq.h"
 #include "statistics.h"
+#include "uop_queue_stage.h"
 
 /**************************************************************************************/
 /* cmp_init_cmp_model  */
@@ -68,36 +69,71 @@ void cmp_init_cmp_model() {
   alloc_mem_djolt(NUM_CORES);
   alloc_mem_fnlmma(NUM_CORES);
   alloc_mem_uop_cache(NUM_CORES);
+  alloc_mem_uop_queue_stage(NUM_CORES);
   alloc_mem_idq_stage(NUM_CORES);
   alloc_mem_lsq(NUM_CORES);
+
+  cmp_model.core_context = (Core_Context*)malloc(sizeof(Core_Context) * NUM_CORES);
+  for (uns8 proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Core_Context* core = &cmp_model.core_context[proc_id];
+    core->proc_id = proc_id;
+    core->thread_data = &cmp_model.thread_data[proc_id];
+    core->bp_recovery_info = &cmp_model.bp_recovery_info[proc_id];
+    core->bp_data = &cmp_model.bp_data[proc_id];
+    core->icache_stage = &cmp_model.icache_stage[proc_id];
+    core->decode_stage = &cmp_model.decode_stage[proc_id];
+    core->uop_cache_stage = &cmp_model.uop_cache_stage[proc_id];
+    core->map_stage = &cmp_model.map_stage[proc_id];
+    core->node_stage = &cmp_model.node_stage[proc_id];
+    core->exec_stage = &cmp_model.exec_stage[proc_id];
+    core->dcache_stage = &cmp_model.dcache_stage[proc_id];
+  }
 }
 
 void cmp_init_thread_data(uns8 proc_id) {
   td->proc_id = proc_id;
   init_map(proc_id);
-  init_list(&td->seq_op_list, "SEQ_OP_LIST", sizeof(Op*), TRUE);
+  init_deque(&td->seq_op_list, "SEQ_OP_LIST", sizeof(Op*), SEQ_OP_LIST_SIZE);
 }
 
 /**************************************************************************************/
-/* cmp_set_all_stages  */
-void cmp_set_all_stages(uns8 proc_id) {
-  set_thread_data(&cmp_model.thread_data[proc_id]);
+/* cmp_set_stages: install the pipeline state of core into the per-thread globals */
+static void cmp_set_stages(Core_Context* core) {
+  uns8 proc_id = core->proc_id;
+
+  set_thread_data(core->thread_data);
   set_map_data(&td->map_data);
 
   set_eip(proc_id);
   set_djolt(proc_id);
   set_fnlmma(proc_id);
-  set_fdip(proc_id, &cmp_model.icache_stage[proc_id]);
+  set_fdip(proc_id, core->icache_stage);
   set_decoupled_fe(proc_id);
-  set_icache_stage(&cmp_model.icache_stage[proc_id]);
-  set_decode_stage(&cmp_model.decode_stage[proc_id]);
-  set_uop_cache_stage(&cmp_model.uop_cache_stage[proc_id]);
+  set_icache_stage(core->icache_stage);
+  set_decode_stage(core->decode_stage);
+  set_uop_cache_stage(core->uop_cache_stage);
+  set_uop_queue_stage(proc_id);
   set_idq_stage(proc_id);
-  set_map_stage(&cmp_model.map_stage[proc_id]);
-  set_node_stage(&cmp_model.node_stage[proc_id]);
+  set_map_stage(core->map_stage);
+  set_node_stage(core->node_stage);
   set_lsq(proc_id);
-  set_exec_stage(&cmp_model.exec_stage[proc_id]);
-  set_dcache_stage(&cmp_model.dcache_stage[proc_id]);
+  set_exec_stage(core->exec_stage);
+  set_dcache_stage(core->dcache_stage);
+}
+
+/**************************************************************************************/
+/* cmp_set_core_context: make core the current core, including its branch predictor */
+void cmp_set_core_context(Core_Context* core) {
+  set_bp_data(core->bp_data);
+  set_bp_recovery_info(core->bp_recovery_info);
+  cmp_set_stages(core);
+}
+
+/**************************************************************************************/
+/* cmp_set_all_stages: shim for callers that only know the proc_id; the branch
+ * predictor globals are left alone */
+void cmp_set_all_stages(uns8 proc_id) {
+  cmp_set_stages(&cmp_model.core_context[proc_id]);
 }
 
 /**************************************************************************************/
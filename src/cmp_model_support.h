@@ -36,6 +36,8 @@
 
 void cmp_init_cmp_model(void);
 void cmp_init_thread_data(uns8);
+struct Core_Context_struct;
+void cmp_set_core_context(struct Core_Context_struct*);
 void cmp_set_all_stages(uns8);
 void cmp_init_bogus_sim(uns8);
 
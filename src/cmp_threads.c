@@ -0,0 +1,487 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : cmp_threads.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Host thread pool that simulates the cores of the cmp model in
+ *                parallel. Every simulated cycle the main thread hands the
+ *                per-core work of each phase (recovery, pipeline update) to the
+ *                pool and waits on a barrier before it continues with the
+ *                shared memory system. Also runs the warmup thread, which
+ *                warms one structure on the ops of a functional warmup while
+ *                the main thread warms the others, and places the threads and
+ *                the state they simulate on the host NUMA nodes.
+ ***************************************************************************************/
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE  // CPU affinity
+#endif
+#include "cmp_threads.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "debug/debug_macros.h"
+
+#include "bp/bp.h"
+
+#include "thread.h"
+
+#include "core.param.h"
+#include "prefetcher/pref.param.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_CMP_THREADS, ##args)
+
+/* Number of failed barrier polls before a waiting thread yields its host core */
+#define BARRIER_SPINS_BEFORE_YIELD 1024
+
+/* Ops the warmup thread may trail the main thread by */
+#define WARMUP_THREAD_SLOTS 256
+
+/* NUMA nodes CORE_THREADS_NUMA can tell apart (one word of node mask) */
+#define NUMA_MAX_NODES (8 * sizeof(unsigned long))
+
+/* set_mempolicy modes, from linux/mempolicy.h */
+#define NUMA_MPOL_DEFAULT 0
+#define NUMA_MPOL_PREFERRED 1
+#define NUMA_MPOL_INTERLEAVE 3
+
+/**************************************************************************************/
+/* Types */
+
+/* Sense-reversing spin barrier. Cores are synchronized a few times per
+   simulated cycle, so the futex round trip of a pthread barrier would dominate
+   the time spent simulating a cycle. */
+typedef struct Spin_Barrier_struct {
+  uns num_threads;
+  volatile uns count;
+  volatile Flag sense;
+} Spin_Barrier;
+
+/* An op handed to the warmup thread, with the per-thread globals of the main
+   thread at the time, which the warmup work sees as its own */
+typedef struct Warmup_Slot_struct {
+  Op op;
+  Table_Info table_info;
+  Inst_Info inst_info;
+  Counter cycle_count;
+  Thread_Data* td;
+  Bp_Data* bp_data;
+  Bp_Recovery_Info* bp_recovery_info;
+} Warmup_Slot;
+
+/**************************************************************************************/
+/* Global variables */
+
+Flag cmp_threads_active = FALSE;
+CORE_LOCAL Counter cmp_threads_sync_lag = 0;
+
+static uns num_threads = 1;
+static pthread_t* workers = NULL;
+static Spin_Barrier start_barrier;
+static Spin_Barrier done_barrier;
+static void (*volatile job_func)(uns8) = NULL;
+static volatile Flag workers_exit = FALSE;
+static Flag main_start_sense = FALSE;
+static Flag main_done_sense = FALSE;
+static pthread_mutex_t uncore_mutex;
+
+/* single producer (main thread), single consumer (warmup thread) ring */
+static Warmup_Slot* warmup_slots = NULL;
+static void (*warmup_func)(Op*) = NULL;
+static pthread_t warmup_thread;
+static Flag warmup_thread_running = FALSE;
+static volatile Flag warmup_thread_exit = FALSE;
+static volatile Counter warmup_head = 0;  // slots posted by the main thread
+static volatile Counter warmup_tail = 0;  // slots done by the warmup thread
+#ifndef NO_STAT
+/* stat banks of the first warmup thread, reused by the ones of later phases */
+static Stat_Count* warmup_stat_counts = NULL;
+#endif
+
+/* CORE_THREADS_NUMA placement */
+static Flag numa_active = FALSE;
+static uns thread_node[MAX_NUM_PROCS];  // host node of each core thread
+static cpu_set_t* node_cpus = NULL;     // allowed host CPUs of each node
+static unsigned long threads_node_mask = 0;
+
+/**************************************************************************************/
+/* Local prototypes */
+
+static void spin_barrier_init(Spin_Barrier* barrier, uns count);
+static void spin_barrier_wait(Spin_Barrier* barrier, Flag* local_sense);
+static void run_owned_cores(uns thread_id);
+static void* worker_main(void* arg);
+static void spin_wait(uns* spins);
+static void* warmup_main(void* arg);
+static uns numa_cpu_node(uns cpu);
+static void numa_init(void);
+static void numa_set_policy(int mode, unsigned long node_mask);
+
+/**************************************************************************************/
+/* spin_barrier_init: */
+
+static void spin_barrier_init(Spin_Barrier* barrier, uns count) {
+  barrier->num_threads = count;
+  barrier->count = count;
+  barrier->sense = FALSE;
+}
+
+/**************************************************************************************/
+/* spin_barrier_wait: local_sense is owned by the calling thread */
+
+static void spin_barrier_wait(Spin_Barrier* barrier, Flag* local_sense) {
+  *local_sense = !*local_sense;
+  if (__atomic_sub_fetch(&barrier->count, 1, __ATOMIC_ACQ_REL) == 0) {
+    barrier->count = barrier->num_threads;
+    __atomic_store_n(&barrier->sense, *local_sense, __ATOMIC_RELEASE);
+  } else {
+    uns spins = 0;
+    while (__atomic_load_n(&barrier->sense, __ATOMIC_ACQUIRE) != *local_sense) {
+      if (++spins == BARRIER_SPINS_BEFORE_YIELD) {
+        spins = 0;
+        sched_yield();
+      }
+    }
+  }
+}
+
+/**************************************************************************************/
+/* run_owned_cores: */
+
+static void run_owned_cores(uns thread_id) {
+  for (uns proc_id = thread_id; proc_id < NUM_CORES; proc_id += num_threads) {
+    job_func(proc_id);
+  }
+}
+
+/**************************************************************************************/
+/* worker_main: */
+
+static void* worker_main(void* arg) {
+  uns thread_id = (uns)(uintptr_t)arg;
+  Flag start_sense = FALSE;
+  Flag done_sense = FALSE;
+
+  while (TRUE) {
+    spin_barrier_wait(&start_barrier, &start_sense);
+    if (workers_exit)
+      break;
+    run_owned_cores(thread_id);
+    spin_barrier_wait(&done_barrier, &done_sense);
+  }
+  return NULL;
+}
+
+/**************************************************************************************/
+/* spin_wait: one failed poll of a waiting thread */
+
+static void spin_wait(uns* spins) {
+  if (++*spins == BARRIER_SPINS_BEFORE_YIELD) {
+    *spins = 0;
+    sched_yield();
+  }
+}
+
+/**************************************************************************************/
+/* warmup_main: */
+
+static void* warmup_main(void* arg) {
+  uns spins = 0;
+#ifndef NO_STAT
+  // a thread is started for every warmup phase, but each takes over the same
+  // bank set rather than attaching one more
+  thread_stat_counts = warmup_stat_counts;
+#endif
+
+  while (TRUE) {
+    Counter tail = warmup_tail;
+    if (tail == __atomic_load_n(&warmup_head, __ATOMIC_ACQUIRE)) {
+      if (__atomic_load_n(&warmup_thread_exit, __ATOMIC_ACQUIRE) &&
+          tail == __atomic_load_n(&warmup_head, __ATOMIC_ACQUIRE))
+        break;
+      spin_wait(&spins);
+      continue;
+    }
+    spins = 0;
+    Warmup_Slot* slot = &warmup_slots[tail % WARMUP_THREAD_SLOTS];
+    cycle_count = slot->cycle_count;
+    set_thread_data(slot->td);
+    set_bp_data(slot->bp_data);
+    set_bp_recovery_info(slot->bp_recovery_info);
+    warmup_func(&slot->op);
+    __atomic_store_n(&warmup_tail, tail + 1, __ATOMIC_RELEASE);
+  }
+#ifndef NO_STAT
+  warmup_stat_counts = thread_stat_counts;  // read by the next phase only after the join
+#endif
+  return NULL;
+}
+
+/**************************************************************************************/
+/* numa_cpu_node: the host node of a CPU, 0 if sysfs does not say */
+
+static uns numa_cpu_node(uns cpu) {
+  char path[MAX_STR_LENGTH + 1];
+  for (uns node = 0; node < NUMA_MAX_NODES; node++) {
+    snprintf(path, MAX_STR_LENGTH, "/sys/devices/system/cpu/cpu%u/node%u", cpu, node);
+    if (!access(path, F_OK))
+      return node;
+  }
+  return 0;
+}
+
+/**************************************************************************************/
+/* numa_init: gives the core threads host nodes in proportion to the allowed
+   CPUs of each node (thread t takes the node of the (t / num_threads)th part
+   of the CPUs in node order) and binds the main thread to its node. Threads
+   are bound to a whole node rather than a CPU, so the helper threads they
+   start share the node instead of one CPU. */
+
+static void numa_init(void) {
+  cpu_set_t allowed;
+  int failed = sched_getaffinity(0, sizeof(allowed), &allowed);
+  ASSERTUM(0, !failed, "Could not read the host CPU affinity\n");
+
+  uns num_cpus = CPU_COUNT(&allowed);
+  uns* cpu_nodes = (uns*)malloc(sizeof(uns) * num_cpus);
+  node_cpus = (cpu_set_t*)calloc(NUMA_MAX_NODES, sizeof(cpu_set_t));
+  uns count = 0;
+  for (uns cpu = 0; cpu < CPU_SETSIZE && count < num_cpus; cpu++) {
+    if (!CPU_ISSET(cpu, &allowed))
+      continue;
+    uns node = numa_cpu_node(cpu);
+    CPU_SET(cpu, &node_cpus[node]);
+    // keep the CPU nodes sorted
+    uns pos = count++;
+    for (; pos > 0 && cpu_nodes[pos - 1] > node; pos--)
+      cpu_nodes[pos] = cpu_nodes[pos - 1];
+    cpu_nodes[pos] = node;
+  }
+
+  for (uns thread_id = 0; thread_id < num_threads; thread_id++) {
+    thread_node[thread_id] = cpu_nodes[(uns64)thread_id * count / num_threads];
+    threads_node_mask |= 1UL << thread_node[thread_id];
+    DEBUG(0, "Core thread %u on host node %u\n", thread_id, thread_node[thread_id]);
+  }
+  free(cpu_nodes);
+
+  int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &node_cpus[thread_node[0]]);
+  ASSERTM(0, !err, "Could not bind the main thread to host node %u (error %d)\n", thread_node[0], err);
+  numa_active = TRUE;
+}
+
+/**************************************************************************************/
+/* numa_set_policy: */
+
+static void numa_set_policy(int mode, unsigned long node_mask) {
+  if (syscall(SYS_set_mempolicy, mode, mode == NUMA_MPOL_DEFAULT ? NULL : &node_mask, NUMA_MAX_NODES + 1))
+    WARNINGU_ONCE(0, "Could not set the NUMA memory policy; state stays on the main thread's node\n");
+}
+
+/**************************************************************************************/
+/* cmp_threads_numa_core: */
+
+void cmp_threads_numa_core(uns8 proc_id) {
+  if (numa_active)
+    numa_set_policy(NUMA_MPOL_PREFERRED, 1UL << thread_node[proc_id % num_threads]);
+}
+
+/**************************************************************************************/
+/* cmp_threads_numa_shared: */
+
+void cmp_threads_numa_shared(void) {
+  if (numa_active)
+    numa_set_policy(NUMA_MPOL_INTERLEAVE, threads_node_mask);
+}
+
+/**************************************************************************************/
+/* cmp_threads_numa_default: */
+
+void cmp_threads_numa_default(void) {
+  if (numa_active)
+    numa_set_policy(NUMA_MPOL_DEFAULT, 0);
+}
+
+/**************************************************************************************/
+/* cmp_threads_init: */
+
+void cmp_threads_init(void) {
+  pthread_mutexattr_t attr;
+
+  num_threads = MIN2(MAX2(NUM_CORE_THREADS, 1), NUM_CORES);
+  if (num_threads == 1)
+    return;
+
+  ASSERTM(0, !EIP_ENABLE && !DJOLT_ENABLE && !FNLMMA_ENABLE,
+          "EIP, D-JOLT and FNL+MMA keep tables shared by all cores and cannot be used with NUM_CORE_THREADS > 1\n");
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&uncore_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  spin_barrier_init(&start_barrier, num_threads);
+  spin_barrier_init(&done_barrier, num_threads);
+
+  if (CORE_THREADS_NUMA)
+    numa_init();
+
+  workers = (pthread_t*)malloc(sizeof(pthread_t) * num_threads);
+  for (uns thread_id = 1; thread_id < num_threads; thread_id++) {
+    pthread_attr_t thread_attr;
+    pthread_attr_init(&thread_attr);
+    if (numa_active)
+      pthread_attr_setaffinity_np(&thread_attr, sizeof(cpu_set_t), &node_cpus[thread_node[thread_id]]);
+    int err = pthread_create(&workers[thread_id], &thread_attr, worker_main, (void*)(uintptr_t)thread_id);
+    ASSERTM(0, err == 0, "Could not create core thread %u (error %d)\n", thread_id, err);
+    pthread_attr_destroy(&thread_attr);
+  }
+  cmp_threads_active = TRUE;
+  DEBUG(0, "Simulating %u cores on %u host threads\n", NUM_CORES, num_threads);
+}
+
+/**************************************************************************************/
+/* cmp_threads_done: */
+
+void cmp_threads_done(void) {
+  cmp_threads_warmup_join();
+  free(warmup_slots);
+  warmup_slots = NULL;
+
+  if (!cmp_threads_active)
+    return;
+
+  workers_exit = TRUE;
+  spin_barrier_wait(&start_barrier, &main_start_sense);
+  for (uns thread_id = 1; thread_id < num_threads; thread_id++) {
+    pthread_join(workers[thread_id], NULL);
+  }
+  free(workers);
+  workers = NULL;
+  cmp_threads_active = FALSE;
+  pthread_mutex_destroy(&uncore_mutex);
+}
+
+/**************************************************************************************/
+/* cmp_threads_for_each_core: */
+
+void cmp_threads_for_each_core(void (*func)(uns8 proc_id)) {
+  job_func = func;
+  if (!cmp_threads_active) {
+    run_owned_cores(0);
+    return;
+  }
+
+  spin_barrier_wait(&start_barrier, &main_start_sense);
+  run_owned_cores(0);
+  spin_barrier_wait(&done_barrier, &main_done_sense);
+}
+
+/**************************************************************************************/
+/* cmp_threads_uncore_lock_scope: */
+
+Flag cmp_threads_uncore_lock_scope(void) {
+  if (!cmp_threads_active)
+    return FALSE;
+  pthread_mutex_lock(&uncore_mutex);
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* cmp_threads_uncore_unlock_scope: */
+
+void cmp_threads_uncore_unlock_scope(Flag* locked) {
+  if (*locked)
+    pthread_mutex_unlock(&uncore_mutex);
+}
+
+/**************************************************************************************/
+/* cmp_threads_warmup_op: */
+
+Op* cmp_threads_warmup_op(void (*func)(Op*)) {
+  if (!warmup_slots) {
+    /* the slots embed an Op, which is cache-line aligned (calloc only
+       guarantees 16 bytes) */
+    int error =
+        posix_memalign((void**)&warmup_slots, __alignof__(Warmup_Slot), WARMUP_THREAD_SLOTS * sizeof(Warmup_Slot));
+    ASSERTUM(0, error == 0, "Could not allocate the warmup thread slots\n");
+    memset(warmup_slots, 0, WARMUP_THREAD_SLOTS * sizeof(Warmup_Slot));
+    for (uns ii = 0; ii < WARMUP_THREAD_SLOTS; ii++) {
+      warmup_slots[ii].op.table_info = &warmup_slots[ii].table_info;
+      warmup_slots[ii].op.inst_info = &warmup_slots[ii].inst_info;
+      warmup_slots[ii].op.mbp7_info = NULL;
+    }
+  }
+  if (!warmup_thread_running) {
+    warmup_func = func;
+    warmup_thread_exit = FALSE;
+    int err = pthread_create(&warmup_thread, NULL, warmup_main, NULL);
+    ASSERTM(0, err == 0, "Could not create the warmup thread (error %d)\n", err);
+    warmup_thread_running = TRUE;
+  }
+  ASSERT(0, warmup_func == func);
+
+  // wait for the slot to be done with
+  uns spins = 0;
+  while (warmup_head - __atomic_load_n(&warmup_tail, __ATOMIC_ACQUIRE) == WARMUP_THREAD_SLOTS)
+    spin_wait(&spins);
+  return &warmup_slots[warmup_head % WARMUP_THREAD_SLOTS].op;
+}
+
+/**************************************************************************************/
+/* cmp_threads_warmup_post: */
+
+void cmp_threads_warmup_post(Op* op) {
+  Warmup_Slot* slot = &warmup_slots[warmup_head % WARMUP_THREAD_SLOTS];
+  ASSERT(0, op == &slot->op);
+  slot->cycle_count = cycle_count;
+  slot->td = td;
+  slot->bp_data = g_bp_data;
+  slot->bp_recovery_info = bp_recovery_info;
+  __atomic_store_n(&warmup_head, warmup_head + 1, __ATOMIC_RELEASE);
+}
+
+/**************************************************************************************/
+/* cmp_threads_warmup_join: */
+
+void cmp_threads_warmup_join(void) {
+  if (!warmup_thread_running)
+    return;
+  __atomic_store_n(&warmup_thread_exit, TRUE, __ATOMIC_RELEASE);
+  pthread_join(warmup_thread, NULL);
+  warmup_thread_running = FALSE;
+}
@@ -0,0 +1,104 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : cmp_threads.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Host thread pool that simulates the cores of the cmp model in
+ *                parallel (see NUM_CORE_THREADS).
+ ***************************************************************************************/
+
+#ifndef __CMP_THREADS_H__
+#define __CMP_THREADS_H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* External variables */
+
+/* TRUE while the cores are being simulated by more than one host thread */
+extern Flag cmp_threads_active;
+
+/* While a core catches up on the cycles of a sync quantum (SYNC_QUANTUM > 1),
+   the number of its cycles by which it trails the uncore; 0 otherwise */
+extern CORE_LOCAL Counter cmp_threads_sync_lag;
+
+/**************************************************************************************/
+/* Macros */
+
+/* Serializes the rest of the enclosing scope with all other users of the
+   state shared between cores (the uncore, the op pool, the frontend). The
+   lock is recursive and released automatically when the scope is left, so it
+   can be taken at the top of functions with several return points. */
+#define UNCORE_LOCK_SCOPE()                                                                     \
+  Flag uncore_lock_scope __attribute__((cleanup(cmp_threads_uncore_unlock_scope), unused)) = \
+      cmp_threads_uncore_lock_scope()
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Starts the worker threads if NUM_CORE_THREADS asks for more than one */
+void cmp_threads_init(void);
+
+/* With CORE_THREADS_NUMA, memory the calling thread first touches from now on
+   is placed on the NUMA node of the thread that simulates proc_id
+   (cmp_threads_numa_core), interleaved over the nodes of all core threads
+   (cmp_threads_numa_shared), or on the toucher's node as usual
+   (cmp_threads_numa_default). Otherwise they do nothing. */
+void cmp_threads_numa_core(uns8 proc_id);
+void cmp_threads_numa_shared(void);
+void cmp_threads_numa_default(void);
+
+/* Stops and joins the worker threads */
+void cmp_threads_done(void);
+
+/* Calls func for every core and returns when all calls are finished. A core is
+   always simulated by the same host thread, core i by thread i %
+   NUM_CORE_THREADS, where thread 0 is the calling (main) thread. */
+void cmp_threads_for_each_core(void (*func)(uns8 proc_id));
+
+/* The warmup thread runs func, in order, on the ops posted to it while the
+   main thread goes on with the warmup. cmp_threads_warmup_op returns the op
+   the next warmup op is to be fetched into (starting the thread if needed);
+   posting that op hands it over, otherwise it is returned again. */
+Op* cmp_threads_warmup_op(void (*func)(Op*));
+void cmp_threads_warmup_post(Op* op);
+
+/* Waits until every posted op is done and stops the warmup thread */
+void cmp_threads_warmup_join(void);
+
+Flag cmp_threads_uncore_lock_scope(void);
+void cmp_threads_uncore_unlock_scope(Flag* locked);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**************************************************************************************/
+
+#endif /* #ifndef __CMP_THREADS_H__ */
@@ -1,5 +1,7 @@
 #include "confidence/btb_miss_bp_taken_conf.hpp"
 
+#include <algorithm>
+
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_CONF, ##args)
 
 BTBMissBPTakenConfStat::BTBMissBPTakenConfStat(uns _proc_id, BTBMissBPTakenConf* _conf_mech)
@@ -52,19 +54,20 @@ void BTBMissBPTakenConfStat::print_data() {
     fclose(fp);
   }
   if (CONF_LOG_DFE_TO_REC) {
+    // op_nums are reused after a recovery, so fetch order is not quite op_num order
+    std::stable_sort(resteer_events.begin(), resteer_events.end(),
+                     [](const Resteer_Event& a, const Resteer_Event& b) { return a.op_num < b.op_num; });
     fp = fopen("off_path_events_cycles.csv", "w");
     fprintf(fp, "op_num,dfe_cycle,resolved_cycle,off_path_reason\n");
-    for (const std::pair<const Counter, std::tuple<Counter, Counter, Off_Path_Reason>>& line : resteer_ops_cycles) {
-      fprintf(fp, "%llu,%llu,%llu,%d", line.first, std::get<0>(line.second), std::get<1>(line.second),
-              std::get<2>(line.second));
+    for (const Resteer_Event& event : resteer_events) {
+      fprintf(fp, "%llu,%llu,%llu,%d", event.op_num, event.dfe_cycle, event.resolved_cycle, event.reason);
       fprintf(fp, "\n");
     }
     fclose(fp);
     fp = fopen("off_path_events_ops.csv", "w");
     fprintf(fp, "op_num,dfe_num_ops,resolved_num_ops,off_path_reason\n");
-    for (const std::pair<const Counter, std::tuple<Counter, Counter, Off_Path_Reason>>& line : resteer_ops_ops) {
-      fprintf(fp, "%llu,%llu,%llu,%d", line.first, std::get<0>(line.second), std::get<1>(line.second),
-              std::get<2>(line.second));
+    for (const Resteer_Event& event : resteer_events) {
+      fprintf(fp, "%llu,%llu,%llu,%d", event.op_num, event.dfe_num_ops, event.resolved_num_ops, event.reason);
       fprintf(fp, "\n");
     }
     fclose(fp);
@@ -124,27 +127,36 @@ void BTBMissBPTakenConfStat::log_off_path_event(Op* op) {
   Off_Path_Reason op_reason = (Off_Path_Reason)op->oracle_info.off_path_reason;
   if (!op_reason)
     return;
-  std::get<0>(resteer_ops_cycles[op->op_num]) = cycle_count;
-  std::get<1>(resteer_ops_cycles[op->op_num]) = 0;
-  std::get<2>(resteer_ops_cycles[op->op_num]) = op_reason;
-
-  std::get<0>(resteer_ops_ops[op->op_num]) = *op_count;
-  std::get<1>(resteer_ops_ops[op->op_num]) = 0;
-  std::get<2>(resteer_ops_ops[op->op_num]) = op_reason;
+  Resteer_Event* event = find_resteer_event(op->op_num);
+  if (!event) {
+    if (resteer_ring.empty())
+      resteer_ring.assign(RESTEER_RING_SIZE, std::make_pair(MAX_CTR, (size_t)0));
+    resteer_ring[op->op_num & (RESTEER_RING_SIZE - 1)] = std::make_pair(op->op_num, resteer_events.size());
+    resteer_events.emplace_back();
+    event = &resteer_events.back();
+  }
+  *event = {op->op_num, cycle_count, 0, *op_count, 0, op_reason};
 }
 
 void BTBMissBPTakenConfStat::log_resolution(Op* op) {
   if (!CONFIDENCE_ENABLE || !CONF_LOG_DFE_TO_REC)
     return;
-  Off_Path_Reason op_reason = (Off_Path_Reason)op->oracle_info.off_path_reason;
-  std::get<1>(resteer_ops_cycles[op->op_num]) = cycle_count;
-  std::get<2>(resteer_ops_cycles[op->op_num]) = op_reason;
-
-  std::get<1>(resteer_ops_cycles[op->op_num]) = *op_count;
-  std::get<2>(resteer_ops_cycles[op->op_num]) = op_reason;
+  Resteer_Event* event = find_resteer_event(op->op_num);
+  if (event) {
+    event->resolved_cycle = cycle_count;
+    event->resolved_num_ops = *op_count;
+    event->reason = (Off_Path_Reason)op->oracle_info.off_path_reason;
+  }
   DEBUG(proc_id, "Op off-path reason");
 }
 
+BTBMissBPTakenConfStat::Resteer_Event* BTBMissBPTakenConfStat::find_resteer_event(Counter op_num) {
+  if (resteer_ring.empty())
+    return nullptr;
+  const std::pair<Counter, size_t>& slot = resteer_ring[op_num & (RESTEER_RING_SIZE - 1)];
+  return slot.first == op_num ? &resteer_events[slot.second] : nullptr;
+}
+
 void BTBMissBPTakenConf::per_op_update(Op* op, Conf_Off_Path_Reason& new_reason) {
   if (!CONFIDENCE_ENABLE)
     return;
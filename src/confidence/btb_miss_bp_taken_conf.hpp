@@ -1,7 +1,6 @@
 #ifndef __BTB_MISS_BP_TAKEN_H__
 #define __BTB_MISS_BP_TAKEN_H__
 
-#include <map>
 #include <tuple>
 #include <vector>
 
@@ -33,8 +32,21 @@ class BTBMissBPTakenConfStat : public ConfMechStatBase {
   std::vector<phase_cycles_line> mispred_event_cycles;
   std::vector<phase_cycles_line> misfetch_event_cycles;
 
-  std::map<Counter, std::tuple<Counter, Counter, Off_Path_Reason>> resteer_ops_cycles;
-  std::map<Counter, std::tuple<Counter, Counter, Off_Path_Reason>> resteer_ops_ops;
+  // one per off-path event, in the order they were fetched; a refetched op_num reuses its event
+  struct Resteer_Event {
+    Counter op_num;
+    Counter dfe_cycle;
+    Counter resolved_cycle;
+    Counter dfe_num_ops;
+    Counter resolved_num_ops;
+    Off_Path_Reason reason;
+  };
+  std::vector<Resteer_Event> resteer_events;
+
+  // op_num-indexed ring of the events of in-flight ops: (op_num, index into resteer_events)
+  static const Counter RESTEER_RING_SIZE = 1 << 16;
+  std::vector<std::pair<Counter, size_t>> resteer_ring;
+  Resteer_Event* find_resteer_event(Counter op_num);
 };
 
 class BTBMissBPTakenConf : public ConfMechBase {
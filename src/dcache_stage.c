@@ -46,11 +46,13 @@
 #include "prefetcher/pref.param.h"
 
 #include "bp/bp.h"
+#include "memory/tlb.h"
 #include "prefetcher/l2l1pref.h"
 #include "prefetcher/pref_common.h"
 #include "prefetcher/stream_pref.h"
 
 #include "cmp_model.h"
+#include "cmp_threads.h"
 #include "map.h"
 #include "model.h"
 #include "statistics.h"
@@ -64,7 +66,7 @@
 /**************************************************************************************/
 /* Global Variables */
 
-Dcache_Stage* dc = NULL;
+CORE_LOCAL Dcache_Stage* dc = NULL;
 
 /**************************************************************************************/
 /* Prototypes for Inline Methods */
@@ -104,6 +106,7 @@ void init_dcache_stage(uns8 proc_id, const char* name) {
 
   /* initialize the cache structure */
   init_cache(&dc->dcache, "DCACHE", DCACHE_SIZE, DCACHE_ASSOC, DCACHE_LINE_SIZE, sizeof(Dcache_Data), DCACHE_REPL);
+  cache_enable_lookup_memo(&dc->dcache, CACHE_LOOKUP_MEMO_ENTRIES, proc_id, DCACHE_LOOKUP_MEMO_MISS);
   reset_dcache_stage();
 
   dc->ports = (Ports*)malloc(sizeof(Ports) * DCACHE_BANKS);
@@ -224,6 +227,16 @@ void update_dcache_stage(Stage_Data* src_sd) {
       continue;
     }
 
+    /* wait for the page to be translated */
+    if (TLB_ON && !PERFECT_DCACHE) {
+      if (!tlb_translate(op->proc_id, TLB_DATA, op->oracle_info.va, op->tlb_wait)) {
+        op->tlb_wait = TRUE;
+        op->state = OS_WAIT_DCACHE;
+        continue;
+      }
+      op->tlb_wait = FALSE;
+    }
+
     /* check on the availability of a read port for the given bank */
     // the bank bits are the lowest order cache index bits
     uns bank = op->oracle_info.va >> dc->dcache.shift_bits & N_BIT_MASK(LOG2(DCACHE_BANKS));
@@ -283,6 +296,7 @@ void update_dcache_stage(Stage_Data* src_sd) {
   }
 
   /* prefetcher update */
+  UNCORE_LOCK_SCOPE();
   if (STREAM_PREFETCH_ON)
     update_pref_queue();
   if (L2WAY_PREF && !L1PREF_IMMEDIATE)
@@ -291,17 +305,28 @@ void update_dcache_stage(Stage_Data* src_sd) {
     update_l2markv_pref_req_queue();
 }
 
+/**************************************************************************************/
+/* dcache_stage_next_event_cycle: ops waiting for a port retry every cycle and
+ * the prefetch request queues drain on their own */
+
+Counter dcache_stage_next_event_cycle() {
+  if (dc->sd.op_count || STREAM_PREFETCH_ON || (L2WAY_PREF && !L1PREF_IMMEDIATE) ||
+      (L2MARKV_PREF_ON && !L1MARKV_PREF_IMMEDIATE))
+    return cycle_count + 1;
+  return MAX_CTR;
+}
+
 /**************************************************************************************/
 /* External API for architectural cache */
 
 Flag dcache_fill_line(Mem_Req* req) {
   set_dcache_stage(&cmp_model.dcache_stage[req->proc_id]);
   Counter old_cycle_count = cycle_count;  // FIXME HACK!
-  cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[req->proc_id]);
+  if (!cmp_threads_sync_lag)  // keep the cycle of a core catching up on a sync quantum
+    cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[req->proc_id]);
 
   ASSERT(dc->proc_id, dc->proc_id == req->proc_id);
-  ASSERT(dc->proc_id, req->op_count == req->op_ptrs.count);
-  ASSERT(dc->proc_id, req->op_count == req->op_uniques.count);
+  ASSERT(dc->proc_id, req->op_count <= req->waiter_slots);
 
   /* if it can't get a write port, fail */
   uns bank = req->addr >> dc->dcache.shift_bits & N_BIT_MASK(LOG2(DCACHE_BANKS));
@@ -335,9 +360,7 @@ Flag dcache_fill_line(Mem_Req* req) {
      * and all end up evicting a dirty line
      */
 
-    ASSERT(dc->proc_id, 0 < dc->ports[bank].write_ports_in_use);
-    dc->ports[bank].write_ports_in_use--;
-    ASSERT(dc->proc_id, dc->ports[bank].write_ports_in_use < dc->ports->num_write_ports);
+    release_write_port(&dc->ports[bank]);
 
     /* TODO: fix this by using a new_cycle_count to avoid replacing cycle_count */
     cycle_count = old_cycle_count;
@@ -437,7 +460,7 @@ static inline void dcache_hit_wp_collect_stats(Dcache_Data* line, Op* op) {
   STAT_EVENT(dc->proc_id, DIST_REQBUF_OFFPATH_USED);
   STAT_EVENT(dc->proc_id, DIST2_REQBUF_OFFPATH_USED_FULL);
 
-  L1_Data* l1_line = do_l1_access(op);
+  L1_Wp_Data* l1_line = do_l1_wp_access(op);
   if (l1_line) {
     if (l1_line->fetched_by_offpath) {
       STAT_EVENT(dc->proc_id, L1_USE_OFFPATH);
@@ -804,17 +827,13 @@ static inline void dcache_fill_process_cacheline(Mem_Req* req, Dcache_Data* data
   }
 
   /* process req op */
-  Op** op_p = (Op**)list_start_head_traversal(&req->op_ptrs);
-  Counter* op_unique = (Counter*)list_start_head_traversal(&req->op_uniques);
-  for (; op_p;
-       op_p = (Op**)list_next_element(&req->op_ptrs), op_unique = (Counter*)list_next_element(&req->op_uniques)) {
-    Op* op = *op_p;
+  for (uns ii = 0; ii < req->op_count; ii++) {
+    Op* op = req->waiters[ii].op;
     ASSERT(dc->proc_id, op);
-    ASSERT(dc->proc_id, op_unique);
     ASSERT(dc->proc_id, dc->proc_id == op->proc_id);
     ASSERT(dc->proc_id, op->proc_id == req->proc_id);
 
-    if (op->unique_num != *op_unique || !op->op_pool_valid) {
+    if (op->unique_num != req->waiters[ii].unique_num || !op->op_pool_valid) {
       continue;
     }
 
@@ -80,7 +80,7 @@ typedef struct Dcache_Data_struct {
 /**************************************************************************************/
 /* External variables */
 
-extern Dcache_Stage* dc;
+extern CORE_LOCAL Dcache_Stage* dc;
 
 /**************************************************************************************/
 /* Prototypes */
@@ -91,6 +91,7 @@ void reset_dcache_stage(void);
 void recover_dcache_stage(void);
 void debug_dcache_stage(void);
 void update_dcache_stage(Stage_Data*);
+Counter dcache_stage_next_event_cycle(void);
 
 Flag dcache_fill_line(Mem_Req*);
 Flag do_oracle_dcache_access(Op*, Addr*);
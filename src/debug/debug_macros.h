@@ -46,6 +46,9 @@ output when
 #include <stdio.h>
 
 #include "globals/global_defs.h"
+
+#include "debug/trace_event.h"
+
 #include "globals/utils.h"
 
 #include "debug/debug.param.h"
@@ -91,6 +94,22 @@ output when
   {}
 #endif
 
+/**************************************************************************************/
+/* Prints one debug line with its file/flag/counter prefix. With DEBUG_ASYNC the
+   line is handed to the trace event I/O thread instead of being written and
+   flushed here. */
+#define DEBUG_PRINT_LINE(proc_id, debug_flag, args...)                                                            \
+  do {                                                                                                            \
+    if (TRACE_EVENT_ON(TRACE_EVENT_DEBUG)) {                                                                      \
+      trace_event_debug(__FILE__, __LINE__, #debug_flag, proc_id, ##args);                                        \
+    } else {                                                                                                      \
+      fprintf(GLOBAL_DEBUG_STREAM, "%s:%u: " #debug_flag " (P=%u O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, \
+              proc_id, op_count[proc_id], inst_count[proc_id], cycle_count);                                      \
+      fprintf(GLOBAL_DEBUG_STREAM, ##args);                                                                       \
+      fflush(GLOBAL_DEBUG_STREAM);                                                                                \
+    }                                                                                                             \
+  } while (0)
+
 /**************************************************************************************/
 
 #if ENABLE_GLOBAL_DEBUG_PRINT
@@ -99,22 +118,23 @@ output when
 #define _DEBUG(proc_id, debug_flag, args...)                                                                      \
   do {                                                                                                            \
     if (debug_flag && DEBUG_RANGE_COND(proc_id)) {                                                                \
-      fprintf(GLOBAL_DEBUG_STREAM, "%s:%u: " #debug_flag " (P=%u O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, \
-              proc_id, op_count[proc_id], inst_count[proc_id], cycle_count);                                      \
-      fprintf(GLOBAL_DEBUG_STREAM, ##args);                                                                       \
-      fflush(GLOBAL_DEBUG_STREAM);                                                                                \
+      DEBUG_PRINT_LINE(proc_id, debug_flag, ##args);                                                              \
     }                                                                                                             \
   } while (0)
 
 /* Prints args printf-style if debug_flag is on and simulation is in
    the debugging range. Does not print proc_id, op_count, inst_count, cycle
    count. i.e., it only prints the given statement.*/
-#define _DEBUG_LEAN(proc_id, debug_flag, args...)  \
-  do {                                             \
-    if (debug_flag && DEBUG_RANGE_COND(proc_id)) { \
-      fprintf(GLOBAL_DEBUG_STREAM, ##args);        \
-      fflush(GLOBAL_DEBUG_STREAM);                 \
-    }                                              \
+#define _DEBUG_LEAN(proc_id, debug_flag, args...)      \
+  do {                                                 \
+    if (debug_flag && DEBUG_RANGE_COND(proc_id)) {     \
+      if (TRACE_EVENT_ON(TRACE_EVENT_DEBUG)) {         \
+        trace_event_printf(TRACE_EVENT_DEBUG, ##args); \
+      } else {                                         \
+        fprintf(GLOBAL_DEBUG_STREAM, ##args);          \
+        fflush(GLOBAL_DEBUG_STREAM);                   \
+      }                                                \
+    }                                                  \
   } while (0)
 
 /* Macro for tracing args to a file stream. */
@@ -130,10 +150,7 @@ output when
 #define _DEBUGU(proc_id, debug_flag, args...)                                                                     \
   do {                                                                                                            \
     if (debug_flag) {                                                                                             \
-      fprintf(GLOBAL_DEBUG_STREAM, "%s:%u: " #debug_flag " (P=%u O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, \
-              proc_id, op_count[proc_id], inst_count[proc_id], cycle_count);                                      \
-      fprintf(GLOBAL_DEBUG_STREAM, ##args);                                                                       \
-      fflush(GLOBAL_DEBUG_STREAM);                                                                                \
+      DEBUG_PRINT_LINE(proc_id, debug_flag, ##args);                                                              \
     }                                                                                                             \
   } while (0)
 
@@ -142,10 +159,7 @@ output when
 #define _DEBUGC(proc_id, debug_flag, cond, args...)                                                               \
   do {                                                                                                            \
     if ((cond) && debug_flag && DEBUG_RANGE_COND(proc_id)) {                                                      \
-      fprintf(GLOBAL_DEBUG_STREAM, "%s:%u: " #debug_flag " (P=%u O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, \
-              proc_id, op_count[proc_id], inst_count[proc_id], cycle_count);                                      \
-      fprintf(GLOBAL_DEBUG_STREAM, ##args);                                                                       \
-      fflush(GLOBAL_DEBUG_STREAM);                                                                                \
+      DEBUG_PRINT_LINE(proc_id, debug_flag, ##args);                                                              \
     }                                                                                                             \
   } while (0)
 
@@ -203,10 +217,7 @@ output when
 #define _DEBUGA(proc_id, debug_flag, args...)                                                                     \
   do {                                                                                                            \
     if (debug_flag && DEBUG_RANGE_COND(proc_id)) {                                                                \
-      fprintf(GLOBAL_DEBUG_STREAM, "%s:%u: " #debug_flag " (P=%u O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, \
-              proc_id, op_count[proc_id], inst_count[proc_id], cycle_count);                                      \
-      fprintf(GLOBAL_DEBUG_STREAM, ##args);                                                                       \
-      fflush(GLOBAL_DEBUG_STREAM);                                                                                \
+      DEBUG_PRINT_LINE(proc_id, debug_flag, ##args);                                                              \
     }                                                                                                             \
   } while (0)
 
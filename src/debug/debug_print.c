@@ -100,7 +100,7 @@ const char* const bar_type_names[] = {"NOT_BAR"};
 DEFINE_ENUM(Op_State, OP_STATE_LIST);
 
 const char* const icache_state_names[] = {"ICACHE_STAGE_RESTEER", "ICACHE_MEM_REQ", "ICACHE_WAIT_FOR_MISS",
-                                          "ICACHE_SERVING", "UOP_CACHE_SERVING"};
+                                          "ICACHE_WAIT_FOR_ITLB", "ICACHE_SERVING", "UOP_CACHE_SERVING"};
 
 const char* const tcache_state_names[] = {"TC_FETCH",
                                           "TC_WAIT_FOR_MISS",
@@ -343,6 +343,28 @@ void print_op(Op* op) {
 /* print_func_op: */
 
 void print_func_op(Op* op) {
+  char line[4 * MAX_STR_LENGTH + 1];
+  sprint_func_op(line, op);
+  fprintf(GLOBAL_DEBUG_STREAM, "%s\n", line);
+}
+
+/**************************************************************************************/
+/* print_retired_op: one line per retired op, prefixed with its retire cycle, in
+   the format bin/scarab_verify_modes.py compares across runs. The line is
+   written with a single call so lines of cores on different threads do not
+   mix. */
+
+void print_retired_op(Op* op) {
+  char line[4 * MAX_STR_LENGTH + 1];
+  sprint_func_op(line, op);
+  fprintf(GLOBAL_DEBUG_STREAM, "RETIRE %llu %s\n", op->retire_cycle, line);
+}
+
+/**************************************************************************************/
+/* sprint_func_op: the functional fields of an op (core, pc, type, registers and
+   memory access), without a newline */
+
+void sprint_func_op(char* line, Op* op) {
   char opcode[MAX_STR_LENGTH + 1];
   if (op->table_info->op_type == OP_CF) {
     sprintf(opcode, "%s", cf_type_names[op->table_info->cf_type]);
@@ -353,20 +375,18 @@ void print_func_op(Op* op) {
     sprintf(opcode, "%s", Op_Type_str(op->table_info->op_type));
   }
 
-  fprintf(GLOBAL_DEBUG_STREAM, "%2d  %08x  %10s", op->proc_id, (uns32)op->inst_info->addr, opcode);
+  line += sprintf(line, "%2d  %08x  %10s", op->proc_id, (uns32)op->inst_info->addr, opcode);
 
   char buf[MAX_STR_LENGTH + 1];
   print_reg_array(buf, op->inst_info->srcs, op->table_info->num_src_regs);
-  fprintf(GLOBAL_DEBUG_STREAM, "  in: %-30s", buf);
+  line += sprintf(line, "  in: %-30s", buf);
 
   print_reg_array(buf, op->inst_info->dests, op->table_info->num_dest_regs);
-  fprintf(GLOBAL_DEBUG_STREAM, "  out: %-30s", buf);
+  line += sprintf(line, "  out: %-30s", buf);
 
   if (op->oracle_info.mem_size) {
-    fprintf(GLOBAL_DEBUG_STREAM, "  %2d @ %08x", op->oracle_info.mem_size, (uns32)op->oracle_info.va);
+    line += sprintf(line, "  %2d @ %08x", op->oracle_info.mem_size, (uns32)op->oracle_info.va);
   }
-
-  fprintf(GLOBAL_DEBUG_STREAM, "\n");
 }
 
 static int compare_reg_ids(const void* p1, const void* p2) {
@@ -413,11 +433,11 @@ void print_short_op_array(FILE* stream, Op* ops[], uns array_length) {
 }
 
 /**************************************************************************************/
-/* disasm_op: */
-
-char* disasm_op(Op* op, Flag wide) {
-  static char buf[MAX_STR_LENGTH + 1];
+/* disasm_op_into: prints the disassembly of op into buf. With a mem_marker, the
+   marker stands in for the memory operand of a load or store (see
+   disasm_op_template). */
 
+static uns disasm_op_into(char* buf, Op* op, Flag wide, const char* mem_marker) {
   const char* opcode;
   if (op->table_info->op_type == OP_CF) {
     opcode = cf_type_names[op->table_info->cf_type];
@@ -434,17 +454,39 @@ char* disasm_op(Op* op, Flag wide) {
   if (wide) {
     i += sprintf(&buf[i], "(");
     i += print_reg_array(&buf[i], op->inst_info->srcs, op->table_info->num_src_regs);
-    if (op->table_info->mem_type == MEM_LD && op->oracle_info.mem_size > 0) {
+    if (op->table_info->mem_type == MEM_LD && mem_marker) {
+      i += sprintf(&buf[i], "%s", mem_marker);
+    } else if (op->table_info->mem_type == MEM_LD && op->oracle_info.mem_size > 0) {
       i += sprintf(&buf[i], " %d@%08x", op->oracle_info.mem_size, (int)op->oracle_info.va);
     }
     if (op->table_info->num_src_regs + op->table_info->num_dest_regs > 0)
       i += sprintf(&buf[i], " ->");
     i += print_reg_array(&buf[i], op->inst_info->dests, op->table_info->num_dest_regs);
-    if (op->table_info->mem_type == MEM_ST && op->oracle_info.mem_size > 0) {
+    if (op->table_info->mem_type == MEM_ST && mem_marker) {
+      i += sprintf(&buf[i], "%s", mem_marker);
+    } else if (op->table_info->mem_type == MEM_ST && op->oracle_info.mem_size > 0) {
       i += sprintf(&buf[i], " %d@%08x", op->oracle_info.mem_size, (int)op->oracle_info.va);
     }
     i += sprintf(&buf[i], " )");
   }
 
+  return i;
+}
+
+/**************************************************************************************/
+/* disasm_op: */
+
+char* disasm_op(Op* op, Flag wide) {
+  static char buf[MAX_STR_LENGTH + 1];
+  disasm_op_into(buf, op, wide, NULL);
   return buf;
 }
+
+/**************************************************************************************/
+/* disasm_op_template: the wide disassembly of op with mem_marker in place of the
+   memory operand, so that it only depends on the static instruction. Returns the
+   length of the string written to buf. */
+
+uns disasm_op_template(char* buf, Op* op, const char* mem_marker) {
+  return disasm_op_into(buf, op, TRUE, mem_marker);
+}
@@ -46,6 +46,8 @@ extern const char* const sm_state_names[];
 
 void print_op(Op*);
 void print_func_op(Op*);
+void print_retired_op(Op*);
+void sprint_func_op(char*, Op*);
 void print_short_op_array(FILE*, Op*[], uns);
 void print_op_array(FILE*, Op*[], uns, uns);
 void print_open_op_array(FILE*, Op*[], uns, uns);
@@ -54,6 +56,7 @@ void print_op_field(FILE*, Op*, uns);
 void print_field_tail(FILE*, uns);
 void print_field_head(FILE*, uns);
 char* disasm_op(Op*, Flag wide);
+uns disasm_op_template(char* buf, Op*, const char* mem_marker);
 char* disasm_reg(uns);
 
 /**************************************************************************************/
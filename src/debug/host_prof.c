@@ -0,0 +1,135 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : debug/host_prof.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Host-side profiling of the simulator's own phases.
+ *
+ *                Besides the stats, which are reset with every dump, each core
+ *                keeps running per-phase totals on its own cache lines for the
+ *                heartbeat percentages.
+ ***************************************************************************************/
+
+#include "debug/host_prof.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_vars.h"
+
+#include "general.param.h"
+
+#include "statistics.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define HOST_PROF_CALIB_NS 20000000ULL
+/* uns64 totals per core, rounded up to whole cache lines */
+#define HOST_PROF_STRIDE ((HOST_PROF_NUM_PHASES + 7) & ~7)
+
+/**************************************************************************************/
+/* Global Variables */
+
+#define HOST_PROF_PHASE_NAME(name) #name,
+static const char* const host_prof_names[HOST_PROF_NUM_PHASES] = {HOST_PROF_PHASE_LIST(HOST_PROF_PHASE_NAME)};
+#undef HOST_PROF_PHASE_NAME
+
+static double host_prof_ns_per_tick = 1.0;
+static uns64* host_prof_totals = NULL;
+static uns64 host_prof_last_totals[HOST_PROF_NUM_PHASES];
+static uns64 host_prof_last_ticks = 0;
+
+/**************************************************************************************/
+/* host_prof_clock_ns: */
+
+uns64 host_prof_clock_ns(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uns64)now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**************************************************************************************/
+/* host_prof_init: */
+
+void host_prof_init(void) {
+  if (!HOST_PROF)
+    return;
+
+  for (uns ii = 0; ii < HOST_PROF_NUM_PHASES; ii++) {
+    char name[MAX_STR_LENGTH + 1];
+    snprintf(name, sizeof(name), "HOST_PROF_%s_NS", host_prof_names[ii]);
+    ASSERTM(0, !strcmp(global_stat_array[0][HOST_PROF_DCACHE_NS + 2 * ii].name, name),
+            "host_prof.stat.def does not match HOST_PROF_PHASE_LIST at %s\n", name);
+  }
+
+#if defined(__x86_64__)
+  /* spin long enough for the clock resolution not to matter */
+  uns64 start_ns = host_prof_clock_ns();
+  uns64 start_ticks = host_prof_ticks();
+  uns64 now_ns;
+  do {
+    now_ns = host_prof_clock_ns();
+  } while (now_ns - start_ns < HOST_PROF_CALIB_NS);
+  host_prof_ns_per_tick = (double)(now_ns - start_ns) / (host_prof_ticks() - start_ticks);
+#endif
+
+  host_prof_totals = (uns64*)calloc((size_t)NUM_CORES * HOST_PROF_STRIDE, sizeof(uns64));
+  host_prof_last_ticks = host_prof_ticks();
+}
+
+/**************************************************************************************/
+/* host_prof_add: */
+
+void host_prof_add(uns proc_id, Host_Prof_Phase phase, uns64 start) {
+  uns64 ns = (uns64)((host_prof_ticks() - start) * host_prof_ns_per_tick);
+  host_prof_totals[proc_id * HOST_PROF_STRIDE + phase] += ns;
+  INC_STAT_EVENT(proc_id, HOST_PROF_DCACHE_NS + 2 * phase, ns);
+  STAT_EVENT(proc_id, HOST_PROF_DCACHE_CALLS + 2 * phase);
+}
+
+/**************************************************************************************/
+/* host_prof_heartbeat: the per-core phases are summed over the cores, so with
+   NUM_CORE_THREADS their shares can add up to more than 100% */
+
+void host_prof_heartbeat(FILE* stream) {
+  if (!HOST_PROF)
+    return;
+
+  uns64 now = host_prof_ticks();
+  double wall_ns = (now - host_prof_last_ticks) * host_prof_ns_per_tick;
+  fprintf(stream, "** Host profile:");
+  for (uns ii = 0; ii < HOST_PROF_NUM_PHASES; ii++) {
+    uns64 total = 0;
+    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+      total += host_prof_totals[proc_id * HOST_PROF_STRIDE + ii];
+    fprintf(stream, " %s %.1f%%", host_prof_names[ii],
+            wall_ns > 0 ? 100.0 * (total - host_prof_last_totals[ii]) / wall_ns : 0.0);
+    host_prof_last_totals[ii] = total;
+  }
+  fprintf(stream, "\n");
+  host_prof_last_ticks = now;
+}
@@ -0,0 +1,119 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : debug/host_prof.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Host-side profiling of the simulator's own phases (HOST_PROF).
+ *                Each HOST_PROF_SCOPE adds the host time and call count of the
+ *                wrapped statement to the HOST_PROF_<PHASE>_NS/_CALLS stats of
+ *                debug/host_prof.stat.def. Phases nest: MEMORY includes
+ *                RAMULATOR, ICACHE includes FRONTEND_FETCH, and BTB (every
+ *                BTB lookup of bp_predict_op) is inside the frontend phase
+ *                that predicts.
+ ***************************************************************************************/
+
+#ifndef __HOST_PROF_H__
+#define __HOST_PROF_H__
+
+#include <stdio.h>
+
+#include "globals/global_types.h"
+
+#include "debug/debug.param.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************/
+/* Types */
+
+/* Must match the order of the stat pairs in host_prof.stat.def */
+#define HOST_PROF_PHASE_LIST(X) \
+  X(DCACHE)                     \
+  X(EXEC)                       \
+  X(NODE)                       \
+  X(MAP)                        \
+  X(IDQ)                        \
+  X(UOP_QUEUE)                  \
+  X(DECODE)                     \
+  X(ICACHE)                     \
+  X(DECOUPLED_FE)               \
+  X(FRONTEND_FETCH)             \
+  X(BTB)                        \
+  X(MEMORY)                     \
+  X(RAMULATOR)                  \
+  X(MEMORY_CORE)                \
+  X(DUMP_STATS)
+
+#define HOST_PROF_PHASE_ENUM(name) HOST_PROF_##name,
+typedef enum Host_Prof_Phase_enum { HOST_PROF_PHASE_LIST(HOST_PROF_PHASE_ENUM) HOST_PROF_NUM_PHASES } Host_Prof_Phase;
+#undef HOST_PROF_PHASE_ENUM
+
+/**************************************************************************************/
+/* Macros */
+
+/* Times stmt as phase of proc_id. With HOST_PROF off the cost is one branch. */
+#define HOST_PROF_SCOPE(proc_id, phase, stmt)          \
+  do {                                                 \
+    if (HOST_PROF) {                                   \
+      uns64 host_prof_start_ = host_prof_ticks();      \
+      stmt;                                            \
+      host_prof_add(proc_id, phase, host_prof_start_); \
+    } else {                                           \
+      stmt;                                            \
+    }                                                  \
+  } while (0)
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Calibrates the tick rate and checks the phase list against the stats */
+void host_prof_init(void);
+
+uns64 host_prof_clock_ns(void);
+
+/* Host timestamp in ticks: the TSC on x86_64, CLOCK_MONOTONIC ns elsewhere */
+static inline uns64 host_prof_ticks(void) {
+#if defined(__x86_64__)
+  uns32 lo, hi;
+  __asm__ __volatile__("rdtsc" : "=a"(lo), "=d"(hi));
+  return ((uns64)hi << 32) | lo;
+#else
+  return host_prof_clock_ns();
+#endif
+}
+
+/* Charges the ticks since start to phase */
+void host_prof_add(uns proc_id, Host_Prof_Phase phase, uns64 start);
+
+/* Prints the share of host time each phase took since the last call */
+void host_prof_heartbeat(FILE* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**************************************************************************************/
+
+#endif /* #ifndef __HOST_PROF_H__ */
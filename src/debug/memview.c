@@ -38,6 +38,8 @@
 
 #include "memory/memory.h"
 
+#include "debug/trace_event.h"
+
 #include "exec_ports.h"
 #include "freq.h"
 #include "trigger.h"
@@ -52,6 +54,43 @@ DEFINE_ENUM(Memview_Note_Type, MEMVIEW_NOTE_TYPE_LIST);
 /**************************************************************************************/
 /* Types */
 
+/* Lines are recorded as TRACE_EVENT_MEMVIEW events and formatted by the trace
+   event I/O thread */
+typedef enum Memview_Rec_Type_enum {
+  MEMVIEW_REC_TEXT,  // preformatted line
+  MEMVIEW_REC_DRAM,
+  MEMVIEW_REC_MEMQUEUE,
+  MEMVIEW_REC_CORE_STATE,
+  MEMVIEW_REC_FUS_BUSY,
+  MEMVIEW_REC_L1,
+} Memview_Rec_Type;
+
+typedef struct Memview_Dram_Rec_struct {
+  Counter start;
+  Counter end;
+  long long unique_num;
+  int proc_id;
+  int req_id;
+  Memview_Dram_Event event;
+  uns flat_bank_id;
+  uns pos;
+} Memview_Dram_Rec;
+
+typedef struct Memview_Span_Rec_struct {
+  Counter begin;
+  Counter end;
+  const char* state;  // MEMVIEW_REC_CORE_STATE, a string literal
+  uns proc_id;
+  uns value;  // MEMVIEW_REC_FUS_BUSY
+} Memview_Span_Rec;
+
+typedef struct Memview_Memqueue_Rec_struct {
+  Counter begin;
+  Counter end;
+  uns proc_id;
+  uns num_reqs_by_type[MRT_NUM_ELEMS];
+} Memview_Memqueue_Rec;
+
 typedef struct Bank_Info_struct {
   uns pos;
 } Bank_Info;
@@ -82,6 +121,8 @@ Mem_Req_Type* req_types;
 static void trace_memqueue_state(uns proc_id, Counter begin, Counter end, uns* num_reqs_by_type);
 static void trace_core_state(uns proc_id, Counter begin, Counter end, const char* state);
 static void trace_fus_busy(uns proc_id, Counter begin, Counter end, uns fus_busy);
+static void write_span(Memview_Rec_Type type, uns proc_id, Counter begin, Counter end, const char* state, uns value);
+static void memview_handler(uns type, const void* payload, uns size);
 
 /**************************************************************************************/
 /* memview_init */
@@ -124,6 +165,8 @@ void memview_init(void) {
 #undef MEMVIEW_PARAM_PRINT
 
   fprintf(trace, "\n");  // empty line indicates end of param section
+
+  trace_event_enable(TRACE_EVENT_MEMVIEW, memview_handler);
 }
 
 /**************************************************************************************/
@@ -136,8 +179,16 @@ void memview_dram(Memview_Dram_Event event, Mem_Req* req, uns flat_bank_id, Coun
     return;
 
   Bank_Info* bank_info = &bank_infos[flat_bank_id];
-  fprintf(trace, "%8s %10s %20lld %20lld %2d %10lld %3d %2d %2d\n", "DRAM", Memview_Dram_Event_str(event), start, end,
-          req ? req->proc_id : -1, req ? req->unique_num : -1, req ? req->id : -1, flat_bank_id, bank_info->pos);
+  Memview_Dram_Rec rec;
+  rec.start = start;
+  rec.end = end;
+  rec.unique_num = req ? (long long)req->unique_num : -1;
+  rec.proc_id = req ? (int)req->proc_id : -1;
+  rec.req_id = req ? req->id : -1;
+  rec.event = event;
+  rec.flat_bank_id = flat_bank_id;
+  rec.pos = bank_info->pos;
+  trace_event_write(TRACE_EVENT_MEMVIEW, MEMVIEW_REC_DRAM, &rec, sizeof(rec));
   if (event == MEMVIEW_DRAM_COLUMN) {
     bank_info->pos = (bank_info->pos + 1) % 3;
   }
@@ -150,16 +201,17 @@ void memview_dram_crit_path(const char* from_type_str, uns from_index, const cha
   if (!trigger_on(start_trigger))
     return;
 
-  fprintf(trace, "%8s %10s %20lld %20lld  %s[%d]->%s[%d]\n", "DRAM", "CRIT_PATH", start, end, from_type_str, from_index,
-          to_type_str, to_index);
+  trace_event_printf(TRACE_EVENT_MEMVIEW, "%8s %10s %20lld %20lld  %s[%d]->%s[%d]\n", "DRAM", "CRIT_PATH", start, end,
+                     from_type_str, from_index, to_type_str, to_index);
 }
 
 void trace_memqueue_state(uns proc_id, Counter begin, Counter end, uns* num_reqs_by_type) {
-  fprintf(trace, "%8s %10s %20lld %20lld %2d", "MEMQUEUE", "DURATION", begin, end, proc_id);
-  for (Mem_Req_Type type = 0; type < MRT_NUM_ELEMS; type++) {
-    fprintf(trace, " %2d", num_reqs_by_type[type]);
-  }
-  fprintf(trace, "\n");
+  Memview_Memqueue_Rec rec;
+  rec.begin = begin;
+  rec.end = end;
+  rec.proc_id = proc_id;
+  memcpy(rec.num_reqs_by_type, num_reqs_by_type, sizeof(rec.num_reqs_by_type));
+  trace_event_write(TRACE_EVENT_MEMVIEW, MEMVIEW_REC_MEMQUEUE, &rec, sizeof(rec));
 }
 
 /**************************************************************************************/
@@ -221,8 +273,8 @@ void memview_l1(Mem_Req* req) {
     return;
 
   ASSERT(0, req);
-  fprintf(trace, "%8s %10s %20lld %20lld %2d\n", "LLC", "ACCESS", freq_time(),
-          (freq_time() + freq_get_cycle_time(FREQ_DOMAIN_L1) * L1_CYCLES), req->proc_id);
+  write_span(MEMVIEW_REC_L1, req->proc_id, freq_time(), freq_time() + freq_get_cycle_time(FREQ_DOMAIN_L1) * L1_CYCLES,
+             NULL, 0);
 }
 
 /**************************************************************************************/
@@ -256,7 +308,7 @@ void memview_core_stall(uns proc_id, Flag stalled, Flag mem_blocked) {
 /* trace_core_state */
 
 void trace_core_state(uns proc_id, Counter begin, Counter end, const char* state) {
-  fprintf(trace, "%8s %10s %20lld %20lld %2d\n", "CORE", state, begin, end, proc_id);
+  write_span(MEMVIEW_REC_CORE_STATE, proc_id, begin, end, state, 0);
 }
 
 /**************************************************************************************/
@@ -281,7 +333,7 @@ void memview_fus_busy(uns proc_id, uns fus_busy) {
 /* trace_fus_busy */
 
 void trace_fus_busy(uns proc_id, Counter begin, Counter end, uns fus_busy) {
-  fprintf(trace, "%8s %10s %20lld %20lld %2d %2d\n", "CORE", "FUS_BUSY", begin, end, proc_id, fus_busy);
+  write_span(MEMVIEW_REC_FUS_BUSY, proc_id, begin, end, NULL, fus_busy);
 }
 
 /**************************************************************************************/
@@ -301,6 +353,7 @@ void memview_done(void) {
       trace_memqueue_state(proc_id, proc_info->last_memqueue_change_time, freq_time(), proc_info->num_reqs_by_type);
     }
   }
+  trace_event_flush();
   fclose(trace);
 }
 
@@ -311,8 +364,65 @@ void memview_note(Memview_Note_Type type, const char* str) {
   if (!MEMVIEW)
     return;
   if (trigger_on(start_trigger)) {
-    fprintf(trace, "%8s %10d %20lld %20lld %2d %s\n", "NOTE", type, freq_time(), 0ULL, 0, str);
+    trace_event_printf(TRACE_EVENT_MEMVIEW, "%8s %10d %20lld %20lld %2d %s\n", "NOTE", type, freq_time(), 0ULL, 0, str);
   }
 }
 
 /*************************************************************/
+
+/**************************************************************************************/
+/* write_span */
+
+void write_span(Memview_Rec_Type type, uns proc_id, Counter begin, Counter end, const char* state, uns value) {
+  Memview_Span_Rec rec;
+  rec.begin = begin;
+  rec.end = end;
+  rec.state = state;
+  rec.proc_id = proc_id;
+  rec.value = value;
+  trace_event_write(TRACE_EVENT_MEMVIEW, type, &rec, sizeof(rec));
+}
+
+/**************************************************************************************/
+/* memview_handler: formats a memview record on the trace event I/O thread */
+
+void memview_handler(uns type, const void* payload, uns size) {
+  switch (type) {
+    case MEMVIEW_REC_TEXT:
+      fwrite(payload, 1, size, trace);
+      break;
+    case MEMVIEW_REC_DRAM: {
+      const Memview_Dram_Rec* rec = (const Memview_Dram_Rec*)payload;
+      fprintf(trace, "%8s %10s %20lld %20lld %2d %10lld %3d %2d %2d\n", "DRAM", Memview_Dram_Event_str(rec->event),
+              rec->start, rec->end, rec->proc_id, rec->unique_num, rec->req_id, rec->flat_bank_id, rec->pos);
+      break;
+    }
+    case MEMVIEW_REC_MEMQUEUE: {
+      const Memview_Memqueue_Rec* rec = (const Memview_Memqueue_Rec*)payload;
+      fprintf(trace, "%8s %10s %20lld %20lld %2d", "MEMQUEUE", "DURATION", rec->begin, rec->end, rec->proc_id);
+      for (Mem_Req_Type mrt = 0; mrt < MRT_NUM_ELEMS; mrt++) {
+        fprintf(trace, " %2d", rec->num_reqs_by_type[mrt]);
+      }
+      fprintf(trace, "\n");
+      break;
+    }
+    case MEMVIEW_REC_CORE_STATE: {
+      const Memview_Span_Rec* rec = (const Memview_Span_Rec*)payload;
+      fprintf(trace, "%8s %10s %20lld %20lld %2d\n", "CORE", rec->state, rec->begin, rec->end, rec->proc_id);
+      break;
+    }
+    case MEMVIEW_REC_FUS_BUSY: {
+      const Memview_Span_Rec* rec = (const Memview_Span_Rec*)payload;
+      fprintf(trace, "%8s %10s %20lld %20lld %2d %2d\n", "CORE", "FUS_BUSY", rec->begin, rec->end, rec->proc_id,
+              rec->value);
+      break;
+    }
+    case MEMVIEW_REC_L1: {
+      const Memview_Span_Rec* rec = (const Memview_Span_Rec*)payload;
+      fprintf(trace, "%8s %10s %20lld %20lld %2d\n", "LLC", "ACCESS", rec->begin, rec->end, rec->proc_id);
+      break;
+    }
+    default:
+      ASSERTM(0, FALSE, "Unknown memview record type %u\n", type);
+  }
+}
@@ -32,6 +32,8 @@
 #include "globals/global_defs.h"
 
 #include "debug/debug_print.h"
+#include "libs/async_writer.h"
+#include "libs/hash_lib.h"
 
 #include "core.param.h"
 #include "general.param.h"
@@ -46,36 +48,115 @@ O3PipeView:<event>:<timestamp>
 <event> can be map, issue, sched, etc.
 All events for a uop must be on consecutive lines
 
+With PIPEVIEW_BIN, each core instead writes <PIPEVIEW_FILE>.<proc_id>.bin (.bin.gz
+with PIPEVIEW_BIN_COMPRESS) in host byte order: "SCRBPIPE", uns32 version, uns32
+proc_id, then records that each start with an uns8 kind:
+  PIPEVIEW_BIN_DISASM: uns32 id, uns16 len, len characters. Defines the
+    disassembly of a static op, with PIPEVIEW_BIN_MEM_MARKER in place of the
+    memory operand.
+  PIPEVIEW_BIN_OP: a Pipeview_Bin_Op.
+bin/pipeview_convert.py turns the stream into the text format above, Konata or
+gem5 O3PipeView.
+
 ***************************************************************************************/
 
+#define PIPEVIEW_BIN_MAGIC "SCRBPIPE"
+#define PIPEVIEW_BIN_VERSION 1
+#define PIPEVIEW_BIN_DISASM 0
+#define PIPEVIEW_BIN_OP 1
+#define PIPEVIEW_BIN_OFF_PATH 0x1
+#define PIPEVIEW_BIN_NO_EVENT 0xffffffff
+#define PIPEVIEW_BIN_MEM_MARKER "\x01"
+
+/* Events in the order they are printed. Off-path ops print fetch as
+   fetch_offpath and retire as flush. */
+typedef enum Pipeview_Event_enum {
+  PIPEVIEW_FETCH,
+  PIPEVIEW_DECODE,
+  PIPEVIEW_DECODE_DONE,
+  PIPEVIEW_MAP,
+  PIPEVIEW_MAP_DONE,
+  PIPEVIEW_ISSUE,
+  PIPEVIEW_ISSUE_DONE,
+  PIPEVIEW_READY,
+  PIPEVIEW_SCHED,
+  PIPEVIEW_EXEC,
+  PIPEVIEW_DCACHE,
+  PIPEVIEW_DONE,
+  PIPEVIEW_RETIRE,
+  PIPEVIEW_END,
+  PIPEVIEW_NUM_EVENTS
+} Pipeview_Event;
+
+typedef struct Pipeview_Bin_Op_struct {
+  uns64 op_num;  // unique_num_per_proc
+  uns64 addr;
+  uns64 fetch_cycle;
+  uns32 disasm_id;
+  uns32 mem_size;
+  uns32 mem_va;  // low 32 bits, as printed
+  uns8 flags;
+  uns32 cycles[PIPEVIEW_NUM_EVENTS];  // cycle - fetch_cycle, PIPEVIEW_BIN_NO_EVENT if not printed
+} __attribute__((packed)) Pipeview_Bin_Op;
+
+typedef struct Pipeview_Disasm_struct {
+  uns32 id;
+  Addr addr;  // the inst_info may be reused for another instruction
+  Table_Info* table_info;
+} Pipeview_Disasm;
+
 /**************************************************************************************/
 /* Global variables: */
 
 static FILE** files = NULL;
+static Async_Writer** bin_writers = NULL;
+static Hash_Table* disasm_tables = NULL;
+static uns32* num_disasms = NULL;
 
 /**************************************************************************************/
 /* Constants: */
 
 static const char* PREFIX = "O3PipeView";
 
+static const char* const event_names[PIPEVIEW_NUM_EVENTS] = {
+    "fetch", "decode", "decode_done", "map",  "map_done", "issue",  "issue_done",
+    "ready", "sched",  "exec",        "dcache", "done",   "retire", "end",
+};
+
 /**************************************************************************************/
 /* Local prototypes: */
 
 void print_header(FILE*, Op*);
-void print_event(FILE*, Op*, const char*, Counter);
+void get_event_cycles(Op*, Counter*);
+uns32 get_disasm_id(Op*);
 
 /**************************************************************************************/
 /* pipeview_init: */
 
 void pipeview_init(void) {
   files = malloc(sizeof(FILE*) * NUM_CORES);
+  bin_writers = malloc(sizeof(Async_Writer*) * NUM_CORES);
   if (PIPEVIEW) {
     for (uns proc_id = 0; proc_id < NUM_CORES; ++proc_id) {
       char filename[MAX_STR_LENGTH + 1];
+      if (PIPEVIEW_BIN) {
+        sprintf(filename, "%s.%d.bin%s", PIPEVIEW_FILE, proc_id, PIPEVIEW_BIN_COMPRESS ? ".gz" : "");
+        bin_writers[proc_id] = async_writer_open(filename, PIPEVIEW_BUF_SIZE, PIPEVIEW_BIN_COMPRESS);
+        uns32 head[2] = {PIPEVIEW_BIN_VERSION, proc_id};
+        async_writer_write(bin_writers[proc_id], PIPEVIEW_BIN_MAGIC, strlen(PIPEVIEW_BIN_MAGIC));
+        async_writer_write(bin_writers[proc_id], head, sizeof(head));
+        continue;
+      }
       sprintf(filename, "%s.%d.trace", PIPEVIEW_FILE, proc_id);
       files[proc_id] = fopen(filename, "w");
       ASSERT(proc_id, files[proc_id]);
     }
+    if (PIPEVIEW_BIN) {
+      disasm_tables = malloc(sizeof(Hash_Table) * NUM_CORES);
+      num_disasms = calloc(NUM_CORES, sizeof(uns32));
+      for (uns proc_id = 0; proc_id < NUM_CORES; ++proc_id)
+        init_hash_table(&disasm_tables[proc_id], "pipeview disasm", 4096, sizeof(Pipeview_Disasm));
+    }
   }
 }
 
@@ -86,36 +167,47 @@ void pipeview_print_op(struct Op_struct* op) {
   if (!DEBUG_RANGE_COND(op->proc_id))
     return;
 
+  Counter cycles[PIPEVIEW_NUM_EVENTS];
+  get_event_cycles(op, cycles);
+
+  if (PIPEVIEW_BIN) {
+    Pipeview_Bin_Op rec;
+    rec.op_num = op->unique_num_per_proc;
+    rec.addr = op->inst_info->addr;
+    rec.fetch_cycle = op->fetch_cycle;
+    rec.disasm_id = get_disasm_id(op);
+    rec.mem_size = op->oracle_info.mem_size;
+    rec.mem_va = op->oracle_info.va;
+    rec.flags = op->off_path ? PIPEVIEW_BIN_OFF_PATH : 0;
+    for (uns ii = 0; ii < PIPEVIEW_NUM_EVENTS; ii++) {
+      Counter cycle = cycles[ii];
+      /* print only events that make sense because flushed ops may not
+         have all *_cycle fields set and non mem ops will not have
+         dcache_cycle set  */
+      Flag valid = cycle >= op->fetch_cycle && cycle <= cycle_count && cycle - op->fetch_cycle < PIPEVIEW_BIN_NO_EVENT;
+      rec.cycles[ii] = valid ? cycle - op->fetch_cycle : PIPEVIEW_BIN_NO_EVENT;
+    }
+    uns8 kind = PIPEVIEW_BIN_OP;
+    async_writer_write(bin_writers[op->proc_id], &kind, sizeof(kind));
+    async_writer_write(bin_writers[op->proc_id], &rec, sizeof(rec));
+    return;
+  }
+
   FILE* file = files[op->proc_id];
   print_header(file, op);
-  if (op->off_path) {
-    print_event(file, op, "fetch_offpath", op->fetch_cycle);
-  } else {
-    print_event(file, op, "fetch", op->fetch_cycle);
-  }
-  print_event(file, op, "decode", op->fetch_cycle + 1);
-  print_event(file, op, "decode_done", op->fetch_cycle + 1 + DECODE_CYCLES);
-  print_event(file, op, "map", op->map_cycle);
-  print_event(file, op, "map_done", op->map_cycle + MAP_CYCLES);
-  print_event(file, op, "issue", op->issue_cycle);
-  print_event(file, op, "issue_done", op->issue_cycle + 1);
-  if (op->srcs_not_rdy_vector == 0) {
-    // op was ready at rdy_cycle only if all sources are ready
-    print_event(file, op, "ready", MAX2(op->rdy_cycle, op->issue_cycle + 1));
-  } else {
-    ASSERT(op->proc_id, op->off_path);
-  }
-  print_event(file, op, "sched", op->sched_cycle);
-  print_event(file, op, "exec", op->exec_cycle);
-  print_event(file, op, "dcache", op->dcache_cycle);
-  print_event(file, op, "done", op->done_cycle);
-  if (op->off_path) {
-    print_event(file, op, "flush", cycle_count);
-    print_event(file, op, "end", cycle_count);
-  } else {
-    ASSERT(op->proc_id, op->retire_cycle <= cycle_count);
-    print_event(file, op, "retire", op->retire_cycle);
-    print_event(file, op, "end", op->retire_cycle);
+  for (uns ii = 0; ii < PIPEVIEW_NUM_EVENTS; ii++) {
+    Counter cycle = cycles[ii];
+    /* print only events that make sense because flushed ops may not
+       have all *_cycle fields set and non mem ops will not have
+       dcache_cycle set  */
+    if (cycle < op->fetch_cycle || cycle > cycle_count)
+      continue;
+    const char* name = event_names[ii];
+    if (op->off_path && ii == PIPEVIEW_FETCH)
+      name = "fetch_offpath";
+    else if (op->off_path && ii == PIPEVIEW_RETIRE)
+      name = "flush";
+    fprintf(file, "%s:%s:%lld\n", PREFIX, name, cycle);
   }
 }
 
@@ -125,21 +217,70 @@ void pipeview_print_op(struct Op_struct* op) {
 void pipeview_done(void) {
   if (PIPEVIEW) {
     for (uns proc_id = 0; proc_id < NUM_CORES; ++proc_id) {
-      fclose(files[proc_id]);
+      if (PIPEVIEW_BIN)
+        async_writer_close(bin_writers[proc_id]);
+      else
+        fclose(files[proc_id]);
     }
   }
 }
 
 /**************************************************************************************/
-/* print_event: */
+/* get_event_cycles: the cycle of each Pipeview_Event of op, MAX_CTR for events
+   that did not happen */
 
-void print_event(FILE* file, Op* op, const char* name, Counter cycle) {
-  /* print only events that make sense because flushed ops may not
-     have all *_cycle fields set and non mem ops will not have
-     dcache_cycle set  */
-  if (cycle >= op->fetch_cycle && cycle <= cycle_count) {
-    fprintf(file, "%s:%s:%lld\n", PREFIX, name, cycle);
+void get_event_cycles(Op* op, Counter* cycles) {
+  cycles[PIPEVIEW_FETCH] = op->fetch_cycle;
+  cycles[PIPEVIEW_DECODE] = op->fetch_cycle + 1;
+  cycles[PIPEVIEW_DECODE_DONE] = op->fetch_cycle + 1 + DECODE_CYCLES;
+  cycles[PIPEVIEW_MAP] = op->map_cycle;
+  cycles[PIPEVIEW_MAP_DONE] = op->map_cycle + MAP_CYCLES;
+  cycles[PIPEVIEW_ISSUE] = op->issue_cycle;
+  cycles[PIPEVIEW_ISSUE_DONE] = op->issue_cycle + 1;
+  if (op->srcs_not_rdy_vector == 0) {
+    // op was ready at rdy_cycle only if all sources are ready
+    cycles[PIPEVIEW_READY] = MAX2(op->rdy_cycle, op->issue_cycle + 1);
+  } else {
+    ASSERT(op->proc_id, op->off_path);
+    cycles[PIPEVIEW_READY] = MAX_CTR;
   }
+  cycles[PIPEVIEW_SCHED] = op->sched_cycle;
+  cycles[PIPEVIEW_EXEC] = op->exec_cycle;
+  cycles[PIPEVIEW_DCACHE] = op->dcache_cycle;
+  cycles[PIPEVIEW_DONE] = op->done_cycle;
+  if (op->off_path) {
+    cycles[PIPEVIEW_RETIRE] = cycle_count;
+    cycles[PIPEVIEW_END] = cycle_count;
+  } else {
+    ASSERT(op->proc_id, op->retire_cycle <= cycle_count);
+    cycles[PIPEVIEW_RETIRE] = op->retire_cycle;
+    cycles[PIPEVIEW_END] = op->retire_cycle;
+  }
+}
+
+/**************************************************************************************/
+/* get_disasm_id: id of the disassembly of op's static instruction, writing its
+   definition the first time it is seen */
+
+uns32 get_disasm_id(Op* op) {
+  Flag new_entry;
+  Pipeview_Disasm* disasm = hash_table_access_create(&disasm_tables[op->proc_id], (int64)op->inst_info, &new_entry);
+  if (!new_entry && disasm->addr == op->inst_info->addr && disasm->table_info == op->table_info)
+    return disasm->id;
+
+  char buf[MAX_STR_LENGTH + 1];
+  uns16 len = disasm_op_template(buf, op, PIPEVIEW_BIN_MEM_MARKER);
+  disasm->id = num_disasms[op->proc_id]++;
+  disasm->addr = op->inst_info->addr;
+  disasm->table_info = op->table_info;
+
+  Async_Writer* writer = bin_writers[op->proc_id];
+  uns8 kind = PIPEVIEW_BIN_DISASM;
+  async_writer_write(writer, &kind, sizeof(kind));
+  async_writer_write(writer, &disasm->id, sizeof(disasm->id));
+  async_writer_write(writer, &len, sizeof(len));
+  async_writer_write(writer, buf, len);
+  return disasm->id;
 }
 
 /**************************************************************************************/
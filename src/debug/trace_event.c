@@ -0,0 +1,292 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : debug/trace_event.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Typed trace events handed to a background I/O thread.
+ *
+ *                Each ring has a single producer (its simulation thread) and a
+ *                single consumer (the I/O thread), so head and tail only need
+ *                acquire/release ordering. Events are an 8-byte
+ *                Trace_Event_Header followed by the payload, padded to 8 bytes.
+ *                An event never wraps around the end of the ring: a pad event
+ *                fills the rest of the ring instead.
+ ***************************************************************************************/
+
+#include "debug/trace_event.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_vars.h"
+
+#include "debug/debug.param.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define TRACE_EVENT_MAX_RINGS 256
+#define TRACE_EVENT_PAD TRACE_EVENT_NUM_CATEGORIES
+#define TRACE_EVENT_IDLE_USEC 100
+#define TRACE_EVENT_ALIGN(size) (((size) + 7) & ~(uns64)7)
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Trace_Event_Header_struct {
+  uns32 size;  // payload bytes
+  uns16 category;
+  uns16 type;
+} Trace_Event_Header;
+
+typedef struct Trace_Event_Ring_struct {
+  char* data;
+  uns64 size;  // a power of two
+  uns64 head;  // bytes ever written, advanced by the producer
+  uns64 tail;  // bytes ever handled, advanced by the I/O thread
+} Trace_Event_Ring;
+
+/**************************************************************************************/
+/* Global Variables */
+
+uns trace_event_mask = 0;
+
+static Trace_Event_Handler handlers[TRACE_EVENT_NUM_CATEGORIES];
+static Trace_Event_Ring* rings[TRACE_EVENT_MAX_RINGS];
+static uns num_rings = 0;
+static __thread Trace_Event_Ring* thread_ring = NULL;
+static pthread_mutex_t rings_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t io_thread;
+static Flag io_thread_running = FALSE;
+static Flag io_done = FALSE;
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static Trace_Event_Ring* get_thread_ring(void);
+static Flag drain_ring(Trace_Event_Ring* ring);
+static void* io_main(void* arg);
+static void flush_at_exit(void);
+static void debug_handler(uns type, const void* payload, uns size);
+
+/**************************************************************************************/
+/* trace_event_init: */
+
+void trace_event_init(void) {
+  if (DEBUG_ASYNC)
+    trace_event_enable(TRACE_EVENT_DEBUG, debug_handler);
+}
+
+/**************************************************************************************/
+/* trace_event_enable: */
+
+void trace_event_enable(Trace_Event_Category category, Trace_Event_Handler handler) {
+  ASSERT(0, category < TRACE_EVENT_NUM_CATEGORIES);
+  pthread_mutex_lock(&rings_mutex);
+  if (!io_thread_running) {
+    ASSERTM(0, TRACE_EVENT_RING_SIZE >= 4096 && !(TRACE_EVENT_RING_SIZE & (TRACE_EVENT_RING_SIZE - 1)),
+            "TRACE_EVENT_RING_SIZE must be a power of two of at least 4096\n");
+    io_done = FALSE;
+    int err = pthread_create(&io_thread, NULL, io_main, NULL);
+    ASSERTM(0, !err, "Could not create the trace event I/O thread (%d)\n", err);
+    io_thread_running = TRUE;
+    static Flag registered_exit = FALSE;
+    if (!registered_exit)
+      atexit(flush_at_exit);
+    registered_exit = TRUE;
+  }
+  handlers[category] = handler;
+  __atomic_or_fetch(&trace_event_mask, 1U << category, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&rings_mutex);
+}
+
+/**************************************************************************************/
+/* trace_event_write: */
+
+void trace_event_write(Trace_Event_Category category, uns type, const void* payload, uns size) {
+  Trace_Event_Ring* ring = get_thread_ring();
+  uns64 need = TRACE_EVENT_ALIGN(sizeof(Trace_Event_Header) + size);
+  ASSERTM(0, need <= ring->size / 2, "Trace event of %u bytes does not fit TRACE_EVENT_RING_SIZE\n", size);
+
+  uns64 head = ring->head;
+  uns64 contig = ring->size - (head & (ring->size - 1));
+  uns64 total = need > contig ? contig + need : need;
+  while (head + total - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) > ring->size)
+    sched_yield();  // the I/O thread is a whole ring behind
+
+  if (need > contig) {
+    Trace_Event_Header* pad = (Trace_Event_Header*)(ring->data + (head & (ring->size - 1)));
+    pad->size = contig - sizeof(Trace_Event_Header);
+    pad->category = TRACE_EVENT_PAD;
+    pad->type = 0;
+    head += contig;
+  }
+  Trace_Event_Header* header = (Trace_Event_Header*)(ring->data + (head & (ring->size - 1)));
+  header->size = size;
+  header->category = category;
+  header->type = type;
+  memcpy(header + 1, payload, size);
+  __atomic_store_n(&ring->head, head + need, __ATOMIC_RELEASE);
+}
+
+/**************************************************************************************/
+/* trace_event_printf: */
+
+void trace_event_printf(Trace_Event_Category category, const char* fmt, ...) {
+  char buf[MAX_STR_LENGTH + 1];
+  va_list args;
+  va_start(args, fmt);
+  int len = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+  if (len > MAX_STR_LENGTH)
+    len = MAX_STR_LENGTH;
+  if (len > 0)
+    trace_event_write(category, 0, buf, len);
+}
+
+/**************************************************************************************/
+/* trace_event_debug: the DEBUG macro line, prefix included, as one event */
+
+void trace_event_debug(const char* file, uns line, const char* flag, uns proc_id, const char* fmt, ...) {
+  char buf[2 * MAX_STR_LENGTH + 1];
+  int len = snprintf(buf, MAX_STR_LENGTH, "%s:%u: %s (P=%u O=%llu  I=%llu  C=%llu):  ", file, line, flag, proc_id,
+                     op_count[proc_id], inst_count[proc_id], cycle_count);
+  if (len > MAX_STR_LENGTH - 1)
+    len = MAX_STR_LENGTH - 1;
+  va_list args;
+  va_start(args, fmt);
+  int body = vsnprintf(buf + len, sizeof(buf) - len, fmt, args);
+  va_end(args);
+  if (body > 0)
+    len += MIN2(body, (int)(sizeof(buf) - len - 1));
+  trace_event_write(TRACE_EVENT_DEBUG, 0, buf, len);
+}
+
+/**************************************************************************************/
+/* trace_event_flush: */
+
+void trace_event_flush(void) {
+  if (!io_thread_running || pthread_equal(pthread_self(), io_thread))
+    return;
+  uns count = __atomic_load_n(&num_rings, __ATOMIC_ACQUIRE);
+  for (uns ii = 0; ii < count; ii++) {
+    Trace_Event_Ring* ring = rings[ii];
+    while (__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) != __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE))
+      sched_yield();
+  }
+}
+
+/**************************************************************************************/
+/* trace_event_done: */
+
+void trace_event_done(void) {
+  if (!io_thread_running)
+    return;
+  trace_event_flush();
+  __atomic_store_n(&trace_event_mask, 0, __ATOMIC_RELEASE);
+  __atomic_store_n(&io_done, TRUE, __ATOMIC_RELEASE);
+  pthread_join(io_thread, NULL);
+  io_thread_running = FALSE;
+  fflush(mystdout);
+}
+
+/**************************************************************************************/
+/* get_thread_ring: the calling thread's ring, created on its first event */
+
+static Trace_Event_Ring* get_thread_ring(void) {
+  if (thread_ring)
+    return thread_ring;
+  Trace_Event_Ring* ring = (Trace_Event_Ring*)calloc(1, sizeof(Trace_Event_Ring));
+  ring->size = TRACE_EVENT_RING_SIZE;
+  ring->data = (char*)malloc(ring->size);
+  pthread_mutex_lock(&rings_mutex);
+  ASSERTM(0, num_rings < TRACE_EVENT_MAX_RINGS, "Too many threads write trace events\n");
+  rings[num_rings] = ring;
+  __atomic_store_n(&num_rings, num_rings + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&rings_mutex);
+  thread_ring = ring;
+  return ring;
+}
+
+/**************************************************************************************/
+/* drain_ring: hands every event written so far to its handler. Returns whether
+   there were any. */
+
+static Flag drain_ring(Trace_Event_Ring* ring) {
+  uns64 head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+  uns64 tail = ring->tail;
+  if (tail == head)
+    return FALSE;
+  while (tail != head) {
+    Trace_Event_Header* header = (Trace_Event_Header*)(ring->data + (tail & (ring->size - 1)));
+    if (header->category != TRACE_EVENT_PAD)
+      handlers[header->category](header->type, header + 1, header->size);
+    tail += TRACE_EVENT_ALIGN(sizeof(Trace_Event_Header) + header->size);
+    __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);  // free the space for a waiting producer
+  }
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* io_main: drains the rings until trace_event_done */
+
+static void* io_main(void* arg) {
+  while (TRUE) {
+    Flag done = __atomic_load_n(&io_done, __ATOMIC_ACQUIRE);
+    Flag any = FALSE;
+    uns count = __atomic_load_n(&num_rings, __ATOMIC_ACQUIRE);
+    for (uns ii = 0; ii < count; ii++)
+      any |= drain_ring(rings[ii]);
+    if (any)
+      continue;
+    if (done)
+      break;
+    fflush(mystdout);
+    usleep(TRACE_EVENT_IDLE_USEC);
+  }
+  return NULL;
+}
+
+/**************************************************************************************/
+/* flush_at_exit: keeps the events before a failed assert or a fatal error */
+
+static void flush_at_exit(void) {
+  if (!io_thread_running)
+    return;
+  trace_event_flush();
+  fflush(mystdout);
+}
+
+/**************************************************************************************/
+/* debug_handler: */
+
+static void debug_handler(uns type, const void* payload, uns size) {
+  fwrite(payload, 1, size, GLOBAL_DEBUG_STREAM);
+}
@@ -0,0 +1,99 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : debug/trace_event.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Typed trace events handed to a background I/O thread. Each
+ *                simulation thread appends events to its own lock-free ring;
+ *                the I/O thread drains the rings and passes every event to the
+ *                handler of its category, which does the formatting and file
+ *                writes off the simulation thread.
+ ***************************************************************************************/
+
+#ifndef __TRACE_EVENT_H__
+#define __TRACE_EVENT_H__
+
+#include "globals/global_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Trace_Event_Category_enum {
+  TRACE_EVENT_DEBUG,    // text of the DEBUG macros (DEBUG_ASYNC)
+  TRACE_EVENT_MEMVIEW,  // debug/memview.c
+  TRACE_EVENT_NUM_CATEGORIES
+} Trace_Event_Category;
+
+/* Called on the I/O thread for each event of a category, in the order the
+   producing thread wrote them */
+typedef void (*Trace_Event_Handler)(uns type, const void* payload, uns size);
+
+/**************************************************************************************/
+/* Global Variables */
+
+/* Bit per enabled category. Checking it is the only cost of a disabled event. */
+extern uns trace_event_mask;
+
+/**************************************************************************************/
+/* Macros */
+
+#define TRACE_EVENT_ON(category) (trace_event_mask & (1U << (category)))
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Enables the categories selected by parameters (DEBUG_ASYNC) */
+void trace_event_init(void);
+
+/* Enables a category, starting the I/O thread on first use */
+void trace_event_enable(Trace_Event_Category category, Trace_Event_Handler handler);
+
+/* Appends an event to the calling thread's ring, waiting only if the ring is
+   full */
+void trace_event_write(Trace_Event_Category category, uns type, const void* payload, uns size);
+
+/* Appends a printf-formatted text event (type 0) */
+void trace_event_printf(Trace_Event_Category category, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+
+/* Appends a DEBUG macro line, with the usual file/flag/counter prefix, as one
+   TRACE_EVENT_DEBUG event */
+void trace_event_debug(const char* file, uns line, const char* flag, uns proc_id, const char* fmt, ...)
+    __attribute__((format(printf, 5, 6)));
+
+/* Returns once the I/O thread has handled every event written so far */
+void trace_event_flush(void);
+
+/* Flushes, disables every category and stops the I/O thread */
+void trace_event_done(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+/**************************************************************************************/
+
+#endif /* #ifndef __TRACE_EVENT_H__ */
@@ -65,13 +65,14 @@
 /**************************************************************************************/
 /* Global Variables */
 
-Decode_Stage* dec = NULL;
-bool decode_off_path;
+CORE_LOCAL Decode_Stage* dec = NULL;
+CORE_LOCAL bool decode_off_path;
 
 /**************************************************************************************/
 /* Local prototypes */
 
 static inline void update_cycles_stats(Stage_Data* src_sd, int empty_stage_idx);
+static inline void count_decode_cycle(Stage_Data* src_sd, Flag stall);
 
 /**************************************************************************************/
 /* set_decode_stage: */
@@ -87,7 +88,7 @@ void init_decode_stage(uns8 proc_id, const char* name) {
   char tmp_name[MAX_STR_LENGTH + 1];
   uns ii;
   ASSERT(0, dec);
-  ASSERT(0, STAGE_MAX_DEPTH > 0);
+  ASSERT(0, STAGE_MAX_DEPTH > 0 && STAGE_MAX_DEPTH <= STAGE_LATCHES_MAX_DEPTH);
   DEBUG(proc_id, "Initializing %s stage\n", name);
 
   memset(dec, 0, sizeof(Decode_Stage));
@@ -102,6 +103,8 @@ void init_decode_stage(uns8 proc_id, const char* name) {
     cur->ops = (Op**)calloc(STAGE_MAX_OP_COUNT, sizeof(Op*));
   }
   dec->last_sd = &dec->sds[0];
+  if (FDIP_DUAL_PATH_PREF_UOC_ONLINE_ENABLE)
+    init_branch_misprediction_table(proc_id);
   reset_decode_stage();
 }
 
@@ -164,44 +167,37 @@ void debug_decode_stage() {
 
 void update_decode_stage(Stage_Data* src_sd) {
   Flag stall = (dec->last_sd->op_count > 0);
-  Stage_Data *cur, *prev;
-  Op** temp;
+  Stage_Data* cur;
   uns ii;
 
-  if (!decode_off_path) {
-    if (stall)
-      STAT_EVENT(dec->proc_id, DECODE_STAGE_STALLED);
-    else
-      STAT_EVENT(dec->proc_id, DECODE_STAGE_NOT_STALLED);
-    if (!src_sd->op_count)
-      STAT_EVENT(dec->proc_id, DECODE_STAGE_STARVED);
-    else
-      STAT_EVENT(dec->proc_id, DECODE_STAGE_NOT_STARVED);
-  } else
-    STAT_EVENT(dec->proc_id, DECODE_STAGE_OFF_PATH);
+  count_decode_cycle(src_sd, stall);
 
-  /* do all the intermediate stages */
-  for (ii = 0; ii < STAGE_MAX_DEPTH - 1; ii++) {
-    cur = &dec->sds[ii];
-    if (cur->op_count)
-      continue;
-    prev = &dec->sds[ii + 1];
-    temp = cur->ops;
-    cur->ops = prev->ops;
-    prev->ops = temp;
-    cur->op_count = prev->op_count;
-    prev->op_count = 0;
+  /* an empty pipeline with nothing to take, or a stalled one in which no op
+     can move, would go through the steps below without changing anything */
+  uns64 occupied = stage_latches_occupancy(dec->sds, STAGE_MAX_DEPTH);
+  Flag first_free = !(occupied >> (STAGE_MAX_DEPTH - 1));
+  if ((!occupied || (stall && stage_latches_packed(occupied))) && !(first_free && src_sd->op_count)) {
+    STAT_EVENT(dec->proc_id, DECODE_STAGE_SKIPPED);
+    return;
   }
 
+  /* do all the intermediate stages */
+  occupied = stage_latches_shift(dec->sds, STAGE_MAX_DEPTH, occupied);
+
   /* do the first decode stage */
   /* Ops from the uop cache do not go to the decode stage. */
   cur = &dec->sds[STAGE_MAX_DEPTH - 1];
   if (cur->op_count == 0 && src_sd->op_count) {
-    for (int i = 0; i < src_sd->max_op_count; i++) {
+    /* stop at the last op of src_sd rather than at its last slot */
+    int src_left = src_sd->op_count;
+    for (int i = 0; src_left && i < src_sd->max_op_count; i++) {
       Op* src_op = src_sd->ops[i];
-      if (src_op && src_op->off_path)
+      if (!src_op)
+        continue;
+      src_left--;
+      if (src_op->off_path)
         decode_off_path = true;
-      if (src_op && !src_op->fetched_from_uop_cache) {
+      if (!src_op->fetched_from_uop_cache) {
         cur->ops[cur->op_count] = src_op;
         src_sd->ops[i] = NULL;
         cur->op_count++;
@@ -262,8 +258,47 @@ void decode_stage_process_op(Op* op) {
     }
 
     if (FDIP_DUAL_PATH_PREF_UOC_ONLINE_ENABLE)
-      increment_branch_count(op->inst_info->addr);
+      increment_branch_count(dec->proc_id, op->inst_info->addr);
+  }
+}
+
+/**************************************************************************************/
+/* decode_stage_next_event_cycle: the decode pipeline is frozen when its last
+ * stage is stalled, no ops can move up into an empty stage and none can be
+ * taken from src_sd */
+
+Counter decode_stage_next_event_cycle(Stage_Data* src_sd) {
+  if (dec->last_sd->op_count == 0)
+    return cycle_count + 1;
+  for (uns ii = 0; ii < STAGE_MAX_DEPTH - 1; ii++) {
+    if (dec->sds[ii].op_count == 0 && dec->sds[ii + 1].op_count)
+      return cycle_count + 1;
   }
+  if (dec->sds[STAGE_MAX_DEPTH - 1].op_count == 0 && src_sd->op_count)
+    return cycle_count + 1;
+  return MAX_CTR;
+}
+
+/**************************************************************************************/
+/* skip_decode_stage: stands in for update_decode_stage in a cycle in which
+ * decode_stage_next_event_cycle() says the pipeline is frozen */
+
+void skip_decode_stage(Stage_Data* src_sd) {
+  count_decode_cycle(src_sd, TRUE);
+}
+
+static inline void count_decode_cycle(Stage_Data* src_sd, Flag stall) {
+  if (!decode_off_path) {
+    if (stall)
+      STAT_EVENT(dec->proc_id, DECODE_STAGE_STALLED);
+    else
+      STAT_EVENT(dec->proc_id, DECODE_STAGE_NOT_STALLED);
+    if (!src_sd->op_count)
+      STAT_EVENT(dec->proc_id, DECODE_STAGE_STARVED);
+    else
+      STAT_EVENT(dec->proc_id, DECODE_STAGE_NOT_STARVED);
+  } else
+    STAT_EVENT(dec->proc_id, DECODE_STAGE_OFF_PATH);
 }
 
 // UNUSED, and not kept up to date with uop cache changes.
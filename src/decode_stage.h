@@ -43,7 +43,7 @@ typedef struct Decode_Stage_struct {
 /**************************************************************************************/
 /* External Variables */
 
-extern Decode_Stage* dec;
+extern CORE_LOCAL Decode_Stage* dec;
 
 /**************************************************************************************/
 /* Prototypes */
@@ -55,6 +55,8 @@ void reset_decode_stage(void);
 void recover_decode_stage(void);
 void debug_decode_stage(void);
 void update_decode_stage(Stage_Data*);
+Counter decode_stage_next_event_cycle(Stage_Data*);
+void skip_decode_stage(Stage_Data*);
 // Needed when ops skip the decode stage when fetched from the uop cache.
 void decode_stage_process_op(Op*);
 
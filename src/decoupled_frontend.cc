@@ -1,7 +1,6 @@
 #include "decoupled_frontend.h"
 
 #include <cmath>
-#include <deque>
 #include <iostream>
 #include <tuple>
 #include <vector>
@@ -21,12 +20,64 @@
 
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_DECOUPLED_FE, ##args)
 
+// The fetch target queue: a ring of FT pointers. The capacity is a power of two
+// and only doubles when the FTQ size limit is raised past it, so pushing,
+// popping and flushing FTs does not allocate. The lookahead queue reuses it.
+template <typename Entry>
+class FTQ_Ring {
+ public:
+  explicit FTQ_Ring(uint64_t min_capacity = 1) {
+    uint64_t capacity = 1;
+    while (capacity < min_capacity)
+      capacity <<= 1;
+    slots.resize(capacity);
+  }
+  uint64_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  Entry front() const { return at(0); }
+  Entry back() const { return at(count - 1); }
+  Entry at(uint64_t idx) const {
+    ASSERT(0, idx < count);
+    return slots[(head + idx) & (slots.size() - 1)];
+  }
+  void push_back(Entry entry) {
+    if (count == slots.size())
+      grow();
+    slots[(head + count) & (slots.size() - 1)] = entry;
+    count++;
+  }
+  void pop_front() {
+    ASSERT(0, count);
+    head = (head + 1) & (slots.size() - 1);
+    count--;
+  }
+  void clear() {
+    head = 0;
+    count = 0;
+  }
+
+ private:
+  void grow() {
+    std::vector<Entry> new_slots(slots.size() * 2);
+    for (uint64_t idx = 0; idx < count; idx++)
+      new_slots[idx] = at(idx);
+    slots.swap(new_slots);
+    head = 0;
+  }
+
+  std::vector<Entry> slots;
+  uint64_t head = 0;
+  uint64_t count = 0;
+};
+
 class Decoupled_FE {
  public:
   Decoupled_FE(uns _proc_id);
   int is_off_path() { return is_off_path_state(); }
   void recover();
   void update();
+  bool is_ftq_stalled();
+  void skip_cycle();
   FT* get_ft();
   void pop_ft(FT* ft);
   decoupled_fe_iter* new_ftq_iter();
@@ -36,6 +87,8 @@ class Decoupled_FE {
   uint64_t ftq_num_fts() { return ftq.size(); }
   void stall(Op* op);
   void retire(Op* op, int op_proc_id, uns64 inst_uid);
+  void set_drain(bool drain) { draining = drain; }
+  bool is_drained() const { return ftq.empty() && lookahead.empty() && state == SERVING_ON_PATH && !stalled; }
   void set_ftq_num(uint64_t set_ftq_ft_num) { ftq_ft_num = set_ftq_ft_num; }
   uint64_t get_ftq_num() { return ftq_ft_num; }
   Op* get_cur_op() { return cur_op; }
@@ -57,13 +110,22 @@ class Decoupled_FE {
 
  private:
   void init(uns proc_id);
+  void begin_cycle();
 
   uns proc_id;
 
   // Per core fetch target queue:
   // Each core has a queue of FTs,
   // where each FT contains a queue of micro instructions.
-  std::deque<FT*> ftq;
+  FTQ_Ring<FT*> ftq;
+  // On-path FTs already built and predicted by the lookahead stage, oldest
+  // first. Only the youngest can end in a predict event, the path is not
+  // known past it.
+  struct Lookahead_FT {
+    FT* ft;
+    FT_PredictResult result;
+  };
+  FTQ_Ring<Lookahead_FT> lookahead;
   // keep track of the current FT to be pushed next
   FT* current_ft_to_push;
   FT* saved_recovery_ft;
@@ -73,6 +135,7 @@ class Decoupled_FE {
   uint64_t recovery_addr;
   uint64_t redirect_cycle;
   bool stalled;
+  bool draining;
   uint64_t ftq_ft_num;
   bool trace_mode;
   Op* cur_op;
@@ -83,17 +146,20 @@ class Decoupled_FE {
 
   void check_consecutivity_and_push_to_ftq();
   void redirect_to_off_path(FT_PredictResult result);
+  FT* build_and_predict_on_path_ft(FT_PredictResult* result);
+  void update_lookahead();
   inline uint64_t ftq_max_size() { return ftq_ft_num; }
 };
 
 /* Global Variables */
-Decoupled_FE* dfe = nullptr;
-Flag have_seen_exit_on_prebuilt = 0;
+CORE_LOCAL Decoupled_FE* dfe = nullptr;
+CORE_LOCAL Flag have_seen_exit_on_prebuilt = 0;
 uint64_t op_num_count = 1;
-uint64_t current_off_path_op_num_count = 0;
+CORE_LOCAL uint64_t current_off_path_op_num_count = 0;
 
 uint64_t get_next_on_path_op_id() {
-  return op_num_count++;
+  // shared by all cores, which may be simulated on different host threads
+  return __atomic_fetch_add(&op_num_count, 1, __ATOMIC_RELAXED);
 }
 uint64_t get_next_off_path_op_id() {
   return current_off_path_op_num_count++;
@@ -107,6 +173,7 @@ std::vector<Decoupled_FE> per_core_dfe;
 
 /* Wrapper functions */
 void alloc_mem_decoupled_fe(uns numCores) {
+  FT::alloc_pools(numCores);
   for (uns i = 0; i < numCores; ++i)
     per_core_dfe.push_back(Decoupled_FE(i));
   ASSERT(0, per_core_dfe.size() == numCores);
@@ -138,6 +205,22 @@ void update_decoupled_fe() {
   dfe->update();
 }
 
+Counter decoupled_fe_next_event_cycle() {
+  return dfe->is_ftq_stalled() ? MAX_CTR : cycle_count + 1;
+}
+
+void skip_decoupled_fe() {
+  dfe->skip_cycle();
+}
+
+void decoupled_fe_set_drain(uns proc_id, bool drain) {
+  per_core_dfe[proc_id].set_drain(drain);
+}
+
+bool decoupled_fe_is_drained(uns proc_id) {
+  return per_core_dfe[proc_id].is_drained();
+}
+
 void decoupled_fe_pop_ft(FT* ft) {
   dfe->pop_ft(ft);
 }
@@ -234,10 +317,13 @@ void Decoupled_FE::init(uns _proc_id) {
   recovery_addr = 0;
   redirect_cycle = 0;
   stalled = false;
+  draining = false;
   ftq_ft_num = FE_FTQ_BLOCK_NUM;
   cur_op = nullptr;
 
   current_ft_to_push = nullptr;
+  ftq = FTQ_Ring<FT*>(ftq_ft_num);
+  lookahead = FTQ_Ring<Lookahead_FT>(FE_LOOKAHEAD_FTS);
 
   if (CONFIDENCE_ENABLE)
     conf = new Conf(_proc_id);
@@ -250,10 +336,12 @@ void Decoupled_FE::recover() {
   cur_op = nullptr;
   recovery_addr = bp_recovery_info->recovery_fetch_addr;
 
-  for (auto it = ftq.begin(); it != ftq.end(); it++) {
-    delete (*it);
+  for (uint64_t idx = 0; idx < ftq.size(); idx++) {
+    ftq.at(idx)->release();
   }
   ftq.clear();
+  // lookahead FTs are on-path, and nothing on-path is fetched after a mispredict
+  ASSERT(proc_id, lookahead.empty());
 
   DEBUG(proc_id, "Recovery signalled fetch_addr0x:%llx\n", bp_recovery_info->recovery_fetch_addr);
 
@@ -297,10 +385,10 @@ void Decoupled_FE::recover() {
     conf->recover(op);
 }
 
-void Decoupled_FE::update() {
-  uint64_t cfs_taken_this_cycle = 0;
-  uint64_t ft_pushed_this_cycle = 0;
-  static int fwd_progress = 0;
+// cycles since any core pushed an FT
+static int fwd_progress = 0;
+
+void Decoupled_FE::begin_cycle() {
   fwd_progress++;
   if (fwd_progress >= 1000000) {
     std::cout << "No forward progress for 1000000 cycles" << std::endl;
@@ -314,6 +402,23 @@ void Decoupled_FE::update() {
   // update per-cycle confidence mechanism state
   if (CONFIDENCE_ENABLE)
     conf->per_cycle_update();
+}
+
+// A full FTQ (with a full lookahead queue behind it) stops update() before it
+// builds anything.
+bool Decoupled_FE::is_ftq_stalled() {
+  return ftq.size() == ftq_max_size() && (!FE_LOOKAHEAD_FTS || lookahead.size() >= FE_LOOKAHEAD_FTS);
+}
+
+void Decoupled_FE::skip_cycle() {
+  begin_cycle();
+  STAT_EVENT(proc_id, FTQ_BREAK_FULL_FT_ONPATH + is_off_path_state());
+}
+
+void Decoupled_FE::update() {
+  uint64_t cfs_taken_this_cycle = 0;
+  uint64_t ft_pushed_this_cycle = 0;
+  begin_cycle();
 
   while (1) {
     ASSERT(proc_id, ftq.size() <= ftq_max_size());
@@ -345,6 +450,12 @@ void Decoupled_FE::update() {
       STAT_EVENT(proc_id, FTQ_BREAK_BAR_FETCH_ONPATH + is_off_path_state());
       break;
     }
+    // a pending recovery still has to deliver its saved on-path FT, and the
+    // lookahead ones are already fetched
+    if (draining && state == SERVING_ON_PATH && lookahead.empty()) {
+      DEBUG(proc_id, "Break due to pipeline drain\n");
+      break;
+    }
     fwd_progress = 0;
     // FSM-based FT build logic - four states:
     // EXITING: stop whend end of track seen
@@ -378,17 +489,17 @@ void Decoupled_FE::update() {
       }
       // recover will fall through to on-path exec
       case SERVING_ON_PATH: {
-        current_ft_to_push = new FT();
         // Build new on-path FT if no recovery ft availble
-        ASSERT(proc_id, !current_ft_to_push->has_unread_ops());
-        auto build_success = current_ft_to_push->build([](uns8 pid) { return frontend_can_fetch_op(pid); },
-                                                       [](uns8 pid, Op* op) -> bool {
-                                                         frontend_fetch_op(pid, op);
-                                                         return true;
-                                                       },
-                                                       false, []() { return get_next_on_path_op_id(); });
-        ASSERT(proc_id, build_success);
-        result = current_ft_to_push->predict_ft();
+        if (!lookahead.empty()) {
+          current_ft_to_push = lookahead.front().ft;
+          result = lookahead.front().result;
+          lookahead.pop_front();
+          STAT_EVENT(proc_id, DFE_LOOKAHEAD_FT_USED);
+        } else {
+          current_ft_to_push = build_and_predict_on_path_ft(&result);
+          if (FE_LOOKAHEAD_FTS)
+            STAT_EVENT(proc_id, DFE_LOOKAHEAD_FT_MISSED);
+        }
         // if current FT is the exit one, skip mispredict handling and directly push
         // set state and early return
         if (current_ft_to_push->ended_by_exit()) {
@@ -411,14 +522,9 @@ void Decoupled_FE::update() {
       case SERVING_OFF_PATH: {
         // for off-path just build and. redirect
         // cf processed while building
-        current_ft_to_push = new FT();
+        current_ft_to_push = FT::alloc(proc_id);
         ASSERT(proc_id, !current_ft_to_push->has_unread_ops());
-        auto build_success = current_ft_to_push->build([](uns8 pid) { return frontend_can_fetch_op(pid); },
-                                                       [](uns8 pid, Op* op) -> bool {
-                                                         frontend_fetch_op(pid, op);
-                                                         return true;
-                                                       },
-                                                       true, []() { return get_next_off_path_op_id(); });
+        auto build_success = current_ft_to_push->build_from_frontend(true);
         ASSERT(proc_id, build_success);
         if (current_ft_to_push->get_end_reason() == FT_TAKEN_BRANCH) {
           frontend_redirect(proc_id, current_ft_to_push->get_last_op()->inst_uid,
@@ -435,6 +541,39 @@ void Decoupled_FE::update() {
                             (current_ft_to_push->get_end_reason() == FT_BAR_FETCH);
     ft_pushed_this_cycle++;
   }
+
+  if (FE_LOOKAHEAD_FTS)
+    update_lookahead();
+}
+
+FT* Decoupled_FE::build_and_predict_on_path_ft(FT_PredictResult* result) {
+  FT* ft = FT::alloc(proc_id);
+  ASSERT(proc_id, !ft->has_unread_ops());
+  auto build_success = ft->build_from_frontend(false);
+  ASSERT(proc_id, build_success);
+  *result = ft->predict_ft();
+  return ft;
+}
+
+// The lookahead stage: predicts the next on-path FTs ahead of the FTQ, up to
+// FE_LOOKAHEAD_FTS of them. It stops at an FT that ends in a mispredict, a
+// fetch barrier or the exit, which the FTQ side handles when it gets there.
+void Decoupled_FE::update_lookahead() {
+  for (uint64_t predicted = 0; predicted < FE_FTQ_FT_PER_CYCLE; predicted++) {
+    if (state != SERVING_ON_PATH || stalled || draining || lookahead.size() >= FE_LOOKAHEAD_FTS)
+      return;
+    if (!lookahead.empty()) {
+      const Lookahead_FT& youngest = lookahead.back();
+      if (youngest.result.event != FT_EVENT_NONE || youngest.ft->ended_by_exit())
+        return;
+    }
+    if (BP_MECH != MTAGE_BP && !bp_is_predictable(g_bp_data, proc_id))
+      return;
+    Lookahead_FT entry;
+    entry.ft = build_and_predict_on_path_ft(&entry.result);
+    lookahead.push_back(entry);
+    STAT_EVENT(proc_id, DFE_LOOKAHEAD_FT_PREDICTED);
+  }
 }
 
 FT* Decoupled_FE::get_ft() {
@@ -511,8 +650,8 @@ Op* Decoupled_FE::ftq_iter_get_next(decoupled_fe_iter* iter, bool* end_of_ft) {
 
 uint64_t Decoupled_FE::ftq_num_ops() {
   uint64_t num_ops = 0;
-  for (auto it = ftq.begin(); it != ftq.end(); it++) {
-    num_ops += (*it)->ops.size();
+  for (uint64_t idx = 0; idx < ftq.size(); idx++) {
+    num_ops += ftq.at(idx)->ops.size();
   }
   return num_ops;
 }
@@ -576,7 +715,7 @@ void Decoupled_FE::check_consecutivity_and_push_to_ftq() {
     ASSERT(proc_id, recovery_addr == current_ft_to_push->get_start_addr());
     recovery_addr = 0;
   }
-  ftq.emplace_back(std::move(current_ft_to_push));
+  ftq.push_back(current_ft_to_push);
 }
 
 void Decoupled_FE::redirect_to_off_path(FT_PredictResult result) {
@@ -591,13 +730,8 @@ void Decoupled_FE::redirect_to_off_path(FT_PredictResult result) {
   }
   // no trailing ft, misprediction happened at the last op of the on-path FT, fetch the next on-path ft, then redirect
   else {
-    saved_recovery_ft = new FT();
-    auto build_success = saved_recovery_ft->build([](uns8 pid) { return frontend_can_fetch_op(pid); },
-                                                  [](uns8 pid, Op* op) -> bool {
-                                                    frontend_fetch_op(pid, op);
-                                                    return true;
-                                                  },
-                                                  false, []() { return get_next_on_path_op_id(); });
+    saved_recovery_ft = FT::alloc(proc_id);
+    auto build_success = saved_recovery_ft->build_from_frontend(false);
     ASSERT(proc_id, build_success);
   }
   redirect_cycle = cycle_count;
@@ -607,12 +741,7 @@ void Decoupled_FE::redirect_to_off_path(FT_PredictResult result) {
   set_off_path_op_id(current_ft_to_push->get_last_op()->op_num + 1);
   // patching/modify the current FT with off-path op if current FT not ended
   if (current_ft_to_push->get_end_reason() == FT_NOT_ENDED) {
-    auto build_success = current_ft_to_push->build([](uns8 pid) { return frontend_can_fetch_op(pid); },
-                                                   [](uns8 pid, Op* op) -> bool {
-                                                     frontend_fetch_op(pid, op);
-                                                     return true;
-                                                   },
-                                                   true, []() { return get_next_off_path_op_id(); });
+    auto build_success = current_ft_to_push->build_from_frontend(true);
     ASSERT(proc_id, build_success);
     if (current_ft_to_push->get_end_reason() == FT_TAKEN_BRANCH) {
       frontend_redirect(proc_id, current_ft_to_push->get_last_op()->inst_uid,
@@ -98,6 +98,15 @@ void set_decoupled_fe(uns proc_id);
 void reset_decoupled_fe();
 void debug_decoupled_fe();
 void update_decoupled_fe();
+/* The FTQ is full and nothing can be built; skip_decoupled_fe() then stands in
+   for update_decoupled_fe() */
+Counter decoupled_fe_next_event_cycle();
+void skip_decoupled_fe();
+/* While draining, the frontend stops building new on-path fetch targets so that
+   the pipeline empties; drained once nothing is left in the FTQ and fetch is back
+   on the correct path */
+void decoupled_fe_set_drain(uns proc_id, bool drain);
+bool decoupled_fe_is_drained(uns proc_id);
 // Icache/Core API
 void recover_decoupled_fe();
 void decoupled_fe_pop_ft(FT* ft);
@@ -105,6 +114,9 @@ bool decoupled_fe_is_off_path();
 void decoupled_fe_retire(Op* op, int proc_id, uns64 inst_uid);
 
 FT* decoupled_fe_get_ft();
+// Op numbers of the FTs built on and off the correct path
+uint64_t get_next_on_path_op_id();
+uint64_t get_next_off_path_op_id();
 // FTQ API
 decoupled_fe_iter* decoupled_fe_new_ftq_iter(uns proc_id);
 /* Returns the Op at current iterator position or NULL if FTQ is empty or the end of FTQ was reached
@@ -41,8 +41,11 @@
 #include "general.param.h"
 #include "memory/memory.param.h"
 
+#include "frontend/frontend.h"
+
 #include "freq.h"
 #include "model.h"
+#include "op_pool.h"
 #include "sim.h"
 #include "statistics.h"
 
@@ -57,12 +60,15 @@ typedef struct Proc_Info_struct {
   uns reqs_out;          // number of outstanding reqs
   Flag retry;            // couldn't send last mem req, keep retrying
   Flag dumb;             // is this core actually dumb
+  Op* stalled_op;        // memory op waiting for a window slot (DUMB_MODEL_FRONTEND)
 } Proc_Info;
 
 /**************************************************************************************/
 /* Local prototypes */
 
 static Flag dumb_req_done(Mem_Req* req);
+static void dumb_frontend_cycle(uns proc_id, Proc_Info* info);
+static void dumb_retire_op(uns proc_id, Op* op);
 
 /**************************************************************************************/
 /* Global variables */
@@ -151,6 +157,8 @@ Flag dumb_req_done(Mem_Req* req) {
   Proc_Info* info = &infos[proc_id];
   ASSERT(proc_id, info->reqs_out >= req->req_count);
   info->reqs_out -= req->req_count;
+  if (DUMB_MODEL_FRONTEND)
+    return TRUE;  // instructions are counted as they issue
   INC_STAT_EVENT(proc_id, NODE_INST_COUNT, req->req_count);
   inst_count[proc_id] += req->req_count;
   if (SIM_MODEL == DUMB_MODEL && !sim_done[proc_id] && INST_LIMIT && inst_count[proc_id] >= inst_limit[proc_id]) {
@@ -170,6 +178,10 @@ void dumb_cycle() {
       continue;
     STAT_EVENT(proc_id, NODE_CYCLE);
     Proc_Info* info = &infos[proc_id];
+    if (DUMB_MODEL_FRONTEND) {
+      dumb_frontend_cycle(proc_id, info);
+      continue;
+    }
     Flag send_req = info->retry || (info->reqs_out < info->mlp && (rand() % info->avg_req_distance) == 0);
     if (info->retry || info->reqs_out == info->mlp) {
       STAT_EVENT(proc_id, FULL_WINDOW_STALL);
@@ -205,6 +217,59 @@ void dumb_cycle() {
     update_memory();
 }
 
+/**************************************************************************************/
+/* dumb_frontend_cycle: issue up to DUMB_MODEL_IPC ops from the frontend. Loads
+   and stores go straight to memory as L1-line requests; everything else
+   retires immediately. Issue stalls in order once MLP requests are
+   outstanding or the memory system refuses a request. */
+
+static void dumb_frontend_cycle(uns proc_id, Proc_Info* info) {
+  for (uns ii = 0; ii < DUMB_MODEL_IPC; ii++) {
+    Op* op = info->stalled_op;
+    if (!op) {
+      if (retired_exit[proc_id] || !frontend_can_fetch_op(proc_id))
+        return;
+      op = alloc_op(proc_id);
+      frontend_fetch_op(proc_id, op);
+    }
+    Mem_Type mem_type = op->table_info->mem_type;
+    if (mem_type == MEM_LD || mem_type == MEM_ST) {
+      Flag sent = FALSE;
+      if (info->reqs_out < info->mlp) {
+        Addr line_addr = op->oracle_info.va & ~(Addr)(L1_LINE_SIZE - 1);
+        Counter unique_num = SIM_MODEL == DUMB_MODEL ? req_num : unique_count;
+        sent = new_mem_req(mem_type == MEM_ST ? MRT_DSTORE : MRT_DFETCH, proc_id, line_addr, L1_LINE_SIZE, 0, NULL,
+                           dumb_req_done, unique_num, NULL);
+      }
+      if (!sent) {
+        STAT_EVENT(proc_id, FULL_WINDOW_STALL);
+        info->stalled_op = op;
+        return;
+      }
+      req_num++;
+      info->reqs_out++;
+      if (SIM_MODEL != DUMB_MODEL)
+        unique_count++;
+    }
+    info->stalled_op = NULL;
+    dumb_retire_op(proc_id, op);
+  }
+}
+
+/**************************************************************************************/
+/* dumb_retire_op: */
+
+static void dumb_retire_op(uns proc_id, Op* op) {
+  if (op->eom) {
+    STAT_EVENT(proc_id, NODE_INST_COUNT);
+    inst_count[proc_id]++;
+    frontend_retire(proc_id, op->inst_uid);
+    if (op->exit || (SIM_MODEL == DUMB_MODEL && INST_LIMIT && inst_count[proc_id] >= inst_limit[proc_id]))
+      retired_exit[proc_id] = TRUE;
+  }
+  free_op(op);
+}
+
 /**************************************************************************************/
 /* dumb_debug: */
 
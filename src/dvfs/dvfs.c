@@ -43,6 +43,7 @@
 
 #include "power/power_intf.h"
 
+#include "cmp_threads.h"
 #include "freq.h"
 #include "optimizer2.h"
 #include "perf_pred.h"
@@ -70,6 +71,14 @@ typedef struct Metric_struct {
   int delay_exp;
 } Metric;
 
+/* Prediction for one config at the current DVFS epoch */
+typedef struct Config_Eval_struct {
+  Flag done;         /* evaluated this epoch */
+  double metric;     /* lower is better */
+  double norm_power; /* predicted power normalized to the current config */
+  double slowdown;   /* predicted slowdown relative to the current config */
+} Config_Eval;
+
 /* Per core info for BW sharing model */
 typedef struct Proc_Info_struct {
   double orig_perf; /* measured performance, compute cycles per second */
@@ -100,7 +109,13 @@ static FILE* dvfs_log;
 static FILE* config_trace;
 static Trigger* start_trigger;
 static Trigger* trigger;
-static Proc_Info* proc_infos;
+static Trigger* prune_trigger;
+static Proc_Info* proc_infos;  // NUM_CORES scratch arrays, one per evaluation job
+static Config_Eval* config_evals;
+static uns* candidates;  // configs evaluated by the current call of evaluate_candidates()
+static uns num_candidates;
+static uns num_core_cycle_times;  // cycle times per core in DVFS_CONFIGS; 0 for DVFS_CONFIG_FILE
+static void (*evaluate_config)(uns config_idx, Proc_Info* infos);
 
 /**************************************************************************************/
 /* Local prototypes */
@@ -114,13 +129,19 @@ static uns dvfs_read_config_trace(void);
 static void dvfs_reconfigure_oracle(void);
 static void dvfs_reconfigure_perf_pred(void);
 static void dvfs_reconfigure_dram_sharing(void);
+static void evaluate_perf_pred_config(uns config_idx, Proc_Info* infos);
+static void evaluate_dram_sharing_config(uns config_idx, Proc_Info* infos);
+static uns choose_config(void);
+static uns hill_climb(void);
+static void evaluate_candidates(void);
+static void evaluate_candidates_job(uns8 proc_id);
 static double dvfs_metric(double power, double delay);
 static Metric get_metric(void);
 static double gmean(const double* array, uns num);
 static double compute_oracle_metric(void);
 static void invoke_dram_sharing_solver(double* pred_speedups, Config* config);
 static void compute_stall_time_speedups(double* pred_speedups, Config* config);
-static void compute_bw_sharing_speedups(double* pred_speedups, Config* config);
+static void compute_bw_sharing_speedups(double* pred_speedups, Config* config, Proc_Info* infos);
 
 /**************************************************************************************/
 /* dvfs_init: */
@@ -166,13 +187,17 @@ void dvfs_init(void) {
 
   start_trigger = trigger_create("DVFS START", DVFS_START, TRIGGER_ONCE);
   trigger = trigger_create("DVFS PERIOD", DVFS_PERIOD, TRIGGER_REPEAT);
+  prune_trigger = trigger_create("DVFS ORACLE PRUNE", DVFS_ORACLE_PRUNE_PERIOD, TRIGGER_REPEAT);
 
   if (DVFS_LOG) {
     dvfs_log = file_tag_fopen(NULL, "dvfs", "w");
     ASSERTM(0, dvfs_log, "Could not open DVFS log file\n");
   }
 
-  proc_infos = malloc(NUM_CORES * sizeof(Proc_Info));
+  proc_infos = malloc(NUM_CORES * NUM_CORES * sizeof(Proc_Info));
+  config_evals = malloc(num_configs * sizeof(Config_Eval));
+  candidates = malloc(num_configs * sizeof(uns));
+  ASSERTM(0, !DVFS_HILL_CLIMB || num_core_cycle_times, "DVFS_HILL_CLIMB needs the configs from DVFS_CONFIGS\n");
 
   if (!DVFS_STATIC) {
     /* set the processor to the initial config */
@@ -207,6 +232,7 @@ void init_configs_from_cmd(void) {
   ASSERT(0, num_configs > 0);
 
   uns num_avail_core_cycle_times = num_configs;
+  num_core_cycle_times = num_avail_core_cycle_times;
   int* avail_core_cycle_times = malloc(num_avail_core_cycle_times * sizeof(int));
   if (DVFS_INDIVIDUAL_CORES) {
     num_configs = 1;
@@ -333,6 +359,9 @@ void dvfs_cycle(void) {
     stat_mon_reset(stat_mon);
     if (!DVFS_USE_BW_SHARING && !DVFS_USE_DRAM_SHARING && !DVFS_USE_STALL_TIME && !DVFS_STATIC)
       perf_pred_reset_stats();
+  } else if (trigger_fired(prune_trigger) && DVFS_USE_ORACLE && trigger_on(start_trigger)) {
+    // let the optimizer kill this config early if it is already losing
+    opt2_interim_report(compute_oracle_metric());
   }
 }
 
@@ -347,6 +376,9 @@ void dvfs_done(void) {
     fclose(config_trace);
   }
   free(configs);
+  free(config_evals);
+  free(candidates);
+  free(proc_infos);
 }
 
 static void set_config(Config* config) {
@@ -394,102 +426,35 @@ static void dvfs_reconfigure_oracle(void) {
 }
 
 static void dvfs_reconfigure_perf_pred(void) {
-  double min_metric = 10.0;
-  uns min_metric_idx = num_configs;
   perf_pred_interval_done();
   if (metric.energy_exp != 0)
     power_intf_calc();
   if (DVFS_LOG)
     fprintf(dvfs_log, "Time: %llu\tInsts: %llu\tPredictions:", sim_time, inst_count[0]);
 
-  for (uns i = 0; i < num_configs; ++i) {
-    Config* config = &configs[i];
-    double pred_slowdown =
-        // perf_pred_slowdown(0, PERF_PRED_MECH, config->core_cycle_times[0],
-        // MEMORY_CYCLE_TIME);
-        perf_pred_slowdown(0, PERF_PRED_MECH, config->core_cycle_times[0], RAMULATOR_TCK);
-    double pred_norm_power;
-    double memory_access_frac = 1.0;
-    if (POWER_INTF_ON) {
-      // pred_norm_power = power_pred_norm_power(config->core_cycle_times,
-      // MEMORY_CYCLE_TIME,
-      pred_norm_power =
-          power_pred_norm_power(config->core_cycle_times, RAMULATOR_TCK, &memory_access_frac, &pred_slowdown);
-    } else {
-      ASSERT(0, metric.energy_exp == 0);
-      pred_norm_power = 1.0;
-    }
-    double metric = dvfs_metric(pred_norm_power, pred_slowdown);
-    DEBUG(0, "Predicted metric for {\%d, \%d} is %f (norm. power %f, slowdown %f)\n",
-          // configs[i].core_cycle_times[0], MEMORY_CYCLE_TIME,
-          configs[i].core_cycle_times[0], RAMULATOR_TCK, metric, pred_norm_power, pred_slowdown);
-    if (DVFS_LOG)
-      fprintf(dvfs_log, " (%f, %f)", pred_norm_power, pred_slowdown);
-    if (metric < min_metric) {
-      min_metric = metric;
-      min_metric_idx = i;
+  evaluate_config = evaluate_perf_pred_config;
+  uns min_metric_idx = choose_config();
+
+  if (DVFS_LOG) {
+    for (uns i = 0; i < num_configs; ++i) {
+      if (config_evals[i].done)
+        fprintf(dvfs_log, " (%f, %f)", config_evals[i].norm_power, config_evals[i].slowdown);
     }
-  }
-  if (DVFS_LOG)
     fprintf(dvfs_log, "\n");
+  }
   ASSERT(0, min_metric_idx != num_configs);
   set_config(&configs[min_metric_idx]);
 }
 
 static void dvfs_reconfigure_dram_sharing(void) {
-  double min_metric = 10.0;
-  uns min_metric_idx = num_configs;
   if (metric.energy_exp != 0)
     power_intf_calc();
   if (DVFS_LOG)
     fprintf(dvfs_log, "Time: %llu\tInsts: %llu\tPredictions: (too many)\n", sim_time, inst_count[0]);
-  for (uns i = 0; i < num_configs; ++i) {
-    Config* config = &configs[i];
-    double pred_speedups[MAX_NUM_PROCS] = {0};
-    if (DVFS_USE_BW_SHARING) {
-      compute_bw_sharing_speedups(pred_speedups, config);
-    } else if (DVFS_USE_DRAM_SHARING) {
-      invoke_dram_sharing_solver(pred_speedups, config);
-    } else {
-      compute_stall_time_speedups(pred_speedups, config);
-    }
-    double pred_gmean_speedup = gmean(pred_speedups, NUM_CORES);
-    double pred_gmean_slowdown = 1.0 / pred_gmean_speedup;
-    double pred_slowdowns[MAX_NUM_PROCS] = {0};
-    // convert speedups to slowdowns as expected by power_pred
-    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      pred_slowdowns[proc_id] = 1.0 / pred_speedups[proc_id];
-    }
-    double memory_access_fracs[MAX_NUM_PROCS];
-    Counter total_memory_accesses = 0;
-    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      total_memory_accesses += stat_mon_get_count(stat_mon, proc_id, MEM_REQ_COMPLETE_MEM);
-    }
-    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      memory_access_fracs[proc_id] =
-          (double)stat_mon_get_count(stat_mon, proc_id, MEM_REQ_COMPLETE_MEM) / (double)total_memory_accesses;
-    }
-    double pred_norm_power;
-    if (POWER_INTF_ON) {
-      // TODO: fix the power prediction for multicore
-      // pred_norm_power = power_pred_norm_power(config->core_cycle_times,
-      // MEMORY_CYCLE_TIME,
-      pred_norm_power =
-          power_pred_norm_power(config->core_cycle_times, RAMULATOR_TCK, memory_access_fracs, pred_slowdowns);
-    } else {
-      ASSERT(0, metric.energy_exp == 0);
-      pred_norm_power = 1.0;
-    }
-    double metric = dvfs_metric(pred_norm_power, pred_gmean_slowdown);
-    DEBUG(0, "Predicted metric for config \%d is %f (norm. power %f, slowdown %f)\n", i, metric, pred_norm_power,
-          pred_gmean_slowdown);
-    // if (DVFS_LOG) fprintf(dvfs_log, " (%f, %f)", pred_norm_power,
-    // pred_gmean_slowdown);
-    if (metric < min_metric) {
-      min_metric = metric;
-      min_metric_idx = i;
-    }
-  }
+
+  evaluate_config = evaluate_dram_sharing_config;
+  uns min_metric_idx = choose_config();
+
   if (DVFS_LOG)
     fprintf(dvfs_log, "\n");
   if (DVFS_DRAM_SHARING_SOLVER_STRICT) {
@@ -502,6 +467,167 @@ static void dvfs_reconfigure_dram_sharing(void) {
   }
 }
 
+/* evaluate_perf_pred_config: runs on the evaluation threads, so it may only
+   read the simulator state */
+static void evaluate_perf_pred_config(uns config_idx, Proc_Info* infos) {
+  Config* config = &configs[config_idx];
+  double pred_slowdown =
+      // perf_pred_slowdown(0, PERF_PRED_MECH, config->core_cycle_times[0],
+      // MEMORY_CYCLE_TIME);
+      perf_pred_slowdown(0, PERF_PRED_MECH, config->core_cycle_times[0], RAMULATOR_TCK);
+  double pred_norm_power;
+  double memory_access_frac = 1.0;
+  UNUSED(infos);
+  if (POWER_INTF_ON) {
+    // pred_norm_power = power_pred_norm_power(config->core_cycle_times,
+    // MEMORY_CYCLE_TIME,
+    pred_norm_power =
+        power_pred_norm_power(config->core_cycle_times, RAMULATOR_TCK, &memory_access_frac, &pred_slowdown);
+  } else {
+    ASSERT(0, metric.energy_exp == 0);
+    pred_norm_power = 1.0;
+  }
+  double metric = dvfs_metric(pred_norm_power, pred_slowdown);
+  DEBUG(0, "Predicted metric for {\%d, \%d} is %f (norm. power %f, slowdown %f)\n",
+        // configs[i].core_cycle_times[0], MEMORY_CYCLE_TIME,
+        config->core_cycle_times[0], RAMULATOR_TCK, metric, pred_norm_power, pred_slowdown);
+  config_evals[config_idx] =
+      (Config_Eval){.done = TRUE, .metric = metric, .norm_power = pred_norm_power, .slowdown = pred_slowdown};
+}
+
+/* evaluate_dram_sharing_config: runs on the evaluation threads, so it may
+   only read the simulator state */
+static void evaluate_dram_sharing_config(uns config_idx, Proc_Info* infos) {
+  Config* config = &configs[config_idx];
+  double pred_speedups[MAX_NUM_PROCS] = {0};
+  if (DVFS_USE_BW_SHARING) {
+    compute_bw_sharing_speedups(pred_speedups, config, infos);
+  } else if (DVFS_USE_DRAM_SHARING) {
+    invoke_dram_sharing_solver(pred_speedups, config);
+  } else {
+    compute_stall_time_speedups(pred_speedups, config);
+  }
+  double pred_gmean_speedup = gmean(pred_speedups, NUM_CORES);
+  double pred_gmean_slowdown = 1.0 / pred_gmean_speedup;
+  double pred_slowdowns[MAX_NUM_PROCS] = {0};
+  // convert speedups to slowdowns as expected by power_pred
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    pred_slowdowns[proc_id] = 1.0 / pred_speedups[proc_id];
+  }
+  double memory_access_fracs[MAX_NUM_PROCS];
+  Counter total_memory_accesses = 0;
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    total_memory_accesses += stat_mon_get_count(stat_mon, proc_id, MEM_REQ_COMPLETE_MEM);
+  }
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    memory_access_fracs[proc_id] =
+        (double)stat_mon_get_count(stat_mon, proc_id, MEM_REQ_COMPLETE_MEM) / (double)total_memory_accesses;
+  }
+  double pred_norm_power;
+  if (POWER_INTF_ON) {
+    // TODO: fix the power prediction for multicore
+    // pred_norm_power = power_pred_norm_power(config->core_cycle_times,
+    // MEMORY_CYCLE_TIME,
+    pred_norm_power =
+        power_pred_norm_power(config->core_cycle_times, RAMULATOR_TCK, memory_access_fracs, pred_slowdowns);
+  } else {
+    ASSERT(0, metric.energy_exp == 0);
+    pred_norm_power = 1.0;
+  }
+  double metric = dvfs_metric(pred_norm_power, pred_gmean_slowdown);
+  DEBUG(0, "Predicted metric for config \%d is %f (norm. power %f, slowdown %f)\n", config_idx, metric,
+        pred_norm_power, pred_gmean_slowdown);
+  config_evals[config_idx] =
+      (Config_Eval){.done = TRUE, .metric = metric, .norm_power = pred_norm_power, .slowdown = pred_gmean_slowdown};
+}
+
+/**************************************************************************************/
+/* choose_config: returns the config with the lowest predicted metric below
+   10.0, or num_configs if there is none. Ties go to the lowest config index,
+   so the choice does not depend on the number of evaluation threads. */
+
+static uns choose_config(void) {
+  for (uns i = 0; i < num_configs; ++i) {
+    config_evals[i].done = FALSE;
+  }
+  if (DVFS_HILL_CLIMB)
+    return hill_climb();
+
+  for (uns i = 0; i < num_configs; ++i) {
+    candidates[i] = i;
+  }
+  num_candidates = num_configs;
+  evaluate_candidates();
+
+  double min_metric = 10.0;
+  uns min_metric_idx = num_configs;
+  for (uns i = 0; i < num_configs; ++i) {
+    if (config_evals[i].metric < min_metric) {
+      min_metric = config_evals[i].metric;
+      min_metric_idx = i;
+    }
+  }
+  return min_metric_idx;
+}
+
+/* hill_climb: greedy search from the current config. Each step evaluates the
+   configs one cycle time away for a single core (or for all cores, without
+   DVFS_INDIVIDUAL_CORES) and moves to the best of them while it improves the
+   metric. Configs from init_configs_from_cmd() are numbered with core 0 as the
+   least significant digit of a base num_core_cycle_times number. */
+
+static uns hill_climb(void) {
+  uns num_dims = DVFS_INDIVIDUAL_CORES ? NUM_CORES : 1;
+  uns best_idx = cur_config - configs;
+  candidates[0] = best_idx;
+  num_candidates = 1;
+  evaluate_candidates();
+  double best_metric = config_evals[best_idx].metric;
+
+  while (TRUE) {
+    num_candidates = 0;
+    uns stride = 1;
+    for (uns dim = 0; dim < num_dims; ++dim, stride *= num_core_cycle_times) {
+      uns digit = best_idx / stride % num_core_cycle_times;
+      if (digit > 0 && !config_evals[best_idx - stride].done)
+        candidates[num_candidates++] = best_idx - stride;
+      if (digit < num_core_cycle_times - 1 && !config_evals[best_idx + stride].done)
+        candidates[num_candidates++] = best_idx + stride;
+    }
+    if (num_candidates == 0)
+      break;
+    evaluate_candidates();
+
+    uns step_idx = num_configs;
+    for (uns i = 0; i < num_candidates; ++i) {
+      uns idx = candidates[i];
+      if (config_evals[idx].metric < best_metric ||
+          (step_idx != num_configs && config_evals[idx].metric == best_metric && idx < step_idx)) {
+        best_metric = config_evals[idx].metric;
+        step_idx = idx;
+      }
+    }
+    if (step_idx == num_configs)
+      break;
+    best_idx = step_idx;
+  }
+
+  return best_metric < 10.0 ? best_idx : num_configs;
+}
+
+/* evaluate_candidates: predicts every config in candidates, spreading them
+   over the per-core evaluation jobs of the cmp_threads pool */
+static void evaluate_candidates(void) {
+  INC_STAT_EVENT(0, DVFS_CONFIGS_EVALUATED, num_candidates);
+  cmp_threads_for_each_core(evaluate_candidates_job);
+}
+
+static void evaluate_candidates_job(uns8 proc_id) {
+  for (uns i = proc_id; i < num_candidates; i += NUM_CORES) {
+    evaluate_config(candidates[i], &proc_infos[proc_id * NUM_CORES]);
+  }
+}
+
 static double dvfs_metric(double power, double delay) {
   double energy = power * delay;
 
@@ -578,12 +704,12 @@ static void compute_stall_time_speedups(double* pred_speedups, Config* config) {
   }
 }
 
-static void compute_bw_sharing_speedups(double* pred_speedups, Config* config) {
+static void compute_bw_sharing_speedups(double* pred_speedups, Config* config, Proc_Info* infos) {
   Counter total_mem_reqs = 0;
   DEBUG(0, "%7s %7s %7s %7s %11s\n", "f%", "stall%", "full%", "perf%", "r");
   /* Compute speedups due to latency */
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    Proc_Info* info = &proc_infos[proc_id];
+    Proc_Info* info = &infos[proc_id];
     Counter core_cycles = stat_mon_get_count(stat_mon, proc_id, NODE_CYCLE);
     Counter stall_cycles = stat_mon_get_count(stat_mon, proc_id, RET_BLOCKED_L1_MISS);
     if (DVFS_BW_SHARING_NO_PREF_STALL) {
@@ -660,7 +786,7 @@ static void compute_bw_sharing_speedups(double* pred_speedups, Config* config) {
     /* compute bandwidth consumption */
     double total_bw = 0.0;
     for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      Proc_Info* info = &proc_infos[proc_id];
+      Proc_Info* info = &infos[proc_id];
       double bw = info->perf * info->r * bus_cycles_per_req;
       total_bw += bw;
     }
@@ -671,7 +797,7 @@ static void compute_bw_sharing_speedups(double* pred_speedups, Config* config) {
       break;
     avg_req_latency += 1.0;
     for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      Proc_Info* info = &proc_infos[proc_id];
+      Proc_Info* info = &infos[proc_id];
       if (info->r == 0.0) {
         info->perf_bw = 1.0e99;  // infinite
       } else {
@@ -683,7 +809,7 @@ static void compute_bw_sharing_speedups(double* pred_speedups, Config* config) {
   DEBUG(0, "Avg req latency: %.0f, avg req bus cycles: %.2f\n", avg_req_latency, bus_cycles_per_req);
   DEBUG(0, "%7s (%7s, %7s) %7s\n", "perf%", "lat", "bw", "bw%");
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    Proc_Info* info = &proc_infos[proc_id];
+    Proc_Info* info = &infos[proc_id];
     pred_speedups[proc_id] = info->perf / info->orig_perf;
     DEBUG(proc_id, "%7.4f (%7.4f, %7.4f) %7.4f\n", info->perf / info->orig_perf, info->perf_lat / info->orig_perf,
           (info->perf_bw == 1.0e99 ? 0 : info->perf_bw) / info->orig_perf,
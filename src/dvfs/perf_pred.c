@@ -601,8 +601,7 @@ void perf_pred_reset_stats(void) {
     Proc_Info* proc = &proc_infos[proc_id];
 
     STAT_EVENT(proc_id, PERF_PRED_NUM_STAT_RESETS);
-    GET_STAT_EVENT(proc_id,
-                   PERF_PRED_RESET_STATS_CYCLE) = chip_cycle_count;  // HACK!
+    SET_STAT_EVENT(proc_id, PERF_PRED_RESET_STATS_CYCLE, chip_cycle_count);  // HACK!
 
     for (int bank = 0; bank < RAMULATOR_BANKS * RAMULATOR_CHANNELS; ++bank) {
       Bank_Info* info = &proc->bank_infos[bank];
@@ -632,7 +631,7 @@ void perf_pred_reset_stats(void) {
 
 void perf_pred_cycle(void) {
   chip_cycle_count = freq_cycle_count(FREQ_DOMAIN_L1);
-  GET_STAT_EVENT(0, PERF_PRED_CYCLE) = chip_cycle_count;
+  SET_STAT_EVENT(0, PERF_PRED_CYCLE, chip_cycle_count);
 }
 
 double perf_pred_slowdown(uns proc_id, Perf_Pred_Mech mech, uns chip_cycle_time, uns memory_cycle_time) {
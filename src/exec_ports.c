@@ -42,12 +42,6 @@
 #include "stat_trace.h"
 #include "table_info.h"
 
-/**************************************************************************************/
-/* Macros */
-
-// Each op_type can have non-simd and simd versions
-#define FU_TYPE_WIDTH (2 * NUM_OP_TYPES)
-
 /**************************************************************************************/
 /* Global Variables */
 
@@ -58,6 +52,8 @@ uns POWER_NUM_ALUS = 0;
 uns POWER_NUM_MULS_AND_DIVS = 0;
 uns POWER_NUM_FPUS = 0;
 
+static Power_FU_Type power_fu_types[FU_TYPE_WIDTH];
+
 /**************************************************************************************/
 /* Local Function Prototypes */
 
@@ -122,16 +118,20 @@ Flag is_alu_type(uns64 fu_type) {
   return (alu_ops & fu_type) != 0;
 }
 
-Power_FU_Type power_get_fu_type(Op_Type op_type, Flag is_simd) {
-  if (is_alu_type(get_fu_type(op_type, is_simd)))
+static Power_FU_Type power_classify_fu_type(uns64 fu_type) {
+  if (is_alu_type(fu_type))
     return POWER_FU_ALU;
-  if (is_mul_or_div_type(get_fu_type(op_type, is_simd)))
+  if (is_mul_or_div_type(fu_type))
     return POWER_FU_MUL_DIV;
-  if (is_fpu_type(get_fu_type(op_type, is_simd)))
+  if (is_fpu_type(fu_type))
     return POWER_FU_FPU;
   return POWER_FU_ALU; /*should never happen*/
 }
 
+Power_FU_Type power_get_fu_type(Op_Type op_type, Flag is_simd) {
+  return power_fu_types[fu_type_index(op_type, is_simd)];
+}
+
 void power_count_fu_types(uns64 fu_type) {
   if (is_fpu_type(fu_type))
     POWER_NUM_FPUS++;
@@ -242,6 +242,7 @@ void init_exec_ports_rs_list(uns proc_id, Reservation_Station* rs, Func_Unit* lo
       idx = idx - 1;                  // built in returns 1 + the true index
       ASSERTM(proc_id, idx < NUM_FUS, "Attempted connections with an FU that does not exist\n");
       rs[i].connected_fus[num_fus] = &local_fus[idx];
+      rs[i].fu_mask |= 1ull << idx;
       // Update the FU to RS mapping
       node->fu_to_rs_map[idx] = i;
       num_fus++;
@@ -259,6 +260,27 @@ void init_exec_ports_rs_list(uns proc_id, Reservation_Station* rs, Func_Unit* lo
   free(rs_connections_copy);
 }
 
+/* Dense per-FU-type tables, so dispatch and scheduling find the RSs and FUs
+   that can execute an op with a lookup instead of testing every FU */
+static void init_exec_ports_fu_type_tables(uns proc_id) {
+  ASSERTM(proc_id, NUM_RS <= 64, "NUM_RS cannot exceed 64 (using a 64 bit int for bitmask)\n");
+  node->fu_type_fu_mask = (uns64*)calloc(FU_TYPE_WIDTH, sizeof(uns64));
+  node->fu_type_rs_mask = (uns64*)calloc(FU_TYPE_WIDTH, sizeof(uns64));
+  for (uns type = 0; type < FU_TYPE_WIDTH; ++type) {
+    uns64 type_bit = 1ull << type;
+    power_fu_types[type] = power_classify_fu_type(type_bit);
+    for (uns32 i = 0; i < NUM_RS; ++i) {
+      Reservation_Station* rs = &node->rs[i];
+      for (uns32 j = 0; j < rs->num_fus; ++j) {
+        if (!(rs->connected_fus[j]->type & type_bit))
+          continue;
+        node->fu_type_fu_mask[type] |= 1ull << rs->connected_fus[j]->fu_id;
+        node->fu_type_rs_mask[type] |= 1ull << i;
+      }
+    }
+  }
+}
+
 // Note: this function must be called *after* init_node_stage and
 // init_exec_stage.
 void init_exec_ports(uns8 proc_id, const char* name) {
@@ -272,8 +294,6 @@ void init_exec_ports(uns8 proc_id, const char* name) {
 
   node->rs = (Reservation_Station*)calloc(NUM_RS, sizeof(Reservation_Station));
   init_exec_ports_rs_list(proc_id, node->rs, exec->fus);
-}
 
-uns64 get_fu_type(Op_Type op_type, Flag is_simd) {
-  return (1ull << op_type) << (is_simd ? NUM_OP_TYPES : 0);
+  init_exec_ports_fu_type_tables(proc_id);
 }
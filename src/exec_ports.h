@@ -31,6 +31,12 @@
 
 #include "table_info.h"
 
+/**************************************************************************************/
+/* Macros */
+
+// Each op_type can have non-simd and simd versions
+#define FU_TYPE_WIDTH (2 * NUM_OP_TYPES)
+
 /**************************************************************************************/
 /* Type Declarations */
 void init_exec_ports(uns8, const char*);
@@ -42,6 +48,15 @@ typedef enum Power_FU_Type_enum {
 } Power_FU_Type;
 
 Power_FU_Type power_get_fu_type(Op_Type op_type, Flag is_simd);
-uns64 get_fu_type(Op_Type op_type, Flag is_simd);
+
+/* Position of the op type's bit in an FU type mask, also the index of the
+   per-type lookup tables */
+static inline uns fu_type_index(Op_Type op_type, Flag is_simd) {
+  return op_type + (is_simd ? NUM_OP_TYPES : 0);
+}
+
+static inline uns64 get_fu_type(Op_Type op_type, Flag is_simd) {
+  return 1ull << fu_type_index(op_type, is_simd);
+}
 
 #endif /* #ifndef __EXEC_PORTS_H__ */
@@ -64,9 +64,9 @@
 /**************************************************************************************/
 /* Global Variables */
 
-Exec_Stage* exec = NULL;
+CORE_LOCAL Exec_Stage* exec = NULL;
 int op_type_delays[NUM_OP_TYPES];
-int exec_off_path;
+CORE_LOCAL int exec_off_path;
 
 /**************************************************************************************/
 /* Prototypes */
@@ -77,6 +77,8 @@ static inline void exec_stage_inc_power_stats(Op* op);
 static inline int exec_stage_check_fu_available(int ii);
 static inline void exec_stage_reject_op(Stage_Data* src_sd, int ii, int event);
 static inline void exec_stage_clear_fu(int ii);
+static inline void exec_stage_fu_update(uns ii);
+static inline void exec_stage_drain_wheel(void);
 
 static inline void exec_stage_dep_wakeup(Op* op);
 static inline void exec_stage_process_op(Op* op);
@@ -125,6 +127,8 @@ void init_exec_stage(uns8 proc_id, const char* name) {
   exec->sd.max_op_count = NUM_FUS;
   exec->sd.ops = (Op**)malloc(sizeof(Op*) * NUM_FUS);
   exec->fus_busy = 0;
+  exec->fus_all = NUM_FUS == 64 ? N_BIT_MASK_64 : N_BIT_MASK(NUM_FUS);
+  exec->wheel_cycle = cycle_count;
 
   reset_exec_stage();
 
@@ -140,6 +144,7 @@ void reset_exec_stage() {
   for (ii = 0; ii < NUM_FUS; ii++) {
     exec->sd.ops[ii] = NULL;
   }
+  exec->fus_occupied = 0;
 }
 
 /**************************************************************************************/
@@ -154,8 +159,10 @@ void recover_exec_stage() {
     if (op && op->op_num > bp_recovery_info->recovery_op_num) {
       exec->sd.ops[ii] = NULL;
       exec->sd.op_count--;
+      exec->fus_occupied &= ~(1ULL << ii);
       fu->avail_cycle = cycle_count + 1;
       fu->idle_cycle = cycle_count + 1;
+      exec_stage_fu_update(ii);
     }
   }
 }
@@ -174,10 +181,9 @@ void debug_exec_stage() {
   }
   DPRINTF("  mem_stalls_cycles:");
   for (ii = 0; ii < NUM_FUS; ii++) {
-    Func_Unit* fu = &exec->fus[ii];
     if (ii % 4 == 0)
       DPRINTF(" ");
-    DPRINTF("%d", fu->held_by_mem);
+    DPRINTF("%d", (int)((exec->fus_held >> ii) & 1));
   }
   DPRINTF("\n");
   print_op_array(GLOBAL_DEBUG_STREAM, exec->sd.ops, NUM_FUS, NUM_FUS);
@@ -199,13 +205,30 @@ void update_exec_stage(Stage_Data* src_sd) {
     STAT_EVENT(exec->proc_id, EXEC_STAGE_OFF_PATH);
   }
 
+  exec_stage_drain_wheel();
+
+  uns64 src_ops = 0;
   for (uns ii = 0; ii < src_sd->max_op_count; ii++) {
-    if (src_sd->ops[ii] && src_sd->ops[ii]->off_path)
+    if (!src_sd->ops[ii])
+      continue;
+    src_ops |= 1ULL << ii;
+    if (src_sd->ops[ii]->off_path)
       exec_off_path = 1;
   }
 
+  /*
+   * Only slots with an op to latch or an op in the FU need work. The rest are starved if
+   * their FU is available, and empty in any case.
+   */
+  uns64 active = src_ops | exec->fus_occupied;
+  uns64 empty = exec->fus_all & ~active;
+  INC_STAT_EVENT(exec->proc_id, FU_STARVED, __builtin_popcountll(empty & ~exec->fus_unavail));
+  INC_STAT_EVENT(exec->proc_id, FUS_EMPTY, __builtin_popcountll(empty));
+  exec->fus_held &= active;
+
   /* phase 1 - success/failure of latching and wake up of dependent ops */
-  for (uns ii = 0; ii < src_sd->max_op_count; ii++) {
+  for (uns64 slots = active; slots; slots &= slots - 1) {
+    uns ii = __builtin_ctzll(slots);
     /* do issue availability checking before latching */
     Op* op = src_sd->ops[ii];
     int ret = exec_stage_check_fu_available(ii);
@@ -263,7 +286,8 @@ void update_exec_stage(Stage_Data* src_sd) {
   }
 
   /* phase 2 - actual latching of instructions and setting of state */
-  for (uns ii = 0; ii < src_sd->max_op_count; ii++) {
+  for (uns64 slots = active; slots; slots &= slots - 1) {
+    uns ii = __builtin_ctzll(slots);
     Func_Unit* fu = &exec->fus[ii];
     Op* op = src_sd->ops[ii];
 
@@ -281,13 +305,13 @@ void update_exec_stage(Stage_Data* src_sd) {
       STAT_EVENT(exec->proc_id, FU_BUSY_0 + ii);
       STAT_EVENT(exec->proc_id, FUS_BUSY_ON_PATH + fop->off_path);
       if (fop->table_info->mem_type) {
-        fu->held_by_mem = TRUE;
+        exec->fus_held |= 1ULL << ii;
         STAT_EVENT(exec->proc_id, FU_BUSY_MEM_STALL);
       }
       continue;
     }
 
-    fu->held_by_mem = FALSE;
+    exec->fus_held &= ~(1ULL << ii);
 
     if (!op) {
       STAT_EVENT(exec->proc_id, FUS_EMPTY);
@@ -306,6 +330,7 @@ void update_exec_stage(Stage_Data* src_sd) {
     exec->fus_busy++;
     exec->sd.ops[ii] = op;
     exec->sd.op_count++;
+    exec->fus_occupied |= 1ULL << ii;
     ASSERT(exec->proc_id, exec->sd.op_count <= exec->sd.max_op_count);
     /*
      * The op's latency is assigned a negative value if it is not pipelined.
@@ -314,6 +339,7 @@ void update_exec_stage(Stage_Data* src_sd) {
     int latency = op->inst_info->latency;
     fu->avail_cycle = cycle_count + (latency < 0 ? -latency : 1);
     fu->idle_cycle = cycle_count + (latency < 0 ? -latency : latency);
+    exec_stage_fu_update(ii);
 
     /* update op status and execution metadata; increment PMU counters */
     exec_stage_process_op(op);
@@ -340,23 +366,12 @@ void update_exec_stage(Stage_Data* src_sd) {
     }
   }
 
-  exec->fus_busy = 0;
-  Counter fu_busy_num = 0;
-  for (uns ii = 0; ii < src_sd->max_op_count; ii++) {
-    Func_Unit* fu = &exec->fus[ii];
-    /*
-     * a functional unit is busy if there's an op in any stage
-     * of its pipeline unless it's stalled by memory
-     */
-    if (fu->idle_cycle > cycle_count) {
-      if (!fu->held_by_mem)
-        exec->fus_busy++;
-    }
-
-    if (fu->avail_cycle > cycle_count) {
-      fu_busy_num++;
-    }
-  }
+  /*
+   * a functional unit is busy if there's an op in any stage
+   * of its pipeline unless it's stalled by memory
+   */
+  exec->fus_busy = __builtin_popcountll(exec->fus_nonidle & ~exec->fus_held);
+  Counter fu_busy_num = __builtin_popcountll(exec->fus_unavail);
 
   topdown_exec_update(exec->proc_id, fu_busy_num);
   memview_fus_busy(exec->proc_id, exec->fus_busy);
@@ -485,9 +500,47 @@ static inline void exec_stage_reject_op(Stage_Data* src_sd, int ii, int event) {
 static inline void exec_stage_clear_fu(int ii) {
   exec->sd.ops[ii] = NULL;
   exec->sd.op_count--;
+  exec->fus_occupied &= ~(1ULL << ii);
   ASSERT(exec->proc_id, exec->sd.op_count >= 0);
 }
 
+/* Brings the FU's unavail/nonidle bits up to date and puts it on the wheel
+   at its next deadline */
+static inline void exec_stage_fu_update(uns ii) {
+  Func_Unit* fu = &exec->fus[ii];
+  uns64 bit = 1ULL << ii;
+  Counter next = MAX_CTR;
+
+  exec->fus_unavail &= ~bit;
+  exec->fus_nonidle &= ~bit;
+  if (fu->avail_cycle > cycle_count) {
+    exec->fus_unavail |= bit;
+    next = fu->avail_cycle;
+  }
+  if (fu->idle_cycle > cycle_count) {
+    exec->fus_nonidle |= bit;
+    next = MIN2(next, fu->idle_cycle);
+  }
+  if (next != MAX_CTR)
+    exec->wheel[next & (EXEC_WHEEL_SIZE - 1)] |= bit;
+}
+
+/* Revisits the FUs due in the cycles since the last drain. Those cycles may
+   have been skipped when the core was idle. */
+static inline void exec_stage_drain_wheel() {
+  Counter first = exec->wheel_cycle + 1;
+  if (cycle_count >= first + EXEC_WHEEL_SIZE)
+    first = cycle_count + 1 - EXEC_WHEEL_SIZE;
+  for (Counter cyc = first; cyc <= cycle_count; cyc++) {
+    uns64* bucket = &exec->wheel[cyc & (EXEC_WHEEL_SIZE - 1)];
+    uns64 fus = *bucket;
+    *bucket = 0;
+    for (; fus; fus &= fus - 1)
+      exec_stage_fu_update(__builtin_ctzll(fus));
+  }
+  exec->wheel_cycle = cycle_count;
+}
+
 static inline int exec_stage_check_fu_available(int ii) {
   /* check whether the functional unit is busy first */
   // if the FU is not available, then nullify node stage entry to make instruction get scheduled again
@@ -571,3 +624,11 @@ static inline void exec_stage_bp_resolve(Op* op) {
   }
 #endif
 }
+
+/**************************************************************************************/
+/* exec_stage_next_event_cycle: the exec stage only has work while ops flow
+ * through it */
+
+Counter exec_stage_next_event_cycle() {
+  return exec->sd.op_count ? cycle_count + 1 : MAX_CTR;
+}
@@ -31,6 +31,13 @@
 
 #include "stage_data.h"
 
+/**************************************************************************************/
+/* Defines */
+
+/* Buckets of the FU timing wheel; a power of two. Deadlines further out than
+   this are rechecked once per turn of the wheel. */
+#define EXEC_WHEEL_SIZE 64
+
 /**************************************************************************************/
 /* Types */
 
@@ -42,7 +49,6 @@ typedef struct Func_Unit_struct {
   uns64 type;          /* bitwise-OR of all OP_<type>_BITs that the fu can execute */
   Counter avail_cycle; /* cycle when the functional unit becomes available */
   Counter idle_cycle;  /* cycle when the FU becomes idle (no op in its pipeline) */
-  Flag held_by_mem;    /* when true, the memory system has determined a stall for  the func unit */
 } Func_Unit;
 
 typedef struct Exec_Stage_struct {
@@ -54,13 +60,25 @@ typedef struct Exec_Stage_struct {
   FILE* fu_util_plot_file;
   uns8 fus_busy; /* for FU util plot and performance prediction, does not include mem stalls */
 
+  /* FU state as bitmasks indexed by fu_id (NUM_FUS <= 64) */
+  uns64 fus_all;      /* every FU */
+  uns64 fus_occupied; /* FUs holding an op in sd.ops */
+  uns64 fus_unavail;  /* FUs with avail_cycle > cycle_count */
+  uns64 fus_nonidle;  /* FUs with idle_cycle > cycle_count */
+  uns64 fus_held;     /* FUs the memory system has stalled */
+
+  /* Timing wheel of FUs by their next avail_cycle or idle_cycle, so that only
+     the FUs whose state changes in a cycle are looked at */
+  uns64 wheel[EXEC_WHEEL_SIZE];
+  Counter wheel_cycle; /* last cycle whose bucket was drained */
+
   Flag is_issue_stall;
 } Exec_Stage;
 
 /**************************************************************************************/
 /* External Variables */
 
-extern Exec_Stage* exec;
+extern CORE_LOCAL Exec_Stage* exec;
 
 /**************************************************************************************/
 /* Prototypes */
@@ -72,6 +90,7 @@ void reset_exec_stage(void);
 void recover_exec_stage(void);
 void debug_exec_stage(void);
 void update_exec_stage(Stage_Data*);
+Counter exec_stage_next_event_cycle(void);
 void finalize_exec_stage(void);
 
 /**************************************************************************************/
@@ -51,7 +51,10 @@
 typedef struct Domain_Info_struct {
   Counter cycles;
   uns cycle_time;
-  uns time_until_next_cycle;
+  Counter next_cycle_time;  // absolute time at which the next cycle starts
+  Flag ready;               // a cycle of this domain starts at cur_time
+  Freq_Tick_Func tick_func;
+  uns tick_arg;
   char* name;
 } Domain_Info;
 
@@ -66,6 +69,16 @@ static Counter cur_time;
 static uns num_domains = 0;
 Domain_Info domains[MAX_FREQ_DOMAINS];
 
+/* The schedule: the domains that are waiting for their next cycle are kept in
+   a min-heap ordered by next cycle time (ties broken by domain id), and the
+   domains whose cycle starts at cur_time are kept in the ready list in
+   increasing domain id order. Advancing time only touches the domains that
+   were ready and the ones that become ready. */
+static Freq_Domain_Id heap[MAX_FREQ_DOMAINS];
+static uns heap_size = 0;
+static Freq_Domain_Id ready_list[MAX_FREQ_DOMAINS];
+static uns num_ready = 0;
+
 Freq_Domain_Id FREQ_DOMAIN_CORES[MAX_NUM_PROCS];
 Freq_Domain_Id FREQ_DOMAIN_L1;
 Freq_Domain_Id FREQ_DOMAIN_MEMORY;
@@ -74,6 +87,10 @@ Freq_Domain_Id FREQ_DOMAIN_MEMORY;
 /* Local prototypes */
 
 static Freq_Domain_Id freq_domain_create(char* name, uns cycle_time);
+static inline Flag heap_before(Freq_Domain_Id a, Freq_Domain_Id b);
+static void heap_push(Freq_Domain_Id id);
+static Freq_Domain_Id heap_pop(void);
+static inline Counter time_until_next_cycle(Freq_Domain_Id id);
 
 /**************************************************************************************/
 /* Function definitions */
@@ -106,16 +123,16 @@ void freq_init(void) {
   for (int proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     sprintf(buf, "CORE_%d", proc_id);
     FREQ_DOMAIN_CORES[proc_id] = freq_domain_create(buf, core_cycle_times[proc_id]);
-    GET_STAT_EVENT(proc_id, PARAM_CORE_CYCLE_TIME) = core_cycle_times[proc_id];
+    SET_STAT_EVENT(proc_id, PARAM_CORE_CYCLE_TIME, core_cycle_times[proc_id]);
   }
   FREQ_DOMAIN_L1 = freq_domain_create("L1", l1_cycle_time);
   // FREQ_DOMAIN_MEMORY = freq_domain_create("MEMORY", MEMORY_CYCLE_TIME);
   FREQ_DOMAIN_MEMORY = freq_domain_create("MEMORY", RAMULATOR_TCK);
   /* These stats simplify data analysis by allowing cycle times to
      be used in get_cmp_data stat formulas */
-  GET_STAT_EVENT(0, PARAM_L1_CYCLE_TIME) = l1_cycle_time;
-  // GET_STAT_EVENT(0, PARAM_MEMORY_CYCLE_TIME) = MEMORY_CYCLE_TIME;
-  GET_STAT_EVENT(0, PARAM_MEMORY_CYCLE_TIME) = RAMULATOR_TCK;
+  SET_STAT_EVENT(0, PARAM_L1_CYCLE_TIME, l1_cycle_time);
+  // SET_STAT_EVENT(0, PARAM_MEMORY_CYCLE_TIME, MEMORY_CYCLE_TIME);
+  SET_STAT_EVENT(0, PARAM_MEMORY_CYCLE_TIME, RAMULATOR_TCK);
 }
 
 static Freq_Domain_Id freq_domain_create(char* name, uns cycle_time) {
@@ -124,36 +141,91 @@ static Freq_Domain_Id freq_domain_create(char* name, uns cycle_time) {
   domains[num_domains].cycles = 0;
   domains[num_domains].cycle_time = cycle_time;
   // every domain's first cycle can start at time zero
-  domains[num_domains].time_until_next_cycle = 0;
+  domains[num_domains].next_cycle_time = cur_time;
+  domains[num_domains].ready = TRUE;
+  domains[num_domains].tick_func = NULL;
+  domains[num_domains].tick_arg = 0;
   domains[num_domains].name = strdup(name);
+  ready_list[num_ready++] = num_domains;
   num_domains++;
   return num_domains - 1;
 }
 
+static inline Flag heap_before(Freq_Domain_Id a, Freq_Domain_Id b) {
+  if (domains[a].next_cycle_time != domains[b].next_cycle_time)
+    return domains[a].next_cycle_time < domains[b].next_cycle_time;
+  return a < b;
+}
+
+static void heap_push(Freq_Domain_Id id) {
+  uns pos = heap_size++;
+  while (pos > 0) {
+    uns parent = (pos - 1) / 2;
+    if (!heap_before(id, heap[parent]))
+      break;
+    heap[pos] = heap[parent];
+    pos = parent;
+  }
+  heap[pos] = id;
+}
+
+static Freq_Domain_Id heap_pop(void) {
+  ASSERT(0, heap_size > 0);
+  Freq_Domain_Id top = heap[0];
+  Freq_Domain_Id last = heap[--heap_size];
+  uns pos = 0;
+  for (;;) {
+    uns child = 2 * pos + 1;
+    if (child >= heap_size)
+      break;
+    if (child + 1 < heap_size && heap_before(heap[child + 1], heap[child]))
+      child++;
+    if (!heap_before(heap[child], last))
+      break;
+    heap[pos] = heap[child];
+    pos = child;
+  }
+  heap[pos] = last;
+  return top;
+}
+
+static inline Counter time_until_next_cycle(Freq_Domain_Id id) {
+  return domains[id].next_cycle_time - cur_time;
+}
+
 Flag freq_is_ready(Freq_Domain_Id id) {
   ASSERT(0, id < num_domains);
-  return domains[id].time_until_next_cycle == 0;
+  return domains[id].ready;
 }
 
-void freq_advance_time(void) {
-  /* Make currently ready domains wait for their next cycles */
-  for (uns i = 0; i < num_domains; i++) {
-    if (domains[i].time_until_next_cycle == 0) {
-      domains[i].time_until_next_cycle = domains[i].cycle_time;
-    }
-  }
+void freq_register_tick(Freq_Domain_Id id, Freq_Tick_Func func, uns arg) {
+  ASSERT(0, id < num_domains);
+  domains[id].tick_func = func;
+  domains[id].tick_arg = arg;
+}
 
-  /* Find the time until the next cycle */
-  uns min_time_until_next_cycle = domains[0].time_until_next_cycle;
+void freq_tick_domains(Freq_Domain_Id first, uns count) {
+  for (uns i = 0; i < num_ready && ready_list[i] < first + count; i++) {
+    Domain_Info* domain = &domains[ready_list[i]];
+    if (ready_list[i] >= first && domain->tick_func)
+      domain->tick_func(domain->tick_arg);
+  }
+}
 
-  for (uns i = 1; i < num_domains; i++) {
-    if (domains[i].time_until_next_cycle < min_time_until_next_cycle) {
-      min_time_until_next_cycle = domains[i].time_until_next_cycle;
-    }
+void freq_advance_time(void) {
+  /* Make currently ready domains wait for their next cycles (a cycle time
+     changed during the cycle applies from here on) */
+  for (uns i = 0; i < num_ready; i++) {
+    Freq_Domain_Id id = ready_list[i];
+    domains[id].ready = FALSE;
+    domains[id].next_cycle_time = cur_time + domains[id].cycle_time;
+    heap_push(id);
   }
+  num_ready = 0;
 
-  /* Time until the next cycle is the time delta */
-  uns time_delta = min_time_until_next_cycle;
+  /* The earliest next cycle time is the new time */
+  ASSERT(0, heap_size > 0);
+  Counter time_delta = time_until_next_cycle(heap[0]);
   ASSERT(0, time_delta > 0);
 
   /* Update externally visible state */
@@ -162,24 +234,34 @@ void freq_advance_time(void) {
   INC_STAT_EVENT_ALL(POWER_TIME, time_delta);
   DEBUG(0, "Advancing time to %lld fs\n", cur_time);
 
-  /* Update every domain's info using the time delta */
-  for (uns i = 0; i < num_domains; i++) {
-    domains[i].time_until_next_cycle -= time_delta;
-    if (domains[i].time_until_next_cycle == 0) {
-      /* This domain is now ready. Update its cycle count. */
-      domains[i].cycles++;
-      DEBUG(0, "Domain %s ready to simulate cycle %lld\n", domains[i].name, domains[i].cycles);
-    }
+  /* Pop every domain whose cycle starts now. The heap yields them in domain
+     id order, which keeps the ready list sorted. */
+  while (heap_size > 0 && domains[heap[0]].next_cycle_time == cur_time) {
+    Freq_Domain_Id id = heap_pop();
+    /* This domain is now ready. Update its cycle count. */
+    domains[id].ready = TRUE;
+    domains[id].cycles++;
+    ready_list[num_ready++] = id;
+    DEBUG(0, "Domain %s ready to simulate cycle %lld\n", domains[id].name, domains[id].cycles);
   }
 }
 
 void freq_reset_cycle_counts(void) {
+  heap_size = 0;
+  num_ready = 0;
   for (uns i = 0; i < num_domains; i++) {
     domains[i].cycles = 0;
-    domains[i].time_until_next_cycle = 0;
+    domains[i].next_cycle_time = cur_time;
+    domains[i].ready = TRUE;
+    ready_list[num_ready++] = i;
   }
 }
 
+void freq_set_time(Counter new_time) {
+  ASSERT(0, new_time >= cur_time);
+  cur_time = new_time;
+}
+
 Counter freq_cycle_count(Freq_Domain_Id id) {
   ASSERT(0, id < num_domains);
   return domains[id].cycles;
@@ -200,7 +282,7 @@ void freq_set_cycle_time(Freq_Domain_Id id, uns cycle_time) {
   ASSERT(0, id < num_domains);
   ASSERT(0, cycle_time > 0);
   domains[id].cycle_time = cycle_time;
-  // Not changing time_until_next_cycle for simplicity (the
+  // Not rescheduling the next cycle for simplicity (the
   // frequency change will take effect after the current cycle
   // finishes).
 }
@@ -218,19 +300,19 @@ Counter freq_convert(Freq_Domain_Id src, Counter src_cycle_count, Freq_Domain_Id
 Counter freq_convert_future_cycle(Freq_Domain_Id src, Counter src_cycle_count, Freq_Domain_Id dst) {
   ASSERT(0, src_cycle_count >= domains[src].cycles);
   Counter remaining_src_cycles = src_cycle_count - domains[src].cycles;
-  Flag src_cycle_ready_now = (domains[src].time_until_next_cycle == 0);
+  Flag src_cycle_ready_now = domains[src].ready;
   Counter last_src_cycle_time =
-      cur_time + domains[src].time_until_next_cycle - (src_cycle_ready_now ? 0 : domains[src].cycle_time);
+      domains[src].next_cycle_time - (src_cycle_ready_now ? 0 : domains[src].cycle_time);
   Counter time_after_last_src_cycle = remaining_src_cycles * domains[src].cycle_time;
   Counter future_time = last_src_cycle_time + time_after_last_src_cycle;
 
-  Flag dst_cycle_ready_now = (domains[dst].time_until_next_cycle == 0);
-  if (future_time <= cur_time + domains[dst].time_until_next_cycle) {
+  Flag dst_cycle_ready_now = domains[dst].ready;
+  if (future_time <= domains[dst].next_cycle_time) {
     // either this cycle or next cycle
     return domains[dst].cycles + !dst_cycle_ready_now;
   }
 
-  Counter time_remaining_after_immediate_dst_cycle = future_time - cur_time - domains[dst].time_until_next_cycle;
+  Counter time_remaining_after_immediate_dst_cycle = future_time - domains[dst].next_cycle_time;
 
   // make sure we don't add an extra cycle if the future time is a cycle
   // boundary for both domains
@@ -40,6 +40,10 @@ extern "C" {
 
 typedef unsigned int Freq_Domain_Id;
 
+/* Called once per cycle of the domain it is registered to, with the argument
+   given at registration */
+typedef void (*Freq_Tick_Func)(uns arg);
+
 /**************************************************************************************/
 /* External variables */
 
@@ -57,6 +61,14 @@ void freq_init(void);
    cycle starting at this exact time)? */
 Flag freq_is_ready(Freq_Domain_Id id);
 
+/* Registers the tick function of a frequency domain (replaces any
+   previously registered one) */
+void freq_register_tick(Freq_Domain_Id id, Freq_Tick_Func func, uns arg);
+
+/* Calls the tick functions of the domains in [first, first + count)
+   that are ready at this time, in increasing domain id order */
+void freq_tick_domains(Freq_Domain_Id first, uns count);
+
 /* Advance time to the next earliest time a frequency domain will be
    ready to be simulated */
 void freq_advance_time(void);
@@ -64,6 +76,10 @@ void freq_advance_time(void);
 /* Reset cycle time of each domain to zero but keep the time value. */
 void freq_reset_cycle_counts(void);
 
+/* Moves the time forward to that of a restored checkpoint. Call
+   freq_reset_cycle_counts afterwards. */
+void freq_set_time(Counter new_time);
+
 /* Returns the cycle count in the specified frequency domain */
 Counter freq_cycle_count(Freq_Domain_Id id);
 
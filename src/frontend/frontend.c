@@ -32,16 +32,20 @@
 #include "globals/global_defs.h"
 #include "globals/global_vars.h"
 
+#include "debug/host_prof.h"
+
 #include "core.param.h"
 #include "general.param.h"
 
 #include "bp/bp.h"
 
+#include "cmp_threads.h"
 #include "frontend_intf.h"
 #include "icache_stage.h"
 #include "op.h"
 #include "pin_exec_driven_fe.h"
 #include "pin_trace_fe.h"
+#include "replay_fe.h"
 #include "sim.h"
 #include "statistics.h"
 #include "thread.h"
@@ -72,6 +76,10 @@ void frontend_init() {
       trace_init();
       break;
     }
+    case FE_REPLAY: {
+      replay_init(NUM_CORES);
+      break;
+    }
 #ifdef ENABLE_PT_MEMTRACE
     case FE_PT:
     case FE_MEMTRACE: {
@@ -95,6 +103,10 @@ void frontend_done(Flag* retired_exit) {
       trace_done();
       break;
     }
+    case FE_REPLAY: {
+      replay_done();
+      break;
+    }
 #ifdef ENABLE_PT_MEMTRACE
     case FE_PT:
     case FE_MEMTRACE: {
@@ -109,24 +121,43 @@ void frontend_done(Flag* retired_exit) {
 }
 
 Addr frontend_next_fetch_addr(uns proc_id) {
+  UNCORE_LOCK_SCOPE();
   return convert_to_cmp_addr(proc_id, frontend->next_fetch_addr(proc_id));
 }
 
 Flag frontend_can_fetch_op(uns proc_id) {
+  UNCORE_LOCK_SCOPE();
   return frontend->can_fetch_op(proc_id);
 }
 
 void frontend_fetch_op(uns proc_id, Op* op) {
-  frontend->fetch_op(proc_id, op);
+  UNCORE_LOCK_SCOPE();
+  HOST_PROF_SCOPE(proc_id, HOST_PROF_FRONTEND_FETCH, frontend->fetch_op(proc_id, op));
   collect_op_stats(op);
 }
 
+uns frontend_ready_ops(uns proc_id) {
+  UNCORE_LOCK_SCOPE();
+  return frontend->ready_ops(proc_id);
+}
+
+uns frontend_fetch_ops(uns proc_id, Op** ops, uns max) {
+  UNCORE_LOCK_SCOPE();
+  uns count;
+  HOST_PROF_SCOPE(proc_id, HOST_PROF_FRONTEND_FETCH, count = frontend->fetch_ops(proc_id, ops, max));
+  for (uns ii = 0; ii < count; ii++)
+    collect_op_stats(ops[ii]);
+  return count;
+}
+
 void frontend_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr) {
+  UNCORE_LOCK_SCOPE();
   DEBUG(proc_id, "Redirect after op_num %lld to 0x%08llx\n", op_count[proc_id] - 1, fetch_addr);
   frontend->redirect(proc_id, inst_uid, fetch_addr);
 }
 
 void frontend_recover(uns proc_id, uns64 inst_uid) {
+  UNCORE_LOCK_SCOPE();
   DEBUG(proc_id, "Recover after inst_uid %lld\n", inst_uid);
 
   /* Recover to correct path */
@@ -134,6 +165,7 @@ void frontend_recover(uns proc_id, uns64 inst_uid) {
 }
 
 void frontend_retire(uns proc_id, uns64 inst_uid) {
+  UNCORE_LOCK_SCOPE();
   DEBUG(proc_id, "Retiring inst_uid %lld\n", inst_uid);
 
   /* Recover to correct path */
@@ -141,6 +173,26 @@ void frontend_retire(uns proc_id, uns64 inst_uid) {
   DEBUG(proc_id, "Retiring inst_uid %lld end\n", inst_uid);
 }
 
+uns64 frontend_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited) {
+  UNCORE_LOCK_SCOPE();
+  DEBUG(proc_id, "Skipping %lld instructions\n", num_insts);
+  *exited = FALSE;
+  uns64 skipped = frontend->skip(proc_id, num_insts, warm_func, exited);
+  DEBUG(proc_id, "Skipped %lld instructions\n", skipped);
+  return skipped;
+}
+
+void frontend_fill_op_buffers() {
+  switch (FRONTEND) {
+    case FE_PIN_EXEC_DRIVEN: {
+      pin_exec_driven_fill_op_buffers();
+      break;
+    }
+    default:
+      break;
+  }
+}
+
 static void collect_op_stats(Op* op) {
   if (!op->off_path) {
     STAT_EVENT(op->proc_id, ST_OP_ONPATH);
@@ -30,6 +30,8 @@
 
 #include "globals/global_types.h"
 
+#include "frontend/frontend_intf.h"
+
 /*************************************************************/
 /* External frontend interface */
 
@@ -50,6 +52,13 @@ Flag frontend_can_fetch_op(uns proc_id);
 /* Get an op from the frontend */
 void frontend_fetch_op(uns proc_id, struct Op_struct* op);
 
+/* How many ops frontend_fetch_ops can return now (0 if none) */
+uns frontend_ready_ops(uns proc_id);
+
+/* Get up to max ops from the frontend, at most one instruction's worth.
+   Returns the number fetched. */
+uns frontend_fetch_ops(uns proc_id, struct Op_struct** ops, uns max);
+
 /* Redirect the front end (down the wrong path) */
 void frontend_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr);
 
@@ -59,6 +68,15 @@ void frontend_recover(uns proc_id, uns64 inst_uid);
 /* Let the frontend know that this instruction is retired) */
 void frontend_retire(uns proc_id, uns64 inst_uid);
 
+/* Advance num_insts instructions without generating ops, warming with
+   warm_func (may be NULL). Returns the number skipped and sets *exited if the
+   last of them ended the program. */
+uns64 frontend_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited);
+
+/* Refill the empty op buffers of all cores at once before the cores are
+   cycled, for frontends that can overlap their requests */
+void frontend_fill_op_buffers(void);
+
 #ifdef ENABLE_PT_MEMTRACE
 /* Trace post-processing to extract basic block vectors */
 void frontend_extract_basic_block_vectors(void);
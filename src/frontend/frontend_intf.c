@@ -29,12 +29,16 @@
 #include "frontend/frontend_intf.h"
 
 #include "globals/global_defs.h"
+#include "globals/utils.h"
 
 #include "general.param.h"
 
+#include "pin/pin_lib/uop_generator.h"
+
 /* Include headers of all the implementations here */
 #include "frontend/pin_exec_driven_fe.h"
 #include "frontend/pin_trace_fe.h"
+#include "frontend/replay_fe.h"
 
 #ifdef ENABLE_PT_MEMTRACE
 #include "frontend/pt_memtrace/trace_fe.h"
@@ -46,9 +50,12 @@ Frontend_Impl frontend_table[] = {
    prefix##_next_fetch_addr,            \
    prefix##_can_fetch_op,               \
    prefix##_fetch_op,                   \
+   prefix##_ready_ops,                  \
+   prefix##_fetch_ops,                  \
    prefix##_redirect,                   \
    prefix##_recover,                    \
-   prefix##_retire},
+   prefix##_retire,                     \
+   prefix##_skip},
 #include "frontend/frontend_table.def"
 #undef FRONTEND_IMPL
 };
@@ -58,3 +65,33 @@ Frontend_Impl* frontend = NULL;
 void frontend_intf_init() {
   frontend = &frontend_table[FRONTEND];
 }
+
+void frontend_skip_warm(uns proc_id, const ctype_pin_inst* pi, Frontend_Skip_Warm_Func warm_func) {
+  Frontend_Skip_Inst inst;
+  inst.addr = convert_to_cmp_addr(proc_id, pi->instruction_addr);
+  inst.num_ld = pi->num_ld;
+  inst.num_st = pi->num_st;
+  for (uns ii = 0; ii < inst.num_ld; ii++)
+    inst.ld_vaddr[ii] = convert_to_cmp_addr(proc_id, pi->ld_vaddr[ii]);
+  for (uns ii = 0; ii < inst.num_st; ii++)
+    inst.st_vaddr[ii] = convert_to_cmp_addr(proc_id, pi->st_vaddr[ii]);
+  warm_func(proc_id, &inst);
+}
+
+uns frontend_uops_ready(uns proc_id, Flag can_fetch) {
+  uns left = uop_generator_uops_left(proc_id);
+  if (left)
+    return left;
+  return can_fetch ? 1 : 0;
+}
+
+uns frontend_uops_fetch(uns proc_id, struct Op_struct** ops, uns max, Flag (*can_fetch_op)(uns),
+                        void (*fetch_op)(uns, struct Op_struct*)) {
+  if (!max || !can_fetch_op(proc_id))
+    return 0;
+  uns count = 0;
+  do {
+    fetch_op(proc_id, ops[count++]);
+  } while (count < max && !uop_generator_get_eom(proc_id));
+  return count;
+}
@@ -30,11 +30,32 @@
 
 #include "globals/global_types.h"
 
+#include "ctype_pin_inst.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /*************************************************************/
 /* Forward Declarations */
 
 struct Op_struct;
 
+/*************************************************************/
+/* Skipping */
+
+/* What a skip shows of each instruction it passes over (cmp addresses) */
+typedef struct Frontend_Skip_Inst_struct {
+  Addr addr;
+  uns num_ld;
+  uns num_st;
+  Addr ld_vaddr[MAX_LD_NUM];
+  Addr st_vaddr[MAX_ST_NUM];
+} Frontend_Skip_Inst;
+
+/* Functional warming of skipped instructions */
+typedef void (*Frontend_Skip_Warm_Func)(uns proc_id, const Frontend_Skip_Inst* inst);
+
 /*************************************************************/
 /* External frontend interface */
 
@@ -56,6 +77,15 @@ typedef struct Frontend_Intf_struct {
   /* Get an op from the frontend */
   void (*fetch_op)(uns proc_id, struct Op_struct* op);
 
+  /* Number of ops that can be fetched right now: the rest of the current
+     instruction, or 1 between instructions (the uop count of the next one is
+     only known once it is decoded). 0 exactly when can_fetch_op is FALSE. */
+  uns (*ready_ops)(uns proc_id);
+
+  /* Fill up to max ops, stopping after the last op of an instruction. Returns
+     the number of ops fetched, 0 if none can be. */
+  uns (*fetch_ops)(uns proc_id, struct Op_struct** ops, uns max);
+
   /* Redirect the front end (down the wrong path) */
   void (*redirect)(uns proc_id, uns64 inst_uid, Addr fetch_addr);
 
@@ -64,6 +94,13 @@ typedef struct Frontend_Intf_struct {
 
   /* Let the frontend know that this instruction is retired) */
   void (*retire)(uns proc_id, uns64 inst_uid);
+
+  /* Advance num_insts instructions on the right path without generating
+     their ops, passing each to warm_func (may be NULL). Must be called
+     between instructions, with nothing in flight. Returns the number of
+     instructions skipped and sets *exited if the last of them ended the
+     program. */
+  uns64 (*skip)(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited);
 } Frontend_Impl;
 
 typedef enum Frontend_Id_enum {
@@ -79,6 +116,21 @@ extern Frontend_Impl frontend_table[];
 /* Initialize the above frontend pointer */
 void frontend_intf_init(void);
 
+/* Passes a skipped instruction to warm_func, for the implementations */
+void frontend_skip_warm(uns proc_id, const ctype_pin_inst* pi, Frontend_Skip_Warm_Func warm_func);
+
+/* ready_ops of a frontend built on the uop generator, for the implementations */
+uns frontend_uops_ready(uns proc_id, Flag can_fetch);
+
+/* fetch_ops of a frontend built on the uop generator, from its per-op
+   can_fetch_op and fetch_op, for the implementations */
+uns frontend_uops_fetch(uns proc_id, struct Op_struct** ops, uns max, Flag (*can_fetch_op)(uns),
+                        void (*fetch_op)(uns, struct Op_struct*));
+
+#ifdef __cplusplus
+}
+#endif
+
 /*************************************************************/
 
 #endif /*  __FRONTEND_INTF_H__*/
@@ -44,8 +44,11 @@ extern "C" {
 #include <time.h>
 
 #include "frontend/pin_exec_driven_fe.h"
+#include "frontend/replay_fe.h"
 #include "pin/pin_lib/message_queue_interface_lib.h"
+#include "pin/pin_lib/op_codec.h"
 #include "pin/pin_lib/pin_scarab_common_lib.h"
+#include "pin/pin_lib/shared_mem_channel.h"
 #include "pin/pin_lib/uop_generator.h"
 
 #include "decoupled_frontend.h"
@@ -53,12 +56,90 @@ extern "C" {
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_PIN_EXEC_DRIVEN, ##args)
 
 Server* server;
+std::vector<SharedMemChannel*> shm_channels;  // NULL: client is on TCP
+std::vector<OpDecoder*> op_decoders;          // NULL: TCP buffers are raw ops
 std::vector<ScarabOpBuffer_type> cached_cop_buffers;
-
+/* A FE_FETCH_OP sent ahead (PIN_EXEC_DRIVEN_FETCH_AHEAD) whose buffer has not
+   been read yet, and whether a redirect/recover sent after it made that buffer
+   stale. PIN answers commands in order, so the stale buffer is the next one. */
+std::vector<Flag> fetch_in_flight;
+std::vector<Flag> fetch_stale;
+/* Whether the last op buffer received lets the next FE_FETCH_OP be sent before
+   the core asks for it (see can_fetch_ahead) */
+std::vector<Flag> fetch_ready;
+
+void attach_shared_mem(uns proc_id);
+void request_compact_ops(uns proc_id);
+void receive_compact_ops(uns proc_id, ScarabOpBuffer_type* buffer);
+void send_cmd_to_pin(uns proc_id, const Scarab_To_Pin_Msg& msg);
+void receive_op_buffer(uns proc_id);
 void get_next_op_buffer_from_pin(uns proc_id);
+Flag can_fetch_ahead(const ScarabOpBuffer_type& buffer);
 void update_op_buffer_if_empty(uns proc_id);
 void invalidate_op_buffer(uns proc_id);
 
+/**********************************************************
+ * Transport
+ **********************************************************/
+void attach_shared_mem(uns proc_id) {
+  Scarab_To_Pin_Msg msg;
+  msg.type = FE_SHM_ATTACH;
+  msg.inst_uid = getpid();
+  msg.inst_addr = proc_id;
+
+  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);
+  uint32_t op_capacity = server->receive<uint32_t>(proc_id);
+  if (op_capacity == 0) {
+    printf("PIN client %u could not create a shared memory channel, using the socket\n", proc_id);
+    return;
+  }
+  shm_channels[proc_id] = new SharedMemChannel();
+  bool attached = shm_channels[proc_id]->attach(SharedMemChannel::path(getpid(), proc_id));
+  ASSERTM(proc_id, attached, "Could not attach to the shared memory channel of PIN client %u\n", proc_id);
+}
+
+void request_compact_ops(uns proc_id) {
+  Scarab_To_Pin_Msg msg;
+  msg.type = FE_COMPACT_OPS;
+  msg.inst_uid = 0;
+  msg.inst_addr = 0;
+
+  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);
+  if (server->receive<uint32_t>(proc_id))
+    op_decoders[proc_id] = new OpDecoder();
+}
+
+void receive_compact_ops(uns proc_id, ScarabOpBuffer_type* buffer) {
+  std::vector<uint8_t> bytes;
+  server->receive_into(proc_id, &bytes);  // blocking
+  buffer->clear();
+  for (size_t pos = 0; pos < bytes.size();) {
+    compressed_op cop;
+    size_t used = op_decoders[proc_id]->decode(bytes.data() + pos, bytes.size() - pos, &cop);
+    ASSERTM(proc_id, used, "Malformed compact op buffer from PIN client %u\n", proc_id);
+    buffer->push_back(cop);
+    pos += used;
+  }
+}
+
+void send_cmd_to_pin(uns proc_id, const Scarab_To_Pin_Msg& msg) {
+  if (shm_channels[proc_id])
+    shm_channels[proc_id]->send_cmd(msg);
+  else
+    server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);  // blocking
+}
+
+void receive_op_buffer(uns proc_id) {
+  if (shm_channels[proc_id])
+    shm_channels[proc_id]->receive_ops(&cached_cop_buffers[proc_id]);             // blocking
+  else if (op_decoders[proc_id])
+    receive_compact_ops(proc_id, &cached_cop_buffers[proc_id]);
+  else
+    server->receive_into(proc_id, &cached_cop_buffers[proc_id]);                  // blocking
+  fetch_in_flight[proc_id] = FALSE;
+  fetch_ready[proc_id] = can_fetch_ahead(cached_cop_buffers[proc_id]);
+}
+
 /**********************************************************
  * Cached Op interface
  **********************************************************/
@@ -68,8 +149,35 @@ void get_next_op_buffer_from_pin(uns proc_id) {
   msg.inst_addr = 0;
   msg.inst_uid = 0;
 
-  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);                       // blocking
-  cached_cop_buffers[proc_id] = server->receive<ScarabOpBuffer_type>(proc_id);  // blocking
+  if (fetch_in_flight[proc_id] && fetch_stale[proc_id]) {
+    DEBUG(proc_id, "Dropping op buffer fetched before the last redirect/recover\n");
+    shm_channels[proc_id]->receive_ops(&cached_cop_buffers[proc_id]);  // blocking
+    cached_cop_buffers[proc_id].clear();
+    fetch_in_flight[proc_id] = FALSE;
+    fetch_stale[proc_id] = FALSE;
+  }
+
+  if (!fetch_in_flight[proc_id])
+    send_cmd_to_pin(proc_id, msg);
+  receive_op_buffer(proc_id);
+
+  // Let PIN produce the next buffer while this one is simulated. The socket
+  // does not frame messages, so this needs the shared memory channel.
+  if (PIN_EXEC_DRIVEN_FETCH_AHEAD && shm_channels[proc_id] && fetch_ready[proc_id]) {
+    send_cmd_to_pin(proc_id, msg);
+    fetch_in_flight[proc_id] = TRUE;
+  }
+}
+
+/* PIN finishes a syscall (or an excepting op, sent like one) on the first
+   FE_FETCH_OP after it, and expects everything before it to be retired by
+   then, so no request may be sent ahead of such a buffer. */
+Flag can_fetch_ahead(const ScarabOpBuffer_type& buffer) {
+  for (const compressed_op& cop : buffer) {
+    if (cop.cf_type == CF_SYS || cop.is_ifetch_barrier || cop.exit || is_sentinal_op((compressed_op*)&cop))
+      return FALSE;
+  }
+  return TRUE;
 }
 
 void update_op_buffer_if_empty(uns proc_id) {
@@ -81,19 +189,54 @@ void update_op_buffer_if_empty(uns proc_id) {
 
 inline void invalidate_op_buffer(uns proc_id) {
   cached_cop_buffers[proc_id].clear();
+  fetch_stale[proc_id] = fetch_in_flight[proc_id];
 }
 
 Addr get_fetch_address(uns proc_id, compressed_op* cop) {
   return convert_to_cmp_addr(proc_id, cop->instruction_addr);
 }
 
+void pin_exec_driven_check_roi_markers(uns proc_id, const compressed_op* cop) {
+  if (cop->scarab_marker_roi_begin == true) {
+    ASSERT(proc_id, !roi_dump_began);
+    // reset stats
+    printf("Reached roi dump begin marker, reset stats\n");
+    reset_stats(TRUE);
+    roi_dump_began = TRUE;
+  } else if (cop->scarab_marker_roi_end == true) {
+    ASSERT(proc_id, roi_dump_began);
+    // dump stats
+    printf("Reached roi dump end marker, dump stats between\n");
+    dump_stats(proc_id, TRUE, 0, NUM_GLOBAL_STATS);
+    roi_dump_began = FALSE;
+    roi_dump_ID++;
+  }
+}
+
 /**********************************************************
  * PIN Exec Driven Interface Functions
  **********************************************************/
 void pin_exec_driven_init(uns numProcs) {
   server = new Server(PIN_EXEC_DRIVEN_FE_SOCKET, numProcs);
+  shm_channels.assign(numProcs, NULL);
+  if (PIN_EXEC_DRIVEN_FE_SHM) {
+    for (uns proc_id = 0; proc_id < numProcs; proc_id++)
+      attach_shared_mem(proc_id);
+  }
+  op_decoders.assign(numProcs, NULL);
+  if (PIN_EXEC_DRIVEN_COMPACT_OPS) {
+    for (uns proc_id = 0; proc_id < numProcs; proc_id++) {
+      if (!shm_channels[proc_id])
+        request_compact_ops(proc_id);
+    }
+  }
   cached_cop_buffers.resize(numProcs);
+  fetch_in_flight.assign(numProcs, FALSE);
+  fetch_stale.assign(numProcs, FALSE);
+  fetch_ready.assign(numProcs, TRUE);
   uop_generator_init(numProcs);
+  if (PIN_EXEC_DRIVEN_RECORD_FILE)
+    replay_record_init(numProcs);
 }
 
 void pin_exec_driven_done(Flag* retired_exit) {
@@ -109,7 +252,48 @@ void pin_exec_driven_done(Flag* retired_exit) {
   for (uint32_t i = 0; i < server->getNumClients(); ++i) {
     server->wait_for_client_to_close(i);
   }
+  for (uint32_t i = 0; i < shm_channels.size(); ++i) {
+    delete shm_channels[i];
+  }
+  for (uint32_t i = 0; i < op_decoders.size(); ++i) {
+    delete op_decoders[i];
+  }
   delete server;
+  if (PIN_EXEC_DRIVEN_RECORD_FILE)
+    replay_record_done();
+}
+
+/* A request on the socket is answered before anything else is sent to that
+   client, since the socket does not frame messages. A request on a shared
+   memory channel is left in flight like a fetch ahead, and the core takes its
+   buffer (or drops it after a redirect/recover) when it needs one. */
+void pin_exec_driven_fill_op_buffers() {
+  if (!PIN_EXEC_DRIVEN_OVERLAP_FETCH || server->getNumClients() < 2)
+    return;
+
+  Scarab_To_Pin_Msg msg;
+  msg.type = FE_FETCH_OP;
+  msg.inst_addr = 0;
+  msg.inst_uid = 0;
+
+  std::vector<uint32_t> waiting;
+  for (uns proc_id = 0; proc_id < server->getNumClients(); proc_id++) {
+    if (!cached_cop_buffers[proc_id].empty() || fetch_in_flight[proc_id] || !fetch_ready[proc_id])
+      continue;
+    DEBUG(proc_id, "Overlapped FETCH_OP to PIN\n");
+    send_cmd_to_pin(proc_id, msg);
+    fetch_in_flight[proc_id] = TRUE;
+    if (!shm_channels[proc_id])
+      waiting.push_back(proc_id);
+  }
+
+  while (!waiting.empty()) {
+    std::vector<uint32_t> ready = server->poll_clients(waiting);
+    for (uint32_t proc_id : ready) {
+      receive_op_buffer(proc_id);
+      waiting.erase(std::find(waiting.begin(), waiting.end(), proc_id));
+    }
+  }
 }
 
 Flag pin_exec_driven_can_fetch_op(uns proc_id) {
@@ -134,28 +318,24 @@ void pin_exec_driven_fetch_op(uns proc_id, Op* op) {
 
   Flag eom = uop_generator_extract_op(proc_id, op, &cached_cop_buffers[proc_id].front());
   if (eom) {
-    if (!decoupled_fe_is_off_path()) {
-      if (cached_cop_buffers[proc_id].front().scarab_marker_roi_begin == true) {
-        ASSERT(proc_id, !roi_dump_began);
-        // reset stats
-        printf("Reached roi dump begin marker, reset stats\n");
-        reset_stats(TRUE);
-        roi_dump_began = TRUE;
-      } else if (cached_cop_buffers[proc_id].front().scarab_marker_roi_end == true) {
-        ASSERT(proc_id, roi_dump_began);
-        // dump stats
-        printf("Reached roi dump end marker, dump stats between\n");
-        dump_stats(proc_id, TRUE, global_stat_array[proc_id], NUM_GLOBAL_STATS);
-        roi_dump_began = FALSE;
-        roi_dump_ID++;
-      }
-    }
+    if (!decoupled_fe_is_off_path())
+      pin_exec_driven_check_roi_markers(proc_id, &cached_cop_buffers[proc_id].front());
+    if (PIN_EXEC_DRIVEN_RECORD_FILE)
+      replay_record_op(proc_id, &cached_cop_buffers[proc_id].front(), decoupled_fe_is_off_path());
     cached_cop_buffers[proc_id].pop_front();
   }
 
   DEBUG(proc_id, "Fetch Op end: %llx (%llu)\n", op->inst_info->addr, op->inst_uid);
 }
 
+uns pin_exec_driven_ready_ops(uns proc_id) {
+  return frontend_uops_ready(proc_id, pin_exec_driven_can_fetch_op(proc_id));
+}
+
+uns pin_exec_driven_fetch_ops(uns proc_id, Op** ops, uns max) {
+  return frontend_uops_fetch(proc_id, ops, max, pin_exec_driven_can_fetch_op, pin_exec_driven_fetch_op);
+}
+
 void pin_exec_driven_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr) {
   DEBUG(proc_id, "Fetch Redirect: %llx (%llu)\n", fetch_addr, inst_uid);
   /* PIN will asynchronously redirect, Scarab does not need to wait for PIN to
@@ -165,8 +345,10 @@ void pin_exec_driven_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr) {
   msg.inst_addr = convert_to_cmp_addr(0, fetch_addr);  // removing proc_id
   msg.inst_uid = inst_uid;
   uop_generator_recover(proc_id);
+  if (PIN_EXEC_DRIVEN_RECORD_FILE)
+    replay_record_redirect(proc_id, inst_uid, msg.inst_addr);
 
-  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);  // blocking
+  send_cmd_to_pin(proc_id, msg);
   invalidate_op_buffer(proc_id);
   DEBUG(proc_id, "Fetch Redirect end: %llx\n", fetch_addr);
 }
@@ -180,8 +362,10 @@ void pin_exec_driven_recover(uns proc_id, uns64 inst_uid) {
   msg.inst_addr = 0;
   msg.inst_uid = inst_uid;
   uop_generator_recover(proc_id);
+  if (PIN_EXEC_DRIVEN_RECORD_FILE)
+    replay_record_recover(proc_id, inst_uid);
 
-  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);  // blocking
+  send_cmd_to_pin(proc_id, msg);
   invalidate_op_buffer(proc_id);
   DEBUG(proc_id, "Fetch Recover end: %llu\n", inst_uid);
 }
@@ -193,6 +377,37 @@ void pin_exec_driven_retire(uns proc_id, uns64 inst_uid) {
   msg.inst_addr = inst_uid == (uns64)-1;
   msg.inst_uid = inst_uid;
 
-  server->send(proc_id, (Message<Scarab_To_Pin_Msg>)msg);  // blocking
+  send_cmd_to_pin(proc_id, msg);
   DEBUG(proc_id, "Fetch Retire end: %llu\n", inst_uid);
 }
+
+/* PIN has already executed the instructions in the op buffers, so they are
+   consumed without uop generation. PIN retires everything up to a uid, so one
+   retire per buffer suffices; it must precede the FE_FETCH_OP of the next
+   buffer, which finishes a pending syscall. */
+uns64 pin_exec_driven_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited) {
+  DEBUG(proc_id, "Skip begin: %llu\n", num_insts);
+  ASSERT(proc_id, uop_generator_get_bom(proc_id) && !decoupled_fe_is_off_path());
+  uns64 skipped = 0;
+  while (skipped < num_insts && !*exited) {
+    update_op_buffer_if_empty(proc_id);
+    ScarabOpBuffer_type& buffer = cached_cop_buffers[proc_id];
+    if (is_sentinal_op(&buffer.front())) {
+      *exited = TRUE;
+      break;
+    }
+    const compressed_op cop = buffer.front();
+    buffer.pop_front();
+    if (warm_func)
+      frontend_skip_warm(proc_id, &cop, warm_func);
+    pin_exec_driven_check_roi_markers(proc_id, &cop);
+    if (PIN_EXEC_DRIVEN_RECORD_FILE)
+      replay_record_op(proc_id, &cop, FALSE);
+    skipped++;
+    *exited = cop.exit;
+    if (buffer.empty() || *exited || skipped == num_insts)
+      pin_exec_driven_retire(proc_id, cop.inst_uid);
+  }
+  DEBUG(proc_id, "Skip end: %llu\n", skipped);
+  return skipped;
+}
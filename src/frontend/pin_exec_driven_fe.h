@@ -27,6 +27,9 @@
  ***************************************************************************************/
 #include "globals/global_types.h"
 
+#include "frontend/frontend_intf.h"
+
+#include "ctype_pin_inst.h"
 #include "op_info.h"
 #include "stdint.h"
 
@@ -54,6 +57,12 @@ Addr pin_exec_driven_next_fetch_addr(uns proc_id);
 /* Get an op from pin_exec_driven */
 void pin_exec_driven_fetch_op(uns proc_id, struct Op_struct* op);
 
+/* How many ops pin_exec_driven_fetch_ops can return now */
+uns pin_exec_driven_ready_ops(uns proc_id);
+
+/* Get up to max ops, at most the rest of one instruction */
+uns pin_exec_driven_fetch_ops(uns proc_id, struct Op_struct** ops, uns max);
+
 /* Redirect pin_exec_driven (down the wrong path) */
 void pin_exec_driven_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr);
 
@@ -63,6 +72,16 @@ void pin_exec_driven_recover(uns proc_id, uns64 inst_uid);
 /* Retire instruction at unique op id */
 void pin_exec_driven_retire(uns proc_id, uns64 inst_uid);
 
+/* Skip instructions without generating their ops */
+uns64 pin_exec_driven_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited);
+
+/* Resets or dumps the stats at the ROI markers of an on-path instruction */
+void pin_exec_driven_check_roi_markers(uns proc_id, const compressed_op* cop);
+
+/* Send FE_FETCH_OP to every core with an empty op buffer, then gather the
+   replies, so the PIN processes produce them concurrently */
+void pin_exec_driven_fill_op_buffers(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,235 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/pin_trace_block.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Reading and writing block-compressed ctype_pin_inst containers.
+ *                Kept free of simulator state so that the trace converter in
+ *                utils/pin_trace_blocks can link it on its own.
+ ***************************************************************************************/
+
+#include "frontend/pin_trace_block.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <zlib.h>
+
+#include "pin/pin_lib/op_codec.h"
+
+struct Pin_Trace_Block_Writer_struct {
+  FILE* file;
+  int level;
+  Pin_Trace_Block_Encoding encoding;
+  uint32_t block_insts;
+  uint64_t num_insts;
+  uint64_t offset;
+  std::vector<ctype_pin_inst> pending;
+  std::vector<uint8_t> encoded;
+  std::vector<Bytef> comp;
+  std::vector<Pin_Trace_Block_Entry> index;
+};
+
+static const char* const pin_trace_block_magics[] = {PIN_TRACE_BLOCK_MAGIC, PIN_TRACE_BLOCK_DELTA_MAGIC,
+                                                     PIN_TRACE_BLOCK_BB_MAGIC};
+
+/* Encoding of a container magic, or -1 */
+static int pin_trace_block_encoding(const char* magic) {
+  for (int ii = 0; ii < (int)(sizeof(pin_trace_block_magics) / sizeof(pin_trace_block_magics[0])); ii++) {
+    if (!memcmp(magic, pin_trace_block_magics[ii], PIN_TRACE_BLOCK_MAGIC_SIZE))
+      return ii;
+  }
+  return -1;
+}
+
+int pin_trace_block_is_container(const char* magic) {
+  return pin_trace_block_encoding(magic) >= 0;
+}
+
+const Pin_Trace_Block_Header* pin_trace_block_header(const void* data, size_t size) {
+  const Pin_Trace_Block_Header* header = (const Pin_Trace_Block_Header*)data;
+  if (size < sizeof(Pin_Trace_Block_Header) || !pin_trace_block_is_container(header->magic))
+    return NULL;
+  if (header->record_size != sizeof(ctype_pin_inst) || !header->block_insts)
+    return NULL;
+  if (header->num_blocks != (header->num_insts + header->block_insts - 1) / header->block_insts)
+    return NULL;
+  if (header->index_offset > size ||
+      (size - header->index_offset) / sizeof(Pin_Trace_Block_Entry) < header->num_blocks)
+    return NULL;
+
+  const Pin_Trace_Block_Entry* index = pin_trace_block_index(header);
+  for (uint64_t ii = 0; ii < header->num_blocks; ii++) {
+    const Pin_Trace_Block_Entry* entry = &index[ii];
+    uint64_t expected = MIN2((uint64_t)header->block_insts, header->num_insts - ii * header->block_insts);
+    if (entry->first_inst != ii * header->block_insts || entry->num_insts != expected ||
+        entry->offset > header->index_offset || entry->comp_size > header->index_offset - entry->offset)
+      return NULL;
+  }
+  return header;
+}
+
+const Pin_Trace_Block_Entry* pin_trace_block_index(const Pin_Trace_Block_Header* header) {
+  return (const Pin_Trace_Block_Entry*)((const char*)header + header->index_offset);
+}
+
+int pin_trace_block_decompress(const Pin_Trace_Block_Header* header, const Pin_Trace_Block_Entry* entry,
+                               ctype_pin_inst* out) {
+  const Bytef* src = (const Bytef*)header + entry->offset;
+  int encoding = pin_trace_block_encoding(header->magic);
+  if (encoding == PIN_TRACE_BLOCK_RAW) {
+    uLongf out_size = (uLongf)entry->num_insts * sizeof(ctype_pin_inst);
+    uLongf expected = out_size;
+    if (uncompress((Bytef*)out, &out_size, src, entry->comp_size) != Z_OK || out_size != expected)
+      return -1;
+    return 0;
+  }
+
+  std::vector<uint8_t> encoded((size_t)entry->num_insts * OP_CODEC_MAX_ENCODED_SIZE);
+  uLongf encoded_size = encoded.size();
+  if (uncompress(encoded.data(), &encoded_size, src, entry->comp_size) != Z_OK)
+    return -1;
+  size_t pos = 0;
+  if (encoding == PIN_TRACE_BLOCK_BB) {
+    BbDecoder decoder;
+    for (size_t ii = 0, num; ii < entry->num_insts; ii += num) {
+      size_t used = decoder.decode(encoded.data() + pos, encoded_size - pos, &out[ii], entry->num_insts - ii, &num);
+      if (!used)
+        return -1;
+      pos += used;
+    }
+  } else {
+    OpDecoder decoder;
+    for (uint32_t ii = 0; ii < entry->num_insts; ii++) {
+      size_t used = decoder.decode(encoded.data() + pos, encoded_size - pos, &out[ii]);
+      if (!used)
+        return -1;
+      pos += used;
+    }
+  }
+  return pos == encoded_size ? 0 : -1;
+}
+
+static int pin_trace_block_writer_flush(Pin_Trace_Block_Writer* writer) {
+  if (writer->pending.empty())
+    return 0;
+
+  const Bytef* src = (const Bytef*)writer->pending.data();
+  uLong src_size = writer->pending.size() * sizeof(ctype_pin_inst);
+  if (writer->encoding != PIN_TRACE_BLOCK_RAW) {
+    writer->encoded.clear();
+    if (writer->encoding == PIN_TRACE_BLOCK_BB) {
+      BbEncoder encoder;
+      encoder.encode(writer->pending.data(), writer->pending.size(), &writer->encoded);
+    } else {
+      OpEncoder encoder;
+      for (const ctype_pin_inst& inst : writer->pending)
+        encoder.encode(inst, &writer->encoded);
+    }
+    src = writer->encoded.data();
+    src_size = writer->encoded.size();
+  }
+  uLongf comp_size = compressBound(src_size);
+  writer->comp.resize(comp_size);
+  if (compress2(writer->comp.data(), &comp_size, src, src_size, writer->level) != Z_OK)
+    return -1;
+  if (fwrite(writer->comp.data(), 1, comp_size, writer->file) != comp_size)
+    return -1;
+
+  Pin_Trace_Block_Entry entry;
+  entry.offset = writer->offset;
+  entry.first_inst = writer->num_insts;
+  entry.comp_size = comp_size;
+  entry.num_insts = writer->pending.size();
+  writer->index.push_back(entry);
+
+  writer->offset += comp_size;
+  writer->num_insts += writer->pending.size();
+  writer->pending.clear();
+  return 0;
+}
+
+Pin_Trace_Block_Writer* pin_trace_block_writer_open(const char* path, uint32_t block_insts, int level,
+                                                    Pin_Trace_Block_Encoding encoding) {
+  if (!block_insts)
+    return NULL;
+  FILE* file = fopen(path, "wb");
+  if (!file)
+    return NULL;
+
+  /* the header is rewritten with the final counts on close */
+  Pin_Trace_Block_Header header;
+  memset(&header, 0, sizeof(header));
+  if (fwrite(&header, sizeof(header), 1, file) != 1) {
+    fclose(file);
+    return NULL;
+  }
+
+  Pin_Trace_Block_Writer* writer = new Pin_Trace_Block_Writer_struct();
+  writer->file = file;
+  writer->level = level;
+  writer->encoding = encoding;
+  writer->block_insts = block_insts;
+  writer->num_insts = 0;
+  writer->offset = sizeof(header);
+  writer->pending.reserve(block_insts);
+  return writer;
+}
+
+int pin_trace_block_writer_add(Pin_Trace_Block_Writer* writer, const ctype_pin_inst* insts, size_t num) {
+  while (num) {
+    size_t take = MIN2(num, (size_t)(writer->block_insts - writer->pending.size()));
+    writer->pending.insert(writer->pending.end(), insts, insts + take);
+    insts += take;
+    num -= take;
+    if (writer->pending.size() == writer->block_insts && pin_trace_block_writer_flush(writer))
+      return -1;
+  }
+  return 0;
+}
+
+int pin_trace_block_writer_close(Pin_Trace_Block_Writer* writer) {
+  int error = pin_trace_block_writer_flush(writer);
+
+  Pin_Trace_Block_Header header;
+  memcpy(header.magic, pin_trace_block_magics[writer->encoding], PIN_TRACE_BLOCK_MAGIC_SIZE);
+  header.record_size = sizeof(ctype_pin_inst);
+  header.block_insts = writer->block_insts;
+  header.num_insts = writer->num_insts;
+  header.num_blocks = writer->index.size();
+  header.index_offset = writer->offset;
+
+  if (!error && !writer->index.empty() &&
+      fwrite(writer->index.data(), sizeof(Pin_Trace_Block_Entry), writer->index.size(), writer->file) !=
+          writer->index.size())
+    error = -1;
+  if (!error && (fseek(writer->file, 0, SEEK_SET) || fwrite(&header, sizeof(header), 1, writer->file) != 1))
+    error = -1;
+  if (fclose(writer->file))
+    error = -1;
+
+  delete writer;
+  return error;
+}
@@ -0,0 +1,114 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/pin_trace_block.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Seekable block-compressed container for ctype_pin_inst traces.
+ *
+ *  A container is a header, a sequence of independently deflate-compressed
+ *  blocks of block_insts instructions each (only the last block may be
+ *  shorter), and an index with one entry per block at index_offset. Block b
+ *  holds instructions [b * block_insts, b * block_insts + num_insts), so the
+ *  block of any instruction is found without touching the blocks before it.
+ *  All fields are stored in host byte order.
+ *
+ *  In a PIN_TRACE_BLOCK_DELTA_MAGIC container the instructions of a block are
+ *  encoded with pin/pin_lib/op_codec.h before they are deflated, one record
+ *  per instruction (OpEncoder). A PIN_TRACE_BLOCK_BB_MAGIC container holds one
+ *  record per dynamic basic block instead (BbEncoder), which for a block seen
+ *  before is little more than its id, memory address deltas and branch
+ *  outcome. Every block starts with a fresh encoder, so blocks still decode
+ *  independently.
+ ***************************************************************************************/
+
+#ifndef __PIN_TRACE_BLOCK_H__
+#define __PIN_TRACE_BLOCK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "ctype_pin_inst.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define PIN_TRACE_BLOCK_MAGIC "SCRBTRC1"
+#define PIN_TRACE_BLOCK_DELTA_MAGIC "SCRBTRC2"
+#define PIN_TRACE_BLOCK_BB_MAGIC "SCRBTRC3"
+#define PIN_TRACE_BLOCK_MAGIC_SIZE 8
+#define PIN_TRACE_BLOCK_DEFAULT_INSTS (1 << 16)
+
+typedef struct Pin_Trace_Block_Header_struct {
+  char magic[PIN_TRACE_BLOCK_MAGIC_SIZE];
+  uint32_t record_size; /* sizeof(ctype_pin_inst) of the converter */
+  uint32_t block_insts; /* instructions per block */
+  uint64_t num_insts;
+  uint64_t num_blocks;
+  uint64_t index_offset; /* file offset of the Pin_Trace_Block_Entry array */
+} __attribute__((packed)) Pin_Trace_Block_Header;
+
+typedef struct Pin_Trace_Block_Entry_struct {
+  uint64_t offset;     /* file offset of the compressed block */
+  uint64_t first_inst; /* trace index of the first instruction in the block */
+  uint32_t comp_size;  /* compressed bytes */
+  uint32_t num_insts;  /* instructions in the block */
+} __attribute__((packed)) Pin_Trace_Block_Entry;
+
+typedef enum Pin_Trace_Block_Encoding_enum {
+  PIN_TRACE_BLOCK_RAW,      /* PIN_TRACE_BLOCK_MAGIC */
+  PIN_TRACE_BLOCK_OP_DELTA, /* PIN_TRACE_BLOCK_DELTA_MAGIC */
+  PIN_TRACE_BLOCK_BB,       /* PIN_TRACE_BLOCK_BB_MAGIC */
+} Pin_Trace_Block_Encoding;
+
+typedef struct Pin_Trace_Block_Writer_struct Pin_Trace_Block_Writer;
+
+/* Nonzero if magic (PIN_TRACE_BLOCK_MAGIC_SIZE bytes) starts a container */
+int pin_trace_block_is_container(const char* magic);
+
+/* Checks the header and index of a container mapped at data. Returns the
+   header, or NULL if data is not a well-formed container for this build's
+   ctype_pin_inst. */
+const Pin_Trace_Block_Header* pin_trace_block_header(const void* data, size_t size);
+
+/* Index of a container that passed pin_trace_block_header() */
+const Pin_Trace_Block_Entry* pin_trace_block_index(const Pin_Trace_Block_Header* header);
+
+/* Decompresses the block described by entry into out, which must have room for
+   entry->num_insts instructions. Returns 0 on success. */
+int pin_trace_block_decompress(const Pin_Trace_Block_Header* header, const Pin_Trace_Block_Entry* entry,
+                               ctype_pin_inst* out);
+
+/* Writes a container to path. level is the zlib compression level (-1 for the
+   default). The writer returns NULL or nonzero on I/O or compression
+   errors. */
+Pin_Trace_Block_Writer* pin_trace_block_writer_open(const char* path, uint32_t block_insts, int level,
+                                                    Pin_Trace_Block_Encoding encoding);
+int pin_trace_block_writer_add(Pin_Trace_Block_Writer* writer, const ctype_pin_inst* insts, size_t num);
+int pin_trace_block_writer_close(Pin_Trace_Block_Writer* writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
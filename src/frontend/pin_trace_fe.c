@@ -99,6 +99,10 @@ void trace_init() {
 
 void trace_setup(uns proc_id) {
   pin_trace_open(proc_id, trace_files[proc_id]);
+  if (FAST_FORWARD && FAST_FORWARD_TRACE_INS) {
+    Flag seeked = pin_trace_seek(proc_id, FAST_FORWARD_TRACE_INS);
+    ASSERTM(proc_id, seeked, "Cannot fast forward past the end of trace %s\n", trace_files[proc_id]);
+  }
   pin_trace_read(proc_id, &next_pi[proc_id]);
 }
 
@@ -148,6 +152,14 @@ void trace_fetch_op(uns proc_id, Op* op) {
   }
 }
 
+uns trace_ready_ops(uns proc_id) {
+  return frontend_uops_ready(proc_id, trace_can_fetch_op(proc_id));
+}
+
+uns trace_fetch_ops(uns proc_id, Op** ops, uns max) {
+  return frontend_uops_fetch(proc_id, ops, max, trace_can_fetch_op, trace_fetch_op);
+}
+
 void trace_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr) {
   FATAL_ERROR(proc_id,
               "Trace frontend does not support wrong path. Turn off "
@@ -164,3 +176,23 @@ void trace_retire(uns proc_id, uns64 inst_uid) {
   // Trace frontend does not need to communicate to PIN which instruction are
   // retired.
 }
+
+uns64 trace_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited) {
+  ASSERT(proc_id, uop_generator_get_bom(proc_id));
+  uns64 skipped = 0;
+  while (skipped < num_insts && !trace_read_done[proc_id]) {
+    /* next_pi is the first instruction not yet fetched */
+    if (warm_func)
+      frontend_skip_warm(proc_id, &next_pi[proc_id], warm_func);
+    skipped++;
+    /* without warming, jump over all but the new next_pi through the index */
+    if (!warm_func && skipped < num_insts)
+      skipped += pin_trace_skip(proc_id, num_insts - skipped);
+    if (!pin_trace_read(proc_id, &next_pi[proc_id])) {
+      trace_read_done[proc_id] = TRUE;
+      reached_exit[proc_id] = TRUE;
+      *exited = TRUE;
+    }
+  }
+  return skipped;
+}
@@ -31,6 +31,8 @@
 
 #include "globals/global_types.h"
 
+#include "frontend/frontend_intf.h"
+
 /**************************************************************************************/
 /* Forward Declarations */
 
@@ -47,9 +49,12 @@ void trace_init(void);
 Addr trace_next_fetch_addr(uns proc_id);
 Flag trace_can_fetch_op(uns proc_id);
 void trace_fetch_op(uns proc_id, Op* op);
+uns trace_ready_ops(uns proc_id);
+uns trace_fetch_ops(uns proc_id, Op** ops, uns max);
 void trace_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr);
 void trace_recover(uns proc_id, uns64 inst_uid);
 void trace_retire(uns proc_id, uns64 inst_uid);
+uns64 trace_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited);
 
 /* For restarting of traces */
 void trace_done(void);
@@ -27,49 +27,426 @@
  ****************************************************************************************/
 #include "frontend/pin_trace_read.h"
 
+#include <algorithm>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <inttypes.h>
 #include <iostream>
+#include <mutex>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
+#include "frontend/pin_trace_block.h"
 #include "isa/isa.h"
 
 extern "C" {
 #include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
 #include "globals/utils.h"
+
+#include "general.param.h"
 }
 
 #define CMP_ADDR_MASK (((uint64_t) - 1) << 58)
 
-FILE** pin_file;
+/* Hands out the instructions of a mapped block-compressed container (see
+   pin_trace_block.h). Helper threads decompress the blocks following the
+   current one into a ring of buffers, so the reader only waits when it
+   outruns them. */
+class Pin_Trace_Blocks {
+ public:
+  Pin_Trace_Blocks(const Pin_Trace_Block_Header* header, uns num_threads);
+  ~Pin_Trace_Blocks();
+
+  const ctype_pin_inst* next();
+  void seek(uint64_t inst);
+  uint64_t skip(uint64_t num_insts);
+  uint64_t tell() const;
+  uint64_t num_insts() const { return header->num_insts; }
+
+ private:
+  struct Slot {
+    int64_t block; /* block held or being decoded, -1 if free */
+    bool ready;
+    std::vector<ctype_pin_inst> insts;
+  };
+
+  const Pin_Trace_Block_Header* header;
+  const Pin_Trace_Block_Entry* index;
+  std::vector<Slot> slots;
+  std::vector<std::thread> threads;
+  std::mutex mutex;
+  std::condition_variable work_cv;  /* a block became decodable, or stop/seek */
+  std::condition_variable ready_cv; /* a block finished decoding */
+  uint64_t cur_block;               /* block the reader is in */
+  uint64_t next_block;              /* next block for the helpers */
+  uns busy;                         /* helpers currently decoding */
+  bool paused;
+  bool stop;
+  const Slot* cur_slot;
+  uint32_t cur_idx;
+
+  void worker();
+  void decode(uint64_t block, Slot* slot);
+  const Slot* acquire(uint64_t block);
+  void release(uint64_t block);
+};
+
+Pin_Trace_Blocks::Pin_Trace_Blocks(const Pin_Trace_Block_Header* header, uns num_threads)
+    : header(header),
+      index(pin_trace_block_index(header)),
+      slots(num_threads ? 2 * num_threads : 1),
+      cur_block(0),
+      next_block(0),
+      busy(0),
+      paused(false),
+      stop(false),
+      cur_slot(NULL),
+      cur_idx(0) {
+  for (Slot& slot : slots) {
+    slot.block = -1;
+    slot.ready = false;
+    slot.insts.resize(header->block_insts);
+  }
+  for (uns ii = 0; ii < num_threads; ii++)
+    threads.emplace_back(&Pin_Trace_Blocks::worker, this);
+}
+
+Pin_Trace_Blocks::~Pin_Trace_Blocks() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stop = true;
+  }
+  work_cv.notify_all();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+void Pin_Trace_Blocks::decode(uint64_t block, Slot* slot) {
+  int error = pin_trace_block_decompress(header, &index[block], slot->insts.data());
+  ASSERTM(0, !error, "Corrupt block %llu in block-compressed pin trace\n", (unsigned long long)block);
+}
+
+/* The helpers decode blocks in order, at most slots.size() blocks past the
+   reader; block b lives in slot b % slots.size(), which the reader has
+   released by the time b enters the window. */
+void Pin_Trace_Blocks::worker() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    work_cv.wait(lock, [this] {
+      return stop || (!paused && next_block < header->num_blocks && next_block < cur_block + slots.size());
+    });
+    if (stop)
+      return;
+    uint64_t block = next_block++;
+    Slot* slot = &slots[block % slots.size()];
+    slot->block = block;
+    slot->ready = false;
+    busy++;
+    lock.unlock();
+    decode(block, slot);
+    lock.lock();
+    slot->ready = true;
+    busy--;
+    ready_cv.notify_all();
+  }
+}
+
+const Pin_Trace_Blocks::Slot* Pin_Trace_Blocks::acquire(uint64_t block) {
+  Slot* slot = &slots[block % slots.size()];
+  if (threads.empty()) {
+    if (slot->block != (int64_t)block) {
+      decode(block, slot);
+      slot->block = block;
+      slot->ready = true;
+    }
+    return slot;
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  ready_cv.wait(lock, [slot, block] { return slot->block == (int64_t)block && slot->ready; });
+  return slot;
+}
+
+void Pin_Trace_Blocks::release(uint64_t block) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (!threads.empty()) {
+    Slot* slot = &slots[block % slots.size()];
+    slot->block = -1;
+    slot->ready = false;
+  }
+  cur_block = block + 1;
+  work_cv.notify_all();
+}
+
+const ctype_pin_inst* Pin_Trace_Blocks::next() {
+  if (!cur_slot || cur_idx == index[cur_block].num_insts) {
+    if (cur_slot) {
+      release(cur_block);
+      cur_slot = NULL;
+    }
+    if (cur_block >= header->num_blocks)
+      return NULL;
+    cur_slot = acquire(cur_block);
+    cur_idx = 0;
+  }
+  return &cur_slot->insts[cur_idx++];
+}
+
+/* Trace index of the instruction next() returns */
+uint64_t Pin_Trace_Blocks::tell() const {
+  if (cur_slot)
+    return index[cur_block].first_inst + cur_idx;
+  return cur_block < header->num_blocks ? index[cur_block].first_inst : header->num_insts;
+}
+
+/* Advances up to num_insts instructions, staying in the current block without
+   a seek when possible. Returns the number of instructions skipped. */
+uint64_t Pin_Trace_Blocks::skip(uint64_t num_insts) {
+  uint64_t pos = tell();
+  uint64_t skipped = std::min<uint64_t>(num_insts, header->num_insts - pos);
+  if (cur_slot && cur_idx + skipped <= index[cur_block].num_insts)
+    cur_idx += skipped;
+  else
+    seek(pos + skipped);
+  return skipped;
+}
+
+/* Repositions the reader in O(1) blocks: the helpers are drained, the ring is
+   emptied and decoding restarts at the block holding inst. */
+void Pin_Trace_Blocks::seek(uint64_t inst) {
+  ASSERT(0, inst <= header->num_insts);
+  uint64_t block = inst / header->block_insts;
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    paused = true;
+    ready_cv.wait(lock, [this] { return busy == 0; });
+    for (Slot& slot : slots) {
+      slot.block = -1;
+      slot.ready = false;
+    }
+    cur_block = block;
+    next_block = block;
+    paused = false;
+  }
+  work_cv.notify_all();
+
+  cur_slot = NULL;
+  if (block < header->num_blocks) {
+    cur_slot = acquire(block);
+    cur_idx = inst % header->block_insts;
+  }
+}
+
+/* A trace is either piped through bzip2 (file != NULL) or mapped read-only
+   (map != NULL). A mapped trace is either raw ctype_pin_inst records, handed
+   out in place, or a block-compressed container (blocks != NULL). */
+typedef struct Pin_Trace_Struct {
+  FILE* file;
+  const char* map;
+  size_t map_size;
+  size_t pos;           /* byte offset of the next instruction in map */
+  size_t readahead_pos; /* prefetch has been issued up to here */
+  int fd;
+  Pin_Trace_Blocks* blocks;
+  ctype_pin_inst buf; /* staging for pin_trace_next on the pipe path */
+  char* name;         /* reopened to seek backward on the pipe path */
+  uint64_t pipe_pos;  /* instructions read from the pipe so far */
+} Pin_Trace;
+
+static Pin_Trace* pin_traces;
+
+static Flag pin_trace_map(Pin_Trace* trace, const char* name);
+static void pin_trace_readahead(Pin_Trace* trace);
+static void pin_trace_popen(Pin_Trace* trace);
 
 // static Reg_Id convert_pin_reg_to_scarab_reg(uns pin_reg);
 void pin_trace_file_pointer_init(unsigned char num_cores) {
-  pin_file = (FILE**)malloc(num_cores * sizeof(FILE*));
+  pin_traces = (Pin_Trace*)calloc(num_cores, sizeof(Pin_Trace));
+  for (uns ii = 0; ii < num_cores; ii++)
+    pin_traces[ii].fd = -1;
+}
+
+/* Maps name if it is a block-compressed container, or (with PIN_TRACE_MMAP) an
+   uncompressed trace: not bzip2 and a whole number of ctype_pin_inst records.
+   Returns FALSE (with nothing left open) otherwise. */
+static Flag pin_trace_map(Pin_Trace* trace, const char* name) {
+  int fd = open(name, O_RDONLY);
+  if (fd < 0)
+    return FALSE;
+
+  struct stat st;
+  char magic[PIN_TRACE_BLOCK_MAGIC_SIZE];
+  if (fstat(fd, &st) != 0 || st.st_size <= 0 || pread(fd, magic, sizeof(magic), 0) != sizeof(magic)) {
+    close(fd);
+    return FALSE;
+  }
+  Flag container = pin_trace_block_is_container(magic);
+  if (!container && (!PIN_TRACE_MMAP || st.st_size % sizeof(ctype_pin_inst) != 0 || !memcmp(magic, "BZh", 3))) {
+    close(fd);
+    return FALSE;
+  }
+
+  void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED) {
+    close(fd);
+    return FALSE;
+  }
+  madvise(map, st.st_size, MADV_SEQUENTIAL);
+
+  trace->map = (const char*)map;
+  trace->map_size = st.st_size;
+  trace->pos = 0;
+  trace->readahead_pos = 0;
+  trace->fd = fd;
+  if (container) {
+    const Pin_Trace_Block_Header* header = pin_trace_block_header(map, st.st_size);
+    ASSERTM(0, header, "Malformed block-compressed pin trace: %s\n", name);
+    trace->blocks = new Pin_Trace_Blocks(header, PIN_TRACE_BLOCK_THREADS);
+  } else {
+    pin_trace_readahead(trace);
+  }
+  return TRUE;
+}
+
+/* Keeps PIN_TRACE_READAHEAD bytes ahead of the cursor in flight, re-arming
+   once the cursor has consumed half of the window. */
+static void pin_trace_readahead(Pin_Trace* trace) {
+  size_t window = PIN_TRACE_READAHEAD;
+  if (!window || trace->readahead_pos >= trace->map_size || trace->pos + window / 2 < trace->readahead_pos)
+    return;
+  size_t end = MIN2(trace->pos + window, trace->map_size);
+#ifdef __linux__
+  readahead(trace->fd, trace->readahead_pos, end - trace->readahead_pos);
+#else
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t base = trace->readahead_pos & ~(page - 1);
+  madvise((void*)(trace->map + base), end - base, MADV_WILLNEED);
+#endif
+  trace->readahead_pos = end;
 }
 
 void pin_trace_open(unsigned char proc_id, const char* name) {
-  char cmdline[1024];
-  sprintf(cmdline, "bzip2 -dc %s", name);
-  pin_file[proc_id] = popen(cmdline, "r");
+  Pin_Trace* trace = &pin_traces[proc_id];
+  if (pin_trace_map(trace, name)) {
+    printf("pin trace mapped for core %u: %s (%llu instructions%s)\n", proc_id, name,
+           trace->blocks ? (unsigned long long)trace->blocks->num_insts()
+                         : (unsigned long long)(trace->map_size / sizeof(ctype_pin_inst)),
+           trace->blocks ? ", block-compressed" : "");
+    return;
+  }
+
+  trace->name = strdup(name);
+  pin_trace_popen(trace);
   printf("pin trace should be opened now for core %u: %s \n", proc_id, name);
-  if (!pin_file[proc_id]) {
-    printf("Cannot open trace file: %s\n", name);
+}
+
+/* Starts decompressing the trace from its first instruction */
+static void pin_trace_popen(Pin_Trace* trace) {
+  char cmdline[1024];
+  sprintf(cmdline, "bzip2 -dc %s", trace->name);
+  trace->file = popen(cmdline, "r");
+  trace->pipe_pos = 0;
+  if (!trace->file) {
+    printf("Cannot open trace file: %s\n", trace->name);
     exit(1);
   }
 }
 
 void pin_trace_close(unsigned char proc_id) {
-  pclose(pin_file[proc_id]);
+  Pin_Trace* trace = &pin_traces[proc_id];
+  if (trace->map) {
+    delete trace->blocks;
+    trace->blocks = NULL;
+    munmap((void*)trace->map, trace->map_size);
+    close(trace->fd);
+    trace->map = NULL;
+    trace->fd = -1;
+  } else if (trace->file) {
+    pclose(trace->file);
+    trace->file = NULL;
+    free(trace->name);
+    trace->name = NULL;
+  }
 }
 
-int pin_trace_read(unsigned char proc_id, ctype_pin_inst* pi) {
-  int read_size;
+const ctype_pin_inst* pin_trace_next(unsigned char proc_id) {
+  Pin_Trace* trace = &pin_traces[proc_id];
+  if (trace->blocks)
+    return trace->blocks->next();
+  if (trace->map) {
+    if (trace->pos >= trace->map_size)
+      return NULL;
+    const ctype_pin_inst* pi = (const ctype_pin_inst*)(trace->map + trace->pos);
+    trace->pos += sizeof(ctype_pin_inst);
+    pin_trace_readahead(trace);
+    return pi;
+  }
 
-  read_size = fread(pi, sizeof(ctype_pin_inst), 1, pin_file[proc_id]);
-  if (read_size != 1) {
+  if (fread(&trace->buf, sizeof(ctype_pin_inst), 1, trace->file) != 1)
+    return NULL;
+  trace->pipe_pos++;
+  return &trace->buf;
+}
+
+int pin_trace_read(unsigned char proc_id, ctype_pin_inst* pi) {
+  const ctype_pin_inst* next = pin_trace_next(proc_id);
+  if (!next) {
     return 0;
   }
+  memcpy(pi, next, sizeof(ctype_pin_inst));
   return 1;
 }
+
+int pin_trace_seek(unsigned char proc_id, uint64_t inst) {
+  Pin_Trace* trace = &pin_traces[proc_id];
+  if (trace->blocks) {
+    if (inst > trace->blocks->num_insts())
+      return 0;
+    trace->blocks->seek(inst);
+    return 1;
+  }
+  if (trace->map) {
+    if (inst > trace->map_size / sizeof(ctype_pin_inst))
+      return 0;
+    trace->pos = inst * sizeof(ctype_pin_inst);
+    trace->readahead_pos = trace->pos;
+    pin_trace_readahead(trace);
+    return 1;
+  }
+  /* a bzip2 stream can only be skipped forward by decompressing it, so going
+     back restarts it */
+  if (inst < trace->pipe_pos) {
+    pclose(trace->file);
+    pin_trace_popen(trace);
+  }
+  while (trace->pipe_pos < inst)
+    if (!pin_trace_next(proc_id))
+      return 0;
+  return 1;
+}
+
+uint64_t pin_trace_skip(unsigned char proc_id, uint64_t num_insts) {
+  Pin_Trace* trace = &pin_traces[proc_id];
+  if (trace->blocks)
+    return trace->blocks->skip(num_insts);
+  if (trace->map) {
+    uint64_t left = (trace->map_size - trace->pos) / sizeof(ctype_pin_inst);
+    uint64_t skipped = MIN2(num_insts, left);
+    trace->pos += skipped * sizeof(ctype_pin_inst);
+    trace->readahead_pos = MAX2(trace->readahead_pos, trace->pos);
+    pin_trace_readahead(trace);
+    return skipped;
+  }
+  uint64_t skipped = 0;
+  while (skipped < num_insts && pin_trace_next(proc_id))
+    skipped++;
+  return skipped;
+}
@@ -37,6 +37,17 @@ extern "C" {
 
 void pin_trace_file_pointer_init(unsigned char);
 int pin_trace_read(unsigned char, ctype_pin_inst*);
+/* Returns the next instruction without copying it out of the trace (valid
+   until the next call on that core), or NULL at the end of the trace. */
+const ctype_pin_inst* pin_trace_next(unsigned char);
+/* Makes instruction inst (counted from the start of the trace) the next one
+   returned. Mapped and block-compressed traces seek in constant time, bzip2
+   traces decompress up to inst, from the start when seeking backward. Returns 0
+   if inst is past the end. */
+int pin_trace_seek(unsigned char, uint64_t);
+/* Skips the next instructions without returning them, through the index where
+   the trace has one. Returns the number skipped, fewer only at the end. */
+uint64_t pin_trace_skip(unsigned char, uint64_t);
 void pin_trace_open(unsigned char, const char*);
 void pin_trace_close(unsigned char);
 
@@ -41,6 +41,7 @@ extern "C" {
 
 #include "bp/bp.h"
 #include "frontend/pt_memtrace/memtrace_fe.h"
+#include "frontend/pt_memtrace/trace_stream.h"
 #include "isa/isa.h"
 #include "pin/pin_lib/gather_scatter_addresses.h"
 #include "pin/pin_lib/uop_generator.h"
@@ -171,8 +172,13 @@ int roi(const xed_decoded_inst_t* ins) {
   return 0;
 }
 
-int memtrace_trace_read(int proc_id, ctype_pin_inst* next_onpath_pi) {
+/* Decodes the next instruction of the trace into next_onpath_pi. *filled is
+   set unless the end of the trace was reached before an instruction. ROI
+   markers are left to memtrace_trace_markers() so that the decode can run ahead
+   of the simulation. */
+int memtrace_trace_decode(int proc_id, ctype_pin_inst* next_onpath_pi, Flag* filled) {
   InstInfo* insi;
+  *filled = FALSE;
 
   do {
     insi = const_cast<InstInfo*>(trace_readers[proc_id]->nextInstruction());
@@ -215,7 +221,18 @@ int memtrace_trace_read(int proc_id, ctype_pin_inst* next_onpath_pi) {
     fill_in_cf_info(next_onpath_pi, insi->ins);
     print_err_if_invalid(next_onpath_pi, insi->ins);
   }
+  *filled = TRUE;
+
+  // End of ROI
+  if (!insi->is_dr_ins && roi(insi->ins))
+    return 0;
 
+  return 1;
+}
+
+/* Acts on the stat markers of an instruction once it is handed to the
+   simulation */
+void memtrace_trace_markers(int proc_id, const ctype_pin_inst* next_onpath_pi) {
   if (next_onpath_pi->scarab_marker_roi_begin == true) {
     assert(!roi_dump_began);
     // reset stats
@@ -226,16 +243,18 @@ int memtrace_trace_read(int proc_id, ctype_pin_inst* next_onpath_pi) {
     assert(roi_dump_began);
     // dump stats
     std::cout << "Reached roi dump end marker, dump stats between" << std::endl;
-    dump_stats(proc_id, TRUE, global_stat_array[proc_id], NUM_GLOBAL_STATS);
+    dump_stats(proc_id, TRUE, 0, NUM_GLOBAL_STATS);
     roi_dump_began = FALSE;
     roi_dump_ID++;
   }
+}
 
-  // End of ROI
-  if (!insi->is_dr_ins && roi(insi->ins))
-    return 0;
-
-  return 1;
+int memtrace_trace_read(int proc_id, ctype_pin_inst* next_onpath_pi) {
+  Flag filled;
+  int ret = memtrace_trace_decode(proc_id, next_onpath_pi, &filled);
+  if (filled)
+    memtrace_trace_markers(proc_id, next_onpath_pi);
+  return ret;
 }
 
 /**************************************************************************************/
@@ -270,7 +289,16 @@ void memtrace_init(void) {
     trace_files[proc_id] = tmp_trace_files[proc_id];
   }
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    memtrace_setup(proc_id);
+    // a core on a shared decode stream sets up its reader only if it has to decode
+    if (!trace_stream_open(proc_id, trace_files[proc_id]))
+      memtrace_setup(proc_id);
+  }
+}
+
+void memtrace_done(void) {
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if (trace_readers[proc_id])
+      trace_readers[proc_id]->saveDecodeCache();
   }
 }
 
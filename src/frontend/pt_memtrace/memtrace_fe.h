@@ -46,7 +46,10 @@ extern "C" {
 #endif
 
 void memtrace_init(void);
+void memtrace_done(void);
 int memtrace_trace_read(int proc_id, ctype_pin_inst* pt_next_pi);
+int memtrace_trace_decode(int proc_id, ctype_pin_inst* pt_next_pi, Flag* filled);
+void memtrace_trace_markers(int proc_id, const ctype_pin_inst* pt_next_pi);
 void memtrace_setup(uns proc_id);
 
 #ifdef __cplusplus
@@ -41,6 +41,10 @@
 
 #include "assert.h"
 #include "elf.h"
+
+extern "C" {
+#include "general.param.h"
+}
 // #include "log.h"
 
 #define warn(...) printf(__VA_ARGS__)
@@ -57,19 +61,74 @@ using std::unique_ptr;
 static bool xedInitDone = false;
 static std::mutex initMutex;
 
+// Sidecar file of decoded instructions (TRACE_XED_CACHE_DIR): a header
+// followed by one record per static instruction. The two pointers inside a
+// xed_decoded_inst_t are stored as nullptr and rebuilt on load.
+static const char xedCacheMagic[8] = {'S', 'C', 'R', 'X', 'E', 'D', 'C', '1'};
+
+struct XedCacheHeader {
+  char magic[8];
+  uint32_t record_size;
+  uint32_t reserved;
+  uint64_t xed_version;  // hash of xed_get_version()
+  uint64_t trace_key;    // TraceReader::decodeCacheKey()
+  uint64_t num_records;
+};
+
+struct XedCacheRecord {
+  uint64_t vaddr;
+  uint64_t inst_index;  // ins._inst - xed_inst_table_base(), or UINT64_MAX
+  XedCacheEntry entry;
+};
+
+static uint64_t fnv1a(const void* _data, size_t _size, uint64_t _hash = 0xcbf29ce484222325ull) {
+  const uint8_t* data = static_cast<const uint8_t*>(_data);
+  for (size_t i = 0; i < _size; i++) {
+    _hash ^= data[i];
+    _hash *= 0x100000001b3ull;
+  }
+  return _hash;
+}
+
 // A non-reader
-TraceReader::TraceReader() : trace_ready_(false), skipped_(0), buf_size_(0) {
+TraceReader::TraceReader()
+    : trace_ready_(false),
+      xed_index_count_(0),
+      xed_index_shift_(64),
+      xed_cache_map_(nullptr),
+      xed_cache_map_size_(0),
+      xed_cache_loaded_(0),
+      skipped_(0),
+      buf_size_(0),
+      ins_head_(0),
+      ins_tail_(0),
+      ins_mask_(0),
+      pc_index_shift_(64) {
 }
 
 // Trace Reader
 TraceReader::TraceReader(const std::string& _trace, uint32_t _buf_size)
-    : trace_ready_(false), warn_not_found_(1), skipped_(0), buf_size_(_buf_size) {
+    : trace_ready_(false),
+      xed_index_count_(0),
+      xed_index_shift_(64),
+      xed_cache_map_(nullptr),
+      xed_cache_map_size_(0),
+      xed_cache_loaded_(0),
+      warn_not_found_(1),
+      skipped_(0),
+      buf_size_(_buf_size),
+      ins_head_(0),
+      ins_tail_(0),
+      ins_mask_(0),
+      pc_index_shift_(64) {
 }
 
 TraceReader::~TraceReader() {
   if (skipped_ > 0) {
     warn("Skipped %lu stray memory references\n", skipped_);
   }
+  if (xed_cache_map_)
+    munmap(xed_cache_map_, xed_cache_map_size_);
 }
 
 bool TraceReader::operator!() {
@@ -104,6 +163,9 @@ void TraceReader::init(const std::string& _trace) {
   invalid_info_.unknown_type = false;
   invalid_info_.valid = false;
 
+  if (_trace.size())
+    trace_ = _trace;
+  loadDecodeCache();
   if (_trace.size())
     traceFileIs(_trace);
   init_buffer();
@@ -114,16 +176,40 @@ void TraceReader::traceFileIs(const std::string& _trace) {
   trace_ready_ = initTrace();
 }
 
-void TraceReader::fillCache(uint64_t _vAddr, uint8_t _reported_size, uint8_t* inst_bytes) {
+void TraceReader::insertXed(uint64_t _vaddr, XedCacheEntry* _entry) {
+  if (2 * (xed_index_count_ + 1) > xed_index_.size()) {
+    std::vector<XedIndexSlot> old_index(std::max<size_t>(1024, 2 * xed_index_.size()), XedIndexSlot{0, nullptr});
+    old_index.swap(xed_index_);
+    xed_index_shift_ = 64 - __builtin_ctzll(xed_index_.size());
+    xed_index_count_ = 0;
+    for (const XedIndexSlot& slot : old_index)
+      if (slot.entry)
+        insertXed(slot.vaddr, slot.entry);
+  }
+  uint64_t mask = xed_index_.size() - 1;
+  uint64_t slot = xedSlot(_vaddr);
+  while (xed_index_[slot].entry) {
+    assert(xed_index_[slot].vaddr != _vaddr);
+    slot = (slot + 1) & mask;
+  }
+  xed_index_[slot] = XedIndexSlot{_vaddr, _entry};
+  xed_index_count_++;
+}
+
+XedCacheEntry* TraceReader::fillCache(uint64_t _vAddr, uint8_t _reported_size, uint8_t* inst_bytes) {
   uint64_t size;
   uint8_t* loc;
+  xed_pool_.emplace_back();
+  XedCacheEntry* entry = &xed_pool_.back();
+  entry->length = _reported_size;
+  xed_decoded_inst_t* ins = &entry->ins;
   if (inst_bytes != NULL || locationForVAddr(_vAddr, &loc, &size)) {
-    xed_map_.emplace(_vAddr, make_tuple(0, false, false, false, make_unique<xed_decoded_inst_t>()));
-    xed_decoded_inst_t* ins = get<MAP_XED>(xed_map_.at(_vAddr)).get();
     xed_decoded_inst_zero_set_mode(ins, &xed_state_);
     if (inst_bytes != NULL) {
       loc = inst_bytes;
+      size = _reported_size;
     }
+    memcpy(entry->bytes, loc, std::min<uint64_t>({size, _reported_size, sizeof(entry->bytes)}));
     xed_error_enum_t res;
     res = xed_decode(ins, loc, _reported_size);
     if (res != XED_ERROR_NONE) {
@@ -151,19 +237,16 @@ void TraceReader::fillCache(uint64_t _vAddr, uint8_t _reported_size, uint8_t* in
           if (n_used_mem_ops > 2) {
             warn("Unexpected %u memory operands for 0x%lx\n", n_used_mem_ops, _vAddr);
           }
-          get<MAP_MEMOPS>(xed_map_.at(_vAddr)) = n_used_mem_ops;
+          entry->mem_ops = n_used_mem_ops;
         }
       }
     }
-    auto& xed_tuple = xed_map_[_vAddr];
     // Record if this instruction is a conditional branch
-    bool is_cond_br = (xed_decoded_inst_get_category(ins) == XED_CATEGORY_COND_BR);
-    get<MAP_COND>(xed_tuple) = is_cond_br;
+    entry->cond = (xed_decoded_inst_get_category(ins) == XED_CATEGORY_COND_BR);
 
     // Record if this instruction is a 'rep' type, which may indicate a
     // variable number of memory records for input formats like memtrace
-    bool is_rep = xed_decoded_inst_get_attribute(ins, XED_ATTRIBUTE_REP) > 0;
-    get<MAP_REP>(xed_tuple) = is_rep;
+    entry->rep = xed_decoded_inst_get_attribute(ins, XED_ATTRIBUTE_REP) > 0;
   } else {
     if (warn_not_found_ > 0) {
       warn_not_found_ -= 1;
@@ -179,8 +262,116 @@ void TraceReader::fillCache(uint64_t _vAddr, uint8_t _reported_size, uint8_t* in
     // Replace the unknown instruction with a NOP
     // NOTE: Unknown memory records are skipped, so 'rep' needs no special
     // handling here
-    xed_map_.emplace(_vAddr, make_tuple(0, true, false, false, makeNop(_reported_size)));
+    *ins = *makeNop(_reported_size);
+    entry->unknown = true;
+  }
+  insertXed(_vAddr, entry);
+  return entry;
+}
+
+std::string TraceReader::decodeCacheFile() const {
+  if (!TRACE_XED_CACHE_DIR || trace_.empty())
+    return "";
+  char name[32];
+  snprintf(name, sizeof(name), "/%016lx.xedcache", fnv1a(trace_.data(), trace_.size()));
+  return std::string(TRACE_XED_CACHE_DIR) + name;
+}
+
+// Identifies the trace contents a sidecar file was built from
+uint64_t TraceReader::decodeCacheKey() const {
+  struct stat st;
+  uint64_t key = fnv1a(trace_.data(), trace_.size());
+  if (stat(trace_.c_str(), &st) == 0) {
+    uint64_t id[2] = {static_cast<uint64_t>(st.st_size), static_cast<uint64_t>(st.st_mtime)};
+    key = fnv1a(id, sizeof(id), key);
+  }
+  return key;
+}
+
+void TraceReader::loadDecodeCache() {
+  std::string file = decodeCacheFile();
+  if (file.empty())
+    return;
+  int fd = open(file.c_str(), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  struct stat st;
+  XedCacheHeader header;
+  const char* version = xed_get_version();
+  bool valid = fstat(fd, &st) == 0 && pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+               !memcmp(header.magic, xedCacheMagic, sizeof(xedCacheMagic)) &&
+               header.record_size == sizeof(XedCacheRecord) &&
+               header.xed_version == fnv1a(version, strlen(version)) && header.trace_key == decodeCacheKey() &&
+               static_cast<uint64_t>(st.st_size) == sizeof(header) + header.num_records * sizeof(XedCacheRecord);
+  void* map = MAP_FAILED;
+  if (valid && header.num_records)
+    map = mmap(nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    if (!valid)
+      warn("Ignoring stale decode cache %s\n", file.c_str());
+    return;
+  }
+  xed_cache_map_ = map;
+  xed_cache_map_size_ = st.st_size;
+
+  // Rebuild the pointers of the decoded instructions in the private mapping
+  const xed_inst_t* inst_base = xed_inst_table_base();
+  XedCacheRecord* records = reinterpret_cast<XedCacheRecord*>(static_cast<char*>(map) + sizeof(header));
+  for (uint64_t i = 0; i < header.num_records; i++) {
+    XedCacheRecord* record = &records[i];
+    record->entry.ins._inst = record->inst_index == UINT64_MAX ? nullptr : inst_base + record->inst_index;
+    record->entry.ins._byte_array._dec = record->entry.bytes;
+    if (!findXed(record->vaddr))
+      insertXed(record->vaddr, &record->entry);
+  }
+  xed_cache_loaded_ = header.num_records;
+  std::cout << "Loaded " << xed_cache_loaded_ << " decoded instructions from " << file << std::endl;
+}
+
+void TraceReader::saveDecodeCache() {
+  std::string file = decodeCacheFile();
+  if (file.empty() || xed_pool_.empty())
+    return;
+
+  std::string tmp = file + "." + std::to_string(getpid());
+  FILE* out = fopen(tmp.c_str(), "wb");
+  if (!out) {
+    warn("Cannot write decode cache %s\n", tmp.c_str());
+    return;
+  }
+  const char* version = xed_get_version();
+  XedCacheHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, xedCacheMagic, sizeof(xedCacheMagic));
+  header.record_size = sizeof(XedCacheRecord);
+  header.xed_version = fnv1a(version, strlen(version));
+  header.trace_key = decodeCacheKey();
+  header.num_records = xed_index_count_;
+  bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+
+  const xed_inst_t* inst_base = xed_inst_table_base();
+  for (const XedIndexSlot& slot : xed_index_) {
+    if (!slot.entry || !ok)
+      continue;
+    XedCacheRecord record;
+    memset(&record, 0, sizeof(record));
+    record.vaddr = slot.vaddr;
+    record.entry = *slot.entry;
+    record.inst_index = record.entry.ins._inst ? record.entry.ins._inst - inst_base : UINT64_MAX;
+    record.entry.ins._inst = nullptr;
+    record.entry.ins._byte_array._dec = nullptr;
+    ok = fwrite(&record, sizeof(record), 1, out) == 1;
   }
+  if (fclose(out) != 0)
+    ok = false;
+  if (!ok || rename(tmp.c_str(), file.c_str()) != 0) {
+    warn("Cannot write decode cache %s\n", file.c_str());
+    unlink(tmp.c_str());
+    return;
+  }
+  std::cout << "Saved " << xed_index_count_ << " decoded instructions to " << file << std::endl;
 }
 
 unique_ptr<xed_decoded_inst_t> TraceReader::makeNop(uint8_t _length) {
@@ -250,56 +441,120 @@ xed_decoded_inst_t* TraceReader::createJmp(uint64_t displacement) {
 }
 
 void TraceReader::init_buffer() {
+  // Room for the buffered instructions plus the one returned last by
+  // nextInstruction()
+  uint64_t entries = static_cast<uint64_t>(buf_size_) + 1;
+  uint64_t capacity = 1;
+  while (capacity < entries)
+    capacity <<= 1;
+  ins_buffer_.assign(capacity, InstInfo());
+  ins_next_same_pc_.assign(capacity, NO_ENTRY);
+  ins_mask_ = capacity - 1;
+  ins_head_ = ins_tail_ = 0;
+  pc_index_.assign(std::max<uint64_t>(8, 2 * capacity), PCIndexSlot{0, NO_ENTRY, NO_ENTRY});
+  pc_index_shift_ = 64 - __builtin_ctzll(pc_index_.size());
+
   // Push one dummy entry so we can pop in nextInstruction()
-  ins_buffer.emplace_back(InstInfo());
+  pushInstruction(InstInfo());
   for (uint32_t i = 0; i < buf_size_; i++) {
-    ins_buffer.emplace_back(*getNextInstruction());
+    pushInstruction(*getNextInstruction());
+  }
+}
+
+uint64_t TraceReader::pcSlot(uint64_t _pc) const {
+  uint64_t mask = pc_index_.size() - 1;
+  uint64_t slot = (_pc * 0x9E3779B97F4A7C15ull) >> pc_index_shift_;
+  while (pc_index_[slot].first != NO_ENTRY && pc_index_[slot].pc != _pc)
+    slot = (slot + 1) & mask;
+  return slot;
+}
+
+void TraceReader::pushInstruction(const InstInfo& _info) {
+  assert(ins_tail_ - ins_head_ <= ins_mask_);
+  uint64_t seq = ins_tail_++;
+  ins_buffer_[seq & ins_mask_] = _info;
+  ins_next_same_pc_[seq & ins_mask_] = NO_ENTRY;
+
+  PCIndexSlot& slot = pc_index_[pcSlot(_info.pc)];
+  if (slot.first == NO_ENTRY) {
+    slot = PCIndexSlot{_info.pc, seq, seq};
+  } else {
+    ins_next_same_pc_[slot.last & ins_mask_] = seq;
+    slot.last = seq;
   }
 }
 
+void TraceReader::popInstruction() {
+  assert(ins_tail_ > ins_head_);
+  uint64_t seq = ins_head_++;
+  uint64_t slot = pcSlot(ins_buffer_[seq & ins_mask_].pc);
+  assert(pc_index_[slot].first == seq);
+  pc_index_[slot].first = ins_next_same_pc_[seq & ins_mask_];
+  if (pc_index_[slot].first != NO_ENTRY)
+    return;
+
+  // Last instance of this PC left the buffer: backward-shift delete so that
+  // probe sequences stay unbroken
+  uint64_t mask = pc_index_.size() - 1;
+  for (uint64_t next = (slot + 1) & mask; pc_index_[next].first != NO_ENTRY; next = (next + 1) & mask) {
+    uint64_t home = (pc_index_[next].pc * 0x9E3779B97F4A7C15ull) >> pc_index_shift_;
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      pc_index_[slot] = pc_index_[next];
+      pc_index_[next].first = NO_ENTRY;
+      slot = next;
+    }
+  }
+}
+
+uint64_t TraceReader::nextInstanceOf(uint64_t _pc, uint64_t _from) const {
+  uint64_t seq = pc_index_[pcSlot(_pc)].first;
+  while (seq != NO_ENTRY && seq < _from)
+    seq = ins_next_same_pc_[seq & ins_mask_];
+  return seq;
+}
+
 const InstInfo* TraceReader::nextInstruction() {
-  ins_buffer.pop_front();
-  ins_buffer.emplace_back(*getNextInstruction());
-  return &ins_buffer.front();
+  popInstruction();
+  pushInstruction(*getNextInstruction());
+  return &ins_buffer_[ins_head_ & ins_mask_];
 }
 
 // Find the next buffer entry, starting from ref, that matches the given PC
 const TraceReader::returnValue TraceReader::findPC(bufferEntry& ref, uint64_t _pc) {
-  for (; ref != ins_buffer.end(); ref++) {
-    if (ref->pc == _pc) {
-      return ENTRY_VALID;
-    }
+  uint64_t seq = nextInstanceOf(_pc, ref.seq_);
+  if (seq == NO_ENTRY) {
+    ref.seq_ = ins_tail_;
+    return ENTRY_NOT_FOUND;
   }
-  return ENTRY_NOT_FOUND;
+  ref.seq_ = seq;
+  return ENTRY_VALID;
 }
 
 const TraceReader::returnValue TraceReader::peekInstructionAtIndex(uint32_t idx, bufferEntry& ref) {
-  if (idx >= ins_buffer.size())
+  if (idx >= ins_tail_ - ins_head_)
     return ENTRY_NOT_FOUND;
 
-  ref = ins_buffer.begin();
-  for (; ref != ins_buffer.end(); ref++) {
-    if (idx == 0)
-      break;
-    idx--;
-  }
+  ref = bufferEntry(this, ins_head_ + idx);
   return ENTRY_VALID;
 }
 
 const TraceReader::returnValue TraceReader::findPCInSegment(bufferEntry& ref, uint64_t _pc, uint64_t _termination_pc) {
-  if (ref == ins_buffer.end())
+  if (ref.seq_ >= ins_tail_)
     return ENTRY_NOT_FOUND;
 
-  for (ref++; ref != ins_buffer.end(); ref++) {
-    if (ref->pc == _pc) {
-      return ENTRY_VALID;
-    } else if (ref->pc == _termination_pc) {
-      return ENTRY_OUT_OF_SEGMENT;
-    }
+  uint64_t found = nextInstanceOf(_pc, ref.seq_ + 1);
+  uint64_t termination = nextInstanceOf(_termination_pc, ref.seq_ + 1);
+  if (found != NO_ENTRY && (termination == NO_ENTRY || found <= termination)) {
+    ref.seq_ = found;
+    return ENTRY_VALID;
+  } else if (termination != NO_ENTRY) {
+    ref.seq_ = termination;
+    return ENTRY_OUT_OF_SEGMENT;
   }
+  ref.seq_ = ins_tail_;
   return ENTRY_NOT_FOUND;
 }
 
 TraceReader::bufferEntry TraceReader::bufferStart() {
-  return ins_buffer.begin();
+  return bufferEntry(this, ins_head_);
 }
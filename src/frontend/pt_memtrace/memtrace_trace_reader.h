@@ -54,13 +54,26 @@ static std::unique_ptr<T> make_unique(Args&&... args) {
 using std::make_unique;
 #endif
 
-// Indices to 'xed_map_' cached features
+// Indices to the features cached with each 'ctype_inst_map' entry
 static constexpr int MAP_MEMOPS = 0;
 static constexpr int MAP_UNKNOWN = 1;
 static constexpr int MAP_COND = 2;
 static constexpr int MAP_REP = 3;
 static constexpr int MAP_XED = 4;
 
+// A decoded static instruction and the features that are looked up for every
+// dynamic instance of it. Entries never move once created, so InstInfo::ins
+// can point into them.
+struct XedCacheEntry {
+  xed_decoded_inst_t ins;
+  int mem_ops;
+  bool unknown;
+  bool cond;
+  bool rep;
+  uint8_t length;
+  uint8_t bytes[15];  // the encoding ins was decoded from, when known
+};
+
 class TraceReader {
  public:
   enum returnValue : uint8_t {
@@ -69,7 +82,31 @@ class TraceReader {
     ENTRY_FIRST,
     ENTRY_OUT_OF_SEGMENT,
   };
-  using bufferEntry = std::deque<InstInfo>::iterator;
+  // Position in the lookahead buffer. Entries are named by their sequence
+  // number, so a position stays meaningful while the ring wraps.
+  class bufferEntry {
+   public:
+    bufferEntry() : reader_(nullptr), seq_(0) {}
+    InstInfo& operator*() const { return reader_->ins_buffer_[seq_ & reader_->ins_mask_]; }
+    InstInfo* operator->() const { return &**this; }
+    bufferEntry& operator++() {
+      seq_++;
+      return *this;
+    }
+    bufferEntry operator++(int) {
+      bufferEntry old = *this;
+      seq_++;
+      return old;
+    }
+    bool operator==(const bufferEntry& _other) const { return seq_ == _other.seq_; }
+    bool operator!=(const bufferEntry& _other) const { return seq_ != _other.seq_; }
+
+   private:
+    friend class TraceReader;
+    bufferEntry(TraceReader* _reader, uint64_t _seq) : reader_(_reader), seq_(_seq) {}
+    TraceReader* reader_;
+    uint64_t seq_;
+  };
 
   // The default-constructed object will not return valid instructions
   TraceReader();
@@ -83,6 +120,10 @@ class TraceReader {
   const returnValue findPC(bufferEntry& ref, uint64_t _pc);
   const returnValue peekInstructionAtIndex(uint32_t idx, bufferEntry& ref);
   bufferEntry bufferStart();
+  bufferEntry bufferEnd() { return bufferEntry(this, ins_tail_); }
+  // Writes the decoded instructions to the sidecar file of the trace (see
+  // TRACE_XED_CACHE_DIR) so that later runs on the same trace start warm
+  void saveDecodeCache();
 
  private:
   virtual const InstInfo* getNextInstruction() = 0;
@@ -90,9 +131,22 @@ class TraceReader {
   virtual bool locationForVAddr(uint64_t _vaddr, uint8_t** _loc, uint64_t* _size) = 0;
 
   void init_buffer();
+  void pushInstruction(const InstInfo& _info);
+  void popInstruction();
+  uint64_t pcSlot(uint64_t _pc) const;
+  uint64_t nextInstanceOf(uint64_t _pc, uint64_t _from) const;
 
   std::unique_ptr<xed_decoded_inst_t> makeNop(uint8_t _length);
 
+  struct XedIndexSlot {
+    uint64_t vaddr;
+    XedCacheEntry* entry;  // nullptr if the slot is free
+  };
+  void insertXed(uint64_t _vaddr, XedCacheEntry* _entry);
+  void loadDecodeCache();
+  std::string decodeCacheFile() const;
+  uint64_t decodeCacheKey() const;
+
  protected:
   std::string trace_;
   InstInfo info_;
@@ -100,14 +154,51 @@ class TraceReader {
   bool trace_ready_;
   xed_state_t xed_state_;
   std::vector<std::tuple<uint64_t, uint64_t, uint8_t*>> sections_;
-  std::unordered_map<uint64_t, std::tuple<int, bool, bool, bool, std::unique_ptr<xed_decoded_inst_t>>> xed_map_;
+  // Decoded instructions: entries decoded in this run live in xed_pool_, the
+  // ones loaded from the sidecar file in its mapping. xed_index_ is an
+  // open-addressed table from vaddr to entry (power-of-two size).
+  std::deque<XedCacheEntry> xed_pool_;
+  std::vector<XedIndexSlot> xed_index_;
+  uint64_t xed_index_count_;
+  unsigned xed_index_shift_;
+  void* xed_cache_map_;
+  size_t xed_cache_map_size_;
+  uint64_t xed_cache_loaded_;
   int warn_not_found_;
   uint64_t skipped_;
   uint32_t buf_size_;
-  std::deque<InstInfo> ins_buffer;
+  // Lookahead buffer: a power-of-two ring holding the sequence numbers
+  // [ins_head_, ins_tail_). Every buffered instance of a PC is chained through
+  // ins_next_same_pc_, and pc_index_ (open-addressed) holds the oldest and
+  // newest instance of each buffered PC, so PC lookups never scan the ring.
+  static constexpr uint64_t NO_ENTRY = UINT64_MAX;
+  struct PCIndexSlot {
+    uint64_t pc;
+    uint64_t first;  // NO_ENTRY if the slot is free
+    uint64_t last;
+  };
+  std::vector<InstInfo> ins_buffer_;
+  std::vector<uint64_t> ins_next_same_pc_;
+  uint64_t ins_head_;
+  uint64_t ins_tail_;
+  uint64_t ins_mask_;
+  std::vector<PCIndexSlot> pc_index_;
+  unsigned pc_index_shift_;
 
   void init(const std::string& _trace);
-  void fillCache(uint64_t _vAddr, uint8_t _reported_size, uint8_t* inst_bytes = NULL);
+  // Returns the cached decode of the instruction at _vaddr, or nullptr
+  XedCacheEntry* findXed(uint64_t _vaddr) const {
+    if (xed_index_.empty())
+      return nullptr;
+    uint64_t mask = xed_index_.size() - 1;
+    for (uint64_t slot = xedSlot(_vaddr);; slot = (slot + 1) & mask) {
+      const XedIndexSlot& s = xed_index_[slot];
+      if (!s.entry || s.vaddr == _vaddr)
+        return s.entry;
+    }
+  }
+  uint64_t xedSlot(uint64_t _vaddr) const { return (_vaddr * 0x9E3779B97F4A7C15ull) >> xed_index_shift_; }
+  XedCacheEntry* fillCache(uint64_t _vAddr, uint8_t _reported_size, uint8_t* inst_bytes = NULL);
   void traceFileIs(const std::string& _trace);
   xed_decoded_inst_t* createJmp(uint64_t displacement);
 };
@@ -293,39 +293,6 @@ const char* TraceReaderMemtrace::parse_buildid_string(const char* src, OUT void*
 #endif
 
 bool TraceReaderMemtrace::initTrace() {
-  {
-    // temporary scope only for reading filetype
-    std::vector<dynamorio::drmemtrace::scheduler_t::input_workload_t> sched_inputs;
-    sched_inputs.emplace_back(trace_);  // None ROI for scanning the filetype first
-
-    dynamorio::drmemtrace::scheduler_t tmp_scheduler;
-    if (tmp_scheduler.init(sched_inputs, 1, dynamorio::drmemtrace::scheduler_t::make_scheduler_serial_options()) !=
-        dynamorio::drmemtrace::scheduler_t::STATUS_SUCCESS) {
-      panic("failed to initialize tmp scheduler: %s", tmp_scheduler.get_error_string().c_str());
-      return false;
-    }
-
-    // Detect trace type
-    auto* tmp_stream = tmp_scheduler.get_stream(0);
-    auto type = tmp_stream->get_filetype();
-    ASSERT(0, type != 0 && "Filetype detection failed: got 0x0 (trace file is missing header)");
-
-    if (dcontext_ == nullptr) {
-      dcontext_ = dr_standalone_init();
-    }
-
-    trace_has_encodings_ = type & dynamorio::drmemtrace::OFFLINE_FILE_TYPE_ENCODINGS;
-    if (type & dynamorio::drmemtrace::OFFLINE_FILE_TYPE_ARCH_REGDEPS) {
-      dr_isa_mode_t dummy;
-      dr_set_isa_mode(dcontext_, DR_ISA_REGDEPS, &dummy);
-    } else {
-      warn(
-          "Warning: Scarab expects the trace file type to include OFFLINE_FILE_TYPE_ARCH_REGDEPS (0x%lx), but got "
-          "type: 0x%lx\n",
-          (unsigned long)dynamorio::drmemtrace::OFFLINE_FILE_TYPE_ARCH_REGDEPS, (unsigned long)type);
-    }
-  }
-
   std::vector<dynamorio::drmemtrace::scheduler_t::input_workload_t> sched_inputs;
   // memtrace region of interest provides a view of the trace only of interest
   // inst count satrt with 1
@@ -347,6 +314,26 @@ bool TraceReaderMemtrace::initTrace() {
     return false;
   }
 
+  // The file type comes from the header, which the scheduler reads at init,
+  // so the trace is opened once instead of once more just to scan the type
+  auto type = scheduler.get_stream(0)->get_filetype();
+  ASSERT(0, type != 0 && "Filetype detection failed: got 0x0 (trace file is missing header)");
+
+  if (dcontext_ == nullptr) {
+    dcontext_ = dr_standalone_init();
+  }
+
+  trace_has_encodings_ = type & dynamorio::drmemtrace::OFFLINE_FILE_TYPE_ENCODINGS;
+  if (type & dynamorio::drmemtrace::OFFLINE_FILE_TYPE_ARCH_REGDEPS) {
+    dr_isa_mode_t dummy;
+    dr_set_isa_mode(dcontext_, DR_ISA_REGDEPS, &dummy);
+  } else {
+    warn(
+        "Warning: Scarab expects the trace file type to include OFFLINE_FILE_TYPE_ARCH_REGDEPS (0x%lx), but got "
+        "type: 0x%lx\n",
+        (unsigned long)dynamorio::drmemtrace::OFFLINE_FILE_TYPE_ARCH_REGDEPS, (unsigned long)type);
+  }
+
   // Set info 'A' to the first complete instruction.
   // It will initially lack branch target information.
   getNextInstruction__(&mt_info_a_, &mt_info_b_);
@@ -409,7 +396,9 @@ bool TraceReaderMemtrace::getNextInstruction__(InstInfo* _info, InstInfo* _prior
         } else if (mt_ref_.instr.type == dynamorio::drmemtrace::TRACE_TYPE_INSTR_NO_FETCH) {
           // a repeated rep
           if (!is_dr_isa) {  // impossible to check DR_ISA_REGDEPS for REP
-            bool is_rep = std::get<MAP_REP>(xed_map_.at(_prior->pc));
+            XedCacheEntry* prior_entry = findXed(_prior->pc);
+            assert(prior_entry);
+            bool is_rep = prior_entry->rep;
             assert(is_rep && ((uint32_t)mt_ref_.instr.pid == _prior->pid) &&
                    ((uint32_t)mt_ref_.instr.tid == _prior->tid) && (mt_ref_.instr.addr == _prior->pc));
           }
@@ -500,7 +489,8 @@ PATCH_REP:
   _info->valid &= complete;
   // Compute the branch target information for the prior instruction
   if (_info->valid) {
-    bool is_rep = xed_map_.find(_prior->pc) != xed_map_.end() ? std::get<MAP_REP>(xed_map_.at(_prior->pc)) : 0;
+    XedCacheEntry* prior_entry = findXed(_prior->pc);
+    bool is_rep = prior_entry ? prior_entry->rep : 0;
     bool non_seq = _info->pc != (_prior->pc + prior_isize);
 
     if (_prior->taken) {  // currently set iif branch
@@ -861,22 +851,18 @@ void TraceReaderMemtrace::processDrIsaInst(InstInfo* _info, bool has_another_mem
 
 void TraceReaderMemtrace::processInst(InstInfo* _info) {
   // Get the XED info from the cache, creating it if needed
-  auto xed_map_iter = xed_map_.find(mt_ref_.instr.addr);
-  if (xed_map_iter == xed_map_.end()) {
+  XedCacheEntry* entry = findXed(mt_ref_.instr.addr);
+  if (!entry) {
     if (trace_has_encodings_)
-      fillCache(mt_ref_.instr.addr, mt_ref_.instr.size, mt_ref_.instr.encoding);
+      entry = fillCache(mt_ref_.instr.addr, mt_ref_.instr.size, mt_ref_.instr.encoding);
     else
-      fillCache(mt_ref_.instr.addr, mt_ref_.instr.size);
-    xed_map_iter = xed_map_.find(mt_ref_.instr.addr);
-    assert((xed_map_iter != xed_map_.end()));
+      entry = fillCache(mt_ref_.instr.addr, mt_ref_.instr.size);
   }
-  bool unknown_type, cond_branch;
-  xed_decoded_inst_t* xed_ins;
-  auto& xed_tuple = (*xed_map_iter).second;
+  bool unknown_type = entry->unknown;
+  xed_decoded_inst_t* xed_ins = &entry->ins;
 
-  tie(mt_mem_ops_, unknown_type, cond_branch, std::ignore, std::ignore) = xed_tuple;
+  mt_mem_ops_ = entry->mem_ops;
   mt_prior_isize_ = mt_ref_.instr.size;
-  xed_ins = std::get<MAP_XED>(xed_tuple).get();
 
   xed_category_enum_t category = xed_decoded_inst_get_category(xed_ins);
   _info->is_dr_ins = false;
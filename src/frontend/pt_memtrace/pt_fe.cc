@@ -46,6 +46,7 @@ extern "C" {
 
 #include "bp/bp.h"
 #include "frontend/pt_memtrace/pt_fe.h"
+#include "frontend/pt_memtrace/trace_stream.h"
 #include "isa/isa.h"
 #include "pin/pin_lib/uop_generator.h"
 #include "pin/pin_lib/x86_decoder.h"
@@ -138,8 +139,11 @@ int pt_roi(const xed_decoded_inst_t* ins) {
   return 0;
 }
 
-int pt_trace_read(int proc_id, ctype_pin_inst* pt_next_pi) {
+/* Decodes the next instruction of the trace into pt_next_pi. *filled is set
+   unless the end of the trace was reached before an instruction. */
+int pt_trace_decode(int proc_id, ctype_pin_inst* pt_next_pi, Flag* filled) {
   InstInfo* insi;
+  *filled = FALSE;
 
   do {
     insi = const_cast<InstInfo*>(pt_trace_readers[proc_id]->nextInstruction());
@@ -167,6 +171,7 @@ int pt_trace_read(int proc_id, ctype_pin_inst* pt_next_pi) {
   /* std::cout << "branch target for PC: " << pt_next_pi->instruction_addr << " is: " << pt_next_pi->branch_target <<
    * std::endl; */
   print_err_if_invalid(pt_next_pi, insi->ins);
+  *filled = TRUE;
 
   // End of ROI
   if (pt_roi(insi->ins))
@@ -175,6 +180,11 @@ int pt_trace_read(int proc_id, ctype_pin_inst* pt_next_pi) {
   return 1;
 }
 
+int pt_trace_read(int proc_id, ctype_pin_inst* pt_next_pi) {
+  Flag filled;
+  return pt_trace_decode(proc_id, pt_next_pi, &filled);
+}
+
 void pt_init(void) {
   uop_generator_init(NUM_CORES);
   init_x86_decoder(nullptr);
@@ -207,7 +217,16 @@ void pt_init(void) {
     pt_trace_files[proc_id] = tmp_trace_files[proc_id];
   }
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    pt_setup(proc_id);
+    // a core on a shared decode stream sets up its reader only if it has to decode
+    if (!trace_stream_open(proc_id, pt_trace_files[proc_id]))
+      pt_setup(proc_id);
+  }
+}
+
+void pt_done(void) {
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if (pt_trace_readers[proc_id])
+      pt_trace_readers[proc_id]->saveDecodeCache();
   }
 }
 
@@ -46,7 +46,9 @@ extern "C" {
 #endif  //__cplusplus
 
 void pt_init(void);
+void pt_done(void);
 int pt_trace_read(int proc_id, ctype_pin_inst* pt_next_pi);
+int pt_trace_decode(int proc_id, ctype_pin_inst* pt_next_pi, Flag* filled);
 void pt_setup(uns proc_id);
 
 #ifdef __cplusplus
@@ -0,0 +1,238 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/pt_memtrace/pt_trace_block.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Reading and writing preprocessed PT trace containers. Kept free
+ *                of simulator state so that utils/pt_trace_blocks can link it
+ *                on its own.
+ *
+ *                Ids are stored as zigzag varints of (id - previous id - 1):
+ *                code is numbered in first-seen order, so straight-line code
+ *                encodes as a run of zero bytes that deflate removes.
+ ***************************************************************************************/
+
+#include "frontend/pt_memtrace/pt_trace_block.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <zlib.h>
+
+#define PT_TRACE_BLOCK_MAX_ID_BYTES 5
+
+struct Pt_Trace_Block_Writer_struct {
+  FILE* file;
+  int level;
+  uint32_t block_insts;
+  uint64_t num_insts;
+  uint64_t offset;
+  uint32_t prev_id;
+  std::vector<uint8_t> pending;
+  uint32_t pending_insts;
+  std::vector<Bytef> comp;
+  std::vector<Pt_Trace_Block_Code> codes;
+  std::unordered_map<std::string, uint32_t> code_ids;
+  std::vector<Pin_Trace_Block_Entry> index;
+};
+
+int pt_trace_block_is_container(const char* magic) {
+  return !memcmp(magic, PT_TRACE_BLOCK_MAGIC, PIN_TRACE_BLOCK_MAGIC_SIZE);
+}
+
+const Pt_Trace_Block_Header* pt_trace_block_header(const void* data, size_t size) {
+  const Pt_Trace_Block_Header* header = (const Pt_Trace_Block_Header*)data;
+  if (size < sizeof(Pt_Trace_Block_Header) || !pt_trace_block_is_container(header->magic) || !header->block_insts)
+    return NULL;
+  if (header->num_blocks != (header->num_insts + header->block_insts - 1) / header->block_insts)
+    return NULL;
+  if (header->code_offset > header->index_offset || header->index_offset > size ||
+      (header->index_offset - header->code_offset) / sizeof(Pt_Trace_Block_Code) != header->num_codes ||
+      (size - header->index_offset) / sizeof(Pin_Trace_Block_Entry) < header->num_blocks)
+    return NULL;
+
+  const Pin_Trace_Block_Entry* index = pt_trace_block_index(header);
+  for (uint64_t ii = 0; ii < header->num_blocks; ii++) {
+    const Pin_Trace_Block_Entry* entry = &index[ii];
+    uint64_t expected = std::min((uint64_t)header->block_insts, header->num_insts - ii * header->block_insts);
+    if (entry->first_inst != ii * header->block_insts || entry->num_insts != expected ||
+        entry->offset > header->code_offset || entry->comp_size > header->code_offset - entry->offset)
+      return NULL;
+  }
+  return header;
+}
+
+const Pt_Trace_Block_Code* pt_trace_block_codes(const Pt_Trace_Block_Header* header) {
+  return (const Pt_Trace_Block_Code*)((const char*)header + header->code_offset);
+}
+
+const Pin_Trace_Block_Entry* pt_trace_block_index(const Pt_Trace_Block_Header* header) {
+  return (const Pin_Trace_Block_Entry*)((const char*)header + header->index_offset);
+}
+
+int pt_trace_block_decompress(const Pt_Trace_Block_Header* header, const Pin_Trace_Block_Entry* entry,
+                              uint32_t* out) {
+  std::vector<uint8_t> encoded((size_t)entry->num_insts * PT_TRACE_BLOCK_MAX_ID_BYTES);
+  uLongf encoded_size = encoded.size();
+  if (uncompress(encoded.data(), &encoded_size, (const Bytef*)header + entry->offset, entry->comp_size) != Z_OK)
+    return -1;
+
+  /* the id chain restarts at every block so that each block inflates on its
+     own */
+  uint32_t prev_id = UINT32_MAX;
+  size_t pos = 0;
+  for (uint32_t ii = 0; ii < entry->num_insts; ii++) {
+    uint32_t zigzag = 0;
+    for (int shift = 0;; shift += 7) {
+      if (pos == encoded_size || shift >= 7 * PT_TRACE_BLOCK_MAX_ID_BYTES)
+        return -1;
+      uint8_t byte = encoded[pos++];
+      zigzag |= (uint32_t)(byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        break;
+    }
+    uint32_t id = prev_id + 1 + (uint32_t)((zigzag >> 1) ^ -(zigzag & 1));
+    if (id >= header->num_codes)
+      return -1;
+    out[ii] = id;
+    prev_id = id;
+  }
+  return pos == encoded_size ? 0 : -1;
+}
+
+static int pt_trace_block_writer_flush(Pt_Trace_Block_Writer* writer) {
+  if (!writer->pending_insts)
+    return 0;
+
+  uLongf comp_size = compressBound(writer->pending.size());
+  writer->comp.resize(comp_size);
+  if (compress2(writer->comp.data(), &comp_size, writer->pending.data(), writer->pending.size(), writer->level) !=
+      Z_OK)
+    return -1;
+  if (fwrite(writer->comp.data(), 1, comp_size, writer->file) != comp_size)
+    return -1;
+
+  Pin_Trace_Block_Entry entry;
+  entry.offset = writer->offset;
+  entry.first_inst = writer->num_insts;
+  entry.comp_size = comp_size;
+  entry.num_insts = writer->pending_insts;
+  writer->index.push_back(entry);
+
+  writer->offset += comp_size;
+  writer->num_insts += writer->pending_insts;
+  writer->pending.clear();
+  writer->pending_insts = 0;
+  writer->prev_id = UINT32_MAX;
+  return 0;
+}
+
+Pt_Trace_Block_Writer* pt_trace_block_writer_open(const char* path, uint32_t block_insts, int level) {
+  if (!block_insts)
+    return NULL;
+  FILE* file = fopen(path, "wb");
+  if (!file)
+    return NULL;
+
+  /* the header is rewritten with the final counts on close */
+  Pt_Trace_Block_Header header;
+  memset(&header, 0, sizeof(header));
+  if (fwrite(&header, sizeof(header), 1, file) != 1) {
+    fclose(file);
+    return NULL;
+  }
+
+  Pt_Trace_Block_Writer* writer = new Pt_Trace_Block_Writer_struct();
+  writer->file = file;
+  writer->level = level;
+  writer->block_insts = block_insts;
+  writer->num_insts = 0;
+  writer->offset = sizeof(header);
+  writer->prev_id = UINT32_MAX;
+  writer->pending_insts = 0;
+  writer->pending.reserve((size_t)block_insts * 2);
+  return writer;
+}
+
+int pt_trace_block_writer_add(Pt_Trace_Block_Writer* writer, const Pt_Trace_Block_Code* code) {
+  if (!code->size || code->size > PT_TRACE_BLOCK_MAX_INST_BYTES)
+    return -1;
+
+  /* bytes past the instruction are not part of its identity */
+  Pt_Trace_Block_Code key;
+  memset(&key, 0, sizeof(key));
+  key.pc = code->pc;
+  key.size = code->size;
+  memcpy(key.inst_bytes, code->inst_bytes, code->size);
+
+  auto inserted = writer->code_ids.emplace(std::string((const char*)&key, sizeof(key)), writer->codes.size());
+  if (inserted.second)
+    writer->codes.push_back(key);
+  uint32_t id = inserted.first->second;
+
+  int32_t delta = (int32_t)(id - writer->prev_id - 1);
+  uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+  while (zigzag >= 0x80) {
+    writer->pending.push_back((uint8_t)(zigzag | 0x80));
+    zigzag >>= 7;
+  }
+  writer->pending.push_back((uint8_t)zigzag);
+  writer->prev_id = id;
+
+  if (++writer->pending_insts == writer->block_insts)
+    return pt_trace_block_writer_flush(writer);
+  return 0;
+}
+
+int pt_trace_block_writer_close(Pt_Trace_Block_Writer* writer) {
+  int error = pt_trace_block_writer_flush(writer);
+
+  Pt_Trace_Block_Header header;
+  memcpy(header.magic, PT_TRACE_BLOCK_MAGIC, PIN_TRACE_BLOCK_MAGIC_SIZE);
+  header.block_insts = writer->block_insts;
+  header.num_codes = writer->codes.size();
+  header.num_insts = writer->num_insts;
+  header.num_blocks = writer->index.size();
+  header.code_offset = writer->offset;
+  header.index_offset = writer->offset + writer->codes.size() * sizeof(Pt_Trace_Block_Code);
+
+  if (!error && !writer->codes.empty() &&
+      fwrite(writer->codes.data(), sizeof(Pt_Trace_Block_Code), writer->codes.size(), writer->file) !=
+          writer->codes.size())
+    error = -1;
+  if (!error && !writer->index.empty() &&
+      fwrite(writer->index.data(), sizeof(Pin_Trace_Block_Entry), writer->index.size(), writer->file) !=
+          writer->index.size())
+    error = -1;
+  if (!error && (fseek(writer->file, 0, SEEK_SET) || fwrite(&header, sizeof(header), 1, writer->file) != 1))
+    error = -1;
+  if (fclose(writer->file))
+    error = -1;
+
+  delete writer;
+  return error;
+}
@@ -0,0 +1,88 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/pt_memtrace/pt_trace_block.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Preprocessed Intel PT trace container. Every distinct
+ *                (pc, size, bytes) instruction is stored once in a static code
+ *                table; the dynamic stream is a list of code table ids, split
+ *                into independently deflate-compressed blocks. Branch targets
+ *                are implicit: they are the pc of the next id in the stream.
+ *
+ *                Layout: Pt_Trace_Block_Header, compressed blocks, the
+ *                Pt_Trace_Block_Code table, then the Pin_Trace_Block_Entry
+ *                index of the blocks.
+ ***************************************************************************************/
+
+#ifndef __PT_TRACE_BLOCK_H__
+#define __PT_TRACE_BLOCK_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "frontend/pin_trace_block.h"
+
+#define PT_TRACE_BLOCK_MAGIC "SCRBPTT1"
+#define PT_TRACE_BLOCK_DEFAULT_INSTS (1 << 20)
+#define PT_TRACE_BLOCK_MAX_INST_BYTES 16
+
+typedef struct Pt_Trace_Block_Header_struct {
+  char magic[PIN_TRACE_BLOCK_MAGIC_SIZE];
+  uint32_t block_insts; /* ids per block */
+  uint32_t num_codes;   /* entries in the static code table */
+  uint64_t num_insts;
+  uint64_t num_blocks;
+  uint64_t code_offset;  /* file offset of the Pt_Trace_Block_Code array */
+  uint64_t index_offset; /* file offset of the Pin_Trace_Block_Entry array */
+} __attribute__((packed)) Pt_Trace_Block_Header;
+
+typedef struct Pt_Trace_Block_Code_struct {
+  uint64_t pc;
+  uint8_t size;
+  uint8_t inst_bytes[PT_TRACE_BLOCK_MAX_INST_BYTES];
+} __attribute__((packed)) Pt_Trace_Block_Code;
+
+typedef struct Pt_Trace_Block_Writer_struct Pt_Trace_Block_Writer;
+
+int pt_trace_block_is_container(const char* magic);
+
+/* Validates the container mapped at data and returns its header, or NULL if
+   data is not a well-formed container. */
+const Pt_Trace_Block_Header* pt_trace_block_header(const void* data, size_t size);
+
+const Pt_Trace_Block_Code* pt_trace_block_codes(const Pt_Trace_Block_Header* header);
+const Pin_Trace_Block_Entry* pt_trace_block_index(const Pt_Trace_Block_Header* header);
+
+/* Inflates one block into out, which must hold entry->num_insts ids. Every id
+   is checked against the code table. Returns 0 on success. */
+int pt_trace_block_decompress(const Pt_Trace_Block_Header* header, const Pin_Trace_Block_Entry* entry,
+                              uint32_t* out);
+
+/* Writes a container of block_insts ids per block at zlib level (-1 for the
+   default). add() looks the instruction up in the code table, adding it if it
+   is new. The writer returns NULL or nonzero on I/O or compression errors. */
+Pt_Trace_Block_Writer* pt_trace_block_writer_open(const char* path, uint32_t block_insts, int level);
+int pt_trace_block_writer_add(Pt_Trace_Block_Writer* writer, const Pt_Trace_Block_Code* code);
+int pt_trace_block_writer_close(Pt_Trace_Block_Writer* writer);
+
+#endif  // __PT_TRACE_BLOCK_H__
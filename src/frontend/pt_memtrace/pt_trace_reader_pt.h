@@ -30,16 +30,22 @@
  ***************************************************************************************/
 #ifndef __PT_TRACE_READER_PT_H__
 #define __PT_TRACE_READER_PT_H__
+#include <fcntl.h>
 #include <map>
 #include <sstream>
 #include <stdlib.h>
+#include <string.h>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 #include <zlib.h>
 
 #include "general.param.h"
 
 #include "frontend/pt_memtrace/memtrace_trace_reader.h"
+#include "frontend/pt_memtrace/pt_trace_block.h"
 
 #define GZ_BUFFER_SIZE 80
 #define panic(...) printf(__VA_ARGS__)
@@ -48,6 +54,7 @@ struct PTInst {
   uint64_t pc;
   uint8_t size;
   uint8_t inst_bytes[16];
+  int64_t code_id;  // static code table index in a preprocessed trace, -1 otherwise
 };
 
 class TraceReaderPT : public TraceReader {
@@ -63,16 +70,62 @@ class TraceReaderPT : public TraceReader {
   uint64_t num_direct_brs_in_trace = 0, num_inserted_direct_brs = 0;
   std::vector<std::string> parsed;
 
- public:
-  bool read_next_line(PTInst &inst) {
-    static uns64 num_nops_at_start = 0;
-    if (num_nops_at_start <=
-        NUM_NOPS) {  // = is because the last one will be overwritten as a JMP to the real instruction stream
-      inst.pc = NOPS_BB_START + num_nops_at_start++;
-      inst.size = 1;
-      inst.inst_bytes[0] = 0x90;
-      return true;
+  // Preprocessed trace (utils/pt_trace_blocks), mapped instead of raw_file
+  void *block_map = nullptr;
+  size_t block_map_size = 0;
+  const Pt_Trace_Block_Header *block_header = nullptr;
+  const Pt_Trace_Block_Code *block_codes = nullptr;
+  std::vector<uint32_t> block_ids;
+  size_t block_pos = 0;
+  uint64_t next_block = 0;
+  std::vector<XedCacheEntry *> code_xed;  // decoded instruction of each static code table entry
+
+  bool open_block_trace(const std::string &_trace) {
+    int fd = open(_trace.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat st;
+    char magic[PIN_TRACE_BLOCK_MAGIC_SIZE];
+    if (fstat(fd, &st) || read(fd, magic, sizeof(magic)) != sizeof(magic) || !pt_trace_block_is_container(magic)) {
+      close(fd);
+      return false;
+    }
+    block_map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (block_map == MAP_FAILED) {
+      block_map = nullptr;
+      throw "TraceReaderPT: Could not map preprocessed trace";
+    }
+    block_map_size = st.st_size;
+    block_header = pt_trace_block_header(block_map, block_map_size);
+    if (!block_header)
+      throw "TraceReaderPT: Malformed preprocessed trace";
+    madvise(block_map, block_map_size, MADV_SEQUENTIAL);
+    block_codes = pt_trace_block_codes(block_header);
+    code_xed.assign(block_header->num_codes, nullptr);
+    return true;
+  }
+
+  bool read_block_line(PTInst &inst) {
+    if (block_pos == block_ids.size()) {
+      if (next_block == block_header->num_blocks)
+        return false;
+      const Pin_Trace_Block_Entry *entry = &pt_trace_block_index(block_header)[next_block++];
+      block_ids.resize(entry->num_insts);
+      if (pt_trace_block_decompress(block_header, entry, block_ids.data()))
+        throw "TraceReaderPT: Corrupt block in preprocessed trace";
+      block_pos = 0;
     }
+    uint32_t id = block_ids[block_pos++];
+    const Pt_Trace_Block_Code *code = &block_codes[id];
+    inst.pc = code->pc;
+    inst.size = code->size;
+    memcpy(inst.inst_bytes, code->inst_bytes, sizeof(inst.inst_bytes));
+    inst.code_id = id;
+    return true;
+  }
+
+  bool read_text_line(PTInst &inst) {
     if (raw_file == NULL)
       return false;
     char buffer[GZ_BUFFER_SIZE];
@@ -100,6 +153,23 @@ class TraceReaderPT : public TraceReader {
       }
       inst.inst_bytes[found++] = strtoul(parsed[i].c_str(), NULL, 16);
     }
+    inst.code_id = -1;
+    return true;
+  }
+
+ public:
+  bool read_next_line(PTInst &inst) {
+    static uns64 num_nops_at_start = 0;
+    if (num_nops_at_start <=
+        NUM_NOPS) {  // = is because the last one will be overwritten as a JMP to the real instruction stream
+      inst.pc = NOPS_BB_START + num_nops_at_start++;
+      inst.size = 1;
+      inst.inst_bytes[0] = 0x90;
+      inst.code_id = -1;
+      return true;
+    }
+    if (!(block_header ? read_block_line(inst) : read_text_line(inst)))
+      return false;
 
     if (enable_code_bloat_effect && (prev_to_new_bbl_address_map != nullptr)) {
       uint64_t result = inst.pc;
@@ -143,19 +213,19 @@ class TraceReaderPT : public TraceReader {
   bool processInst(PTInst &next_line) {
     /*std::cout << "Processing Inst w/ PC: " << std::hex << next_line.pc << " byt " << *((int*)next_line.inst_bytes) <<
      * std::endl; */
-    // Get the XED info from the cache, creating it if needed
-    auto xed_map_iter = xed_map_.find(next_line.pc);
-    if (xed_map_iter == xed_map_.end()) {
-      fillCache(next_line.pc, next_line.size, next_line.inst_bytes);
-      xed_map_iter = xed_map_.find(next_line.pc);
-      assert((xed_map_iter != xed_map_.end()));
+    // Get the XED info from the cache, creating it if needed. Preprocessed traces remember it per static
+    // instruction, so only the first instance of each instruction is looked up.
+    XedCacheEntry *entry = next_line.code_id >= 0 ? code_xed[next_line.code_id] : nullptr;
+    if (!entry) {
+      entry = findXed(next_line.pc);
+      if (!entry)
+        entry = fillCache(next_line.pc, next_line.size, next_line.inst_bytes);
+      if (next_line.code_id >= 0)
+        code_xed[next_line.code_id] = entry;
     }
-    bool unknown_type, cond_branch;
-    int mem_ops_;
-    xed_decoded_inst_t *xed_ins;
-    auto &xed_tuple = (*xed_map_iter).second;
-    tie(mem_ops_, unknown_type, cond_branch, std::ignore, std::ignore) = xed_tuple;
-    xed_ins = std::get<MAP_XED>(xed_tuple).get();
+    bool unknown_type = entry->unknown;
+    int mem_ops_ = entry->mem_ops;
+    xed_decoded_inst_t *xed_ins = &entry->ins;
     InstInfo &_info = (use_info_a ? inst_info_a : inst_info_b);
     InstInfo &_prior = (use_info_a ? inst_info_b : inst_info_a);
     auto &ins = _prior;  // have to do this for the macros to work
@@ -248,8 +318,9 @@ class TraceReaderPT : public TraceReader {
   }
   TraceReaderPT(const std::string &_trace, bool _enable_code_bloat_effect = false,
                 std::map<uint64_t, uint64_t> *_prev_to_new_bbl_address_map = nullptr) {
-    raw_file = gzopen(_trace.c_str(), "rb");
-    if (!raw_file) {
+    if (!open_block_trace(_trace))
+      raw_file = gzopen(_trace.c_str(), "rb");
+    if (!raw_file && !block_header) {
       panic("TraceReaderPT: Invalid GZ File");
       throw "Could not open file";
     }
@@ -257,6 +328,7 @@ class TraceReaderPT : public TraceReader {
     prev_to_new_bbl_address_map = _prev_to_new_bbl_address_map;
     inst_info_a.valid = false;
     inst_info_b.valid = false;
+    trace_ = _trace;
     init("");
     initTrace();
   }
@@ -293,6 +365,8 @@ class TraceReaderPT : public TraceReader {
               << ", ratio: " << double(num_inserted_direct_brs) / double(num_direct_brs_in_trace) << std::endl;
     if (raw_file != NULL)
       gzclose(raw_file);
+    if (block_map)
+      munmap(block_map, block_map_size);
   }
 };
 
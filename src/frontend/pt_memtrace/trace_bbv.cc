@@ -0,0 +1,369 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/pt_memtrace/trace_bbv.cc
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Streaming BBV extraction. The simulation thread only forms
+ *                basic blocks and bumps per-segment counters in flat
+ *                open-addressed tables keyed on the block's start PC (or
+ *                its id) and on the fetched PCs. A finished segment is
+ *                handed to one of TRACE_BBV_THREADS workers, which sort and
+ *                format its vectors, and is written out once all earlier
+ *                segments are. The trace itself is read sequentially; its
+ *                decoding overlaps with the extraction when
+ *                TRACE_DECODE_QUEUE_DEPTH is set.
+ ***************************************************************************************/
+
+extern "C" {
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "general.param.h"
+}
+
+#include "frontend/pt_memtrace/trace_bbv.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sim.h"
+
+/**************************************************************************************/
+/* Bbv_Count_Map */
+
+/* Counters keyed on nonzero 64-bit keys, with linear probing. A slot with key
+   0 is free; the table is at most half full. */
+class Bbv_Count_Map {
+ public:
+  Bbv_Count_Map() : slots(64), used(0) {}
+
+  uint64_t &operator[](uint64_t key) {
+    if (2 * (used + 1) > slots.size())
+      grow();
+    Slot *slot = find(key);
+    if (!slot->key) {
+      slot->key = key;
+      used++;
+    }
+    return slot->count;
+  }
+
+  bool empty() const { return !used; }
+
+  /* The used slots sorted by key, as the vectors are printed */
+  std::vector<std::pair<uint64_t, uint64_t>> sorted() const {
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    entries.reserve(used);
+    for (const Slot &slot : slots) {
+      if (slot.key)
+        entries.emplace_back(slot.key, slot.count);
+    }
+    std::sort(entries.begin(), entries.end());
+    return entries;
+  }
+
+ private:
+  struct Slot {
+    uint64_t key = 0;
+    uint64_t count = 0;
+  };
+
+  std::vector<Slot> slots;
+  size_t used;
+
+  Slot *find(uint64_t key) {
+    size_t mask = slots.size() - 1;
+    size_t idx = (key * 0x9E3779B97F4A7C15ULL) >> 32 & mask;
+    while (slots[idx].key && slots[idx].key != key)
+      idx = (idx + 1) & mask;
+    return &slots[idx];
+  }
+
+  void grow() {
+    std::vector<Slot> old(2 * slots.size());
+    old.swap(slots);
+    for (const Slot &slot : old) {
+      if (slot.key)
+        *find(slot.key) = slot;
+    }
+  }
+};
+
+/**************************************************************************************/
+/* Segments */
+
+struct Bbv_Segment {
+  Bbv_Count_Map bbv;
+  Bbv_Count_Map footprint;
+  std::string bbv_line;
+  std::string footprint_line;
+  uint64_t bbv_insts = 0;
+  uint64_t footprint_insts = 0;
+  bool formatted = false;
+};
+
+/* Formats a vector the way SimPoint reads it: "T:key:count ..." per line */
+static uint64_t format_vector(const Bbv_Count_Map &map, std::string *line) {
+  uint64_t insts = 0;
+  char buf[64];
+  for (const auto &entry : map.sorted()) {
+    snprintf(buf, sizeof(buf), "%s:%lu:%lu ", line->empty() ? "T" : "", entry.first, entry.second);
+    line->append(buf);
+    insts += entry.second;
+  }
+  line->push_back('\n');
+  return insts;
+}
+
+/* Formats segments on worker threads and appends them to the output files in
+   segment order. At most twice as many segments as workers are in flight. */
+class Bbv_Writer {
+ public:
+  Bbv_Writer(uns num_threads) : exiting(false) {
+    bbv_file = fopen(TRACE_BBV_OUTPUT, "a");
+    ASSERTM(0, bbv_file, "Could not open BBV output %s\n", TRACE_BBV_OUTPUT);
+    footprint_file = NULL;
+    if (TRACE_FOOTPRINT_OUTPUT && *TRACE_FOOTPRINT_OUTPUT) {
+      footprint_file = fopen(TRACE_FOOTPRINT_OUTPUT, "a");
+      ASSERTM(0, footprint_file, "Could not open footprint output %s\n", TRACE_FOOTPRINT_OUTPUT);
+    }
+    max_in_flight = 2 * std::max(num_threads, 1u);
+    for (uns ii = 0; ii < num_threads; ii++)
+      workers.emplace_back(&Bbv_Writer::worker_main, this);
+  }
+
+  ~Bbv_Writer() {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      drain(lock, 0);
+      exiting = true;
+    }
+    work_cv.notify_all();
+    for (std::thread &worker : workers)
+      worker.join();
+    fclose(bbv_file);
+    if (footprint_file)
+      fclose(footprint_file);
+  }
+
+  bool has_footprint() const { return footprint_file != NULL; }
+
+  void submit(std::unique_ptr<Bbv_Segment> segment) {
+    if (workers.empty()) {
+      format(segment.get());
+      write(segment.get());
+      return;
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    drain(lock, max_in_flight - 1);
+    in_flight.push_back(std::move(segment));
+    to_format.push_back(in_flight.back().get());
+    lock.unlock();
+    work_cv.notify_one();
+  }
+
+ private:
+  FILE *bbv_file;
+  FILE *footprint_file;
+  size_t max_in_flight;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable work_cv;  // workers wait for segments to format
+  std::condition_variable done_cv;  // the reader waits for formatted segments
+  std::deque<std::unique_ptr<Bbv_Segment>> in_flight;  // in segment order
+  std::deque<Bbv_Segment *> to_format;
+  bool exiting;
+
+  void format(Bbv_Segment *segment) {
+    segment->bbv_insts = format_vector(segment->bbv, &segment->bbv_line);
+    if (footprint_file)
+      segment->footprint_insts = format_vector(segment->footprint, &segment->footprint_line);
+  }
+
+  void write(const Bbv_Segment *segment) {
+    fputs(segment->bbv_line.c_str(), bbv_file);
+    if (footprint_file) {
+      fputs(segment->footprint_line.c_str(), footprint_file);
+      ASSERT(0, segment->bbv_insts == segment->footprint_insts);
+    }
+  }
+
+  /* Writes formatted segments from the front until at most max are left */
+  void drain(std::unique_lock<std::mutex> &lock, size_t max) {
+    while (in_flight.size() > max) {
+      done_cv.wait(lock, [this] { return in_flight.front()->formatted; });
+      write(in_flight.front().get());
+      in_flight.pop_front();
+    }
+  }
+
+  void worker_main() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+      work_cv.wait(lock, [this] { return exiting || !to_format.empty(); });
+      if (to_format.empty())
+        return;
+      Bbv_Segment *segment = to_format.front();
+      to_format.pop_front();
+      lock.unlock();
+      format(segment);
+      lock.lock();
+      segment->formatted = true;
+      done_cv.notify_one();
+    }
+  }
+};
+
+/**************************************************************************************/
+/* trace_bbv_extract: follows ext_trace_extract_basic_block_vectors() block for
+   block, so both write the same vectors */
+
+void trace_bbv_extract(int proc_id, ctype_pin_inst *inst, Trace_Bbv_Read_Func read) {
+  ASSERTM(proc_id, TRACE_BBV_OUTPUT, "TRACE_BBV_OUTPUT is needed to extract basic block vectors\n");
+  const uint64_t segment_size = SEGMENT_INSTR_COUNT ? SEGMENT_INSTR_COUNT : std::numeric_limits<uint64_t>::max();
+
+  Bbv_Writer writer(TRACE_BBV_THREADS);
+  std::unique_ptr<Bbv_Segment> segment(new Bbv_Segment());
+  Bbv_Count_Map block_ids;  // start PC -> id, in order of first execution
+  uint64_t num_blocks = 0, num_blocks_size = 0;
+  uint64_t num_segments = 0;
+  uint64_t total_insts = 0, total_fetched = 0, blocks_executed = 0;
+  uint64_t seg_insts = 0, seg_fetched = 0;
+
+  // the current block
+  std::vector<uint8_t> block_fetched;  // per instruction
+  Addr block_pc = 0;
+  uint64_t block_fetched_count = 0;
+
+  auto seg_count = [&]() { return USE_FETCHED_COUNT ? seg_fetched : seg_insts; };
+
+  int success = true;
+  while (success) {
+    if (inst->instruction_next_addr != inst->instruction_addr + inst->size) {
+      ASSERT(proc_id, inst->cf_type || inst->is_repeat || inst->last_inst_from_trace);
+    }
+    if (block_fetched.empty())
+      block_pc = inst->instruction_addr;
+    block_fetched.push_back(inst->fetched_instruction);
+    if (inst->fetched_instruction) {
+      block_fetched_count++;
+      if (writer.has_footprint())
+        segment->footprint[inst->instruction_addr]++;
+    }
+    Flag last_cf = inst->cf_type != 0;
+    Flag last_rep = inst->is_repeat;
+
+    success = read(proc_id, inst);
+
+    // a block ends at a cf, at the trace end, and around a rep (each rep
+    // iteration is a block of its own)
+    if (!last_cf && success && !last_rep && !inst->is_repeat)
+      continue;
+
+    uint64_t block_size = block_fetched.size();
+    uint64_t &block_id = block_ids[block_pc];
+    if (!block_id) {
+      ASSERT(proc_id, block_size == block_fetched_count);
+      block_id = ++num_blocks;
+      num_blocks_size += block_size;
+    }
+    uint64_t key = SIM_MODE == TRACE_BBV_MODE ? block_id : block_pc;
+
+    if (block_fetched_count)
+      blocks_executed++;
+    total_insts += block_size;
+    total_fetched += block_fetched_count;
+    seg_insts += block_size;
+    seg_fetched += block_fetched_count;
+    if (SIM_MODE == TRACE_BBV_DISTRIBUTED_MODE)
+      ASSERT(proc_id, seg_fetched <= segment_size);
+    if (seg_fetched == segment_size)
+      ASSERT(proc_id, !success);
+
+    // split a block that crosses the segment boundary
+    uint64_t to_last = block_size, to_new = 0, to_new_fetched = 0;
+    if (seg_count() > segment_size) {
+      seg_insts -= block_size;
+      seg_fetched -= block_fetched_count;
+      to_last = 0;
+      for (uint8_t fetched : block_fetched) {
+        if (seg_count() == segment_size) {
+          to_new++;
+          to_new_fetched += fetched;
+        } else {
+          seg_insts++;
+          seg_fetched += fetched;
+          to_last++;
+        }
+      }
+      ASSERT(proc_id, to_new > 0 && seg_count() == segment_size);
+    }
+
+    if (block_fetched_count)
+      segment->bbv[key] += to_last;
+
+    if (seg_count() == segment_size) {
+      num_segments++;
+      writer.submit(std::move(segment));
+      segment.reset(new Bbv_Segment());
+      seg_insts = to_new;
+      seg_fetched = to_new_fetched;
+      if (to_new)
+        segment->bbv[key] = to_new;
+    }
+
+    block_fetched.clear();
+    block_fetched_count = 0;
+
+    if (!success && !segment->bbv.empty()) {
+      num_segments++;
+      writer.submit(std::move(segment));
+      segment.reset(new Bbv_Segment());
+    }
+  }
+
+  printf(
+      "========================================================\n"
+      "Number of segments     : %lu\n"
+      "Number of blocks built : %lu\n"
+      "     Average size      : %5.2lf instructions\n"
+      "Number of blocks executed  : %lu\n"
+      "     Average weighted size : %5.2lf instructions\n"
+      "Number of total instructions  : %lu\n"
+      "Number of fetched instruction : %lu\n"
+      "========================================================\n",
+      num_segments, num_blocks, num_blocks_size / (double)num_blocks, blocks_executed,
+      total_insts / (double)blocks_executed, total_insts, total_fetched);
+}
@@ -0,0 +1,49 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/pt_memtrace/trace_bbv.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Streaming basic block vector extraction for SimPoint
+ *                (TRACE_BBV_STREAMING). Writes the same TRACE_BBV_OUTPUT and
+ *                TRACE_FOOTPRINT_OUTPUT files as
+ *                ext_trace_extract_basic_block_vectors(), without its
+ *                per-block debug output.
+ ***************************************************************************************/
+
+#ifndef __TRACE_BBV_H__
+#define __TRACE_BBV_H__
+
+#include "globals/global_types.h"
+
+#include "ctype_pin_inst.h"
+
+/**************************************************************************************/
+/* Prototypes */
+
+typedef int (*Trace_Bbv_Read_Func)(int proc_id, ctype_pin_inst *pi);
+
+/* Reads the rest of the core's trace with read(), starting with the already
+   read instruction in *inst */
+void trace_bbv_extract(int proc_id, ctype_pin_inst *inst, Trace_Bbv_Read_Func read);
+
+#endif  // __TRACE_BBV_H__
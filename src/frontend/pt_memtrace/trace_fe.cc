@@ -1,10 +1,14 @@
 #include "trace_fe.h"
 
+#include <atomic>
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <limits>
 #include <map>
+#include <mutex>
+#include <thread>
 
 #include "bp/bp.param.h"
 
@@ -12,6 +16,9 @@
 #include "frontend/frontend_intf.h"
 #include "frontend/pt_memtrace/memtrace_fe.h"
 #include "frontend/pt_memtrace/pt_fe.h"
+#include "frontend/pt_memtrace/trace_bbv.h"
+#include "frontend/pt_memtrace/trace_stream.h"
+#include "frontend/static_code_image.h"
 #include "isa/isa.h"
 #include "pin/pin_lib/uop_generator.h"
 #include "pin/pin_lib/x86_decoder.h"
@@ -40,49 +47,236 @@ static ctype_pin_inst next_onpath_pi[MAX_NUM_PROCS];
 static ctype_pin_inst next_offpath_pi[MAX_NUM_PROCS];
 static bool off_path_mode[MAX_NUM_PROCS] = {false};
 static uint64_t off_path_addr[MAX_NUM_PROCS] = {0};
-static std::unordered_map<uint64_t, ctype_pin_inst> pc_to_inst;
+/* Code seen so far, for off-path fetch: every on-path instruction, and
+   provisionally the ones read into the lookahead buffer */
+static Static_Code_Image static_code;
 
-uint64_t rdptr = 0;
-uint64_t wrptr = 0;
-std::vector<ctype_pin_inst> circ_buf;
-std::unordered_map<Addr, Counter> buf_map;
 const int CLINE = ~0x3F;
 
+/* Per-core lookahead of TRACE_BUF_SIZE on-path instructions. lines counts the
+   buffered instructions of every cache line in an open-addressed table with
+   linear probing; a slot with count 0 is free. The table has at least twice
+   as many slots as the buffer has instructions, so probes stay short. */
+struct Trace_Buf_Line {
+  Addr line_addr;
+  uns count;
+};
+
+struct Trace_Buf {
+  std::vector<ctype_pin_inst> insts;
+  uint64_t rdptr;
+  uint64_t wrptr;
+  std::vector<Trace_Buf_Line> lines;
+  uns lines_shift;
+};
+
+static Trace_Buf trace_bufs[MAX_NUM_PROCS];
+
 extern uint64_t ins_id;
 extern uint64_t ins_id_fetched;
 
-Flag buf_map_find(Addr line_addr) {
-  return buf_map.find(line_addr) != buf_map.end();
+/**************************************************************************************/
+/* Asynchronous decode (TRACE_DECODE_QUEUE_DEPTH) */
+
+struct Trace_Decode_Entry {
+  ctype_pin_inst pi;
+  int ret;
+  Flag filled;
+};
+
+/* Runs the trace reader of one core on its own host thread, ahead of the
+   simulation. Decoded instructions are handed over through a single-producer
+   single-consumer ring, so neither side takes a lock on the common path. */
+class Trace_Decoder {
+ public:
+  Trace_Decoder(uns proc_id, uns depth);
+  ~Trace_Decoder();
+  int read(ctype_pin_inst *pi);
+
+ private:
+  uns proc_id;
+  std::vector<Trace_Decode_Entry> ring;
+  uint64_t mask;
+  alignas(64) std::atomic<uint64_t> head;  // next entry to consume, written by the simulation
+  alignas(64) std::atomic<uint64_t> tail;  // next entry to produce, written by the decoder
+  std::atomic<bool> stop;
+  bool done;  // the consumer has seen the last entry
+  std::thread thread;
+
+  void produce();
+};
+
+static Trace_Decoder *trace_decoders[MAX_NUM_PROCS];
+/* The readers share state across cores (instruction counters, the pid/tid
+   filter, the gather/scatter table), so their decode threads take turns */
+static std::mutex trace_decode_mutex;
+
+static void trace_decode_backoff(uns spins) {
+  if (spins < 1024)
+    std::this_thread::yield();
+  else
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
 }
 
-// inserts the inst written to write_ptr location
-void buf_map_insert() {
-  Addr line_addr = circ_buf[wrptr].instruction_addr & CLINE;
-  auto it = buf_map.find(line_addr);
-  if (it != buf_map.end()) {
-    it->second++;
-  } else {
-    buf_map.insert(std::pair<Addr, Counter>(line_addr, 1));
+static int trace_decode(uns proc_id, ctype_pin_inst *pi, Flag *filled) {
+  if (FRONTEND == FE_PT)
+    return pt_trace_decode(proc_id, pi, filled);
+  ASSERT(proc_id, FRONTEND == FE_MEMTRACE);
+  return memtrace_trace_decode(proc_id, pi, filled);
+}
+
+Trace_Decoder::Trace_Decoder(uns proc_id, uns depth)
+    : proc_id(proc_id), head(0), tail(0), stop(false), done(false) {
+  uns size = 1;
+  while (size < depth)
+    size <<= 1;
+  ring.resize(size);
+  mask = size - 1;
+  thread = std::thread(&Trace_Decoder::produce, this);
+}
+
+Trace_Decoder::~Trace_Decoder() {
+  stop.store(true, std::memory_order_relaxed);
+  thread.join();
+}
+
+/* Decodes until the reader reports the end of the trace (or of the ROI); the
+   trace is never read past that point, as in the synchronous path. */
+void Trace_Decoder::produce() {
+  uint64_t pos = tail.load(std::memory_order_relaxed);
+  while (true) {
+    uns spins = 0;
+    while (pos - head.load(std::memory_order_acquire) == ring.size()) {
+      if (stop.load(std::memory_order_relaxed))
+        return;
+      trace_decode_backoff(spins++);
+    }
+    if (stop.load(std::memory_order_relaxed))
+      return;
+
+    Trace_Decode_Entry *entry = &ring[pos & mask];
+    {
+      std::lock_guard<std::mutex> lock(trace_decode_mutex);
+      entry->ret = trace_decode(proc_id, &entry->pi, &entry->filled);
+    }
+    tail.store(++pos, std::memory_order_release);
+    if (!entry->ret)
+      return;
   }
-  wrptr = (wrptr + 1) % TRACE_BUF_SIZE;
 }
 
-void buf_map_remove() {
-  Addr line_addr = circ_buf[rdptr].instruction_addr & CLINE;
-  auto it = buf_map.find(line_addr);
-  assert(it != buf_map.end());
-  if (it->second > 1) {
-    it->second--;
-  } else {
-    buf_map.erase(it);
+int Trace_Decoder::read(ctype_pin_inst *pi) {
+  if (done)
+    return 0;
+
+  uint64_t pos = head.load(std::memory_order_relaxed);
+  uns spins = 0;
+  while (tail.load(std::memory_order_acquire) == pos)
+    trace_decode_backoff(spins++);
+
+  const Trace_Decode_Entry *entry = &ring[pos & mask];
+  int ret = entry->ret;
+  if (entry->filled) {
+    *pi = entry->pi;
+    if (FRONTEND == FE_MEMTRACE)
+      memtrace_trace_markers(proc_id, pi);
+  }
+  done = !ret;
+  head.store(pos + 1, std::memory_order_release);
+  return ret;
+}
+
+static void trace_decoders_init() {
+  /* the shared stream decodes on the simulation thread; a decode thread of
+     another core would race with it on the readers' shared state */
+  if (!TRACE_DECODE_QUEUE_DEPTH || TRACE_SHARED_DECODE_DIR)
+    return;
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    trace_decoders[proc_id] = new Trace_Decoder(proc_id, TRACE_DECODE_QUEUE_DEPTH);
+}
+
+static void trace_decoders_done() {
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    delete trace_decoders[proc_id];
+    trace_decoders[proc_id] = NULL;
+  }
+}
+
+/* Reads the next on-path instruction from the core's shared decode stream, its
+   decode thread, or from the trace reader directly */
+static int trace_backend_read(uns proc_id, ctype_pin_inst *pi) {
+  if (trace_stream_active(proc_id))
+    return trace_stream_read(proc_id, pi);
+  if (trace_decoders[proc_id])
+    return trace_decoders[proc_id]->read(pi);
+  if (FRONTEND == FE_PT)
+    return pt_trace_read(proc_id, pi);
+  else if (FRONTEND == FE_MEMTRACE)
+    return memtrace_trace_read(proc_id, pi);
+  return 0;
+}
+
+/**************************************************************************************/
+/* Lookahead buffer (TRACE_BUF_SIZE) */
+
+static inline uns64 trace_buf_line_slot(const Trace_Buf *buf, Addr line_addr) {
+  return ((line_addr >> 6) * 0x9E3779B97F4A7C15ull) >> buf->lines_shift;
+}
+
+Flag buf_map_find(uns proc_id, Addr line_addr) {
+  const Trace_Buf *buf = &trace_bufs[proc_id];
+  if (buf->lines.empty())
+    return FALSE;
+  uns64 mask = buf->lines.size() - 1;
+  for (uns64 slot = trace_buf_line_slot(buf, line_addr);; slot = (slot + 1) & mask) {
+    const Trace_Buf_Line *line = &buf->lines[slot];
+    if (!line->count)
+      return FALSE;
+    if (line->line_addr == line_addr)
+      return TRUE;
+  }
+}
+
+// inserts the inst written to write_ptr location
+static void buf_map_insert(Trace_Buf *buf) {
+  Addr line_addr = buf->insts[buf->wrptr].instruction_addr & CLINE;
+  uns64 mask = buf->lines.size() - 1;
+  uns64 slot = trace_buf_line_slot(buf, line_addr);
+  while (buf->lines[slot].count && buf->lines[slot].line_addr != line_addr)
+    slot = (slot + 1) & mask;
+  buf->lines[slot].line_addr = line_addr;
+  buf->lines[slot].count++;
+  buf->wrptr = (buf->wrptr + 1) % TRACE_BUF_SIZE;
+}
+
+// removes the inst at the read_ptr location, closing the probe gap behind it
+static void buf_map_remove(Trace_Buf *buf) {
+  Addr line_addr = buf->insts[buf->rdptr].instruction_addr & CLINE;
+  uns64 mask = buf->lines.size() - 1;
+  uns64 slot = trace_buf_line_slot(buf, line_addr);
+  while (buf->lines[slot].line_addr != line_addr || !buf->lines[slot].count) {
+    assert(buf->lines[slot].count);
+    slot = (slot + 1) & mask;
+  }
+  buf->rdptr = (buf->rdptr + 1) % TRACE_BUF_SIZE;
+  if (--buf->lines[slot].count)
+    return;
+
+  for (uns64 next = (slot + 1) & mask; buf->lines[next].count; next = (next + 1) & mask) {
+    uns64 home = trace_buf_line_slot(buf, buf->lines[next].line_addr);
+    /* move next back if its home is not cyclically within (slot, next] */
+    if (((next - home) & mask) >= ((next - slot) & mask)) {
+      buf->lines[slot] = buf->lines[next];
+      buf->lines[next].count = 0;
+      slot = next;
+    }
   }
-  rdptr = (rdptr + 1) % TRACE_BUF_SIZE;
 }
 
 void off_path_generate_inst(uns proc_id, uint64_t *off_path_addr, ctype_pin_inst *inst) {
-  auto op_iter = pc_to_inst.find(*off_path_addr);
-  if (op_iter != pc_to_inst.end()) {
-    *inst = op_iter->second;
+  const ctype_pin_inst *known = static_code.find(*off_path_addr);
+  if (known) {
+    *inst = *known;
     *off_path_addr += inst->size;
     DEBUG(proc_id, "Generate off-path inst:%lx inst_size:%i ", inst->instruction_addr, inst->size);
   } else {
@@ -192,41 +386,40 @@ void trace_buf_init() {
   if (!TRACE_BUF_SIZE)
     return;
 
+  uns num_lines = 1;
+  uns lines_shift = 64;
+  while (num_lines < 2 * TRACE_BUF_SIZE) {
+    num_lines <<= 1;
+    lines_shift--;
+  }
+
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    circ_buf.resize(TRACE_BUF_SIZE);
-    rdptr = 0;
-    wrptr = 0;
-    if (FRONTEND == FE_PT) {
-      for (uint i = 0; i < TRACE_BUF_SIZE; i++) {
-        pt_trace_read(proc_id, &circ_buf[wrptr]);
-        buf_map_insert();
-      }
-    } else if (FRONTEND == FE_MEMTRACE) {
-      for (uint i = 0; i < TRACE_BUF_SIZE; i++) {
-        memtrace_trace_read(proc_id, &circ_buf[wrptr]);
-        buf_map_insert();
-      }
+    Trace_Buf *buf = &trace_bufs[proc_id];
+    buf->insts.resize(TRACE_BUF_SIZE);
+    buf->rdptr = 0;
+    buf->wrptr = 0;
+    buf->lines.assign(num_lines, Trace_Buf_Line{0, 0});
+    buf->lines_shift = lines_shift;
+    for (uint i = 0; i < TRACE_BUF_SIZE; i++) {
+      if (trace_backend_read(proc_id, &buf->insts[buf->wrptr]))
+        static_code.add(buf->insts[buf->wrptr]);
+      buf_map_insert(buf);
     }
   }
 }
 
 int trace_read(int proc_id, ctype_pin_inst *next_onpath_pi) {
-  if (!TRACE_BUF_SIZE) {
-    if (FRONTEND == FE_PT)
-      return pt_trace_read(proc_id, next_onpath_pi);
-    else if (FRONTEND == FE_MEMTRACE)
-      return memtrace_trace_read(proc_id, next_onpath_pi);
-  }
+  if (!TRACE_BUF_SIZE)
+    return trace_backend_read(proc_id, next_onpath_pi);
 
   ASSERT(0, TRACE_BUF_SIZE);
-  *next_onpath_pi = circ_buf[rdptr];
-  buf_map_remove();
-  int ret = 0;
-  if (FRONTEND == FE_PT)
-    ret = pt_trace_read(proc_id, &circ_buf[wrptr]);
-  else if (FRONTEND == FE_MEMTRACE)
-    ret = memtrace_trace_read(proc_id, &circ_buf[wrptr]);
-  buf_map_insert();
+  Trace_Buf *buf = &trace_bufs[proc_id];
+  *next_onpath_pi = buf->insts[buf->rdptr];
+  buf_map_remove(buf);
+  int ret = trace_backend_read(proc_id, &buf->insts[buf->wrptr]);
+  if (ret)
+    static_code.add(buf->insts[buf->wrptr]);
+  buf_map_insert(buf);
   return ret;
 }
 
@@ -252,41 +445,38 @@ void ext_trace_fetch_op(uns proc_id, Op *op) {
         op->exit = TRUE;
       } else {
         uint64_t addr = next_onpath_pi[proc_id].instruction_addr;
-        auto find = pc_to_inst.find(addr);
-        if (find == pc_to_inst.end()) {
-          pc_to_inst.insert(std::pair<uint64_t, ctype_pin_inst>(addr, next_onpath_pi[proc_id]));
+        bool provisional = false;
+        const ctype_pin_inst *find = static_code.find(addr, &provisional);
+        if (!find || provisional) {
+          static_code.set(next_onpath_pi[proc_id]);
         } else if (next_onpath_pi[proc_id].encoding_is_new) {
           STAT_EVENT(proc_id, INST_MAP_UPDATE_ENCODING);
-          pc_to_inst.erase(addr);
-          pc_to_inst.insert(std::pair<uint64_t, ctype_pin_inst>(addr, next_onpath_pi[proc_id]));
-        } else if (next_onpath_pi[proc_id].inst_binary_lsb != find->second.inst_binary_lsb ||
-                   next_onpath_pi[proc_id].inst_binary_msb != find->second.inst_binary_msb) {
+          static_code.set(next_onpath_pi[proc_id]);
+        } else if (next_onpath_pi[proc_id].inst_binary_lsb != find->inst_binary_lsb ||
+                   next_onpath_pi[proc_id].inst_binary_msb != find->inst_binary_msb) {
           DEBUG(proc_id, "Previously seen PC references new instruction addr:%lx inst_size:%i lsb:%lx msb:%lx\n ", addr,
                 next_onpath_pi[proc_id].size, next_onpath_pi[proc_id].inst_binary_lsb,
                 next_onpath_pi[proc_id].inst_binary_msb);
           // Handle jitted code
           STAT_EVENT(proc_id, INST_MAP_UPDATE_JITTED);
-          pc_to_inst.erase(addr);
-          pc_to_inst.insert(std::pair<uint64_t, ctype_pin_inst>(addr, next_onpath_pi[proc_id]));
-        } else if (next_onpath_pi[proc_id].instruction_next_addr != find->second.instruction_next_addr) {
-          ASSERT(proc_id, next_onpath_pi[proc_id].op_type == find->second.op_type);
+          static_code.set(next_onpath_pi[proc_id]);
+        } else if (next_onpath_pi[proc_id].instruction_next_addr != find->instruction_next_addr) {
+          ASSERT(proc_id, next_onpath_pi[proc_id].op_type == find->op_type);
           if (next_onpath_pi[proc_id].cf_type) {
-            ASSERT(proc_id, next_onpath_pi[proc_id].cf_type == find->second.cf_type);
+            ASSERT(proc_id, next_onpath_pi[proc_id].cf_type == find->cf_type);
             // This can fail for java pt traces
             // ASSERT(proc_id, next_onpath_pi[proc_id].cf_type == CF_CBR ||
             //                 next_onpath_pi[proc_id].cf_type >= CF_IBR ||
             //                 next_onpath_pi[proc_id].last_inst_from_trace);
           }
           STAT_EVENT(proc_id, INST_MAP_UPDATE_NPC_INV + next_onpath_pi[proc_id].op_type);
-          pc_to_inst.erase(addr);
-          pc_to_inst.insert(std::pair<uint64_t, ctype_pin_inst>(addr, next_onpath_pi[proc_id]));
-        } else if (!ctype_pin_inst_same_mem_vaddr(next_onpath_pi[proc_id], find->second)) {
-          ASSERT(proc_id, next_onpath_pi[proc_id].op_type == find->second.op_type);
+          static_code.set(next_onpath_pi[proc_id]);
+        } else if (!ctype_pin_inst_same_mem_vaddr(next_onpath_pi[proc_id], *find)) {
+          ASSERT(proc_id, next_onpath_pi[proc_id].op_type == find->op_type);
           STAT_EVENT(proc_id, INST_MAP_UPDATE_MEM_INV + next_onpath_pi[proc_id].op_type);
-          pc_to_inst.erase(addr);
-          pc_to_inst.insert(std::pair<uint64_t, ctype_pin_inst>(addr, next_onpath_pi[proc_id]));
-        } else {
-          assert_ctype_pin_inst_same(proc_id, next_onpath_pi[proc_id], find->second);
+          static_code.set(next_onpath_pi[proc_id]);
+        } else if (ENABLE_PARANOID_ASSERTIONS) {
+          assert_ctype_pin_inst_same(proc_id, next_onpath_pi[proc_id], *find);
         }
       }
     } else {
@@ -304,6 +494,14 @@ Flag ext_trace_can_fetch_op(uns proc_id) {
     return true;
 }
 
+uns ext_trace_ready_ops(uns proc_id) {
+  return frontend_uops_ready(proc_id, ext_trace_can_fetch_op(proc_id));
+}
+
+uns ext_trace_fetch_ops(uns proc_id, Op **ops, uns max) {
+  return frontend_uops_fetch(proc_id, ops, max, ext_trace_can_fetch_op, ext_trace_fetch_op);
+}
+
 void ext_trace_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr) {
   off_path_mode[proc_id] = true;
   off_path_addr[proc_id] = fetch_addr;
@@ -327,6 +525,26 @@ void ext_trace_retire(uns proc_id, uns64 inst_uid) {
   // retired.
 }
 
+/* The skipped instructions still refresh static_code, which the off-path
+   generator reads. */
+uns64 ext_trace_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag *exited) {
+  ASSERT(proc_id, uop_generator_get_bom(proc_id) && !off_path_mode[proc_id]);
+  uns64 skipped = 0;
+  while (skipped < num_insts && !trace_read_done[proc_id]) {
+    if (warm_func)
+      frontend_skip_warm(proc_id, &next_onpath_pi[proc_id], warm_func);
+    skipped++;
+    if (!trace_read(proc_id, &next_onpath_pi[proc_id])) {
+      trace_read_done[proc_id] = TRUE;
+      reached_exit[proc_id] = TRUE;
+      *exited = TRUE;
+    } else {
+      static_code.set(next_onpath_pi[proc_id]);
+    }
+  }
+  return skipped;
+}
+
 Addr ext_trace_next_fetch_addr(uns proc_id) {
   return next_onpath_pi[proc_id].instruction_addr;
 }
@@ -340,12 +558,20 @@ void ext_trace_init() {
   else if (FRONTEND == FE_MEMTRACE)
     memtrace_init();
 
+  trace_decoders_init();
   trace_buf_init();
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
     trace_read(proc_id, &next_onpath_pi[proc_id]);
 }
 
 void ext_trace_done() {
+  trace_decoders_done();
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    trace_stream_close(proc_id);
+  if (FRONTEND == FE_PT)
+    pt_done();
+  else if (FRONTEND == FE_MEMTRACE)
+    memtrace_done();
 }
 
 // is also used to print footprint
@@ -511,6 +737,11 @@ void ext_trace_extract_basic_block_vectors() {
   uns8 proc_id = 0;
   ASSERT(proc_id, (FRONTEND == FE_PT) || (FRONTEND == FE_MEMTRACE));
 
+  if (TRACE_BBV_STREAMING) {
+    trace_bbv_extract(proc_id, &next_onpath_pi[proc_id], trace_read);
+    return;
+  }
+
   // global counters for the entire trace
   bb_counts counts_dynamic{}, counts_as_built{};
   uint64_t num_of_segments = 0;
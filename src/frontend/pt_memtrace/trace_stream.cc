@@ -0,0 +1,434 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/pt_memtrace/trace_stream.cc
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Shared decoded trace streams (TRACE_SHARED_DECODE_DIR).
+ *
+ *                A stream file is a Trace_Stream_Header page followed by one
+ *                Trace_Stream_Record per trace_decode() call. The header page
+ *                is mapped shared by every attached process; count is the
+ *                number of records that are fully written. The decoding
+ *                process holds an exclusive flock() on the file, so the role
+ *                passes to a waiting reader as soon as the decoder exits,
+ *                whether it finished its run or crashed. The new decoder
+ *                opens the trace and re-decodes the published prefix before
+ *                appending, since trace readers cannot seek.
+ ***************************************************************************************/
+
+extern "C" {
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "general.param.h"
+}
+
+#include "frontend/pt_memtrace/trace_stream.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frontend/frontend_intf.h"
+#include "frontend/pt_memtrace/memtrace_fe.h"
+#include "frontend/pt_memtrace/pt_fe.h"
+
+/**************************************************************************************/
+/* Stream file layout */
+
+#define TRACE_STREAM_DATA_OFFSET 4096  // records start on the page after the header
+#define TRACE_STREAM_BATCH 4096        // records decoded or read at a time
+
+static const char trace_stream_magic[8] = {'S', 'C', 'R', 'S', 'T', 'R', 'M', '1'};
+
+struct Trace_Stream_Record {
+  ctype_pin_inst pi;
+  uint64_t ins_id;  // memtrace instruction counters after the decode
+  uint64_t ins_id_fetched;
+  int32_t ret;
+  uint8_t filled;
+};
+
+struct Trace_Stream_Header {
+  char magic[8];
+  uint32_t record_size;
+  uint32_t reserved;
+  uint64_t key;                    // trace_stream_key()
+  std::atomic<uint64_t> count;     // records published so far
+  std::atomic<uint32_t> complete;  // the last published record ends the trace
+};
+
+static_assert(sizeof(Trace_Stream_Header) <= TRACE_STREAM_DATA_OFFSET, "stream header must fit its page");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "stream counters are shared between processes");
+
+extern uint64_t ins_id;
+extern uint64_t ins_id_fetched;
+
+/**************************************************************************************/
+/* Trace_Stream */
+
+class Trace_Stream {
+ public:
+  Trace_Stream(uns proc_id, int fd, uint64_t key);
+  ~Trace_Stream();
+  bool attach(const std::string& file);
+  int read(ctype_pin_inst* pi);
+
+ private:
+  uns proc_id;
+  int fd;
+  uint64_t key;
+  Trace_Stream_Header* header;
+  bool decoder;       // holds the file lock
+  bool reader_ready;  // the trace reader has been set up and caught up
+  bool done;
+  uint64_t pos;      // next record consumed by the simulation
+  uint64_t decoded;  // records the trace reader has produced
+  uint64_t dec_ins_id;
+  uint64_t dec_ins_id_fetched;
+  std::vector<Trace_Stream_Record> batch;
+  size_t batch_pos;
+
+  bool header_valid();
+  void init_header();
+  void refill();
+  void fetch(uint64_t num);
+  void take_over();
+  void produce();
+};
+
+static Trace_Stream* trace_streams[MAX_NUM_PROCS];
+/* Stream files opened by this process. A second core on the same trace reads it
+   on its own: the simulation thread would otherwise wait on itself. */
+static std::map<std::string, uns> trace_stream_files;
+
+static uint64_t fnv1a(const void* _data, size_t _size, uint64_t _hash = 0xcbf29ce484222325ull) {
+  const uint8_t* data = static_cast<const uint8_t*>(_data);
+  for (size_t i = 0; i < _size; i++) {
+    _hash ^= data[i];
+    _hash *= 0x100000001b3ull;
+  }
+  return _hash;
+}
+
+/* Identifies everything the decoded stream depends on: the trace contents, the
+   parameters applied while decoding and the simulator binary itself */
+static uint64_t trace_stream_key(const char* trace) {
+  struct stat trace_st, exe_st;
+  memset(&trace_st, 0, sizeof(trace_st));
+  memset(&exe_st, 0, sizeof(exe_st));
+  stat(trace, &trace_st);
+  stat("/proc/self/exe", &exe_st);
+  uint64_t id[] = {FRONTEND,
+                   FAST_FORWARD,
+                   FAST_FORWARD_TRACE_INS,
+                   MEMTRACE_ROI_BEGIN,
+                   MEMTRACE_ROI_END,
+                   USE_FETCHED_COUNT,
+                   sizeof(Trace_Stream_Record),
+                   static_cast<uint64_t>(trace_st.st_size),
+                   static_cast<uint64_t>(trace_st.st_mtime),
+                   static_cast<uint64_t>(exe_st.st_size),
+                   static_cast<uint64_t>(exe_st.st_mtime)};
+  return fnv1a(id, sizeof(id), fnv1a(trace, strlen(trace)));
+}
+
+static void trace_stream_backoff(uns spins) {
+  if (spins < 1024)
+    std::this_thread::yield();
+  else
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+}
+
+static int trace_stream_decode(uns proc_id, ctype_pin_inst* pi, Flag* filled) {
+  if (FRONTEND == FE_PT)
+    return pt_trace_decode(proc_id, pi, filled);
+  ASSERT(proc_id, FRONTEND == FE_MEMTRACE);
+  return memtrace_trace_decode(proc_id, pi, filled);
+}
+
+Trace_Stream::Trace_Stream(uns proc_id, int fd, uint64_t key)
+    : proc_id(proc_id),
+      fd(fd),
+      key(key),
+      header(nullptr),
+      decoder(false),
+      reader_ready(false),
+      done(false),
+      pos(0),
+      decoded(0),
+      dec_ins_id(0),
+      dec_ins_id_fetched(0),
+      batch_pos(0) {
+}
+
+Trace_Stream::~Trace_Stream() {
+  std::cout << "Shared decode: read " << pos << " instructions, decoded " << decoded << std::endl;
+  if (header)
+    munmap(header, TRACE_STREAM_DATA_OFFSET);
+  close(fd);  // releases the decoder lock
+}
+
+bool Trace_Stream::header_valid() {
+  struct stat st;
+  char buf[sizeof(Trace_Stream_Header)];
+  if (fstat(fd, &st) != 0 || st.st_size < TRACE_STREAM_DATA_OFFSET || pread(fd, buf, sizeof(buf), 0) != sizeof(buf))
+    return false;
+  uint32_t record_size;
+  uint64_t file_key;
+  memcpy(&record_size, buf + offsetof(Trace_Stream_Header, record_size), sizeof(record_size));
+  memcpy(&file_key, buf + offsetof(Trace_Stream_Header, key), sizeof(file_key));
+  return !memcmp(buf, trace_stream_magic, sizeof(trace_stream_magic)) && record_size == sizeof(Trace_Stream_Record) &&
+         file_key == key;
+}
+
+/* Called with the lock held, on a new file or on one left half-initialized */
+void Trace_Stream::init_header() {
+  std::vector<char> page(TRACE_STREAM_DATA_OFFSET, 0);
+  uint32_t record_size = sizeof(Trace_Stream_Record);
+  memcpy(page.data(), trace_stream_magic, sizeof(trace_stream_magic));
+  memcpy(page.data() + offsetof(Trace_Stream_Header, record_size), &record_size, sizeof(record_size));
+  memcpy(page.data() + offsetof(Trace_Stream_Header, key), &key, sizeof(key));
+  if (ftruncate(fd, 0) != 0 || pwrite(fd, page.data(), page.size(), 0) != static_cast<ssize_t>(page.size()))
+    FATAL_ERROR(proc_id, "Cannot initialize shared decode stream: %s\n", strerror(errno));
+}
+
+/* Becomes the decoder if nobody else is, and waits until the header is
+   readable otherwise */
+bool Trace_Stream::attach(const std::string& file) {
+  for (uns spins = 0;; spins++) {
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+      decoder = true;
+      if (!header_valid())
+        init_header();
+      break;
+    }
+    if (header_valid())
+      break;
+    trace_stream_backoff(spins);
+  }
+
+  void* map = mmap(nullptr, TRACE_STREAM_DATA_OFFSET, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    WARNINGU(proc_id, "Cannot map shared decode stream %s, decoding privately\n", file.c_str());
+    return false;
+  }
+  header = static_cast<Trace_Stream_Header*>(map);
+
+  uint64_t count = header->count.load(std::memory_order_acquire);
+  bool complete = header->complete.load(std::memory_order_acquire);
+  if (decoder && complete) {
+    flock(fd, LOCK_UN);
+    decoder = false;
+  }
+  std::cout << "Shared decode stream " << file << ": " << count << " instructions"
+            << (complete ? " (complete)" : decoder ? ", decoding" : ", following") << std::endl;
+  return true;
+}
+
+int Trace_Stream::read(ctype_pin_inst* pi) {
+  if (done)
+    return 0;
+  if (batch_pos == batch.size())
+    refill();
+
+  const Trace_Stream_Record* record = &batch[batch_pos++];
+  pos++;
+  if (record->filled) {
+    *pi = record->pi;
+    if (FRONTEND == FE_MEMTRACE) {
+      ins_id = record->ins_id;
+      ins_id_fetched = record->ins_id_fetched;
+      memtrace_trace_markers(proc_id, pi);
+    }
+  }
+  done = !record->ret;
+  return record->ret;
+}
+
+/* Reads published records, decodes new ones if this process holds the lock, or
+   waits for the decoder (trying to take its place) */
+void Trace_Stream::refill() {
+  for (uns spins = 0;; spins++) {
+    uint64_t count = header->count.load(std::memory_order_acquire);
+    if (pos < count) {
+      fetch(std::min<uint64_t>(count - pos, TRACE_STREAM_BATCH));
+      return;
+    }
+    ASSERTM(proc_id, !header->complete.load(std::memory_order_acquire), "read past the end of a shared stream\n");
+    if (!decoder && flock(fd, LOCK_EX | LOCK_NB) == 0) {
+      decoder = true;
+      continue;  // the previous decoder may have published more before exiting
+    }
+    if (decoder) {
+      produce();
+      return;
+    }
+    trace_stream_backoff(spins);
+  }
+}
+
+void Trace_Stream::fetch(uint64_t num) {
+  batch.resize(num);
+  batch_pos = 0;
+  char* buf = reinterpret_cast<char*>(batch.data());
+  size_t size = num * sizeof(Trace_Stream_Record);
+  off_t offset = TRACE_STREAM_DATA_OFFSET + pos * sizeof(Trace_Stream_Record);
+  for (size_t got = 0; got < size;) {
+    ssize_t ret = pread(fd, buf + got, size - got, offset + got);
+    if (ret <= 0)
+      FATAL_ERROR(proc_id, "Cannot read shared decode stream: %s\n", ret ? strerror(errno) : "truncated");
+    got += ret;
+  }
+}
+
+/* Opens the trace and decodes up to the end of the published stream. Records
+   past count from a decoder that died mid-write are dropped. */
+void Trace_Stream::take_over() {
+  uint64_t count = header->count.load(std::memory_order_acquire);
+  if (ftruncate(fd, TRACE_STREAM_DATA_OFFSET + count * sizeof(Trace_Stream_Record)) != 0)
+    FATAL_ERROR(proc_id, "Cannot truncate shared decode stream: %s\n", strerror(errno));
+  if (count)
+    std::cout << "Shared decode: resuming at instruction " << count << std::endl;
+
+  ins_id = 0;
+  ins_id_fetched = 0;
+  if (FRONTEND == FE_PT)
+    pt_setup(proc_id);
+  else
+    memtrace_setup(proc_id);
+  for (; decoded < count; decoded++) {
+    ctype_pin_inst pi;
+    Flag filled;
+    int ret = trace_stream_decode(proc_id, &pi, &filled);
+    ASSERTM(proc_id, ret, "trace ended before the shared stream of it\n");
+  }
+  dec_ins_id = ins_id;
+  dec_ins_id_fetched = ins_id_fetched;
+  reader_ready = true;
+}
+
+/* Decodes the next batch, appends it to the file and publishes it. The
+   simulation's instruction counters are swapped out for the decoder's, which
+   run up to a batch ahead. */
+void Trace_Stream::produce() {
+  if (!reader_ready)
+    take_over();
+  uint64_t count = header->count.load(std::memory_order_relaxed);
+  ASSERT(proc_id, count == decoded && count == pos);
+
+  uint64_t sim_ins_id = ins_id;
+  uint64_t sim_ins_id_fetched = ins_id_fetched;
+  ins_id = dec_ins_id;
+  ins_id_fetched = dec_ins_id_fetched;
+  batch.resize(TRACE_STREAM_BATCH);
+  batch_pos = 0;
+  size_t num = 0;
+  while (num < TRACE_STREAM_BATCH) {
+    Trace_Stream_Record* record = &batch[num++];
+    Flag filled;
+    memset(record, 0, sizeof(*record));
+    record->ret = trace_stream_decode(proc_id, &record->pi, &filled);
+    record->filled = filled;
+    record->ins_id = ins_id;
+    record->ins_id_fetched = ins_id_fetched;
+    if (!record->ret)
+      break;
+  }
+  batch.resize(num);
+  dec_ins_id = ins_id;
+  dec_ins_id_fetched = ins_id_fetched;
+  ins_id = sim_ins_id;
+  ins_id_fetched = sim_ins_id_fetched;
+
+  const char* buf = reinterpret_cast<const char*>(batch.data());
+  size_t size = num * sizeof(Trace_Stream_Record);
+  off_t offset = TRACE_STREAM_DATA_OFFSET + count * sizeof(Trace_Stream_Record);
+  for (size_t put = 0; put < size;) {
+    ssize_t ret = pwrite(fd, buf + put, size - put, offset + put);
+    if (ret <= 0)
+      FATAL_ERROR(proc_id, "Cannot write shared decode stream: %s\n", strerror(errno));
+    put += ret;
+  }
+  decoded += num;
+  if (!batch.back().ret)
+    header->complete.store(1, std::memory_order_release);
+  header->count.store(count + num, std::memory_order_release);
+}
+
+/**************************************************************************************/
+/* External interface */
+
+Flag trace_stream_open(uns proc_id, const char* trace) {
+  if (!TRACE_SHARED_DECODE_DIR || !trace)
+    return FALSE;
+
+  uint64_t key = trace_stream_key(trace);
+  char name[32];
+  snprintf(name, sizeof(name), "/%016lx.pistream", key);
+  std::string file = std::string(TRACE_SHARED_DECODE_DIR) + name;
+  if (trace_stream_files.count(file))
+    return FALSE;
+
+  int fd = open(file.c_str(), O_RDWR | O_CREAT, 0666);
+  if (fd < 0) {
+    WARNINGU(proc_id, "Cannot open shared decode stream %s, decoding privately\n", file.c_str());
+    return FALSE;
+  }
+  Trace_Stream* stream = new Trace_Stream(proc_id, fd, key);
+  if (!stream->attach(file)) {
+    delete stream;
+    return FALSE;
+  }
+  trace_stream_files[file] = proc_id;
+  trace_streams[proc_id] = stream;
+  return TRUE;
+}
+
+Flag trace_stream_active(uns proc_id) {
+  return trace_streams[proc_id] != nullptr;
+}
+
+int trace_stream_read(uns proc_id, ctype_pin_inst* pi) {
+  return trace_streams[proc_id]->read(pi);
+}
+
+void trace_stream_close(uns proc_id) {
+  delete trace_streams[proc_id];
+  trace_streams[proc_id] = nullptr;
+}
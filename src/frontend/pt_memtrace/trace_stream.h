@@ -0,0 +1,64 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/pt_memtrace/trace_stream.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Decoded memtrace/PT instruction stream shared by the Scarab
+ *                processes running the same trace on one host
+ *                (TRACE_SHARED_DECODE_DIR). One process at a time decodes
+ *                and appends ctype_pin_insts to a file in the directory; the
+ *                others read them back from the page cache, each at its own
+ *                position. A process that needs more of the trace than has
+ *                been published takes the decoding over once the current
+ *                decoder has exited. A finished stream is reused as is by
+ *                later runs, which then never open the trace.
+ ***************************************************************************************/
+
+#ifndef __TRACE_STREAM_H__
+#define __TRACE_STREAM_H__
+
+#include "globals/global_types.h"
+
+#include "ctype_pin_inst.h"
+
+/**************************************************************************************/
+/* Prototypes */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Attaches the core to the shared stream of its trace. Returns FALSE if the
+   core should set up its own trace reader instead (sharing disabled, or the
+   trace is already streamed to another core of this process). */
+Flag trace_stream_open(uns proc_id, const char* trace);
+Flag trace_stream_active(uns proc_id);
+/* Same contract as memtrace_trace_read()/pt_trace_read() */
+int trace_stream_read(uns proc_id, ctype_pin_inst* pi);
+void trace_stream_close(uns proc_id);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __TRACE_STREAM_H__
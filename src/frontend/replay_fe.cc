@@ -0,0 +1,507 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/replay_fe.cc
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Recording and replay of exec-driven runs (see replay_fe.h).
+ *
+ *  A recording starts with a Replay_Header and holds one record per event, in
+ *  the order the core saw them: a type byte, then either an op encoded with
+ *  OpEncoder (pin_lib/op_codec.h) or the inst_uid (and fetch address) of a
+ *  redirect/recover. PIN never reuses an inst_uid, so the uid of every on-path
+ *  op is greater than that of every op, and every event, recorded before it.
+ *
+ *  The replay reads a recording lazily and keeps only what can still be asked
+ *  for: the on-path ops from the oldest unretired one on, and the wrong paths
+ *  hanging off unretired instructions. A wrong path is keyed by the redirect
+ *  that started it. Its ops are the ones PIN executed after the redirect; a
+ *  recover to one of them truncates the path there, and the ops fetched after
+ *  the recover continue it.
+ ***************************************************************************************/
+
+extern "C" {
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "debug/debug.param.h"
+
+#include "general.param.h"
+
+#include "op.h"
+#include "statistics.h"
+}
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "frontend/pin_exec_driven_fe.h"
+#include "frontend/replay_fe.h"
+#include "pin/pin_lib/op_codec.h"
+#include "pin/pin_lib/uop_generator.h"
+
+#include "decoupled_frontend.h"
+
+#define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_PIN_EXEC_DRIVEN, ##args)
+
+#define REPLAY_MAGIC "SCRBRPL1"
+// Generated wrong-path ops get uids PIN never hands out
+#define REPLAY_GENERATED_UID_BASE (1ULL << 62)
+// Largest record: type byte plus an encoded op
+#define REPLAY_MAX_RECORD_SIZE (1 + OP_CODEC_MAX_ENCODED_SIZE)
+
+typedef enum Replay_Record_Type_enum {
+  REPLAY_ON_PATH_OP,
+  REPLAY_OFF_PATH_OP,
+  REPLAY_REDIRECT,  // uid, fetch address
+  REPLAY_RECOVER,   // uid
+} Replay_Record_Type;
+
+typedef struct Replay_Header_struct {
+  char magic[8];
+  uint32_t op_size;  // sizeof(compressed_op) of the recording build
+  uint32_t reserved;
+} Replay_Header;
+
+typedef std::pair<uns64, Addr> Replay_Path_Key;  // redirect uid, fetch address
+
+/**************************************************************************************/
+/* Recording */
+
+struct Replay_Writer {
+  FILE* file;
+  OpEncoder encoder;
+  std::vector<uint8_t> record;
+};
+
+static std::vector<Replay_Writer> replay_writers;
+
+static void replay_file_name(char* name, size_t size, const char* base, uns proc_id) {
+  snprintf(name, size, "%s.%u", base, proc_id);
+}
+
+void replay_record_init(uns num_cores) {
+  replay_writers.resize(num_cores);
+  for (uns proc_id = 0; proc_id < num_cores; proc_id++) {
+    char name[MAX_STR_LENGTH + 1];
+    replay_file_name(name, sizeof(name), PIN_EXEC_DRIVEN_RECORD_FILE, proc_id);
+    Replay_Writer* writer = &replay_writers[proc_id];
+    writer->file = fopen(name, "wb");
+    ASSERTM(proc_id, writer->file, "Could not create the replay recording %s\n", name);
+
+    Replay_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    header.op_size = sizeof(compressed_op);
+    fwrite(&header, sizeof(header), 1, writer->file);
+  }
+}
+
+void replay_record_done() {
+  for (uns proc_id = 0; proc_id < replay_writers.size(); proc_id++) {
+    ASSERTM(proc_id, !ferror(replay_writers[proc_id].file), "Failed to write the replay recording\n");
+    fclose(replay_writers[proc_id].file);
+  }
+  replay_writers.clear();
+}
+
+static void replay_write_uid(std::vector<uint8_t>* record, uns64 value) {
+  const uint8_t* bytes = (const uint8_t*)&value;
+  record->insert(record->end(), bytes, bytes + sizeof(value));
+}
+
+static void replay_write_record(Replay_Writer* writer) {
+  fwrite(writer->record.data(), 1, writer->record.size(), writer->file);
+  writer->record.clear();
+}
+
+void replay_record_op(uns proc_id, const compressed_op* cop, Flag off_path) {
+  Replay_Writer* writer = &replay_writers[proc_id];
+  writer->record.push_back(off_path ? REPLAY_OFF_PATH_OP : REPLAY_ON_PATH_OP);
+  writer->encoder.encode(*cop, &writer->record);
+  replay_write_record(writer);
+}
+
+void replay_record_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr) {
+  Replay_Writer* writer = &replay_writers[proc_id];
+  writer->record.push_back(REPLAY_REDIRECT);
+  replay_write_uid(&writer->record, inst_uid);
+  replay_write_uid(&writer->record, fetch_addr);
+  replay_write_record(writer);
+}
+
+void replay_record_recover(uns proc_id, uns64 inst_uid) {
+  Replay_Writer* writer = &replay_writers[proc_id];
+  writer->record.push_back(REPLAY_RECOVER);
+  replay_write_uid(&writer->record, inst_uid);
+  replay_write_record(writer);
+}
+
+/**************************************************************************************/
+/* Replay */
+
+struct Replay_Core {
+  /* Reading the recording */
+  FILE* file;
+  std::vector<uint8_t> buf;
+  size_t buf_pos;
+  Flag eof;
+  OpDecoder decoder;
+  uns64 last_on_path_uid;  // of the last on-path op read
+  std::vector<compressed_op>* loading;  // wrong path the off-path ops read go to
+  Replay_Path_Key loading_key;
+  std::vector<compressed_op> discarded;  // ops of a wrong path recorded twice
+
+  /* What was read and can still be asked for */
+  std::deque<compressed_op> on_path;  // from the oldest unretired op
+  std::map<Replay_Path_Key, std::vector<compressed_op>> wrong_paths;
+  std::map<uns64, std::pair<Replay_Path_Key, size_t>> wrong_path_ops;  // uid -> path, index
+  std::map<uns64, Addr> generated_ops;  // uid -> next address
+  std::unordered_map<Addr, compressed_op> static_code;  // last on-path instance
+
+  /* Position of the core */
+  size_t on_path_pos;  // next on-path op
+  Flag off_path;
+  Flag on_recorded_path;  // serving wrong_paths[path_key], else generating
+  Replay_Path_Key path_key;
+  size_t path_pos;
+  compressed_op wrong_path_op;  // next off-path op
+  uns64 next_generated_uid;
+};
+
+static std::vector<Replay_Core> replay_cores;
+
+static void replay_refill(Replay_Core* core) {
+  core->buf.erase(core->buf.begin(), core->buf.begin() + core->buf_pos);
+  core->buf_pos = 0;
+  size_t used = core->buf.size();
+  core->buf.resize(used + (1 << 16));
+  size_t read = fread(core->buf.data() + used, 1, core->buf.size() - used, core->file);
+  core->buf.resize(used + read);
+}
+
+static uns64 replay_read_uid(Replay_Core* core) {
+  uns64 value;
+  memcpy(&value, core->buf.data() + core->buf_pos, sizeof(value));
+  core->buf_pos += sizeof(value);
+  return value;
+}
+
+/* Recover in the recording: back on the on-path, or down the rest of the wrong
+   path the uid belongs to */
+static void replay_load_recover(Replay_Core* core, uns64 inst_uid) {
+  auto op = core->wrong_path_ops.find(inst_uid);
+  if (op != core->wrong_path_ops.end()) {
+    core->loading_key = op->second.first;
+    core->loading = &core->wrong_paths[core->loading_key];
+    if (core->loading->size() > op->second.second + 1)
+      core->loading->resize(op->second.second + 1);
+    return;
+  }
+  core->loading = NULL;
+  while (!core->on_path.empty() && core->on_path.back().inst_uid > inst_uid)
+    core->on_path.pop_back();
+  core->on_path_pos = MIN2(core->on_path_pos, core->on_path.size());
+}
+
+/* Reads one record, returns FALSE at the end of the recording */
+static Flag replay_read_record(uns proc_id, Replay_Core* core) {
+  if (core->eof)
+    return FALSE;
+  if (core->buf.size() - core->buf_pos < REPLAY_MAX_RECORD_SIZE)
+    replay_refill(core);
+  if (core->buf_pos == core->buf.size()) {
+    core->eof = TRUE;
+    return FALSE;
+  }
+
+  uns8 type = core->buf[core->buf_pos++];
+  const uint8_t* data = core->buf.data() + core->buf_pos;
+  size_t size = core->buf.size() - core->buf_pos;
+  switch (type) {
+    case REPLAY_ON_PATH_OP:
+    case REPLAY_OFF_PATH_OP: {
+      compressed_op cop;
+      size_t used = core->decoder.decode(data, size, &cop);
+      ASSERTM(proc_id, used, "Malformed op in the replay recording\n");
+      core->buf_pos += used;
+      if (type == REPLAY_ON_PATH_OP) {
+        core->on_path.push_back(cop);
+        core->last_on_path_uid = cop.inst_uid;
+        core->loading = NULL;
+      } else if (core->loading) {
+        if (core->loading != &core->discarded)
+          core->wrong_path_ops[cop.inst_uid] = std::make_pair(core->loading_key, core->loading->size());
+        core->loading->push_back(cop);
+      }
+      break;
+    }
+    case REPLAY_REDIRECT: {
+      ASSERTM(proc_id, size >= 2 * sizeof(uns64), "Truncated replay recording\n");
+      uns64 inst_uid = replay_read_uid(core);
+      Addr fetch_addr = replay_read_uid(core);
+      Replay_Path_Key key(inst_uid, fetch_addr);
+      if (core->wrong_paths.count(key)) {
+        core->discarded.clear();
+        core->loading = &core->discarded;
+      } else {
+        core->loading = &core->wrong_paths[key];
+        core->loading_key = key;
+      }
+      break;
+    }
+    case REPLAY_RECOVER: {
+      ASSERTM(proc_id, size >= sizeof(uns64), "Truncated replay recording\n");
+      replay_load_recover(core, replay_read_uid(core));
+      break;
+    }
+    default:
+      ASSERTM(proc_id, FALSE, "Unknown record type %u in the replay recording\n", type);
+  }
+  return TRUE;
+}
+
+/* Reads on until every event recorded before the first on-path op after
+   inst_uid is in */
+static void replay_read_past(uns proc_id, Replay_Core* core, uns64 inst_uid) {
+  while (core->last_on_path_uid <= inst_uid && replay_read_record(proc_id, core)) {
+  }
+}
+
+static Flag replay_has_on_path_op(uns proc_id, Replay_Core* core) {
+  while (core->on_path_pos == core->on_path.size() && replay_read_record(proc_id, core)) {
+  }
+  return core->on_path_pos < core->on_path.size();
+}
+
+/* Makes the next off-path op the one at addr in the on-path code seen so far */
+static void replay_generate_op(Replay_Core* core, Addr addr) {
+  auto inst = core->static_code.find(addr);
+  if (inst != core->static_code.end()) {
+    core->wrong_path_op = inst->second;
+    core->wrong_path_op.exit = FALSE;
+    core->wrong_path_op.scarab_marker_roi_begin = FALSE;
+    core->wrong_path_op.scarab_marker_roi_end = FALSE;
+  } else {
+    core->wrong_path_op = create_dummy_nop(addr, WPNM_REASON_REDIRECT_TO_NOT_INSTRUMENTED);
+  }
+  core->wrong_path_op.inst_uid = core->next_generated_uid++;
+  core->on_recorded_path = FALSE;
+  core->generated_ops[core->wrong_path_op.inst_uid] = core->wrong_path_op.instruction_next_addr;
+}
+
+/* Moves to the op at path_pos of the recorded wrong path, or generates the op
+   after the last one served once the path runs out */
+static void replay_follow_path(Replay_Core* core) {
+  const std::vector<compressed_op>& path = core->wrong_paths[core->path_key];
+  if (core->path_pos < path.size()) {
+    core->wrong_path_op = path[core->path_pos];
+    core->on_recorded_path = TRUE;
+  } else {
+    replay_generate_op(core, core->wrong_path_op.instruction_next_addr);
+  }
+}
+
+static void replay_next_wrong_path_op(Replay_Core* core) {
+  if (core->on_recorded_path) {
+    core->path_pos++;
+    replay_follow_path(core);
+  } else {
+    replay_generate_op(core, core->wrong_path_op.instruction_next_addr);
+  }
+}
+
+static void replay_learn_static_code(Replay_Core* core, const compressed_op* cop) {
+  core->static_code[cop->instruction_addr] = *cop;
+}
+
+void replay_init(uns num_cores) {
+  replay_cores.resize(num_cores);
+  for (uns proc_id = 0; proc_id < num_cores; proc_id++) {
+    char name[MAX_STR_LENGTH + 1];
+    replay_file_name(name, sizeof(name), REPLAY_FILE, proc_id);
+    Replay_Core* core = &replay_cores[proc_id];
+    core->file = fopen(name, "rb");
+    ASSERTM(proc_id, core->file, "Could not open the replay recording %s\n", name);
+
+    Replay_Header header;
+    Flag valid = fread(&header, sizeof(header), 1, core->file) == 1 &&
+                 !memcmp(header.magic, REPLAY_MAGIC, sizeof(header.magic));
+    ASSERTM(proc_id, valid, "%s is not a replay recording\n", name);
+    ASSERTM(proc_id, header.op_size == sizeof(compressed_op),
+            "Replay recording %s was made by a build with a different compressed_op\n", name);
+
+    core->buf_pos = 0;
+    core->eof = FALSE;
+    core->last_on_path_uid = 0;
+    core->loading = NULL;
+    core->on_path_pos = 0;
+    core->off_path = FALSE;
+    core->on_recorded_path = FALSE;
+    core->path_pos = 0;
+    core->next_generated_uid = REPLAY_GENERATED_UID_BASE;
+  }
+  uop_generator_init(num_cores);
+}
+
+void replay_done() {
+  for (uns proc_id = 0; proc_id < replay_cores.size(); proc_id++)
+    fclose(replay_cores[proc_id].file);
+  replay_cores.clear();
+}
+
+Addr replay_next_fetch_addr(uns proc_id) {
+  Replay_Core* core = &replay_cores[proc_id];
+  if (core->off_path)
+    return convert_to_cmp_addr(proc_id, core->wrong_path_op.instruction_addr);
+  ASSERT(proc_id, replay_has_on_path_op(proc_id, core));
+  return convert_to_cmp_addr(proc_id, core->on_path[core->on_path_pos].instruction_addr);
+}
+
+Flag replay_can_fetch_op(uns proc_id) {
+  Replay_Core* core = &replay_cores[proc_id];
+  return core->off_path || replay_has_on_path_op(proc_id, core);
+}
+
+void replay_fetch_op(uns proc_id, Op* op) {
+  Replay_Core* core = &replay_cores[proc_id];
+  if (core->off_path) {
+    if (uop_generator_extract_op(proc_id, op, &core->wrong_path_op))
+      replay_next_wrong_path_op(core);
+  } else {
+    ASSERT(proc_id, replay_has_on_path_op(proc_id, core));
+    compressed_op* cop = &core->on_path[core->on_path_pos];
+    if (uop_generator_extract_op(proc_id, op, cop)) {
+      if (!decoupled_fe_is_off_path())
+        pin_exec_driven_check_roi_markers(proc_id, cop);
+      replay_learn_static_code(core, cop);
+      core->on_path_pos++;
+    }
+  }
+  DEBUG(proc_id, "Replay fetch op: %llx (%llu) off_path:%d\n", op->inst_info->addr, op->inst_uid, core->off_path);
+}
+
+uns replay_ready_ops(uns proc_id) {
+  return frontend_uops_ready(proc_id, replay_can_fetch_op(proc_id));
+}
+
+uns replay_fetch_ops(uns proc_id, Op** ops, uns max) {
+  return frontend_uops_fetch(proc_id, ops, max, replay_can_fetch_op, replay_fetch_op);
+}
+
+void replay_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr) {
+  Replay_Core* core = &replay_cores[proc_id];
+  Addr addr = convert_to_cmp_addr(0, fetch_addr);  // removing proc_id
+  DEBUG(proc_id, "Replay redirect: %llx (%llu)\n", addr, inst_uid);
+  uop_generator_recover(proc_id);
+  replay_read_past(proc_id, core, inst_uid);
+
+  core->off_path = TRUE;
+  core->path_key = Replay_Path_Key(inst_uid, addr);
+  core->path_pos = 0;
+  auto path = core->wrong_paths.find(core->path_key);
+  if (path != core->wrong_paths.end() && !path->second.empty()) {
+    STAT_EVENT(proc_id, REPLAY_WRONG_PATH_RECORDED);
+    replay_follow_path(core);
+  } else {
+    STAT_EVENT(proc_id, REPLAY_WRONG_PATH_GENERATED);
+    replay_generate_op(core, addr);
+  }
+}
+
+void replay_recover(uns proc_id, uns64 inst_uid) {
+  Replay_Core* core = &replay_cores[proc_id];
+  DEBUG(proc_id, "Replay recover: %llu\n", inst_uid);
+  uop_generator_recover(proc_id);
+
+  auto recorded = core->wrong_path_ops.find(inst_uid);
+  if (recorded != core->wrong_path_ops.end()) {
+    core->off_path = TRUE;
+    core->path_key = recorded->second.first;
+    core->path_pos = recorded->second.second + 1;
+    core->wrong_path_op = core->wrong_paths[core->path_key][recorded->second.second];
+    replay_follow_path(core);
+    return;
+  }
+  auto generated = core->generated_ops.find(inst_uid);
+  if (generated != core->generated_ops.end()) {
+    core->off_path = TRUE;
+    replay_generate_op(core, generated->second);
+    return;
+  }
+
+  core->off_path = FALSE;
+  core->generated_ops.clear();
+  replay_read_past(proc_id, core, inst_uid);
+  auto next = std::upper_bound(core->on_path.begin(), core->on_path.end(), inst_uid,
+                               [](uns64 uid, const compressed_op& cop) { return uid < cop.inst_uid; });
+  core->on_path_pos = next - core->on_path.begin();
+}
+
+/* Nothing at or before a retired uid can be asked for again */
+void replay_retire(uns proc_id, uns64 inst_uid) {
+  Replay_Core* core = &replay_cores[proc_id];
+  if (inst_uid == (uns64)-1)
+    return;
+  while (!core->on_path.empty() && core->on_path.front().inst_uid <= inst_uid && core->on_path_pos > 0) {
+    core->on_path.pop_front();
+    core->on_path_pos--;
+  }
+  if (core->loading && core->loading != &core->discarded && core->loading_key.first <= inst_uid)
+    core->loading = NULL;
+  core->wrong_paths.erase(core->wrong_paths.begin(),
+                          core->wrong_paths.lower_bound(Replay_Path_Key(inst_uid + 1, 0)));
+  core->wrong_path_ops.erase(core->wrong_path_ops.begin(), core->wrong_path_ops.upper_bound(inst_uid));
+}
+
+uns64 replay_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited) {
+  Replay_Core* core = &replay_cores[proc_id];
+  ASSERT(proc_id, uop_generator_get_bom(proc_id) && !core->off_path);
+  uns64 skipped = 0;
+  uns64 last_uid = 0;
+  while (skipped < num_insts && !*exited) {
+    if (!replay_has_on_path_op(proc_id, core)) {
+      *exited = TRUE;
+      break;
+    }
+    const compressed_op* cop = &core->on_path[core->on_path_pos++];
+    if (warm_func)
+      frontend_skip_warm(proc_id, cop, warm_func);
+    pin_exec_driven_check_roi_markers(proc_id, cop);
+    replay_learn_static_code(core, cop);
+    skipped++;
+    last_uid = cop->inst_uid;
+    *exited = cop->exit;
+  }
+  if (skipped)
+    replay_retire(proc_id, last_uid);
+  return skipped;
+}
@@ -0,0 +1,79 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/replay_fe.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Replays the ops of a recorded exec-driven run without PIN.
+ *
+ *  An exec-driven run with --pin_exec_driven_record_file <file> writes, for
+ *  every core, the ops it consumed to <file>.<proc_id>, along with each
+ *  redirect and recover it sent to PIN. The replay frontend
+ *  (--frontend replay --replay_file <file>) serves the on-path ops back, and
+ *  after a redirect serves the wrong path recorded for the same instruction
+ *  and target. A wrong path that was not recorded, or runs past its recorded
+ *  end, is generated from the on-path code seen so far (dummy nops where none
+ *  was seen), like the memtrace frontend does.
+ ***************************************************************************************/
+
+#ifndef __REPLAY_FE_H__
+#define __REPLAY_FE_H__
+
+#include "globals/global_types.h"
+
+#include "frontend/frontend_intf.h"
+
+#include "ctype_pin_inst.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct Op_struct;
+
+void replay_init(uns num_cores);
+void replay_done(void);
+
+/* Implementing the frontend interface */
+Addr replay_next_fetch_addr(uns proc_id);
+Flag replay_can_fetch_op(uns proc_id);
+void replay_fetch_op(uns proc_id, struct Op_struct* op);
+uns replay_ready_ops(uns proc_id);
+uns replay_fetch_ops(uns proc_id, struct Op_struct** ops, uns max);
+void replay_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr);
+void replay_recover(uns proc_id, uns64 inst_uid);
+void replay_retire(uns proc_id, uns64 inst_uid);
+uns64 replay_skip(uns proc_id, uns64 num_insts, Frontend_Skip_Warm_Func warm_func, Flag* exited);
+
+/* Recording, driven by the exec-driven frontend. Addresses are without the
+   proc_id bits. */
+void replay_record_init(uns num_cores);
+void replay_record_done(void);
+void replay_record_op(uns proc_id, const compressed_op* cop, Flag off_path);
+void replay_record_redirect(uns proc_id, uns64 inst_uid, Addr fetch_addr);
+void replay_record_recover(uns proc_id, uns64 inst_uid);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // __REPLAY_FE_H__
@@ -0,0 +1,111 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/static_code_image.cc
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  :
+ ***************************************************************************************/
+
+#include "frontend/static_code_image.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+Static_Code_Image::Static_Code_Image() {
+  memset(tables, 0, sizeof(tables));
+}
+
+Static_Code_Image::~Static_Code_Image() {
+  for (uint64_t ii = 0; ii < LEVEL_SIZE; ii++) {
+    if (!tables[ii])
+      continue;
+    for (uint64_t jj = 0; jj < LEVEL_SIZE; jj++) {
+      if (!tables[ii]->dirs[jj])
+        continue;
+      for (uint64_t kk = 0; kk < LEVEL_SIZE; kk++)
+        free(tables[ii]->dirs[jj]->pages[kk]);
+      free(tables[ii]->dirs[jj]);
+    }
+    free(tables[ii]);
+  }
+}
+
+/* NULL for a non-canonical address, or when nothing was allocated for it and
+   allocate is false */
+uint32_t* Static_Code_Image::slot(uint64_t addr, bool allocate) {
+  int64_t high = (int64_t)addr >> 47;
+  if (high != 0 && high != -1)
+    return nullptr;
+
+  uint64_t mask = LEVEL_SIZE - 1;
+  Table** table = &tables[(addr >> (3 * LEVEL_BITS)) & mask];
+  if (!*table) {
+    if (!allocate)
+      return nullptr;
+    *table = (Table*)calloc(1, sizeof(Table));
+  }
+  Directory** dir = &(*table)->dirs[(addr >> (2 * LEVEL_BITS)) & mask];
+  if (!*dir) {
+    if (!allocate)
+      return nullptr;
+    *dir = (Directory*)calloc(1, sizeof(Directory));
+  }
+  Page** page = &(*dir)->pages[(addr >> LEVEL_BITS) & mask];
+  if (!*page) {
+    if (!allocate)
+      return nullptr;
+    *page = (Page*)calloc(1, sizeof(Page));
+  }
+  return &(*page)->slots[addr & mask];
+}
+
+const ctype_pin_inst* Static_Code_Image::find(uint64_t addr, bool* provisional) const {
+  uint32_t* entry = const_cast<Static_Code_Image*>(this)->slot(addr, false);
+  if (!entry || !*entry)
+    return nullptr;
+  if (provisional)
+    *provisional = provisional_insts[*entry - 1];
+  return &insts[*entry - 1];
+}
+
+void Static_Code_Image::put(const ctype_pin_inst& inst, bool provisional, bool replace) {
+  uint32_t* entry = slot(inst.instruction_addr, true);
+  if (!entry)
+    return;
+  if (!*entry) {
+    insts.push_back(inst);
+    provisional_insts.push_back(provisional);
+    *entry = insts.size();
+  } else if (replace) {
+    insts[*entry - 1] = inst;
+    provisional_insts[*entry - 1] = provisional;
+  }
+}
+
+void Static_Code_Image::set(const ctype_pin_inst& inst) {
+  put(inst, false, true);
+}
+
+void Static_Code_Image::add(const ctype_pin_inst& inst) {
+  put(inst, true, false);
+}
@@ -0,0 +1,83 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : frontend/static_code_image.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Instructions by address, for frontends that build wrong paths
+ *                out of the code they have seen.
+ *
+ *  A three-level table over the 48-bit canonical address space (12 address
+ *  bits per level) leads to a page with one slot per byte offset, holding the
+ *  index of the instruction that starts there. A lookup is three array loads,
+ *  with no hashing. Directories and pages are allocated on first use.
+ *
+ *  An instruction can be added as provisional, e.g. when it was only seen
+ *  ahead of the fetch point; add() never replaces a known instruction, while
+ *  set() replaces anything and clears the provisional mark.
+ ***************************************************************************************/
+
+#ifndef __STATIC_CODE_IMAGE_H__
+#define __STATIC_CODE_IMAGE_H__
+
+#include <stdint.h>
+#include <vector>
+
+#include "ctype_pin_inst.h"
+
+class Static_Code_Image {
+ public:
+  Static_Code_Image();
+  ~Static_Code_Image();
+
+  /* Returns the instruction starting at addr, or NULL. The pointer is valid
+     until the next instruction is added. */
+  const ctype_pin_inst* find(uint64_t addr, bool* provisional = nullptr) const;
+  /* Adds or replaces the instruction at inst.instruction_addr */
+  void set(const ctype_pin_inst& inst);
+  /* Adds the instruction as provisional if nothing is known at its address */
+  void add(const ctype_pin_inst& inst);
+  uint64_t size() const { return insts.size(); }
+
+ private:
+  static const unsigned LEVEL_BITS = 12;
+  static const uint64_t LEVEL_SIZE = 1ull << LEVEL_BITS;
+
+  struct Page {
+    uint32_t slots[LEVEL_SIZE];  // instruction index + 1, 0 if none
+  };
+  struct Directory {
+    Page* pages[LEVEL_SIZE];
+  };
+  struct Table {
+    Directory* dirs[LEVEL_SIZE];
+  };
+
+  Table* tables[LEVEL_SIZE];
+  std::vector<ctype_pin_inst> insts;
+  std::vector<bool> provisional_insts;
+
+  uint32_t* slot(uint64_t addr, bool allocate);
+  void put(const ctype_pin_inst& inst, bool provisional, bool replace);
+};
+
+#endif  // __STATIC_CODE_IMAGE_H__
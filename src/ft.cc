@@ -44,21 +44,20 @@
 
 uint64_t FT_id_counter = 0;
 
+// Per core free lists of released FTs. A pooled FT keeps the capacity of its
+// op vector, so once the pools are warm, building, splitting and flushing
+// FTs does not allocate.
+std::vector<std::vector<FT*>> ft_free_lists;
+
 /* FT member functions */
-FT::~FT() {
-  ASSERT(proc_id, !ops.empty());
-  Flag all_on_path = !ops[0]->off_path && !ops.back()->off_path;
-  for (auto ft_op : ops) {
-    if (all_on_path || ft_op->off_path) {
-      free_op(ft_op);
-      ft_op->parent_FT = nullptr;
-    }
-  }
+FT::FT(uns _proc_id) : proc_id(_proc_id) {
+  reset();
 }
 
-FT::FT(uns _proc_id) : proc_id(_proc_id) {
-  ft_info.dynamic_info.FT_id = FT_id_counter++;
+void FT::reset() {
+  ft_info.dynamic_info.FT_id = __atomic_fetch_add(&FT_id_counter, 1, __ATOMIC_RELAXED);
   op_pos = 0;
+  ops.clear();
   ft_info.static_info.start = 0;
   ft_info.static_info.length = 0;
   ft_info.static_info.n_uops = 0;
@@ -66,6 +65,34 @@ FT::FT(uns _proc_id) : proc_id(_proc_id) {
   ft_info.dynamic_info.first_op_off_path = FALSE;
 }
 
+void FT::alloc_pools(uns num_cores) {
+  ft_free_lists.resize(num_cores);
+}
+
+FT* FT::alloc(uns proc_id) {
+  auto& free_list = ft_free_lists.at(proc_id);
+  if (free_list.empty())
+    return new FT(proc_id);
+  FT* ft = free_list.back();
+  free_list.pop_back();
+  ft->reset();
+  return ft;
+}
+
+// Frees the ops the FT owns and returns it to the pool of its core.
+void FT::release() {
+  ASSERT(proc_id, !ops.empty());
+  Flag all_on_path = !ops[0]->off_path && !ops.back()->off_path;
+  for (auto ft_op : ops) {
+    if (all_on_path || ft_op->off_path) {
+      free_op(ft_op);
+      ft_op->parent_FT = nullptr;
+    }
+  }
+  ops.clear();
+  ft_free_lists.at(proc_id).push_back(this);
+}
+
 bool FT::can_fetch_op() {
   return op_pos < ops.size();
 }
@@ -97,10 +124,57 @@ void FT::add_op(Op* op) {
 
 Flag FT::build(std::function<bool(uns8)> can_fetch_op_fn, std::function<bool(uns8, Op*)> fetch_op_fn, bool off_path,
                std::function<uint64_t()> get_next_op_id_fn) {
+  return build_ops(can_fetch_op_fn, fetch_op_fn, off_path, get_next_op_id_fn);
+}
+
+// Pulls the ops from the frontend an instruction at a time (the first op, then
+// the rest) rather than op by op
+Flag FT::build_from_frontend(bool off_path) {
+  std::vector<Op*> batch;
+  do {
+    uns ready = frontend_ready_ops(proc_id);
+    if (!ready) {
+      std::cout << "Warning could not fetch inst from frontend" << std::endl;
+      release();
+      return false;
+    }
+    batch.resize(ready);
+    for (Op*& op : batch)
+      op = alloc_op(proc_id);
+    uns fetched = frontend_fetch_ops(proc_id, batch.data(), ready);
+    // a short fetch leaves the surplus ops untouched; hand them back
+    for (uns ii = fetched; ii < ready; ii++)
+      unalloc_op(batch[ii]);
+    batch.resize(fetched);
+    if (!fetched) {
+      std::cout << "Warning could not fetch inst from frontend" << std::endl;
+      release();
+      return false;
+    }
+    for (Op* op : batch) {
+      op->off_path = off_path;
+      op->op_num = off_path ? get_next_off_path_op_id() : get_next_on_path_op_id();
+      op->oracle_info.pred_npc = op->oracle_info.npc;
+      op->oracle_info.pred = op->oracle_info.dir;  // for prebuilt, pred is same as dir
+      if (off_path)
+        predict_one_cf_op(op);
+      add_op(op);
+      STAT_EVENT(proc_id, FTQ_FETCHED_INS_ONPATH + off_path);
+    }
+  } while (get_end_reason() == FT_NOT_ENDED);
+
+  generate_ft_info();
+
+  return true;
+}
+
+template <typename Can_Fetch_Op_Fn, typename Fetch_Op_Fn, typename Get_Next_Op_Id_Fn>
+Flag FT::build_ops(Can_Fetch_Op_Fn&& can_fetch_op_fn, Fetch_Op_Fn&& fetch_op_fn, bool off_path,
+                   Get_Next_Op_Id_Fn&& get_next_op_id_fn) {
   do {
     if (!can_fetch_op_fn(proc_id)) {
       std::cout << "Warning could not fetch inst from frontend" << std::endl;
-      delete this;
+      release();
       return false;
     }
     Op* op = alloc_op(proc_id);
@@ -183,7 +257,7 @@ std::pair<FT*, FT*> FT::extract_off_path_ft(uns split_index) {
     return {this, nullptr};
   }
   // Initialize off-path FT that will contain off-path ops after split position
-  FT* off_path_ft = new FT(proc_id);
+  FT* off_path_ft = FT::alloc(proc_id);
 
   for (uns i = 0; i <= split_index; i++) {
     off_path_ft->ops.push_back(ops[i]);
@@ -273,6 +347,7 @@ FT_Event FT::predict_one_cf_op(Op* op) {
 }
 
 FT_PredictResult FT::predict_ft() {
+  bp_prefetch_ops(g_bp_data, ops.data() + op_pos, ops.size() - op_pos);
   for (size_t idx = op_pos; idx < ops.size(); idx++) {
     Op* op = ops[idx];
     FT_Event event = predict_one_cf_op(op);
@@ -403,6 +478,6 @@ FT_Info ft_get_ft_info(FT* ft) {
 void ft_free_op(Op* op) {
   ASSERT(0, op->parent_FT);
   if (op->parent_FT->get_last_op() == op) {
-    delete op->parent_FT;
+    op->parent_FT->release();
   }
 }
\ No newline at end of file
@@ -80,8 +80,9 @@ struct FT_PredictResult {
 
 class FT {
  public:
-  FT(uns _proc_id = 0);
-  ~FT();
+  static void alloc_pools(uns num_cores);
+  static FT* alloc(uns proc_id);
+  void release();
   void add_op(Op* op);
   bool can_fetch_op();
   Op* fetch_op();
@@ -92,6 +93,9 @@ class FT {
   // Change return type to FT_BuildResult
   Flag build(std::function<bool(uns8)> can_fetch_op_fn, std::function<bool(uns8, Op*)> fetch_op_fn, bool off_path,
              std::function<uint64_t()> get_next_op_id_fn);
+  // Same as build() with the frontend_intf fetch calls and the decoupled
+  // frontend op numbering, called directly on the per-op path.
+  Flag build_from_frontend(bool off_path);
 
   FT_PredictResult predict_ft();
   std::pair<FT*, FT*> extract_off_path_ft(uns split_index);
@@ -111,7 +115,12 @@ class FT {
   uint64_t op_pos;
   FT_Info ft_info;
   std::vector<Op*> ops;
+  FT(uns _proc_id);
+  void reset();
   FT_Event predict_one_cf_op(Op* op);
+  template <typename Can_Fetch_Op_Fn, typename Fetch_Op_Fn, typename Get_Next_Op_Id_Fn>
+  Flag build_ops(Can_Fetch_Op_Fn&& can_fetch_op_fn, Fetch_Op_Fn&& fetch_op_fn, bool off_path,
+                 Get_Next_Op_Id_Fn&& get_next_op_id_fn);
   void generate_ft_info();
   friend class Decoupled_FE;
 };
@@ -47,11 +47,33 @@ whenever any assert fails.
 
 #include "debug/debug_macros.h"
 
+/* Assertion tiers, chosen at build time with ASSERT_LEVEL (SCARAB_ASSERT_LEVEL
+   in CMake). ASSERT_CHEAP guards invariants whose violation would corrupt
+   memory or silently skew results and costs a compare or two; ASSERT is the
+   default tier; ASSERT_PARANOID is for checks that walk lists or compare
+   whole structures per op. A tier is compiled in when ASSERT_LEVEL is at
+   least its level. ASSERTU is always on. Defining NO_ASSERT is the same as
+   ASSERT_LEVEL=0.
+   A disabled tier does not evaluate its condition, so the condition must have
+   no side effects: do the call or update first and assert on its result, or
+   use ASSERTU/ASSERTUM for checks of I/O and system calls that must happen.
+   bin/check_assert_side_effects.sh flags the common offenders. */
+#define ASSERT_LEVEL_NONE 0
+#define ASSERT_LEVEL_CHEAP 1
+#define ASSERT_LEVEL_DEFAULT 2
+#define ASSERT_LEVEL_PARANOID 3
+
+#ifndef ASSERT_LEVEL
 #ifdef NO_ASSERT
-#define ENABLE_ASSERTIONS FALSE /* default FALSE */
+#define ASSERT_LEVEL ASSERT_LEVEL_NONE
 #else
-#define ENABLE_ASSERTIONS TRUE /* default TRUE */
+#define ASSERT_LEVEL ASSERT_LEVEL_DEFAULT
 #endif
+#endif
+
+#define ENABLE_ASSERTIONS (ASSERT_LEVEL >= ASSERT_LEVEL_DEFAULT)
+#define ENABLE_CHEAP_ASSERTIONS (ASSERT_LEVEL >= ASSERT_LEVEL_CHEAP)
+#define ENABLE_PARANOID_ASSERTIONS (ASSERT_LEVEL >= ASSERT_LEVEL_PARANOID)
 
 /**************************************************************************************/
 /* Prints the current call stack of Scarab. For the function names to be
@@ -70,13 +92,11 @@ inline void print_backtrace(void) {
 }
 
 /**************************************************************************************/
-/* Asserts that cond is true. If cond is false, prints simulation
- * information and stops the simulation. May be disabled by defining
- * NO_ASSERT. */
-#undef ASSERT
-#define ASSERT(proc_id, cond)                                                                                  \
+/* Asserts that cond is true if enabled (a constant) is. If cond is false,
+ * prints simulation information and stops the simulation. */
+#define ASSERT_IF(enabled, proc_id, cond)                                                                      \
   do {                                                                                                         \
-    if (ENABLE_ASSERTIONS && !(cond)) {                                                                        \
+    if ((enabled) && !(cond)) {                                                                                \
       fflush(mystdout);                                                                                        \
       fprintf(mystderr, "\n");                                                                                 \
       fprintf(mystderr, "%s:%d: ASSERT FAILED (P=%u  O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, proc_id, \
@@ -90,12 +110,12 @@ inline void print_backtrace(void) {
   } while (0)
 
 /**************************************************************************************/
-/* Asserts that cond is true. If cond is false, prints simulation
- * information, prints the printf-style message specified by args, and
- * stops the simulation. May be disabled by defining NO_ASSERT. */
-#define ASSERTM(proc_id, cond, args...)                                                                        \
+/* Asserts that cond is true if enabled (a constant) is. If cond is false,
+ * prints simulation information, prints the printf-style message
+ * specified by args, and stops the simulation. */
+#define ASSERTM_IF(enabled, proc_id, cond, args...)                                                            \
   do {                                                                                                         \
-    if (ENABLE_ASSERTIONS && !(cond)) {                                                                        \
+    if ((enabled) && !(cond)) {                                                                                \
       fflush(mystdout);                                                                                        \
       fprintf(mystderr, "\n");                                                                                 \
       fprintf(mystderr, "%s:%d: ASSERT FAILED (P=%u  O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, proc_id, \
@@ -111,46 +131,22 @@ inline void print_backtrace(void) {
     }                                                                                                          \
   } while (0)
 
-/**************************************************************************************/
-/* Asserts that cond is true. If cond is false, prints simulation
- * information and stops the simulation. Always enabled (NO_ASSERT has
- * no effect). */
-#define ASSERTU(proc_id, cond)                                                                                 \
-  do {                                                                                                         \
-    if (!(cond)) {                                                                                             \
-      fflush(mystdout);                                                                                        \
-      fprintf(mystderr, "\n");                                                                                 \
-      fprintf(mystderr, "%s:%d: ASSERT FAILED (P=%u  O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, proc_id, \
-              op_count[proc_id], inst_count[proc_id], cycle_count);                                            \
-      fprintf(mystderr, "%s\n", #cond);                                                                        \
-      breakpoint(__FILE__, __LINE__);                                                                          \
-      WRITE_STATUS("ASSERT");                                                                                  \
-      print_backtrace();                                                                                       \
-      exit(15);                                                                                                \
-    }                                                                                                          \
-  } while (0)
+/* Default tier. May be disabled by defining NO_ASSERT or a lower ASSERT_LEVEL. */
+#undef ASSERT
+#define ASSERT(proc_id, cond) ASSERT_IF(ENABLE_ASSERTIONS, proc_id, cond)
+#define ASSERTM(proc_id, cond, args...) ASSERTM_IF(ENABLE_ASSERTIONS, proc_id, cond, ##args)
 
-/**************************************************************************************/
-/* Asserts that cond is true. If cond is false, prints simulation
- * information, prints the printf-style message specified by args, and
- * stops the simulation. Always enabled (NO_ASSERT has no effect). */
-#define ASSERTUM(proc_id, cond, args...)                                                                       \
-  do {                                                                                                         \
-    if (!(cond)) {                                                                                             \
-      fflush(mystdout);                                                                                        \
-      fprintf(mystderr, "\n");                                                                                 \
-      fprintf(mystderr, "%s:%d: ASSERT FAILED (P=%u  O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, proc_id, \
-              op_count[proc_id], inst_count[proc_id], cycle_count);                                            \
-      fprintf(mystderr, "%s\n", #cond);                                                                        \
-      fprintf(mystderr, "%s:%d: ASSERT FAILED (P=%u  O=%llu  I=%llu  C=%llu):  ", __FILE__, __LINE__, proc_id, \
-              op_count[proc_id], inst_count[proc_id], cycle_count);                                            \
-      fprintf(mystderr, ##args);                                                                               \
-      breakpoint(__FILE__, __LINE__);                                                                          \
-      WRITE_STATUS("ASSERT");                                                                                  \
-      print_backtrace();                                                                                       \
-      exit(15);                                                                                                \
-    }                                                                                                          \
-  } while (0)
+/* Cheap tier, kept down to ASSERT_LEVEL=1 */
+#define ASSERT_CHEAP(proc_id, cond) ASSERT_IF(ENABLE_CHEAP_ASSERTIONS, proc_id, cond)
+#define ASSERTM_CHEAP(proc_id, cond, args...) ASSERTM_IF(ENABLE_CHEAP_ASSERTIONS, proc_id, cond, ##args)
+
+/* Paranoid tier, only with ASSERT_LEVEL=3 */
+#define ASSERT_PARANOID(proc_id, cond) ASSERT_IF(ENABLE_PARANOID_ASSERTIONS, proc_id, cond)
+#define ASSERTM_PARANOID(proc_id, cond, args...) ASSERTM_IF(ENABLE_PARANOID_ASSERTIONS, proc_id, cond, ##args)
+
+/* Always enabled (NO_ASSERT and ASSERT_LEVEL have no effect) */
+#define ASSERTU(proc_id, cond) ASSERT_IF(TRUE, proc_id, cond)
+#define ASSERTUM(proc_id, cond, args...) ASSERTM_IF(TRUE, proc_id, cond, ##args)
 
 /**************************************************************************************/
 
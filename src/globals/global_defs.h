@@ -63,6 +63,11 @@
 #undef UNUSED
 #define UNUSED(X) (void)(X)
 
+/* Storage class for the "current core" state that the pipeline stages switch
+   between cores (see cmp_set_all_stages). When the cores are simulated on
+   several host threads, each thread keeps its own copy. */
+#define CORE_LOCAL __thread
+
 /**************************************************************************************/
 
 #ifndef NULL
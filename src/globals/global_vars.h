@@ -46,7 +46,7 @@ extern Counter* unique_count_per_core;
 extern Counter* op_count;
 extern Counter* inst_count;
 extern Counter* inst_count_fetched;
-extern Counter cycle_count;
+extern CORE_LOCAL Counter cycle_count;
 extern Counter sim_time;
 extern Counter* uop_count;
 extern Counter* pret_inst_count;
@@ -50,6 +50,7 @@
 #include "frontend/pin_trace_fe.h"
 #include "libs/list_lib.h"
 #include "memory/memory.h"
+#include "memory/tlb.h"
 #include "prefetcher/D_JOLT.h"
 #include "prefetcher/FNL+MMA.h"
 #include "prefetcher/eip.h"
@@ -58,6 +59,7 @@
 #include "prefetcher/stream_pref.h"
 
 #include "cmp_model.h"
+#include "cmp_threads.h"
 #include "decode_stage.h"
 #include "ft.h"
 #include "map.h"
@@ -78,18 +80,19 @@
 
 /**************************************************************************************/
 
-Icache_Stage* ic = NULL;
+CORE_LOCAL Icache_Stage* ic = NULL;
 
 extern Cmp_Model cmp_model;
 extern Memory* mem;
-extern Rob_Stall_Reason rob_stall_reason;
-extern Rob_Block_Issue_Reason rob_block_issue_reason;
+extern CORE_LOCAL Rob_Stall_Reason rob_stall_reason;
+extern CORE_LOCAL Rob_Block_Issue_Reason rob_block_issue_reason;
 
 /**************************************************************************************/
 /* Local prototypes */
 
 static inline void icache_process_ops(Stage_Data* cur_data, Flag fetched_from_uop_cache, uns start_idx);
 static inline Inst_Info** lookup_icache(void);
+static inline Inst_Info** icache_insert(Addr addr, Addr* line_addr, Addr* repl_line_addr);
 static inline void prefetcher_update_on_icache_access(Flag icache_hit);
 static inline void icache_hit_events(void);
 static inline void icache_miss_events(void);
@@ -103,6 +106,8 @@ static inline void log_stats_mshr_hit(Addr line_addr);
 static inline FT_Arbitration_Result ft_arbitration(void);
 static inline Icache_State icache_mem_req_actions(Break_Reason*);
 static inline Icache_State icache_wait_for_miss_actions(Break_Reason*);
+static inline Icache_State icache_wait_for_itlb_actions(Break_Reason*);
+static inline Icache_State ft_arbitration_actions(FT_Arbitration_Result, Break_Reason*);
 static inline Flag fill_icache_stage_data(FT* ft, int requested, Stage_Data* sd);
 static inline void icache_serve_ops(void);
 static inline Icache_State icache_serving_actions(Break_Reason*);
@@ -140,20 +145,10 @@ void init_icache_stage(uns8 proc_id, const char* name) {
 
   ic->current_ft = NULL;
 
-  /* initialize the cache structure */
-  init_cache(&ic->icache, "ICACHE", ICACHE_SIZE, ICACHE_ASSOC, ICACHE_LINE_SIZE, 0, REPL_TRUE_LRU);
-
-  /* init icache_line_info struct - this struct keeps data about corresponding
-   * icache lines */
-  if (WP_COLLECT_STATS) {
-    // init_cache(&ic->icache_line_info, "IC LI", ICACHE_SIZE, ICACHE_ASSOC,
-    // ICACHE_LINE_SIZE,
-    //           sizeof(Icache_Data), REPL_TRUE_LRU);
-    /*init_cache(&ic->icache_line_info, "IC LI", ICACHE_SIZE, ICACHE_ASSOC,*/
-    /*ICACHE_LINE_SIZE, sizeof(Icache_Data), ICACHE_REPL);*/
-    init_cache(&ic->icache_line_info, "IC LI", ICACHE_SIZE, ICACHE_ASSOC, ICACHE_LINE_SIZE, sizeof(Icache_Data),
-               REPL_TRUE_LRU);
-  }
+  /* initialize the cache structure; the Icache_Data about each line is kept in
+   * the line itself, so a single probe finds both */
+  init_cache(&ic->icache, "ICACHE", ICACHE_SIZE, ICACHE_ASSOC, ICACHE_LINE_SIZE,
+             WP_COLLECT_STATS ? sizeof(Icache_Data) : 0, REPL_TRUE_LRU);
 
   // moved the init code from here to reset
   reset_icache_stage();
@@ -190,6 +185,7 @@ void reset_icache_stage() {
 
   ic->off_path = FALSE;
   ic->back_on_path = FALSE;
+  ic->last_hit_way = -1;
   op_count[ic->proc_id] = 1;
   unique_count_per_core[ic->proc_id] = 1;
 }
@@ -287,23 +283,33 @@ Inst_Info** lookup_icache() {
   STAT_EVENT(ic->proc_id, POWER_ICACHE_ACCESS);
   STAT_EVENT(ic->proc_id, POWER_ITLB_ACCESS);
 
-  Inst_Info** line = NULL;
-  line = (Inst_Info**)cache_access(&ic->icache, ic->fetch_addr, &ic->line_addr, TRUE);
+  /* fetch usually stays in the line it hit last, so try that way before
+   * searching the set */
+  Inst_Info** line = (Inst_Info**)cache_access_at(&ic->icache, ic->fetch_addr, &ic->line_addr, TRUE, ic->last_hit_set,
+                                                  ic->last_hit_way);
+  if (line)
+    STAT_EVENT(ic->proc_id, ICACHE_LAST_LINE_HIT);
+  else
+    line = (Inst_Info**)cache_access_way(&ic->icache, ic->fetch_addr, &ic->line_addr, TRUE, &ic->last_hit_set,
+                                         &ic->last_hit_way);
+  Flag icache_hit = line != NULL;
   if (PERFECT_ICACHE && !line)
     line = (Inst_Info**)INIT_CACHE_DATA_VALUE;
 
   // ideal L2 Icache prefetcher
   if (IDEAL_L2_ICACHE_PREFETCHER && !line) {
+    UNCORE_LOCK_SCOPE();
     Addr dummy_line_addr;
     L1_Data* data;
-    Cache* l1_cache = model->mem == MODEL_MEM ? &mem->uncores[ic->proc_id].l1->cache : NULL;
+    Cache* l1_cache = model->mem == MODEL_MEM ? &mem->uncores[ic->proc_id].l1[mem_l1_slice(ic->fetch_addr)].cache : NULL;
     data = l1_cache ? (L1_Data*)cache_access(l1_cache, ic->fetch_addr, &dummy_line_addr, TRUE) : NULL;
     if (data) {  // second level cache hit
       STAT_EVENT(ic->proc_id, L2_IDEAL_FILL_ICACHE);
       // actually bring it into the L1 icache
       Addr dummy_repl_line_addr;
-      line =
-          (Inst_Info**)cache_insert(&ic->icache, ic->proc_id, ic->fetch_addr, &dummy_line_addr, &dummy_repl_line_addr);
+      line = icache_insert(ic->fetch_addr, &dummy_line_addr, &dummy_repl_line_addr);
+      if (WP_COLLECT_STATS)
+        memset(line, 0, sizeof(Icache_Data));
     } else
       STAT_EVENT(ic->proc_id, L2_IDEAL_MISS_ICACHE);
   }
@@ -312,18 +318,23 @@ Inst_Info** lookup_icache() {
     line = ic_pref_cache_access();
   }
 
-  if (WP_COLLECT_STATS) {  // CMP remove?
-    Addr dummy_addr;
-    Icache_Data* line_info = (Icache_Data*)cache_access(&ic->icache_line_info, ic->fetch_addr, &dummy_addr, TRUE);
-    if (line && (line != (Inst_Info**)INIT_CACHE_DATA_VALUE)) {
-      ASSERT(ic->proc_id, line_info);
-      wp_process_icache_hit(line_info, ic->fetch_addr);
-    }
-  }
+  if (WP_COLLECT_STATS && icache_hit)  // CMP remove?
+    wp_process_icache_hit((Icache_Data*)line, ic->fetch_addr);
 
   return line;
 }
 
+/**************************************************************************************/
+/* icache_insert: cache_insert into the icache. The line may now be in two ways,
+ * which cache_access_at cannot see, so the remembered hit is dropped. With
+ * WP_COLLECT_STATS the returned data is the Icache_Data of the new line, still
+ * holding that of the line it replaced. */
+
+Inst_Info** icache_insert(Addr addr, Addr* line_addr, Addr* repl_line_addr) {
+  ic->last_hit_way = -1;
+  return (Inst_Info**)cache_insert(&ic->icache, ic->proc_id, addr, line_addr, repl_line_addr);
+}
+
 void prefetcher_update_on_icache_access(Flag icache_hit) {
   if (EIP_ENABLE)
     eip_prefetch(ic->proc_id, ic->fetch_addr, icache_hit, 0, ic->off_path);
@@ -508,6 +519,23 @@ Icache_State icache_wait_for_miss_actions(Break_Reason* break_fetch) {
   }
 }
 
+/* icache_wait_for_itlb_actions: the FT taken by ft_arbitration waits until its
+   page is translated. The icache may have changed meanwhile, so a hit is looked
+   up again (without counting it twice). A uop cache hit needs no translation. */
+Icache_State icache_wait_for_itlb_actions(Break_Reason* break_fetch) {
+  if (!tlb_translate(ic->proc_id, TLB_INST, ic->fetch_addr, TRUE)) {
+    *break_fetch = BREAK_ITLB_MISS;
+    return ICACHE_WAIT_FOR_ITLB;
+  }
+  if (ic->itlb_wait_result == FT_HIT_ICACHE && !PERFECT_ICACHE) {
+    ic->line = (Inst_Info**)cache_access_way(&ic->icache, ic->fetch_addr, &ic->line_addr, TRUE, &ic->last_hit_set,
+                                             &ic->last_hit_way);
+    if (!ic->line)
+      ic->itlb_wait_result = FT_MISS_BOTH;
+  }
+  return ft_arbitration_actions(ic->itlb_wait_result, break_fetch);
+}
+
 // fill in the icache stage data with current FT in use
 // return if FT has ended
 // if true, the requested number of ops might not be fulfilled
@@ -697,7 +725,10 @@ Icache_State uop_cache_serving_actions(Break_Reason* break_fetch) {
   }
 }
 
-void execute_coupled_FSM() {
+/* begin_fsm_cycle, end_fsm_cycle: the per-cycle bookkeeping around one step of
+ * the fetch FSM */
+
+static inline void begin_fsm_cycle(void) {
   STAT_EVENT(ic->proc_id, ICACHE_CYCLE);
   STAT_EVENT(ic->proc_id, ICACHE_CYCLE_ONPATH + ic->off_path);
   if (ic->off_path)
@@ -707,46 +738,11 @@ void execute_coupled_FSM() {
   ic->back_on_path = FALSE;
   STAT_EVENT(ic->proc_id, FETCH_ON_PATH + ic->off_path);
 
-  Break_Reason break_fetch = BREAK_DONT;
   ic->state = ic->next_state;
   DEBUG(ic->proc_id, "Icache state: %i\n", ic->state);
-  if (ic->icache_stage_resteer_signaled) {
-    ic->icache_stage_resteer_signaled = FALSE;
-    ic->next_state = ICACHE_STAGE_RESTEER;
-    break_fetch = BREAK_ICACHE_STAGE_RESTEER;
-  } else if (ic->state == ICACHE_STAGE_RESTEER) {
-    ASSERT(ic->proc_id, !uc || !uc->current_ft || !ft_can_fetch_op(uc->current_ft));
-    ASSERT(ic->proc_id, !ic->current_ft || !ft_can_fetch_op(ic->current_ft));
+}
 
-    FT_Arbitration_Result result = ft_arbitration();
-    switch (result) {
-      case FT_UNAVAILABLE:
-        ic->next_state = ICACHE_STAGE_RESTEER;
-        break_fetch = BREAK_FT_UNAVAILABLE;
-        break;
-      case FT_MISS_BOTH:
-        ic->next_state = icache_mem_req_actions(&break_fetch);
-        break;
-      case FT_HIT_ICACHE:
-        ic->next_state = icache_serving_actions(&break_fetch);
-        break;
-      case FT_HIT_UOP_CACHE:
-        ic->next_state = uop_cache_serving_actions(&break_fetch);
-        break;
-      default:
-        ASSERT(ic->proc_id, 0);
-    }
-  } else if (ic->state == ICACHE_MEM_REQ) {
-    ic->next_state = icache_mem_req_actions(&break_fetch);
-  } else if (ic->state == ICACHE_WAIT_FOR_MISS) {
-    ic->next_state = icache_wait_for_miss_actions(&break_fetch);
-  } else if (ic->state == ICACHE_SERVING) {
-    ic->next_state = icache_serving_actions(&break_fetch);
-  } else if (ic->state == UOP_CACHE_SERVING) {
-    ic->next_state = uop_cache_serving_actions(&break_fetch);
-  } else {
-    ASSERT(ic->proc_id, 0);
-  }
+static inline void end_fsm_cycle(Break_Reason break_fetch) {
   ASSERT(ic->proc_id, break_fetch != BREAK_DONT);
   if (UOP_CACHE_ENABLE) {
     ASSERT(ic->proc_id, ic->sd.op_count * uc->sd.op_count == 0);
@@ -773,6 +769,61 @@ void execute_coupled_FSM() {
   }
 }
 
+/* ft_arbitration_actions: the first actions on an FT taken by ft_arbitration */
+Icache_State ft_arbitration_actions(FT_Arbitration_Result result, Break_Reason* break_fetch) {
+  switch (result) {
+    case FT_UNAVAILABLE:
+      *break_fetch = BREAK_FT_UNAVAILABLE;
+      return ICACHE_STAGE_RESTEER;
+    case FT_MISS_BOTH:
+      return icache_mem_req_actions(break_fetch);
+    case FT_HIT_ICACHE:
+      return icache_serving_actions(break_fetch);
+    case FT_HIT_UOP_CACHE:
+      return uop_cache_serving_actions(break_fetch);
+    default:
+      ASSERT(ic->proc_id, 0);
+  }
+  return ICACHE_STAGE_RESTEER;
+}
+
+void execute_coupled_FSM() {
+  begin_fsm_cycle();
+
+  Break_Reason break_fetch = BREAK_DONT;
+  if (ic->icache_stage_resteer_signaled) {
+    ic->icache_stage_resteer_signaled = FALSE;
+    ic->next_state = ICACHE_STAGE_RESTEER;
+    break_fetch = BREAK_ICACHE_STAGE_RESTEER;
+  } else if (ic->state == ICACHE_STAGE_RESTEER) {
+    ASSERT(ic->proc_id, !uc || !uc->current_ft || !ft_can_fetch_op(uc->current_ft));
+    ASSERT(ic->proc_id, !ic->current_ft || !ft_can_fetch_op(ic->current_ft));
+
+    FT_Arbitration_Result result = ft_arbitration();
+    if (TLB_ON && (result == FT_MISS_BOTH || result == FT_HIT_ICACHE) &&
+        !tlb_translate(ic->proc_id, TLB_INST, ic->fetch_addr, FALSE)) {
+      ic->itlb_wait_result = result;
+      ic->next_state = ICACHE_WAIT_FOR_ITLB;
+      break_fetch = BREAK_ITLB_MISS;
+    } else {
+      ic->next_state = ft_arbitration_actions(result, &break_fetch);
+    }
+  } else if (ic->state == ICACHE_WAIT_FOR_ITLB) {
+    ic->next_state = icache_wait_for_itlb_actions(&break_fetch);
+  } else if (ic->state == ICACHE_MEM_REQ) {
+    ic->next_state = icache_mem_req_actions(&break_fetch);
+  } else if (ic->state == ICACHE_WAIT_FOR_MISS) {
+    ic->next_state = icache_wait_for_miss_actions(&break_fetch);
+  } else if (ic->state == ICACHE_SERVING) {
+    ic->next_state = icache_serving_actions(&break_fetch);
+  } else if (ic->state == UOP_CACHE_SERVING) {
+    ic->next_state = uop_cache_serving_actions(&break_fetch);
+  } else {
+    ASSERT(ic->proc_id, 0);
+  }
+  end_fsm_cycle(break_fetch);
+}
+
 /**************************************************************************************/
 /* icache_cycle: */
 
@@ -785,6 +836,38 @@ void update_icache_stage() {
   execute_coupled_FSM();
 }
 
+/**************************************************************************************/
+/* icache_stage_next_event_cycle: a serving icache stage whose output has not
+ * been taken by decode (or the IDQ) only counts a stalled cycle */
+
+Counter icache_stage_next_event_cycle() {
+  if (ic->icache_stage_resteer_signaled)
+    return cycle_count + 1;
+  if (ic->next_state != ICACHE_SERVING && ic->next_state != UOP_CACHE_SERVING)
+    return cycle_count + 1;
+  if (ic->sd.op_count || (uc && uc->sd.op_count))
+    return MAX_CTR;
+  return cycle_count + 1;
+}
+
+/**************************************************************************************/
+/* skip_icache_stage: stands in for update_icache_stage in a cycle in which
+ * icache_stage_next_event_cycle() says the stage is stalled */
+
+void skip_icache_stage() {
+  ic->lookups_per_cycle_count = 0;
+  if (UOP_CACHE_ENABLE) {
+    uc->lookups_per_cycle_count = 0;
+  }
+
+  begin_fsm_cycle();
+  if (ic->state == UOP_CACHE_SERVING)
+    STAT_EVENT(ic->proc_id, UCACHE_SERVING_CYCLE_ON_PATH + ic->off_path);
+  else
+    STAT_EVENT(ic->proc_id, ICACHE_SERVING_CYCLE_ON_PATH + ic->off_path);
+  end_fsm_cycle(ic->sd.op_count ? BREAK_ICACHE_STALLED : BREAK_UOP_CACHE_STALLED);
+}
+
 /**************************************************************************************/
 /* icache_process_ops: process fetched ops.
  * In one cycle, icache_process_ops can be executed multiple times, once per fetch target.
@@ -843,7 +926,7 @@ static inline void icache_process_ops(Stage_Data* cur_data, Flag fetched_from_uo
 
     op_count[ic->proc_id]++; /* increment instruction counters */
     unique_count_per_core[ic->proc_id]++;
-    unique_count++;
+    __atomic_add_fetch(&unique_count, 1, __ATOMIC_RELAXED);
     /* check trigger */
     if (op->inst_info->trigger_op_fetched_hook)
       model->op_fetched_hook(op);
@@ -894,10 +977,8 @@ static inline void icache_process_ops(Stage_Data* cur_data, Flag fetched_from_uo
 Flag icache_fill_line(Mem_Req* req)  // cmp FIXME maybe needed to be optimized
 {
   Addr repl_line_addr;
-  Addr repl_line_addr2;
   Inst_Info** line;
   Addr dummy_addr;
-  Addr dummy_addr2;
   Icache_Data* line_info = NULL;
   UNUSED(line);
 
@@ -930,17 +1011,16 @@ Flag icache_fill_line(Mem_Req* req)  // cmp FIXME maybe needed to be optimized
       return TRUE;
     }
 
-    ic->line = (Inst_Info**)cache_insert(&ic->icache, ic->proc_id, ic->fetch_addr, &ic->line_addr, &repl_line_addr);
+    ic->line = icache_insert(ic->fetch_addr, &ic->line_addr, &repl_line_addr);
     DEBUG(ic->proc_id, "Got line switch into ic fetch %llx\n", ic->line_addr);
     STAT_EVENT(ic->proc_id, ICACHE_FILL);
 
     if (WP_COLLECT_STATS) {  // cmp IGNORE
-      line_info = (Icache_Data*)cache_insert(&ic->icache_line_info, ic->proc_id, ic->fetch_addr, &dummy_addr2,
-                                             &repl_line_addr2);
+      line_info = (Icache_Data*)ic->line;
       if (line_info) {
-        wp_process_icache_evicted(line_info, req, &repl_line_addr2);
+        wp_process_icache_evicted(line_info, req, &repl_line_addr);
         if (EIP_ENABLE)
-          eip_cache_fill(ic->proc_id, req->addr, repl_line_addr2);
+          eip_cache_fill(ic->proc_id, req->addr, repl_line_addr);
         line_info->fetched_by_offpath = USE_CONFIRMED_OFF ? req->off_path_confirmed : req->off_path;
         line_info->offpath_op_addr = req->oldest_op_addr;
         line_info->offpath_op_unique = req->oldest_op_unique_num;
@@ -997,17 +1077,16 @@ Flag icache_fill_line(Mem_Req* req)  // cmp FIXME maybe needed to be optimized
       return TRUE;
     }
 
-    line = (Inst_Info**)cache_insert(&ic->icache, ic->proc_id, req->addr, &dummy_addr, &repl_line_addr);
+    line = icache_insert(req->addr, &dummy_addr, &repl_line_addr);
 
     if (WP_COLLECT_STATS) {  // cmp IGNORE
-      line_info =
-          (Icache_Data*)cache_insert(&ic->icache_line_info, ic->proc_id, req->addr, &dummy_addr2, &repl_line_addr2);
+      line_info = (Icache_Data*)line;
       if (line_info) {
         STAT_EVENT(ic->proc_id, ICACHE_FILL);
 
-        wp_process_icache_evicted(line_info, req, &repl_line_addr2);
+        wp_process_icache_evicted(line_info, req, &repl_line_addr);
         if (EIP_ENABLE)
-          eip_cache_fill(ic->proc_id, req->addr, repl_line_addr2);
+          eip_cache_fill(ic->proc_id, req->addr, repl_line_addr);
         line_info->fetched_by_offpath = USE_CONFIRMED_OFF ? req->off_path_confirmed : req->off_path;
         line_info->offpath_op_addr = req->oldest_op_addr;
         line_info->offpath_op_unique = req->oldest_op_unique_num;
@@ -1081,8 +1160,9 @@ Inst_Info** ic_pref_cache_access(void) {
   }
 
   if (line) {
-    inserted_line =
-        (Inst_Info**)cache_insert(&ic->icache, ic->proc_id, ic->fetch_addr, &ic->line_addr, &repl_line_addr);
+    inserted_line = icache_insert(ic->fetch_addr, &ic->line_addr, &repl_line_addr);
+    if (WP_COLLECT_STATS)
+      memset(inserted_line, 0, sizeof(Icache_Data));
     DEBUG(ic->proc_id, "ic_pref cache hit:fetch_addr:0x%s \n", hexstr64(ic->fetch_addr));
     STAT_EVENT(ic->proc_id, IC_PREF_MOVE_IC);
 
@@ -1094,8 +1174,9 @@ Inst_Info** ic_pref_cache_access(void) {
 
     if (PREF_ICACHE_HIT_FILL_L1) {
       if (model->mem == MODEL_MEM) {
+        UNCORE_LOCK_SCOPE();
         Addr line_addr;
-        Cache* l1_cache = &mem->uncores[ic->proc_id].l1->cache;
+        Cache* l1_cache = &mem->uncores[ic->proc_id].l1[mem_l1_slice(ic->fetch_addr)].cache;
         L1_Data* l1_data = (L1_Data*)cache_access(l1_cache, ic->fetch_addr, &line_addr, TRUE);
         if (!l1_data) {
           Mem_Req tmp_req;
@@ -1117,7 +1198,7 @@ Inst_Info** ic_pref_cache_access(void) {
 /* Stat Inline Functions */
 
 static inline void wp_process_icache_hit(Icache_Data* line, Addr fetch_addr) {
-  L1_Data* l1_line;
+  L1_Wp_Data* l1_line;
 
   if (!WP_COLLECT_STATS)
     return;
@@ -1131,7 +1212,7 @@ static inline void wp_process_icache_hit(Icache_Data* line, Addr fetch_addr) {
       STAT_EVENT(ic->proc_id, DIST_REQBUF_OFFPATH_USED);
       STAT_EVENT(ic->proc_id, DIST2_REQBUF_OFFPATH_USED_FULL);
 
-      l1_line = do_l1_access_addr(fetch_addr);
+      l1_line = do_l1_wp_access_addr(fetch_addr);
       if (l1_line) {
         if (l1_line->fetched_by_offpath) {
           STAT_EVENT(ic->proc_id, L1_USE_OFFPATH);
@@ -53,6 +53,7 @@ typedef enum Icache_State_enum {
   ICACHE_STAGE_RESTEER,
   ICACHE_MEM_REQ,
   ICACHE_WAIT_FOR_MISS,
+  ICACHE_WAIT_FOR_ITLB,
   ICACHE_SERVING,
   UOP_CACHE_SERVING
 } Icache_State;
@@ -65,6 +66,7 @@ typedef enum Break_Reason_enum {
   BREAK_ICACHE_MISS_REQ_SUCCESS,  // break because of an icache miss where the mem req succeeds
   BREAK_ICACHE_MISS_REQ_FAILURE,  // break because of an icache miss where the mem req fails
   BREAK_ICACHE_WAIT_FOR_MISS,
+  BREAK_ITLB_MISS,  // break because the FT's page is being translated
   BREAK_ICACHE_STALLED,
   BREAK_ICACHE_TO_UOP_CACHE_SWITCH,  // break because in the same cycle switched to fetching from uop cache
   BREAK_ICACHE_READ_LIMIT,           // break because the uop cache has limited read capability
@@ -93,10 +95,13 @@ typedef struct Icache_Stage_struct {
   Icache_State next_state;      /* state that the ICACHE is going to be in next cycle */
   uint64_t wait_for_miss_start; /* time when cache miss was observed */
   Flag icache_miss_fulfilled;
+  FT_Arbitration_Result itlb_wait_result; /* what the FT waiting for the ITLB found */
   Flag icache_stage_resteer_signaled;
 
   Inst_Info** line; /* pointer to current line on a hit */
   Addr line_addr;   /* address of the last cache line hit */
+  uns last_hit_set; /* where the last icache lookup hit, so fetch from the same line */
+  int last_hit_way; /* skips the set search; -1 when nothing is remembered */
   Addr fetch_addr;  /* address to fetch or fetching */
   // keep track of the current FT being used by the icache / uop cache
   FT* current_ft;
@@ -105,8 +110,7 @@ typedef struct Icache_Stage_struct {
 
   Counter rdy_cycle; /* cycle that the henry icache will return data (only used in henry model) */
 
-  Cache icache;           /* the cache storage structure (caches Inst_Info *) */
-  Cache icache_line_info; /* contains info about the icache lines */
+  Cache icache;           /* the cache storage structure; with WP_COLLECT_STATS each line's data is its Icache_Data */
   Cache pref_icache;      /* Prefetcher cache storage structure (caches Inst_Info *) */
   char rand_wb_state[31]; /* State of random number generator for random writeback */
 } Icache_Stage;
@@ -127,7 +131,7 @@ typedef struct Icache_Data_struct {
 /**************************************************************************************/
 /* External Variables */
 
-extern Icache_Stage* ic;
+extern CORE_LOCAL Icache_Stage* ic;
 
 /**************************************************************************************/
 /* Prototypes */
@@ -142,6 +146,8 @@ void recover_icache_stage(void);
 void redirect_icache_stage(void);
 void debug_icache_stage(void);
 void update_icache_stage(void);
+Counter icache_stage_next_event_cycle(void);
+void skip_icache_stage(void);
 
 Flag icache_fill_line(Mem_Req*);
 Flag icache_off_path(void);
@@ -0,0 +1,308 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/***************************************************************************************
+ * File         : idle_skip.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Idle cycle skipping for the cmp model. Memory-bound runs
+ *                spend most chip cycles with every ROB full behind a DRAM
+ *                miss, where the only effect of a cycle is to bump stall
+ *                counters. Once the stages report that nothing can happen
+ *                before some future cycle (their *_next_event_cycle()
+ *                functions), one such cycle is simulated while recording
+ *                the stat increments it makes, a second one confirms them,
+ *                and the following idle chip cycles only replay those
+ *                increments. DRAM keeps ticking every memory cycle; a DRAM
+ *                response shows up in the memory queues and ends the skip.
+ ***************************************************************************************/
+
+#include "idle_skip.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "debug/debug.param.h"
+#include "debug/debug_macros.h"
+
+#include "core.param.h"
+#include "dvfs/dvfs.param.h"
+#include "general.param.h"
+#include "memory/memory.param.h"
+#include "prefetcher/pref.param.h"
+
+#include "bp/bp.h"
+#include "memory/memory.h"
+
+#include "cmp_model.h"
+#include "freq.h"
+#include "idq_stage.h"
+#include "op_pool.h"
+#include "statistics.h"
+#include "topdown.h"
+#include "uop_queue_stage.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_IDLE_SKIP, ##args)
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Idle_Skip_State_enum {
+  IDLE_SKIP_OFF,       // the last chip cycle was not idle
+  IDLE_SKIP_LEARN,     // recording the stat increments of an idle cycle
+  IDLE_SKIP_VERIFY,    // checking that the next idle cycle makes the same ones
+  IDLE_SKIP_SKIPPING,  // replaying the recorded increments
+} Idle_Skip_State;
+
+typedef struct Idle_Stat_Inc_struct {
+  uns proc_id;
+  Stat_Enum stat;
+  Counter inc;
+} Idle_Stat_Inc;
+
+/**************************************************************************************/
+/* Global variables */
+
+static Idle_Skip_State state = IDLE_SKIP_OFF;
+static Flag cycle_recorded = FALSE;  // the current cmp_cycle() is recorded
+static uns64 idle_signature;         // machine state during the idle period
+static Counter idle_until;           // last chip cycle known to be idle
+
+static Counter* stat_snapshot;  // stat counts before the recorded cycle
+static Idle_Stat_Inc* incs;     // stat increments of one idle cycle
+static uns num_incs;
+static uns max_incs;
+
+/**************************************************************************************/
+/* Local prototypes */
+
+static Counter chip_next_event_cycle(void);
+static uns64 chip_signature(void);
+static void take_stat_snapshot(void);
+static Flag diff_stat_snapshot(Flag record);
+
+/**************************************************************************************/
+/* signature_add: */
+
+static inline uns64 signature_add(uns64 sig, uns64 val) {
+  return (sig ^ val) * 0x100000001b3ULL;
+}
+
+/**************************************************************************************/
+/* idle_skip_init: */
+
+void idle_skip_init(void) {
+  if (!IDLE_SKIP)
+    return;
+
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    ASSERTM(0, freq_get_cycle_time(FREQ_DOMAIN_CORES[proc_id]) == freq_get_cycle_time(FREQ_DOMAIN_L1),
+            "IDLE_SKIP needs all cores to run at the L1 frequency (set CHIP_CYCLE_TIME)\n");
+  }
+  /* These features do work on periodic cycle counts that an idle cycle
+     skipped without simulating it could miss */
+  ASSERTM(0, !DVFS_ON && !L1_PART_ON && !CONFIDENCE_ENABLE && !FDIP_ADJUSTABLE_FTQ && SYNC_QUANTUM <= 1,
+          "IDLE_SKIP cannot be combined with DVFS, L1 partitioning, confidence, the adjustable FTQ or SYNC_QUANTUM\n");
+  ASSERTM(0, !(PREF_HFILTER_ON && PREF_HFILTER_RESET_ENABLE), "IDLE_SKIP cannot be combined with hfilter resets\n");
+
+  stat_snapshot = (Counter*)malloc(sizeof(Counter) * NUM_CORES * NUM_GLOBAL_STATS);
+  max_incs = 64;
+  incs = (Idle_Stat_Inc*)malloc(sizeof(Idle_Stat_Inc) * max_incs);
+}
+
+/**************************************************************************************/
+/* chip_next_event_cycle: earliest chip cycle in which a core or the on-chip
+   memory system can do more than count stall cycles */
+
+static Counter chip_next_event_cycle(void) {
+  Counter next_event = memory_next_event_cycle();
+
+  for (uns proc_id = 0; proc_id < NUM_CORES && next_event > cycle_count + 1; proc_id++) {
+    if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+      continue;
+    Bp_Recovery_Info* info = &cmp_model.bp_recovery_info[proc_id];
+    cmp_set_all_stages(proc_id);
+
+    next_event = MIN2(next_event, info->recovery_cycle);
+    next_event = MIN2(next_event, info->redirect_cycle);
+    next_event = MIN2(next_event, node_stage_next_event_cycle());
+    next_event = MIN2(next_event, exec_stage_next_event_cycle());
+    next_event = MIN2(next_event, dcache_stage_next_event_cycle());
+    next_event = MIN2(next_event, map_stage_next_event_cycle(idq_stage_get_stage_data()));
+    next_event = MIN2(next_event, decode_stage_next_event_cycle(&ic->sd));
+  }
+  return next_event;
+}
+
+/**************************************************************************************/
+/* chip_signature: hash of the machine state that changes whenever the parts of
+   the frontend without a *_next_event_cycle() function make progress */
+
+static uns64 chip_signature(void) {
+  uns64 sig = 0xcbf29ce484222325ULL;
+
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    cmp_set_all_stages(proc_id);
+    sig = signature_add(sig, op_count[proc_id]);
+    sig = signature_add(sig, unique_count_per_core[proc_id]);
+    sig = signature_add(sig, inst_count[proc_id]);
+    sig = signature_add(sig, node->ret_op);
+    sig = signature_add(sig, (uns64)(uintptr_t)node->node_precommit);
+    sig = signature_add(sig, ic->sd.op_count);
+    sig = signature_add(sig, ic->state);
+    sig = signature_add(sig, ic->next_state);
+    sig = signature_add(sig, uc->sd.op_count);
+    sig = signature_add(sig, idq_stage_get_stage_data()->op_count);
+    if (uop_queue_stage_get_latest_sd())
+      sig = signature_add(sig, uop_queue_stage_get_latest_sd()->op_count);
+    sig = signature_add(sig, decoupled_fe_ftq_num_ops());
+    sig = signature_add(sig, decoupled_fe_ftq_num_fts());
+    sig = signature_add(sig, mem_get_req_count(proc_id));
+    sig = signature_add(sig, topdown_idle_signature(proc_id));
+  }
+  sig = signature_add(sig, op_pool_active_ops);
+  return sig;
+}
+
+/**************************************************************************************/
+/* take_stat_snapshot: */
+
+static void take_stat_snapshot(void) {
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Counter* snapshot = &stat_snapshot[proc_id * NUM_GLOBAL_STATS];
+    for (uns stat = 0; stat < NUM_GLOBAL_STATS; stat++) {
+      snapshot[stat] = GET_STAT_EVENT(proc_id, stat);
+    }
+  }
+}
+
+/**************************************************************************************/
+/* diff_stat_snapshot: records the stat increments since take_stat_snapshot()
+   if record is set, otherwise returns whether they match the recorded ones */
+
+static Flag diff_stat_snapshot(Flag record) {
+  uns num = 0;
+
+  if (record)
+    num_incs = 0;
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Counter* snapshot = &stat_snapshot[proc_id * NUM_GLOBAL_STATS];
+    for (uns stat = 0; stat < NUM_GLOBAL_STATS; stat++) {
+      if (global_stat_array[proc_id][stat].type == FLOAT_TYPE_STAT)
+        continue;
+      Counter inc = GET_STAT_EVENT(proc_id, stat) - snapshot[stat];
+      if (!inc)
+        continue;
+      if (record) {
+        if (num_incs == max_incs) {
+          max_incs *= 2;
+          incs = (Idle_Stat_Inc*)realloc(incs, sizeof(Idle_Stat_Inc) * max_incs);
+        }
+        incs[num_incs++] = (Idle_Stat_Inc){proc_id, (Stat_Enum)stat, inc};
+      } else if (num >= num_incs || incs[num].proc_id != proc_id || incs[num].stat != stat ||
+                 incs[num].inc != inc) {
+        return FALSE;
+      }
+      num++;
+    }
+  }
+  return record || num == num_incs;
+}
+
+/**************************************************************************************/
+/* idle_skip_cycle_begin: */
+
+Flag idle_skip_cycle_begin(void) {
+  cycle_recorded = FALSE;
+  if (!IDLE_SKIP || !freq_is_ready(FREQ_DOMAIN_L1))
+    return FALSE;
+
+  /* DRAM cycles are always simulated in full */
+  if (freq_is_ready(FREQ_DOMAIN_MEMORY)) {
+    state = IDLE_SKIP_OFF;
+    return FALSE;
+  }
+
+  cycle_count = freq_cycle_count(FREQ_DOMAIN_L1);
+  if (state == IDLE_SKIP_SKIPPING && cycle_count <= idle_until && chip_signature() == idle_signature) {
+    for (uns ii = 0; ii < num_incs; ii++) {
+      INC_STAT_EVENT(incs[ii].proc_id, incs[ii].stat, incs[ii].inc);
+    }
+    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+        continue;
+      set_node_stage(&cmp_model.node_stage[proc_id]);
+      node_stage_skip_idle_cycle();
+      topdown_idle_cycle(proc_id);
+    }
+    STAT_EVENT(0, IDLE_SKIP_CYCLES);
+    return TRUE;
+  }
+
+  Counter next_event = chip_next_event_cycle();
+  if (next_event <= cycle_count + 1) {
+    state = IDLE_SKIP_OFF;
+    return FALSE;
+  }
+
+  /* this cycle is idle: record or verify its stat increments */
+  if (state != IDLE_SKIP_LEARN || chip_signature() != idle_signature)
+    state = IDLE_SKIP_OFF;
+  idle_until = next_event - 1;
+  idle_signature = chip_signature();
+  take_stat_snapshot();
+  cycle_recorded = TRUE;
+  return FALSE;
+}
+
+/**************************************************************************************/
+/* idle_skip_cycle_end: */
+
+void idle_skip_cycle_end(void) {
+  if (!cycle_recorded)
+    return;
+  cycle_recorded = FALSE;
+
+  if (chip_signature() != idle_signature) {
+    state = IDLE_SKIP_OFF;
+    return;
+  }
+  if (state == IDLE_SKIP_OFF) {
+    diff_stat_snapshot(TRUE);
+    state = IDLE_SKIP_LEARN;
+  } else if (diff_stat_snapshot(FALSE)) {
+    state = IDLE_SKIP_SKIPPING;
+    DEBUG(0, "Skipping idle chip cycles up to %llu\n", idle_until);
+  } else {
+    diff_stat_snapshot(TRUE);
+    state = IDLE_SKIP_LEARN;
+  }
+}
@@ -0,0 +1,52 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/***************************************************************************************
+ * File         : idle_skip.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Skips the simulation of chip cycles in which no core and no
+ *                on-chip memory queue can make progress (see IDLE_SKIP).
+ ***************************************************************************************/
+
+#ifndef __IDLE_SKIP_H__
+#define __IDLE_SKIP_H__
+
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Prototypes */
+
+void idle_skip_init(void);
+
+/* Called at the beginning of every cmp_cycle(). Returns TRUE if the current
+   time step was an idle chip cycle that has been accounted for without
+   simulating it. */
+Flag idle_skip_cycle_begin(void);
+
+/* Called at the end of every simulated cmp_cycle() */
+void idle_skip_cycle_end(void);
+
+/**************************************************************************************/
+
+#endif /* #ifndef __IDLE_SKIP_H__ */
@@ -40,7 +40,9 @@ extern "C" {
 #include "globals/global_vars.h"
 #include "globals/utils.h"
 
+#include "core.param.h"
 #include "memory/memory.param.h"
+#include "statistics.h"
 
 #include "bp/bp.h"
 
@@ -64,7 +66,8 @@ class IDQ_Stage {
  private:
   uns8 proc_id;
   int capacity;
-  std::vector<Op*> ops;
+  std::vector<Op*> ops;  // ring of a power-of-two size of at least capacity
+  int mask;
   int occupied_count;
   int head;
   int tail;
@@ -74,15 +77,21 @@ class IDQ_Stage {
   /* the IDQ outpur stage data */
   Stage_Data idq_sd;
 
+  /* update specialized for the output width (WIDTH 0 uses idq_sd.max_op_count) */
+  void (IDQ_Stage::*update_func)(Stage_Data* dec_src_sd, Stage_Data* ic_uopc_sd, Stage_Data* uop_queue_sd);
+
   Stage_Data* select_input_stage_data(Stage_Data* dec_src_sd, Stage_Data* ic_uopc_sd, Stage_Data* uop_queue_sd);
+  template <int WIDTH>
+  void update_width(Stage_Data* dec_src_sd, Stage_Data* ic_uopc_sd, Stage_Data* uop_queue_sd);
+  template <int WIDTH>
   void process_input_stage_data(Stage_Data* consume_from_sd, int& count_issued, int& count_issued_on_path);
-  bool enqueue(Op* op);
-  Op* dequeue();
+  void enqueue_block(Op* const* src, int count);
+  int dequeue_block(Op** dst, int max);
   inline int wrap_around(int);
 };
 
 /* Global Variables */
-IDQ_Stage* idq_stage = NULL;
+CORE_LOCAL IDQ_Stage* idq_stage = NULL;
 
 /* Per-Core IDQ_Stage */
 std::vector<IDQ_Stage> per_core_idq_stage;
@@ -90,6 +99,10 @@ std::vector<IDQ_Stage> per_core_idq_stage;
 void IDQ_Stage::init(uns8 _proc_id, const char* name) {
   proc_id = _proc_id;
   capacity = IDQ_SIZE;
+  int ring_size = 1;
+  while (ring_size < capacity)
+    ring_size <<= 1;
+  mask = ring_size - 1;
   next_op_num = 1;
 
   /* Init the IDQ output stage data. */
@@ -100,12 +113,25 @@ void IDQ_Stage::init(uns8 _proc_id, const char* name) {
   idq_sd.ops = (Op**)malloc(sizeof(Op*) * ISSUE_WIDTH);
   idq_sd.op_count = 0;
 
+#define IDQ_UPDATE_WIDTH_CASE(width)               \
+  case width:                                      \
+    update_func = &IDQ_Stage::update_width<width>; \
+    break;
+
+  switch (idq_sd.max_op_count) {
+    STAGE_SPECIALIZED_WIDTHS(IDQ_UPDATE_WIDTH_CASE)
+    default:
+      update_func = &IDQ_Stage::update_width<0>;
+      break;
+  }
+#undef IDQ_UPDATE_WIDTH_CASE
+
   reset();
 }
 
 void IDQ_Stage::reset() {
   ops.clear();
-  ops.resize(capacity, NULL);
+  ops.resize(mask + 1, NULL);
   occupied_count = 0;
   head = 0;
   tail = 0;
@@ -192,21 +218,35 @@ Stage_Data* IDQ_Stage::select_input_stage_data(Stage_Data* dec_src_sd, Stage_Dat
   return consume_from_sd;
 }
 
+template <int WIDTH>
 void IDQ_Stage::process_input_stage_data(Stage_Data* consume_from_sd, int& count_issued, int& count_issued_on_path) {
+  const int width = WIDTH ? WIDTH : idq_sd.max_op_count;
+
   /* Return if the next expected uop has not yet arrived. */
   if (!consume_from_sd) {
     return;
   }
 
-  /* Return if there is no enough space. */
-  if (capacity - occupied_count < consume_from_sd->op_count) {
-    ASSERT(proc_id, idq_sd.op_count == idq_sd.max_op_count);
+  /* While there are slots in the output stage data, the ops bypass the queue
+   * and go straight to the output data; the rest are enqueued. Without
+   * IDQ_PARTIAL_FILL, nothing moves until the whole input block fits. */
+  int available = consume_from_sd->op_count;
+  int bypassed = MIN2(width - idq_sd.op_count, available);
+  int queued = MIN2(capacity - occupied_count, available - bypassed);
+  if (bypassed)
+    ASSERT(proc_id, !occupied_count);
+  if (!IDQ_PARTIAL_FILL && bypassed + queued < available) {
+    ASSERT(proc_id, idq_sd.op_count == width);
+    return;
+  }
+  int taken = bypassed + queued;
+  if (!taken) {
+    ASSERT(proc_id, idq_sd.op_count == width);
     return;
   }
 
   /* Process the input stage data. */
-  int op_count_before_consuming = consume_from_sd->op_count;
-  for (int i = 0; i < op_count_before_consuming; i++) {
+  for (int i = 0; i < taken; i++) {
     Op* op = consume_from_sd->ops[i];
     ASSERT(proc_id, op && op->op_num == next_op_num);
     /* If the uops are fetched from the uop cache,
@@ -215,83 +255,81 @@ void IDQ_Stage::process_input_stage_data(Stage_Data* consume_from_sd, int& count
       ASSERT(proc_id, op->fetched_from_uop_cache);
       decode_stage_process_op(op);
     }
-    /* If there are still slots in the output stage data,
-     * bypass the queue and go straight to the output data.
-     * Otherwise, enqueue the IDQ. */
-    if (idq_sd.op_count < idq_sd.max_op_count) {
-      ASSERT(proc_id, !occupied_count);
-      idq_sd.ops[idq_sd.op_count++] = op;
+    if (i < bypassed) {
       if (!op->off_path) {
         count_issued_on_path++;
       }
       count_issued++;
-    } else {
-      bool success = enqueue(op);
-      ASSERT(proc_id, success);
     }
-    consume_from_sd->ops[i] = NULL;
-    consume_from_sd->op_count--;
     next_op_num++;
   }
-  ASSERT(proc_id, !consume_from_sd->op_count);
+  memcpy(&idq_sd.ops[idq_sd.op_count], consume_from_sd->ops, bypassed * sizeof(Op*));
+  idq_sd.op_count += bypassed;
+  enqueue_block(consume_from_sd->ops + bypassed, queued);
+
+  /* The ops left over move to the front of the input block. */
+  int left = available - taken;
+  memmove(consume_from_sd->ops, consume_from_sd->ops + taken, left * sizeof(Op*));
+  for (int i = left; i < available; i++)
+    consume_from_sd->ops[i] = NULL;
+  consume_from_sd->op_count = left;
+  if (left)
+    STAT_EVENT(proc_id, IDQ_PARTIAL_FILL_CYCLES);
 
   /* The output stage data should be full unless the IDQ is empty. */
-  ASSERT(proc_id, idq_sd.op_count == idq_sd.max_op_count || !occupied_count);
+  ASSERT(proc_id, idq_sd.op_count == width || !occupied_count);
 }
 
 void IDQ_Stage::update(Stage_Data* dec_src_sd, Stage_Data* ic_uopc_sd, Stage_Data* uop_queue_sd) {
+  (this->*update_func)(dec_src_sd, ic_uopc_sd, uop_queue_sd);
+}
+
+template <int WIDTH>
+void IDQ_Stage::update_width(Stage_Data* dec_src_sd, Stage_Data* ic_uopc_sd, Stage_Data* uop_queue_sd) {
+  const int width = WIDTH ? WIDTH : idq_sd.max_op_count;
+  ASSERT(proc_id, width == idq_sd.max_op_count);
+
   /* Fill the IDQ output stage data with uops from IDQ. */
-  int count_issued = 0;
+  int count_issued = dequeue_block(&idq_sd.ops[idq_sd.op_count], width - idq_sd.op_count);
   int count_issued_on_path = 0;
-  for (int i = idq_sd.op_count; i < idq_sd.max_op_count; i++) {
-    Op* op = dequeue();
-    if (!op) {
-      ASSERT(proc_id, !occupied_count);
-      break;
-    }
-    idq_sd.ops[i] = op;
-    idq_sd.op_count++;
-
-    if (!op->off_path) {
+  for (int i = idq_sd.op_count; i < idq_sd.op_count + count_issued; i++) {
+    if (!idq_sd.ops[i]->off_path) {
       count_issued_on_path++;
     }
-    count_issued++;
   }
+  idq_sd.op_count += count_issued;
+  ASSERT(proc_id, idq_sd.op_count == width || !occupied_count);
 
   /* Select the input stage data. */
   Stage_Data* consume_from_sd = select_input_stage_data(dec_src_sd, ic_uopc_sd, uop_queue_sd);
-  process_input_stage_data(consume_from_sd, count_issued, count_issued_on_path);
+  process_input_stage_data<WIDTH>(consume_from_sd, count_issued, count_issued_on_path);
 
   topdown_idq_update(proc_id, idq_sd.op_count, count_issued, count_issued_on_path);
 }
 
-bool IDQ_Stage::enqueue(Op* op) {
-  if (occupied_count == capacity) {
-    return false;
-  }
-  ASSERT(proc_id, op);
-  ops[tail] = op;
-  occupied_count++;
-  ASSERT(proc_id, occupied_count <= capacity);
-  tail = wrap_around(tail + 1);
-  return true;
+/* Copies count ops in at the tail, in at most two pieces around the end of the ring */
+void IDQ_Stage::enqueue_block(Op* const* src, int count) {
+  ASSERT(proc_id, count >= 0 && occupied_count + count <= capacity);
+  int first = MIN2(count, mask + 1 - tail);
+  memcpy(&ops[tail], src, first * sizeof(Op*));
+  memcpy(&ops[0], src + first, (count - first) * sizeof(Op*));
+  occupied_count += count;
+  tail = wrap_around(tail + count);
 }
 
-Op* IDQ_Stage::dequeue() {
-  if (occupied_count == 0) {
-    return NULL;
-  }
-  Op* op = ops[head];
-  ASSERT(proc_id, op);
-  ops[head] = NULL;
-  occupied_count--;
-  ASSERT(proc_id, occupied_count >= 0);
-  head = wrap_around(head + 1);
-  return op;
+/* Copies up to max ops out from the head and returns how many */
+int IDQ_Stage::dequeue_block(Op** dst, int max) {
+  int count = MIN2(max, occupied_count);
+  int first = MIN2(count, mask + 1 - head);
+  memcpy(dst, &ops[head], first * sizeof(Op*));
+  memcpy(dst + first, &ops[0], (count - first) * sizeof(Op*));
+  occupied_count -= count;
+  head = wrap_around(head + count);
+  return count;
 }
 
 int IDQ_Stage::wrap_around(int index) {
-  return (index + capacity) % capacity;
+  return index & mask;
 }
 
 void IDQ_Stage::set_recovery_cycle(int recovery_cycle) {
@@ -43,7 +43,7 @@ typedef struct IDQ_Stage IDQ_Stage;
 /**************************************************************************************/
 /* External Variables */
 
-extern IDQ_Stage* idq_stage;
+extern CORE_LOCAL IDQ_Stage* idq_stage;
 
 /**************************************************************************************/
 /* Prototypes */
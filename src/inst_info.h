@@ -93,6 +93,10 @@ struct Inst_Info_struct {
    * for handling exceptions and uninstrumented code. */
   Flag fake_inst;
   Wrongpath_Nop_Mode_Reason fake_inst_reason;
+
+  /* info of the next uop of the same decoded instruction (NULL for the last one), so a
+   * re-executed instruction finds all of its uops from the first */
+  struct Inst_Info_struct* next_uop;
 };
 
 /**************************************************************************************/
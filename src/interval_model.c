@@ -0,0 +1,436 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : interval_model.c
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : First-order superscalar core model (see interval_model.h).
+ *
+ * Every op is timed once: done = max(dispatch, source ready cycles) + latency. An op whose
+ * source is still waiting on a load miss is deferred and timed when it reaches the ROB head,
+ * where every older producer is known, using the retire view of the register file. A
+ * mispredicted branch stops fetch until it resolves plus the frontend refill, an icache
+ * miss stops fetch until the line returns, and a load miss holds the ROB head until its
+ * request comes back from the memory system, so independent misses overlap within the
+ * window.
+ ***************************************************************************************/
+
+#include "interval_model.h"
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "debug/debug.param.h"
+#include "debug/debug_macros.h"
+#include "debug/debug_print.h"
+
+#include "bp/bp.param.h"
+#include "core.param.h"
+#include "general.param.h"
+#include "memory/memory.param.h"
+
+#include "bp/bp_stream.h"
+#include "frontend/frontend.h"
+#include "isa/isa_macros.h"
+
+#include "freq.h"
+#include "model.h"
+#include "op_pool.h"
+#include "sim.h"
+#include "statistics.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define ROB_ENTRY(core, ii) (&(core)->rob[((core)->rob_head + (ii)) % NODE_TABLE_SIZE])
+
+/**************************************************************************************/
+/* Global variables */
+
+Interval_Model interval_model;
+
+/**************************************************************************************/
+/* Local prototypes */
+
+static void interval_core_cycle(Interval_Core* core);
+static void interval_retire(Interval_Core* core);
+static void interval_fetch(Interval_Core* core);
+static Flag interval_dispatch(Interval_Core* core, Op* op);
+static Flag interval_time_op(Interval_Core* core, Interval_Entry* entry, Counter ready);
+static void interval_set_done(Interval_Core* core, Interval_Entry* entry, Counter done);
+static void interval_predict(Interval_Core* core, Op* op);
+static Flag interval_req_done(Mem_Req* req);
+
+/**************************************************************************************/
+/* interval_init */
+
+void interval_init(uns mode) {
+  if (mode != WARMUP_MODE)
+    return;
+
+  freq_init();
+  interval_model.cores = (Interval_Core*)calloc(NUM_CORES, sizeof(Interval_Core));
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Interval_Core* core = &interval_model.cores[proc_id];
+    core->proc_id = proc_id;
+    init_bp_recovery_info(proc_id, &core->bp_recovery_info);
+    init_bp_data(proc_id, &core->bp_data);
+    init_cache(&core->icache, "ICACHE", ICACHE_SIZE, ICACHE_ASSOC, ICACHE_LINE_SIZE, 0, REPL_TRUE_LRU);
+    init_cache(&core->dcache, "DCACHE", DCACHE_SIZE, DCACHE_ASSOC, DCACHE_LINE_SIZE, 0, DCACHE_REPL);
+    core->rob = (Interval_Entry*)calloc(NODE_TABLE_SIZE, sizeof(Interval_Entry));
+    core->reg_ready = (Counter*)calloc(NUM_REG_IDS, sizeof(Counter));
+    core->reg_writer = (Counter*)calloc(NUM_REG_IDS, sizeof(Counter));
+    core->reg_done = (Counter*)calloc(NUM_REG_IDS, sizeof(Counter));
+  }
+
+  set_memory(&interval_model.memory);
+  init_memory();
+}
+
+/**************************************************************************************/
+/* interval_reset: */
+
+void interval_reset() {
+  reset_memory();
+}
+
+/**************************************************************************************/
+/* interval_cycle: */
+
+void interval_cycle() {
+  update_memory();
+
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+      continue;
+    if (freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
+      cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+      interval_core_cycle(&interval_model.cores[proc_id]);
+    }
+  }
+}
+
+/**************************************************************************************/
+/* interval_debug: */
+
+void interval_debug() {
+  debug_memory();
+}
+
+/**************************************************************************************/
+/* interval_done: */
+
+void interval_done() {
+  finalize_memory();
+}
+
+/**************************************************************************************/
+/* interval_warmup: functional warmup of the branch predictor and the first
+   level caches (the memory system is warmed by the simulated misses). */
+
+void interval_warmup(Op* op) {
+  Interval_Core* core = &interval_model.cores[op->proc_id];
+  Addr line_addr, repl_line_addr;
+
+  if (!cache_access(&core->icache, op->inst_info->addr, &line_addr, TRUE))
+    cache_insert(&core->icache, core->proc_id, op->inst_info->addr, &line_addr, &repl_line_addr);
+  if (op->table_info->mem_type == MEM_LD || op->table_info->mem_type == MEM_ST) {
+    if (!cache_access(&core->dcache, op->oracle_info.va, &line_addr, TRUE))
+      cache_insert(&core->dcache, core->proc_id, op->oracle_info.va, &line_addr, &repl_line_addr);
+  }
+  if (op->table_info->cf_type != NOT_CF)
+    interval_predict(core, op);
+}
+
+/**************************************************************************************/
+/* interval_core_cycle: */
+
+static void interval_core_cycle(Interval_Core* core) {
+  STAT_EVENT(core->proc_id, NODE_CYCLE);
+  interval_retire(core);
+  interval_fetch(core);
+}
+
+/**************************************************************************************/
+/* interval_retire: times a deferred op at the head of the ROB and retires ops
+   in order once their result is available. */
+
+static void interval_retire(Interval_Core* core) {
+  uns proc_id = core->proc_id;
+
+  for (uns ii = 0; ii < NODE_RET_WIDTH && core->rob_count; ii++) {
+    Interval_Entry* entry = ROB_ENTRY(core, 0);
+    Op* op = entry->op;
+
+    if (entry->deferred) {
+      Counter ready = entry->dispatch;
+      for (uns jj = 0; jj < op->table_info->num_src_regs; jj++)
+        ready = MAX2(ready, core->reg_done[op->inst_info->srcs[jj].id]);
+      // a dependent miss is not sent before its address is known
+      if (entry->need_req && ready > cycle_count)
+        break;
+      if (!interval_time_op(core, entry, ready))
+        break;
+    }
+    if (entry->done > cycle_count)
+      break;
+
+    for (uns jj = 0; jj < op->table_info->num_dest_regs; jj++)
+      core->reg_done[op->inst_info->dests[jj].id] = entry->done;
+
+    if (BP_STREAM)
+      bp_stream_op(op);
+    if (op->eom) {
+      inst_count[proc_id]++;
+      STAT_EVENT(proc_id, NODE_INST_COUNT);
+      frontend_retire(proc_id, op->inst_uid);
+      if (op->exit)
+        retired_exit[proc_id] = TRUE;
+    }
+    uop_count[proc_id]++;
+    STAT_EVENT(proc_id, NODE_UOP_COUNT);
+
+    free_op(op);
+    entry->op = NULL;
+    core->rob_head = (core->rob_head + 1) % NODE_TABLE_SIZE;
+    core->rob_count--;
+  }
+}
+
+/**************************************************************************************/
+/* interval_fetch: dispatches up to ISSUE_WIDTH correct path ops into the
+   window unless a miss event stops the frontend. */
+
+static void interval_fetch(Interval_Core* core) {
+  uns proc_id = core->proc_id;
+
+  for (uns ii = 0; ii < ISSUE_WIDTH; ii++) {
+    Stat_Enum stall = NUM_GLOBAL_STATS;
+    if (core->ifetch_line)
+      stall = INTERVAL_STALL_ICACHE_MISS;
+    else if (core->fetch_blocked || cycle_count < core->fetch_ready)
+      stall = INTERVAL_STALL_BR_MISPRED;
+    else if (core->rob_count == NODE_TABLE_SIZE)
+      stall = INTERVAL_STALL_ROB_FULL;
+    if (stall != NUM_GLOBAL_STATS) {
+      if (ii == 0)
+        STAT_EVENT(proc_id, stall);
+      return;
+    }
+
+    Op* op = core->stalled_op;
+    if (!op) {
+      if (retired_exit[proc_id] || !frontend_can_fetch_op(proc_id))
+        return;
+      op = alloc_op(proc_id);
+      frontend_fetch_op(proc_id, op);
+      op->op_num = core->seq + 1;
+      op->unique_num = unique_count++;
+    }
+    if (!interval_dispatch(core, op)) {
+      if (ii == 0 && !core->ifetch_line)
+        STAT_EVENT(proc_id, INTERVAL_STALL_MEM_BUSY);
+      core->stalled_op = op;
+      return;
+    }
+    core->stalled_op = NULL;
+  }
+}
+
+/**************************************************************************************/
+/* interval_dispatch: puts an op in the window. Returns FALSE without changing
+   any state if the op has to wait for the icache or for a memory request
+   buffer. */
+
+static Flag interval_dispatch(Interval_Core* core, Op* op) {
+  uns proc_id = core->proc_id;
+  Addr line_addr;
+
+  Addr iline = op->inst_info->addr & ~(Addr)(ICACHE_LINE_SIZE - 1);
+  if (iline != core->last_iline) {
+    if (!cache_access(&core->icache, iline, &line_addr, TRUE)) {
+      if (!new_mem_req(MRT_IFETCH, proc_id, iline, ICACHE_LINE_SIZE, 0, NULL, interval_req_done, op->unique_num,
+                       NULL))
+        return FALSE;
+      STAT_EVENT(proc_id, INTERVAL_ICACHE_MISS);
+      core->ifetch_line = iline;
+      return FALSE;
+    }
+    core->last_iline = iline;
+  }
+
+  Counter ready = cycle_count;
+  Flag deferred = FALSE;
+  for (uns ii = 0; ii < op->table_info->num_src_regs; ii++) {
+    Counter src_ready = core->reg_ready[op->inst_info->srcs[ii].id];
+    if (src_ready == MAX_CTR)
+      deferred = TRUE;
+    else
+      ready = MAX2(ready, src_ready);
+  }
+
+  uns latency = MAX2(op->inst_info->latency, 1);
+  Addr miss_line = 0;
+  Mem_Type mem_type = op->table_info->mem_type;
+  if (mem_type == MEM_LD || mem_type == MEM_ST) {
+    Addr dline = op->oracle_info.va & ~(Addr)(DCACHE_LINE_SIZE - 1);
+    Flag hit = cache_access(&core->dcache, dline, &line_addr, TRUE) != NULL;
+    if (mem_type == MEM_LD) {
+      latency = DCACHE_CYCLES;
+      if (!hit) {
+        if (!deferred && !new_mem_req(MRT_DFETCH, proc_id, dline, DCACHE_LINE_SIZE, 0, NULL, interval_req_done,
+                                      op->unique_num, NULL))
+          return FALSE;
+        miss_line = dline;
+        STAT_EVENT(proc_id, INTERVAL_DCACHE_MISS);
+      }
+    } else if (!hit) {
+      // stores retire into the store buffer, the line is allocated in the background
+      if (!new_mem_req(MRT_DSTORE, proc_id, dline, DCACHE_LINE_SIZE, 0, NULL, interval_req_done, op->unique_num, NULL))
+        return FALSE;
+      STAT_EVENT(proc_id, INTERVAL_DCACHE_MISS);
+    }
+  }
+
+  Interval_Entry* entry = ROB_ENTRY(core, core->rob_count);
+  core->rob_count++;
+  memset(entry, 0, sizeof(Interval_Entry));
+  entry->op = op;
+  entry->seq = ++core->seq;
+  entry->dispatch = cycle_count;
+  entry->latency = latency;
+  entry->miss_line = miss_line;
+  entry->need_req = miss_line && deferred;
+  entry->deferred = deferred;
+  entry->done = MAX_CTR;
+  for (uns ii = 0; ii < op->table_info->num_dest_regs; ii++) {
+    uns16 id = op->inst_info->dests[ii].id;
+    core->reg_ready[id] = MAX_CTR;
+    core->reg_writer[id] = entry->seq;
+  }
+
+  if (op->table_info->cf_type != NOT_CF) {
+    interval_predict(core, op);
+    if (op->oracle_info.mispred) {
+      STAT_EVENT(proc_id, INTERVAL_BR_MISPRED);
+      entry->mispred = TRUE;
+      core->fetch_blocked = TRUE;
+    } else if (op->oracle_info.misfetch) {
+      // the target is fixed at decode
+      core->fetch_ready = cycle_count + DECODE_CYCLES + EXTRA_REDIRECT_CYCLES + 1;
+    }
+  }
+
+  if (deferred)
+    STAT_EVENT(proc_id, INTERVAL_DEFERRED_OP);
+  else if (!miss_line)
+    interval_time_op(core, entry, ready);
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* interval_time_op: computes when an op with known source ready cycles
+   finishes. A deferred load miss sends its request now instead and finishes
+   when the line returns. Returns FALSE if the request could not be sent. */
+
+static Flag interval_time_op(Interval_Core* core, Interval_Entry* entry, Counter ready) {
+  Addr line_addr;
+  // the line may have been brought in while the op waited
+  if (entry->need_req && cache_access(&core->dcache, entry->miss_line, &line_addr, FALSE)) {
+    entry->need_req = FALSE;
+    entry->miss_line = 0;
+  }
+  if (entry->need_req) {
+    Addr dline = entry->miss_line;
+    if (!new_mem_req(MRT_DFETCH, core->proc_id, dline, DCACHE_LINE_SIZE, 0, NULL, interval_req_done,
+                     entry->op->unique_num, NULL))
+      return FALSE;
+    entry->need_req = FALSE;
+    entry->deferred = FALSE;
+    return TRUE;
+  }
+  entry->deferred = FALSE;
+  interval_set_done(core, entry, ready + entry->latency);
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* interval_set_done: records the completion cycle of an op, makes it visible
+   to younger readers of its destinations and restarts fetch behind a
+   mispredicted branch. */
+
+static void interval_set_done(Interval_Core* core, Interval_Entry* entry, Counter done) {
+  Op* op = entry->op;
+  entry->done = done;
+  for (uns ii = 0; ii < op->table_info->num_dest_regs; ii++) {
+    uns16 id = op->inst_info->dests[ii].id;
+    if (core->reg_writer[id] == entry->seq)
+      core->reg_ready[id] = done;
+  }
+  if (entry->mispred) {
+    core->fetch_blocked = FALSE;
+    core->fetch_ready = done + ICACHE_LATENCY + DECODE_CYCLES + MAP_CYCLES + EXTRA_RECOVERY_CYCLES;
+  }
+}
+
+/**************************************************************************************/
+/* interval_predict: runs a branch through the predictor the way warmup does;
+   only the correct path is simulated, so the predictor is recovered and
+   retired right away. */
+
+static void interval_predict(Interval_Core* core, Op* op) {
+  Bp_Data* bp_data = &core->bp_data;
+  set_bp_recovery_info(&core->bp_recovery_info);
+  bp_train_op(bp_data, op);
+}
+
+/**************************************************************************************/
+/* interval_req_done: fills the first level cache and wakes every op waiting
+   for the line. */
+
+static Flag interval_req_done(Mem_Req* req) {
+  Interval_Core* core = &interval_model.cores[req->proc_id];
+  Addr line_addr, repl_line_addr;
+
+  Addr iline = req->addr & ~(Addr)(ICACHE_LINE_SIZE - 1);
+  if (core->ifetch_line == iline) {
+    cache_insert(&core->icache, core->proc_id, iline, &line_addr, &repl_line_addr);
+    core->ifetch_line = 0;
+  }
+
+  if (!mem_req_is_type(req, MRT_DFETCH) && !mem_req_is_type(req, MRT_DSTORE))
+    return TRUE;
+  Addr dline = req->addr & ~(Addr)(DCACHE_LINE_SIZE - 1);
+  if (!cache_access(&core->dcache, dline, &line_addr, FALSE))
+    cache_insert(&core->dcache, core->proc_id, dline, &line_addr, &repl_line_addr);
+  for (uns ii = 0; ii < core->rob_count; ii++) {
+    Interval_Entry* entry = ROB_ENTRY(core, ii);
+    if (entry->miss_line == dline && !entry->need_req && entry->done == MAX_CTR) {
+      entry->miss_line = 0;
+      interval_set_done(core, entry, cycle_count + DCACHE_CYCLES);
+    }
+  }
+  return TRUE;
+}
@@ -0,0 +1,102 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : interval_model.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : First-order superscalar core model. Only the correct path is
+ *                fetched; ops dispatch in order into a ROB-sized window and are
+ *                timed from their register dependences, so the time between miss
+ *                events (branch mispredicts, icache and dcache misses) follows
+ *                the dependence-limited dispatch rate. The real branch predictor,
+ *                first level caches and memory system provide the miss events.
+ ***************************************************************************************/
+
+#ifndef __INTERVAL_MODEL_H__
+#define __INTERVAL_MODEL_H__
+
+#include "bp/bp.h"
+#include "libs/cache_lib.h"
+#include "memory/memory.h"
+
+/**************************************************************************************/
+/* interval model data  */
+
+typedef struct Interval_Entry_struct {
+  Op* op;
+  Counter seq;       // dispatch sequence number
+  Counter dispatch;  // cycle the op entered the window
+  Counter done;      // cycle the result is available (MAX_CTR while unknown)
+  uns latency;       // execution latency once the sources are ready
+  Addr miss_line;    // dcache line the op waits for (0 if none)
+  Flag deferred;     // a source was pending at dispatch, timed at the ROB head
+  Flag need_req;     // load miss whose request goes out once the op is timed
+  Flag mispred;      // mispredicted branch that fetch waits on
+} Interval_Entry;
+
+typedef struct Interval_Core_struct {
+  uns8 proc_id;
+
+  Bp_Recovery_Info bp_recovery_info;
+  Bp_Data bp_data;
+  Cache icache;
+  Cache dcache;
+
+  Interval_Entry* rob;
+  uns rob_head;
+  uns rob_count;
+  Counter seq;
+
+  Counter* reg_ready;   // dispatch view: cycle each register is ready (MAX_CTR if pending)
+  Counter* reg_writer;  // seq of the youngest dispatched writer of each register
+  Counter* reg_done;    // retire view: ready cycle of the last retired writer
+
+  Counter fetch_ready;  // fetch restarts at this cycle after a redirect
+  Flag fetch_blocked;   // fetch waits on a mispredicted branch that is not timed yet
+  Addr last_iline;      // icache line of the last dispatched op
+  Addr ifetch_line;     // icache line being fetched from memory (0 if none)
+  Op* stalled_op;       // fetched op that could not dispatch yet
+} Interval_Core;
+
+typedef struct Interval_Model_struct {
+  Interval_Core* cores;
+  Memory memory;
+} Interval_Model;
+
+/**************************************************************************************/
+/* Global vars */
+
+extern Interval_Model interval_model;
+
+/**************************************************************************************/
+/* Prototypes */
+
+void interval_init(uns mode);
+void interval_reset(void);
+void interval_cycle(void);
+void interval_debug(void);
+void interval_done(void);
+void interval_warmup(Op*);
+
+/**************************************************************************************/
+
+#endif /* #ifndef __INTERVAL_MODEL_H__ */
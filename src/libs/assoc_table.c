@@ -0,0 +1,67 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : libs/assoc_table.c
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Hashed set-associative table for prefetcher metadata.
+ ***************************************************************************************/
+
+#include "libs/assoc_table.h"
+
+#include "libs/malloc_lib.h"
+#include "libs/mem_footprint.h"
+
+/**************************************************************************************/
+/* init_assoc_table: */
+
+void init_assoc_table(Assoc_Table* table, const char* name, uns proc_id, uns num_entries, uns ways, uns entry_size) {
+  ASSERTM(0, ways && ways <= 64 && num_entries % ways == 0, "%s: %u entries do not fill %u ways\n", name, num_entries,
+          ways);
+  const uns num_sets = num_entries / ways;
+  ASSERTM(0, num_sets && !(num_sets & (num_sets - 1)), "%s: %u sets is not a power of 2\n", name, num_sets);
+
+  table->name = name;
+  table->num_sets = num_sets;
+  table->set_bits = 0;
+  while ((1u << table->set_bits) < num_sets)
+    table->set_bits++;
+  table->ways = ways;
+  table->entry_size = entry_size;
+  table->keys = (Addr*)lazy_calloc(num_entries, sizeof(Addr));
+  table->valid = (uns64*)calloc(num_sets, sizeof(uns64));
+  table->ranks = (uns8*)malloc(num_entries * sizeof(uns8));
+  table->data = (char*)lazy_calloc(num_entries, entry_size);
+  for (uns ii = 0; ii < num_entries; ii++)
+    table->ranks[ii] = ii % ways;
+
+  mem_footprint_add(name, proc_id,
+                    (uns64)num_entries * (sizeof(Addr) + sizeof(uns8) + entry_size) + num_sets * sizeof(uns64));
+}
+
+/**************************************************************************************/
+/* assoc_table_clear: invalidates every entry */
+
+void assoc_table_clear(Assoc_Table* table) {
+  memset(table->valid, 0, table->num_sets * sizeof(uns64));
+}
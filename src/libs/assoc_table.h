@@ -0,0 +1,179 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : libs/assoc_table.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Hashed set-associative table of fixed-size entries keyed by an
+ *                Addr, for prefetcher metadata (index tables, history tables,
+ *                correlation tables). The keys of a set are contiguous and kept
+ *                apart from the entry data, so a lookup reads one or two lines;
+ *                replacement is true LRU within the set.
+ ***************************************************************************************/
+
+#ifndef __ASSOC_TABLE_H__
+#define __ASSOC_TABLE_H__
+
+#include <string.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Types */
+
+/* Every access function takes the number of ways again, and callers pass the
+   compile-time constant they built the table with, so that the way loops of the
+   inlined functions are unrolled. An entry is named by its slot, set * ways +
+   way, which stays the same until the entry is replaced or invalidated. */
+typedef struct Assoc_Table_struct {
+  const char* name;
+  uns num_sets;
+  uns set_bits;
+  uns ways;
+  uns entry_size;
+  Addr* keys;    // num_sets * ways keys, the ways of a set next to each other
+  uns64* valid;  // one bit per way, one word per set
+  uns8* ranks;   // LRU rank of every way, 0 for the MRU way of its set
+  char* data;    // num_sets * ways entries of entry_size bytes
+} Assoc_Table;
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* num_entries / ways must be a power of 2; ways is at most 64. Entries start
+   zeroed and invalid. */
+void init_assoc_table(Assoc_Table* table, const char* name, uns proc_id, uns num_entries, uns ways, uns entry_size);
+void assoc_table_clear(Assoc_Table* table);
+
+/**************************************************************************************/
+/* Inline functions */
+
+static inline uns assoc_table_set(const Assoc_Table* table, Addr key) {
+  // multiply-shift: the top set_bits of the product pick the set
+  return table->set_bits ? (uns)((key * 0x9E3779B97F4A7C15ULL) >> (64 - table->set_bits)) : 0;
+}
+
+static inline void* assoc_table_entry(const Assoc_Table* table, uns slot) {
+  return table->data + (uns64)slot * table->entry_size;
+}
+
+static inline Addr assoc_table_key(const Assoc_Table* table, uns slot) {
+  return table->keys[slot];
+}
+
+static inline Flag assoc_table_slot_valid(const Assoc_Table* table, uns slot, uns ways) {
+  return (table->valid[slot / ways] >> (slot % ways)) & 1;
+}
+
+/* Returns the slot holding key, or -1 */
+static inline int assoc_table_find(const Assoc_Table* table, Addr key, uns ways) {
+  ASSERT(0, ways == table->ways);
+  const uns set = assoc_table_set(table, key);
+  const Addr* keys = &table->keys[set * ways];
+  const uns64 valid = table->valid[set];
+  for (uns ii = 0; ii < ways; ii++) {
+    if (keys[ii] == key && ((valid >> ii) & 1))
+      return set * ways + ii;
+  }
+  return -1;
+}
+
+/* Makes slot the MRU way of its set */
+static inline void assoc_table_touch(Assoc_Table* table, uns slot, uns ways) {
+  uns8* rank = &table->ranks[slot - slot % ways];
+  const uns8 old_rank = rank[slot % ways];
+  for (uns ii = 0; ii < ways; ii++)
+    rank[ii] += rank[ii] < old_rank;
+  rank[slot % ways] = 0;
+}
+
+/* Returns the data of key, or NULL. update_repl makes it the MRU way. */
+static inline void* assoc_table_access(Assoc_Table* table, Addr key, uns ways, Flag update_repl) {
+  const int slot = assoc_table_find(table, key, ways);
+  if (slot < 0)
+    return NULL;
+  if (update_repl)
+    assoc_table_touch(table, slot, ways);
+  return assoc_table_entry(table, slot);
+}
+
+/* Fills key, which must not be in the table, into an invalid way of its set or
+   over the LRU way, and makes it the MRU way. The entry data is zeroed. Returns
+   the slot; *evicted (if not NULL) tells whether a valid key was replaced, and
+   *evicted_key (if not NULL) which one. */
+static inline uns assoc_table_insert_slot(Assoc_Table* table, Addr key, uns ways, Flag* evicted, Addr* evicted_key) {
+  ASSERT(0, ways == table->ways);
+  const uns set = assoc_table_set(table, key);
+  const uns64 valid = table->valid[set];
+  const uns8* rank = &table->ranks[set * ways];
+  uns way = ways;
+  for (uns ii = ways; ii-- > 0;)
+    way = (valid >> ii) & 1 ? way : ii;
+  const Flag replaced = way == ways;
+  if (replaced) {
+    for (uns ii = 0; ii < ways; ii++)
+      way = rank[ii] == ways - 1 ? ii : way;
+  }
+  const uns slot = set * ways + way;
+  if (evicted)
+    *evicted = replaced;
+  if (evicted_key)
+    *evicted_key = replaced ? table->keys[slot] : 0;
+
+  table->keys[slot] = key;
+  table->valid[set] = valid | (1ULL << way);
+  memset(assoc_table_entry(table, slot), 0, table->entry_size);
+  assoc_table_touch(table, slot, ways);
+  return slot;
+}
+
+static inline void* assoc_table_insert(Assoc_Table* table, Addr key, uns ways) {
+  return assoc_table_entry(table, assoc_table_insert_slot(table, key, ways, NULL, NULL));
+}
+
+/* Returns the data of key, inserting a zeroed entry for it if it is missing.
+   *created (if not NULL) tells which happened. Either way key becomes MRU. */
+static inline void* assoc_table_access_create(Assoc_Table* table, Addr key, uns ways, Flag* created) {
+  void* data = assoc_table_access(table, key, ways, TRUE);
+  if (created)
+    *created = data == NULL;
+  return data ? data : assoc_table_insert(table, key, ways);
+}
+
+static inline void assoc_table_invalidate_slot(Assoc_Table* table, uns slot, uns ways) {
+  table->valid[slot / ways] &= ~(1ULL << (slot % ways));
+}
+
+static inline Flag assoc_table_invalidate(Assoc_Table* table, Addr key, uns ways) {
+  const int slot = assoc_table_find(table, key, ways);
+  if (slot < 0)
+    return FALSE;
+  assoc_table_invalidate_slot(table, slot, ways);
+  return TRUE;
+}
+
+/**************************************************************************************/
+
+#endif /* #ifndef __ASSOC_TABLE_H__ */
@@ -0,0 +1,177 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/async_writer.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Buffered output file drained by a background thread.
+ ***************************************************************************************/
+
+#include "libs/async_writer.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "globals/assert.h"
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Async_Writer_Buffer_struct {
+  char* data;
+  uns size;
+  Flag full;  // handed to the writer thread and not written yet
+} Async_Writer_Buffer;
+
+struct Async_Writer_struct {
+  char* path;
+  FILE* file;
+  gzFile gz_file;
+  uns buf_size;
+  Async_Writer_Buffer bufs[2];
+  uns cur_buf;
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  Flag done;
+};
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static void submit_buffer(Async_Writer* writer);
+static void* writer_main(void* arg);
+
+/**************************************************************************************/
+/* async_writer_open: */
+
+Async_Writer* async_writer_open(const char* path, uns buf_size, Flag compress) {
+  ASSERTM(0, buf_size > 0, "Async writer buffer for %s must be nonempty\n", path);
+  Async_Writer* writer = (Async_Writer*)calloc(1, sizeof(Async_Writer));
+  writer->path = strdup(path);
+  if (compress) {
+    writer->gz_file = gzopen(path, "wb1");
+    ASSERTM(0, writer->gz_file, "Could not open %s\n", path);
+  } else {
+    writer->file = fopen(path, "wb");
+    ASSERTM(0, writer->file, "Could not open %s\n", path);
+  }
+  writer->buf_size = buf_size;
+  for (uns ii = 0; ii < 2; ii++) {
+    writer->bufs[ii].data = (char*)malloc(buf_size);
+    writer->bufs[ii].size = 0;
+    writer->bufs[ii].full = FALSE;
+  }
+  writer->cur_buf = 0;
+  writer->done = FALSE;
+  pthread_mutex_init(&writer->mutex, NULL);
+  pthread_cond_init(&writer->cond, NULL);
+  int err = pthread_create(&writer->thread, NULL, writer_main, writer);
+  ASSERTM(0, !err, "Could not create the writer thread for %s (%d)\n", path, err);
+  return writer;
+}
+
+/**************************************************************************************/
+/* async_writer_write: */
+
+void async_writer_write(Async_Writer* writer, const void* data, uns size) {
+  const char* src = (const char*)data;
+  while (size) {
+    Async_Writer_Buffer* buf = &writer->bufs[writer->cur_buf];
+    uns take = MIN2(size, writer->buf_size - buf->size);
+    memcpy(buf->data + buf->size, src, take);
+    buf->size += take;
+    src += take;
+    size -= take;
+    if (buf->size == writer->buf_size)
+      submit_buffer(writer);
+  }
+}
+
+/**************************************************************************************/
+/* async_writer_close: */
+
+void async_writer_close(Async_Writer* writer) {
+  if (writer->bufs[writer->cur_buf].size)
+    submit_buffer(writer);
+
+  pthread_mutex_lock(&writer->mutex);
+  writer->done = TRUE;
+  pthread_cond_broadcast(&writer->cond);
+  pthread_mutex_unlock(&writer->mutex);
+  pthread_join(writer->thread, NULL);
+  pthread_mutex_destroy(&writer->mutex);
+  pthread_cond_destroy(&writer->cond);
+
+  int err = writer->gz_file ? gzclose(writer->gz_file) != Z_OK : fclose(writer->file) != 0;
+  ASSERTM(0, !err, "Could not finish writing %s\n", writer->path);
+  for (uns ii = 0; ii < 2; ii++)
+    free(writer->bufs[ii].data);
+  free(writer->path);
+  free(writer);
+}
+
+/**************************************************************************************/
+/* submit_buffer: hands the current buffer to the writer thread and switches to
+   the other one, waiting only if the thread has fallen a whole buffer behind */
+
+static void submit_buffer(Async_Writer* writer) {
+  pthread_mutex_lock(&writer->mutex);
+  writer->bufs[writer->cur_buf].full = TRUE;
+  pthread_cond_broadcast(&writer->cond);
+  writer->cur_buf ^= 1;
+  while (writer->bufs[writer->cur_buf].full)
+    pthread_cond_wait(&writer->cond, &writer->mutex);
+  pthread_mutex_unlock(&writer->mutex);
+}
+
+/**************************************************************************************/
+/* writer_main: writes full buffers in the order they were submitted */
+
+static void* writer_main(void* arg) {
+  Async_Writer* writer = (Async_Writer*)arg;
+  uns next = 0;
+  pthread_mutex_lock(&writer->mutex);
+  while (TRUE) {
+    while (!writer->bufs[next].full && !writer->done)
+      pthread_cond_wait(&writer->cond, &writer->mutex);
+    if (!writer->bufs[next].full)
+      break;  // done and drained
+    pthread_mutex_unlock(&writer->mutex);
+
+    Async_Writer_Buffer* buf = &writer->bufs[next];
+    int written = writer->gz_file ? gzwrite(writer->gz_file, buf->data, buf->size)
+                                  : (int)fwrite(buf->data, 1, buf->size, writer->file);
+    ASSERTM(0, written == (int)buf->size, "Could not write %s\n", writer->path);
+
+    pthread_mutex_lock(&writer->mutex);
+    buf->size = 0;
+    buf->full = FALSE;
+    pthread_cond_broadcast(&writer->cond);
+    next ^= 1;
+  }
+  pthread_mutex_unlock(&writer->mutex);
+  return NULL;
+}
@@ -0,0 +1,58 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/async_writer.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Buffered output file drained by a background thread. The
+ *                simulator appends to one buffer while the thread writes (and
+ *                optionally gzip-compresses) the other.
+ ***************************************************************************************/
+
+#ifndef __ASYNC_WRITER_H__
+#define __ASYNC_WRITER_H__
+
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Async_Writer_struct Async_Writer;
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Opens path for writing through two buf_size byte buffers. With compress, the
+   file is gzip-compressed by the writer thread. */
+Async_Writer* async_writer_open(const char* path, uns buf_size, Flag compress);
+
+/* Appends size bytes, blocking only when the writer thread is a whole buffer
+   behind */
+void async_writer_write(Async_Writer* writer, const void* data, uns size);
+
+/* Drains the buffers, closes the file and frees the writer */
+void async_writer_close(Async_Writer* writer);
+
+/**************************************************************************************/
+
+#endif /* #ifndef __ASYNC_WRITER_H__ */
@@ -0,0 +1,167 @@
+/* Copyright 2025 Litz Lab
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : blocked_bloom_filter.hpp
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Cache-line blocked bloom filter for 64-bit line addresses.
+ *                A key lives in one 64B block and sets one bit in each of the
+ *                block's eight words, so insert and lookup touch a single
+ *                line and the probe is a masked compare of the whole block.
+ ***************************************************************************************/
+
+#ifndef __BLOCKED_BLOOM_FILTER_HPP__
+#define __BLOCKED_BLOOM_FILTER_HPP__
+
+#include <cmath>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "globals/assert.h"
+#include "globals/global_types.h"
+
+#define BLOCKED_BLOOM_WORDS 8  // one 64-bit word per probe, eight probes per key
+
+/*
+ * Every key is hashed once: a multiply-shift of the key picks the block from
+ * the high half of the hash, and the low half times a per-word odd salt gives
+ * the bit index (top 6 bits) in each word. The eight salted multiplies are
+ * independent, so they map onto one 32-bit vector multiply.
+ *
+ * clear() zeroes the table in place and decay() zeroes the next few blocks in
+ * round-robin order, so a filter can be aged or reset without reallocation.
+ */
+class Blocked_Bloom_Filter {
+ public:
+  /* Size the table for projected_count keys at roughly the given false
+     positive rate. The blocked layout costs a little accuracy against a
+     classic filter of the same size, which the sizing does not correct. */
+  Blocked_Bloom_Filter(uns64 projected_count, double false_positive_rate) : decay_cursor(0), num_inserted(0) {
+    ASSERT(0, projected_count > 0 && false_positive_rate > 0.0 && false_positive_rate < 1.0);
+    double bits = -(double)projected_count * std::log(false_positive_rate) / (std::log(2.0) * std::log(2.0));
+    uns64 num_blocks = (uns64)std::ceil(bits / (BLOCKED_BLOOM_WORDS * 64));
+    blocks.resize(num_blocks ? num_blocks : 1);
+    clear();
+  }
+
+  void insert(uns64 key) {
+    Block mask;
+    Block& block = blocks[block_index(key)];
+    make_mask(key, mask);
+    for (uns ii = 0; ii < BLOCKED_BLOOM_WORDS; ii++)
+      block.word[ii] |= mask.word[ii];
+    num_inserted++;
+  }
+
+  bool contains(uns64 key) const {
+    Block mask;
+    const Block& block = blocks[block_index(key)];
+    make_mask(key, mask);
+#if defined(__AVX2__)
+    __m256i lo = _mm256_load_si256((const __m256i*)&block.word[0]);
+    __m256i hi = _mm256_load_si256((const __m256i*)&block.word[4]);
+    return _mm256_testc_si256(lo, _mm256_load_si256((const __m256i*)&mask.word[0])) &&
+           _mm256_testc_si256(hi, _mm256_load_si256((const __m256i*)&mask.word[4]));
+#else
+    uns64 missing = 0;
+    for (uns ii = 0; ii < BLOCKED_BLOOM_WORDS; ii++)
+      missing |= mask.word[ii] & ~block.word[ii];
+    return missing == 0;
+#endif
+  }
+
+  void clear() {
+    memset(blocks.data(), 0, blocks.size() * sizeof(Block));
+    decay_cursor = 0;
+    num_inserted = 0;
+  }
+
+  /* Zero the next num_blocks blocks, wrapping around the table. Keys in those
+     blocks are forgotten, the others stay. */
+  void decay(uns64 num_blocks) {
+    if (num_blocks >= blocks.size()) {
+      clear();
+      return;
+    }
+    for (uns64 ii = 0; ii < num_blocks; ii++) {
+      memset(&blocks[decay_cursor], 0, sizeof(Block));
+      decay_cursor = decay_cursor + 1 == blocks.size() ? 0 : decay_cursor + 1;
+    }
+  }
+
+  uns64 size_in_bits() const { return blocks.size() * BLOCKED_BLOOM_WORDS * 64; }
+  uns64 inserted() const { return num_inserted; }
+
+ private:
+  struct alignas(64) Block {
+    uns64 word[BLOCKED_BLOOM_WORDS];
+  };
+
+  static uns64 hash(uns64 key) {
+    uns64 h = key * 0x9E3779B97F4A7C15ULL;
+    return h ^ (h >> 29);
+  }
+
+  uns64 block_index(uns64 key) const {
+    // multiply-high maps the top 32 hash bits onto [0, blocks.size())
+    return ((hash(key) >> 32) * (uns64)blocks.size()) >> 32;
+  }
+
+  static void make_mask(uns64 key, Block& mask) {
+    static const uint32_t salt[BLOCKED_BLOOM_WORDS] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                                       0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+    uint32_t low = (uint32_t)hash(key);
+#if defined(__AVX2__)
+    __m256i bit = _mm256_srli_epi32(
+        _mm256_mullo_epi32(_mm256_set1_epi32((int)low), _mm256_loadu_si256((const __m256i*)salt)), 26);
+    __m256i one = _mm256_set1_epi64x(1);
+    _mm256_store_si256((__m256i*)&mask.word[0],
+                       _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(bit))));
+    _mm256_store_si256((__m256i*)&mask.word[4],
+                       _mm256_sllv_epi64(one, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(bit, 1))));
+#elif defined(__ARM_NEON)
+    uint32x4_t key_vec = vdupq_n_u32(low);
+    for (uns ii = 0; ii < BLOCKED_BLOOM_WORDS; ii += 4) {
+      uint32x4_t bit = vshrq_n_u32(vmulq_u32(key_vec, vld1q_u32(&salt[ii])), 26);
+      uint64x2_t one = vdupq_n_u64(1);
+      vst1q_u64(&mask.word[ii], vshlq_u64(one, vreinterpretq_s64_u64(vmovl_u32(vget_low_u32(bit)))));
+      vst1q_u64(&mask.word[ii + 2], vshlq_u64(one, vreinterpretq_s64_u64(vmovl_u32(vget_high_u32(bit)))));
+    }
+#else
+    for (uns ii = 0; ii < BLOCKED_BLOOM_WORDS; ii++)
+      mask.word[ii] = 1ULL << ((low * salt[ii]) >> 26);
+#endif
+  }
+
+  std::vector<Block> blocks;
+  uns64 decay_cursor;
+  uns64 num_inserted;
+};
+
+#endif /* #ifndef __BLOCKED_BLOOM_FILTER_HPP__ */
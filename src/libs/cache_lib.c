@@ -29,6 +29,9 @@
 #include "libs/cache_lib.h"
 
 #include <stdlib.h>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 #include "globals/assert.h"
 #include "globals/global_defs.h"
@@ -44,6 +47,9 @@
 #include "memory/memory.param.h"
 
 #include "frontend/frontend_intf.h"
+#include "libs/malloc_lib.h"
+#include "libs/snapshot_lib.h"
+#include "statistics.h"
 
 // DeleteMe
 #define ideal_num_entries 256
@@ -59,6 +65,13 @@
 static inline uns cache_index(Cache* cache, Addr addr, Addr* tag, Addr* line_addr);
 static inline void update_repl_policy(Cache*, Cache_Entry*, uns, uns, Flag);
 static inline Cache_Entry* find_repl_entry(Cache*, uns8, uns, uns*);
+static inline void cache_alloc_tag_store(Cache*);
+static void cache_alloc_lines(Cache* cache, Flag lazy);
+static inline void cache_sync_tag(Cache*, uns, Cache_Entry*);
+static inline int cache_find_way(Cache*, uns, Addr, uns);
+static inline void* cache_lookup(Cache*, Addr, Addr*, Flag, uns*, int*);
+static inline void* cache_touch_line(Cache*, uns, int, Flag);
+static inline void cache_lookup_memo_forget_set(Cache*, uns);
 
 /* for ideal replacement */
 static inline void* access_unsure_lines(Cache*, uns, Addr, Flag);
@@ -87,6 +100,128 @@ uns ext_cache_index(Cache* cache, Addr addr, Addr* tag, Addr* line_addr) {
   return cache_index(cache, addr, tag, line_addr);
 }
 
+/* ext_cache_find_way: the valid way of the set holding tag, -1 if none, matched
+   against the packed tag_store like every lookup of the cache */
+int ext_cache_find_way(Cache* cache, uns set, Addr tag) {
+  return cache_find_way(cache, set, tag, 0);
+}
+
+/**************************************************************************************/
+/* tag store: every write of an entry's valid bit or tag in cache->entries goes through
+   cache_sync_tag, so lookups can match a whole set against the packed tag_store. */
+
+/* cache_alloc_lines: allocates cache->entries. With lazy set, all lines and
+   all line data come from one zeroed lazy_calloc block each, so a large cache
+   costs two mappings instead of a malloc per line, and the data pages are
+   only faulted in as the cache fills. REPL_IDEAL frees line data one by one
+   and cannot use it. */
+static void cache_alloc_lines(Cache* cache, Flag lazy) {
+  uns num_sets = cache->num_sets;
+  uns assoc = cache->assoc;
+  uns data_size = cache->data_size;
+  Cache_Entry* lines = NULL;
+  char* line_data = NULL;
+  uns ii, jj;
+
+  if (lazy) {
+    lines = (Cache_Entry*)lazy_calloc((size_t)num_sets * assoc, sizeof(Cache_Entry));
+    if (data_size)
+      line_data = (char*)lazy_calloc((size_t)num_sets * assoc, data_size);
+  }
+
+  cache->entries = (Cache_Entry**)malloc(sizeof(Cache_Entry*) * num_sets);
+  for (ii = 0; ii < num_sets; ii++) {
+    cache->entries[ii] = lazy ? &lines[(size_t)ii * assoc] : (Cache_Entry*)malloc(sizeof(Cache_Entry) * assoc);
+    /* allocate memory for all of the data elements in each line */
+    for (jj = 0; jj < assoc; jj++) {
+      cache->entries[ii][jj].valid = FALSE;
+      if (data_size && lazy) {
+        cache->entries[ii][jj].data = line_data + ((size_t)ii * assoc + jj) * data_size;
+      } else if (data_size) {
+        cache->entries[ii][jj].data = (void*)malloc(data_size);
+        memset(cache->entries[ii][jj].data, 0, data_size);
+      } else
+        cache->entries[ii][jj].data = INIT_CACHE_DATA_VALUE;
+    }
+  }
+  cache->line_data = line_data;
+  cache->line_ext = NULL;
+  cache->line_ext_size = 0;
+}
+
+static inline void cache_alloc_tag_store(Cache* cache) {
+  uns ii;
+  cache->tag_store = (Addr*)lazy_calloc((size_t)cache->num_sets * cache->assoc, sizeof(Addr));
+  for (ii = 0; ii < cache->num_sets * cache->assoc; ii++)
+    cache->tag_store[ii] = CACHE_TAG_INVALID;
+}
+
+static inline void cache_sync_tag(Cache* cache, uns set, Cache_Entry* line) {
+  uns way = line - cache->entries[set];
+  ASSERT(0, way < cache->assoc);
+  ASSERTM(0, !line->valid || line->tag != CACHE_TAG_INVALID, "Cache '%s' tag collides with CACHE_TAG_INVALID\n",
+          cache->name);
+  cache->tag_store[set * cache->assoc + way] = line->valid ? line->tag : CACHE_TAG_INVALID;
+  if (cache->lookup_memo)
+    cache_lookup_memo_forget_set(cache, set);
+}
+
+/* bit ii of the result is set if tags[ii] == tag, for n <= 64 */
+static inline uns64 cache_tag_match_mask(const Addr* tags, uns n, Addr tag) {
+  uns64 mask = 0;
+  uns ii = 0;
+#if defined(__AVX2__)
+  __m256i key4 = _mm256_set1_epi64x(tag);
+  for (; ii + 4 <= n; ii += 4) {
+    __m256i cmp = _mm256_cmpeq_epi64(_mm256_loadu_si256((const __m256i*)(tags + ii)), key4);
+    mask |= (uns64)_mm256_movemask_pd(_mm256_castsi256_pd(cmp)) << ii;
+  }
+#endif
+#if defined(__SSE2__)
+  /* SSE2 has no 64-bit compare: both 32-bit halves have to match */
+  __m128i key2 = _mm_set1_epi64x(tag);
+  for (; ii + 2 <= n; ii += 2) {
+    __m128i cmp = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(tags + ii)), key2);
+    cmp = _mm_and_si128(cmp, _mm_shuffle_epi32(cmp, _MM_SHUFFLE(2, 3, 0, 1)));
+    mask |= (uns64)_mm_movemask_pd(_mm_castsi128_pd(cmp)) << ii;
+  }
+#endif
+  for (; ii < n; ii++)
+    mask |= (uns64)(tags[ii] == tag) << ii;
+  return mask;
+}
+
+/* cache_find_way: returns the first valid way >= start in the set whose tag matches, -1 if none */
+static inline int cache_find_way(Cache* cache, uns set, Addr tag, uns start) {
+  const Addr* tags = cache->tag_store + set * cache->assoc;
+  uns base;
+
+  for (base = start & ~63U; base < cache->assoc; base += 64) {
+    uns n = MIN2(cache->assoc - base, 64);
+    uns64 mask;
+    /* constant sizes let the compiler fully unroll the common associativities */
+    switch (n) {
+      case 8:
+        mask = cache_tag_match_mask(tags + base, 8, tag);
+        break;
+      case 16:
+        mask = cache_tag_match_mask(tags + base, 16, tag);
+        break;
+      case 32:
+        mask = cache_tag_match_mask(tags + base, 32, tag);
+        break;
+      default:
+        mask = cache_tag_match_mask(tags + base, n, tag);
+        break;
+    }
+    if (base < start)
+      mask &= ~N_BIT_MASK(start - base);
+    if (mask)
+      return base + __builtin_ctzll(mask);
+  }
+  return -1;
+}
+
 /**************************************************************************************/
 /* init_cache: */
 
@@ -98,6 +233,9 @@ void init_cache(Cache* cache, const char* name, uns cache_size, uns assoc, uns l
 
   DEBUG(0, "Initializing cache called '%s'.\n", name);
 
+  cache->lookup_memo = NULL;
+  cache->lookup_memo_size = 0;
+
   if (repl_policy >= REPL_VOID) {
     init_cache_strategy(cache, name, cache_size, assoc, line_size, data_size, repl_policy);
     return;
@@ -122,34 +260,20 @@ void init_cache(Cache* cache, const char* name, uns cache_size, uns assoc, uns l
   /* allocate memory for NMRU replacement counters  */
   cache->repl_ctrs = (uns*)calloc(num_sets, sizeof(uns));
 
-  /* allocate memory for all the sets (pointers to line arrays)  */
-  cache->entries = (Cache_Entry**)malloc(sizeof(Cache_Entry*) * num_sets);
-
-  /* allocate memory for the unsure lists (if necessary) */
-  if (cache->repl_policy == REPL_IDEAL)
-    cache->unsure_lists = (List*)malloc(sizeof(List) * num_sets);
-
   /* allocate memory for all of the lines in each set */
-  for (ii = 0; ii < num_sets; ii++) {
-    cache->entries[ii] = (Cache_Entry*)malloc(sizeof(Cache_Entry) * assoc);
-    /* allocate memory for all of the data elements in each line */
-    for (jj = 0; jj < assoc; jj++) {
-      cache->entries[ii][jj].valid = FALSE;
-      if (data_size) {
-        cache->entries[ii][jj].data = (void*)malloc(data_size);
-        memset(cache->entries[ii][jj].data, 0, data_size);
-      } else
-        cache->entries[ii][jj].data = INIT_CACHE_DATA_VALUE;
-    }
+  cache_alloc_lines(cache, cache->repl_policy != REPL_IDEAL);
 
-    /* initialize the unsure lists (if necessary) */
-    if (cache->repl_policy == REPL_IDEAL) {
+  /* allocate and initialize the unsure lists (if necessary) */
+  if (cache->repl_policy == REPL_IDEAL) {
+    cache->unsure_lists = (Deque*)malloc(sizeof(Deque) * num_sets);
+    for (ii = 0; ii < num_sets; ii++) {
       char list_name[MAX_STR_LENGTH + 1];
       // 21 guaruntees the string will always be smaller than MAX_STR_LENGTH
       snprintf(list_name, MAX_STR_LENGTH, "%.*s unsure [%d]", MAX_STR_LENGTH - 20, cache->name, ii);
-      init_list(&cache->unsure_lists[ii], list_name, sizeof(Cache_Entry), USE_UNSURE_FREE_LISTS);
+      init_deque(&cache->unsure_lists[ii], list_name, sizeof(Cache_Entry), cache->assoc);
     }
   }
+  cache_alloc_tag_store(cache);
   cache->num_demand_access = 0;
   cache->last_update = 0;
 
@@ -201,16 +325,50 @@ void init_cache(Cache* cache, const char* name, uns cache_size, uns assoc, uns l
   cache->tag_incl_offset = FALSE;
 }
 
+/**************************************************************************************/
+/* cache_prefetch_set: brings the tags and entries of the set of addr into the host
+   cache ahead of a cache_access. It has no effect on the simulated cache. */
+
+void cache_prefetch_set(Cache* cache, Addr addr) {
+  Addr tag, line_addr;
+  uns set = cache_index(cache, addr, &tag, &line_addr);
+
+  if (cache->repl_policy >= REPL_VOID || cache->repl_policy == REPL_IDEAL_STORAGE)
+    return;
+  __builtin_prefetch(cache->tag_store + set * cache->assoc);
+  __builtin_prefetch(cache->entries[set]);
+}
+
 /**************************************************************************************/
 /* cache_access: Does a cache lookup based on the address.  Returns a pointer
  * to the cache line data if it is found.  */
 
 void* cache_access(Cache* cache, Addr addr, Addr* line_addr, Flag update_repl) {
+  uns set;
+  int way;
+  return cache_lookup(cache, addr, line_addr, update_repl, &set, &way);
+}
+
+/**************************************************************************************/
+/* cache_access_way: cache_access that also returns where the line was found. *way
+ * is -1 unless exactly one way of the main entries held the line, so a hit in the
+ * unsure list or shadow cache, or on a duplicated line, is never remembered. */
+
+void* cache_access_way(Cache* cache, Addr addr, Addr* line_addr, Flag update_repl, uns* hit_set, int* hit_way) {
+  return cache_lookup(cache, addr, line_addr, update_repl, hit_set, hit_way);
+}
+
+static inline void* cache_lookup(Cache* cache, Addr addr, Addr* line_addr, Flag update_repl, uns* hit_set,
+                                 int* hit_way) {
   Addr tag;
   uns set = cache_index(cache, addr, &tag, line_addr);
-  uns ii;
+  int way;
+  int matches = 0;
   void* line_data = NULL;
 
+  *hit_set = set;
+  *hit_way = -1;
+
   if (cache->repl_policy >= REPL_VOID)
     return cache_access_strategy(cache, addr, line_addr, update_repl);
 
@@ -218,27 +376,38 @@ void* cache_access(Cache* cache, Addr addr, Addr* line_addr, Flag update_repl) {
     return access_ideal_storage(cache, set, tag, addr);
   }
 
-  for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* line = &cache->entries[set][ii];
-
-    if (line->valid && line->tag == tag) {
-      /* update replacement state if necessary */
-      ASSERT(0, line->data);
-      DEBUG(0, "Found line in cache '%s' at (set %u, way %u, base 0x%s)\n", cache->name, set, ii,
-            hexstr64s(line->base));
-
-      if (update_repl) {
-        if (line->pref) {
-          line->pref = FALSE;
-        }
-        cache->num_demand_access++;
-        update_repl_policy(cache, line, set, ii, FALSE);
-        DEBUG(0, "(%s, %d) [0x%x, 0x%x]: in access\n\n", cache->name, cache->repl_policy, cache->num_sets,
-              cache->assoc);
+  if (cache->lookup_memo) {
+    Cache_Lookup_Memo* memo = NULL;
+    for (uns ii = 0; ii < cache->lookup_memo_size; ii++) {
+      if (cache->lookup_memo[ii].valid && cache->lookup_memo[ii].line_addr == *line_addr) {
+        memo = &cache->lookup_memo[ii];
+        break;
       }
-
-      line_data = line->data;
     }
+    STAT_EVENT(cache->lookup_memo_proc_id, cache->lookup_memo_miss_stat + (memo != NULL));
+    if (memo) {
+      ASSERT(0, memo->set == set);
+      *hit_way = memo->way;
+      return memo->way < 0 ? NULL : cache_touch_line(cache, set, memo->way, update_repl);
+    }
+  }
+
+  /* every matching way is visited, in way order, as the per-entry scan did */
+  for (way = cache_find_way(cache, set, tag, 0); way >= 0; way = cache_find_way(cache, set, tag, way + 1)) {
+    DEBUG(0, "Found line in cache '%s' at (set %u, way %u, base 0x%s)\n", cache->name, set, way,
+          hexstr64s(cache->entries[set][way].base));
+    line_data = cache_touch_line(cache, set, way, update_repl);
+    *hit_way = matches++ ? -1 : way;
+  }
+
+  /* a line found in more than one way is left to the full search */
+  if (cache->lookup_memo && matches <= 1) {
+    Cache_Lookup_Memo* memo = &cache->lookup_memo[cache->lookup_memo_next];
+    cache->lookup_memo_next = (cache->lookup_memo_next + 1) % cache->lookup_memo_size;
+    memo->valid = TRUE;
+    memo->line_addr = *line_addr;
+    memo->set = set;
+    memo->way = *hit_way;
   }
 
   if (line_data)
@@ -260,6 +429,84 @@ void* cache_access(Cache* cache, Addr addr, Addr* line_addr, Flag update_repl) {
   return NULL;
 }
 
+/**************************************************************************************/
+/* cache_access_at: repeats a lookup that cache_access_way resolved to (set, way)
+ * without searching the set. Returns NULL, touching nothing, if that way no longer
+ * holds the line of addr; otherwise updates replacement as cache_access would.
+ * The caller must forget (set, way) whenever it may have inserted the line again,
+ * since a second copy in another way would not be seen here. */
+
+void* cache_access_at(Cache* cache, Addr addr, Addr* line_addr, Flag update_repl, uns set, int way) {
+  Addr tag;
+
+  if (way < 0 || cache_index(cache, addr, &tag, line_addr) != set ||
+      cache->tag_store[set * cache->assoc + way] != tag)
+    return NULL;
+
+  ASSERT(0, cache->entries[set][way].valid);
+  return cache_touch_line(cache, set, way, update_repl);
+}
+
+/**************************************************************************************/
+/* cache_touch_line: the part of a hit shared by every lookup path; updates the
+ * replacement state if asked and returns the line data. */
+
+static inline void* cache_touch_line(Cache* cache, uns set, int way, Flag update_repl) {
+  Cache_Entry* line = &cache->entries[set][way];
+
+  /* update replacement state if necessary */
+  ASSERT(0, line->data);
+  if (update_repl) {
+    if (line->pref) {
+      line->pref = FALSE;
+    }
+    cache->num_demand_access++;
+    update_repl_policy(cache, line, set, way, FALSE);
+    DEBUG(0, "(%s, %d) [0x%x, 0x%x]: in access\n\n", cache->name, cache->repl_policy, cache->num_sets,
+          cache->assoc);
+  }
+  return line->data;
+}
+
+/**************************************************************************************/
+/* cache_enable_lookup_memo: remembers the outcome of the last num_entries lookups
+ * of the cache, hits and misses, so probing a line again (a prefetch filter followed
+ * by the demand access, or several accesses to one line) costs a scan of the memo
+ * instead of a set search. Results are the same as without it. Each lookup counts
+ * miss_stat, or the stat after it on a memo hit, for proc_id. Policies that look
+ * past the main entries on a miss keep searching every time. */
+
+void cache_enable_lookup_memo(Cache* cache, uns num_entries, uns8 proc_id, uns miss_stat) {
+  if (!num_entries || cache->repl_policy >= REPL_VOID || cache->repl_policy == REPL_IDEAL ||
+      cache->repl_policy == REPL_SHADOW_IDEAL || cache->repl_policy == REPL_IDEAL_STORAGE)
+    return;
+  cache->lookup_memo = (Cache_Lookup_Memo*)lazy_calloc(num_entries, sizeof(Cache_Lookup_Memo));
+  cache->lookup_memo_size = num_entries;
+  cache->lookup_memo_next = 0;
+  cache->lookup_memo_proc_id = proc_id;
+  cache->lookup_memo_miss_stat = miss_stat;
+}
+
+/**************************************************************************************/
+/* cache_enable_line_ext: gives every line of the cache ext_size zeroed bytes in a
+ * side table, found from the line's data with cache_line_ext. Fields that only
+ * some stats need can live there instead of in the data of every line, so caches
+ * that do not collect those stats keep a small payload. The side table is
+ * allocated lazily like the line data and needs it to be one block. */
+
+void cache_enable_line_ext(Cache* cache, uns ext_size) {
+  ASSERTM(0, cache->line_data, "Cache %s has no line data block for a side table\n", cache->name);
+  cache->line_ext = (char*)lazy_calloc((size_t)cache->num_sets * cache->assoc, ext_size);
+  cache->line_ext_size = ext_size;
+}
+
+static inline void cache_lookup_memo_forget_set(Cache* cache, uns set) {
+  for (uns ii = 0; ii < cache->lookup_memo_size; ii++) {
+    if (cache->lookup_memo[ii].set == set)
+      cache->lookup_memo[ii].valid = FALSE;
+  }
+}
+
 /**************************************************************************************/
 /* cache_insert: returns a pointer to the data section of the new cache line.
    Sets line_addr to the address of the first block of the new line.  Sets
@@ -320,6 +567,7 @@ void* cache_insert_replpos(Cache* cache, uns8 proc_id, Addr addr, Addr* line_add
   new_line->valid = TRUE;
   new_line->tag = tag;
   new_line->base = *line_addr;
+  cache_sync_tag(cache, set, new_line);
   new_line->last_access_time = sim_time;  // FIXME: this fixes valgrind warnings in update_prf_
   new_line->pref = isPrefetch;
 
@@ -408,6 +656,7 @@ void* cache_insert_replpos(Cache* cache, uns8 proc_id, Addr addr, Addr* line_add
       main_line->valid = TRUE;
       main_line->tag = tag;
       main_line->base = *line_addr;
+      cache_sync_tag(cache, set, main_line);
       main_line->last_access_time = sim_time;
     }
   }
@@ -420,15 +669,14 @@ void* cache_insert_replpos(Cache* cache, uns8 proc_id, Addr addr, Addr* line_add
 void cache_invalidate(Cache* cache, Addr addr, Addr* line_addr) {
   Addr tag;
   uns set = cache_index(cache, addr, &tag, line_addr);
-  uns ii;
-
-  for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* line = &cache->entries[set][ii];
-    if (line->tag == tag && line->valid) {
-      line->tag = 0;
-      line->valid = FALSE;
-      line->base = 0;
-    }
+  int way;
+
+  for (way = cache_find_way(cache, set, tag, 0); way >= 0; way = cache_find_way(cache, set, tag, way + 1)) {
+    Cache_Entry* line = &cache->entries[set][way];
+    line->tag = 0;
+    line->valid = FALSE;
+    line->base = 0;
+    cache_sync_tag(cache, set, line);
   }
 
   if (cache->repl_policy == REPL_IDEAL)
@@ -703,14 +951,12 @@ void update_repl_resteer_policy(Cache* cache, Addr addr) {
   Addr tag;
   Addr line_addr;
   uns set = cache_index(cache, addr, &tag, &line_addr);
-  for (ii = 0; ii < cache->assoc; ii++) {
+  for (ii = cache_find_way(cache, set, tag, 0); ii >= 0; ii = cache_find_way(cache, set, tag, ii + 1)) {
     Cache_Entry* line = &cache->entries[set][ii];
-    if (line->valid && line->tag == tag) {
-      ASSERT(0, line->data);
-      DEBUG(0, "updating access time REPL_RESTEER '%s' at (set %u, way %u, base 0x%s)\n", cache->name, set, ii,
-            hexstr64s(line->base));
-      line->last_access_time = sim_time;
-    }
+    ASSERT(0, line->data);
+    DEBUG(0, "updating access time REPL_RESTEER '%s' at (set %u, way %u, base 0x%s)\n", cache->name, set, ii,
+          hexstr64s(line->base));
+    line->last_access_time = sim_time;
   }
 }
 
@@ -736,25 +982,27 @@ uns cache_get_invalid_line_count(Cache* cache, Addr addr) {
 /* access_unsure_lines: */
 
 static inline void* access_unsure_lines(Cache* cache, uns set, Addr tag, Flag update_repl) {
-  List* list = &cache->unsure_lists[set];
+  Deque* list = &cache->unsure_lists[set];
   Cache_Entry* temp;
   int ii;
 
-  for (temp = (Cache_Entry*)list_start_head_traversal(list); temp; temp = (Cache_Entry*)list_next_element(list)) {
+  for (temp = (Cache_Entry*)deque_start_head_traversal(list); temp; temp = (Cache_Entry*)deque_next_element(list)) {
     ASSERT(0, temp->valid);
     if (temp->tag == tag) {
       for (ii = 0; ii < cache->assoc; ii++) {
         if (!cache->entries[set][ii].valid) {
           void* data = cache->entries[set][ii].data;
           memcpy(&cache->entries[set][ii], temp, sizeof(Cache_Entry));
+          cache_sync_tag(cache, set, &cache->entries[set][ii]);
           temp->data = data;
-          ASSERT(0, dl_list_remove_current(list) == temp);
-          ASSERT(0, ++cache->repl_ctrs[set] <= cache->assoc); /* repl ctr holds the sure count */
+          deque_remove_current(list);
+          cache->repl_ctrs[set]++; /* repl ctr holds the sure count */
+          ASSERT(0, cache->repl_ctrs[set] <= cache->assoc);
           if (cache->repl_ctrs[set] == cache->assoc) {
-            for (temp = (Cache_Entry*)list_start_head_traversal(list); temp;
-                 temp = (Cache_Entry*)list_next_element(list))
+            for (temp = (Cache_Entry*)deque_start_head_traversal(list); temp;
+                 temp = (Cache_Entry*)deque_next_element(list))
               free(temp->data);
-            clear_list(&cache->unsure_lists[set]);
+            clear_deque(&cache->unsure_lists[set]);
           }
           return cache->entries[set][ii].data;
         }
@@ -769,19 +1017,20 @@ static inline void* access_unsure_lines(Cache* cache, uns set, Addr tag, Flag up
 /* insert_sure_line: */
 
 static inline Cache_Entry* insert_sure_line(Cache* cache, uns set, Addr tag) {
-  List* list = &cache->unsure_lists[set];
+  Deque* list = &cache->unsure_lists[set];
   int ii;
-  if (list_get_head(list) || cache->repl_ctrs[set] == cache->assoc) {
+  if (deque_get_head(list) || cache->repl_ctrs[set] == cache->assoc) {
     /* if there is an unsure list already, or if we have all sure entries... */
     int count = 0;
     for (ii = 0; ii < cache->assoc; ii++) {
       Cache_Entry* entry = &cache->entries[set][ii];
       if (entry->valid) {
-        Cache_Entry* temp = (Cache_Entry*)dl_list_add_tail(list);
+        Cache_Entry* temp = (Cache_Entry*)deque_add_tail(list);
         memcpy(temp, entry, sizeof(Cache_Entry));
         temp->data = malloc(sizeof(cache->data_size));
         memcpy(entry->data, temp->data, sizeof(cache->data_size));
         entry->valid = FALSE;
+        cache_sync_tag(cache, set, entry);
         count++;
       }
     }
@@ -793,7 +1042,8 @@ static inline Cache_Entry* insert_sure_line(Cache* cache, uns set, Addr tag) {
     for (ii = 0; ii < cache->assoc; ii++) {
       Cache_Entry* entry = &cache->entries[set][ii];
       if (!entry->valid) {
-        ASSERT(0, ++cache->repl_ctrs[set] <= cache->assoc);
+        cache->repl_ctrs[set]++;
+        ASSERT(0, cache->repl_ctrs[set] <= cache->assoc);
         return entry;
       }
     }
@@ -805,13 +1055,13 @@ static inline Cache_Entry* insert_sure_line(Cache* cache, uns set, Addr tag) {
 /* invalidate_unsure_line: */
 
 static inline void invalidate_unsure_line(Cache* cache, uns set, Addr tag) {
-  List* list = &cache->unsure_lists[set];
+  Deque* list = &cache->unsure_lists[set];
   Cache_Entry* temp;
-  for (temp = (Cache_Entry*)list_start_head_traversal(list); temp; temp = (Cache_Entry*)list_next_element(list)) {
+  for (temp = (Cache_Entry*)deque_start_head_traversal(list); temp; temp = (Cache_Entry*)deque_next_element(list)) {
     ASSERT(0, temp->valid);
     if (temp->tag == tag) {
       free(temp->data);
-      dl_list_remove_current(list);
+      deque_remove_current(list);
       return;
     }
   }
@@ -858,6 +1108,7 @@ void* access_shadow_lines(Cache* cache, uns set, Addr tag) {
 
         tmp_line = (cache->entries[set][lru_ind]);
         (cache->entries[set][lru_ind]) = *line;
+        cache_sync_tag(cache, set, &cache->entries[set][lru_ind]);
         *line = tmp_line;
         line->last_access_time = (cache->entries[set][lru_ind]).last_access_time;
         (cache->entries[set][lru_ind]).last_access_time = sim_time;
@@ -1034,6 +1285,7 @@ void* cache_insert_lru(Cache* cache, uns8 proc_id, Addr addr, Addr* line_addr, A
   new_line->valid = TRUE;
   new_line->tag = tag;
   new_line->base = *line_addr;
+  cache_sync_tag(cache, set, new_line);
   update_repl_policy(cache, new_line, set, repl_index, TRUE);
   if (cache->repl_policy == REPL_TRUE_LRU)
     new_line->last_access_time = 137;
@@ -1075,6 +1327,7 @@ void* cache_insert_lru(Cache* cache, uns8 proc_id, Addr addr, Addr* line_addr, A
       main_line->valid = TRUE;
       main_line->tag = tag;
       main_line->base = *line_addr;
+      cache_sync_tag(cache, set, main_line);
       main_line->last_access_time = sim_time;
     }
   }
@@ -1090,8 +1343,47 @@ void reset_cache(Cache* cache) {
   for (ii = 0; ii < cache->num_sets; ii++) {
     for (jj = 0; jj < cache->assoc; jj++) {
       cache->entries[ii][jj].valid = FALSE;
+      cache_sync_tag(cache, ii, &cache->entries[ii][jj]);
+    }
+  }
+}
+
+/**************************************************************************************/
+/* cache_snapshot: saves or restores the tags, data and replacement state of a
+   cache. The cache must have been initialized with the same geometry. */
+
+void cache_snapshot(Cache* cache, Snapshot* snap) {
+  uns ii, jj;
+
+  ASSERTM(0,
+          cache->repl_policy != REPL_IDEAL && cache->repl_policy != REPL_SHADOW_IDEAL &&
+              cache->repl_policy != REPL_IDEAL_STORAGE && cache->repl_policy != REPL_PARTITION &&
+              cache->repl_policy < REPL_VOID,
+          "Snapshots do not support the replacement policy of cache %s\n", cache->name);
+  snapshot_section(snap, cache->name);
+  snapshot_check(snap, "sets", cache->num_sets);
+  snapshot_check(snap, "assoc", cache->assoc);
+  snapshot_check(snap, "line size", cache->line_size);
+  snapshot_check(snap, "data size", cache->data_size);
+  snapshot_check(snap, "replacement policy", cache->repl_policy);
+
+  snapshot_data(snap, cache->repl_ctrs, sizeof(uns) * cache->num_sets);
+  SNAPSHOT_VAR(snap, cache->num_demand_access);
+  SNAPSHOT_VAR(snap, cache->last_update);
+  for (ii = 0; ii < cache->num_sets; ii++) {
+    for (jj = 0; jj < cache->assoc; jj++) {
+      Cache_Entry* line = &cache->entries[ii][jj];
+      void* data = line->data;
+      SNAPSHOT_VAR(snap, *line);
+      line->data = data;
+      if (cache->data_size)
+        snapshot_data(snap, data, cache->data_size);
+      cache_sync_tag(cache, ii, line);
     }
   }
+  snapshot_check(snap, "line ext size", cache->line_ext_size);
+  if (cache->line_ext)
+    snapshot_data(snap, cache->line_ext, (size_t)cache->num_sets * cache->assoc * cache->line_ext_size);
 }
 
 /**************************************************************************************/
@@ -1107,19 +1399,11 @@ int cache_find_pos_in_lru_stack(Cache* cache, uns8 proc_id, Addr addr, Addr* lin
   uns ii;
   int position;
   Cache_Entry* hit_line = NULL;
-  Flag hit = FALSE;
-
-  for (ii = 0; ii < cache->assoc; ii++) {
-    hit_line = &cache->entries[set][ii];
+  int way = cache_find_way(cache, set, tag, 0);
 
-    if (hit_line->valid && hit_line->tag == tag) {
-      hit = TRUE;
-      break;
-    }
-  }
-
-  if (!hit)
+  if (way < 0)
     return -1;
+  hit_line = &cache->entries[set][way];
 
   ASSERT(0, hit_line);
   ASSERT(0, hit_line->proc_id == proc_id);
@@ -1220,12 +1504,16 @@ static inline void cache_debug_print_set(Cache* cache, uns set, uns way, int eve
     if (line == NULL)
       continue;
     DEBUG(0, "(%d <- 0x%x) [0x%x, 0x%x] : {0x%llx, 0x%x, 0x%llx, 0x%x, 0x%x}\n", event, way, set, ii, line->tag,
-          line->valid, line->last_access_time, line->reference_val, line->outcome);
+          line->valid, line->last_access_time, cache->repl_state[set * cache->assoc + ii], line->outcome);
   }
 
   DEBUG(0, "\n");
 }
 
+static inline void repl_update_hit(Cache* cache, uns set, uns way);
+static inline void repl_update_insert(Cache* cache, uns8 proc_id, uns set, uns way);
+static inline Cache_Entry* repl_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, Flag if_external);
+
 /**************************************************************************************/
 /* External Behavior of Calling Strategy (Policy) */
 /*
@@ -1236,10 +1524,12 @@ static inline void cache_debug_print_set(Cache* cache, uns set, uns way, int eve
 void init_cache_strategy(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
                          Repl_Policy repl_policy) {
   int policy = cache_get_policy_index(repl_policy);
+  cache->repl_funcs = NULL;
   if (policy == -1)
     return;
 
   repl_policy_func_table[policy].action_init(cache, name, cache_size, assoc, line_size, data_size, repl_policy);
+  cache->repl_funcs = &repl_policy_func_table[policy];
 }
 
 /*
@@ -1251,26 +1541,24 @@ void* cache_insert_strategy(Cache* cache, uns8 proc_id, Addr addr, Addr* line_ad
   Addr tag;
   uns repl_index;
   Cache_Entry* new_line;
-  int policy;
   uns set = cache_index(cache, addr, &tag, line_addr);
 
-  // Get the selected strategy (policy)
-  policy = cache_get_policy_index(cache->repl_policy);
-  if (policy == -1)
+  if (!cache->repl_funcs)
     return NULL;
 
   DEBUG(0, "%s, %d: Insert Strategy\n", cache->name, cache->repl_policy);
 
   // update_evict -> action_repl -> update_insert
   // External func also directly call it
-  new_line = repl_policy_func_table[policy].update_evict(cache, proc_id, set, &repl_index, NULL, FALSE);
+  new_line = repl_update_evict(cache, proc_id, set, &repl_index, FALSE);
 
   if (new_line->valid)
     *repl_line_addr = new_line->base;
   else
     *repl_line_addr = 0;
-  repl_policy_func_table[policy].action_repl(cache, new_line, proc_id, tag, line_addr, repl_line_addr);
-  repl_policy_func_table[policy].update_insert(cache, proc_id, set, repl_index, NULL);
+  cache->repl_funcs->action_repl(cache, new_line, proc_id, tag, line_addr, repl_line_addr);
+  cache_sync_tag(cache, set, new_line);
+  repl_update_insert(cache, proc_id, set, repl_index);
 
   return new_line->data;
 }
@@ -1283,25 +1571,19 @@ void* cache_insert_strategy(Cache* cache, uns8 proc_id, Addr addr, Addr* line_ad
 void* cache_access_strategy(Cache* cache, Addr addr, Addr* line_addr, Flag update_repl) {
   Addr tag;
   uns set = cache_index(cache, addr, &tag, line_addr);
-  uns ii;
-  int policy;
+  int way;
 
-  // Get the selected strategy (policy)
-  policy = cache_get_policy_index(cache->repl_policy);
-  if (policy == -1)
+  if (!cache->repl_funcs)
     return NULL;
 
   DEBUG(0, "%s, %d: Access Strategy\n", cache->name, cache->repl_policy);
 
-  for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* line = &cache->entries[set][ii];
-
-    if (line->valid && line->tag == tag) {
-      if (update_repl)
-        repl_policy_func_table[policy].update_hit(cache, set, ii, NULL);
+  way = cache_find_way(cache, set, tag, 0);
+  if (way >= 0) {
+    if (update_repl)
+      repl_update_hit(cache, set, way);
 
-      return line->data;
-    }
+    return cache->entries[set][way].data;
   }
 
   return NULL;
@@ -1313,33 +1595,27 @@ void* cache_access_strategy(Cache* cache, Addr addr, Addr* line_addr, Flag updat
   -- called by external func: find_repl_entry
 */
 Cache_Entry* cache_evict_strategy(Cache* cache, uns8 proc_id, uns set, uns* way) {
-  Cache_Entry* new_line;
-  int policy;
-
-  policy = cache_get_policy_index(cache->repl_policy);
-  if (policy == -1)
+  if (!cache->repl_funcs)
     return NULL;
 
   DEBUG(0, "%s, %d: Evict Strategy\n", cache->name, cache->repl_policy);
 
   /* True flag indicates it is called in the external eviction */
-  new_line = repl_policy_func_table[policy].update_evict(cache, proc_id, set, way, NULL, TRUE);
-  return new_line;
+  return repl_update_evict(cache, proc_id, set, way, TRUE);
 }
 
 /**************************************************************************************/
 /* General */
 
-void general_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
-                         Repl_Policy repl_policy);
-void general_action_repl(Cache* cache, Cache_Entry* new_line, uns8 proc_id, Addr tag, Addr* line_addr,
-                         Addr* repl_line_addr);
+static void general_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size,
+                                uns data_size, Repl_Policy repl_policy);
+static void general_action_repl(Cache* cache, Cache_Entry* new_line, uns8 proc_id, Addr tag, Addr* line_addr,
+                                Addr* repl_line_addr);
 
-void general_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
-                         Repl_Policy repl_policy) {
+static void general_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size,
+                                uns data_size, Repl_Policy repl_policy) {
   uns num_lines = cache_size / line_size;
   uns num_sets = cache_size / line_size / assoc;
-  uns ii, jj;
 
   /* set the basic parameters */
   strncpy(cache->name, name, MAX_STR_LENGTH);
@@ -1357,99 +1633,90 @@ void general_action_init(Cache* cache, const char* name, uns cache_size, uns ass
   cache->tag_mask = ~cache->set_mask;                 /* use after shifting */
   cache->offset_mask = N_BIT_MASK(cache->shift_bits); /* use before shifting */
 
-  /* allocate memory for all the sets (pointers to line arrays)  */
-  cache->entries = (Cache_Entry**)malloc(sizeof(Cache_Entry*) * num_sets);
-
   /* allocate memory for all of the lines in each set */
-  for (ii = 0; ii < num_sets; ii++) {
-    cache->entries[ii] = (Cache_Entry*)malloc(sizeof(Cache_Entry) * assoc);
-    /* allocate memory for all of the data elements in each line */
-    for (jj = 0; jj < assoc; jj++) {
-      cache->entries[ii][jj].valid = FALSE;
-      if (data_size) {
-        cache->entries[ii][jj].data = (void*)malloc(data_size);
-        memset(cache->entries[ii][jj].data, 0, data_size);
-      } else
-        cache->entries[ii][jj].data = INIT_CACHE_DATA_VALUE;
-    }
-  }
+  cache_alloc_lines(cache, TRUE);
+  cache_alloc_tag_store(cache);
+  cache->repl_state = (uns8*)lazy_calloc((size_t)num_sets * assoc, sizeof(uns8));
 }
 
-void general_action_repl(Cache* cache, Cache_Entry* new_line, uns8 proc_id, Addr tag, Addr* line_addr,
-                         Addr* repl_line_addr) {
+static void general_action_repl(Cache* cache, Cache_Entry* new_line, uns8 proc_id, Addr tag, Addr* line_addr,
+                                Addr* repl_line_addr) {
   new_line->proc_id = proc_id;
   new_line->valid = TRUE;
   new_line->tag = tag;
   new_line->base = *line_addr;
 }
 
+/* the packed replacement state and tags of a set */
+static inline uns8* repl_set_state(Cache* cache, uns set) {
+  return &cache->repl_state[(size_t)set * cache->assoc];
+}
+
+static inline const Addr* repl_set_tags(Cache* cache, uns set) {
+  return &cache->tag_store[(size_t)set * cache->assoc];
+}
+
 /**************************************************************************************/
 /* LRU */
-void lru_update_hit(Cache* cache, uns set, uns way, void* arg);
-void lru_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
-Cache_Entry* lru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
+static void lru_update_hit(Cache* cache, uns set, uns way, void* arg);
+static void lru_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
+static Cache_Entry* lru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
 
-void lru_update_hit(Cache* cache, uns set, uns way, void* arg) {
-  int ii;
-  uns8 ref_orig = cache->entries[set][way].reference_val;
+static void lru_update_hit(Cache* cache, uns set, uns way, void* arg) {
+  uns8* state = repl_set_state(cache, set);
+  const Addr* tags = repl_set_tags(cache, set);
+  uns ii;
+  uns8 ref_orig = state[way];
 
   // promotion
-  cache->entries[set][way].reference_val = 0;
+  state[way] = 0;
 
   // aging
   for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* entry = &cache->entries[set][ii];
-
-    if (ii == way)
-      continue;
-
-    if (!entry->valid)
+    if (ii == way || tags[ii] == CACHE_TAG_INVALID)
       continue;
 
-    if (entry->reference_val < ref_orig)
-      entry->reference_val++;
+    if (state[ii] < ref_orig)
+      state[ii]++;
   }
 
   cache_debug_print_set(cache, set, way, CACHE_EVENT_HIT);
 }
 
-void lru_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
-  int ii;
+static void lru_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
+  uns8* state = repl_set_state(cache, set);
+  const Addr* tags = repl_set_tags(cache, set);
+  uns ii;
 
   // insertion
-  cache->entries[set][way].reference_val = 0;
+  state[way] = 0;
 
   // aging
   for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* entry = &cache->entries[set][ii];
-
-    if (ii == way)
-      continue;
-
-    if (!entry->valid)
+    if (ii == way || tags[ii] == CACHE_TAG_INVALID)
       continue;
 
-    entry->reference_val++;
+    state[ii]++;
   }
 
   cache_debug_print_set(cache, set, way, CACHE_EVENT_INSERT);
 }
 
-Cache_Entry* lru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
-  int ii;
+static Cache_Entry* lru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
+  const uns8* state = repl_set_state(cache, set);
+  const Addr* tags = repl_set_tags(cache, set);
+  uns ii;
   uns8 oldest_ref = 0;
 
   // search the oldest line
   for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* entry = &cache->entries[set][ii];
-
-    if (!entry->valid) {
+    if (tags[ii] == CACHE_TAG_INVALID) {
       *way = ii;
       break;
     }
-    if (entry->reference_val > oldest_ref) {
+    if (state[ii] > oldest_ref) {
       *way = ii;
-      oldest_ref = entry->reference_val;
+      oldest_ref = state[ii];
     }
   }
 
@@ -1457,102 +1724,78 @@ Cache_Entry* lru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, voi
   return &cache->entries[set][*way];
 }
 
+/**************************************************************************************/
+/* RRIP: NRU, SRRIP, BRRIP, DRRIP */
+const static uns8 RRIP_M = 2;
+const static uns8 RRIP_DISTANT_VAL = (1 << RRIP_M) - 1;
+
+/* rrip_evict: the first invalid way or way at distant_val, else the ways are aged
+   until one gets there. Aging all ways by the gap to the oldest one at once picks
+   the same way as aging them one step at a time. */
+static inline uns rrip_evict(Cache* cache, uns set, uns8 distant_val) {
+  uns8* state = repl_set_state(cache, set);
+  const Addr* tags = repl_set_tags(cache, set);
+  uns ii;
+  uns oldest = 0;
+
+  for (ii = 0; ii < cache->assoc; ii++) {
+    if (tags[ii] == CACHE_TAG_INVALID || state[ii] == distant_val)
+      return ii;
+    if (state[ii] > state[oldest])
+      oldest = ii;
+  }
+
+  uns8 gap = distant_val - state[oldest];
+  for (ii = 0; ii < cache->assoc; ii++)
+    state[ii] += gap;
+  return oldest;
+}
+
 /**************************************************************************************/
 /* NRU */
-void nru_update_hit(Cache* cache, uns set, uns way, void* arg);
-void nru_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
-Cache_Entry* nru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
+static void nru_update_hit(Cache* cache, uns set, uns way, void* arg);
+static void nru_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
+static Cache_Entry* nru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
 
 const static uns8 NRU_DISTANT_VAL = 1;
 
-void nru_update_hit(Cache* cache, uns set, uns way, void* arg) {
+static void nru_update_hit(Cache* cache, uns set, uns way, void* arg) {
   // promotion: near immediate -> RRPV = 0
-  cache->entries[set][way].reference_val = 0;
+  repl_set_state(cache, set)[way] = 0;
 
   cache_debug_print_set(cache, set, way, CACHE_EVENT_HIT);
 }
 
-void nru_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
+static void nru_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
   // insertion: near immediate -> RRPV = 0
-  cache->entries[set][way].reference_val = NRU_DISTANT_VAL;
+  repl_set_state(cache, set)[way] = NRU_DISTANT_VAL;
 
   cache_debug_print_set(cache, set, way, CACHE_EVENT_INSERT);
 }
 
-Cache_Entry* nru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
-  int ii;
-  Flag found = FALSE;
-
-  while (!found) {
-    // eviction: search the distant line whose RRPV == 1
-    for (ii = 0; ii < cache->assoc; ii++) {
-      Cache_Entry* entry = &cache->entries[set][ii];
-      if (!entry->valid) {
-        *way = ii;
-        found = TRUE;
-        break;
-      }
-      if (entry->reference_val == NRU_DISTANT_VAL) {
-        *way = ii;
-        found = TRUE;
-        break;
-      }
-    }
-
-    // aging: increment until there is a RRPV == 1
-    if (found)
-      break;
-    for (ii = 0; ii < cache->assoc; ii++)
-      cache->entries[set][ii].reference_val++;
-  }
+static Cache_Entry* nru_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
+  // eviction: search the distant line whose RRPV == 1, aging until there is one
+  *way = rrip_evict(cache, set, NRU_DISTANT_VAL);
 
   cache_debug_print_set(cache, set, *way, CACHE_EVENT_EVICT);
   return &cache->entries[set][*way];
 }
 
-/**************************************************************************************/
-/* RRIP: SRRIP, BRRIP, DRRIP */
-const static uns8 RRIP_M = 2;
-const static uns8 RRIP_DISTANT_VAL = (1 << RRIP_M) - 1;
-
 /**************************************************************************************/
 /* SRRIP */
-void srrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
-Cache_Entry* srrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
+static void srrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
+static Cache_Entry* srrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
 
-void srrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
+static void srrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
   // insertion: long interval -> RRPV = 2^M - 2
-  cache->entries[set][way].reference_val = RRIP_DISTANT_VAL - 1;
+  repl_set_state(cache, set)[way] = RRIP_DISTANT_VAL - 1;
 
   cache_debug_print_set(cache, set, way, CACHE_EVENT_INSERT);
 }
 
-Cache_Entry* srrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
-  int ii;
-  Flag found = FALSE;
-
-  while (!found) {
-    // eviction: search the distant line whose RRPV == 2^M - 1
-    for (ii = 0; ii < cache->assoc; ii++) {
-      Cache_Entry* entry = &cache->entries[set][ii];
-      if (!entry->valid) {
-        *way = ii;
-        found = TRUE;
-        break;
-      }
-      if (entry->reference_val == RRIP_DISTANT_VAL) {
-        *way = ii;
-        found = TRUE;
-        break;
-      }
-    }
-
-    // aging: increment until there is a RRPV == 2^M-1
-    if (found)
-      break;
-    for (ii = 0; ii < cache->assoc; ii++)
-      cache->entries[set][ii].reference_val++;
-  }
+static Cache_Entry* srrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
+  // eviction: search the distant line whose RRPV == 2^M - 1, aging until there is one
+  *way = rrip_evict(cache, set, RRIP_DISTANT_VAL);
 
   cache_debug_print_set(cache, set, *way, CACHE_EVENT_EVICT);
   return &cache->entries[set][*way];
@@ -1562,12 +1805,12 @@ Cache_Entry* srrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, v
 /* BRRIP */
 const static uns BRRIP_BIMODAL_PARA = 32;
 const static uns BRRIP_BIMODAL_SRAND_NUM = 0;
-void brrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
-                       Repl_Policy repl_policy);
-void brrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
+static void brrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size,
+                              uns data_size, Repl_Policy repl_policy);
+static void brrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
 
-void brrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
-                       Repl_Policy repl_policy) {
+static void brrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size,
+                              uns data_size, Repl_Policy repl_policy) {
   general_action_init(cache, name, cache_size, assoc, line_size, data_size, repl_policy);
 
   // Counter Impl
@@ -1577,8 +1820,9 @@ void brrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc
   srand(BRRIP_BIMODAL_SRAND_NUM);
 }
 
-void brrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
+static void brrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
   Flag bimodal_para;
+  uns8* state = repl_set_state(cache, set);
 
   // insertion: most in distant future
   // Counter Impl
@@ -1592,12 +1836,12 @@ void brrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg
 
   if (bimodal_para) {
     // insertion in distant future
-    cache->entries[set][way].reference_val = RRIP_DISTANT_VAL;
-    DEBUG(0, "BRRIP insert in distant: %d, %d\n", bimodal_para, cache->entries[set][way].reference_val);
+    state[way] = RRIP_DISTANT_VAL;
+    DEBUG(0, "BRRIP insert in distant: %d, %d\n", bimodal_para, state[way]);
   } else {
     // insertion in long-interval future
-    cache->entries[set][way].reference_val = RRIP_DISTANT_VAL - 1;
-    DEBUG(0, "BRRIP insert in long-interval: %d, %d\n", bimodal_para, cache->entries[set][way].reference_val);
+    state[way] = RRIP_DISTANT_VAL - 1;
+    DEBUG(0, "BRRIP insert in long-interval: %d, %d\n", bimodal_para, state[way]);
   }
 
   cache_debug_print_set(cache, set, way, CACHE_EVENT_INSERT);
@@ -1608,29 +1852,25 @@ void brrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg
 const static int DRRIP_DEDICATED_BIMODAL = 1;
 const static int DRRIP_DEDICATED_STATIC = 2;
 
-void drrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
-                       Repl_Policy repl_policy);
-void drrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
-Cache_Entry* drrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
+static void drrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size,
+                              uns data_size, Repl_Policy repl_policy);
+static void drrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
+static Cache_Entry* drrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
 
-void drrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
-                       Repl_Policy repl_policy) {
+static void drrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size,
+                              uns data_size, Repl_Policy repl_policy) {
   int ii;
   int shift_dedicated = 0;
   uns num_sets = cache_size / line_size / assoc;
 
   brrip_action_init(cache, name, cache_size, assoc, line_size, data_size, repl_policy);
 
-  // init sample
-  cache->miss_count = (Counter*)malloc(sizeof(Counter) * num_sets);
-  for (ii = 0; ii < num_sets; ii++)
-    cache->miss_count[ii] = 0;
+  // init sample: the leader sets' misses are summed as they happen
+  cache->dueling_misses[0] = 0;
+  cache->dueling_misses[1] = 0;
 
   // init dedicated
-  cache->dedicated_policy_set = (uns*)malloc(sizeof(uns) * num_sets);
-  for (ii = 0; ii < num_sets; ii++) {
-    cache->dedicated_policy_set[ii] = 0;  // for dueling
-  }
+  cache->dedicated_policy_set = (uns8*)calloc(num_sets, sizeof(uns8));  // 0 for dueling
   for (ii = 0; ii + 4 <= num_sets; ii = ii + 4) {
     cache->dedicated_policy_set[ii + shift_dedicated % 4] = DRRIP_DEDICATED_BIMODAL;
     cache->dedicated_policy_set[ii + (shift_dedicated + 1) % 4] = DRRIP_DEDICATED_STATIC;
@@ -1638,10 +1878,9 @@ void drrip_action_init(Cache* cache, const char* name, uns cache_size, uns assoc
   }
 }
 
-void drrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
-  int ii;
-  Counter miss_in_brrip = 0;
-  Counter miss_in_srrip = 0;
+static void drrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
+  Counter miss_in_brrip = cache->dueling_misses[DRRIP_DEDICATED_BIMODAL - 1];
+  Counter miss_in_srrip = cache->dueling_misses[DRRIP_DEDICATED_STATIC - 1];
   Flag psel;
 
   // dedicated set
@@ -1656,15 +1895,6 @@ void drrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg
   }
 
   // set dueling
-  for (ii = 0; ii < cache->num_sets; ii++) {
-    if (!cache->dedicated_policy_set[ii])
-      continue;
-    // sampling
-    if (cache->dedicated_policy_set[ii] == DRRIP_DEDICATED_BIMODAL)
-      miss_in_brrip += cache->miss_count[ii];
-    else
-      miss_in_srrip += cache->miss_count[ii];
-  }
   psel = miss_in_brrip < miss_in_srrip ? TRUE : FALSE;
 
   // do insertion
@@ -1676,37 +1906,45 @@ void drrip_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg
   DEBUG(0, "DRRIP insert dueling: 0x%x, %d, 0x%llx, 0x%llx\n\n", set, psel, miss_in_brrip, miss_in_srrip);
 }
 
-Cache_Entry* drrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
-  cache->miss_count[set]++;
-  DEBUG(0, "DRRIP evict count: 0x%x, 0x%llx\n", set, cache->miss_count[set]);
+static Cache_Entry* drrip_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
+  // sampling
+  uns8 dedicated = cache->dedicated_policy_set[set];
+  if (dedicated) {
+    cache->dueling_misses[dedicated - 1]++;
+    DEBUG(0, "DRRIP evict count: 0x%x, 0x%llx\n", set, cache->dueling_misses[dedicated - 1]);
+  }
   return srrip_update_evict(cache, proc_id, set, way, arg, if_external);
 }
 
 /**************************************************************************************/
 /* SHiP */
-void ship_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
-                      Repl_Policy repl_policy);
-void ship_update_hit(Cache* cache, uns set, uns way, void* arg);
-void ship_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
-Cache_Entry* ship_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
-
-/* Signiture History Counter Table */
-struct ship_shct {
-  Hash_Table shct_hash;
-  Cache_Repl_Signiture shct_key_tpye;
-};
+static void ship_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size,
+                             uns data_size, Repl_Policy repl_policy);
+static void ship_update_hit(Cache* cache, uns set, uns way, void* arg);
+static void ship_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg);
+static Cache_Entry* ship_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external);
+
+/* Signiture History Counter Table: saturating counters indexed by a hash of the
+   signature, sized as in the SHiP paper so the table stays cache resident */
+const static uns SHIP_SHCT_BITS = 14;
+const static uns8 SHIP_SHCT_MAX = 7;
+const static Cache_Repl_Signiture SHIP_SHCT_KEY_TYPE = CACHE_REPL_SIGH_MEM;
+
+static inline uns8* ship_shct_entry(Cache* cache, Cache_Entry* line) {
+  uns64 sign = cache_repl_signiture(line, SHIP_SHCT_KEY_TYPE) >> cache->shift_bits;
+  sign ^= sign >> SHIP_SHCT_BITS;
+  sign ^= sign >> (2 * SHIP_SHCT_BITS);
+  return &((uns8*)cache->predictor)[sign & N_BIT_MASK(SHIP_SHCT_BITS)];
+}
 
-void ship_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size, uns data_size,
-                      Repl_Policy repl_policy) {
+static void ship_action_init(Cache* cache, const char* name, uns cache_size, uns assoc, uns line_size,
+                             uns data_size, Repl_Policy repl_policy) {
   int ii, jj;
   uns num_sets = cache_size / line_size / assoc;
   general_action_init(cache, name, cache_size, assoc, line_size, data_size, repl_policy);
 
   /* allocate history table */
-  cache->predictor = malloc(sizeof(struct ship_shct));
-  struct ship_shct* cache_shct = (struct ship_shct*)cache->predictor;
-  init_hash_table(&cache_shct->shct_hash, "cache repl ship shct", NODE_TABLE_SIZE, sizeof(Counter));
-  cache_shct->shct_key_tpye = CACHE_REPL_SIGH_MEM;
+  cache->predictor = calloc(1 << SHIP_SHCT_BITS, sizeof(uns8));
 
   /* init outcome and sign for each line */
   for (ii = 0; ii < num_sets; ii++) {
@@ -1716,40 +1954,34 @@ void ship_action_init(Cache* cache, const char* name, uns cache_size, uns assoc,
   }
 }
 
-void ship_update_hit(Cache* cache, uns set, uns way, void* arg) {
+static void ship_update_hit(Cache* cache, uns set, uns way, void* arg) {
   // promotion: near future -> RRPV = 0
-  cache->entries[set][way].reference_val = 0;
+  repl_set_state(cache, set)[way] = 0;
 
   // prediction update
   cache->entries[set][way].outcome = TRUE;
-  struct ship_shct* cache_shct = (struct ship_shct*)cache->predictor;
-  Counter* cache_shct_entry = (Counter*)hash_table_access(
-      &cache_shct->shct_hash, cache_repl_signiture(&cache->entries[set][way], cache_shct->shct_key_tpye));
-  (*cache_shct_entry)++;
+  uns8* cache_shct_entry = ship_shct_entry(cache, &cache->entries[set][way]);
+  if (*cache_shct_entry < SHIP_SHCT_MAX)
+    (*cache_shct_entry)++;
 
   cache_debug_print_set(cache, set, way, CACHE_EVENT_HIT);
 }
 
-void ship_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
-  struct ship_shct* cache_shct = (struct ship_shct*)cache->predictor;
-  Flag new_entry = FALSE;
-  Counter* cache_shct_entry = (Counter*)hash_table_access_create(
-      &cache_shct->shct_hash, cache_repl_signiture(&cache->entries[set][way], cache_shct->shct_key_tpye), &new_entry);
-  if (new_entry)
-    *cache_shct_entry = 0;
+static void ship_update_insert(Cache* cache, uns8 proc_id, uns set, uns way, void* arg) {
+  uns8* cache_shct_entry = ship_shct_entry(cache, &cache->entries[set][way]);
 
   if (*cache_shct_entry == 0) {
     // insertion in distant future
-    cache->entries[set][way].reference_val = RRIP_DISTANT_VAL;
+    repl_set_state(cache, set)[way] = RRIP_DISTANT_VAL;
   } else {
     // insertion in long-interval future
-    cache->entries[set][way].reference_val = RRIP_DISTANT_VAL - 1;
+    repl_set_state(cache, set)[way] = RRIP_DISTANT_VAL - 1;
   }
 
   cache_debug_print_set(cache, set, way, CACHE_EVENT_INSERT);
 }
 
-Cache_Entry* ship_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
+static Cache_Entry* ship_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, void* arg, Flag if_external) {
   Cache_Entry* line = srrip_update_evict(cache, proc_id, set, way, arg, if_external);
 
   // if it is called by external eviction, do not change the prediction value
@@ -1757,13 +1989,9 @@ Cache_Entry* ship_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, vo
     return line;
 
   // prediction update
-  if (!line->outcome) {
-    cache->entries[set][*way].outcome = TRUE;
-    struct ship_shct* cache_shct = (struct ship_shct*)cache->predictor;
-    Counter* cache_shct_entry = (Counter*)hash_table_access(
-        &cache_shct->shct_hash, cache_repl_signiture(&cache->entries[set][*way], cache_shct->shct_key_tpye));
-
-    if (cache_shct_entry != NULL && (*cache_shct_entry) > 0)
+  if (line->valid && !line->outcome) {
+    uns8* cache_shct_entry = ship_shct_entry(cache, line);
+    if (*cache_shct_entry > 0)
       (*cache_shct_entry)--;
   }
   line->outcome = FALSE;
@@ -1772,6 +2000,65 @@ Cache_Entry* ship_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, vo
   return line;
 }
 
+/**************************************************************************************/
+/* Dispatch: the common policies are called directly so their updates inline into
+   the strategy functions; the others go through repl_policy_func_table. */
+
+static inline void repl_update_hit(Cache* cache, uns set, uns way) {
+  switch (cache->repl_policy) {
+    case REPL_LRU_REF:
+      lru_update_hit(cache, set, way, NULL);
+      break;
+    case REPL_SRRIP:
+    case REPL_BRRIP:
+    case REPL_DRRIP:
+      nru_update_hit(cache, set, way, NULL);
+      break;
+    case REPL_SHIP:
+      ship_update_hit(cache, set, way, NULL);
+      break;
+    default:
+      cache->repl_funcs->update_hit(cache, set, way, NULL);
+      break;
+  }
+}
+
+static inline void repl_update_insert(Cache* cache, uns8 proc_id, uns set, uns way) {
+  switch (cache->repl_policy) {
+    case REPL_LRU_REF:
+      lru_update_insert(cache, proc_id, set, way, NULL);
+      break;
+    case REPL_SRRIP:
+      srrip_update_insert(cache, proc_id, set, way, NULL);
+      break;
+    case REPL_DRRIP:
+      drrip_update_insert(cache, proc_id, set, way, NULL);
+      break;
+    case REPL_SHIP:
+      ship_update_insert(cache, proc_id, set, way, NULL);
+      break;
+    default:
+      cache->repl_funcs->update_insert(cache, proc_id, set, way, NULL);
+      break;
+  }
+}
+
+static inline Cache_Entry* repl_update_evict(Cache* cache, uns8 proc_id, uns set, uns* way, Flag if_external) {
+  switch (cache->repl_policy) {
+    case REPL_LRU_REF:
+      return lru_update_evict(cache, proc_id, set, way, NULL, if_external);
+    case REPL_SRRIP:
+    case REPL_BRRIP:
+      return srrip_update_evict(cache, proc_id, set, way, NULL, if_external);
+    case REPL_DRRIP:
+      return drrip_update_evict(cache, proc_id, set, way, NULL, if_external);
+    case REPL_SHIP:
+      return ship_update_evict(cache, proc_id, set, way, NULL, if_external);
+    default:
+      return cache->repl_funcs->update_evict(cache, proc_id, set, way, NULL, if_external);
+  }
+}
+
 /**************************************************************************************/
 /* Driven Table */
 
@@ -31,13 +31,18 @@
 
 #include "globals/global_defs.h"
 
-#include "libs/list_lib.h"
+#include "libs/deque_lib.h"
+
+struct Snapshot_struct;
 
 /**************************************************************************************/
 
 /* set data pointers to this initially */
 #define INIT_CACHE_DATA_VALUE ((void*)0x8badbeef)
 
+/* tag_store value of an invalid way; no valid tag can have every bit set */
+#define CACHE_TAG_INVALID ((Addr)-1)
+
 /**************************************************************************************/
 
 typedef enum Repl_Policy_enum {
@@ -85,10 +90,17 @@ typedef struct Cache_Entry_struct {
   Flag dirty;               /* Dirty bit should have been here, however this is used only in warmup now */
   Addr pw_start_addr;       /* for uop cache: start addr of prediction window */
 
-  uns8 reference_val; /* for re-reference replacement policy */
-  Flag outcome;       /* for replacement policy */
+  Flag outcome; /* for replacement policy */
 } Cache_Entry;
 
+/* One remembered lookup, see cache_enable_lookup_memo */
+typedef struct Cache_Lookup_Memo_struct {
+  Flag valid;
+  Addr line_addr;
+  uns set;
+  int way; /* -1 if the line was not in the cache */
+} Cache_Lookup_Memo;
+
 // DO NOT CHANGE THIS ORDER
 typedef enum Cache_Insert_Repl_enum {
   INSERT_REPL_DEFAULT = 0, /* Insert with default replacement information */
@@ -99,6 +111,8 @@ typedef enum Cache_Insert_Repl_enum {
   NUM_INSERT_REPL
 } Cache_Insert_Repl;
 
+struct repl_policy_func;
+
 typedef struct Cache_struct {
   char name[MAX_STR_LENGTH + 1]; /* name to identify the cache (for debugging) */
   uns data_size;                 /* how big are the data items in each cache entry? (for malloc) */
@@ -119,9 +133,24 @@ typedef struct Cache_struct {
 
   /* A dynamically allocated array of all of the cache entries. The array is two-dimensional, sets are row major. */
   Cache_Entry** entries;
+  char* line_data; /* the lazy block behind every line's data, NULL if the lines were malloced one by one */
+
+  /* Optional side table of ext_size bytes per line, parallel to line_data, for per-line fields that only some
+     stats read. NULL unless cache_enable_line_ext was called; see cache_line_ext. */
+  char* line_ext;
+  uns line_ext_size;
+
+  /* Structure-of-arrays copy of the tags, tag_store[set * assoc + way], holding CACHE_TAG_INVALID for invalid ways.
+     Lookups compare a whole set from here instead of touching every Cache_Entry. Kept in sync by cache_sync_tag. */
+  Addr* tag_store;
+
+  /* Per-way age or re-reference value of the REPL_VOID policies, repl_state[set * assoc + way], next to tag_store
+     so a victim search reads two packed arrays instead of every Cache_Entry */
+  uns8* repl_state;
+  const struct repl_policy_func* repl_funcs; /* table entry of a REPL_VOID policy */
 
   /* A linked list for each set in the cache that is used when simulating ideal replacement policies */
-  List* unsure_lists;
+  Deque* unsure_lists;
 
   Flag perfect;                 /* is the cache perfect (for henry mem system) */
   uns repl_pref_thresh;         /* threshhold for how many entries are high-priority. */
@@ -131,6 +160,15 @@ typedef struct Cache_struct {
   Counter num_demand_access;
   Counter last_update; /* last update cycle */
 
+  /* Where the last lookup_memo_size lookups resolved, so a line probed again soon
+     skips the set search. NULL unless cache_enable_lookup_memo was called. Any
+     change to the valid bit or tag of a way forgets the lookups of its set. */
+  Cache_Lookup_Memo* lookup_memo;
+  uns lookup_memo_size;
+  uns lookup_memo_next;       /* slot that the next lookup replaces, round robin */
+  uns8 lookup_memo_proc_id;   /* core whose stats count memo hits and misses */
+  uns lookup_memo_miss_stat;  /* followed by the hit stat */
+
   uns* num_ways_allocted_core; /* For cache partitioning */
   uns* num_ways_occupied_core; /* For cache partitioning */
   uns* lru_index_core;         /* For cache partitioning */
@@ -139,8 +177,8 @@ typedef struct Cache_struct {
   Flag tag_incl_offset; /* The uop cache is byte-addressable, so the tag includes offset bits as well */
 
   /* For DRRIP repl */
-  uns* dedicated_policy_set; /* For dedicated set map */
-  Counter* miss_count;       /* For sampling */
+  uns8* dedicated_policy_set; /* For dedicated set map */
+  Counter dueling_misses[2];  /* misses of the BRRIP and SRRIP leader sets */
   Counter bimodal_count;
 
   /* For repl with predictor */
@@ -175,7 +213,12 @@ const static Flag CACHE_DEBUG_ENABLE = FALSE;  // To be Changed into DEBUG_PARA
 /* prototypes */
 
 void init_cache(Cache*, const char*, uns, uns, uns, uns, Repl_Policy);
+void cache_enable_lookup_memo(Cache*, uns, uns8, uns);
+void cache_enable_line_ext(Cache*, uns);
 void* cache_access(Cache*, Addr, Addr*, Flag);
+void* cache_access_way(Cache*, Addr, Addr*, Flag, uns*, int*);
+void* cache_access_at(Cache*, Addr, Addr*, Flag, uns, int);
+void cache_prefetch_set(Cache*, Addr);
 void* cache_insert(Cache*, uns8, Addr, Addr*, Addr*);
 void* cache_insert_replpos(Cache* cache, uns8 proc_id, Addr addr, Addr* line_addr, Addr* repl_line_addr,
                            Cache_Insert_Repl insert_repl_policy, Flag isPrefetch);
@@ -185,6 +228,7 @@ void cache_flush(Cache*);
 void* get_next_repl_line(Cache*, uns8, Addr, Addr*, Flag*);
 void* get_next_valid_repl_line(Cache* cache, uns8 proc_id, Addr addr);
 uns ext_cache_index(Cache*, Addr, Addr*, Addr*);
+int ext_cache_find_way(Cache*, uns, Addr);
 Addr get_cache_line_addr(Cache*, Addr);
 uns cache_get_invalid_line_count(Cache* cache, Addr addr);
 void update_repl_resteer_policy(Cache*, Addr);
@@ -193,10 +237,26 @@ void* shadow_cache_insert(Cache* cache, uns set, Addr tag, Addr base);
 void* access_shadow_lines(Cache* cache, uns set, Addr tag);
 void* access_ideal_storage(Cache* cache, uns set, Addr tag, Addr addr);
 void reset_cache(Cache*);
+/* Saves or restores the lines and replacement state of a cache that has the same geometry */
+void cache_snapshot(Cache*, struct Snapshot_struct*);
 int cache_find_pos_in_lru_stack(Cache* cache, uns8 proc_id, Addr addr, Addr* line_addr);
 void set_partition_allocate(Cache* cache, uns8 proc_id, uns num_ways);
 uns get_partition_allocated(Cache* cache, uns8 proc_id);
 
+/* The index (set * assoc + way) of the line whose data cache_access/cache_insert returned, for side tables kept
+   outside the cache; needs the line data to be one block */
+static inline size_t cache_line_index(Cache* cache, void* data) {
+  return ((char*)data - cache->line_data) / cache->data_size;
+}
+
+/* The side table entry of the line whose data cache_access/cache_insert returned, NULL if the cache has no side
+   table */
+static inline void* cache_line_ext(Cache* cache, void* data) {
+  if (!cache->line_ext)
+    return NULL;
+  return cache->line_ext + cache_line_index(cache, data) * cache->line_ext_size;
+}
+
 /**************************************************************************************/
 
 #endif /* #ifndef __CACHE_LIB_H__ */
@@ -30,29 +30,42 @@ struct Entry {
   Counter accessed_cycle;
 };
 
+// A view of one set: its assoc entries are contiguous in the cache's flat entry array.
 template <typename User_Key_Type, typename User_Data_Type>
 class Set {
  public:
-  std::vector<Entry<User_Key_Type, User_Data_Type>> entries;
+  Entry<User_Key_Type, User_Data_Type>* entries;
   // for round-robin replacement policy
-  uns next_evict;
+  uns* next_evict;
 };
 
 template <typename User_Key_Type, typename User_Data_Type>
 class Cpp_Cache {
  protected:
-  std::vector<Set<User_Key_Type, User_Data_Type>> sets;
+  // all entries, set-major: the entries of set i are entries[i * assoc, (i + 1) * assoc)
+  std::vector<Entry<User_Key_Type, User_Data_Type>> entries;
+  std::vector<uns> next_evicts;
   Repl_Policy repl_policy;
   uns assoc;
   uns num_sets;
   uns line_bytes;
+  // num_sets - 1 when num_sets is a power of two, so that set_idx_hash can mask instead of taking a modulo
+  uns set_mask;
+  Flag pow2_sets;
 
   // defines how to hash the key to the set index, need to be implemented by the user
   virtual uns set_idx_hash(User_Key_Type key) = 0;
 
+  // maps a hashed index to a set, masking when the number of sets is a power of two
+  uns set_idx_from_hash(uns64 hash) const { return pow2_sets ? hash & set_mask : hash % num_sets; }
+
+  Set<User_Key_Type, User_Data_Type> get_set(uns set_idx) {
+    return Set<User_Key_Type, User_Data_Type>{&entries[set_idx * assoc], &next_evicts[set_idx]};
+  }
+
   // replacement policy functions
-  virtual void update_repl_states(Set<User_Key_Type, User_Data_Type>& set, uns hit_idx);
-  virtual uns get_repl_idx(Set<User_Key_Type, User_Data_Type>& set);
+  virtual void update_repl_states(Set<User_Key_Type, User_Data_Type> set, uns hit_idx);
+  virtual uns get_repl_idx(Set<User_Key_Type, User_Data_Type> set);
 
  public:
   Cpp_Cache() = default;
@@ -61,11 +74,11 @@ class Cpp_Cache {
     num_sets = nl / assoc;
     line_bytes = lb;
     repl_policy = rp;
+    pow2_sets = num_sets && !(num_sets & (num_sets - 1));
+    set_mask = num_sets - 1;
 
-    sets = std::vector<Set<User_Key_Type, User_Data_Type>>(num_sets);
-    for (uns i = 0; i < num_sets; i++) {
-      sets[i].entries.resize(assoc);
-    }
+    entries = std::vector<Entry<User_Key_Type, User_Data_Type>>(num_sets * assoc);
+    next_evicts = std::vector<uns>(num_sets);
   }
 
   User_Data_Type* access(User_Key_Type key, bool update_repl);
@@ -74,7 +87,7 @@ class Cpp_Cache {
 };
 
 template <typename User_Key_Type, typename User_Data_Type>
-void Cpp_Cache<User_Key_Type, User_Data_Type>::update_repl_states(Set<User_Key_Type, User_Data_Type>& set,
+void Cpp_Cache<User_Key_Type, User_Data_Type>::update_repl_states(Set<User_Key_Type, User_Data_Type> set,
                                                                   uns hit_idx) {
   switch (repl_policy) {
     case REPL_TRUE_LRU: {
@@ -90,10 +103,10 @@ void Cpp_Cache<User_Key_Type, User_Data_Type>::update_repl_states(Set<User_Key_T
 }
 
 template <typename User_Key_Type, typename User_Data_Type>
-uns Cpp_Cache<User_Key_Type, User_Data_Type>::get_repl_idx(Set<User_Key_Type, User_Data_Type>& set) {
+uns Cpp_Cache<User_Key_Type, User_Data_Type>::get_repl_idx(Set<User_Key_Type, User_Data_Type> set) {
   // if there are invalid entries, replace them
   for (uns i = 0; i < assoc; i++) {
-    Entry<User_Key_Type, User_Data_Type> entry = set.entries[i];
+    const Entry<User_Key_Type, User_Data_Type>& entry = set.entries[i];
     if (!entry.valid) {
       return i;
     }
@@ -105,7 +118,7 @@ uns Cpp_Cache<User_Key_Type, User_Data_Type>::get_repl_idx(Set<User_Key_Type, Us
     case REPL_TRUE_LRU: {
       Counter lru_cycle = std::numeric_limits<Counter>::max();
       for (uns i = 0; i < assoc; i++) {
-        Entry<User_Key_Type, User_Data_Type> entry = set.entries[i];
+        const Entry<User_Key_Type, User_Data_Type>& entry = set.entries[i];
         // find smallest access cycle
         if (entry.accessed_cycle < lru_cycle) {
           repl_idx = i;
@@ -117,8 +130,8 @@ uns Cpp_Cache<User_Key_Type, User_Data_Type>::get_repl_idx(Set<User_Key_Type, Us
       repl_idx = rand() % assoc;
     } break;
     case REPL_ROUND_ROBIN: {
-      repl_idx = (set.next_evict + 1) % assoc;
-      set.next_evict = repl_idx;
+      repl_idx = (*set.next_evict + 1) % assoc;
+      *set.next_evict = repl_idx;
     } break;
     default:
       ASSERT(0, FALSE);  // unsupported
@@ -130,13 +143,13 @@ uns Cpp_Cache<User_Key_Type, User_Data_Type>::get_repl_idx(Set<User_Key_Type, Us
 template <typename User_Key_Type, typename User_Data_Type>
 User_Data_Type* Cpp_Cache<User_Key_Type, User_Data_Type>::access(User_Key_Type key, bool update_repl) {
   User_Data_Type* data = NULL;
-  uns set_idx = set_idx_hash(key);
+  Set<User_Key_Type, User_Data_Type> set = get_set(set_idx_hash(key));
   for (uns i = 0; i < assoc; i++) {
-    Entry<User_Key_Type, User_Data_Type>& entry = sets[set_idx].entries[i];
+    Entry<User_Key_Type, User_Data_Type>& entry = set.entries[i];
     if (entry.valid && entry.key == key) {  // hit
       data = &entry.data;
       if (update_repl) {
-        update_repl_states(sets[set_idx], i);
+        update_repl_states(set, i);
       }
       break;
     }
@@ -150,14 +163,14 @@ Entry<User_Key_Type, User_Data_Type> Cpp_Cache<User_Key_Type, User_Data_Type>::i
   // first check if line exists
   ASSERT(0, access(key, FALSE) == NULL);
 
-  uns set_idx = set_idx_hash(key);
+  Set<User_Key_Type, User_Data_Type> set = get_set(set_idx_hash(key));
   // if the set is full, repl_idx will be overwritten;
   // if the set has vacancy, repl_idx will point to an invalid line
-  uns repl_idx = get_repl_idx(sets[set_idx]);
+  uns repl_idx = get_repl_idx(set);
 
-  Entry<User_Key_Type, User_Data_Type> evicted_entry = sets[set_idx].entries[repl_idx];
-  sets[set_idx].entries[repl_idx] = Entry<User_Key_Type, User_Data_Type>{TRUE, key, data, 0};
-  update_repl_states(sets[set_idx], repl_idx);
+  Entry<User_Key_Type, User_Data_Type> evicted_entry = set.entries[repl_idx];
+  set.entries[repl_idx] = Entry<User_Key_Type, User_Data_Type>{TRUE, key, data, 0};
+  update_repl_states(set, repl_idx);
 
   // the evicted entry is an eviciton victim if and only if it is valid
   return evicted_entry;
@@ -165,10 +178,10 @@ Entry<User_Key_Type, User_Data_Type> Cpp_Cache<User_Key_Type, User_Data_Type>::i
 
 template <typename User_Key_Type, typename User_Data_Type>
 Entry<User_Key_Type, User_Data_Type> Cpp_Cache<User_Key_Type, User_Data_Type>::invalidate(User_Key_Type key) {
-  uns set_idx = set_idx_hash(key);
+  Set<User_Key_Type, User_Data_Type> set = get_set(set_idx_hash(key));
   Entry<User_Key_Type, User_Data_Type> invalidated_entry{};
   for (uns i = 0; i < assoc; i++) {
-    Entry<User_Key_Type, User_Data_Type>& entry = sets[set_idx].entries[i];
+    Entry<User_Key_Type, User_Data_Type>& entry = set.entries[i];
     if (entry.valid && entry.key == key) {  // hit
       invalidated_entry = entry;
       entry.valid = FALSE;
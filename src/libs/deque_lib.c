@@ -0,0 +1,199 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/deque_lib.c
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : A deque of fixed-size elements in one contiguous ring
+ ***************************************************************************************/
+
+#include "libs/deque_lib.h"
+
+#include <string.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "debug/debug.param.h"
+#include "debug/debug_macros.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_LIST_LIB, ##args)
+#define DEBUGU(proc_id, args...) _DEBUGU(proc_id, DEBUG_LIST_LIB, ##args)
+#define DEQUE_MIN_CAPACITY 16
+
+/**************************************************************************************/
+/* Prototypes */
+
+static void grow_deque(Deque*);
+static inline void copy_element(Deque*, int, int);
+
+/**************************************************************************************/
+/* init_deque: capacity is a hint for the number of elements, rounded up to a
+   power of 2 */
+
+void init_deque(Deque* deque, const char* name, uns data_size, uns capacity) {
+  DEBUGU(0, "Initializing deque called '%s'.\n", name);
+  ASSERT(0, data_size);
+
+  deque->name = strdup(name);
+  deque->data_size = data_size;
+  deque->capacity = DEQUE_MIN_CAPACITY;
+  while (deque->capacity < capacity)
+    deque->capacity <<= 1;
+  deque->ring = (char*)malloc((size_t)deque->capacity * data_size);
+  deque->removed = (char*)malloc(data_size);
+  ASSERT(0, deque->ring && deque->removed);
+  deque->head = 0;
+  deque->count = 0;
+  deque->place = -1;
+}
+
+/**************************************************************************************/
+/* clear_deque: */
+
+void clear_deque(Deque* deque) {
+  DEBUG(0, "Clearing deque '%s'.\n", deque->name);
+  deque->count = 0;
+  deque->place = -1;
+}
+
+/**************************************************************************************/
+/* clip_deque_at_current: drops every element after the current one */
+
+void clip_deque_at_current(Deque* deque) {
+  DEBUG(0, "Clipping deque '%s'.\n", deque->name);
+  ASSERT(0, deque_get_current(deque));
+  deque->count = deque->place + 1;
+}
+
+/**************************************************************************************/
+/* clip_deque: keeps the first count elements */
+
+void clip_deque(Deque* deque, int count) {
+  DEBUG(0, "Clipping deque '%s' to %d elements.\n", deque->name, count);
+  ASSERT(0, count >= 0 && count <= deque->count);
+  deque->count = count;
+  deque->place = -1;
+}
+
+/**************************************************************************************/
+/* grow_deque: doubles the ring, unwrapping it so element 0 is at slot 0 */
+
+static void grow_deque(Deque* deque) {
+  uns new_capacity = deque->capacity * 2;
+  char* new_ring = (char*)malloc((size_t)new_capacity * deque->data_size);
+  ASSERT(0, new_ring);
+
+  uns first = MIN2(deque->count, deque->capacity - deque->head);
+  memcpy(new_ring, deque->ring + (size_t)deque->head * deque->data_size, (size_t)first * deque->data_size);
+  memcpy(new_ring + (size_t)first * deque->data_size, deque->ring, (size_t)(deque->count - first) * deque->data_size);
+  free(deque->ring);
+
+  DEBUGU(0, "Growing deque '%s' to %u elements\n", deque->name, new_capacity);
+  deque->ring = new_ring;
+  deque->capacity = new_capacity;
+  deque->head = 0;
+}
+
+/**************************************************************************************/
+/* deque_add_tail: */
+
+void* deque_add_tail(Deque* deque) {
+  if ((uns)deque->count == deque->capacity)
+    grow_deque(deque);
+  deque->count++;
+  return deque_get(deque, deque->count - 1);
+}
+
+/**************************************************************************************/
+/* deque_add_head: the traversal stays on the same element */
+
+void* deque_add_head(Deque* deque) {
+  if ((uns)deque->count == deque->capacity)
+    grow_deque(deque);
+  deque->head = (deque->head - 1) & (deque->capacity - 1);
+  deque->count++;
+  deque->place++;
+  return deque_get(deque, 0);
+}
+
+/**************************************************************************************/
+/* deque_remove_head: the traversal stays on the same element */
+
+void* deque_remove_head(Deque* deque) {
+  if (!deque->count)
+    return NULL;
+  void* data = deque_get(deque, 0);
+  deque->head = (deque->head + 1) & (deque->capacity - 1);
+  deque->count--;
+  deque->place--;
+  return data;
+}
+
+/**************************************************************************************/
+/* deque_remove_tail: */
+
+void* deque_remove_tail(Deque* deque) {
+  if (!deque->count)
+    return NULL;
+  deque->count--;
+  return deque_get(deque, deque->count);
+}
+
+/**************************************************************************************/
+/* copy_element: */
+
+static inline void copy_element(Deque* deque, int dst, int src) {
+  memcpy(deque_get(deque, dst), deque_get(deque, src), deque->data_size);
+}
+
+/**************************************************************************************/
+/* deque_remove_current: removes the current element, closing the gap from the
+   nearer end. The traversal moves back one element, as dl_list_remove_current
+   does, so deque_next_element continues with the element after the removed one.
+   Returns a copy of the removed element, good until the next remove_current. */
+
+void* deque_remove_current(Deque* deque) {
+  int ii;
+
+  DEBUG(0, "Removing current of deque '%s'.\n", deque->name);
+  ASSERT(0, deque_get_current(deque));
+  memcpy(deque->removed, deque_get(deque, deque->place), deque->data_size);
+
+  if (deque->place < deque->count / 2) {
+    for (ii = deque->place; ii > 0; ii--)
+      copy_element(deque, ii, ii - 1);
+    deque->head = (deque->head + 1) & (deque->capacity - 1);
+  } else {
+    for (ii = deque->place; ii < deque->count - 1; ii++)
+      copy_element(deque, ii, ii + 1);
+  }
+  deque->count--;
+  deque->place--;
+  return deque->removed;
+}
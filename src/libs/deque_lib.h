@@ -0,0 +1,115 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/deque_lib.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : A deque of fixed-size elements in one contiguous ring, with the
+ *                add/remove/traverse interface of list_lib, so a traversal walks
+ *                memory in order instead of chasing List_Entry pointers.
+ ***************************************************************************************/
+
+#ifndef __DEQUE_LIB_H__
+#define __DEQUE_LIB_H__
+
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Types */
+
+/* Elements are numbered from 0 at the head. The ring doubles when full, which
+   moves every element, so pointers into a deque are only good until the next
+   add; a removed element stays readable until then, as with list_lib. */
+typedef struct Deque_struct {
+  char* name;    /* name of the deque */
+  uns data_size; /* size of the data elements in the deque */
+
+  char* ring;    /* capacity elements */
+  uns capacity;  /* a power of 2 */
+  uns head;      /* ring slot of element 0 */
+  int count;     /* number of elements */
+  int place;     /* element the traversal is at, -1 or count when off either end */
+  char* removed; /* copy of the element taken by deque_remove_current */
+} Deque;
+
+/**************************************************************************************/
+/* Prototypes */
+
+void init_deque(Deque*, const char*, uns, uns);
+void clear_deque(Deque*);
+void clip_deque_at_current(Deque*);
+void clip_deque(Deque*, int);
+void* deque_add_tail(Deque*);
+void* deque_add_head(Deque*);
+void* deque_remove_head(Deque*);
+void* deque_remove_tail(Deque*);
+void* deque_remove_current(Deque*);
+
+/**************************************************************************************/
+/* Element access and traversal */
+
+/* element ii, counting from the head */
+static inline void* deque_get(Deque* deque, int ii) {
+  return deque->ring + ((deque->head + ii) & (deque->capacity - 1)) * deque->data_size;
+}
+
+static inline void* deque_get_head(Deque* deque) {
+  return deque->count ? deque_get(deque, 0) : NULL;
+}
+
+static inline void* deque_get_tail(Deque* deque) {
+  return deque->count ? deque_get(deque, deque->count - 1) : NULL;
+}
+
+static inline void* deque_get_current(Deque* deque) {
+  return deque->place >= 0 && deque->place < deque->count ? deque_get(deque, deque->place) : NULL;
+}
+
+static inline void* deque_start_head_traversal(Deque* deque) {
+  deque->place = 0;
+  return deque_get_current(deque);
+}
+
+static inline void* deque_start_tail_traversal(Deque* deque) {
+  deque->place = deque->count - 1;
+  return deque_get_current(deque);
+}
+
+/* like list_next_element, moving off the tail and then next starts over at the head */
+static inline void* deque_next_element(Deque* deque) {
+  deque->place = deque->place >= 0 && deque->place < deque->count ? deque->place + 1 : 0;
+  return deque_get_current(deque);
+}
+
+static inline void* deque_prev_element(Deque* deque) {
+  deque->place = deque->place >= 0 && deque->place < deque->count ? deque->place - 1 : deque->count - 1;
+  return deque_get_current(deque);
+}
+
+static inline int deque_get_count(Deque* deque) {
+  return deque->count;
+}
+
+/**************************************************************************************/
+
+#endif /* #ifndef __DEQUE_LIB_H__ */
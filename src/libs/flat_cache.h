@@ -0,0 +1,242 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/flat_cache.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Header-only set-associative container with all entries in one
+ *                contiguous allocation and the replacement policy chosen at compile
+ *                time. Its access/insert/invalidate interface matches Cpp_Cache, so a
+ *                user can switch containers by changing a typedef.
+ ***************************************************************************************/
+
+#ifndef __FLAT_CACHE_H__
+#define __FLAT_CACHE_H__
+
+#include <vector>
+
+#include "globals/global_types.h"
+
+#include "libs/cpp_cache.h"
+
+/**************************************************************************************/
+/* Replacement policies
+ *
+ * A policy keeps its state for all sets in one flat array and provides:
+ *   void init(uns num_sets, uns ways);
+ *   void touch(uns set, uns way);   called on a hit
+ *   void insert(uns set, uns way);  called when a line is filled
+ *   uns victim(uns set);            called when every way of the set is valid
+ * Victim selection walks all ways without data-dependent branches.
+ */
+
+// True LRU: every way holds its recency rank, 0 for the MRU way up to ways - 1
+// for the LRU way, so the ranks of a set are always a permutation.
+class Flat_Cache_LRU {
+ public:
+  void init(uns num_sets, uns num_ways) {
+    ASSERT(0, num_ways <= 256);
+    ways = num_ways;
+    ages.resize(num_sets * ways);
+    for (uns ii = 0; ii < ages.size(); ii++)
+      ages[ii] = ii % ways;
+  }
+  void touch(uns set, uns way) {
+    uns8* age = &ages[set * ways];
+    const uns8 old_age = age[way];
+    for (uns ii = 0; ii < ways; ii++)
+      age[ii] += age[ii] < old_age;
+    age[way] = 0;
+  }
+  void insert(uns set, uns way) { touch(set, way); }
+  uns victim(uns set) const {
+    const uns8* age = &ages[set * ways];
+    uns victim_way = 0;
+    for (uns ii = 0; ii < ways; ii++)
+      victim_way |= (age[ii] == ways - 1) * ii;
+    return victim_way;
+  }
+
+ private:
+  uns ways;
+  std::vector<uns8> ages;
+};
+
+// Tree pseudo-LRU: ways - 1 bits per set form a binary tree (node 1 is the root,
+// the children of node n are 2n and 2n + 1) whose bits point toward the victim.
+// Needs a power-of-2 number of ways, at most 64.
+class Flat_Cache_PLRU {
+ public:
+  void init(uns num_sets, uns num_ways) {
+    ASSERT(0, num_ways && !(num_ways & (num_ways - 1)) && num_ways <= 64);
+    ways = num_ways;
+    levels = 0;
+    while ((1u << levels) < ways)
+      levels++;
+    trees.assign(num_sets, 0);
+  }
+  void touch(uns set, uns way) {
+    uns64 tree = trees[set];
+    uns node = 1;
+    for (uns level = 0; level < levels; level++) {
+      const uns64 dir = (way >> (levels - 1 - level)) & 1;
+      // point the node away from the way just used
+      tree = (tree & ~(1ULL << node)) | ((dir ^ 1) << node);
+      node = 2 * node + dir;
+    }
+    trees[set] = tree;
+  }
+  void insert(uns set, uns way) { touch(set, way); }
+  uns victim(uns set) const {
+    const uns64 tree = trees[set];
+    uns node = 1;
+    for (uns level = 0; level < levels; level++)
+      node = 2 * node + ((tree >> node) & 1);
+    return node - ways;
+  }
+
+ private:
+  uns ways;
+  uns levels;
+  std::vector<uns64> trees;
+};
+
+// Static RRIP with 2-bit re-reference prediction values (Jaleel et al., ISCA
+// 2010): lines are filled with a long re-reference interval, promoted to near
+// on a hit, and the victim is the first line predicted distant after aging the
+// set just enough for one to be.
+class Flat_Cache_RRIP {
+ public:
+  enum : uns8 { RRPV_MAX = 3 };
+
+  void init(uns num_sets, uns num_ways) {
+    ways = num_ways;
+    rrpvs.assign(num_sets * ways, RRPV_MAX);
+  }
+  void touch(uns set, uns way) { rrpvs[set * ways + way] = 0; }
+  void insert(uns set, uns way) { rrpvs[set * ways + way] = RRPV_MAX - 1; }
+  uns victim(uns set) {
+    uns8* rrpv = &rrpvs[set * ways];
+    uns8 max_rrpv = 0;
+    for (uns ii = 0; ii < ways; ii++)
+      max_rrpv = rrpv[ii] > max_rrpv ? rrpv[ii] : max_rrpv;
+    const uns8 delta = RRPV_MAX - max_rrpv;
+    uns victim_way = ways;
+    for (uns ii = ways; ii-- > 0;) {
+      rrpv[ii] += delta;
+      victim_way = rrpv[ii] == RRPV_MAX ? ii : victim_way;
+    }
+    return victim_way;
+  }
+
+ private:
+  uns ways;
+  std::vector<uns8> rrpvs;
+};
+
+/**************************************************************************************/
+/* Flat_Cache
+ *
+ * Set_Hash is a functor returning a 64-bit hash of a key; the set index is that
+ * hash masked to the number of sets when it is a power of two, and taken modulo
+ * the number of sets otherwise. Entries of a set are contiguous.
+ */
+
+template <typename User_Key_Type, typename User_Data_Type, typename Repl_Type, typename Set_Hash>
+class Flat_Cache {
+ public:
+  typedef Entry<User_Key_Type, User_Data_Type> Entry_Type;
+
+  Flat_Cache(uns num_lines, uns assoc, Set_Hash set_hash = Set_Hash()) : assoc(assoc), set_hash(set_hash) {
+    ASSERT(0, assoc && num_lines % assoc == 0);
+    num_sets = num_lines / assoc;
+    pow2_sets = !(num_sets & (num_sets - 1));
+    set_mask = num_sets - 1;
+    entries.resize(num_sets * assoc);
+    repl.init(num_sets, assoc);
+  }
+
+  // access: Looks up the cache based on key. Returns pointer to line data if found
+  User_Data_Type* access(const User_Key_Type& key, bool update_repl) {
+    const uns set = set_idx(key);
+    const int way = find_way(set, key);
+    if (way < 0)
+      return NULL;
+    if (update_repl)
+      repl.touch(set, way);
+    return &entries[set * assoc + way].data;
+  }
+
+  // insert: fills key, which must not be in the cache, into an invalid way or over
+  // the policy's victim. Returns the entry it replaced (valid only on an eviction)
+  Entry_Type insert(const User_Key_Type& key, const User_Data_Type& data) {
+    const uns set = set_idx(key);
+    ASSERT(0, find_way(set, key) < 0);
+
+    uns way = assoc;
+    for (uns ii = assoc; ii-- > 0;)
+      way = entries[set * assoc + ii].valid ? way : ii;
+    if (way == assoc)
+      way = repl.victim(set);
+
+    Entry_Type evicted_entry = entries[set * assoc + way];
+    entries[set * assoc + way] = Entry_Type{TRUE, key, data, 0};
+    repl.insert(set, way);
+    return evicted_entry;
+  }
+
+  // invalidate: drops key if present. Returns the dropped entry (invalid if key was not found)
+  Entry_Type invalidate(const User_Key_Type& key) {
+    const uns set = set_idx(key);
+    const int way = find_way(set, key);
+    if (way < 0)
+      return Entry_Type{};
+    Entry_Type invalidated_entry = entries[set * assoc + way];
+    entries[set * assoc + way].valid = FALSE;
+    return invalidated_entry;
+  }
+
+ private:
+  uns set_idx(const User_Key_Type& key) const {
+    const uns64 hash = set_hash(key);
+    return pow2_sets ? hash & set_mask : hash % num_sets;
+  }
+
+  int find_way(uns set, const User_Key_Type& key) const {
+    const Entry_Type* set_entries = &entries[set * assoc];
+    for (uns ii = 0; ii < assoc; ii++) {
+      if (set_entries[ii].valid && set_entries[ii].key == key)
+        return ii;
+    }
+    return -1;
+  }
+
+  std::vector<Entry_Type> entries;
+  Repl_Type repl;
+  uns assoc;
+  uns num_sets;
+  uns set_mask;
+  Flag pow2_sets;
+  Set_Hash set_hash;
+};
+
+#endif /* #ifndef __FLAT_CACHE_H__ */
@@ -27,11 +27,13 @@
  ***************************************************************************************/
 
 #include <stdlib.h>
+#include <string.h>
 #include "debug/debug_macros.h"
 #include "globals/assert.h"
 #include "globals/global_defs.h"
 #include "globals/global_types.h"
 #include "globals/global_vars.h"
+#include "globals/utils.h"
 
 #include "libs/hash_lib.h"
 #include "libs/malloc_lib.h"
@@ -73,25 +75,56 @@ int64 HASH_INDEX(const Hash_Table*  table, int64 key) {
 static uns const hash_table_primes[NUM_HASH_TABLE_PRIMES] = {
   1, 5, 11, 23, 47, 101, 211, 401, 811, 1601, 3209, 6373};
 
+#define HASH_OPEN_MIN_BUCKETS 8
+#define HASH_OPEN_SLOT(table, pos) ((table)->slots + (size_t)(pos) * (table)->slot_size)
+
+static void  init_open_hash_table(Hash_Table*, uns);
+static void* open_hash_table_access(Hash_Table const*, int64, void const*);
+static void* open_hash_table_access_create(Hash_Table*, int64, void const*,
+                                           Flag*);
+static Flag  open_hash_table_access_delete(Hash_Table*, int64, void const*);
+static void  open_hash_table_resize(Hash_Table*, uns);
+
 
 /**************************************************************************************/
 /* init_hash_table: */
 
 void init_hash_table(Hash_Table* table, const char* name, uns buckets,
                      uns data_size) {
-  init_complex_hash_table(table, name, buckets, data_size, NULL);
+  init_complex_hash_table_impl(table, name, buckets, data_size, NULL,
+                               HASH_TABLE_CHAINED);
+}
+
+void init_hash_table_impl(Hash_Table* table, const char* name, uns buckets,
+                          uns data_size, Hash_Table_Impl impl) {
+  init_complex_hash_table_impl(table, name, buckets, data_size, NULL, impl);
 }
 
 void init_complex_hash_table(Hash_Table* table, const char* name, uns buckets,
                              uns data_size,
                              Flag (*eq_func)(void const*, void const*)) {
+  init_complex_hash_table_impl(table, name, buckets, data_size, eq_func,
+                               HASH_TABLE_CHAINED);
+}
+
+void init_complex_hash_table_impl(Hash_Table* table, const char* name,
+                                  uns buckets, uns data_size,
+                                  Flag (*eq_func)(void const*, void const*),
+                                  Hash_Table_Impl impl) {
+  ASSERTM(0, impl < NUM_HASH_TABLE_IMPLS, "Bad hash table impl %d\n", impl);
+  memset(table, 0, sizeof(Hash_Table));
   table->name      = strdup(name);
-  table->buckets   = buckets;
   table->data_size = data_size;
   table->count     = 0;
-  table->entries   = (Hash_Table_Entry**)calloc(buckets,
-                                              sizeof(Hash_Table_Entry*));
   table->eq_func   = eq_func;
+  table->impl      = impl;
+  if(impl == HASH_TABLE_OPEN) {
+    init_open_hash_table(table, buckets);
+    return;
+  }
+  table->buckets = buckets;
+  table->entries = (Hash_Table_Entry**)calloc(buckets,
+                                              sizeof(Hash_Table_Entry*));
 }
 
 
@@ -102,6 +135,9 @@ void init_complex_hash_table(Hash_Table* table, const char* name, uns buckets,
 
 void* hash_table_access(Hash_Table const* table, int64 key) {
   // {{{ access hash table using simple key compare
+  if(table->impl == HASH_TABLE_OPEN)
+    return open_hash_table_access(table, key, NULL);
+
   uns               index  = HASH_INDEX(table, key);
   Hash_Table_Entry* bucket = table->entries[index];
   Hash_Table_Entry* temp;
@@ -117,13 +153,16 @@ void* hash_table_access(Hash_Table const* table, int64 key) {
 void* complex_hash_table_access(Hash_Table const* table, int64 key,
                                 void const* data) {
   // {{{ access hash table using a complex comparison
+  ASSERT(0, table->eq_func);
+  ASSERT(0, data);
+
+  if(table->impl == HASH_TABLE_OPEN)
+    return open_hash_table_access(table, key, data);
+
   uns               index  = HASH_INDEX(table, key);
   Hash_Table_Entry* bucket = table->entries[index];
   Hash_Table_Entry* temp;
 
-  ASSERT(0, table->eq_func);
-  ASSERT(0, data);
-
   for(temp = bucket; temp != NULL; temp = temp->next)
     if(temp->key == key && table->eq_func(temp->data, data))
       return temp->data;
@@ -140,6 +179,9 @@ void* complex_hash_table_access(Hash_Table const* table, int64 key,
 
 void* hash_table_access_create(Hash_Table* table, int64 key, Flag* new_entry) {
   // {{{ access hash table using simple key compare
+  if(table->impl == HASH_TABLE_OPEN)
+    return open_hash_table_access_create(table, key, NULL, new_entry);
+
   uns               index    = HASH_INDEX(table, key);
   Hash_Table_Entry* bucket   = table->entries[index];
   Hash_Table_Entry* new_hash = NULL;
@@ -179,15 +221,18 @@ void* hash_table_access_create(Hash_Table* table, int64 key, Flag* new_entry) {
 void* complex_hash_table_access_create(Hash_Table* table, int64 key,
                                        void const* data, Flag* new_entry) {
   // {{{ access hash table using a complex comparison
+  ASSERT(0, table->eq_func);
+  ASSERT(0, data);
+
+  if(table->impl == HASH_TABLE_OPEN)
+    return open_hash_table_access_create(table, key, data, new_entry);
+
   uns               index    = HASH_INDEX(table, key);
   Hash_Table_Entry* bucket   = table->entries[index];
   Hash_Table_Entry* new_hash = NULL;
   Hash_Table_Entry* temp;
   Hash_Table_Entry* prev = NULL;
 
-  ASSERT(0, table->eq_func);
-  ASSERT(0, data);
-
   *new_entry = FALSE;
   ASSERT(0, index < table->buckets);
   for(temp = bucket; temp != NULL; temp = temp->next) {
@@ -225,6 +270,9 @@ void* complex_hash_table_access_create(Hash_Table* table, int64 key,
 
 Flag hash_table_access_delete(Hash_Table* table, int64 key) {
   // {{{ access hash table using simple key compare
+  if(table->impl == HASH_TABLE_OPEN)
+    return open_hash_table_access_delete(table, key, NULL);
+
   uns               index  = HASH_INDEX(table, key);
   Hash_Table_Entry* bucket = table->entries[index];
   Hash_Table_Entry* temp;
@@ -253,14 +301,17 @@ Flag hash_table_access_delete(Hash_Table* table, int64 key) {
 Flag complex_hash_table_access_delete(Hash_Table* table, int64 key,
                                       void const* data) {
   // {{{ access hash table using a complex comparison
+  ASSERT(0, table->eq_func);
+  ASSERT(0, data);
+
+  if(table->impl == HASH_TABLE_OPEN)
+    return open_hash_table_access_delete(table, key, data);
+
   uns               index  = HASH_INDEX(table, key);
   Hash_Table_Entry* bucket = table->entries[index];
   Hash_Table_Entry* temp;
   Hash_Table_Entry* prev = NULL;
 
-  ASSERT(0, table->eq_func);
-  ASSERT(0, data);
-
   for(temp = bucket; temp != NULL; temp = temp->next) {
     if(temp->key == key && table->eq_func(temp->data, data)) {
       Hash_Table_Entry* next_ptr = temp->next;
@@ -291,6 +342,12 @@ void hash_table_clear(Hash_Table* table) {
   uns               count = 0;
   int               ii;
 
+  if(table->impl == HASH_TABLE_OPEN) {
+    memset(table->dists, 0, sizeof(uns) * table->buckets);
+    table->count = 0;
+    return;
+  }
+
   for(ii = 0; ii < table->buckets; ii++) {
     temp0 = table->entries[ii];
     while(temp0) {
@@ -331,6 +388,11 @@ void** hash_table_flatten(Hash_Table* table, void** reuse_array) {
   /* write into the new array */
   count = 0;
   for(ii = 0; ii < table->buckets; ii++) {
+    if(table->impl == HASH_TABLE_OPEN) {
+      if(table->dists[ii])
+        new_array[count++] = HASH_OPEN_SLOT(table, ii);
+      continue;
+    }
     temp = table->entries[ii];
     while(temp) {
       new_array[count++] = temp->data;
@@ -361,6 +423,13 @@ void hash_table_scan(Hash_Table* table, void (*scan_func)(void*, void*),
     return;
 
   for(ii = 0; ii < table->buckets; ii++) {
+    if(table->impl == HASH_TABLE_OPEN) {
+      if(table->dists[ii]) {
+        count++;
+        scan_func(HASH_OPEN_SLOT(table, ii), arg);
+      }
+      continue;
+    }
     temp = table->entries[ii];
     while(temp) {
       count++;
@@ -385,6 +454,11 @@ void hash_table_rehash(Hash_Table* table, int new_buckets) {
   uns                ii, jj;
 
   ASSERT(0, new_buckets >= 0);
+  if(table->impl == HASH_TABLE_OPEN) {
+    open_hash_table_resize(table, new_buckets ? new_buckets :
+                                                2 * table->buckets);
+    return;
+  }
   if(new_buckets == 0) {  // use next prime
     new_buckets = table->buckets;
     for(ii = 0; ii < NUM_HASH_TABLE_PRIMES - 1; ii++)
@@ -438,6 +512,8 @@ void hash_table_access_replace(Hash_Table* table, int64 key,
   Hash_Table_Entry* prev      = NULL;
   Flag              new_entry = FALSE;
   UNUSED(new_entry);
+  ASSERTM(0, table->impl == HASH_TABLE_CHAINED,
+          "%s: access_replace needs a chained hash table\n", table->name);
   ASSERT(0, replacement);
   ASSERT(0, index < table->buckets);
   for(temp = bucket; temp != NULL; temp = temp->next) {
@@ -472,3 +548,162 @@ void hash_table_access_replace(Hash_Table* table, int64 key,
           table->count);
   // }}}
 }
+
+/**************************************************************************************/
+// Open addressing implementation (HASH_TABLE_OPEN): Robin Hood linear probing
+// over a power-of-two table with the data stored inline in the slots and a
+// single multiplicative hash.  Lookups stop as soon as they reach a slot
+// closer to its home than the probe is, so misses are as cheap as hits.
+
+static inline uns open_hash_table_home(Hash_Table const* table, int64 key) {
+  return (uns)(((uns64)key * 0x9e3779b97f4a7c15ULL) >> table->shift);
+}
+
+static uns open_hash_table_size(uns buckets) {
+  uns size = HASH_OPEN_MIN_BUCKETS;
+  while(size < buckets)
+    size <<= 1;
+  return size;
+}
+
+static void open_hash_table_alloc(Hash_Table* table, uns buckets) {
+  table->buckets = open_hash_table_size(buckets);
+  table->shift   = 64 - LOG2(table->buckets);
+  table->dists   = (uns*)calloc(table->buckets, sizeof(uns));
+  table->keys    = (int64*)malloc(table->buckets * sizeof(int64));
+  table->slots   = (char*)malloc((size_t)table->buckets * table->slot_size);
+  ASSERT(0, table->dists && table->keys && table->slots);
+}
+
+static void init_open_hash_table(Hash_Table* table, uns buckets) {
+  table->slot_size = MAX2((table->data_size + 7) & ~7U, 8);
+  table->scratch   = (char*)malloc(2 * table->slot_size);
+  open_hash_table_alloc(table, buckets);
+}
+
+/* find the slot holding key (and matching data if given), -1 if none */
+static inline int open_hash_table_find(Hash_Table const* table, int64 key,
+                                       void const* data) {
+  uns mask = table->buckets - 1;
+  uns pos  = open_hash_table_home(table, key);
+  uns dist = 1;
+
+  for(; table->dists[pos] >= dist; pos = (pos + 1) & mask, dist++)
+    if(table->keys[pos] == key &&
+       (!data || table->eq_func(HASH_OPEN_SLOT(table, pos), data)))
+      return pos;
+  return -1;
+}
+
+/* Robin Hood insert of a new entry; entries that are closer to their home
+   give up their slot and move on.  Returns the slot of the new entry, whose
+   data is copied from data or zeroed. */
+static uns open_hash_table_place(Hash_Table* table, int64 key,
+                                 void const* data) {
+  uns   mask   = table->buckets - 1;
+  uns   pos    = open_hash_table_home(table, key);
+  uns   dist   = 1;
+  uns   result = table->buckets;
+  char* carry  = table->scratch;
+  char* swap   = table->scratch + table->slot_size;
+
+  if(data)
+    memcpy(carry, data, table->data_size);
+  else
+    memset(carry, 0, table->data_size);
+
+  for(;; pos = (pos + 1) & mask, dist++) {
+    char* slot = HASH_OPEN_SLOT(table, pos);
+    if(!table->dists[pos]) {
+      table->keys[pos]  = key;
+      table->dists[pos] = dist;
+      memcpy(slot, carry, table->data_size);
+      return result == table->buckets ? pos : result;
+    }
+    if(table->dists[pos] < dist) {
+      int64 tmp_key = table->keys[pos];
+      uns   tmp_dist = table->dists[pos];
+      char* tmp;
+      table->keys[pos]  = key;
+      table->dists[pos] = dist;
+      memcpy(swap, slot, table->data_size);
+      memcpy(slot, carry, table->data_size);
+      tmp   = carry;
+      carry = swap;
+      swap  = tmp;
+      key   = tmp_key;
+      dist  = tmp_dist;
+      if(result == table->buckets)
+        result = pos;
+    }
+  }
+}
+
+static void open_hash_table_resize(Hash_Table* table, uns new_buckets) {
+  uns    old_buckets = table->buckets;
+  uns*   old_dists   = table->dists;
+  int64* old_keys    = table->keys;
+  char*  old_slots   = table->slots;
+  uns    ii;
+
+  /* never go above the 3/4 load factor */
+  new_buckets = MAX2(new_buckets, table->count + table->count / 3 + 1);
+  if(open_hash_table_size(new_buckets) == old_buckets)
+    return;
+  open_hash_table_alloc(table, new_buckets);
+
+  for(ii = 0; ii < old_buckets; ii++)
+    if(old_dists[ii])
+      open_hash_table_place(table, old_keys[ii],
+                            old_slots + (size_t)ii * table->slot_size);
+
+  _DEBUGA(0, 0, "resized %s from %d to %d slots (%d entries)\n", table->name,
+          old_buckets, table->buckets, table->count);
+  free(old_dists);
+  free(old_keys);
+  free(old_slots);
+}
+
+static void* open_hash_table_access(Hash_Table const* table, int64 key,
+                                    void const* data) {
+  int pos = open_hash_table_find(table, key, data);
+  return pos < 0 ? NULL : HASH_OPEN_SLOT(table, pos);
+}
+
+static void* open_hash_table_access_create(Hash_Table* table, int64 key,
+                                           void const* data, Flag* new_entry) {
+  int pos = open_hash_table_find(table, key, data);
+
+  *new_entry = FALSE;
+  if(pos >= 0)
+    return HASH_OPEN_SLOT(table, pos);
+
+  if(4 * (table->count + 1) > 3 * table->buckets)
+    open_hash_table_resize(table, 2 * table->buckets);
+  table->count++;
+  *new_entry = TRUE;
+  return HASH_OPEN_SLOT(table, open_hash_table_place(table, key, NULL));
+}
+
+static Flag open_hash_table_access_delete(Hash_Table* table, int64 key,
+                                          void const* data) {
+  uns mask = table->buckets - 1;
+  int pos  = open_hash_table_find(table, key, data);
+  uns next;
+
+  if(pos < 0)
+    return FALSE;
+
+  /* shift the rest of the probe run back by one slot */
+  for(next = (pos + 1) & mask; table->dists[next] > 1;
+      pos = next, next = (next + 1) & mask) {
+    table->keys[pos]  = table->keys[next];
+    table->dists[pos] = table->dists[next] - 1;
+    memcpy(HASH_OPEN_SLOT(table, pos), HASH_OPEN_SLOT(table, next),
+           table->data_size);
+  }
+  table->dists[pos] = 0;
+  table->count--;
+  ASSERT(0, table->count >= 0);
+  return TRUE;
+}
@@ -35,6 +35,18 @@
 /**************************************************************************************/
 /* Types */
 
+/* HASH_TABLE_CHAINED mallocs every entry, so data pointers returned by the
+   access functions stay valid until the entry is deleted.  HASH_TABLE_OPEN
+   keeps the data inline in a power-of-two Robin Hood table: lookups touch one
+   contiguous run of slots, but any insert or delete may move other entries,
+   so data pointers are only valid until the next access_create,
+   access_delete, rehash or clear on the table. */
+typedef enum Hash_Table_Impl_enum {
+  HASH_TABLE_CHAINED,
+  HASH_TABLE_OPEN,
+  NUM_HASH_TABLE_IMPLS
+} Hash_Table_Impl;
+
 typedef struct Hash_Table_Entry_struct {
   int64 key;
   void* data;
@@ -48,17 +60,29 @@ typedef struct Hash_Table_struct {
   int count;  // total number of elements in the hash table
   Hash_Table_Entry** entries;
   Flag (*eq_func)(void const* const, void const* const);
+
+  /* HASH_TABLE_OPEN only (buckets is the number of slots) */
+  Hash_Table_Impl impl;
+  uns   shift;      // 64 - log2(buckets)
+  uns   slot_size;  // data_size rounded up to 8 bytes
+  uns*  dists;      // probe distance + 1, 0 if the slot is empty
+  int64* keys;
+  char* slots;
+  char* scratch;  // two slots used while displacing entries
 } Hash_Table;
 
 /**************************************************************************************/
 /* Prototypes */
 
 void init_hash_table(Hash_Table*, const char*, uns, uns);
+void init_hash_table_impl(Hash_Table*, const char*, uns, uns, Hash_Table_Impl);
 void* hash_table_access(Hash_Table const*, int64);
 void* hash_table_access_create(Hash_Table*, int64, Flag*);
 Flag hash_table_access_delete(Hash_Table*, int64);
 
 void init_complex_hash_table(Hash_Table*, const char*, uns, uns, Flag (*)(void const*, void const*));
+void init_complex_hash_table_impl(Hash_Table*, const char*, uns, uns, Flag (*)(void const*, void const*),
+                                  Hash_Table_Impl);
 void* complex_hash_table_access(Hash_Table const*, int64, void const*);
 void* complex_hash_table_access_create(Hash_Table*, int64, void const*, Flag*);
 Flag complex_hash_table_access_delete(Hash_Table*, int64, void const*);
@@ -44,13 +44,13 @@
 
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_LIST_LIB, ##args)
 #define DEBUGU(proc_id, args...) _DEBUGU(proc_id, DEBUG_LIST_LIB, ##args)
-#define FREE_LIST_ALLOC_SIZE 8
-#define VERIFY_LIST_COUNTS FALSE
+#define VERIFY_LIST_COUNTS ENABLE_PARANOID_ASSERTIONS /* walks the list on every update */
 
 /**************************************************************************************/
 /* Prototypes */
 
 static inline List_Entry* get_list_entry(List*);
+static inline void release_list_entry(List*, List_Entry*);
 static inline void free_list_entry(List*, List_Entry*);
 static inline void verify_list_counts(List*);
 
@@ -65,11 +65,10 @@ void init_list(List* list, char name[], uns data_size, Flag use_free_list) {
   list->data_size = data_size;
   list->head = NULL;
   list->tail = NULL;
-  list->free = NULL;
+  list->removed = NULL;
   list->count = 0;
   list->use_free_list = use_free_list;
 
-  list->free_count = 0;
   list->total_count = 0;
 }
 
@@ -79,17 +78,10 @@ void init_list(List* list, char name[], uns data_size, Flag use_free_list) {
 void clear_list(List* list) {
   DEBUG(0, "Clearing list '%s'.\n", list->name);
   if (list->tail) {
-    if (list->use_free_list) {
-      list->tail->next = list->free;
-      list->free = list->head;
-
-      list->free_count += list->count;
-    } else {
-      List_Entry *temp0, *temp1;
-      for (temp0 = list->head; temp0 != NULL; temp0 = temp1) {
-        temp1 = temp0->next;
-        free(temp0);
-      }
+    List_Entry *temp0, *temp1;
+    for (temp0 = list->head; temp0 != NULL; temp0 = temp1) {
+      temp1 = temp0->next;
+      release_list_entry(list, temp0);
     }
     list->head = NULL;
     list->tail = NULL;
@@ -108,18 +100,10 @@ void clip_list_at_current(List* list) {
   ASSERT(0, list);
   ASSERT(0, list->current);
   if (list->current->next) {
-    if (list->use_free_list) {
-      list->tail->next = list->free;
-      list->free = list->current->next;
-      list->current->next = NULL;
-
-      list->free_count += list->count - (list->place + 1);
-    } else {
-      List_Entry *temp0, *temp1;
-      for (temp0 = list->current->next; temp0 != NULL; temp0 = temp1) {
-        temp1 = temp0->next;
-        free(temp0);
-      }
+    List_Entry *temp0, *temp1;
+    for (temp0 = list->current->next; temp0 != NULL; temp0 = temp1) {
+      temp1 = temp0->next;
+      release_list_entry(list, temp0);
     }
     list->tail = list->current;
     list->tail->next = NULL;
@@ -129,59 +113,42 @@ void clip_list_at_current(List* list) {
 }
 
 /**************************************************************************************/
-/* alloc_list_entry: */
+/* get_list_entry: lists with use_free_list take their entries from smalloc, so
+   they share the per-core free lists of each entry size */
 
 static inline List_Entry* get_list_entry(List* list) {
-  List_Entry *temp, *rval;
-  uns ii, size;
-
-  if (list->use_free_list) {
-    if (list->free) {
-      temp = list->free;
-      list->free = temp->next;
-      list->free_count--;
-      return temp;
-    }
-
-    size = sizeof(List_Entry) + list->data_size - sizeof(char);
-
-    ASSERT(0, FREE_LIST_ALLOC_SIZE > 1);
-    rval = (List_Entry*)malloc(size * FREE_LIST_ALLOC_SIZE);
-    ASSERT(0, rval);
-    temp = (List_Entry*)((char*)rval + size);
-    list->free = temp;
-    list->total_count += FREE_LIST_ALLOC_SIZE;
-    list->free_count += FREE_LIST_ALLOC_SIZE - 1;
-
-    for (ii = 0; ii < FREE_LIST_ALLOC_SIZE - 2; ii++) {
-      char* temp2;
-      temp->next = (List_Entry*)((char*)temp + size);
-      temp2 = (char*)temp + size;  // work-around: stupid c++ can't handle my code
-      temp = (List_Entry*)temp2;
-    }
-    temp->next = NULL;
-  } else {
-    size = sizeof(List_Entry) + list->data_size - sizeof(char);
-    rval = (List_Entry*)malloc(size);
-    ASSERT(0, rval);
-    list->total_count++;
+  if (list->removed) {
+    List_Entry* rval = list->removed;
+    list->removed = NULL;
+    return rval;
   }
-
+  uns size = sizeof(List_Entry) + list->data_size - sizeof(char);
+  List_Entry* rval = list->use_free_list ? (List_Entry*)smalloc(size) : (List_Entry*)malloc(size);
+  ASSERT(0, rval);
+  list->total_count++;
   return rval;
 }
 
 /**************************************************************************************/
-/* free_list_entry: */
+/* release_list_entry: returns the memory of an entry that is off the list */
 
-static inline void free_list_entry(List* list, List_Entry* entry) {
-  if (list->use_free_list) {
-    entry->next = list->free;
-    list->free = entry;
-    list->free_count++;
-  } else {
+static inline void release_list_entry(List* list, List_Entry* entry) {
+  if (list->use_free_list)
+    sfree(sizeof(List_Entry) + list->data_size - sizeof(char), entry);
+  else
     free(entry);
-    list->total_count--;
-  }
+  list->total_count--;
+}
+
+/**************************************************************************************/
+/* free_list_entry: callers of the remove functions read the data of the removed
+   entry after it is off the list, so its memory is held back until the list
+   next adds (which reuses it) or removes */
+
+static inline void free_list_entry(List* list, List_Entry* entry) {
+  if (list->removed)
+    release_list_entry(list, list->removed);
+  list->removed = entry;
   list->count--;
   verify_list_counts(list);
 }
@@ -204,7 +171,7 @@ void* sl_list_add_tail(List* list) {
     list->tail = temp;
   }
   list->count++;
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return &temp->data;
 }
@@ -230,7 +197,7 @@ void* dl_list_add_tail(List* list) {
     list->tail = temp;
   }
   list->count++;
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return &temp->data;
 }
@@ -250,7 +217,7 @@ void* sl_list_add_head(List* list) {
     list->tail = temp;
 
   list->count++;
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return &temp->data;
 }
@@ -274,7 +241,7 @@ void* dl_list_add_head(List* list) {
   list->head = temp;
 
   list->count++;
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return &temp->data;
 }
@@ -306,7 +273,7 @@ void* sl_list_remove_head(List* list) {
     return NULL;
   }
 
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return temp;
 }
@@ -339,7 +306,7 @@ void* dl_list_remove_head(List* list) {
     return NULL;
   }
 
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return temp;
 }
@@ -372,7 +339,7 @@ void* dl_list_remove_tail(List* list) {
     return NULL;
   }
 
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return temp;
 }
@@ -416,7 +383,7 @@ void* dl_list_remove_current(List* list) {
 
   free_list_entry(list, free);
 
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return temp;
 }
@@ -438,7 +405,7 @@ void* sl_list_add_after_current(List* list) {
     list->tail = temp;
   list->count++;
 
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return &temp->data;
 }
@@ -463,7 +430,7 @@ void* dl_list_add_after_current(List* list) {
   list->current->next = temp;
   list->count++;
 
-  DEBUG(0, "%d %d %d\n", list->count, list->free_count, list->total_count);
+  DEBUG(0, "%d %d\n", list->count, list->total_count);
   verify_list_counts(list);
   return &temp->data;
 }
@@ -576,24 +543,12 @@ static inline void verify_list_counts(List* list) {
 #if VERIFY_LIST_COUNTS
   List_Entry* temp;
   uns count = 0;
-  uns free_count = 0;
-  uns total_count = 0;
 
-  for (temp = list->head; temp; temp = temp->next) {
+  for (temp = list->head; temp; temp = temp->next)
     count++;
-    total_count++;
-  }
-
-  for (temp = list->free; temp; temp = temp->next) {
-    free_count++;
-    total_count++;
-  }
 
-  ASSERT(0, count + free_count == total_count);
-  ASSERT(0, list->count + list->free_count == list->total_count);
   ASSERTM(0, count == list->count, "%d %d\n", count, list->count);
-  ASSERTM(0, free_count == list->free_count, "%d %d\n", free_count, list->free_count);
-  ASSERT(0, total_count == list->total_count);
+  ASSERT(0, list->count + (list->removed != NULL) == list->total_count);
 #endif
 }
 
@@ -46,13 +46,12 @@ typedef struct List_struct {
 
   List_Entry *head, *tail; /* pointers to the head and tail of the list */
   List_Entry* current;     /* pointer to the current element (for traversals) */
-  List_Entry* free;        /* pointer to the free entry pool for the list */
+  List_Entry* removed;     /* last removed entry, kept until the next add or remove (see free_list_entry) */
   int count;               /* count of elements in the list */
   int place;               /* place of 'current' in the list (starts at 0) */
-  Flag use_free_list;      /* whether or not to use free list or free memory on removal */
+  Flag use_free_list;      /* whether entries come from smalloc (per-core free lists) or malloc */
 
-  int free_count;
-  int total_count;
+  int total_count; /* entries allocated: count, plus one while removed is set */
 } List;
 
 /**************************************************************************************/
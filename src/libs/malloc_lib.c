@@ -27,94 +27,154 @@
  ***************************************************************************************/
 #include "libs/malloc_lib.h"
 
+#include <stdint.h>
+#include <sys/mman.h>
+
 #include "globals/assert.h"
 #include "globals/global_defs.h"
 #include "globals/global_types.h"
 #include "globals/global_vars.h"
+#include "globals/utils.h"
 
 #include "debug/debug_macros.h"
 
+#include "general.param.h"
+
 /* Defines */
 #define MAX_SMALLOC 32768
-#define WRAPPER_BLOCK 1024
-#define SMALLOC_BLOCK (0x1 << 20)
+#define SMALLOC_ALIGN 16
+#define SMALLOC_NUM_CLASSES (MAX_SMALLOC / SMALLOC_ALIGN + 1)
+#define SMALLOC_SLAB (64 << 10)
 
-/* Global Variables */
-static char* raw_mem_ptr = NULL;
-static int raw_mem_size = 0;
-static SMalloc_Entry* wrapper_free_list = NULL;
-static SMalloc_Entry* smalloc_free_list[MAX_SMALLOC];
+/* A free object holds the pointer to the next one in its first bytes */
+typedef struct SMalloc_Free_struct {
+  struct SMalloc_Free_struct* next;
+} SMalloc_Free;
+
+typedef struct SMalloc_Class_struct {
+  SMalloc_Free* free; /* freed objects of this class */
+  char* slab_ptr;     /* not yet handed out part of the current slab */
+  char* slab_end;
+} SMalloc_Class;
 
-static inline SMalloc_Entry* get_wrapper();
-static inline void free_wrapper(SMalloc_Entry* wrap);
+typedef struct SMalloc_Arena_struct {
+  SMalloc_Class classes[SMALLOC_NUM_CLASSES];
+  SMalloc_Stats stats;
+} SMalloc_Arena;
+
+/* Global Variables */
+static CORE_LOCAL SMalloc_Arena* smalloc_arena = NULL;
 
 /**************************************************************************************/
-/* get_wrapper */
-static inline SMalloc_Entry* get_wrapper() {
-  SMalloc_Entry* tmp;
-
-  if (wrapper_free_list == NULL) {
-    char* wrap_mem = (char*)malloc(sizeof(SMalloc_Entry) * WRAPPER_BLOCK);
-    SMalloc_Entry* cur_wrap;
-    int ii;
-    ASSERT(0, wrap_mem);
-    for (ii = 0; ii < WRAPPER_BLOCK; ii++) {
-      cur_wrap = (SMalloc_Entry*)wrap_mem;
-      cur_wrap->next = wrapper_free_list;
-      wrapper_free_list = cur_wrap;
-      wrap_mem += sizeof(SMalloc_Entry);
-    }
-  }
-  tmp = wrapper_free_list;
-  wrapper_free_list = wrapper_free_list->next;
-  return tmp;
+/* smalloc_class: the class of an nbytes request; class c holds c * SMALLOC_ALIGN bytes */
+static inline uns smalloc_class(int nbytes) {
+  ASSERT(0, nbytes >= 0 && nbytes < MAX_SMALLOC);
+  return nbytes ? (nbytes + SMALLOC_ALIGN - 1) / SMALLOC_ALIGN : 1;
 }
 
 /**************************************************************************************/
-/* free_wrapper */
-static inline void free_wrapper(SMalloc_Entry* wrap) {
-  wrap->next = wrapper_free_list;
-  wrapper_free_list = wrap;
+/* get_arena: the calling thread's arena, created on first use */
+static inline SMalloc_Arena* get_arena() {
+  if (!smalloc_arena) {
+    smalloc_arena = (SMalloc_Arena*)calloc(1, sizeof(SMalloc_Arena));
+    ASSERT(0, smalloc_arena);
+  }
+  return smalloc_arena;
 }
 
 /**************************************************************************************/
 /* smalloc */
 void* smalloc(int nbytes) {
-  SMalloc_Entry* tmp;
-  void* ptr = NULL;
-
-  ASSERT(0, nbytes < MAX_SMALLOC);
-  if (smalloc_free_list[nbytes]) {
-    tmp = smalloc_free_list[nbytes];
-    smalloc_free_list[nbytes] = smalloc_free_list[nbytes]->next;
-    ptr = tmp->data;
-    free_wrapper(tmp);
-  } else { /* need to allocate some memory */
-    if (nbytes > raw_mem_size) {
-      while (raw_mem_size >= sizeof(SMalloc_Entry)) { /* never can have too many wrappers */
-        tmp = (SMalloc_Entry*)raw_mem_ptr;
-        free_wrapper(tmp);
-        raw_mem_ptr += sizeof(SMalloc_Entry);
-        raw_mem_size -= sizeof(SMalloc_Entry);
-      }
-      /* Yes, we waste up to 7 bytes per SMALLOC_BLOCK allocation */
-      raw_mem_ptr = (char*)malloc(SMALLOC_BLOCK);
-      ASSERT(0, raw_mem_ptr);
-      raw_mem_size = SMALLOC_BLOCK;
-    }
-    ptr = raw_mem_ptr;
-    raw_mem_ptr += nbytes;
-    raw_mem_size -= nbytes;
+  SMalloc_Arena* arena = get_arena();
+  uns cls = smalloc_class(nbytes);
+  uns size = cls * SMALLOC_ALIGN;
+  SMalloc_Class* sc = &arena->classes[cls];
+  void* ptr;
+
+  arena->stats.allocs++;
+  arena->stats.live_bytes += size;
+  if (sc->free) {
+    ptr = sc->free;
+    sc->free = sc->free->next;
+    arena->stats.reuses++;
+    return ptr;
+  }
+
+  if (sc->slab_ptr + size > sc->slab_end) { /* the rest of the old slab is wasted */
+    uns slab_size = MAX2(SMALLOC_SLAB, size);
+    sc->slab_ptr = (char*)malloc(slab_size);
+    ASSERT(0, sc->slab_ptr);
+    sc->slab_end = sc->slab_ptr + slab_size;
+    arena->stats.slab_bytes += slab_size;
   }
-  ASSERT(0, ptr);
+  ptr = sc->slab_ptr;
+  sc->slab_ptr += size;
   return ptr;
 }
 
 /**************************************************************************************/
 /* sfree */
 void sfree(int nbytes, void* item) {
-  SMalloc_Entry* wrapper = get_wrapper();
-  wrapper->next = smalloc_free_list[nbytes];
-  wrapper->data = item;
-  smalloc_free_list[nbytes] = wrapper;
+  SMalloc_Arena* arena = get_arena();
+  uns cls = smalloc_class(nbytes);
+  SMalloc_Free* obj = (SMalloc_Free*)item;
+
+  ASSERT(0, item);
+  obj->next = arena->classes[cls].free;
+  arena->classes[cls].free = obj;
+  arena->stats.frees++;
+  arena->stats.live_bytes -= cls * SMALLOC_ALIGN;
+}
+
+/**************************************************************************************/
+/* smalloc_get_stats */
+void smalloc_get_stats(SMalloc_Stats* stats) {
+  *stats = get_arena()->stats;
+}
+
+/**************************************************************************************/
+/* huge_map: whole huge pages at a huge page boundary, from hugetlbfs with
+   HUGE_PAGES 2 when it has enough free pages, else transparent ones. The
+   hugetlbfs mapping is reserved up front (no MAP_NORESERVE), so running out
+   fails here instead of faulting later. */
+static void* huge_map(size_t nbytes) {
+  nbytes = (nbytes + HUGE_PAGE_BYTES - 1) & ~(size_t)(HUGE_PAGE_BYTES - 1);
+#ifdef MAP_HUGETLB
+  if (HUGE_PAGES == 2) {
+    void* ptr = mmap(NULL, nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (ptr != MAP_FAILED)
+      return ptr;
+    WARNINGU_ONCE(0, "Not enough free hugetlbfs pages, using transparent huge pages\n");
+  }
+#endif
+
+  /* over-map by a huge page and trim both ends to align the rest */
+  size_t map_bytes = nbytes + HUGE_PAGE_BYTES;
+  char* map = (char*)mmap(NULL, map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  ASSERTM(0, map != MAP_FAILED, "Could not map %zu bytes\n", map_bytes);
+  char* ptr = (char*)(((uintptr_t)map + HUGE_PAGE_BYTES - 1) & ~(uintptr_t)(HUGE_PAGE_BYTES - 1));
+  if (ptr > map)
+    munmap(map, ptr - map);
+  if (map + map_bytes > ptr + nbytes)
+    munmap(ptr + nbytes, map + map_bytes - (ptr + nbytes));
+#ifdef MADV_HUGEPAGE
+  if (madvise(ptr, nbytes, MADV_HUGEPAGE))
+    WARNINGU_ONCE(0, "Transparent huge pages are not available\n");
+#endif
+  return ptr;
+}
+
+/**************************************************************************************/
+/* lazy_calloc */
+void* lazy_calloc(size_t num, size_t size) {
+  size_t nbytes = num * size;
+  ASSERT(0, !size || nbytes / size == num);
+  if (nbytes < LAZY_ALLOC_MIN_BYTES)
+    return calloc(num, size);
+  if (HUGE_PAGES && nbytes >= HUGE_PAGE_BYTES)
+    return huge_map(nbytes);
+
+  void* ptr = mmap(NULL, nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  ASSERTM(0, ptr != MAP_FAILED, "Could not map %zu bytes\n", nbytes);
+  return ptr;
 }
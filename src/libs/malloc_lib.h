@@ -29,17 +29,39 @@
 #ifndef __MALLOC_LIB_H__
 #define __MALLOC_LIB_H__
 
-typedef struct SMalloc_Raw_struct {
-  char* ptr;
-  int cur_size;
-} SMalloc_Raw;
+#include <stddef.h>
 
-typedef struct SMalloc_Entry_struct {
-  void* data;
-  struct SMalloc_Entry_struct* next;
-} SMalloc_Entry;
+#include "globals/global_types.h"
 
+/* smalloc/sfree: small allocations of a size known again at free time. Sizes
+   are rounded up to 16-byte classes, and each thread (each core in a parallel
+   run) carves its own slabs and keeps its own free lists, threaded through the
+   freed objects, so neither call takes a lock. An object may be freed on
+   another thread, which then reuses it. Memory is never returned to the
+   system. */
 void* smalloc(int nbytes);
 void sfree(int nbytes, void* item);
 
+typedef struct SMalloc_Stats_struct {
+  Counter allocs;     /* smalloc calls */
+  Counter reuses;     /* smalloc calls served from a free list */
+  Counter frees;      /* sfree calls */
+  SCounter live_bytes; /* bytes allocated less bytes freed, by class size; negative on a
+                          thread that frees more than it allocates */
+  Counter slab_bytes; /* bytes taken from malloc for slabs */
+} SMalloc_Stats;
+
+/* The counters of the calling thread's allocator */
+void smalloc_get_stats(SMalloc_Stats* stats);
+
+/* Zeroed memory for large tables that are mostly untouched at startup.
+   Requests of at least LAZY_ALLOC_MIN_BYTES are mapped with MAP_NORESERVE, so
+   their pages are only faulted in when first written; smaller ones come from
+   calloc. The memory is never freed. With HUGE_PAGES, requests of at least
+   HUGE_PAGE_BYTES are rounded up to whole huge pages and mapped at a huge page
+   boundary. */
+#define LAZY_ALLOC_MIN_BYTES (1 << 20)
+#define HUGE_PAGE_BYTES (2 << 20)
+void* lazy_calloc(size_t num, size_t size);
+
 #endif /* #ifndef __MALLOC_LIB_H__ */
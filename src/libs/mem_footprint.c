@@ -0,0 +1,102 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/mem_footprint.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Registry of the large tables allocated by the model.
+ ***************************************************************************************/
+
+#include "libs/mem_footprint.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals/assert.h"
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Mem_Footprint_Entry_struct {
+  char* name;
+  uns proc_id;
+  uns64 bytes;
+} Mem_Footprint_Entry;
+
+/**************************************************************************************/
+/* Global Variables */
+
+static Mem_Footprint_Entry* entries = NULL;
+static uns num_entries = 0;
+static uns max_entries = 0;
+
+/**************************************************************************************/
+/* mem_footprint_add: */
+
+void mem_footprint_add(const char* name, uns proc_id, uns64 bytes) {
+  for (uns ii = 0; ii < num_entries; ii++) {
+    if (entries[ii].proc_id == proc_id && !strcmp(entries[ii].name, name)) {
+      entries[ii].bytes += bytes;
+      return;
+    }
+  }
+  if (num_entries == max_entries) {
+    max_entries = max_entries ? 2 * max_entries : 32;
+    entries = (Mem_Footprint_Entry*)realloc(entries, max_entries * sizeof(Mem_Footprint_Entry));
+    ASSERT(0, entries);
+  }
+  entries[num_entries].name = strdup(name);
+  entries[num_entries].proc_id = proc_id;
+  entries[num_entries].bytes = bytes;
+  num_entries++;
+}
+
+/**************************************************************************************/
+/* mem_footprint_cmp: largest first, then by name and core */
+
+static int mem_footprint_cmp(const void* a, const void* b) {
+  const Mem_Footprint_Entry* entry_a = (const Mem_Footprint_Entry*)a;
+  const Mem_Footprint_Entry* entry_b = (const Mem_Footprint_Entry*)b;
+  if (entry_a->bytes != entry_b->bytes)
+    return entry_a->bytes < entry_b->bytes ? 1 : -1;
+  int name_cmp = strcmp(entry_a->name, entry_b->name);
+  if (name_cmp)
+    return name_cmp;
+  return (entry_a->proc_id > entry_b->proc_id) - (entry_a->proc_id < entry_b->proc_id);
+}
+
+/**************************************************************************************/
+/* mem_footprint_report: */
+
+void mem_footprint_report(FILE* stream) {
+  uns64 total = 0;
+  qsort(entries, num_entries, sizeof(Mem_Footprint_Entry), mem_footprint_cmp);
+  for (uns ii = 0; ii < num_entries; ii++) {
+    fprintf(stream, "** Footprint %-32s core %-3u %12.1f KB\n", entries[ii].name, entries[ii].proc_id,
+            entries[ii].bytes / 1024.0);
+    total += entries[ii].bytes;
+    free(entries[ii].name);
+  }
+  if (num_entries)
+    fprintf(stream, "** Footprint %-41s %12.1f KB\n", "total", total / 1024.0);
+  num_entries = 0;
+}
@@ -0,0 +1,51 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/mem_footprint.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Registry of the large tables allocated by the model, printed
+ *                once initialization is done (--report_mem_footprint).
+ ***************************************************************************************/
+
+#ifndef __MEM_FOOTPRINT_H__
+#define __MEM_FOOTPRINT_H__
+
+#include <stdio.h>
+
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Records that structure name of core proc_id occupies bytes. The name is
+   copied. Entries with the same name and core are summed. */
+void mem_footprint_add(const char* name, uns proc_id, uns64 bytes);
+
+/* Prints the recorded structures, largest first, with their total, and clears
+   the registry so that a later report only lists new structures */
+void mem_footprint_report(FILE* stream);
+
+/**************************************************************************************/
+
+#endif /* #ifndef __MEM_FOOTPRINT_H__ */
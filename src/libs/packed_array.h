@@ -0,0 +1,149 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/packed_array.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Header-only arrays of BITS-wide fields packed into 64-bit words,
+ *                for predictor and prefetcher tables whose counters and tags are
+ *                much narrower than the C type that would otherwise hold them.
+ *                Fields never straddle a word, so a get or set is one load, a
+ *                shift and a mask. Storage is zeroed and comes from lazy_calloc,
+ *                so untouched parts of a large table never become resident.
+ ***************************************************************************************/
+
+#ifndef __PACKED_ARRAY_H__
+#define __PACKED_ARRAY_H__
+
+#include <stdint.h>
+#include <type_traits>
+
+#include "globals/assert.h"
+#include "globals/global_types.h"
+
+extern "C" {
+#include "libs/malloc_lib.h"
+}
+
+/**************************************************************************************/
+/* Packed_Array
+ *
+ * Signed fields hold two's complement values in [-2^(BITS-1), 2^(BITS-1) - 1],
+ * unsigned ones [0, 2^BITS - 1]. set() truncates its value to BITS bits. A
+ * default-constructed array is empty until init() is called; the storage is
+ * never freed, like the tables it replaces.
+ */
+
+template <uns BITS, bool SIGNED = false>
+class Packed_Array {
+  static_assert(BITS > 0 && BITS <= 32, "Packed_Array fields must be 1 to 32 bits wide");
+
+ public:
+  typedef typename std::conditional<SIGNED, int32_t, uint32_t>::type Value;
+
+  static const uns FIELDS_PER_WORD = 64 / BITS;
+  static const Value MIN_VALUE = SIGNED ? -(Value)((uint64_t)1 << (BITS - 1)) : 0;
+  static const Value MAX_VALUE = (Value)((SIGNED ? (uint64_t)1 << (BITS - 1) : (uint64_t)1 << BITS) - 1);
+
+  // Proxy returned by the non-const operator[], so that table[i] reads and
+  // assigns like a plain array element.
+  class Reference {
+   public:
+    Reference(Packed_Array* array, uns64 index) : array(array), index(index) {}
+    operator Value() const { return array->get(index); }
+    Reference& operator=(Value value) {
+      array->set(index, value);
+      return *this;
+    }
+    Reference& operator=(const Reference& other) { return *this = (Value)other; }
+
+   private:
+    Packed_Array* array;
+    uns64 index;
+  };
+
+  Packed_Array() : words(NULL), num_entries(0) {}
+  explicit Packed_Array(uns64 num) : Packed_Array() { init(num); }
+
+  void init(uns64 num) {
+    ASSERT(0, !words);
+    num_entries = num;
+    words = (uint64_t*)lazy_calloc(num_words(), sizeof(uint64_t));
+  }
+
+  uns64 size() const { return num_entries; }
+  uns64 bytes() const { return num_words() * sizeof(uint64_t); }
+
+  Value get(uns64 index) const {
+    uint64_t field = (words[index / FIELDS_PER_WORD] >> shift(index)) & FIELD_MASK;
+    if (SIGNED && (field >> (BITS - 1)))
+      field |= ~FIELD_MASK;
+    return (Value)field;
+  }
+
+  void set(uns64 index, Value value) {
+    uint64_t& word = words[index / FIELDS_PER_WORD];
+    word = (word & ~(FIELD_MASK << shift(index))) | (((uint64_t)value & FIELD_MASK) << shift(index));
+  }
+
+  Value operator[](uns64 index) const { return get(index); }
+  Reference operator[](uns64 index) { return Reference(this, index); }
+
+  // Saturating counter updates. Each returns whether the field was already at
+  // the bound it moved towards.
+  Flag sat_inc(uns64 index) {
+    Value value = get(index);
+    if (value == MAX_VALUE)
+      return TRUE;
+    set(index, value + 1);
+    return FALSE;
+  }
+
+  Flag sat_dec(uns64 index) {
+    Value value = get(index);
+    if (value == MIN_VALUE)
+      return TRUE;
+    set(index, value - 1);
+    return FALSE;
+  }
+
+  Flag sat_update(uns64 index, Flag inc) { return inc ? sat_inc(index) : sat_dec(index); }
+
+ private:
+  static const uint64_t FIELD_MASK = ((uint64_t)1 << BITS) - 1;
+
+  uns64 num_words() const { return (num_entries + FIELDS_PER_WORD - 1) / FIELDS_PER_WORD; }
+  static uns shift(uns64 index) { return (index % FIELDS_PER_WORD) * BITS; }
+
+  uint64_t* words;
+  uns64 num_entries;
+};
+
+// Unsigned fields, e.g. partial tags or small confidence counters.
+template <uns BITS>
+using Packed_Tag_Array = Packed_Array<BITS, false>;
+
+// Two's complement up-down counters as used by TAGE-like predictors.
+template <uns BITS>
+using Packed_Ctr_Array = Packed_Array<BITS, true>;
+
+#endif  // __PACKED_ARRAY_H__
@@ -26,10 +26,20 @@
  * Description  :
  ***************************************************************************************/
 
+#ifndef __PERCEPTRON_HPP__
+#define __PERCEPTRON_HPP__
+
+#include <stdint.h>
 #include <numeric>
 #include <string>
 #include <vector>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
 #include "globals/assert.h"
 #include "globals/global_types.h"
 
@@ -145,13 +155,13 @@ class PerceptronTable {
 
   // helpful functions
   static void extract_bipolar_features(int input, double* output, int num_features) {
-    for (u_int i = 0; i < num_features; ++i) {
+    for (int i = 0; i < num_features; ++i) {
       output[i] = (input & (1 << i)) ? 1.0 : -1.0;
     }
   }
 
   static void extract_binary_features(int input, double* output, int num_features) {
-    for (u_int i = 0; i < num_features; ++i) {
+    for (int i = 0; i < num_features; ++i) {
       output[i] = (input & (1 << i)) ? 1.0 : 0.0;
     }
   }
@@ -164,4 +174,207 @@ class PerceptronTable {
   double theta;
   double saturation_value;
   double threshold;  // moves decision boundary for inference
-};
\ No newline at end of file
+};
+
+/*
+ * Fixed-point perceptron table for the lookup-heavy users. Weights are int8_t or
+ * int16_t, all rows in one contiguous array. A row holds the feature weights, then
+ * the bias weight, then zero padding up to a multiple of 32 bytes so the kernels
+ * below run whole vectors. A feature vector from new_features() has the same
+ * layout with the bias input fixed at 1, so the bias needs no special case.
+ * Features are small integers (bipolar -1/+1 or binary 0/1).
+ *
+ * Predict and train match PerceptronTable with a learning rate of 1 and
+ * SaturatingCounterUpdate: the sum is the same integer, and only mispredictions
+ * move the weights (the double table's error is 0 otherwise). The double table
+ * stays available to check this one against.
+ */
+
+// Dot products and saturating updates over rows whose length is a multiple of 32 bytes
+static inline int32_t perceptron_dot(const int8_t* weights, const int8_t* features, uns length) {
+  int32_t sum = 0;
+  uns ii = 0;
+#if defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+  for (; ii + 16 <= length; ii += 16) {
+    __m256i w = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(weights + ii)));
+    __m256i f = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(features + ii)));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(w, f));
+  }
+  __m128i acc4 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  acc4 = _mm_hadd_epi32(acc4, acc4);
+  acc4 = _mm_hadd_epi32(acc4, acc4);
+  sum = _mm_cvtsi128_si32(acc4);
+#elif defined(__ARM_NEON)
+  int32x4_t acc = vdupq_n_s32(0);
+  for (; ii + 16 <= length; ii += 16) {
+    int8x16_t w = vld1q_s8(weights + ii);
+    int8x16_t f = vld1q_s8(features + ii);
+    acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(w), vget_low_s8(f)));
+    acc = vpadalq_s16(acc, vmull_s8(vget_high_s8(w), vget_high_s8(f)));
+  }
+  sum = vaddvq_s32(acc);
+#endif
+  for (; ii < length; ii++)
+    sum += weights[ii] * features[ii];
+  return sum;
+}
+
+static inline int32_t perceptron_dot(const int16_t* weights, const int16_t* features, uns length) {
+  int32_t sum = 0;
+  uns ii = 0;
+#if defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+  for (; ii + 16 <= length; ii += 16) {
+    __m256i w = _mm256_loadu_si256((const __m256i*)(weights + ii));
+    __m256i f = _mm256_loadu_si256((const __m256i*)(features + ii));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(w, f));
+  }
+  __m128i acc4 = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+  acc4 = _mm_hadd_epi32(acc4, acc4);
+  acc4 = _mm_hadd_epi32(acc4, acc4);
+  sum = _mm_cvtsi128_si32(acc4);
+#elif defined(__ARM_NEON)
+  int32x4_t acc = vdupq_n_s32(0);
+  for (; ii + 8 <= length; ii += 8) {
+    int16x8_t w = vld1q_s16(weights + ii);
+    int16x8_t f = vld1q_s16(features + ii);
+    acc = vmlal_s16(acc, vget_low_s16(w), vget_low_s16(f));
+    acc = vmlal_s16(acc, vget_high_s16(w), vget_high_s16(f));
+  }
+  sum = vaddvq_s32(acc);
+#endif
+  for (; ii < length; ii++)
+    sum += weights[ii] * features[ii];
+  return sum;
+}
+
+// weights += error * features, clamped to [-saturation, saturation]; error is +1 or -1
+static inline void perceptron_update(int8_t* weights, const int8_t* features, uns length, int error,
+                                     int saturation) {
+  uns ii = 0;
+#if defined(__AVX2__)
+  const __m256i sign = _mm256_set1_epi8((int8_t)error);
+  const __m256i hi = _mm256_set1_epi8((int8_t)saturation);
+  const __m256i lo = _mm256_set1_epi8((int8_t)-saturation);
+  for (; ii + 32 <= length; ii += 32) {
+    __m256i w = _mm256_loadu_si256((const __m256i*)(weights + ii));
+    __m256i f = _mm256_sign_epi8(_mm256_loadu_si256((const __m256i*)(features + ii)), sign);
+    w = _mm256_max_epi8(_mm256_min_epi8(_mm256_adds_epi8(w, f), hi), lo);
+    _mm256_storeu_si256((__m256i*)(weights + ii), w);
+  }
+#elif defined(__ARM_NEON)
+  const int8x16_t hi = vdupq_n_s8((int8_t)saturation);
+  const int8x16_t lo = vdupq_n_s8((int8_t)-saturation);
+  for (; ii + 16 <= length; ii += 16) {
+    int8x16_t f = vld1q_s8(features + ii);
+    if (error < 0)
+      f = vnegq_s8(f);
+    int8x16_t w = vqaddq_s8(vld1q_s8(weights + ii), f);
+    vst1q_s8(weights + ii, vmaxq_s8(vminq_s8(w, hi), lo));
+  }
+#endif
+  for (; ii < length; ii++) {
+    int value = weights[ii] + error * features[ii];
+    weights[ii] = value > saturation ? saturation : (value < -saturation ? -saturation : value);
+  }
+}
+
+static inline void perceptron_update(int16_t* weights, const int16_t* features, uns length, int error,
+                                     int saturation) {
+  uns ii = 0;
+#if defined(__AVX2__)
+  const __m256i sign = _mm256_set1_epi16((int16_t)error);
+  const __m256i hi = _mm256_set1_epi16((int16_t)saturation);
+  const __m256i lo = _mm256_set1_epi16((int16_t)-saturation);
+  for (; ii + 16 <= length; ii += 16) {
+    __m256i w = _mm256_loadu_si256((const __m256i*)(weights + ii));
+    __m256i f = _mm256_sign_epi16(_mm256_loadu_si256((const __m256i*)(features + ii)), sign);
+    w = _mm256_max_epi16(_mm256_min_epi16(_mm256_adds_epi16(w, f), hi), lo);
+    _mm256_storeu_si256((__m256i*)(weights + ii), w);
+  }
+#elif defined(__ARM_NEON)
+  const int16x8_t hi = vdupq_n_s16((int16_t)saturation);
+  const int16x8_t lo = vdupq_n_s16((int16_t)-saturation);
+  for (; ii + 8 <= length; ii += 8) {
+    int16x8_t f = vld1q_s16(features + ii);
+    if (error < 0)
+      f = vnegq_s16(f);
+    int16x8_t w = vqaddq_s16(vld1q_s16(weights + ii), f);
+    vst1q_s16(weights + ii, vmaxq_s16(vminq_s16(w, hi), lo));
+  }
+#endif
+  for (; ii < length; ii++) {
+    int value = weights[ii] + error * features[ii];
+    weights[ii] = value > saturation ? saturation : (value < -saturation ? -saturation : value);
+  }
+}
+
+template <typename IndexFunction = PCBasedIndex, typename Weight_Type = int8_t>
+class FixedPerceptronTable {
+ public:
+  FixedPerceptronTable(int _num_features, int _num_entries, int weight_width, int _threshold)
+      : num_features(_num_features),
+        num_entries(_num_entries),
+        row_length((_num_features + 1 + ROW_ALIGN - 1) / ROW_ALIGN * ROW_ALIGN),
+        saturation_value((int)(1u << weight_width) - 1),
+        threshold(_threshold) {
+    ASSERT(0, weight_width < (int)(8 * sizeof(Weight_Type)));
+    clear_weights();
+  }
+
+  void clear_weights() { weights.assign((size_t)num_entries * row_length, 0); }
+
+  // A zeroed feature vector of the row layout, with the bias input set
+  std::vector<Weight_Type> new_features() const {
+    std::vector<Weight_Type> features(row_length, 0);
+    features[num_features] = 1;
+    return features;
+  }
+
+  // Pass the sum from predict; the weights only move when its sign was wrong
+  void train(const std::vector<Weight_Type>& features, bool correct_prediction, int32_t prediction_val, Addr pc,
+             uns history) {
+    ASSERT(0, features.size() == row_length);
+    if ((prediction_val >= 0) == correct_prediction)
+      return;
+    int index = IndexFunction::get_index(pc, num_entries, history);
+    perceptron_update(&weights[(size_t)index * row_length], features.data(), row_length, correct_prediction ? 1 : -1,
+                      saturation_value);
+  }
+
+  bool predict(const std::vector<Weight_Type>& features, int32_t& sum_out, bool& prediction, Addr pc,
+               uns history) const {
+    ASSERT(0, features.size() == row_length);
+    int index = IndexFunction::get_index(pc, num_entries, history);
+    sum_out = perceptron_dot(&weights[(size_t)index * row_length], features.data(), row_length);
+    prediction = sum_out >= threshold;
+    return prediction;
+  }
+
+  Weight_Type get_weight(uns index, uns feature) const { return weights[(size_t)index * row_length + feature]; }
+
+  static void extract_bipolar_features(int input, Weight_Type* output, int num_features) {
+    for (int i = 0; i < num_features; ++i) {
+      output[i] = (input & (1 << i)) ? 1 : -1;
+    }
+  }
+
+  static void extract_binary_features(int input, Weight_Type* output, int num_features) {
+    for (int i = 0; i < num_features; ++i) {
+      output[i] = (input & (1 << i)) ? 1 : 0;
+    }
+  }
+
+ private:
+  static const uns ROW_ALIGN = 32 / sizeof(Weight_Type);
+
+  std::vector<Weight_Type> weights;
+  uns num_features;
+  uns num_entries;
+  uns row_length;
+  int saturation_value;
+  int32_t threshold;  // moves decision boundary for inference
+};
+
+#endif /* #ifndef __PERCEPTRON_HPP__ */
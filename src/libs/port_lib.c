@@ -28,10 +28,13 @@
 
 #include "libs/port_lib.h"
 
+#include <stdlib.h>
+
 #include "globals/assert.h"
 #include "globals/global_defs.h"
 #include "globals/global_types.h"
 #include "globals/global_vars.h"
+#include "globals/utils.h"
 
 #include "debug/debug.param.h"
 #include "debug/debug_macros.h"
@@ -41,67 +44,153 @@
 
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_PORT_LIB, ##args)
 
+/**************************************************************************************/
+/* Local Prototypes */
+
+static void ports_advance(Ports* ports);
+static uns64 ports_union(const uns64* busy, uns num);
+static uns64 port_window(uns delay, uns cycles);
+static Flag reserve_port(const Ports* ports, uns64* busy, uns num, uns64 blocked, uns64 window);
+static Counter port_free_cycle(const Ports* ports, const uns64* busy, uns num, uns64 blocked, uns cycles);
+
 /**************************************************************************************/
 /* init_ports: */
 
 void init_ports(Ports* ports, char name[], uns read, uns write, Flag writes_prevent_reads) {
   DEBUG(0, "Initializing ports called '%s'.\n", name);
   strncpy(ports->name, name, MAX_STR_LENGTH);
-  ports->read_last_cycle = 0;
-  ports->write_last_cycle = 0;
+  ports->base_cycle = 0;
   ports->num_read_ports = read;
-  ports->read_ports_in_use = 0;
   ports->num_write_ports = write;
-  ports->write_ports_in_use = 0;
+  ports->read_busy = (uns64*)calloc(MAX2(read, 1), sizeof(uns64));
+  ports->write_busy = (uns64*)calloc(MAX2(write, 1), sizeof(uns64));
   ports->writes_prevent_reads = writes_prevent_reads;
 }
 
 /**************************************************************************************/
-/* get_read_port: */
+/* ports_advance: slide the calendars so that bit 0 is the current cycle */
+
+static void ports_advance(Ports* ports) {
+  if (ports->base_cycle == cycle_count)
+    return;
+  Counter shift = cycle_count - ports->base_cycle;
+  Flag clear = cycle_count < ports->base_cycle || shift >= PORT_CALENDAR_CYCLES;
+  for (uns ii = 0; ii < ports->num_read_ports; ii++)
+    ports->read_busy[ii] = clear ? 0 : ports->read_busy[ii] >> shift;
+  for (uns ii = 0; ii < ports->num_write_ports; ii++)
+    ports->write_busy[ii] = clear ? 0 : ports->write_busy[ii] >> shift;
+  ports->base_cycle = cycle_count;
+}
 
-Flag get_read_port(Ports* ports) {
-  if (ports->read_last_cycle != cycle_count) {
-    ASSERT(0, ports->num_read_ports > 0);
-    ports->read_last_cycle = cycle_count;
-    ports->read_ports_in_use = 1;
-    DEBUG(0, "get_read_port successful\n");
-    return SUCCESS;
-  }
+static uns64 ports_union(const uns64* busy, uns num) {
+  uns64 all = 0;
+  for (uns ii = 0; ii < num; ii++)
+    all |= busy[ii];
+  return all;
+}
 
-  if (ports->read_ports_in_use == ports->num_read_ports) {
-    DEBUG(0, "get_read_port failed (%d ports in use)\n", ports->read_ports_in_use);
+static uns64 port_window(uns delay, uns cycles) {
+  ASSERT(0, cycles > 0 && delay + cycles <= PORT_CALENDAR_CYCLES);
+  uns64 mask = cycles == PORT_CALENDAR_CYCLES ? ~0ULL : (1ULL << cycles) - 1;
+  return mask << delay;
+}
+
+/* takes the first port free over the whole window */
+static Flag reserve_port(const Ports* ports, uns64* busy, uns num, uns64 blocked, uns64 window) {
+  ASSERTM(0, num > 0, "%s has no ports of the requested kind\n", ports->name);
+  if (blocked & window)
     return FAILURE;
+  for (uns ii = 0; ii < num; ii++) {
+    if (!(busy[ii] & window)) {
+      busy[ii] |= window;
+      return SUCCESS;
+    }
   }
-  if (ports->write_ports_in_use && ports->writes_prevent_reads) {
-    DEBUG(0, "get_read_port failed (%d writes preventing reads)\n", ports->write_ports_in_use);
-    return FAILURE;
+  return FAILURE;
+}
+
+/* bit k of run is set if a port is free from base_cycle + k for cycles cycles;
+   the cycles past the calendar are all free */
+static Counter port_free_cycle(const Ports* ports, const uns64* busy, uns num, uns64 blocked, uns cycles) {
+  ASSERT(0, cycles > 0 && cycles <= PORT_CALENDAR_CYCLES);
+  uns64 run = 0;
+  for (uns ii = 0; ii < num; ii++) {
+    uns64 free = ~(busy[ii] | blocked);
+    uns64 port_run = free;
+    for (uns jj = 1; jj < cycles; jj++)
+      port_run &= (free >> jj) | ~(~0ULL >> jj);
+    run |= port_run;
   }
+  return ports->base_cycle + (run ? __builtin_ctzll(run) : PORT_CALENDAR_CYCLES);
+}
 
-  DEBUG(0, "get_read_port successful\n");
-  ports->read_ports_in_use++;
-  return SUCCESS;
+/**************************************************************************************/
+/* get_read_port: */
+
+Flag get_read_port(Ports* ports) {
+  return reserve_read_port(ports, 0, 1);
 }
 
 /**************************************************************************************/
 /* get_write_port: */
 
 Flag get_write_port(Ports* ports) {
-  if (ports->write_last_cycle != cycle_count) {
-    ASSERT(0, ports->num_write_ports > 0);
-    ports->write_last_cycle = cycle_count;
-    ports->write_ports_in_use = 1;
-    DEBUG(0, "get_write_port successful\n");
-    return SUCCESS;
-  }
+  return reserve_write_port(ports, 0, 1);
+}
 
-  if (ports->write_ports_in_use == ports->num_write_ports) {
-    DEBUG(0, "get_write_port failed (%d ports in use)\n", ports->write_ports_in_use);
-    return FAILURE;
+/**************************************************************************************/
+/* release_write_port: */
+
+void release_write_port(Ports* ports) {
+  ports_advance(ports);
+  for (uns ii = ports->num_write_ports; ii-- > 0;) {
+    if (ports->write_busy[ii] & 1) {
+      ports->write_busy[ii] &= ~1ULL;
+      return;
+    }
   }
+  ASSERTM(0, FALSE, "%s has no write port taken this cycle\n", ports->name);
+}
+
+/**************************************************************************************/
+/* reserve_read_port: */
+
+Flag reserve_read_port(Ports* ports, uns delay, uns cycles) {
+  ports_advance(ports);
+  uns64 window = port_window(delay, cycles);
+  uns64 blocked = ports->writes_prevent_reads ? ports_union(ports->write_busy, ports->num_write_ports) : 0;
+  Flag success = reserve_port(ports, ports->read_busy, ports->num_read_ports, blocked, window);
+  DEBUG(0, "reserve_read_port %s +%u for %u %s\n", ports->name, delay, cycles, success ? "successful" : "failed");
+  return success;
+}
+
+/**************************************************************************************/
+/* reserve_write_port: */
+
+Flag reserve_write_port(Ports* ports, uns delay, uns cycles) {
+  ports_advance(ports);
+  uns64 window = port_window(delay, cycles);
   if (ports->writes_prevent_reads)
-    ASSERTM(0, ports->read_ports_in_use == 0, "Must request write ports before reads.\n");
+    ASSERTM(0, !(ports_union(ports->read_busy, ports->num_read_ports) & window),
+            "Must request write ports before reads.\n");
+  Flag success = reserve_port(ports, ports->write_busy, ports->num_write_ports, 0, window);
+  DEBUG(0, "reserve_write_port %s +%u for %u %s\n", ports->name, delay, cycles, success ? "successful" : "failed");
+  return success;
+}
+
+/**************************************************************************************/
+/* read_port_free_cycle: */
+
+Counter read_port_free_cycle(Ports* ports, uns cycles) {
+  ports_advance(ports);
+  uns64 blocked = ports->writes_prevent_reads ? ports_union(ports->write_busy, ports->num_write_ports) : 0;
+  return port_free_cycle(ports, ports->read_busy, ports->num_read_ports, blocked, cycles);
+}
+
+/**************************************************************************************/
+/* write_port_free_cycle: */
 
-  DEBUG(0, "get_write_port successful\n");
-  ports->write_ports_in_use++;
-  return SUCCESS;
+Counter write_port_free_cycle(Ports* ports, uns cycles) {
+  ports_advance(ports);
+  return port_free_cycle(ports, ports->write_busy, ports->num_write_ports, 0, cycles);
 }
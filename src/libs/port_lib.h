@@ -32,18 +32,23 @@
 #include "globals/global_defs.h"
 #include "globals/global_types.h"
 
+/**************************************************************************************/
+/* Defines */
+
+/* Cycles ahead of cycle_count that a port can be reserved */
+#define PORT_CALENDAR_CYCLES 64
+
 /**************************************************************************************/
 /* Types */
 
 // typedef in globals/global_types.h
 struct Ports_struct {
   char name[MAX_STR_LENGTH + 1];
-  Counter read_last_cycle;
-  Counter write_last_cycle;
+  Counter base_cycle;  // the cycle of bit 0 of the calendars
   uns num_read_ports;
-  uns read_ports_in_use;
   uns num_write_ports;
-  uns write_ports_in_use;
+  uns64* read_busy;  // per port, bit k is set if the port is taken at base_cycle + k
+  uns64* write_busy;
   Flag writes_prevent_reads;
 };
 
@@ -51,9 +56,24 @@ struct Ports_struct {
 /* Prototypes */
 
 void init_ports(Ports* ports, char[], uns, uns, Flag);
+
+/* Take a port for the current cycle */
 Flag get_read_port(Ports* ports);
 Flag get_write_port(Ports* ports);
 
+/* Give back a write port taken this cycle by get_write_port */
+void release_write_port(Ports* ports);
+
+/* Take a port for the cycles cycles starting delay cycles from now
+   (delay + cycles <= PORT_CALENDAR_CYCLES) */
+Flag reserve_read_port(Ports* ports, uns delay, uns cycles);
+Flag reserve_write_port(Ports* ports, uns delay, uns cycles);
+
+/* The earliest cycle, not before cycle_count, at which a port is free for
+   cycles consecutive cycles */
+Counter read_port_free_cycle(Ports* ports, uns cycles);
+Counter write_port_free_cycle(Ports* ports, uns cycles);
+
 /**************************************************************************************/
 
 #endif /* #ifndef __PORT_LIB_H__ */
@@ -0,0 +1,131 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/snapshot_lib.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Versioned binary snapshots of simulator state.
+ ***************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "libs/snapshot_lib.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define SNAPSHOT_MAGIC 0x50414e5342524353ULL /* "SCRBSNAP" */
+#define SNAPSHOT_VERSION 1
+
+/**************************************************************************************/
+/* File layout: magic, version, then for every section its name and for every
+   block its size followed by its bytes. */
+
+static void snapshot_write(Snapshot* snap, const void* data, uns64 bytes) {
+  uns64 written = fwrite(data, 1, bytes, snap->file);
+  ASSERTM(0, written == bytes, "Could not write snapshot %s\n", snap->file_name);
+}
+
+static void snapshot_read(Snapshot* snap, void* data, uns64 bytes) {
+  uns64 read = fread(data, 1, bytes, snap->file);
+  ASSERTM(0, read == bytes, "Snapshot %s is truncated in section %s\n", snap->file_name, snap->section);
+}
+
+Snapshot* snapshot_open(const char* file_name, Flag save) {
+  Snapshot* snap = (Snapshot*)calloc(1, sizeof(Snapshot));
+  snap->file = fopen(file_name, save ? "wb" : "rb");
+  ASSERTM(0, snap->file, "Could not open snapshot %s\n", file_name);
+  strncpy(snap->file_name, file_name, MAX_STR_LENGTH);
+  strncpy(snap->section, "header", MAX_STR_LENGTH);
+  snap->save = save;
+
+  uns64 magic = SNAPSHOT_MAGIC;
+  uns32 version = SNAPSHOT_VERSION;
+  if (save) {
+    snapshot_write(snap, &magic, sizeof(magic));
+    snapshot_write(snap, &version, sizeof(version));
+  } else {
+    snapshot_read(snap, &magic, sizeof(magic));
+    snapshot_read(snap, &version, sizeof(version));
+    ASSERTM(0, magic == SNAPSHOT_MAGIC, "%s is not a snapshot\n", file_name);
+    ASSERTM(0, version == SNAPSHOT_VERSION, "Snapshot %s has version %u, expected %u\n", file_name, version,
+            SNAPSHOT_VERSION);
+  }
+  return snap;
+}
+
+void snapshot_close(Snapshot* snap) {
+  if (!snap->save) {
+    char extra;
+    uns64 read = fread(&extra, 1, 1, snap->file);
+    ASSERTM(0, read == 0, "Snapshot %s has data after section %s\n", snap->file_name, snap->section);
+  }
+  int error = fclose(snap->file);
+  ASSERTM(0, error == 0, "Could not write snapshot %s\n", snap->file_name);
+  free(snap);
+}
+
+void snapshot_section(Snapshot* snap, const char* name) {
+  uns32 length = strlen(name);
+  ASSERT(0, length <= MAX_STR_LENGTH);
+  if (snap->save) {
+    snapshot_write(snap, &length, sizeof(length));
+    snapshot_write(snap, name, length);
+  } else {
+    char saved[MAX_STR_LENGTH + 1];
+    uns32 saved_length;
+    snapshot_read(snap, &saved_length, sizeof(saved_length));
+    ASSERTM(0, saved_length <= MAX_STR_LENGTH, "Snapshot %s is corrupt after section %s\n", snap->file_name,
+            snap->section);
+    snapshot_read(snap, saved, saved_length);
+    saved[saved_length] = '\0';
+    ASSERTM(0, !strcmp(saved, name), "Snapshot %s has section %s where %s was expected\n", snap->file_name, saved,
+            name);
+  }
+  strncpy(snap->section, name, MAX_STR_LENGTH);
+}
+
+void snapshot_data(Snapshot* snap, void* data, uns64 bytes) {
+  if (snap->save) {
+    snapshot_write(snap, &bytes, sizeof(bytes));
+    snapshot_write(snap, data, bytes);
+  } else {
+    uns64 saved_bytes;
+    snapshot_read(snap, &saved_bytes, sizeof(saved_bytes));
+    ASSERTM(0, saved_bytes == bytes, "Snapshot %s has a %llu byte block in section %s where %llu bytes were expected\n",
+            snap->file_name, saved_bytes, snap->section, bytes);
+    snapshot_read(snap, data, bytes);
+  }
+}
+
+void snapshot_check(Snapshot* snap, const char* what, uns64 value) {
+  uns64 saved = value;
+  snapshot_data(snap, &saved, sizeof(saved));
+  ASSERTM(0, saved == value, "Snapshot %s was taken with %s %llu in section %s, now %llu\n", snap->file_name, what,
+          saved, snap->section, value);
+}
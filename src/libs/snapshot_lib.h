@@ -0,0 +1,77 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : libs/snapshot_lib.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Versioned binary snapshots of simulator state. Saving and
+ *                restoring go through the same calls, so a component describes
+ *                its state once: each snapshot_data() either writes a block or
+ *                overwrites it with the block read back, checking its size.
+ ***************************************************************************************/
+
+#ifndef __SNAPSHOT_LIB_H__
+#define __SNAPSHOT_LIB_H__
+
+#include <stdio.h>
+
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Snapshot_struct {
+  FILE* file;
+  char file_name[MAX_STR_LENGTH + 1];
+  char section[MAX_STR_LENGTH + 1]; /* current section, for error messages */
+  Flag save;                        /* writing the snapshot, else restoring it */
+} Snapshot;
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Opens file_name for saving or restoring, the header is checked on restore */
+Snapshot* snapshot_open(const char* file_name, Flag save);
+void snapshot_close(Snapshot* snap);
+
+/* Starts a named section. Restoring checks the name, so that state is never
+   read into the wrong structure. */
+void snapshot_section(Snapshot* snap, const char* name);
+
+/* Saves or restores bytes of data */
+void snapshot_data(Snapshot* snap, void* data, uns64 bytes);
+
+/* Saves value, or checks on restore that it is unchanged (e.g. a table size) */
+void snapshot_check(Snapshot* snap, const char* what, uns64 value);
+
+#define SNAPSHOT_VAR(snap, var) snapshot_data(snap, &(var), sizeof(var))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* #ifndef __SNAPSHOT_LIB_H__ */
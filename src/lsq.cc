@@ -46,9 +46,21 @@ extern "C" {
 #include "node_stage.h"
 }
 
+#include <algorithm>
 #include <deque>
+#include <unordered_map>
 #include <vector>
 
+/**************************************************************************************/
+/* Defines */
+
+/* Granularity of the store forwarding index. One line covers 64 bytes so a
+   line's byte mask fits in 64 bits. */
+#define STORE_INDEX_LINE_SIZE_LOG 6
+#define STORE_INDEX_LINE_SIZE (1 << STORE_INDEX_LINE_SIZE_LOG)
+#define STORE_INDEX_LINE(va) ((va) >> STORE_INDEX_LINE_SIZE_LOG)
+#define STORE_INDEX_BYTE_IN_LINE(va) ((va) & (STORE_INDEX_LINE_SIZE - 1))
+
 /**************************************************************************************/
 /* Definition */
 
@@ -139,11 +151,188 @@ void LSQ::recover(Counter flush_op_num) {
 
 /**************************************************************************************/
 
+/* Store_Index: address CAM used for store-to-load dependence lookup. Every
+   mapped store is kept in an age-ordered queue and, for every 64-byte line it
+   writes, in that line's age-ordered list together with the bytes it writes
+   in that line. A load only walks the stores of the lines it reads, youngest
+   first, and stops once every byte it reads has a supplier. */
+struct Store_Index_Entry {
+  Op* op;
+  Counter op_num;
+  Counter unique_num;
+  uns64 byte_mask;  // bytes written within the line (only used in line lists)
+
+  Store_Index_Entry(Op* store_op, uns64 mask)
+      : op(store_op), op_num(store_op->op_num), unique_num(store_op->unique_num), byte_mask(mask) {}
+};
+
+class Store_Index {
+ private:
+  uns8 proc_id;
+
+  std::deque<Store_Index_Entry> stores;                               // all indexed stores, oldest first
+  std::unordered_map<Addr, std::deque<Store_Index_Entry>> line_index;  // per-line stores, oldest first
+  std::vector<Op*> found;                                              // distinct stores found by a lookup
+
+  static uns64 line_mask(Addr va, uns size, Addr line);
+  static std::deque<Store_Index_Entry>::iterator find_entry(std::deque<Store_Index_Entry>& entries, Counter op_num,
+                                                            Counter unique_num);
+  void remove_from_lines(const Store_Index_Entry& store);
+
+ public:
+  void init(uns8 proc_id);
+  void insert(Op* store_op);
+  void remove(Op* store_op);
+  void recover(Counter flush_op_num);
+  Op* find_deps(Op* load_op, void (*dep_action)(Op*, Op*));
+};
+
+/* line_mask: bytes of the access [va, va + size) that fall into the given line */
+uns64 Store_Index::line_mask(Addr va, uns size, Addr line) {
+  Addr last_va = ADDR_PLUS_OFFSET(va, size - 1);
+  uns first_byte = STORE_INDEX_LINE(va) == line ? STORE_INDEX_BYTE_IN_LINE(va) : 0;
+  uns last_byte = STORE_INDEX_LINE(last_va) == line ? STORE_INDEX_BYTE_IN_LINE(last_va) : STORE_INDEX_LINE_SIZE - 1;
+  uns num_bytes = last_byte - first_byte + 1;
+  uns64 mask = num_bytes == STORE_INDEX_LINE_SIZE ? ~(uns64)0 : ((uns64)1 << num_bytes) - 1;
+  return mask << first_byte;
+}
+
+/* find_entry: the entry of a store in an age-ordered list, or end() if it is
+   not there. The lists are sorted by op_num, so this is a binary search. */
+std::deque<Store_Index_Entry>::iterator Store_Index::find_entry(std::deque<Store_Index_Entry>& entries, Counter op_num,
+                                                                 Counter unique_num) {
+  auto entry = std::lower_bound(entries.begin(), entries.end(), op_num,
+                                [](const Store_Index_Entry& lhs, Counter rhs) { return lhs.op_num < rhs; });
+  if (entry == entries.end() || entry->unique_num != unique_num)
+    return entries.end();
+  return entry;
+}
+
+void Store_Index::remove_from_lines(const Store_Index_Entry& store) {
+  Addr va = store.op->oracle_info.va;
+  Addr first_line = STORE_INDEX_LINE(va);
+  Addr last_line = STORE_INDEX_LINE(ADDR_PLUS_OFFSET(va, store.op->oracle_info.mem_size - 1));
+
+  for (Addr line = first_line;; line++) {
+    auto it = line_index.find(line);
+    ASSERT(proc_id, it != line_index.end());
+    auto& line_stores = it->second;
+    // stores almost always leave from one of the ends of the line list
+    if (line_stores.front().unique_num == store.unique_num) {
+      line_stores.pop_front();
+    } else if (line_stores.back().unique_num == store.unique_num) {
+      line_stores.pop_back();
+    } else {
+      auto entry = find_entry(line_stores, store.op_num, store.unique_num);
+      ASSERT(proc_id, entry != line_stores.end());
+      line_stores.erase(entry);
+    }
+    if (line_stores.empty())
+      line_index.erase(it);
+    if (line == last_line)
+      break;
+  }
+}
+
+void Store_Index::init(uns8 proc_id) {
+  this->proc_id = proc_id;
+  stores.clear();
+  line_index.clear();
+  found.clear();
+}
+
+void Store_Index::insert(Op* store_op) {
+  Addr va = store_op->oracle_info.va;
+  uns size = store_op->oracle_info.mem_size;
+
+  ASSERT(proc_id, store_op->table_info->mem_type == MEM_ST);
+  ASSERT(proc_id, stores.empty() || stores.back().op_num < store_op->op_num);
+  if (size == 0)
+    return;
+
+  Addr first_line = STORE_INDEX_LINE(va);
+  Addr last_line = STORE_INDEX_LINE(ADDR_PLUS_OFFSET(va, size - 1));
+  for (Addr line = first_line;; line++) {
+    line_index[line].emplace_back(store_op, line_mask(va, size, line));
+    if (line == last_line)
+      break;
+  }
+  stores.emplace_back(store_op, 0);
+}
+
+void Store_Index::remove(Op* store_op) {
+  // flushed stores have already been removed by recover
+  if (!stores.empty() && stores.front().unique_num == store_op->unique_num) {
+    remove_from_lines(stores.front());
+    stores.pop_front();
+    return;
+  }
+  auto entry = find_entry(stores, store_op->op_num, store_op->unique_num);
+  if (entry != stores.end()) {
+    remove_from_lines(*entry);
+    stores.erase(entry);
+  }
+}
+
+void Store_Index::recover(Counter flush_op_num) {
+  while (!stores.empty() && stores.back().op_num >= flush_op_num) {
+    remove_from_lines(stores.back());
+    stores.pop_back();
+  }
+}
+
+/* find_deps: calls dep_action for every distinct store supplying at least one
+   byte of the load and returns the youngest of them */
+Op* Store_Index::find_deps(Op* load_op, void (*dep_action)(Op*, Op*)) {
+  Addr va = load_op->oracle_info.va;
+  uns size = load_op->oracle_info.mem_size;
+  Op* last_src_op = NULL;
+
+  if (size == 0 || stores.empty())
+    return NULL;
+
+  found.clear();
+  Addr first_line = STORE_INDEX_LINE(va);
+  Addr last_line = STORE_INDEX_LINE(ADDR_PLUS_OFFSET(va, size - 1));
+  for (Addr line = first_line;; line++) {
+    auto it = line_index.find(line);
+    if (it != line_index.end()) {
+      uns64 needed = line_mask(va, size, line);
+      for (auto entry = it->second.rbegin(); entry != it->second.rend() && needed; entry++) {
+        uns64 supplied = needed & entry->byte_mask;
+        if (!supplied)
+          continue;
+        needed &= ~supplied;
+
+        Op* src_op = entry->op;
+        ASSERT(proc_id, src_op->unique_num == entry->unique_num && src_op->op_pool_valid);
+        ASSERT(proc_id, src_op->op_num < load_op->op_num || load_op->off_path);
+        Flag seen = FALSE;
+        for (Op* op : found)
+          seen |= op == src_op;
+        if (seen)
+          continue;
+        found.push_back(src_op);
+        if (dep_action)
+          dep_action(load_op, src_op);
+        if (!last_src_op || last_src_op->op_num < src_op->op_num)
+          last_src_op = src_op;
+      }
+    }
+    if (line == last_line)
+      break;
+  }
+  return last_src_op;
+}
+
+/**************************************************************************************/
+
 class LSQ_Unit {
  private:
   uns8 proc_id;
   LSQ load_queue;
   LSQ store_queue;
+  Store_Index store_index;
 
  public:
   LSQ_Unit(uns8 proc_id);
@@ -154,6 +343,7 @@ class LSQ_Unit {
   void dispatch(Op* mem_op);
   void recover(Counter flush_op_num);
   void commit(Op* mem_op);
+  Store_Index* get_store_index() { return &store_index; }
 };
 
 LSQ_Unit::LSQ_Unit(uns8 proc_id) {
@@ -177,6 +367,8 @@ const LSQ* LSQ_Unit::get_queue(Mem_Type mem_type) const {
 }
 
 void LSQ_Unit::init(uns8 proc_id) {
+  this->proc_id = proc_id;
+  store_index.init(proc_id);
   load_queue.init(proc_id, MEM_LD, LOAD_QUEUE_ENTRY_NUM);
   store_queue.init(proc_id, MEM_ST, STORE_QUEUE_ENTRY_NUM);
 }
@@ -214,6 +406,9 @@ void LSQ_Unit::dispatch(Op* mem_op) {
 }
 
 void LSQ_Unit::recover(Counter flush_op_num) {
+  store_index.recover(flush_op_num);
+  if (!LSQ_ENABLE)
+    return;
   load_queue.recover(flush_op_num);
   store_queue.recover(flush_op_num);
 }
@@ -238,38 +433,28 @@ void LSQ_Unit::commit(Op* mem_op) {
 /* Global Values */
 
 static std::vector<LSQ_Unit> per_core_lsq_unit;
-LSQ_Unit* lsq_unit = nullptr;
+CORE_LOCAL LSQ_Unit* lsq_unit = nullptr;
 
 /**************************************************************************************/
 /* External Methods */
 
+/* The store index is used for memory dependences even when LSQ occupancy is not
+   modeled, so the per-core units always exist. */
 void alloc_mem_lsq(uns num_cores) {
-  if (!LSQ_ENABLE)
-    return;
-
   for (uns ii = 0; ii < num_cores; ii++) {
     per_core_lsq_unit.push_back(LSQ_Unit(ii));
   }
 }
 
 void set_lsq(uns8 proc_id) {
-  if (!LSQ_ENABLE)
-    return;
-
   lsq_unit = &per_core_lsq_unit[proc_id];
 }
 
 void init_lsq(uns8 proc_id, const char* name) {
-  if (!LSQ_ENABLE)
-    return;
-
   lsq_unit->init(proc_id);
 }
 
 void recover_lsq() {
-  if (!LSQ_ENABLE)
-    return;
-
   lsq_unit->recover(bp_recovery_info->recovery_op_num);
 }
 
@@ -316,18 +501,48 @@ void lsq_commit(Op* mem_op) {
   lsq_unit->commit(mem_op);
 }
 
+/*
+  Called by:
+  --- map.c -> when a store's address is known at map time
+  Desc:
+  --- index the store for store-to-load dependence lookup
+*/
+void lsq_map_store(Op* store_op) {
+  lsq_unit->get_store_index()->insert(store_op);
+}
+
+/*
+  Called by:
+  --- map.c -> when a load's address is known at map time
+  Desc:
+  --- call dep_action for every in-flight store that supplies part of the
+  --- load and return the youngest one, or NULL if there is none
+*/
+Op* lsq_find_store_deps(Op* load_op, void (*dep_action)(Op*, Op*)) {
+  return lsq_unit->get_store_index()->find_deps(load_op, dep_action);
+}
+
+/*
+  Called by:
+  --- op_pool.c -> when a store op is freed
+  Desc:
+  --- drop the store from the store index
+*/
+void lsq_release_store(Op* store_op) {
+  per_core_lsq_unit[store_op->proc_id].get_store_index()->remove(store_op);
+}
+
 /**************************************************************************************/
 
-int lsq_get_in_flight_load_num() {
+Flag lsq_has_in_flight_load() {
   if (!LSQ_ENABLE)
-    return 0;
+    return FALSE;
 
-  int in_flight_num = 0;
-  const auto& store_entries = lsq_unit->get_queue(MEM_LD)->get_entries();
-  for (const auto& entry : store_entries) {
+  const auto& load_entries = lsq_unit->get_queue(MEM_LD)->get_entries();
+  for (const auto& entry : load_entries) {
     if (entry.op->state >= OS_IN_RS)
-      in_flight_num++;
+      return TRUE;
   }
 
-  return in_flight_num;
+  return FALSE;
 }
@@ -48,7 +48,11 @@ Flag lsq_available(Mem_Type mem_type);  // check if there is an available LSQ en
 void lsq_dispatch(Op* mem_op);          // insert mem op into LSQ when mem op is inserted into ROB
 void lsq_commit(Op* mem_op);            // free the entry when the mem op is retired
 
-int lsq_get_in_flight_load_num();
+void lsq_map_store(Op* store_op);                                  // index a store for dependence lookup
+Op* lsq_find_store_deps(Op* load_op, void (*dep_action)(Op*, Op*));  // find the stores a load depends on
+void lsq_release_store(Op* store_op);                              // drop a freed store from the index
+
+Flag lsq_has_in_flight_load();  // any load in the LSQ has been scheduled
 
 #ifdef __cplusplus
 }
@@ -94,6 +94,7 @@ Scarab's source code is organized as follows:
     + cmp_model.h
     + cmp_model_support.h
     + dumb_model.h
+    + interval_model.h
 
   + Cores
 
@@ -243,10 +244,13 @@ int main(int argc, char* argv[], char* envp[]) {
   ASSERTU(0, sizeof(int64) == 8);
 
   /* read parameters from PARAMS.in and the command line */
+  init_phase_start();
   simulated_argv = get_params(argc, argv);
+  init_phase_done("params");
 
   /* perform global initialization */
   init_global(simulated_argv, envp);
+  init_phase_done("global");
 
   /* print PID (sometimes useful for debugging) */
   if (PRINT_PID) {
@@ -254,8 +258,9 @@ int main(int argc, char* argv[], char* envp[]) {
     sleep(10);
   }
 
-  /* set up signal handler for SIGINT */
-  signal(SIGINT, handle_SIGINT);
+  /* set up signal handlers for SIGINT and SIGTERM */
+  signal(SIGINT, handle_exit_signal);
+  signal(SIGTERM, handle_exit_signal);
 
   /* print startup messages */
   time(&cur_time);
@@ -271,6 +276,12 @@ int main(int argc, char* argv[], char* envp[]) {
     case FULL_SIM_MODE:
       full_sim();
       break;
+    case SAMPLING_SIM_MODE:
+      sampling_sim();
+      break;
+    case DRAM_REPLAY_SIM_MODE:
+      dram_replay_sim();
+      break;
 #ifdef ENABLE_PT_MEMTRACE
     case TRACE_BBV_MODE:
     case TRACE_BBV_DISTRIBUTED_MODE:
@@ -39,11 +39,11 @@
 #include "debug/debug_print.h"
 
 #include "core.param.h"
+#include "general.param.h"
 #include "memory/memory.param.h"
 
-#include "libs/hash_lib.h"
-
 #include "cmp_model.h"
+#include "lsq.h"
 #include "map_rename.h"
 #include "model.h"
 #include "statistics.h"
@@ -55,39 +55,8 @@
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_MAP, ##args)
 #define DEBUGU(proc_id, args...) _DEBUGU(proc_id, DEBUG_MAP, ##args)
 
-#define WAKE_UP_ENTRIES_INC 256 /* default 256 */
-#define MEM_ADDR_SRC 0          /* address for memory instructions calculated off source 0 */
-
-#define MEM_MAP_ENTRY_SIZE_LOG 3
-#define MEM_MAP_ENTRY_SIZE (1 << MEM_MAP_ENTRY_SIZE_LOG)
-#define MEM_MAP_BYTE_IN_ENTRY(va) ((va) & (MEM_MAP_ENTRY_SIZE - 1))
-#define MEM_MAP_ENTRY_ADDR(va) ((va) & ~(Addr)(MEM_MAP_ENTRY_SIZE - 1))
-
-#define MEM_MAP_KEY(va) ((va) >> MEM_MAP_ENTRY_SIZE_LOG)
-#define MEM_MAP_BYTE_INDEX(byte, off_path) ((byte) + ((off_path) ? MEM_MAP_ENTRY_SIZE : 0))
-
-/**************************************************************************************/
-/* Types */
-
-typedef struct Mem_Map_Entry_struct {
-  Op* op[2 * MEM_MAP_ENTRY_SIZE]; /* last op to write (invalid when committed),
-                                   * first half onpath, second half offpath*/
-  uns flag_mask;                  /* offpath flags, one per byte */
-  uns store_mask;                 /* shows position of all distinct stores
-                                   * supplying a partial value to this map entry */
-} Mem_Map_Entry;
-
-/* Data structure for easy traversal of memory map hash given an
-   access with an address and size */
-typedef struct Mem_Map_Traversal_struct {
-  Addr entry_addr; /* Entry address, can be used by caller */
-  Addr first_entry_addr;
-  Addr last_entry_addr;
-  uns byte; /* Byte within entry, can be used by caller */
-  uns last_byte;
-  uns first_entry_first_byte;
-  uns last_entry_last_byte;
-} Mem_Map_Traversal;
+#define WAKE_UP_CHUNKS_INC 64 /* default 64 */
+#define MEM_ADDR_SRC 0        /* address for memory instructions calculated off source 0 */
 
 /**************************************************************************************/
 /* External variables */
@@ -97,7 +66,7 @@ extern Op invalid_op;
 /**************************************************************************************/
 /* Global Variables */
 
-Map_Data* map_data = NULL;
+CORE_LOCAL Map_Data* map_data = NULL;
 
 const char* const dep_type_names[NUM_DEP_TYPES] = {
     "REG_DATA",
@@ -112,19 +81,10 @@ static inline void read_reg_map(Op*);
 static inline void read_store_map(Op*);
 static inline void update_map(Op*);
 
-static inline void expand_wake_up_entries(void);
-static inline void update_store_hash(Op* op);
+static inline void expand_wake_up_chunks(void);
 static inline Op* add_store_deps(Op* op);
+static void add_store_dep(Op* op, Op* src_op);
 static inline void update_map_entry(Op* op, Map_Entry* map_entry);
-static inline void recover_mem_map_entry(void* hash_entry, void* arg);
-
-/* memory map hash traversal */
-static inline void mem_map_entry_traversal_init(Mem_Map_Traversal* traversal, Addr va, uns size);
-static inline Flag mem_map_entry_traversal_done(Mem_Map_Traversal* traversal);
-static inline void mem_map_entry_traversal_next(Mem_Map_Traversal* traversal);
-static inline void mem_map_byte_traversal_init(Mem_Map_Traversal* traversal);
-static inline Flag mem_map_byte_traversal_done(Mem_Map_Traversal* traversal);
-static inline void mem_map_byte_traversal_next(Mem_Map_Traversal* traversal);
 
 /**************************************************************************************/
 /* set_map_data: */
@@ -158,17 +118,8 @@ void init_map(uns8 proc_id) {
   map_data->last_store[1].op = &invalid_op;
   map_data->last_store[1].op_num = 0;
 
-  /* Allocate the wake_up_entry pool. */
-  expand_wake_up_entries();
-
-  /* Initialize the memory dependence hash table. The number of
-     buckets matters since we scan all entries (and all buckets) on
-     branch misprediction recovery, so we want to keep the number of
-     buckets large enough to avoid collisions but small enough to
-     keep the scan fast. Since the number of entries is roughly at
-     most the number of in-flight stores, we set the number of
-     buckets to the size of instruction window. */
-  init_hash_table(&map_data->oracle_mem_hash, "oracle mem dependence map", NODE_TABLE_SIZE, sizeof(Mem_Map_Entry));
+  /* Allocate the wake up overflow chunk pool. */
+  expand_wake_up_chunks();
 
   /* Init the register renaming table */
   reg_file_init();
@@ -183,18 +134,9 @@ void recover_map() {
   for (ii = 0; ii < NUM_REG_IDS; ii++)
     map_data->map_flags[ii] = FALSE;
   map_data->last_store_flag = FALSE;
-  hash_table_scan(&map_data->oracle_mem_hash, recover_mem_map_entry, NULL);
   rebuild_offpath_map();
 }
 
-/**************************************************************************************/
-/* recover_mem_map_entry: */
-
-void recover_mem_map_entry(void* hash_entry, void* arg) {
-  Mem_Map_Entry* entry = (Mem_Map_Entry*)hash_entry;
-  entry->flag_mask = 0;
-}
-
 /**************************************************************************************/
 /* rebuild_offpath_map: rebuild the offpath half of map structures
    using the sequential op list from a Thread. Make sure you recover
@@ -206,34 +148,31 @@ void rebuild_offpath_map() {
   ASSERT(map_data->proc_id, map_data->proc_id == td->proc_id);
 
   /* First find the oldest offpath op */
-  Op** op_p = (Op**)list_start_head_traversal(&td->seq_op_list);
+  Op** op_p = (Op**)deque_start_head_traversal(&td->seq_op_list);
   while (op_p && !(*op_p)->off_path) {
-    op_p = (Op**)list_next_element(&td->seq_op_list);
+    op_p = (Op**)deque_next_element(&td->seq_op_list);
   }
 
   /* rebuild the map starting with the first offpath op */
-  for (; op_p; op_p = (Op**)list_next_element(&td->seq_op_list)) {
+  for (; op_p; op_p = (Op**)deque_next_element(&td->seq_op_list)) {
     update_map(*op_p);
-    if ((*op_p)->table_info->mem_type == MEM_ST) {
-      update_store_hash(*op_p);
-    }
   }
 }
 
 /**************************************************************************************/
-/* expand_wake_up_pool: */
+/* expand_wake_up_chunks: */
 
-static inline void expand_wake_up_entries() {
-  Wake_Up_Entry* new_pool = (Wake_Up_Entry*)calloc(WAKE_UP_ENTRIES_INC, sizeof(Wake_Up_Entry));
+static inline void expand_wake_up_chunks() {
+  Wake_Up_Chunk* new_pool = (Wake_Up_Chunk*)calloc(WAKE_UP_CHUNKS_INC, sizeof(Wake_Up_Chunk));
   uns ii;
 
-  DEBUGU(map_data->proc_id, "Expanding wake up pool to size %d\n", (map_data->wake_up_entries + WAKE_UP_ENTRIES_INC));
-  for (ii = 0; ii < WAKE_UP_ENTRIES_INC - 1; ii++)
+  DEBUGU(map_data->proc_id, "Expanding wake up pool to size %d\n", (map_data->wake_up_chunks + WAKE_UP_CHUNKS_INC));
+  for (ii = 0; ii < WAKE_UP_CHUNKS_INC - 1; ii++)
     new_pool[ii].next = &new_pool[ii + 1];
   new_pool[ii].next = map_data->free_list_head;
   map_data->free_list_head = &new_pool[0];
-  map_data->wake_up_entries += WAKE_UP_ENTRIES_INC;
-  ASSERT(map_data->proc_id, map_data->wake_up_entries <= WAKE_UP_ENTRIES_INC * 128);
+  map_data->wake_up_chunks += WAKE_UP_CHUNKS_INC;
+  ASSERT(map_data->proc_id, map_data->wake_up_chunks <= WAKE_UP_CHUNKS_INC * 128);
 }
 
 /**************************************************************************************/
@@ -261,9 +200,13 @@ void map_op(Op* op) {
 static inline void read_reg_map(Op* op) {
   uns ii;
 
+  /* an idiom's result does not depend on its sources */
+  if (REG_RENAMING_IDIOM_ELIMINATE && op->table_info->elim_class >= ELIM_ZERO_IDIOM)
+    return;
+
   for (ii = 0; ii < op->table_info->num_src_regs; ii++) {
     uns id = op->inst_info->srcs[ii].id;
-    ASSERT(map_data->proc_id, id < NUM_REG_IDS);
+    ASSERT_CHEAP(map_data->proc_id, id < NUM_REG_IDS);
 
     uns ind = id << 1 | map_data->map_flags[id];
     Map_Entry* map_entry = &map_data->reg_map[ind];
@@ -305,7 +248,7 @@ static inline void update_map(Op* op) {
   /* update the register map if the op produces a value */
   for (ii = 0; ii < op->table_info->num_dest_regs; ii++) {
     uns id = op->inst_info->dests[ii].id;
-    ASSERT(map_data->proc_id, id < NUM_REG_IDS);
+    ASSERT_CHEAP(map_data->proc_id, id < NUM_REG_IDS);
 
     uns ind = id << 1 | op->off_path;
     Map_Entry* map_entry = &map_data->reg_map[ind];
@@ -352,128 +295,20 @@ void map_mem_dep(Op* op) {
   if (!MEM_OBEY_STORE_DEP)
     return;
   if (op->table_info->mem_type == MEM_ST)
-    update_store_hash(op);
+    lsq_map_store(op);
   if (op->table_info->mem_type == MEM_LD)
     add_store_deps(op);
 }
 
 /**************************************************************************************/
-/* map_mem_*_traversal_*: these functions traverse the memory map
-   entries and bytes within those entries given an access with an
-   address and size. */
-
-static inline void mem_map_entry_traversal_init(Mem_Map_Traversal* traversal, Addr va, uns size) {
-  Addr last_va = ADDR_PLUS_OFFSET(va, size - 1);  // last byte in access
-  traversal->first_entry_addr = MEM_MAP_ENTRY_ADDR(va);
-  traversal->last_entry_addr = MEM_MAP_ENTRY_ADDR(last_va);
-  traversal->entry_addr = traversal->first_entry_addr;
-  traversal->first_entry_first_byte = MEM_MAP_BYTE_IN_ENTRY(va);
-  traversal->last_entry_last_byte = MEM_MAP_BYTE_IN_ENTRY(last_va);
-
-  if (0 == size) {
-    // special case - if the size is 0, we shouldn't do a traversal at all, so
-    // force the traversal to be "done"
-    traversal->entry_addr = ADDR_PLUS_OFFSET(traversal->last_entry_addr, MEM_MAP_ENTRY_SIZE);
-    ASSERT(get_proc_id_from_cmp_addr(va), mem_map_entry_traversal_done(traversal));
-  }
-}
-
-static inline Flag mem_map_entry_traversal_done(Mem_Map_Traversal* traversal) {
-  return traversal->entry_addr == ADDR_PLUS_OFFSET(traversal->last_entry_addr, MEM_MAP_ENTRY_SIZE);
-}
-
-static inline void mem_map_entry_traversal_next(Mem_Map_Traversal* traversal) {
-  traversal->entry_addr = ADDR_PLUS_OFFSET(traversal->entry_addr, MEM_MAP_ENTRY_SIZE);
-}
-
-static inline void mem_map_byte_traversal_init(Mem_Map_Traversal* traversal) {
-  traversal->byte = traversal->entry_addr == traversal->first_entry_addr ? traversal->first_entry_first_byte : 0;
-  traversal->last_byte =
-      traversal->entry_addr == traversal->last_entry_addr ? traversal->last_entry_last_byte : MEM_MAP_ENTRY_SIZE - 1;
-  ASSERT(0, traversal->byte <= traversal->last_byte);
-}
-
-static inline Flag mem_map_byte_traversal_done(Mem_Map_Traversal* traversal) {
-  return traversal->byte > traversal->last_byte;
-}
-
-static inline void mem_map_byte_traversal_next(Mem_Map_Traversal* traversal) {
-  traversal->byte++;
-}
-
-/**************************************************************************************/
-/* delete_store_hash_entry */
-
-void delete_store_hash_entry(Op* op) {
-  Addr va = op->oracle_info.va;
-  Mem_Map_Traversal traversal;
-
-  ASSERT(map_data->proc_id, map_data->proc_id == op->proc_id);
-
-  /* Iterate through each entry that was written to by the op */
-  for (mem_map_entry_traversal_init(&traversal, va, op->oracle_info.mem_size);
-       !mem_map_entry_traversal_done(&traversal); mem_map_entry_traversal_next(&traversal)) {
-    Mem_Map_Entry* mem_map_p =
-        (Mem_Map_Entry*)hash_table_access(&map_data->oracle_mem_hash, MEM_MAP_KEY(traversal.entry_addr));
-
-    if (!mem_map_p)
-      continue;
-
-    /* Iterate through each byte written to by the op (within this entry) */
-    for (mem_map_byte_traversal_init(&traversal); !mem_map_byte_traversal_done(&traversal);
-         mem_map_byte_traversal_next(&traversal)) {
-      uns ind = MEM_MAP_BYTE_INDEX(traversal.byte, op->off_path);
-      if (TESTBIT(mem_map_p->store_mask, ind) && mem_map_p->op[ind] == op) {
-        CLRBIT(mem_map_p->store_mask, ind);
-      }
-    }
-    if (!mem_map_p->store_mask) {
-      hash_table_access_delete(&map_data->oracle_mem_hash, MEM_MAP_KEY(traversal.entry_addr));
-    }
-  }
-}
-
-/**************************************************************************************/
-/* add_store_deps: */
+/* add_store_deps: the LSQ store index finds the in-flight stores supplying the
+   bytes read by the load. With MEM_OOO_STORES the load depends on all of them,
+   otherwise only on the youngest one. */
 
 static inline Op* add_store_deps(Op* op) {
-  Addr va = op->oracle_info.va;
-  Op* last_src_op = NULL;
-  uns orig_num_srcs = op->oracle_info.num_srcs;
-  Mem_Map_Traversal traversal;
-
   ASSERT(map_data->proc_id, map_data->proc_id == op->proc_id);
 
-  /* Iterate through each entry that is read by the op */
-  for (mem_map_entry_traversal_init(&traversal, va, op->oracle_info.mem_size);
-       !mem_map_entry_traversal_done(&traversal); mem_map_entry_traversal_next(&traversal)) {
-    Mem_Map_Entry* mem_map_p =
-        (Mem_Map_Entry*)hash_table_access(&map_data->oracle_mem_hash, MEM_MAP_KEY(traversal.entry_addr));
-
-    if (!mem_map_p)
-      continue;
-
-    /* Iterate through each byte read by the op (within this entry) */
-    for (mem_map_byte_traversal_init(&traversal); !mem_map_byte_traversal_done(&traversal);
-         mem_map_byte_traversal_next(&traversal)) {
-      uns ind = MEM_MAP_BYTE_INDEX(traversal.byte, TESTBIT(mem_map_p->flag_mask, traversal.byte));
-      if (!TESTBIT(mem_map_p->store_mask, ind))
-        continue; /* ensure mem_map_p info is valid */
-      Op* src_op = mem_map_p->op[ind];
-      ASSERTM(op->proc_id,
-              BYTE_OVERLAP(src_op->oracle_info.va, src_op->oracle_info.mem_size, va, op->oracle_info.mem_size),
-              "%d@0x%08x and %d@0x%08x\n", src_op->oracle_info.mem_size, (uns32)src_op->oracle_info.va,
-              op->oracle_info.mem_size, (uns32)va);
-      if (MEM_OOO_STORES && !src_op->marked) {
-        add_src_from_op(op, src_op, MEM_DATA_DEP);
-        src_op->marked = TRUE;  // mark op to avoid adding duplicate sources
-        STAT_EVENT(op->proc_id, FORWARDED_LD);
-      }
-      if (!last_src_op || last_src_op->op_num < src_op->op_num) { /* take latest store dependency only */
-        last_src_op = src_op;
-      }
-    }
-  }
+  Op* last_src_op = lsq_find_store_deps(op, MEM_OOO_STORES ? add_store_dep : NULL);
 
   if (!last_src_op) {
     STAT_EVENT(op->proc_id, LD_NO_FORWARD);
@@ -481,13 +316,7 @@ static inline Op* add_store_deps(Op* op) {
   }
 
   ASSERT(op->proc_id, last_src_op->op_num < op->op_num || op->off_path);
-  if (MEM_OOO_STORES) {
-    /* unmark all ops we marked earlier */
-    for (uns ii = orig_num_srcs; ii < op->oracle_info.num_srcs; ii++) {
-      ASSERT(op->proc_id, op->oracle_info.src_info[ii].op->marked);
-      op->oracle_info.src_info[ii].op->marked = FALSE;
-    }
-  } else {
+  if (!MEM_OOO_STORES) {
     add_src_from_op(op, last_src_op, MEM_DATA_DEP);
     STAT_EVENT(op->proc_id, FORWARDED_LD);
   }
@@ -495,43 +324,21 @@ static inline Op* add_store_deps(Op* op) {
 }
 
 /**************************************************************************************/
-/* update_store_hash: */
-
-static inline void update_store_hash(Op* op) {
-  Mem_Map_Entry* mem_map_p;
-  Addr va = op->oracle_info.va;
-  Mem_Map_Traversal traversal;
-
-  ASSERT(map_data->proc_id, map_data->proc_id == op->proc_id);
-
-  /* Iterate through each entry that was written to by the op */
-  for (mem_map_entry_traversal_init(&traversal, va, op->oracle_info.mem_size);
-       !mem_map_entry_traversal_done(&traversal); mem_map_entry_traversal_next(&traversal)) {
-    Flag new_entry = FALSE;
-    mem_map_p = (Mem_Map_Entry*)hash_table_access_create(&map_data->oracle_mem_hash, MEM_MAP_KEY(traversal.entry_addr),
-                                                         &new_entry);
-
-    if (new_entry) {
-      mem_map_p->flag_mask = 0;
-      mem_map_p->store_mask = 0;
-    }
-
-    /* Iterate through each byte written to by the op (within this entry) */
-    for (mem_map_byte_traversal_init(&traversal); !mem_map_byte_traversal_done(&traversal);
-         mem_map_byte_traversal_next(&traversal)) {
-      DEFBIT(mem_map_p->flag_mask, traversal.byte, op->off_path);
-      uns ind = MEM_MAP_BYTE_INDEX(traversal.byte, op->off_path);
-      SETBIT(mem_map_p->store_mask, ind);
-      mem_map_p->op[ind] = op;
-    }
-  }
+/* add_store_dep: */
+
+static void add_store_dep(Op* op, Op* src_op) {
+  ASSERTM(op->proc_id, BYTE_OVERLAP(src_op->oracle_info.va, src_op->oracle_info.mem_size, op->oracle_info.va,
+                                    op->oracle_info.mem_size),
+          "%d@0x%08x and %d@0x%08x\n", src_op->oracle_info.mem_size, (uns32)src_op->oracle_info.va,
+          op->oracle_info.mem_size, (uns32)op->oracle_info.va);
+  add_src_from_op(op, src_op, MEM_DATA_DEP);
+  STAT_EVENT(op->proc_id, FORWARDED_LD);
 }
 
 /**************************************************************************************/
 /* wake_up_ops: */
 
 void wake_up_ops(Op* op, Dep_Type type, void (*wake_action)(Op*, Op*, uns8)) {
-  Wake_Up_Entry* temp;
 
   _DEBUG(op->proc_id, DEBUG_REPLAY, "Waking up ops from src_op:%s unique:%s type:%s\n", unsstr64(op->op_num),
          unsstr64(op->unique_num), dep_type_names[type]);
@@ -542,14 +349,12 @@ void wake_up_ops(Op* op, Dep_Type type, void (*wake_action)(Op*, Op*, uns8)) {
   reg_file_produce(op);
 
   ASSERT(op->proc_id, wake_action);
-  for (temp = op->wake_up_head; temp; temp = temp->next) {
+  FOR_EACH_WAKE_UP_ENTRY(&op->wake_up[type], temp) {
     Op* dep_op = temp->op;
     Counter dep_unique_num = temp->unique_num;
 
     ASSERT(op->proc_id, dep_op);
 
-    if (temp->dep_type != type)
-      continue;
     /* if the stored unique num is not the same as the op pool entry, the op has
            been reclaimed and the wake up should be ignored */
     if (dep_op->unique_num == dep_unique_num && dep_op->op_pool_valid) {
@@ -594,40 +399,46 @@ void add_to_wake_up_lists(Op* op, Op_Info* op_info, void (*wake_action)(Op*, Op*
         src_op->unique_num == src_info->unique_num) {
       /* make sure the source op is still in the machine */
       /* add to the src op's wake up list regardless of whether it has already produced a result or not */
+      Wake_Up_List* list = &src_op->wake_up[src_info->type];
+      Wake_Up_Chunk* chunk;
       Wake_Up_Entry* wake;
 
       ASSERTM(op->proc_id, op->proc_id == src_op->proc_id,
               "op num: %llu fetch: %llu, src_op num: %llu unique: %llu fetch: %llu\n", op->op_num, op->fetch_cycle,
               src_op->op_num, src_op->unique_num, src_op->fetch_cycle);
 
-      if (map_data->free_list_head == NULL) {
-        ASSERT(map_data->proc_id, map_data->active_wake_up_entries == map_data->wake_up_entries);
-        expand_wake_up_entries();
-      }
-
       if (src_info->type == MEM_DATA_DEP)
         dep_on_in_window_store = TRUE;
 
-      wake = map_data->free_list_head;
+      /* append to the last chunk, taking a new overflow chunk once it is full */
+      if (list->count < WAKE_UP_CHUNK_ENTRIES) {
+        chunk = &list->head;
+      } else if (list->count % WAKE_UP_CHUNK_ENTRIES == 0) {
+        if (map_data->free_list_head == NULL)
+          expand_wake_up_chunks();
+        chunk = map_data->free_list_head;
+        map_data->free_list_head = chunk->next;
+        chunk->next = NULL;
+        if (list->tail)
+          list->tail->next = chunk;
+        else
+          list->head.next = chunk;
+        list->tail = chunk;
+      } else {
+        chunk = list->tail;
+      }
+      wake = &chunk->entries[list->count % WAKE_UP_CHUNK_ENTRIES];
+      list->count++;
+
       map_data->active_wake_up_entries++;
-      map_data->free_list_head = wake->next;
+      if (map_data->active_wake_up_entries > map_data->peak_wake_up_entries) {
+        STAT_EVENT(map_data->proc_id, WAKE_UP_ENTRIES_PEAK);
+        map_data->peak_wake_up_entries = map_data->active_wake_up_entries;
+      }
 
       wake->op = op;
       wake->unique_num = op->unique_num;
-      wake->dep_type = src_info->type;
       wake->rdy_bit = ii;
-      wake->next = NULL;
-
-      if (src_op->wake_up_tail == NULL) {
-        src_op->wake_up_head = wake;
-        src_op->wake_up_tail = wake;
-        src_op->wake_up_count = 1;
-      } else {
-        ASSERT(map_data->proc_id, src_op->wake_up_head);
-        src_op->wake_up_tail->next = wake;
-        src_op->wake_up_tail = wake;
-        src_op->wake_up_count++;
-      }
 
       if (TRACK_L1_MISS_DEPS) {
         // An op can occupy multiple entries in the wakeup list of another op
@@ -660,18 +471,36 @@ void free_wake_up_list(Op* op) {
   ASSERT(map_data->proc_id, op);
   ASSERT(map_data->proc_id, op->proc_id == map_data->proc_id);
 
-  if (op->wake_up_tail) {
-    ASSERT(map_data->proc_id, op->wake_up_head);
+  if (op_has_wake_ups(op)) {
     DEBUG(map_data->proc_id, "Freeing wake up list for op_num:%s\n", unsstr64(op->op_num));
-    op->wake_up_tail->next = map_data->free_list_head;
-    map_data->free_list_head = op->wake_up_head;
-    map_data->active_wake_up_entries -= op->wake_up_count;
-    ASSERT(map_data->proc_id, map_data->active_wake_up_entries >= 0);
-    op->wake_up_head = NULL;
-    op->wake_up_tail = NULL;
   } else {
     DEBUG(map_data->proc_id, "No wake up list for op_num:%s\n", unsstr64(op->op_num));
   }
+
+  for (uns type = 0; type < NUM_DEP_TYPES; type++) {
+    Wake_Up_List* list = &op->wake_up[type];
+    if (list->tail) {
+      ASSERT(map_data->proc_id, list->head.next);
+      list->tail->next = map_data->free_list_head;
+      map_data->free_list_head = list->head.next;
+      list->head.next = NULL;
+      list->tail = NULL;
+    }
+    ASSERT(map_data->proc_id, map_data->active_wake_up_entries >= list->count);
+    map_data->active_wake_up_entries -= list->count;
+    list->count = 0;
+  }
+}
+
+/**************************************************************************************/
+/* op_has_wake_ups: does any op depend on this one? */
+
+Flag op_has_wake_ups(Op* op) {
+  for (uns type = 0; type < NUM_DEP_TYPES; type++) {
+    if (op->wake_up[type].count)
+      return TRUE;
+  }
+  return FALSE;
 }
 
 /**************************************************************************************/
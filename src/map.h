@@ -30,11 +30,22 @@
 #define __MAP_H__
 
 #include "isa/isa_macros.h"
-#include "libs/hash_lib.h"
 
 #include "map_rename.h"
 #include "op.h"
 
+/**************************************************************************************/
+/* Macros */
+
+/* Visits the entries of a Wake_Up_List in insertion order, walking each chunk as a plain array. The body must not
+ * break out of the loop. */
+#define FOR_EACH_WAKE_UP_ENTRY(list, entry)                                                                 \
+  for (uns _wake_ii = 0, _wake_count = (list)->count; _wake_ii < _wake_count; _wake_ii = _wake_count)      \
+    for (Wake_Up_Chunk* _wake_chunk = &(list)->head; _wake_ii < _wake_count; _wake_chunk = _wake_chunk->next) \
+      for (Wake_Up_Entry *entry = _wake_chunk->entries,                                                     \
+                         *_wake_end = entry + MIN2(_wake_count - _wake_ii, WAKE_UP_CHUNK_ENTRIES);          \
+           entry < _wake_end; entry++, _wake_ii++)
+
 /**************************************************************************************/
 /* Types */
 
@@ -53,11 +64,10 @@ typedef struct Map_Data_struct {
   Map_Entry last_store[2];
   Flag last_store_flag;
 
-  Hash_Table oracle_mem_hash;
-
-  Wake_Up_Entry* free_list_head;
-  uns wake_up_entries;
+  Wake_Up_Chunk* free_list_head;  // free overflow chunks for wake up lists
+  uns wake_up_chunks;
   uns active_wake_up_entries;
+  uns peak_wake_up_entries;
 
   /* register files for INT/FP with arch/physical tables */
   Reg_File* reg_file[REG_FILE_REG_TYPE_NUM];
@@ -66,7 +76,7 @@ typedef struct Map_Data_struct {
 /**************************************************************************************/
 /* External Variables */
 
-extern Map_Data* map_data;
+extern CORE_LOCAL Map_Data* map_data;
 
 /**************************************************************************************/
 /* Prototypes */
@@ -80,13 +90,13 @@ void map_op(Op*);
 void map_mem_dep(Op*);
 void wake_up_ops(Op*, Dep_Type, void (*)(Op*, Op*, uns8));
 void free_wake_up_list(Op*);
+Flag op_has_wake_ups(Op*);
 void add_to_wake_up_lists(Op*, Op_Info*, void (*)(Op*, Op*, uns8));
 
 void add_src_from_op(Op*, Op*, Dep_Type);
 void add_src_from_map_entry(Op*, Map_Entry*, Dep_Type);
 
 void simple_wake(Op*, Op*, uns8);
-void delete_store_hash_entry(Op*);
 
 void clear_not_rdy_bit(Op*, uns);
 Flag test_not_rdy_bit(Op*, uns);
@@ -49,7 +49,7 @@
 /**************************************************************************************/
 /* Extern Definition */
 
-struct reg_file **reg_file;
+CORE_LOCAL struct reg_file **reg_file;
 
 extern Op invalid_op;
 
@@ -63,6 +63,10 @@ void reg_free_list_init(struct reg_free_list *reg_free_list);
 void reg_free_list_free(struct reg_free_list *reg_free_list, struct reg_table_entry *entry);
 struct reg_table_entry *reg_free_list_alloc(struct reg_free_list *reg_free_list);
 
+void reg_free_list_fifo_init(struct reg_free_list *reg_free_list);
+void reg_free_list_fifo_free(struct reg_free_list *reg_free_list, struct reg_table_entry *entry);
+struct reg_table_entry *reg_free_list_fifo_alloc(struct reg_free_list *reg_free_list);
+
 // register entry operations
 void reg_table_entry_clear(struct reg_table_entry *entry);
 void reg_table_entry_read(struct reg_table_entry *entry, Op *op);
@@ -162,6 +166,16 @@ static inline Flag reg_file_check_reg_num(uns reg_table_type, uns op_count) {
   return TRUE;
 }
 
+// set all register ids of an op to REG_TABLE_REG_ID_INVALID (-1, i.e. all bytes 0xff), once per op
+static inline void reg_file_setup_op_reg_ids(Op *op) {
+  if (op->reg_ids_valid)
+    return;
+  memset(op->src_reg_id, 0xff, sizeof(op->src_reg_id));
+  memset(op->dst_reg_id, 0xff, sizeof(op->dst_reg_id));
+  memset(op->prev_dst_reg_id, 0xff, sizeof(op->prev_dst_reg_id));
+  op->reg_ids_valid = TRUE;
+}
+
 // extract the valid architectural register id into the op from inst info
 static inline void reg_file_extract_arch_reg_id(Op *op) {
   ASSERT(op->proc_id, op != &invalid_op);
@@ -278,7 +292,7 @@ static inline void reg_file_collect_released_entry_stat(struct reg_table_entry *
 /* move elimination:
  *    The destination register of an instruction can be renamed to the same physical register as the source
  *    if all the bellow conditions are met:
- *    - The instruction is a register-to-register move (e.g., XED_ICLASS_MOV)
+ *    - The instruction is a register-to-register move (ELIM_MOVE, see iclass_elim_class in uop_generator.c)
  *    - It has exactly one source and one destination
  *    - Both source and destination operands are general-purpose or SIMD registers
  *    - There is no memory access involved (i.e., no load or store)
@@ -286,24 +300,6 @@ static inline void reg_file_collect_released_entry_stat(struct reg_table_entry *
  *    - The move has no side effects (e.g., it does not update flags)
  */
 
-uns16 MOVE_ELIMINATION_OP_CODE[] = {
-    XED_ICLASS_MOV,
-};
-#define NUM_MOVE_ELIM_OP_CODES (sizeof(MOVE_ELIMINATION_OP_CODE) / sizeof(MOVE_ELIMINATION_OP_CODE[0]))
-
-static inline Flag reg_file_check_move_elim_candidate(uns16 op_code) {
-  ASSERT(map_data->proc_id, REG_RENAMING_MOVE_ELIMINATE);
-
-  // TODO: use hashmap when increasing op_code candidates
-  for (int ii = 0; ii < NUM_MOVE_ELIM_OP_CODES; ii++) {
-    if (op_code == MOVE_ELIMINATION_OP_CODE[ii]) {
-      return TRUE;
-    }
-  }
-
-  return FALSE;
-}
-
 static inline Flag reg_file_check_same_reg_width(int src_reg_id, int dst_reg_id) {
   ASSERT(map_data->proc_id, REG_RENAMING_MOVE_ELIMINATE);
 
@@ -319,7 +315,7 @@ static inline Flag reg_file_check_same_reg_width(int src_reg_id, int dst_reg_id)
 }
 
 static inline void reg_file_move_eliminate(Op *op) {
-  if (!REG_RENAMING_MOVE_ELIMINATE)
+  if (!REG_RENAMING_MOVE_ELIMINATE || op->table_info->elim_class != ELIM_MOVE)
     return;
 
   if (op->table_info->mem_type)
@@ -339,13 +335,24 @@ static inline void reg_file_move_eliminate(Op *op) {
   if (!reg_file_check_same_reg_width(src_reg_id, dst_reg_id))
     return;
 
-  if (!reg_file_check_move_elim_candidate(op->inst_info->table_info->true_op_type))
-    return;
-
   op->move_eliminated = TRUE;
   STAT_EVENT(map_data->proc_id, MAP_STAGE_RENAME_MOVE_ELIM_ONPATH + op->off_path);
 }
 
+/* idiom elimination:
+ *    Zero and dependency-breaking idioms produce a constant, so the map stage does not make them wait on their
+ *    sources (see read_reg_map in map.c). Their destination is still renamed and written as usual.
+ */
+static inline void reg_file_idiom_eliminate(Op *op) {
+  if (!REG_RENAMING_IDIOM_ELIMINATE)
+    return;
+
+  if (op->table_info->elim_class == ELIM_ZERO_IDIOM)
+    STAT_EVENT(map_data->proc_id, MAP_STAGE_RENAME_ZERO_IDIOM_ONPATH + op->off_path);
+  else if (op->table_info->elim_class == ELIM_DEP_BREAK_IDIOM)
+    STAT_EVENT(map_data->proc_id, MAP_STAGE_RENAME_DEP_BREAK_IDIOM_ONPATH + op->off_path);
+}
+
 /**************************************************************************************/
 /* reg file operation functions for all register schemes */
 
@@ -546,8 +553,9 @@ static inline void reg_file_release_prev(Op *op, int *reg_table_types, int reg_t
 static inline void reg_file_init_checkpoint() {
   for (uns ii = 0; ii < REG_FILE_REG_TYPE_NUM; ++ii) {
     reg_file[ii]->reg_checkpoint = (struct reg_checkpoint *)malloc(sizeof(struct reg_checkpoint));
-    reg_file[ii]->reg_checkpoint->entries = (struct reg_table_entry *)malloc(
-        sizeof(struct reg_table_entry) * reg_file[ii]->reg_table[REG_TABLE_TYPE_ARCHITECTURAL]->size);
+    reg_file[ii]->reg_checkpoint->child_reg_ids =
+        (int *)malloc(sizeof(int) * reg_file[ii]->reg_table[REG_TABLE_TYPE_ARCHITECTURAL]->size);
+    reg_file[ii]->reg_checkpoint->free_list_alloc_count = 0;
     reg_file[ii]->reg_checkpoint->is_valid = FALSE;
   }
 }
@@ -556,12 +564,17 @@ static inline void reg_file_init_checkpoint() {
   Scarab currently does not support early flushes and will only trigger a flush if the
   oldest mispredicted branch is resolved
   Therefore, only maintain one checkpoint of that mispredicted branch for recovering SRT
+  Only the arch-to-child mapping changes during renaming, so only that array is copied
 */
 static inline void reg_file_snapshot_srt() {
   for (uns ii = 0; ii < REG_FILE_REG_TYPE_NUM; ++ii) {
     struct reg_table *srt = reg_file[ii]->reg_table[REG_TABLE_TYPE_ARCHITECTURAL];
     struct reg_checkpoint *checkpoint = reg_file[ii]->reg_checkpoint;
-    memcpy(checkpoint->entries, srt->entries, sizeof(struct reg_table_entry) * srt->size);
+    for (uns jj = 0; jj < srt->size; ++jj)
+      checkpoint->child_reg_ids[jj] = srt->entries[jj].child_reg_id;
+
+    if (REG_RENAMING_BULK_RECOVERY)
+      checkpoint->free_list_alloc_count = reg_file[ii]->reg_table[REG_TABLE_TYPE_PHYSICAL]->free_list->fifo_alloc_count;
 
     ASSERT(map_data->proc_id, !checkpoint->is_valid);
     checkpoint->is_valid = TRUE;
@@ -578,13 +591,32 @@ static inline void reg_file_rollback_srt() {
   for (uns ii = 0; ii < REG_FILE_REG_TYPE_NUM; ++ii) {
     struct reg_table *srt = reg_file[ii]->reg_table[REG_TABLE_TYPE_ARCHITECTURAL];
     struct reg_checkpoint *checkpoint = reg_file[ii]->reg_checkpoint;
-    memcpy(srt->entries, checkpoint->entries, sizeof(struct reg_table_entry) * srt->size);
+    for (uns jj = 0; jj < srt->size; ++jj)
+      srt->entries[jj].child_reg_id = checkpoint->child_reg_ids[jj];
 
     ASSERT(map_data->proc_id, checkpoint->is_valid);
     checkpoint->is_valid = FALSE;
   }
 }
 
+/*
+  Every register allocated after the checkpoint belongs to a flushed op, and the only
+  registers freed since then are pushed behind them at the tail of the fifo by retiring
+  ops. Moving the head back to the checkpoint releases all of them at once, the stale
+  entries are cleared lazily when they are allocated again
+*/
+static inline void reg_file_rollback_free_list() {
+  for (uns ii = 0; ii < REG_FILE_REG_TYPE_NUM; ++ii) {
+    struct reg_free_list *free_list = reg_file[ii]->reg_table[REG_TABLE_TYPE_PHYSICAL]->free_list;
+    struct reg_checkpoint *checkpoint = reg_file[ii]->reg_checkpoint;
+    ASSERT(map_data->proc_id, free_list->fifo_alloc_count >= checkpoint->free_list_alloc_count);
+
+    free_list->reg_free_num += free_list->fifo_alloc_count - checkpoint->free_list_alloc_count;
+    free_list->fifo_alloc_count = checkpoint->free_list_alloc_count;
+    ASSERT(map_data->proc_id, free_list->reg_free_num <= free_list->fifo_size);
+  }
+}
+
 /**************************************************************************************/
 /* register free list operation */
 
@@ -622,6 +654,47 @@ struct reg_free_list_ops reg_free_list_ops = {
     .alloc = reg_free_list_alloc,
 };
 
+void reg_free_list_fifo_init(struct reg_free_list *reg_free_list) {
+  ASSERT(map_data->proc_id, reg_free_list != NULL && reg_free_list->fifo_size > 0);
+
+  reg_free_list->reg_free_num = 0;
+  reg_free_list->reg_free_list_head = NULL;
+  reg_free_list->fifo = (struct reg_table_entry **)calloc(reg_free_list->fifo_size, sizeof(struct reg_table_entry *));
+  reg_free_list->fifo_alloc_count = 0;
+}
+
+/* push the entry to the tail of the free list */
+void reg_free_list_fifo_free(struct reg_free_list *reg_free_list, struct reg_table_entry *entry) {
+  ASSERT(map_data->proc_id, reg_free_list != NULL && reg_free_list->reg_free_num < reg_free_list->fifo_size);
+
+  Counter tail = reg_free_list->fifo_alloc_count + reg_free_list->reg_free_num;
+  reg_free_list->fifo[tail % reg_free_list->fifo_size] = entry;
+  ++reg_free_list->reg_free_num;
+}
+
+/* pop the entry from the head of the free list */
+struct reg_table_entry *reg_free_list_fifo_alloc(struct reg_free_list *reg_free_list) {
+  ASSERT(map_data->proc_id, reg_free_list != NULL && reg_free_list->reg_free_num > 0);
+
+  struct reg_table_entry *entry = reg_free_list->fifo[reg_free_list->fifo_alloc_count % reg_free_list->fifo_size];
+  ++reg_free_list->fifo_alloc_count;
+  --reg_free_list->reg_free_num;
+
+  // the entry of a flushed op is released by bulk recovery without being cleared
+  if (entry->reg_state != REG_TABLE_ENTRY_STATE_FREE) {
+    ASSERT(map_data->proc_id, entry->off_path);
+    entry->ops->clear(entry);
+  }
+
+  return entry;
+}
+
+struct reg_free_list_ops reg_free_list_fifo_ops = {
+    .init = reg_free_list_fifo_init,
+    .free = reg_free_list_fifo_free,
+    .alloc = reg_free_list_fifo_alloc,
+};
+
 /**************************************************************************************/
 /* register entry operation */
 
@@ -762,7 +835,9 @@ void reg_table_init(struct reg_table *reg_table, struct reg_table *parent_reg_ta
   reg_table->parent_reg_table = parent_reg_table;
 
   reg_table->free_list = (struct reg_free_list *)malloc(sizeof(struct reg_free_list));
-  reg_table->free_list->ops = &reg_free_list_ops;
+  reg_table->free_list->ops = REG_RENAMING_BULK_RECOVERY ? &reg_free_list_fifo_ops : &reg_free_list_ops;
+  reg_table->free_list->fifo = NULL;
+  reg_table->free_list->fifo_size = reg_table_size;
   reg_table->free_list->ops->init(reg_table->free_list);
 
   reg_table->reg_type = reg_type;
@@ -1043,10 +1118,16 @@ void reg_renaming_scheme_realistic_recover(Op *op) {
   // rollback to the status that does not contain any off_path entries
   reg_file_rollback_srt();
 
+  // release all the registers allocated after the checkpoint at once
+  if (REG_RENAMING_BULK_RECOVERY) {
+    reg_file_rollback_free_list();
+    return;
+  }
+
   // release the registers from the youngest to the flush point
   int reg_table_types[] = {REG_TABLE_TYPE_PHYSICAL};
-  for (Op **op_p = (Op **)list_start_tail_traversal(&td->seq_op_list); op_p && (*op_p)->op_num > op->op_num;
-       op_p = (Op **)list_prev_element(&td->seq_op_list)) {
+  for (Op **op_p = (Op **)deque_start_tail_traversal(&td->seq_op_list); op_p && (*op_p)->op_num > op->op_num;
+       op_p = (Op **)deque_prev_element(&td->seq_op_list)) {
     reg_file_flush_mispredict(*op_p, reg_table_types, sizeof(reg_table_types) / sizeof(reg_table_types[0]));
   }
 }
@@ -1194,8 +1275,8 @@ void reg_renaming_scheme_late_allocation_recover(Op *op) {
 
   // release the registers from the youngest to the flush point for both register tables
   int reg_table_types[] = {REG_TABLE_TYPE_VIRTUAL, REG_TABLE_TYPE_PHYSICAL};
-  for (Op **op_p = (Op **)list_start_tail_traversal(&td->seq_op_list); op_p && (*op_p)->op_num > op->op_num;
-       op_p = (Op **)list_prev_element(&td->seq_op_list)) {
+  for (Op **op_p = (Op **)deque_start_tail_traversal(&td->seq_op_list); op_p && (*op_p)->op_num > op->op_num;
+       op_p = (Op **)deque_prev_element(&td->seq_op_list)) {
     reg_file_flush_mispredict(*op_p, reg_table_types, sizeof(reg_table_types) / sizeof(reg_table_types[0]));
   }
 }
@@ -1819,6 +1900,10 @@ struct reg_renaming_scheme_func reg_renaming_scheme_func_table[REG_RENAMING_SCHE
 void reg_file_init(void) {
   ASSERT(map_data->proc_id,
          REG_RENAMING_SCHEME >= REG_RENAMING_SCHEME_INFINITE && REG_RENAMING_SCHEME < REG_RENAMING_SCHEME_NUM);
+  ASSERTM(map_data->proc_id,
+          !REG_RENAMING_BULK_RECOVERY ||
+              (REG_RENAMING_SCHEME == REG_RENAMING_SCHEME_REALISTIC && !REG_RENAMING_MOVE_ELIMINATE),
+          "Bulk rename recovery requires the realistic scheme without move elimination\n");
   reg_file = map_data->reg_file;
   reg_renaming_scheme_func_table[REG_RENAMING_SCHEME].init();
 }
@@ -1847,12 +1932,15 @@ void reg_file_rename(Op *op) {
   ASSERT(map_data->proc_id,
          REG_RENAMING_SCHEME >= REG_RENAMING_SCHEME_INFINITE && REG_RENAMING_SCHEME < REG_RENAMING_SCHEME_NUM);
   reg_file = map_data->reg_file;
+  // a no-op if a recovery resolved at decode already set the ids up
+  reg_file_setup_op_reg_ids(op);
 
   // update the arch register id in the op for child tables processing
   reg_file_extract_arch_reg_id(op);
 
-  // check if the op can be move eliminated before inlining
+  // check if the op can be move or idiom eliminated before inlining
   reg_file_move_eliminate(op);
+  reg_file_idiom_eliminate(op);
 
   // allocate physical registers
   reg_renaming_scheme_func_table[REG_RENAMING_SCHEME].rename(op);
@@ -1869,6 +1957,8 @@ void reg_file_rename(Op *op) {
 Flag reg_file_issue(Op *op) {
   ASSERT(map_data->proc_id,
          REG_RENAMING_SCHEME >= REG_RENAMING_SCHEME_INFINITE && REG_RENAMING_SCHEME < REG_RENAMING_SCHEME_NUM);
+  // op is NULL for an exec slot whose FU is busy with nothing new to latch
+  ASSERT(map_data->proc_id, !op || op->reg_ids_valid);
   reg_file = map_data->reg_file;
   return reg_renaming_scheme_func_table[REG_RENAMING_SCHEME].issue(op);
 }
@@ -1882,6 +1972,7 @@ Flag reg_file_issue(Op *op) {
 void reg_file_consume(Op *op) {
   ASSERT(map_data->proc_id,
          REG_RENAMING_SCHEME >= REG_RENAMING_SCHEME_INFINITE && REG_RENAMING_SCHEME < REG_RENAMING_SCHEME_NUM);
+  ASSERT(map_data->proc_id, op->reg_ids_valid);
   reg_file = map_data->reg_file;
   reg_renaming_scheme_func_table[REG_RENAMING_SCHEME].consume(op);
 }
@@ -1895,6 +1986,7 @@ void reg_file_consume(Op *op) {
 void reg_file_produce(Op *op) {
   ASSERT(map_data->proc_id,
          REG_RENAMING_SCHEME >= REG_RENAMING_SCHEME_INFINITE && REG_RENAMING_SCHEME < REG_RENAMING_SCHEME_NUM);
+  ASSERT(map_data->proc_id, op->reg_ids_valid);
   reg_file = map_data->reg_file;
   reg_renaming_scheme_func_table[REG_RENAMING_SCHEME].produce(op);
 }
@@ -1908,6 +2000,8 @@ void reg_file_produce(Op *op) {
 void reg_file_recover(Op *op) {
   ASSERT(map_data->proc_id,
          REG_RENAMING_SCHEME >= REG_RENAMING_SCHEME_INFINITE && REG_RENAMING_SCHEME < REG_RENAMING_SCHEME_NUM);
+  // the recovery op may have been resolved at decode, before it was renamed
+  reg_file_setup_op_reg_ids(op);
   reg_file = map_data->reg_file;
   reg_renaming_scheme_func_table[REG_RENAMING_SCHEME].recover(op);
 }
@@ -1921,6 +2015,7 @@ void reg_file_recover(Op *op) {
 void reg_file_precommit(Op *op) {
   ASSERT(map_data->proc_id,
          REG_RENAMING_SCHEME >= REG_RENAMING_SCHEME_INFINITE && REG_RENAMING_SCHEME < REG_RENAMING_SCHEME_NUM);
+  ASSERT(map_data->proc_id, op->reg_ids_valid);
   reg_file = map_data->reg_file;
   reg_renaming_scheme_func_table[REG_RENAMING_SCHEME].precommit(op);
 }
@@ -1934,6 +2029,7 @@ void reg_file_precommit(Op *op) {
 void reg_file_commit(Op *op) {
   ASSERT(map_data->proc_id,
          REG_RENAMING_SCHEME >= REG_RENAMING_SCHEME_INFINITE && REG_RENAMING_SCHEME < REG_RENAMING_SCHEME_NUM);
+  ASSERT(map_data->proc_id, op->reg_ids_valid);
   reg_file = map_data->reg_file;
   reg_renaming_scheme_func_table[REG_RENAMING_SCHEME].commit(op);
 }
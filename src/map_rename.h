@@ -138,6 +138,11 @@ struct reg_free_list {
   struct reg_table_entry *reg_free_list_head;
   uns reg_free_num;
 
+  // fifo implementation for free list (bulk recovery restores the head from a checkpoint)
+  struct reg_table_entry **fifo;
+  uns fifo_size;
+  Counter fifo_alloc_count;  // the number of pops, the head is fifo_alloc_count % fifo_size
+
   // free list operation
   struct reg_free_list_ops *ops;
 };
@@ -165,8 +170,11 @@ struct reg_checkpoint {
   // metadata for validation of the special checkpoint mechanism in Scarab
   Flag is_valid;
 
-  // only map on-path op for recovery
-  struct reg_table_entry *entries;
+  // only map on-path op for recovery (the child reg id of each architectural register)
+  int *child_reg_ids;
+
+  // the physical free list head at the checkpoint for bulk recovery
+  Counter free_list_alloc_count;
 };
 
 struct reg_file {
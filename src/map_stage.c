@@ -62,10 +62,10 @@
 /**************************************************************************************/
 /* Global Variables */
 
-Map_Stage* map = NULL;
+CORE_LOCAL Map_Stage* map = NULL;
 
-int map_off_path = 0;
-Counter map_stage_next_op_num = 1;
+CORE_LOCAL int map_off_path = 0;
+CORE_LOCAL Counter map_stage_next_op_num = 1;
 /* The next op number is used when deciding whether to consume ops from the uop
  * cache: i.e. check if any preceding instructions are still in the decoder. */
 
@@ -90,7 +90,7 @@ void init_map_stage(uns8 proc_id, const char* name) {
   char tmp_name[MAX_STR_LENGTH + 1];
   uns ii;
   ASSERT(proc_id, map);
-  ASSERT(proc_id, STAGE_MAX_DEPTH > 0);
+  ASSERT(proc_id, STAGE_MAX_DEPTH > 0 && STAGE_MAX_DEPTH <= STAGE_LATCHES_MAX_DEPTH);
   DEBUG(proc_id, "Initializing %s stage\n", name);
 
   memset(map, 0, sizeof(Map_Stage));
@@ -186,21 +186,18 @@ void update_map_stage(Stage_Data* src_sd) {
   Flag starved = (src_sd->op_count == 0);
   map_stage_collect_stat(stall, starved);
 
-  /* do all the intermediate stages */
-  for (int ii = 0; ii < STAGE_MAX_DEPTH - 1; ii++) {
-    Stage_Data* cur = &map->sds[ii];
-    Stage_Data* prev = &map->sds[ii + 1];
-
-    if (cur->op_count)
-      continue;
-
-    Op** temp = cur->ops;
-    cur->ops = prev->ops;
-    prev->ops = temp;
-    cur->op_count = prev->op_count;
-    prev->op_count = 0;
+  /* an empty pipeline with nothing to take, or a stalled one in which no op
+     can move, would go through the steps below without changing anything */
+  uns64 occupied = stage_latches_occupancy(map->sds, STAGE_MAX_DEPTH);
+  Flag first_free = !(occupied >> (STAGE_MAX_DEPTH - 1));
+  if ((!occupied || (stall && stage_latches_packed(occupied))) && !(first_free && !starved)) {
+    STAT_EVENT(map->proc_id, MAP_STAGE_SKIPPED);
+    return;
   }
 
+  /* do all the intermediate stages */
+  stage_latches_shift(map->sds, STAGE_MAX_DEPTH, occupied);
+
   /* do the first map stage */
   if (map->sds[STAGE_MAX_DEPTH - 1].op_count == 0 && !starved) {
     map_stage_fetch_op(src_sd);
@@ -219,6 +216,25 @@ void update_map_stage(Stage_Data* src_sd) {
   }
 }
 
+/**************************************************************************************/
+/* map_stage_next_event_cycle: the map pipeline is frozen while the register
+ * file is full, or when its last stage is stalled, no ops can move up into an
+ * empty stage and none can be taken from src_sd */
+
+Counter map_stage_next_event_cycle(Stage_Data* src_sd) {
+  if (!reg_file_available(STAGE_MAX_OP_COUNT))
+    return MAX_CTR;
+  if (map->last_sd->op_count == 0)
+    return cycle_count + 1;
+  for (int ii = 0; ii < STAGE_MAX_DEPTH - 1; ii++) {
+    if (map->sds[ii].op_count == 0 && map->sds[ii + 1].op_count)
+      return cycle_count + 1;
+  }
+  if (map->sds[STAGE_MAX_DEPTH - 1].op_count == 0 && src_sd->op_count)
+    return cycle_count + 1;
+  return MAX_CTR;
+}
+
 /**************************************************************************************/
 /* Local methods */
 
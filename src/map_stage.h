@@ -46,7 +46,7 @@ typedef struct Map_Stage_struct {
 /**************************************************************************************/
 /* External Variables */
 
-extern Map_Stage* map;
+extern CORE_LOCAL Map_Stage* map;
 
 /**************************************************************************************/
 /* prototypes */
@@ -58,6 +58,7 @@ void reset_map_stage(void);
 void recover_map_stage(void);
 void debug_map_stage(void);
 void update_map_stage(Stage_Data*);
+Counter map_stage_next_event_cycle(Stage_Data*);
 
 /**************************************************************************************/
 
@@ -29,6 +29,8 @@
 #include "memory/cache_part.h"
 
 #include <math.h>
+#include <pthread.h>
+#include <string.h>
 
 #include "globals/assert.h"
 #include "globals/global_types.h"
@@ -36,6 +38,7 @@
 #include "debug/debug_macros.h"
 
 #include "core.param.h"
+#include "freq.h"
 #include "memory/memory.param.h"
 
 #include "libs/cache_lib.h"
@@ -55,12 +58,22 @@
 /* Types */
 
 typedef struct Proc_Info_struct {
-  Cache shadow_cache;
+  Cache shadow_cache;  // the sampled sets only, see shadow_addr
   double* miss_rates;  // indexed by number of ways - 1
+  // L1_SHADOW_SAMPLE_CHECK: unsampled shadow tags and their hits per stack
+  // position this epoch, to measure the sampling error
+  Cache full_shadow_cache;
+  Counter* full_hits;
+  Counter full_accesses;
+  // copied from stat_mon with the miss curves, so that a search running on the
+  // helper thread never reads counters the simulation is still updating
+  double accesses;
+  double stall_frac;
 } Proc_Info;
 
 typedef struct Shadow_Cache_Data_struct {
   Flag prefetched;
+  Counter fetch_cycle; /* L1 cycle the line becomes usable, see L1_PART_FILL_DELAY */
 } Shadow_Cache_Data;
 
 typedef double (*Metric_Func)(uns*);
@@ -81,6 +94,15 @@ uns* new_partition;      // pre-allocated structure for new partition
 uns* temp_partition;     // pre-allocated structure for partition exploration
 uns tie_breaker_proc_id;
 
+// L1_PART_ASYNC_DELAY: search running on the helper thread and the L1 cycle at
+// which its result is applied
+static pthread_t search_thread;
+static Flag search_pending;
+static Counter search_apply_cycle;
+
+static uns l1_set_bits;         // set bits of the whole L1 as the shadow tags index it
+static uns shadow_sample_bits;  // LOG2(L1_SHADOW_TAGS_MODULO)
+
 /**************************************************************************************/
 /* Enums */
 
@@ -90,7 +112,9 @@ DEFINE_ENUM(Cache_Part_Search, CACHE_PART_SEARCH_LIST);
 /**************************************************************************************/
 /* Local Prototypes */
 
-static Flag in_shadow_cache(Addr addr);
+static Flag shadow_addr(Addr addr, Addr* shadow);
+static int shadow_cache_access(Cache* cache, Mem_Req* req, Addr addr, Flag* untimely_hit);
+static void measure_sample_error(Proc_Info* proc_info, uns proc_id);
 static double get_global_miss_rate(uns* partition);
 static double get_miss_rate_sum(uns* partition);
 static double get_gmean_perf(uns* partition);
@@ -99,6 +123,8 @@ static void measure_miss_curves(void);
 static void search_lookahead(void);
 static void search_bruteforce(void);
 static void set_partition(void);
+static void* search_main(void* arg);
+static void finish_search(void);
 static void debug_cache_part(uns* old_partition, uns* new_partition);
 
 /**
@@ -113,16 +139,26 @@ void cache_part_init(void) {
   ASSERTM(0, !PRIVATE_L1, "Cache partitioning works only on shared cache.\n");
   ASSERT(0, L1_CACHE_REPL_POLICY == REPL_PARTITION);
   ASSERT(0, L1_ASSOC <= 128);
+  l1_set_bits = LOG2(L1_SIZE / L1_LINE_SIZE / L1_ASSOC);
+  shadow_sample_bits = LOG2(L1_SHADOW_TAGS_MODULO);
+  ASSERTM(0, L1_SHADOW_TAGS_MODULO == 1U << shadow_sample_bits && shadow_sample_bits <= l1_set_bits,
+          "L1_SHADOW_TAGS_MODULO must be a power of 2 no larger than the L1 set count\n");
 
-  // create shadow cache for each core
+  // create shadow cache for each core, holding only the sampled sets
   proc_infos = calloc(NUM_CORES, sizeof(Proc_Info));
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     Proc_Info* proc_info = &proc_infos[proc_id];
     char buf[MAX_STR_LENGTH + 1];
     sprintf(buf, "SHADOW L1[%d]", proc_id);
-    init_cache(&proc_info->shadow_cache, buf, L1_SIZE, L1_ASSOC, L1_LINE_SIZE, sizeof(Shadow_Cache_Data),
-               REPL_TRUE_LRU);
+    init_cache(&proc_info->shadow_cache, buf, L1_SIZE / L1_SHADOW_TAGS_MODULO, L1_ASSOC, L1_LINE_SIZE,
+               sizeof(Shadow_Cache_Data), REPL_TRUE_LRU);
     proc_info->miss_rates = calloc(L1_ASSOC, sizeof(double));
+    if (L1_SHADOW_SAMPLE_CHECK) {
+      sprintf(buf, "FULL SHADOW L1[%d]", proc_id);
+      init_cache(&proc_info->full_shadow_cache, buf, L1_SIZE, L1_ASSOC, L1_LINE_SIZE, sizeof(Shadow_Cache_Data),
+                 REPL_TRUE_LRU);
+      proc_info->full_hits = calloc(L1_ASSOC, sizeof(Counter));
+    }
   }
 
   l1_part_trigger = trigger_create("L1 PART TRIGGER", L1_PART_TRIGGER, TRIGGER_REPEAT);
@@ -424,8 +460,9 @@ void cache_part_init(void) {
   ASSERT(0, L1_ASSOC % NUM_CORES == 0);
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     current_partition[proc_id] = L1_ASSOC / NUM_CORES;
-    set_partition_allocate(&mem->uncores[0].l1->cache, proc_id, current_partition[proc_id]);
-    GET_STAT_EVENT(proc_id, NORESET_L1_PARTITION) = current_partition[proc_id];
+    for (uns slice = 0; slice < mem->num_l1_slices; slice++)
+      set_partition_allocate(&mem->uncores[0].l1[slice].cache, proc_id, current_partition[proc_id]);
+    SET_STAT_EVENT(proc_id, NORESET_L1_PARTITION, current_partition[proc_id]);
   }
   new_partition = calloc(NUM_CORES, sizeof(uns));
   temp_partition = calloc(NUM_CORES, sizeof(uns));
@@ -447,27 +484,33 @@ void cache_part_init(void) {
 void cache_part_l1_access(Mem_Req* req) {
   if (!L1_PART_ON)
     return;
-  if (!in_shadow_cache(req->addr))
-    return;
 
   Proc_Info* proc_info = &proc_infos[req->proc_id];
-  Addr dummy_line_addr;
-  int pos = cache_find_pos_in_lru_stack(&proc_info->shadow_cache, req->proc_id, req->addr, &dummy_line_addr);
-  Flag miss = (pos == -1);
-  Flag untimely_hit = FALSE;
   Flag stalling = mem_req_type_is_stalling(req->type);
   Flag demand = mem_req_type_is_demand(req->type);
-  if (!miss && L1_PART_FILL_DELAY) {
-    L1_Data* data = (L1_Data*)cache_access(&proc_info->shadow_cache, req->addr, &dummy_line_addr, FALSE);
-    ASSERT(req->proc_id, data);
-    untimely_hit = data->fetch_cycle > freq_cycle_count(FREQ_DOMAIN_L1);
+  Flag untimely_hit;
+  if (L1_SHADOW_SAMPLE_CHECK) {
+    int pos = shadow_cache_access(&proc_info->full_shadow_cache, req, req->addr, &untimely_hit);
+    STAT_EVENT(req->proc_id, L1_SHADOW_FULL_ACCESS);
+    if (L1_PART_USE_STALLING ? stalling : demand) {
+      proc_info->full_accesses++;
+      if (pos >= 0)
+        proc_info->full_hits[pos]++;
+    }
   }
+
+  Addr addr;
+  if (!shadow_addr(req->addr, &addr))
+    return;
+
+  int pos = shadow_cache_access(&proc_info->shadow_cache, req, addr, &untimely_hit);
+  Flag miss = pos < 0 && !untimely_hit;
   STAT_EVENT(req->proc_id, L1_SHADOW_ACCESS);
   if (stalling)
     STAT_EVENT(req->proc_id, L1_SHADOW_ACCESS_STALLING);
   if (demand)
     STAT_EVENT(req->proc_id, L1_SHADOW_ACCESS_DEMAND);
-  if (!miss && !untimely_hit) {
+  if (pos >= 0) {
     STAT_EVENT(req->proc_id, L1_SHADOW_HIT_POS0 + MIN2(pos, 127));
     if (stalling)
       STAT_EVENT(req->proc_id, L1_SHADOW_STALLING_HIT_POS0 + MIN2(pos, 127));
@@ -481,29 +524,54 @@ void cache_part_l1_access(Mem_Req* req) {
   INC_STAT_EVENT(req->proc_id, L1_SHADOW_UNTIMELY_HIT, untimely_hit);
   INC_STAT_EVENT(req->proc_id, L1_SHADOW_UNTIMELY_HIT_STALLING, stalling && untimely_hit);
   INC_STAT_EVENT(req->proc_id, L1_SHADOW_UNTIMELY_HIT_DEMAND, demand && untimely_hit);
+}
+
+/**************************************************************************************/
+/* Look up addr in one shadow cache and update it. Returns the LRU stack position
+ * of a hit, or -1 on a miss or on a hit whose line would not have arrived yet
+ * (*untimely_hit, see L1_PART_FILL_DELAY). */
 
-  // update shadow tag
-  if (miss) {
-    L1_Data* data = cache_insert(&proc_info->shadow_cache, req->proc_id, req->addr, &dummy_line_addr, &dummy_line_addr);
+int shadow_cache_access(Cache* cache, Mem_Req* req, Addr addr, Flag* untimely_hit) {
+  Addr dummy_line_addr;
+  int pos = cache_find_pos_in_lru_stack(cache, req->proc_id, addr, &dummy_line_addr);
+  *untimely_hit = FALSE;
+  if (pos == -1) {
+    Shadow_Cache_Data* data = cache_insert(cache, req->proc_id, addr, &dummy_line_addr, &dummy_line_addr);
+    Flag stalling = mem_req_type_is_stalling(req->type);
     data->fetch_cycle = freq_cycle_count(FREQ_DOMAIN_L1) + (stalling || req->type == MRT_WB ? 0 : L1_PART_FILL_DELAY);
-  } else {
-    cache_access(&proc_info->shadow_cache, req->addr, &dummy_line_addr, TRUE);
+    return -1;
+  }
+
+  Shadow_Cache_Data* data = (Shadow_Cache_Data*)cache_access(cache, addr, &dummy_line_addr, TRUE);
+  ASSERT(req->proc_id, data);
+  if (L1_PART_FILL_DELAY && data->fetch_cycle > freq_cycle_count(FREQ_DOMAIN_L1)) {
+    *untimely_hit = TRUE;
+    return -1;
   }
+  return pos;
 }
 
 /**************************************************************************************/
 /* cache_part_l1_warmup: */
 
-void cache_part_l1_warmup(uns proc_id, Addr addr) {
-  Proc_Info* proc_info = &proc_infos[proc_id];
+static void shadow_cache_warmup(Cache* cache, uns proc_id, Addr addr) {
   Addr dummy_line_addr;
-  L1_Data* data = (L1_Data*)cache_access(&proc_info->shadow_cache, addr, &dummy_line_addr, TRUE);
+  Shadow_Cache_Data* data = (Shadow_Cache_Data*)cache_access(cache, addr, &dummy_line_addr, TRUE);
   if (!data) {
-    L1_Data* data = cache_insert(&proc_info->shadow_cache, proc_id, addr, &dummy_line_addr, &dummy_line_addr);
+    Shadow_Cache_Data* data = cache_insert(cache, proc_id, addr, &dummy_line_addr, &dummy_line_addr);
     data->fetch_cycle = 0;
   }
 }
 
+void cache_part_l1_warmup(uns proc_id, Addr addr) {
+  Proc_Info* proc_info = &proc_infos[proc_id];
+  Addr shadow;
+  if (L1_SHADOW_SAMPLE_CHECK)
+    shadow_cache_warmup(&proc_info->full_shadow_cache, proc_id, addr);
+  if (shadow_addr(addr, &shadow))
+    shadow_cache_warmup(&proc_info->shadow_cache, proc_id, shadow);
+}
+
 /**
  * @brief Update the partition allocation
  * called once every cmp_cycle(), after update_memory()
@@ -516,18 +584,36 @@ void cache_part_update(void) {
   // the REPL is set to LRU initially only when L1_PART_WARM is on
   if (trigger_fired(l1_part_start)) {
     if (L1_PART_WARMUP) {
-      ASSERT(0, mem->uncores[0].l1->cache.repl_policy == REPL_TRUE_LRU);
-      mem->uncores[0].l1->cache.repl_policy = REPL_PARTITION;
+      for (uns slice = 0; slice < mem->num_l1_slices; slice++) {
+        ASSERT(0, mem->uncores[0].l1[slice].cache.repl_policy == REPL_TRUE_LRU);
+        mem->uncores[0].l1[slice].cache.repl_policy = REPL_PARTITION;
+      }
     }
   }
 
+  // the new partition applies at a fixed cycle no matter how fast the helper
+  // thread is, so results stay reproducible
+  if (search_pending && freq_cycle_count(FREQ_DOMAIN_L1) >= search_apply_cycle)
+    finish_search();
+
   if (!trigger_fired(l1_part_trigger))
     return;
 
   DEBUG(0, "Cache partition triggered\n");
   if (trigger_on(l1_part_start)) {
+    // only one search is in flight, so the previous epoch's result lands first
+    if (search_pending)
+      finish_search();
     measure_miss_curves();
-    set_partition();
+    if (L1_PART_ASYNC_DELAY) {
+      search_pending = TRUE;
+      search_apply_cycle = freq_cycle_count(FREQ_DOMAIN_L1) + L1_PART_ASYNC_DELAY;
+      int err = pthread_create(&search_thread, NULL, search_main, NULL);
+      ASSERTM(0, !err, "Could not create the cache partition search thread (%d)\n", err);
+    } else {
+      search_func();
+      set_partition();
+    }
   }
 
   // TODO: if this func is called too often (controlled by user through
@@ -535,15 +621,48 @@ void cache_part_update(void) {
   // shadow access between two  triggers, thus divide by 0), corrently there is
   // not check for this case
   stat_mon_reset(stat_mon);
+  if (L1_SHADOW_SAMPLE_CHECK) {
+    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      memset(proc_infos[proc_id].full_hits, 0, L1_ASSOC * sizeof(Counter));
+      proc_infos[proc_id].full_accesses = 0;
+    }
+  }
+}
+
+/**************************************************************************************/
+/* Run the configured search on the helper thread. It only touches proc_infos,
+ * new_partition, temp_partition and tie_breaker_proc_id, none of which the
+ * simulation thread uses until finish_search() has joined it. */
+
+void* search_main(void* arg) {
+  search_func();
+  return NULL;
 }
 
 /**************************************************************************************/
-/* Is the line with specified addr tracked in the shadow cache? */
+/* Wait for the in-flight search and enforce its partition */
 
-Flag in_shadow_cache(Addr addr) {
-  Addr dummy_addr;
-  uns set = ext_cache_index(&proc_infos[0].shadow_cache, addr, &dummy_addr, &dummy_addr);
-  return set % L1_SHADOW_TAGS_MODULO == 0;
+void finish_search(void) {
+  ASSERT(0, search_pending);
+  pthread_join(search_thread, NULL);
+  search_pending = FALSE;
+  set_partition();
+}
+
+/**************************************************************************************/
+/* Is the line with specified addr in a sampled set? If so, *shadow is its address
+ * in the shadow cache, which has only the sampled sets: the L1 tag stays, and the
+ * L1 set number drops its low bits, which are zero for every sampled set. */
+
+Flag shadow_addr(Addr addr, Addr* shadow) {
+  uns line_bits = LOG2(L1_LINE_SIZE);
+  Addr line = addr >> line_bits;
+  Addr set = line & N_BIT_MASK(l1_set_bits);
+  if (set & N_BIT_MASK(shadow_sample_bits))
+    return FALSE;
+  Addr tag = line >> l1_set_bits;
+  *shadow = ((tag << (l1_set_bits - shadow_sample_bits)) | (set >> shadow_sample_bits)) << line_bits;
+  return TRUE;
 }
 
 /**************************************************************************************/
@@ -555,15 +674,41 @@ void measure_miss_curves(void) {
     uns access_stat = L1_PART_USE_STALLING ? L1_SHADOW_ACCESS_STALLING : L1_SHADOW_ACCESS_DEMAND;
     uns pos0_hit_stat = L1_PART_USE_STALLING ? L1_SHADOW_STALLING_HIT_POS0 : L1_SHADOW_DEMAND_HIT_POS0;
     Counter shadow_accesses = stat_mon_get_count(stat_mon, proc_id, access_stat);
+    // scaled up to an estimate of all L1 accesses
+    proc_info->accesses = (double)shadow_accesses * L1_SHADOW_TAGS_MODULO;
+    proc_info->stall_frac = (double)stat_mon_get_count(stat_mon, proc_id, RET_BLOCKED_L1_MISS) /
+                            (double)stat_mon_get_count(stat_mon, proc_id, NODE_CYCLE);
     Counter shadow_misses_sum = shadow_accesses;
     for (uns ii = 0; ii < L1_ASSOC - 1; ii++) {
       Counter way_hits = stat_mon_get_count(stat_mon, proc_id, pos0_hit_stat + ii);
       shadow_misses_sum -= way_hits;
       proc_info->miss_rates[ii] = (double)shadow_misses_sum / (double)shadow_accesses;
     }
+    if (L1_SHADOW_SAMPLE_CHECK)
+      measure_sample_error(proc_info, proc_id);
   }
 }
 
+/**************************************************************************************/
+/* Compare the sampled miss curve with the one of the unsampled shadow tags */
+
+void measure_sample_error(Proc_Info* proc_info, uns proc_id) {
+  if (!proc_info->full_accesses || !proc_info->accesses)
+    return;
+  Counter full_misses_sum = proc_info->full_accesses;
+  double error_sum = 0.0;
+  double error_max = 0.0;
+  for (uns ii = 0; ii < L1_ASSOC - 1; ii++) {
+    full_misses_sum -= proc_info->full_hits[ii];
+    double error = fabs(proc_info->miss_rates[ii] - (double)full_misses_sum / (double)proc_info->full_accesses);
+    error_sum += error;
+    error_max = MAX2(error_max, error);
+  }
+  STAT_EVENT(proc_id, L1_SHADOW_SAMPLE_EPOCHS);
+  INC_STAT_EVENT(proc_id, L1_SHADOW_SAMPLE_ERROR_PPM, (Counter)(1e6 * error_sum / MAX2(L1_ASSOC - 1, 1)));
+  INC_STAT_EVENT(proc_id, L1_SHADOW_SAMPLE_MAX_ERROR_PPM, (Counter)(1e6 * error_max));
+}
+
 /**************************************************************************************/
 /* Find best marginal utility using lookahead method (Algorithm 2) of Moin's
  * paper.
@@ -690,21 +835,19 @@ void search_lookahead(void) {
 }
 
 /**************************************************************************************/
-/* Set target partition */
+/* Enforce the partition the last search left in new_partition */
 
 void set_partition(void) {
-  // the one bind at config time (lookahead/brutal force)
-  search_func();
-
   if (ENABLE_GLOBAL_DEBUG_PRINT && DEBUG_RANGE_COND(0)) {
     debug_cache_part(current_partition, new_partition);
   }
 
   /* set up the estimated best partition */
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    set_partition_allocate(&mem->uncores[0].l1->cache, proc_id, new_partition[proc_id]);
+    for (uns slice = 0; slice < mem->num_l1_slices; slice++)
+      set_partition_allocate(&mem->uncores[0].l1[slice].cache, proc_id, new_partition[proc_id]);
     current_partition[proc_id] = new_partition[proc_id];
-    GET_STAT_EVENT(proc_id, NORESET_L1_PARTITION) = new_partition[proc_id];
+    SET_STAT_EVENT(proc_id, NORESET_L1_PARTITION, new_partition[proc_id]);
   }
   STAT_EVENT_ALL(L1_PARTITION_INTERVALS);
 }
@@ -736,9 +879,7 @@ double get_global_miss_rate(uns* partition) {
   double sum = 0.0;
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     Proc_Info* proc_info = &proc_infos[proc_id];
-    Counter accesses = stat_mon_get_count(stat_mon, proc_id,
-                                          L1_PART_USE_STALLING ? L1_SHADOW_ACCESS_STALLING : L1_SHADOW_ACCESS_DEMAND);
-    sum += proc_info->miss_rates[partition[proc_id]] * (double)accesses;
+    sum += proc_info->miss_rates[partition[proc_id]] * proc_info->accesses;
   }
   return sum;
 }
@@ -782,8 +923,7 @@ double get_gmean_perf(uns* partition) {
                \ old miss rate     /
     */
     Proc_Info* proc_info = &proc_infos[proc_id];
-    double stall_frac = (double)stat_mon_get_count(stat_mon, proc_id, RET_BLOCKED_L1_MISS) /
-                        (double)stat_mon_get_count(stat_mon, proc_id, NODE_CYCLE);
+    double stall_frac = proc_info->stall_frac;
     double miss_rate0 = proc_info->miss_rates[current_partition[proc_id]];
     double miss_rate = proc_info->miss_rates[partition[proc_id]];
     double pred_perf;
@@ -97,6 +97,13 @@ typedef enum Destination_enum {
 
 DECLARE_ENUM(Dram_Req_Status, DRAM_REQ_STATUS_LIST, DRAM_REQ_ROW_);
 
+/* An op waiting for a request. The op may have been reclaimed by the time the
+   request completes, so the unique num is kept to validate it. */
+typedef struct Mem_Req_Waiter_struct {
+  Op* op;
+  Counter unique_num;
+} Mem_Req_Waiter;
+
 // typedef in globals/global_types.h
 struct Mem_Req_struct {
   uns proc_id;             /* processor id that generates the request */
@@ -126,6 +133,7 @@ struct Mem_Req_struct {
   Counter start_cycle;                 /* cycle that the request is ready to process */
   Counter rdy_cycle;                   /* cycle when the current operation is complete */
   uns reserved_entry_count;            /* how many entries are reserved for this request */
+  Counter queue_insert_num;            /* stamp of the latest insertion into a queue */
   Counter first_stalling_cycle;        /* cycle this request became a type considered
                                           stalling */
   Counter oldest_op_unique_num;        /* unique num of the oldest op that is waiting
@@ -135,8 +143,8 @@ struct Mem_Req_struct {
                                           req - may not be in the machine any more */
   Counter oldest_op_addr;              /* PC of the oldest op that is waiting for this req -
                                           may not be in the machine any more */
-  List op_ptrs;
-  List op_uniques;
+  Mem_Req_Waiter* waiters;                   /* ops that are waiting for the miss, in arrival order */
+  uns waiter_slots;                          /* allocated size of waiters */
   uns op_count;                              /* number of ops that are waiting for the miss */
   uns req_count;                             /* number of requests coalesced into this one */
   Flag (*done_func)(struct Mem_Req_struct*); /* pointer to function to call when
@@ -40,6 +40,7 @@
 #include "debug/debug.param.h"
 #include "debug/debug_macros.h"
 #include "debug/debug_print.h"
+#include "debug/host_prof.h"
 #include "debug/memview.h"
 
 #include "core.param.h"
@@ -49,6 +50,7 @@
 
 #include "bp/bp.h"
 #include "dvfs/perf_pred.h"
+#include "libs/malloc_lib.h"
 #include "prefetcher//pref_stream.h"
 #include "prefetcher/fdip.h"
 #include "prefetcher/l2l1pref.h"
@@ -57,9 +59,13 @@
 
 #include "addr_trans.h"
 #include "cache_part.h"
+#include "stack_dist.h"
+#include "cmp_threads.h"
 #include "cmp_model.h"
 #include "icache_stage.h"
+#include "map.h"
 #include "mem_req.h"
+#include "noc.h"
 #include "op.h"
 #include "statistics.h"
 // #include "dram.h"
@@ -79,6 +85,8 @@
 
 #define MLC(proc_id) (mem->uncores[proc_id].mlc)
 #define L1(proc_id) (mem->uncores[proc_id].l1)
+#define L1_SLICE(proc_id, addr) (&L1(proc_id)[mem_l1_slice(addr)])
+#define L1_QUEUE(addr) (&mem->l1_queues[mem_l1_slice(addr)])
 
 /**************************************************************************************/
 /* Global Variables */
@@ -96,18 +104,21 @@ static Counter* core_fill_seq_num;
 static uns mem_req_demand_entries = 0;
 static uns mem_req_pref_entries = 0;
 static uns mem_req_wb_entries = 0;
+static uns l1_slice_shift; /* lowest tag bit of a slice's lines */
 
 Memory* mem = NULL;
-extern Icache_Stage* ic;
+extern CORE_LOCAL Icache_Stage* ic;
 extern Counter last_recover_cycle;
 
 Counter Mem_Req_Priority[MRT_NUM_ELEMS];
 Counter Mem_Req_Priority_Offset[MRT_NUM_ELEMS];
+static Mem_Credit_Class mem_req_credit_class[MRT_NUM_ELEMS];
 
 /**************************************************************************************/
 /* Local Prototypes */
 
 static void init_mem_req_type_priorities(void);
+static void init_req_buffer_credits(void);
 static void init_uncores(void);
 static void update_memory_queues(void);
 static void update_on_chip_memory_stats(void);
@@ -120,6 +131,7 @@ static void update_mem_req_occupancy_counter(Mem_Req_Type type, int delta);
 int mem_compare_priority(const void* a, const void* b);
 void mem_start_mlc_access(Mem_Req* req);
 static void mem_process_core_fill_reqs(uns proc_id);
+static void update_memory_core_tick(uns proc_id);
 Flag mem_process_mlc_hit_access(Mem_Req* req, Mem_Queue_Entry* mlc_queue_entry, Addr* line_addr, MLC_Data* data,
                                 int lruu_position);
 static void mem_process_mlc_fill_reqs(void);
@@ -153,6 +165,11 @@ static inline Mem_Req* mem_search_reqbuf(uns8 proc_id, Addr addr, Mem_Req_Type t
                                          Flag* demand_hit_prefetch, Flag* demand_hit_writeback, uns queues_to_search,
                                          Mem_Queue_Entry** queue_entry, Flag* ramulator_match);
 
+static void mem_req_addr_index_init(void);
+static void mem_req_addr_index_insert(Mem_Req* req);
+static void mem_req_addr_index_remove(Mem_Req* req);
+static inline Flag mem_req_addr_index_may_match(Addr addr);
+
 static Flag mem_adjust_matching_request(Mem_Req* req, Mem_Req_Type type, Addr addr, uns size, Destination destination,
                                         uns delay, Op* op, Flag done_func(Mem_Req*), Counter unique_num,
                                         Flag demand_hit_prefetch, Flag demand_hit_writeback,
@@ -169,6 +186,11 @@ static void mem_init_new_req(Mem_Req* new_req, Mem_Req_Type type, Mem_Queue_Type
                              Counter new_priority);
 
 static inline void init_mem_queue(Mem_Queue* queue, char* name, uns size, Mem_Queue_Type type);
+static void mem_pref_index_insert(Mem_Queue* queue, Mem_Req* req);
+static inline Flag mem_queue_idle(Mem_Queue* queue);
+static uns mem_l1_queue_count(void);
+static void mem_l1_queues_sort(void);
+static void mem_queue_sort(Mem_Queue* queue);
 
 static void print_mem_queue_generic(Mem_Queue* queue);
 
@@ -180,6 +202,10 @@ static Flag new_mem_mlc_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns s
                                Flag done_func(Mem_Req*), Counter unique_num);
 static Flag new_mem_l1_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay, Op* op,
                               Flag done_func(Mem_Req*), Counter unique_num);
+static void init_mem_wb_buffer(Mem_Wb_Buffer* buf, uns size);
+static Flag mem_wb_buffer_add(Mem_Wb_Buffer* buf, uns8 proc_id, Addr addr, Stat_Enum stat_base);
+static void mem_drain_wb_buffers(void);
+static Flag mem_wb_buffer_flush_line(uns8 proc_id, Addr addr);
 
 static inline void set_off_path_confirmed_status(Mem_Req* req);
 static void mem_clear_reqbuf(Mem_Req* req);
@@ -205,11 +231,68 @@ static inline void init_mem_queue(Mem_Queue* queue, char* name, uns size, Mem_Qu
   ASSERTM(0, !(type & QUEUE_MEM), "Ramulator does not use QUEUE_MEM. QUEUE_MEM should not be initialized!\n");
 
   queue->base = (Mem_Queue_Entry*)malloc(sizeof(Mem_Queue_Entry) * (size + 1));
+  queue->scratch = (Mem_Queue_Entry*)malloc(sizeof(Mem_Queue_Entry) * (size + 1));
   queue->size = size;
   queue->entry_count = 0;
   queue->reserved_entry_count = 0;
+  queue->next_rdy_cycle = 0;
   queue->type = type;
   strcpy(queue->name, name);
+
+  /* the queues mem_kick_out_prefetch_from_queue searches */
+  if (KICKOUT_PREFETCHES && KICKOUT_OLDEST_PREFETCH && (type & (QUEUE_L1 | QUEUE_BUS_OUT | QUEUE_L1FILL))) {
+    queue->num_pref_heaps = 1 + (KICKOUT_OLDEST_PREFETCH_WITHIN_BANK ? RAMULATOR_BANKS * RAMULATOR_CHANNELS : 0);
+    queue->pref_heaps = (Mem_Pref_Heap*)calloc(queue->num_pref_heaps, sizeof(Mem_Pref_Heap));
+  }
+}
+
+/**************************************************************************************/
+/* mem_queue_idle: */
+/* TRUE if no entry of the queue can be ready this cycle, so its walk can be
+ * skipped. Each walk records the earliest rdy_cycle it left behind and every
+ * insertion clears it. */
+
+static inline Flag mem_queue_idle(Mem_Queue* queue) {
+  return cycle_count < queue->next_rdy_cycle;
+}
+
+/**************************************************************************************/
+/* mem_l1_slice: */
+/* L1 slice holding addr. Slices are selected with the tag bits so that every
+ * slice keeps using all of its sets. */
+
+uns mem_l1_slice(Addr addr) {
+  if (mem->num_l1_slices == 1)
+    return 0;
+  Addr tag = addr >> l1_slice_shift;
+  if (L1_SLICE_HASH) {
+    uns fold_bits = LOG2(mem->num_l1_slices);
+    if (mem->num_l1_slices & (mem->num_l1_slices - 1))
+      fold_bits++;
+    Addr folded = 0;
+    for (; tag; tag >>= fold_bits)
+      folded ^= tag & N_BIT_MASK(fold_bits);
+    tag = folded;
+  }
+  return tag % mem->num_l1_slices;
+}
+
+/**************************************************************************************/
+/* mem_l1_queue_count: */
+
+static uns mem_l1_queue_count() {
+  uns count = 0;
+  for (uns ii = 0; ii < mem->num_l1_slices; ii++)
+    count += mem->l1_queues[ii].entry_count;
+  return count;
+}
+
+/**************************************************************************************/
+/* mem_l1_queues_sort: */
+
+static void mem_l1_queues_sort() {
+  for (uns ii = 0; ii < mem->num_l1_slices; ii++)
+    mem_queue_sort(&mem->l1_queues[ii]);
 }
 
 /**************************************************************************************/
@@ -271,12 +354,49 @@ void init_mem_req_type_priorities() {
   }
 }
 
+/**************************************************************************************/
+/* init_req_buffer_credits: the watermark, valve and deadlock checks of each
+   request type reduce to a single limit on the entries in use */
+
+static void init_req_buffer_credits(void) {
+  for (uns type = 0; type < MRT_NUM_ELEMS; ++type) {
+    switch (type) {
+      case MRT_IPRF:
+      case MRT_DPRF:
+      case MRT_UOCPRF:
+      case MRT_FDIPPRFON:
+      case MRT_FDIPPRFOFF:
+        mem_req_credit_class[type] = MEM_CREDIT_PREF;
+        break;
+      case MRT_WB:
+      case MRT_WB_NODIRTY:
+        mem_req_credit_class[type] = MEM_CREDIT_WB;
+        break;
+      default:
+        mem_req_credit_class[type] = MEM_CREDIT_DEMAND;
+        break;
+    }
+  }
+
+  uns reserve[NUM_MEM_CREDIT_CLASSES];
+  reserve[MEM_CREDIT_L1_WB] = 0;
+  reserve[MEM_CREDIT_WB] = 1;
+  reserve[MEM_CREDIT_DEMAND] = MAX2(reserve[MEM_CREDIT_WB], MEM_REQ_BUFFER_WB_VALVE);
+  reserve[MEM_CREDIT_PREF] = MAX2(reserve[MEM_CREDIT_DEMAND], MEM_REQ_BUFFER_PREF_WATERMARK);
+  for (uns ii = 0; ii < NUM_MEM_CREDIT_CLASSES; ii++)
+    mem->req_buffer_credits[ii] = MEM_REQ_BUFFER_ENTRIES > reserve[ii] ? MEM_REQ_BUFFER_ENTRIES - reserve[ii] : 0;
+
+  mem->req_buffer_pool = (uns**)malloc(sizeof(uns*) * NUM_CORES);
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    mem->req_buffer_pool[proc_id] =
+        PRIVATE_MSHR_ON ? &mem->num_req_buffers_per_core[proc_id] : &mem->num_req_buffers_shared;
+}
+
 /**************************************************************************************/
 /* init_memory: */
 
 void init_memory() {
   int ii;
-  char name[20];
   uns8 proc_id;
 
   ASSERT(0, mem);
@@ -288,6 +408,7 @@ void init_memory() {
   memset(mem, 0, sizeof(Memory));
 
   init_mem_req_type_priorities();
+  init_addr_trans();
 
   /* Initialize request buffers */
   mem->total_mem_req_buffers = MEM_REQ_BUFFER_ENTRIES * (PRIVATE_MSHR_ON ? NUM_CORES : 1);
@@ -296,28 +417,53 @@ void init_memory() {
     mem->req_buffer[ii].state = MRS_INV;
   }
   mem->num_req_buffers_per_core = calloc(NUM_CORES, sizeof(uns));
-  init_list(&mem->req_buffer_free_list, "REQ BUF FREE LIST", sizeof(int), TRUE);
+  mem_req_addr_index_init();
+  mem->req_buffer_free_stack = (int*)malloc(sizeof(int) * mem->total_mem_req_buffers);
+  init_req_buffer_credits();
 
   if (ROUND_ROBIN_TO_L1) {
-    mem->l1_in_buffer_core = (List*)malloc(sizeof(List) * NUM_CORES);
+    mem->l1_in_buffer_core = (Deque*)malloc(sizeof(Deque) * NUM_CORES);
     for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      init_list(&mem->l1_in_buffer_core[proc_id], "L1 IN BUFFER", sizeof(Mem_Req*), TRUE);
+      init_deque(&mem->l1_in_buffer_core[proc_id], "L1 IN BUFFER", sizeof(Mem_Req*), 16);
     }
   }
 
+  if (MEM_WB_BUFFER_ENTRIES) {
+    ASSERTM(0, MEM_WB_BUFFER_DRAIN_PER_CYCLE > 0, "MEM_WB_BUFFER_DRAIN_PER_CYCLE must be positive\n");
+    mem->mlc_wb_buffers = (Mem_Wb_Buffer*)calloc(NUM_CORES, sizeof(Mem_Wb_Buffer));
+    for (proc_id = 0; proc_id < NUM_CORES; proc_id++)
+      init_mem_wb_buffer(&mem->mlc_wb_buffers[proc_id], MLC_PRESENT ? MEM_WB_BUFFER_ENTRIES : 0);
+    // without contention modeling an L1 writeback costs nothing already
+    init_mem_wb_buffer(&mem->l1_wb_buffer,
+                       CONSTANT_MEMORY_LATENCY || STALL_MEM_REQS_ONLY ? 0 : MEM_WB_BUFFER_ENTRIES * NUM_CORES);
+  }
+
+  ASSERT(0, MEM_REQ_WAITER_SLOTS > 0);
+  mem->waiter_slab =
+      (Mem_Req_Waiter*)malloc(sizeof(Mem_Req_Waiter) * MEM_REQ_WAITER_SLOTS * mem->total_mem_req_buffers);
   for (ii = 0; ii < mem->total_mem_req_buffers; ii++) {
     mem->req_buffer[ii].id = ii;
-    sprintf(name, "%d OPP_L", ii);
-    init_list(&mem->req_buffer[ii].op_ptrs, name, sizeof(Op*), TRUE);
-    sprintf(name, "%d OPU_L", ii);
-    init_list(&mem->req_buffer[ii].op_uniques, name, sizeof(Counter), TRUE);
+    mem->req_buffer[ii].waiter_slots = MEM_REQ_WAITER_SLOTS;
+    mem->req_buffer[ii].waiters = &mem->waiter_slab[ii * MEM_REQ_WAITER_SLOTS];
+    mem->req_buffer[ii].op_count = 0;
   }
 
   /* Initialize l1 and bus access queues which hold id's of request buffers */
   init_mem_queue(&mem->mlc_queue, "MLC_QUEUE", QUEUE_MLC_SIZE == 0 ? mem->total_mem_req_buffers : QUEUE_MLC_SIZE,
                  QUEUE_MLC);
   init_mem_queue(&mem->mlc_fill_queue, "MLC_FILL_QUEUE", mem->total_mem_req_buffers, QUEUE_MLC_FILL);
-  init_mem_queue(&mem->l1_queue, "L1_QUEUE", QUEUE_L1_SIZE == 0 ? mem->total_mem_req_buffers : QUEUE_L1_SIZE, QUEUE_L1);
+  mem->num_l1_slices = PRIVATE_L1 ? 1 : L1_SLICES;
+  ASSERTM(0, mem->num_l1_slices > 0, "L1_SLICES must be at least 1\n");
+  mem->l1_queues = (Mem_Queue*)calloc(mem->num_l1_slices, sizeof(Mem_Queue));
+  for (uns slice = 0; slice < mem->num_l1_slices; slice++) {
+    char buf[MAX_STR_LENGTH + 1];
+    if (mem->num_l1_slices == 1)
+      sprintf(buf, "L1_QUEUE");
+    else
+      sprintf(buf, "L1_QUEUE[%d]", slice);
+    init_mem_queue(&mem->l1_queues[slice], buf, QUEUE_L1_SIZE == 0 ? mem->total_mem_req_buffers : QUEUE_L1_SIZE,
+                   QUEUE_L1);
+  }
   init_mem_queue(&mem->bus_out_queue, "BUS_OUT_QUEUE",
                  QUEUE_BUS_OUT_SIZE == 0 ? mem->total_mem_req_buffers : QUEUE_BUS_OUT_SIZE, QUEUE_BUS_OUT);
   init_mem_queue(&mem->l1fill_queue, "L1FILL_QUEUE", mem->total_mem_req_buffers, QUEUE_L1FILL);
@@ -330,6 +476,7 @@ void init_memory() {
     init_mem_queue(&mem->core_fill_queues[proc_id], buf,
                    QUEUE_CORE_FILL_SIZE == 0 ? mem->total_mem_req_buffers : QUEUE_CORE_FILL_SIZE, QUEUE_CORE_FILL);
     core_fill_seq_num[proc_id] = 1;
+    freq_register_tick(FREQ_DOMAIN_CORES[proc_id], update_memory_core_tick, proc_id);
   }
 
   init_uncores();
@@ -351,12 +498,20 @@ void init_memory() {
 
   // init_dram ();
   ramulator_init();
+  noc_init();
 
   reset_memory();
 
   init_perf_pred();
 }
 
+/* The wrong-path side table of an L1, one entry per line */
+static void init_l1_wp_data(Ported_Cache* l1) {
+  l1->wp_data = NULL;
+  if (WP_COLLECT_STATS)
+    l1->wp_data = (L1_Wp_Data*)lazy_calloc((size_t)l1->cache.num_sets * l1->cache.assoc, sizeof(L1_Wp_Data));
+}
+
 /**
  * @brief this function should only be called once in warmup mode
  *
@@ -367,7 +522,11 @@ void init_uncores(void) {
   /* Initialize MLC cache (shared only for now) */
   Ported_Cache* mlc = (Ported_Cache*)malloc(sizeof(Ported_Cache));
   init_cache(&mlc->cache, "MLC_CACHE", MLC_SIZE, MLC_ASSOC, MLC_LINE_SIZE, sizeof(MLC_Data), MLC_CACHE_REPL_POLICY);
+  cache_enable_lookup_memo(&mlc->cache, CACHE_LOOKUP_MEMO_ENTRIES, 0, MLC_LOOKUP_MEMO_MISS);
+  if (CACHE_LINE_STATS)
+    cache_enable_line_ext(&mlc->cache, sizeof(L1_Data_Ext));
   mlc->num_banks = MLC_BANKS;
+  mlc->wp_data = NULL;
   mlc->ports = (Ports*)malloc(sizeof(Ports) * mlc->num_banks);
   for (uns ii = 0; ii < mlc->num_banks; ii++) {
     char name[MAX_STR_LENGTH + 1];
@@ -383,11 +542,16 @@ void init_uncores(void) {
     ASSERTM(0, L1_SIZE % NUM_CORES == 0, "Total L1_SIZE must be a multiple of NUM_CORES if PRIVATE_L1 is on\n");
     ASSERTM(0, L1_BANKS % NUM_CORES == 0, "Total L1_BANKS must be a multiple of NUM_CORES if PRIVATE_L1 is on\n");
     for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      cmp_threads_numa_core(proc_id);
       Ported_Cache* l1 = (Ported_Cache*)malloc(sizeof(Ported_Cache));
 
       char buf[MAX_STR_LENGTH + 1];
       sprintf(buf, "L1[%d]", proc_id);
       init_cache(&l1->cache, buf, L1_SIZE / NUM_CORES, L1_ASSOC, L1_LINE_SIZE, sizeof(L1_Data), L1_CACHE_REPL_POLICY);
+      cache_enable_lookup_memo(&l1->cache, CACHE_LOOKUP_MEMO_ENTRIES, proc_id, L1_LOOKUP_MEMO_MISS);
+      if (CACHE_LINE_STATS)
+        cache_enable_line_ext(&l1->cache, sizeof(L1_Data_Ext));
+      init_l1_wp_data(l1);
 
       l1->num_banks = L1_BANKS / NUM_CORES;
       l1->ports = (Ports*)malloc(sizeof(Ports) * l1->num_banks);
@@ -398,16 +562,39 @@ void init_uncores(void) {
       }
       L1(proc_id) = l1;
     }
+    cmp_threads_numa_shared();
   } else {
-    Ported_Cache* l1 = (Ported_Cache*)malloc(sizeof(Ported_Cache));
-    init_cache(&l1->cache, "L1_CACHE", L1_SIZE, L1_ASSOC, L1_LINE_SIZE, sizeof(L1_Data), L1_CACHE_REPL_POLICY);
-    l1->num_banks = L1_BANKS;
-    l1->ports = (Ports*)malloc(sizeof(Ports) * l1->num_banks);
-    for (uns ii = 0; ii < l1->num_banks; ii++) {
-      char name[MAX_STR_LENGTH + 1];
-      snprintf(name, MAX_STR_LENGTH, "L1 BANK %d PORTS", ii);
-      init_ports(&l1->ports[ii], name, L1_READ_PORTS, L1_WRITE_PORTS, FALSE);
+    uns num_slices = mem->num_l1_slices;
+    if (num_slices > 1) {
+      ASSERTM(0, L1_SIZE % num_slices == 0, "Total L1_SIZE must be a multiple of L1_SLICES\n");
+      ASSERTM(0, L1_BANKS % num_slices == 0, "Total L1_BANKS must be a multiple of L1_SLICES\n");
+      ASSERTM(0, !HIER_MSHR_ON, "HIER_MSHR_ON is not supported with L1_SLICES > 1\n");
     }
+    Ported_Cache* l1 = (Ported_Cache*)malloc(sizeof(Ported_Cache) * num_slices);
+    for (uns slice = 0; slice < num_slices; slice++) {
+      char buf[MAX_STR_LENGTH + 1];
+      if (num_slices == 1)
+        sprintf(buf, "L1_CACHE");
+      else
+        sprintf(buf, "L1_CACHE[%d]", slice);
+      init_cache(&l1[slice].cache, buf, L1_SIZE / num_slices, L1_ASSOC, L1_LINE_SIZE, sizeof(L1_Data),
+                 L1_CACHE_REPL_POLICY);
+      cache_enable_lookup_memo(&l1[slice].cache, CACHE_LOOKUP_MEMO_ENTRIES, 0, L1_LOOKUP_MEMO_MISS);
+      if (CACHE_LINE_STATS)
+        cache_enable_line_ext(&l1[slice].cache, sizeof(L1_Data_Ext));
+      init_l1_wp_data(&l1[slice]);
+      l1[slice].num_banks = L1_BANKS / num_slices;
+      l1[slice].ports = (Ports*)malloc(sizeof(Ports) * l1[slice].num_banks);
+      for (uns ii = 0; ii < l1[slice].num_banks; ii++) {
+        char name[MAX_STR_LENGTH + 1];
+        if (num_slices == 1)
+          snprintf(name, MAX_STR_LENGTH, "L1 BANK %d PORTS", ii);
+        else
+          snprintf(name, MAX_STR_LENGTH, "L1[%d] BANK %d PORTS", slice, ii);
+        init_ports(&l1[slice].ports[ii], name, L1_READ_PORTS, L1_WRITE_PORTS, FALSE);
+      }
+    }
+    l1_slice_shift = l1[0].cache.shift_bits + l1[0].cache.set_bits;
     for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
       L1(proc_id) = l1;
     }
@@ -417,7 +604,8 @@ void init_uncores(void) {
     // initially equally partition
     uns num_ways = L1_ASSOC / NUM_CORES;
     for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      set_partition_allocate(&L1(proc_id)->cache, proc_id, num_ways);
+      for (uns slice = 0; slice < mem->num_l1_slices; slice++)
+        set_partition_allocate(&L1(proc_id)[slice].cache, proc_id, num_ways);
     }
 
     // set static partition (if used)
@@ -428,7 +616,8 @@ void init_uncores(void) {
       int num_tokens = parse_int_array(ways_per_core, L1_STATIC_PARTITION, MAX_NUM_PROCS);
       ASSERT(0, num_tokens == NUM_CORES);
       for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-        set_partition_allocate(&L1(proc_id)->cache, proc_id, ways_per_core[proc_id]);
+        for (uns slice = 0; slice < mem->num_l1_slices; slice++)
+          set_partition_allocate(&L1(proc_id)[slice].cache, proc_id, ways_per_core[proc_id]);
       }
     }
 
@@ -463,22 +652,38 @@ void init_uncores(void) {
 void reset_memory() {
   uns ii;
 
-  clear_list(&mem->req_buffer_free_list);
+  mem->req_buffer_free_count = 0;
+  mem->num_req_buffers_shared = 0;
 
-  mem->l1_queue.entry_count = 0;
+  for (ii = 0; ii < mem->num_l1_slices; ii++)
+    mem->l1_queues[ii].entry_count = 0;
   mem->mlc_queue.entry_count = 0;
   mem->bus_out_queue.entry_count = 0;
   mem->l1fill_queue.entry_count = 0;
   mem->mlc_fill_queue.entry_count = 0;
-
-  for (ii = 0; ii < mem->total_mem_req_buffers; ii++) {
-    int* free_list_entry = sl_list_add_tail(&mem->req_buffer_free_list);
-    *free_list_entry = ii;
+  for (ii = 0; ii < mem->num_l1_slices; ii++)
+    for (uns jj = 0; jj < mem->l1_queues[ii].num_pref_heaps; jj++)
+      mem->l1_queues[ii].pref_heaps[jj].count = 0;
+  for (uns jj = 0; jj < mem->bus_out_queue.num_pref_heaps; jj++)
+    mem->bus_out_queue.pref_heaps[jj].count = 0;
+  for (uns jj = 0; jj < mem->l1fill_queue.num_pref_heaps; jj++)
+    mem->l1fill_queue.pref_heaps[jj].count = 0;
+
+  /* pushed in reverse, so the entries are first handed out in order */
+  for (ii = mem->total_mem_req_buffers; ii-- > 0;) {
+    mem->req_buffer_free_stack[mem->req_buffer_free_count++] = ii;
     mem->req_buffer[ii].state = MRS_INV;
   }
 
   mem->req_count = 0;
 
+  /* the writeback buffers keep their entries: those lines are already gone from
+     the cache that evicted them, so dropping the entries would lose the dirty
+     data. They drain after the reset as usual. */
+
+  memset(mem->req_addr_index, 0, sizeof(Mem_Req_Addr_Index_Entry) << (64 - mem->req_addr_index_shift));
+  mem->req_addr_index_num_sizes = 0;
+
   uns8 proc_id;
   for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     mem->l1_ave_num_ways_per_core[proc_id] = 0;
@@ -486,15 +691,36 @@ void reset_memory() {
 }
 
 static void mem_clear_reqbuf(Mem_Req* req) {
-  clear_list(&req->op_ptrs);
-  clear_list(&req->op_uniques);
+  req->op_count = 0;
 }
 
-void mem_free_reqbuf(Mem_Req* req) {
-  int* reqbuf_num_ptr;
+/**************************************************************************************/
+/* mem_req_add_waiter: append the op to the request's waiter slots. The
+   first slots of every request sit in one slab; a request spills to its own
+   block only when more ops than ever before merge into it, and keeps that
+   block, so the steady state does not allocate. */
+
+static void mem_req_add_waiter(Mem_Req* req, Op* op) {
+  if (req->op_count == req->waiter_slots) {
+    Mem_Req_Waiter* slab_slots = &mem->waiter_slab[req->id * MEM_REQ_WAITER_SLOTS];
+    req->waiter_slots *= 2;
+    if (req->waiters == slab_slots) {
+      req->waiters = (Mem_Req_Waiter*)malloc(sizeof(Mem_Req_Waiter) * req->waiter_slots);
+      ASSERT(req->proc_id, req->waiters);
+      memcpy(req->waiters, slab_slots, sizeof(Mem_Req_Waiter) * req->op_count);
+    } else {
+      req->waiters = (Mem_Req_Waiter*)realloc(req->waiters, sizeof(Mem_Req_Waiter) * req->waiter_slots);
+      ASSERT(req->proc_id, req->waiters);
+    }
+  }
+  req->waiters[req->op_count].op = op;
+  req->waiters[req->op_count].unique_num = op->unique_num;
+  req->op_count++;
+}
 
+void mem_free_reqbuf(Mem_Req* req) {
   DEBUG(req->proc_id, "Freeing mem buffer entry  index:%d queue:%s rcount:%d l1:%d bo:%d lf:%d\n", req->id,
-        (NULL == req->queue) ? "NULL" : req->queue->name, mem->req_count, mem->l1_queue.entry_count,
+        (NULL == req->queue) ? "NULL" : req->queue->name, mem->req_count, mem_l1_queue_count(),
         mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count);
 
   if (req->state == MRS_MEM_DONE) {
@@ -564,23 +790,20 @@ void mem_free_reqbuf(Mem_Req* req) {
 
   ASSERT(req->proc_id, mem->num_req_buffers_per_core[req->proc_id] > 0);
   mem->num_req_buffers_per_core[req->proc_id] -= 1;
+  mem->num_req_buffers_shared -= 1;
   update_mem_req_occupancy_counter(req->type, -1);
 
   ASSERT(req->proc_id, req->reserved_entry_count == 0);
 
+  mem_req_addr_index_remove(req);
   req->state = MRS_INV;
   mem->req_count--;
   ASSERT(req->proc_id, mem->req_count >= 0);
-  clear_list(&req->op_ptrs);
-  clear_list(&req->op_uniques);
-
-  reqbuf_num_ptr = sl_list_add_tail(&mem->req_buffer_free_list);
+  req->op_count = 0;
 
-  ASSERT(req->proc_id, reqbuf_num_ptr);
-  *reqbuf_num_ptr = req->id;
-
-  ASSERT(req->proc_id, mem->req_buffer_free_list.count <= mem->total_mem_req_buffers);
-  ASSERT(req->proc_id, (mem->req_count + mem->req_buffer_free_list.count) == mem->total_mem_req_buffers);
+  ASSERT_CHEAP(req->proc_id, mem->req_buffer_free_count < (int)mem->total_mem_req_buffers);
+  mem->req_buffer_free_stack[mem->req_buffer_free_count++] = req->id;
+  ASSERT(req->proc_id, (mem->req_count + mem->req_buffer_free_count) == (int)mem->total_mem_req_buffers);
 }
 
 /**************************************************************************************/
@@ -652,8 +875,10 @@ void print_req_buffer() {
 
 void print_mem_queue(Mem_Queue_Type queue_type) {
   fprintf(stdout, "\n");
-  if (queue_type & QUEUE_L1)
-    print_mem_queue_generic(&(mem->l1_queue));
+  if (queue_type & QUEUE_L1) {
+    for (uns ii = 0; ii < mem->num_l1_slices; ii++)
+      print_mem_queue_generic(&(mem->l1_queues[ii]));
+  }
 
   if (queue_type & QUEUE_MLC)
     print_mem_queue_generic(&(mem->mlc_queue));
@@ -708,6 +933,7 @@ static inline void set_off_path_confirmed_status(Mem_Req* req) {
 /* recover_memory: */
 
 void recover_memory() {
+  UNCORE_LOCK_SCOPE();
   if (SET_OFF_PATH_CONFIRMED) {
     for (uns ii = 0; ii < mem->total_mem_req_buffers; ii++) {  // FIXME: inefficient
       Mem_Req* req = &(mem->req_buffer[ii]);
@@ -728,9 +954,9 @@ void recover_memory() {
 void debug_memory() {
   DPRINTF("# MEMORY\n");
   DPRINTF("reqbuf_used_count:    %d\n", mem->req_count);
-  DPRINTF("reqbuf_free_count:    %d\n", mem->req_buffer_free_list.count);
+  DPRINTF("reqbuf_free_count:    %d\n", mem->req_buffer_free_count);
   DPRINTF("mlc_queue_count:      %d\n", mem->mlc_queue.entry_count);
-  DPRINTF("l1_queue_count:       %d\n", mem->l1_queue.entry_count);
+  DPRINTF("l1_queue_count:       %d\n", mem_l1_queue_count());
   DPRINTF("bus_out_queue_count:  %d\n", mem->bus_out_queue.entry_count);
   DPRINTF("mlc_fill_queue_count: %d\n", mem->mlc_fill_queue.entry_count);
   DPRINTF("l1fill_queue_count:   %d\n", mem->l1fill_queue.entry_count);
@@ -743,15 +969,15 @@ void debug_memory() {
 /* update_memory: */
 
 static inline void queue_sanity_check(int location) {
-  int queue_count = mem->l1_queue.entry_count + mem->bus_out_queue.entry_count + mem->l1fill_queue.entry_count +
+  int queue_count = mem_l1_queue_count() + mem->bus_out_queue.entry_count + mem->l1fill_queue.entry_count +
                     mem->mlc_queue.entry_count + mem->mlc_fill_queue.entry_count;
 
   ASSERTM(0, mem->req_count == queue_count, "rc:%d l1:%d bo:%d lf:%d loc:%d\n", mem->req_count,
-          mem->l1_queue.entry_count, mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count, location);
+          mem_l1_queue_count(), mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count, location);
 
-  ASSERTM(0, (mem->req_count + mem->req_buffer_free_list.count) == mem->total_mem_req_buffers,
-          "rc:%d rf:%d l1:%d bo:%d lf:%d loc:%d\n", mem->req_count, mem->req_buffer_free_list.count,
-          mem->l1_queue.entry_count, mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count, location);
+  ASSERTM(0, (mem->req_count + mem->req_buffer_free_count) == mem->total_mem_req_buffers,
+          "rc:%d rf:%d l1:%d bo:%d lf:%d loc:%d\n", mem->req_count, mem->req_buffer_free_count,
+          mem_l1_queue_count(), mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count, location);
 }
 
 int cycle_l1q_insert_count = 0;
@@ -770,17 +996,17 @@ void update_memory_queues() {
   }
 
   if (!ALL_FIFO_QUEUES && (cycle_l1q_insert_count > 0)) {
-    qsort(mem->l1_queue.base, mem->l1_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_l1_queues_sort();
     cycle_l1q_insert_count = 0;
   }
 
   if (!ALL_FIFO_QUEUES && (cycle_mlcq_insert_count > 0)) {
-    qsort(mem->mlc_queue.base, mem->mlc_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_queue_sort(&mem->mlc_queue);
     cycle_mlcq_insert_count = 0;
   }
 
   if (!ALL_FIFO_QUEUES && (cycle_busoutq_insert_count > 0)) {
-    qsort(mem->bus_out_queue.base, mem->bus_out_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_queue_sort(&mem->bus_out_queue);
     cycle_busoutq_insert_count = 0;
   }
 }
@@ -808,6 +1034,19 @@ void update_on_chip_memory_stats() {
  *
  */
 void update_memory() {
+  update_memory_uncore();
+
+  // the core domains are created back to back, so only the ready ones tick
+  freq_tick_domains(FREQ_DOMAIN_CORES[0], NUM_CORES);
+}
+
+/**
+ * @brief the part of update_memory() shared by all cores: caches, queues and
+ * DRAM
+ */
+void update_memory_uncore() {
+  uns64 prof_start = HOST_PROF ? host_prof_ticks() : 0;
+
   if (freq_is_ready(FREQ_DOMAIN_L1)) {
     cycle_count = freq_cycle_count(FREQ_DOMAIN_L1);
 
@@ -816,6 +1055,7 @@ void update_memory() {
     pref_update();
     update_memory_queues();
     update_on_chip_memory_stats();
+    mem_drain_wb_buffers();
 
     mem_process_mlc_fill_reqs();
     mem_process_l1_fill_reqs();
@@ -825,23 +1065,54 @@ void update_memory() {
     cycle_count = freq_cycle_count(FREQ_DOMAIN_MEMORY);
 
     // dram_process_main_memory_reqs();
-    ramulator_tick();
+    HOST_PROF_SCOPE(0, HOST_PROF_RAMULATOR, ramulator_tick());
   }
 
   if (freq_is_ready(FREQ_DOMAIN_L1)) {
     cycle_count = freq_cycle_count(FREQ_DOMAIN_L1);
 
+    noc_tick();
     mem_process_bus_out_reqs();
     mem_process_l1_reqs();
     mem_process_mlc_reqs();
   }
 
+  if (HOST_PROF)
+    host_prof_add(0, HOST_PROF_MEMORY, prof_start);
+}
+
+/**
+ * @brief the per-core part of update_memory(): hands the finished requests of
+ * the core back to it, in the core's cycle_count
+ */
+void update_memory_core(uns proc_id) {
+  UNCORE_LOCK_SCOPE();
+  HOST_PROF_SCOPE(proc_id, HOST_PROF_MEMORY_CORE, mem_process_core_fill_reqs(proc_id));
+}
+
+/**
+ * @brief core domain tick registered by init_memory(): runs
+ * update_memory_core() in the core's cycle_count
+ */
+static void update_memory_core_tick(uns proc_id) {
+  cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
+  update_memory_core(proc_id);
+}
+
+/**
+ * @brief first L1 cycle at which the on-chip memory system has work to do: as
+ * long as all of its queues are empty it only waits for the NoC and DRAM. DRAM
+ * itself is ticked every memory cycle and does not take part in idle skipping.
+ */
+Counter memory_next_event_cycle() {
+  if (mem->mlc_queue.entry_count || mem->mlc_fill_queue.entry_count || mem_l1_queue_count() ||
+      mem->bus_out_queue.entry_count || mem->l1fill_queue.entry_count || mem->wb_buffered)
+    return cycle_count + 1;
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    if (freq_is_ready(FREQ_DOMAIN_CORES[proc_id])) {
-      cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[proc_id]);
-      mem_process_core_fill_reqs(proc_id);
-    }
+    if (mem->core_fill_queues[proc_id].entry_count)
+      return cycle_count + 1;
   }
+  return MAX2(noc_next_event_cycle(), cycle_count + 1);
 }
 
 /**************************************************************************************/
@@ -861,6 +1132,63 @@ int mem_compare_priority(const void* a, const void* b) {
     return 0;
 }
 
+/**************************************************************************************/
+/* mem_queue_sort: stable sort of a queue by priority. A queue is almost in
+ * order whenever it is sorted again: new entries are appended to the tail,
+ * removed entries are marked with the lowest priority and promotions move
+ * single entries. This is therefore a natural merge sort that merges the
+ * ordered runs already present in the queue. A sorted queue costs one scan
+ * without any copies, and k entries out of place cost O(n log k). */
+
+static void mem_queue_sort(Mem_Queue* queue) {
+  int count = queue->entry_count;
+  Mem_Queue_Entry* src = queue->base;
+  Mem_Queue_Entry* dst = queue->scratch;
+
+  while (TRUE) {
+    int start = 0;
+    int num_runs = 0;
+
+    while (start < count) {
+      int mid = start + 1;
+      while (mid < count && src[mid - 1].priority <= src[mid].priority)
+        mid++;
+      if (mid == count && start == 0)
+        break; /* the whole queue is one run */
+
+      int end = mid;
+      if (end < count) {
+        end++;
+        while (end < count && src[end - 1].priority <= src[end].priority)
+          end++;
+      }
+
+      /* merge [start, mid) and [mid, end), taking the left entry on ties */
+      int left = start, right = mid, out = start;
+      while (left < mid && right < end)
+        dst[out++] = src[right].priority < src[left].priority ? src[right++] : src[left++];
+      while (left < mid)
+        dst[out++] = src[left++];
+      while (right < end)
+        dst[out++] = src[right++];
+
+      num_runs++;
+      start = end;
+    }
+
+    if (num_runs == 0)
+      break;
+
+    Mem_Queue_Entry* tmp = src;
+    src = dst;
+    dst = tmp;
+  }
+
+  if (src != queue->base) {
+    memcpy(queue->base, src, sizeof(Mem_Queue_Entry) * count);
+  }
+}
+
 /**************************************************************************************/
 /* mem_start_mlc_access: */
 
@@ -870,8 +1198,9 @@ void mem_start_mlc_access(Mem_Req* req) {
   /* FIXME: Only WB reqs try to get a write port? How about stores? */
   Flag need_wp = ((req->type == MRT_WB) || (req->type == MRT_WB_NODIRTY));
   Flag need_rp = !need_wp;
-  if ((need_wp && get_write_port(&MLC(req->proc_id)->ports[req->mlc_bank])) ||
-      (need_rp && get_read_port(&MLC(req->proc_id)->ports[req->mlc_bank]))) {
+  Ports* ports = &MLC(req->proc_id)->ports[req->mlc_bank];
+  if ((need_wp && reserve_write_port(ports, 0, MLC_PORT_BUSY_CYCLES)) ||
+      (need_rp && reserve_read_port(ports, 0, MLC_PORT_BUSY_CYCLES))) {
     DEBUG(req->proc_id,
           "Mem request accessing MLC  index:%ld  type:%s  addr:0x%s  "
           "mem_bank:%d  size:%d  state: %s\n",
@@ -881,6 +1210,10 @@ void mem_start_mlc_access(Mem_Req* req) {
     avail = TRUE;
     req->state = MRS_MLC_WAIT;
     req->rdy_cycle = cycle_count + MLC_CYCLES;
+  } else {
+    // no use retrying before a port frees up
+    req->rdy_cycle = need_wp ? write_port_free_cycle(ports, MLC_PORT_BUSY_CYCLES)
+                             : read_port_free_cycle(ports, MLC_PORT_BUSY_CYCLES);
   }
 
   if (need_wp)
@@ -898,8 +1231,9 @@ void mem_start_l1_access(Mem_Req* req) {
   /* FIXME: Only WB reqs try to get a write port? How about stores? */
   Flag need_wp = ((req->type == MRT_WB) || (req->type == MRT_WB_NODIRTY));
   Flag need_rp = !need_wp;
-  if ((need_wp && get_write_port(&L1(req->proc_id)->ports[req->l1_bank])) ||
-      (need_rp && get_read_port(&L1(req->proc_id)->ports[req->l1_bank]))) {
+  Ports* ports = &L1_SLICE(req->proc_id, req->addr)->ports[req->l1_bank];
+  if ((need_wp && reserve_write_port(ports, 0, L1_PORT_BUSY_CYCLES)) ||
+      (need_rp && reserve_read_port(ports, 0, L1_PORT_BUSY_CYCLES))) {
     DEBUG(req->proc_id,
           "Mem request accessing L1  index:%ld  type:%s  addr:0x%s  "
           "mem_bank:%d  size:%d  state: %s\n",
@@ -920,6 +1254,10 @@ void mem_start_l1_access(Mem_Req* req) {
 
     mem->uncores[req->proc_id].num_outstanding_l1_accesses++;
     memview_l1(req);
+  } else {
+    // no use retrying before a port frees up
+    req->rdy_cycle = need_wp ? write_port_free_cycle(ports, L1_PORT_BUSY_CYCLES)
+                             : read_port_free_cycle(ports, L1_PORT_BUSY_CYCLES);
   }
 
   if (need_wp)
@@ -1013,7 +1351,8 @@ Flag mem_process_l1_hit_access(Mem_Req* req, Mem_Queue_Entry* l1_queue_entry, Ad
   }
 
   // this is just a stat collection
-  wp_process_l1_hit(data, req);
+  if (WP_COLLECT_STATS)
+    wp_process_l1_hit(l1_wp_data(L1_SLICE(req->proc_id, req->addr), data), req);
 
   if (L1_WRITE_THROUGH && (req->type == MRT_WB)) {
     req->state = MRS_BUS_NEW;
@@ -1344,7 +1683,7 @@ static Flag mem_process_mlc_miss_access(Mem_Req* req, Mem_Queue_Entry* mlc_queue
     }
   }
 
-  if (!queue_full(&mem->l1_queue)) {
+  if (!queue_full(L1_QUEUE(req->addr))) {
     req->state = MRS_L1_NEW;
     /* this req will be ready to be sent to memory in the  next cycle */
     req->rdy_cycle = cycle_count + MLCQ_TO_L1Q_TRANSFER_LATENCY;
@@ -1371,7 +1710,7 @@ static Flag mem_complete_l1_access(Mem_Req* req, Mem_Queue_Entry* l1_queue_entry
 
   if (L1_CACHE_HIT_POSITION_COLLECT || (L1_DYNAMIC_PARTITION_ENABLE && L1_DYNAMIC_PARTITION_POLICY == MARGINAL_UTIL)) {
     if ((req->type == MRT_DFETCH) || (req->type == MRT_DSTORE) || (req->type == MRT_IFETCH)) {
-      lru_position = cache_find_pos_in_lru_stack(&L1(req->proc_id)->cache, req->proc_id, req->addr, &line_addr);
+      lru_position = cache_find_pos_in_lru_stack(&L1_SLICE(req->proc_id, req->addr)->cache, req->proc_id, req->addr, &line_addr);
       ASSERT(req->proc_id, lru_position < (int)L1_ASSOC);
     }
   }
@@ -1389,7 +1728,7 @@ static Flag mem_complete_l1_access(Mem_Req* req, Mem_Queue_Entry* l1_queue_entry
       ASSERT(0, L1_CACHE_REPL_POLICY == REPL_PARTITION);
       ASSERT(0, ADDR_TRANSLATION == ADDR_TRANS_NONE);
 
-      l1_cache = &L1(req->proc_id)->cache;
+      l1_cache = &L1_SLICE(req->proc_id, req->addr)->cache;
       set = req->addr >> l1_cache->shift_bits & l1_cache->set_mask;
       if (set % 33 == 0) {
         set = set / 33;  // converting the addr
@@ -1422,10 +1761,11 @@ static Flag mem_complete_l1_access(Mem_Req* req, Mem_Queue_Entry* l1_queue_entry
   if (!PREFETCH_UPDATE_LRU_L1 && (req->type == MRT_DPRF || req->type == MRT_IPRF || req->type == MRT_UOCPRF ||
                                   req->type == MRT_FDIPPRFON || req->type == MRT_FDIPPRFOFF))
     update_l1_lru = FALSE;
-  data = (L1_Data*)cache_access(&L1(req->proc_id)->cache, req->addr, &line_addr,
+  data = (L1_Data*)cache_access(&L1_SLICE(req->proc_id, req->addr)->cache, req->addr, &line_addr,
                                 update_l1_lru);  // access L2
   req->l1_hit = data ? TRUE : FALSE;
   cache_part_l1_access(req);
+  stack_dist_access(req->proc_id, STACK_DIST_L1, req->addr, FALSE);
   if (FORCE_L1_MISS)
     data = NULL;
 
@@ -1473,7 +1813,7 @@ static Flag mem_complete_l1_access(Mem_Req* req, Mem_Queue_Entry* l1_queue_entry
         // bus_out_seq_num : 0);
         ASSERT(req->proc_id, MRS_L1_WAIT == req->state);
         req->state = MRS_MEM_NEW;
-        l1_hit_access = ramulator_send(req);
+        l1_hit_access = noc_send(req);
 
         if (!l1_hit_access) {
           // request rejected by Ramulator, so restore state to
@@ -1525,7 +1865,7 @@ static Flag mem_complete_l1_access(Mem_Req* req, Mem_Queue_Entry* l1_queue_entry
 
         ASSERT(req->proc_id, MRS_L1_WAIT == req->state);
         req->state = MRS_MEM_NEW;
-        l1_miss_access = ramulator_send(req);
+        l1_miss_access = noc_send(req);
         if (!l1_miss_access) {
           // STAT_EVENT(req->proc_id, REJECTED_QUEUE_BUS_OUT);
 
@@ -1629,6 +1969,7 @@ static Flag mem_complete_mlc_access(Mem_Req* req, Mem_Queue_Entry* mlc_queue_ent
     update_mlc_lru = FALSE;
   data = (MLC_Data*)cache_access(&MLC(req->proc_id)->cache, req->addr, &line_addr, update_mlc_lru);  // access MLC
   req->mlc_hit = data ? TRUE : FALSE;
+  stack_dist_access(req->proc_id, STACK_DIST_MLC, req->addr, FALSE);
 
   if (data || PERFECT_MLC) { /* mlc hit */
     /* if exclusive cache, invalidate the line in L2 if there is a done function
@@ -1648,7 +1989,7 @@ static Flag mem_complete_mlc_access(Mem_Req* req, Mem_Queue_Entry* mlc_queue_ent
       }
 
       if (MLC_WRITE_THROUGH && (req->type == MRT_WB)) {
-        req->queue = &(mem->l1_queue);
+        req->queue = L1_QUEUE(req->addr);
         mem_insert_req_into_queue(req, req->queue, ALL_FIFO_QUEUES ? l1_seq_num : 0);
         l1_seq_num++;
         (*l1_queue_insertion_count) += 1;
@@ -1663,9 +2004,9 @@ static Flag mem_complete_mlc_access(Mem_Req* req, Mem_Queue_Entry* mlc_queue_ent
     Flag mlc_miss_access = mem_process_mlc_miss_access(req, mlc_queue_entry, &line_addr, data);
     if (mlc_miss_access && mlc_miss_send_l1) {
       DEBUG(req->proc_id, "mlc miss request is inserted to l1 queue rc:%d mlc:%d bo:%d lf:%d\n", mem->req_count,
-            mem->mlc_queue.entry_count, mem->l1_queue.entry_count, mem->mlc_fill_queue.entry_count);
+            mem->mlc_queue.entry_count, mem_l1_queue_count(), mem->mlc_fill_queue.entry_count);
 
-      req->queue = &(mem->l1_queue);
+      req->queue = L1_QUEUE(req->addr);
       // queue full check is done in mem_process_mlc_miss_access
       mem_insert_req_into_queue(req, req->queue, ALL_FIFO_QUEUES ? l1_seq_num : 0);
       l1_seq_num++;
@@ -1694,22 +2035,26 @@ static Flag mem_complete_mlc_access(Mem_Req* req, Mem_Queue_Entry* mlc_queue_ent
 }
 
 /**************************************************************************************/
-/* mem_process_new_reqs: */
+/* mem_process_l1_slice_reqs: */
 /* Access L1 if port is ready - If L1 miss, then put the request into miss queue */
 
-static void mem_process_l1_reqs() {
+static void mem_process_l1_slice_reqs(Mem_Queue* l1_queue, int* out_queue_insertion_count) {
   Mem_Req* req = NULL;
   int ii;
   int reqbuf_id;
+  Counter next_rdy_cycle = MAX_CTR;
   int l1_queue_removal_count = 0;
-  int out_queue_insertion_count = 0;
+  int slice_out_insertion_count = 0;
   int l1_queue_reserve_entry_count = 0;
 
-  INC_STAT_EVENT(0, L1_QUEUE_OCCUPANCY, mem->l1_queue.entry_count);
+  if (mem_queue_idle(l1_queue))
+    return;
+  l1_queue->next_rdy_cycle = MAX_CTR;
+
   /* Go thru the l1_queue and try to access L1 for each request */
 
-  for (ii = 0; ii < mem->l1_queue.entry_count; ii++) {
-    reqbuf_id = mem->l1_queue.base[ii].reqbuf;
+  for (ii = 0; ii < l1_queue->entry_count; ii++) {
+    reqbuf_id = l1_queue->base[ii].reqbuf;
     req = &(mem->req_buffer[reqbuf_id]);
 
     // this is just a print
@@ -1718,12 +2063,15 @@ static void mem_process_l1_reqs() {
     }
 
     ASSERTM(req->proc_id, req->state != MRS_INV, "id:%d state:%s type:%s rc:%d l1:%d bi:%d lf:%d\n", req->id,
-            mem_req_state_names[req->state], Mem_Req_Type_str(req->type), mem->req_count, mem->l1_queue.entry_count,
+            mem_req_state_names[req->state], Mem_Req_Type_str(req->type), mem->req_count, l1_queue->entry_count,
             mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count);
 
     /* if the request is not yet ready, then try the next one */
-    if (cycle_count < req->rdy_cycle)
+    if (cycle_count < req->rdy_cycle) {
+      next_rdy_cycle = MIN2(next_rdy_cycle, req->rdy_cycle);
       continue;
+    }
+    next_rdy_cycle = MIN2(next_rdy_cycle, cycle_count + 1);
 
     /* Request is ready: see what state it is in */
 
@@ -1738,39 +2086,52 @@ static void mem_process_l1_reqs() {
         STAT_EVENT(req->proc_id, L1_DEMAND_ACCESS);
     } else {
       ASSERTM(req->proc_id, req->state == MRS_L1_WAIT, "id:%d state:%s type:%s rc:%d l1:%d bi:%d lf:%d\n", req->id,
-              mem_req_state_names[req->state], Mem_Req_Type_str(req->type), mem->req_count, mem->l1_queue.entry_count,
+              mem_req_state_names[req->state], Mem_Req_Type_str(req->type), mem->req_count, l1_queue->entry_count,
               mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count);
 
-      if (mem_complete_l1_access(req, &(mem->l1_queue.base[ii]), &out_queue_insertion_count,
+      if (mem_complete_l1_access(req, &(l1_queue->base[ii]), &slice_out_insertion_count,
                                  &l1_queue_reserve_entry_count))
         l1_queue_removal_count++;
     }
   }
+  l1_queue->next_rdy_cycle = MIN2(l1_queue->next_rdy_cycle, next_rdy_cycle);
 
-  ASSERT(req->proc_id, out_queue_insertion_count <= l1_queue_removal_count);
-  ASSERT(req->proc_id, l1_queue_reserve_entry_count <= out_queue_insertion_count);
+  ASSERT(req->proc_id, slice_out_insertion_count <= l1_queue_removal_count);
+  ASSERT(req->proc_id, l1_queue_reserve_entry_count <= slice_out_insertion_count);
+  *out_queue_insertion_count += slice_out_insertion_count;
 
   /* Remove requests from l1 access queue */
   if (l1_queue_removal_count > 0) {
     /* After this sort requests that should be removed will be at the tail of
      * the l1_queue */
     DEBUG(0, "l1_queue removal\n");
-    qsort(mem->l1_queue.base, mem->l1_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
-    mem->l1_queue.entry_count -= l1_queue_removal_count;
-    ASSERT(req->proc_id, mem->l1_queue.entry_count >= 0);
+    mem_queue_sort(l1_queue);
+    l1_queue->entry_count -= l1_queue_removal_count;
+    ASSERT(req->proc_id, l1_queue->entry_count >= 0);
     /* if HIER_MSHR_ON, requests stay in the queues until filled (by reserving
      * entries) */
     if (HIER_MSHR_ON) {
-      mem->l1_queue.reserved_entry_count += l1_queue_reserve_entry_count;
+      l1_queue->reserved_entry_count += l1_queue_reserve_entry_count;
     }
   }
+}
+
+/**************************************************************************************/
+/* mem_process_l1_reqs: */
+
+static void mem_process_l1_reqs() {
+  int out_queue_insertion_count = 0;
+
+  INC_STAT_EVENT(0, L1_QUEUE_OCCUPANCY, mem_l1_queue_count());
+  for (uns ii = 0; ii < mem->num_l1_slices; ii++)
+    mem_process_l1_slice_reqs(&mem->l1_queues[ii], &out_queue_insertion_count);
 
   /* Sort the out queue if requests were inserted */
   if (!ALL_FIFO_QUEUES && (out_queue_insertion_count > 0)) {
     if (CONSTANT_MEMORY_LATENCY) {  // request went straight to L1 fill queue
-      qsort(mem->l1fill_queue.base, mem->l1fill_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+      mem_queue_sort(&mem->l1fill_queue);
     } else {
-      qsort(mem->bus_out_queue.base, mem->bus_out_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+      mem_queue_sort(&mem->bus_out_queue);
     }
   }
 }
@@ -1783,11 +2144,16 @@ static void mem_process_mlc_reqs() {
   Mem_Req* req = NULL;
   int ii;
   int reqbuf_id;
+  Counter next_rdy_cycle = MAX_CTR;
   int mlc_queue_removal_count = 0;
   int l1_queue_insertion_count = 0;
   int mlc_queue_reserve_entry_count = 0;
 
-  INC_STAT_EVENT(0, MLC_QUEUE_OCCUPANCY, mem->l1_queue.entry_count);
+  INC_STAT_EVENT(0, MLC_QUEUE_OCCUPANCY, mem_l1_queue_count());
+  if (mem_queue_idle(&mem->mlc_queue))
+    return;
+  mem->mlc_queue.next_rdy_cycle = MAX_CTR;
+
   /* Go thru the mlc_queue and try to access MLC for each request */
 
   for (ii = 0; ii < mem->mlc_queue.entry_count; ii++) {
@@ -1801,11 +2167,14 @@ static void mem_process_mlc_reqs() {
 
     ASSERTM(req->proc_id, req->state != MRS_INV, "id:%d state:%s type:%s rc:%d mlc:%d l1:%d mf:%d\n", req->id,
             mem_req_state_names[req->state], Mem_Req_Type_str(req->type), mem->req_count, mem->mlc_queue.entry_count,
-            mem->l1_queue.entry_count, mem->mlc_fill_queue.entry_count);
+            mem_l1_queue_count(), mem->mlc_fill_queue.entry_count);
 
     /* if the request is not yet ready, then try the next one */
-    if (cycle_count < req->rdy_cycle)
+    if (cycle_count < req->rdy_cycle) {
+      next_rdy_cycle = MIN2(next_rdy_cycle, req->rdy_cycle);
       continue;
+    }
+    next_rdy_cycle = MIN2(next_rdy_cycle, cycle_count + 1);
 
     /* Request is ready: see what state it is in */
 
@@ -1822,12 +2191,13 @@ static void mem_process_mlc_reqs() {
     } else {
       ASSERTM(req->proc_id, req->state == MRS_MLC_WAIT, "id:%d state:%s type:%s rc:%d mlc:%d l1:%d mf:%d\n", req->id,
               mem_req_state_names[req->state], Mem_Req_Type_str(req->type), mem->req_count, mem->mlc_queue.entry_count,
-              mem->l1_queue.entry_count, mem->mlc_fill_queue.entry_count);
+              mem_l1_queue_count(), mem->mlc_fill_queue.entry_count);
       if (mem_complete_mlc_access(req, &(mem->mlc_queue.base[ii]), &l1_queue_insertion_count,
                                   &mlc_queue_reserve_entry_count))
         mlc_queue_removal_count++;
     }
   }
+  mem->mlc_queue.next_rdy_cycle = MIN2(mem->mlc_queue.next_rdy_cycle, next_rdy_cycle);
 
   ASSERT(req->proc_id, l1_queue_insertion_count <= mlc_queue_removal_count);
   ASSERT(req->proc_id, mlc_queue_reserve_entry_count <= l1_queue_insertion_count);
@@ -1837,7 +2207,7 @@ static void mem_process_mlc_reqs() {
     /* After this sort requests that should be removed will be at the tail of
      * the mlc_queue */
     DEBUG(0, "mlc_queue removal\n");
-    qsort(mem->mlc_queue.base, mem->mlc_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_queue_sort(&mem->mlc_queue);
     mem->mlc_queue.entry_count -= mlc_queue_removal_count;
     ASSERT(req->proc_id, mem->mlc_queue.entry_count >= 0);
     /* if HIER_MSHR_ON, requests stay in the queues until filled (by reserving
@@ -1849,7 +2219,7 @@ static void mem_process_mlc_reqs() {
 
   /* Sort the l1 queue if requests were inserted */
   if (!ALL_FIFO_QUEUES && (l1_queue_insertion_count > 0)) {
-    qsort(mem->l1_queue.base, mem->l1_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_l1_queues_sort();
   }
 }
 
@@ -2124,7 +2494,7 @@ static void mem_process_bus_out_reqs() {
     //}
 
     DEBUG(0, "bus_out_queue removal\n");
-    qsort(mem->bus_out_queue.base, mem->bus_out_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_queue_sort(&mem->bus_out_queue);
     mem->bus_out_queue.entry_count--;
     ASSERT(req->proc_id, mem->bus_out_queue.entry_count >= 0);
 
@@ -2189,13 +2559,13 @@ static void remove_from_l1_fill_queue(uns proc_id, int* p_l1fill_queue_removal_c
     /* After this sort requests that should be removed will be at the tail of
      * the l1_queue */
     DEBUG(0, "l1fill_queue removal\n");
-    qsort(mem->l1fill_queue.base, mem->l1fill_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_queue_sort(&mem->l1fill_queue);
     mem->l1fill_queue.entry_count -= *p_l1fill_queue_removal_count;
     ASSERT(proc_id, mem->l1fill_queue.entry_count >= 0);
     /* free corresponding reserved entries in the L1 queue if HIER_MSHR_ON */
     if (HIER_MSHR_ON) {
-      mem->l1_queue.reserved_entry_count -= *p_l1fill_queue_removal_count;
-      ASSERT(0, mem->l1_queue.reserved_entry_count >= 0);
+      mem->l1_queues[0].reserved_entry_count -= *p_l1fill_queue_removal_count;
+      ASSERT(0, mem->l1_queues[0].reserved_entry_count >= 0);
     }
   }
 
@@ -2210,8 +2580,13 @@ static void mem_process_l1_fill_reqs() {
   Mem_Req* req = NULL;
   int ii;
   int reqbuf_id;
+  Counter next_rdy_cycle = MAX_CTR;
   int l1fill_queue_removal_count = 0;
 
+  if (mem_queue_idle(&mem->l1fill_queue))
+    return;
+  mem->l1fill_queue.next_rdy_cycle = MAX_CTR;
+
   /* Go thru the l1fill_queue */
 
   for (ii = 0; ii < mem->l1fill_queue.entry_count; ii++) {
@@ -2223,8 +2598,11 @@ static void mem_process_l1_fill_reqs() {
     ASSERT(req->proc_id, req->type != MRT_WB_NODIRTY);
 
     /* if the request is not yet ready, then try the next one */
-    if (cycle_count < req->rdy_cycle)
+    if (cycle_count < req->rdy_cycle) {
+      next_rdy_cycle = MIN2(next_rdy_cycle, req->rdy_cycle);
       continue;
+    }
+    next_rdy_cycle = MIN2(next_rdy_cycle, cycle_count + 1);
 
     if (req->state == MRS_FILL_L1) {
       DEBUG(req->proc_id,
@@ -2295,6 +2673,7 @@ static void mem_process_l1_fill_reqs() {
       }
     }
   }
+  mem->l1fill_queue.next_rdy_cycle = MIN2(mem->l1fill_queue.next_rdy_cycle, next_rdy_cycle);
 
   if (req) {
     remove_from_l1_fill_queue(req->proc_id, &l1fill_queue_removal_count);
@@ -2308,8 +2687,13 @@ static void mem_process_mlc_fill_reqs() {
   Mem_Req* req;
   int ii;
   int reqbuf_id;
+  Counter next_rdy_cycle = MAX_CTR;
   int mlc_fill_queue_removal_count = 0;
 
+  if (mem_queue_idle(&mem->mlc_fill_queue))
+    return;
+  mem->mlc_fill_queue.next_rdy_cycle = MAX_CTR;
+
   /* Go thru the mlc_fill_queue */
 
   for (ii = 0; ii < mem->mlc_fill_queue.entry_count; ii++) {
@@ -2322,8 +2706,11 @@ static void mem_process_mlc_fill_reqs() {
     ASSERT(req->proc_id, req->destination < DEST_L1);
 
     /* if the request is not yet ready, then try the next one */
-    if (cycle_count < req->rdy_cycle)
+    if (cycle_count < req->rdy_cycle) {
+      next_rdy_cycle = MIN2(next_rdy_cycle, req->rdy_cycle);
       continue;
+    }
+    next_rdy_cycle = MIN2(next_rdy_cycle, cycle_count + 1);
 
     if (req->state == MRS_FILL_MLC) {
       DEBUG(req->proc_id,
@@ -2350,13 +2737,14 @@ static void mem_process_mlc_fill_reqs() {
       }
     }
   }
+  mem->mlc_fill_queue.next_rdy_cycle = MIN2(mem->mlc_fill_queue.next_rdy_cycle, next_rdy_cycle);
 
   /* Remove requests from mlc access queue */
   if (mlc_fill_queue_removal_count > 0) {
     /* After this sort requests that should be removed will be at the tail of
      * the mlc_queue */
     DEBUG(0, "mlc_fill_queue removal\n");
-    qsort(mem->mlc_fill_queue.base, mem->mlc_fill_queue.entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_queue_sort(&mem->mlc_fill_queue);
     mem->mlc_fill_queue.entry_count -= mlc_fill_queue_removal_count;
     ASSERT(req->proc_id, mem->mlc_fill_queue.entry_count >= 0);
     /* free corresponding reserved entries in the MLC queue if HIER_MSHR_ON */
@@ -2383,6 +2771,11 @@ static void mem_process_core_fill_reqs(uns proc_id) {
     reqbuf_id = core_fill_queue->base[ii].reqbuf;
     req = &(mem->req_buffer[reqbuf_id]);
 
+    /* A core catching up on a sync quantum only sees the fills that had
+       arrived by the cycle it is simulating */
+    if (cmp_threads_sync_lag && req->rdy_cycle > cycle_count)
+      continue;
+
     ASSERT(req->proc_id, req->proc_id == proc_id);
     ASSERT(req->proc_id, req->state != MRS_INV);
     ASSERT(req->proc_id, (req->type != MRT_WB) || req->wb_requested_back);
@@ -2407,7 +2800,7 @@ static void mem_process_core_fill_reqs(uns proc_id) {
     /* After this sort requests that should be removed will be at the tail of
      * the core_fill_queue */
     DEBUG(0, "core_fill_queue removal\n");
-    qsort(core_fill_queue->base, core_fill_queue->entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+    mem_queue_sort(core_fill_queue);
     core_fill_queue->entry_count -= core_fill_queue_removal_count;
     ASSERT(req->proc_id, core_fill_queue->entry_count >= 0);
   }
@@ -2417,6 +2810,7 @@ static void mem_process_core_fill_reqs(uns proc_id) {
 /* scan_stores: */
 
 Flag scan_stores(Addr addr, uns size) {
+  UNCORE_LOCK_SCOPE();
   uns ii;
 
   for (ii = 0; ii < mem->total_mem_req_buffers; ii++) {
@@ -2432,7 +2826,109 @@ Flag scan_stores(Addr addr, uns size) {
 }
 
 /**************************************************************************************/
-/* mem_search_reqbuf: */
+/* mem_req_addr_index: counts the live reqbufs under their (size, line address)
+   key, the same CACHE_SIZE_ADDR that mem_search_queue compares.  Open
+   addressing with linear probing and backward-shift deletion; the table holds
+   at least twice as many slots as there are reqbufs so it never fills up. */
+
+static inline uns mem_req_addr_index_slot(Addr addr, uns size) {
+  return (uns)(((addr ^ ((uns64)size << 48)) * 0x9e3779b97f4a7c15ULL) >> mem->req_addr_index_shift);
+}
+
+static void mem_req_addr_index_init(void) {
+  uns bits = 1;
+  while ((1U << bits) < 2 * mem->total_mem_req_buffers)
+    bits++;
+  mem->req_addr_index_shift = 64 - bits;
+  mem->req_addr_index = (Mem_Req_Addr_Index_Entry*)calloc(1U << bits, sizeof(Mem_Req_Addr_Index_Entry));
+  /* there can never be more distinct live sizes than live reqbufs */
+  mem->req_addr_index_sizes = (uns*)calloc(mem->total_mem_req_buffers, sizeof(uns));
+  mem->req_addr_index_size_counts = (uns*)calloc(mem->total_mem_req_buffers, sizeof(uns));
+  mem->req_addr_index_num_sizes = 0;
+}
+
+static void mem_req_addr_index_insert(Mem_Req* req) {
+  uns mask = (1U << (64 - mem->req_addr_index_shift)) - 1;
+  Addr addr = CACHE_SIZE_ADDR(req->size, req->addr);
+  uns slot = mem_req_addr_index_slot(addr, req->size);
+  uns ii;
+
+  while (mem->req_addr_index[slot].count &&
+         (mem->req_addr_index[slot].addr != addr || mem->req_addr_index[slot].size != req->size))
+    slot = (slot + 1) & mask;
+  if (!mem->req_addr_index[slot].count) {
+    mem->req_addr_index[slot].addr = addr;
+    mem->req_addr_index[slot].size = req->size;
+  }
+  mem->req_addr_index[slot].count++;
+
+  for (ii = 0; ii < mem->req_addr_index_num_sizes; ii++)
+    if (mem->req_addr_index_sizes[ii] == req->size)
+      break;
+  if (ii == mem->req_addr_index_num_sizes) {
+    ASSERT(req->proc_id, ii < mem->total_mem_req_buffers);
+    mem->req_addr_index_sizes[ii] = req->size;
+    mem->req_addr_index_size_counts[ii] = 0;
+    mem->req_addr_index_num_sizes++;
+  }
+  mem->req_addr_index_size_counts[ii]++;
+}
+
+static void mem_req_addr_index_remove(Mem_Req* req) {
+  uns mask = (1U << (64 - mem->req_addr_index_shift)) - 1;
+  Addr addr = CACHE_SIZE_ADDR(req->size, req->addr);
+  uns slot = mem_req_addr_index_slot(addr, req->size);
+  uns next, home, ii;
+
+  while (mem->req_addr_index[slot].addr != addr || mem->req_addr_index[slot].size != req->size ||
+         !mem->req_addr_index[slot].count) {
+    ASSERTM(req->proc_id, mem->req_addr_index[slot].count, "Req index:%d addr:0x%s missing from the address index\n",
+            req->id, hexstr64s(req->addr));
+    slot = (slot + 1) & mask;
+  }
+
+  if (--mem->req_addr_index[slot].count == 0) {
+    /* pull later entries of the probe run back over the hole */
+    for (next = (slot + 1) & mask; mem->req_addr_index[next].count; next = (next + 1) & mask) {
+      home = mem_req_addr_index_slot(mem->req_addr_index[next].addr, mem->req_addr_index[next].size);
+      if (((next - home) & mask) >= ((next - slot) & mask)) {
+        mem->req_addr_index[slot] = mem->req_addr_index[next];
+        mem->req_addr_index[next].count = 0;
+        slot = next;
+      }
+    }
+  }
+
+  for (ii = 0; ii < mem->req_addr_index_num_sizes; ii++)
+    if (mem->req_addr_index_sizes[ii] == req->size)
+      break;
+  ASSERT(req->proc_id, ii < mem->req_addr_index_num_sizes);
+  if (--mem->req_addr_index_size_counts[ii] == 0) {
+    mem->req_addr_index_num_sizes--;
+    mem->req_addr_index_sizes[ii] = mem->req_addr_index_sizes[mem->req_addr_index_num_sizes];
+    mem->req_addr_index_size_counts[ii] = mem->req_addr_index_size_counts[mem->req_addr_index_num_sizes];
+  }
+}
+
+/* FALSE only if no live reqbuf can pass the address check of
+   mem_search_queue for addr */
+static inline Flag mem_req_addr_index_may_match(Addr addr) {
+  uns mask = (1U << (64 - mem->req_addr_index_shift)) - 1;
+  uns ii;
+
+  for (ii = 0; ii < mem->req_addr_index_num_sizes; ii++) {
+    uns size = mem->req_addr_index_sizes[ii];
+    Addr line_addr = CACHE_SIZE_ADDR(size, addr);
+    uns slot = mem_req_addr_index_slot(line_addr, size);
+    for (; mem->req_addr_index[slot].count; slot = (slot + 1) & mask)
+      if (mem->req_addr_index[slot].addr == line_addr && mem->req_addr_index[slot].size == size)
+        return TRUE;
+  }
+  return FALSE;
+}
+
+/**************************************************************************************/
+/* mem_search_queue: */
 
 static inline Mem_Req* mem_search_queue(
     Mem_Queue* queue, uns8 proc_id, Addr addr, Mem_Req_Type type, uns size,
@@ -2583,6 +3079,14 @@ static inline Mem_Req* mem_search_reqbuf(
   ASSERTM(proc_id, proc_id == get_proc_id_from_cmp_addr(addr), "Proc ID (%d) does not match proc ID in address (%d)!\n",
           proc_id, get_proc_id_from_cmp_addr(addr));
 
+  /* Every request in the queues below is a live reqbuf, so if no reqbuf has
+     this line address none of the scans can match.  The ramulator queue
+     matches on physical address and is always searched. */
+  if (!mem_req_addr_index_may_match(addr)) {
+    STAT_EVENT(proc_id, MEM_REQ_ADDR_INDEX_FILTERED);
+    queues_to_search &= QUEUE_MEM;
+  }
+
   if (queues_to_search & QUEUE_MLC_FILL) {
     req = mem_search_queue(&mem->mlc_fill_queue, proc_id, addr, type, size, demand_hit_prefetch, demand_hit_writeback,
                            queue_entry, TRUE);
@@ -2600,6 +3104,8 @@ static inline Mem_Req* mem_search_reqbuf(
   // ASSERT(proc_id, !(queues_to_search & QUEUE_MEM));
   if (queues_to_search & QUEUE_MEM) {
     req = ramulator_search_queue(addr_translate(addr), type);
+    if (!req)
+      req = noc_search_queue(addr_translate(addr), type);
     if (req) {
       *ramulator_match = TRUE;
       if (req->type == MRT_IPRF) {
@@ -2626,7 +3132,7 @@ static inline Mem_Req* mem_search_reqbuf(
   }
 
   if (queues_to_search & QUEUE_L1) {
-    req = mem_search_queue(&mem->l1_queue, proc_id, addr, type, size, demand_hit_prefetch, demand_hit_writeback,
+    req = mem_search_queue(L1_QUEUE(addr), proc_id, addr, type, size, demand_hit_prefetch, demand_hit_writeback,
                            queue_entry, TRUE);
     if (req)
       return req;
@@ -2656,8 +3162,6 @@ Flag mem_adjust_matching_request(Mem_Req* req, Mem_Req_Type type, Addr addr, uns
   // TODO: Should we change ramulator queue priority on match?
   if (!ramulator_match)
     old_priority = (*queue_entry)->priority;  // this is the old priority of request in the queue
-  Op** op_ptr = NULL;
-  Counter* op_unique = NULL;
   Counter current_priority;
 
   current_priority = new_priority;
@@ -2673,7 +3177,8 @@ Flag mem_adjust_matching_request(Mem_Req* req, Mem_Req_Type type, Addr addr, uns
     INC_STAT_EVENT(req->proc_id, MEM_REQ_DEMAND_ICACHE_CYCLE_DELTA, cycle_count - req->demand_icache_emitted_cycle);
   }
 
-  wp_process_reqbuf_match(req, op);
+  if (WP_COLLECT_STATS)
+    wp_process_reqbuf_match(req, op);
 
   if (ALLOW_TYPE_MATCHES && demand_hit_writeback) {
     ASSERT(req->proc_id, (req->type == MRT_WB) || (req->type == MRT_WB_NODIRTY));
@@ -2718,11 +3223,7 @@ Flag mem_adjust_matching_request(Mem_Req* req, Mem_Req_Type type, Addr addr, uns
     // writebacks do not have associated ops
     ASSERT(req->proc_id, req->type != MRT_WB && req->type != MRT_WB_NODIRTY);
 
-    req->op_count++;
-    op_ptr = sl_list_add_tail(&req->op_ptrs);
-    *op_ptr = op;
-    op_unique = sl_list_add_tail(&req->op_uniques);
-    *op_unique = op->unique_num;
+    mem_req_add_waiter(req, op);
 
     if (op->table_info->mem_type == MEM_ST && !op->off_path)
       req->dirty_l0 = TRUE;
@@ -2803,8 +3304,7 @@ Flag mem_adjust_matching_request(Mem_Req* req, Mem_Req_Type type, Addr addr, uns
         req->type = type;
         memview_req_changed_type(req);
       }
-      qsort(req->queue->base, req->queue->entry_count, sizeof(Mem_Queue_Entry),
-            mem_compare_priority); /* Sort the associated queue */
+      mem_queue_sort(req->queue); /* Sort the associated queue */
     }
 
     switch (req->queue->type) {
@@ -2899,72 +3399,129 @@ Flag mem_adjust_matching_request(Mem_Req* req, Mem_Req_Type type, Addr addr, uns
 /* mem_can_allocate_req_buffer: */
 
 Flag mem_can_allocate_req_buffer(uns proc_id, Mem_Req_Type type, Flag for_l1_writeback) {
-  Counter watermark = MEM_REQ_BUFFER_PREF_WATERMARK;
+  UNCORE_LOCK_SCOPE();
+  // only an L1 (i.e., LLC) writeback may take the last entry: it is the only
+  // type of request that is guaranteed not to cause additional write backs
+  // (and hence guaranteed to not require additional mem_req entries), so
+  // keeping it free ensures deadlock freedom
+  ASSERT(proc_id, !for_l1_writeback || type == MRT_WB);
+  Mem_Credit_Class credit_class = for_l1_writeback ? MEM_CREDIT_L1_WB : mem_req_credit_class[type];
+  return *mem->req_buffer_pool[proc_id] < mem->req_buffer_credits[credit_class];
+}
 
-  if (type == MRT_IPRF || type == MRT_DPRF || type == MRT_UOCPRF || type == MRT_FDIPPRFON || type == MRT_FDIPPRFOFF) {
-    if (PRIVATE_MSHR_ON && mem->num_req_buffers_per_core[proc_id] + watermark >= MEM_REQ_BUFFER_ENTRIES) {
-      return FALSE;
-    } else if (!PRIVATE_MSHR_ON && mem->req_buffer_free_list.count <= watermark) {
-      return FALSE;
-    }
-  }
+/**************************************************************************************/
+/* mem_allocate_req_buffer: */
+/* If queue is specified, only allocates if its entry_count < size */
 
-  if (type != MRT_WB && type != MRT_WB_NODIRTY) {
-    if (PRIVATE_MSHR_ON && mem->num_req_buffers_per_core[proc_id] + MEM_REQ_BUFFER_WB_VALVE >= MEM_REQ_BUFFER_ENTRIES) {
-      return FALSE;
-    } else if (!PRIVATE_MSHR_ON && mem->req_buffer_free_list.count <= MEM_REQ_BUFFER_WB_VALVE) {
-      return FALSE;
-    }
-  }
+static inline Mem_Req* mem_allocate_req_buffer(uns proc_id, Mem_Req_Type type, Flag for_l1_writeback) {
+  if (!mem_can_allocate_req_buffer(proc_id, type, for_l1_writeback))
+    return FALSE;
 
-  // to ensure deadlock freedom, we need to make sure that there will at least
-  // be space for a L1 (i.e., LLC) writeback, since this is the only type of
-  // request that is guaranteed not to cause additional write backs (and hence
-  // guaranteed to not require additional mem_req entries)
-  if (PRIVATE_MSHR_ON && mem->num_req_buffers_per_core[proc_id] + 1 >= MEM_REQ_BUFFER_ENTRIES) {
-    if (!for_l1_writeback) {
-      return FALSE;
-    } else {
-      ASSERT(proc_id, MRT_WB == type);
-    }
+  ASSERT_CHEAP(0, mem->req_buffer_free_count > 0);
+  int reqbuf_num = mem->req_buffer_free_stack[--mem->req_buffer_free_count];
+  ASSERT(0, mem->req_buffer[reqbuf_num].state == MRS_INV);
+  mem->num_req_buffers_per_core[proc_id] += 1;
+  mem->num_req_buffers_shared += 1;
+  update_mem_req_occupancy_counter(type, +1);
+  return &(mem->req_buffer[reqbuf_num]);
+}
 
-  } else if (!PRIVATE_MSHR_ON && mem->req_buffer_free_list.count <= 1) {
-    if (!for_l1_writeback) {
-      return FALSE;
-    } else {
-      ASSERT(proc_id, MRT_WB == type);
-    }
-  }
+/**************************************************************************************/
+/* mem_pref_heap_*: binary min-heaps of prefetch queue entries by age, ties
+ * broken by insertion order */
 
-  if (PRIVATE_MSHR_ON) {
-    ASSERT(proc_id, mem->num_req_buffers_per_core[proc_id] <= MEM_REQ_BUFFER_ENTRIES);
-    if (mem->num_req_buffers_per_core[proc_id] == MEM_REQ_BUFFER_ENTRIES)
-      return FALSE;
+static inline Flag mem_pref_heap_older(const Mem_Pref_Heap_Entry* a, const Mem_Pref_Heap_Entry* b) {
+  return a->start_cycle < b->start_cycle || (a->start_cycle == b->start_cycle && a->insert_num < b->insert_num);
+}
+
+static void mem_pref_heap_sift_down(Mem_Pref_Heap* heap, uns pos) {
+  Mem_Pref_Heap_Entry entry = heap->entries[pos];
+  while (2 * pos + 1 < heap->count) {
+    uns child = 2 * pos + 1;
+    if (child + 1 < heap->count && mem_pref_heap_older(&heap->entries[child + 1], &heap->entries[child]))
+      child++;
+    if (!mem_pref_heap_older(&heap->entries[child], &entry))
+      break;
+    heap->entries[pos] = heap->entries[child];
+    pos = child;
   }
+  heap->entries[pos] = entry;
+}
 
-  if (mem->req_count == mem->total_mem_req_buffers) {
-    ASSERT(0, sl_list_remove_head(&mem->req_buffer_free_list) == 0);
-    return FALSE;
+static void mem_pref_heap_push(Mem_Pref_Heap* heap, Mem_Pref_Heap_Entry entry) {
+  if (heap->count == heap->size) {
+    heap->size = heap->size ? 2 * heap->size : 16;
+    heap->entries = (Mem_Pref_Heap_Entry*)realloc(heap->entries, sizeof(Mem_Pref_Heap_Entry) * heap->size);
+  }
+  uns pos = heap->count++;
+  while (pos && mem_pref_heap_older(&entry, &heap->entries[(pos - 1) / 2])) {
+    heap->entries[pos] = heap->entries[(pos - 1) / 2];
+    pos = (pos - 1) / 2;
   }
+  heap->entries[pos] = entry;
+}
 
-  return TRUE;
+static void mem_pref_heap_pop(Mem_Pref_Heap* heap) {
+  ASSERT(0, heap->count);
+  heap->entries[0] = heap->entries[--heap->count];
+  if (heap->count)
+    mem_pref_heap_sift_down(heap, 0);
 }
 
 /**************************************************************************************/
-/* mem_allocate_req_buffer: */
-/* If queue is specified, only allocates if its entry_count < size */
+/* mem_pref_entry_live: can the entry's request still be kicked out of the
+ * queue? Its presence in the queue is only checked for the chosen victim. */
 
-static inline Mem_Req* mem_allocate_req_buffer(uns proc_id, Mem_Req_Type type, Flag for_l1_writeback) {
-  if (!mem_can_allocate_req_buffer(proc_id, type, for_l1_writeback))
-    return FALSE;
+static inline Flag mem_pref_entry_live(Mem_Queue* queue, const Mem_Pref_Heap_Entry* entry) {
+  Mem_Req* req = &mem->req_buffer[entry->reqbuf];
+  return req->state != MRS_INV && req->state < MRS_MEM_WAIT && req->queue == queue &&
+         req->queue_insert_num == entry->insert_num && mem_req_type_is_prefetch(req->type);
+}
 
-  int* reqbuf_num_ptr = sl_list_remove_head(&mem->req_buffer_free_list);
+/**************************************************************************************/
+/* mem_pref_index_insert: */
+
+static void mem_pref_index_insert(Mem_Queue* queue, Mem_Req* req) {
+  Mem_Pref_Heap_Entry entry = {req->start_cycle, req->queue_insert_num, req->id};
+  for (uns ii = 0; ii < 2 && ii < queue->num_pref_heaps; ii++) {
+    Mem_Pref_Heap* heap = ii == 0 ? &queue->pref_heaps[0]
+                                  : &queue->pref_heaps[1 + req->mem_flat_bank % (queue->num_pref_heaps - 1)];
+    /* a queue holds at most size live entries, so compacting at twice that
+     * keeps the heap bounded at a linear cost per insertion */
+    if (heap->count >= 2 * queue->size) {
+      uns live = 0;
+      for (uns jj = 0; jj < heap->count; jj++) {
+        if (mem_pref_entry_live(queue, &heap->entries[jj]))
+          heap->entries[live++] = heap->entries[jj];
+      }
+      heap->count = live;
+      for (uns jj = live / 2; jj-- > 0;)
+        mem_pref_heap_sift_down(heap, jj);
+    }
+    mem_pref_heap_push(heap, entry);
+  }
+}
 
-  ASSERT(0, reqbuf_num_ptr);
-  ASSERT(0, mem->req_buffer[*reqbuf_num_ptr].state == MRS_INV);
-  mem->num_req_buffers_per_core[proc_id] += 1;
-  update_mem_req_occupancy_counter(type, +1);
-  return &(mem->req_buffer[*reqbuf_num_ptr]);
+/**************************************************************************************/
+/* mem_pref_index_oldest: the oldest prefetch in the heap that can still be
+ * kicked out, with its position in the queue */
+
+static Mem_Req* mem_pref_index_oldest(Mem_Queue* queue, Mem_Pref_Heap* heap, uns mem_bank, Flag within_bank,
+                                      int* queue_index) {
+  while (heap->count) {
+    const Mem_Pref_Heap_Entry* top = &heap->entries[0];
+    Mem_Req* req = &mem->req_buffer[top->reqbuf];
+    if (mem_pref_entry_live(queue, top) && (!within_bank || req->mem_flat_bank == mem_bank)) {
+      for (int ii = 0; ii < queue->entry_count; ii++) {
+        if (queue->base[ii].reqbuf == top->reqbuf) {
+          *queue_index = ii;
+          return req;
+        }
+      }
+    }
+    mem_pref_heap_pop(heap);
+  }
+  return NULL;
 }
 
 /**************************************************************************************/
@@ -2978,51 +3535,20 @@ static Mem_Req* mem_kick_out_prefetch_from_queue(uns mem_bank, Mem_Queue* queue,
 
   int kickout_reqbuf_num;
 
-  // FIXME: May need to sort the queue here
-
   if (queue->entry_count == 0)
     return NULL;
 
-  qsort(queue->base, queue->entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
-
   if (KICKOUT_OLDEST_PREFETCH) {
-    int ii, oldest_index = 0;
+    int oldest_index = 0;
     Mem_Req* req_kicked_out = NULL;
-    Counter oldest_req_age = MAX_CTR;
 
+    ASSERT(0, queue->pref_heaps);
     if (KICKOUT_OLDEST_PREFETCH_WITHIN_BANK) {
-      for (ii = 0; ii < queue->entry_count; ii++) {
-        Mem_Req* req = &(mem->req_buffer[queue->base[ii].reqbuf]);
-        if (req->type != MRT_IPRF && req->type != MRT_DPRF && req->type != MRT_UOCPRF && req->type != MRT_FDIPPRFON &&
-            req->type != MRT_FDIPPRFOFF)
-          continue;
-        if (oldest_req_age > req->start_cycle && mem_bank == req->mem_flat_bank) {
-          if (req->state < MRS_MEM_WAIT) {
-            oldest_req_age = req->start_cycle;
-            req_kicked_out = req;
-            oldest_index = ii;
-          }
-        }
-      }
-    }
-
-    if (!req_kicked_out) {
-      oldest_req_age = MAX_CTR;
-      // Search for the oldest prefetch
-      for (ii = 0; ii < queue->entry_count; ii++) {
-        Mem_Req* req = &(mem->req_buffer[queue->base[ii].reqbuf]);
-        if (req->type != MRT_IPRF && req->type != MRT_DPRF && req->type != MRT_UOCPRF && req->type != MRT_FDIPPRFON &&
-            req->type != MRT_FDIPPRFOFF)
-          continue;
-        if (oldest_req_age > req->start_cycle) {
-          if (req->state < MRS_MEM_WAIT) {
-            oldest_req_age = req->start_cycle;
-            req_kicked_out = req;
-            oldest_index = ii;
-          }
-        }
-      }
+      Mem_Pref_Heap* bank_heap = &queue->pref_heaps[1 + mem_bank % (queue->num_pref_heaps - 1)];
+      req_kicked_out = mem_pref_index_oldest(queue, bank_heap, mem_bank, TRUE, &oldest_index);
     }
+    if (!req_kicked_out)
+      req_kicked_out = mem_pref_index_oldest(queue, &queue->pref_heaps[0], mem_bank, FALSE, &oldest_index);
 
     // If the oldest prefetch found
     if (req_kicked_out) {
@@ -3030,13 +3556,14 @@ static Mem_Req* mem_kick_out_prefetch_from_queue(uns mem_bank, Mem_Queue* queue,
       STAT_EVENT(req_kicked_out->proc_id, ONPATH_KICKED_OUT_PREFETCH);
       queue->base[oldest_index].priority = Mem_Req_Priority_Offset[MRT_MIN_PRIORITY];
       DEBUG(0, "%s removal\n", queue->name);
-      qsort(queue->base, queue->entry_count, sizeof(Mem_Queue_Entry), mem_compare_priority);
+      mem_queue_sort(queue);
       queue->entry_count--;
-      pref_req_drop_process(req_kicked_out->proc_id, mem->req_buffer[queue->base[oldest_index].reqbuf].prefetcher_id);
+      pref_req_drop_process(req_kicked_out->proc_id, req_kicked_out->prefetcher_id);
     }
 
     return req_kicked_out;
   } else {
+    mem_queue_sort(queue);
     kickout_reqbuf_num = queue->base[queue->entry_count - 1].reqbuf;
     if (mem->req_buffer[kickout_reqbuf_num].type == MRT_DPRF &&
         mem->req_buffer[kickout_reqbuf_num].state < MRS_MEM_WAIT) {
@@ -3065,9 +3592,11 @@ static Mem_Req* mem_kick_out_prefetch_from_queues(uns mem_bank, Counter new_prio
   Mem_Req* req;
 
   if (queues_to_search & QUEUE_L1) {
-    req = mem_kick_out_prefetch_from_queue(mem_bank, &mem->l1_queue, new_priority);
-    if (req)
-      return req;
+    for (uns ii = 0; ii < mem->num_l1_slices; ii++) {
+      req = mem_kick_out_prefetch_from_queue(mem_bank, &mem->l1_queues[ii], new_priority);
+      if (req)
+        return req;
+    }
   }
 
   if (queues_to_search & QUEUE_BUS_OUT) {
@@ -3122,9 +3651,11 @@ static Mem_Req* mem_kick_out_oldest_first_prefetch_from_queues(uns mem_bank, Cou
   }
 
   if (queues_to_search & QUEUE_L1) {
-    req = mem_kick_out_prefetch_from_queue(mem_bank, &mem->l1_queue, new_priority);
-    if (req)
-      return req;
+    for (uns ii = 0; ii < mem->num_l1_slices; ii++) {
+      req = mem_kick_out_prefetch_from_queue(mem_bank, &mem->l1_queues[ii], new_priority);
+      if (req)
+        return req;
+    }
   }
 
   return NULL;
@@ -3150,6 +3681,7 @@ static void mem_init_new_req(Mem_Req* new_req, Mem_Req_Type type, Mem_Queue_Type
   if (!kicked_out_another) {
     mem->req_count++;
   } else {
+    mem_req_addr_index_remove(new_req);
     mem_clear_reqbuf(new_req);
   }
 
@@ -3171,7 +3703,7 @@ static void mem_init_new_req(Mem_Req* new_req, Mem_Req_Type type, Mem_Queue_Type
     new_req->fdip_emitted_cycle = 0;
   }
   mem_req_set_types(new_req, type);
-  new_req->queue = to_mlc ? &mem->mlc_queue : &mem->l1_queue;
+  new_req->queue = to_mlc ? &mem->mlc_queue : L1_QUEUE(addr);
   new_req->proc_id = proc_id;
   new_req->addr = addr;
   new_req->phys_addr = addr_translate(addr);
@@ -3181,6 +3713,7 @@ static void mem_init_new_req(Mem_Req* new_req, Mem_Req_Type type, Mem_Queue_Type
   new_req->priority = new_priority;
   new_req->size = size;
   ASSERT(new_req->proc_id, new_req->size <= VA_PAGE_SIZE_BYTES);
+  mem_req_addr_index_insert(new_req);
   new_req->reserved_entry_count = 0;
   // TODO: actually populate mem_flat_bank, mem_channel, and mem_bank by
   // grabbing that information from Ramulator
@@ -3192,7 +3725,7 @@ static void mem_init_new_req(Mem_Req* new_req, Mem_Req_Type type, Mem_Queue_Type
   new_req->mem_bank = BANK_IN_CHANNEL(new_req->mem_flat_bank, RAMULATOR_BANKS);
   */
   new_req->mlc_bank = BANK(addr, MLC(proc_id)->num_banks, MLC_INTERLEAVE_FACTOR);
-  new_req->l1_bank = BANK(addr, L1(proc_id)->num_banks, L1_INTERLEAVE_FACTOR);
+  new_req->l1_bank = BANK(addr, L1_SLICE(proc_id, addr)->num_banks, L1_INTERLEAVE_FACTOR);
   new_req->start_cycle = freq_cycle_count(FREQ_DOMAIN_L1) + delay;
   new_req->rdy_cycle = freq_cycle_count(FREQ_DOMAIN_L1) + delay;
   new_req->first_stalling_cycle = mem_req_type_is_stalling(type) ? new_req->start_cycle : MAX_CTR;
@@ -3231,11 +3764,7 @@ static void mem_init_new_req(Mem_Req* new_req, Mem_Req_Type type, Mem_Queue_Type
   if (op) {
     ASSERT(new_req->proc_id, new_req->proc_id == op->proc_id);
 
-    Op** op_ptr = sl_list_add_tail(&new_req->op_ptrs);
-    Counter* op_unique = sl_list_add_tail(&new_req->op_uniques);
-    *op_ptr = op;
-    *op_unique = op->unique_num;
-    new_req->op_count++;
+    mem_req_add_waiter(new_req, op);
 
     new_req->oldest_op_unique_num = op->unique_num;
     new_req->oldest_op_op_num = op->op_num;
@@ -3294,20 +3823,26 @@ static inline Mem_Queue_Entry* mem_insert_req_into_queue(Mem_Req* new_req, Mem_Q
   if (queue->entry_count >= (queue->size - queue->reserved_entry_count)) {
     print_mem_queue(QUEUE_L1 | QUEUE_BUS_OUT | QUEUE_MEM | QUEUE_L1FILL | QUEUE_MLC | QUEUE_MLC_FILL);
   }
-  ASSERTM(new_req->proc_id, queue->entry_count < (queue->size - queue->reserved_entry_count),
+  ASSERTM_CHEAP(new_req->proc_id, queue->entry_count < (queue->size - queue->reserved_entry_count),
           "name:%s  count:%d  size:%d  reserved:%d  reqbuf:%d  rc:%d l1:%d "
           "bo:%d lf:%d rf:%d\n",
           queue->name, queue->entry_count, queue->size, queue->reserved_entry_count, new_req->id, mem->req_count,
-          mem->l1_queue.entry_count, mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count,
-          mem->req_buffer_free_list.count);
+          mem_l1_queue_count(), mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count,
+          mem->req_buffer_free_count);
 
   Mem_Queue_Entry* new_entry = &queue->base[queue->entry_count];
   new_entry->reqbuf = new_req->id;
+  /* the new entry's rdy_cycle may still be set after insertion, so the next
+   * walk must look at the queue */
+  queue->next_rdy_cycle = 0;
   new_entry->priority = priority > 0 ? priority : new_req->priority;
   queue->entry_count++;
+  new_req->queue_insert_num = ++mem->queue_insert_count;
+  if (queue->pref_heaps && mem_req_type_is_prefetch(new_req->type))
+    mem_pref_index_insert(queue, new_req);
 
   DEBUG(new_req->proc_id, "Inserted into %s index:%d pri:%s rc:%d l1:%d bo:%d lf:%d\n", queue->name, new_req->id,
-        unsstr64(priority > 0 ? priority : new_req->priority), mem->req_count, mem->l1_queue.entry_count,
+        unsstr64(priority > 0 ? priority : new_req->priority), mem->req_count, mem_l1_queue_count(),
         mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count);
   return new_entry;
 }
@@ -3321,7 +3856,7 @@ void mem_insert_req_round_robin() {
 
   while (l1_in_buf_count) {
     for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-      req_ptr = sl_list_remove_head(&mem->l1_in_buffer_core[proc_id]);
+      req_ptr = deque_remove_head(&mem->l1_in_buffer_core[proc_id]);
       if (req_ptr) {
         (*req_ptr)->priority =
             ((*req_ptr)->type == MRT_DPRF || (*req_ptr)->type == MRT_IPRF) ? (*req_ptr)->priority : order_num;
@@ -3347,6 +3882,7 @@ void mem_insert_req_round_robin() {
 Flag new_mem_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay, Op* op, Flag done_func(Mem_Req*),
                  Counter unique_num, /* This counter is used when op is NULL */
                  Pref_Req_Info* pref_info) {
+  UNCORE_LOCK_SCOPE();
   Mem_Req* new_req = NULL;
   Mem_Req* matching_req = NULL;
   Mem_Queue_Entry* queue_entry = NULL;
@@ -3369,6 +3905,10 @@ Flag new_mem_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay
 
   new_priority = Mem_Req_Priority_Offset[type] + priority_offset;
 
+  /* Step 0: A writeback of the line still in a writeback buffer goes out first */
+  if (mem->wb_buffered && !mem_wb_buffer_flush_line(proc_id, addr))
+    return FALSE;
+
   /* Step 1: Figure out if this access is already in the request buffer */
   // Search ramulator queue
   matching_req = mem_search_reqbuf(proc_id, addr, type, size, &demand_hit_prefetch, &demand_hit_writeback,
@@ -3445,8 +3985,8 @@ Flag new_mem_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay
       return FALSE;
     }
   } else {
-    if (queue_full(&mem->l1_queue) ||
-        ((type == MRT_IPRF || type == MRT_DPRF) && queue_num_free(&mem->l1_queue) <= MEM_REQ_BUFFER_PREF_WATERMARK)) {
+    if (queue_full(L1_QUEUE(addr)) ||
+        ((type == MRT_IPRF || type == MRT_DPRF) && queue_num_free(L1_QUEUE(addr)) <= MEM_REQ_BUFFER_PREF_WATERMARK)) {
       STAT_EVENT(proc_id, REJECTED_QUEUE_L1);
       return FALSE;
     }
@@ -3484,9 +4024,9 @@ Flag new_mem_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay
       DEBUG(proc_id,
             "Request denied in mem buffer  addr:%s rc:%d mlc:%d l1:%d bo:%d "
             "lf:%d mf:%d rf:%d\n",
-            hexstr64s(addr), mem->req_count, mem->mlc_queue.entry_count, mem->l1_queue.entry_count,
+            hexstr64s(addr), mem->req_count, mem->mlc_queue.entry_count, mem_l1_queue_count(),
             mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count, mem->mlc_fill_queue.entry_count,
-            mem->req_buffer_free_list.count);
+            mem->req_buffer_free_count);
       STAT_EVENT(proc_id, MEM_REQ_BUFFER_FULL);
       if ((type == MRT_IFETCH) || (type == MRT_DFETCH) || (type == MRT_DSTORE))
         STAT_EVENT(proc_id, MEM_REQ_BUFFER_FULL_DENIED_DEMAND);
@@ -3513,7 +4053,7 @@ Flag new_mem_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay
       Addr line_addr;
 
       ASSERTM(0, ADDR_TRANSLATION == ADDR_TRANS_NONE, "PREF_ORACLE_TRAIN_ON && ADDR_TRANSLATION not supported\n");
-      data = (L1_Data*)cache_access(&L1(proc_id)->cache, addr, &line_addr, FALSE);
+      data = (L1_Data*)cache_access(&L1_SLICE(proc_id, addr)->cache, addr, &line_addr, FALSE);
 
       if (data) {
         pref_ul1_hit(proc_id, addr, (op ? op->inst_info->addr : 0), (op ? op->oracle_info.pred_global_hist : 0));
@@ -3547,6 +4087,11 @@ Flag new_mem_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay
   mem_init_new_req(new_req, type, to_mlc ? QUEUE_MLC : QUEUE_L1, proc_id, addr, size, delay, op, done_func, unique_num,
                    kicked_out, new_priority);
 
+  if (cmp_threads_sync_lag) {
+    STAT_EVENT(proc_id, SYNC_QUANTUM_MEM_REQS);
+    INC_STAT_EVENT(proc_id, SYNC_QUANTUM_MEM_REQ_LAG, cmp_threads_sync_lag);
+  }
+
   /* Step 6: Insert the request into the appropriate queue if it is not already there */
 
   new_req->loadPC = op ? op->inst_info->addr : 0;
@@ -3583,7 +4128,7 @@ Flag new_mem_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay
 
 static Flag insert_new_req_into_l1_queue(uns proc_id, Mem_Req* new_req) {
   if (!ROUND_ROBIN_TO_L1) {
-    if (queue_full(&mem->l1_queue)) {
+    if (queue_full(new_req->queue)) {
       ASSERT(proc_id, 0);
     }
     mem_insert_req_into_queue(new_req, new_req->queue, ALL_FIFO_QUEUES ? l1_seq_num : 0);
@@ -3591,7 +4136,7 @@ static Flag insert_new_req_into_l1_queue(uns proc_id, Mem_Req* new_req) {
     l1_seq_num++;
   } else {
     ASSERT(proc_id, 0);
-    Mem_Req** req_ptr = sl_list_add_tail(&mem->l1_in_buffer_core[proc_id]);
+    Mem_Req** req_ptr = deque_add_tail(&mem->l1_in_buffer_core[proc_id]);
     *req_ptr = new_req;
     l1_in_buf_count++;
   }
@@ -3611,12 +4156,64 @@ static Flag insert_new_req_into_mlc_queue(uns proc_id, Mem_Req* new_req) {
   return TRUE;
 }
 
+/**************************************************************************************/
+/* new_mem_req_batch: */
+/* Issues one instruction prefetch per address in addrs, all with the same type
+   and priority. Lines that are already in the icache or repeat an earlier line
+   of the batch are dropped before the request buffer is searched. Once no
+   request buffer is left, the remaining lines can only merge into in-flight
+   requests, so the ones the reqbuf address index rules out fail without a
+   search. results, if not NULL, gets the Mem_Queue_Req_Result of every line
+   (FAILED for dropped ones). Returns the number of new requests. */
+
+uns new_mem_req_batch(Mem_Req_Type type, uns8 proc_id, const Addr* addrs, uns num_addrs, Flag done_func(Mem_Req*),
+                      Counter unique_num, Pref_Req_Info* pref_info, Mem_Queue_Req_Result* results) {
+  Addr line_mask = ~(Addr)(ICACHE_LINE_SIZE - 1);
+  Flag check_icache = type != MRT_UOCPRF && ic && ic->proc_id == proc_id;
+  Flag full = FALSE;
+  uns num_new = 0;
+  uns ii, jj;
+
+  ASSERT(proc_id, type == MRT_IPRF || type == MRT_UOCPRF || type == MRT_FDIPPRFON || type == MRT_FDIPPRFOFF);
+
+  for (ii = 0; ii < num_addrs; ii++) {
+    Addr line_addr = addrs[ii] & line_mask;
+    Mem_Queue_Req_Result result = FAILED;
+
+    for (jj = 0; jj < ii && (addrs[jj] & line_mask) != line_addr; jj++)
+      ;
+
+    if (jj < ii) {
+      STAT_EVENT(proc_id, MEM_REQ_BATCH_DUPLICATE);
+    } else if (check_icache && in_icache(line_addr)) {
+      STAT_EVENT(proc_id, MEM_REQ_BATCH_ICACHE_HIT);
+    } else if (full && ADDR_TRANSLATION == ADDR_TRANS_NONE && !mem_req_addr_index_may_match(line_addr)) {
+      // the ramulator queue matches on physical addresses, which the index
+      // only covers when there is no translation
+      STAT_EVENT(proc_id, MEM_REQ_BATCH_FULL_FILTERED);
+    } else {
+      result = (Mem_Queue_Req_Result)new_mem_req(type, proc_id, line_addr, ICACHE_LINE_SIZE, 0, NULL, done_func,
+                                                 unique_num, pref_info);
+      if (result == SUCCESS_NEW)
+        num_new++;
+      else if (result == FAILED && !mem_can_allocate_req_buffer(proc_id, type, FALSE))
+        full = TRUE;
+    }
+
+    if (results)
+      results[ii] = result;
+  }
+
+  return num_new;
+}
+
 /**************************************************************************************/
 /* new_mem_dc_wb_req: */
 /* Returns TRUE if the request is successfully entered into the memory system */
 
 Flag new_mem_dc_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay, Op* op,
                        Flag done_func(Mem_Req*), Counter unique_num, Flag used_onpath) {
+  UNCORE_LOCK_SCOPE();
   Mem_Req* new_req = NULL;
   Mem_Req* matching_req = NULL;
   Mem_Queue_Entry* queue_entry = NULL;
@@ -3661,7 +4258,7 @@ Flag new_mem_dc_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns
       return FALSE;
     }
   } else {
-    if (queue_full(&mem->l1_queue)) {
+    if (queue_full(L1_QUEUE(addr))) {
       STAT_EVENT(proc_id, REJECTED_QUEUE_L1);
       return FALSE;
     }
@@ -3679,9 +4276,9 @@ Flag new_mem_dc_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns
     DEBUG(proc_id,
           "Request denied in mem buffer  addr:%s rc:%d mlc:%d l1:%d bo:%d "
           "lf:%d mf:%d rf:%d\n",
-          hexstr64s(addr), mem->req_count, mem->mlc_queue.entry_count, mem->l1_queue.entry_count,
+          hexstr64s(addr), mem->req_count, mem->mlc_queue.entry_count, mem_l1_queue_count(),
           mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count, mem->mlc_fill_queue.entry_count,
-          mem->req_buffer_free_list.count);
+          mem->req_buffer_free_count);
     STAT_EVENT(proc_id, MEM_REQ_BUFFER_FULL);
     if ((type == MRT_IFETCH) || (type == MRT_DFETCH) || (type == MRT_DSTORE))
       STAT_EVENT(proc_id, MEM_REQ_BUFFER_FULL_DENIED_DEMAND);
@@ -3747,7 +4344,7 @@ static Flag new_mem_mlc_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns s
   }
 
   /* Step 2.5: Check if there is space in the L1 queue */
-  if (queue_full(&mem->l1_queue)) {
+  if (queue_full(L1_QUEUE(addr))) {
     STAT_EVENT(proc_id, REJECTED_QUEUE_L1);
     return FALSE;
   }
@@ -3763,9 +4360,9 @@ static Flag new_mem_mlc_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns s
     DEBUG(proc_id,
           "Request denied in mem buffer  addr:%s rc:%d mlc:%d l1:%d bo:%d "
           "lf:%d mf:%d rf:%d\n",
-          hexstr64s(addr), mem->req_count, mem->mlc_queue.entry_count, mem->l1_queue.entry_count,
+          hexstr64s(addr), mem->req_count, mem->mlc_queue.entry_count, mem_l1_queue_count(),
           mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count, mem->mlc_fill_queue.entry_count,
-          mem->req_buffer_free_list.count);
+          mem->req_buffer_free_count);
     STAT_EVENT(proc_id, MEM_REQ_BUFFER_FULL);
     if ((type == MRT_IFETCH) || (type == MRT_DFETCH) || (type == MRT_DSTORE))
       STAT_EVENT(proc_id, MEM_REQ_BUFFER_FULL_DENIED_DEMAND);
@@ -3876,9 +4473,9 @@ static Flag new_mem_l1_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns si
       DEBUG(proc_id,
             "Request denied in mem buffer  addr:%s rc:%d mlc:%d l1:%d bo:%d "
             "lf:%d mf:%d rf:%d\n",
-            hexstr64s(addr), mem->req_count, mem->mlc_queue.entry_count, mem->l1_queue.entry_count,
+            hexstr64s(addr), mem->req_count, mem->mlc_queue.entry_count, mem_l1_queue_count(),
             mem->bus_out_queue.entry_count, mem->l1fill_queue.entry_count, mem->mlc_fill_queue.entry_count,
-            mem->req_buffer_free_list.count);
+            mem->req_buffer_free_count);
       STAT_EVENT(proc_id, MEM_REQ_BUFFER_FULL);
       if ((type == MRT_IFETCH) || (type == MRT_DFETCH) || (type == MRT_DSTORE))
         STAT_EVENT(proc_id, MEM_REQ_BUFFER_FULL_DENIED_DEMAND);
@@ -3903,7 +4500,7 @@ static Flag new_mem_l1_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns si
   if (!ROUND_ROBIN_TO_L1) {
     bus_out_seq_num++;  // RAMULATOR_remove: this is not currently used
 
-    is_sent = ramulator_send(new_req);
+    is_sent = noc_send(new_req);
     if (!is_sent) {
       mem_free_reqbuf(new_req);  // RAMULATOR_todo: optimize this
       return FALSE;
@@ -3917,7 +4514,7 @@ static Flag new_mem_l1_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns si
       mem_free_reqbuf(new_req);
     }
   } else {
-    Mem_Req** req_ptr = sl_list_add_tail(&mem->l1_in_buffer_core[proc_id]);
+    Mem_Req** req_ptr = deque_add_tail(&mem->l1_in_buffer_core[proc_id]);
     *req_ptr = new_req;
     l1_in_buf_count++;
     ASSERTM(proc_id, FALSE, "Ramulator integration not complete if ROUND_ROBIN_TO_L1 is enabled");
@@ -3926,10 +4523,125 @@ static Flag new_mem_l1_wb_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns si
   return TRUE;
 }
 
+/**************************************************************************************/
+/* Writeback buffers */
+
+static void init_mem_wb_buffer(Mem_Wb_Buffer* buf, uns size) {
+  buf->size = size;
+  buf->head = 0;
+  buf->count = 0;
+  if (size) {
+    buf->addrs = (Addr*)malloc(sizeof(Addr) * size);
+    buf->proc_ids = (uns8*)malloc(sizeof(uns8) * size);
+  }
+}
+
+/* mem_wb_buffer_add: takes the writeback of a dirty line evicted by proc_id.
+   Returns FALSE only if the buffer is full. The stats of each level are
+   defined in the order ADDED, COALESCED, FULL, DRAINED from stat_base. The
+   buffers are a few entries deep, so the coalescing search is linear. */
+
+static Flag mem_wb_buffer_add(Mem_Wb_Buffer* buf, uns8 proc_id, Addr addr, Stat_Enum stat_base) {
+  for (uns ii = 0, idx = buf->head; ii < buf->count; ii++, idx = idx + 1 == buf->size ? 0 : idx + 1) {
+    if (buf->addrs[idx] == addr) {
+      STAT_EVENT(proc_id, stat_base + 1);
+      return TRUE;
+    }
+  }
+  if (buf->count == buf->size) {
+    STAT_EVENT(proc_id, stat_base + 2);
+    return FALSE;
+  }
+  uns tail = (buf->head + buf->count) % buf->size;
+  buf->addrs[tail] = addr;
+  buf->proc_ids[tail] = proc_id;
+  buf->count++;
+  mem->wb_buffered++;
+  STAT_EVENT(proc_id, stat_base);
+  return TRUE;
+}
+
+/* mem_drain_wb_buffer: passes up to MEM_WB_BUFFER_DRAIN_PER_CYCLE of the
+   oldest writebacks to the next level, stopping at the first it refuses.
+   Only then does a writeback take a request buffer entry: until an MLC one
+   is inserted into the L1 queue, and just long enough to send an L1 one to
+   DRAM. */
+
+static Flag mem_wb_buffer_send(Flag to_dram, uns8 proc_id, Addr addr) {
+  return to_dram ? new_mem_l1_wb_req(MRT_WB, proc_id, addr, L1_LINE_SIZE, 0, NULL, NULL, unique_count)
+                 : new_mem_mlc_wb_req(MRT_WB, proc_id, addr, MLC_LINE_SIZE, 1, NULL, NULL, unique_count);
+}
+
+static void mem_drain_wb_buffer(Mem_Wb_Buffer* buf, Flag to_dram) {
+  for (uns ii = 0; ii < MEM_WB_BUFFER_DRAIN_PER_CYCLE && buf->count; ii++) {
+    Addr addr = buf->addrs[buf->head];
+    uns8 proc_id = buf->proc_ids[buf->head];
+    if (!mem_wb_buffer_send(to_dram, proc_id, addr))
+      return;
+    buf->head = buf->head + 1 == buf->size ? 0 : buf->head + 1;
+    buf->count--;
+    mem->wb_buffered--;
+    STAT_EVENT(proc_id, to_dram ? L1_WB_BUFFER_DRAINED : MLC_WB_BUFFER_DRAINED);
+  }
+}
+
+static void mem_drain_wb_buffers(void) {
+  if (!mem->wb_buffered)
+    return;
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    mem_drain_wb_buffer(&mem->mlc_wb_buffers[proc_id], FALSE);
+  mem_drain_wb_buffer(&mem->l1_wb_buffer, TRUE);
+}
+
+/* mem_wb_buffer_flush_entry: sends on the writeback of the line at line_addr
+   if buf holds it, out of order, and closes the gap it leaves. Returns FALSE
+   if the next level refused it. */
+
+static Flag mem_wb_buffer_flush_entry(Mem_Wb_Buffer* buf, Flag to_dram, Addr line_addr, Stat_Enum hit_stat) {
+  for (uns ii = 0, idx = buf->head; ii < buf->count; ii++, idx = idx + 1 == buf->size ? 0 : idx + 1) {
+    if (buf->addrs[idx] != line_addr)
+      continue;
+    uns8 proc_id = buf->proc_ids[idx];
+    if (!mem_wb_buffer_send(to_dram, proc_id, line_addr))
+      return FALSE;
+    STAT_EVENT(proc_id, hit_stat);
+    for (; ii + 1 < buf->count; ii++) {
+      uns next = idx + 1 == buf->size ? 0 : idx + 1;
+      buf->addrs[idx] = buf->addrs[next];
+      buf->proc_ids[idx] = buf->proc_ids[next];
+      idx = next;
+    }
+    buf->count--;
+    mem->wb_buffered--;
+    STAT_EVENT(proc_id, to_dram ? L1_WB_BUFFER_DRAINED : MLC_WB_BUFFER_DRAINED);
+    return TRUE;
+  }
+  return TRUE;
+}
+
+/* mem_wb_buffer_flush_line: a request must not pass the buffered writeback of
+   its own line, or it would read stale data from the next level. Sends such a
+   writeback on ahead of it, where the request buffer search matches it as it
+   matched the writeback request before the buffers (demand_hit_writeback).
+   Returns FALSE if the writeback could not be sent, and the request has to be
+   retried. */
+
+static Flag mem_wb_buffer_flush_line(uns8 proc_id, Addr addr) {
+  if (mem->mlc_wb_buffers && mem->mlc_wb_buffers[proc_id].count &&
+      !mem_wb_buffer_flush_entry(&mem->mlc_wb_buffers[proc_id], FALSE, addr & ~(Addr)(MLC_LINE_SIZE - 1),
+                                 MLC_WB_BUFFER_REQ_HIT))
+    return FALSE;
+  if (mem->l1_wb_buffer.count &&
+      !mem_wb_buffer_flush_entry(&mem->l1_wb_buffer, TRUE, addr & ~(Addr)(L1_LINE_SIZE - 1), L1_WB_BUFFER_REQ_HIT))
+    return FALSE;
+  return TRUE;
+}
+
 /**************************************************************************************/
 // op_nuke_mem_req:
 
 void op_nuke_mem_req(Op* op) {
+  UNCORE_LOCK_SCOPE();
   // FIXME: why is this here?
 }
 
@@ -3947,7 +4659,7 @@ Flag l1_fill_line(Mem_Req* req) {
   UNUSED(tmp_num);
 
   if (req->op_count) {
-    top = *((Op**)list_start_head_traversal(&req->op_ptrs));
+    top = req->waiters[0].op;
     tmp_num = top->unique_num;
   }
 
@@ -3981,8 +4693,9 @@ Flag l1_fill_line(Mem_Req* req) {
      that we won't be able to insert the writeback into the
      memory system. */
   Flag repl_line_valid;
-  data = (L1_Data*)get_next_repl_line(&L1(req->proc_id)->cache, req->proc_id, req->addr, &repl_line_addr,
+  data = (L1_Data*)get_next_repl_line(&L1_SLICE(req->proc_id, req->addr)->cache, req->proc_id, req->addr, &repl_line_addr,
                                       &repl_line_valid);
+  L1_Data_Ext* ext = cache_line_ext(&L1_SLICE(req->proc_id, req->addr)->cache, data);
 
   /* If we are replacing anything, check if we need to write it back */
   if (repl_line_valid) {
@@ -3991,7 +4704,11 @@ Flag l1_fill_line(Mem_Req* req) {
       DEBUG(data->proc_id, "Scheduling writeback of addr:0x%s\n", hexstr64s(repl_line_addr));
       if (0 && DEBUG_EXC_INSERTS)
         printf("Scheduling L2 writeback of addr:0x%s ins addr:0x%s\n", hexstr64s(repl_line_addr), hexstr64s(req->addr));
-      if (!new_mem_l1_wb_req(MRT_WB, data->proc_id, repl_line_addr, L1_LINE_SIZE, 0, NULL, NULL, unique_count))
+      Flag wb_taken =
+          mem->l1_wb_buffer.size
+              ? mem_wb_buffer_add(&mem->l1_wb_buffer, data->proc_id, repl_line_addr, L1_WB_BUFFER_ADDED)
+              : new_mem_l1_wb_req(MRT_WB, data->proc_id, repl_line_addr, L1_LINE_SIZE, 0, NULL, NULL, unique_count);
+      if (!wb_taken)
         return FAILURE;
       STAT_EVENT(req->proc_id, L1_FILL_DIRTY);
     }
@@ -4006,87 +4723,93 @@ Flag l1_fill_line(Mem_Req* req) {
     // cmp FIXME prefetchers
     pref_ul1evict(data->proc_id, repl_line_addr);
     if (data->prefetch) {
-      uns log2_distance = data->pref_distance ? MIN2(LOG2(data->pref_distance), 6) : 0;
+      uns log2_distance = ext && ext->pref_distance ? MIN2(LOG2(ext->pref_distance), 6) : 0;
       if (!data->seen_prefetch) {  // prefeched line not used
         pref_evictline_notused(data->proc_id, repl_line_addr, data->pref_loadPC, data->global_hist);
 
         STAT_EVENT(data->proc_id, CORE_EVICTED_L1_PREF_NOT_USED);
         STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED);
-        INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_PREF_NOT_USED, data->l1miss_latency);
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_DISTANCE_1 + log2_distance);
-        INC_STAT_EVENT(data->proc_id, L1_STAY_PREF_NOT_USED, cycle_count - data->fetch_cycle);
         STAT_EVENT(data->proc_id, NORESET_L1_EVICT_PREF_UNUSED);
 
-        if (data->l1miss_latency > 1600)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1600MORE);
-        else if (data->l1miss_latency > 1400)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1600);
-        else if (data->l1miss_latency > 1200)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1400);
-        else if (data->l1miss_latency > 1000)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1200);
-        else if (data->l1miss_latency > 800)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1000);
-        else if (data->l1miss_latency > 600)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY800);
-        else if (data->l1miss_latency > 400)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY600);
-        else if (data->l1miss_latency > 200)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY400);
-        else
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY200);
+        if (ext) {
+          INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_PREF_NOT_USED, ext->l1miss_latency);
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_DISTANCE_1 + log2_distance);
+          INC_STAT_EVENT(data->proc_id, L1_STAY_PREF_NOT_USED, cycle_count - ext->fetch_cycle);
+          if (ext->l1miss_latency > 1600)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1600MORE);
+          else if (ext->l1miss_latency > 1400)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1600);
+          else if (ext->l1miss_latency > 1200)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1400);
+          else if (ext->l1miss_latency > 1000)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1200);
+          else if (ext->l1miss_latency > 800)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY1000);
+          else if (ext->l1miss_latency > 600)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY800);
+          else if (ext->l1miss_latency > 400)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY600);
+          else if (ext->l1miss_latency > 200)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY400);
+          else
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_NOT_USED_LATENCY200);
+        }
       } else {  // prefeched line used
         pref_evictline_used(data->proc_id, repl_line_addr, data->pref_loadPC, data->global_hist);
 
         STAT_EVENT(data->proc_id, CORE_EVICTED_L1_PREF_USED);
-        INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_PREF_USED, data->l1miss_latency);
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_DISTANCE_1 + log2_distance);
-        INC_STAT_EVENT(data->proc_id, L1_STAY_PREF_USED, cycle_count - data->fetch_cycle);
         STAT_EVENT(data->proc_id, NORESET_L1_EVICT_PREF_USED);
 
-        if (data->l1miss_latency > 1600)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1600MORE);
-        else if (data->l1miss_latency > 1400)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1600);
-        else if (data->l1miss_latency > 1200)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1400);
-        else if (data->l1miss_latency > 1000)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1200);
-        else if (data->l1miss_latency > 800)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1000);
-        else if (data->l1miss_latency > 600)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY800);
-        else if (data->l1miss_latency > 400)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY600);
-        else if (data->l1miss_latency > 200)
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY400);
-        else
-          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY200);
+        if (ext) {
+          INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_PREF_USED, ext->l1miss_latency);
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_DISTANCE_1 + log2_distance);
+          INC_STAT_EVENT(data->proc_id, L1_STAY_PREF_USED, cycle_count - ext->fetch_cycle);
+          if (ext->l1miss_latency > 1600)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1600MORE);
+          else if (ext->l1miss_latency > 1400)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1600);
+          else if (ext->l1miss_latency > 1200)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1400);
+          else if (ext->l1miss_latency > 1000)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1200);
+          else if (ext->l1miss_latency > 800)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY1000);
+          else if (ext->l1miss_latency > 600)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY800);
+          else if (ext->l1miss_latency > 400)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY600);
+          else if (ext->l1miss_latency > 200)
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY400);
+          else
+            STAT_EVENT(data->proc_id, CORE_PREF_L1_USED_LATENCY200);
+        }
       }
     } else {
       STAT_EVENT(data->proc_id, CORE_EVICTED_L1_DEMAND);
-      INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_DEMAND, data->l1miss_latency);
-      INC_STAT_EVENT(data->proc_id, L1_STAY_DEMAND, cycle_count - data->fetch_cycle);
       STAT_EVENT(data->proc_id, NORESET_L1_EVICT_NONPREF);
 
-      if (data->l1miss_latency > 1000)
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY1000MORE);
-      else if (data->l1miss_latency > 900)
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY1000);
-      else if (data->l1miss_latency > 800)
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY900);
-      else if (data->l1miss_latency > 700)
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY800);
-      else if (data->l1miss_latency > 600)
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY700);
-      else if (data->l1miss_latency > 500)
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY600);
-      else if (data->l1miss_latency > 400)
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY500);
-      else if (data->l1miss_latency > 300)
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY400);
-      else
-        STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY300);
+      if (ext) {
+        INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_DEMAND, ext->l1miss_latency);
+        INC_STAT_EVENT(data->proc_id, L1_STAY_DEMAND, cycle_count - ext->fetch_cycle);
+        if (ext->l1miss_latency > 1000)
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY1000MORE);
+        else if (ext->l1miss_latency > 900)
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY1000);
+        else if (ext->l1miss_latency > 800)
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY900);
+        else if (ext->l1miss_latency > 700)
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY800);
+        else if (ext->l1miss_latency > 600)
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY700);
+        else if (ext->l1miss_latency > 500)
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY600);
+        else if (ext->l1miss_latency > 400)
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY500);
+        else if (ext->l1miss_latency > 300)
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY400);
+        else
+          STAT_EVENT(data->proc_id, CORE_PREF_L1_DEMAND_LATENCY300);
+      }
     }
 
     // cmp FIXME prefetchers
@@ -4131,12 +4854,12 @@ Flag l1_fill_line(Mem_Req* req) {
         STAT_EVENT(req->proc_id, PREF_REPL_MID);
       }
     }
-    data = (L1_Data*)cache_insert_replpos(&L1(req->proc_id)->cache, req->proc_id, req->addr, &line_addr,
+    data = (L1_Data*)cache_insert_replpos(&L1_SLICE(req->proc_id, req->addr)->cache, req->proc_id, req->addr, &line_addr,
                                           &repl_line_addr, mem->pref_replpos, TRUE);
     if (repl_line_addr && (!data->prefetch || (data->prefetch && data->seen_prefetch)))  // Prefetch kicks out demand
       pref_ul1evictOnPF(req->proc_id, repl_line_addr, data->proc_id);
   } else {
-    data = (L1_Data*)cache_insert(&L1(req->proc_id)->cache, req->proc_id, req->addr, &line_addr, &repl_line_addr);
+    data = (L1_Data*)cache_insert(&L1_SLICE(req->proc_id, req->addr)->cache, req->proc_id, req->addr, &line_addr, &repl_line_addr);
   }
 
   STAT_EVENT(req->proc_id, NORESET_L1_FILL);
@@ -4176,7 +4899,7 @@ Flag l1_fill_line(Mem_Req* req) {
         uns set;
         Addr tag, conv_addr, dummy_addr;
 
-        l1_cache = &L1(req->proc_id)->cache;
+        l1_cache = &L1_SLICE(req->proc_id, req->addr)->cache;
         set = req->addr >> l1_cache->shift_bits & l1_cache->set_mask;
         if (set % 33 == 0) {
           set = set / 33;  // converting the addr
@@ -4209,19 +4932,18 @@ Flag l1_fill_line(Mem_Req* req) {
   // If demand matches prefetch, then it is already seen
   data->seen_prefetch = req->demand_match_prefetch;
   data->prefetcher_id = req->prefetcher_id;
-  data->pref_distance = req->pref_distance;
   data->pref_loadPC = req->pref_loadPC;
   data->global_hist = req->global_hist;
   data->dcache_touch = FALSE;
-  data->fetched_by_offpath = req->off_path;
-  data->offpath_op_addr = req->oldest_op_addr;
-  data->offpath_op_unique = req->oldest_op_unique_num;
-  data->l0_modified_fetched_by_offpath = FALSE;
 
-  // WB from dcache does not need a memory access
-  data->l1miss_latency = (req->type == MRT_WB) ? 0 : cycle_count - req->l1_miss_cycle;
-  data->fetch_cycle = cycle_count;
-  data->onpath_use_cycle = req->off_path ? 0 : cycle_count;
+  ext = cache_line_ext(&L1_SLICE(req->proc_id, req->addr)->cache, data);
+  if (ext) {
+    ext->pref_distance = req->pref_distance;
+    // WB from dcache does not need a memory access
+    ext->l1miss_latency = (req->type == MRT_WB) ? 0 : cycle_count - req->l1_miss_cycle;
+    ext->fetch_cycle = cycle_count;
+    ext->onpath_use_cycle = req->off_path ? 0 : cycle_count;
+  }
 
   req->l1_miss_satisfied = TRUE;
 
@@ -4240,7 +4962,8 @@ Flag l1_fill_line(Mem_Req* req) {
     mark_ops_as_l1_miss_satisfied(req);
 
   // this is just a stat collection
-  wp_process_l1_fill(data, req);
+  if (WP_COLLECT_STATS)
+    wp_process_l1_fill(l1_wp_data(L1_SLICE(req->proc_id, req->addr), data), req);
 
   return SUCCESS;
 }
@@ -4256,7 +4979,7 @@ Flag mlc_fill_line(Mem_Req* req) {
   UNUSED(tmp_num);
 
   if (req->op_count) {
-    top = *((Op**)list_start_head_traversal(&req->op_ptrs));
+    top = req->waiters[0].op;
     tmp_num = top->unique_num;
   }
 
@@ -4325,6 +5048,7 @@ Flag mlc_fill_line(Mem_Req* req) {
   Flag repl_line_valid;
   data = (MLC_Data*)get_next_repl_line(&MLC(req->proc_id)->cache, req->proc_id, req->addr, &repl_line_addr,
                                        &repl_line_valid);
+  L1_Data_Ext* ext = cache_line_ext(&MLC(req->proc_id)->cache, data);
 
   /* If we are replacing anything, check if we need to write it back */
   if (repl_line_valid) {
@@ -4333,7 +5057,12 @@ Flag mlc_fill_line(Mem_Req* req) {
       DEBUG(req->proc_id, "Scheduling writeback of addr:0x%s\n", hexstr64s(repl_line_addr));
       if (0 && DEBUG_EXC_INSERTS)
         printf("Scheduling L2 writeback of addr:0x%s ins addr:0x%s\n", hexstr64s(repl_line_addr), hexstr64s(req->addr));
-      if (!new_mem_mlc_wb_req(MRT_WB, data->proc_id, repl_line_addr, MLC_LINE_SIZE, 1, NULL, NULL, unique_count))
+      Mem_Wb_Buffer* wb_buffer = mem->mlc_wb_buffers ? &mem->mlc_wb_buffers[data->proc_id] : NULL;
+      Flag wb_taken = wb_buffer && wb_buffer->size
+                          ? mem_wb_buffer_add(wb_buffer, data->proc_id, repl_line_addr, MLC_WB_BUFFER_ADDED)
+                          : new_mem_mlc_wb_req(MRT_WB, data->proc_id, repl_line_addr, MLC_LINE_SIZE, 1, NULL, NULL,
+                                               unique_count);
+      if (!wb_taken)
         return FAILURE;
       STAT_EVENT(req->proc_id, MLC_FILL_DIRTY);
     }
@@ -4343,73 +5072,79 @@ Flag mlc_fill_line(Mem_Req* req) {
         pref_evictline_notused(data->proc_id, repl_line_addr, data->pref_loadPC, data->global_hist);
 
         STAT_EVENT(data->proc_id, CORE_EVICTED_MLC_PREF_NOT_USED);
-        INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_PREF_NOT_USED, data->mlc_miss_latency);
-
-        if (data->mlc_miss_latency > 1600)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1600MORE);
-        else if (data->mlc_miss_latency > 1400)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1600);
-        else if (data->mlc_miss_latency > 1200)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1400);
-        else if (data->mlc_miss_latency > 1000)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1200);
-        else if (data->mlc_miss_latency > 800)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1000);
-        else if (data->mlc_miss_latency > 600)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY800);
-        else if (data->mlc_miss_latency > 400)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY600);
-        else if (data->mlc_miss_latency > 200)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY400);
-        else
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY200);
+
+        if (ext) {
+          INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_PREF_NOT_USED, ext->mlc_miss_latency);
+          if (ext->mlc_miss_latency > 1600)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1600MORE);
+          else if (ext->mlc_miss_latency > 1400)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1600);
+          else if (ext->mlc_miss_latency > 1200)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1400);
+          else if (ext->mlc_miss_latency > 1000)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1200);
+          else if (ext->mlc_miss_latency > 800)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY1000);
+          else if (ext->mlc_miss_latency > 600)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY800);
+          else if (ext->mlc_miss_latency > 400)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY600);
+          else if (ext->mlc_miss_latency > 200)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY400);
+          else
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_NOT_USED_LATENCY200);
+        }
       } else {  // prefeched line used
         pref_evictline_used(data->proc_id, repl_line_addr, data->pref_loadPC, data->global_hist);
 
         STAT_EVENT(data->proc_id, CORE_EVICTED_MLC_PREF_USED);
-        INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_PREF_USED, data->mlc_miss_latency);
-
-        if (data->mlc_miss_latency > 1600)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1600MORE);
-        else if (data->mlc_miss_latency > 1400)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1600);
-        else if (data->mlc_miss_latency > 1200)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1400);
-        else if (data->mlc_miss_latency > 1000)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1200);
-        else if (data->mlc_miss_latency > 800)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1000);
-        else if (data->mlc_miss_latency > 600)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY800);
-        else if (data->mlc_miss_latency > 400)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY600);
-        else if (data->mlc_miss_latency > 200)
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY400);
-        else
-          STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY200);
+
+        if (ext) {
+          INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_PREF_USED, ext->mlc_miss_latency);
+          if (ext->mlc_miss_latency > 1600)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1600MORE);
+          else if (ext->mlc_miss_latency > 1400)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1600);
+          else if (ext->mlc_miss_latency > 1200)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1400);
+          else if (ext->mlc_miss_latency > 1000)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1200);
+          else if (ext->mlc_miss_latency > 800)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY1000);
+          else if (ext->mlc_miss_latency > 600)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY800);
+          else if (ext->mlc_miss_latency > 400)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY600);
+          else if (ext->mlc_miss_latency > 200)
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY400);
+          else
+            STAT_EVENT(data->proc_id, CORE_PREF_MLC_USED_LATENCY200);
+        }
       }
     } else {
       STAT_EVENT(data->proc_id, CORE_EVICTED_MLC_DEMAND);
-      INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_DEMAND, data->mlc_miss_latency);
-
-      if (data->mlc_miss_latency > 1000)
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY1000MORE);
-      else if (data->mlc_miss_latency > 900)
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY1000);
-      else if (data->mlc_miss_latency > 800)
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY900);
-      else if (data->mlc_miss_latency > 700)
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY800);
-      else if (data->mlc_miss_latency > 600)
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY700);
-      else if (data->mlc_miss_latency > 500)
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY600);
-      else if (data->mlc_miss_latency > 400)
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY500);
-      else if (data->mlc_miss_latency > 300)
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY400);
-      else
-        STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY300);
+
+      if (ext) {
+        INC_STAT_EVENT(data->proc_id, CORE_MEM_LATENCY_AVE_DEMAND, ext->mlc_miss_latency);
+        if (ext->mlc_miss_latency > 1000)
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY1000MORE);
+        else if (ext->mlc_miss_latency > 900)
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY1000);
+        else if (ext->mlc_miss_latency > 800)
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY900);
+        else if (ext->mlc_miss_latency > 700)
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY800);
+        else if (ext->mlc_miss_latency > 600)
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY700);
+        else if (ext->mlc_miss_latency > 500)
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY600);
+        else if (ext->mlc_miss_latency > 400)
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY500);
+        else if (ext->mlc_miss_latency > 300)
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY400);
+        else
+          STAT_EVENT(data->proc_id, CORE_PREF_MLC_DEMAND_LATENCY300);
+      }
     }
   }
 
@@ -4427,15 +5162,13 @@ Flag mlc_fill_line(Mem_Req* req) {
   data->pref_loadPC = req->pref_loadPC;
   data->global_hist = req->global_hist;
   data->dcache_touch = FALSE;
-  data->fetched_by_offpath = req->off_path;
-  data->offpath_op_addr = req->oldest_op_addr;
-  data->offpath_op_unique = req->oldest_op_unique_num;
-  data->l0_modified_fetched_by_offpath = FALSE;
 
-  // WB from dcache does not need a memory access
-  data->mlc_miss_latency = (req->type == MRT_WB) ? 0 : cycle_count - req->mlc_miss_cycle;
-  data->fetch_cycle = cycle_count;
-  data->onpath_use_cycle = req->off_path ? 0 : cycle_count;
+  if (ext) {
+    // WB from dcache does not need a memory access
+    ext->mlc_miss_latency = (req->type == MRT_WB) ? 0 : cycle_count - req->mlc_miss_cycle;
+    ext->fetch_cycle = cycle_count;
+    ext->onpath_use_cycle = req->off_path ? 0 : cycle_count;
+  }
 
   req->mlc_miss_satisfied = TRUE;
 
@@ -4458,6 +5191,7 @@ Flag mlc_fill_line(Mem_Req* req) {
 /* mem_req_younger_than_uniquenum: */
 
 Flag mem_req_younger_than_uniquenum(int reqbuf, Counter unique_num) {
+  UNCORE_LOCK_SCOPE();
   if (mem->req_buffer[reqbuf].oldest_op_unique_num == 0)
     return mem->req_buffer[reqbuf].off_path;
   else {
@@ -4472,6 +5206,7 @@ Flag mem_req_younger_than_uniquenum(int reqbuf, Counter unique_num) {
 /* mem_req_older_than_uniquenum: */
 
 Flag mem_req_older_than_uniquenum(int reqbuf, Counter unique_num) {
+  UNCORE_LOCK_SCOPE();
   if (mem->req_buffer[reqbuf].oldest_op_unique_num == 0)
     return FALSE;
   else {
@@ -4486,18 +5221,32 @@ Flag mem_req_older_than_uniquenum(int reqbuf, Counter unique_num) {
 /* do_l1_access: */
 
 L1_Data* do_l1_access(Op* op) {
+  UNCORE_LOCK_SCOPE();
   L1_Data* hit;
   Addr line_addr;
 
-  hit = (L1_Data*)cache_access(&L1(op->proc_id)->cache, op->oracle_info.va, &line_addr, FALSE);
+  hit = (L1_Data*)cache_access(&L1_SLICE(op->proc_id, op->oracle_info.va)->cache, op->oracle_info.va, &line_addr, FALSE);
 
   return hit;
 }
 
+/**************************************************************************************/
+/* do_l1_wp_access: the wrong-path entry of the L1 line op hits, NULL on a miss or
+   without WP_COLLECT_STATS */
+
+L1_Wp_Data* do_l1_wp_access(Op* op) {
+  UNCORE_LOCK_SCOPE();
+  Ported_Cache* l1 = L1_SLICE(op->proc_id, op->oracle_info.va);
+  Addr line_addr;
+
+  return l1_wp_data(l1, (L1_Data*)cache_access(&l1->cache, op->oracle_info.va, &line_addr, FALSE));
+}
+
 /**************************************************************************************/
 /* do_mlc_access: */
 
 MLC_Data* do_mlc_access(Op* op) {
+  UNCORE_LOCK_SCOPE();
   MLC_Data* hit;
   Addr line_addr;
 
@@ -4510,19 +5259,33 @@ MLC_Data* do_mlc_access(Op* op) {
 /* do_l1_access_addr: */
 
 L1_Data* do_l1_access_addr(Addr addr) {
+  UNCORE_LOCK_SCOPE();
   L1_Data* hit;
   Addr line_addr;
   uns proc_id = get_proc_id_from_cmp_addr(addr);
 
-  hit = (L1_Data*)cache_access(&L1(proc_id)->cache, addr, &line_addr, FALSE);
+  hit = (L1_Data*)cache_access(&L1_SLICE(proc_id, addr)->cache, addr, &line_addr, FALSE);
 
   return hit;
 }
 
+/**************************************************************************************/
+/* do_l1_wp_access_addr: */
+
+L1_Wp_Data* do_l1_wp_access_addr(Addr addr) {
+  UNCORE_LOCK_SCOPE();
+  uns proc_id = get_proc_id_from_cmp_addr(addr);
+  Ported_Cache* l1 = L1_SLICE(proc_id, addr);
+  Addr line_addr;
+
+  return l1_wp_data(l1, (L1_Data*)cache_access(&l1->cache, addr, &line_addr, FALSE));
+}
+
 /**************************************************************************************/
 /* do_mlc_access_addr: */
 
 MLC_Data* do_mlc_access_addr(Addr addr) {
+  UNCORE_LOCK_SCOPE();
   MLC_Data* hit;
   Addr line_addr;
   uns proc_id = get_proc_id_from_cmp_addr(addr);
@@ -4536,15 +5299,10 @@ MLC_Data* do_mlc_access_addr(Addr addr) {
 /* mark_ops_as_l1_miss: */
 
 static void mark_ops_as_l1_miss(Mem_Req* req) {
-  Op* op;
-  Op** op_p = (Op**)list_start_head_traversal(&req->op_ptrs);
-  Counter* op_unique = (Counter*)list_start_head_traversal(&req->op_uniques);
+  for (uns ii = 0; ii < req->op_count; ii++) {
+    Op* op = req->waiters[ii].op;
 
-  for (; op_p; op_p = (Op**)list_next_element(&req->op_ptrs)) {
-    ASSERT(req->proc_id, op_unique);
-    op = *op_p;
-
-    if (op->unique_num == *op_unique && op->op_pool_valid) {
+    if (op->unique_num == req->waiters[ii].unique_num && op->op_pool_valid) {
       ASSERT(req->proc_id, req->proc_id == op->proc_id);
       if (op->req == req) {
         op->engine_info.l1_miss = TRUE;
@@ -4552,7 +5310,6 @@ static void mark_ops_as_l1_miss(Mem_Req* req) {
           mark_l1_miss_deps(op);
       }
     }
-    op_unique = (Counter*)list_next_element(&req->op_uniques);
   }
 
   // collect stats on l1 misses during RA
@@ -4562,16 +5319,10 @@ static void mark_ops_as_l1_miss(Mem_Req* req) {
 /* mark_ops_as_l1_miss_satisfied: */
 
 void mark_ops_as_l1_miss_satisfied(Mem_Req* req) {
-  Op* op;
-  Op** op_p = (Op**)list_start_head_traversal(&req->op_ptrs);
-  Counter* op_unique = (Counter*)list_start_head_traversal(&req->op_uniques);
-
-  for (; op_p; op_p = (Op**)list_next_element(&req->op_ptrs)) {
-    ASSERT(req->proc_id, op_unique);
-
-    op = *op_p;
+  for (uns ii = 0; ii < req->op_count; ii++) {
+    Op* op = req->waiters[ii].op;
 
-    if (op->unique_num == *op_unique && op->op_pool_valid) {
+    if (op->unique_num == req->waiters[ii].unique_num && op->op_pool_valid) {
       ASSERTM(req->proc_id, req->proc_id == op->proc_id,
               "req addr: %llx, valid_op: %u, op_proc_id: %u op_num: %llu, "
               "offpath: %u op_type: %u, mem_type: %u\n",
@@ -4585,8 +5336,6 @@ void mark_ops_as_l1_miss_satisfied(Mem_Req* req) {
         }
       }
     }
-
-    op_unique = (Counter*)list_next_element(&req->op_uniques);
   }
 }
 
@@ -4595,27 +5344,27 @@ void mark_ops_as_l1_miss_satisfied(Mem_Req* req) {
 /* recursively go through the wake up lists of the op and mark ops as
  * l1_miss_dep */
 static void mark_l1_miss_deps(Op* op) {
-  Wake_Up_Entry* temp;
-
   ASSERT(op->proc_id,
          (op->engine_info.l1_miss && !op->engine_info.l1_miss_satisfied) || op->engine_info.dep_on_l1_miss);
 
-  for (temp = op->wake_up_head; temp; temp = temp->next) {
-    Op* dep_op = temp->op;
-    Counter dep_unique_num = temp->unique_num;
-
-    if (dep_op->unique_num == dep_unique_num && dep_op->op_pool_valid) {
-      ASSERT(op->proc_id, op->proc_id == dep_op->proc_id);
-      /*printf("MARK c: %s dep_op: %s %s %s %s op: %s %s %s %s\n",
-         unsstr64(cycle_count), unsstr64(dep_op->unique_num),
-         unsstr64(dep_op->exec_cycle), disasm_op(dep_op, TRUE),
-         unsstr64(dep_op->oracle_info.va), unsstr64(op->unique_num),
-         unsstr64(op->exec_cycle), disasm_op(op, TRUE),
-         unsstr64(op->oracle_info.va)); */
-      ASSERT(dep_op->proc_id, !dep_op->engine_info.l1_miss || dep_op->table_info->mem_type == MEM_ST);
-      if (!dep_op->engine_info.dep_on_l1_miss) {
-        dep_op->engine_info.dep_on_l1_miss = TRUE;
-        mark_l1_miss_deps(dep_op);
+  for (uns type = 0; type < NUM_DEP_TYPES; type++) {
+    FOR_EACH_WAKE_UP_ENTRY(&op->wake_up[type], temp) {
+      Op* dep_op = temp->op;
+      Counter dep_unique_num = temp->unique_num;
+
+      if (dep_op->unique_num == dep_unique_num && dep_op->op_pool_valid) {
+        ASSERT(op->proc_id, op->proc_id == dep_op->proc_id);
+        /*printf("MARK c: %s dep_op: %s %s %s %s op: %s %s %s %s\n",
+           unsstr64(cycle_count), unsstr64(dep_op->unique_num),
+           unsstr64(dep_op->exec_cycle), disasm_op(dep_op, TRUE),
+           unsstr64(dep_op->oracle_info.va), unsstr64(op->unique_num),
+           unsstr64(op->exec_cycle), disasm_op(op, TRUE),
+           unsstr64(op->oracle_info.va)); */
+        ASSERT(dep_op->proc_id, !dep_op->engine_info.l1_miss || dep_op->table_info->mem_type == MEM_ST);
+        if (!dep_op->engine_info.dep_on_l1_miss) {
+          dep_op->engine_info.dep_on_l1_miss = TRUE;
+          mark_l1_miss_deps(dep_op);
+        }
       }
     }
   }
@@ -4627,47 +5376,47 @@ static void mark_l1_miss_deps(Op* op) {
  * l1_miss_dep */
 
 static void unmark_l1_miss_deps(Op* op) {
-  Wake_Up_Entry* temp;
-
   ASSERT(op->proc_id,
          op->engine_info.l1_miss_satisfied || (!op->engine_info.dep_on_l1_miss && op->engine_info.was_dep_on_l1_miss));
 
   /* Go thru the wake up list and unmark ops if they are not dependent on
    * another l1 miss */
-  for (temp = op->wake_up_head; temp; temp = temp->next) {
-    Op* dep_op = temp->op;
-    Counter dep_unique_num = temp->unique_num;
-
-    if (dep_op->unique_num == dep_unique_num && dep_op->op_pool_valid) {
-      int ii;
-      Op_Info* op_info = &dep_op->oracle_info;
-      Flag still_dep_on_l1_miss = FALSE;
-
-      ASSERT(op->proc_id, op->proc_id == dep_op->proc_id);
-      ASSERT(dep_op->proc_id, dep_op->engine_info.dep_on_l1_miss || dep_op->engine_info.was_dep_on_l1_miss);
-
-      if (dep_op->engine_info.dep_on_l1_miss) {
-        /* Determine if the op is dependent on another l1_miss */
-        for (ii = 0; ii < op_info->num_srcs; ii++) {
-          Src_Info* src_info = &op_info->src_info[ii];
-          Op* src_op = src_info->op;
-
-          if (src_op->unique_num == src_info->unique_num && src_op->op_pool_valid) {
-            if (src_op->unique_num != op->unique_num)
-              if ((src_op->engine_info.l1_miss && !src_op->engine_info.l1_miss_satisfied) ||
-                  src_op->engine_info.dep_on_l1_miss)
-                still_dep_on_l1_miss = TRUE;
+  for (uns type = 0; type < NUM_DEP_TYPES; type++) {
+    FOR_EACH_WAKE_UP_ENTRY(&op->wake_up[type], temp) {
+      Op* dep_op = temp->op;
+      Counter dep_unique_num = temp->unique_num;
+
+      if (dep_op->unique_num == dep_unique_num && dep_op->op_pool_valid) {
+        int ii;
+        Op_Info* op_info = &dep_op->oracle_info;
+        Flag still_dep_on_l1_miss = FALSE;
+
+        ASSERT(op->proc_id, op->proc_id == dep_op->proc_id);
+        ASSERT(dep_op->proc_id, dep_op->engine_info.dep_on_l1_miss || dep_op->engine_info.was_dep_on_l1_miss);
+
+        if (dep_op->engine_info.dep_on_l1_miss) {
+          /* Determine if the op is dependent on another l1_miss */
+          for (ii = 0; ii < op_info->num_srcs; ii++) {
+            Src_Info* src_info = &op_info->src_info[ii];
+            Op* src_op = src_info->op;
+
+            if (src_op->unique_num == src_info->unique_num && src_op->op_pool_valid) {
+              if (src_op->unique_num != op->unique_num)
+                if ((src_op->engine_info.l1_miss && !src_op->engine_info.l1_miss_satisfied) ||
+                    src_op->engine_info.dep_on_l1_miss)
+                  still_dep_on_l1_miss = TRUE;
+            }
+            if (still_dep_on_l1_miss)
+              break;
           }
-          if (still_dep_on_l1_miss)
-            break;
-        }
 
-        /* If the op is not dependent on another l1 miss, then go ahead and
-           unmark it and figure out if we need to unmark its dependents */
-        if (!still_dep_on_l1_miss) {
-          dep_op->engine_info.dep_on_l1_miss = FALSE;
-          dep_op->engine_info.was_dep_on_l1_miss = TRUE;
-          unmark_l1_miss_deps(dep_op);
+          /* If the op is not dependent on another l1 miss, then go ahead and
+             unmark it and figure out if we need to unmark its dependents */
+          if (!still_dep_on_l1_miss) {
+            dep_op->engine_info.dep_on_l1_miss = FALSE;
+            dep_op->engine_info.was_dep_on_l1_miss = TRUE;
+            unmark_l1_miss_deps(dep_op);
+          }
         }
       }
     }
@@ -4687,7 +5436,7 @@ L1_Data* l1_pref_cache_access(Mem_Req* req) {
     return pref_data;
 
   if (pref_data) {
-    data = cache_insert(&L1(req->proc_id)->cache, req->proc_id, req->addr, &line_addr, &repl_line_addr);
+    data = cache_insert(&L1_SLICE(req->proc_id, req->addr)->cache, req->proc_id, req->addr, &line_addr, &repl_line_addr);
     STAT_EVENT(req->proc_id, L1_DATA_EVICT);
     STAT_EVENT(req->proc_id, L1_PREF_MOVE_L1);
     if (data) {
@@ -4715,16 +5464,14 @@ L1_Data* l1_pref_cache_access(Mem_Req* req) {
     data->pref_loadPC = pref_data->pref_loadPC;
     data->global_hist = pref_data->global_hist;
     data->dcache_touch = FALSE;
-    data->fetched_by_offpath = req->off_path;
-    data->offpath_op_addr = req->oldest_op_addr;
-    data->offpath_op_unique = req->oldest_op_unique_num;
 
     req->l1_miss_satisfied = TRUE;
 
     if (TRACK_L1_MISS_DEPS)
       mark_ops_as_l1_miss_satisfied(req);
 
-    wp_process_l1_fill(data, req);
+    if (WP_COLLECT_STATS)
+      wp_process_l1_fill(l1_wp_data(L1_SLICE(req->proc_id, req->addr), data), req);
     STAT_EVENT(req->proc_id, L1_PREF_CACHE_HIT_PER + req->off_path);
     STAT_EVENT(req->proc_id, L1_PREF_CACHE_HIT + req->off_path);
 
@@ -4738,6 +5485,7 @@ L1_Data* l1_pref_cache_access(Mem_Req* req) {
 /* mem_get_req_count: */
 
 int mem_get_req_count(uns proc_id) {
+  UNCORE_LOCK_SCOPE();
   return mem->num_req_buffers_per_core[proc_id];
 }
 
@@ -4775,26 +5523,30 @@ void l1_cache_collect_stats() {
     WARNING(0, "Some L1 stats not collected with PRIVATE_L1 on\n");
     return;
   }
-  Cache* l1_cache = &L1(0)->cache;
+  uns num_sets = 0;
 
   ASSERT(0, NUM_CORES <= 64);
 
   for (proc_id = 0; proc_id < NUM_CORES; proc_id++)
     lines_per_core[proc_id] = 0;
 
-  for (ii = 0; ii < l1_cache->num_sets; ii++) {
-    for (jj = 0; jj < l1_cache->assoc; jj++) {
-      if (l1_cache->entries[ii][jj].valid) {
-        L1_Data* l1_line = l1_cache->entries[ii][jj].data;
-        lines_per_core[l1_line->proc_id]++;
+  for (uns slice = 0; slice < mem->num_l1_slices; slice++) {
+    Cache* l1_cache = &L1(0)[slice].cache;
+    num_sets += l1_cache->num_sets;
+    for (ii = 0; ii < l1_cache->num_sets; ii++) {
+      for (jj = 0; jj < l1_cache->assoc; jj++) {
+        if (l1_cache->entries[ii][jj].valid) {
+          L1_Data* l1_line = l1_cache->entries[ii][jj].data;
+          lines_per_core[l1_line->proc_id]++;
+        }
       }
     }
   }
 
   for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    INC_STAT_EVENT(proc_id, CORE_TOTAL_SETS_ALL_INTERVALS, l1_cache->num_sets);
+    INC_STAT_EVENT(proc_id, CORE_TOTAL_SETS_ALL_INTERVALS, num_sets);
     INC_STAT_EVENT(proc_id, CORE_L1_AVG_NUM_WAYS, lines_per_core[proc_id]);
-    mem->l1_ave_num_ways_per_core[proc_id] = (double)lines_per_core[proc_id] / l1_cache->num_sets;
+    mem->l1_ave_num_ways_per_core[proc_id] = (double)lines_per_core[proc_id] / num_sets;
   }
 }
 
@@ -4810,15 +5562,12 @@ Flag is_inv_state(Mem_Req_State state) {
 /**************************************************************************************/
 /* wp_process_l1_hit: */
 
-void wp_process_l1_hit(L1_Data* line, Mem_Req* req) {
+void wp_process_l1_hit(L1_Wp_Data* line, Mem_Req* req) {
   if (!line) {
     ASSERT(req->proc_id, PERFECT_L1);
     return;
   }
 
-  if (!WP_COLLECT_STATS)
-    return;
-
   if (!req->off_path) {
     if (line->fetched_by_offpath) {
       STAT_EVENT(req->proc_id, L1_HIT_ONPATH_SAT_BY_OFFPATH);
@@ -4887,9 +5636,13 @@ void wp_process_l1_hit(L1_Data* line, Mem_Req* req) {
 /**************************************************************************************/
 /* wp_process_l1_fill: */
 
-void wp_process_l1_fill(L1_Data* line, Mem_Req* req) {
-  if (!WP_COLLECT_STATS)
-    return;
+void wp_process_l1_fill(L1_Wp_Data* line, Mem_Req* req) {
+  if (line) {
+    line->fetched_by_offpath = req->off_path;
+    line->l0_modified_fetched_by_offpath = FALSE;
+    line->offpath_op_addr = req->oldest_op_addr;
+    line->offpath_op_unique = req->oldest_op_unique_num;
+  }
 
   if ((req->type == MRT_WB) || (req->type == MRT_WB_NODIRTY) ||
       (req->type == MRT_DPRF)) /* for now we don't consider prefetches */
@@ -4934,9 +5687,6 @@ void wp_process_l1_fill(L1_Data* line, Mem_Req* req) {
 /* wp_process_reqbuf_match: */
 
 void wp_process_reqbuf_match(Mem_Req* req, Op* op) {
-  if (!WP_COLLECT_STATS)
-    return;
-
   if (op) {
     if (req->off_path) {
       if (!op->off_path) {
@@ -5007,6 +5757,7 @@ uns num_offchip_stall_reqs(uns proc_id) {
 Mem_Req* mem_search_reqbuf_wrapper(uns8 proc_id, Addr addr, Mem_Req_Type type, uns size, Flag* demand_hit_prefetch,
                                    Flag* demand_hit_writeback, uns queues_to_search, Mem_Queue_Entry** queue_entry,
                                    Flag* ramulator_match) {
+  UNCORE_LOCK_SCOPE();
   return mem_search_reqbuf(proc_id, addr, type, size, demand_hit_prefetch, demand_hit_writeback, queues_to_search,
                            queue_entry, ramulator_match);
 }
@@ -35,7 +35,7 @@
 
 #include "libs/cache_lib.h"
 #include "libs/hash_lib.h"
-#include "libs/list_lib.h"
+#include "libs/deque_lib.h"
 #include "libs/port_lib.h"
 #include "memory/mem_req.h"
 
@@ -51,20 +51,24 @@
 /**************************************************************************************/
 /* Types */
 
+/* Per-line data of the MLC and L1 caches. Kept small since every line of a
+   large cache carries one; the fields only the eviction stats read are in
+   L1_Data_Ext. */
 typedef struct L1_Data_struct {
-  uns8 proc_id;       /* processor id that generated this miss */
-  Flag dirty;         /* is the line dirty? */
-  Flag prefetch;      /* was the line prefetched? */
-  Flag seen_prefetch; /* have we counted this prefetch earlier */
-  uns pref_distance;
-  Addr pref_loadPC;
-  uns32 global_hist;                   /* used for prefetch hfilter */
+  uns8 proc_id;                        /* processor id that generated this miss */
+  Flag dirty;                          /* is the line dirty? */
+  Flag prefetch;                       /* was the line prefetched? */
+  Flag seen_prefetch;                  /* have we counted this prefetch earlier */
   uns8 prefetcher_id;                  /* which Prefetcher sent this prefetch */
   Flag dcache_touch;                   /* does dcache touch? for measuring useless prefetch */
-  Flag fetched_by_offpath;             /* fetched by an off_path op? */
-  Flag l0_modified_fetched_by_offpath; /* fetched by an off_path op? */
-  Addr offpath_op_addr;                /* PC of the off path op that fetched this line */
-  Counter offpath_op_unique;           /* unique of the off path op that fetched this line */
+  uns32 global_hist;                   /* used for prefetch hfilter */
+  Addr pref_loadPC;
+} L1_Data;
+
+/* Side table entry of an MLC or L1 line (see cache_line_ext), only present
+   with CACHE_LINE_STATS */
+typedef struct L1_Data_Ext_struct {
+  uns pref_distance;
 
   Counter mlc_miss_latency; /* memory latency the request for this line
                                experienced */
@@ -72,7 +76,16 @@ typedef struct L1_Data_struct {
                                experienced */
   Counter fetch_cycle;
   Counter onpath_use_cycle;
-} L1_Data;
+} L1_Data_Ext;
+
+/* Wrong-path analytics of an L1 line, in a side table of the L1 that only
+   exists with WP_COLLECT_STATS (see l1_wp_data) */
+typedef struct L1_Wp_Data_struct {
+  Flag fetched_by_offpath;             /* fetched by an off_path op? */
+  Flag l0_modified_fetched_by_offpath; /* fetched by an off_path op? */
+  Addr offpath_op_addr;                /* PC of the off path op that fetched this line */
+  Counter offpath_op_unique;           /* unique of the off path op that fetched this line */
+} L1_Wp_Data;
 
 typedef L1_Data MLC_Data; /* Use the same data structure for simplicity */
 
@@ -98,13 +111,34 @@ typedef struct Mem_Queue_Entry_struct {
   Counter rdy_cycle;
 } Mem_Queue_Entry;
 
+/* A prefetch inserted into a queue, in the queue's age-ordered kick-out
+   index. The entry goes stale once its request leaves the queue; stale
+   entries are dropped when they reach the top or the heap is compacted. */
+typedef struct Mem_Pref_Heap_Entry_struct {
+  Counter start_cycle;
+  Counter insert_num; /* queue_insert_num of the request at insertion */
+  int reqbuf;
+} Mem_Pref_Heap_Entry;
+
+typedef struct Mem_Pref_Heap_struct {
+  Mem_Pref_Heap_Entry* entries; /* binary min-heap, oldest on top */
+  uns count;
+  uns size;
+} Mem_Pref_Heap;
+
 typedef struct Mem_Queue_struct {
   Mem_Queue_Entry* base;
+  Mem_Queue_Entry* scratch; /* merge buffer for mem_queue_sort() */
   int entry_count;
   int reserved_entry_count; /* for HIER_MSHR_ON */
+  Counter next_rdy_cycle;   /* no entry is ready before this cycle */
   uns size;
   char name[20];
   Mem_Queue_Type type;
+  /* KICKOUT_OLDEST_PREFETCH victims: [0] over all banks, then one heap per
+     bank with KICKOUT_OLDEST_PREFETCH_WITHIN_BANK; NULL if not searched */
+  Mem_Pref_Heap* pref_heaps;
+  uns num_pref_heaps;
 } Mem_Queue;
 
 typedef struct Mem_Bank_Queue_Entry_struct {
@@ -126,28 +160,84 @@ typedef struct Ported_Cache_struct {
   struct Cache_struct cache;
   struct Ports_struct* ports;
   uns num_banks;
+  L1_Wp_Data* wp_data; /* per line, NULL unless this is an L1 and WP_COLLECT_STATS is on */
 } Ported_Cache;
 
+/* The wrong-path entry of the line whose data cache_access/cache_insert returned, NULL without the side table */
+static inline L1_Wp_Data* l1_wp_data(Ported_Cache* l1, L1_Data* line) {
+  return l1->wp_data && line ? &l1->wp_data[cache_line_index(&l1->cache, line)] : NULL;
+}
+
 typedef struct Uncore_struct {
   Ported_Cache* mlc;
-  Ported_Cache* l1;
+  Ported_Cache* l1; /* array of mem->num_l1_slices slices */
   uns num_outstanding_l1_accesses;
   uns num_outstanding_l1_misses;
   Counter mem_block_start;
 } Uncore;
 
+/* One live (size, line address) key of the request buffer.  Requests with the
+   same key share an entry; count == 0 marks an empty slot. */
+typedef struct Mem_Req_Addr_Index_Entry_struct {
+  Addr addr;
+  uns size;
+  uns count;
+} Mem_Req_Addr_Index_Entry;
+
+/* Request buffer admission classes. Each leaves the reserve of the classes
+   below it: prefetches MEM_REQ_BUFFER_PREF_WATERMARK entries, all but
+   writebacks MEM_REQ_BUFFER_WB_VALVE, and all but L1 writebacks the last
+   entry, which keeps an L1 writeback (which causes no further writebacks)
+   from deadlocking. */
+typedef enum Mem_Credit_Class_enum {
+  MEM_CREDIT_PREF,
+  MEM_CREDIT_DEMAND,
+  MEM_CREDIT_WB,
+  MEM_CREDIT_L1_WB,
+  NUM_MEM_CREDIT_CLASSES,
+} Mem_Credit_Class;
+
+/* Dirty lines evicted from a cache level that the next level has not taken
+   yet, oldest first. A line evicted again while it waits is coalesced into
+   its entry. */
+typedef struct Mem_Wb_Buffer_struct {
+  Addr* addrs;
+  uns8* proc_ids;
+  uns head;
+  uns count;
+  uns size; /* 0 if the level does not buffer its writebacks */
+} Mem_Wb_Buffer;
+
 typedef struct Memory_struct {
   /* miss buffer */
   Mem_Req* req_buffer;
-  List req_buffer_free_list;
-  List* l1_in_buffer_core;
+  Mem_Req_Waiter* waiter_slab; /* the first MEM_REQ_WAITER_SLOTS waiters of each entry */
+  int* req_buffer_free_stack;  // indices of the free entries, the most recently freed on top
+  int req_buffer_free_count;
+  Deque* l1_in_buffer_core;
   uns total_mem_req_buffers;
   uns* num_req_buffers_per_core;
+  uns num_req_buffers_shared;
+  /* a request is admitted while the entries used in its core's pool (the
+     core's own with PRIVATE_MSHR_ON, else the shared count) are below the
+     credits of its class */
+  uns** req_buffer_pool;
+  uns req_buffer_credits[NUM_MEM_CREDIT_CLASSES];
 
   int req_count;
+  Counter queue_insert_count; /* stamps each insertion into a queue */
+
+  /* address index over the live request buffer entries, used to skip queue
+     scans in mem_search_reqbuf that cannot match */
+  Mem_Req_Addr_Index_Entry* req_addr_index;
+  uns req_addr_index_shift;
+  uns* req_addr_index_sizes;  // distinct sizes of the live reqs
+  uns* req_addr_index_size_counts;
+  uns req_addr_index_num_sizes;
 
   /* uncore (includes MLC and L1) */
   Uncore* uncores;
+  uns num_l1_slices; /* each uncore's l1 points at an array of this many slices */
 
   /* prfetcher cache */
   Cache pref_l1_cache;
@@ -155,13 +245,19 @@ typedef struct Memory_struct {
   /* various queues (arrays) */
   Mem_Queue mlc_queue;
   Mem_Queue mlc_fill_queue;
-  Mem_Queue l1_queue;
+  Mem_Queue* l1_queues; /* one per L1 slice, indexed by mem_l1_slice() */
   Mem_Queue bus_out_queue;
   Mem_Queue l1fill_queue;
   Mem_Queue* core_fill_queues;
 
   Counter last_mem_queue_cycle;
 
+  /* MEM_WB_BUFFER_ENTRIES writeback buffers: one per core for the MLC, one
+     shared for the L1 */
+  Mem_Wb_Buffer* mlc_wb_buffers;
+  Mem_Wb_Buffer l1_wb_buffer;
+  uns wb_buffered; /* entries in all of them */
+
   /* PREF_ANALYZE_LOAD study */
   Hash_Table* pref_loadPC_hash;
   Cache_Insert_Repl pref_replpos;
@@ -219,11 +315,15 @@ typedef struct Umon_Cache_Data_struct {
 int mem_compare_priority(const void* a, const void* b);
 
 void set_memory(Memory*);
+uns mem_l1_slice(Addr addr);
 void init_memory(void);
 void reset_memory(void);
 void recover_memory(void);
 void debug_memory(void);
 void update_memory(void);
+void update_memory_uncore(void);
+void update_memory_core(uns proc_id);
+Counter memory_next_event_cycle(void);
 
 Flag scan_stores(Addr, uns);
 void op_nuke_mem_req(Op*);
@@ -231,11 +331,15 @@ Flag mem_req_younger_than_uniquenum(int, Counter);
 Flag mem_req_older_than_uniquenum(int, Counter);
 L1_Data* do_l1_access(Op* op);
 L1_Data* do_l1_access_addr(Addr);
+L1_Wp_Data* do_l1_wp_access(Op* op);
+L1_Wp_Data* do_l1_wp_access_addr(Addr);
 L1_Data* do_mlc_access(Op* op);
 L1_Data* do_mlc_access_addr(Addr);
 
 Flag new_mem_req(Mem_Req_Type type, uns8 proc_id, Addr addr, uns size, uns delay, Op* op, Flag done_func(Mem_Req*),
                  Counter unique_num, Pref_Req_Info*);
+uns new_mem_req_batch(Mem_Req_Type type, uns8 proc_id, const Addr* addrs, uns num_addrs, Flag done_func(Mem_Req*),
+                      Counter unique_num, Pref_Req_Info* pref_info, Mem_Queue_Req_Result* results);
 void mem_free_reqbuf(Mem_Req* req);
 void mem_complete_bus_in_access(Mem_Req* req, Counter priority);
 void print_req_buffer(void);
@@ -256,8 +360,9 @@ void stats_per_core_collect(uns8 proc_id);
 void finalize_memory(void);
 void l1_cache_collect_stats(void);
 
-void wp_process_l1_hit(L1_Data* line, Mem_Req* req);
-void wp_process_l1_fill(L1_Data* line, Mem_Req* req);
+/* Wrong-path analytics, only to be called with WP_COLLECT_STATS */
+void wp_process_l1_hit(L1_Wp_Data* line, Mem_Req* req);
+void wp_process_l1_fill(L1_Wp_Data* line, Mem_Req* req);
 void wp_process_reqbuf_match(Mem_Req* req, Op* op);
 
 // batch scheduler
@@ -0,0 +1,406 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : memory/noc.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : On-chip interconnect between the L1 and the memory controllers
+ ***************************************************************************************/
+
+#include "memory/noc.h"
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "debug/debug_macros.h"
+
+#include "core.param.h"
+#include "memory/memory.param.h"
+#include "ramulator.param.h"
+
+#include "memory/mem_req.h"
+#include "memory/memory.h"
+
+#include "freq.h"
+#include "ramulator.h"
+#include "statistics.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_MEMORY, ##args)
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Noc_Packet_struct {
+  Mem_Req* req;     /* the request in flight, or wb_copy for a writeback */
+  Mem_Req wb_copy;  /* writebacks are freed by the L1 once they are sent */
+  Counter inject_cycle;
+  Counter arrive_cycle;
+  Counter seq; /* orders packets arriving in the same cycle by injection */
+} Noc_Packet;
+
+/* min-heap of packet indices on (arrive_cycle, seq) */
+typedef struct Noc_Heap_struct {
+  uns* entries;
+  uns count;
+} Noc_Heap;
+
+/**************************************************************************************/
+/* Global Variables */
+
+DEFINE_ENUM(Noc_Topology, NOC_TOPOLOGY_LIST);
+
+static Noc_Packet* packets;
+static uns* free_packets;
+static uns num_free_packets;
+static uns num_req_packets; /* bounded by NOC_BUFFER_ENTRIES */
+static Noc_Heap req_heap;   /* towards the memory controllers */
+static Noc_Heap resp_heap;  /* towards the L1 */
+static Counter packet_seq;
+
+static uns num_nodes;
+static uns mesh_cols;
+static Counter* link_free_cycle; /* first cycle each directed link takes a new packet */
+static uns data_flits;           /* flits of a packet carrying a line */
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static inline Flag packet_before(uns a, uns b);
+static void heap_push(Noc_Heap* heap, uns idx);
+static uns heap_pop(Noc_Heap* heap);
+static uns noc_alloc_packet(Mem_Req* req);
+static uns noc_l1_node(Mem_Req* req);
+static uns noc_mc_node(Mem_Req* req);
+static uns noc_next_hop(uns node, uns dst, uns* link);
+static Counter noc_traverse(Mem_Req* req, uns src, uns dst, uns flits, Counter cycle);
+static Mem_Req* noc_search_heap(Noc_Heap* heap, Addr phys_addr, Mem_Req_Type type);
+
+/**************************************************************************************/
+/* noc_init: */
+
+void noc_init() {
+  if (NOC_TOPOLOGY == NOC_TOPOLOGY_NONE)
+    return;
+
+  ASSERTM(0, NOC_BUFFER_ENTRIES > 0, "NOC_BUFFER_ENTRIES must be at least 1\n");
+  ASSERTM(0, NOC_LINK_BYTES > 0, "NOC_LINK_BYTES must be at least 1\n");
+  ASSERTM(0, !CONSTANT_MEMORY_LATENCY, "The NoC sits in front of Ramulator and needs CONSTANT_MEMORY_LATENCY off\n");
+
+  /* one response per request buffer plus the request packets */
+  uns num_packets = NOC_BUFFER_ENTRIES + mem->total_mem_req_buffers;
+  packets = (Noc_Packet*)calloc(num_packets, sizeof(Noc_Packet));
+  free_packets = (uns*)malloc(sizeof(uns) * num_packets);
+  for (uns ii = 0; ii < num_packets; ii++)
+    free_packets[ii] = num_packets - 1 - ii;
+  num_free_packets = num_packets;
+  req_heap.entries = (uns*)malloc(sizeof(uns) * num_packets);
+  resp_heap.entries = (uns*)malloc(sizeof(uns) * num_packets);
+
+  num_nodes = NOC_NODES ? NOC_NODES : MAX2(NUM_CORES, mem->num_l1_slices);
+  num_nodes = MAX2(num_nodes, (uns)RAMULATOR_CHANNELS);
+  uns links_per_node = 2;
+  if (NOC_TOPOLOGY == NOC_TOPOLOGY_MESH) {
+    mesh_cols = NOC_MESH_COLS;
+    if (!mesh_cols)
+      for (mesh_cols = 1; mesh_cols * mesh_cols < num_nodes; mesh_cols++)
+        ;
+    /* XY routing needs every row to be complete */
+    num_nodes = (num_nodes + mesh_cols - 1) / mesh_cols * mesh_cols;
+    links_per_node = 4;
+  }
+  link_free_cycle = (Counter*)calloc(num_nodes * links_per_node, sizeof(Counter));
+  data_flits = 1 + (L1_LINE_SIZE + NOC_LINK_BYTES - 1) / NOC_LINK_BYTES;
+}
+
+/**************************************************************************************/
+/* noc_send: */
+
+Flag noc_send(Mem_Req* req) {
+  if (NOC_TOPOLOGY == NOC_TOPOLOGY_NONE)
+    return ramulator_send(req);
+
+  if (num_req_packets == NOC_BUFFER_ENTRIES) {
+    STAT_EVENT(req->proc_id, NOC_BUFFER_FULL);
+    return FALSE;
+  }
+
+  uns idx = noc_alloc_packet(req);
+  Noc_Packet* packet = &packets[idx];
+  if (req->type == MRT_WB) {
+    packet->wb_copy = *req;
+    packet->req = &packet->wb_copy;
+  }
+  uns flits = req->type == MRT_WB ? data_flits : 1;
+  packet->arrive_cycle = noc_traverse(req, noc_l1_node(req), noc_mc_node(req), flits, packet->inject_cycle);
+  heap_push(&req_heap, idx);
+  num_req_packets++;
+
+  req->mem_queue_cycle = packet->inject_cycle;
+  STAT_EVENT(req->proc_id, NOC_REQ_PACKETS);
+  DEBUG(req->proc_id, "NoC: injected a (%s) request to address %llx, arrives at %llu\n", Mem_Req_Type_str(req->type),
+        req->addr, packet->arrive_cycle);
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* noc_complete_request: */
+
+void noc_complete_request(Mem_Req* req) {
+  if (NOC_TOPOLOGY == NOC_TOPOLOGY_NONE) {
+    mem_complete_bus_in_access(req, 0);
+    return;
+  }
+
+  uns idx = noc_alloc_packet(req);
+  Noc_Packet* packet = &packets[idx];
+  packet->arrive_cycle = noc_traverse(req, noc_mc_node(req), noc_l1_node(req), data_flits, packet->inject_cycle);
+  heap_push(&resp_heap, idx);
+  STAT_EVENT(req->proc_id, NOC_RESP_PACKETS);
+}
+
+/**************************************************************************************/
+/* noc_tick: */
+
+void noc_tick() {
+  if (NOC_TOPOLOGY == NOC_TOPOLOGY_NONE)
+    return;
+  Counter cycle = freq_cycle_count(FREQ_DOMAIN_L1);
+
+  while (resp_heap.count && packets[resp_heap.entries[0]].arrive_cycle <= cycle) {
+    uns idx = heap_pop(&resp_heap);
+    Mem_Req* req = packets[idx].req;
+    INC_STAT_EVENT(req->proc_id, NOC_RESP_LATENCY, cycle - packets[idx].inject_cycle);
+    free_packets[num_free_packets++] = idx;
+    mem_complete_bus_in_access(req, 0);
+  }
+
+  while (req_heap.count && packets[req_heap.entries[0]].arrive_cycle <= cycle) {
+    uns idx = heap_pop(&req_heap);
+    Noc_Packet* packet = &packets[idx];
+    Mem_Req* req = packet->req;
+    if (!ramulator_send(req)) {
+      /* the controller's queue is full, so the packet waits at its port */
+      STAT_EVENT(req->proc_id, NOC_MC_REJECTED);
+      packet->arrive_cycle = cycle + 1;
+      heap_push(&req_heap, idx);
+      continue;
+    }
+    INC_STAT_EVENT(req->proc_id, NOC_REQ_LATENCY, cycle - packet->inject_cycle);
+    /* memory latency is measured from the L1, not from the controller */
+    req->mem_queue_cycle = packet->inject_cycle;
+    num_req_packets--;
+    free_packets[num_free_packets++] = idx;
+  }
+}
+
+/**************************************************************************************/
+/* noc_next_event_cycle: */
+
+Counter noc_next_event_cycle() {
+  Counter next = MAX_CTR;
+  if (req_heap.count)
+    next = packets[req_heap.entries[0]].arrive_cycle;
+  if (resp_heap.count)
+    next = MIN2(next, packets[resp_heap.entries[0]].arrive_cycle);
+  return next;
+}
+
+/**************************************************************************************/
+/* noc_search_queue: */
+
+Mem_Req* noc_search_queue(Addr phys_addr, Mem_Req_Type type) {
+  if (NOC_TOPOLOGY == NOC_TOPOLOGY_NONE)
+    return NULL;
+  Mem_Req* req = noc_search_heap(&req_heap, phys_addr, type);
+  return req ? req : noc_search_heap(&resp_heap, phys_addr, type);
+}
+
+/**************************************************************************************/
+/* noc_search_heap: */
+/* Same matching rule as ramulator_search_queue(): instruction and data reads
+ * to a line are tracked separately */
+
+static Mem_Req* noc_search_heap(Noc_Heap* heap, Addr phys_addr, Mem_Req_Type type) {
+  Flag inst = type == MRT_IFETCH || type == MRT_IPRF || type == MRT_FDIPPRFON || type == MRT_FDIPPRFOFF ||
+              type == MRT_UOCPRF;
+  Flag data = type == MRT_DFETCH || type == MRT_DPRF || type == MRT_DSTORE;
+  for (uns ii = 0; ii < heap->count; ii++) {
+    Mem_Req* req = packets[heap->entries[ii]].req;
+    if (req->phys_addr != phys_addr)
+      continue;
+    if (inst && (req->type == MRT_IFETCH || req->type == MRT_IPRF || req->type == MRT_FDIPPRFON ||
+                 req->type == MRT_FDIPPRFOFF || req->type == MRT_UOCPRF))
+      return req;
+    if (data && (req->type == MRT_DFETCH || req->type == MRT_DPRF || req->type == MRT_DSTORE))
+      return req;
+  }
+  return NULL;
+}
+
+/**************************************************************************************/
+/* noc_alloc_packet: */
+
+static uns noc_alloc_packet(Mem_Req* req) {
+  ASSERT(req->proc_id, num_free_packets > 0);
+  uns idx = free_packets[--num_free_packets];
+  Noc_Packet* packet = &packets[idx];
+  packet->req = req;
+  packet->inject_cycle = freq_cycle_count(FREQ_DOMAIN_L1);
+  packet->seq = packet_seq++;
+  return idx;
+}
+
+/**************************************************************************************/
+/* noc_l1_node: */
+/* Node of the L1 (slice) that holds the request's line */
+
+static uns noc_l1_node(Mem_Req* req) {
+  if (PRIVATE_L1)
+    return req->proc_id * num_nodes / NUM_CORES;
+  return mem_l1_slice(req->addr) * num_nodes / mem->num_l1_slices;
+}
+
+/**************************************************************************************/
+/* noc_mc_node: */
+/* Node of the memory controller serving the request. Ramulator's own address
+ * mapping is not visible here, so lines are interleaved across channels and the
+ * controllers are spread evenly between the nodes. */
+
+static uns noc_mc_node(Mem_Req* req) {
+  uns channel = (req->phys_addr >> LOG2(L1_LINE_SIZE)) % RAMULATOR_CHANNELS;
+  return (2 * channel + 1) * num_nodes / (2 * RAMULATOR_CHANNELS);
+}
+
+/**************************************************************************************/
+/* noc_next_hop: */
+/* Shortest direction on the ring, X then Y on the mesh */
+
+static uns noc_next_hop(uns node, uns dst, uns* link) {
+  if (NOC_TOPOLOGY == NOC_TOPOLOGY_RING) {
+    uns forward = (dst + num_nodes - node) % num_nodes;
+    if (forward <= num_nodes - forward) {
+      *link = node * 2;
+      return (node + 1) % num_nodes;
+    }
+    *link = node * 2 + 1;
+    return (node + num_nodes - 1) % num_nodes;
+  }
+
+  uns x = node % mesh_cols;
+  uns dst_x = dst % mesh_cols;
+  if (x < dst_x) {
+    *link = node * 4;
+    return node + 1;
+  }
+  if (x > dst_x) {
+    *link = node * 4 + 1;
+    return node - 1;
+  }
+  if (node < dst) {
+    *link = node * 4 + 2;
+    return node + mesh_cols;
+  }
+  *link = node * 4 + 3;
+  return node - mesh_cols;
+}
+
+/**************************************************************************************/
+/* noc_traverse: */
+/* Arrival cycle of a packet injected at src in the given cycle. Each link on
+ * the route is reserved for as many cycles as the packet has flits, so a packet
+ * waits behind the ones that took a shared link before it. */
+
+static Counter noc_traverse(Mem_Req* req, uns src, uns dst, uns flits, Counter cycle) {
+  if (NOC_TOPOLOGY == NOC_TOPOLOGY_FIXED)
+    return cycle + NOC_FIXED_LATENCY;
+
+  uns hops = 0;
+  Counter contention = 0;
+  for (uns node = src; node != dst; hops++) {
+    uns link;
+    uns next = noc_next_hop(node, dst, &link);
+    Counter depart = MAX2(cycle, link_free_cycle[link]);
+    contention += depart - cycle;
+    link_free_cycle[link] = depart + flits;
+    cycle = depart + NOC_HOP_LATENCY;
+    node = next;
+  }
+  INC_STAT_EVENT(req->proc_id, NOC_HOPS, hops);
+  INC_STAT_EVENT(req->proc_id, NOC_CONTENTION_CYCLES, contention);
+
+  /* the tail flit follows the head over the last link */
+  return hops ? cycle + flits - 1 : cycle;
+}
+
+/**************************************************************************************/
+/* packet_before: */
+
+static inline Flag packet_before(uns a, uns b) {
+  return packets[a].arrive_cycle < packets[b].arrive_cycle ||
+         (packets[a].arrive_cycle == packets[b].arrive_cycle && packets[a].seq < packets[b].seq);
+}
+
+/**************************************************************************************/
+/* heap_push: */
+
+static void heap_push(Noc_Heap* heap, uns idx) {
+  uns pos = heap->count++;
+  while (pos > 0) {
+    uns parent = (pos - 1) / 2;
+    if (!packet_before(idx, heap->entries[parent]))
+      break;
+    heap->entries[pos] = heap->entries[parent];
+    pos = parent;
+  }
+  heap->entries[pos] = idx;
+}
+
+/**************************************************************************************/
+/* heap_pop: */
+
+static uns heap_pop(Noc_Heap* heap) {
+  ASSERT(0, heap->count > 0);
+  uns top = heap->entries[0];
+  uns last = heap->entries[--heap->count];
+  uns pos = 0;
+  for (;;) {
+    uns child = 2 * pos + 1;
+    if (child >= heap->count)
+      break;
+    if (child + 1 < heap->count && packet_before(heap->entries[child + 1], heap->entries[child]))
+      child++;
+    if (!packet_before(heap->entries[child], last))
+      break;
+    heap->entries[pos] = heap->entries[child];
+    pos = child;
+  }
+  if (heap->count)
+    heap->entries[pos] = last;
+  return top;
+}
@@ -0,0 +1,71 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : memory/noc.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : On-chip interconnect between the L1 and the memory controllers
+ ***************************************************************************************/
+
+#ifndef __NOC_H__
+#define __NOC_H__
+
+#include "globals/enum.h"
+#include "globals/global_types.h"
+
+#include "memory/mem_req.h"
+
+/**************************************************************************************/
+/* Enums */
+
+/* NONE hands L1 misses straight to the memory controllers, FIXED adds a
+   constant latency each way, RING and MESH route packets hop by hop and model
+   link contention */
+#define NOC_TOPOLOGY_LIST(elem) elem(NONE) elem(FIXED) elem(RING) elem(MESH)
+
+DECLARE_ENUM(Noc_Topology, NOC_TOPOLOGY_LIST, NOC_TOPOLOGY_);
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Initialize (after the L1 and Ramulator) */
+void noc_init(void);
+
+/* Inject a request from the L1 towards its memory controller. Returns FALSE
+   if it could not be accepted. Writebacks are copied, so their request buffer
+   may be freed as soon as this returns. */
+Flag noc_send(Mem_Req* req);
+
+/* Inject a read response from its memory controller towards the L1 */
+void noc_complete_request(Mem_Req* req);
+
+/* Deliver the packets that have arrived; call every L1 cycle */
+void noc_tick(void);
+
+/* First L1 cycle at which a packet arrives (MAX_CTR if the network is empty) */
+Counter noc_next_event_cycle(void);
+
+/* Find a read in flight in the network that a new request can merge with */
+Mem_Req* noc_search_queue(Addr phys_addr, Mem_Req_Type type);
+
+#endif /* #ifndef __NOC_H__ */
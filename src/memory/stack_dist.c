@@ -0,0 +1,193 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : memory/stack_dist.c
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Mattson stack distance profiles. For every set count a table
+ *                keeps each set's lines in LRU order, up to STACK_DIST_MAX_WAYS
+ *                deep. An access that finds its line at depth d would hit in
+ *                any cache of that set count with more than d ways, so one
+ *                histogram of depths per set count gives the miss rate of all
+ *                associativities. Lines deeper than the maximum, and cold
+ *                lines, count as misses everywhere.
+ ***************************************************************************************/
+
+#include "memory/stack_dist.h"
+
+#include <string.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "core.param.h"
+#include "general.param.h"
+#include "memory/memory.param.h"
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Stack_Dist_Table_struct {
+  uns num_sets;
+  Addr* lines;        // num_sets stacks of max_ways lines, most recent first
+  uns16* fill;        // valid lines of each stack
+  Counter* hits[2];   // per depth, [warmup]
+  Counter misses[2];  // [warmup]
+} Stack_Dist_Table;
+
+typedef struct Stack_Dist_Domain_struct {
+  Stack_Dist_Table* tables;
+} Stack_Dist_Domain;
+
+typedef struct Stack_Dist_Cache_struct {
+  const char* name;
+  uns line_shift;
+  uns num_domains;  // one per core for a private cache, else one
+  Stack_Dist_Domain* domains;
+} Stack_Dist_Cache;
+
+/**************************************************************************************/
+/* Global variables */
+
+static Stack_Dist_Cache stack_dist_caches[NUM_STACK_DIST_LEVELS];
+static uns stack_dist_num_tables;
+
+/**************************************************************************************/
+/* stack_dist_init: */
+
+static void stack_dist_cache_init(Stack_Dist_Cache* cache, const char* name, uns line_size, uns num_domains) {
+  cache->name = name;
+  cache->line_shift = LOG2(line_size);
+  cache->num_domains = num_domains;
+  cache->domains = (Stack_Dist_Domain*)calloc(num_domains, sizeof(Stack_Dist_Domain));
+  for (uns ii = 0; ii < num_domains; ii++) {
+    Stack_Dist_Table* tables = (Stack_Dist_Table*)calloc(stack_dist_num_tables, sizeof(Stack_Dist_Table));
+    for (uns jj = 0; jj < stack_dist_num_tables; jj++) {
+      Stack_Dist_Table* table = &tables[jj];
+      table->num_sets = STACK_DIST_MIN_SETS << jj;
+      table->lines = (Addr*)malloc(sizeof(Addr) * table->num_sets * STACK_DIST_MAX_WAYS);
+      table->fill = (uns16*)calloc(table->num_sets, sizeof(uns16));
+      table->hits[0] = (Counter*)calloc(STACK_DIST_MAX_WAYS, sizeof(Counter));
+      table->hits[1] = (Counter*)calloc(STACK_DIST_MAX_WAYS, sizeof(Counter));
+    }
+    cache->domains[ii].tables = tables;
+  }
+}
+
+void stack_dist_init(void) {
+  if (!STACK_DIST_ON)
+    return;
+
+  ASSERTM(0, STACK_DIST_MIN_SETS && !(STACK_DIST_MIN_SETS & (STACK_DIST_MIN_SETS - 1)) && STACK_DIST_MAX_SETS &&
+                 !(STACK_DIST_MAX_SETS & (STACK_DIST_MAX_SETS - 1)),
+          "STACK_DIST_MIN_SETS and STACK_DIST_MAX_SETS must be powers of two\n");
+  ASSERTM(0, STACK_DIST_MIN_SETS <= STACK_DIST_MAX_SETS, "STACK_DIST_MIN_SETS exceeds STACK_DIST_MAX_SETS\n");
+  ASSERTM(0, STACK_DIST_MAX_WAYS > 0 && STACK_DIST_MAX_WAYS <= 0xFFFF, "STACK_DIST_MAX_WAYS out of range\n");
+  stack_dist_num_tables = LOG2(STACK_DIST_MAX_SETS) - LOG2(STACK_DIST_MIN_SETS) + 1;
+
+  stack_dist_cache_init(&stack_dist_caches[STACK_DIST_L1], "l1", L1_LINE_SIZE, PRIVATE_L1 ? NUM_CORES : 1);
+  if (MLC_PRESENT)
+    stack_dist_cache_init(&stack_dist_caches[STACK_DIST_MLC], "mlc", MLC_LINE_SIZE, NUM_CORES);
+}
+
+/**************************************************************************************/
+/* stack_dist_access: */
+
+void stack_dist_access(uns proc_id, Stack_Dist_Level level, Addr addr, Flag warmup) {
+  Stack_Dist_Cache* cache = &stack_dist_caches[level];
+  if (!cache->domains)
+    return;
+
+  Addr line = addr >> cache->line_shift;
+  Stack_Dist_Domain* domain = &cache->domains[cache->num_domains == 1 ? 0 : proc_id];
+  for (uns ii = 0; ii < stack_dist_num_tables; ii++) {
+    Stack_Dist_Table* table = &domain->tables[ii];
+    uns set = line & (table->num_sets - 1);
+    Addr* stack = &table->lines[(uns64)set * STACK_DIST_MAX_WAYS];
+    uns fill = table->fill[set];
+    uns depth = 0;
+    while (depth < fill && stack[depth] != line)
+      depth++;
+
+    if (depth < fill) {
+      table->hits[warmup != FALSE][depth]++;
+    } else {
+      table->misses[warmup != FALSE]++;
+      if (fill < STACK_DIST_MAX_WAYS)
+        table->fill[set] = ++fill;
+      depth = fill - 1;  // the least recent line falls off a full stack
+    }
+    memmove(stack + 1, stack, depth * sizeof(Addr));
+    stack[0] = line;
+  }
+}
+
+/**************************************************************************************/
+/* stack_dist_done: */
+
+static void stack_dist_print_phase(FILE* file, Stack_Dist_Cache* cache, uns domain_id, Flag warmup) {
+  uns line_size = 1 << cache->line_shift;
+  for (uns ii = 0; ii < stack_dist_num_tables; ii++) {
+    Stack_Dist_Table* table = &cache->domains[domain_id].tables[ii];
+    Counter accesses = table->misses[warmup];
+    for (uns way = 0; way < STACK_DIST_MAX_WAYS; way++)
+      accesses += table->hits[warmup][way];
+    if (!accesses)
+      continue;
+
+    Counter misses = accesses;
+    for (uns way = 0; way < STACK_DIST_MAX_WAYS; way++) {
+      misses -= table->hits[warmup][way];
+      fprintf(file, "%-6u %-7s %8u %5u %12llu %14llu %14llu %10.6f\n", domain_id, warmup ? "warmup" : "run",
+              table->num_sets, way + 1, (uns64)table->num_sets * (way + 1) * line_size, accesses, misses,
+              (double)misses / accesses);
+    }
+  }
+}
+
+void stack_dist_done(void) {
+  for (uns level = 0; level < NUM_STACK_DIST_LEVELS; level++) {
+    Stack_Dist_Cache* cache = &stack_dist_caches[level];
+    if (!cache->domains)
+      continue;
+
+    char name[MAX_STR_LENGTH + 1];
+    snprintf(name, MAX_STR_LENGTH, "stack_dist_%s", cache->name);
+    FILE* file = file_tag_fopen(OUTPUT_DIR, name, "w");
+    if (!file) {
+      WARNINGU(0, "Couldn't open stack distance output %s/%s.out\n", OUTPUT_DIR, name);
+      continue;
+    }
+    fprintf(file, "# LRU miss rates of %s caches with %u byte lines (domain: core of a private cache, else 0)\n",
+            cache->name, 1 << cache->line_shift);
+    fprintf(file, "%-6s %-7s %8s %5s %12s %14s %14s %10s\n", "domain", "phase", "sets", "ways", "bytes", "accesses",
+            "misses", "miss_rate");
+    for (uns domain_id = 0; domain_id < cache->num_domains; domain_id++) {
+      stack_dist_print_phase(file, cache, domain_id, TRUE);
+      stack_dist_print_phase(file, cache, domain_id, FALSE);
+    }
+    fclose(file);
+  }
+}
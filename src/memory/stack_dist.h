@@ -0,0 +1,55 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : memory/stack_dist.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Single-pass LRU stack distance profiles of the L1 (LLC) and
+ *                MLC access streams, giving the miss rate of every
+ *                (sets, ways) configuration in the STACK_DIST_* range at once
+ ***************************************************************************************/
+
+#ifndef __STACK_DIST_H__
+#define __STACK_DIST_H__
+
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Stack_Dist_Level_enum {
+  STACK_DIST_L1,
+  STACK_DIST_MLC,
+  NUM_STACK_DIST_LEVELS,
+} Stack_Dist_Level;
+
+/**************************************************************************************/
+/* Prototypes */
+
+void stack_dist_init(void);
+/* Record one access to the level's cache. Warmup accesses update the stacks
+   and are counted apart from the timed ones. */
+void stack_dist_access(uns proc_id, Stack_Dist_Level level, Addr addr, Flag warmup);
+/* Write the miss rate curves to OUTPUT_DIR */
+void stack_dist_done(void);
+
+#endif /* #ifndef __STACK_DIST_H__ */
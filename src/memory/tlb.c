@@ -0,0 +1,281 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : memory/tlb.c
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : TLB hierarchy. An ITLB or DTLB miss looks up the STLB, which
+ *                answers after STLB_CYCLES; an STLB miss walks a radix page
+ *                table of TLB_WALK_LEVELS levels, one PTE read into the memory
+ *                system per level, skipping the upper levels held by a small
+ *                page walk cache. The page tables are not kept anywhere: a
+ *                PTE's address follows from the page number, in a region of
+ *                the address space set apart for them, so a walk costs the
+ *                host no more than the address arithmetic. Up to TLB_WALKERS
+ *                translations per core are in flight; accesses to a page
+ *                being translated wait on the same one.
+ ***************************************************************************************/
+
+#include "memory/tlb.h"
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+#include "globals/utils.h"
+
+#include "core.param.h"
+#include "memory/memory.param.h"
+
+#include "libs/cache_lib.h"
+#include "memory/memory.h"
+
+#include "cmp_threads.h"
+#include "freq.h"
+#include "statistics.h"
+
+/**************************************************************************************/
+/* Macros */
+
+/* PTEs of level l live at TLB_PT_BASE + (l << TLB_PT_LEVEL_SHIFT), one 4KB
+   table per prefix of the page number above the level */
+#define TLB_PT_BASE 0x600000000000ULL
+#define TLB_PT_LEVEL_SHIFT 40
+#define TLB_PT_INDEX_BITS 9
+#define TLB_PTE_BYTES 8
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Tlb_Walk_struct {
+  Flag valid;
+  uns types;            // bit per Tlb_Type waiting for the translation
+  Addr va;              // an address in the page
+  Addr vpn;             // page number, without the sign-extended and core bits
+  int level;            // page table level read next; -1 once translated
+  Flag walked;          // missed in the STLB
+  Flag issued;          // the PTE read of level is in the memory system
+  Addr pte_line;        // the line it reads
+  Counter start_cycle;
+  Counter ready_cycle;  // when the translation can be used (level -1)
+} Tlb_Walk;
+
+typedef struct Tlb_Core_struct {
+  Cache tlbs[NUM_TLB_TYPES];
+  uns last_set[NUM_TLB_TYPES];  // where the last hit of each TLB was, so accesses
+  int last_way[NUM_TLB_TYPES];  // to the same page skip the set search (-1: none)
+  Cache stlb;
+  Cache pwc;  // upper-level PTEs, by PTE address
+  Tlb_Walk* walks;
+  uns num_walks;
+} Tlb_Core;
+
+/**************************************************************************************/
+/* Global variables */
+
+static Tlb_Core tlb_cores[MAX_NUM_PROCS];
+
+/**************************************************************************************/
+/* Local prototypes */
+
+static Addr tlb_pte_addr(uns level, Addr vpn);
+static void tlb_walk_issue(uns8 proc_id, Tlb_Walk* walk);
+static void tlb_walk_finish(uns8 proc_id, Tlb_Walk* walk);
+static void tlb_service(uns8 proc_id);
+
+/**************************************************************************************/
+/* init_tlb: */
+
+void init_tlb(uns8 proc_id) {
+  if (!TLB_ON)
+    return;
+
+  ASSERTM(proc_id, TLB_WALK_LEVELS > 0 && TLB_WALK_LEVELS <= 5, "TLB_WALK_LEVELS must be 1 to 5\n");
+  ASSERTM(proc_id, TLB_WALKERS > 0, "TLB_WALKERS must be positive\n");
+  Tlb_Core* core = &tlb_cores[proc_id];
+  init_cache(&core->tlbs[TLB_INST], "ITLB", ITLB_ENTRIES * VA_PAGE_SIZE_BYTES, ITLB_ASSOC, VA_PAGE_SIZE_BYTES, 0,
+             REPL_TRUE_LRU);
+  init_cache(&core->tlbs[TLB_DATA], "DTLB", DTLB_ENTRIES * VA_PAGE_SIZE_BYTES, DTLB_ASSOC, VA_PAGE_SIZE_BYTES, 0,
+             REPL_TRUE_LRU);
+  init_cache(&core->stlb, "STLB", STLB_ENTRIES * VA_PAGE_SIZE_BYTES, STLB_ASSOC, VA_PAGE_SIZE_BYTES, 0,
+             REPL_TRUE_LRU);
+  if (TLB_PWC_ENTRIES)
+    init_cache(&core->pwc, "TLB_PWC", TLB_PWC_ENTRIES * TLB_PTE_BYTES, TLB_PWC_ENTRIES, TLB_PTE_BYTES, 0,
+               REPL_TRUE_LRU);
+  for (uns type = 0; type < NUM_TLB_TYPES; type++)
+    core->last_way[type] = -1;
+  core->walks = (Tlb_Walk*)calloc(TLB_WALKERS, sizeof(Tlb_Walk));
+}
+
+/**************************************************************************************/
+/* tlb_translate: */
+
+Flag tlb_translate(uns8 proc_id, Tlb_Type type, Addr va, Flag retry) {
+  Tlb_Core* core = &tlb_cores[proc_id];
+  Cache* tlb = &core->tlbs[type];
+  Addr line_addr;
+
+  if (core->num_walks)
+    tlb_service(proc_id);
+
+  if (cache_access_at(tlb, va, &line_addr, TRUE, core->last_set[type], core->last_way[type]) ||
+      cache_access_way(tlb, va, &line_addr, TRUE, &core->last_set[type], &core->last_way[type])) {
+    if (!retry)
+      STAT_EVENT(proc_id, ITLB_HIT + type);
+    return TRUE;
+  }
+  if (!retry)
+    STAT_EVENT(proc_id, ITLB_MISS + type);
+
+  Addr vpn = (va & N_BIT_MASK(NUM_ADDR_NON_SIGN_EXTEND_BITS)) >> LOG2(VA_PAGE_SIZE_BYTES);
+  Tlb_Walk* walk = NULL;
+  for (uns ii = 0; ii < TLB_WALKERS; ii++) {
+    if (core->walks[ii].valid && core->walks[ii].vpn == vpn) {
+      core->walks[ii].types |= 1 << type;
+      return FALSE;
+    }
+    if (!core->walks[ii].valid && !walk)
+      walk = &core->walks[ii];
+  }
+  if (!walk) {
+    if (!retry)
+      STAT_EVENT(proc_id, TLB_WALKERS_FULL);
+    return FALSE;
+  }
+
+  walk->valid = TRUE;
+  walk->types = 1 << type;
+  walk->va = va;
+  walk->vpn = vpn;
+  walk->issued = FALSE;
+  walk->start_cycle = cycle_count;
+  core->num_walks++;
+  if (cache_access(&core->stlb, va, &line_addr, TRUE)) {
+    STAT_EVENT(proc_id, STLB_HIT);
+    walk->walked = FALSE;
+    walk->level = -1;
+    walk->ready_cycle = cycle_count + STLB_CYCLES;
+  } else {
+    STAT_EVENT(proc_id, STLB_MISS);
+    walk->walked = TRUE;
+    walk->level = TLB_WALK_LEVELS - 1;
+    walk->ready_cycle = MAX_CTR;
+    // start below the deepest level whose PTE the page walk cache holds
+    for (uns level = 1; TLB_PWC_ENTRIES && level < TLB_WALK_LEVELS; level++) {
+      if (cache_access(&core->pwc, tlb_pte_addr(level, vpn), &line_addr, TRUE)) {
+        STAT_EVENT(proc_id, TLB_PWC_HIT);
+        walk->level = level - 1;
+        break;
+      }
+    }
+  }
+
+  tlb_service(proc_id);
+  return !walk->valid;
+}
+
+/**************************************************************************************/
+/* tlb_walk_fill: the PTE line of one or more walks has arrived */
+
+Flag tlb_walk_fill(Mem_Req* req) {
+  Tlb_Core* core = &tlb_cores[req->proc_id];
+  // keep the cycle of a core catching up on a sync quantum
+  Counter now = cmp_threads_sync_lag ? cycle_count : freq_cycle_count(FREQ_DOMAIN_CORES[req->proc_id]);
+
+  for (uns ii = 0; ii < TLB_WALKERS; ii++) {
+    Tlb_Walk* walk = &core->walks[ii];
+    if (!walk->valid || !walk->issued || walk->pte_line != req->addr)
+      continue;
+    walk->issued = FALSE;
+    if (walk->level > 0 && TLB_PWC_ENTRIES) {
+      Addr line_addr, repl_line_addr;
+      Addr pte_addr = tlb_pte_addr(walk->level, walk->vpn);
+      if (!cache_access(&core->pwc, pte_addr, &line_addr, FALSE))
+        cache_insert(&core->pwc, req->proc_id, pte_addr, &line_addr, &repl_line_addr);
+    }
+    walk->level--;
+    if (walk->level < 0)
+      walk->ready_cycle = now;
+  }
+  return SUCCESS;
+}
+
+/**************************************************************************************/
+/* tlb_pte_addr: */
+
+static Addr tlb_pte_addr(uns level, Addr vpn) {
+  Addr table = vpn >> (TLB_PT_INDEX_BITS * (level + 1));
+  Addr index = (vpn >> (TLB_PT_INDEX_BITS * level)) & N_BIT_MASK(TLB_PT_INDEX_BITS);
+  return TLB_PT_BASE + ((Addr)level << TLB_PT_LEVEL_SHIFT) + (table << 12) + index * TLB_PTE_BYTES;
+}
+
+/**************************************************************************************/
+/* tlb_walk_issue: sends the PTE read of the walk's level, if a request buffer is free */
+
+static void tlb_walk_issue(uns8 proc_id, Tlb_Walk* walk) {
+  Addr pte_addr = convert_to_cmp_addr(proc_id, tlb_pte_addr(walk->level, walk->vpn));
+  walk->pte_line = pte_addr & ~(Addr)(DCACHE_LINE_SIZE - 1);
+  if (new_mem_req(MRT_DFETCH, proc_id, walk->pte_line, DCACHE_LINE_SIZE, 0, NULL, tlb_walk_fill, unique_count,
+                  NULL)) {
+    walk->issued = TRUE;
+    STAT_EVENT(proc_id, TLB_WALK_MEM_REQ);
+  }
+}
+
+/**************************************************************************************/
+/* tlb_walk_finish: fills the translation into the TLBs waiting for it */
+
+static void tlb_walk_finish(uns8 proc_id, Tlb_Walk* walk) {
+  Tlb_Core* core = &tlb_cores[proc_id];
+  Addr line_addr, repl_line_addr;
+
+  if (walk->walked) {
+    STAT_EVENT(proc_id, TLB_WALKS);
+    INC_STAT_EVENT(proc_id, TLB_WALK_CYCLES, cycle_count - walk->start_cycle);
+    cache_insert(&core->stlb, proc_id, walk->va, &line_addr, &repl_line_addr);
+  }
+  for (uns type = 0; type < NUM_TLB_TYPES; type++) {
+    if ((walk->types & (1 << type)) && !cache_access(&core->tlbs[type], walk->va, &line_addr, FALSE))
+      cache_insert(&core->tlbs[type], proc_id, walk->va, &line_addr, &repl_line_addr);
+  }
+  walk->valid = FALSE;
+  core->num_walks--;
+}
+
+/**************************************************************************************/
+/* tlb_service: issues the PTE reads that are due and finishes the translations
+   that are done */
+
+static void tlb_service(uns8 proc_id) {
+  Tlb_Core* core = &tlb_cores[proc_id];
+  for (uns ii = 0; ii < TLB_WALKERS; ii++) {
+    Tlb_Walk* walk = &core->walks[ii];
+    if (!walk->valid)
+      continue;
+    if (walk->level >= 0) {
+      if (!walk->issued)
+        tlb_walk_issue(proc_id, walk);
+    } else if (cycle_count >= walk->ready_cycle) {
+      tlb_walk_finish(proc_id, walk);
+    }
+  }
+}
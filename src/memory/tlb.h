@@ -0,0 +1,57 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : memory/tlb.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Per-core ITLB, DTLB and STLB with page walks whose PTE reads
+ *                go through the memory system (see TLB_ON)
+ ***************************************************************************************/
+
+#ifndef __TLB_H__
+#define __TLB_H__
+
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Types */
+
+typedef enum Tlb_Type_enum {
+  TLB_INST,
+  TLB_DATA,
+  NUM_TLB_TYPES,
+} Tlb_Type;
+
+struct Mem_Req_struct;
+
+/**************************************************************************************/
+/* Prototypes */
+
+void init_tlb(uns8 proc_id);
+/* Whether the page of va is translated for an access of the given type. On a
+   miss the translation is started and the caller asks again in later cycles
+   with retry set, which keeps the retries out of the hit and miss counts. */
+Flag tlb_translate(uns8 proc_id, Tlb_Type type, Addr va, Flag retry);
+/* done_func of the PTE reads of a page walk */
+Flag tlb_walk_fill(struct Mem_Req_struct* req);
+
+#endif /* #ifndef __TLB_H__ */
@@ -33,12 +33,16 @@
 
 #include "thread.h"
 
+struct Snapshot_struct;
+struct Frontend_Skip_Inst_struct;
+
 /**************************************************************************************/
 /* Types */
 
 typedef enum Model_Id_enum {
   CMP_MODEL,
   DUMB_MODEL,
+  INTERVAL_MODEL,
   NUM_MODELS,
 } Model_Id;
 
@@ -66,6 +70,14 @@ typedef struct Model_struct {
   void (*op_fetched_hook)(Op*);
   void (*op_retired_hook)(Op*);  // called just before the op is freed
   void (*warmup_func)(Op* op);   // called for warmup(may be NULL)
+  void (*snapshot_func)(struct Snapshot_struct*);  // called to save or restore the state trained by warmup_func
+                                                   // (may be NULL)
+  void (*warmup_skip_func)(uns, const struct Frontend_Skip_Inst_struct*);  // called for warmup of instructions
+                                                                           // skipped without ops (may be NULL)
+  Op* (*warmup_op_func)(void);     // returns the op the next warmup op is fetched into (NULL for the caller's),
+                                   // which warmup_func may keep until warmup_done_func (may be NULL)
+  void (*warmup_done_func)(void);  // called at the end of a warmup phase, before the warmed state is used
+                                   // (may be NULL)
 
   /*      void (*l0_cache_miss_hook)      (Op *); */
   /*      void (*resolve_mispredict_hook) (Op *); */
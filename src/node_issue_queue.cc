@@ -29,6 +29,10 @@
 
 #include "node_issue_queue.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 extern "C" {
 #include "globals/assert.h"
 #include "globals/global_defs.h"
@@ -51,12 +55,39 @@ extern "C" {
 
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_NODE_STAGE, ##args)
 
+#define BITMATRIX_WORD(entry) ((entry) >> 6)
+#define BITMATRIX_BIT(entry) (1ULL << ((entry)&63))
+
+/**************************************************************************************/
+/* Types */
+
+/*
+ * Entry state of one RS for the BITMATRIX scheduler. All vectors hold one bit
+ * per RS entry in num_words uns64 words.
+ */
+typedef struct Rs_Bitmatrix_struct {
+  uns32 num_words;
+  uns64* free;        // entries not holding an op
+  uns64* ready;       // entries requesting an FU this cycle
+  uns64* candidates;  // scratch vector used by select
+  uns64* eligible;    // one vector per connected FU: entries whose op it can execute
+  uns64* older;       // age matrix: row e holds the entries older than entry e
+  Op** ops;           // op held by each entry
+} Rs_Bitmatrix;
+
 /**************************************************************************************/
 /* Prototypes */
 
 int64 node_dispatch_find_emptiest_rs(Op*);
 void node_schedule_oldest_first_sched(Op*);
+void node_schedule_bitmatrix_sched(Op*);
+void node_select_bitmatrix();
+Rs_Bitmatrix* node_bitmatrix_alloc(Reservation_Station*);
+void node_bitmatrix_insert(Reservation_Station*, Op*);
+uns node_bitmatrix_oldest(Rs_Bitmatrix*);
 void node_track_fu_idle_stats();
+void node_issue_queue_consider(Op*);
+void node_issue_queue_schedule_ready_vector();
 
 /**************************************************************************************/
 /* Issuers:
@@ -74,34 +105,23 @@ int64 node_dispatch_find_emptiest_rs(Op* op) {
   uns emptiest_rs_slots = 0;
 
   /*
-   * Iterate through RSs looking for an available RS that is connected to
-   * an FU that can execute the OP.
+   * Iterate through the RSs that are connected to an FU that can execute the
+   * OP, looking for an available one.
    */
-  for (int64 rs_id = 0; rs_id < NUM_RS; ++rs_id) {
+  uns64 eligible_rss = node->fu_type_rs_mask[fu_type_index(op->table_info->op_type, op->table_info->is_simd)];
+  for (; eligible_rss; eligible_rss &= eligible_rss - 1) {
+    int64 rs_id = __builtin_ctzll(eligible_rss);
     Reservation_Station* rs = &node->rs[rs_id];
-    ASSERT(node->proc_id, !rs->size || rs->rs_op_count <= rs->size);
 
     /* TODO: support infinite RS for upper-bound expr */
     ASSERTM(node->proc_id, rs->size, "Infinite RS not suppoted by node_dispatch_find_emptiest_rs issuer.");
+    ASSERT(node->proc_id, rs->size >= rs->rs_op_count);
 
-    for (uns32 i = 0; i < rs->num_fus; ++i) {
-      // find the FU that can execute this op
-      Func_Unit* fu = rs->connected_fus[i];
-      if (!(get_fu_type(op->table_info->op_type, op->table_info->is_simd) & fu->type)) {
-        continue;
-      }
-
-      ASSERT(node->proc_id, rs->size >= rs->rs_op_count);
-      uns num_empty_slots = rs->size - rs->rs_op_count;
-      if (num_empty_slots == 0) {
-        continue;
-      }
-
-      // find the emptiest RS
-      if (emptiest_rs_slots < num_empty_slots) {
-        emptiest_rs_id = rs_id;
-        emptiest_rs_slots = num_empty_slots;
-      }
+    // find the emptiest RS
+    uns num_empty_slots = rs->size - rs->rs_op_count;
+    if (emptiest_rs_slots < num_empty_slots) {
+      emptiest_rs_id = rs_id;
+      emptiest_rs_slots = num_empty_slots;
     }
   }
 
@@ -123,16 +143,11 @@ int64 node_dispatch_find_emptiest_rs(Op* op) {
 void node_schedule_oldest_first_sched(Op* op) {
   int32 youngest_slot_op_id = NODE_ISSUE_QUEUE_FU_SLOT_INVALID;
 
-  // Iterate through the FUs that this RS is connected to.
+  // Iterate through the FUs that this RS is connected to and that can execute this op.
   Reservation_Station* rs = &node->rs[op->rs_id];
-  for (uns32 i = 0; i < rs->num_fus; ++i) {
-    // check if this op can be executed by this FU
-    Func_Unit* fu = rs->connected_fus[i];
-    if (!(get_fu_type(op->table_info->op_type, op->table_info->is_simd) & fu->type)) {
-      continue;
-    }
-
-    uns32 fu_id = fu->fu_id;
+  uns64 fus = rs->fu_mask & node->fu_type_fu_mask[fu_type_index(op->table_info->op_type, op->table_info->is_simd)];
+  for (; fus; fus &= fus - 1) {
+    uns32 fu_id = __builtin_ctzll(fus);
     Op* s_op = node->sd.ops[fu_id];
 
     // nobody has been scheduled to this FU yet
@@ -185,6 +200,148 @@ void node_schedule_oldest_first_sched(Op* op) {
   ASSERT(node->proc_id, node->sd.op_count <= node->sd.max_op_count);
 }
 
+/*
+ * BITMATRIX_SCHED: also selects the oldest ready ops, but only marks the op
+ * ready here. node_select_bitmatrix() then picks, for each FU, the oldest
+ * ready entry of its RS that the FU can execute, using word-wide operations on
+ * the per-RS bit vectors instead of comparing op ages. An FU connected to
+ * several RSs goes to the oldest of their picks, as in the scalar path.
+ */
+void node_schedule_bitmatrix_sched(Op* op) {
+  Rs_Bitmatrix* bm = node->rs[op->rs_id].bitmatrix;
+  ASSERT(node->proc_id, bm && bm->ops[op->rs_entry] == op);
+  bm->ready[BITMATRIX_WORD(op->rs_entry)] |= BITMATRIX_BIT(op->rs_entry);
+}
+
+void node_select_bitmatrix() {
+  for (int64 rs_id = 0; rs_id < NUM_RS; ++rs_id) {
+    Reservation_Station* rs = &node->rs[rs_id];
+    Rs_Bitmatrix* bm = rs->bitmatrix;
+    if (!bm)
+      continue;
+
+    uns32 num_words = bm->num_words;
+    for (uns32 i = 0; i < rs->num_fus; ++i) {
+      uns64* eligible = &bm->eligible[i * num_words];
+      uns64 any = 0;
+      for (uns32 w = 0; w < num_words; ++w) {
+        bm->candidates[w] = bm->ready[w] & eligible[w];
+        any |= bm->candidates[w];
+      }
+      if (!any)
+        continue;
+
+      uns entry = node_bitmatrix_oldest(bm);
+      Op* op = bm->ops[entry];
+      uns32 fu_id = rs->connected_fus[i]->fu_id;
+      ASSERT(node->proc_id, fu_id < (uns32)node->sd.max_op_count);
+      Op* s_op = node->sd.ops[fu_id];
+      if (s_op && s_op->op_num < op->op_num)
+        continue;  // the FU went to an older op of another RS
+
+      DEBUG(node->proc_id, "Scheduler selecting    op_num:%s  fu_id:%d op:%s l1:%d\n", unsstr64(op->op_num), fu_id,
+            disasm_op(op, TRUE), op->engine_info.l1_miss);
+      if (s_op) {
+        // displace a younger op picked by an earlier RS; it is marked ready again next cycle
+        s_op->fu_num = -1;
+        STAT_EVENT(node->proc_id, RS_OP_READY_NOT_ISSUED_TOTAL);
+        STAT_EVENT(node->proc_id, RS_0_OP_READY_NOT_ISSUED + (s_op->rs_id < 8 ? s_op->rs_id : 8));
+      }
+      op->fu_num = fu_id;
+      node->sd.ops[op->fu_num] = op;
+      node->last_scheduled_opnum = op->op_num;
+      node->sd.op_count += !s_op;
+      ASSERT(node->proc_id, node->sd.op_count <= node->sd.max_op_count);
+      bm->ready[BITMATRIX_WORD(entry)] &= ~BITMATRIX_BIT(entry);
+    }
+
+    // whatever is still ready lost select this cycle; start the next one empty
+    uns32 num_not_issued = 0;
+    for (uns32 w = 0; w < num_words; ++w) {
+      num_not_issued += __builtin_popcountll(bm->ready[w]);
+      bm->ready[w] = 0;
+    }
+    if (num_not_issued) {
+      INC_STAT_EVENT(node->proc_id, RS_OP_READY_NOT_ISSUED_TOTAL, num_not_issued);
+      INC_STAT_EVENT(node->proc_id, RS_0_OP_READY_NOT_ISSUED + (rs_id < 8 ? rs_id : 8), num_not_issued);
+    }
+  }
+}
+
+/**************************************************************************************/
+/* BITMATRIX entry management */
+
+Rs_Bitmatrix* node_bitmatrix_alloc(Reservation_Station* rs) {
+  ASSERTM(node->proc_id, rs->size, "Infinite RS not supported by the BITMATRIX scheduler.\n");
+  Rs_Bitmatrix* bm = (Rs_Bitmatrix*)calloc(1, sizeof(Rs_Bitmatrix));
+  uns32 num_words = (rs->size + 63) / 64;
+  bm->num_words = num_words;
+  bm->free = (uns64*)calloc(num_words, sizeof(uns64));
+  bm->ready = (uns64*)calloc(num_words, sizeof(uns64));
+  bm->candidates = (uns64*)calloc(num_words, sizeof(uns64));
+  bm->eligible = (uns64*)calloc(rs->num_fus * num_words, sizeof(uns64));
+  bm->older = (uns64*)calloc(rs->size * num_words, sizeof(uns64));
+  bm->ops = (Op**)calloc(rs->size, sizeof(Op*));
+  for (uns entry = 0; entry < rs->size; ++entry)
+    bm->free[BITMATRIX_WORD(entry)] |= BITMATRIX_BIT(entry);
+  return bm;
+}
+
+/*
+ * Ops enter an RS in program order (younger ops are flushed before any op
+ * younger than the survivors is dispatched), so a new entry is always the
+ * youngest one.
+ */
+void node_bitmatrix_insert(Reservation_Station* rs, Op* op) {
+  if (!rs->bitmatrix)
+    rs->bitmatrix = node_bitmatrix_alloc(rs);
+  Rs_Bitmatrix* bm = rs->bitmatrix;
+  uns32 num_words = bm->num_words;
+
+  uns32 w = 0;
+  while (w < num_words && !bm->free[w])
+    ++w;
+  ASSERTM(node->proc_id, w < num_words, "No free entry in %s\n", rs->name);
+  uns entry = w * 64 + __builtin_ctzll(bm->free[w]);
+  uns64 bit = BITMATRIX_BIT(entry);
+  bm->free[w] &= ~bit;
+  bm->ops[entry] = op;
+  op->rs_entry = entry;
+
+  // every occupied entry is older than the new one, which is older than none
+  uns64* row = &bm->older[entry * num_words];
+  for (uns32 v = 0; v < num_words; ++v)
+    row[v] = ~bm->free[v];
+  for (uns r = 0; r < rs->size; ++r)
+    bm->older[r * num_words + w] &= ~bit;
+
+  uns64 op_fu_type = get_fu_type(op->table_info->op_type, op->table_info->is_simd);
+  for (uns32 i = 0; i < rs->num_fus; ++i) {
+    if (op_fu_type & rs->connected_fus[i]->type)
+      bm->eligible[i * num_words + w] |= bit;
+  }
+}
+
+/*
+ * The oldest candidate is the one with no other candidate in its age matrix row
+ */
+uns node_bitmatrix_oldest(Rs_Bitmatrix* bm) {
+  uns32 num_words = bm->num_words;
+  for (uns32 w = 0; w < num_words; ++w) {
+    for (uns64 bits = bm->candidates[w]; bits; bits &= bits - 1) {
+      uns entry = w * 64 + __builtin_ctzll(bits);
+      uns64* row = &bm->older[entry * num_words];
+      uns64 older_candidates = 0;
+      for (uns32 v = 0; v < num_words; ++v)
+        older_candidates |= row[v] & bm->candidates[v];
+      if (!older_candidates)
+        return entry;
+    }
+  }
+  ASSERTM(node->proc_id, FALSE, "Age matrix has no oldest candidate\n");
+  return 0;
+}
+
 /**************************************************************************************/
 /* Driven Table */
 
@@ -196,6 +353,14 @@ Dispatch_Func dispatch_func_table[NODE_ISSUE_QUEUE_DISPATCH_SCHEME_NUM] = {
 using Schedule_Func = void (*)(Op*);
 Schedule_Func schedule_func_table[NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_NUM] = {
     [NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_OLDEST_FIRST] = {node_schedule_oldest_first_sched},
+    [NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_BITMATRIX] = {node_schedule_bitmatrix_sched},
+};
+
+/* Optional pass run once all ready ops have been handed to the Schedule_Func */
+using Select_Func = void (*)();
+Select_Func select_func_table[NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_NUM] = {
+    [NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_OLDEST_FIRST] = {NULL},
+    [NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_BITMATRIX] = {node_select_bitmatrix},
 };
 
 /**************************************************************************************/
@@ -239,8 +404,7 @@ void node_issue_queue_clear() {
           disasm_op(op, TRUE), op->engine_info.l1_miss);
     *last = op->next_rdy;
     op->in_rdy_list = FALSE;
-    ASSERT(node->proc_id, node->rs[op->rs_id].rs_op_count > 0);
-    node->rs[op->rs_id].rs_op_count--;
+    node_issue_queue_rs_release(op);
     STAT_EVENT(node->proc_id, OP_ISSUED);
   }
 }
@@ -270,6 +434,8 @@ void node_issue_queue_dispatch() {
     op->state = OS_IN_RS;
     op->rs_id = (Counter)rs_id;
     rs->rs_op_count++;
+    if (NODE_ISSUE_QUEUE_SCHEDULE_SCHEME == NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_BITMATRIX)
+      node_bitmatrix_insert(rs, op);
     num_fill_rs++;
 
     DEBUG(node->proc_id, "Filling %s with op_num:%s (%d)\n", rs->name, unsstr64(op->op_num), rs->rs_op_count);
@@ -283,6 +449,7 @@ void node_issue_queue_dispatch() {
       node->rdy_head = op;
       op->in_rdy_list = TRUE;
     }
+    node_issue_queue_ready_update(op);
 
     // maximum number of operations to fill into the RS per cycle (0 = unlimited)
     if (RS_FILL_WIDTH && (num_fill_rs == RS_FILL_WIDTH)) {
@@ -316,36 +483,87 @@ void node_issue_queue_schedule() {
   // Check to see if the L1 Q is (still) full
   node_issue_queue_check_mem();
 
-  for (Op* op = node->rdy_head; op; op = op->next_rdy) {
-    ASSERT(node->proc_id, node->proc_id == op->proc_id);
-    ASSERTM(node->proc_id, op->in_rdy_list, "op_num %llu\n", op->op_num);
-    if (op->state == OS_WAIT_MEM) {
-      if (node->mem_blocked)
-        continue;
-      else
-        op->state = OS_READY;
-    }
+  if (node->rdy_key)
+    node_issue_queue_schedule_ready_vector();
+  else
+    for (Op* op = node->rdy_head; op; op = op->next_rdy)
+      node_issue_queue_consider(op);
+  if (select_func_table[NODE_ISSUE_QUEUE_SCHEDULE_SCHEME])
+    select_func_table[NODE_ISSUE_QUEUE_SCHEDULE_SCHEME]();
 
-    if (op->state == OS_TENTATIVE || op->state == OS_WAIT_DCACHE)
-      continue;
+  // Track statistics for idle FUs when no ready ops are available
+  node_track_fu_idle_stats();
+}
 
-    ASSERTM(node->proc_id, op->state == OS_IN_RS || op->state == OS_READY || op->state == OS_WAIT_FWD,
-            "op_num: %llu, op_state: %s\n", op->op_num, Op_State_str(op->state));
-    DEBUG(node->proc_id, "Scheduler examining    op_num:%s op:%s l1:%d st:%s rdy:%s exec:%s done:%s\n",
-          unsstr64(op->op_num), disasm_op(op, TRUE), op->engine_info.l1_miss, Op_State_str(op->state),
-          unsstr64(op->rdy_cycle), unsstr64(op->exec_cycle), unsstr64(op->done_cycle));
+/*
+ * Hand one op of the ready list to the Schedule_Func if it can leave the RS this cycle
+ */
+void node_issue_queue_consider(Op* op) {
+  ASSERT(node->proc_id, node->proc_id == op->proc_id);
+  ASSERTM(node->proc_id, op->in_rdy_list, "op_num %llu\n", op->op_num);
+  if (op->state == OS_WAIT_MEM) {
+    if (node->mem_blocked)
+      return;
+    else
+      op->state = OS_READY;
+  }
 
-    /* op will be ready next cycle, try to schedule */
-    if (cycle_count >= op->rdy_cycle - 1) {
-      ASSERT(node->proc_id, op->srcs_not_rdy_vector == 0x0);
-      DEBUG(node->proc_id, "Scheduler considering  op_num:%s op:%s l1:%d\n", unsstr64(op->op_num), disasm_op(op, TRUE),
-            op->engine_info.l1_miss);
+  if (op->state == OS_TENTATIVE || op->state == OS_WAIT_DCACHE)
+    return;
+
+  ASSERTM(node->proc_id, op->state == OS_IN_RS || op->state == OS_READY || op->state == OS_WAIT_FWD,
+          "op_num: %llu, op_state: %s\n", op->op_num, Op_State_str(op->state));
+  DEBUG(node->proc_id, "Scheduler examining    op_num:%s op:%s l1:%d st:%s rdy:%s exec:%s done:%s\n",
+        unsstr64(op->op_num), disasm_op(op, TRUE), op->engine_info.l1_miss, Op_State_str(op->state),
+        unsstr64(op->rdy_cycle), unsstr64(op->exec_cycle), unsstr64(op->done_cycle));
 
-      schedule_func_table[NODE_ISSUE_QUEUE_SCHEDULE_SCHEME](op);
+  /* op will be ready next cycle, try to schedule */
+  if (cycle_count >= op->rdy_cycle - 1) {
+    ASSERT(node->proc_id, op->srcs_not_rdy_vector == 0x0);
+    DEBUG(node->proc_id, "Scheduler considering  op_num:%s op:%s l1:%d\n", unsstr64(op->op_num), disasm_op(op, TRUE),
+          op->engine_info.l1_miss);
+
+    schedule_func_table[NODE_ISSUE_QUEUE_SCHEDULE_SCHEME](op);
+  }
+}
+
+/* bit ii of the result is set if keys[ii] <= limit, for n <= 64 */
+static inline uns64 node_ready_key_mask(const Counter* keys, uns n, Counter limit) {
+  uns64 mask = 0;
+  uns ii = 0;
+#if defined(__AVX2__)
+  /* AVX2 only has a signed 64-bit compare: flip the sign bits to compare unsigned */
+  const __m256i sign = _mm256_set1_epi64x((long long)0x8000000000000000ULL);
+  __m256i limit4 = _mm256_xor_si256(_mm256_set1_epi64x((long long)limit), sign);
+  for (; ii + 4 <= n; ii += 4) {
+    __m256i key4 = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(keys + ii)), sign);
+    __m256i late = _mm256_cmpgt_epi64(key4, limit4);
+    mask |= (uns64)(~_mm256_movemask_pd(_mm256_castsi256_pd(late)) & 0xF) << ii;
+  }
+#endif
+  for (; ii < n; ii++)
+    mask |= (uns64)(keys[ii] <= limit) << ii;
+  return mask;
+}
+
+/*
+ * NODE_READY_VECTOR: find the ops that can be scheduled this cycle by comparing the ready keys of the whole
+ * window at once (see node_issue_queue_ready_update) instead of chasing the ready list. Ops are visited oldest
+ * first, one 64-slot word of the ROB ring at a time.
+ */
+void node_issue_queue_schedule_ready_vector() {
+  uns rob_size = node->rob_mask + 1;
+  for (Counter id = node->rob_head_id; id < node->rob_tail_id;) {
+    uns slot = id & node->rob_mask;
+    uns n = MIN2(MIN2(64 - (slot & 63), rob_size - slot), node->rob_tail_id - id);
+    uns64 mask = node_ready_key_mask(node->rdy_key + slot, n, cycle_count);
+    for (; mask; mask &= mask - 1) {
+      Op* op = node->rob[slot + __builtin_ctzll(mask)];
+      ASSERT(node->proc_id, op);
+      node_issue_queue_consider(op);
     }
+    id += n;
   }
-  // Track statistics for idle FUs when no ready ops are available
-  node_track_fu_idle_stats();
 }
 
 /**************************************************************************************/
@@ -356,7 +574,7 @@ void node_issue_queue_schedule() {
  * ready ops that could potentially be executed on it.
  */
 void node_track_fu_idle_stats(void) {
-  extern Exec_Stage* exec;  // Access to FUs through exec stage
+  extern CORE_LOCAL Exec_Stage* exec;  // Access to FUs through exec stage
 
   // Create ready_type vector for each RS to track which op types have ready ops
   uns64 ready_type_per_rs[NUM_RS] = {0};
@@ -377,7 +595,7 @@ void node_track_fu_idle_stats(void) {
 
     // Also check if the FU itself is available (not held by memory or still busy from previous op)
     Func_Unit* fu = &exec->fus[fu_id];
-    if (fu->avail_cycle > cycle_count || fu->held_by_mem)
+    if (fu->avail_cycle > cycle_count || (exec->fus_held >> fu_id) & 1)
       continue;  // FU is not available, skip
 
     // FU is available - use global mapping to find connected RS
@@ -396,6 +614,41 @@ void node_track_fu_idle_stats(void) {
 /**************************************************************************************/
 /* External Function */
 
+/*
+ * Take an op out of its RS, either because it was scheduled or because it was flushed
+ */
+void node_issue_queue_rs_release(Op* op) {
+  Reservation_Station* rs = &node->rs[op->rs_id];
+  ASSERT(node->proc_id, rs->rs_op_count > 0);
+  rs->rs_op_count--;
+  if (node->rdy_key)
+    node->rdy_key[op->node_id & node->rob_mask] = MAX_CTR;
+
+  Rs_Bitmatrix* bm = rs->bitmatrix;
+  if (!bm)
+    return;
+  uns entry = op->rs_entry;
+  uns32 w = BITMATRIX_WORD(entry);
+  uns64 bit = BITMATRIX_BIT(entry);
+  ASSERT(node->proc_id, bm->ops[entry] == op);
+  bm->ops[entry] = NULL;
+  bm->free[w] |= bit;
+  for (uns32 i = 0; i < rs->num_fus; ++i)
+    bm->eligible[i * bm->num_words + w] &= ~bit;
+}
+
+/*
+ * NODE_READY_VECTOR: refresh the ready key of an op in an RS after its sources or rdy_cycle changed. The key is
+ * rdy_cycle - 1 once all sources are ready and MAX_CTR otherwise, so one compare against cycle_count tells whether
+ * the op can be considered, exactly like the ready list test in node_issue_queue_consider.
+ */
+void node_issue_queue_ready_update(Op* op) {
+  if (!node->rdy_key)
+    return;
+  ASSERT(node->proc_id, op->state != OS_IN_ROB);
+  node->rdy_key[op->node_id & node->rob_mask] = op->srcs_not_rdy_vector ? MAX_CTR : op->rdy_cycle - 1;
+}
+
 void node_issue_queue_update() {
   /* remove scheduled ops from RS and ready list */
   node_issue_queue_clear();
@@ -46,6 +46,7 @@ typedef enum NODE_ISSUE_QUEUE_DISPATCH_SCHEME_enum {
 
 typedef enum NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_enum {
   NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_OLDEST_FIRST,
+  NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_BITMATRIX,
   NODE_ISSUE_QUEUE_SCHEDULE_SCHEME_NUM
 } Node_Issue_Queue_Schedule_Scheme;
 
@@ -56,6 +57,8 @@ const static int32 NODE_ISSUE_QUEUE_FU_SLOT_INVALID = -1;
 /* External Methods */
 
 void node_issue_queue_update();
+void node_issue_queue_rs_release(Op* op);
+void node_issue_queue_ready_update(Op* op);
 
 #ifdef __cplusplus
 }
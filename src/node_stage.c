@@ -43,9 +43,11 @@
 
 #include "bp/bp.param.h"
 #include "core.param.h"
+#include "general.param.h"
 #include "memory/memory.param.h"
 
 #include "bp/bp.h"
+#include "bp/bp_stream.h"
 #include "bp/tagescl.h"
 #include "frontend/frontend.h"
 #include "memory/memory.h"
@@ -66,6 +68,7 @@
 /* Macros */
 
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_NODE_STAGE, ##args)
+#define ROB_OP(id) (node->rob[(id)&node->rob_mask])
 #define PRINT_RETIRED_UOP(proc_id, args...) _DEBUG_LEAN(proc_id, DEBUG_RETIRED_UOPS, ##args)
 
 #define DEBUG_NODE_WIDTH ISSUE_WIDTH
@@ -74,9 +77,9 @@
 /**************************************************************************************/
 /* Global Variables */
 
-Node_Stage* node = NULL;
-Rob_Stall_Reason rob_stall_reason = ROB_STALL_NONE;
-Rob_Block_Issue_Reason rob_block_issue_reason = ROB_BLOCK_ISSUE_NONE;
+CORE_LOCAL Node_Stage* node = NULL;
+CORE_LOCAL Rob_Stall_Reason rob_stall_reason = ROB_STALL_NONE;
+CORE_LOCAL Rob_Block_Issue_Reason rob_block_issue_reason = ROB_BLOCK_ISSUE_NONE;
 
 /**************************************************************************************/
 /* Prototypes */
@@ -97,6 +100,10 @@ void collect_node_table_full_stats(Op* op);
 
 void node_fill_rob(Stage_Data*);
 void node_retire(void);
+void node_retire_batch(void);
+void node_retire_stall_ended(uns ret_count);
+void node_retire_commit(Op* op);
+void node_retire_set_head(Counter id);
 
 void node_precommit_update(void);
 void node_precommit_retire(Op* op);
@@ -126,6 +133,15 @@ void init_node_stage(uns8 proc_id, const char* name) {
   // allocate FU to RS mapping array
   node->fu_to_rs_map = (int32*)malloc(sizeof(int32) * NUM_FUS);
 
+  // macro-fused ops do not count against NODE_TABLE_SIZE but still occupy a ring slot
+  uns rob_size = 1;
+  while (rob_size < 2 * NODE_TABLE_SIZE)
+    rob_size <<= 1;
+  node->rob = (Op**)calloc(rob_size, sizeof(Op*));
+  node->rob_mask = rob_size - 1;
+  node->rdy_key = NODE_READY_VECTOR ? (Counter*)malloc(sizeof(Counter) * rob_size) : NULL;
+  node->ret_batch = NODE_RETIRE_BATCH ? (Op**)malloc(sizeof(Op*) * NODE_RET_WIDTH) : NULL;
+
   reset_node_stage();
 }
 
@@ -142,8 +158,13 @@ void reset_node_stage() {
 
   node->node_head = NULL;
   node->node_tail = NULL;
+  node->rob_head_id = 0;
+  node->rob_tail_id = 0;
   node->rdy_head = NULL;
   node->next_op_into_rs = NULL;
+  if (node->rdy_key)
+    for (ii = 0; ii <= node->rob_mask; ii++)
+      node->rdy_key[ii] = MAX_CTR;
 
   node->node_count = 0;
   node->ret_op = 1;
@@ -227,45 +248,55 @@ void flush_rs() {
 }
 
 void flush_window() {
-  Op* op;
-  Op** last;
   uns flush_ops = 0;
-  uns keep_ops = 0;
 
-  node->node_tail = NULL;
-  for (op = node->node_head, last = &node->node_head; op; op = *last) {
+  /* the node list is in program order, so the flushed ops are a suffix of the ring */
+  Counter first_flush_id = node->rob_head_id;
+  Counter end_id = node->rob_tail_id;
+  while (first_flush_id < end_id) {
+    Counter mid_id = first_flush_id + (end_id - first_flush_id) / 2;
+    if (FLUSH_OP(ROB_OP(mid_id)))
+      end_id = mid_id;
+    else
+      first_flush_id = mid_id + 1;
+  }
+
+  for (Counter id = first_flush_id; id < node->rob_tail_id; id++) {
+    Op* op = ROB_OP(id);
     ASSERT(node->proc_id, node->proc_id == op->proc_id);
+    ASSERT(node->proc_id, op->node_id == id);
+    ASSERT(node->proc_id, op->op_num > bp_recovery_info->recovery_op_num);
 
-    if (FLUSH_OP(op)) {
-      DEBUG(node->proc_id, "Node flushing  op:%s\n", unsstr64(op->op_num));
-      if (!op->macro_fused)
-        flush_ops++;
-      ASSERT(node->proc_id, op->op_num > bp_recovery_info->recovery_op_num);
-      op->in_node_list = FALSE;
-      *last = op->next_node;
-      if (op->state == OS_IN_RS || op->state == OS_READY || op->state == OS_WAIT_FWD) {
-        ASSERT(op->proc_id, node->rs[op->rs_id].rs_op_count > 0);
-        node->rs[op->rs_id].rs_op_count--;
-      }
-      if (op->parent_FT)
-        ft_free_op(op);
-    } else {
-      /* Keep op */
+    DEBUG(node->proc_id, "Node flushing  op:%s\n", unsstr64(op->op_num));
+    if (!op->macro_fused)
+      flush_ops++;
+    op->in_node_list = FALSE;
+    if (op->state == OS_IN_RS || op->state == OS_READY || op->state == OS_WAIT_FWD) {
+      node_issue_queue_rs_release(op);
+    }
+    if (op->parent_FT)
+      ft_free_op(op);
+  }
+  node->rob_tail_id = first_flush_id;
 
-      if (IS_FLUSHING_OP(op)) {
-        /* Mark that the scheduled recovery has occurred */
-        op->recovery_scheduled = FALSE;
-      }
-      DEBUG(node->proc_id, "Node keeping  op:%s node_id:%llu\n", unsstr64(op->op_num), op->node_id);
-      if (!op->macro_fused)
-        keep_ops++;
-      last = &op->next_node;
-      node->node_tail = op;
+  if (first_flush_id == node->rob_head_id) {
+    node->node_head = NULL;
+    node->node_tail = NULL;
+  } else {
+    node->node_tail = ROB_OP(first_flush_id - 1);
+    node->node_tail->next_node = NULL;
+    DEBUG(node->proc_id, "Node keeping  op:%s node_id:%llu and older\n", unsstr64(node->node_tail->op_num),
+          node->node_tail->node_id);
+
+    /* only the youngest kept op can be the one that caused the flush */
+    if (IS_FLUSHING_OP(node->node_tail)) {
+      /* Mark that the scheduled recovery has occurred */
+      node->node_tail->recovery_scheduled = FALSE;
     }
   }
 
-  ASSERT(node->proc_id, flush_ops + keep_ops == node->node_count);
-  node->node_count = keep_ops;
+  ASSERT(node->proc_id, flush_ops <= node->node_count);
+  node->node_count -= flush_ops;
   ASSERT(node->proc_id, node->node_count <= NODE_TABLE_SIZE);
 }
 
@@ -290,7 +321,8 @@ void debug_print_node_table() {
 
   Op** temp = (Op**)calloc(DEBUG_NODE_WIDTH, sizeof(Op*));
 
-  for (op = node->node_head; op; op = op->next_node, ++row) {
+  for (Counter id = node->rob_head_id; id < node->rob_tail_id; id++, ++row) {
+    op = ROB_OP(id);
     slot_num = row % DEBUG_NODE_WIDTH;
     ASSERT(node->proc_id, node->proc_id == op->proc_id);
     ASSERT(node->proc_id, temp[slot_num] == NULL);
@@ -443,7 +475,9 @@ void node_fill_rob(Stage_Data* src_sd) {
     ASSERT(node->proc_id, src_sd->op_count >= 0);
 
     /* set op fields */
-    op->node_id = node->node_count;
+    ASSERT(node->proc_id, node->rob_tail_id - node->rob_head_id <= node->rob_mask);
+    op->node_id = node->rob_tail_id++;
+    ROB_OP(op->node_id) = op;
     op->issue_cycle = cycle_count;
 
     /* add to node list & update node state*/
@@ -486,13 +520,20 @@ void node_fill_rob(Stage_Data* src_sd) {
 void node_retire() {
   uns ret_count = 0;
   Op* op = NULL;
+  Counter id;
 
   // If node table is empty, then there is nothing to retire
   if (is_node_table_empty())
     return;
 
+  if (node->ret_batch) {
+    node_retire_batch();
+    return;
+  }
+
   // Iterate through the first NODE_RET_WIDTH number of ops and try to retire them
-  for (op = node->node_head; op && ret_count < NODE_RET_WIDTH; op = op->next_node) {
+  for (id = node->rob_head_id; id < node->rob_tail_id && ret_count < NODE_RET_WIDTH; id++) {
+    op = ROB_OP(id);
     ASSERT(node->proc_id, node->proc_id == op->proc_id);
 
     // check to see if the head of the node table is ready to retire
@@ -513,24 +554,11 @@ void node_retire() {
     debug_print_retired_uop(op);
 
     // count number of stall cycles
-    STAT_EVENT(node->proc_id, RET_STALL_LENGTH_0 + MIN2(node->ret_stall_length, 5000) / 100);
-    if (DIE_ON_RET_STALL_THRESH) {
-      // time out code
-      if (node->proc_id == DIE_ON_RET_STALL_CORE) {
-        ASSERTM(node->proc_id, node->ret_stall_length < DIE_ON_RET_STALL_THRESH,
-                "Retire stalled for %u cycles (%llu--%llu)\n", node->ret_stall_length,
-                cycle_count - node->ret_stall_length, cycle_count);
-      }
-    }
-    node->ret_stall_length = 0;
-
-    // retire the ops
-    Counter real_rdy_cycle = MAX2(op->rdy_cycle, op->issue_cycle);
+    node_retire_stall_ended(1);
 
     ASSERT(node->proc_id, node->proc_id == op->proc_id);
     ASSERT(node->proc_id, op->in_node_list);
     ASSERT(node->proc_id, !op->off_path);
-    STAT_EVENT(op->proc_id, OP_WAIT_0 + MIN2(op->sched_cycle - real_rdy_cycle, 31));
     STAT_EVENT(op->proc_id, OP_RETIRED);  // Counts all ops retired, not just those in primary thread
 
     DEBUG(node->proc_id, "Retiring op_num:%s\n", unsstr64(op->op_num));
@@ -538,6 +566,8 @@ void node_retire() {
     ASSERTM(node->proc_id, op->op_num == node->ret_op, "op_num=%s  ret_op=%s\n", unsstr64(op->op_num),
             unsstr64(node->ret_op));
 
+    if (BP_STREAM)
+      bp_stream_op(op);
     if (op->eom) {
       /* We need to retire sys calls, bar fetch instructions, and the last instruction.
        * All other retires are "optional" to release resources in the PIN frontend */
@@ -581,40 +611,180 @@ void node_retire() {
       bp_retire_op(g_bp_data, op);
     }
 
-    if (op->table_info->mem_type == MEM_LD && (op->done_cycle - op->sched_cycle) < 5) {
-      STAT_EVENT(op->proc_id, LD_EXEC_CYCLES_0 + (op->done_cycle - op->sched_cycle));
+    node_retire_commit(op);
+  }
+
+  STAT_EVENT(node->proc_id, ROW_SIZE_0 + ret_count);
+
+  // id is the first op that was not retired because of the above for-loop
+  node_retire_set_head(id);
+}
+
+/**************************************************************************************/
+/* node_retire_batch: node_retire for NODE_RETIRE_BATCH. The retirable prefix of the ROB is found first, then each
+ * subsystem retires the whole batch in program order: stat events are counted once per batch, the frontend gets a
+ * single retire for the youngest instruction due one (PIN retires everything up to a uid) unless a system call,
+ * fetch barrier or exit needs its own, and the branch predictor retires all of the batch's branches in one call. */
+
+void node_retire_batch() {
+  Op** batch = node->ret_batch;
+  uns ret_count = 0;
+  uns ret_inst_count = 0;
+  uns ret_fetched_count = 0;
+  Op* fe_retire_op = NULL;
+  Counter id;
+  uns ii;
+
+  for (id = node->rob_head_id; id < node->rob_tail_id && ret_count < NODE_RET_WIDTH; id++) {
+    Op* op = ROB_OP(id);
+    ASSERT(node->proc_id, node->proc_id == op->proc_id);
+    if (op_not_ready_for_retire(op)) {
+      collect_not_ready_to_retire_stats(op);
+      break;
+    }
+    rob_stall_reason = ROB_STALL_NONE;
+    batch[ret_count++] = op;
+  }
+
+  if (ret_count)
+    node_retire_stall_ended(ret_count);
+
+  /* program-ordered bookkeeping and frontend retirement */
+  for (ii = 0; ii < ret_count; ii++) {
+    Op* op = batch[ii];
+    ASSERTM(node->proc_id, op->state != OS_TENTATIVE, "op_num: %llu\n", op->op_num);
+    DEBUG(node->proc_id, "Retiring op_num:%s\n", unsstr64(op->op_num));
+    debug_print_retired_uop(op);
+    ASSERT(node->proc_id, op->in_node_list);
+    ASSERT(node->proc_id, !op->off_path);
+    ASSERTM(node->proc_id, op->op_num == node->ret_op, "op_num=%s  ret_op=%s\n", unsstr64(op->op_num),
+            unsstr64(node->ret_op));
+
+    if (BP_STREAM)
+      bp_stream_op(op);
+    if (op->eom) {
+      inst_count[node->proc_id]++;
+      ret_inst_count++;
+      if (op->fetched_instruction) {
+        inst_count_fetched[node->proc_id]++;
+        ret_fetched_count++;
+      }
+
+      if (op->exit || IS_CALLSYS(op->table_info) || op->table_info->bar_type & BAR_FETCH) {
+        if (fe_retire_op)
+          decoupled_fe_retire(fe_retire_op, op->proc_id, fe_retire_op->inst_uid);
+        fe_retire_op = NULL;
+        if (op->exit)
+          retired_exit[op->proc_id] = TRUE;
+        decoupled_fe_retire(op, op->proc_id, op->exit ? (uns64)-1 : op->inst_uid);
+      } else if (inst_count[node->proc_id] % NODE_RETIRE_RATE == 0) {
+        fe_retire_op = op;
+      }
     }
-    if (op->table_info->mem_type == MEM_LD) {
-      STAT_EVENT(op->proc_id, LD_NO_DEPENDENTS + (op->wake_up_head ? 1 : 0));
+    uop_count[node->proc_id]++;
+    ASSERTM(node->proc_id, uop_count[node->proc_id] == node->ret_op, "%s  %s op_num: %s\n",
+            unsstr64(uop_count[node->proc_id]), unsstr64(node->ret_op), unsstr64(op->op_num));
+    node->ret_op++;
+
+    remove_from_seq_op_list(td, op);
+  }
+  if (fe_retire_op)
+    decoupled_fe_retire(fe_retire_op, fe_retire_op->proc_id, fe_retire_op->inst_uid);
+
+  INC_STAT_EVENT(node->proc_id, OP_RETIRED, ret_count);
+  INC_STAT_EVENT(node->proc_id, NODE_UOP_COUNT, ret_count);
+  INC_STAT_EVENT(node->proc_id, RET_ALL_INST, ret_count);
+  INC_STAT_EVENT(node->proc_id, NODE_INST_COUNT, ret_inst_count);
+  INC_STAT_EVENT(node->proc_id, NODE_INST_COUNT_FETCHED, ret_fetched_count);
+
+  /* resolving at retire has to stay interleaved with retiring, branch by branch */
+  if (BP_UPDATE_AT_RETIRE) {
+    for (ii = 0; ii < ret_count; ii++) {
+      Op* op = batch[ii];
+      if (!op->table_info->cf_type)
+        continue;
+      if (op->table_info->cf_type >= CF_IBR)
+        bp_target_known_op(g_bp_data, op);
+      bp_resolve_op(g_bp_data, op);
+      bp_retire_op(g_bp_data, op);
     }
-    STAT_EVENT(op->proc_id, RET_OP_EXEC_COUNT_0 + MIN2(32, op->exec_count));
+  } else {
+    bp_retire_ops(g_bp_data, batch, ret_count);
+  }
 
-    op->retire_cycle = cycle_count;
+  for (ii = 0; ii < ret_count; ii++)
+    node_retire_commit(batch[ii]);
 
-    // free the previous register entries with same architectural destination
-    reg_file_commit(op);
+  STAT_EVENT(node->proc_id, ROW_SIZE_0 + ret_count);
 
-    node_precommit_retire(op);
+  node_retire_set_head(id);
+}
 
-    if (op->table_info->mem_type == MEM_LD || op->table_info->mem_type == MEM_ST) {
-      lsq_commit(op);
+/**************************************************************************************/
+/* node_retire_stall_ended: stall length stats for ret_count ops retiring this cycle. Only the first one ends the
+ * stall, the others count as retiring after a stall of 0 cycles. */
+
+void node_retire_stall_ended(uns ret_count) {
+  STAT_EVENT(node->proc_id, RET_STALL_LENGTH_0 + MIN2(node->ret_stall_length, 5000) / 100);
+  INC_STAT_EVENT(node->proc_id, RET_STALL_LENGTH_0, ret_count - 1);
+  if (DIE_ON_RET_STALL_THRESH) {
+    // time out code
+    if (node->proc_id == DIE_ON_RET_STALL_CORE) {
+      ASSERTM(node->proc_id, node->ret_stall_length < DIE_ON_RET_STALL_THRESH,
+              "Retire stalled for %u cycles (%llu--%llu)\n", node->ret_stall_length,
+              cycle_count - node->ret_stall_length, cycle_count);
     }
+  }
+  node->ret_stall_length = 0;
+}
 
-    if (model->op_retired_hook)
-      model->op_retired_hook(op);
-    else
-      ft_free_op(op);
+/**************************************************************************************/
+/* node_retire_commit: release the resources of a retiring op and free it */
 
-    // the fused op does not occupy the ROB entry
-    if (!op->macro_fused)
-      node->node_count--;
+void node_retire_commit(Op* op) {
+  Counter real_rdy_cycle = MAX2(op->rdy_cycle, op->issue_cycle);
+  STAT_EVENT(op->proc_id, OP_WAIT_0 + MIN2(op->sched_cycle - real_rdy_cycle, 31));
 
-    ASSERT(node->proc_id, node->node_count >= 0);
+  if (op->table_info->mem_type == MEM_LD && (op->done_cycle - op->sched_cycle) < 5) {
+    STAT_EVENT(op->proc_id, LD_EXEC_CYCLES_0 + (op->done_cycle - op->sched_cycle));
+  }
+  if (op->table_info->mem_type == MEM_LD) {
+    STAT_EVENT(op->proc_id, LD_NO_DEPENDENTS + (op_has_wake_ups(op) ? 1 : 0));
   }
+  STAT_EVENT(op->proc_id, RET_OP_EXEC_COUNT_0 + MIN2(32, op->exec_count));
 
-  STAT_EVENT(node->proc_id, ROW_SIZE_0 + ret_count);
+  op->retire_cycle = cycle_count;
+  if (DUMP_RETIRE_TRACE && DEBUG_RANGE_COND(op->proc_id))
+    print_retired_op(op);
+
+  // free the previous register entries with same architectural destination
+  reg_file_commit(op);
+
+  node_precommit_retire(op);
+
+  if (op->table_info->mem_type == MEM_LD || op->table_info->mem_type == MEM_ST) {
+    lsq_commit(op);
+  }
+
+  if (model->op_retired_hook)
+    model->op_retired_hook(op);
+  else
+    ft_free_op(op);
+
+  // the fused op does not occupy the ROB entry
+  if (!op->macro_fused)
+    node->node_count--;
+
+  ASSERT(node->proc_id, node->node_count >= 0);
+}
+
+/**************************************************************************************/
+/* node_retire_set_head: id is the first op that was not retired this cycle */
 
-  // op should be pointing to first op that was not retired because of the above for-loop
+void node_retire_set_head(Counter id) {
+  Op* op;
+  node->rob_head_id = id;
+  op = id < node->rob_tail_id ? ROB_OP(id) : NULL;
   node->node_head = op;
   if (node->node_head)
     DEBUG(node->proc_id, "Op op_num:%s is now head of the node table\n", unsstr64(node->node_head->op_num));
@@ -634,6 +804,38 @@ Flag is_node_stage_stalled() {
          !node->next_op_into_rs;                  /* no ops waiting to enter RS */
 }
 
+/**************************************************************************************/
+/* node_stage_next_event_cycle: first cycle at which the node stage could do
+ * anything but count stall cycles (MAX_CTR if it waits for another stage or the
+ * memory system). Ops finish execution at their done_cycle without any event,
+ * so the earliest one bounds how long the stage stays idle. */
+
+Counter node_stage_next_event_cycle() {
+  if (!is_node_stage_stalled())
+    return cycle_count + 1;
+
+  Counter next_event = MAX_CTR;
+  for (Op* op = node->node_head; op; op = op->next_node) {
+    if (op->recovery_scheduled || op->redirect_scheduled)
+      return cycle_count + 1;
+    if (op->done_cycle != MAX_CTR && op->done_cycle > cycle_count)
+      next_event = MIN2(next_event, op->done_cycle - 1);
+  }
+  return MAX2(next_event, cycle_count + 1);
+}
+
+/**************************************************************************************/
+/* node_stage_skip_idle_cycle: the state update of a cycle in which
+ * node_stage_next_event_cycle() said nothing happens */
+
+void node_stage_skip_idle_cycle() {
+  node->ret_stall_length++;
+  node->mem_block_length += node->mem_blocked;
+}
+
+/**************************************************************************************/
+/* debug_print_retired_uop: */
+
 void debug_print_retired_uop(Op* op) {
   PRINT_RETIRED_UOP(node->proc_id, "============================\n");
   PRINT_RETIRED_UOP(node->proc_id, "EIP: 0x%llx\n", op->inst_info->addr);
@@ -41,7 +41,10 @@ typedef struct Reservation_Station_struct {
   uns32 size;                          // 0 is infinite
   Func_Unit** connected_fus;           // FUs that this reservation station is connected to.
   uns32 num_fus;                       // number of fus that this rs is connected to.
+  uns64 fu_mask;                       // fu_ids of connected_fus
   uns32 rs_op_count;                   // number of ops in this reservation station
+  // entry state of the BITMATRIX scheduler (NULL for other schedule schemes)
+  struct Rs_Bitmatrix_struct* bitmatrix;
 } Reservation_Station;
 
 typedef struct Node_Stage_struct {
@@ -53,6 +56,18 @@ typedef struct Node_Stage_struct {
   Op* node_precommit;  // the pre-commit pointer in the ROB
   int32 node_count;    // number of ops in the node table
 
+  /* ring of the ops in the node list in program order: op->node_id indexes it (masked), so recovery can find the
+   * flushed suffix without walking the kept ops */
+  Op** rob;
+  uns rob_mask;
+  Counter rob_head_id;  // node_id of node_head
+  Counter rob_tail_id;  // node_id of the next op to enter the node list
+  /* NODE_READY_VECTOR only: per ring slot, rdy_cycle - 1 of an RS op whose sources are all ready, MAX_CTR
+   * otherwise, so the scheduler can test the whole window with vector compares */
+  Counter* rdy_key;
+
+  Op** ret_batch;  // NODE_RETIRE_BATCH only: the ops retiring this cycle
+
   Flag prev_op_fusable;  // if the next dispatched op is macro-fusable
 
   /* linked-list of ops that are ready to schedule. Ops are put in here when they are issued,
@@ -67,6 +82,10 @@ typedef struct Node_Stage_struct {
 
   int32* fu_to_rs_map;  // mapping from FU ID to RS ID (-1 for unconnected FUs)
 
+  /* indexed by fu_type_index(): the FUs that can execute the op type, and the RSs connected to one of them */
+  uns64* fu_type_fu_mask;
+  uns64* fu_type_rs_mask;
+
   Flag mem_blocked;      // are we out of mem req buffers for this core
   uns mem_block_length;  // length of the current memory block
   uns ret_stall_length;  // length of the current retirement stall
@@ -75,7 +94,7 @@ typedef struct Node_Stage_struct {
 /**************************************************************************************/
 // External Variables
 
-extern Node_Stage* node;
+extern CORE_LOCAL Node_Stage* node;
 
 /**************************************************************************************/
 // Prototypes
@@ -88,6 +107,8 @@ void recover_node_stage(void);
 void debug_node_stage(void);
 void update_node_stage(Stage_Data*);
 Flag is_node_stage_stalled(void);
+Counter node_stage_next_event_cycle(void);
+void node_stage_skip_idle_cycle(void);
 
 /**************************************************************************************/
 
@@ -73,14 +73,28 @@ DECLARE_ENUM(Op_State, OP_STATE_LIST, OS_);
 
 /**************************************************************************************/
 
+#define WAKE_UP_CHUNK_ENTRIES 4
+
 typedef struct Wake_Up_Entry_struct {
   Op* op;
   Counter unique_num;
-  Dep_Type dep_type;
   uns8 rdy_bit;
-  struct Wake_Up_Entry_struct* next;
 } Wake_Up_Entry;
 
+// contiguous run of the consumers of one producer for one dependence type
+typedef struct Wake_Up_Chunk_struct {
+  Wake_Up_Entry entries[WAKE_UP_CHUNK_ENTRIES];
+  struct Wake_Up_Chunk_struct* next;
+} Wake_Up_Chunk;
+
+// consumers of one dependence type: the first chunk lives in the producer op
+// itself, overflow chunks come from the map's chunk pool
+typedef struct Wake_Up_List_struct {
+  uns count;
+  Wake_Up_Chunk head;
+  Wake_Up_Chunk* tail;  // last overflow chunk (NULL if none)
+} Wake_Up_List;
+
 // per branch stats
 typedef struct Per_Branch_Stat_struct {
   Addr addr;
@@ -91,7 +105,7 @@ typedef struct Per_Branch_Stat_struct {
 // this information is used when the op mispredicts
 typedef struct Recovery_Info_struct {  // QUESTION no proc_id?
   uns proc_id;
-  uns32 pred_global_hist;                  // the global history used for the prediction
+  uns32 hist_head;                         // head of the speculative global history at prediction
   uns64 conf_perceptron_global_hist;       // Only for confidnece perceptron, a copy of the correct global history
   uns64 conf_perceptron_global_misp_hist;  // Only for confidnece perceptron, a copy of the correct global history
   uns32 targ_hist;                         // a copy of the correct indirect branch pattern history
@@ -127,6 +141,33 @@ typedef struct Dp_Info_struct {
 /* typedef in globals/global_types.h */
 
 struct Op_struct {
+  /* {{{ hot fields: the first two cache lines hold what scheduling, wakeup and the node
+   * stage touch every cycle, so the rest of the op stays out of the cache there */
+  Counter op_num;              // op number
+  Counter rdy_cycle;           // cycle when the final source value is available (only useful when vector is clear)
+  Counter wake_cycle;          // used by wake up logic for time wake up signal is sent
+  struct Op_struct* next_rdy;  // pointer to next ready op (node table)
+  Table_Info* table_info;      // copy of info->table_info to limit pointer chasing
+  Counter rs_id;               // id for which Reservation Station (RS) this op is assigned to
+  Op_State state;              // the state of the op in the datapath
+  uns srcs_not_rdy_vector;     // bits as given by order in the src_info array
+  uns fu_num;                  // functional unit number the op will or did execute on
+  uns rs_entry;                // entry within the RS (BITMATRIX scheduler only)
+
+  Counter node_id;              // id for position in the node table
+  Counter issue_cycle;          // cycle an individual instruction is issued -- same as chkpt
+  Counter sched_cycle;          // cycle when the op is scheduled (arrives at the functional unit)
+  Counter exec_cycle;           // cycle when execution (or addr gen) of op will be completed (result usable)
+  Counter done_cycle;           // cycle when the op is ready to retire
+  struct Op_struct* next_node;  // pointer to the next op in the node table
+  struct Mem_Req_struct* req;   // pointer to memory request responsible for waking up the op
+  uns proc_id;                  // processor id for cmp model
+  Flag in_rdy_list;             // is the op in the node stage's ready list?
+  Flag in_node_list;            // is the op in the node list?
+  Flag off_path;                // is the op on the correct path of the program? - oracle information
+  Flag replay;                  // is the op waiting to replay?
+  // }}}
+
   // {{{ op_pool stuff --- don't use outside of op pool management
   Flag op_pool_valid;  // is op allocated from the op_pool?
   Op* op_pool_next;    // either next free or next active op
@@ -134,17 +175,14 @@ struct Op_struct {
   // }}}
 
   // {{{ op numbers and info pointers
-  uns proc_id;                  // processor id for cmp model
   uns thread_id;                // id number for the thread to which this op belongs
   Flag bom;                     // begining of macro instruction when we use op as a uop
   Flag eom;                     // end of macro instruction when we use op as a uop
   Flag fetched_instruction;     // is this op fetched or a rep op?
-  Counter op_num;               // op number
   Counter unique_num;           // unique number for each instance of an op (not reset on recovery)
   Counter unique_num_per_proc;  // unique number per core
   uns64 inst_uid;               // unique number for the macro instruction provided by the frontend (PIN)
   Counter addr_pred_num;        // unique number for each address prediction
-  Table_Info* table_info;       // copy of info->table_info to limit pointer chasing
   Inst_Info* inst_info;         // pointer to unique struct for each static instruction
   Op_Info oracle_info;          // information about the execution of the op in the oracle
   Op_Info engine_info;          // information about the execution of the op in the engine
@@ -154,16 +192,10 @@ struct Op_struct {
   int32 perceptron_output;
   int32 conf_perceptron_output;  // confidece perceptron
   // {{{ state and event cycle counters
-  Op_State state;        // the state of the op in the datapath
   Counter fetch_cycle;   // cycle an individual instruction is fetched
   Counter bp_cycle;      // cycle a CF instruction accesses the branch predictor
   Counter map_cycle;     // cycle an individual instruction enters the map stage
-  Counter issue_cycle;   // cycle an individual instruction is issued -- same as chkpt
-  Counter rdy_cycle;     // cycle when the final source value is available to the op (only useful when vector is clear)
-  Counter sched_cycle;   // cycle when the op is scheduled (arrives at the functional unit)
-  Counter exec_cycle;    // cycle when execution (or addr gen) of op will be completed (result usable)
   Counter dcache_cycle;  // cycle when the op accesses the dcache
-  Counter done_cycle;    // cycle when the op is ready to retire
   Counter retire_cycle;  // cycle when the op actually retires (useful if you keep the ops around after they commit
   Counter replay_cycle;  // cycle when the op catches a replay signal
   Counter pred_cycle;
@@ -172,7 +204,6 @@ struct Op_struct {
   // }}}
 
   // {{{ path and fetch info
-  Flag off_path;                // is the op on the correct path of the program? - oracle information
   Flag conf_off_path;           // is the op on the correct path of the program? - confidence information
   Flag exit;                    // is this the last instruction to execute?
   Flag prog_input;              // is this op directly related to an input value of the program ?
@@ -181,34 +212,22 @@ struct Op_struct {
   // }}}
 
   // {{{ scheduler information
-  uns fu_num;         // functional unit number the op will or did execute on
-  Counter node_id;    // id for position in the node table
-  Counter rs_id;      // id for which Reservation Station (RS) this op is assigned to
   Counter chkpt_num;  // id for chkpt (WARNING: this can change due to recoveries)
 
-  struct Op_struct* next_rdy;   // pointer to next ready op (node table)
-  Flag in_rdy_list;             // is the op in the node stage's ready list?
-  struct Op_struct* next_node;  // pointer to the next op in the node table
-  Flag in_node_list;            // is the op in the node list?
   Flag precommitted;            // if the op is pre-commit in the ROB
   Flag macro_fused;             // if the op should be fused with the previous op (CMP/TEST)
   Flag move_eliminated;         // if the op can be move-eliminated
-  Flag replay;                  // is the op waiting to replay?
   uns replay_count;             // number of times the op has replayed
   Flag dont_cause_replays;      // true if the op should not cause other ops to replay (like a correct value prediction)
   uns exec_count;               // how many times has this op been executed?
+  Flag tlb_wait;                // is the op waiting for its page to be translated? (TLB_ON)
   // }}}
 
   // {{{ dependency information
-  uns srcs_not_rdy_vector;               // bits as given by order in the src_info array
   Flag wake_up_signaled[NUM_DEP_TYPES];  // set to true once a wake up has been signaled by the op for the given type
-  Wake_Up_Entry* wake_up_head;           // list of ops that are dependent on this op, by dependency type
-  Wake_Up_Entry* wake_up_tail;           // last entry in each wake up list (for speed)
-  uns wake_up_count;                     // count of ops to be awakened by this op (wake up list length)
-  Counter wake_cycle;                    // used by wake up logic for time wake up signal is sent
+  Wake_Up_List wake_up[NUM_DEP_TYPES];   // ops that are dependent on this op, by dependency type
   // }}}
 
-  struct Mem_Req_struct* req;  // pointer to memory request responsible for waking up the op
   // }}}
 
   Flag marked;  // for algorithms that mark already seen ops
@@ -270,9 +289,10 @@ struct Op_struct {
   int src_reg_id[MAX_SRCS][REG_TABLE_TYPE_NUM];        // the reg id of the source reg file entries
   int dst_reg_id[MAX_DESTS][REG_TABLE_TYPE_NUM];       // the reg id of allocated reg file entries
   int prev_dst_reg_id[MAX_DESTS][REG_TABLE_TYPE_NUM];  // the previous dst reg id with the same parent register id
+  Flag reg_ids_valid;  // the reg id arrays above are set up; done at rename, so ops dropped before it skip them
   // }}}
   FT* parent_FT;
-};
+} __attribute__((aligned(64)));
 
 /**************************************************************************************/
 
@@ -48,9 +48,12 @@ allocates them once and then hands out pointers every time 'alloc_op' is called.
 #include "frontend/frontend_intf.h"
 #include "frontend/pin_trace_fe.h"
 
+#include "cmp_threads.h"
+#include "lsq.h"
 #include "map.h"
 #include "model.h"
 #include "sim.h"
+#include "statistics.h"
 
 /**************************************************************************************/
 /* Macros */
@@ -60,6 +63,25 @@ allocates them once and then hands out pointers every time 'alloc_op' is called.
 
 // TODO: it should be increased to 512 to use more than 50,000 FDIP lookahead buffer entries
 #define OP_POOL_ENTRIES_INC 128 /* default 128 */
+#define FAKE_INST_INFO_ENTRIES_INC 128
+
+/**************************************************************************************/
+/* Types */
+
+/* A typed slab pool: items are carved out of calloc'd slabs of items_per_slab and
+   recycled through a per-core free list threaded through the first word of each
+   free item, so steady-state alloc/free never touch the heap.  A core's items are
+   only allocated and freed by that core. */
+typedef struct Slab_Pool_struct {
+  const char* name;
+  uns item_size;
+  uns items_per_slab;
+  void** free_heads; /* per core */
+  uns* entries;      /* per core: items carved so far */
+  uns* active;       /* per core: items handed out */
+  uns* peak;         /* per core: high-water mark of active */
+  Stat_Enum peak_stat;
+} Slab_Pool;
 
 /**************************************************************************************/
 /* Global variables */
@@ -67,6 +89,7 @@ allocates them once and then hands out pointers every time 'alloc_op' is called.
 uns op_pool_entries = 0;
 uns op_pool_active_ops = 0;
 static Op* op_pool_free_head;
+static Slab_Pool fake_inst_info_pool;
 
 Op invalid_op;
 
@@ -74,10 +97,16 @@ Op invalid_op;
 /* Prototypes */
 
 static inline void expand_op_pool(void);
+static void init_slab_pool(Slab_Pool*, const char*, uns, uns, Stat_Enum);
+static inline void* slab_pool_alloc(Slab_Pool*, uns);
+static inline void slab_pool_free(Slab_Pool*, uns, void*);
 
 /**************************************************************************************/
 /* init_op_pool: */
 
+_Static_assert(offsetof(Op, node_id) == 64 && offsetof(Op, op_pool_valid) == 128,
+               "The hot fields of Op no longer fill its first two cache lines");
+
 void init_op_pool() {
   DEBUGU(0, "Initializing op pool...\n");
 
@@ -92,6 +121,73 @@ void init_op_pool() {
 
   /* allocate memory for op pool */
   expand_op_pool();
+
+  init_slab_pool(&fake_inst_info_pool, "fake inst_info", sizeof(Inst_Info), FAKE_INST_INFO_ENTRIES_INC,
+                 FAKE_INST_INFO_PEAK);
+}
+
+/**************************************************************************************/
+/* init_slab_pool: */
+
+static void init_slab_pool(Slab_Pool* pool, const char* name, uns item_size, uns items_per_slab, Stat_Enum peak_stat) {
+  ASSERT(0, item_size >= sizeof(void*));
+  pool->name = name;
+  pool->item_size = item_size;
+  pool->items_per_slab = items_per_slab;
+  pool->free_heads = (void**)calloc(NUM_CORES, sizeof(void*));
+  pool->entries = (uns*)calloc(NUM_CORES, sizeof(uns));
+  pool->active = (uns*)calloc(NUM_CORES, sizeof(uns));
+  pool->peak = (uns*)calloc(NUM_CORES, sizeof(uns));
+  pool->peak_stat = peak_stat;
+}
+
+/**************************************************************************************/
+/* slab_pool_alloc: returns a zeroed item */
+
+static inline void* slab_pool_alloc(Slab_Pool* pool, uns proc_id) {
+  void* item;
+
+  ASSERT(proc_id, pool->free_heads);
+  if (pool->free_heads[proc_id] == NULL) {
+    char* slab = (char*)calloc(pool->items_per_slab, pool->item_size);
+    uns ii;
+    ASSERT(proc_id, slab);
+    for (ii = 0; ii < pool->items_per_slab - 1; ii++)
+      *(void**)(slab + ii * pool->item_size) = slab + (ii + 1) * pool->item_size;
+    *(void**)(slab + ii * pool->item_size) = NULL;
+    pool->free_heads[proc_id] = slab;
+    pool->entries[proc_id] += pool->items_per_slab;
+    DEBUGU(proc_id, "Expanding %s pool to size %d\n", pool->name, pool->entries[proc_id]);
+  }
+
+  item = pool->free_heads[proc_id];
+  pool->free_heads[proc_id] = *(void**)item;
+  memset(item, 0, pool->item_size);
+
+  pool->active[proc_id]++;
+  if (pool->active[proc_id] > pool->peak[proc_id]) {
+    INC_STAT_EVENT(proc_id, pool->peak_stat, pool->active[proc_id] - pool->peak[proc_id]);
+    pool->peak[proc_id] = pool->active[proc_id];
+  }
+  return item;
+}
+
+/**************************************************************************************/
+/* slab_pool_free: */
+
+static inline void slab_pool_free(Slab_Pool* pool, uns proc_id, void* item) {
+  ASSERT(proc_id, pool->active[proc_id] > 0);
+  pool->active[proc_id]--;
+  *(void**)item = pool->free_heads[proc_id];
+  pool->free_heads[proc_id] = item;
+}
+
+/**************************************************************************************/
+/* alloc_fake_inst_info: zeroed Inst_Info for a fake (not decoded) instruction of
+   proc_id; it goes back to the pool when free_op frees the op that holds it */
+
+Inst_Info* alloc_fake_inst_info(uns proc_id) {
+  return (Inst_Info*)slab_pool_alloc(&fake_inst_info_pool, proc_id);
 }
 
 /**************************************************************************************/
@@ -107,6 +203,7 @@ void reset_op_pool() {
 /* alloc_op:  returns a pointer to the next available op */
 
 Op* alloc_op(uns proc_id) {
+  UNCORE_LOCK_SCOPE();
   Op* new_op;
 
   if (op_pool_free_head == NULL) {
@@ -128,10 +225,26 @@ Op* alloc_op(uns proc_id) {
   return new_op;
 }
 
+/**************************************************************************************/
+/* unalloc_op: returns an op that was allocated but never fetched into, so has
+   nothing of its own for free_op to release */
+
+void unalloc_op(Op* op) {
+  UNCORE_LOCK_SCOPE();
+  ASSERT(0, op);
+  ASSERT(0, op->op_pool_valid);
+
+  op->op_pool_valid = FALSE;
+  op_pool_active_ops--;
+  op->op_pool_next = op_pool_free_head;
+  op_pool_free_head = op;
+}
+
 /**************************************************************************************/
 /* free_op:  "frees" an op */
 
 void free_op(Op* op) {
+  UNCORE_LOCK_SCOPE();
   ASSERT(0, op);
   ASSERT(0, op->op_pool_valid);
   ASSERT(0, !op->marked);
@@ -148,13 +261,13 @@ void free_op(Op* op) {
     free(op->sched_info);
 
   if (op->table_info->mem_type == MEM_ST)
-    delete_store_hash_entry(op);
+    lsq_release_store(op);
 
   if (op->inst_info && op->inst_info->fake_inst) {
     ASSERT(0, op->table_info == op->inst_info->table_info);
     // we no longer allocate memory for fake nops
     // free(op->inst_info->table_info);
-    free(op->inst_info);
+    slab_pool_free(&fake_inst_info_pool, op->proc_id, op->inst_info);
     op->inst_info = NULL;
   }
 
@@ -178,7 +291,7 @@ void op_pool_init_op(Op* op) {
    taken from the pool to be used */
 
 void op_pool_setup_op(uns proc_id, Op* op) {
-  uns ii, jj;
+  uns ii;
   /* only initialize here what is independent of the engine (the
      rest should be in the fetch stage) */
   op->bom = FALSE;
@@ -210,6 +323,7 @@ void op_pool_setup_op(uns proc_id, Op* op) {
   op->precommit_cycle = MAX_CTR;
   op->decode_cycle = 0;
   op->replay = FALSE;
+  op->tlb_wait = FALSE;
   op->replay_count = 0;
   op->dont_cause_replays = FALSE;
   op->exec_count = 0;
@@ -252,25 +366,19 @@ void op_pool_setup_op(uns proc_id, Op* op) {
   for (ii = 0; ii < NUM_DEP_TYPES; ii++)
     op->wake_up_signaled[ii] = FALSE;
 
-  for (ii = 0; ii < MAX_SRCS; ++ii) {
-    for (jj = 0; jj < REG_TABLE_TYPE_NUM; ++jj) {
-      op->src_reg_id[ii][jj] = -1;
-    }
-  }
-
-  for (ii = 0; ii < MAX_DESTS; ++ii) {
-    for (jj = 0; jj < REG_TABLE_TYPE_NUM; ++jj) {
-      op->dst_reg_id[ii][jj] = -1;
-      op->prev_dst_reg_id[ii][jj] = -1;
-    }
-  }
+  /* src_reg_id, dst_reg_id and prev_dst_reg_id are set up by the register file */
+  op->reg_ids_valid = FALSE;
 }
 
 /**************************************************************************************/
 /* expand_op_pool: */
 
 static inline void expand_op_pool() {
-  Op* new_pool = (Op*)calloc(OP_POOL_ENTRIES_INC, sizeof(Op));
+  /* keep the ops cache-line aligned, so their hot fields fill whole lines */
+  Op* new_pool = NULL;
+  int error = posix_memalign((void**)&new_pool, __alignof__(Op), OP_POOL_ENTRIES_INC * sizeof(Op));
+  ASSERT(0, error == 0);
+  memset(new_pool, 0, OP_POOL_ENTRIES_INC * sizeof(Op));
   uns ii;
 
   DEBUGU(0, "Expanding op pool to size %d\n", op_pool_entries + OP_POOL_ENTRIES_INC);
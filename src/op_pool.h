@@ -49,8 +49,10 @@ void init_op_pool(void);
 void reset_op_pool(void);
 Op* alloc_op(uns proc_id);
 void free_op(Op*);
+void unalloc_op(Op*);
 void op_pool_init_op(Op*);
 void op_pool_setup_op(uns proc_id, Op* op);
+Inst_Info* alloc_fake_inst_info(uns proc_id);
 
 /**************************************************************************************/
 
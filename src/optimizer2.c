@@ -31,12 +31,19 @@
  *from the master feed comparison barrier decisions to the
  *slaves. A single feedback fifo pipe feeds performance data
  *from the slaves to the master.
+ *
+ *                Between comparison barriers, slaves may report interim
+ *metrics. The master compares each against the best interim metric of the
+ *round at the same point and kills slaves that trail it by more than
+ *OPTIMIZER2_PRUNE_MARGIN, so hopeless configurations free their host core
+ *for the ones still waiting to be spawned.
  ***************************************************************************************/
 
 #include "optimizer2.h"
 
 #include <dirent.h>
 #include <errno.h>
+#include <math.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -64,6 +71,8 @@
   MESSAGE_TYPE_LIST_ITEM(OPT_NEW_SLAVE_ACK)     \
   MESSAGE_TYPE_LIST_ITEM(OPT_REPORT_METRIC)     \
   MESSAGE_TYPE_LIST_ITEM(OPT_REPORT_METRIC_ACK) \
+  MESSAGE_TYPE_LIST_ITEM(OPT_INTERIM_METRIC)    \
+  MESSAGE_TYPE_LIST_ITEM(OPT_INTERIM_METRIC_ACK) \
   MESSAGE_TYPE_LIST_ITEM(OPT_DIE)               \
   MESSAGE_TYPE_LIST_ITEM(OPT_DIE_ACK)           \
   MESSAGE_TYPE_LIST_ITEM(OPT_SIM_COMPLETE)      \
@@ -88,6 +97,7 @@ typedef struct Message_struct {
   pid_t sender_pid;
   Message_Type type;
   uns config;
+  uns interim_num;  // interim reports the sender made this round
   Counter data;
 } Message;
 
@@ -103,6 +113,8 @@ static Flag is_leader = TRUE;  // if we have not initialized, there's only one
 static uns num_configs;
 static uns master_pid;
 static uns my_config_num;
+static uns my_interim_num;
+static uns max_num_slaves;
 static FILE* read_stream;
 static FILE* feedback_read_stream;
 static FILE* feedback_write_stream;
@@ -116,6 +128,7 @@ static double ctr2dbl(Counter x);
 static void spawn_children(void);
 static FILE* open_fifo(uns pid, const char* mode);
 static void slave_clean_up(void);
+static void slave_die(void);
 static void master_clean_up(void);
 static void run_master(void);
 static void decouple_open_files(void);
@@ -150,12 +163,16 @@ FILE* open_fifo(uns pid, const char* mode) {
 void run_master(void) {
   Message msg;
   Flag new_slave_req_outstanding = FALSE;
+  uns new_slave_req_pid = 0;
   uns num_slaves = 1;
   uns num_slaves_to_report = num_slaves;
   uns num_slaves_reported = 0;
   Slave_Result best_result = {0};
   Slave_Result survivor_result = {-1, 0, 0};
   uns prev_best_config_num = 0;
+  double* interim_best = NULL;  // best interim metric of the round, per interim report
+  uns num_interim_best = 0;
+  uns interim_best_size = 0;
   FILE* master_trace = fopen("master.trace", "w");
   ASSERTM(0, master_trace, "Could not open master trace\n");
   while (1) {
@@ -168,7 +185,7 @@ void run_master(void) {
     switch (msg.type) {
       case OPT_NEW_SLAVE_REQ:
         ASSERT(0, !new_slave_req_outstanding);
-        if (num_slaves < OPTIMIZER2_MAX_NUM_SLAVES) {
+        if (num_slaves < max_num_slaves) {
           FILE* slave_fifo = open_fifo(msg.sender_pid, "w");
           send_msg(slave_fifo, OPT_NEW_SLAVE_ACK, 0);
           fclose(slave_fifo);
@@ -176,13 +193,13 @@ void run_master(void) {
           num_slaves_to_report++;
         } else {
           new_slave_req_outstanding = TRUE;
+          new_slave_req_pid = msg.sender_pid;
         }
         break;
       case OPT_DIE_ACK:
         // waitpid() here?
         if (new_slave_req_outstanding) {
-          uns parent_pid = msg.data;
-          FILE* parent_fifo = open_fifo(parent_pid, "w");
+          FILE* parent_fifo = open_fifo(new_slave_req_pid, "w");
           send_msg(parent_fifo, OPT_NEW_SLAVE_ACK, 0);
           fclose(parent_fifo);
           new_slave_req_outstanding = FALSE;
@@ -228,6 +245,34 @@ void run_master(void) {
         }
         ++num_slaves_reported;
       } break;
+      case OPT_INTERIM_METRIC: {
+        // slaves of a round are forked at the same point and report at the
+        // same intervals, so the first one to make a report sets its baseline
+        double metric = ctr2dbl(msg.data);
+        Flag prune = FALSE;
+        if (msg.interim_num < num_interim_best) {
+          double best = interim_best[msg.interim_num];
+          prune = metric > best + fabs(best) * OPTIMIZER2_PRUNE_MARGIN;
+          if (metric < best)
+            interim_best[msg.interim_num] = metric;
+        } else {
+          ASSERT(0, msg.interim_num == num_interim_best);
+          if (num_interim_best == interim_best_size) {
+            interim_best_size = interim_best_size ? 2 * interim_best_size : 16;
+            interim_best = realloc(interim_best, interim_best_size * sizeof(double));
+          }
+          interim_best[num_interim_best++] = metric;
+        }
+        FILE* slave_fifo = open_fifo(msg.sender_pid, "w");
+        send_msg(slave_fifo, prune ? OPT_DIE : OPT_INTERIM_METRIC_ACK, 0);
+        fclose(slave_fifo);
+        if (prune) {
+          // the slave will not report at the barrier; its OPT_DIE_ACK frees its slot
+          DEBUG(0, "Pruned slave %d (config %d) at interim report %d\n", msg.sender_pid, msg.config, msg.interim_num);
+          ASSERT(0, num_slaves_to_report > num_slaves_reported);
+          num_slaves_to_report--;
+        }
+      } break;
       case OPT_SIM_COMPLETE: {
         ASSERT(0, num_slaves == 1);
         // waitpid() here?
@@ -256,6 +301,7 @@ void run_master(void) {
       num_slaves_to_report = num_slaves;
       prev_best_config_num = best_result.config;
       survivor_result.pid = -1;
+      num_interim_best = 0;
     }
   }
 }
@@ -267,6 +313,8 @@ void opt2_init(uns n, uns n_to_keep, void (*fn)(int)) {
           "at different times.\n");
   num_configs = n;
   setup_param_fn = fn;
+  max_num_slaves = OPTIMIZER2_MAX_NUM_SLAVES ? OPTIMIZER2_MAX_NUM_SLAVES : MAX2(sysconf(_SC_NPROCESSORS_ONLN), 1);
+  DEBUG(0, "Optimizer2 runs up to %d slaves at once\n", max_num_slaves);
   char buf[MAX_STR_LENGTH + 1];
   DEBUG(0, "Initializing optimizer2\n");
   signal(SIGCHLD, SIG_IGN); /* avoid zombie processes */
@@ -298,6 +346,12 @@ void slave_clean_up(void) {
   fclose(feedback_write_stream);
 }
 
+void slave_die(void) {
+  send_msg(feedback_write_stream, OPT_DIE_ACK, getppid());
+  slave_clean_up();
+  exit(EXIT_SUCCESS);
+}
+
 void master_clean_up(void) {
   char buf[MAX_STR_LENGTH + 1];
   fclose(feedback_read_stream);
@@ -311,12 +365,28 @@ void opt2_comparison_barrier(double metric) {
   receive_msg(read_stream, OPT_ANY_TYPE, &msg, master_pid);
   switch (msg.type) {
     case OPT_DIE:
-      send_msg(feedback_write_stream, OPT_DIE_ACK, getppid());
-      slave_clean_up();
-      exit(EXIT_SUCCESS);
+      slave_die();
       break;
     case OPT_REPORT_METRIC_ACK:
       is_leader = TRUE;
+      my_interim_num = 0;
+      break;
+    default:
+      FATAL_ERROR(0, "Unexpected message %s received!\n", message_type_names[msg.type]);
+      break;
+  }
+}
+
+void opt2_interim_report(double metric) {
+  send_msg(feedback_write_stream, OPT_INTERIM_METRIC, dbl2ctr(metric));
+  Message msg;
+  receive_msg(read_stream, OPT_ANY_TYPE, &msg, master_pid);
+  switch (msg.type) {
+    case OPT_DIE:
+      slave_die();
+      break;
+    case OPT_INTERIM_METRIC_ACK:
+      my_interim_num++;
       break;
     default:
       FATAL_ERROR(0, "Unexpected message %s received!\n", message_type_names[msg.type]);
@@ -330,6 +400,7 @@ void send_msg(FILE* stream, Message_Type type, Counter data) {
   Message msg;
   msg.type = type;
   msg.config = my_config_num;
+  msg.interim_num = my_interim_num;
   msg.data = data;
   msg.sender_pid = getpid();
   uns written = fwrite(&msg, sizeof(Message), 1, stream);
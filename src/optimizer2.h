@@ -40,6 +40,11 @@ void opt2_init(uns n, uns n_to_keep, void (*setup_param_fn)(int));
 /* Called by slave once a comparison barrier is reached. Slave may die. */
 void opt2_comparison_barrier(double metric);
 
+/* Called by slave between comparison barriers, at the same points in every
+ * slave of a round (lower metric is better). Slave dies if it trails the best
+ * slave's metric at that point by more than OPTIMIZER2_PRUNE_MARGIN. */
+void opt2_interim_report(double metric);
+
 /* Called by slave when the decision point of the studied adaptive scheme would
  * be reached */
 void opt2_decision_point(void);
@@ -43,9 +43,14 @@ the program.  This way, an exact duplicate run can be performed.
 #include "param_parser.h"
 
 #include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "globals/global_defs.h"
 #include "globals/global_types.h"
@@ -69,6 +74,8 @@ the program.  This way, an exact duplicate run can be performed.
 
 #define ARG_FILE_OUT "PARAMS" /* the name of the parameter dump file */
 
+#define PARAM_BIN_MAGIC "SCRBPAR1" /* PARAM_BIN_SAVE file magic, 8 bytes */
+
 #define ASSERTM(proc_id, cond, ...) \
   if (!(cond)) {                    \
     printf(__VA_ARGS__);            \
@@ -80,7 +87,7 @@ the program.  This way, an exact duplicate run can be performed.
 /* Global Variables */
 
 const char* help_options[] = {"-help", "-h", "--help", "--h"}; /* cmd-line help options strings */
-const char* sim_mode_names[] = {"uop", "full"
+const char* sim_mode_names[] = {"uop", "full", "sampling", "dram_replay"
 #ifdef ENABLE_PT_MEMTRACE
                                 ,
                                 "trace_bbv", "trace_bbv_distributed"
@@ -148,6 +155,29 @@ typedef struct Param_Record_struct {
   char optarg[MAX_STR_LENGTH + 1];
 } Param_Record;
 
+/* A binary parameter set (PARAM_BIN_SAVE) is the header followed by
+   num_records of {uns32 index, uns32 length, length bytes of value}, one per
+   parameter assignment in the order they were applied. It is only valid for
+   a binary with the same parameter list, which names_hash checks. */
+typedef struct Param_Bin_Header_struct {
+  char magic[8];
+  uns32 num_params;
+  uns32 names_hash;
+  uns32 num_records;
+} Param_Bin_Header;
+
+typedef struct Param_Assignment_struct {
+  uns32 index;
+  char* value;
+} Param_Assignment;
+
+/* every parameter assignment so far, for PARAM_BIN_SAVE */
+static Param_Assignment* assignments = NULL;
+static uns num_assignments = 0;
+
+/* this process simulates one lane of SIM_LANES_FILE */
+static Flag in_lane = FALSE;
+
 void dump_params(char** arg_list, Param_Record used_params[], Flag exe_found);
 
 /**************************************************************************************/
@@ -172,6 +202,12 @@ uns fill_arg_list_with_param_file_args(FILE* param_file_fp, const int param_file
 uns add_all_param_file_args_to_arg_list(FILE* param_file_fp, const uns param_file_arg_count, char** arg_list, int argc);
 uns add_all_command_line_args_to_end_of_arg_list(char** arg_list, uns arg_list_index, char* argv[]);
 uns get_param_file_args_and_command_line_args(char*** arg_list, int argc, char* argv[]);
+static void apply_param(int index, Param_Record* used_params);
+static uns32 param_names_hash(void);
+static const char* find_param_bin_load(char* argv[]);
+static void load_param_bin(const char* file_name, Param_Record* used_params);
+static void save_param_bin(const char* file_name);
+static void run_lanes(Param_Record* used_params);
 
 /**************************************************************************************/
 /**************************************************************************************/
@@ -440,7 +476,7 @@ void get_uns64_param(const char* name, uns64* variable) {
 
 void dump_params(char** arg_list, Param_Record used_params[], Flag exe_found) {
   int ii;
-  FILE* arg_stream_out = file_tag_fopen(NULL, ARG_FILE_OUT, "w");
+  FILE* arg_stream_out = file_tag_fopen(in_lane ? OUTPUT_DIR : NULL, ARG_FILE_OUT, "w");
   if (!arg_stream_out) {
     WARNINGU(0, "Couldn't open parameter output file %s.out --- Dumping to stderr.\n", ARG_FILE_OUT);
     arg_stream_out = stderr;
@@ -738,32 +774,35 @@ char** get_params(int argc, char* argv[]) {
     exit(0);
   }
 
-  arg_list_count = get_param_file_args_and_command_line_args(&arg_list, argc, argv);
+  mark_all_params_as_unused(used_params);
+  const char* param_bin = find_param_bin_load(argv);
+  if (param_bin) {
+    /* the binary set replaces PARAMS.in; the command line still applies on top */
+    arg_list = allocate_and_initialize_arg_list(0, argc, argv);
+    add_all_command_line_args_to_end_of_arg_list(arg_list, 1, argv);
+    arg_list_count = argc;
+    load_param_bin(param_bin, used_params);
+  } else {
+    arg_list_count = get_param_file_args_and_command_line_args(&arg_list, argc, argv);
+  }
 
   int temp_index = 0;
   param_idx = -1;
   opterr = 0;  // Suppress getopt_long's error message (we have our own)
-  mark_all_params_as_unused(used_params);
   while (getopt_long(arg_list_count, arg_list, "", long_options, &temp_index) != -1) {
     int index = param_idx;
     param_idx = -1;
     if (index == -1) {
       FATAL_ERROR(0, "Unknown parameter '%s'\n", arg_list[optind - 1]);
     }
-    if (strncmp(const_options[index], "const", MAX_STR_LENGTH) == 0) {
-      FATAL_ERROR(0, "Cannot set parameter '%s' compiled as a constant.\n", long_options[index].name);
-      continue;
-    }
-    switch (index) {
-#include "param_files.def"
-      case PARAM_ENUM_help:
-        if (system("cat ../doc/cmd-line_options") != 0)
-          if (system("cat $SIMDIR/doc/cmd-line_options") != 0)
-            ERROR(0, "File 'cmd-line_options' could not be found.\n");
-        break;
-      default:
-        FATAL_ERROR(0, "Unknown command-line option found (index:%u).\n", index);
-    }
+    apply_param(index, used_params);
+  }
+  if (PARAM_BIN_SAVE)
+    save_param_bin(PARAM_BIN_SAVE);
+  if (SIM_LANES_FILE) {
+    int sim_optind = optind;
+    run_lanes(used_params); /* returns in the lane processes only */
+    optind = sim_optind;
   }
 
   // Set global size variables.
@@ -775,13 +814,16 @@ char** get_params(int argc, char* argv[]) {
           "RS_CONNECTIONS(%d)",
           NUM_RS, temp);
 
+  if (FRONTEND == FE_REPLAY && !REPLAY_FILE)
+    FATAL_ERROR(0, "Replay frontend specified, but no recording specified (use --replay_file).\n");
+
   if ((FRONTEND == FE_TRACE
 #ifdef ENABLE_PT_MEMTRACE
        || FRONTEND == FE_MEMTRACE
 #endif
        ) &&
       !CBP_TRACE_R0) {
-    if (SIM_MODEL != DUMB_MODEL) {
+    if (SIM_MODEL != DUMB_MODEL || DUMB_MODEL_FRONTEND) {
       FATAL_ERROR(0,
                   "Trace frontend specified, but no trace file specified "
                   "(use --cbp_trace_r0).\n");
@@ -795,6 +837,228 @@ char** get_params(int argc, char* argv[]) {
   return &arg_list[optind]; /* return pointer to simulated argv */
 }
 
+/**************************************************************************************/
+/* apply_param: assigns optarg to parameter index */
+
+static void apply_param(int index, Param_Record* used_params) {
+  if (strncmp(const_options[index], "const", MAX_STR_LENGTH) == 0) {
+    FATAL_ERROR(0, "Cannot set parameter '%s' compiled as a constant.\n", long_options[index].name);
+    return;
+  }
+  switch (index) {
+#include "param_files.def"
+    case PARAM_ENUM_help:
+      if (system("cat ../doc/cmd-line_options") != 0)
+        if (system("cat $SIMDIR/doc/cmd-line_options") != 0)
+          ERROR(0, "File 'cmd-line_options' could not be found.\n");
+      return;
+    default:
+      FATAL_ERROR(0, "Unknown command-line option found (index:%u).\n", index);
+  }
+
+  if (index != PARAM_ENUM_param_bin_save && index != PARAM_ENUM_param_bin_load) {
+    assignments = (Param_Assignment*)realloc(assignments, sizeof(Param_Assignment) * (num_assignments + 1));
+    assignments[num_assignments].index = index;
+    assignments[num_assignments].value = strdup(optarg);
+    num_assignments++;
+  }
+}
+
+/**************************************************************************************/
+/* param_names_hash: FNV-1a hash of the parameter names, in order */
+
+static uns32 param_names_hash(void) {
+  uns32 hash = 2166136261u;
+  for (uns ii = 0; ii < NUM_PARAMS; ii++) {
+    for (const char* c = long_options[ii].name; *c; c++)
+      hash = (hash ^ (uns8)*c) * 16777619u;
+    hash = (hash ^ ',') * 16777619u;
+  }
+  return hash;
+}
+
+/**************************************************************************************/
+/* find_param_bin_load: the value of --param_bin_load on the command line, which
+   has to be known before PARAMS.in would be read */
+
+static const char* find_param_bin_load(char* argv[]) {
+  const char* option = "--param_bin_load";
+  size_t len = strlen(option);
+  const char* file_name = NULL;
+  for (uns ii = 1; argv[ii] && !param_is_exe_option(argv[ii]); ii++) {
+    if (strncmp(argv[ii], option, len))
+      continue;
+    if (argv[ii][len] == '=')
+      file_name = argv[ii] + len + 1;
+    else if (argv[ii][len] == '\0' && argv[ii + 1])
+      file_name = argv[ii + 1];
+  }
+  return file_name;
+}
+
+/**************************************************************************************/
+/* load_param_bin: applies the assignments of a PARAM_BIN_SAVE file without
+   matching any parameter names */
+
+static void load_param_bin(const char* file_name, Param_Record* used_params) {
+  FILE* file = fopen(file_name, "rb");
+  ASSERTM(0, file, "Could not open parameter set '%s'\n", file_name);
+  Param_Bin_Header header;
+  size_t num_read = fread(&header, sizeof(header), 1, file);
+  ASSERTM(0, num_read == 1 && !memcmp(header.magic, PARAM_BIN_MAGIC, 8), "'%s' is not a parameter set\n", file_name);
+  ASSERTM(0, header.num_params == NUM_PARAMS && header.names_hash == param_names_hash(),
+          "Parameter set '%s' was saved by a build with different parameters\n", file_name);
+
+  char value[MAX_STR_LENGTH + 1];
+  for (uns ii = 0; ii < header.num_records; ii++) {
+    uns32 record[2];
+    num_read = fread(record, sizeof(record), 1, file);
+    ASSERTM(0, num_read == 1, "Parameter set '%s' is truncated\n", file_name);
+    ASSERTM(0, record[0] < NUM_PARAMS && record[1] <= MAX_STR_LENGTH, "Parameter set '%s' is corrupt\n",
+            file_name);
+    num_read = fread(value, 1, record[1], file);
+    ASSERTM(0, num_read == record[1], "Parameter set '%s' is truncated\n", file_name);
+    value[record[1]] = '\0';
+    optarg = value;
+    apply_param(record[0], used_params);
+  }
+  optarg = NULL;
+  fclose(file);
+}
+
+/**************************************************************************************/
+/* save_param_bin: */
+
+static void save_param_bin(const char* file_name) {
+  FILE* file = fopen(file_name, "wb");
+  ASSERTM(0, file, "Could not create parameter set '%s'\n", file_name);
+  Param_Bin_Header header;
+  memcpy(header.magic, PARAM_BIN_MAGIC, 8);
+  header.num_params = NUM_PARAMS;
+  header.names_hash = param_names_hash();
+  header.num_records = num_assignments;
+  Flag ok = fwrite(&header, sizeof(header), 1, file) == 1;
+  for (uns ii = 0; ok && ii < num_assignments; ii++) {
+    uns32 record[2] = {assignments[ii].index, MIN2(strlen(assignments[ii].value), MAX_STR_LENGTH)};
+    ok = fwrite(record, sizeof(record), 1, file) == 1 && fwrite(assignments[ii].value, 1, record[1], file) == record[1];
+  }
+  ok = !fclose(file) && ok;
+  ASSERTM(0, ok, "Could not write parameter set '%s'\n", file_name);
+}
+
+/**************************************************************************************/
+/* run_lanes: forks one simulation per line of SIM_LANES_FILE. A line is a lane
+   name followed by parameter assignments ("--name value" or "--name=value",
+   no quoting) applied on top of the common parameters. Each lane writes to
+   OUTPUT_DIR/<name> unless it sets its own output_dir. With a memtrace or PT
+   frontend the lanes share one decoded trace stream unless
+   TRACE_SHARED_DECODE_DIR is already set. The parent waits for every lane and
+   exits with a failure status if any of them failed. */
+
+static void run_lanes(Param_Record* used_params) {
+  FILE* lanes_file = fopen(SIM_LANES_FILE, "r");
+  if (!lanes_file)
+    FATAL_ERROR(0, "Could not open lanes file '%s'\n", SIM_LANES_FILE);
+
+  char* decode_dir = NULL;
+#ifdef ENABLE_PT_MEMTRACE
+  if (!TRACE_SHARED_DECODE_DIR && (FRONTEND == FE_MEMTRACE || FRONTEND == FE_PT)) {
+    char buf[MAX_STR_LENGTH + 1];
+    snprintf(buf, MAX_STR_LENGTH, "%s/lanes.decode", OUTPUT_DIR);
+    if (mkdir(buf, 0777) == 0 || errno == EEXIST)
+      TRACE_SHARED_DECODE_DIR = decode_dir = strdup(buf);
+  }
+#endif
+
+  char* line = NULL;
+  size_t line_size = 0;
+  uns num_lanes = 0;
+  char** lane_names = NULL;
+  pid_t* lane_pids = NULL;
+  while (getline(&line, &line_size, lanes_file) != -1) {
+    char* name = strtok(line, " \t\r\n");
+    if (!name || name[0] == '#')
+      continue;
+
+    lane_names = (char**)realloc(lane_names, sizeof(char*) * (num_lanes + 1));
+    lane_pids = (pid_t*)realloc(lane_pids, sizeof(pid_t) * (num_lanes + 1));
+    lane_names[num_lanes] = strdup(name);
+    fflush(NULL);
+    pid_t pid = fork();
+    if (pid < 0)
+      FATAL_ERROR(0, "Could not fork lane '%s'\n", name);
+    if (pid > 0) {
+      fprintf(stdout, "Lane %s: pid %d\n", name, pid);
+      lane_pids[num_lanes++] = pid;
+      continue;
+    }
+
+    /* the lane: its output directory first, so that the lane may override it */
+    char** lane_args = (char**)malloc(sizeof(char*) * (line_size / 2 + 2));
+    uns lane_argc = 0;
+    char dir[MAX_STR_LENGTH + 1];
+    snprintf(dir, MAX_STR_LENGTH, "%s/%s", OUTPUT_DIR, name);
+    OUTPUT_DIR = strdup(dir);
+    lane_args[lane_argc++] = "scarab";
+    for (char* arg = strtok(NULL, " \t\r\n"); arg; arg = strtok(NULL, " \t\r\n"))
+      lane_args[lane_argc++] = strdup(arg);
+    lane_args[lane_argc] = NULL;
+
+    int temp_index = 0;
+    optind = 0; /* restart getopt_long on the lane's arguments */
+    param_idx = -1;
+    while (getopt_long(lane_argc, lane_args, "", long_options, &temp_index) != -1) {
+      int index = param_idx;
+      param_idx = -1;
+      if (index == -1)
+        FATAL_ERROR(0, "Unknown parameter '%s' in lane '%s'\n", lane_args[optind - 1], name);
+      apply_param(index, used_params);
+    }
+    if (mkdir(OUTPUT_DIR, 0777) != 0 && errno != EEXIST)
+      FATAL_ERROR(0, "Could not create lane directory '%s'\n", OUTPUT_DIR);
+    in_lane = TRUE;
+    fclose(lanes_file);
+    free(line);
+    return;
+  }
+  fclose(lanes_file);
+  free(line);
+  if (!num_lanes)
+    FATAL_ERROR(0, "No lanes in '%s'\n", SIM_LANES_FILE);
+
+  Flag failed = FALSE;
+  for (uns done = 0; done < num_lanes;) {
+    int status;
+    pid_t pid = wait(&status);
+    if (pid < 0)
+      break;
+    for (uns ii = 0; ii < num_lanes; ii++) {
+      if (lane_pids[ii] != pid)
+        continue;
+      Flag ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+      fprintf(stdout, "Lane %s: %s\n", lane_names[ii], ok ? "finished" : "FAILED");
+      failed |= !ok;
+      done++;
+    }
+  }
+
+  if (decode_dir) {
+    DIR* dir = opendir(decode_dir);
+    struct dirent* entry;
+    char buf[MAX_STR_LENGTH + 1];
+    while (dir && (entry = readdir(dir))) {
+      if (!strstr(entry->d_name, ".pistream"))
+        continue;
+      snprintf(buf, MAX_STR_LENGTH, "%s/%s", decode_dir, entry->d_name);
+      unlink(buf);
+    }
+    if (dir)
+      closedir(dir);
+    rmdir(decode_dir);
+  }
+  exit(failed ? 1 : 0);
+}
+
 static void print_help(void) {
   const char* help =
       "Scarab command-line option summary:\n"
@@ -84,9 +84,11 @@ void process_syscall(ADDRINT ip, ADDRINT num, ADDRINT arg0, ADDRINT arg1,
 
     checkpoints.append_to_cir_buf();
     checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                on_wrongpath_nop_mode, next_eip, 0);
+                                on_wrongpath_nop_mode, next_eip, 0,
+                              undo_log.get_tail_pos());
 #ifndef ASSUME_PERFECT
     save_context(ctxt);
+    next_ctxt_pending = true;  // never replay across a syscall
 #endif
     // Because syscalls uniquely are sent to scarab BEFORE their execution,
     // we do NOT update the global uid_ctr until the syscall compressed_op
@@ -99,6 +101,26 @@ void process_syscall(ADDRINT ip, ADDRINT num, ADDRINT arg0, ADDRINT arg1,
 
 void save_context(CONTEXT* ctxt) {
   PIN_SaveContext(ctxt, &checkpoints.get_tail().ctxt);
+  checkpoints.get_tail().has_ctxt = true;
+  insts_since_ctxt_save           = 0;
+}
+
+// With sparse checkpoints, only branches, the instruction after a branch,
+// syscall or marker, wrong-path instructions and every
+// sparse_checkpoint_interval-th instruction save a context. The others keep
+// only their store-undo state and are recovered by replaying from the nearest
+// older context (see recover_to_past_checkpoint).
+void save_sparse_context(CONTEXT* ctxt) {
+  bool save = !sparse_checkpoints || on_wrongpath || on_wrongpath_nop_mode ||
+              branch_ctxt_pending || next_ctxt_pending ||
+              insts_since_ctxt_save >= sparse_checkpoint_interval;
+  next_ctxt_pending   = branch_ctxt_pending;
+  branch_ctxt_pending = false;
+  if(save) {
+    save_context(ctxt);
+  } else {
+    insts_since_ctxt_save++;
+  }
 }
 
 void check_if_region_written_to(ADDRINT write_addr) {
@@ -164,10 +186,12 @@ void save_mem(ADDRINT write_addr, UINT32 write_size, UINT write_index) {
 
   check_if_region_written_to(write_addr);
 
-  checkpoints.get_tail().mem_state_list[write_index].init(write_addr,
-                                                          write_size);
-  PIN_SafeCopy(checkpoints.get_tail().mem_state_list[write_index].mem_data_ptr,
-               (void*)write_addr, write_size);
+  MemState& mem_state = checkpoints.get_tail().mem_state_list[write_index];
+  mem_state.mem_addr  = write_addr;
+  mem_state.mem_size  = write_size;
+  mem_state.log_pos   = undo_log.alloc(write_size);
+  PIN_SafeCopy(undo_log.data(mem_state.log_pos), (void*)write_addr,
+               write_size);
 #endif
 }
 
@@ -185,7 +209,8 @@ void finish_before_ins_all(CONTEXT* ctxt, bool from_syscall) {
 
       checkpoints.append_to_cir_buf();
       checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                  on_wrongpath_nop_mode, next_eip, 0);
+                                  on_wrongpath_nop_mode, next_eip, 0,
+                                  undo_log.get_tail_pos());
       uid_ctr++;
       save_context(ctxt);
       PIN_SetContextRegval(&(checkpoints.get_tail().ctxt), REG_INST_PTR,
@@ -225,10 +250,12 @@ void add_right_path_exec_br(CONTEXT* ctxt) {
   // Save checkpoint
   checkpoints.append_to_cir_buf();
   checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                              on_wrongpath_nop_mode, next_eip, 0);
+                              on_wrongpath_nop_mode, next_eip, 0,
+                              undo_log.get_tail_pos());
   uid_ctr++;
 #ifndef ASSUME_PERFECT
   save_context(ctxt);
+  next_ctxt_pending = true;
 #endif
 }
 
@@ -246,10 +273,11 @@ void before_ins_no_mem(CONTEXT* ctxt) {
 
     checkpoints.append_to_cir_buf();
     checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                on_wrongpath_nop_mode, next_eip, 0);
+                                on_wrongpath_nop_mode, next_eip, 0,
+                              undo_log.get_tail_pos());
     uid_ctr++;
 #ifndef ASSUME_PERFECT
-    save_context(ctxt);
+    save_sparse_context(ctxt);
 #endif
     finish_before_ins_all(ctxt, false);
   }
@@ -270,10 +298,11 @@ void before_ins_one_mem(CONTEXT* ctxt, ADDRINT write_addr, UINT32 write_size) {
 
     checkpoints.append_to_cir_buf();
     checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                on_wrongpath_nop_mode, next_eip, 1);
+                                on_wrongpath_nop_mode, next_eip, 1,
+                                undo_log.get_tail_pos());
     uid_ctr++;
 #ifndef ASSUME_PERFECT
-    save_context(ctxt);
+    save_sparse_context(ctxt);
 #endif
     save_mem(write_addr, write_size, 0);
     finish_before_ins_all(ctxt, false);
@@ -313,10 +342,11 @@ void before_ins_multi_mem(CONTEXT*                   ctxt,
 
     checkpoints.append_to_cir_buf();
     checkpoints.get_tail().init(uid_ctr, false, on_wrongpath,
-                                on_wrongpath_nop_mode, next_eip, numMemOps);
+                                on_wrongpath_nop_mode, next_eip, numMemOps,
+                                undo_log.get_tail_pos());
     uid_ctr++;
 #ifndef ASSUME_PERFECT
-    save_context(ctxt);
+    save_sparse_context(ctxt);
 #endif
     for(UINT32 i = 0; i < numMemOps; i++) {
       ADDRINT write_addr;
@@ -397,6 +427,7 @@ void logging(ADDRINT n_eip, ADDRINT curr_eip, BOOL check_next_addr,
 void check_ret_control_ins(ADDRINT read_addr, UINT32 read_size, CONTEXT* ctxt) {
   read_addr = ADDR_MASK(read_addr);
   if(!fast_forward_count) {
+    branch_ctxt_pending = true;
     ASSERTM(0, read_size <= 8,
             "RET pops more than 8 bytes off the stack as ESP: %" PRIx64
             ", size: %u\n",
@@ -432,6 +463,7 @@ void check_ret_control_ins(ADDRINT read_addr, UINT32 read_size, CONTEXT* ctxt) {
 void check_nonret_control_ins(BOOL taken, ADDRINT target_addr) {
   target_addr = ADDR_MASK(target_addr);
   if(!fast_forward_count) {
+    branch_ctxt_pending = true;
     DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
               "Non Ret Control targetaddr=%" PRIx64 "\n",
               (uint64_t)target_addr);
@@ -471,6 +503,7 @@ void check_nonret_control_mem_target(BOOL taken, ADDRINT addr, UINT32 ld_size) {
 }
 
 void handle_scarab_marker(ADDRINT op) {
+  branch_ctxt_pending = true;  // markers must not be replayed
   switch(op) {
     case SCARAB_START:
       fast_forward_to_pin_start = (fast_forward_count = 0);
@@ -32,6 +32,8 @@ void process_syscall(ADDRINT ip, ADDRINT num, ADDRINT arg0, ADDRINT arg1,
 
 void save_context(CONTEXT* ctxt);
 
+void save_sparse_context(CONTEXT* ctxt);
+
 void check_if_region_written_to(ADDRINT write_addr);
 
 void save_mem(ADDRINT write_addr, UINT32 write_size, UINT write_index);
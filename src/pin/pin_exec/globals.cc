@@ -28,6 +28,8 @@ Address_Tracker instrumented_rip_tracker;
 CirBuf<ProcState, checkpoints_init_capacity> checkpoints =
   CirBuf<ProcState, checkpoints_init_capacity>();
 
+Undo_Log undo_log = Undo_Log(undo_log_init_capacity);
+
 UINT64 uid_ctr = 0;
 UINT64 dbg_print_start_uid;
 UINT64 dbg_print_end_uid;
@@ -37,6 +39,8 @@ CONTEXT last_ctxt;
 ADDRINT next_eip;
 
 Client*                   scarab;
+SharedMemChannel*         scarab_shm        = NULL;
+OpEncoder*                scarab_op_encoder = NULL;
 ScarabOpBuffer_type       scarab_op_buffer;
 compressed_op             op_mailbox;
 bool                      op_mailbox_full           = false;
@@ -65,6 +69,11 @@ bool              excp_rewind_msg = false;
 bool              found_syscall   = false;
 bool              excp_ff         = false;
 
+// Sparse checkpoints
+bool     branch_ctxt_pending   = false;
+bool     next_ctxt_pending     = false;
+uint32_t insts_since_ctxt_save = 0;
+
 // TODO_b: this name could be better?
 bool     fast_forward_to_pin_start = false;
 uint64_t total_ff_count            = 0;
@@ -76,4 +85,6 @@ int64_t  orig_hyper_fast_forward_count;
 // Commandline arguments
 bool     heartbeat_enabled;
 uint32_t max_buffer_size;
-uint64_t start_rip;
\ No newline at end of file
+uint64_t start_rip;
+bool     sparse_checkpoints;
+uint32_t sparse_checkpoint_interval;
@@ -34,6 +34,8 @@
 #undef WARNING
 
 #include "../pin_lib/message_queue_interface_lib.h"
+#include "../pin_lib/op_codec.h"
+#include "../pin_lib/shared_mem_channel.h"
 #include "read_mem_map.h"
 #include "utils.h"
 
@@ -45,6 +47,9 @@ extern Address_Tracker instrumented_rip_tracker;
 const int checkpoints_init_capacity = 512;
 extern CirBuf<ProcState, checkpoints_init_capacity> checkpoints;
 
+const UINT64 undo_log_init_capacity = 64 * 1024;
+extern Undo_Log undo_log;
+
 extern UINT64 uid_ctr;
 extern UINT64 dbg_print_start_uid;
 extern UINT64 dbg_print_end_uid;
@@ -54,6 +59,8 @@ extern CONTEXT last_ctxt;
 extern ADDRINT next_eip;
 
 extern Client*                   scarab;
+extern SharedMemChannel*         scarab_shm;
+extern OpEncoder*                scarab_op_encoder;
 extern ScarabOpBuffer_type       scarab_op_buffer;
 extern compressed_op             op_mailbox;
 extern bool                      op_mailbox_full;
@@ -82,6 +89,11 @@ extern bool              excp_rewind_msg;
 extern bool              found_syscall;
 extern bool              excp_ff;
 
+// Sparse checkpoints
+extern bool     branch_ctxt_pending;  // the instruction being processed is a branch
+extern bool     next_ctxt_pending;    // the next instruction must save its context
+extern uint32_t insts_since_ctxt_save;
+
 // TODO_b: this name could be better?
 extern bool     fast_forward_to_pin_start;
 extern uint64_t total_ff_count;
@@ -94,6 +106,8 @@ extern int64_t  orig_hyper_fast_forward_count;
 extern bool     heartbeat_enabled;
 extern uint32_t max_buffer_size;
 extern uint64_t start_rip;
+extern bool     sparse_checkpoints;
+extern uint32_t sparse_checkpoint_interval;
 
 
 #endif  // PIN_EXEC_GLOBALS_H__
\ No newline at end of file
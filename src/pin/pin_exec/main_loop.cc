@@ -26,15 +26,26 @@
 #include "../pin_lib/decoder.h"
 
 namespace {
+Undo_Page_Shadow undo_shadow;
+
+// Stages the stores of undo_state for the next flush_undo_mem(). Checkpoints
+// are undone youngest first, so the shadow keeps the oldest value of every
+// byte and memory is written once per dirty run, not once per store.
 void undo_mem(const ProcState& undo_state) {
   for(uint i = 0; i < undo_state.num_mem_state; i++) {
-    void*  write_addr = (void*)undo_state.mem_state_list[i].mem_addr;
-    UINT32 write_size = undo_state.mem_state_list[i].mem_size;
-    void*  prev_data  = undo_state.mem_state_list[i].mem_data_ptr;
-    PIN_SafeCopy(write_addr, prev_data, write_size);
+    const MemState& mem_state = undo_state.mem_state_list[i];
+    undo_shadow.add(mem_state.mem_addr, undo_log.data(mem_state.log_pos),
+                    mem_state.mem_size);
   }
 }
 
+void flush_undo_mem() { undo_shadow.flush(); }
+
+void squash_tail_checkpoint() {
+  undo_log.pop_to(checkpoints.get_tail().undo_log_pos);
+  checkpoints.remove_from_cir_buf_tail();
+}
+
 void recover_to_past_checkpoint(UINT64 uid, bool is_redirect_recover,
                                 bool enter_ff) {
   INT64 idx = checkpoints.get_tail_index();
@@ -51,19 +62,35 @@ void recover_to_past_checkpoint(UINT64 uid, bool is_redirect_recover,
       on_wrongpath_nop_mode = checkpoints[idx].wrongpath_nop_mode;
       generate_dummy_nops   = (generate_dummy_nops && on_wrongpath_nop_mode);
       if(is_redirect_recover) {
+        flush_undo_mem();
         return;
       } else {
         undo_mem(checkpoints[idx]);
+
+        // A sparse checkpoint resumes at the nearest older context. The
+        // instructions in between keep their entries and are replayed
+        // without being sent to scarab.
+        UINT64 replay_insts = 0;
+        while(!checkpoints[idx].has_ctxt) {
+          ASSERTM(0, idx > checkpoints.get_head_index(),
+                  "No context to replay uid %" PRIu64 " from.\n", uid);
+          idx--;
+          undo_mem(checkpoints[idx]);
+          replay_insts++;
+        }
         PIN_SaveContext(&(checkpoints[idx].ctxt), &last_ctxt);
+        flush_undo_mem();
 
         if(!on_wrongpath_nop_mode) {
           if(enter_ff) {
             excp_ff = true;
-            fast_forward_count += 2;
+            fast_forward_count += 2 + replay_insts;
             // pin skips (ffc - 1) instructions
           } else {
-            idx = checkpoints.remove_from_cir_buf_tail();
+            squash_tail_checkpoint();
+            fast_forward_count += replay_insts ? replay_insts + 1 : 0;
           }
+          next_ctxt_pending = true;
           PIN_ExecuteAt(&last_ctxt);
           ASSERTM(0, false, "PIN_ExecuteAt did not redirect execution.\n");
         } else {
@@ -81,10 +108,15 @@ void recover_to_past_checkpoint(UINT64 uid, bool is_redirect_recover,
     undo_mem(checkpoints[idx]);
 
     if(is_redirect_recover && (checkpoints[idx].uid == (uid + 1))) {
+      ASSERTM(0, checkpoints[idx].has_ctxt,
+              "Redirect after uid %" PRIu64
+              ", which is not a branch, needs -sparse_checkpoints 0.\n",
+              uid);
       PIN_SaveContext(&(checkpoints[idx].ctxt), &last_ctxt);
     }
 
-    idx = checkpoints.remove_from_cir_buf_tail();
+    squash_tail_checkpoint();
+    idx = checkpoints.get_tail_index();
   }
   ASSERTM(0, false, "Checkpoint %" PRIu64 " not found. \n", uid);
 }
@@ -121,9 +153,12 @@ void retire_older_checkpoints(UINT64 uid) {
       ASSERTM(0, !checkpoints[idx].wrongpath,
               "Tried to retire wrongpath op %" PRIu64 ".\n", uid);
       if(checkpoints[idx].unretireable_instruction) {
-        ADDRINT eip;
-        PIN_GetContextRegval(&(checkpoints[idx].ctxt), REG_INST_PTR,
-                             (UINT8*)&eip);
+        // without a context, report the fall-through address instead
+        ADDRINT eip = checkpoints[idx].wpnm_eip;
+        if(checkpoints[idx].has_ctxt) {
+          PIN_GetContextRegval(&(checkpoints[idx].ctxt), REG_INST_PTR,
+                               (UINT8*)&eip);
+        }
         ASSERTM(0, false,
                 "Exception by program caused at address 0x%" PRIx64 "\n",
                 (uint64_t)eip);
@@ -136,6 +171,8 @@ void retire_older_checkpoints(UINT64 uid) {
       break;
     }
   }
+  undo_log.retire_to(checkpoints.empty() ? undo_log.get_tail_pos() :
+                                           checkpoints[idx].undo_log_pos);
   ASSERTM(0, found_uid, "Checkpoint %" PRIu64 " not found. \n", uid);
 }
 
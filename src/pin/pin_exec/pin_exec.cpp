@@ -25,6 +25,7 @@
 #include <iostream>
 #include <signal.h>
 #include <syscall.h>
+#include <unistd.h>
 #include <unordered_map>
 
 #undef UNUSED
@@ -62,6 +63,11 @@ KNOB<string> KnobSocketPath(KNOB_MODE_WRITEONCE, "pintool", "socket_path",
 KNOB<UINT32> KnobCoreId(KNOB_MODE_WRITEONCE, "pintool", "core_id", "0",
                         "The ID of the Scarab core to connect to");
 
+KNOB<INT32>  KnobReadyFd(
+  KNOB_MODE_WRITEONCE, "pintool", "ready_fd", "-1",
+  "Inherited file descriptor to write the core ID to once connected to "
+  "Scarab, then close (used by scarab_launch.py)");
+
 KNOB<UINT32> KnobMaxBufferSize(
   KNOB_MODE_WRITEONCE, "pintool", "max_buffer_size", "8",
   "pintool buffers up to (max_buffer_size-2) instructions for sending");
@@ -87,6 +93,13 @@ KNOB<UINT64> KnobDebugPrintEndUid(KNOB_MODE_WRITEONCE, "pintool",
                                   "Stop printing debug prints after this UID");
 KNOB<UINT64> KnobStartRip(KNOB_MODE_WRITEONCE, "pintool", "rip", "0",
                           "the starting rip of the program");
+KNOB<bool>   KnobSparseCheckpoints(
+  KNOB_MODE_WRITEONCE, "pintool", "sparse_checkpoints", "false",
+  "Save the full context only at branches and other recovery points, and "
+  "recover other instructions by replaying from the nearest one");
+KNOB<UINT32> KnobSparseCheckpointInterval(
+  KNOB_MODE_WRITEONCE, "pintool", "sparse_checkpoint_interval", "64",
+  "With sparse_checkpoints, the most instructions between two full contexts");
 
 /* ===================================================================== */
 /* ===================================================================== */
@@ -281,6 +294,9 @@ int main(int argc, char* argv[]) {
   heartbeat_enabled = KnobHeartbeatEnabled.Value();
   max_buffer_size   = KnobMaxBufferSize.Value();
 
+  sparse_checkpoints         = KnobSparseCheckpoints.Value();
+  sparse_checkpoint_interval = KnobSparseCheckpointInterval.Value();
+
   fast_forward_count = KnobFastForwardCount.Value();
   fast_forward_to_pin_start =
     (fast_forward_count = KnobFastForwardToStartInst.Value());
@@ -326,6 +342,16 @@ int main(int argc, char* argv[]) {
 
   scarab = new Client(KnobSocketPath, KnobCoreId);
 
+  if(KnobReadyFd.Value() >= 0) {
+    UINT32 core_id = KnobCoreId.Value();
+    if(write(KnobReadyFd.Value(), &core_id, sizeof(core_id)) !=
+       sizeof(core_id)) {
+      cerr << "Could not signal readiness on fd " << KnobReadyFd.Value()
+           << endl;
+    }
+    close(KnobReadyFd.Value());
+  }
+
   // Start the program, never returns
   PIN_StartProgram();
   return 0;
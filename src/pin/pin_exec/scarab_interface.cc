@@ -26,35 +26,88 @@ Scarab_To_Pin_Msg get_scarab_cmd() {
 
   DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
             "START: Receiving from Scarab\n");
-  cmd = scarab->receive<Scarab_To_Pin_Msg>();
+  do {
+    if(scarab_shm)
+      cmd = scarab_shm->receive_cmd();
+    else
+      cmd = scarab->receive<Scarab_To_Pin_Msg>();
+    if(cmd.type == FE_SHM_ATTACH)
+      attach_scarab_shm(cmd);
+    else if(cmd.type == FE_COMPACT_OPS)
+      enable_compact_ops();
+  } while(cmd.type == FE_SHM_ATTACH || cmd.type == FE_COMPACT_OPS);
   DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
             "END: %d Received from Scarab\n", cmd.type);
 
   return cmd;
 }
 
+void attach_scarab_shm(const Scarab_To_Pin_Msg& cmd) {
+  // Leave room for the op, mailbox op and sentinel that can be inserted
+  // after scarab_buffer_full() last returned false
+  uint32_t          op_capacity = max_buffer_size + 4;
+  SharedMemChannel* channel     = new SharedMemChannel();
+  if(!channel->create(SharedMemChannel::path(cmd.inst_uid, cmd.inst_addr),
+                      op_capacity, cmd.inst_uid)) {
+    delete channel;
+    scarab->send(Message<uint32_t>(0));
+    return;
+  }
+
+  // Ops gathered before the switch move to the channel
+  for(const compressed_op& cop : scarab_op_buffer)
+    channel->push_op(cop);
+  scarab_op_buffer.clear();
+  scarab->send(Message<uint32_t>(op_capacity));
+  scarab_shm = channel;
+}
+
+// Only asked for at setup, before any op buffer was sent
+void enable_compact_ops() {
+  if(!scarab_op_encoder)
+    scarab_op_encoder = new OpEncoder();
+  scarab->send(Message<uint32_t>(1));
+}
+
 void insert_scarab_op_in_buffer(compressed_op& cop) {
-  scarab_op_buffer.push_back(cop);
+  if(scarab_shm)
+    scarab_shm->push_op(cop);
+  else
+    scarab_op_buffer.push_back(cop);
 }
 
 bool scarab_buffer_full() {
-  return scarab_op_buffer.size() > (max_buffer_size - 2);
+  uint32_t size = scarab_shm ? scarab_shm->num_ops() : scarab_op_buffer.size();
+  return size > (max_buffer_size - 2);
   // Two spots are always reserved in the buffer just in case the
   // exit syscall and sentinel nullop are
   // the last two elements of a packet sent to Scarab.
 }
 
 void scarab_send_buffer() {
-  Message<ScarabOpBuffer_type> message = scarab_op_buffer;
+  if(scarab_shm) {
+    scarab_shm->publish_ops();
+    return;
+  }
   DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
             "START: Sending message to Scarab.\n");
-  scarab->send(message);
+  if(scarab_op_encoder) {
+    std::vector<uint8_t> bytes;
+    bytes.reserve(scarab_op_buffer.size() * OP_CODEC_MAX_ENCODED_SIZE);
+    for(const compressed_op& cop : scarab_op_buffer)
+      scarab_op_encoder->encode(cop, &bytes);
+    scarab->send_elements(bytes);
+  } else {
+    scarab->send_elements(scarab_op_buffer);
+  }
   DBG_PRINT(uid_ctr, dbg_print_start_uid, dbg_print_end_uid,
             "END: Sending message to Scarab.\n");
   scarab_op_buffer.clear();
 }
 
 void scarab_clear_all_buffers() {
+  if(scarab_shm)
+    scarab_shm->clear_ops();
   scarab_op_buffer.clear();
   op_mailbox_full = false;
 }
@@ -27,6 +27,8 @@
 #include "../pin_lib/pin_scarab_common_lib.h"
 
 Scarab_To_Pin_Msg get_scarab_cmd();
+void              attach_scarab_shm(const Scarab_To_Pin_Msg& cmd);
+void              enable_compact_ops();
 void              insert_scarab_op_in_buffer(compressed_op& cop);
 bool              scarab_buffer_full();
 void              scarab_send_buffer();
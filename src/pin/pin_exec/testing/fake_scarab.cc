@@ -161,8 +161,7 @@ void Fake_Scarab::refill_op_buffer() {
   msg.inst_uid  = 0;
 
   server_communicator_->send(0, Message<Scarab_To_Pin_Msg>(msg));
-  op_buffer_ = server_communicator_->receive<ScarabOpBuffer_type>(
-    /*proc_id=*/0);
+  server_communicator_->receive_into(/*proc_id=*/0, &op_buffer_);
 }
 
 void Fake_Scarab::retire(uint64_t inst_uid) {
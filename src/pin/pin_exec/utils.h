@@ -22,9 +22,12 @@
 #ifndef PIN_EXEC_UTILS_H__
 #define PIN_EXEC_UTILS_H__
 
+#include <algorithm>
 #include <cinttypes>
 #include <stdio.h>
+#include <string.h>
 #include <unordered_map>
+#include <vector>
 
 #undef UNUSED
 #undef WARNING
@@ -66,36 +69,150 @@
     }                                                                       \
   } while(0)
 
+// Bytes overwritten by one store. The old bytes live in undo_log at log_pos.
 struct MemState {
   ADDRINT mem_addr;
   UINT32  mem_size;
-  VOID*   mem_data_ptr;
+  UINT64  log_pos;
+};
 
-  MemState() : mem_size(0), mem_data_ptr(NULL) {}
+// Pooled byte arena for the MemState undo bytes of all live checkpoints.
+// Positions grow monotonically: checkpoints are retired from the head and
+// squashed from the tail, so the live bytes are always one contiguous range
+// [head_pos, tail_pos) of the ring. One store's bytes never wrap.
+class Undo_Log {
+  UINT8* buf;
+  UINT64 capacity;
+  UINT64 head_pos = 0;
+  UINT64 tail_pos = 0;
 
-  void resize(UINT32 new_mem_size) {
-    // we need to free the old mem_data_ptr if we need to reallocate a longer
-    // one
-    if(new_mem_size > mem_size) {
-      if(mem_data_ptr) {
-        free(mem_data_ptr);
-      }
+  void double_capacity() {
+    UINT64 doubled_capacity = capacity * 2;
+    UINT8* doubled_buf      = (UINT8*)malloc(doubled_capacity);
+    ASSERTM(0, NULL != doubled_buf, "malloc for undo log failed\n");
+
+    // live bytes keep their positions; capacity is a power of two multiple,
+    // so no chunk crosses the end of either ring
+    for(UINT64 pos = head_pos; pos < tail_pos;) {
+      UINT64 chunk = std::min(tail_pos - pos, capacity - pos % capacity);
+      memcpy(doubled_buf + pos % doubled_capacity, buf + pos % capacity,
+             chunk);
+      pos += chunk;
+    }
+
+    free(buf);
+    buf      = doubled_buf;
+    capacity = doubled_capacity;
+  }
 
-      mem_data_ptr = malloc(new_mem_size);
+ public:
+  Undo_Log(UINT64 init_capacity) : capacity(init_capacity) {
+    buf = (UINT8*)malloc(capacity);
+    ASSERTM(0, NULL != buf, "initial malloc for undo log failed\n");
+  }
+
+  UINT64 get_tail_pos() const { return tail_pos; }
+
+  // Reserves size contiguous bytes at the tail and returns their position.
+  UINT64 alloc(UINT32 size) {
+    while(true) {
+      UINT64 pos = tail_pos;
+      if(pos % capacity + size > capacity) {
+        pos += capacity - pos % capacity;
+      }
+      if(pos + size - head_pos <= capacity) {
+        tail_pos = pos + size;
+        return pos;
+      }
+      double_capacity();
     }
   }
 
-  void init(ADDRINT _mem_addr, UINT32 _mem_size) {
-    resize(_mem_size);
+  UINT8* data(UINT64 pos) { return buf + pos % capacity; }
+
+  // Drops everything at or after pos (squashed checkpoints).
+  void pop_to(UINT64 pos) { tail_pos = pos; }
+
+  // Drops everything before pos (retired checkpoints).
+  void retire_to(UINT64 pos) { head_pos = pos; }
+};
+
+// Collects the undo bytes of a recovery page by page so that every dirty
+// byte is written back once, however many squashed stores touched it.
+// States must be added youngest first: the oldest saved value wins.
+class Undo_Page_Shadow {
+  static const UINT64 PAGE_BYTES = 4096;
+  static const UINT64 PAGE_WORDS = PAGE_BYTES / 64;
+
+  struct Page {
+    ADDRINT base;
+    UINT64  valid[PAGE_WORDS];
+    UINT8   data[PAGE_BYTES];
+  };
+
+  std::unordered_map<ADDRINT, Page*> page_map;
+  std::vector<Page*>                 pages;  // pooled across recoveries
+  UINT                               num_pages = 0;
+
+  Page* get_page(ADDRINT base) {
+    auto it = page_map.find(base);
+    if(it != page_map.end()) {
+      return it->second;
+    }
+    if(num_pages == pages.size()) {
+      pages.push_back((Page*)calloc(1, sizeof(Page)));
+      ASSERTM(0, NULL != pages.back(), "calloc for undo page failed\n");
+    }
+    Page* page = pages[num_pages++];
+    page->base = base;
+    page_map.insert({base, page});
+    return page;
+  }
 
-    mem_addr = _mem_addr;
-    mem_size = _mem_size;
+ public:
+  void add(ADDRINT addr, const UINT8* bytes, UINT32 size) {
+    while(size) {
+      ADDRINT base   = addr & ~(PAGE_BYTES - 1);
+      UINT64  offset = addr - base;
+      UINT32  chunk  = std::min((UINT64)size, PAGE_BYTES - offset);
+      Page*   page   = get_page(base);
+      memcpy(page->data + offset, bytes, chunk);
+      for(UINT64 i = offset; i < offset + chunk; i++) {
+        page->valid[i / 64] |= 1ULL << (i % 64);
+      }
+      addr += chunk;
+      bytes += chunk;
+      size -= chunk;
+    }
   }
 
-  ~MemState() {
-    if(mem_data_ptr) {
-      free(mem_data_ptr);
+  // Writes every collected run back to memory and empties the shadow.
+  void flush() {
+    for(UINT p = 0; p < num_pages; p++) {
+      Page*  page  = pages[p];
+      UINT64 start = 0;
+      while(start < PAGE_BYTES) {
+        if(!page->valid[start / 64]) {
+          start = (start / 64 + 1) * 64;
+          continue;
+        }
+        if(!(page->valid[start / 64] & (1ULL << (start % 64)))) {
+          start++;
+          continue;
+        }
+        UINT64 end = start;
+        while(end < PAGE_BYTES &&
+              (page->valid[end / 64] & (1ULL << (end % 64)))) {
+          end++;
+        }
+        PIN_SafeCopy((void*)(page->base + start), page->data + start,
+                     end - start);
+        start = end;
+      }
+      memset(page->valid, 0, sizeof(page->valid));
     }
+    page_map.clear();
+    num_pages = 0;
   }
 };
 
@@ -103,28 +220,34 @@ struct ProcState {
   UINT64    uid;
   MemState* mem_state_list = NULL;
   UINT      num_mem_state;
+  UINT      mem_state_capacity;
+  UINT64    undo_log_pos;  // undo_log tail when this checkpoint was taken
   CONTEXT   ctxt;
+  bool      has_ctxt;  // false for sparse checkpoints, see save_sparse_context
   bool      unretireable_instruction;
   bool      wrongpath;
   bool      wrongpath_nop_mode;
   ADDRINT   wpnm_eip;
 
-  ProcState() : mem_state_list(NULL), num_mem_state(0) {}
+  ProcState() : mem_state_list(NULL), num_mem_state(0), mem_state_capacity(0) {}
 
   void init(UINT64 _uid, bool _u_i, bool _wrongpath, bool _wrongpath_nop_mode,
-            ADDRINT _wpnm_eip, UINT _num_mem_state) {
+            ADDRINT _wpnm_eip, UINT _num_mem_state, UINT64 _undo_log_pos) {
     uid                      = _uid;
+    has_ctxt                 = false;
     unretireable_instruction = _u_i;
     wrongpath                = _wrongpath;
     wrongpath_nop_mode       = _wrongpath_nop_mode;
     wpnm_eip                 = _wpnm_eip;
+    undo_log_pos             = _undo_log_pos;
 
-    if(_num_mem_state > num_mem_state) {
+    if(_num_mem_state > mem_state_capacity) {
       if(NULL != mem_state_list) {
         free(mem_state_list);
       }
 
       mem_state_list = (MemState*)malloc(_num_mem_state * sizeof(MemState));
+      mem_state_capacity = _num_mem_state;
     }
 
     num_mem_state = _num_mem_state;
@@ -47,7 +47,7 @@ static ctype_pin_inst  tmp_inst_info;
 /************************** Data Type Definitions *****************************/
 
 // Globals used for communication between analysis functions
-uint32_t       glb_opcode, glb_actually_taken;
+uint32_t       glb_actually_taken;
 deque<ADDRINT> glb_ld_vaddrs, glb_st_vaddrs;
 
 std::ostream*                                    glb_err_ostream;
@@ -62,15 +62,16 @@ ctype_pin_inst* get_inst_info_obj(const INS& ins);
 
 void insert_analysis_functions(ctype_pin_inst* info, const INS& ins);
 void print_err_if_invalid(ctype_pin_inst* info, const INS& ins);
+static bool uses_x87_stack_regs(const ctype_pin_inst* info);
 
-void get_opcode(UINT32 opcode);
 void get_gather_scatter_eas(bool is_gather, CONTEXT* ctxt,
                             PIN_MULTI_MEM_ACCESS_INFO* mem_access_info);
 void get_ld_ea(ADDRINT addr);
 void get_ld_ea2(ADDRINT addr1, ADDRINT addr2);
 void get_st_ea(ADDRINT addr);
 void get_branch_dir(bool taken);
-void create_compressed_op(ADDRINT iaddr);
+void create_compressed_op(ADDRINT iaddr, ctype_pin_inst* info, UINT32 opcode,
+                          bool translate_x87_regs);
 
 void update_gather_scatter_num_ld_or_st(const ADDRINT                   iaddr,
                                         const gather_scatter_info::type type,
@@ -84,9 +85,6 @@ std::vector<PIN_MEM_ACCESS_INFO> compute_mem_access_infos(
   const CONTEXT* ctxt, gather_scatter_info* info);
 ADDRDELTA compute_base_reg_addr_contribution(const CONTEXT*       ctxt,
                                              gather_scatter_info* info);
-ADDRDELTA compute_base_index_addr_contribution(
-  const PIN_REGISTER& vector_index_reg_val, const UINT32 lane_id,
-  gather_scatter_info* info);
 PIN_MEMOP_ENUM type_to_PIN_MEMOP_ENUM(gather_scatter_info* info);
 bool extract_mask_on(const PIN_REGISTER& mask_reg_val_buf, const UINT32 lane_id,
                      gather_scatter_info* info);
@@ -144,23 +142,31 @@ void pin_decoder_print_unknown_opcodes() {
 
 /*************************** Private Functions  *******************************/
 ctype_pin_inst* get_inst_info_obj(const INS& ins) {
-  ctype_pin_inst* info = (ctype_pin_inst*)calloc(1, sizeof(ctype_pin_inst));
-  inst_info_map_p lp   = inst_info_storage.find(INS_Address(ins));
-  if(lp == inst_info_storage.end()) {
-    inst_info_storage[INS_Address(ins)] = info;
-  } else {
-    // TODO_b: should we free the existing ctype_pin_inst at
-    // inst_info_storage[INS_Address(ins)]?
+  inst_info_map_p lp = inst_info_storage.find(INS_Address(ins));
+  if(lp != inst_info_storage.end()) {
+    // the address is being re-instrumented (e.g. after a code cache flush):
+    // decode it again into the existing object instead of leaking a new one
+    memset(lp->second, 0, sizeof(ctype_pin_inst));
+    return lp->second;
   }
+  ctype_pin_inst* info = (ctype_pin_inst*)calloc(1, sizeof(ctype_pin_inst));
+  inst_info_storage[INS_Address(ins)] = info;
   return info;
 }
 
-void insert_analysis_functions(ctype_pin_inst* info, const INS& ins) {
-  if(Knob_translate_x87_regs.Value()) {
-    INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)get_opcode, IARG_UINT32,
-                   INS_Opcode(ins), IARG_END);
+static bool uses_x87_stack_regs(const ctype_pin_inst* info) {
+  for(int i = 0; i < info->num_src_regs; ++i) {
+    if(is_x87_stack_reg(info->src_regs[i]))
+      return true;
+  }
+  for(int i = 0; i < info->num_dst_regs; ++i) {
+    if(is_x87_stack_reg(info->dst_regs[i]))
+      return true;
   }
+  return false;
+}
 
+void insert_analysis_functions(ctype_pin_inst* info, const INS& ins) {
   if(INS_IsVgather(ins) || INS_IsVscatter(ins)) {
     INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)get_gather_scatter_eas,
                    IARG_BOOL, INS_IsVgather(ins), IARG_CONTEXT,
@@ -187,31 +193,37 @@ void insert_analysis_functions(ctype_pin_inst* info, const INS& ins) {
                    IARG_BRANCH_TAKEN, IARG_END);
   }
 
+  // The decoded instruction and whether its regs need x87 translation are
+  // known statically, so hand them to the analysis routine directly instead of
+  // looking them up on every dynamic instance.
   INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR)create_compressed_op,
-                 IARG_INST_PTR, IARG_END);
+                 IARG_INST_PTR, IARG_PTR, info, IARG_UINT32, INS_Opcode(ins),
+                 IARG_BOOL, uses_x87_stack_regs(info), IARG_END);
 }
 
 // int64_t heartbeat = 0;
-void create_compressed_op(ADDRINT iaddr) {
+void create_compressed_op(ADDRINT iaddr, ctype_pin_inst* info, UINT32 opcode,
+                          bool translate_x87_regs) {
   if(!fast_forward_count) {
-    assert(inst_info_storage.count(iaddr) == 1);
-    filled_inst_info = inst_info_storage[iaddr];
+    filled_inst_info = info;
     if(glb_translate_x87_regs) {
-      // copy ctype_pin_inst to avoid clobbering it
-      memcpy(&tmp_inst_info, filled_inst_info, sizeof(ctype_pin_inst));
-      filled_inst_info = &tmp_inst_info;
-      // translate registers (no need to translate agen, since they won't be
-      // FP)
-      for(int i = 0; i < filled_inst_info->num_src_regs; ++i) {
-        filled_inst_info->src_regs[i] = absolute_reg(
-          filled_inst_info->src_regs[i], glb_opcode, false);
-      }
-      for(int i = 0; i < filled_inst_info->num_dst_regs; ++i) {
-        filled_inst_info->dst_regs[i] = absolute_reg(
-          filled_inst_info->dst_regs[i], glb_opcode, true);
+      if(translate_x87_regs) {
+        // copy ctype_pin_inst to avoid clobbering it
+        memcpy(&tmp_inst_info, filled_inst_info, sizeof(ctype_pin_inst));
+        filled_inst_info = &tmp_inst_info;
+        // translate registers (no need to translate agen, since they won't be
+        // FP)
+        for(int i = 0; i < filled_inst_info->num_src_regs; ++i) {
+          filled_inst_info->src_regs[i] = absolute_reg(
+            filled_inst_info->src_regs[i], opcode, false);
+        }
+        for(int i = 0; i < filled_inst_info->num_dst_regs; ++i) {
+          filled_inst_info->dst_regs[i] = absolute_reg(
+            filled_inst_info->dst_regs[i], opcode, true);
+        }
       }
       // update x87 state
-      update_x87_stack_state(glb_opcode);
+      update_x87_stack_state(opcode);
     }
 
     uint num_lds = glb_ld_vaddrs.size();
@@ -238,7 +250,6 @@ void create_compressed_op(ADDRINT iaddr) {
 
     filled_inst_info->actually_taken = glb_actually_taken;
   }
-  glb_opcode = 0;
   glb_ld_vaddrs.clear();
   glb_st_vaddrs.clear();
   glb_actually_taken = 0;
@@ -283,10 +294,6 @@ void get_gather_scatter_eas(bool is_gather, CONTEXT* ctxt,
   }
 }
 
-void get_opcode(UINT32 opcode) {
-  glb_opcode = opcode;
-}
-
 void get_ld_ea(ADDRINT addr) {
   glb_ld_vaddrs.push_back(addr);
 }
@@ -392,15 +399,21 @@ vector<PIN_MEM_ACCESS_INFO> compute_mem_access_infos(
          reg_xed_to_pin_map.end());
   PIN_GetContextRegval(ctxt, reg_xed_to_pin_map[info->get_mask_reg()],
                        (UINT8*)&mask_reg_val_buf);
-  for(UINT32 lane_id = 0; lane_id < info->get_num_mem_ops(); lane_id++) {
-    ADDRDELTA index_val = compute_base_index_addr_contribution(
-      vector_index_reg_val_buf, lane_id, info);
-    ADDRINT final_addr = base_addr_contribution +
-                         (index_val * info->get_scale()) +
-                         info->get_displacement();
+
+  // all lane addresses at once (vectorized where the host allows it)
+  UINT32   num_lanes = info->get_num_mem_ops();
+  uint64_t lane_addrs[16];
+  ASSERTX(num_lanes <= 16);
+  compute_gather_scatter_lane_addrs(
+    &vector_index_reg_val_buf, info->get_index_lane_width_bytes(), num_lanes,
+    base_addr_contribution + info->get_displacement(), info->get_scale(),
+    lane_addrs);
+
+  mem_access_infos.reserve(num_lanes);
+  for(UINT32 lane_id = 0; lane_id < num_lanes; lane_id++) {
     bool mask_on = extract_mask_on(mask_reg_val_buf, lane_id, info);
     PIN_MEM_ACCESS_INFO access_info = {
-      .memoryAddress = final_addr,
+      .memoryAddress = lane_addrs[lane_id],
       .memopType     = memop_type,
       .bytesAccessed = info->get_data_lane_width_bytes(),
       .maskOn        = mask_on};
@@ -433,24 +446,6 @@ ADDRDELTA compute_base_reg_addr_contribution(const CONTEXT*       ctxt,
   return base_addr_contribution;
 }
 
-ADDRDELTA compute_base_index_addr_contribution(
-  const PIN_REGISTER& vector_index_reg_val, const UINT32 lane_id,
-  gather_scatter_info* info) {
-  ADDRDELTA index_val;
-  switch(info->get_index_lane_width_bytes()) {
-    case 4:
-      index_val = vector_index_reg_val.s_dword[lane_id];
-      break;
-    case 8:
-      index_val = vector_index_reg_val.s_qword[lane_id];
-      break;
-    default:
-      ASSERTX(false);
-      break;
-  }
-  return index_val;
-}
-
 PIN_MEMOP_ENUM type_to_PIN_MEMOP_ENUM(gather_scatter_info* info) {
   switch(info->get_type()) {
     case gather_scatter_info::GATHER:
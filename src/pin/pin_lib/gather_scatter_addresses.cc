@@ -23,6 +23,10 @@
 #include <cassert>
 #include <iostream>
 #include <map>
+#include <string.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 // Global static instruction map just for scatter instructions
 scatter_info_map scatter_info_storage;
@@ -260,6 +264,56 @@ void finalize_scatter_info(const ADDRINT iaddr, ctype_pin_inst* info) {
   }
   }*/
 
+void compute_gather_scatter_lane_addrs(const void*    index_reg,
+                                       const uint32_t index_lane_width_bytes,
+                                       const uint32_t num_lanes,
+                                       const uint64_t base,
+                                       const uint32_t scale, uint64_t* addrs) {
+  assert(scale == 1 || scale == 2 || scale == 4 || scale == 8);
+  const int shift = __builtin_ctz(scale);
+  uint32_t  lane  = 0;
+  switch(index_lane_width_bytes) {
+    case 4: {
+      int32_t idx[16];
+      assert(num_lanes <= 16);
+      memcpy(idx, index_reg, num_lanes * sizeof(int32_t));
+#if defined(__AVX2__)
+      const __m256i vbase  = _mm256_set1_epi64x(base);
+      const __m128i vshift = _mm_cvtsi32_si128(shift);
+      for(; lane + 4 <= num_lanes; lane += 4) {
+        __m256i vidx = _mm256_cvtepi32_epi64(
+          _mm_loadu_si128((const __m128i*)&idx[lane]));
+        __m256i vaddr = _mm256_add_epi64(vbase, _mm256_sll_epi64(vidx, vshift));
+        _mm256_storeu_si256((__m256i*)&addrs[lane], vaddr);
+      }
+#endif
+      for(; lane < num_lanes; lane++)
+        addrs[lane] = base + ((uint64_t)(int64_t)idx[lane] << shift);
+      break;
+    }
+    case 8: {
+      int64_t idx[8];
+      assert(num_lanes <= 8);
+      memcpy(idx, index_reg, num_lanes * sizeof(int64_t));
+#if defined(__AVX2__)
+      const __m256i vbase  = _mm256_set1_epi64x(base);
+      const __m128i vshift = _mm_cvtsi32_si128(shift);
+      for(; lane + 4 <= num_lanes; lane += 4) {
+        __m256i vidx  = _mm256_loadu_si256((const __m256i*)&idx[lane]);
+        __m256i vaddr = _mm256_add_epi64(vbase, _mm256_sll_epi64(vidx, vshift));
+        _mm256_storeu_si256((__m256i*)&addrs[lane], vaddr);
+      }
+#endif
+      for(; lane < num_lanes; lane++)
+        addrs[lane] = base + ((uint64_t)idx[lane] << shift);
+      break;
+    }
+    default:
+      assert(false);
+      break;
+  }
+}
+
 bool gather_scatter_info::is_non_zero_and_powerof2(const uint32_t v) const {
   return v && ((v & (v - 1)) == 0);
 }
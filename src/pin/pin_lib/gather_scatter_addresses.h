@@ -110,6 +110,13 @@ void set_gather_scatter_memory_operand_info(const ADDRINT        iaddr,
                                             const bool operandReadOnly,
                                             const bool operandWritenOnly);
 void finalize_scatter_info(const ADDRINT iaddr, ctype_pin_inst* info);
+// addrs[i] = base + sign_extend(index lane i) * scale for the first num_lanes
+// lanes of the raw index register contents; scale must be 1, 2, 4 or 8
+void compute_gather_scatter_lane_addrs(const void*    index_reg,
+                                       const uint32_t index_lane_width_bytes,
+                                       const uint32_t num_lanes,
+                                       const uint64_t base,
+                                       const uint32_t scale, uint64_t* addrs);
 void init_reg_xed_to_pin_map();
 
 #endif  // __SCATTER_H__
@@ -120,14 +120,51 @@ void TCPSocket::send(SocketDescriptor         socket,
                     "TCPSocket Send did not send the correct number of bytes!")
 }
 
+void TCPSocket::send_iov(SocketDescriptor socket, struct iovec* iov,
+                         uint32_t iov_count, uint32_t num_bytes) {
+  uint32_t total_bytes_sent = 0;
+  int32_t  failure;
+  assertm(num_bytes <= RECEIVE_BUFFER_MAX_SIZE,
+          "Need to allocation more space in the send buffer");
+
+  while(total_bytes_sent < num_bytes) {
+    do {
+      failure = writev(socket, iov, iov_count);
+    } while(failure < 0 && (errno == EWOULDBLOCK || errno == EAGAIN));
+
+    CHECK_FOR_FAILURE(failure < 0, "Send Failed (send_iov)");
+    total_bytes_sent += failure;
+
+    // Skip what was written before retrying the rest
+    uint32_t bytes_left = failure;
+    while(iov_count > 0 && bytes_left >= iov->iov_len) {
+      bytes_left -= iov->iov_len;
+      ++iov;
+      --iov_count;
+    }
+    if(bytes_left > 0) {
+      iov->iov_base = (char*)iov->iov_base + bytes_left;
+      iov->iov_len -= bytes_left;
+    }
+  }
+}
+
 #if !defined(PIN_COMPILE) || defined(GTEST_COMPILE)
 
 std::vector<char> TCPSocket::scarab_receive(SocketDescriptor socket) {
-  char    buffer[RECEIVE_BUFFER_MAX_SIZE];
+  char     buffer[RECEIVE_BUFFER_MAX_SIZE];
+  uint32_t bytes_recv = scarab_receive_bytes(socket, buffer, sizeof(buffer));
+
+  std::vector<char> message(buffer, buffer + bytes_recv);
+  return message;
+}
+
+uint32_t TCPSocket::scarab_receive_bytes(SocketDescriptor socket, char* buffer,
+                                         uint32_t buffer_size) {
   int32_t bytes_recv;
 
   do {
-    bytes_recv = recv(socket, buffer, sizeof(buffer), 0);
+    bytes_recv = recv(socket, buffer, buffer_size, 0);
     CHECK_FOR_FAILURE(
       bytes_recv == 0,
       "Socket closed unepectedly on read. PIN process probably died.");
@@ -136,9 +173,7 @@ std::vector<char> TCPSocket::scarab_receive(SocketDescriptor socket) {
   } while(bytes_recv < 0 && (errno == EWOULDBLOCK || errno == EAGAIN));
 
   CHECK_FOR_FAILURE(bytes_recv < 0, "Receive Failed");
-
-  std::vector<char> message(buffer, buffer + bytes_recv);
-  return message;
+  return bytes_recv;
 }
 
 #endif
@@ -358,6 +393,32 @@ void Server::verify_and_assign_requested_client_ids(uint32_t numClients) {
   client_fds = temp_client_fds;
 }
 
+std::vector<uint32_t> Server::poll_clients(
+  const std::vector<uint32_t>& client_ids, int32_t timeout_ms) {
+  std::vector<struct pollfd> poll_fds(client_ids.size());
+  for(uint32_t i = 0; i < client_ids.size(); ++i) {
+    assertm(client_ids[i] < client_fds.size(),
+            "Attempting to poll an invalid client_id!");
+    poll_fds[i].fd      = client_fds[client_ids[i]];
+    poll_fds[i].events  = POLLIN;
+    poll_fds[i].revents = 0;
+  }
+
+  int32_t num_ready;
+  do {
+    num_ready = poll(poll_fds.data(), poll_fds.size(), timeout_ms);
+  } while(num_ready < 0 && errno == EINTR);
+  CHECK_FOR_FAILURE(num_ready < 0, "Poll Failed");
+
+  /* A hung up client is returned too, so that its receive reports it */
+  std::vector<uint32_t> ready_ids;
+  for(uint32_t i = 0; i < client_ids.size(); ++i) {
+    if(poll_fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+      ready_ids.push_back(client_ids[i]);
+  }
+  return ready_ids;
+}
+
 void Server::disconnect(uint32_t client_id) {
   assertm(client_id < client_fds.size(),
           "Attempting to disconnect from an invalid client_id!");
@@ -23,11 +23,13 @@
 #define __MESSAGE_QUEUE_INTERFACE_LIB_H__
 
 extern "C" {
+#include <poll.h>
 #include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <sys/un.h>
 }
 
@@ -256,9 +258,13 @@ class TCPSocket {
   std::string client_init_message;
 
   void send(SocketDescriptor socket, const std::vector<char>* msg);
+  void send_iov(SocketDescriptor socket, struct iovec* iov, uint32_t iov_count,
+                uint32_t num_bytes);
 
 #if !defined(PIN_COMPILE) || defined(GTEST_COMPILE)
   std::vector<char> scarab_receive(SocketDescriptor socket);
+  uint32_t          scarab_receive_bytes(SocketDescriptor socket, char* buffer,
+                                         uint32_t buffer_size);
 #endif
 
 #if defined(PIN_COMPILE) || defined(GTEST_COMPILE)
@@ -281,6 +287,21 @@ class TCPSocket {
   void send(SocketDescriptor socket, const Message<T>& m);
   template <typename T>
   Message<T> receive(SocketDescriptor socket);
+
+  /* Sends the elements straight from the container's storage with one
+   * writev, without building a Message. The receiver sees the same bytes as
+   * for a Message of the container. */
+  template <typename Container>
+  void send_elements(SocketDescriptor socket, const Container& elems);
+
+#if !defined(PIN_COMPILE) || defined(GTEST_COMPILE)
+  /* Receives a vector/deque message into the caller's container, replacing
+   * its contents. A vector is received into its own storage. */
+  template <typename T>
+  void receive_into(SocketDescriptor socket, std::vector<T>* elems);
+  template <typename T>
+  void receive_into(SocketDescriptor socket, std::deque<T>* elems);
+#endif
 };
 
 class Server : public TCPSocket {
@@ -307,8 +328,15 @@ class Server : public TCPSocket {
   void send(uint32_t id, const Message<T>& m);
   template <typename T>
   Message<T> receive(uint32_t id);
+  template <typename Container>
+  void       receive_into(uint32_t id, Container* elems);
   void       disconnect(uint32_t client_id);
   uint32_t   getNumClients() const { return client_fds.size(); }
+  /* Blocks until at least one of the client_ids has a message to receive (or
+   * timeout_ms passes, -1 waits forever) and returns those that do. Lets the
+   * caller send to every client first and take the replies as they arrive. */
+  std::vector<uint32_t> poll_clients(const std::vector<uint32_t>& client_ids,
+                                     int32_t timeout_ms = -1);
   void       wait_for_client_to_close(uint32_t client_id);
 };
 
@@ -330,6 +358,8 @@ class Client : public TCPSocket {
   void send(const Message<T>& m);
   template <typename T>
   Message<T> receive();
+  template <typename Container>
+  void       send_elements(const Container& elems);
   void       disconnect();
 
 #ifdef GTEST_COMPILE
@@ -348,6 +378,11 @@ Message<T> Server::receive(uint32_t id) {
   return TCPSocket::receive<T>(client_fds[id]);
 }
 
+template <typename Container>
+void Server::receive_into(uint32_t id, Container* elems) {
+  TCPSocket::receive_into(client_fds[id], elems);
+}
+
 template <typename T>
 void Client::send(const Message<T>& m) {
   TCPSocket::send(socket_fd, m);
@@ -358,6 +393,11 @@ Message<T> Client::receive() {
   return TCPSocket::receive<T>(socket_fd);
 }
 
+template <typename Container>
+void Client::send_elements(const Container& elems) {
+  TCPSocket::send_elements(socket_fd, elems);
+}
+
 #ifdef GTEST_COMPILE
 template <typename T>
 Message<T> Client::pin_receive() {
@@ -378,4 +418,48 @@ Message<T> TCPSocket::receive(SocketDescriptor socket) {
   return Message<T>(pin_receive(socket, sizeof(T)));
 #endif
 }
+
+template <typename Container>
+void TCPSocket::send_elements(SocketDescriptor socket, const Container& elems) {
+  typedef typename Container::value_type T;
+  uint32_t num_bytes = elems.size() * sizeof(T);
+  assertm(num_bytes <= MAX_PACKET_SIZE, "Scarab does not currently support "
+                                        "sending messages larger than "
+                                        "MAX_PACKET_SIZE.\n");
+
+  // One entry per contiguous run of elements (a deque is stored in blocks)
+  std::vector<struct iovec> iov;
+  for(const T& elem : elems) {
+    char* elem_ptr = (char*)&elem;
+    if(!iov.empty() &&
+       (char*)iov.back().iov_base + iov.back().iov_len == elem_ptr) {
+      iov.back().iov_len += sizeof(T);
+    } else {
+      struct iovec run = {elem_ptr, sizeof(T)};
+      iov.push_back(run);
+    }
+  }
+  send_iov(socket, iov.data(), iov.size(), num_bytes);
+}
+
+#if !defined(PIN_COMPILE) || defined(GTEST_COMPILE)
+template <typename T>
+void TCPSocket::receive_into(SocketDescriptor socket, std::vector<T>* elems) {
+  elems->resize(MAX_PACKET_SIZE / sizeof(T));
+  uint32_t num_bytes = scarab_receive_bytes(socket, (char*)elems->data(),
+                                            elems->size() * sizeof(T));
+  assertm(num_bytes % sizeof(T) == 0,
+          "Recieve type is not the same size as the send type");
+  elems->resize(num_bytes / sizeof(T));
+}
+
+template <typename T>
+void TCPSocket::receive_into(SocketDescriptor socket, std::deque<T>* elems) {
+  alignas(T) char buffer[MAX_PACKET_SIZE];
+  uint32_t num_bytes = scarab_receive_bytes(socket, buffer, sizeof(buffer));
+  assertm(num_bytes % sizeof(T) == 0,
+          "Recieve type is not the same size as the send type");
+  elems->assign((const T*)buffer, (const T*)(buffer + num_bytes));
+}
+#endif
 #endif
@@ -0,0 +1,318 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : op_codec.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  :
+ ***************************************************************************************/
+
+#include "op_codec.h"
+
+#include <string.h>
+
+// Unchanged bytes between two changed ones that are cheaper to resend than to
+// start a new run for
+#define OP_CODEC_MAX_GAP 2
+
+static void put_varint(std::vector<uint8_t>* out, uint64_t value) {
+  while(value >= 0x80) {
+    out->push_back((uint8_t)(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back((uint8_t)value);
+}
+
+static bool get_varint(const uint8_t** p, const uint8_t* end,
+                       uint64_t* value) {
+  *value = 0;
+  for(uint32_t shift = 0; *p < end && shift < 64; shift += 7) {
+    uint8_t byte = *(*p)++;
+    *value |= (uint64_t)(byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+static void put_zigzag(std::vector<uint8_t>* out, uint64_t delta) {
+  put_varint(out, (delta << 1) ^ (uint64_t)((int64_t)delta >> 63));
+}
+
+static bool get_zigzag(const uint8_t** p, const uint8_t* end, uint64_t* delta) {
+  uint64_t value;
+  if(!get_varint(p, end, &value))
+    return false;
+  *delta = (value >> 1) ^ (uint64_t)-(int64_t)(value & 1);
+  return true;
+}
+
+// Appends the (skip, length) runs in which cur differs from prev
+static void put_diff(const compressed_op& op, const compressed_op& old,
+                     std::vector<uint8_t>* out) {
+  const uint8_t* cur  = (const uint8_t*)&op;
+  const uint8_t* prev = (const uint8_t*)&old;
+  size_t         pos  = 0;  // end of the previous run
+  size_t         ii   = 0;
+  while(true) {
+    while(ii < sizeof(compressed_op) && cur[ii] == prev[ii])
+      ii++;
+    if(ii == sizeof(compressed_op))
+      break;
+    size_t run_end = ii + 1;
+    for(size_t jj = ii + 1;
+        jj < sizeof(compressed_op) && jj - run_end <= OP_CODEC_MAX_GAP; jj++) {
+      if(cur[jj] != prev[jj])
+        run_end = jj + 1;
+    }
+    put_varint(out, ii - pos);
+    put_varint(out, run_end - ii);
+    out->insert(out->end(), cur + ii, cur + run_end);
+    pos = ii = run_end;
+  }
+  put_varint(out, 0);
+  put_varint(out, 0);
+}
+
+// Applies the runs at *p to op
+static bool get_diff(const uint8_t** p, const uint8_t* end,
+                     compressed_op* op) {
+  uint8_t* bytes = (uint8_t*)op;
+  size_t   pos   = 0;
+  while(true) {
+    uint64_t skip, len;
+    if(!get_varint(p, end, &skip) || !get_varint(p, end, &len))
+      return false;
+    if(!len)
+      return !skip;
+    if(skip > sizeof(compressed_op) - pos ||
+       len > sizeof(compressed_op) - pos - skip || len > (size_t)(end - *p))
+      return false;
+    pos += skip;
+    memcpy(bytes + pos, *p, len);
+    *p += len;
+    pos += len;
+  }
+}
+
+/* What a block's op becomes when only its dynamic fields changed since old:
+ * the next inst_uid, the addresses and the branch outcome (ld, st, taken). */
+static void predict_bb_op(const compressed_op& old, uint64_t uid,
+                          const uint64_t* ld_vaddr, const uint64_t* st_vaddr,
+                          bool taken, compressed_op* op) {
+  *op          = old;
+  op->inst_uid = uid;
+  memcpy(op->ld_vaddr, ld_vaddr, old.num_ld * sizeof(uint64_t));
+  memcpy(op->st_vaddr, st_vaddr, old.num_st * sizeof(uint64_t));
+  if(old.cf_type) {
+    op->actually_taken        = taken;
+    op->instruction_next_addr = taken ? old.branch_target :
+                                        old.instruction_addr + old.size;
+  }
+}
+
+void OpEncoder::reset() {
+  ids.clear();
+  templates.clear();
+}
+
+void OpEncoder::encode(const compressed_op& op, std::vector<uint8_t>* out) {
+  uint32_t id;
+  auto     it = ids.find(op.instruction_addr);
+  if(it == ids.end()) {
+    id                       = templates.size();
+    ids[op.instruction_addr] = id;
+    templates.emplace_back();
+    memset(&templates.back(), 0, sizeof(compressed_op));
+  } else {
+    id = it->second;
+  }
+  put_varint(out, id);
+  put_diff(op, templates[id], out);
+  templates[id] = op;
+}
+
+void OpDecoder::reset() {
+  templates.clear();
+}
+
+size_t OpDecoder::decode(const uint8_t* data, size_t size, compressed_op* op) {
+  const uint8_t* p   = data;
+  const uint8_t* end = p + size;
+  uint64_t       id;
+  if(!get_varint(&p, end, &id) || id > templates.size())
+    return 0;
+
+  compressed_op next;
+  if(id == templates.size())
+    memset(&next, 0, sizeof(next));
+  else
+    next = templates[id];
+  if(!get_diff(&p, end, &next))
+    return 0;
+
+  if(id == templates.size())
+    templates.push_back(next);
+  else
+    templates[id] = next;
+  *op = next;
+  return p - data;
+}
+
+void BbEncoder::reset() {
+  ids.clear();
+  templates.clear();
+  last_uid = 0;
+}
+
+/* A record starts with (id << 1 | exact). A new id is followed by the block
+ * length and diffs against all-zero ops, an exact record by the address
+ * deltas of each op and a taken byte for a final control-flow op, any other
+ * record by a diff for each op. */
+void BbEncoder::encode(const compressed_op* ops, size_t num,
+                       std::vector<uint8_t>* out) {
+  size_t start = 0;
+  while(start < num) {
+    size_t len = 1;
+    while(start + len < num && !ops[start + len - 1].cf_type &&
+          len < OP_CODEC_MAX_BB_OPS)
+      len++;
+    const compressed_op* bb = &ops[start];
+
+    auto key = std::make_pair((uint64_t)bb[0].instruction_addr, (uint32_t)len);
+    auto it  = ids.find(key);
+    uint32_t id;
+    bool     exact = false;
+    if(it == ids.end()) {
+      id       = templates.size();
+      ids[key] = id;
+      templates.emplace_back(len);
+      memset(templates.back().data(), 0, len * sizeof(compressed_op));
+      put_varint(out, (uint64_t)id << 1);
+      put_varint(out, len);
+    } else {
+      id                                    = it->second;
+      const std::vector<compressed_op>& old = templates[id];
+      exact                                 = true;
+      for(size_t ii = 0; ii < len && exact; ii++) {
+        if(old[ii].num_ld > MAX_LD_NUM || old[ii].num_st > MAX_ST_NUM) {
+          exact = false;
+          break;
+        }
+        compressed_op predicted;
+        uint64_t      ld_vaddr[MAX_LD_NUM], st_vaddr[MAX_ST_NUM];
+        memcpy(ld_vaddr, bb[ii].ld_vaddr, sizeof(ld_vaddr));
+        memcpy(st_vaddr, bb[ii].st_vaddr, sizeof(st_vaddr));
+        predict_bb_op(old[ii], ii ? bb[ii - 1].inst_uid + 1 : last_uid + 1,
+                      ld_vaddr, st_vaddr, bb[ii].actually_taken, &predicted);
+        exact = !memcmp(&predicted, &bb[ii], sizeof(compressed_op));
+      }
+      put_varint(out, (uint64_t)id << 1 | exact);
+    }
+
+    std::vector<compressed_op>& old = templates[id];
+    for(size_t ii = 0; ii < len; ii++) {
+      if(exact) {
+        for(uint32_t ld = 0; ld < old[ii].num_ld; ld++)
+          put_zigzag(out, bb[ii].ld_vaddr[ld] - old[ii].ld_vaddr[ld]);
+        for(uint32_t st = 0; st < old[ii].num_st; st++)
+          put_zigzag(out, bb[ii].st_vaddr[st] - old[ii].st_vaddr[st]);
+        if(old[ii].cf_type)
+          out->push_back(bb[ii].actually_taken);
+      } else {
+        put_diff(bb[ii], old[ii], out);
+      }
+      old[ii] = bb[ii];
+    }
+    last_uid = bb[len - 1].inst_uid;
+    start += len;
+  }
+}
+
+void BbDecoder::reset() {
+  templates.clear();
+  last_uid = 0;
+}
+
+size_t BbDecoder::decode(const uint8_t* data, size_t size, compressed_op* ops,
+                         size_t capacity, size_t* num) {
+  const uint8_t* p   = data;
+  const uint8_t* end = p + size;
+  uint64_t       header, len;
+  if(!get_varint(&p, end, &header))
+    return 0;
+  uint64_t id    = header >> 1;
+  bool     exact = header & 1;
+  if(id > templates.size() || (id == templates.size() && exact))
+    return 0;
+
+  std::vector<compressed_op> fresh;
+  if(id == templates.size()) {
+    if(!get_varint(&p, end, &len) || !len || len > OP_CODEC_MAX_BB_OPS)
+      return 0;
+    fresh.resize(len);
+    memset(fresh.data(), 0, len * sizeof(compressed_op));
+  } else {
+    len = templates[id].size();
+  }
+  const std::vector<compressed_op>& old = fresh.empty() ? templates[id] : fresh;
+  if(len > capacity)
+    return 0;
+
+  for(size_t ii = 0; ii < len; ii++) {
+    if(exact) {
+      uint64_t ld_vaddr[MAX_LD_NUM], st_vaddr[MAX_ST_NUM], delta;
+      if(old[ii].num_ld > MAX_LD_NUM || old[ii].num_st > MAX_ST_NUM)
+        return 0;
+      for(uint32_t ld = 0; ld < old[ii].num_ld; ld++) {
+        if(!get_zigzag(&p, end, &delta))
+          return 0;
+        ld_vaddr[ld] = old[ii].ld_vaddr[ld] + delta;
+      }
+      for(uint32_t st = 0; st < old[ii].num_st; st++) {
+        if(!get_zigzag(&p, end, &delta))
+          return 0;
+        st_vaddr[st] = old[ii].st_vaddr[st] + delta;
+      }
+      bool taken = false;
+      if(old[ii].cf_type) {
+        if(p == end || *p > 1)
+          return 0;
+        taken = *p++;
+      }
+      predict_bb_op(old[ii], (ii ? ops[ii - 1].inst_uid : last_uid) + 1,
+                    ld_vaddr, st_vaddr, taken, &ops[ii]);
+    } else {
+      ops[ii] = old[ii];
+      if(!get_diff(&p, end, &ops[ii]))
+        return 0;
+    }
+  }
+
+  if(fresh.empty())
+    templates[id].assign(ops, ops + len);
+  else
+    templates.emplace_back(ops, ops + len);
+  last_uid = ops[len - 1].inst_uid;
+  *num     = len;
+  return p - data;
+}
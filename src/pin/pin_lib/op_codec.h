@@ -0,0 +1,115 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : op_codec.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Compact variable-length encoding of compressed_op streams.
+ *
+ *  Every op is encoded as a varint static id followed by the bytes in which it
+ *  differs from the last op encoded with the same id. Ids are handed out by
+ *  instruction address in order of first appearance (an id equal to the
+ *  number of ids seen so far introduces a new one, diffed against an all-zero
+ *  op), so the decoder rebuilds the encoder's table from the stream itself.
+ *  The static fields of an instruction therefore cost nothing after its first
+ *  instance, and the dynamic ones only cost the bytes that changed (usually
+ *  the low bytes of inst_uid and of the memory addresses).
+ *
+ *  The diff is a list of (unchanged bytes to skip, changed bytes) varint
+ *  pairs, each followed by the changed bytes, and ends with a pair whose
+ *  length is zero. Encoder and decoder are stateful: a stream has to be
+ *  decoded in order with a decoder that saw everything before it.
+ *
+ *  BbEncoder/BbDecoder work the same way one basic block at a time: a block
+ *  is a run of ops ending at a control-flow op (or at OP_CODEC_MAX_BB_OPS
+ *  ops), identified by its first address and length. When a block's ops
+ *  differ from its last instance only in inst_uid (the previous op's + 1),
+ *  the memory addresses and the branch outcome, the record holds just those:
+ *  the address deltas and one taken byte. Otherwise every op of the block is
+ *  byte-diffed as above.
+ ***************************************************************************************/
+
+#ifndef __OP_CODEC_H__
+#define __OP_CODEC_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "../../ctype_pin_inst.h"
+
+// Upper bound on the bytes either encoder appends per op
+#define OP_CODEC_MAX_ENCODED_SIZE (2 * sizeof(compressed_op) + 16)
+#define OP_CODEC_MAX_BB_OPS 64
+
+class OpEncoder {
+ private:
+  std::unordered_map<uint64_t, uint32_t> ids;
+  std::vector<compressed_op>             templates;
+
+ public:
+  void reset();
+  void encode(const compressed_op& op, std::vector<uint8_t>* out);
+};
+
+class OpDecoder {
+ private:
+  std::vector<compressed_op> templates;
+
+ public:
+  void reset();
+  // Decodes one op from data. Returns the number of bytes consumed, or 0 if
+  // data does not start with a well-formed op for this decoder's state.
+  size_t decode(const uint8_t* data, size_t size, compressed_op* op);
+};
+
+class BbEncoder {
+ private:
+  std::map<std::pair<uint64_t, uint32_t>, uint32_t> ids;
+  std::vector<std::vector<compressed_op>>          templates;
+  uint64_t                                          last_uid;
+
+ public:
+  BbEncoder() : last_uid(0) {}
+  void reset();
+  // Encodes all num ops, the last block ending at ops[num - 1]
+  void encode(const compressed_op* ops, size_t num, std::vector<uint8_t>* out);
+};
+
+class BbDecoder {
+ private:
+  std::vector<std::vector<compressed_op>> templates;
+  uint64_t                                last_uid;
+
+ public:
+  BbDecoder() : last_uid(0) {}
+  void reset();
+  // Decodes one block record into ops, which has room for capacity ops, and
+  // sets *num to its length. Returns the number of bytes consumed, or 0 if
+  // data does not start with a well-formed record that fits.
+  size_t decode(const uint8_t* data, size_t size, compressed_op* ops,
+                size_t capacity, size_t* num);
+};
+
+#endif  // __OP_CODEC_H__
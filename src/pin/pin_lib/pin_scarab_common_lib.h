@@ -47,6 +47,10 @@ typedef enum Scarab_To_Pin_Cmd_enum {
   FE_RECOVER_BEFORE,
   FE_RECOVER_AFTER,
   FE_RETIRE,
+  FE_SHM_ATTACH,  // switch to a SharedMemChannel (inst_uid: Scarab pid,
+                  // inst_addr: client id); answered with a uint32_t over TCP
+  FE_COMPACT_OPS,  // send op buffers over TCP in the op_codec.h encoding;
+                   // answered with a uint32_t (nonzero: accepted)
   FE_NUM_COMMANDS
 } Scarab_To_Pin_Cmd;
 
@@ -0,0 +1,235 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : shared_mem_channel.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  :
+ ***************************************************************************************/
+
+#include "shared_mem_channel.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "message_queue_interface_lib.h"
+
+#define SHM_MAGIC 0x314d485342524353ull  // "SCRBSHM1"
+#define SHM_SPIN_ITERATIONS 4096
+#define SHM_WAIT_TIMEOUT_SEC 1
+
+/* Every word a side waits on has a waiter count next to it, so that the other
+ * side only makes the wake-up syscall when somebody actually sleeps. The
+ * futex words and their counters each get their own cache line. */
+struct SharedMemHeader {
+  uint64_t magic;
+  uint32_t op_capacity;
+  uint32_t pin_pid;
+  uint32_t scarab_pid;
+
+  alignas(64) uint32_t cmd_head;  // advanced by PIN
+  uint32_t cmd_head_waiters;
+  alignas(64) uint32_t cmd_tail;  // advanced by Scarab
+  uint32_t cmd_tail_waiters;
+  alignas(64) uint32_t ops_seq;   // op buffers published by PIN
+  uint32_t ops_seq_waiters;
+  uint32_t op_count[2];
+
+  alignas(64) Scarab_To_Pin_Msg cmds[SHM_CMD_RING_SIZE];
+};
+
+static size_t ops_offset() {
+  return (sizeof(SharedMemHeader) + 63) & ~(size_t)63;
+}
+
+static uint32_t load(const uint32_t* word) {
+  return __atomic_load_n(word, __ATOMIC_SEQ_CST);
+}
+
+static void store_and_wake(uint32_t* word, uint32_t* waiters, uint32_t val) {
+  __atomic_store_n(word, val, __ATOMIC_SEQ_CST);
+  if(load(waiters))
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+// Waits until *word differs from old. Spins first, since the other side
+// usually answers within a few microseconds; on a single CPU spinning would
+// only delay the other side, so it sleeps right away.
+static void wait_while_equal(uint32_t* word, uint32_t* waiters, uint32_t old,
+                             uint32_t peer_pid) {
+  static const uint32_t spin_iterations = sysconf(_SC_NPROCESSORS_ONLN) > 1 ?
+                                            SHM_SPIN_ITERATIONS :
+                                            0;
+  for(uint32_t i = 0; i < spin_iterations; ++i) {
+    if(load(word) != old)
+      return;
+    __builtin_ia32_pause();
+  }
+  while(load(word) == old) {
+    struct timespec timeout = {SHM_WAIT_TIMEOUT_SEC, 0};
+    __atomic_fetch_add(waiters, 1, __ATOMIC_SEQ_CST);
+    if(load(word) == old)
+      syscall(SYS_futex, word, FUTEX_WAIT, old, &timeout, NULL, 0);
+    __atomic_fetch_sub(waiters, 1, __ATOMIC_SEQ_CST);
+    assertm(load(word) != old || kill(peer_pid, 0) == 0 || errno != ESRCH,
+            "Shared memory peer exited unexpectedly");
+  }
+}
+
+/********************************************************************************************
+ * SharedMemChannel Functions
+ *******************************************************************************************/
+
+SharedMemChannel::SharedMemChannel()
+    : header(NULL), ops(NULL), map_size(0), ops_seq(0) {}
+
+SharedMemChannel::~SharedMemChannel() {
+  if(header)
+    munmap(header, map_size);
+}
+
+std::string SharedMemChannel::path(uint64_t scarab_pid, uint64_t client_id) {
+  const char* dir = access("/dev/shm", W_OK) == 0 ? "/dev/shm" : "/tmp";
+  return std::string(dir) + "/scarab_pin_exec." + std::to_string(scarab_pid) +
+         "." + std::to_string(client_id);
+}
+
+bool SharedMemChannel::map(int fd, size_t size) {
+  void* addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if(addr == MAP_FAILED) {
+    perror("SharedMemChannel mmap");
+    return false;
+  }
+  header   = (SharedMemHeader*)addr;
+  ops      = (compressed_op*)((char*)addr + ops_offset());
+  map_size = size;
+  return true;
+}
+
+bool SharedMemChannel::create(const std::string& path, uint32_t op_capacity,
+                              uint32_t scarab_pid) {
+  size_t size = ops_offset() + 2 * (size_t)op_capacity * sizeof(compressed_op);
+  int    fd   = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if(fd < 0) {
+    perror("SharedMemChannel open");
+    return false;
+  }
+  if(ftruncate(fd, size) != 0) {
+    perror("SharedMemChannel ftruncate");
+    close(fd);
+    unlink(path.c_str());
+    return false;
+  }
+  if(!map(fd, size)) {
+    unlink(path.c_str());
+    return false;
+  }
+  // The file is zero-filled, so only the identification needs writing
+  header->op_capacity = op_capacity;
+  header->pin_pid     = getpid();
+  header->scarab_pid  = scarab_pid;
+  __atomic_store_n(&header->magic, SHM_MAGIC, __ATOMIC_SEQ_CST);
+  return true;
+}
+
+bool SharedMemChannel::attach(const std::string& path) {
+  int fd = open(path.c_str(), O_RDWR);
+  unlink(path.c_str());
+  if(fd < 0) {
+    perror("SharedMemChannel open");
+    return false;
+  }
+  off_t size = lseek(fd, 0, SEEK_END);
+  if(size < (off_t)ops_offset() || !map(fd, size))
+    return false;
+  if(__atomic_load_n(&header->magic, __ATOMIC_SEQ_CST) != SHM_MAGIC ||
+     map_size < ops_offset() +
+                  2 * (size_t)header->op_capacity * sizeof(compressed_op)) {
+    munmap(header, map_size);
+    header = NULL;
+    return false;
+  }
+  return true;
+}
+
+void SharedMemChannel::send_cmd(const Scarab_To_Pin_Msg& msg) {
+  uint32_t tail = header->cmd_tail;
+  uint32_t head;
+  while(tail - (head = load(&header->cmd_head)) == SHM_CMD_RING_SIZE)
+    wait_while_equal(&header->cmd_head, &header->cmd_head_waiters, head,
+                     header->pin_pid);
+  header->cmds[tail % SHM_CMD_RING_SIZE] = msg;
+  store_and_wake(&header->cmd_tail, &header->cmd_tail_waiters, tail + 1);
+}
+
+void SharedMemChannel::receive_ops(ScarabOpBuffer_type* buffer) {
+  wait_while_equal(&header->ops_seq, &header->ops_seq_waiters, ops_seq,
+                   header->pin_pid);
+  uint32_t             slot  = ops_seq % 2;
+  const compressed_op* begin = ops + slot * header->op_capacity;
+  buffer->assign(begin, begin + header->op_count[slot]);
+  ops_seq++;
+}
+
+Scarab_To_Pin_Msg SharedMemChannel::receive_cmd() {
+  uint32_t head = header->cmd_head;
+  wait_while_equal(&header->cmd_tail, &header->cmd_tail_waiters, head,
+                   header->scarab_pid);
+  Scarab_To_Pin_Msg msg = header->cmds[head % SHM_CMD_RING_SIZE];
+  store_and_wake(&header->cmd_head, &header->cmd_head_waiters, head + 1);
+  return msg;
+}
+
+/* Scarab copies a published slot out before it asks for the next buffer,
+ * and PIN only publishes in response to that request, so the slot after the
+ * one just published is always free to fill. */
+void SharedMemChannel::push_op(const compressed_op& cop) {
+  uint32_t slot = ops_seq % 2;
+  assertm(header->op_count[slot] < header->op_capacity,
+          "Shared memory op buffer overflow");
+  ops[slot * header->op_capacity + header->op_count[slot]++] = cop;
+}
+
+uint32_t SharedMemChannel::num_ops() const {
+  return header->op_count[ops_seq % 2];
+}
+
+void SharedMemChannel::clear_ops() {
+  header->op_count[ops_seq % 2] = 0;
+}
+
+void SharedMemChannel::publish_ops() {
+  ops_seq++;
+  header->op_count[ops_seq % 2] = 0;
+  store_and_wake(&header->ops_seq, &header->ops_seq_waiters, ops_seq);
+}
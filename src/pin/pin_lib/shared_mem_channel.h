@@ -0,0 +1,80 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : shared_mem_channel.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Shared-memory transport between Scarab and one pin_exec
+ *                client. Scarab's commands go through a small ring and the
+ *                op buffers are written in place by PIN into two alternating
+ *                slots; idle sides sleep on futexes. The TCP socket is still
+ *                used to set the channel up (see FE_SHM_ATTACH).
+ ***************************************************************************************/
+
+#ifndef __SHARED_MEM_CHANNEL_H__
+#define __SHARED_MEM_CHANNEL_H__
+
+#include <stdint.h>
+#include <string>
+#include "pin_scarab_common_lib.h"
+
+#define SHM_CMD_RING_SIZE 64
+
+struct SharedMemHeader;
+
+class SharedMemChannel {
+ private:
+  SharedMemHeader* header;
+  compressed_op*   ops;
+  size_t           map_size;
+  uint32_t         ops_seq;  // next op buffer to publish (PIN) / read (Scarab)
+
+  bool map(int fd, size_t size);
+
+ public:
+  SharedMemChannel();
+  ~SharedMemChannel();
+
+  // Path of the channel file for the given Scarab process and client id
+  static std::string path(uint64_t scarab_pid, uint64_t client_id);
+
+  // PIN side: creates the channel file, sized for op buffers of up to
+  // op_capacity ops. Returns false if shared memory is unavailable.
+  bool create(const std::string& path, uint32_t op_capacity,
+              uint32_t scarab_pid);
+  // Scarab side: maps a channel created by the client and unlinks its file
+  bool attach(const std::string& path);
+
+  // Scarab side
+  void send_cmd(const Scarab_To_Pin_Msg& msg);
+  void receive_ops(ScarabOpBuffer_type* buffer);
+
+  // PIN side. Ops are appended in place to the slot being filled, which
+  // publish_ops() hands over to Scarab.
+  Scarab_To_Pin_Msg receive_cmd();
+  void              push_op(const compressed_op& cop);
+  uint32_t          num_ops() const;
+  void              clear_ops();
+  void              publish_ops();
+};
+
+#endif  // __SHARED_MEM_CHANNEL_H__
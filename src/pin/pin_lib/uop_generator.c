@@ -40,15 +40,19 @@
 
 #include "bp/bp.param.h"
 #include "general.param.h"
+#include "memory/memory.param.h"
 
 #include "bp/bp.h"
 #include "isa/isa.h"
 #include "libs/cpp_hash_lib_wrapper.h"
 #include "libs/hash_lib.h"
 
+#include "op_pool.h"
+
 #include "ctype_pin_inst.h"
 #include "math.h"
 #include "statistics.h"
+#include "xed-iclass-enum.h"
 
 /**************************************************************************************/
 /* Macros */
@@ -56,6 +60,7 @@
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_TRACE_READ, ##args)
 #define DEBUG_PRINT(proc_id, args...) fprintf(GLOBAL_DEBUG_STREAM, ##args)
 #define MAX_PUP 256
+#define UOP_TEMPLATE_CACHE_ENTRIES 4096
 /**************************************************************************************/
 /* Types */
 
@@ -96,6 +101,75 @@ struct Trace_Uop_struct {
 };
 typedef struct Trace_Uop_struct Trace_Uop;
 
+/* Direct-mapped, per-core cache in front of the inst_info hash table: maps the pc and
+ * binary of an instruction to the info of its first uop */
+typedef struct Uop_Template_struct {
+  Addr addr;
+  uint64_t binary_lsb;
+  uint64_t binary_msb;
+  Inst_Info* info;
+} Uop_Template;
+
+/* Elim_Class of each opcode, before looking at the operands. Moves are limited to full-width register moves; the
+ * idioms are the ones that give the same result whatever the (single) source register holds. */
+static const uns8 iclass_elim_class[XED_ICLASS_LAST] = {
+    [XED_ICLASS_MOV] = ELIM_MOVE,
+    [XED_ICLASS_MOVAPS] = ELIM_MOVE,
+    [XED_ICLASS_MOVAPD] = ELIM_MOVE,
+    [XED_ICLASS_MOVUPS] = ELIM_MOVE,
+    [XED_ICLASS_MOVUPD] = ELIM_MOVE,
+    [XED_ICLASS_MOVDQA] = ELIM_MOVE,
+    [XED_ICLASS_MOVDQU] = ELIM_MOVE,
+    [XED_ICLASS_VMOVAPS] = ELIM_MOVE,
+    [XED_ICLASS_VMOVAPD] = ELIM_MOVE,
+    [XED_ICLASS_VMOVUPS] = ELIM_MOVE,
+    [XED_ICLASS_VMOVUPD] = ELIM_MOVE,
+    [XED_ICLASS_VMOVDQA] = ELIM_MOVE,
+    [XED_ICLASS_VMOVDQU] = ELIM_MOVE,
+
+    [XED_ICLASS_XOR] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_SUB] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PXOR] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_XORPS] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_XORPD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPXOR] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPXORD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPXORQ] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VXORPS] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VXORPD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PANDN] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_ANDNPS] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_ANDNPD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPANDN] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VANDNPS] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VANDNPD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PSUBB] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PSUBW] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PSUBD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PSUBQ] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPSUBB] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPSUBW] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPSUBD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPSUBQ] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PCMPGTB] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PCMPGTW] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PCMPGTD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_PCMPGTQ] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPCMPGTB] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPCMPGTW] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPCMPGTD] = ELIM_ZERO_IDIOM,
+    [XED_ICLASS_VPCMPGTQ] = ELIM_ZERO_IDIOM,
+
+    [XED_ICLASS_PCMPEQB] = ELIM_DEP_BREAK_IDIOM,
+    [XED_ICLASS_PCMPEQW] = ELIM_DEP_BREAK_IDIOM,
+    [XED_ICLASS_PCMPEQD] = ELIM_DEP_BREAK_IDIOM,
+    [XED_ICLASS_PCMPEQQ] = ELIM_DEP_BREAK_IDIOM,
+    [XED_ICLASS_VPCMPEQB] = ELIM_DEP_BREAK_IDIOM,
+    [XED_ICLASS_VPCMPEQW] = ELIM_DEP_BREAK_IDIOM,
+    [XED_ICLASS_VPCMPEQD] = ELIM_DEP_BREAK_IDIOM,
+    [XED_ICLASS_VPCMPEQQ] = ELIM_DEP_BREAK_IDIOM,
+};
+
 /**************************************************************************************/
 /* Global Variables */
 
@@ -111,6 +185,7 @@ Flag* fetched_instruction;
 uns* num_sending_uop;
 uns* num_uops;
 Addr* last_ga_va;
+Uop_Template** uop_template_cache;
 
 /**************************************************************************************/
 /* Local prototypes */
@@ -119,6 +194,7 @@ static void convert_pinuop_to_t_uop(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop*
 static void convert_t_uop_to_info(uns8 proc_id, Trace_Uop* t_uop, Inst_Info* info);
 static void convert_dyn_uop(uns8 proc_id, Inst_Info* info, ctype_pin_inst* pi, Trace_Uop* trace_uop, uns mem_size,
                             Flag is_last_uop);
+static Elim_Class inst_elim_class(ctype_pin_inst* pi);
 
 /**************************************************************************************/
 
@@ -218,6 +294,10 @@ void uop_generator_init(uint32_t num_cores) {
   memset(num_sending_uop, 0, num_cores * sizeof(uns));
 
   last_ga_va = (Addr*)malloc(num_cores * sizeof(Addr));
+
+  uop_template_cache = (Uop_Template**)malloc(num_cores * sizeof(Uop_Template*));
+  for (uns ii = 0; ii < num_cores; ii++)
+    uop_template_cache[ii] = (Uop_Template*)calloc(UOP_TEMPLATE_CACHE_ENTRIES, sizeof(Uop_Template));
 }
 
 Flag uop_generator_extract_op(uns proc_id, Op* op, compressed_op* cop) {
@@ -349,6 +429,7 @@ void uop_generator_get_uop(uns proc_id, Op* op, ctype_pin_inst* inst) {
   op->replay_cycle = MAX_CTR;
   op->retire_cycle = MAX_CTR;
   op->replay = FALSE;
+  op->tlb_wait = FALSE;
   op->replay_count = 0;
   op->dont_cause_replays = FALSE;
   op->exec_count = 0;
@@ -443,6 +524,10 @@ Flag uop_generator_get_eom(uns proc_id) {
   return eom[proc_id];
 }
 
+uns uop_generator_uops_left(uns proc_id) {
+  return bom[proc_id] ? 0 : num_uops[proc_id] - num_sending_uop[proc_id];
+}
+
 void convert_t_uop_to_info(uns8 proc_id, Trace_Uop* t_uop, Inst_Info* info) {
   int ii;
 
@@ -461,6 +546,7 @@ void convert_t_uop_to_info(uns8 proc_id, Trace_Uop* t_uop, Inst_Info* info) {
   info->table_info->num_dest_regs = t_uop->num_dest_regs;
   info->table_info->num_src_regs = t_uop->num_src_regs;
   info->table_info->mem_size = t_uop->mem_size;  // IGNORED FOR REP STRING instructions
+  info->table_info->elim_class = ELIM_NONE;
 
   info->table_info->type = 0;        /* scarab internals, ignore */
   info->table_info->mask = 0;        /* scarab internals, ignore */
@@ -781,6 +867,103 @@ static uns generate_uops(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop** trace_uop
   return idx;
 }
 
+/* coalesce_lane_addrs: replaces the num lane addresses (of size bytes each) in vaddrs by the unique cache lines
+ * they touch, in order of first touch. Returns the number of lines, or num with vaddrs untouched if the lines
+ * do not fit in max. */
+static uns coalesce_lane_addrs(void* vaddrs, uns num, uns size, uns max) {
+  uint64_t addrs[MAX2(MAX_LD_NUM, MAX_ST_NUM)];
+  uint64_t lines[MAX2(MAX_LD_NUM, MAX_ST_NUM)];
+  uns num_lines = 0;
+  ASSERT(0, num <= max && max <= MAX2(MAX_LD_NUM, MAX_ST_NUM));
+  memcpy(addrs, vaddrs, num * sizeof(uint64_t));  // vaddrs is a packed ctype_pin_inst field
+
+  for (uns ii = 0; ii < num; ii++) {
+    uint64_t first = addrs[ii] & ~((uint64_t)DCACHE_LINE_SIZE - 1);
+    uint64_t last = (addrs[ii] + MAX2(size, 1) - 1) & ~((uint64_t)DCACHE_LINE_SIZE - 1);
+    for (uint64_t line = first;; line += DCACHE_LINE_SIZE) {
+      uns jj;
+      for (jj = 0; jj < num_lines && lines[jj] != line; jj++)
+        ;
+      if (jj == num_lines) {
+        if (num_lines == max)
+          return num;
+        lines[num_lines++] = line;
+      }
+      if (line == last)
+        break;
+    }
+  }
+  memcpy(vaddrs, lines, num_lines * sizeof(uint64_t));
+  return num_lines;
+}
+
+/* coalesce_gather_scatter_lanes: turns the per-lane accesses of a gather/scatter into one line-sized access per
+ * cache line (GATHER_SCATTER_COALESCE_LINES), so that it becomes one mem uop and memory request per line */
+static void coalesce_gather_scatter_lanes(uns8 proc_id, ctype_pin_inst* pi) {
+  uns num_ld = pi->num_ld;
+  uns num_st = pi->num_st;
+  ASSERTM(proc_id, DCACHE_LINE_SIZE <= UINT8_MAX, "Line-sized gather/scatter accesses need DCACHE_LINE_SIZE < 256\n");
+
+  if (pi->num_ld) {
+    pi->num_ld = coalesce_lane_addrs(pi->ld_vaddr, pi->num_ld, pi->ld_size, MAX_LD_NUM);
+    if (pi->num_ld < num_ld)
+      pi->ld_size = DCACHE_LINE_SIZE;
+  }
+  if (pi->num_st) {
+    pi->num_st = coalesce_lane_addrs(pi->st_vaddr, pi->num_st, pi->st_size, MAX_ST_NUM);
+    if (pi->num_st < num_st)
+      pi->st_size = DCACHE_LINE_SIZE;
+  }
+  INC_STAT_EVENT(proc_id, GATHER_SCATTER_LANES_COALESCED, num_ld + num_st - pi->num_ld - pi->num_st);
+}
+
+/* inst_elim_class: the Elim_Class of an instruction, its opcode's class if the operands allow it. Nothing
+ * touching memory is eliminated, and an idiom needs every source to be the same register (xor eax, eax but not
+ * xor eax, ebx or xor eax, 1). A GPR idiom also needs a 32- or 64-bit destination: xor al, al keeps the upper
+ * bits of the compressed RAX, so it still depends on the previous RAX. */
+static Elim_Class inst_elim_class(ctype_pin_inst* pi) {
+  if (pi->true_op_type >= XED_ICLASS_LAST || pi->fake_inst || pi->num_ld || pi->num_st)
+    return ELIM_NONE;
+
+  Elim_Class elim_class = (Elim_Class)iclass_elim_class[pi->true_op_type];
+  if (elim_class < ELIM_ZERO_IDIOM)
+    return elim_class;
+  if (pi->has_immediate)
+    return ELIM_NONE;
+  if ((pi->true_op_type == XED_ICLASS_XOR || pi->true_op_type == XED_ICLASS_SUB) && pi->lane_width_bytes < 4)
+    return ELIM_NONE;
+
+  uns num_srcs = 0;
+  Reg_Id src = REG_ZPS;
+  for (uns ii = 0; ii < pi->num_src_regs; ii++) {
+    if (pi->src_regs[ii] == REG_ZPS)
+      continue;
+    if (num_srcs++ && pi->src_regs[ii] != src)
+      return ELIM_NONE;
+    src = pi->src_regs[ii];
+  }
+  return num_srcs >= 2 ? elim_class : ELIM_NONE;
+}
+
+/* uop_template_lookup: info of the first uop of pi, created (and *new_entry set) if the
+ * instruction was never decoded */
+static Inst_Info* uop_template_lookup(uns8 proc_id, ctype_pin_inst* pi, Flag* new_entry) {
+  Addr addr = pi->instruction_addr;
+  uns idx = (addr ^ (addr >> 12) ^ pi->inst_binary_lsb) & (UOP_TEMPLATE_CACHE_ENTRIES - 1);
+  Uop_Template* entry = &uop_template_cache[proc_id][idx];
+
+  if (entry->info && entry->addr == addr && entry->binary_lsb == pi->inst_binary_lsb &&
+      entry->binary_msb == pi->inst_binary_msb) {
+    *new_entry = FALSE;
+    return entry->info;
+  }
+  entry->info = cpp_hash_table_access_create(proc_id, addr, pi->inst_binary_lsb, pi->inst_binary_msb, 0, new_entry);
+  entry->addr = addr;
+  entry->binary_lsb = pi->inst_binary_lsb;
+  entry->binary_msb = pi->inst_binary_msb;
+  return entry->info;
+}
+
 void convert_pinuop_to_t_uop(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop** trace_uop) {
   Flag new_entry = FALSE;
   Inst_Info* info;
@@ -790,7 +973,7 @@ void convert_pinuop_to_t_uop(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop** trace
   static Inst_Info dummy_nop;
   static Flag generated_dummy_nop = FALSE;
   if (pi->fake_inst) {
-    info = (Inst_Info*)calloc(1, sizeof(Inst_Info));
+    info = alloc_fake_inst_info(proc_id);
     if (generated_dummy_nop) {
       *info = dummy_nop;
       info->addr = pi->instruction_addr;
@@ -798,8 +981,7 @@ void convert_pinuop_to_t_uop(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop** trace
     info->fake_inst = TRUE;
     info->fake_inst_reason = pi->fake_inst_reason;
   } else {
-    info = cpp_hash_table_access_create(proc_id, pi->instruction_addr, pi->inst_binary_lsb, pi->inst_binary_msb, 0,
-                                        &new_entry);
+    info = uop_template_lookup(proc_id, pi, &new_entry);
     info->fake_inst = FALSE;
     info->fake_inst_reason = WPNM_NOT_IN_WPNM;
   }
@@ -820,6 +1002,9 @@ void convert_pinuop_to_t_uop(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop** trace
     pi->st_vaddr[st] = convert_to_cmp_addr(proc_id, pi->st_vaddr[st]);
   }
 
+  if (GATHER_SCATTER_COALESCE_LINES && pi->is_gather_scatter)
+    coalesce_gather_scatter_lanes(proc_id, pi);
+
   /* always regenerate uops for gather/scatter, because the num of uops could be different every time*/
   Flag need_to_gen_uops = new_entry || (pi->fake_inst && !generated_dummy_nop) || pi->is_gather_scatter;
 
@@ -835,7 +1020,7 @@ void convert_pinuop_to_t_uop(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop** trace
     for (ii = 0; ii < num_uop; ii++) {
       if (ii > 0) {
         if (pi->fake_inst) {
-          info = (Inst_Info*)calloc(1, sizeof(Inst_Info));
+          info = alloc_fake_inst_info(proc_id);
           info->fake_inst = TRUE;
           info->fake_inst_reason = pi->fake_inst_reason;
         } else {
@@ -862,8 +1047,13 @@ void convert_pinuop_to_t_uop(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop** trace
 
       convert_t_uop_to_info(proc_id, trace_uop[ii], info);
       trace_uop[ii]->info = info;
+      info->next_uop = NULL;
+      if (ii > 0 && !pi->fake_inst)
+        trace_uop[ii - 1]->info->next_uop = info;
 
       info->table_info->true_op_type = pi->true_op_type;
+      if (trace_uop[ii]->alu_uop)
+        info->table_info->elim_class = inst_elim_class(pi);
       trace_uop[ii]->info->table_info->is_simd = pi->is_simd;
       trace_uop[ii]->info->uop_seq_num = ii;
       strcpy(trace_uop[ii]->info->table_info->name, pi->pin_iclass);
@@ -890,8 +1080,10 @@ void convert_pinuop_to_t_uop(uns8 proc_id, ctype_pin_inst* pi, Trace_Uop** trace
 
     for (ii = 0; ii < num_uop; ii++) {
       if (ii > 0) {
-        info = cpp_hash_table_access_create(proc_id, pi->instruction_addr, pi->inst_binary_lsb, pi->inst_binary_msb, ii,
-                                            &new_entry);
+        /* the uops were chained when the instruction was decoded */
+        info = info->next_uop ? info->next_uop
+                              : cpp_hash_table_access_create(proc_id, pi->instruction_addr, pi->inst_binary_lsb,
+                                                             pi->inst_binary_msb, ii, &new_entry);
       }
       ASSERT(proc_id, !new_entry);
 
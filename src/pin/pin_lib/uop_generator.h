@@ -46,6 +46,7 @@ Flag uop_generator_extract_op(uns proc_id, Op* op, compressed_op* cop);
 void uop_generator_get_uop(uns proc_id, Op* op, compressed_op* inst);
 Flag uop_generator_get_bom(uns proc_id);  // Called before uop_generator_get_uop.
 Flag uop_generator_get_eom(uns proc_id);  // Called after uop_generator_get_uop.
+uns uop_generator_uops_left(uns proc_id);  // Uops of the current inst not yet sent, 0 between insts.
 void uop_generator_recover(uns8 proc_id);
 
 #ifdef __cplusplus
@@ -156,8 +156,12 @@ int pops_x87_stack(int opcode) {
   return opcode_to_delta_map[opcode] > 0;
 }
 
+bool is_x87_stack_reg(int reg) {
+  return reg >= SCARAB_REG_FP0 && reg < SCARAB_REG_FP0 + X87_STACK_SIZE;
+}
+
 int absolute_reg(int reg, int opcode, bool write) {
-  if(reg >= SCARAB_REG_FP0 && reg < SCARAB_REG_FP0 + X87_STACK_SIZE) {
+  if(is_x87_stack_reg(reg)) {
     ASSERTX(opcode < XED_ICLASS_LAST);
     int correction = 0;
     if(write && opcode_to_delta_map[opcode] < 0) {
@@ -25,6 +25,9 @@
 /* Initialize (call before calling the other function) */
 void init_x87_stack_delta();
 
+/* Check whether the given reg is one of the relative x87 stack regs */
+bool is_x87_stack_reg(int reg);
+
 /* Translate the relative reg given to its absolute name */
 int absolute_reg(int reg, int opcode, bool write);
 
@@ -29,6 +29,8 @@
 #include "power_intf.h"
 
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "globals/assert.h"
 #include "globals/global_defs.h"
@@ -42,6 +44,18 @@
 
 #include "ramulator.h"
 #include "statistics.h"
+#include "trigger.h"
+
+/**************************************************************************************/
+/* Macros */
+
+/* Power events are the POWER_* stats that count activity, as opposed to
+   elapsed time and cycles */
+#define POWER_EVENT_FIRST (POWER_CYCLE + 1)
+#define NUM_POWER_EVENTS (POWER_STATS_END - POWER_EVENT_FIRST)
+
+#define COEFFS_CACHE_MAGIC "SCARABPC"
+#define COEFFS_CACHE_VERSION 1
 
 /**************************************************************************************/
 /* Enum Definitions */
@@ -58,12 +72,51 @@ typedef struct Value_struct {
   double scaled_value; /* Scaled to Scarab's V/f */
 } Value;
 
+/* Results of the last external model run. The model is always evaluated at the
+   reference V/f, so its static results hold for the whole run; only dynamic
+   power follows the activity counters. */
+typedef struct Model_Cache_struct {
+  Flag valid;
+  uns calls; /* power_intf_calc calls served since the model last ran */
+  Value values[POWER_DOMAIN_NUM_ELEMS][POWER_RESULT_NUM_ELEMS];
+  double activity_rate[POWER_DOMAIN_NUM_ELEMS]; /* power events per second */
+} Model_Cache;
+
+/* Linear dynamic energy model derived from the external tools at startup */
+typedef struct Event_Coeffs_struct {
+  Value values[POWER_DOMAIN_NUM_ELEMS][POWER_RESULT_NUM_ELEMS]; /* model results at idle */
+  double idle_dynamic[POWER_DOMAIN_NUM_ELEMS];                  /* W, with no power events */
+  double energy[POWER_DOMAIN_NUM_ELEMS][NUM_POWER_EVENTS];      /* J per event */
+} Event_Coeffs;
+
+/* Header of a POWER_INTF_COEFFS_CACHE_DIR entry, followed by an Event_Coeffs */
+typedef struct Coeffs_Cache_Header_struct {
+  char magic[8];
+  uns32 version;
+  uns32 coeffs_size;
+  uns64 key;
+} Coeffs_Cache_Header;
+
 /**************************************************************************************/
 /* Local Prototypes */
 
 // static void dump_power_stats(void);
 static void run_power_model_exec(void);
-static void parse_power_model_results(void);
+static void read_power_model_results(void);
+static void finish_power_model_results(void);
+static Flag model_cache_stale(void);
+static void save_model_cache(void);
+static void load_model_cache(void);
+static double domain_activity_rate(Power_Domain domain);
+static double domain_stat_events(Power_Domain domain, uns stat);
+static void derive_event_coeffs(void);
+static void set_calib_counts(uns stat, Counter count);
+static uns64 coeffs_cache_key(void);
+static Flag load_coeffs_cache(uns64 key, const char* file_name);
+static void save_coeffs_cache(uns64 key, const char* file_name);
+static void apply_event_coeffs(void);
+static void write_power_series(void);
+static Power_Domain power_stat_domain(uns stat, uns proc_id);
 static void update_energy_stats(void);
 static void scale_values(Power_Domain domain);
 static Freq_Domain_Id freq_domain(Power_Domain);
@@ -76,6 +129,10 @@ static const char* model_results_filename = "power_model_results";
 
 static Value values[POWER_DOMAIN_NUM_ELEMS][POWER_RESULT_NUM_ELEMS];
 static double elapsed_time;  // time elapsed in this interval, seconds
+static Model_Cache model_cache;
+static Event_Coeffs event_coeffs;
+static Trigger* period_trigger;
+static FILE* series_file;
 
 /**************************************************************************************/
 /* power_intf_init: */
@@ -89,6 +146,42 @@ void power_intf_init(void) {
   for (uns stat = POWER_STATS_BEGIN; stat <= POWER_STATS_END; ++stat) {
     ASSERT(0, GET_TOTAL_STAT_EVENT(0, stat) == 0);
   }
+
+  period_trigger = trigger_create("POWER PERIOD", POWER_INTF_PERIOD, TRIGGER_REPEAT);
+
+  if (POWER_INTF_SERIES) {
+    series_file = file_tag_fopen(NULL, "power_series.out", "w");
+    ASSERTM(0, series_file, "Could not open power_series.out\n");
+    fprintf(series_file, "time_fs\tinterval_s");
+    for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+      if (domain < POWER_DOMAIN_CORE_0 + NUM_CORES || domain > POWER_DOMAIN_CORE_7)
+        fprintf(series_file, "\t%s_W", Power_Domain_str(domain));
+    }
+    fprintf(series_file, "\tenergy_J\n");
+  }
+}
+
+/**************************************************************************************/
+/* power_intf_start: */
+
+void power_intf_start(void) {
+  if (!POWER_INTF_ON || !POWER_INTF_EVENT_COEFFS)
+    return;
+
+  for (uns stat = POWER_STATS_BEGIN; stat <= POWER_STATS_END; ++stat) {
+    ASSERT(0, GET_TOTAL_STAT_EVENT(0, stat) == 0);
+  }
+  derive_event_coeffs();
+}
+
+/**************************************************************************************/
+/* power_intf_cycle: */
+
+void power_intf_cycle(void) {
+  if (!POWER_INTF_ON)
+    return;
+  if (trigger_fired(period_trigger))
+    power_intf_calc();
 }
 
 /**************************************************************************************/
@@ -98,8 +191,18 @@ void power_intf_calc(void) {
   double fempto_elapsed_time = (double)GET_TOTAL_STAT_EVENT(0, POWER_TIME);
   elapsed_time = fempto_elapsed_time * 1.0e-15;
 
-  run_power_model_exec();
-  parse_power_model_results();
+  if (POWER_INTF_EVENT_COEFFS) {
+    apply_event_coeffs();
+  } else if (!POWER_INTF_CACHE_MODEL || model_cache_stale()) {
+    run_power_model_exec();
+    read_power_model_results();
+    if (POWER_INTF_CACHE_MODEL)
+      save_model_cache();
+  } else {
+    load_model_cache();
+  }
+  finish_power_model_results();
+  write_power_series();
   update_energy_stats();
 }
 
@@ -121,9 +224,12 @@ double power_intf_result(Power_Domain domain, Power_Result result) {
 void power_intf_done(void) {
   if (!POWER_INTF_ON)
     return;
-  if (GET_TOTAL_STAT_EVENT(0, POWER_TIME) == 0)
-    return;
-  power_intf_calc();
+  if (GET_TOTAL_STAT_EVENT(0, POWER_TIME) != 0)
+    power_intf_calc();
+  if (series_file)
+    fclose(series_file);
+  series_file = NULL;
+  trigger_free(period_trigger);
 }
 
 void run_power_model_exec(void) {
@@ -139,7 +245,7 @@ void run_power_model_exec(void) {
   ASSERTM(0, rc == 0, "Command \"%s\" failed\n", cmd);
 }
 
-void parse_power_model_results(void) {
+void read_power_model_results(void) {
   /* Mark all values as unset */
   for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
     for (uns result = 0; result < POWER_RESULT_NUM_ELEMS; ++result) {
@@ -171,7 +277,13 @@ void parse_power_model_results(void) {
 
   ASSERTM(0, feof(file) && !ferror(file), "Error reading %s\n", model_results_filename);
   fclose(file);
+}
 
+/**************************************************************************************/
+/* finish_power_model_results: derive the remaining values from the model
+ * results, whether they were just read or rescaled from the cache. */
+
+void finish_power_model_results(void) {
   /* Adjusting DRAM power */
   /* CACTI reports numbers for a single DRAM chip:
    * 1. For static power, we need to adjust the value by multiplying to the
@@ -214,6 +326,293 @@ void parse_power_model_results(void) {
   }
 }
 
+/**************************************************************************************/
+/* model_cache_stale: should the external model run again? It has to if the
+ * cached run saw no activity in a domain that is active now, since there is
+ * nothing to scale its dynamic power from. */
+
+Flag model_cache_stale(void) {
+  if (!model_cache.valid)
+    return TRUE;
+  if (POWER_INTF_CACHE_REFRESH && model_cache.calls >= POWER_INTF_CACHE_REFRESH)
+    return TRUE;
+
+  for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+    if (model_cache.values[domain][POWER_RESULT_DYNAMIC].set && model_cache.activity_rate[domain] == 0 &&
+        domain_activity_rate(domain) > 0)
+      return TRUE;
+  }
+  return FALSE;
+}
+
+void save_model_cache(void) {
+  memcpy(model_cache.values, values, sizeof(values));
+  for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+    model_cache.activity_rate[domain] = domain_activity_rate(domain);
+  }
+  model_cache.valid = TRUE;
+  model_cache.calls = 0;
+}
+
+/**************************************************************************************/
+/* load_model_cache: McPAT and CACTI dynamic power is a sum of per-event
+ * energies over the elapsed time, so it is approximated as proportional to
+ * the domain's rate of power events. */
+
+void load_model_cache(void) {
+  memcpy(values, model_cache.values, sizeof(values));
+  for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+    if (values[domain][POWER_RESULT_DYNAMIC].set && model_cache.activity_rate[domain] > 0) {
+      values[domain][POWER_RESULT_DYNAMIC].intf_value *=
+          domain_activity_rate(domain) / model_cache.activity_rate[domain];
+    }
+  }
+  model_cache.calls++;
+  DEBUG(0, "Power model results rescaled from cache (%d calls)\n", model_cache.calls);
+}
+
+double domain_activity_rate(Power_Domain domain) {
+  if (elapsed_time <= 0)
+    return 0;
+
+  double events = 0;
+  for (uns stat = POWER_EVENT_FIRST; stat < POWER_STATS_END; ++stat) {
+    events += domain_stat_events(domain, stat);
+  }
+  return events / elapsed_time;
+}
+
+/* domain_stat_events: occurrences of a power event that the domain's model
+ * consumes, summed over the cores that count it */
+double domain_stat_events(Power_Domain domain, uns stat) {
+  double events = 0;
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if (power_stat_domain(stat, proc_id) == domain)
+      events += (double)GET_TOTAL_STAT_EVENT(proc_id, stat);
+  }
+  return events;
+}
+
+/**************************************************************************************/
+/* derive_event_coeffs: run the external model on synthetic counters, once
+ * with no events and once with each power event occurring every cycle, to
+ * get each event's dynamic energy in every domain. Called before the first
+ * simulated cycle, so all POWER_* stats are zero and are left that way. */
+
+void derive_event_coeffs(void) {
+  Counter calib_cycles = POWER_INTF_CALIB_CYCLES;
+  Counter calib_time = (Counter)((double)calib_cycles * 1.0e15 / POWER_INTF_REF_CHIP_FREQ);
+  ASSERTM(0, calib_cycles > 0 && calib_time > 0, "POWER_INTF_CALIB_CYCLES must be positive\n");
+
+  set_calib_counts(POWER_TIME, calib_time);
+  set_calib_counts(POWER_CYCLE, calib_cycles);
+  elapsed_time = (double)calib_time * 1.0e-15;
+
+  char cache_file[MAX_STR_LENGTH + 1] = "";
+  uns64 key = 0;
+  if (POWER_INTF_COEFFS_CACHE_DIR) {
+    key = coeffs_cache_key();
+    snprintf(cache_file, MAX_STR_LENGTH, "%s/%016llx.coeffs", POWER_INTF_COEFFS_CACHE_DIR, (unsigned long long)key);
+    if (load_coeffs_cache(key, cache_file)) {
+      set_calib_counts(POWER_TIME, 0);
+      set_calib_counts(POWER_CYCLE, 0);
+      elapsed_time = 0;
+      return;
+    }
+  }
+
+  run_power_model_exec();
+  read_power_model_results();
+  memcpy(event_coeffs.values, values, sizeof(values));
+  for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+    event_coeffs.idle_dynamic[domain] =
+        values[domain][POWER_RESULT_DYNAMIC].set ? values[domain][POWER_RESULT_DYNAMIC].intf_value : 0;
+  }
+
+  for (uns stat = POWER_EVENT_FIRST; stat < POWER_STATS_END; ++stat) {
+    set_calib_counts(stat, calib_cycles);
+    run_power_model_exec();
+    read_power_model_results();
+
+    for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+      double events = domain_stat_events(domain, stat);
+      if (!values[domain][POWER_RESULT_DYNAMIC].set || events == 0)
+        continue;
+      /* the models are not exactly linear; an event never saves energy */
+      double extra_power = MAX2(values[domain][POWER_RESULT_DYNAMIC].intf_value - event_coeffs.idle_dynamic[domain], 0);
+      event_coeffs.energy[domain][stat - POWER_EVENT_FIRST] = extra_power * elapsed_time / events;
+      DEBUG(0, "Energy of %s in %s: %le J\n", global_stat_array[0][stat].name, Power_Domain_str(domain),
+            event_coeffs.energy[domain][stat - POWER_EVENT_FIRST]);
+    }
+    set_calib_counts(stat, 0);
+  }
+
+  set_calib_counts(POWER_TIME, 0);
+  set_calib_counts(POWER_CYCLE, 0);
+  elapsed_time = 0;
+  if (POWER_INTF_COEFFS_CACHE_DIR)
+    save_coeffs_cache(key, cache_file);
+}
+
+/**************************************************************************************/
+/* coeffs_cache_key: FNV-1a hash of the model inputs at idle. With every power
+ * event at zero they describe only the structures and the calibration
+ * interval, so runs that differ in workload or activity share a key. */
+
+static uns64 fnv1a(const void* data, size_t size, uns64 hash) {
+  const unsigned char* bytes = (const unsigned char*)data;
+  for (size_t ii = 0; ii < size; ii++) {
+    hash ^= bytes[ii];
+    hash *= 0x100000001b3ull;
+  }
+  return hash;
+}
+
+uns64 coeffs_cache_key(void) {
+  power_print_mcpat_xml_infile();
+  power_print_cacti_cfg_infile();
+
+  uns64 key = 0xcbf29ce484222325ull;
+  uns32 shape[3] = {POWER_DOMAIN_NUM_ELEMS, NUM_POWER_EVENTS, POWER_INTF_ENABLE_SCALING};
+  key = fnv1a(shape, sizeof(shape), key);
+  key = fnv1a(POWER_INTF_EXEC, strlen(POWER_INTF_EXEC), key);
+  const char* infiles[] = {"mcpat_infile.xml", "cacti_infile.cfg"};
+  for (uns ii = 0; ii < sizeof(infiles) / sizeof(infiles[0]); ii++) {
+    char name[MAX_STR_LENGTH + 1];
+    snprintf(name, MAX_STR_LENGTH, "%s%s", FILE_TAG, infiles[ii]);
+    FILE* file = fopen(name, "rb");
+    ASSERTM(0, file, "Could not open %s\n", name);
+    char buf[4096];
+    size_t len;
+    while ((len = fread(buf, 1, sizeof(buf), file)) > 0)
+      key = fnv1a(buf, len, key);
+    fclose(file);
+  }
+  return key;
+}
+
+/**************************************************************************************/
+/* load_coeffs_cache: */
+
+Flag load_coeffs_cache(uns64 key, const char* file_name) {
+  FILE* file = fopen(file_name, "rb");
+  if (!file)
+    return FALSE;
+
+  Coeffs_Cache_Header header;
+  Flag valid = fread(&header, sizeof(header), 1, file) == 1 &&
+               !memcmp(header.magic, COEFFS_CACHE_MAGIC, sizeof(header.magic)) &&
+               header.version == COEFFS_CACHE_VERSION && header.coeffs_size == sizeof(Event_Coeffs) &&
+               header.key == key && fread(&event_coeffs, sizeof(Event_Coeffs), 1, file) == 1;
+  fclose(file);
+  if (!valid) {
+    WARNINGU(0, "Ignoring stale power coefficient cache %s\n", file_name);
+    memset(&event_coeffs, 0, sizeof(event_coeffs));
+    return FALSE;
+  }
+  DEBUG(0, "Loaded power event energies from %s\n", file_name);
+  return TRUE;
+}
+
+/**************************************************************************************/
+/* save_coeffs_cache: written under a private name and renamed into place, so
+ * concurrent runs of one configuration never see a partial entry */
+
+void save_coeffs_cache(uns64 key, const char* file_name) {
+  char tmp_name[MAX_STR_LENGTH + 1];
+  snprintf(tmp_name, MAX_STR_LENGTH, "%s.%d", file_name, (int)getpid());
+  FILE* file = fopen(tmp_name, "wb");
+  if (!file) {
+    WARNINGU(0, "Could not write power coefficient cache %s\n", tmp_name);
+    return;
+  }
+
+  Coeffs_Cache_Header header = {};
+  memcpy(header.magic, COEFFS_CACHE_MAGIC, sizeof(header.magic));
+  header.version = COEFFS_CACHE_VERSION;
+  header.coeffs_size = sizeof(Event_Coeffs);
+  header.key = key;
+  Flag ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(&event_coeffs, sizeof(Event_Coeffs), 1, file) == 1;
+  ok = !fclose(file) && ok;
+  if (!ok || rename(tmp_name, file_name)) {
+    WARNINGU(0, "Could not write power coefficient cache %s\n", file_name);
+    unlink(tmp_name);
+  }
+}
+
+void set_calib_counts(uns stat, Counter count) {
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    SET_STAT_EVENT(proc_id, stat, count);
+  }
+}
+
+/**************************************************************************************/
+/* apply_event_coeffs: dynamic power of each domain as the dot product of its
+ * event energies and the interval's POWER_* counters */
+
+void apply_event_coeffs(void) {
+  memcpy(values, event_coeffs.values, sizeof(values));
+  for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+    if (!values[domain][POWER_RESULT_DYNAMIC].set)
+      continue;
+    double energy = 0;
+    for (uns stat = POWER_EVENT_FIRST; stat < POWER_STATS_END; ++stat) {
+      double coeff = event_coeffs.energy[domain][stat - POWER_EVENT_FIRST];
+      if (coeff != 0)
+        energy += coeff * domain_stat_events(domain, stat);
+    }
+    values[domain][POWER_RESULT_DYNAMIC].intf_value =
+        event_coeffs.idle_dynamic[domain] + (elapsed_time > 0 ? energy / elapsed_time : 0);
+  }
+}
+
+/**************************************************************************************/
+/* write_power_series: one line of power_series.out per power_intf_calc */
+
+void write_power_series(void) {
+  if (!series_file)
+    return;
+
+  double total_power = 0;
+  fprintf(series_file, "%llu\t%le", (unsigned long long)sim_time, elapsed_time);
+  for (uns domain = 0; domain < POWER_DOMAIN_NUM_ELEMS; ++domain) {
+    if (domain >= POWER_DOMAIN_CORE_0 + NUM_CORES && domain <= POWER_DOMAIN_CORE_7)
+      continue;
+    double power = values[domain][POWER_RESULT_TOTAL].set ? power_intf_result(domain, POWER_RESULT_TOTAL) : 0;
+    fprintf(series_file, "\t%le", power);
+    total_power += power;
+  }
+  fprintf(series_file, "\t%le\n", total_power * elapsed_time);
+}
+
+/* power_stat_domain: the power domain whose model consumes a power event */
+Power_Domain power_stat_domain(uns stat, uns proc_id) {
+  switch (stat) {
+    case POWER_LLC_READ_ACCESS:
+    case POWER_LLC_WRITE_ACCESS:
+    case POWER_LLC_READ_MISS:
+    case POWER_LLC_WRITE_MISS:
+    case POWER_MEMORY_ACCESS:
+    case POWER_MEMORY_READ_ACCESS:
+    case POWER_MEMORY_WRITE_ACCESS:
+    case POWER_L2DIREC_READ_ACCESS:
+    case POWER_L2DIREC_WRITE_ACCESS:
+    case POWER_L2DIREC_READ_MISS:
+    case POWER_L2DIREC_WRITE_MISS:
+    case POWER_MEMORY_CTRL_ACCESS:
+    case POWER_MEMORY_CTRL_READ:
+    case POWER_MEMORY_CTRL_WRITE:
+      return POWER_DOMAIN_UNCORE;
+    case POWER_DRAM_PRECHARGE:
+    case POWER_DRAM_ACTIVATE:
+    case POWER_DRAM_READ:
+    case POWER_DRAM_WRITE:
+      return POWER_DOMAIN_MEMORY;
+    default:
+      return POWER_DOMAIN_CORE_0 + proc_id;
+  }
+}
+
 void update_energy_stats(void) {
   INC_STAT_VALUE(0, TIME, elapsed_time);
 
@@ -254,7 +653,7 @@ void update_energy_stats(void) {
 
 void dump_power_energy_stats(void) {
   for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
-    dump_stats(proc_id, TRUE, global_stat_array[proc_id] + POWER_STATS_BEGIN, ENERGY_STATS_END - POWER_STATS_BEGIN + 1);
+    dump_stats(proc_id, TRUE, POWER_STATS_BEGIN, ENERGY_STATS_END - POWER_STATS_BEGIN + 1);
   }
 }
 
@@ -57,6 +57,13 @@ void power_intf_init(void);
    called) */
 void power_intf_calc(void);
 
+/* Derive the per-event energies of POWER_INTF_EVENT_COEFFS; called once the
+   model is initialized, before the first simulated cycle */
+void power_intf_start(void);
+
+/* Call power_intf_calc() whenever POWER_INTF_PERIOD fires */
+void power_intf_cycle(void);
+
 /* Return the specified power result for the specified domain */
 double power_intf_result(Power_Domain domain, Power_Result result);
 
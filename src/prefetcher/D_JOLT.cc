@@ -22,6 +22,7 @@ extern "C" {
 #include "memory/memory.param.h"
 #include "prefetcher/pref.param.h"
 
+#include "libs/mem_footprint.h"
 #include "memory/memory.h"
 
 #include "op.h"
@@ -510,13 +511,13 @@ class WindowBasedStreamPrefetcher {
       }
 
       // Update, issue prefetch, and touch a entry
+      std::array<Addr, Degree> pf_addrs;
       for (size_t j = 0; j < Degree; ++j) {
-        const uint64_t pf_addr = (stream.start_line_address + Distance) << LOG2(ICACHE_LINE_SIZE);
-
-        new_mem_req(MRT_IPRF, djolt_proc_id, pf_addr, ICACHE_LINE_SIZE, 0, NULL, instr_fill_line, unique_count, 0);
+        pf_addrs[j] = (stream.start_line_address + Distance) << LOG2(ICACHE_LINE_SIZE);
         INC_STAT_EVENT(0, DJOLT_PREFETCH_ENTRY, 1);
         ++stream.start_line_address;
       }
+      new_mem_req_batch(MRT_IPRF, djolt_proc_id, pf_addrs.data(), Degree, instr_fill_line, unique_count, NULL, NULL);
       monitoring_table.touch(i);
       return true;
     }
@@ -525,11 +526,13 @@ class WindowBasedStreamPrefetcher {
 
   void prefetch_initial_stream(uint64_t line_address, const TrainingStreamEntry& stream) {
     // i == 0 is not needed since it is the same line as the demand access.
+    std::array<Addr, Distance - 1> pf_addrs;
     for (size_t i = 1; i < Distance; ++i) {
-      const uint64_t pf_addr = (line_address + i) << LOG2(ICACHE_LINE_SIZE);
-      new_mem_req(MRT_IPRF, djolt_proc_id, pf_addr, ICACHE_LINE_SIZE, 0, NULL, instr_fill_line, unique_count, 0);
+      pf_addrs[i - 1] = (line_address + i) << LOG2(ICACHE_LINE_SIZE);
       INC_STAT_EVENT(0, DJOLT_PREFETCH_INITIAL, 1);
     }
+    new_mem_req_batch(MRT_IPRF, djolt_proc_id, pf_addrs.data(), Distance - 1, instr_fill_line, unique_count, NULL,
+                      NULL);
   }
 
  public:
@@ -611,18 +614,24 @@ std::vector<D_JOLT_PREFETCHER*> per_core_d_jolt_prefetcher;
 
 D_JOLT_PREFETCHER::D_JOLT_PREFETCHER(uns proc_id) : proc_id(proc_id) {
   std::cout << "L1I D-JOLT instruction prefetcher has been constructed!" << std::endl;
+  mem_footprint_add("djolt.miss_table_1", proc_id, sizeof(miss_table_1));
+  mem_footprint_add("djolt.miss_table_2", proc_id, sizeof(miss_table_2));
+  mem_footprint_add("djolt.extra_miss_table", proc_id, sizeof(extra_miss_table));
+  mem_footprint_add("djolt.state", proc_id,
+                    sizeof(*this) - sizeof(miss_table_1) - sizeof(miss_table_2) - sizeof(extra_miss_table));
 }
 
 template <class Table>
 void D_JOLT_PREFETCHER::prefetch_with_sig(const Table& table, uint32_t sig) {
   if (table.contains(sig)) {
+    std::vector<Addr> pf_addrs;
     for (const auto& v : table[sig].getValidEntries()) {
       for (const auto& address : v.getAddresses()) {
-        const uint64_t pf_addr = upper_bit_table.decompress(address);
-        new_mem_req(MRT_IPRF, proc_id, pf_addr, ICACHE_LINE_SIZE, 0, NULL, instr_fill_line, unique_count, 0);
+        pf_addrs.push_back(upper_bit_table.decompress(address));
         INC_STAT_EVENT(0, DJOLT_PREFETCH_SIG, 1);
       }
     }
+    new_mem_req_batch(MRT_IPRF, proc_id, pf_addrs.data(), pf_addrs.size(), instr_fill_line, unique_count, NULL, NULL);
   }
 }
 
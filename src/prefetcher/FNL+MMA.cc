@@ -13,6 +13,7 @@
 #include "debug/debug_macros.h"
 #include "debug/debug_print.h"
 
+#include "libs/packed_array.h"
 #include "prefetcher/FNL+MMA.h"
 
 extern "C" {
@@ -22,6 +23,7 @@ extern "C" {
 #include "memory/memory.param.h"
 #include "prefetcher/pref.param.h"
 
+#include "libs/mem_footprint.h"
 #include "memory/memory.h"
 
 #include "op.h"
@@ -62,8 +64,8 @@ uint64_t PrefetchCandidate;
   5  // 3 to 6  reaches approximately the same performance, but slightly more accesses to L2 with larger MAXFNL
 #define PERIODRESET 8192
 #define FNL_NBENTRIES (1 << (16 + LOGMULTSIZE))
-static int WorthPF[FNL_NBENTRIES];
-static int Touched[FNL_NBENTRIES];
+static Packed_Tag_Array<2> WorthPF(FNL_NBENTRIES);  // 2-bit counters
+static Packed_Tag_Array<1> Touched(FNL_NBENTRIES);
 static int ptReset;
 
 #define NBWAYISHADOW 3
@@ -127,25 +129,25 @@ bool IsInIShadow(uint64_t Block, bool Insert) {
 #define LOGWAYNEXTMISS (10 + LOGMULTSIZE)
 #define SIZEWAYNEXTMISS (1 << LOGWAYNEXTMISS)
 
-uint64_t GNtag[NBWAYPRED * SIZEWAYNEXTMISS];
+Packed_Tag_Array<LOGTAGNEXTMISS> GNtag(NBWAYPRED * SIZEWAYNEXTMISS);
 uint64_t GNblock[NBWAYPRED * SIZEWAYNEXTMISS];
 int GNbMiss[NBWAYPRED * SIZEWAYNEXTMISS];
 int8_t GU[NBWAYPRED * SIZEWAYNEXTMISS];
 class PredictMiss {
  public:
-  uint64_t *Ntag;    // 12 bits
+  Packed_Tag_Array<LOGTAGNEXTMISS> *Ntag;
   uint64_t *NBlock;  // 58 bits
   int8_t *U;
   int *NbMiss;  // 1 bit for replacement and confidence
   int distahead;
   void init(int X) {
-    Ntag = GNtag;
+    Ntag = &GNtag;
     NBlock = GNblock;
     NbMiss = GNbMiss;
     U = GU;
     for (int i = 0; i < NBWAYPRED * SIZEWAYNEXTMISS; i++) {
       U[i] = 0;
-      Ntag[i] = 0;
+      Ntag->set(i, 0);
       NBlock[i] = 0;
       NbMiss[i] = 0;
     }
@@ -165,7 +167,7 @@ class PredictMiss {
     uint64_t tag = (Addr >> LOGWAYNEXTMISS) & ((1 << LOGTAGNEXTMISS) - 1);
     int NHIT = -1;
     for (int i = 0; i < NBWAYPRED; i++) {
-      if (Ntag[index[i]] == tag) {
+      if (Ntag->get(index[i]) == tag) {
         NHIT = i;
         PrefetchCandidate = NBlock[index[NHIT]];
         break;
@@ -193,7 +195,7 @@ class PredictMiss {
     uint64_t tag = (PrevAddr >> LOGWAYNEXTMISS) & ((1 << LOGTAGNEXTMISS) - 1);
     int NHIT = -1;
     for (int i = 0; i < NBWAYPRED; i++) {
-      if (Ntag[index[i]] == tag) {
+      if (Ntag->get(index[i]) == tag) {
         NbMiss[index[i]]++;
         NHIT = i;  // increase the confidence
         if (NBlock[index[i]] == Block) {
@@ -223,7 +225,7 @@ class PredictMiss {
     if (NHIT != -1) {
       // allocate the entry
       NBlock[index[NHIT]] = Block;
-      Ntag[index[NHIT]] = tag;
+      Ntag->set(index[NHIT], tag);
       NbMiss[index[NHIT]] = 0;
       U[index[X]] = 0;
     }
@@ -232,13 +234,20 @@ class PredictMiss {
 
 PredictMiss AHEAD, AHEADphist;
 
-#define PrefCodeBlock(X)                                                                                         \
-  new_mem_req(MRT_IPRF, fnlmma_proc_id, X << LOG2(ICACHE_LINE_SIZE), ICACHE_LINE_SIZE, 0, NULL, instr_fill_line, \
-              unique_count, 0)
+// the blocks of one access are collected and issued together at its end
+#define FNLMMA_MAX_PREFETCHES (3 * MAXFNL + 2)
+#define PrefCodeBlock(X)                                                                                               \
+  do {                                                                                                                 \
+    ASSERT(proc_id, num_pf_addrs < FNLMMA_MAX_PREFETCHES);                                                             \
+    pf_addrs[num_pf_addrs++] = (X) << LOG2(ICACHE_LINE_SIZE);                                                          \
+  } while (0)
 // prefetch  works on  blocks
 
 /////////////////////////////////
 void alloc_mem_fnlmma(uns numCores) {
+  // the tables are shared by all cores, and AHEAD and AHEADphist share the MMA table
+  mem_footprint_add("fnlmma.fnl_tables", 0, WorthPF.bytes() + Touched.bytes());
+  mem_footprint_add("fnlmma.mma_table", 0, GNtag.bytes() + sizeof(GNblock) + sizeof(GNbMiss) + sizeof(GU));
 }
 
 void init_fnlmma(uns proc_id) {
@@ -262,6 +271,8 @@ void fnlmma_prefetch(uns proc_id, uint64_t v_addr, uint8_t cache_hit, uint8_t pr
   int index = Block & (FNL_NBENTRIES - 1);
   bool ShadowMiss = (!IsInIShadow(Block, 1));
   uint64_t AheadPredictedBlock = 0;
+  Addr pf_addrs[FNLMMA_MAX_PREFETCHES];
+  uns num_pf_addrs = 0;
   // prefetch is triggered only on misses on the Shadow I-cache
   if (ShadowMiss) {
     // The FNL prefetcher
@@ -279,8 +290,7 @@ void fnlmma_prefetch(uns proc_id, uint64_t v_addr, uint8_t cache_hit, uint8_t pr
     // I-Shadow misses
     {
       if (Touched[i])
-        if (WorthPF[i] > 0)
-          WorthPF[i]--;
+        WorthPF.sat_dec(i);
       Touched[i] = 0;
     }
     ptReset += (FNL_NBENTRIES / PERIODRESET);
@@ -417,6 +427,7 @@ void fnlmma_prefetch(uns proc_id, uint64_t v_addr, uint8_t cache_hit, uint8_t pr
       PREVPRED[0] = AheadPredictedBlock;
     }
 #endif
+    new_mem_req_batch(MRT_IPRF, fnlmma_proc_id, pf_addrs, num_pf_addrs, instr_fill_line, unique_count, NULL, NULL);
   }
 }
 
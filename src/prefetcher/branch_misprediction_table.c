@@ -8,6 +8,9 @@
 
 #include "prefetcher/branch_misprediction_table.h"
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "globals/assert.h"
 #include "globals/global_defs.h"
 #include "globals/global_types.h"
@@ -24,56 +27,199 @@
 
 #include "statistics.h"
 
+/**************************************************************************************/
+/* Types */
+
 typedef struct Bm_Info_struct {
   Counter branch_count;
   Counter branch_mispred_count;
 } Bm_Info;
 
+/* One set of the bounded table fills one cache line. A tag of 0 marks an
+   empty way. The counters saturate by halving both, which keeps the rate. */
+#define BM_TABLE_ASSOC 8
+#define BM_COUNT_MAX 0xFFFF
+
+typedef struct Bm_Set_struct {
+  uns32 tag[BM_TABLE_ASSOC];
+  uns16 branch_count[BM_TABLE_ASSOC];
+  uns16 branch_mispred_count[BM_TABLE_ASSOC];
+} __attribute__((aligned(64))) Bm_Set;
+
+typedef struct Bm_Table_struct {
+  Bm_Set* sets;  // NULL for the unbounded table
+  uns set_bits;
+  Hash_Table inf_size_table;
+} Bm_Table;
+
 /**************************************************************************************/
 /* Global Variables */
 
-uns8 proc_id;
+static Bm_Table* bm_tables;
+
+/**************************************************************************************/
+/* Local Prototypes */
 
-Hash_Table inf_size_bm_table;
+static inline uns bm_set_index(const Bm_Table* table, Addr pc);
+static inline uns32 bm_tag(const Bm_Table* table, Addr pc);
+static int bm_find_way(const Bm_Set* set, uns32 tag);
+static int bm_find_or_insert_way(Bm_Set* set, uns32 tag);
+static void bm_halve(Bm_Set* set, int way);
+static float bm_rate(Counter count, Counter mispred_count);
 
 /**************************************************************************************/
 /* init_branch_misprediction_table */
 
-void init_branch_misprediction_table(uns8 pid) {
-  proc_id = pid;
+void init_branch_misprediction_table(uns8 proc_id) {
+  if (!bm_tables)
+    bm_tables = (Bm_Table*)calloc(NUM_CORES, sizeof(Bm_Table));
+  Bm_Table* table = &bm_tables[proc_id];
+
   if (BRANCH_MISPREDICTION_TABLE_SIZE == 0) {
-    init_hash_table(&inf_size_bm_table, "infinite sized", 15000000, sizeof(Bm_Info));
-    // cpp version is not a lib yet. only one instance.
+    // the open table grows with the branches seen instead of reserving buckets up front
+    init_hash_table_impl(&table->inf_size_table, "infinite sized", 4096, sizeof(Bm_Info), HASH_TABLE_OPEN);
+    return;
   }
+
+  uns num_sets = BRANCH_MISPREDICTION_TABLE_SIZE / BM_TABLE_ASSOC;
+  ASSERTM(proc_id, num_sets && !(num_sets & (num_sets - 1)),
+          "BRANCH_MISPREDICTION_TABLE_SIZE must be %d times a power of 2\n", BM_TABLE_ASSOC);
+  table->set_bits = LOG2(num_sets);
+  int error = posix_memalign((void**)&table->sets, __alignof__(Bm_Set), num_sets * sizeof(Bm_Set));
+  ASSERTM(proc_id, !error, "Could not allocate the branch misprediction table\n");
+  memset(table->sets, 0, num_sets * sizeof(Bm_Set));
 }
 
-float get_branch_misprediction_rate(Addr pc) {
-  float rate = 0;
-  if (BRANCH_MISPREDICTION_TABLE_SIZE == 0) {
-    Bm_Info* info = (Bm_Info*)hash_table_access(&inf_size_bm_table, pc);
-    if (info) {
-      rate = info->branch_mispred_count / info->branch_count;
-    }
+/**************************************************************************************/
+/* get_branch_misprediction_rate */
+
+float get_branch_misprediction_rate(uns8 proc_id, Addr pc) {
+  Bm_Table* table = &bm_tables[proc_id];
+  if (!table->sets) {
+    Bm_Info* info = (Bm_Info*)hash_table_access(&table->inf_size_table, pc);
+    return info ? bm_rate(info->branch_count, info->branch_mispred_count) : 0;
+  }
+
+  const Bm_Set* set = &table->sets[bm_set_index(table, pc)];
+  int way = bm_find_way(set, bm_tag(table, pc));
+  return way >= 0 ? bm_rate(set->branch_count[way], set->branch_mispred_count[way]) : 0;
+}
+
+/**************************************************************************************/
+/* get_branch_misprediction_candidates: looks up all branches of a fetch target
+   at once. Each lookup reads one set, and the sets of the later branches are
+   prefetched while the first are compared. */
+
+uns get_branch_misprediction_candidates(uns8 proc_id, const Addr* pcs, uns num_pcs, Flag* candidates) {
+  Bm_Table* table = &bm_tables[proc_id];
+  uns num_candidates = 0;
+
+  if (table->sets) {
+    for (uns ii = 0; ii < num_pcs; ii++)
+      __builtin_prefetch(&table->sets[bm_set_index(table, pcs[ii])]);
+  }
+  for (uns ii = 0; ii < num_pcs; ii++) {
+    float rate = get_branch_misprediction_rate(proc_id, pcs[ii]);
+    candidates[ii] = rate >= FDIP_DUAL_PATH_PREF_UOC_ONLINE_MISPRED_THRESHOLD;
+    num_candidates += candidates[ii];
   }
-  return rate;
+  return num_candidates;
 }
 
-void increment_branch_count(Addr pc) {
-  if (BRANCH_MISPREDICTION_TABLE_SIZE == 0) {
-    Flag new_entry;
-    Bm_Info* info = (Bm_Info*)hash_table_access_create(&inf_size_bm_table, pc, &new_entry);
-    if (new_entry)
-      memset(info, 0, sizeof(*info));
+/**************************************************************************************/
+/* increment_branch_count */
+
+void increment_branch_count(uns8 proc_id, Addr pc) {
+  Bm_Table* table = &bm_tables[proc_id];
+  if (!table->sets) {
+    Flag new_entry;  // open tables zero new entries
+    Bm_Info* info = (Bm_Info*)hash_table_access_create(&table->inf_size_table, pc, &new_entry);
     info->branch_count++;
+    return;
   }
+
+  Bm_Set* set = &table->sets[bm_set_index(table, pc)];
+  int way = bm_find_or_insert_way(set, bm_tag(table, pc));
+  if (set->branch_count[way] == BM_COUNT_MAX)
+    bm_halve(set, way);
+  set->branch_count[way]++;
 }
 
-void increment_branch_mispredictions(Addr pc) {
-  if (BRANCH_MISPREDICTION_TABLE_SIZE == 0) {
-    Flag new_entry;
-    Bm_Info* info = (Bm_Info*)hash_table_access_create(&inf_size_bm_table, pc, &new_entry);
-    if (new_entry)
-      memset(info, 0, sizeof(*info));
+/**************************************************************************************/
+/* increment_branch_mispredictions */
+
+void increment_branch_mispredictions(uns8 proc_id, Addr pc) {
+  Bm_Table* table = &bm_tables[proc_id];
+  if (!table->sets) {
+    Flag new_entry;  // open tables zero new entries
+    Bm_Info* info = (Bm_Info*)hash_table_access_create(&table->inf_size_table, pc, &new_entry);
     info->branch_mispred_count++;
+    return;
   }
-}
\ No newline at end of file
+
+  Bm_Set* set = &table->sets[bm_set_index(table, pc)];
+  int way = bm_find_or_insert_way(set, bm_tag(table, pc));
+  if (set->branch_mispred_count[way] == BM_COUNT_MAX)
+    bm_halve(set, way);
+  set->branch_mispred_count[way]++;
+}
+
+/**************************************************************************************/
+/* bm_set_index: */
+
+static inline uns bm_set_index(const Bm_Table* table, Addr pc) {
+  return (pc ^ (pc >> table->set_bits)) & N_BIT_MASK(table->set_bits);
+}
+
+/**************************************************************************************/
+/* bm_tag: the pc bits above the index, never 0 */
+
+static inline uns32 bm_tag(const Bm_Table* table, Addr pc) {
+  uns32 tag = (uns32)(pc >> table->set_bits) ^ (uns32)(pc >> 32);
+  return tag ? tag : 1;
+}
+
+/**************************************************************************************/
+/* bm_find_way: */
+
+static int bm_find_way(const Bm_Set* set, uns32 tag) {
+  for (int way = 0; way < BM_TABLE_ASSOC; way++) {
+    if (set->tag[way] == tag)
+      return way;
+  }
+  return -1;
+}
+
+/**************************************************************************************/
+/* bm_find_or_insert_way: a missing branch replaces the empty or least executed
+   way of the set */
+
+static int bm_find_or_insert_way(Bm_Set* set, uns32 tag) {
+  int victim = 0;
+  for (int way = 0; way < BM_TABLE_ASSOC; way++) {
+    if (set->tag[way] == tag)
+      return way;
+    if (!set->tag[way] || (set->tag[victim] && set->branch_count[way] < set->branch_count[victim]))
+      victim = way;
+  }
+  set->tag[victim] = tag;
+  set->branch_count[victim] = 0;
+  set->branch_mispred_count[victim] = 0;
+  return victim;
+}
+
+/**************************************************************************************/
+/* bm_halve: */
+
+static void bm_halve(Bm_Set* set, int way) {
+  set->branch_count[way] >>= 1;
+  set->branch_mispred_count[way] >>= 1;
+}
+
+/**************************************************************************************/
+/* bm_rate: */
+
+static float bm_rate(Counter count, Counter mispred_count) {
+  // a branch can be mispredicted before its first count reaches the table
+  return count ? MIN2((float)mispred_count / count, 1.0f) : (mispred_count ? 1.0f : 0.0f);
+}
@@ -4,7 +4,8 @@
  * Date         : 10.28.2020
  * Description  : Store branch count and branch misprediction count for each branch.
  *                Used to identify candidates for dual path prefetching into the uop cache.
- *                8-way set associative.
+ *                8-way set associative with 16-bit saturating counters, one cache
+ *                line per set; unbounded when BRANCH_MISPREDICTION_TABLE_SIZE is 0.
  ***************************************************************************************/
 
 #ifndef __BRANCH_MISPREDICTION_TABLE_H__
@@ -17,9 +18,14 @@
 
 void init_branch_misprediction_table(uns8 proc_id);
 
-float get_branch_misprediction_rate(Addr pc);
+float get_branch_misprediction_rate(uns8 proc_id, Addr pc);
 
-void increment_branch_count(Addr pc);
-void increment_branch_mispredictions(Addr pc);
+/* Set candidates[ii] when the misprediction rate of pcs[ii] reaches
+   FDIP_DUAL_PATH_PREF_UOC_ONLINE_MISPRED_THRESHOLD, for all branches of an FT
+   at once. Returns the number of candidates. */
+uns get_branch_misprediction_candidates(uns8 proc_id, const Addr* pcs, uns num_pcs, Flag* candidates);
+
+void increment_branch_count(uns8 proc_id, Addr pc);
+void increment_branch_mispredictions(uns8 proc_id, Addr pc);
 
 #endif /* #ifndef __BRANCH_MISPREDICTION_TABLE_H__ */
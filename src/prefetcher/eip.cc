@@ -52,6 +52,8 @@ extern "C" {
 #include "memory/memory.param.h"
 #include "prefetcher/pref.param.h"
 
+#include "libs/malloc_lib.h"
+#include "libs/mem_footprint.h"
 #include "memory/memory.h"
 
 #include "op.h"
@@ -73,6 +75,7 @@ extern int per_cyc_ipref;
 uint32_t eip_proc_id;
 uint32_t L1I_RQ_SIZE = 0;
 uint32_t L1I_TIMING_MSHR_SIZE = 0;
+uint32_t L1I_TIMING_MSHR_BUCKET_BITS = 0;
 uint32_t L1I_SET = 0;
 uint32_t L1I_WAY = 0;
 
@@ -125,8 +128,27 @@ typedef struct __l1i_stats_entry {
   uint64_t wrong;  // early
 } l1i_stats_entry;
 
-// l1i_stats_entry l1i_stats_table[NUM_CPUS][L1I_STATS_TABLE_ENTRIES];
-std::vector<l1i_stats_entry *> l1i_stats_table;
+// Per-core state. Every table is a flat array carved out of one allocation,
+// set-indexed tables are laid out as [set * ways + way]
+typedef struct __l1i_core_tables {
+  l1i_stats_entry *stats_table;                          // [L1I_STATS_TABLE_ENTRIES]
+  struct __l1i_hist_entry *hist_table;                   // [L1I_HIST_TABLE_ENTRIES]
+  uint64_t hist_table_head;                              // log_2 (L1I_HIST_TABLE_ENTRIES)
+  uint64_t hist_table_head_time;                         // 64 bits
+  struct __l1i_timing_mshr_entry *timing_mshr_table;     // [L1I_TIMING_MSHR_SIZE]
+  uint32_t *timing_mshr_buckets;                         // [1 << L1I_TIMING_MSHR_BUCKET_BITS], tag chain heads
+  uint32_t timing_mshr_free;                             // head of the invalid entry list
+  struct __l1i_timing_cache_entry *timing_cache_table;   // [L1I_SET][L1I_WAY]
+  struct __l1i_entangled_entry *entangled_table;         // [L1I_ENTANGLED_TABLE_SETS][L1I_ENTANGLED_TABLE_WAYS]
+  uint32_t *entangled_fifo;                              // [L1I_ENTANGLED_TABLE_SETS]
+} l1i_core_tables;
+
+std::vector<l1i_core_tables> l1i_cores;
+
+static inline l1i_core_tables &l1i_core() {
+  return l1i_cores[eip_proc_id];
+}
+
 uint64_t l1i_stats_discarded_prefetches;
 uint64_t l1i_stats_evict_entangled_j_table;
 uint64_t l1i_stats_evict_entangled_k_table;
@@ -138,13 +160,8 @@ uint64_t l1i_stats_entangled[L1I_ENTANGLED_MAX_FORMATS + 1];
 uint64_t l1i_stats_basic_blocks_ent[L1I_MERGE_BBSIZE_MAX_VALUE + 1];
 
 void l1i_init_stats_table() {
-  for (int i = 0; i < L1I_STATS_TABLE_ENTRIES; i++) {
-    l1i_stats_table[eip_proc_id][i].accesses = 0;
-    l1i_stats_table[eip_proc_id][i].misses = 0;
-    l1i_stats_table[eip_proc_id][i].hits = 0;
-    l1i_stats_table[eip_proc_id][i].late = 0;
-    l1i_stats_table[eip_proc_id][i].wrong = 0;
-  }
+  // stats_table comes zeroed from lazy_calloc, so only the lines a run
+  // touches become resident
   l1i_stats_discarded_prefetches = 0;
   l1i_stats_evict_entangled_j_table = 0;
   l1i_stats_evict_entangled_k_table = 0;
@@ -172,11 +189,11 @@ void l1i_print_stats_table() {
   uint64_t max_addr = 0;
   uint64_t total_accesses = 0;
   for (uint32_t i = 0; i < L1I_STATS_TABLE_ENTRIES; i++) {
-    if (l1i_stats_table[eip_proc_id][i].accesses > max) {
-      max = l1i_stats_table[eip_proc_id][i].accesses;
+    if (l1i_core().stats_table[i].accesses > max) {
+      max = l1i_core().stats_table[i].accesses;
       max_addr = i;
     }
-    total_accesses += l1i_stats_table[eip_proc_id][i].accesses;
+    total_accesses += l1i_core().stats_table[i].accesses;
   }
   cout << hex << max_addr << " " << (max_addr << LOG2(ICACHE_LINE_SIZE)) << dec << " " << max << " / " << total_accesses
        << endl;
@@ -185,11 +202,11 @@ void l1i_print_stats_table() {
   max_addr = 0;
   uint64_t total_misses = 0;
   for (uint32_t i = 0; i < L1I_STATS_TABLE_ENTRIES; i++) {
-    if (l1i_stats_table[eip_proc_id][i].misses > max) {
-      max = l1i_stats_table[eip_proc_id][i].misses;
+    if (l1i_core().stats_table[i].misses > max) {
+      max = l1i_core().stats_table[i].misses;
       max_addr = i;
     }
-    total_misses += l1i_stats_table[eip_proc_id][i].misses;
+    total_misses += l1i_core().stats_table[i].misses;
   }
   cout << hex << max_addr << " " << (max_addr << LOG2(ICACHE_LINE_SIZE)) << dec << " " << max << " / " << total_misses
        << endl;
@@ -198,11 +215,11 @@ void l1i_print_stats_table() {
   max_addr = 0;
   uint64_t total_hits = 0;
   for (uint32_t i = 0; i < L1I_STATS_TABLE_ENTRIES; i++) {
-    if (l1i_stats_table[eip_proc_id][i].hits > max) {
-      max = l1i_stats_table[eip_proc_id][i].hits;
+    if (l1i_core().stats_table[i].hits > max) {
+      max = l1i_core().stats_table[i].hits;
       max_addr = i;
     }
-    total_hits += l1i_stats_table[eip_proc_id][i].hits;
+    total_hits += l1i_core().stats_table[i].hits;
   }
   cout << hex << max_addr << " " << (max_addr << LOG2(ICACHE_LINE_SIZE)) << dec << " " << max << " / " << total_hits
        << endl;
@@ -211,11 +228,11 @@ void l1i_print_stats_table() {
   max_addr = 0;
   uint64_t total_late = 0;
   for (uint32_t i = 0; i < L1I_STATS_TABLE_ENTRIES; i++) {
-    if (l1i_stats_table[eip_proc_id][i].late > max) {
-      max = l1i_stats_table[eip_proc_id][i].late;
+    if (l1i_core().stats_table[i].late > max) {
+      max = l1i_core().stats_table[i].late;
       max_addr = i;
     }
-    total_late += l1i_stats_table[eip_proc_id][i].late;
+    total_late += l1i_core().stats_table[i].late;
   }
   cout << hex << max_addr << " " << (max_addr << LOG2(ICACHE_LINE_SIZE)) << dec << " " << max << " / " << total_late
        << endl;
@@ -224,11 +241,11 @@ void l1i_print_stats_table() {
   max_addr = 0;
   uint64_t total_wrong = 0;
   for (uint32_t i = 0; i < L1I_STATS_TABLE_ENTRIES; i++) {
-    if (l1i_stats_table[eip_proc_id][i].wrong > max) {
-      max = l1i_stats_table[eip_proc_id][i].wrong;
+    if (l1i_core().stats_table[i].wrong > max) {
+      max = l1i_core().stats_table[i].wrong;
       max_addr = i;
     }
-    total_wrong += l1i_stats_table[eip_proc_id][i].wrong;
+    total_wrong += l1i_core().stats_table[i].wrong;
   }
   cout << hex << max_addr << " " << (max_addr << LOG2(ICACHE_LINE_SIZE)) << dec << " " << max << " / " << total_wrong
        << endl;
@@ -311,28 +328,21 @@ typedef struct __l1i_hist_entry {
   uint32_t bb_size;    // L1I_MERGE_BBSIZE_BITS bits
 } l1i_hist_entry;
 
-// l1i_hist_entry l1i_hist_table[NUM_CPUS][L1I_HIST_TABLE_ENTRIES];
-std::vector<l1i_hist_entry *> l1i_hist_table;
-// uint64_t l1i_hist_table_head[NUM_CPUS]; // log_2 (L1I_HIST_TABLE_ENTRIES)
-std::vector<uint64_t> l1i_hist_table_head;  // log_2 (L1I_HIST_TABLE_ENTRIES)
-// uint64_t l1i_hist_table_head_time[NUM_CPUS]; // 64 bits
-std::vector<uint64_t> l1i_hist_table_head_time;  // 64 bits
-
 void l1i_init_hist_table() {
-  l1i_hist_table_head[eip_proc_id] = 0;
-  l1i_hist_table_head_time[eip_proc_id] = cycle_count;
+  l1i_core().hist_table_head = 0;
+  l1i_core().hist_table_head_time = cycle_count;
   for (uint32_t i = 0; i < L1I_HIST_TABLE_ENTRIES; i++) {
-    l1i_hist_table[eip_proc_id][i].tag = 0;
-    l1i_hist_table[eip_proc_id][i].time_diff = 0;
-    l1i_hist_table[eip_proc_id][i].bb_size = 0;
+    l1i_core().hist_table[i].tag = 0;
+    l1i_core().hist_table[i].time_diff = 0;
+    l1i_core().hist_table[i].bb_size = 0;
   }
 }
 
 uint64_t l1i_find_hist_entry(uint64_t line_addr) {
   uint64_t tag = line_addr & L1I_HIST_TAG_MASK;
-  for (uint32_t count = 0, i = (l1i_hist_table_head[eip_proc_id] + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES;
+  for (uint32_t count = 0, i = (l1i_core().hist_table_head + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES;
        count < L1I_HIST_TABLE_ENTRIES; count++, i = (i + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES) {
-    if (l1i_hist_table[eip_proc_id][i].tag == tag)
+    if (l1i_core().hist_table[i].tag == tag)
       return i;
   }
   return L1I_HIST_TABLE_ENTRIES;
@@ -341,41 +351,41 @@ uint64_t l1i_find_hist_entry(uint64_t line_addr) {
 // It can have duplicated entries if the line was evicted in between
 uint32_t l1i_add_hist_table(uint64_t line_addr) {
   // Insert empty addresses in hist not to have timediff overflows
-  while (cycle_count - l1i_hist_table_head_time[eip_proc_id] >= L1I_TIME_DIFF_OVERFLOW) {
-    l1i_hist_table[eip_proc_id][l1i_hist_table_head[eip_proc_id]].tag = 0;
-    l1i_hist_table[eip_proc_id][l1i_hist_table_head[eip_proc_id]].time_diff = L1I_TIME_DIFF_MASK;
-    l1i_hist_table[eip_proc_id][l1i_hist_table_head[eip_proc_id]].bb_size = 0;
-    l1i_hist_table_head[eip_proc_id] = (l1i_hist_table_head[eip_proc_id] + 1) % L1I_HIST_TABLE_ENTRIES;
-    l1i_hist_table_head_time[eip_proc_id] += L1I_TIME_DIFF_MASK;
+  while (cycle_count - l1i_core().hist_table_head_time >= L1I_TIME_DIFF_OVERFLOW) {
+    l1i_core().hist_table[l1i_core().hist_table_head].tag = 0;
+    l1i_core().hist_table[l1i_core().hist_table_head].time_diff = L1I_TIME_DIFF_MASK;
+    l1i_core().hist_table[l1i_core().hist_table_head].bb_size = 0;
+    l1i_core().hist_table_head = (l1i_core().hist_table_head + 1) % L1I_HIST_TABLE_ENTRIES;
+    l1i_core().hist_table_head_time += L1I_TIME_DIFF_MASK;
   }
 
   // Allocate a new entry (evict old one if necessary)
-  l1i_hist_table[eip_proc_id][l1i_hist_table_head[eip_proc_id]].tag = line_addr & L1I_HIST_TAG_MASK;
-  l1i_hist_table[eip_proc_id][l1i_hist_table_head[eip_proc_id]].time_diff =
-      (cycle_count - l1i_hist_table_head_time[eip_proc_id]) & L1I_TIME_DIFF_MASK;
-  l1i_hist_table[eip_proc_id][l1i_hist_table_head[eip_proc_id]].bb_size = 0;
-  uint32_t pos = l1i_hist_table_head[eip_proc_id];
-  l1i_hist_table_head[eip_proc_id] = (l1i_hist_table_head[eip_proc_id] + 1) % L1I_HIST_TABLE_ENTRIES;
-  l1i_hist_table_head_time[eip_proc_id] = cycle_count;
+  l1i_core().hist_table[l1i_core().hist_table_head].tag = line_addr & L1I_HIST_TAG_MASK;
+  l1i_core().hist_table[l1i_core().hist_table_head].time_diff =
+      (cycle_count - l1i_core().hist_table_head_time) & L1I_TIME_DIFF_MASK;
+  l1i_core().hist_table[l1i_core().hist_table_head].bb_size = 0;
+  uint32_t pos = l1i_core().hist_table_head;
+  l1i_core().hist_table_head = (l1i_core().hist_table_head + 1) % L1I_HIST_TABLE_ENTRIES;
+  l1i_core().hist_table_head_time = cycle_count;
   return pos;
 }
 
 void l1i_add_bb_size_hist_table(uint64_t line_addr, uint32_t bb_size) {
   uint64_t index = l1i_find_hist_entry(line_addr);
-  l1i_hist_table[eip_proc_id][index].bb_size = bb_size & L1I_MERGE_BBSIZE_MAX_VALUE;
+  l1i_core().hist_table[index].bb_size = bb_size & L1I_MERGE_BBSIZE_MAX_VALUE;
 }
 
 uint32_t l1i_find_bb_merge_hist_table(uint64_t line_addr) {
   uint64_t tag = line_addr & L1I_HIST_TAG_MASK;
-  for (uint32_t count = 0, i = (l1i_hist_table_head[eip_proc_id] + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES;
+  for (uint32_t count = 0, i = (l1i_core().hist_table_head + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES;
        count < L1I_HIST_TABLE_ENTRIES; count++, i = (i + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES) {
     if (count >= L1I_BB_MERGE_ENTRIES) {
       return 0;
     }
-    if (tag > l1i_hist_table[eip_proc_id][i].tag &&
-        (tag - l1i_hist_table[eip_proc_id][i].tag) <= l1i_hist_table[eip_proc_id][i].bb_size) {
-      //&& (tag - l1i_hist_table[eip_proc_id][i].tag) == l1i_hist_table[eip_proc_id][i].bb_size) {
-      return tag - l1i_hist_table[eip_proc_id][i].tag;
+    if (tag > l1i_core().hist_table[i].tag &&
+        (tag - l1i_core().hist_table[i].tag) <= l1i_core().hist_table[i].bb_size) {
+      //&& (tag - l1i_core().hist_table[i].tag) == l1i_core().hist_table[i].bb_size) {
+      return tag - l1i_core().hist_table[i].tag;
     }
   }
   ASSERT(eip_proc_id, false);
@@ -386,28 +396,28 @@ uint64_t l1i_get_src_entangled_hist_table(uint64_t line_addr, uint32_t pos_hist,
   ASSERT(eip_proc_id, pos_hist < L1I_HIST_TABLE_ENTRIES);
   uint64_t tag = line_addr & L1I_HIST_TAG_MASK;
   ASSERT(eip_proc_id, tag);
-  if (l1i_hist_table[eip_proc_id][pos_hist].tag != tag) {
+  if (l1i_core().hist_table[pos_hist].tag != tag) {
     l1i_stats_hist_lookups[L1I_HIST_TABLE_ENTRIES]++;
     return 0;  // removed
   }
   uint32_t next_pos = (pos_hist + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES;
-  uint32_t first = (l1i_hist_table_head[eip_proc_id] + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES;
-  uint64_t time_i = l1i_hist_table[eip_proc_id][pos_hist].time_diff;
+  uint32_t first = (l1i_core().hist_table_head + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES;
+  uint64_t time_i = l1i_core().hist_table[pos_hist].time_diff;
   uint32_t num_skipped = 0;
   for (uint32_t count = 0, i = next_pos; i != first; count++, i = (i + L1I_HIST_TABLE_MASK) % L1I_HIST_TABLE_ENTRIES) {
     // Against the time overflow
-    if (l1i_hist_table[eip_proc_id][i].tag == tag) {
+    if (l1i_core().hist_table[i].tag == tag) {
       return 0;  // Second time it appeared (it was evicted in between) or many for the same set. No entangle
     }
-    if (l1i_hist_table[eip_proc_id][i].tag && time_i >= latency) {
+    if (l1i_core().hist_table[i].tag && time_i >= latency) {
       if (skip == num_skipped) {
         l1i_stats_hist_lookups[count]++;
-        return l1i_hist_table[eip_proc_id][i].tag;
+        return l1i_core().hist_table[i].tag;
       } else {
         num_skipped++;
       }
     }
-    time_i += l1i_hist_table[eip_proc_id][i].time_diff;
+    time_i += l1i_core().hist_table[i].time_diff;
   }
   l1i_stats_hist_lookups[L1I_HIST_TABLE_ENTRIES + 1]++;
   return 0;
@@ -432,6 +442,7 @@ typedef struct __l1i_timing_mshr_entry {
   uint64_t timestamp;   // L1I_TIME_BITS bits // time when issued
   bool accessed;        // 1 bit
   uint32_t pos_hist;    // 1 bit
+  uint32_t next;        // next entry in the same bucket chain or free list
 } l1i_timing_mshr_entry;
 
 // We do not have access to the cache, so we aproximate it using this structure
@@ -443,26 +454,35 @@ typedef struct __l1i_timing_cache_entry {
   bool accessed;        // 1 bit
 } l1i_timing_cache_entry;
 
-// l1i_timing_mshr_entry l1i_timing_mshr_table[NUM_CPUS][L1I_TIMING_MSHR_SIZE];
-std::vector<l1i_timing_mshr_entry *> l1i_timing_mshr_table;
-// l1i_timing_cache_entry l1i_timing_cache_table[NUM_CPUS][L1I_SET][L1I_WAY];
-std::vector<l1i_timing_cache_entry **> l1i_timing_cache_table;
+// The timing MSHR is fully associative. Valid entries are chained off a bucket
+// picked by hashing their tag, and invalid ones form a free list, so lookups
+// and allocations no longer scan the whole table.
+uint32_t l1i_timing_mshr_bucket(uint64_t tag) {
+  return (uint32_t)((tag * 0x9E3779B97F4A7C15ULL) >> (64 - L1I_TIMING_MSHR_BUCKET_BITS));
+}
 
 void l1i_init_timing_tables() {
   for (uint32_t i = 0; i < L1I_TIMING_MSHR_SIZE; i++) {
-    l1i_timing_mshr_table[eip_proc_id][i].valid = 0;
+    l1i_core().timing_mshr_table[i].valid = 0;
+    l1i_core().timing_mshr_table[i].next = i + 1;
+  }
+  l1i_core().timing_mshr_free = 0;
+  for (uint32_t i = 0; i < (1U << L1I_TIMING_MSHR_BUCKET_BITS); i++) {
+    l1i_core().timing_mshr_buckets[i] = L1I_TIMING_MSHR_SIZE;
   }
   for (uint32_t i = 0; i < L1I_SET; i++) {
     for (uint32_t j = 0; j < L1I_WAY; j++) {
-      l1i_timing_cache_table[eip_proc_id][i][j].valid = 0;
+      l1i_core().timing_cache_table[i * L1I_WAY + j].valid = 0;
     }
   }
 }
 
 uint64_t l1i_find_timing_mshr_entry(uint64_t line_addr) {
-  for (uint32_t i = 0; i < L1I_TIMING_MSHR_SIZE; i++) {
-    if (l1i_timing_mshr_table[eip_proc_id][i].tag == (line_addr & L1I_TIMING_MSHR_TAG_MASK) &&
-        l1i_timing_mshr_table[eip_proc_id][i].valid)
+  uint64_t tag = line_addr & L1I_TIMING_MSHR_TAG_MASK;
+  l1i_timing_mshr_entry *table = l1i_core().timing_mshr_table;
+  for (uint32_t i = l1i_core().timing_mshr_buckets[l1i_timing_mshr_bucket(tag)]; i != L1I_TIMING_MSHR_SIZE;
+       i = table[i].next) {
+    if (table[i].tag == tag)
       return i;
   }
   return L1I_TIMING_MSHR_SIZE;
@@ -470,30 +490,29 @@ uint64_t l1i_find_timing_mshr_entry(uint64_t line_addr) {
 
 uint64_t l1i_find_timing_cache_entry(uint64_t line_addr) {
   uint64_t i = line_addr % L1I_SET;
+  l1i_timing_cache_entry *ways = l1i_core().timing_cache_table + i * L1I_WAY;
   for (uint32_t j = 0; j < L1I_WAY; j++) {
-    if (l1i_timing_cache_table[eip_proc_id][i][j].tag == ((line_addr >> L1I_SET_BITS) & L1I_TIMING_CACHE_TAG_MASK) &&
-        l1i_timing_cache_table[eip_proc_id][i][j].valid)
+    if (ways[j].tag == ((line_addr >> L1I_SET_BITS) & L1I_TIMING_CACHE_TAG_MASK) && ways[j].valid)
       return j;
   }
   return L1I_WAY;
 }
 
 uint32_t l1i_get_invalid_timing_mshr_entry() {
-  for (uint32_t i = 0; i < L1I_TIMING_MSHR_SIZE; i++) {
-    if (!l1i_timing_mshr_table[eip_proc_id][i].valid)
-      return i;
-  }
-  ASSERT(eip_proc_id, false);  // It must return a free entry
-  return L1I_TIMING_MSHR_SIZE;
+  uint32_t i = l1i_core().timing_mshr_free;
+  ASSERT(eip_proc_id, i < L1I_TIMING_MSHR_SIZE);  // It must return a free entry
+  l1i_core().timing_mshr_free = l1i_core().timing_mshr_table[i].next;
+  return i;
 }
 
 uint32_t l1i_get_invalid_timing_cache_entry(uint64_t line_addr) {
   uint32_t i = line_addr % L1I_SET;
+  l1i_timing_cache_entry *ways = l1i_core().timing_cache_table + i * L1I_WAY;
   DEBUG(eip_proc_id, "find a timing cache entry to invalidate for set %u\n", i);
   for (uint32_t j = 0; j < L1I_WAY; j++) {
-    if (l1i_timing_cache_table[eip_proc_id][i][j].tag == ((line_addr >> L1I_SET_BITS) & L1I_TIMING_CACHE_TAG_MASK))
+    if (ways[j].tag == ((line_addr >> L1I_SET_BITS) & L1I_TIMING_CACHE_TAG_MASK))
       return j;
-    if (!l1i_timing_cache_table[eip_proc_id][i][j].valid)
+    if (!ways[j].valid)
       return j;
   }
   ASSERT(eip_proc_id, false);  // It must return a free entry
@@ -508,43 +527,54 @@ void l1i_add_timing_entry(uint64_t line_addr, uint32_t source_set, uint32_t sour
     return;
 
   uint32_t i = l1i_get_invalid_timing_mshr_entry();
-  l1i_timing_mshr_table[eip_proc_id][i].valid = true;
-  l1i_timing_mshr_table[eip_proc_id][i].tag = line_addr & L1I_TIMING_MSHR_TAG_MASK;
-  l1i_timing_mshr_table[eip_proc_id][i].source_set = source_set;
-  l1i_timing_mshr_table[eip_proc_id][i].source_way = source_way;
-  l1i_timing_mshr_table[eip_proc_id][i].timestamp = cycle_count & L1I_TIME_MASK;
-  l1i_timing_mshr_table[eip_proc_id][i].accessed = false;
+  uint32_t bucket = l1i_timing_mshr_bucket(line_addr & L1I_TIMING_MSHR_TAG_MASK);
+  l1i_core().timing_mshr_table[i].valid = true;
+  l1i_core().timing_mshr_table[i].tag = line_addr & L1I_TIMING_MSHR_TAG_MASK;
+  l1i_core().timing_mshr_table[i].next = l1i_core().timing_mshr_buckets[bucket];
+  l1i_core().timing_mshr_buckets[bucket] = i;
+  l1i_core().timing_mshr_table[i].source_set = source_set;
+  l1i_core().timing_mshr_table[i].source_way = source_way;
+  l1i_core().timing_mshr_table[i].timestamp = cycle_count & L1I_TIME_MASK;
+  l1i_core().timing_mshr_table[i].accessed = false;
 }
 
 void l1i_invalid_timing_mshr_entry(uint64_t line_addr) {
-  uint32_t index = l1i_find_timing_mshr_entry(line_addr);
+  uint64_t tag = line_addr & L1I_TIMING_MSHR_TAG_MASK;
+  l1i_timing_mshr_entry *table = l1i_core().timing_mshr_table;
+  uint32_t *link = &l1i_core().timing_mshr_buckets[l1i_timing_mshr_bucket(tag)];
+  while (*link != L1I_TIMING_MSHR_SIZE && table[*link].tag != tag)
+    link = &table[*link].next;
+  uint32_t index = *link;
   ASSERT(eip_proc_id, index < L1I_TIMING_MSHR_SIZE);
-  l1i_timing_mshr_table[eip_proc_id][index].valid = false;
+  *link = table[index].next;
+  table[index].valid = false;
+  table[index].next = l1i_core().timing_mshr_free;
+  l1i_core().timing_mshr_free = index;
 }
 
 void l1i_move_timing_entry(uint64_t line_addr) {
   uint32_t index_mshr = l1i_find_timing_mshr_entry(line_addr);
   if (index_mshr == L1I_TIMING_MSHR_SIZE) {
     uint32_t set = line_addr % L1I_SET;
+    l1i_timing_cache_entry *ways = l1i_core().timing_cache_table + set * L1I_WAY;
     uint32_t index_cache = l1i_get_invalid_timing_cache_entry(line_addr);
-    l1i_timing_cache_table[eip_proc_id][set][index_cache].valid = true;
-    l1i_timing_cache_table[eip_proc_id][set][index_cache].tag = (line_addr >> L1I_SET_BITS) & L1I_TIMING_CACHE_TAG_MASK;
-    l1i_timing_cache_table[eip_proc_id][set][index_cache].source_way = L1I_ENTANGLED_TABLE_WAYS;
-    l1i_timing_cache_table[eip_proc_id][set][index_cache].accessed = true;
+    ways[index_cache].valid = true;
+    ways[index_cache].tag = (line_addr >> L1I_SET_BITS) & L1I_TIMING_CACHE_TAG_MASK;
+    ways[index_cache].source_way = L1I_ENTANGLED_TABLE_WAYS;
+    ways[index_cache].accessed = true;
     DEBUG(eip_proc_id, "fill timing_cache_entry at set %u index %u for 0x%lx icache_line_addr 0x%lx\n", set,
           index_cache, line_addr, line_addr << LOG2(ICACHE_LINE_SIZE));
     return;
   }
   uint64_t set = line_addr % L1I_SET;
+  l1i_timing_cache_entry *ways = l1i_core().timing_cache_table + set * L1I_WAY;
+  l1i_timing_mshr_entry *mshr = &l1i_core().timing_mshr_table[index_mshr];
   uint64_t index_cache = l1i_get_invalid_timing_cache_entry(line_addr);
-  l1i_timing_cache_table[eip_proc_id][set][index_cache].valid = true;
-  l1i_timing_cache_table[eip_proc_id][set][index_cache].tag = (line_addr >> L1I_SET_BITS) & L1I_TIMING_CACHE_TAG_MASK;
-  l1i_timing_cache_table[eip_proc_id][set][index_cache].source_set =
-      l1i_timing_mshr_table[eip_proc_id][index_mshr].source_set;
-  l1i_timing_cache_table[eip_proc_id][set][index_cache].source_way =
-      l1i_timing_mshr_table[eip_proc_id][index_mshr].source_way;
-  l1i_timing_cache_table[eip_proc_id][set][index_cache].accessed =
-      l1i_timing_mshr_table[eip_proc_id][index_mshr].accessed;
+  ways[index_cache].valid = true;
+  ways[index_cache].tag = (line_addr >> L1I_SET_BITS) & L1I_TIMING_CACHE_TAG_MASK;
+  ways[index_cache].source_set = mshr->source_set;
+  ways[index_cache].source_way = mshr->source_way;
+  ways[index_cache].accessed = mshr->accessed;
   l1i_invalid_timing_mshr_entry(line_addr);
   DEBUG(eip_proc_id, "fill timing_cache_entry at set %lu index %lu for 0x%lx icache_line_addr 0x%lx\n", set,
         index_cache, line_addr, line_addr << LOG2(ICACHE_LINE_SIZE));
@@ -553,47 +583,50 @@ void l1i_move_timing_entry(uint64_t line_addr) {
 // returns if accessed
 bool l1i_invalid_timing_cache_entry(uint64_t line_addr, uint32_t &source_set, uint32_t &source_way) {
   uint32_t set = line_addr % L1I_SET;
+  l1i_timing_cache_entry *ways = l1i_core().timing_cache_table + set * L1I_WAY;
   uint32_t way = l1i_find_timing_cache_entry(line_addr);
   ASSERT(eip_proc_id, way < L1I_WAY);
-  l1i_timing_cache_table[eip_proc_id][set][way].valid = false;
+  ways[way].valid = false;
   DEBUG(eip_proc_id, "invalidate timing_cache_entry at set %u index %u for 0x%lx icache_line_addr 0x%lx\n", set, way,
         line_addr, line_addr << LOG2(ICACHE_LINE_SIZE));
-  source_set = l1i_timing_cache_table[eip_proc_id][set][way].source_set;
-  source_way = l1i_timing_cache_table[eip_proc_id][set][way].source_way;
-  return l1i_timing_cache_table[eip_proc_id][set][way].accessed;
+  source_set = ways[way].source_set;
+  source_way = ways[way].source_way;
+  return ways[way].accessed;
 }
 
 void l1i_access_timing_entry(uint64_t line_addr, uint32_t pos_hist, uint32_t &source_set, uint32_t &source_way) {
   uint32_t index = l1i_find_timing_mshr_entry(line_addr);
   if (index < L1I_TIMING_MSHR_SIZE) {
-    if (!l1i_timing_mshr_table[eip_proc_id][index].accessed) {  // Prefetch accessed while in MSHR: late
-      l1i_timing_mshr_table[eip_proc_id][index].accessed = true;
-      l1i_timing_mshr_table[eip_proc_id][index].pos_hist = pos_hist;
-      if (l1i_timing_mshr_table[eip_proc_id][index].source_way < L1I_ENTANGLED_TABLE_WAYS) {
-        source_set = l1i_timing_mshr_table[eip_proc_id][index].source_set;
-        source_way = l1i_timing_mshr_table[eip_proc_id][index].source_way;
-        l1i_timing_mshr_table[eip_proc_id][index].source_set = 0;
-        l1i_timing_mshr_table[eip_proc_id][index].source_way = L1I_ENTANGLED_TABLE_WAYS;
+    if (!l1i_core().timing_mshr_table[index].accessed) {  // Prefetch accessed while in MSHR: late
+      l1i_core().timing_mshr_table[index].accessed = true;
+      l1i_core().timing_mshr_table[index].pos_hist = pos_hist;
+      if (l1i_core().timing_mshr_table[index].source_way < L1I_ENTANGLED_TABLE_WAYS) {
+        source_set = l1i_core().timing_mshr_table[index].source_set;
+        source_way = l1i_core().timing_mshr_table[index].source_way;
+        l1i_core().timing_mshr_table[index].source_set = 0;
+        l1i_core().timing_mshr_table[index].source_way = L1I_ENTANGLED_TABLE_WAYS;
       }
     }
     return;
   }
   uint32_t set = line_addr % L1I_SET;
+  l1i_timing_cache_entry *ways = l1i_core().timing_cache_table + set * L1I_WAY;
   uint32_t way = l1i_find_timing_cache_entry(line_addr);
   if (way < L1I_WAY) {
-    l1i_timing_cache_table[eip_proc_id][set][way].accessed = true;
+    ways[way].accessed = true;
   }
 }
 
 bool l1i_is_accessed_timing_entry(uint64_t line_addr) {
   uint32_t index = l1i_find_timing_mshr_entry(line_addr);
   if (index < L1I_TIMING_MSHR_SIZE) {
-    return l1i_timing_mshr_table[eip_proc_id][index].accessed;
+    return l1i_core().timing_mshr_table[index].accessed;
   }
   uint32_t set = line_addr % L1I_SET;
+  l1i_timing_cache_entry *ways = l1i_core().timing_cache_table + set * L1I_WAY;
   uint32_t way = l1i_find_timing_cache_entry(line_addr);
   if (way < L1I_WAY) {
-    return l1i_timing_cache_table[eip_proc_id][set][way].accessed;
+    return ways[way].accessed;
   }
   return false;
 }
@@ -613,17 +646,17 @@ bool l1i_ongoing_accessed_request(uint64_t line_addr) {
   uint32_t index = l1i_find_timing_mshr_entry(line_addr);
   if (index == L1I_TIMING_MSHR_SIZE)
     return false;
-  return l1i_timing_mshr_table[eip_proc_id][index].accessed;
+  return l1i_core().timing_mshr_table[index].accessed;
 }
 
 uint64_t l1i_get_latency_timing_mshr(uint64_t line_addr, uint32_t &pos_hist) {
   uint32_t index = l1i_find_timing_mshr_entry(line_addr);
   if (index == L1I_TIMING_MSHR_SIZE)
     return 0;
-  if (!l1i_timing_mshr_table[eip_proc_id][index].accessed)
+  if (!l1i_core().timing_mshr_table[index].accessed)
     return 0;
-  pos_hist = l1i_timing_mshr_table[eip_proc_id][index].pos_hist;
-  return l1i_get_latency(cycle_count, l1i_timing_mshr_table[eip_proc_id][index].timestamp);
+  pos_hist = l1i_core().timing_mshr_table[index].pos_hist;
+  return l1i_get_latency(cycle_count, l1i_core().timing_mshr_table[index].timestamp);
 }
 
 // ENTANGLED TABLE
@@ -650,6 +683,9 @@ uint64_t l1i_compress_format_entangled(uint64_t entangled_addr, uint32_t format)
 }
 
 #define L1I_MAX_ENTANGLED_PER_LINE L1I_ENTANGLED_NUM_FORMATS
+// a line's basic block plus every entangled line with its basic block
+#define L1I_MAX_PREFETCHES_PER_ACCESS \
+  (L1I_MERGE_BBSIZE_MAX_VALUE + L1I_MAX_ENTANGLED_PER_LINE * (L1I_MERGE_BBSIZE_MAX_VALUE + 1))
 
 uint32_t L1I_ENTANGLED_TABLE_SETS;
 uint32_t L1I_TAG_BITS;
@@ -660,44 +696,41 @@ uint32_t L1I_TAG_MASK;
 #define L1I_CONFIDENCE_COUNTER_THRESHOLD 1
 #define L1I_TRIES_AVAIL_ENTANGLED 2
 
+// fields are stored in the narrowest type that holds their width, widest first
 typedef struct __l1i_entangled_entry {
-  uint64_t tag;                                         // L1I_TAG_BITS bits
-  uint32_t format;                                      // log2(L1I_ENTANGLED_NUM_FORMATS) bits
   uint64_t entangled_addr[L1I_MAX_ENTANGLED_PER_LINE];  // JUST DIFF
-  uint32_t entangled_conf[L1I_MAX_ENTANGLED_PER_LINE];  // L1I_CONFIDENCE_COUNTER_BITS bits
-  uint32_t bb_size;                                     // L1I_MERGE_BBSIZE_BITS bits
+  uint32_t tag;                                         // L1I_TAG_BITS bits
+  uint8_t format;                                       // log2(L1I_ENTANGLED_NUM_FORMATS) bits
+  uint8_t bb_size;                                      // L1I_MERGE_BBSIZE_BITS bits
+  uint8_t entangled_conf[L1I_MAX_ENTANGLED_PER_LINE];   // L1I_CONFIDENCE_COUNTER_BITS bits
 } l1i_entangled_entry;
 
-// l1i_entangled_entry l1i_entangled_table[NUM_CPUS][L1I_ENTANGLED_TABLE_SETS][L1I_ENTANGLED_TABLE_WAYS];
-std::vector<l1i_entangled_entry **> l1i_entangled_table;
-// uint32_t l1i_entangled_fifo[NUM_CPUS][L1I_ENTANGLED_TABLE_SETS]; // log2(L1I_ENTANGLED_TABLE_WAYS) *
-// L1I_ENTANGLED_TABLE_SETS bits
-std::vector<uint32_t *> l1i_entangled_fifo;  // log2(L1I_ENTANGLED_TABLE_WAYS) * L1I_ENTANGLED_TABLE_SETS bits
-
 uint64_t l1i_hash(uint64_t line_addr) {
   return line_addr ^ (line_addr >> 2) ^ (line_addr >> 5);
 }
 
 void l1i_init_entangled_table() {
   for (uint32_t i = 0; i < L1I_ENTANGLED_TABLE_SETS; i++) {
+    l1i_entangled_entry *ways = l1i_core().entangled_table + i * L1I_ENTANGLED_TABLE_WAYS;
     for (uint32_t j = 0; j < L1I_ENTANGLED_TABLE_WAYS; j++) {
-      l1i_entangled_table[eip_proc_id][i][j].tag = 0;
-      l1i_entangled_table[eip_proc_id][i][j].format = 1;
+      ways[j].tag = 0;
+      ways[j].format = 1;
       for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-        l1i_entangled_table[eip_proc_id][i][j].entangled_addr[k] = 0;
-        l1i_entangled_table[eip_proc_id][i][j].entangled_conf[k] = 0;
+        ways[j].entangled_addr[k] = 0;
+        ways[j].entangled_conf[k] = 0;
       }
-      l1i_entangled_table[eip_proc_id][i][j].bb_size = 0;
+      ways[j].bb_size = 0;
     }
-    l1i_entangled_fifo[eip_proc_id][i] = 0;
+    l1i_core().entangled_fifo[i] = 0;
   }
 }
 
 uint32_t l1i_get_way_entangled_table(uint64_t line_addr) {
   uint64_t tag = (l1i_hash(line_addr) >> L1I_ENTANGLED_TABLE_INDEX_BITS) & L1I_TAG_MASK;
   uint32_t set = l1i_hash(line_addr) % L1I_ENTANGLED_TABLE_SETS;
+  l1i_entangled_entry *ways = l1i_core().entangled_table + set * L1I_ENTANGLED_TABLE_WAYS;
   for (uint32_t i = 0; i < L1I_ENTANGLED_TABLE_WAYS; i++) {
-    if (l1i_entangled_table[eip_proc_id][set][i].tag == tag) {  // Found
+    if (ways[i].tag == tag) {  // Found
       return i;
     }
   }
@@ -705,22 +738,23 @@ uint32_t l1i_get_way_entangled_table(uint64_t line_addr) {
 }
 
 void l1i_try_realocate_evicted_in_available_entangled_table(uint32_t set) {
-  uint64_t way = l1i_entangled_fifo[eip_proc_id][set];
+  l1i_entangled_entry *ways = l1i_core().entangled_table + set * L1I_ENTANGLED_TABLE_WAYS;
+  uint64_t way = l1i_core().entangled_fifo[set];
   bool dest_free_way = true;
   for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-    if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
+    if (ways[way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
       dest_free_way = false;
       break;
     }
   }
-  if (dest_free_way && l1i_entangled_table[eip_proc_id][set][way].bb_size == 0)
+  if (dest_free_way && ways[way].bb_size == 0)
     return;
   uint32_t free_way = way;
   bool free_with_size = false;
   for (uint32_t i = (way + 1) % L1I_ENTANGLED_TABLE_WAYS; i != way; i = (i + 1) % L1I_ENTANGLED_TABLE_WAYS) {
     bool dest_free = true;
     for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-      if (l1i_entangled_table[eip_proc_id][set][i].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
+      if (ways[i].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
         dest_free = false;
         break;
       }
@@ -728,8 +762,8 @@ void l1i_try_realocate_evicted_in_available_entangled_table(uint32_t set) {
     if (dest_free) {
       if (free_way == way) {
         free_way = i;
-        free_with_size = (l1i_entangled_table[eip_proc_id][set][i].bb_size != 0);
-      } else if (free_with_size && l1i_entangled_table[eip_proc_id][set][i].bb_size == 0) {
+        free_with_size = (ways[i].bb_size != 0);
+      } else if (free_with_size && ways[i].bb_size == 0) {
         free_way = i;
         free_with_size = false;
         break;
@@ -738,39 +772,37 @@ void l1i_try_realocate_evicted_in_available_entangled_table(uint32_t set) {
   }
   if (free_way != way &&
       ((!free_with_size) || (free_with_size && !dest_free_way))) {  // Only evict if it has more information
-    l1i_entangled_table[eip_proc_id][set][free_way].tag = l1i_entangled_table[eip_proc_id][set][way].tag;
-    l1i_entangled_table[eip_proc_id][set][free_way].format = l1i_entangled_table[eip_proc_id][set][way].format;
+    ways[free_way].tag = ways[way].tag;
+    ways[free_way].format = ways[way].format;
     for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-      l1i_entangled_table[eip_proc_id][set][free_way].entangled_addr[k] =
-          l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k];
-      l1i_entangled_table[eip_proc_id][set][free_way].entangled_conf[k] =
-          l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k];
+      ways[free_way].entangled_addr[k] = ways[way].entangled_addr[k];
+      ways[free_way].entangled_conf[k] = ways[way].entangled_conf[k];
     }
-    l1i_entangled_table[eip_proc_id][set][free_way].bb_size = l1i_entangled_table[eip_proc_id][set][way].bb_size;
+    ways[free_way].bb_size = ways[way].bb_size;
   }
 }
 
 void l1i_add_entangled_table(uint64_t line_addr, uint64_t entangled_addr) {
   uint64_t tag = (l1i_hash(line_addr) >> L1I_ENTANGLED_TABLE_INDEX_BITS) & L1I_TAG_MASK;
   uint32_t set = l1i_hash(line_addr) % L1I_ENTANGLED_TABLE_SETS;
+  l1i_entangled_entry *ways = l1i_core().entangled_table + set * L1I_ENTANGLED_TABLE_WAYS;
   uint32_t way = l1i_get_way_entangled_table(line_addr);
   if (way == L1I_ENTANGLED_TABLE_WAYS) {
     l1i_try_realocate_evicted_in_available_entangled_table(set);
-    way = l1i_entangled_fifo[eip_proc_id][set];
-    l1i_entangled_table[eip_proc_id][set][way].tag = tag;
-    l1i_entangled_table[eip_proc_id][set][way].format = 1;
+    way = l1i_core().entangled_fifo[set];
+    ways[way].tag = tag;
+    ways[way].format = 1;
     for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-      l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k] = 0;
-      l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] = 0;
+      ways[way].entangled_addr[k] = 0;
+      ways[way].entangled_conf[k] = 0;
     }
-    l1i_entangled_table[eip_proc_id][set][way].bb_size = 0;
-    l1i_entangled_fifo[eip_proc_id][set] = (l1i_entangled_fifo[eip_proc_id][set] + 1) % L1I_ENTANGLED_TABLE_WAYS;
+    ways[way].bb_size = 0;
+    l1i_core().entangled_fifo[set] = (l1i_core().entangled_fifo[set] + 1) % L1I_ENTANGLED_TABLE_WAYS;
   }
   for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-    if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD &&
-        l1i_extend_format_entangled(line_addr, l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k],
-                                    l1i_entangled_table[eip_proc_id][set][way].format) == entangled_addr) {
-      l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] = L1I_CONFIDENCE_COUNTER_MAX_VALUE;
+    if (ways[way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD &&
+        l1i_extend_format_entangled(line_addr, ways[way].entangled_addr[k], ways[way].format) == entangled_addr) {
+      ways[way].entangled_conf[k] = L1I_CONFIDENCE_COUNTER_MAX_VALUE;
       return;
     }
   }
@@ -786,43 +818,38 @@ void l1i_add_entangled_table(uint64_t line_addr, uint64_t entangled_addr) {
     uint32_t min_value = L1I_CONFIDENCE_COUNTER_MAX_VALUE + 1;
     uint32_t min_pos = 0;
     for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-      if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
+      if (ways[way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
         num_valid++;
         uint32_t format_k = l1i_get_format_entangled(
-            line_addr,
-            l1i_extend_format_entangled(line_addr, l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k],
-                                        l1i_entangled_table[eip_proc_id][set][way].format));
+            line_addr, l1i_extend_format_entangled(line_addr, ways[way].entangled_addr[k], ways[way].format));
         if (format_k < min_format) {
           min_format = format_k;
         }
-        if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] < min_value) {
-          min_value = l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k];
+        if (ways[way].entangled_conf[k] < min_value) {
+          min_value = ways[way].entangled_conf[k];
           min_pos = k;
         }
       }
     }
     if (num_valid > min_format) {  // Eviction is necessary. We chose the lower confidence one
       l1i_stats_evict_entangled_k_table++;
-      l1i_entangled_table[eip_proc_id][set][way].entangled_conf[min_pos] = 0;
+      ways[way].entangled_conf[min_pos] = 0;
     } else {
       // Reformat
       for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-        if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
-          l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k] = l1i_compress_format_entangled(
-              l1i_extend_format_entangled(line_addr, l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k],
-                                          l1i_entangled_table[eip_proc_id][set][way].format),
-              min_format);
+        if (ways[way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
+          ways[way].entangled_addr[k] = l1i_compress_format_entangled(
+              l1i_extend_format_entangled(line_addr, ways[way].entangled_addr[k], ways[way].format), min_format);
         }
       }
-      l1i_entangled_table[eip_proc_id][set][way].format = min_format;
+      ways[way].format = min_format;
       break;
     }
   }
   for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-    if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] < L1I_CONFIDENCE_COUNTER_THRESHOLD) {
-      l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k] =
-          l1i_compress_format_entangled(entangled_addr, l1i_entangled_table[eip_proc_id][set][way].format);
-      l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] = L1I_CONFIDENCE_COUNTER_MAX_VALUE;
+    if (ways[way].entangled_conf[k] < L1I_CONFIDENCE_COUNTER_THRESHOLD) {
+      ways[way].entangled_addr[k] = l1i_compress_format_entangled(entangled_addr, ways[way].format);
+      ways[way].entangled_conf[k] = L1I_CONFIDENCE_COUNTER_MAX_VALUE;
       return;
     }
   }
@@ -830,13 +857,13 @@ void l1i_add_entangled_table(uint64_t line_addr, uint64_t entangled_addr) {
 
 bool l1i_avail_entangled_table(uint64_t line_addr, uint64_t entangled_addr, bool insert_not_present) {
   uint32_t set = l1i_hash(line_addr) % L1I_ENTANGLED_TABLE_SETS;
+  l1i_entangled_entry *ways = l1i_core().entangled_table + set * L1I_ENTANGLED_TABLE_WAYS;
   uint32_t way = l1i_get_way_entangled_table(line_addr);
   if (way == L1I_ENTANGLED_TABLE_WAYS)
     return insert_not_present;
   for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-    if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD &&
-        l1i_extend_format_entangled(line_addr, l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k],
-                                    l1i_entangled_table[eip_proc_id][set][way].format) == entangled_addr) {
+    if (ways[way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD &&
+        l1i_extend_format_entangled(line_addr, ways[way].entangled_addr[k], ways[way].format) == entangled_addr) {
       return true;
     }
   }
@@ -844,12 +871,10 @@ bool l1i_avail_entangled_table(uint64_t line_addr, uint64_t entangled_addr, bool
   uint32_t min_format = l1i_get_format_entangled(line_addr, entangled_addr);
   uint32_t num_valid = 1;
   for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-    if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
+    if (ways[way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
       num_valid++;
       uint32_t format_k = l1i_get_format_entangled(
-          line_addr,
-          l1i_extend_format_entangled(line_addr, l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k],
-                                      l1i_entangled_table[eip_proc_id][set][way].format));
+          line_addr, l1i_extend_format_entangled(line_addr, ways[way].entangled_addr[k], ways[way].format));
       if (format_k < min_format) {
         min_format = format_k;
       }
@@ -865,61 +890,64 @@ bool l1i_avail_entangled_table(uint64_t line_addr, uint64_t entangled_addr, bool
 void l1i_add_bbsize_table(uint64_t line_addr, uint32_t bb_size) {
   uint64_t tag = (l1i_hash(line_addr) >> L1I_ENTANGLED_TABLE_INDEX_BITS) & L1I_TAG_MASK;
   uint32_t set = l1i_hash(line_addr) % L1I_ENTANGLED_TABLE_SETS;
+  l1i_entangled_entry *ways = l1i_core().entangled_table + set * L1I_ENTANGLED_TABLE_WAYS;
   uint32_t way = l1i_get_way_entangled_table(line_addr);
   if (way == L1I_ENTANGLED_TABLE_WAYS) {
     l1i_try_realocate_evicted_in_available_entangled_table(set);
-    way = l1i_entangled_fifo[eip_proc_id][set];
-    l1i_entangled_table[eip_proc_id][set][way].tag = tag;
-    l1i_entangled_table[eip_proc_id][set][way].format = 1;
+    way = l1i_core().entangled_fifo[set];
+    ways[way].tag = tag;
+    ways[way].format = 1;
     for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-      l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k] = 0;
-      l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] = 0;
+      ways[way].entangled_addr[k] = 0;
+      ways[way].entangled_conf[k] = 0;
     }
-    l1i_entangled_table[eip_proc_id][set][way].bb_size = 0;
-    l1i_entangled_fifo[eip_proc_id][set] = (l1i_entangled_fifo[eip_proc_id][set] + 1) % L1I_ENTANGLED_TABLE_WAYS;
+    ways[way].bb_size = 0;
+    l1i_core().entangled_fifo[set] = (l1i_core().entangled_fifo[set] + 1) % L1I_ENTANGLED_TABLE_WAYS;
   }
-  if (bb_size > l1i_entangled_table[eip_proc_id][set][way].bb_size) {
-    l1i_entangled_table[eip_proc_id][set][way].bb_size = bb_size & L1I_MERGE_BBSIZE_MAX_VALUE;
+  if (bb_size > ways[way].bb_size) {
+    ways[way].bb_size = bb_size & L1I_MERGE_BBSIZE_MAX_VALUE;
   }
   if (bb_size > l1i_stats_max_bb_size) {
     l1i_stats_max_bb_size = bb_size;
   }
 }
 
-uint64_t l1i_get_entangled_addr_entangled_table(uint64_t line_addr, uint32_t index_k, uint32_t &set, uint32_t &way) {
+// Fills entangled_addrs with every confident entangled line of line_addr (0 for the others), so a lookup walks
+// the set once for all of them
+void l1i_get_entangled_addrs_entangled_table(uint64_t line_addr, uint64_t *entangled_addrs, uint32_t &set,
+                                             uint32_t &way) {
   set = l1i_hash(line_addr) % L1I_ENTANGLED_TABLE_SETS;
+  l1i_entangled_entry *ways = l1i_core().entangled_table + set * L1I_ENTANGLED_TABLE_WAYS;
   way = l1i_get_way_entangled_table(line_addr);
-  if (way < L1I_ENTANGLED_TABLE_WAYS) {
-    if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[index_k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD) {
-      return l1i_extend_format_entangled(line_addr, l1i_entangled_table[eip_proc_id][set][way].entangled_addr[index_k],
-                                         l1i_entangled_table[eip_proc_id][set][way].format);
-    }
+  for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
+    entangled_addrs[k] = 0;
+    if (way < L1I_ENTANGLED_TABLE_WAYS && ways[way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD)
+      entangled_addrs[k] = l1i_extend_format_entangled(line_addr, ways[way].entangled_addr[k], ways[way].format);
   }
-  return 0;
 }
 
 uint32_t l1i_get_bbsize_entangled_table(uint64_t line_addr) {
   uint32_t set = l1i_hash(line_addr) % L1I_ENTANGLED_TABLE_SETS;
+  l1i_entangled_entry *ways = l1i_core().entangled_table + set * L1I_ENTANGLED_TABLE_WAYS;
   uint32_t way = l1i_get_way_entangled_table(line_addr);
   if (way < L1I_ENTANGLED_TABLE_WAYS) {
-    return l1i_entangled_table[eip_proc_id][set][way].bb_size;
+    return ways[way].bb_size;
   }
   return 0;
 }
 
 void l1i_update_confidence_entangled_table(uint32_t set, uint32_t way, uint64_t entangled_addr, bool accessed) {
+  l1i_entangled_entry *ways = l1i_core().entangled_table + set * L1I_ENTANGLED_TABLE_WAYS;
   if (way < L1I_ENTANGLED_TABLE_WAYS) {
     for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-      if (l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD &&
-          l1i_compress_format_entangled(l1i_entangled_table[eip_proc_id][set][way].entangled_addr[k],
-                                        l1i_entangled_table[eip_proc_id][set][way].format) ==
-              l1i_compress_format_entangled(entangled_addr, l1i_entangled_table[eip_proc_id][set][way].format)) {
-        if (accessed &&
-            l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] < L1I_CONFIDENCE_COUNTER_MAX_VALUE) {
-          l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k]++;
+      if (ways[way].entangled_conf[k] >= L1I_CONFIDENCE_COUNTER_THRESHOLD &&
+          l1i_compress_format_entangled(ways[way].entangled_addr[k], ways[way].format) ==
+              l1i_compress_format_entangled(entangled_addr, ways[way].format)) {
+        if (accessed && ways[way].entangled_conf[k] < L1I_CONFIDENCE_COUNTER_MAX_VALUE) {
+          ways[way].entangled_conf[k]++;
         }
-        if (!accessed && l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k] > 0) {
-          l1i_entangled_table[eip_proc_id][set][way].entangled_conf[k]--;
+        if (!accessed && ways[way].entangled_conf[k] > 0) {
+          ways[way].entangled_conf[k]--;
         }
       }
     }
@@ -927,6 +955,9 @@ void l1i_update_confidence_entangled_table(uint32_t set, uint32_t way, uint64_t
 }
 
 // INTERFACE
+
+#define L1I_ALIGN_TABLE(bytes) (((bytes) + 63) & ~(size_t)63)
+
 void alloc_mem_eip(uns numCores) {
   if (!EIP_ENABLE)
     return;
@@ -944,32 +975,49 @@ void alloc_mem_eip(uns numCores) {
   L1I_TIMING_MSHR_SIZE = FE_FTQ_BLOCK_NUM + L1I_MSHR_SIZE + L1I_RQ_SIZE;
   DEBUG(eip_proc_id, "L1I_RQ_SIZE: %d, L1I_SET: %d, L1I_WAY: %d, L1I_TIMING_MSHR_SIZE: %d\n", L1I_RQ_SIZE, L1I_SET,
         L1I_WAY, L1I_TIMING_MSHR_SIZE);
-  l1i_stats_table.resize(numCores);
-  for (auto it = l1i_stats_table.begin(); it != l1i_stats_table.end(); ++it)
-    *it = (l1i_stats_entry *)malloc(sizeof(l1i_stats_entry) * L1I_STATS_TABLE_ENTRIES);
-  l1i_hist_table.resize(numCores);
-  for (auto it = l1i_hist_table.begin(); it != l1i_hist_table.end(); ++it)
-    *it = (l1i_hist_entry *)malloc(sizeof(l1i_hist_entry) * L1I_HIST_TABLE_ENTRIES);
-  l1i_hist_table_head.resize(numCores);
-  l1i_hist_table_head_time.resize(numCores);
-  l1i_timing_mshr_table.resize(numCores);
-  for (auto it = l1i_timing_mshr_table.begin(); it != l1i_timing_mshr_table.end(); ++it)
-    *it = (l1i_timing_mshr_entry *)malloc(sizeof(l1i_timing_mshr_entry) * L1I_TIMING_MSHR_SIZE);
-  l1i_timing_cache_table.resize(numCores);
-  for (auto it = l1i_timing_cache_table.begin(); it != l1i_timing_cache_table.end(); ++it) {
-    *it = (l1i_timing_cache_entry **)malloc(sizeof(l1i_timing_cache_entry *) * L1I_SET);
-    for (uint32_t i = 0; i < L1I_SET; i++)
-      (*it)[i] = (l1i_timing_cache_entry *)malloc(sizeof(l1i_timing_cache_entry) * L1I_WAY);
-  }
-  l1i_entangled_table.resize(numCores);
-  for (auto it = l1i_entangled_table.begin(); it != l1i_entangled_table.end(); ++it) {
-    *it = (l1i_entangled_entry **)malloc(sizeof(l1i_entangled_entry *) * L1I_ENTANGLED_TABLE_SETS);
-    for (uint32_t i = 0; i < L1I_ENTANGLED_TABLE_SETS; i++)
-      (*it)[i] = (l1i_entangled_entry *)malloc(sizeof(l1i_entangled_entry) * L1I_ENTANGLED_TABLE_WAYS);
-  }
-  l1i_entangled_fifo.resize(numCores);
-  for (auto it = l1i_entangled_fifo.begin(); it != l1i_entangled_fifo.end(); ++it)
-    *it = (uint32_t *)malloc(sizeof(uint32_t) * L1I_ENTANGLED_TABLE_SETS);
+  L1I_TIMING_MSHR_BUCKET_BITS = LOG2(L1I_TIMING_MSHR_SIZE) + 2;  // chains average under one entry
+
+  // One allocation per core, each table starting on its own cache line. It
+  // comes zeroed from lazy_calloc, so the stats table lines a run never
+  // touches stay non-resident.
+  size_t stats_bytes = L1I_ALIGN_TABLE(sizeof(l1i_stats_entry) * L1I_STATS_TABLE_ENTRIES);
+  size_t hist_bytes = L1I_ALIGN_TABLE(sizeof(l1i_hist_entry) * L1I_HIST_TABLE_ENTRIES);
+  size_t mshr_bytes = L1I_ALIGN_TABLE(sizeof(l1i_timing_mshr_entry) * L1I_TIMING_MSHR_SIZE);
+  size_t buckets_bytes = L1I_ALIGN_TABLE(sizeof(uint32_t) << L1I_TIMING_MSHR_BUCKET_BITS);
+  size_t timing_cache_bytes = L1I_ALIGN_TABLE(sizeof(l1i_timing_cache_entry) * L1I_SET * L1I_WAY);
+  size_t entangled_bytes =
+      L1I_ALIGN_TABLE(sizeof(l1i_entangled_entry) * L1I_ENTANGLED_TABLE_SETS * L1I_ENTANGLED_TABLE_WAYS);
+  size_t fifo_bytes = L1I_ALIGN_TABLE(sizeof(uint32_t) * L1I_ENTANGLED_TABLE_SETS);
+  size_t total_bytes =
+      stats_bytes + hist_bytes + mshr_bytes + buckets_bytes + timing_cache_bytes + entangled_bytes + fifo_bytes;
+
+  l1i_cores.resize(numCores);
+  for (auto it = l1i_cores.begin(); it != l1i_cores.end(); ++it) {
+    char *next = (char *)lazy_calloc(1, total_bytes);
+    it->stats_table = (l1i_stats_entry *)next;
+    next += stats_bytes;
+    it->hist_table = (l1i_hist_entry *)next;
+    next += hist_bytes;
+    it->timing_mshr_table = (l1i_timing_mshr_entry *)next;
+    next += mshr_bytes;
+    it->timing_mshr_buckets = (uint32_t *)next;
+    next += buckets_bytes;
+    it->timing_cache_table = (l1i_timing_cache_entry *)next;
+    next += timing_cache_bytes;
+    it->entangled_table = (l1i_entangled_entry *)next;
+    next += entangled_bytes;
+    it->entangled_fifo = (uint32_t *)next;
+  }
+
+  for (uns proc_id = 0; proc_id < numCores; proc_id++) {
+    mem_footprint_add("eip.stats_table", proc_id, sizeof(l1i_stats_entry) * L1I_STATS_TABLE_ENTRIES);
+    mem_footprint_add("eip.hist_table", proc_id, sizeof(l1i_hist_entry) * L1I_HIST_TABLE_ENTRIES);
+    mem_footprint_add("eip.timing_mshr_table", proc_id, mshr_bytes + buckets_bytes);
+    mem_footprint_add("eip.timing_cache_table", proc_id, sizeof(l1i_timing_cache_entry) * L1I_SET * L1I_WAY);
+    mem_footprint_add("eip.entangled_table", proc_id,
+                      (sizeof(l1i_entangled_entry) * L1I_ENTANGLED_TABLE_WAYS + sizeof(uint32_t)) *
+                          L1I_ENTANGLED_TABLE_SETS);
+  }
 }
 
 void init_eip(uns proc_id) {
@@ -1003,15 +1051,15 @@ void eip_prefetch(uns proc_id, uint64_t v_addr, uint8_t cache_hit, uint8_t prefe
   if (cache_hit)
     ASSERT(eip_proc_id, l1i_find_timing_cache_entry(line_addr) < L1I_WAY);
 
-  l1i_stats_table[proc_id][(line_addr & L1I_STATS_TABLE_MASK)].accesses++;
+  l1i_cores[proc_id].stats_table[(line_addr & L1I_STATS_TABLE_MASK)].accesses++;
   if (!cache_hit) {
-    l1i_stats_table[proc_id][(line_addr & L1I_STATS_TABLE_MASK)].misses++;
+    l1i_cores[proc_id].stats_table[(line_addr & L1I_STATS_TABLE_MASK)].misses++;
     if (l1i_ongoing_request(line_addr) && !l1i_is_accessed_timing_entry(line_addr)) {
-      l1i_stats_table[proc_id][(line_addr & L1I_STATS_TABLE_MASK)].late++;
+      l1i_cores[proc_id].stats_table[(line_addr & L1I_STATS_TABLE_MASK)].late++;
     }
   }
   if (prefetch_hit) {
-    l1i_stats_table[proc_id][(line_addr & L1I_STATS_TABLE_MASK)].hits++;
+    l1i_cores[proc_id].stats_table[(line_addr & L1I_STATS_TABLE_MASK)].hits++;
   }
 
   bool consecutive = false;
@@ -1025,35 +1073,35 @@ void eip_prefetch(uns proc_id, uint64_t v_addr, uint8_t cache_hit, uint8_t prefe
   if (!FDIP_ENABLE)
     per_cyc_ipref = 0;
 
-  // Queue basic block prefetches
+  // Queue basic block prefetches, then the entangled lines and their basic blocks. They are issued as one batch
+  Addr pf_addrs[L1I_MAX_PREFETCHES_PER_ACCESS];
+  uint32_t pf_source_set[L1I_MAX_PREFETCHES_PER_ACCESS];
+  uint32_t pf_source_way[L1I_MAX_PREFETCHES_PER_ACCESS];
+  Mem_Queue_Req_Result pf_results[L1I_MAX_PREFETCHES_PER_ACCESS];
+  uint32_t num_pf = 0;
+
   uint32_t bb_size = l1i_get_bbsize_entangled_table(line_addr);
   if (bb_size)
     l1i_stats_basic_blocks[bb_size]++;
   for (uint32_t i = 1; i <= bb_size; i++) {
     uint64_t pf_addr = v_addr + i * (1 << LOG2(ICACHE_LINE_SIZE));
     if (!l1i_ongoing_request(pf_addr >> LOG2(ICACHE_LINE_SIZE))) {
-      Flag success = FALSE;
       // TODO : limit per-cycle prefetches
       // if (per_cyc_ipref < IPRF_MAX_FTQ_ENTRY_CYC)
-      success =
-          new_mem_req(MRT_IPRF, eip_proc_id, pf_addr, ICACHE_LINE_SIZE, 0, NULL, instr_fill_line, unique_count, 0);
-      if (success) {
-        DEBUG(proc_id, "new_mem_req (BB pref) for v_addr 0x%lx,line_addr 0x%lx  pf_addr 0x%lx, unique_count: %llu\n",
-              v_addr, v_addr & ~0x3F, pf_addr, unique_count);
-        if (!off_path)
-          l1i_add_timing_entry(pf_addr >> LOG2(ICACHE_LINE_SIZE), 0, L1I_ENTANGLED_TABLE_WAYS);
-        // if (success == Mem_Queue_Req_Result::SUCCESS_NEW)
-        // per_cyc_ipref++;
-      }
+      pf_addrs[num_pf] = pf_addr;
+      pf_source_set[num_pf] = 0;
+      pf_source_way[num_pf] = L1I_ENTANGLED_TABLE_WAYS;
+      num_pf++;
     }
   }
 
-  // Queue entangled and basic block of entangled prefetches
   uint32_t num_entangled = 0;
+  uint32_t entangled_set = 0;
+  uint32_t entangled_way = L1I_ENTANGLED_TABLE_WAYS;
+  uint64_t entangled_addrs[L1I_MAX_ENTANGLED_PER_LINE];
+  l1i_get_entangled_addrs_entangled_table(line_addr, entangled_addrs, entangled_set, entangled_way);
   for (uint32_t k = 0; k < L1I_MAX_ENTANGLED_PER_LINE; k++) {
-    uint32_t source_set = 0;
-    uint32_t source_way = L1I_ENTANGLED_TABLE_WAYS;
-    uint64_t entangled_line_addr = l1i_get_entangled_addr_entangled_table(line_addr, k, source_set, source_way);
+    uint64_t entangled_line_addr = entangled_addrs[k];
     if (entangled_line_addr && (entangled_line_addr != line_addr)) {
       num_entangled++;
       uint32_t bb_size = l1i_get_bbsize_entangled_table(entangled_line_addr);
@@ -1062,23 +1110,25 @@ void eip_prefetch(uns proc_id, uint64_t v_addr, uint8_t cache_hit, uint8_t prefe
       for (uint32_t i = 0; i <= bb_size; i++) {
         uint64_t pf_line_addr = entangled_line_addr + i;
         if (!l1i_ongoing_request(pf_line_addr)) {
-          Flag success = FALSE;
-          // TODO : limit per-cycle prefetches
-          // if (per_cyc_ipref < IPRF_MAX_FTQ_ENTRY_CYC)
-          success = new_mem_req(MRT_IPRF, eip_proc_id, pf_line_addr << LOG2(ICACHE_LINE_SIZE), ICACHE_LINE_SIZE, 0,
-                                NULL, instr_fill_line, unique_count, 0);
-          if (success) {
-            DEBUG(proc_id, "new_mem_req (Entangled pref) for 0x%lx, unique_count: %llu\n",
-                  pf_line_addr << LOG2(ICACHE_LINE_SIZE), unique_count);
-            if (!off_path)
-              l1i_add_timing_entry(pf_line_addr, source_set, (i == 0) ? source_way : L1I_ENTANGLED_TABLE_WAYS);
-            // if (success == Mem_Queue_Req_Result::SUCCESS_NEW)
-            // per_cyc_ipref++;
-          }
+          pf_addrs[num_pf] = pf_line_addr << LOG2(ICACHE_LINE_SIZE);
+          pf_source_set[num_pf] = entangled_set;
+          pf_source_way[num_pf] = (i == 0) ? entangled_way : L1I_ENTANGLED_TABLE_WAYS;
+          num_pf++;
         }
       }
     }
   }
+
+  new_mem_req_batch(MRT_IPRF, eip_proc_id, pf_addrs, num_pf, instr_fill_line, unique_count, NULL, pf_results);
+  for (uint32_t i = 0; i < num_pf; i++) {
+    if (pf_results[i] != FAILED) {
+      DEBUG(proc_id, "new_mem_req (EIP pref) for 0x%llx, unique_count: %llu\n", pf_addrs[i], unique_count);
+      if (!off_path)
+        l1i_add_timing_entry(pf_addrs[i] >> LOG2(ICACHE_LINE_SIZE), pf_source_set[i], pf_source_way[i]);
+      // if (pf_results[i] == SUCCESS_NEW)
+      // per_cyc_ipref++;
+    }
+  }
   if (num_entangled)
     l1i_stats_entangled[num_entangled]++;
 
@@ -1157,7 +1207,7 @@ void eip_cache_fill(uns proc_id, uint64_t v_addr, uint64_t evicted_v_addr) {
     uint32_t source_way = L1I_ENTANGLED_TABLE_WAYS;
     bool accessed = l1i_invalid_timing_cache_entry(evicted_line_addr, source_set, source_way);
     if (!accessed) {
-      l1i_stats_table[proc_id][(evicted_line_addr & L1I_STATS_TABLE_MASK)].wrong++;
+      l1i_cores[proc_id].stats_table[(evicted_line_addr & L1I_STATS_TABLE_MASK)].wrong++;
     }
     if (source_way < L1I_ENTANGLED_TABLE_WAYS) {
       // If accessed hit, but if not wrong
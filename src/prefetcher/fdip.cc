@@ -5,6 +5,7 @@
 #include "decoupled_frontend.h"
 #include "sim.h"
 
+#include "prefetcher/fdip_line_stats.hpp"
 #include "prefetcher/udp.hpp"
 #include "prefetcher/uftq.hpp"
 
@@ -64,7 +65,13 @@ class FDIP_Stat {
         last_recover_cycle(0),
         cur_line_delay(0),
         ftq_occupancy_ops(0),
-        ftq_occupancy_blocks(0) {}
+        ftq_occupancy_blocks(0) {
+    if (FDIP_LINE_STATS == FDIP_LINE_STATS_COMPACT) {
+      line_table.init(FDIP_LINE_STATS_ENTRIES);
+      miss_top_k.init(FDIP_LINE_STATS_SKETCH_WIDTH, FDIP_LINE_STATS_TOP_K);
+      delay_top_k.init(FDIP_LINE_STATS_SKETCH_WIDTH, FDIP_LINE_STATS_TOP_K);
+    }
+  }
   void inc_prefetched_cls(Addr line_addr, Flag on_path, uns success);
   void not_prefetch(Addr line_addr);
   void print_cl_info(Icache_Stage* ic_ref);
@@ -75,8 +82,12 @@ class FDIP_Stat {
   void probe_prefetched_cls(Addr line_addr);
   void inc_icache_hit(Addr line_addr);
   void inc_cnt_unuseful(Addr line_addr);
+  void add_seq(Addr line_addr, char event, Counter cyc);
 
  private:
+  FDIP_Line_Counters* compact_line(Addr line_addr, char event);
+  void print_compact_cl_info(Icache_Stage* ic_ref);
+
   /* global variables for utility study and stats */
   // for icache miss stats
   uns last_imiss_reason;
@@ -138,6 +149,10 @@ class FDIP_Stat {
   // accumulated FTQ occupancy every cycle
   uint64_t ftq_occupancy_ops;
   uint64_t ftq_occupancy_blocks;
+  // FDIP_LINE_STATS_COMPACT: per-line counters, most-missed lines and lines with the largest miss delay
+  FDIP_Line_Table line_table;
+  FDIP_Line_Top_K miss_top_k;
+  FDIP_Line_Top_K delay_top_k;
   friend class FDIP;
 };
 
@@ -201,7 +216,7 @@ class FDIP {
 };
 
 /* Global Variables */
-FDIP* fdip = NULL;
+CORE_LOCAL FDIP* fdip = NULL;
 
 // Per core FDIP
 vector<FDIP> per_core_fdip;
@@ -381,7 +396,27 @@ Counter fdip_get_last_recover_cycle() {
 }
 
 /* FDIP_Stat member functions */
+static inline Flag fdip_line_stats_exact() {
+  return FDIP_LINE_STATS == FDIP_LINE_STATS_EXACT;
+}
+
+static inline Flag fdip_line_stats_compact() {
+  return FDIP_LINE_STATS == FDIP_LINE_STATS_COMPACT;
+}
+
+// the useful/unuseful maps are also the infinite utility hash
+static inline Flag fdip_utility_maps_on() {
+  return FDIP_UTILITY_HASH_ENABLE || fdip_line_stats_exact();
+}
+
 void FDIP_Stat::print_cl_info(Icache_Stage* ic_ref) {
+  if (fdip_line_stats_compact()) {
+    print_compact_cl_info(ic_ref);
+    return;
+  }
+  if (!fdip_line_stats_exact())
+    return;
+
   uns proc_id = fdip->get_proc_id();
   DEBUG(proc_id,
         "icache miss cache lines (UNIQUE_MISSED_LINES) size: %lu, icache hit cache lines (UNIQUE_MISSED_LINES): %lu\n",
@@ -499,96 +534,166 @@ void FDIP_Stat::print_cl_info(Icache_Stage* ic_ref) {
   fclose(fp);
 }
 
-void FDIP_Stat::inc_cnt_useful_signed(Addr line_addr) {
-  auto it = cnt_useful_signed.find(line_addr);
-  if (it == cnt_useful_signed.end())
-    cnt_useful_signed.insert(pair<Addr, int64_t>(line_addr, UDP_USEFUL_THRESHOLD + UDP_WEIGHT_USEFUL));
-  else if (it->second + UDP_WEIGHT_USEFUL <= UDP_WEIGHT_POSITIVE_SATURATION)
-    it->second += UDP_WEIGHT_USEFUL;
-
-  uns8 useful_value = fdip->get_warmed_up() ? 3 : 1;
-  auto it2 = useful_sequence.find(line_addr);
-  if (it2 == useful_sequence.end()) {
-    useful_sequence.insert(make_pair(line_addr, vector<uns8>()));
-    useful_sequence[line_addr].push_back(useful_value);
-  } else {
-    it2->second.push_back(useful_value);
+void FDIP_Stat::print_compact_cl_info(Icache_Stage* ic_ref) {
+  uns proc_id = fdip->get_proc_id();
+  const vector<FDIP_Line_Counters>& lines = line_table.get_entries();
+  Counter missed_lines = 0;
+  Counter hit_lines = 0;
+  for (auto it = lines.begin(); it != lines.end(); ++it) {
+    missed_lines += it->valid && it->icache_miss[0];
+    hit_lines += it->valid && it->icache_hit[0];
   }
+  DEBUG(proc_id, "tracked lines: %u, untracked line events: %llu\n", line_table.get_num_valid(),
+        line_table.get_untracked());
+  INC_STAT_EVENT(proc_id, ICACHE_UNIQUE_MISSED_LINES, missed_lines);
+  INC_STAT_EVENT(proc_id, ICACHE_UNIQUE_HIT_LINES, hit_lines);
+  vector<pair<Addr, Counter>> most_missed = miss_top_k.sorted();
+  for (auto it = most_missed.begin(); it != most_missed.end(); ++it) {
+    DEBUG(proc_id, "[set %u] 0x%llx missed about %llu times\n",
+          (uns)(it->first >> ic_ref->icache.shift_bits & ic_ref->icache.set_mask), it->first, it->second);
+  }
+
+  FILE* fp = fopen("per_line_icache_line_info.csv", "w");
+  FILE* fp_aw = fopen("per_line_icache_line_info_after_warmup.csv", "w");
+  fprintf(fp, "cl_addr,useful_cnt,unuseful_cnt,prefetch_cnt,new_prefetch_cnt,icache_hit,icache_miss\n");
+  fprintf(fp_aw, "cl_addr,useful_cnt,unuseful_cnt,prefetch_cnt,new_prefetch_cnt,icache_hit,icache_miss\n");
+  for (auto it = lines.begin(); it != lines.end(); ++it) {
+    if (!it->valid)
+      continue;
+    if (it->prefetched[0] && !it->useful[0])
+      DEBUG(proc_id, "Unuseful 0x%llx prefetched %u times\n", it->line_addr, it->prefetched[0]);
+    if (it->aw_events == 2 && it->aw_first[0] == 'P' && it->aw_first[1] == 'u')
+      STAT_EVENT(proc_id, FDIP_PREFETCH_EVICT_NO_HIT_ONLY_ONCE);
+    for (uns aw = 0; aw < 2; aw++) {
+      if (it->useful[aw] || it->unuseful[aw])
+        fprintf(aw ? fp_aw : fp, "%llx,%u,%u,%u,%u,%u,%u\n", it->line_addr, it->useful[aw], it->unuseful[aw],
+                it->prefetched[aw], it->new_prefetched[aw], it->icache_hit[aw], it->icache_miss[aw]);
+    }
+  }
+  fclose(fp);
+  fclose(fp_aw);
+
+  vector<pair<Addr, Counter>> most_delayed = delay_top_k.sorted();
+  fp = fopen("per_line_delay.csv", "w");
+  fprintf(fp, "cl_addr,delay\n");
+  for (auto it = most_delayed.begin(); it != most_delayed.end(); ++it) {
+    fprintf(fp, "%llx,%lld\n", it->first, it->second);
+  }
+  fclose(fp);
 }
 
-void FDIP_Stat::inc_cnt_unuseful(Addr line_addr) {
-  uns proc_id = fdip->get_proc_id();
-  auto unuseful_iter = cnt_unuseful.find(line_addr);
-  if (unuseful_iter == cnt_unuseful.end()) {
-    STAT_EVENT(proc_id, ICACHE_UNUSEFUL_FETCHES);
-    cnt_unuseful.insert(make_pair(move(line_addr), 1));
+FDIP_Line_Counters* FDIP_Stat::compact_line(Addr line_addr, char event) {
+  Flag inserted;
+  FDIP_Line_Counters* line = line_table.lookup(line_addr, &inserted);
+  if (!line) {
+    STAT_EVENT(fdip->get_proc_id(), FDIP_LINE_STATS_UNTRACKED);
+    return NULL;
+  }
+  if (fdip->get_warmed_up()) {
+    if (line->aw_events < 2)
+      line->aw_first[line->aw_events] = event;
+    if (line->aw_events < 0xffff)
+      line->aw_events++;
   } else {
-    unuseful_iter->second++;
+    line->bw_events |= FDIP_LINE_BW_SEEN;
+    if (event == 'p')
+      line->bw_events |= FDIP_LINE_BW_NO_PREF;
+    else if (event == 'U')
+      line->bw_events |= FDIP_LINE_BW_USEFUL;
+    else if (event == 'u')
+      line->bw_events |= FDIP_LINE_BW_UNUSEFUL;
   }
+  return line;
+}
 
-  if (fdip->get_warmed_up()) {
-    auto it = cnt_unuseful_aw.find(line_addr);
-    if (it == cnt_unuseful_aw.end())
-      cnt_unuseful_aw.insert(make_pair(move(line_addr), 1));
-    else
-      it->second++;
+void FDIP_Stat::add_seq(Addr line_addr, char event, Counter cyc) {
+  if (fdip_line_stats_compact()) {
+    compact_line(line_addr, event);
+    return;
+  }
+  if (!fdip_line_stats_exact())
+    return;
+  auto* sequence = fdip->get_warmed_up() ? &sequence_aw : &sequence_bw;
+  (*sequence)[line_addr].push_back(make_pair(event, cyc));
+}
+
+void FDIP_Stat::inc_cnt_useful_signed(Addr line_addr) {
+  if (fdip_utility_maps_on()) {
+    auto it = cnt_useful_signed.find(line_addr);
+    if (it == cnt_useful_signed.end())
+      cnt_useful_signed.insert(pair<Addr, int64_t>(line_addr, UDP_USEFUL_THRESHOLD + UDP_WEIGHT_USEFUL));
+    else if (it->second + UDP_WEIGHT_USEFUL <= UDP_WEIGHT_POSITIVE_SATURATION)
+      it->second += UDP_WEIGHT_USEFUL;
+  }
+
+  if (fdip_line_stats_exact()) {
+    uns8 useful_value = fdip->get_warmed_up() ? 3 : 1;
+    useful_sequence[line_addr].push_back(useful_value);
+  }
+}
 
-    auto it2 = sequence_aw.find(line_addr);
-    if (it2 == sequence_aw.end()) {
-      sequence_aw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_aw[line_addr].push_back(make_pair('u', cycle_count));
+void FDIP_Stat::inc_cnt_unuseful(Addr line_addr) {
+  uns proc_id = fdip->get_proc_id();
+  if (fdip_utility_maps_on()) {
+    auto unuseful_iter = cnt_unuseful.find(line_addr);
+    if (unuseful_iter == cnt_unuseful.end()) {
+      STAT_EVENT(proc_id, ICACHE_UNUSEFUL_FETCHES);
+      cnt_unuseful.insert(make_pair(move(line_addr), 1));
     } else {
-      it2->second.push_back(make_pair('u', cycle_count));
+      unuseful_iter->second++;
     }
-  } else {
-    auto it2 = sequence_bw.find(line_addr);
-    if (it2 == sequence_bw.end()) {
-      sequence_bw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_bw[line_addr].push_back(make_pair('u', cycle_count));
-    } else {
-      it2->second.push_back(make_pair('u', cycle_count));
+  }
+
+  if (fdip_line_stats_compact()) {
+    FDIP_Line_Counters* line = compact_line(line_addr, 'u');
+    if (line) {
+      if (!line->unuseful[0] && !fdip_utility_maps_on())
+        STAT_EVENT(proc_id, ICACHE_UNUSEFUL_FETCHES);
+      line->unuseful[0]++;
+      line->unuseful[1] += fdip->get_warmed_up();
     }
+  } else if (fdip_line_stats_exact()) {
+    if (fdip->get_warmed_up())
+      cnt_unuseful_aw[line_addr]++;
+    add_seq(line_addr, 'u', cycle_count);
   }
 }
 
 void FDIP_Stat::inc_cnt_useful(Addr line_addr, Flag pref_miss) {
   uns proc_id = fdip->get_proc_id();
-  auto useful_iter = cnt_useful.find(line_addr);
-  DEBUG(proc_id, "cnt_useful size %ld\n", cnt_useful.size());
-  if (useful_iter == cnt_useful.end()) {
-    DEBUG(proc_id, "%llx useful line new insert\n", line_addr);
-    STAT_EVENT(proc_id, ICACHE_USEFUL_FETCHES);
-    cnt_useful.insert(make_pair(move(line_addr), make_pair(1, pref_miss)));
-  } else {
-    useful_iter->second.first++;
-    useful_iter->second.second = pref_miss;
-  }
-  DEBUG(proc_id, "cnt_useful size after inserted %ld\n", cnt_useful.size());
-
-  if (fdip->get_warmed_up()) {
-    auto it = cnt_useful_aw.find(line_addr);
-    if (it == cnt_useful_aw.end())
-      cnt_useful_aw.insert(make_pair(move(line_addr), make_pair(1, pref_miss)));
-    else {
-      it->second.first++;
-      it->second.second = pref_miss;
+  if (fdip_utility_maps_on()) {
+    auto useful_iter = cnt_useful.find(line_addr);
+    DEBUG(proc_id, "cnt_useful size %ld\n", cnt_useful.size());
+    if (useful_iter == cnt_useful.end()) {
+      DEBUG(proc_id, "%llx useful line new insert\n", line_addr);
+      STAT_EVENT(proc_id, ICACHE_USEFUL_FETCHES);
+      cnt_useful.insert(make_pair(move(line_addr), make_pair(1, pref_miss)));
+    } else {
+      useful_iter->second.first++;
+      useful_iter->second.second = pref_miss;
     }
+    DEBUG(proc_id, "cnt_useful size after inserted %ld\n", cnt_useful.size());
+  }
 
-    auto it2 = sequence_aw.find(line_addr);
-    if (it2 == sequence_aw.end()) {
-      sequence_aw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_aw[line_addr].push_back(make_pair('U', cycle_count));
-    } else {
-      it2->second.push_back(make_pair('U', cycle_count));
+  if (fdip_line_stats_compact()) {
+    FDIP_Line_Counters* line = compact_line(line_addr, 'U');
+    if (line) {
+      if (!line->useful[0] && !fdip_utility_maps_on())
+        STAT_EVENT(proc_id, ICACHE_USEFUL_FETCHES);
+      line->useful[0]++;
+      line->useful[1] += fdip->get_warmed_up();
     }
-  } else {
-    auto iter = sequence_bw.find(line_addr);
-    if (iter == sequence_bw.end()) {
-      sequence_bw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_bw[line_addr].push_back(make_pair('U', cycle_count));
-    } else {
-      iter->second.push_back(make_pair('U', cycle_count));
+  } else if (fdip_line_stats_exact()) {
+    if (fdip->get_warmed_up()) {
+      auto it = cnt_useful_aw.find(line_addr);
+      if (it == cnt_useful_aw.end())
+        cnt_useful_aw.insert(make_pair(move(line_addr), make_pair(1, pref_miss)));
+      else {
+        it->second.first++;
+        it->second.second = pref_miss;
+      }
     }
+    add_seq(line_addr, 'U', cycle_count);
   }
 }
 
@@ -599,29 +704,44 @@ void FDIP_Stat::probe_prefetched_cls(Addr line_addr) {
 }
 
 void FDIP_Stat::not_prefetch(Addr line_addr) {
-  if (fdip->get_warmed_up()) {
-    auto it = sequence_aw.find(line_addr);
-    Counter onoff_cycle_count = fdip_off_path() ? -cycle_count : cycle_count;
-    if (it == sequence_aw.end()) {
-      sequence_aw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_aw[line_addr].push_back(make_pair('p', onoff_cycle_count));
-    } else {
-      it->second.push_back(make_pair('p', onoff_cycle_count));
-    }
-  } else {
-    auto it = sequence_bw.find(line_addr);
-    Counter onoff_cycle_count = fdip_off_path() ? -cycle_count : cycle_count;
-    if (it == sequence_bw.end()) {
-      sequence_bw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_bw[line_addr].push_back(make_pair('p', onoff_cycle_count));
-    } else {
-      it->second.push_back(make_pair('p', onoff_cycle_count));
-    }
-  }
+  add_seq(line_addr, 'p', fdip_off_path() ? -cycle_count : cycle_count);
 }
 
 void FDIP_Stat::inc_icache_miss(Addr line_addr) {
   uns proc_id = fdip->get_proc_id();
+  if (fdip_line_stats_compact()) {
+    miss_top_k.add(line_addr, 1);
+    FDIP_Line_Counters* line = compact_line(line_addr, 'm');
+    if (fdip->get_warmed_up())
+      cur_line_delay = cycle_count;
+    if (!line)
+      return;
+    Flag first_icache_access = !line->icache_hit[0] && !line->icache_miss[0];
+    if (!line->icache_miss[0])
+      STAT_EVENT(proc_id, UNIQUE_MISSED_LINES);
+    line->icache_miss[0]++;
+    line->icache_miss[1] += fdip->get_warmed_up();
+    if (first_icache_access && fdip->get_warmed_up()) {
+      // same classification as the walk over sequence_bw below
+      if (line->bw_events & FDIP_LINE_BW_SEEN) {
+        STAT_EVENT(proc_id, ICACHE_FIRST_MISS_AFTER_WARMUP_SEEN_DURING_WARMUP);
+        Flag no_pref = line->bw_events & FDIP_LINE_BW_NO_PREF;
+        Flag useful = line->bw_events & FDIP_LINE_BW_UNUSEFUL;
+        Flag unuseful = line->bw_events & FDIP_LINE_BW_USEFUL;
+        if (no_pref && !unuseful && !useful)
+          STAT_EVENT(proc_id, ICACHE_FIRST_MISS_AFTER_WARMUP_NO_PREF_DURING_WARMUP);
+        if (!no_pref && unuseful && !useful)
+          STAT_EVENT(proc_id, ICACHE_FIRST_MISS_AFTER_WARMUP_TRAINED_UNUSEFUL_DURING_WARMUP);
+        if (!no_pref && !unuseful && useful)
+          STAT_EVENT(proc_id, ICACHE_FIRST_MISS_AFTER_WARMUP_TRAINED_USEFUL_DURING_WARMUP);
+      } else
+        STAT_EVENT(proc_id, ICACHE_FIRST_MISS_AFTER_WARMUP_NOT_SEEN_DURING_WARMUP);
+    }
+    return;
+  }
+  if (!fdip_line_stats_exact())
+    return;
+
   auto cl_iter = icache_miss.find(line_addr);
   if (cl_iter == icache_miss.end()) {
     STAT_EVENT(proc_id, UNIQUE_MISSED_LINES);
@@ -630,30 +750,10 @@ void FDIP_Stat::inc_icache_miss(Addr line_addr) {
     cl_iter->second++;
 
   if (fdip->get_warmed_up()) {
-    auto it = icache_miss_aw.find(line_addr);
-    if (it == icache_miss_aw.end())
-      icache_miss_aw.insert(pair<Addr, Counter>(line_addr, 1));
-    else
-      it->second++;
-
-    auto it2 = sequence_aw.find(line_addr);
-    if (it2 == sequence_aw.end()) {
-      sequence_aw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_aw[line_addr].push_back(make_pair('m', cycle_count));
-    } else {
-      it2->second.push_back(make_pair('m', cycle_count));
-    }
-
+    icache_miss_aw[line_addr]++;
     cur_line_delay = cycle_count;
-  } else {
-    auto it2 = sequence_bw.find(line_addr);
-    if (it2 == sequence_bw.end()) {
-      sequence_bw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_bw[line_addr].push_back(make_pair('m', cycle_count));
-    } else {
-      it2->second.push_back(make_pair('m', cycle_count));
-    }
   }
+  add_seq(line_addr, 'm', cycle_count);
 
   uns icache_val = fdip->get_warmed_up() ? 2 : 0;
   auto it = icache_sequence.find(line_addr);
@@ -693,132 +793,97 @@ void FDIP_Stat::inc_icache_miss(Addr line_addr) {
 
 void FDIP_Stat::inc_prefetched_cls(Addr line_addr, Flag on_path, uns success) {
   uns proc_id = fdip->get_proc_id();
-  auto cl_iter = prefetched_cls.find(line_addr);
-  if (cl_iter == prefetched_cls.end()) {
-    prefetched_cls.insert(pair<Addr, Counter>(line_addr, 1));
+  auto cl_info_iter = prefetched_cls_info.find(line_addr);
+  if (cl_info_iter == prefetched_cls_info.end()) {
     prefetched_cls_info.insert(
         make_pair(move(line_addr), make_pair(make_pair(move(cycle_count), on_path), make_pair(0, 0))));
     DEBUG(proc_id, "%llx inserted into prefetched_cls at %llu\n", line_addr, cycle_count);
   } else {
-    cl_iter->second++;
-    auto cl_info_iter = prefetched_cls_info.find(line_addr);
-    ASSERT(proc_id, cl_info_iter != prefetched_cls_info.end());
     cl_info_iter->second.first.first = cycle_count;
     cl_info_iter->second.first.second = on_path;
-    DEBUG(proc_id, "%llx updated with cnt %llu in prefetched_cls at cyc %llu\n", line_addr, cl_iter->second,
-          cycle_count);
+    DEBUG(proc_id, "%llx updated in prefetched_cls at cyc %llu\n", line_addr, cycle_count);
   }
 
-  if (success == Mem_Queue_Req_Result::SUCCESS_NEW) {
-    auto cl_new_iter = new_prefetched_cls.find(line_addr);
-    if (cl_new_iter == new_prefetched_cls.end())
-      new_prefetched_cls.insert(pair<Addr, Counter>(line_addr, 1));
-    else
-      cl_new_iter->second++;
+  if (fdip_line_stats_compact()) {
+    FDIP_Line_Counters* line = compact_line(line_addr, 'P');
+    if (line) {
+      Flag is_new = success == Mem_Queue_Req_Result::SUCCESS_NEW;
+      line->prefetched[0]++;
+      line->new_prefetched[0] += is_new;
+      if (fdip->get_warmed_up()) {
+        line->prefetched[1]++;
+        line->new_prefetched[1] += is_new;
+      }
+    }
+    return;
   }
+  if (!fdip_line_stats_exact())
+    return;
 
-  if (fdip->get_warmed_up()) {
-    auto it = prefetched_cls_aw.find(line_addr);
-    if (it == prefetched_cls_aw.end())
-      prefetched_cls_aw.insert(pair<Addr, Counter>(line_addr, 1));
-    else
-      it->second++;
-
-    if (success == Mem_Queue_Req_Result::SUCCESS_NEW) {
-      it = new_prefetched_cls_aw.find(line_addr);
-      if (it == new_prefetched_cls_aw.end())
-        new_prefetched_cls_aw.insert(pair<Addr, Counter>(line_addr, 1));
-      else
-        it->second++;
-    }
+  prefetched_cls[line_addr]++;
+  if (success == Mem_Queue_Req_Result::SUCCESS_NEW)
+    new_prefetched_cls[line_addr]++;
 
-    auto it2 = sequence_aw.find(line_addr);
-    Counter onoff_cycle_count = fdip_off_path() ? -cycle_count : cycle_count;
-    if (it2 == sequence_aw.end()) {
-      sequence_aw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_aw[line_addr].push_back(make_pair('P', onoff_cycle_count));
-    } else {
-      it2->second.push_back(make_pair('P', onoff_cycle_count));
-    }
-  } else {
-    auto it2 = sequence_bw.find(line_addr);
-    Counter onoff_cycle_count = fdip_off_path() ? -cycle_count : cycle_count;
-    if (it2 == sequence_bw.end()) {
-      sequence_bw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_bw[line_addr].push_back(make_pair('P', onoff_cycle_count));
-    } else {
-      it2->second.push_back(make_pair('P', onoff_cycle_count));
-    }
+  if (fdip->get_warmed_up()) {
+    prefetched_cls_aw[line_addr]++;
+    if (success == Mem_Queue_Req_Result::SUCCESS_NEW)
+      new_prefetched_cls_aw[line_addr]++;
   }
+  add_seq(line_addr, 'P', fdip_off_path() ? -cycle_count : cycle_count);
 }
 
 void FDIP_Stat::dec_cnt_useful_signed(Addr line_addr) {
-  auto it = cnt_useful_signed.find(line_addr);
-  if (it == cnt_useful_signed.end())
-    cnt_useful_signed.insert(pair<Addr, int64_t>(line_addr, UDP_USEFUL_THRESHOLD - UDP_WEIGHT_UNUSEFUL));
-  else
-    it->second -= UDP_WEIGHT_UNUSEFUL;
+  if (fdip_utility_maps_on()) {
+    auto it = cnt_useful_signed.find(line_addr);
+    if (it == cnt_useful_signed.end())
+      cnt_useful_signed.insert(pair<Addr, int64_t>(line_addr, UDP_USEFUL_THRESHOLD - UDP_WEIGHT_UNUSEFUL));
+    else
+      it->second -= UDP_WEIGHT_UNUSEFUL;
+  }
 
-  uns8 unuseful_value = fdip->get_warmed_up() ? 2 : 0;
-  auto it2 = useful_sequence.find(line_addr);
-  if (it2 == useful_sequence.end()) {
-    useful_sequence.insert(make_pair(line_addr, vector<uns8>()));
+  if (fdip_line_stats_exact()) {
+    uns8 unuseful_value = fdip->get_warmed_up() ? 2 : 0;
     useful_sequence[line_addr].push_back(unuseful_value);
-  } else {
-    it2->second.push_back(unuseful_value);
   }
 }
 
 void FDIP_Stat::inc_icache_hit(Addr line_addr) {
+  uns proc_id = fdip->get_proc_id();
+  if (fdip_line_stats_compact()) {
+    FDIP_Line_Counters* line = compact_line(line_addr, 'h');
+    if (fdip->get_warmed_up()) {
+      if (cur_line_delay)
+        delay_top_k.add(line_addr, cycle_count - cur_line_delay);
+      cur_line_delay = 0;
+    }
+    if (!line)
+      return;
+    if (!line->icache_hit[0])
+      STAT_EVENT(proc_id, UNIQUE_HIT_LINES);
+    line->icache_hit[0]++;
+    line->icache_hit[1] += fdip->get_warmed_up();
+    return;
+  }
+  if (!fdip_line_stats_exact())
+    return;
+
   auto cl_iter = icache_hit.find(line_addr);
   if (cl_iter == icache_hit.end()) {
-    STAT_EVENT(fdip->get_proc_id(), UNIQUE_HIT_LINES);
+    STAT_EVENT(proc_id, UNIQUE_HIT_LINES);
     icache_hit.insert(pair<Addr, Counter>(line_addr, 1));
   } else
     cl_iter->second++;
 
   if (fdip->get_warmed_up()) {
-    auto it = icache_hit_aw.find(line_addr);
-    if (it == icache_hit_aw.end())
-      icache_hit_aw.insert(pair<Addr, Counter>(line_addr, 1));
-    else
-      it->second++;
-
-    auto it2 = sequence_aw.find(line_addr);
-    if (it2 == sequence_aw.end()) {
-      sequence_aw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_aw[line_addr].push_back(make_pair('h', cycle_count));
-    } else {
-      it2->second.push_back(make_pair('h', cycle_count));
-    }
-
-    if (cur_line_delay) {
-      auto it3 = per_line_delay_aw.find(line_addr);
-      if (it3 == per_line_delay_aw.end()) {
-        per_line_delay_aw.insert(make_pair(line_addr, cycle_count - cur_line_delay));
-      } else {
-        it3->second += cycle_count - cur_line_delay;
-      }
-    }
+    icache_hit_aw[line_addr]++;
+    if (cur_line_delay)
+      per_line_delay_aw[line_addr] += cycle_count - cur_line_delay;
     cur_line_delay = 0;
-  } else {
-    auto it2 = sequence_bw.find(line_addr);
-    if (it2 == sequence_bw.end()) {
-      sequence_bw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      sequence_bw[line_addr].push_back(make_pair('h', cycle_count));
-    } else {
-      it2->second.push_back(make_pair('h', cycle_count));
-    }
   }
+  add_seq(line_addr, 'h', cycle_count);
 
   uns icache_val = fdip->get_warmed_up() ? 3 : 1;
-  auto it = icache_sequence.find(line_addr);
-  if (it == icache_sequence.end()) {
-    icache_sequence.insert(make_pair(line_addr, vector<uns8>()));
-    icache_sequence[line_addr].push_back(icache_val);
-  } else {
-    it->second.push_back(icache_val);
-  }
+  icache_sequence[line_addr].push_back(icache_val);
 }
 
 /* FDIP member functions */
@@ -891,13 +956,8 @@ void FDIP::update() {
       Mem_Req* mem_req = NULL;
       if (emit_new_prefetch) {
         line = (Inst_Info**)cache_access(&(ic_ref->icache), pc_addr, &line_addr, TRUE);
-        // icache_line_info cache should be accessed same times with icache for a consistant line information
-        if (WP_COLLECT_STATS) {
-          bool line_info = (Icache_Data*)cache_access(&(ic_ref->icache_line_info), pc_addr, &dummy_addr, TRUE);
-          UNUSED(line_info);
-        }
         bool mlc_line = (Inst_Info**)cache_access(&mem->uncores[proc_id].mlc->cache, pc_addr, &dummy_addr, FALSE);
-        bool l1_line = (Inst_Info**)cache_access(&mem->uncores[proc_id].l1->cache, pc_addr, &dummy_addr, FALSE);
+        bool l1_line = (Inst_Info**)cache_access(&mem->uncores[proc_id].l1[mem_l1_slice(pc_addr)].cache, pc_addr, &dummy_addr, FALSE);
         UNUSED(dummy_addr);
         uns pref_from = line ? 0 : (mlc_line ? 1 : (l1_line ? 2 : 3));
         STAT_EVENT(proc_id, FDIP_PREFETCH_HIT_ICACHE + pref_from);
@@ -1055,6 +1115,8 @@ void FDIP::inc_prefetched_cls(Addr line_addr, uns success, Flag conf_off_path) {
 }
 
 void FDIP::inc_off_fetched_cls(Addr line_addr) {
+  if (!fdip_line_stats_exact())
+    return;
   auto cl_iter = fdip_stat.off_fetched_cls.find(line_addr);
   if (cl_iter == fdip_stat.off_fetched_cls.end()) {
     fdip_stat.off_fetched_cls.insert(pair<Addr, Counter>(line_addr, cycle_count));
@@ -1082,9 +1144,8 @@ void FDIP::evict_prefetched_cls(Addr line_addr, Flag by_fdip) {
 uns FDIP::get_miss_reason(Addr line_addr) {
   auto cl_iter = fdip_stat.prefetched_cls_info.find(line_addr);
   if (cl_iter == fdip_stat.prefetched_cls_info.end()) {
-    auto tmp_iter = fdip_stat.prefetched_cls.find(line_addr);
     DEBUG(proc_id, "%llx misses due to 'not prefetched ever'\n", line_addr);
-    ASSERT(proc_id, tmp_iter == fdip_stat.prefetched_cls.end());
+    ASSERT(proc_id, !fdip_line_stats_exact() || !fdip_stat.prefetched_cls.count(line_addr));
     return Imiss_Reason::IMISS_NOT_PREFETCHED;
   }
   if (cl_iter->second.first.first < fdip_stat.last_recover_cycle) {
@@ -1289,7 +1350,7 @@ Flag FDIP::determine_usefulness(Addr line_addr, Op* op) {
     if (!fdip_off_path())
       emit_new_prefetch = TRUE;
     else {
-      emit_new_prefetch = buf_map_find(line_addr);
+      emit_new_prefetch = buf_map_find(proc_id, line_addr);
       if (emit_new_prefetch)
         STAT_EVENT(proc_id, FDIP_MEM_BUF_FOUND);
       else
@@ -1353,15 +1414,11 @@ void FDIP::inc_timeliness_info(Flag mshr_hit) {
 }
 
 Flag FDIP::search_pref_candidate(Addr addr) {
-  auto seniority_ftq = &(udp->seniority_ftq);
-  DEBUG(proc_id, "Search a pref candidate for %llx. seniority_ftq.size(): %ld\n", addr, seniority_ftq->size());
-  for (auto it = seniority_ftq->begin(); it != seniority_ftq->end(); ++it) {
-    if (get<0>(*it) == addr && (FDIP_UTILITY_ONLY_TRAIN_OFF_PATH ? get<2>(*it) == FALSE : TRUE)) {
-      DEBUG(proc_id, "Hit seniority-FTQ for addr: %llx cyc: %lld, on-path: %u\n", get<0>(*it), get<1>(*it),
-            get<2>(*it));
-      STAT_EVENT(proc_id, FDIP_SENIORITY_FTQ_HIT);
-      return TRUE;
-    }
+  DEBUG(proc_id, "Search a pref candidate for %llx. seniority_ftq.size(): %ld\n", addr, udp->seniority_ftq.size());
+  if (udp->seniority_ftq.contains(addr, FDIP_UTILITY_ONLY_TRAIN_OFF_PATH)) {
+    DEBUG(proc_id, "Hit seniority-FTQ for addr: %llx\n", addr);
+    STAT_EVENT(proc_id, FDIP_SENIORITY_FTQ_HIT);
+    return TRUE;
   }
   STAT_EVENT(fdip->proc_id, FDIP_SENIORITY_FTQ_MISS);
   return FALSE;
@@ -1373,7 +1430,7 @@ void FDIP::insert_pref_candidate_to_seniority_ftq(Addr line_addr) {
   uint64_t hashed_line_addr = line_addr;
   if (FDIP_GHIST_HASHING)
     hashed_line_addr = fdip_hash_addr_ghist(line_addr, g_bp_data->global_hist);
-  udp->seniority_ftq.push_back(make_tuple(hashed_line_addr, cycle_count, !is_conf_off_path()));
+  udp->seniority_ftq.push(hashed_line_addr, cycle_count, !is_conf_off_path());
   DEBUG(proc_id, "Insert %llx (hashed %lx) to seniority FTQ at cyc %llu seniority_ftq.size() : %ld\n", line_addr,
         hashed_line_addr, cycle_count, udp->seniority_ftq.size());
 }
@@ -1424,23 +1481,7 @@ void FDIP::assert_break_reason(Addr line_addr) {
 }
 
 void FDIP::add_evict_seq(Addr line_addr) {
-  if (warmed_up) {
-    auto it2 = fdip_stat.sequence_aw.find(line_addr);
-    if (it2 == fdip_stat.sequence_aw.end()) {
-      fdip_stat.sequence_aw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      fdip_stat.sequence_aw[line_addr].push_back(make_pair('e', cycle_count));
-    } else {
-      it2->second.push_back(make_pair('e', cycle_count));
-    }
-  } else {
-    auto it2 = fdip_stat.sequence_bw.find(line_addr);
-    if (it2 == fdip_stat.sequence_bw.end()) {
-      fdip_stat.sequence_bw.insert(make_pair(line_addr, vector<pair<char, Counter>>()));
-      fdip_stat.sequence_bw[line_addr].push_back(make_pair('e', cycle_count));
-    } else {
-      it2->second.push_back(make_pair('e', cycle_count));
-    }
-  }
+  fdip_stat.add_seq(line_addr, 'e', cycle_count);
 }
 
 void FDIP::log_stats_path_conf_per_pref_candidate() {
@@ -0,0 +1,117 @@
+/* Copyright 2024 Litz Lab
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : fdip_line_stats.cc
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Bounded per-cache-line bookkeeping for the FDIP utility analysis
+ ***************************************************************************************/
+
+#include "prefetcher/fdip_line_stats.hpp"
+
+#include <algorithm>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/utils.h"
+
+static inline uns64 line_hash(Addr line_addr, uns64 seed) {
+  uns64 x = line_addr ^ seed;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/* FDIP_Line_Table member functions */
+void FDIP_Line_Table::init(uns num_entries) {
+  ASSERT(0, num_entries > 0);
+  uns size = 1;
+  while (size < num_entries)
+    size <<= 1;
+  entries.assign(size, FDIP_Line_Counters());
+  mask = size - 1;
+  limit = size - size / 4;
+}
+
+FDIP_Line_Counters* FDIP_Line_Table::lookup(Addr line_addr, Flag* inserted) {
+  *inserted = FALSE;
+  for (uns64 idx = line_hash(line_addr, 0) & mask;; idx = (idx + 1) & mask) {
+    FDIP_Line_Counters* entry = &entries[idx];
+    if (entry->valid && entry->line_addr == line_addr)
+      return entry;
+    if (!entry->valid) {
+      if (num_valid >= limit) {
+        untracked++;
+        return NULL;
+      }
+      entry->valid = TRUE;
+      entry->line_addr = line_addr;
+      num_valid++;
+      *inserted = TRUE;
+      return entry;
+    }
+  }
+}
+
+/* FDIP_Line_Top_K member functions */
+void FDIP_Line_Top_K::init(uns width, uns top_k) {
+  ASSERT(0, width > 0);
+  uns size = 1;
+  while (size < width)
+    size <<= 1;
+  sketch.assign(DEPTH * size, 0);
+  width_mask = size - 1;
+  k = top_k;
+  top.clear();
+  top.reserve(k);
+}
+
+void FDIP_Line_Top_K::add(Addr line_addr, Counter inc) {
+  Counter estimate = MAX_CTR;
+  for (uns row = 0; row < DEPTH; row++) {
+    Counter* cell = &sketch[row * (width_mask + 1) + (line_hash(line_addr, row + 1) & width_mask)];
+    *cell += inc;
+    estimate = MIN2(estimate, *cell);
+  }
+
+  uns min_idx = 0;
+  for (uns ii = 0; ii < top.size(); ii++) {
+    if (top[ii].first == line_addr) {
+      top[ii].second = estimate;
+      return;
+    }
+    if (top[ii].second < top[min_idx].second)
+      min_idx = ii;
+  }
+  if (top.size() < k)
+    top.push_back(std::make_pair(line_addr, estimate));
+  else if (k && estimate > top[min_idx].second)
+    top[min_idx] = std::make_pair(line_addr, estimate);
+}
+
+std::vector<std::pair<Addr, Counter>> FDIP_Line_Top_K::sorted() const {
+  std::vector<std::pair<Addr, Counter>> lines = top;
+  std::sort(lines.begin(), lines.end(),
+            [](const std::pair<Addr, Counter>& a, const std::pair<Addr, Counter>& b) { return a.second > b.second; });
+  return lines;
+}
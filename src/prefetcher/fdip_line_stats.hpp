@@ -0,0 +1,105 @@
+/* Copyright 2024 Litz Lab
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : fdip_line_stats.hpp
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Bounded per-cache-line bookkeeping for the FDIP utility analysis: a
+ *                fixed-size open-addressing table of per-line counters and a
+ *                count-min sketch with a top-K list for the heaviest lines.
+ ***************************************************************************************/
+
+#ifndef __FDIP_LINE_STATS_H__
+#define __FDIP_LINE_STATS_H__
+
+#include <utility>
+#include <vector>
+
+#include "globals/global_types.h"
+
+/* FDIP_LINE_STATS levels */
+typedef enum FDIP_LINE_STATS_enum {
+  FDIP_LINE_STATS_OFF,
+  FDIP_LINE_STATS_COMPACT,  // fixed-size tables and sketches
+  FDIP_LINE_STATS_EXACT,    // per-line maps and full event sequences (grows with the code footprint)
+} FDIP_Line_Stats_Level;
+
+/* Per-line counters, index 0 over the whole run and index 1 after warm-up */
+typedef struct FDIP_Line_Counters_struct {
+  Addr line_addr;
+  Flag valid;
+  uns8 bw_events;    // FDIP_LINE_BW_* bits of the events seen before warm-up
+  uns8 aw_first[2];  // first two events after warm-up (sequence characters)
+  uns16 aw_events;   // number of events after warm-up, saturating
+  uns32 useful[2];
+  uns32 unuseful[2];
+  uns32 prefetched[2];
+  uns32 new_prefetched[2];
+  uns32 icache_hit[2];
+  uns32 icache_miss[2];
+} FDIP_Line_Counters;
+
+#define FDIP_LINE_BW_SEEN 0x1
+#define FDIP_LINE_BW_NO_PREF 0x2   // 'p'
+#define FDIP_LINE_BW_USEFUL 0x4    // 'U'
+#define FDIP_LINE_BW_UNUSEFUL 0x8  // 'u'
+
+/* Open-addressing table with linear probing. Lines are never removed; once the
+   table is 3/4 full new lines are not tracked and only counted as untracked. */
+class FDIP_Line_Table {
+ public:
+  FDIP_Line_Table() : mask(0), num_valid(0), limit(0), untracked(0) {}
+  void init(uns num_entries);
+  // returns the counters of line_addr, inserting it if needed (NULL if the table is full)
+  FDIP_Line_Counters* lookup(Addr line_addr, Flag* inserted);
+  const std::vector<FDIP_Line_Counters>& get_entries() const { return entries; }
+  uns get_num_valid() const { return num_valid; }
+  Counter get_untracked() const { return untracked; }
+
+ private:
+  std::vector<FDIP_Line_Counters> entries;
+  uns64 mask;
+  uns num_valid;
+  uns limit;
+  Counter untracked;
+};
+
+/* Count-min sketch of a per-line quantity with the K lines of largest
+   estimate. Memory is fixed by the sketch width and K. */
+class FDIP_Line_Top_K {
+ public:
+  FDIP_Line_Top_K() : width_mask(0), k(0) {}
+  void init(uns width, uns top_k);
+  void add(Addr line_addr, Counter inc);
+  // the tracked lines in decreasing estimate order
+  std::vector<std::pair<Addr, Counter>> sorted() const;
+
+ private:
+  static const uns DEPTH = 4;
+  std::vector<Counter> sketch;
+  uns64 width_mask;
+  uns k;
+  std::vector<std::pair<Addr, Counter>> top;
+};
+
+#endif /* #ifndef __FDIP_LINE_STATS_H__ */
@@ -49,6 +49,7 @@
 #include "memory/memory.h"
 #include "prefetcher/stream_pref.h"
 
+#include "cmp_threads.h"
 #include "dcache_stage.h"
 #include "op.h"
 #include "statistics.h"
@@ -61,7 +62,7 @@
 /* Global Variables */
 
 extern Memory* mem;
-extern Dcache_Stage* dc;
+extern CORE_LOCAL Dcache_Stage* dc;
 static Cache* l1_cache;
 
 /***************************************************************************************/
@@ -80,6 +81,7 @@ Counter last_hps_hit;
 void init_prefetch(void) {
   if (model->mem == MODEL_MEM) {
     ASSERTM(0, !PRIVATE_L1, "L2L1 Prefetcher assumes shared L1\n");
+    ASSERTM(0, mem->num_l1_slices == 1, "L2L1 Prefetcher assumes an unsliced L1\n");
     l1_cache = &mem->uncores[0].l1->cache;
   }
 
@@ -102,8 +104,7 @@ void l2l1_init(void) {
 
 void l2l1pref_mem(Mem_Req* req) {
   Mem_Req_Info mem_req_info;
-  Op** op_p = (Op**)list_start_head_traversal(&req->op_ptrs);
-  Op* op = op_p ? *op_p : NULL;
+  Op* op = req->op_count ? req->waiters[0].op : NULL;
   mem_req_info.addr = req->addr;
   mem_req_info.type = (Mem_Req_Type)req->type;  // FIXME !!
   mem_req_info.oldest_op_unique_num = req->oldest_op_unique_num;
@@ -192,6 +193,7 @@ void l2l1pref_mem_process(Mem_Req_Info* req) {
 }
 
 void l2l1pref_dcache(Addr line_addr, Op* op) {
+  UNCORE_LOCK_SCOPE();
   Mem_Req_Info tmp_req;
   tmp_req.addr = line_addr;
 
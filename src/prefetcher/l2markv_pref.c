@@ -56,7 +56,7 @@
 /**************************************************************************************/
 /* Global Variables */
 
-extern Dcache_Stage* dc;
+extern CORE_LOCAL Dcache_Stage* dc;
 
 /***************************************************************************************/
 /* Local Prototypes */
@@ -108,22 +108,15 @@ int l2markv_pref_train(Mem_Req_Info* req) {
   Addr tag;
   Addr line_addr;
   Addr addr = req->addr;
-  Cache* cache = &mem->uncores[req->proc_id].l1->cache;
+  Cache* cache = &mem->uncores[req->proc_id].l1[mem_l1_slice(addr)].cache;
 
   uns set = cache_index_l(cache, addr, &tag, &line_addr);
-  uns ii;
   Counter time_diff;
   int train_hit = FALSE;
-#define INIT_WAY 99999
-  uns current_way = INIT_WAY;
-  for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* line = &cache->entries[set][ii];
-    if (line->tag == tag && line->valid) {
-      current_way = ii;
-    }
-  }
-  if (current_way == INIT_WAY)
+  int found_way = ext_cache_find_way(cache, set, tag);
+  if (found_way < 0)
     return FALSE;
+  uns current_way = found_way;
   // training for the next addr ( for future prefetching )
 
   if (l2markv_table[last_set][last_way].next_addr == addr) {
@@ -338,7 +331,7 @@ void l2next_pref(Mem_Req_Info* req) {
       STAT_EVENT(0, L2NEXT_PREF_REQ);
     } else {
       uns bank = req_va >> dc->dcache.shift_bits & N_BIT_MASK(LOG2(DCACHE_BANKS));
-      Cache* l1_cache = &mem->uncores[req->proc_id].l1->cache;
+      Cache* l1_cache = &mem->uncores[req->proc_id].l1[mem_l1_slice(req_va)].cache;
       L1_Data* l1_data = cache_access(l1_cache, req_va, &line_addr, FALSE);
 
       if (l1_data) {                                                                // hit l1 cache
@@ -57,7 +57,7 @@
 /* Global Variables */
 
 extern Memory* mem;
-extern Dcache_Stage* dc;
+extern CORE_LOCAL Dcache_Stage* dc;
 
 /***************************************************************************************/
 /* Local Prototypes */
@@ -91,6 +91,7 @@ void l2way_init(void) {
 
   if (model->mem == MODEL_MEM) {
     ASSERTM(0, !PRIVATE_L1, "L2 Way Prefetcher assumes shared L1\n");
+    ASSERTM(0, mem->num_l1_slices == 1, "L2 Way Prefetcher assumes an unsliced L1\n");
     l1_cache = &mem->uncores[0].l1->cache;
   }
 }
@@ -109,19 +110,11 @@ void l2way_pref_train(Mem_Req_Info* req) {
   Cache* cache = l1_cache;
   uns set = cache_index_l(cache, addr, &tag, &line_addr);
   uns prev_way = l2way_table[set][0].last_way;
-#define INIT_WAY 99999
-  uns current_way = INIT_WAY;
-  uns ii;
   Counter l2_access_interval;
-  for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* line = &cache->entries[set][ii];
-
-    if (line->tag == tag && line->valid) {
-      current_way = ii;
-    }
-  }
-  if (current_way == INIT_WAY)
+  int found_way = ext_cache_find_way(cache, set, tag);
+  if (found_way < 0)
     return;
+  uns current_way = found_way;
   if (l2way_table[set][prev_way].pred_way == current_way) {
     if (l2way_table[set][prev_way].counter < 3)
       l2way_table[set][prev_way].counter++;
@@ -163,18 +156,11 @@ void l2way_pref_pred(Mem_Req_Info* req) {
   Addr addr = req->addr;
   Cache* cache = l1_cache;
   uns set = cache_index_l(cache, addr, &tag, &line_addr);
-  uns ii;
-  uns current_way = INIT_WAY;
-
-  for (ii = 0; ii < cache->assoc; ii++) {
-    Cache_Entry* line = &cache->entries[set][ii];
 
-    if (line->tag == tag && line->valid) {
-      current_way = ii;
-    }
-  }
-  if (current_way == INIT_WAY)
+  int found_way = ext_cache_find_way(cache, set, tag);
+  if (found_way < 0)
     return;
+  uns current_way = found_way;
   if (req->type == MRT_WB)
     return;  // Don't prefetch for the write back
 
@@ -39,8 +39,8 @@
 #include "core.param.h"
 #include "debug/debug.param.h"
 #include "general.param.h"
+#include "libs/assoc_table.h"
 #include "libs/cache_lib.h"
-#include "libs/hash_lib.h"
 #include "libs/list_lib.h"
 #include "memory/memory.param.h"
 #include "prefetcher//pref_bingo.h"
@@ -51,12 +51,12 @@
 
 /**************************************************************************************/
 /* Macros */
-#define DEBUG(args...) _DEBUG(DEBUG_PREF_BINGO, ##args)
+#define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_PREF_BINGO, ##args)
 
 /**************************************************************************************/
-Hash_Table History_Table;
-Hash_Table Aux_Storage;
-HWP_Info   hwp_in;
+Assoc_Table History_Table;  // Bingo_Table_Line by PC+Offset
+Assoc_Table Aux_Storage;    // Aux_Entry by page number
+HWP_Info    hwp_in;
 
 /* Helper: page number and indices */
 
@@ -75,6 +75,20 @@ static inline int bingo_get_block_index(Addr addr) {
   return (int)(page_offset >> 6); // 64-byte blocks
 }
 
+// Records the access in the footprint of its page, starting one (over the LRU
+// page of the set) if the page is not tracked yet
+static inline void bingo_record_access(Addr lineAddr, Addr loadPC) {
+  Flag       created;
+  Aux_Entry* aux_entry = (Aux_Entry*)assoc_table_access_create(
+    &Aux_Storage, bingo_get_page_number(lineAddr), PREF_BINGO_AUX_WAYS,
+    &created);
+  if(created) {
+    aux_entry->trigger_addr = lineAddr;
+    aux_entry->pc           = loadPC;
+  }
+  aux_entry->footprint.accessed[bingo_get_block_index(lineAddr)] = TRUE;
+}
+
 /**************************************************************************************/
 
 void pref_bingo_init(HWP* hwp) {
@@ -84,11 +98,13 @@ void pref_bingo_init(HWP* hwp) {
   hwp->hwp_info->enabled = TRUE;
   hwp_in                 = *(hwp->hwp_info);
 
-  init_hash_table(&History_Table, "History Table", 2048,
-                  sizeof(Bingo_Table_Line));
-  init_hash_table(&Aux_Storage, "Auxiliary Storage", 2048, sizeof(Aux_Entry));
+  init_assoc_table(&History_Table, "pref_bingo.history_table", 0,
+                   PREF_BINGO_HISTORY_N, PREF_BINGO_HISTORY_WAYS,
+                   sizeof(Bingo_Table_Line));
+  init_assoc_table(&Aux_Storage, "pref_bingo.aux_storage", 0, PREF_BINGO_AUX_N,
+                   PREF_BINGO_AUX_WAYS, sizeof(Aux_Entry));
 
-  DEBUG("Bingo prefetcher initialized\n");
+  DEBUG(0, "Bingo prefetcher initialized\n");
 }
 
 /**************************************************************************************/
@@ -96,25 +112,7 @@ void pref_bingo_init(HWP* hwp) {
 void pref_bingo_ul1_hit(uns8 proc_id, Addr lineAddr, Addr loadPC,
                         uns32 global_hist) {
   // On hit, we only update the footprint bitmap (no prefetching).
-
-  Addr page_number = bingo_get_page_number(lineAddr);
-  int  block_index = bingo_get_block_index(lineAddr);
-
-  Aux_Entry* aux_entry = (Aux_Entry*)hash_table_access(&Aux_Storage,
-                                                       page_number);
-
-  if(aux_entry) {
-    aux_entry->footprint.accessed[block_index] = TRUE;
-  } else {
-    Aux_Entry new_entry;
-    memset(&new_entry, 0, sizeof(new_entry));
-    new_entry.trigger_addr = lineAddr;
-    new_entry.pc           = loadPC;
-    new_entry.footprint.accessed[block_index] = TRUE;
-
-    // Store the new auxiliary entry in the aux table (copied into hash storage)
-    hash_table_access_replace(&Aux_Storage, page_number, &new_entry);
-  }
+  bingo_record_access(lineAddr, loadPC);
 
   (void)proc_id;
   (void)global_hist;
@@ -128,8 +126,8 @@ void pref_bingo_ul1_cache_evict(uns8 proc_id, Addr lineAddr) {
   Addr page_number = bingo_get_page_number(lineAddr);
 
   // Access the auxiliary entry from the Aux_Storage table
-  Aux_Entry* aux_entry =
-    (Aux_Entry*)hash_table_access(&Aux_Storage, page_number);
+  Aux_Entry* aux_entry = (Aux_Entry*)assoc_table_access(
+    &Aux_Storage, page_number, PREF_BINGO_AUX_WAYS, FALSE);
 
   if(aux_entry == NULL) {
     // No aux entry for this page; nothing to promote to history
@@ -147,23 +145,15 @@ void pref_bingo_ul1_cache_evict(uns8 proc_id, Addr lineAddr) {
   hist_entry.pc_plus_offset  = pc_plus_offset;
   hist_entry.entry           = *aux_entry; // copy aux data
 
-  // Access history line by pc_plus_offset; allocate new line if needed
-  Bingo_Table_Line* table_line =
-    (Bingo_Table_Line*)hash_table_access(&History_Table, pc_plus_offset);
-
-  Bingo_Table_Line new_line;
-  if(table_line == NULL) {
-    memset(&new_line, 0, sizeof(new_line));
-    table_line = &new_line;
-  }
+  // Access history line by pc_plus_offset; allocate new line (over the LRU
+  // line of the set) if needed
+  Bingo_Table_Line* table_line = (Bingo_Table_Line*)assoc_table_access_create(
+    &History_Table, pc_plus_offset, PREF_BINGO_HISTORY_WAYS, NULL);
 
   add_entry(table_line, hist_entry);
 
-  // Replace / insert line in history table
-  hash_table_access_replace(&History_Table, pc_plus_offset, table_line);
-
   // Remove from auxiliary storage; page is no longer tracked there
-  hash_table_access_delete(&Aux_Storage, page_number);
+  assoc_table_invalidate(&Aux_Storage, page_number, PREF_BINGO_AUX_WAYS);
 }
 
 /**************************************************************************************/
@@ -179,27 +169,13 @@ void pref_bingo_ul1_miss(uns8 proc_id, Addr lineAddr, Addr loadPC,
   Addr pc_plus_offset = loadPC + block_address;
   Addr pc_plus_address = loadPC + lineAddr;
   Addr page_number = bingo_get_page_number(lineAddr);
-  int  block_index = bingo_get_block_index(lineAddr);
 
-  Bingo_Table_Line* line =
-    (Bingo_Table_Line*)hash_table_access(&History_Table, pc_plus_offset);
+  Bingo_Table_Line* line = (Bingo_Table_Line*)assoc_table_access(
+    &History_Table, pc_plus_offset, PREF_BINGO_HISTORY_WAYS, TRUE);
 
   if(line == NULL) {
     // No history yet: just update auxiliary footprint for this page
-    Aux_Entry* aux_entry =
-      (Aux_Entry*)hash_table_access(&Aux_Storage, page_number);
-
-    if(aux_entry) {
-      aux_entry->footprint.accessed[block_index] = TRUE;
-    } else {
-      Aux_Entry new_entry;
-      memset(&new_entry, 0, sizeof(new_entry));
-      new_entry.trigger_addr = lineAddr;
-      new_entry.pc           = loadPC;
-      new_entry.footprint.accessed[block_index] = TRUE;
-
-      hash_table_access_replace(&Aux_Storage, page_number, &new_entry);
-    }
+    bingo_record_access(lineAddr, loadPC);
     return;
   }
 
@@ -212,9 +188,6 @@ void pref_bingo_ul1_miss(uns8 proc_id, Addr lineAddr, Addr loadPC,
     hash_entry = pref_bingo_find_event_to_fetch(line, pc_plus_offset);
   }
 
-  Aux_Entry* aux_entry =
-    (Aux_Entry*)hash_table_access(&Aux_Storage, page_number);
-
   if(hash_entry) {
     // Use the history entry to prefetch
     pref_bingo_prefetch(*hash_entry, proc_id, page_number);
@@ -223,17 +196,7 @@ void pref_bingo_ul1_miss(uns8 proc_id, Addr lineAddr, Addr loadPC,
   }
 
   // No history event chosen → keep learning via Aux_Storage
-  if(aux_entry) {
-    aux_entry->footprint.accessed[block_index] = TRUE;
-  } else {
-    Aux_Entry new_entry;
-    memset(&new_entry, 0, sizeof(new_entry));
-    new_entry.trigger_addr = lineAddr;
-    new_entry.pc           = loadPC;
-    new_entry.footprint.accessed[block_index] = TRUE;
-
-    hash_table_access_replace(&Aux_Storage, page_number, &new_entry);
-  }
+  bingo_record_access(lineAddr, loadPC);
 
   (void)global_hist;
 }
@@ -245,9 +208,6 @@ void pref_bingo_ul1_miss(uns8 proc_id, Addr lineAddr, Addr loadPC,
 Bingo_History_Table*
 pref_bingo_find_event_to_fetch(Bingo_Table_Line* table_line,
                                Addr              pc_plus_offset) {
-  if(History_Table.count == 0) {
-    return NULL;
-  }
   for(int i = 0; i < table_line->current_size; i++) {
     int index = table_line->usage_order[i];
     if(table_line->line[index].pc_plus_offset == pc_plus_offset) {
@@ -261,10 +221,6 @@ pref_bingo_find_event_to_fetch(Bingo_Table_Line* table_line,
 Bingo_History_Table*
 pref_bingo_find_event_to_fetch_addr(Bingo_Table_Line* table_line,
                                     Addr              pc_plus_address) {
-  if(History_Table.count == 0) {
-    return NULL;
-  }
-
   for(int i = 0; i < table_line->current_size; i++) {
     int index = table_line->usage_order[i];
     if(table_line->line[index].pc_plus_address == pc_plus_address) {
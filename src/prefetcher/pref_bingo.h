@@ -1,9 +1,13 @@
 #ifndef __PREF_BINGO_H__
 #define __PREF_BINGO_H__
 
+#include "libs/assoc_table.h"
 #include "pref_common.h"
 #include <stdbool.h>
 
+#define PREF_BINGO_HISTORY_WAYS 8  // PREF_BINGO_HISTORY_N / PREF_BINGO_HISTORY_WAYS sets
+#define PREF_BINGO_AUX_WAYS 8      // PREF_BINGO_AUX_N / PREF_BINGO_AUX_WAYS sets
+
 typedef struct Footprint_struct {
     bool accessed[64];  // Size of page divided by block size: 4096 / 64
 } Footprint;
@@ -39,6 +39,7 @@
 #include "op.h"
 
 #include "cmp_model.h"
+#include "cmp_threads.h"
 #include "core.param.h"
 #include "dcache_stage.h"
 #include "debug/debug.param.h"
@@ -75,11 +76,17 @@ static int pref_table_size;
 /* Macros */
 #define DEBUG(proc_id, args...) _DEBUG(proc_id, DEBUG_PREF, ##args)
 
+/* Calls func of every enabled prefetcher that implements hook */
+#define PREF_DISPATCH(hook, func, args...)                            \
+  for(uns hwp_ii = 0; hwp_ii < pref.num_hook_hwps[hook]; hwp_ii++) { \
+    pref.hook_hwps[hook][hwp_ii]->func(args);                          \
+  }
+
 /**************************************************************************************/
 /* Global Variables */
 
 extern Memory*       mem;
-extern Dcache_Stage* dc;
+extern CORE_LOCAL Dcache_Stage* dc;
 
 HWP_Common pref;
 
@@ -88,6 +95,10 @@ FILE* PREF_TRACE_OUT;
 FILE* PREF_DEGFB_FILE;
 
 static void pref_core_init(HWP_Core* pref_core);
+static void pref_build_hook_tables(void);
+static void pref_batch_event(HWP_Hook hook, uns8 proc_id, Addr line_addr,
+                             Addr load_PC, uns32 global_hist);
+static void pref_flush_batch(uns8 proc_id);
 static void pref_update_core(uns proc_id);
 static void pref_polbv_update_on_evict(uns8 pref_proc_id, uns8 evicted_proc_id,
                                        Addr evicted_addr);
@@ -97,6 +108,21 @@ void        pref_feed_back_info_update(uns8 prefetcher_id);
 /***************************************************************************************/
 /* supporting functions */
 
+/* Queue slots holding a line. Slots keep their line_index after being
+   invalidated, and the add filters match those too. */
+typedef struct Pref_Req_Queue_Line_struct {
+  uns slots;
+  uns valid;  // how many of the slots are still valid
+} Pref_Req_Queue_Line;
+
+static void pref_req_queue_lines_update(Hash_Table* lines, Addr line_index,
+                                        int slots, int valid);
+static int  pref_req_queue_find_valid(Pref_Mem_Req* queue, Hash_Table* lines,
+                                      uns size, Addr line_addr);
+static void pref_req_queue_write(Pref_Mem_Req* queue, Hash_Table* lines,
+                                 int pos, Pref_Mem_Req* new_req);
+static void pref_req_queue_invalidate(Pref_Mem_Req* entry, Hash_Table* lines);
+
 int pref_compare_hwp_priority(const void* const a, const void* const b) {
   return (((HWP*)a)->hwp_info->priority - ((HWP*)b)->hwp_info->priority);
 }
@@ -125,6 +151,213 @@ void pref_core_init(HWP_Core* pref_core) {
 
   pref_core->ul1req_queue_req_pos  = -1;
   pref_core->ul1req_queue_send_pos = 0;
+
+  init_hash_table_impl(&pref_core->dl0req_queue_lines, "dl0req queue lines",
+                       2 * PREF_DL0REQ_QUEUE_SIZE, sizeof(Pref_Req_Queue_Line),
+                       HASH_TABLE_OPEN);
+  init_hash_table_impl(&pref_core->umlc_req_queue_lines, "umlc req queue lines",
+                       2 * PREF_UMLC_REQ_QUEUE_SIZE,
+                       sizeof(Pref_Req_Queue_Line), HASH_TABLE_OPEN);
+  init_hash_table_impl(&pref_core->ul1req_queue_lines, "ul1req queue lines",
+                       2 * PREF_UL1REQ_QUEUE_SIZE, sizeof(Pref_Req_Queue_Line),
+                       HASH_TABLE_OPEN);
+}
+
+static void pref_req_queue_lines_update(Hash_Table* lines, Addr line_index,
+                                        int slots, int valid) {
+  Flag                 new_entry;
+  Pref_Req_Queue_Line* line = (Pref_Req_Queue_Line*)hash_table_access_create(
+    lines, line_index, &new_entry);
+  if(new_entry) {
+    line->slots = 0;
+    line->valid = 0;
+  }
+  ASSERT(0, (int)line->slots + slots >= 0 && (int)line->valid + valid >= 0);
+  line->slots += slots;
+  line->valid += valid;
+  if(!line->slots)
+    hash_table_access_delete(lines, line_index);
+}
+
+/* Returns the first valid slot holding line_addr's line, -1 if there is none */
+static int pref_req_queue_find_valid(Pref_Mem_Req* queue, Hash_Table* lines,
+                                     uns size, Addr line_addr) {
+  Addr                 line_index = line_addr >> LOG2(DCACHE_LINE_SIZE);
+  Pref_Req_Queue_Line* line = (Pref_Req_Queue_Line*)hash_table_access(
+    lines, line_index);
+  if(!line || !line->valid)
+    return -1;
+  for(uns ii = 0; ii < size; ii++) {
+    if(queue[ii].valid &&
+       (queue[ii].line_addr >> LOG2(DCACHE_LINE_SIZE)) == line_index)
+      return ii;
+  }
+  ASSERTM(0, FALSE, "Prefetch queue index out of sync for line %llx\n",
+          line_index);
+  return -1;
+}
+
+static void pref_req_queue_write(Pref_Mem_Req* queue, Hash_Table* lines,
+                                 int pos, Pref_Mem_Req* new_req) {
+  if(queue[pos].line_index)
+    pref_req_queue_lines_update(lines, queue[pos].line_index, -1,
+                                queue[pos].valid ? -1 : 0);
+  queue[pos] = *new_req;
+  pref_req_queue_lines_update(lines, new_req->line_index, 1, 1);
+}
+
+static void pref_req_queue_invalidate(Pref_Mem_Req* entry, Hash_Table* lines) {
+  if(!entry->valid)
+    return;
+  entry->valid = FALSE;
+  pref_req_queue_lines_update(lines, entry->line_index, 0, -1);
+}
+
+static Flag pref_hwp_has_hook(HWP* hwp, HWP_Hook hook) {
+  switch(hook) {
+    case HWP_HOOK_DONE:
+      return hwp->done_func != NULL;
+    case HWP_HOOK_PER_CORE_DONE:
+      return hwp->per_core_done_func != NULL;
+    case HWP_HOOK_DL0_MISS:
+      return hwp->dl0_miss_func != NULL;
+    case HWP_HOOK_DL0_HIT:
+      return hwp->dl0_hit_func != NULL;
+    case HWP_HOOK_DL0_PREF_HIT:
+      return hwp->dl0_pref_hit != NULL;
+    case HWP_HOOK_UMLC_MISS:
+      return hwp->umlc_miss_func != NULL;
+    case HWP_HOOK_UMLC_HIT:
+      return hwp->umlc_hit_func != NULL;
+    case HWP_HOOK_UMLC_PREF_HIT:
+      return hwp->umlc_pref_hit != NULL;
+    case HWP_HOOK_UL1_MISS:
+      return hwp->ul1_miss_func != NULL;
+    case HWP_HOOK_UL1_HIT:
+      return hwp->ul1_hit_func != NULL;
+    case HWP_HOOK_UL1_PREF_HIT:
+      return hwp->ul1_pref_hit != NULL;
+    case HWP_HOOK_UL1_CACHE_EVICT:
+      return hwp->ul1_cache_evict != NULL;
+    default:
+      ASSERT(0, FALSE);
+      return FALSE;
+  }
+}
+
+/* Prefetchers only set enabled from their init_func, so the per-hook lists
+   can be built once after the table has been sorted by priority */
+static void pref_build_hook_tables(void) {
+  uns hook;
+  int ii;
+
+  for(hook = 0; hook < HWP_HOOK_NUM; hook++) {
+    pref.hook_hwps[hook]     = (HWP**)calloc(pref_table_size, sizeof(HWP*));
+    pref.num_hook_hwps[hook] = 0;
+  }
+  pref.batch_hwps     = (HWP**)calloc(pref_table_size, sizeof(HWP*));
+  pref.num_batch_hwps = 0;
+
+  for(ii = 0; ii < pref_table_size; ii++) {
+    HWP* hwp    = &pref_table[ii];
+    Flag trains = FALSE;
+
+    if(!hwp->hwp_info->enabled)
+      continue;
+    for(hook = 0; hook < HWP_HOOK_NUM; hook++) {
+      if(!pref_hwp_has_hook(hwp, hook))
+        continue;
+      pref.hook_hwps[hook][pref.num_hook_hwps[hook]++] = hwp;
+      if(hook >= HWP_HOOK_UMLC_MISS && hook <= HWP_HOOK_UL1_PREF_HIT)
+        trains = TRUE;
+    }
+    if(trains)
+      pref.batch_hwps[pref.num_batch_hwps++] = hwp;
+  }
+
+  if(PREF_BATCH_EVENTS) {
+    ASSERTM(0, PREF_BATCH_SIZE > 0, "PREF_BATCH_SIZE must be positive\n");
+    pref.batch_events = (Pref_Batch_Event**)calloc(NUM_CORES,
+                                                   sizeof(Pref_Batch_Event*));
+    pref.num_batch_events = (uns*)calloc(NUM_CORES, sizeof(uns));
+    for(uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      pref.batch_events[proc_id] = (Pref_Batch_Event*)calloc(
+        PREF_BATCH_SIZE, sizeof(Pref_Batch_Event));
+    }
+  }
+}
+
+/* Delivers one buffered event to a single prefetcher */
+static void pref_hwp_train(HWP* hwp, uns8 proc_id, Pref_Batch_Event* event) {
+  switch(event->hook) {
+    case HWP_HOOK_UMLC_MISS:
+      if(hwp->umlc_miss_func)
+        hwp->umlc_miss_func(proc_id, event->line_addr, event->load_PC,
+                            event->global_hist);
+      break;
+    case HWP_HOOK_UMLC_HIT:
+      if(hwp->umlc_hit_func)
+        hwp->umlc_hit_func(proc_id, event->line_addr, event->load_PC,
+                           event->global_hist);
+      break;
+    case HWP_HOOK_UMLC_PREF_HIT:
+      if(hwp->umlc_pref_hit)
+        hwp->umlc_pref_hit(proc_id, event->line_addr, event->load_PC,
+                           event->global_hist);
+      break;
+    case HWP_HOOK_UL1_MISS:
+      if(hwp->ul1_miss_func)
+        hwp->ul1_miss_func(proc_id, event->line_addr, event->load_PC,
+                           event->global_hist);
+      break;
+    case HWP_HOOK_UL1_HIT:
+      if(hwp->ul1_hit_func)
+        hwp->ul1_hit_func(proc_id, event->line_addr, event->load_PC,
+                          event->global_hist);
+      break;
+    case HWP_HOOK_UL1_PREF_HIT:
+      if(hwp->ul1_pref_hit)
+        hwp->ul1_pref_hit(proc_id, event->line_addr, event->load_PC,
+                          event->global_hist);
+      break;
+    default:
+      ASSERT(proc_id, FALSE);
+  }
+}
+
+static void pref_batch_event(HWP_Hook hook, uns8 proc_id, Addr line_addr,
+                             Addr load_PC, uns32 global_hist) {
+  Pref_Batch_Event* event;
+
+  if(pref.num_batch_events[proc_id] == PREF_BATCH_SIZE)
+    pref_flush_batch(proc_id);
+
+  event = &pref.batch_events[proc_id][pref.num_batch_events[proc_id]++];
+  event->hook        = hook;
+  event->line_addr   = line_addr;
+  event->load_PC     = load_PC;
+  event->global_hist = global_hist;
+}
+
+/* Hands the core's buffered events to each prefetcher in turn, so that one
+   prefetcher's training code and tables stay hot across the whole batch */
+static void pref_flush_batch(uns8 proc_id) {
+  Pref_Batch_Event* events;
+  uns               num_events;
+
+  if(!PREF_BATCH_EVENTS || !pref.batch_events)
+    return;
+  events     = pref.batch_events[proc_id];
+  num_events = pref.num_batch_events[proc_id];
+  if(num_events == 0)
+    return;
+
+  for(uns ii = 0; ii < pref.num_batch_hwps; ii++) {
+    for(uns jj = 0; jj < num_events; jj++) {
+      pref_hwp_train(pref.batch_hwps[ii], proc_id, &events[jj]);
+    }
+  }
+  pref.num_batch_events[proc_id] = 0;
 }
 
 void pref_init(void) {
@@ -191,6 +424,7 @@ void pref_init(void) {
       pref_table[ii].init_func(&pref_table[ii]);
   }
   qsort(pref_table, pref_table_size, sizeof(HWP), pref_compare_hwp_priority);
+  pref_build_hook_tables();
 
   if(PREF_TRACE_ON)
     PREF_TRACE_OUT = file_tag_fopen(NULL, pref_trace_filename, "w");
@@ -230,15 +464,11 @@ void pref_init(void) {
 }
 
 void pref_per_core_done(uns proc_id) {
-  for(uns ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].per_core_done_func) {
-      pref_table[ii].per_core_done_func(proc_id);
-    }
-  }
+  pref_flush_batch(proc_id);
+  PREF_DISPATCH(HWP_HOOK_PER_CORE_DONE, per_core_done_func, proc_id);
 }
 
 void pref_done(void) {
-  int ii;
   if(!PREF_FRAMEWORK_ON)
     return;
   if(PREF_ANALYZE_LOAD) {
@@ -256,61 +486,47 @@ void pref_done(void) {
               ((Pref_LoadPCInfo*)new_array[ii])->count);
     }
   }
-  for(ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].done_func) {
-      pref_table[ii].done_func();
-    }
+  for(uns8 proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    pref_flush_batch(proc_id);
   }
+  PREF_DISPATCH(HWP_HOOK_DONE, done_func);
 }
 
 // FIXME LATER
 void pref_dl0_miss(Addr line_addr, Addr load_PC) {
-  int ii;
+  UNCORE_LOCK_SCOPE();
   if(!PREF_FRAMEWORK_ON)
     return;
   if(PREF_DL0_MISS_ON) {
-    for(ii = 0; ii < pref_table_size; ii++) {
-      if(pref_table[ii].hwp_info->enabled && pref_table[ii].dl0_miss_func) {
-        pref_table[ii].dl0_miss_func(line_addr, load_PC);
-      }
-    }
+    PREF_DISPATCH(HWP_HOOK_DL0_MISS, dl0_miss_func, line_addr, load_PC);
   }
 }
 
 // FIXME LATER
 void pref_dl0_hit(Addr line_addr, Addr load_PC) {
-  int ii;
+  UNCORE_LOCK_SCOPE();
   if(!PREF_FRAMEWORK_ON)
     return;
   if(PREF_DL0_HIT_ON) {
-    for(ii = 0; ii < pref_table_size; ii++) {
-      if(pref_table[ii].hwp_info->enabled && pref_table[ii].dl0_hit_func) {
-        pref_table[ii].dl0_hit_func(line_addr, load_PC);
-      }
-    }
+    PREF_DISPATCH(HWP_HOOK_DL0_HIT, dl0_hit_func, line_addr, load_PC);
   }
 }
 
 // FIXME LATER
 void pref_dl0_pref_hit(Addr line_addr, Addr load_PC, uns8 prefetcher_id) {
-  int ii;
+  UNCORE_LOCK_SCOPE();
   if(!PREF_FRAMEWORK_ON)
     return;
   if(prefetcher_id == 0)
     return;
 
   if(PREF_DL0_HIT_ON) {
-    for(ii = 0; ii < pref_table_size; ii++) {
-      if(pref_table[ii].hwp_info->enabled && pref_table[ii].dl0_pref_hit) {
-        pref_table[ii].dl0_pref_hit(line_addr, load_PC);
-      }
-    }
+    PREF_DISPATCH(HWP_HOOK_DL0_PREF_HIT, dl0_pref_hit, line_addr, load_PC);
   }
 }
 
 void pref_umlc_miss(uns8 proc_id, Addr line_addr, Addr load_PC,
                     uns32 global_hist) {
-  int ii;
   if(!PREF_FRAMEWORK_ON)
     return;
   if(!PREF_UMLC_ON || !MLC_PRESENT)
@@ -326,16 +542,15 @@ void pref_umlc_miss(uns8 proc_id, Addr line_addr, Addr load_PC,
     pref_polbv_lookup_on_miss(proc_id, line_addr);
   }
 
-  for(ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].umlc_miss_func) {
-      pref_table[ii].umlc_miss_func(proc_id, line_addr, load_PC, global_hist);
-    }
+  if(PREF_BATCH_EVENTS) {
+    pref_batch_event(HWP_HOOK_UMLC_MISS, proc_id, line_addr, load_PC, global_hist);
+    return;
   }
+  PREF_DISPATCH(HWP_HOOK_UMLC_MISS, umlc_miss_func, proc_id, line_addr, load_PC, global_hist);
 }
 
 void pref_umlc_hit(uns8 proc_id, Addr line_addr, Addr load_PC,
                    uns32 global_hist) {
-  int ii;
   if(!PREF_FRAMEWORK_ON)
     return;
   if(!PREF_UMLC_ON || !MLC_PRESENT)
@@ -344,11 +559,11 @@ void pref_umlc_hit(uns8 proc_id, Addr line_addr, Addr load_PC,
     fprintf(PREF_TRACE_OUT, "%s \t %s \t %s \t %s\n", hexstr64s(cycle_count),
             hexstr64s(0), hexstr64s(line_addr), "UMLC_HIT");
 
-  for(ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].umlc_hit_func) {
-      pref_table[ii].umlc_hit_func(proc_id, line_addr, load_PC, global_hist);
-    }
+  if(PREF_BATCH_EVENTS) {
+    pref_batch_event(HWP_HOOK_UMLC_HIT, proc_id, line_addr, load_PC, global_hist);
+    return;
   }
+  PREF_DISPATCH(HWP_HOOK_UMLC_HIT, umlc_hit_func, proc_id, line_addr, load_PC, global_hist);
 }
 
 void pref_umlc_pref_hit_late(uns8 proc_id, Addr line_addr, Addr load_PC,
@@ -368,7 +583,6 @@ void pref_umlc_pref_hit_late(uns8 proc_id, Addr line_addr, Addr load_PC,
 void pref_umlc_pref_hit(uns8 proc_id, Addr line_addr, Addr load_PC,
                         uns32 global_hist, int lru_position,
                         uns8 prefetcher_id) {
-  int ii;
   if(prefetcher_id == 0)
     return;
 
@@ -383,16 +597,15 @@ void pref_umlc_pref_hit(uns8 proc_id, Addr line_addr, Addr load_PC,
 
   pref_table[prefetcher_id].hwp_info->curr_useful_core[proc_id]++;
 
-  for(ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].umlc_pref_hit) {
-      pref_table[ii].umlc_pref_hit(proc_id, line_addr, load_PC, global_hist);
-    }
+  if(PREF_BATCH_EVENTS) {
+    pref_batch_event(HWP_HOOK_UMLC_PREF_HIT, proc_id, line_addr, load_PC, global_hist);
+    return;
   }
+  PREF_DISPATCH(HWP_HOOK_UMLC_PREF_HIT, umlc_pref_hit, proc_id, line_addr, load_PC, global_hist);
 }
 
 void pref_ul1_miss(uns8 proc_id, Addr line_addr, Addr load_PC,
                    uns32 global_hist) {
-  int ii;
   if(!PREF_FRAMEWORK_ON)
     return;
   if(!PREF_UL1_ON)
@@ -413,16 +626,15 @@ void pref_ul1_miss(uns8 proc_id, Addr line_addr, Addr load_PC,
     pref_polbv_lookup_on_miss(proc_id, line_addr);
   }
 
-  for(ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].ul1_miss_func) {
-      pref_table[ii].ul1_miss_func(proc_id, line_addr, load_PC, global_hist);
-    }
+  if(PREF_BATCH_EVENTS) {
+    pref_batch_event(HWP_HOOK_UL1_MISS, proc_id, line_addr, load_PC, global_hist);
+    return;
   }
+  PREF_DISPATCH(HWP_HOOK_UL1_MISS, ul1_miss_func, proc_id, line_addr, load_PC, global_hist);
 }
 
 void pref_ul1_hit(uns8 proc_id, Addr line_addr, Addr load_PC,
                   uns32 global_hist) {
-  int ii;
   if(!PREF_FRAMEWORK_ON)
     return;
   if(!PREF_UL1_ON)
@@ -433,11 +645,11 @@ void pref_ul1_hit(uns8 proc_id, Addr line_addr, Addr load_PC,
     fprintf(PREF_TRACE_OUT, "%s \t %s \t %s \t %s\n", hexstr64s(cycle_count),
             hexstr64s(0), hexstr64s(line_addr), "UL1_HIT");
 
-  for(ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].ul1_hit_func) {
-      pref_table[ii].ul1_hit_func(proc_id, line_addr, load_PC, global_hist);
-    }
+  if(PREF_BATCH_EVENTS) {
+    pref_batch_event(HWP_HOOK_UL1_HIT, proc_id, line_addr, load_PC, global_hist);
+    return;
   }
+  PREF_DISPATCH(HWP_HOOK_UL1_HIT, ul1_hit_func, proc_id, line_addr, load_PC, global_hist);
 }
 
 void pref_ul1_pref_hit_late(uns8 proc_id, Addr line_addr, Addr load_PC,
@@ -461,7 +673,6 @@ void pref_ul1_pref_hit_late(uns8 proc_id, Addr line_addr, Addr load_PC,
 void pref_ul1_pref_hit(uns8 proc_id, Addr line_addr, Addr load_PC,
                        uns32 global_hist, int lru_position,
                        uns8 prefetcher_id) {
-  int ii;
   if(prefetcher_id == 0)
     return;
 
@@ -476,92 +687,77 @@ void pref_ul1_pref_hit(uns8 proc_id, Addr line_addr, Addr load_PC,
 
   pref_table[prefetcher_id].hwp_info->curr_useful_core[proc_id]++;
 
-  for(ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].ul1_pref_hit) {
-      pref_table[ii].ul1_pref_hit(proc_id, line_addr, load_PC, global_hist);
-    }
+  if(PREF_BATCH_EVENTS) {
+    pref_batch_event(HWP_HOOK_UL1_PREF_HIT, proc_id, line_addr, load_PC, global_hist);
+    return;
   }
+  PREF_DISPATCH(HWP_HOOK_UL1_PREF_HIT, ul1_pref_hit, proc_id, line_addr, load_PC, global_hist);
 }
 
 Flag pref_dl0req_queue_filter(Addr line_addr) {
   if(!PREF_DL0REQ_QUEUE_FILTER_ON)
     return FALSE;
-  uns           proc_id      = get_proc_id_from_cmp_addr(line_addr);
-  Pref_Mem_Req* dl0req_queue = pref.cores[proc_id]->dl0req_queue;
-  for(uns ii = 0; ii < PREF_DL0REQ_QUEUE_SIZE; ii++) {
-    if(dl0req_queue[ii].valid &&
-       (dl0req_queue[ii].line_addr >> LOG2(DCACHE_LINE_SIZE)) ==
-         (line_addr >> LOG2(DCACHE_LINE_SIZE))) {
-      dl0req_queue[ii].valid = FALSE;
-      STAT_EVENT(0, PREF_DL0REQ_QUEUE_HIT_BY_DEMAND);
-      return TRUE;
-    }
-  }
-  return FALSE;
+  uns           proc_id = get_proc_id_from_cmp_addr(line_addr);
+  Pref_Mem_Req* queue   = pref.cores[proc_id]->dl0req_queue;
+  Hash_Table*   lines   = &pref.cores[proc_id]->dl0req_queue_lines;
+  int ii = pref_req_queue_find_valid(queue, lines, PREF_DL0REQ_QUEUE_SIZE,
+                                     line_addr);
+  if(ii < 0)
+    return FALSE;
+  pref_req_queue_invalidate(&queue[ii], lines);
+  STAT_EVENT(0, PREF_DL0REQ_QUEUE_HIT_BY_DEMAND);
+  return TRUE;
 }
 
 Flag pref_umlc_req_queue_filter(Addr line_addr) {
   if(!PREF_UMLC_REQ_QUEUE_FILTER_ON)
     return FALSE;
-  uns           proc_id        = get_proc_id_from_cmp_addr(line_addr);
-  Pref_Mem_Req* umlc_req_queue = pref.cores[proc_id]->umlc_req_queue;
-  for(uns ii = 0; ii < PREF_UMLC_REQ_QUEUE_SIZE; ii++) {
-    if(umlc_req_queue[ii].valid &&
-       (umlc_req_queue[ii].line_addr >> LOG2(DCACHE_LINE_SIZE)) ==
-         (line_addr >> LOG2(DCACHE_LINE_SIZE))) {
-      umlc_req_queue[ii].valid = FALSE;
-      STAT_EVENT(0, PREF_UMLC_REQ_QUEUE_HIT_BY_DEMAND);
-      return TRUE;
-    }
-  }
-  return FALSE;
+  uns           proc_id = get_proc_id_from_cmp_addr(line_addr);
+  Pref_Mem_Req* queue   = pref.cores[proc_id]->umlc_req_queue;
+  Hash_Table*   lines   = &pref.cores[proc_id]->umlc_req_queue_lines;
+  int ii = pref_req_queue_find_valid(queue, lines, PREF_UMLC_REQ_QUEUE_SIZE,
+                                     line_addr);
+  if(ii < 0)
+    return FALSE;
+  pref_req_queue_invalidate(&queue[ii], lines);
+  STAT_EVENT(0, PREF_UMLC_REQ_QUEUE_HIT_BY_DEMAND);
+  return TRUE;
 }
 
 Flag pref_ul1req_queue_filter(Addr line_addr) {
   if(!PREF_UL1REQ_QUEUE_FILTER_ON)
     return FALSE;
-  uns           proc_id      = get_proc_id_from_cmp_addr(line_addr);
-  Pref_Mem_Req* ul1req_queue = pref.cores[proc_id]->ul1req_queue;
-  for(uns ii = 0; ii < PREF_UL1REQ_QUEUE_SIZE; ii++) {
-    if(ul1req_queue[ii].valid &&
-       (ul1req_queue[ii].line_addr >> LOG2(DCACHE_LINE_SIZE)) ==
-         (line_addr >> LOG2(DCACHE_LINE_SIZE))) {
-      ul1req_queue[ii].valid = FALSE;
-      STAT_EVENT(0, PREF_UL1REQ_QUEUE_HIT_BY_DEMAND);
-      return TRUE;
-    }
-  }
-  return FALSE;
+  uns           proc_id = get_proc_id_from_cmp_addr(line_addr);
+  Pref_Mem_Req* queue   = pref.cores[proc_id]->ul1req_queue;
+  Hash_Table*   lines   = &pref.cores[proc_id]->ul1req_queue_lines;
+  int ii = pref_req_queue_find_valid(queue, lines, PREF_UL1REQ_QUEUE_SIZE,
+                                     line_addr);
+  if(ii < 0)
+    return FALSE;
+  pref_req_queue_invalidate(&queue[ii], lines);
+  STAT_EVENT(0, PREF_UL1REQ_QUEUE_HIT_BY_DEMAND);
+  return TRUE;
 }
 
 Flag pref_ul1req_queue_match(Addr line_addr) {
-  uns           proc_id      = get_proc_id_from_cmp_addr(line_addr);
-  Pref_Mem_Req* ul1req_queue = pref.cores[proc_id]->ul1req_queue;
-  for(uns ii = 0; ii < PREF_UL1REQ_QUEUE_SIZE; ii++) {
-    if(ul1req_queue[ii].valid &&
-       (ul1req_queue[ii].line_addr >> LOG2(DCACHE_LINE_SIZE)) ==
-         (line_addr >> LOG2(DCACHE_LINE_SIZE))) {
-      return TRUE;
-    }
-  }
-  return FALSE;
+  uns                  proc_id = get_proc_id_from_cmp_addr(line_addr);
+  Pref_Req_Queue_Line* line    = (Pref_Req_Queue_Line*)hash_table_access(
+    &pref.cores[proc_id]->ul1req_queue_lines,
+    line_addr >> LOG2(DCACHE_LINE_SIZE));
+  return line && line->valid;
 }
 
 Flag pref_addto_dl0req_queue(uns8 proc_id, Addr line_index,
                              uns8 prefetcher_id) {
-  int          ii;
   Pref_Mem_Req new_req = {0};
   if(!line_index)  // addr = 0
     return TRUE;
   Pref_Mem_Req* dl0req_queue = pref.cores[proc_id]->dl0req_queue;
   int* dl0req_queue_req_pos  = &pref.cores[proc_id]->dl0req_queue_req_pos;
-  if(PREF_DL0REQ_ADD_FILTER_ON) {
-    for(ii = 0; ii < PREF_DL0REQ_QUEUE_SIZE; ii++) {
-      if(dl0req_queue[ii].line_index == line_index) {
-        STAT_EVENT(0, PREF_DL0REQ_QUEUE_MATCHED_REQ);
-        return TRUE;  // Hit another request
-      }
-    }
+  if(PREF_DL0REQ_ADD_FILTER_ON &&
+     hash_table_access(&pref.cores[proc_id]->dl0req_queue_lines, line_index)) {
+    STAT_EVENT(0, PREF_DL0REQ_QUEUE_MATCHED_REQ);
+    return TRUE;  // Hit another request
   }
   if(dl0req_queue[(*dl0req_queue_req_pos + 1) % PREF_DL0REQ_QUEUE_SIZE].valid) {
     STAT_EVENT_ALL(PREF_DL0REQ_QUEUE_FULL);
@@ -578,25 +774,23 @@ Flag pref_addto_dl0req_queue(uns8 proc_id, Addr line_index,
 
   *dl0req_queue_req_pos = (*dl0req_queue_req_pos + 1) % PREF_DL0REQ_QUEUE_SIZE;
 
-  dl0req_queue[*dl0req_queue_req_pos] = new_req;
+  pref_req_queue_write(dl0req_queue, &pref.cores[proc_id]->dl0req_queue_lines,
+                       *dl0req_queue_req_pos, &new_req);
   return TRUE;
 }
 
 Flag pref_addto_umlc_req_queue(uns8 proc_id, Addr line_index,
                                uns8 prefetcher_id) {
-  int          ii;
   Pref_Mem_Req new_req = {0};
   if(!line_index)  // addr = 0
     return TRUE;
   Pref_Mem_Req* umlc_req_queue = pref.cores[proc_id]->umlc_req_queue;
   int* umlc_req_queue_req_pos  = &pref.cores[proc_id]->umlc_req_queue_req_pos;
-  if(PREF_UMLC_REQ_ADD_FILTER_ON) {
-    for(ii = 0; ii < PREF_UMLC_REQ_QUEUE_SIZE; ii++) {
-      if(umlc_req_queue[ii].line_index == line_index) {
-        STAT_EVENT(0, PREF_UMLC_REQ_QUEUE_MATCHED_REQ);
-        return TRUE;  // Hit another request
-      }
-    }
+  if(PREF_UMLC_REQ_ADD_FILTER_ON &&
+     hash_table_access(&pref.cores[proc_id]->umlc_req_queue_lines,
+                       line_index)) {
+    STAT_EVENT(0, PREF_UMLC_REQ_QUEUE_MATCHED_REQ);
+    return TRUE;  // Hit another request
   }
   if(umlc_req_queue[(*umlc_req_queue_req_pos + 1) % PREF_UMLC_REQ_QUEUE_SIZE]
        .valid) {
@@ -617,7 +811,9 @@ Flag pref_addto_umlc_req_queue(uns8 proc_id, Addr line_index,
   *umlc_req_queue_req_pos = (*umlc_req_queue_req_pos + 1) %
                             PREF_UMLC_REQ_QUEUE_SIZE;
 
-  umlc_req_queue[*umlc_req_queue_req_pos] = new_req;
+  pref_req_queue_write(umlc_req_queue,
+                       &pref.cores[proc_id]->umlc_req_queue_lines,
+                       *umlc_req_queue_req_pos, &new_req);
   return TRUE;
 }
 
@@ -630,7 +826,6 @@ Flag pref_addto_ul1req_queue(uns8 proc_id, Addr line_index,
 Flag pref_addto_ul1req_queue_set(uns8 proc_id, Addr line_index,
                                  uns8 prefetcher_id, uns distance, Addr loadPC,
                                  uns32 global_hist, Flag bw) {
-  int          ii;
   Pref_Mem_Req new_req;
   Addr         line_addr;
   if(!line_index)  // addr = 0
@@ -643,13 +838,10 @@ Flag pref_addto_ul1req_queue_set(uns8 proc_id, Addr line_index,
 
   pref_feed_back_info_update(prefetcher_id);
 
-  if(PREF_UL1REQ_ADD_FILTER_ON) {
-    for(ii = 0; ii < PREF_UL1REQ_QUEUE_SIZE; ii++) {
-      if(ul1req_queue[ii].line_index == line_index) {
-        STAT_EVENT(0, PREF_UL1REQ_QUEUE_MATCHED_REQ);
-        return TRUE;  // Hit another request
-      }
-    }
+  if(PREF_UL1REQ_ADD_FILTER_ON &&
+     hash_table_access(&pref.cores[proc_id]->ul1req_queue_lines, line_index)) {
+    STAT_EVENT(0, PREF_UL1REQ_QUEUE_MATCHED_REQ);
+    return TRUE;  // Hit another request
   }
   if(ul1req_queue[(*ul1req_queue_req_pos + 1) % PREF_UL1REQ_QUEUE_SIZE].valid) {
     STAT_EVENT_ALL(PREF_UL1REQ_QUEUE_FULL);
@@ -670,7 +862,8 @@ Flag pref_addto_ul1req_queue_set(uns8 proc_id, Addr line_index,
 
   *ul1req_queue_req_pos = (*ul1req_queue_req_pos + 1) % PREF_UL1REQ_QUEUE_SIZE;
 
-  ul1req_queue[*ul1req_queue_req_pos] = new_req;
+  pref_req_queue_write(ul1req_queue, &pref.cores[proc_id]->ul1req_queue_lines,
+                       *ul1req_queue_req_pos, &new_req);
   return TRUE;
 }
 
@@ -682,6 +875,11 @@ void pref_update(void) {
      cycle_count % PREF_HFILTER_RESET_INTERVAL == 0)
     pref_hfilter_pht_reset();
 
+  // train on last cycle's events before scheduling the requests they produce
+  for(uns8 proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    pref_flush_batch(proc_id);
+  }
+
   if(PREF_SHARED_QUEUES) {
     pref_update_core(0);
   } else {
@@ -702,6 +900,7 @@ void pref_update_core(uns proc_id) {
   // ul1 access
   //  - 1. create a new request and call new_mem_req
 
+  HWP_Core*     pref_core      = pref.cores[proc_id];
   Pref_Mem_Req* dl0req_queue   = pref.cores[proc_id]->dl0req_queue;
   int* dl0req_queue_send_pos   = &pref.cores[proc_id]->dl0req_queue_send_pos;
   Pref_Mem_Req* umlc_req_queue = pref.cores[proc_id]->umlc_req_queue;
@@ -784,7 +983,8 @@ void pref_update_core(uns proc_id) {
         STAT_EVENT(0, PREF_MLCQ_STALL);
         if(PREF_REQ_DROP &&
            MEM_REQ_BUFFER_ENTRIES == mem_get_req_count(proc_id)) {
-          umlc_req_queue[q_index].valid = FALSE;
+          pref_req_queue_invalidate(&umlc_req_queue[q_index],
+                                    &pref_core->umlc_req_queue_lines);
         } else {
           inc_send_pos = FALSE;
         }
@@ -798,7 +998,8 @@ void pref_update_core(uns proc_id) {
         DEBUG(0, "Sent req %llx to umlc Qpos:%d\n",
               umlc_req_queue[q_index].line_index, *umlc_req_queue_send_pos);
         STAT_EVENT(0, PREF_UMLC_REQ_QUEUE_SENTREQ);
-        umlc_req_queue[q_index].valid = FALSE;
+        pref_req_queue_invalidate(&umlc_req_queue[q_index],
+                                  &pref_core->umlc_req_queue_lines);
       } else {
         STAT_EVENT(0, PREF_UMLC_REQ_SEND_QUEUE_STALL);
         inc_send_pos = FALSE;
@@ -841,7 +1042,8 @@ void pref_update_core(uns proc_id) {
         STAT_EVENT(0, PREF_L1Q_STALL);
         if(PREF_REQ_DROP &&
            MEM_REQ_BUFFER_ENTRIES == mem_get_req_count(proc_id)) {
-          ul1req_queue[q_index].valid = FALSE;
+          pref_req_queue_invalidate(&ul1req_queue[q_index],
+                                    &pref_core->ul1req_queue_lines);
         } else {
           inc_send_pos = FALSE;
         }
@@ -855,7 +1057,8 @@ void pref_update_core(uns proc_id) {
         DEBUG(0, "Sent req %llx to ul1 Qpos:%d\n",
               ul1req_queue[q_index].line_index, *ul1req_queue_send_pos);
         STAT_EVENT(0, PREF_UL1REQ_QUEUE_SENTREQ);
-        ul1req_queue[q_index].valid = FALSE;
+        pref_req_queue_invalidate(&ul1req_queue[q_index],
+                                  &pref_core->ul1req_queue_lines);
       } else {
         STAT_EVENT(0, PREF_UL1REQ_SEND_QUEUE_STALL);
         inc_send_pos = FALSE;
@@ -996,11 +1199,10 @@ inline void pref_ul1evict(uns8 proc_id, Addr addr) {
     return;
 
   pref.num_ul1_evicted++;
-  for(int ii = 0; ii < pref_table_size; ii++) {
-    if(pref_table[ii].hwp_info->enabled && pref_table[ii].ul1_cache_evict) {
-      pref_table[ii].ul1_cache_evict(proc_id, addr);
-    }
-  }
+  if(PREF_TRACE_ON)
+    fprintf(PREF_TRACE_OUT, "%s \t %s \t %s \t %s\n", hexstr64s(cycle_count),
+            hexstr64s(0), hexstr64s(addr), "UL1_EVICT");
+  PREF_DISPATCH(HWP_HOOK_UL1_CACHE_EVICT, ul1_cache_evict, proc_id, addr);
 }
 
 inline void pref_ul1evictOnPF(uns8 pref_proc_id, uns8 evicted_proc_id,
@@ -29,6 +29,7 @@
 #ifndef __PREF_COMMON_H__
 #define __PREF_COMMON_H__
 
+#include "libs/hash_lib.h"
 #include "memory/mem_req.h"
 
 #define PREF_TRACKERS_NUM 16
@@ -125,6 +126,31 @@ struct HWP_struct {
                                             // mostly for Bingo's auxilary data
 };
 
+/* Training hooks of struct HWP_struct, in declaration order */
+typedef enum HWP_Hook_enum {
+  HWP_HOOK_DONE,
+  HWP_HOOK_PER_CORE_DONE,
+  HWP_HOOK_DL0_MISS,
+  HWP_HOOK_DL0_HIT,
+  HWP_HOOK_DL0_PREF_HIT,
+  HWP_HOOK_UMLC_MISS,
+  HWP_HOOK_UMLC_HIT,
+  HWP_HOOK_UMLC_PREF_HIT,
+  HWP_HOOK_UL1_MISS,
+  HWP_HOOK_UL1_HIT,
+  HWP_HOOK_UL1_PREF_HIT,
+  HWP_HOOK_UL1_CACHE_EVICT,
+  HWP_HOOK_NUM
+} HWP_Hook;
+
+/* A umlc/ul1 training event buffered under PREF_BATCH_EVENTS */
+typedef struct Pref_Batch_Event_struct {
+  HWP_Hook hook;
+  Addr     line_addr;
+  Addr     load_PC;
+  uns32    global_hist;
+} Pref_Batch_Event;
+
 /* Per core prefetching data */
 typedef struct HWP_Core_struct {
   Pref_Mem_Req* dl0req_queue;    // L1 req queue
@@ -140,6 +166,12 @@ typedef struct HWP_Core_struct {
   int ul1req_queue_req_pos;
   int ul1req_queue_send_pos;
 
+  // line_index -> Pref_Req_Queue_Line, so that filtering and deduplicating
+  // against a queue does not scan it
+  Hash_Table dl0req_queue_lines;
+  Hash_Table umlc_req_queue_lines;
+  Hash_Table ul1req_queue_lines;
+
   Counter ul1_misses;
   Counter curr_ul1_misses;
 
@@ -168,6 +200,18 @@ typedef struct HWP_Common_struct {
   Counter curr_num_ul1_misses;
 
   uns phase;
+
+  // enabled prefetchers that implement each hook, in priority order. Built
+  // once by pref_init() so that dispatch does not walk the whole pref_table.
+  HWP** hook_hwps[HWP_HOOK_NUM];
+  uns   num_hook_hwps[HWP_HOOK_NUM];
+
+  // PREF_BATCH_EVENTS: enabled prefetchers with any umlc/ul1 training hook,
+  // and each core's training events buffered until the next pref_update()
+  HWP**              batch_hwps;
+  uns                num_batch_hwps;
+  Pref_Batch_Event** batch_events;
+  uns*               num_batch_events;
 } HWP_Common;
 
 typedef enum {
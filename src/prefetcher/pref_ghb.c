@@ -95,8 +95,8 @@ void init_ghb_core(HWP* hwp, Pref_GHB* ghb_hwp_core) {
   for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     ghb_hwp_core[proc_id].hwp_info = hwp->hwp_info;
     ghb_hwp_core[proc_id].hwp_info->enabled = TRUE;
-    ghb_hwp_core[proc_id].index_table =
-        (GHB_Index_Table_Entry*)malloc(sizeof(GHB_Index_Table_Entry) * PREF_GHB_INDEX_N);
+    init_assoc_table(&ghb_hwp_core[proc_id].index_table, "pref_ghb.index_table", proc_id, PREF_GHB_INDEX_N,
+                     PREF_GHB_INDEX_WAYS, sizeof(GHB_Index_Table_Entry));
     ghb_hwp_core[proc_id].ghb_buffer = (GHB_Entry*)malloc(sizeof(GHB_Entry) * PREF_GHB_BUFFER_N);
 
     ghb_hwp_core[proc_id].ghb_head = -1;
@@ -106,10 +106,6 @@ void init_ghb_core(HWP* hwp, Pref_GHB* ghb_hwp_core) {
     ghb_hwp_core[proc_id].delta_buffer = (int*)calloc(ghb_hwp_core[proc_id].deltab_size, sizeof(int));
     ghb_hwp_core[proc_id].pref_degree = PREF_GHB_DEGREE;
 
-    for (ii = 0; ii < PREF_GHB_INDEX_N; ii++) {
-      ghb_hwp_core[proc_id].index_table[ii].valid = FALSE;
-      ghb_hwp_core[proc_id].index_table[ii].last_access = 0;
-    }
     for (ii = 0; ii < PREF_GHB_BUFFER_N; ii++) {
       ghb_hwp_core[proc_id].ghb_buffer[ii].ghb_ptr = -1;
       ghb_hwp_core[proc_id].ghb_buffer[ii].ghb_reverse_ptr = -1;
@@ -159,31 +155,12 @@ void pref_ghb_train(Pref_GHB* ghb_hwp, uns8 proc_id, Addr lineAddr, Addr loadPC,
   Addr currLineIndex = lineIndex;
   Addr index_tag = CZONE_TAG(lineAddr);
 
-  for (ii = 0; ii < PREF_GHB_INDEX_N; ii++) {
-    if (index_tag == ghb_hwp->index_table[ii].czone_tag && ghb_hwp->index_table[ii].valid) {
-      // got a hit in the index table
-      czone_idx = ii;
-      old_ptr = ghb_hwp->index_table[ii].ghb_ptr;
-      break;
-    }
-  }
-  if (czone_idx == -1) {
-    if (is_hit) {  // ONLY TRAIN on hit
-      return;
-    }
-
-    // Not present in index table.
-    // Make new czone
-    // First look if any entry is unused
-    for (ii = 0; ii < PREF_GHB_INDEX_N; ii++) {
-      if (!ghb_hwp->index_table[ii].valid) {
-        czone_idx = ii;
-        break;
-      }
-      if (czone_idx == -1 || (ghb_hwp->index_table[czone_idx].last_access < ghb_hwp->index_table[ii].last_access)) {
-        czone_idx = ii;
-      }
-    }
+  czone_idx = assoc_table_find(&ghb_hwp->index_table, index_tag, PREF_GHB_INDEX_WAYS);
+  if (czone_idx != -1) {
+    // got a hit in the index table
+    old_ptr = ((GHB_Index_Table_Entry*)assoc_table_entry(&ghb_hwp->index_table, czone_idx))->ghb_ptr;
+  } else if (is_hit) {  // ONLY TRAIN on hit
+    return;
   }
   if (old_ptr != -1 && ghb_hwp->ghb_buffer[old_ptr].miss_index == lineIndex) {
     return;
@@ -195,6 +172,12 @@ void pref_ghb_train(Pref_GHB* ghb_hwp, uns8 proc_id, Addr lineAddr, Addr loadPC,
     pref_ghb_throttle_fb(ghb_hwp);
   }
 
+  if (czone_idx == -1) {
+    // Not present in index table. Make new czone over an unused or the LRU entry of its set
+    czone_idx = assoc_table_insert_slot(&ghb_hwp->index_table, index_tag, PREF_GHB_INDEX_WAYS, NULL, NULL);
+  } else {
+    assoc_table_touch(&ghb_hwp->index_table, czone_idx, PREF_GHB_INDEX_WAYS);
+  }
   pref_ghb_create_newentry(ghb_hwp, czone_idx, lineAddr, index_tag, old_ptr);
 
   for (ii = 0; ii < ghb_hwp->deltab_size; ii++)
@@ -264,10 +247,8 @@ void pref_ghb_train(Pref_GHB* ghb_hwp, uns8 proc_id, Addr lineAddr, Addr loadPC,
 void pref_ghb_create_newentry(Pref_GHB* ghb_hwp, int idx, Addr line_addr, Addr czone_tag, int old_ptr) {
   int rev_ptr;
   int rev_idx_ptr;
-
-  ghb_hwp->index_table[idx].valid = TRUE;
-  ghb_hwp->index_table[idx].czone_tag = czone_tag;
-  ghb_hwp->index_table[idx].last_access = cycle_count;
+  GHB_Index_Table_Entry* index_entry = (GHB_Index_Table_Entry*)assoc_table_entry(&ghb_hwp->index_table, idx);
+  ASSERT(0, assoc_table_key(&ghb_hwp->index_table, idx) == czone_tag);
 
   // Now make entry in ghb
   ghb_hwp->ghb_tail = (ghb_hwp->ghb_tail + 1) % PREF_GHB_BUFFER_N;
@@ -287,9 +268,13 @@ void pref_ghb_create_newentry(Pref_GHB* ghb_hwp, int idx, Addr line_addr, Addr c
     ghb_hwp->ghb_buffer[rev_ptr].ghb_ptr = -1;
   }
 
-  if (rev_idx_ptr != -1 && ghb_hwp->index_table[rev_idx_ptr].ghb_ptr == ghb_hwp->ghb_tail && rev_idx_ptr != idx) {
-    ghb_hwp->index_table[rev_idx_ptr].ghb_ptr = -1;
-    ghb_hwp->index_table[rev_idx_ptr].valid = FALSE;
+  if (rev_idx_ptr != -1 && rev_idx_ptr != idx) {
+    GHB_Index_Table_Entry* rev_index_entry =
+        (GHB_Index_Table_Entry*)assoc_table_entry(&ghb_hwp->index_table, rev_idx_ptr);
+    if (rev_index_entry->ghb_ptr == ghb_hwp->ghb_tail) {
+      rev_index_entry->ghb_ptr = -1;
+      assoc_table_invalidate_slot(&ghb_hwp->index_table, rev_idx_ptr, PREF_GHB_INDEX_WAYS);
+    }
   }
 
   ghb_hwp->ghb_buffer[ghb_hwp->ghb_tail].miss_index = line_addr >> LOG2(DCACHE_LINE_SIZE);
@@ -299,7 +284,7 @@ void pref_ghb_create_newentry(Pref_GHB* ghb_hwp, int idx, Addr line_addr, Addr c
   if (old_ptr != -1)
     ghb_hwp->ghb_buffer[old_ptr].ghb_reverse_ptr = ghb_hwp->ghb_tail;
 
-  ghb_hwp->index_table[idx].ghb_ptr = ghb_hwp->ghb_tail;
+  index_entry->ghb_ptr = ghb_hwp->ghb_tail;
 }
 
 void pref_ghb_throttle(Pref_GHB* ghb_hwp) {
@@ -28,29 +28,29 @@
 #ifndef __PREF_GHB_H__
 #define __PREF_GHB_H__
 
+#include "libs/assoc_table.h"
 #include "pref_common.h"
 
 #define CZONE_TAG(x) (x >> (PREF_GHB_CZONE_BITS))
+#define PREF_GHB_INDEX_WAYS 8  // PREF_GHB_INDEX_N / PREF_GHB_INDEX_WAYS sets
 
+// index table entries are keyed by czone tag
 typedef struct GHB_Index_Table_Entry_Struct {
-  Addr czone_tag;
-  Flag valid;
-  uns ghb_ptr;      // ptr to last entry in ghb with same czone
-  uns last_access;  // for lru
+  uns ghb_ptr;  // ptr to last entry in ghb with same czone
 } GHB_Index_Table_Entry;
 
 typedef struct GHB_Entry_Struct {
   Addr miss_index;
   int ghb_ptr;          // -1 == invalid
   int ghb_reverse_ptr;  // -1 == invalid
-  int idx_reverse_ptr;
+  int idx_reverse_ptr;  // index table slot
 } GHB_Entry;
 
 typedef struct Pref_GHB_Struct {
   HWP_Info* hwp_info;
 
   // Index table
-  GHB_Index_Table_Entry* index_table;
+  Assoc_Table index_table;
   // GHB
   GHB_Entry* ghb_buffer;
 
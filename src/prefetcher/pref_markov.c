@@ -87,24 +87,15 @@ void pref_markov_init(HWP* hwp) {
 }
 
 void init_markov(HWP* hwp, Pref_Markov* markov_hwp_core, Addr* last_miss_addr_core) {
-  uns ii, jj, proc_id;
+  uns proc_id;
   Pref_Markov* markov_hwp;
   for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     last_miss_addr_core[proc_id] = 0;
     markov_hwp = &markov_hwp_core[proc_id];
     markov_hwp->hwp_info = hwp->hwp_info;
-
-    markov_hwp->markov_table = (Markov_Table_Entry**)calloc(PREF_MARKOV_NUM_ENTRIES, sizeof(Markov_Table_Entry*));
-    for (ii = 0; ii < PREF_MARKOV_NUM_ENTRIES; ii++) {
-      markov_hwp->markov_table[ii] =
-          (Markov_Table_Entry*)calloc(PREF_MARKOV_NUM_NEXT_STATES, sizeof(Markov_Table_Entry));
-      for (jj = 0; jj < PREF_MARKOV_NUM_NEXT_STATES; jj++) {
-        markov_hwp->markov_table[ii][jj].valid = 0;
-        markov_hwp->markov_table[ii][jj].next_addr = 0;
-        markov_hwp->markov_table[ii][jj].tag = 0;
-        markov_hwp->markov_table[ii][jj].count = 0;
-      }
-    }
+    markov_hwp->num_updates = 0;
+    init_assoc_table(&markov_hwp->markov_table, "pref_markov.markov_table", proc_id, PREF_MARKOV_NUM_ENTRIES,
+                     PREF_MARKOV_WAYS, PREF_MARKOV_NUM_NEXT_STATES * sizeof(Markov_Table_Entry));
   }
 }
 
@@ -144,64 +135,38 @@ void pref_markov_update_table(Pref_Markov* markov_hwp, Addr* last_miss_addr_core
                               Flag true_miss) {
   unsigned ii = 0;
   Addr last_miss_addr = last_miss_addr_core[proc_id];
-  unsigned table_index = (last_miss_addr >> LOG2(L1_LINE_SIZE)) % PREF_MARKOV_NUM_ENTRIES;
-  Flag new_entry = 0;
-  Markov_Table_Entry temp = {0};
+  Markov_Table_Entry* next_states;
+  unsigned victim = 0;
 
   if (!last_miss_addr) {
     last_miss_addr_core[proc_id] = current_addr;
     return;
   }
 
+  // one pass finds the state for current_addr and the replacement victim: an
+  // unused state, else the LRU (policy 0) or least frequently used (policy 1) one
+  next_states = (Markov_Table_Entry*)assoc_table_access_create(&markov_hwp->markov_table, last_miss_addr,
+                                                               PREF_MARKOV_WAYS, NULL);
+  markov_hwp->num_updates++;
   for (ii = 0; ii < PREF_MARKOV_NUM_NEXT_STATES; ii++) {
-    if (markov_hwp->markov_table[table_index][ii].valid) {
-      if ((markov_hwp->markov_table[table_index][ii].next_addr == current_addr) &&
-          (markov_hwp->markov_table[table_index][ii].tag == last_miss_addr)) {
-        if (markov_hwp->markov_table[table_index][ii].count < MAX_CTR)
-          markov_hwp->markov_table[table_index][ii].count++;  // only used for
-                                                              // LFU, not used
-                                                              // for LRU
-        temp = markov_hwp->markov_table[table_index][ii];
-        break;
-      }
-    } else {
-      new_entry = 1;
+    Markov_Table_Entry* state = &next_states[ii];
+    if (state->count && state->next_addr == current_addr)
       break;
-    }
+    if (!next_states[victim].count)
+      continue;
+    if (!state->count || (PREF_MARKOV_TABLE_UPDATE_POLICY == 0 ? state->last_use < next_states[victim].last_use
+                                                               : state->count < next_states[victim].count))
+      victim = ii;
   }
 
-  if (ii == PREF_MARKOV_NUM_NEXT_STATES) {
-    new_entry = 1;
-    ii--;
-  }
-
-  if (PREF_MARKOV_TABLE_UPDATE_POLICY == 0) {  // LRU
-    for (; ii > 0; ii--)
-      markov_hwp->markov_table[table_index][ii] = markov_hwp->markov_table[table_index][ii - 1];
-
-    if (new_entry) {
-      markov_hwp->markov_table[table_index][0].next_addr = current_addr;
-      markov_hwp->markov_table[table_index][0].valid = 1;
-      markov_hwp->markov_table[table_index][0].tag = last_miss_addr;
-      markov_hwp->markov_table[table_index][0].count = 1;
-    } else
-      markov_hwp->markov_table[table_index][0] = temp;
-  } else if (PREF_MARKOV_TABLE_UPDATE_POLICY == 1) {  // LFU
-    if (new_entry) {
-      markov_hwp->markov_table[table_index][ii].next_addr = current_addr;
-      markov_hwp->markov_table[table_index][ii].valid = 1;
-      markov_hwp->markov_table[table_index][ii].tag = last_miss_addr;
-      markov_hwp->markov_table[table_index][ii].count = 1;
-    } else {
-      for (; ii > 0; ii--) {
-        if (markov_hwp->markov_table[table_index][ii].count > markov_hwp->markov_table[table_index][ii - 1].count) {
-          temp = markov_hwp->markov_table[table_index][ii];
-          markov_hwp->markov_table[table_index][ii] = markov_hwp->markov_table[table_index][ii - 1];
-          markov_hwp->markov_table[table_index][ii - 1] = temp;
-        } else
-          break;
-      }
-    }
+  if (ii < PREF_MARKOV_NUM_NEXT_STATES) {
+    if (next_states[ii].count < MAX_CTR)
+      next_states[ii].count++;  // only used for LFU, not used for LRU
+    next_states[ii].last_use = markov_hwp->num_updates;
+  } else {
+    next_states[victim].next_addr = current_addr;
+    next_states[victim].count = 1;
+    next_states[victim].last_use = markov_hwp->num_updates;
   }
 
   if (true_miss)
@@ -210,20 +175,17 @@ void pref_markov_update_table(Pref_Markov* markov_hwp, Addr* last_miss_addr_core
 
 void pref_markov_send_prefetches(Pref_Markov* markov_hwp, uns8 proc_id, Addr miss_lineAddr) {
   unsigned ii = 0;
-  unsigned table_index = (miss_lineAddr >> LOG2(L1_LINE_SIZE)) % PREF_MARKOV_NUM_ENTRIES;
+  Markov_Table_Entry* next_states = (Markov_Table_Entry*)assoc_table_access(&markov_hwp->markov_table, miss_lineAddr,
+                                                                            PREF_MARKOV_WAYS, FALSE);
+  if (!next_states)
+    return;
 
   for (ii = 0; ii < PREF_MARKOV_NUM_NEXT_STATES; ii++) {
-    if (markov_hwp->markov_table[table_index][ii].valid) {
-      if ((markov_hwp->markov_table[table_index][ii].tag == miss_lineAddr) &&
-          (markov_hwp->markov_table[table_index][ii].count > PREF_MARKOV_SEND_THRESHOLD)) {
-        if (markov_hwp->type == UMLC)
-          pref_addto_umlc_req_queue(proc_id, markov_hwp->markov_table[table_index][ii].next_addr >> LOG2(L1_LINE_SIZE),
-                                    markov_hwp->hwp_info->id);
-        else
-          pref_addto_ul1req_queue(proc_id, markov_hwp->markov_table[table_index][ii].next_addr >> LOG2(L1_LINE_SIZE),
-                                  markov_hwp->hwp_info->id);
-      }
-    } else
-      break;
+    if (next_states[ii].count > PREF_MARKOV_SEND_THRESHOLD) {
+      if (markov_hwp->type == UMLC)
+        pref_addto_umlc_req_queue(proc_id, next_states[ii].next_addr >> LOG2(L1_LINE_SIZE), markov_hwp->hwp_info->id);
+      else
+        pref_addto_ul1req_queue(proc_id, next_states[ii].next_addr >> LOG2(L1_LINE_SIZE), markov_hwp->hwp_info->id);
+    }
   }
 }
@@ -28,18 +28,23 @@
 #ifndef __PREF_MARKOV_H__
 #define __PREF_MARKOV_H__
 
+#include "libs/assoc_table.h"
 #include "pref_common.h"
 
+#define PREF_MARKOV_WAYS 4  // PREF_MARKOV_NUM_ENTRIES / PREF_MARKOV_WAYS sets
+
+// The markov table is keyed by miss address; each entry holds
+// PREF_MARKOV_NUM_NEXT_STATES of these for the misses that followed it.
 typedef struct Markov_Table_Entry_Struct {
-  Flag valid;
   Addr next_addr;
-  Addr tag;
-  Counter count;
+  Counter count;     // 0 if the state is unused
+  Counter last_use;  // update number of the last update, for LRU
 } Markov_Table_Entry;
 
 typedef struct Pref_Markov_Struct {
   HWP_Info* hwp_info;
-  Markov_Table_Entry** markov_table;
+  Assoc_Table markov_table;
+  Counter num_updates;
   CacheLevel type;
 } Pref_Markov;
 
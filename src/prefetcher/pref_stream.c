@@ -63,12 +63,13 @@
 /**************************************************************************************/
 /* Global Variables */
 
-extern Dcache_Stage* dc;
+extern CORE_LOCAL Dcache_Stage* dc;
 
 /***************************************************************************************/
 /* Local Prototypes */
 
 static void collect_stream_stats(const Stream_Buffer* stream);
+static inline int next_candidate_stream(const Pref_Stream* pref_stream, Addr line_index, int extra_dis, int ii);
 
 /**************************************************************************************/
 /* stream prefetcher  */
@@ -121,6 +122,9 @@ void init_stream_core(HWP* hwp, Pref_Stream* pref_stream_core) {
     if (PREF_STREAM_PER_CORE_ENABLE) {
       pref_stream_core[proc_id].stream = (Stream_Buffer*)calloc(STREAM_BUFFER_N, sizeof(Stream_Buffer));
       memset(pref_stream_core[proc_id].stream, 0, STREAM_BUFFER_N * sizeof(Stream_Buffer));
+      pref_stream_core[proc_id].stream_index = (Stream_Index*)malloc(sizeof(Stream_Index));
+      init_stream_index(pref_stream_core[proc_id].stream_index, pref_stream_core[proc_id].stream, STREAM_BUFFER_N,
+                        STREAM_TRAIN_LENGTH);
       pref_stream_core[proc_id].train_filter = (Addr*)calloc(TRAIN_FILTER_SIZE, sizeof(Addr));
       memset(pref_stream_core[proc_id].train_filter, 0, TRAIN_FILTER_SIZE * sizeof(Addr));
       pref_stream_core[proc_id].train_filter_no = (int*)malloc(sizeof(int));
@@ -148,6 +152,9 @@ void init_stream_core(HWP* hwp, Pref_Stream* pref_stream_core) {
   if (!PREF_STREAM_PER_CORE_ENABLE) {
     pref_stream_core[0].stream = (Stream_Buffer*)calloc(STREAM_BUFFER_N, sizeof(Stream_Buffer));
     memset(pref_stream_core[0].stream, 0, STREAM_BUFFER_N * sizeof(Stream_Buffer));
+    pref_stream_core[0].stream_index = (Stream_Index*)malloc(sizeof(Stream_Index));
+    init_stream_index(pref_stream_core[0].stream_index, pref_stream_core[0].stream, STREAM_BUFFER_N,
+                      STREAM_TRAIN_LENGTH);
     pref_stream_core[0].train_filter = (Addr*)calloc(TRAIN_FILTER_SIZE, sizeof(Addr));
     memset(pref_stream_core[0].train_filter, 0, TRAIN_FILTER_SIZE * sizeof(Addr));
     pref_stream_core[0].train_filter_no = (int*)malloc(sizeof(int));
@@ -155,6 +162,7 @@ void init_stream_core(HWP* hwp, Pref_Stream* pref_stream_core) {
 
     for (proc_id = 1; proc_id < NUM_CORES; proc_id++) {
       pref_stream_core[proc_id].stream = pref_stream_core[0].stream;
+      pref_stream_core[proc_id].stream_index = pref_stream_core[0].stream_index;
       pref_stream_core[proc_id].train_filter = pref_stream_core[0].train_filter;
       pref_stream_core[proc_id].train_filter_no = pref_stream_core[0].train_filter_no;
     }
@@ -199,7 +207,7 @@ void pref_stream_train(Pref_Stream* pref_stream, uns8 proc_id, Addr line_addr, A
     ASSERT(proc_id, proc_id == stream->proc_id);
 
     if (stream->trained) {
-      stream->lru = cycle_count;  // update lru
+      stream_index_set_lru(pref_stream->stream_index, hit_index, cycle_count);  // update lru
       STAT_EVENT(0, HIT_TRAIN_STREAM);
       stream->pause = SAT_DEC(stream->pause, 0);
       if (stream->pause > 0)
@@ -224,6 +232,7 @@ void pref_stream_train(Pref_Stream* pref_stream, uns8 proc_id, Addr line_addr, A
         // addresses
         if (proc_id != (stream->ep + stream->dir) >> (58 - LOG2(DCACHE_LINE_SIZE))) {
           stream->valid = FALSE;
+          stream_index_update(pref_stream->stream_index, hit_index);
           return;
         }
 
@@ -251,6 +260,7 @@ void pref_stream_train(Pref_Stream* pref_stream, uns8 proc_id, Addr line_addr, A
           stream->buffer_full = TRUE;
           stream->sp = stream->sp + stream->dir;
         }
+        stream_index_update(pref_stream->stream_index, hit_index);
 
         if (REMOVE_REDUNDANT_STREAM)
           pref_stream_remove_redundant_stream(pref_stream, hit_index);
@@ -303,7 +313,8 @@ int pref_stream_train_create_stream_buffer(Pref_Stream* pref_stream, uns8 proc_i
           "extra_dis should not be used when altering prefetcher state\n");
 
   // First check for a trained buffer
-  for (ii = 0; ii < STREAM_BUFFER_N; ii++) {
+  for (ii = next_candidate_stream(pref_stream, line_index, extra_dis, -1); ii >= 0;
+       ii = next_candidate_stream(pref_stream, line_index, extra_dis, ii)) {
     Stream_Buffer* stream = &pref_stream->stream[ii];
     if (stream->valid && stream->trained) {
       if (((stream->sp <= line_index) && (stream->ep + extra_dis >= line_index) && (stream->dir == 1)) ||
@@ -318,7 +329,8 @@ int pref_stream_train_create_stream_buffer(Pref_Stream* pref_stream, uns8 proc_i
   }
 
   if (train || create) {
-    for (ii = 0; ii < STREAM_BUFFER_N; ii++) {
+    for (ii = next_candidate_stream(pref_stream, line_index, 0, -1); ii >= 0;
+         ii = next_candidate_stream(pref_stream, line_index, 0, ii)) {
       Stream_Buffer* stream = &pref_stream->stream[ii];
       if (stream->valid && !stream->trained) {
         if ((stream->sp <= (line_index + STREAM_TRAIN_LENGTH)) && (stream->sp >= (line_index - STREAM_TRAIN_LENGTH))) {
@@ -338,9 +350,11 @@ int pref_stream_train_create_stream_buffer(Pref_Stream* pref_stream, uns8 proc_i
               // check for address space overflow
               if (get_proc_id_from_cmp_addr(stream->ep << LOG2(DCACHE_LINE_SIZE)) != proc_id) {
                 stream->valid = FALSE;
+                stream_index_update(pref_stream->stream_index, ii);
                 return -1;
               }
               stream->dir = dir;
+              stream_index_update(pref_stream->stream_index, ii);
               DEBUG(proc_id,
                     "stream  trained stream_index:%3d sp %7s ep %7s dir %2d "
                     "miss_index %7d\n",
@@ -358,24 +372,10 @@ int pref_stream_train_create_stream_buffer(Pref_Stream* pref_stream, uns8 proc_i
   }
 
   if (create) {
-    // search for invalid buffer
-    for (ii = 0; ii < STREAM_BUFFER_N; ii++) {
-      if (!pref_stream->stream[ii].valid) {
-        lru_index = ii;
-        break;
-      }
-    }
-
-    // search for oldest buffer
-
-    if (lru_index == -1) {
-      lru_index = 0;
+    // an invalid buffer if there is one, else the oldest buffer
+    lru_index = stream_index_victim(pref_stream->stream_index);
 
-      for (ii = 0; ii < STREAM_BUFFER_N; ii++) {
-        if (pref_stream->stream[ii].lru < pref_stream->stream[lru_index].lru) {
-          lru_index = ii;
-        }
-      }
+    if (pref_stream->stream[lru_index].valid) {
       STAT_EVENT(0, REPLACE_OLD_STREAM);
       collect_stream_stats(&pref_stream->stream[lru_index]);
       if (PREF_STREAM_PER_CORE_ENABLE) {
@@ -387,7 +387,7 @@ int pref_stream_train_create_stream_buffer(Pref_Stream* pref_stream, uns8 proc_i
     // create new train buffer
     Stream_Buffer* lru_stream = &pref_stream->stream[lru_index];
     lru_stream->proc_id = proc_id;
-    lru_stream->lru = cycle_count;
+    stream_index_set_lru(pref_stream->stream_index, lru_index, cycle_count);
     lru_stream->valid = TRUE;
     lru_stream->sp = line_index;
     lru_stream->ep = line_index;
@@ -399,6 +399,7 @@ int pref_stream_train_create_stream_buffer(Pref_Stream* pref_stream, uns8 proc_i
     lru_stream->length = STREAM_LENGTH;
     lru_stream->pref_issued = 0;
     lru_stream->pref_useful = 0;
+    stream_index_update(pref_stream->stream_index, lru_index);
 
     STAT_EVENT_ALL(STREAM_TRAIN_CREATE);
     STAT_EVENT(proc_id, CORE_STREAM_TRAIN_CREATE);
@@ -497,6 +498,7 @@ void pref_stream_remove_redundant_stream(Pref_Stream* pref_stream, int hit_index
     if ((stream->ep < hit_stream->ep && stream->ep > hit_stream->sp) ||
         (stream->sp < hit_stream->ep && stream->sp > hit_stream->sp)) {
       stream->valid = FALSE;
+      stream_index_update(pref_stream->stream_index, ii);
       STAT_EVENT(0, REMOVE_REDUNDANT_STREAM_STAT);
       DEBUG(0, "stream[%d] sp:0x%s ep:0x%s is removed by stream[%d] sp:0x%s ep:0x%s\n", ii, hexstr64(stream->sp),
             hexstr64(stream->ep), hit_index, hexstr64(hit_stream->sp), hexstr64(hit_stream->ep));
@@ -567,6 +569,14 @@ void pref_stream_throttle_streams(Pref_Stream* pref_stream, Addr line_index) {
    throttle_stream_pf -> reset the stream length and train length for this
    stream buffer
 */
+/* next_candidate_stream: the next stream after ii that may match line_index. A lookup that
+   reaches extra_dis lines past the end of trained streams visits every stream. */
+static inline int next_candidate_stream(const Pref_Stream* pref_stream, Addr line_index, int extra_dis, int ii) {
+  if (extra_dis)
+    return ii + 1 < (int)STREAM_BUFFER_N ? ii + 1 : -1;
+  return stream_index_next(pref_stream->stream_index, line_index, ii);
+}
+
 void pref_stream_throttle_stream(int index) {
   // FIXME: why is this here?
 }
@@ -31,6 +31,7 @@
 #include "globals/global_types.h"
 
 #include "pref_common.h"
+#include "stream_index.h"
 
 /**************************************************************************************/
 /* Forward Declarations */
@@ -69,6 +70,7 @@ typedef struct Pref_Stream_struct {
   // WATCHOUT These are shared by cores or duplicated based on
   // PREF_STREAM_PER_CORE_ENABLE
   Stream_Buffer* stream;
+  Stream_Index* stream_index;
   Addr* train_filter;
   int* train_filter_no;
   ////////////////////////////////////////////////
@@ -0,0 +1,208 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : prefetcher/stream_index.c
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Region index over a stream buffer array.
+ ***************************************************************************************/
+
+#include "prefetcher/stream_index.h"
+
+#include <stdlib.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/utils.h"
+
+#include "prefetcher/pref_stream.h"
+
+/**************************************************************************************/
+/* Macros */
+
+#define STREAM_INDEX_REGION_BITS 6  // 64 lines per region
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static inline uns64* stream_index_bucket(const Stream_Index* index, Addr region);
+static void stream_index_mark(Stream_Index* index, int ii, Addr first, Addr last, Flag set);
+
+/**************************************************************************************/
+/* init_stream_index: */
+
+void init_stream_index(Stream_Index* index, Stream_Buffer* streams, uns num_streams, uns train_length) {
+  uns num_buckets = 64;
+  while (num_buckets < 4 * num_streams)
+    num_buckets <<= 1;
+
+  index->streams = streams;
+  index->num_streams = num_streams;
+  index->words = (num_streams + 63) / 64;
+  index->bucket_mask = num_buckets - 1;
+  index->train_length = train_length;
+  index->buckets = (uns64*)calloc(num_buckets * index->words, sizeof(uns64));
+  index->valid = (uns64*)calloc(index->words, sizeof(uns64));
+  index->first_region = (Addr*)malloc(num_streams * sizeof(Addr));
+  index->last_region = (Addr*)malloc(num_streams * sizeof(Addr));
+  index->lru_prev = (int*)malloc(num_streams * sizeof(int));
+  index->lru_next = (int*)malloc(num_streams * sizeof(int));
+
+  // the list starts in index order, matching the lowest-index tie break of the old lru scan
+  for (uns ii = 0; ii < num_streams; ii++) {
+    ASSERT(0, !streams[ii].valid && streams[ii].lru == 0);
+    index->first_region[ii] = 1;
+    index->last_region[ii] = 0;
+    index->lru_prev[ii] = (int)ii - 1;
+    index->lru_next[ii] = ii + 1 < num_streams ? (int)ii + 1 : -1;
+  }
+  index->lru_head = 0;
+  index->lru_tail = (int)num_streams - 1;
+}
+
+/**************************************************************************************/
+/* stream_index_update: reindexes stream ii after its valid, trained, sp or ep changed */
+
+void stream_index_update(Stream_Index* index, int ii) {
+  const Stream_Buffer* stream = &index->streams[ii];
+  const uns64 bit = 1ULL << (ii & 63);
+  Addr first = 1, last = 0;
+
+  if (stream->valid) {
+    Addr lo, hi;
+    if (stream->trained) {
+      lo = MIN2(stream->sp, stream->ep);
+      hi = MAX2(stream->sp, stream->ep);
+    } else {
+      lo = stream->sp > index->train_length ? stream->sp - index->train_length : 0;
+      hi = stream->sp + index->train_length;
+    }
+    first = lo >> STREAM_INDEX_REGION_BITS;
+    last = hi >> STREAM_INDEX_REGION_BITS;
+    index->valid[ii >> 6] |= bit;
+  } else {
+    index->valid[ii >> 6] &= ~bit;
+  }
+
+  if (first == index->first_region[ii] && last == index->last_region[ii])
+    return;
+  if (index->first_region[ii] <= index->last_region[ii])
+    stream_index_mark(index, ii, index->first_region[ii], index->last_region[ii], FALSE);
+  if (first <= last)
+    stream_index_mark(index, ii, first, last, TRUE);
+  index->first_region[ii] = first;
+  index->last_region[ii] = last;
+}
+
+/**************************************************************************************/
+/* stream_index_set_lru: sets the lru of stream ii and moves it to its place in the list */
+
+void stream_index_set_lru(Stream_Index* index, int ii, int lru) {
+  index->streams[ii].lru = lru;
+
+  if (index->lru_prev[ii] >= 0)
+    index->lru_next[index->lru_prev[ii]] = index->lru_next[ii];
+  else
+    index->lru_head = index->lru_next[ii];
+  if (index->lru_next[ii] >= 0)
+    index->lru_prev[index->lru_next[ii]] = index->lru_prev[ii];
+  else
+    index->lru_tail = index->lru_prev[ii];
+
+  // lru is normally the current cycle, so the walk stops at the tail
+  int pos = index->lru_tail;
+  while (pos >= 0 && index->streams[pos].lru > lru)
+    pos = index->lru_prev[pos];
+
+  index->lru_prev[ii] = pos;
+  index->lru_next[ii] = pos >= 0 ? index->lru_next[pos] : index->lru_head;
+  if (index->lru_next[ii] >= 0)
+    index->lru_prev[index->lru_next[ii]] = ii;
+  else
+    index->lru_tail = ii;
+  if (pos >= 0)
+    index->lru_next[pos] = ii;
+  else
+    index->lru_head = ii;
+}
+
+/**************************************************************************************/
+/* stream_index_next: the lowest stream above after that may cover line_index, or -1 */
+
+int stream_index_next(const Stream_Index* index, Addr line_index, int after) {
+  const uns64* bucket = stream_index_bucket(index, line_index >> STREAM_INDEX_REGION_BITS);
+  const uns start = after + 1;
+
+  for (uns word = start >> 6; word < index->words; word++) {
+    uns64 bits = bucket[word];
+    if (word == start >> 6)
+      bits &= ~0ULL << (start & 63);
+    if (bits)
+      return word * 64 + __builtin_ctzll(bits);
+  }
+  return -1;
+}
+
+/**************************************************************************************/
+/* stream_index_victim: the lowest invalid stream, else the lowest of the streams with
+   the smallest lru */
+
+int stream_index_victim(const Stream_Index* index) {
+  for (uns word = 0; word < index->words; word++) {
+    uns64 free_bits = ~index->valid[word];
+    if (word == index->words - 1 && index->num_streams % 64)
+      free_bits &= (1ULL << (index->num_streams % 64)) - 1;
+    if (free_bits)
+      return word * 64 + __builtin_ctzll(free_bits);
+  }
+
+  const int oldest_lru = index->streams[index->lru_head].lru;
+  int victim = index->lru_head;
+  for (int pos = index->lru_next[victim]; pos >= 0 && index->streams[pos].lru == oldest_lru;
+       pos = index->lru_next[pos])
+    victim = MIN2(victim, pos);
+  return victim;
+}
+
+/**************************************************************************************/
+/* stream_index_bucket: */
+
+static inline uns64* stream_index_bucket(const Stream_Index* index, Addr region) {
+  return &index->buckets[(region & index->bucket_mask) * index->words];
+}
+
+/**************************************************************************************/
+/* stream_index_mark: sets or clears stream ii in the buckets of regions first to last */
+
+static void stream_index_mark(Stream_Index* index, int ii, Addr first, Addr last, Flag set) {
+  const uns64 bit = 1ULL << (ii & 63);
+  // a span longer than the table visits every bucket once
+  const Addr count = MIN2(last - first, (Addr)index->bucket_mask) + 1;
+
+  for (Addr jj = 0; jj < count; jj++) {
+    uns64* word = &stream_index_bucket(index, first + jj)[ii >> 6];
+    if (set)
+      *word |= bit;
+    else
+      *word &= ~bit;
+  }
+}
@@ -0,0 +1,73 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : prefetcher/stream_index.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Region index over a stream buffer array. Maps each 64-line
+ *                region to the streams whose span may cover it, and keeps the
+ *                streams in LRU order, so that matching a miss and picking a
+ *                stream to replace do not scan the whole array.
+ ***************************************************************************************/
+
+#ifndef __STREAM_INDEX_H__
+#define __STREAM_INDEX_H__
+
+#include "globals/global_types.h"
+
+/**************************************************************************************/
+/* Types */
+
+/* The index only narrows the search: every stream whose [sp, ep] span (or, for
+   a stream still training, sp +- train_length) touches the region of a line is
+   returned as a candidate, in ascending stream order, and the caller applies
+   its own match test. The owner of the stream array must call
+   stream_index_update after changing valid, trained, sp or ep of a stream and
+   set lru only through stream_index_set_lru. */
+typedef struct Stream_Index_struct {
+  Stream_Buffer* streams;
+  uns num_streams;
+  uns words;           // uns64 words of stream bits per bucket
+  uns bucket_mask;     // number of buckets - 1
+  Addr train_length;   // a training stream matches within this many lines of sp
+  uns64* buckets;      // (bucket_mask + 1) * words stream bits
+  uns64* valid;        // one bit per valid stream
+  Addr* first_region;  // region span each stream is indexed under,
+  Addr* last_region;   // first > last when it is not indexed
+  int* lru_prev;       // streams ordered by ascending lru, -1 ends the list
+  int* lru_next;
+  int lru_head;
+  int lru_tail;
+} Stream_Index;
+
+/**************************************************************************************/
+/* Prototypes */
+
+void init_stream_index(Stream_Index* index, Stream_Buffer* streams, uns num_streams, uns train_length);
+void stream_index_update(Stream_Index* index, int ii);
+void stream_index_set_lru(Stream_Index* index, int ii, int lru);
+int stream_index_next(const Stream_Index* index, Addr line_index, int after);
+int stream_index_victim(const Stream_Index* index);
+
+/**************************************************************************************/
+
+#endif /* #ifndef __STREAM_INDEX_H__ */
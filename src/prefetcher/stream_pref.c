@@ -62,7 +62,7 @@
 /**************************************************************************************/
 /* Global Variables */
 
-extern Dcache_Stage* dc;
+extern CORE_LOCAL Dcache_Stage* dc;
 
 /***************************************************************************************/
 /* Local Prototypes */
@@ -102,6 +102,7 @@ static int l2hit_l2access_send_no;
 void init_stream_HWP(void) {
   stream_hwp = (Stream_HWP*)malloc(sizeof(Stream_HWP));
   stream_hwp->stream = (Stream_Buffer*)calloc(STREAM_BUFFER_N, sizeof(Stream_Buffer));
+  init_stream_index(&stream_hwp->stream_index, stream_hwp->stream, STREAM_BUFFER_N, STREAM_TRAIN_LENGTH);
 
   stream_hwp->pref_req_queue = (Pref_Mem_Req*)calloc(PREF_REQ_Q_SIZE, sizeof(Pref_Mem_Req));
   train_filter = (Addr*)calloc(TRAIN_FILTER_SIZE, sizeof(Addr));
@@ -141,7 +142,7 @@ void stream_dl0_miss(Addr line_addr) /* line_addr: the first address of the
     addto_train_stream_filter(line_index);
 
     if (stream_hwp->stream[hit_index].trained) {
-      stream_hwp->stream[hit_index].lru = cycle_count;  // update lru
+      stream_index_set_lru(&stream_hwp->stream_index, hit_index, cycle_count);  // update lru
       STAT_EVENT(proc_id, HIT_TRAIN_STREAM);
       /* hit the stream_buffer, request the prefetch */
 
@@ -180,6 +181,7 @@ void stream_dl0_miss(Addr line_addr) /* line_addr: the first address of the
           stream_hwp->stream[hit_index].buffer_full = TRUE;
           stream_hwp->stream[hit_index].sp = stream_hwp->stream[hit_index].sp + stream_hwp->stream[hit_index].dir;
         }
+        stream_index_update(&stream_hwp->stream_index, hit_index);
         STAT_EVENT(proc_id, STREAM_BUFFER_REQ);
 
         if (REMOVE_REDUNDANT_STREAM)
@@ -213,7 +215,7 @@ void stream_dl0_hit_train(Addr line_addr) {
     addto_train_stream_filter(line_index);
 
     if (stream_hwp->stream[hit_index].trained) {
-      stream_hwp->stream[hit_index].lru = cycle_count;  // update lru
+      stream_index_set_lru(&stream_hwp->stream_index, hit_index, cycle_count);  // update lru
       STAT_EVENT(proc_id, HIT_TRAIN_STREAM);
       /* hit the stream_buffer, request the prefetch */
 
@@ -252,6 +254,7 @@ void stream_dl0_hit_train(Addr line_addr) {
           stream_hwp->stream[hit_index].buffer_full = TRUE;
           stream_hwp->stream[hit_index].sp = stream_hwp->stream[hit_index].sp + stream_hwp->stream[hit_index].dir;
         }
+        stream_index_update(&stream_hwp->stream_index, hit_index);
         STAT_EVENT(proc_id, STREAM_BUFFER_REQ);
 
         if (REMOVE_REDUNDANT_STREAM)
@@ -408,7 +411,8 @@ int train_create_stream_buffer(uns proc_id, Addr line_index, Flag train, Flag cr
   int lru_index = -1;
 
   if (train || create) {
-    for (ii = 0; ii < STREAM_BUFFER_N; ii++) {
+    for (ii = stream_index_next(&stream_hwp->stream_index, line_index, -1); ii >= 0;
+         ii = stream_index_next(&stream_hwp->stream_index, line_index, ii)) {
       if (stream_hwp->stream[ii].valid && stream_hwp->stream[ii].trained) {
         if (((stream_hwp->stream[ii].sp <= line_index) && (stream_hwp->stream[ii].ep >= line_index) &&
              (stream_hwp->stream[ii].dir == 1)) ||
@@ -420,7 +424,8 @@ int train_create_stream_buffer(uns proc_id, Addr line_index, Flag train, Flag cr
       }
     }
 
-    for (ii = 0; ii < STREAM_BUFFER_N; ii++) {
+    for (ii = stream_index_next(&stream_hwp->stream_index, line_index, -1); ii >= 0;
+         ii = stream_index_next(&stream_hwp->stream_index, line_index, ii)) {
       if (stream_hwp->stream[ii].valid && (!stream_hwp->stream[ii].trained)) {
         if ((stream_hwp->stream[ii].sp <= (line_index + STREAM_TRAIN_LENGTH)) &&
             (stream_hwp->stream[ii].sp >= (line_index - STREAM_TRAIN_LENGTH))) {  // FIXME: should creation be
@@ -437,6 +442,7 @@ int train_create_stream_buffer(uns proc_id, Addr line_index, Flag train, Flag cr
             stream_hwp->stream[ii].ep =
                 (dir > 0) ? line_index + STREAM_START_DIS : line_index - STREAM_START_DIS;  // BUG 57
             stream_hwp->stream[ii].dir = dir;
+            stream_index_update(&stream_hwp->stream_index, ii);
             DEBUG(proc_id,
                   "stream  trained stream_index:%3d sp %7s ep %7s dir %2d "
                   "miss_index %7d\n",
@@ -454,35 +460,21 @@ int train_create_stream_buffer(uns proc_id, Addr line_index, Flag train, Flag cr
   }
 
   if (create) {
-    // search for invalid buffer
-    for (ii = 0; ii < STREAM_BUFFER_N; ii++) {
-      if (!stream_hwp->stream[ii].valid) {
-        lru_index = ii;
-        break;
-      }
-    }
-
-    // search for oldest buffer
-
-    if (lru_index == -1) {
-      lru_index = 0;
-      for (ii = 0; ii < STREAM_BUFFER_N; ii++) {
-        if (stream_hwp->stream[ii].lru < stream_hwp->stream[lru_index].lru) {
-          lru_index = ii;
-        }
-      }
+    // an invalid buffer if there is one, else the oldest buffer
+    lru_index = stream_index_victim(&stream_hwp->stream_index);
+    if (stream_hwp->stream[lru_index].valid)
       STAT_EVENT(proc_id, REPLACE_OLD_STREAM);
-    }
 
     // create new train buffer
 
-    stream_hwp->stream[lru_index].lru = cycle_count;
+    stream_index_set_lru(&stream_hwp->stream_index, lru_index, cycle_count);
     stream_hwp->stream[lru_index].valid = TRUE;
     stream_hwp->stream[lru_index].sp = line_index;
     stream_hwp->stream[lru_index].ep = line_index;
     stream_hwp->stream[lru_index].train_hit = 1;
     stream_hwp->stream[lru_index].trained = FALSE;
     stream_hwp->stream[lru_index].buffer_full = FALSE;
+    stream_index_update(&stream_hwp->stream_index, lru_index);
 
     STAT_EVENT(proc_id, STREAM_TRAIN_CREATE);
     DEBUG(proc_id, "create new stream : stream_no :%3d, line_index %7s sp = %7s\n", lru_index, hexstr64(line_index),
@@ -700,6 +692,7 @@ void remove_redundant_stream(int hit_index) {
         ((stream_hwp->stream[ii].sp < stream_hwp->stream[hit_index].ep) &&
          (stream_hwp->stream[ii].sp > stream_hwp->stream[hit_index].sp))) {
       stream_hwp->stream[ii].valid = FALSE;
+      stream_index_update(&stream_hwp->stream_index, ii);
       STAT_EVENT(0, REMOVE_REDUNDANT_STREAM_STAT);
       DEBUG(0, "stream[%d] sp:0x%s ep:0x%s is removed by stream[%d] sp:0x%s ep:0x%s\n", ii,
             hexstr64(stream_hwp->stream[ii].sp), hexstr64(stream_hwp->stream[ii].ep), hit_index,
@@ -30,6 +30,8 @@
 
 #include "globals/global_types.h"
 
+#include "prefetcher/stream_index.h"
+
 /**************************************************************************************/
 /* Forward Declarations */
 
@@ -43,6 +45,7 @@ struct Stream_Buffer_struct;
 typedef struct Stream_HWP_Struct {
   // stream HWP
   Stream_Buffer* stream;
+  Stream_Index stream_index;
   Stream_Buffer* l2hit_stream;
   /* prefetch req queues */
   Pref_Mem_Req* pref_req_queue;
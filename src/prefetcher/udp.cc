@@ -148,23 +148,9 @@ UDP::UDP(uns _proc_id)
   if (FDIP_BLOOM_FILTER) {
     ASSERT(proc_id, !FDIP_UC_SIZE && !FDIP_UTILITY_HASH_ENABLE);
     bf = new Bloom_Filter(proc_id);
-    bloom_parameters bloom1_parameters;
-    bloom1_parameters.projected_element_count = FDIP_BLOOM_ENTRIES;
-    bloom1_parameters.false_positive_probability = 0.005;
-    bloom1_parameters.compute_optimal_parameters();
-    bf->bloom = new bloom_filter(bloom1_parameters);
-
-    bloom_parameters bloom2_parameters;
-    bloom2_parameters.projected_element_count = FDIP_BLOOM2_ENTRIES;
-    bloom2_parameters.false_positive_probability = 0.005;
-    bloom2_parameters.compute_optimal_parameters();
-    bf->bloom2 = new bloom_filter(bloom2_parameters);
-
-    bloom_parameters bloom4_parameters;
-    bloom4_parameters.projected_element_count = FDIP_BLOOM4_ENTRIES;
-    bloom4_parameters.false_positive_probability = 0.005;
-    bloom4_parameters.compute_optimal_parameters();
-    bf->bloom4 = new bloom_filter(bloom4_parameters);
+    bf->bloom = new Blocked_Bloom_Filter(FDIP_BLOOM_ENTRIES, 0.005);
+    bf->bloom2 = new Blocked_Bloom_Filter(FDIP_BLOOM2_ENTRIES, 0.005);
+    bf->bloom4 = new Blocked_Bloom_Filter(FDIP_BLOOM4_ENTRIES, 0.005);
 
     bf->last_prefetch_candidate_counter = 0;
     bf->last_clear_cycle_count = 0;
@@ -188,16 +174,10 @@ void UDP::cyc_reset() {
 void UDP::clear_old_seniority_ftq() {
   if (!FDIP_UTILITY_HASH_ENABLE && !FDIP_UC_SIZE && !FDIP_BLOOM_FILTER)
     return;
-  Counter cnt_old = 0;
-  for (auto it = seniority_ftq.begin(); it != seniority_ftq.end(); ++it) {
-    if (cycle_count <= FDIP_SENIORITY_FTQ_HOLD_CYC)
-      break;
-    if ((cycle_count > FDIP_SENIORITY_FTQ_HOLD_CYC) && (get<1>(*it) >= cycle_count - FDIP_SENIORITY_FTQ_HOLD_CYC))
-      break;
-    cnt_old++;
-  }
-  DEBUG(proc_id, "Clear %llu entries among %ld at cyc %llu\n", cnt_old, seniority_ftq.size(), cycle_count);
-  seniority_ftq.erase(seniority_ftq.begin(), seniority_ftq.begin() + cnt_old);
+  if (cycle_count <= FDIP_SENIORITY_FTQ_HOLD_CYC)
+    return;
+  Counter cnt_old = seniority_ftq.pop_older_than(cycle_count - FDIP_SENIORITY_FTQ_HOLD_CYC);
+  DEBUG(proc_id, "Clear %llu entries, %ld left at cyc %llu\n", cnt_old, seniority_ftq.size(), cycle_count);
 }
 
 void UDP::set_last_bbl_start_addr(Addr addr) {
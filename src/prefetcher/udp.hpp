@@ -31,10 +31,11 @@
 
 #include <deque>
 #include <tuple>
+#include <unordered_map>
 
 #include "prefetcher/fdip.h"
 
-#include "libs/bloom_filter.hpp"
+#include "libs/blocked_bloom_filter.hpp"
 
 using namespace std;
 
@@ -66,9 +67,9 @@ class Bloom_Filter {
   void insert_remaining(uint32_t inserted);
 
   uns proc_id;
-  bloom_filter* bloom;
-  bloom_filter* bloom2;
-  bloom_filter* bloom4;
+  Blocked_Bloom_Filter* bloom;
+  Blocked_Bloom_Filter* bloom2;
+  Blocked_Bloom_Filter* bloom4;
   Addr last_prefetch_candidate;
   uint32_t last_prefetch_candidate_counter;
   Counter last_clear_cycle_count;
@@ -80,6 +81,50 @@ class Bloom_Filter {
   friend class UDP;
 };
 
+// Seniority-FTQ: prefetch candidates FDIP skipped, kept for FDIP_SENIORITY_FTQ_HOLD_CYC cycles so a later miss can be
+// matched against them. Entries are aged in FIFO order and a per-address count of the live entries is updated on every
+// push and pop, so a lookup does not walk the queue.
+class Seniority_FTQ {
+ public:
+  void push(uns64 cl_addr, Counter cycle, Flag on_path) {
+    entries.push_back(make_tuple(cl_addr, cycle, on_path));
+    Live_Count& live = counts[cl_addr];
+    live.all++;
+    live.off_path += !on_path;
+  }
+
+  // pop every entry inserted before min_cycle, returns the number popped
+  Counter pop_older_than(Counter min_cycle) {
+    Counter cnt_old = 0;
+    while (!entries.empty() && get<1>(entries.front()) < min_cycle) {
+      auto it = counts.find(get<0>(entries.front()));
+      if (--it->second.all == 0)
+        counts.erase(it);
+      else
+        it->second.off_path -= !get<2>(entries.front());
+      entries.pop_front();
+      cnt_old++;
+    }
+    return cnt_old;
+  }
+
+  Flag contains(uns64 cl_addr, Flag off_path_only) const {
+    auto it = counts.find(cl_addr);
+    return it != counts.end() && (!off_path_only || it->second.off_path);
+  }
+
+  size_t size() const { return entries.size(); }
+
+ private:
+  struct Live_Count {
+    uns32 all;
+    uns32 off_path;
+  };
+  // <Cl address, cycle count, on/off-path>
+  deque<tuple<uns64, Counter, Flag>> entries;
+  unordered_map<uns64, Live_Count> counts;
+};
+
 class UDP {
  public:
   UDP(uns _proc_id);
@@ -97,8 +142,7 @@ class UDP {
   void detect_stream(Addr uc_line_addr);
 
   /* Seniority-FTQ */
-  // <Cl address, cycle count, on/off-path>
-  deque<tuple<uns64, Counter, Flag>> seniority_ftq;
+  Seniority_FTQ seniority_ftq;
 
  private:
   uns proc_id;
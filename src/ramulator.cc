@@ -26,10 +26,12 @@
  * Description  : Defines an interface to Ramulator
  ***************************************************************************************/
 
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
 #include <deque>
-#include <list>
-#include <map>
 #include <utility>
+#include <vector>
 
 #include "ramulator/Config.h"
 #include "ramulator/Request.h"
@@ -43,8 +45,11 @@ extern "C" {
 #include "ramulator.param.h"
 
 #include "memory/memory.h"
+#include "memory/noc.h"
 
+#include "globals/utils.h"
 #include "ramulator.h"
+#include "sim.h"
 #include "statistics.h"
 }
 
@@ -62,7 +67,7 @@ Config* configs = NULL;
 
 void to_ramulator_req(const Mem_Req* scarab_req, Request* ramulator_req);
 void init_configs();
-bool try_completing_request(Mem_Req* req);
+void complete_request(Mem_Req* req);
 void enqueue_response(Request& req);
 
 void stats_callback(int coreid, int type);
@@ -70,8 +75,117 @@ void stats_callback(int coreid, int type);
 deque<pair<long, Mem_Req*>> resp_queue;  // completed read request that need to
                                          // send back to Scarab
 
-map<long, list<Mem_Req*>> inflight_read_reqs;
-// map<long, Mem_Req*> inflight_read_reqs;
+/* Reads in flight in Ramulator, keyed by line address. A line has at most one
+ * ifetch and one dfetch outstanding, so its requests are kept inline in an
+ * open-addressed table that only allocates when it grows. */
+#define INFLIGHT_REQS_PER_LINE 2
+#define INFLIGHT_TABLE_INIT_SIZE 256
+
+struct Inflight_Read {
+  long addr;
+  uns num_reqs;  // 0 marks an empty slot
+  Mem_Req* reqs[INFLIGHT_REQS_PER_LINE];
+};
+
+class Inflight_Read_Table {
+ public:
+  Inflight_Read_Table() : slots(INFLIGHT_TABLE_INIT_SIZE), mask(INFLIGHT_TABLE_INIT_SIZE - 1), count(0) {}
+
+  Inflight_Read* find(long addr) {
+    Inflight_Read* slot = &slots[probe(addr)];
+    return slot->num_reqs ? slot : NULL;
+  }
+
+  void add(long addr, Mem_Req* req) {
+    if (2 * (count + 1) > slots.size())
+      grow();
+    Inflight_Read* slot = &slots[probe(addr)];
+    if (!slot->num_reqs) {
+      slot->addr = addr;
+      count++;
+    }
+    ASSERT(req->proc_id, slot->num_reqs < INFLIGHT_REQS_PER_LINE);
+    slot->reqs[slot->num_reqs++] = req;
+  }
+
+  void remove(Inflight_Read* slot) {
+    size_t i = slot - &slots[0];
+    ASSERT(0, slots[i].num_reqs);
+    slots[i].num_reqs = 0;
+    count--;
+    // backward-shift deletion keeps probe chains unbroken
+    for (size_t j = (i + 1) & mask; slots[j].num_reqs; j = (j + 1) & mask) {
+      size_t k = home(slots[j].addr);
+      if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+        continue;
+      slots[i] = slots[j];
+      slots[j].num_reqs = 0;
+      i = j;
+    }
+  }
+
+ private:
+  vector<Inflight_Read> slots;
+  size_t mask;
+  size_t count;
+
+  size_t home(long addr) const { return ((unsigned long)addr * 0x9E3779B97F4A7C15UL) >> 32 & mask; }
+
+  size_t probe(long addr) const {
+    size_t i = home(addr);
+    while (slots[i].num_reqs && slots[i].addr != addr)
+      i = (i + 1) & mask;
+    return i;
+  }
+
+  void grow() {
+    vector<Inflight_Read> old(2 * slots.size());
+    old.swap(slots);
+    mask = slots.size() - 1;
+    for (auto& slot : old)
+      if (slot.num_reqs)
+        slots[probe(slot.addr)] = slot;
+  }
+};
+
+Inflight_Read_Table inflight_read_reqs;
+
+/* Recorded DRAM request streams (RAMULATOR_RECORD_FILE): a header followed by
+ * one record per request that reached Ramulator, in the order they were sent.
+ * Ticks are DRAM ticks (calls of ramulator_tick) since the start of the run. */
+#define DRAM_RECORD_MAGIC "SCARABDR"
+#define DRAM_RECORD_VERSION 1
+
+struct Dram_Record_Header {
+  char magic[8];
+  uns32 version;
+  uns32 line_size;
+  uns32 num_cores;
+  uns32 reserved;
+};
+
+struct Dram_Record {
+  uns64 addr;
+  uns32 tick_delta;  // DRAM ticks since the previous record (saturates)
+  uns16 proc_id;
+  uns8 is_write;
+  uns8 reserved;
+};
+
+static Counter dram_tick = 0;
+static FILE* record_file = NULL;
+static Counter record_last_tick = 0;
+
+static void record_request(const Request& req) {
+  Dram_Record rec;
+  memset(&rec, 0, sizeof(rec));
+  rec.addr = req.addr;
+  rec.tick_delta = (uns32)MIN2(dram_tick - record_last_tick, (Counter)UINT32_MAX);
+  rec.proc_id = req.coreid;
+  rec.is_write = req.type == Request::Type::WRITE;
+  record_last_tick = dram_tick;
+  fwrite(&rec, sizeof(rec), 1, record_file);
+}
 
 void ramulator_init() {
   ASSERTM(0, ICACHE_LINE_SIZE == DCACHE_LINE_SIZE,
@@ -86,11 +200,29 @@ void ramulator_init() {
 
   wrapper = new ScarabWrapper(*configs, DCACHE_LINE_SIZE, &stats_callback);
 
+  if (RAMULATOR_RECORD_FILE && SIM_MODE != DRAM_REPLAY_SIM_MODE) {
+    char buf[MAX_STR_LENGTH + 1];
+    snprintf(buf, MAX_STR_LENGTH, "%s/%s%s", OUTPUT_DIR, FILE_TAG, RAMULATOR_RECORD_FILE);
+    record_file = fopen(buf, "wb");
+    ASSERTM(0, record_file, "Could not open %s\n", buf);
+    Dram_Record_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DRAM_RECORD_MAGIC, sizeof(header.magic));
+    header.version = DRAM_RECORD_VERSION;
+    header.line_size = DCACHE_LINE_SIZE;
+    header.num_cores = NUM_CORES;
+    fwrite(&header, sizeof(header), 1, record_file);
+  }
+
   DPRINTF("Initialized Ramulator. \n");
 }
 
 void ramulator_finish() {
   wrapper->finish();
+  if (record_file) {
+    fclose(record_file);
+    record_file = NULL;
+  }
 
   delete wrapper;
   delete configs;
@@ -137,12 +269,20 @@ void init_configs() {
   configs->add("channel_width", to_string(BUS_WIDTH_IN_BYTES * 8));
 
   configs->add("record_cmd_trace", RAMULATOR_REC_CMD_TRACE);
+  configs->add("cmd_trace_format", RAMULATOR_CMD_TRACE_FORMAT);
+  configs->add("cmd_trace_compress", RAMULATOR_CMD_TRACE_COMPRESS);
   configs->add("print_cmd_trace", RAMULATOR_PRINT_CMD_TRACE);
+  configs->add("queue_stats", RAMULATOR_QUEUE_STATS);
   configs->add("use_rest_of_addr_as_row_addr", RAMULATOR_USE_REST_OF_ADDR_AS_ROW_ADDR);
 
+  configs->add("memory_model", RAMULATOR_MODEL);
+  configs->add("fast_latency", to_string(RAMULATOR_FAST_LATENCY));
+  configs->add("fast_row_buffer", RAMULATOR_FAST_ROW_BUFFER);
   configs->add("scheduling_policy", RAMULATOR_SCHEDULING_POLICY);
   configs->add("readq_entries", to_string(RAMULATOR_READQ_ENTRIES));
   configs->add("writeq_entries", to_string(RAMULATOR_WRITEQ_ENTRIES));
+  configs->add("tick_threads", to_string(RAMULATOR_TICK_THREADS));
+  configs->add("skip_idle", RAMULATOR_SKIP_IDLE);
   configs->add("output_dir", OUTPUT_DIR);
 
   // TODO: make these optional and use the preset values specified by
@@ -176,17 +316,16 @@ int ramulator_send(Mem_Req* scarab_req) {
   // Mem_Req_Type_str(scarab_req->type), scarab_req->addr);
 
   // does inflight_read_reqs have the proc_id in the req?
-  auto it_scarab_req = inflight_read_reqs.find(req.addr);
-  if (it_scarab_req != inflight_read_reqs.end() && req.type == Request::Type::READ) {
+  Inflight_Read* inflight = inflight_read_reqs.find(req.addr);
+  if (inflight && req.type == Request::Type::READ) {
     DEBUG(scarab_req->proc_id, "Ramulator: Duplicate (%s) request to address %llx\n",
           Mem_Req_Type_str(scarab_req->type), scarab_req->addr);
     // Can have duplicate Ifetch and Dfetch requests, but only one of each
-    ASSERT(0, it_scarab_req->second.size() <= 1);
+    ASSERT(0, inflight->num_reqs <= 1);
 
     /* save it as an inflight request so later it will be moved to the resp_queue
      * at the same time with the older request */
-    if (req.type == Request::Type::READ)
-      inflight_read_reqs[req.addr].push_back(scarab_req);
+    inflight_read_reqs.add(req.addr, scarab_req);
 
     scarab_req->mem_queue_cycle = cycle_count;
     return true;  // a request to the same address is already issued
@@ -196,13 +335,14 @@ int ramulator_send(Mem_Req* scarab_req) {
 
   if (is_sent) {
     STAT_EVENT(scarab_req->proc_id, POWER_MEMORY_CTRL_ACCESS);
+    if (record_file)
+      record_request(req);
 
     if (req.type == Request::Type::READ) {
-      ASSERTM(0, inflight_read_reqs.find(req.addr) == inflight_read_reqs.end(),
+      ASSERTM(0, !inflight_read_reqs.find(req.addr),
               "ERROR: A read request to the same address shouldn't be sent "
               "multiple times to Ramulator\n");
-      // inflight_read_reqs[req.addr] = scarab_req;
-      inflight_read_reqs[req.addr].push_back(scarab_req);
+      inflight_read_reqs.add(req.addr, scarab_req);
       STAT_EVENT(scarab_req->proc_id, POWER_MEMORY_CTRL_READ);
     } else if (req.type == Request::Type::WRITE) {
       STAT_EVENT(scarab_req->proc_id, POWER_MEMORY_CTRL_WRITE);
@@ -223,42 +363,35 @@ int ramulator_send(Mem_Req* scarab_req) {
 void enqueue_response(Request& req) {
   // This should only be called by READ requests
   ASSERTM(0, req.type == Request::Type::READ, "ERROR: Responses should be sent only for read requests! \n");
-  ASSERTM(0, inflight_read_reqs.find(req.addr) != inflight_read_reqs.end(),
+  Inflight_Read* inflight = inflight_read_reqs.find(req.addr);
+  ASSERTM(0, inflight,
           "ERROR: A corresponding Scarab request was not found for the "
           "Ramulator request that read address: %lu\n",
           req.addr);
 
-  auto it_scarab_req = inflight_read_reqs.find(req.addr);
-  for (auto req : it_scarab_req->second)
-    resp_queue.push_back(make_pair(it_scarab_req->first, req));
-  // resp_queue.push_back(make_pair(it_scarab_req->first, it_scarab_req->second));
-  inflight_read_reqs.erase(it_scarab_req);
+  for (uns ii = 0; ii < inflight->num_reqs; ii++)
+    resp_queue.push_back(make_pair(inflight->addr, inflight->reqs[ii]));
+  inflight_read_reqs.remove(inflight);
 }
 
-bool try_completing_request(Mem_Req* req) {
-  if ((unsigned int)mem->l1fill_queue.entry_count < MEM_L1_FILL_QUEUE_ENTRIES) {
-    DEBUG(req->proc_id, "Ramulator: Completing a (%s) request to address %llx\n", Mem_Req_Type_str(req->type),
-          req->addr);
-
-    // TODO_hasan: how do we need to set the priority?
-    mem_complete_bus_in_access(req, 0 /*mem->mem_queue.base[ii].priority*/);
+void complete_request(Mem_Req* req) {
+  DEBUG(req->proc_id, "Ramulator: Completing a (%s) request to address %llx\n", Mem_Req_Type_str(req->type),
+        req->addr);
 
-    // remove from mem queue - how do we handle this now?
-    // mem_queue_removal_count++;
-    // l1fill_queue_insertion_count++;
-    // mem->mem_queue.base[ii].priority =
-    // Mem_Req_Priority_Offset[MRT_MIN_PRIORITY];
-    // memview_memqueue(MEMVIEW_MEMQUEUE_DEPART, req);
+  // TODO_hasan: how do we need to set the priority?
+  noc_complete_request(req);
 
-    // if (MEM_MEM_QUEUE_PARTITION_ENABLE) {
-    //    ASSERT(0, mem->mem_queue_entry_count_bank[req->mem_flat_bank] > 0);
-    //    mem->mem_queue_entry_count_bank[req->mem_flat_bank]--;
-    //}
-
-    return true;
-  }
+  // remove from mem queue - how do we handle this now?
+  // mem_queue_removal_count++;
+  // l1fill_queue_insertion_count++;
+  // mem->mem_queue.base[ii].priority =
+  // Mem_Req_Priority_Offset[MRT_MIN_PRIORITY];
+  // memview_memqueue(MEMVIEW_MEMQUEUE_DEPART, req);
 
-  return false;
+  // if (MEM_MEM_QUEUE_PARTITION_ENABLE) {
+  //    ASSERT(0, mem->mem_queue_entry_count_bank[req->mem_flat_bank] > 0);
+  //    mem->mem_queue_entry_count_bank[req->mem_flat_bank]--;
+  //}
 }
 
 void to_ramulator_req(const Mem_Req* scarab_req, Request* ramulator_req) {
@@ -286,10 +419,18 @@ void to_ramulator_req(const Mem_Req* scarab_req, Request* ramulator_req) {
 
 void ramulator_tick() {
   wrapper->tick();
-
-  if (resp_queue.size() > 0) {
-    if (try_completing_request(resp_queue.front().second))
-      resp_queue.pop_front();
+  dram_tick++;
+
+  // hand back as many completed reads as the response bandwidth and the L1
+  // fill queue allow
+  uns fill_space = MEM_L1_FILL_QUEUE_ENTRIES - MIN2((uns)mem->l1fill_queue.entry_count, MEM_L1_FILL_QUEUE_ENTRIES);
+  uns num_resps = MIN2(fill_space, (uns)resp_queue.size());
+  if (RAMULATOR_RESPONSES_PER_TICK)
+    num_resps = MIN2(num_resps, RAMULATOR_RESPONSES_PER_TICK);
+
+  for (uns ii = 0; ii < num_resps; ii++) {
+    complete_request(resp_queue.front().second);
+    resp_queue.pop_front();
   }
 }
 
@@ -315,11 +456,12 @@ Mem_Req* ramulator_search_queue(long phys_addr, Mem_Req_Type type) {
               (type == MRT_DSTORE) || (type == MRT_MIN_PRIORITY) || (type == MRT_FDIPPRFON) ||
               (type == MRT_FDIPPRFOFF) || (type == MRT_UOCPRF),
           "Ramulator: Cannot search write requests in Ramulator request queue\n");
-  auto it_req = inflight_read_reqs.find(phys_addr);
+  Inflight_Read* inflight = inflight_read_reqs.find(phys_addr);
 
   // Search request queue
-  if (it_req != inflight_read_reqs.end()) {
-    for (auto req : it_req->second) {
+  if (inflight) {
+    for (uns ii = 0; ii < inflight->num_reqs; ii++) {
+      Mem_Req* req = inflight->reqs[ii];
       if ((req->type == MRT_IFETCH || req->type == MRT_IPRF || req->type == MRT_FDIPPRFON ||
            req->type == MRT_FDIPPRFOFF || req->type == MRT_UOCPRF) &&
           (type == MRT_IFETCH || type == MRT_IPRF || type == MRT_FDIPPRFON || type == MRT_FDIPPRFOFF ||
@@ -332,7 +474,7 @@ Mem_Req* ramulator_search_queue(long phys_addr, Mem_Req_Type type) {
   }
 
   // Search response queue
-  for (auto resp : resp_queue) {
+  for (const auto& resp : resp_queue) {
     if (resp.first == phys_addr) {
       if ((resp.second->type == MRT_IFETCH || resp.second->type == MRT_IPRF || resp.second->type == MRT_FDIPPRFON ||
            resp.second->type == MRT_FDIPPRFOFF || resp.second->type == MRT_UOCPRF) &&
@@ -347,3 +489,103 @@ Mem_Req* ramulator_search_queue(long phys_addr, Mem_Req_Type type) {
 
   return NULL;
 }
+
+/**************************************************************************************/
+/* DRAM replay: feeds a recorded request stream to the wrapper, one DRAM tick
+ * per loop iteration. Each core issues its requests in recorded order, no
+ * earlier than its recorded tick plus the time the core was held back so far
+ * (by full Ramulator queues or, with RAMULATOR_REPLAY_MLP, by its outstanding
+ * reads). */
+
+struct Replay_Core {
+  deque<pair<Counter, Dram_Record>> pending;  // recorded tick and request, not yet sent
+  Counter delay;                              // ticks the core has been held back
+  uns reads_out;
+};
+
+void ramulator_replay() {
+  ASSERTUM(0, RAMULATOR_REPLAY_FILE, "dram_replay mode needs RAMULATOR_REPLAY_FILE\n");
+  FILE* file = fopen(RAMULATOR_REPLAY_FILE, "rb");
+  ASSERTUM(0, file, "Could not open %s\n", RAMULATOR_REPLAY_FILE);
+  Dram_Record_Header header;
+  size_t num_read = fread(&header, sizeof(header), 1, file);
+  ASSERTUM(0, num_read == 1 && !memcmp(header.magic, DRAM_RECORD_MAGIC, 8), "%s is not a DRAM request recording\n",
+           RAMULATOR_REPLAY_FILE);
+  ASSERTUM(0, header.version == DRAM_RECORD_VERSION, "%s has version %u, expected %u\n", RAMULATOR_REPLAY_FILE,
+           header.version, DRAM_RECORD_VERSION);
+  ASSERTUM(0, header.line_size == DCACHE_LINE_SIZE, "%s was recorded with %u byte lines, DCACHE_LINE_SIZE is %u\n",
+           RAMULATOR_REPLAY_FILE, header.line_size, DCACHE_LINE_SIZE);
+  ASSERTUM(0, header.num_cores <= NUM_CORES, "%s was recorded with %u cores, NUM_CORES is %u\n",
+           RAMULATOR_REPLAY_FILE, header.num_cores, NUM_CORES);
+
+  ramulator_init();
+
+  vector<Replay_Core> cores(NUM_CORES);
+  Dram_Record next;
+  Counter next_tick = 0;
+  bool eof = fread(&next, sizeof(next), 1, file) != 1;
+  if (!eof)
+    next_tick = next.tick_delta;
+
+  for (uns first = 0;; first = (first + 1) % NUM_CORES) {
+    cycle_count = dram_tick;
+
+    // no core can send a request before its recorded tick
+    while (!eof && next_tick <= dram_tick) {
+      ASSERTM(0, next.proc_id < NUM_CORES, "Recorded request of core %u\n", next.proc_id);
+      cores[next.proc_id].pending.push_back(make_pair(next_tick, next));
+      eof = fread(&next, sizeof(next), 1, file) != 1;
+      if (!eof)
+        next_tick += next.tick_delta;
+    }
+
+    bool busy = !eof;
+    for (uns ii = 0; ii < NUM_CORES; ii++) {
+      uns proc_id = (first + ii) % NUM_CORES;
+      Replay_Core& core = cores[proc_id];
+      busy |= !core.pending.empty() || core.reads_out;
+
+      while (!core.pending.empty() && core.pending.front().first + core.delay <= dram_tick) {
+        const Dram_Record& rec = core.pending.front().second;
+        if (!rec.is_write && RAMULATOR_REPLAY_MLP && core.reads_out >= RAMULATOR_REPLAY_MLP) {
+          STAT_EVENT(proc_id, DRAM_REPLAY_MLP_STALL);
+          break;
+        }
+
+        Counter sent_tick = dram_tick;
+        Request req(rec.addr, rec.is_write ? Request::Type::WRITE : Request::Type::READ,
+                    [&core, proc_id, sent_tick](Request&) {
+                      core.reads_out--;
+                      INC_STAT_EVENT(proc_id, DRAM_REPLAY_READ_LATENCY, dram_tick - sent_tick);
+                    },
+                    proc_id);
+        if (!wrapper->send(req)) {
+          STAT_EVENT(proc_id, DRAM_REPLAY_QUEUE_FULL);
+          break;
+        }
+        if (rec.is_write) {
+          STAT_EVENT(proc_id, DRAM_REPLAY_WRITES);
+        } else {
+          STAT_EVENT(proc_id, DRAM_REPLAY_READS);
+          core.reads_out++;
+        }
+        core.pending.pop_front();
+      }
+
+      // a request that is due but was not sent holds back everything after it
+      if (!core.pending.empty() && core.pending.front().first + core.delay <= dram_tick) {
+        core.delay++;
+        STAT_EVENT(proc_id, DRAM_REPLAY_DELAY);
+      }
+      STAT_EVENT(proc_id, DRAM_REPLAY_TICKS);
+    }
+    if (!busy)
+      break;
+
+    wrapper->tick();
+    dram_tick++;
+  }
+
+  fclose(file);
+  ramulator_finish();
+}
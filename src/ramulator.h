@@ -51,6 +51,9 @@ EXTERNC int ramulator_get_num_chips();
 EXTERNC int ramulator_get_chip_row_buffer_size();
 
 EXTERNC Mem_Req* ramulator_search_queue(long phys_addr, Mem_Req_Type type);
+
+/* Sets up Ramulator, replays RAMULATOR_REPLAY_FILE into it and finishes it */
+EXTERNC void ramulator_replay();
 #undef EXTERNC
 
 #endif  // __RAMULATOR_H__
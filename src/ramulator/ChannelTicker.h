@@ -0,0 +1,117 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * ChannelTicker.h
+ *
+ * A small persistent thread pool that ticks independent channel controllers
+ * in parallel. Job i is always run by thread (i % num_threads) and the
+ * calling thread takes part as thread 0, so a run() is one fork/join of
+ * spin barriers with no allocation on the per-cycle path.
+ */
+
+#ifndef __CHANNEL_TICKER_H
+#define __CHANNEL_TICKER_H
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace ramulator
+{
+
+class ChannelTicker
+{
+public:
+    ChannelTicker(int num_threads, int num_jobs, std::function<void(int)> job)
+        : num_threads(num_threads), num_jobs(num_jobs), job(job)
+    {
+        for (int tid = 1; tid < num_threads; tid++)
+            workers.emplace_back(&ChannelTicker::worker, this, tid);
+    }
+
+    ~ChannelTicker()
+    {
+        exiting.store(true, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        for (auto& t : workers)
+            t.join();
+    }
+
+    /* Runs every job once and returns when all of them have finished */
+    void run()
+    {
+        done.store(0, std::memory_order_relaxed);
+        generation.fetch_add(1, std::memory_order_release);
+        run_jobs(0);
+        for (int spins = 0; done.load(std::memory_order_acquire) != num_threads - 1; spins++)
+            spin_pause(spins);
+    }
+
+private:
+    int num_threads;
+    int num_jobs;
+    std::function<void(int)> job;
+    std::vector<std::thread> workers;
+
+    std::atomic<unsigned> generation{0};
+    std::atomic<int> done{0};
+    std::atomic<bool> exiting{false};
+
+    void run_jobs(int tid)
+    {
+        for (int i = tid; i < num_jobs; i += num_threads)
+            job(i);
+    }
+
+    void worker(int tid)
+    {
+        unsigned seen = 0;
+        while (true) {
+            unsigned cur;
+            for (int spins = 0; (cur = generation.load(std::memory_order_acquire)) == seen; spins++)
+                spin_pause(spins);
+            seen = cur;
+            if (exiting.load(std::memory_order_relaxed))
+                return;
+            run_jobs(tid);
+            done.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    /* busy-wait briefly, then give the core away in case the host is
+       oversubscribed */
+    static void spin_pause(int spins)
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        if (spins < 1024) {
+            __builtin_ia32_pause();
+            return;
+        }
+#endif
+        std::this_thread::yield();
+    }
+};
+
+} /*namespace ramulator*/
+
+#endif /*__CHANNEL_TICKER_H*/
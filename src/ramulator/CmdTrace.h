@@ -0,0 +1,223 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * CmdTrace.h
+ *
+ * Per-rank DRAM command trace of a channel, for DRAMPower 3.1. The text format
+ * is one "clk,CMD[,bank]" line per command. The binary format appends a fixed
+ * size Record per command to a large buffer; full buffers are written (and
+ * gzip-compressed with cmd_trace_compress) by a background thread, so the
+ * controller only pays for a store. A binary file is, in host byte order:
+ *
+ *   "RAMCMDTR", uint32 version, uint32 number of commands, then for each
+ *   command a uint8 length and its name, then the Records.
+ *
+ * bin/ramulator_cmdtrace_convert.py turns a binary trace into the text format.
+ */
+
+#ifndef __CMD_TRACE_H
+#define __CMD_TRACE_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <zlib.h>
+
+namespace ramulator
+{
+
+class CmdTrace
+{
+public:
+    struct Record {
+        int64_t clk;
+        int32_t cmd;
+        int32_t bank;  // -1 for commands that address the whole rank
+    };
+
+    static constexpr const char* MAGIC = "RAMCMDTR";
+    static const uint32_t VERSION = 1;
+    static const size_t BUF_RECORDS = 1 << 16;  // 1MB per buffer
+    static const size_t MAX_PENDING = 4;        // full buffers the writer may lag behind
+
+    CmdTrace(const std::string& prefix, int num_ranks, const std::vector<std::string>& command_names, bool binary,
+             bool compress)
+        : binary(binary), ranks(num_ranks)
+    {
+        for (auto& name : command_names)
+            has_bank.push_back(name != "PREA" && name != "REF");
+        this->command_names = command_names;
+
+        for (int i = 0; i < num_ranks; i++) {
+            std::string path = prefix + std::to_string(i) + ".cmdtrace";
+            if (!binary) {
+                ranks[i].text.open(path);
+                continue;
+            }
+            path += compress ? ".bin.gz" : ".bin";
+            if (compress)
+                ranks[i].gz = gzopen(path.c_str(), "wb1");
+            else
+                ranks[i].file = fopen(path.c_str(), "wb");
+            if (!ranks[i].gz && !ranks[i].file) {
+                std::cerr << "ERROR: cannot open command trace " << path << std::endl;
+                exit(-1);
+            }
+            write_header(i);
+            ranks[i].buf.reserve(BUF_RECORDS);
+        }
+        if (binary)
+            writer = std::thread(&CmdTrace::writer_main, this);
+    }
+
+    ~CmdTrace()
+    {
+        if (binary) {
+            for (int i = 0; i < int(ranks.size()); i++)
+                submit(i);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                exiting = true;
+            }
+            work_cv.notify_one();
+            writer.join();
+        }
+        for (auto& rank : ranks) {
+            if (rank.gz)
+                gzclose(rank.gz);
+            if (rank.file)
+                fclose(rank.file);
+            if (rank.text.is_open())
+                rank.text.close();
+        }
+    }
+
+    void record(int rank, long clk, int cmd, int bank)
+    {
+        Rank& r = ranks[rank];
+        if (!binary) {
+            r.text << clk << ',' << command_names[cmd];
+            if (has_bank[cmd])
+                r.text << ',' << bank;
+            r.text << '\n';
+            return;
+        }
+        r.buf.push_back({clk, cmd, has_bank[cmd] ? bank : -1});
+        if (r.buf.size() == BUF_RECORDS)
+            submit(rank);
+    }
+
+private:
+    struct Rank {
+        std::ofstream text;
+        FILE* file = nullptr;
+        gzFile gz = nullptr;
+        std::vector<Record> buf;
+    };
+
+    bool binary;
+    std::vector<std::string> command_names;
+    std::vector<bool> has_bank;
+    std::vector<Rank> ranks;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable work_cv;   // the writer waits for full buffers
+    std::condition_variable space_cv;  // the controller waits for the writer to catch up
+    std::deque<std::pair<int, std::vector<Record>>> pending;
+    std::vector<std::vector<Record>> free_bufs;
+    bool exiting = false;
+
+    void write_bytes(Rank& r, const void* data, size_t size)
+    {
+        if (r.gz)
+            gzwrite(r.gz, data, unsigned(size));
+        else
+            fwrite(data, 1, size, r.file);
+    }
+
+    void write_header(int rank)
+    {
+        Rank& r = ranks[rank];
+        uint32_t head[2] = {VERSION, uint32_t(command_names.size())};
+        write_bytes(r, MAGIC, 8);
+        write_bytes(r, head, sizeof(head));
+        for (auto& name : command_names) {
+            uint8_t len = uint8_t(name.size());
+            write_bytes(r, &len, 1);
+            write_bytes(r, name.data(), len);
+        }
+    }
+
+    /* Hands the rank's buffer to the writer and continues in a recycled one */
+    void submit(int rank)
+    {
+        Rank& r = ranks[rank];
+        if (r.buf.empty())
+            return;
+        std::unique_lock<std::mutex> lock(mutex);
+        space_cv.wait(lock, [this] { return pending.size() < MAX_PENDING; });
+        pending.emplace_back(rank, std::move(r.buf));
+        if (!free_bufs.empty()) {
+            r.buf = std::move(free_bufs.back());
+            free_bufs.pop_back();
+        } else {
+            r.buf = std::vector<Record>();
+            r.buf.reserve(BUF_RECORDS);
+        }
+        lock.unlock();
+        work_cv.notify_one();
+    }
+
+    void writer_main()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            work_cv.wait(lock, [this] { return exiting || !pending.empty(); });
+            if (pending.empty())
+                return;
+            auto job = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+            space_cv.notify_one();
+
+            write_bytes(ranks[job.first], job.second.data(), job.second.size() * sizeof(Record));
+            job.second.clear();
+
+            lock.lock();
+            free_bufs.push_back(std::move(job.second));
+        }
+    }
+};
+
+} /*namespace ramulator*/
+
+#endif /*__CMD_TRACE_H*/
@@ -66,10 +66,23 @@ private:
 		{"readq_entries", "64"},
 		{"writeq_entries", "64"},
 
+        // Host threads used to tick channel controllers
+        {"tick_threads", "1"},
+        // Pass the cycles in which no channel has work in one step
+        {"skip_idle", "on"},
+
+        // DRAM model: "cycle" (Memory/Controller) or "fast" (FastMemory)
+        {"memory_model", "cycle"},
+        {"fast_latency", "0"},
+        {"fast_row_buffer", "on"},
+
         
         // Other
         {"record_cmd_trace", "off"},
+        {"cmd_trace_format", "text"},
+        {"cmd_trace_compress", "off"},
         {"print_cmd_trace", "off"},
+        {"queue_stats", "on"},
         {"use_rest_of_addr_as_row_addr", "on"}
     };
 
@@ -187,6 +200,30 @@ public:
       }
       return false;
     }
+    std::string cmd_trace_format() const {
+      // "text" (default) or "binary"
+      if (options.find("cmd_trace_format") != options.end())
+        return (options.find("cmd_trace_format"))->second;
+      return "text";
+    }
+    bool cmd_trace_compress() const {
+      // the default value is false
+      if (options.find("cmd_trace_compress") != options.end())
+        return (options.find("cmd_trace_compress"))->second == "on";
+      return false;
+    }
+    bool queue_stats() const {
+      // the default value is true
+      if (options.find("queue_stats") != options.end())
+        return (options.find("queue_stats"))->second != "off";
+      return true;
+    }
+    bool skip_idle() const {
+      // the default value is true
+      if (options.find("skip_idle") != options.end())
+        return (options.find("skip_idle"))->second != "off";
+      return true;
+    }
     bool print_cmd_trace() const {
       // the default value is false
       if (options.find("print_cmd_trace") != options.end()) {
@@ -88,7 +88,7 @@ void Controller<TLDRAM>::tick(){
                   channel->update_serving_requests(
                       req.addr_vec.data(), -1, clk);
           }
-            req.callback(req);
+            respond(req);
             pending.pop_front();
         }
     }
@@ -181,7 +181,7 @@ void Controller<TLDRAM>::tick(){
     }
 
     // remove request from queue
-    queue->q.erase(req);
+    erase_request(*queue, req);
 }
 
 template<>
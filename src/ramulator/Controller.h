@@ -30,6 +30,7 @@
 #include <string>
 #include <vector>
 
+#include "CmdTrace.h"
 #include "Config.h"
 #include "DRAM.h"
 #include "Refresh.h"
@@ -96,10 +97,68 @@ public:
     RowTable<T>* rowtable;  // tracks metadata about rows (e.g., which are open and for how long)
     Refresh<T>* refresh;
 
+    /* Open-addressed count of queued requests per row, keyed by
+       rowgroup_key(). Sized once for the most requests a queue can hold, so
+       it never allocates on the enqueue/issue path. */
+    struct RowCounter {
+        struct Slot {
+            long key;
+            int count;  // 0 marks an empty slot
+        };
+        vector<Slot> slots;
+        unsigned long mask = 0;
+
+        void init(unsigned int max_reqs) {
+            unsigned long n = 1;
+            while (n < 2 * (unsigned long)max_reqs)
+                n <<= 1;
+            slots.assign(n, Slot{0, 0});
+            mask = n - 1;
+        }
+
+        unsigned long home(long key) const {
+            return ((unsigned long)key * 0x9E3779B97F4A7C15UL) >> 32 & mask;
+        }
+
+        unsigned long find(long key) const {
+            unsigned long i = home(key);
+            while (slots[i].count && slots[i].key != key)
+                i = (i + 1) & mask;
+            return i;
+        }
+
+        int get(long key) const {
+            return slots[find(key)].count;
+        }
+
+        void add(long key) {
+            Slot& slot = slots[find(key)];
+            slot.key = key;
+            slot.count++;
+        }
+
+        void remove(long key) {
+            unsigned long i = find(key);
+            assert(slots[i].count > 0);
+            if (--slots[i].count)
+                return;
+            // backward-shift deletion keeps probe chains unbroken
+            for (unsigned long j = (i + 1) & mask; slots[j].count; j = (j + 1) & mask) {
+                unsigned long k = home(slots[j].key);
+                if (i <= j ? (i < k && k <= j) : (i < k || k <= j))
+                    continue;
+                slots[i] = slots[j];
+                slots[j].count = 0;
+                i = j;
+            }
+        }
+    };
+
     struct Queue {
         list<Request> q;
         unsigned int max = 32;
         unsigned int size() {return q.size();}
+        RowCounter row_reqs;  // queued requests per row
     };
 
     Queue readq;  // queue for read requests
@@ -119,14 +178,32 @@ public:
 
     /* Command trace for DRAMPower 3.1 */
     string cmd_trace_prefix = "cmd-trace-";
-    vector<ofstream> cmd_trace_files;
+    CmdTrace* cmd_trace = nullptr;
     bool record_cmd_trace = false;
     /* Commands to stdout */
     bool print_cmd_trace = false;
 
+    /* Per-cycle sums are kept in plain counters on the tick path and only
+       copied into the queue length and latency stats by finish() */
+    long read_latency_total = 0;
+    long req_queue_length_total = 0;
+    long read_req_queue_length_total = 0;
+    long write_req_queue_length_total = 0;
+    bool record_queue_stats = true;  // queue_stats=off drops the queue length group
+
+    // address range of each level up to Row, used to build rowgroup keys
+    long level_span[int(T::Level::MAX)];
+
     // callback function for passing stats to Scarab when an event occurs
     void (*stats_callback)(int, int) = nullptr;
 
+    /* When Memory ticks channels on worker threads, completed reads and stat
+       events are buffered here instead of calling back into Scarab, and are
+       replayed on the main thread by flush_callbacks() */
+    bool defer_callbacks = false;
+    vector<Request> deferred_responses;
+    vector<pair<int, int>> deferred_stats;
+
 
     /* Constructor */
     Controller(const Config& configs, DRAM<T>* channel, void (*_stats_callback)(int,int)) :
@@ -134,26 +211,35 @@ public:
         scheduler(new Scheduler<T>(this, configs)),
         rowpolicy(new RowPolicy<T>(this)),
         rowtable(new RowTable<T>(this)),
-        refresh(new Refresh<T>(this)),
-        cmd_trace_files(channel->children.size())
+        refresh(new Refresh<T>(this))
     {
 
         stats_callback = _stats_callback;
 
         record_cmd_trace = configs.record_cmd_trace();
         print_cmd_trace = configs.print_cmd_trace();
+        record_queue_stats = configs.queue_stats();
         if (record_cmd_trace){
             if (configs["cmd_trace_prefix"] != "") {
               cmd_trace_prefix = configs["cmd_trace_prefix"];
             }
             string prefix = cmd_trace_prefix + "chan-" + to_string(channel->id) + "-rank-";
-            string suffix = ".cmdtrace";
-            for (unsigned int i = 0; i < channel->children.size(); i++)
-                cmd_trace_files[i].open(prefix + to_string(i) + suffix);
+            vector<string> names(channel->spec->command_name, channel->spec->command_name + int(T::Command::MAX));
+            cmd_trace = new CmdTrace(prefix, channel->children.size(), names, configs.cmd_trace_format() == "binary",
+                                     configs.cmd_trace_compress());
         }
 
         readq.max = (unsigned int) configs.get_int("readq_entries");
         writeq.max = (unsigned int) configs.get_int("writeq_entries");
+        // actq is fed from readq and writeq, so it never holds more than both
+        readq.row_reqs.init(readq.max);
+        writeq.row_reqs.init(writeq.max);
+        actq.row_reqs.init(readq.max + writeq.max);
+        otherq.row_reqs.init(otherq.max);
+        for (int lev = 0; lev <= int(T::Level::Row); lev++) {
+            int count = channel->spec->org_entry.count[lev];
+            level_span[lev] = count > 0 ? count : 256;
+        }
 
         // regStats
 
@@ -271,6 +357,14 @@ public:
             .desc("Write queue length average per memory cycle per channel.")
             .precision(6)
             ;
+        if (!record_queue_stats) {
+            req_queue_length_sum.flags(0);
+            req_queue_length_avg.flags(0);
+            read_req_queue_length_sum.flags(0);
+            read_req_queue_length_avg.flags(0);
+            write_req_queue_length_sum.flags(0);
+            write_req_queue_length_avg.flags(0);
+        }
 
 #ifndef INTEGRATED_WITH_GEM5
         record_read_hits
@@ -317,12 +411,14 @@ public:
         delete rowtable;
         delete channel;
         delete refresh;
-        for (auto& file : cmd_trace_files)
-            file.close();
-        cmd_trace_files.clear();
+        delete cmd_trace;
     }
 
     void finish(long read_req, long dram_cycles) {
+      read_latency_sum = read_latency_total;
+      req_queue_length_sum = req_queue_length_total;
+      read_req_queue_length_sum = read_req_queue_length_total;
+      write_req_queue_length_sum = write_req_queue_length_total;
       read_latency_avg = read_latency_sum.value() / read_req;
       req_queue_length_avg = req_queue_length_sum.value() / dram_cycles;
       read_req_queue_length_avg = read_req_queue_length_sum.value() / dram_cycles;
@@ -332,6 +428,43 @@ public:
     }
 
     /* Member Functions */
+
+    // Packs addr_vec[0..last_level] into one integer, e.g. a rowgroup
+    // (bank or subarray) or a row
+    long rowgroup_key(const vector<int>& addr_vec, int last_level) const
+    {
+        long key = 0;
+        for (int lev = 0; lev <= last_level; lev++)
+            key = key * level_span[lev] + addr_vec[lev];
+        return key;
+    }
+
+    long row_key(const vector<int>& addr_vec) const
+    {
+        return rowgroup_key(addr_vec, int(T::Level::Row));
+    }
+
+    void push_request(Queue& queue, const Request& req)
+    {
+        queue.q.push_back(req);
+        queue.row_reqs.add(row_key(req.addr_vec));
+    }
+
+    void erase_request(Queue& queue, list<Request>::iterator req)
+    {
+        queue.row_reqs.remove(row_key(req->addr_vec));
+        queue.q.erase(req);
+    }
+
+    // moves the request's list node, so nothing is copied or allocated
+    void move_request(Queue& from, Queue& to, list<Request>::iterator req)
+    {
+        long key = row_key(req->addr_vec);
+        from.row_reqs.remove(key);
+        to.row_reqs.add(key);
+        to.q.splice(to.q.end(), from.q, req);
+    }
+
     Queue& get_queue(Request::Type type)
     {
         switch (int(type)) {
@@ -349,35 +482,37 @@ public:
             return false;
 
         req.arrive = clk;
-        queue.q.push_back(req);
         // shortcut for read requests, if a write to same addr exists
         // necessary for coherence
         if (req.type == Request::Type::READ && find_if(writeq.q.begin(), writeq.q.end(),
-                [req](Request& wreq){ return req.addr == wreq.addr;}) != writeq.q.end()){
+                [&req](Request& wreq){ return req.addr == wreq.addr;}) != writeq.q.end()){
             req.depart = clk + 1;
             pending.push_back(req);
-            readq.q.pop_back();
+            return true;
         }
+        push_request(queue, req);
         return true;
     }
 
     void tick()
     {
         clk++;
-        req_queue_length_sum += readq.size() + writeq.size() + pending.size();
-        read_req_queue_length_sum += readq.size() + pending.size();
-        write_req_queue_length_sum += writeq.size();
+        if (record_queue_stats) {
+            req_queue_length_total += readq.size() + writeq.size() + pending.size();
+            read_req_queue_length_total += readq.size() + pending.size();
+            write_req_queue_length_total += writeq.size();
+        }
 
         /*** 1. Serve completed reads ***/
         if (pending.size()) {
             Request& req = pending[0];
             if (req.depart <= clk) {
                 if (req.depart - req.arrive > 1) { // this request really accessed a row
-                  read_latency_sum += req.depart - req.arrive;
+                  read_latency_total += req.depart - req.arrive;
                   channel->update_serving_requests(
                       req.addr_vec.data(), -1, clk);
                 }
-                req.callback(req);
+                respond(req);
                 pending.pop_front();
             }
         }
@@ -469,8 +604,7 @@ public:
         if (!(channel->spec->is_accessing(cmd) || channel->spec->is_refreshing(cmd))) {
             if(channel->spec->is_opening(cmd)) {
                 // promote the request that caused issuing activation to actq
-                actq.q.push_back(*req);
-                queue->q.erase(req);
+                move_request(*queue, actq, req);
             }
 
             return;
@@ -487,7 +621,7 @@ public:
         }
 
         // remove request from queue
-        queue->q.erase(req);
+        erase_request(*queue, req);
     }
 
     bool is_ready(list<Request>::iterator req)
@@ -529,6 +663,48 @@ public:
     {
     }
 
+    void respond(Request& req) {
+      if (defer_callbacks)
+        deferred_responses.push_back(req);
+      else
+        req.callback(req);
+    }
+
+    void report_stat(int coreid, int type) {
+      if (defer_callbacks)
+        deferred_stats.push_back(make_pair(coreid, type));
+      else
+        stats_callback(coreid, type);
+    }
+
+    void flush_callbacks() {
+      for (auto& req : deferred_responses)
+        req.callback(req);
+      deferred_responses.clear();
+      for (auto& stat : deferred_stats)
+        stats_callback(stat.first, stat.second);
+      deferred_stats.clear();
+    }
+
+    /* The first clk at which tick() does more than count the cycle. With all
+       queues empty and no open row for the row policy to close, only the
+       refresh scheduler has anything left to do. */
+    long next_event_clk() {
+        if (readq.size() || writeq.size() || actq.size() || otherq.size() || pending.size())
+            return clk + 1;
+        if (rowpolicy->type != RowPolicy<T>::Type::Opened && rowtable->table.size())
+            return clk + 1;
+        return max(refresh->next_refresh_clk(), clk + 1);
+    }
+
+    /* Stands in for cycles ticks that all come before next_event_clk(). The
+       queue length sums would only have added zeros, and the DRAM stats and
+       command trace are timestamped with clk, so idle time is still charged. */
+    void skip(long cycles) {
+        clk += cycles;
+        refresh->clk += cycles;
+    }
+
     // For telling whether this channel is busying in processing read or write
     bool is_active() {
       return (channel->cur_serving_requests > 0);
@@ -572,33 +748,14 @@ private:
         // currently, autoprecharge is only used with closed row policy
         if(channel->spec->is_accessing(cmd) && rowpolicy->type == RowPolicy<T>::Type::ClosedAP) {
             // check if it is the last request to the opened row
+            // The row is open, so every queued request to it is a row hit
             Queue* queue = write_mode ? &writeq : &readq;
+            long key = row_key(addr_vec);
 
-            auto begin = addr_vec.begin();
-            vector<int> rowgroup(begin, begin + int(T::Level::Row) + 1);
+            int num_row_hits = queue->row_reqs.get(key);
 
-			int num_row_hits = 0;
-
-            for (auto itr = queue->q.begin(); itr != queue->q.end(); ++itr) {
-                if (is_row_hit(itr)) { 
-                    auto begin2 = itr->addr_vec.begin();
-                    vector<int> rowgroup2(begin2, begin2 + int(T::Level::Row) + 1);
-                    if(rowgroup == rowgroup2)
-                        num_row_hits++;
-                }
-            }
-
-            if(num_row_hits == 0) {
-                Queue* queue = &actq;
-                for (auto itr = queue->q.begin(); itr != queue->q.end(); ++itr) {
-                    if (is_row_hit(itr)) {
-                        auto begin2 = itr->addr_vec.begin();
-                        vector<int> rowgroup2(begin2, begin2 + int(T::Level::Row) + 1);
-                        if(rowgroup == rowgroup2)
-                            num_row_hits++;
-                    }
-                }
-            }
+            if(num_row_hits == 0)
+                num_row_hits = actq.row_reqs.get(key);
 
             assert(num_row_hits > 0); // The current request should be a hit, 
                                       // so there should be at least one request 
@@ -622,16 +779,16 @@ private:
         channel->update(cmd, addr_vec.data(), clk);
 
         if(channel->spec->is_opening(cmd))
-            stats_callback(coreid, int(StatCallbackType::DRAM_ACT));
+            report_stat(coreid, int(StatCallbackType::DRAM_ACT));
 
         if(channel->spec->is_closing(cmd))
-            stats_callback(coreid, int(StatCallbackType::DRAM_PRE));
+            report_stat(coreid, int(StatCallbackType::DRAM_PRE));
         
         if(channel->spec->is_reading(cmd))
-            stats_callback(coreid, int(StatCallbackType::DRAM_READ));
+            report_stat(coreid, int(StatCallbackType::DRAM_READ));
 
         if(channel->spec->is_writing(cmd))
-            stats_callback(coreid, int(StatCallbackType::DRAM_WRITE));
+            report_stat(coreid, int(StatCallbackType::DRAM_WRITE));
 
 
         if(cmd == T::Command::PRE){
@@ -643,18 +800,10 @@ private:
         rowtable->update(cmd, addr_vec, clk);
         if (record_cmd_trace){
             // select rank
-            auto& file = cmd_trace_files[addr_vec[1]];
-            string& cmd_name = channel->spec->command_name[int(cmd)];
-            file<<clk<<','<<cmd_name;
-            // TODO bad coding here
-            if (cmd_name == "PREA" || cmd_name == "REF")
-                file<<endl;
-            else{
-                int bank_id = addr_vec[int(T::Level::Bank)];
-                if (channel->spec->standard_name == "DDR4" || channel->spec->standard_name == "GDDR5")
-                    bank_id += addr_vec[int(T::Level::Bank) - 1] * channel->spec->org_entry.count[int(T::Level::Bank)];
-                file<<','<<bank_id<<endl;
-            }
+            int bank_id = addr_vec[int(T::Level::Bank)];
+            if (channel->spec->standard_name == "DDR4" || channel->spec->standard_name == "GDDR5")
+                bank_id += addr_vec[int(T::Level::Bank) - 1] * channel->spec->org_entry.count[int(T::Level::Bank)];
+            cmd_trace->record(addr_vec[1], clk, int(cmd), bank_id);
         }
         if (print_cmd_trace){
             printf("%5s %10ld:", channel->spec->command_name[int(cmd)].c_str(), clk);
@@ -0,0 +1,345 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is furnished to do
+ * so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * FastMemory.h
+ *
+ * An analytical stand-in for the cycle-level Memory/Controller model, for
+ * studies that only need plausible DRAM latency and bandwidth. Each access
+ * pays a fixed latency, or a row hit/miss/conflict latency taken from the
+ * standard's timing table, and then queues for its channel's data bus.
+ * Address mapping, queue capacity and the Scarab-facing interface match
+ * Memory, so it can be swapped in through ScarabWrapper.
+ */
+
+#ifndef __FAST_MEMORY_H
+#define __FAST_MEMORY_H
+
+#include "Config.h"
+#include "Memory.h"
+#include "Request.h"
+#include "Statistics.h"
+#include <vector>
+#include <queue>
+#include <cassert>
+#include <climits>
+
+using namespace std;
+
+namespace ramulator
+{
+
+template <class T>
+class FastMemory : public MemoryBase
+{
+protected:
+  ScalarStat num_dram_cycles;
+  ScalarStat num_incoming_requests;
+  ScalarStat row_hits;
+  ScalarStat row_misses;
+  ScalarStat row_conflicts;
+  ScalarStat read_latency_sum;
+  ScalarStat read_latency_avg;
+  ScalarStat bus_wait_sum;
+
+public:
+    T* spec;
+
+    FastMemory(const Config& configs, T* spec, void (*stats_callback)(int, int))
+        : spec(spec), addr_bits(int(T::Level::MAX)), stats_callback(stats_callback)
+    {
+        int *sz = spec->org_entry.count;
+        assert((sz[0] & (sz[0] - 1)) == 0);
+        int tx = (spec->prefetch_size * spec->channel_width / 8);
+        tx_bits = calc_log2(tx);
+        assert((1<<tx_bits) == tx);
+
+        max_address = spec->channel_width / 8;
+        for (unsigned int lev = 0; lev < addr_bits.size(); lev++) {
+          addr_bits[lev] = calc_log2(sz[lev]);
+          max_address *= sz[lev];
+        }
+        addr_bits[int(T::Level::MAX) - 1] -= calc_log2(spec->prefetch_size);
+        use_rest_of_addr_as_row_addr = configs.use_rest_of_addr_as_row_addr();
+
+        num_channels = sz[int(T::Level::Channel)];
+        banks_per_channel = 1;
+        for (int lev = int(T::Level::Channel) + 1; lev < int(T::Level::Row); lev++)
+          banks_per_channel *= sz[lev];
+
+        reqs_per_channel = configs.get_int("readq_entries") + configs.get_int("writeq_entries");
+        row_buffer = configs["fast_row_buffer"] != "off";
+
+        // latencies in DRAM cycles, from the same timing tables Controller uses
+        int nRCD = bank_timing(T::Command::ACT, T::Command::RD);
+        int nRP = bank_timing(T::Command::PRE, T::Command::ACT);
+        // data bus time per access: the channel's back-to-back read spacing,
+        // or else the burst length (two beats per DRAM cycle)
+        burst_cycles = channel_timing(T::Command::RD, T::Command::RD);
+        if (!burst_cycles)
+          burst_cycles = max(1, spec->prefetch_size / 2);
+        hit_latency = spec->read_latency;
+        miss_latency = nRCD + spec->read_latency;
+        conflict_latency = nRP + nRCD + spec->read_latency;
+        fixed_latency = configs.get_int("fast_latency");
+        if (!fixed_latency)
+          fixed_latency = miss_latency;
+
+        bus_free.resize(num_channels, 0);
+        inflight.resize(num_channels, 0);
+        bank_free.resize(num_channels * banks_per_channel, 0);
+        open_row.resize(num_channels * banks_per_channel, -1);
+
+        num_dram_cycles
+            .name("dram_cycles")
+            .desc("Number of DRAM cycles simulated")
+            .precision(0)
+            ;
+        num_incoming_requests
+            .name("incoming_requests")
+            .desc("Number of incoming requests to DRAM")
+            .precision(0)
+            ;
+        row_hits
+            .name("fast_row_hits")
+            .desc("Number of row hits in the fast DRAM model")
+            .precision(0)
+            ;
+        row_misses
+            .name("fast_row_misses")
+            .desc("Number of row misses in the fast DRAM model")
+            .precision(0)
+            ;
+        row_conflicts
+            .name("fast_row_conflicts")
+            .desc("Number of row conflicts in the fast DRAM model")
+            .precision(0)
+            ;
+        read_latency_sum
+            .name("fast_read_latency_sum")
+            .desc("Sum of read latencies in the fast DRAM model (cycles)")
+            .precision(0)
+            ;
+        read_latency_avg
+            .name("fast_read_latency_avg")
+            .desc("Average read latency in the fast DRAM model (cycles)")
+            .precision(6)
+            ;
+        bus_wait_sum
+            .name("fast_bus_wait_sum")
+            .desc("Cycles requests waited for a busy channel data bus")
+            .precision(0)
+            ;
+    }
+
+    ~FastMemory()
+    {
+        delete spec;
+    }
+
+    double clk_ns() const {
+        return spec->speed_entry.tCK;
+    }
+
+    void tick()
+    {
+        clk++;  // num_dram_cycles is copied from clk in finish()
+        while (!in_flight.empty() && in_flight.top().req.depart <= clk) {
+            Access access = in_flight.top();
+            in_flight.pop();
+            inflight[access.channel]--;
+            if (access.req.type == Request::Type::READ) {
+                read_latency_sum += access.req.depart - access.req.arrive;
+                ++num_reads;
+                access.req.callback(access.req);
+            }
+        }
+    }
+
+    bool send(Request req)
+    {
+        long row = map_address(req);
+        int channel = req.addr_vec[int(T::Level::Channel)];
+        if (inflight[channel] >= reqs_per_channel)
+            return false;
+        ++num_incoming_requests;
+
+        int bank = 0;
+        for (int lev = int(T::Level::Channel) + 1; lev < int(T::Level::Row); lev++)
+            bank = bank * spec->org_entry.count[lev] + req.addr_vec[lev];
+        bank += channel * banks_per_channel;
+
+        long start = max(clk, bank_free[bank]);
+        long latency = fixed_latency;
+        bool reading = req.type == Request::Type::READ;
+        if (row_buffer) {
+            if (open_row[bank] == row) {
+                ++row_hits;
+                latency = hit_latency;
+            } else {
+                if (open_row[bank] == -1) {
+                    ++row_misses;
+                    latency = miss_latency;
+                } else {
+                    ++row_conflicts;
+                    latency = conflict_latency;
+                    stats_callback(req.coreid, int(StatCallbackType::DRAM_PRE));
+                }
+                stats_callback(req.coreid, int(StatCallbackType::DRAM_ACT));
+                open_row[bank] = row;
+            }
+            // the bank can take its next column command once the row is open
+            bank_free[bank] = start + latency - hit_latency;
+        }
+        stats_callback(req.coreid, int(reading ? StatCallbackType::DRAM_READ : StatCallbackType::DRAM_WRITE));
+
+        long data_start = max(start + latency - burst_cycles, bus_free[channel]);
+        bus_wait_sum += data_start - (start + latency - burst_cycles);
+        bus_free[channel] = data_start + burst_cycles;
+
+        req.arrive = clk;
+        req.depart = data_start + burst_cycles;
+        inflight[channel]++;
+        in_flight.push(Access{req, channel, seq++});
+        return true;
+    }
+
+    int pending_requests()
+    {
+        return in_flight.size();
+    }
+
+    void finish(void) {
+        num_dram_cycles = clk;
+        read_latency_avg = num_reads ? read_latency_sum.value() / num_reads : 0;
+    }
+
+    long page_allocator(long addr, int coreid) {
+        return addr;
+    }
+
+    void record_core(int coreid) {}
+    void set_high_writeq_watermark(const float watermark) {}
+    void set_low_writeq_watermark(const float watermark) {}
+
+    int get_chip_width() const {
+        return spec->org_entry.dq;
+    }
+
+    int get_chip_size() const {
+        return spec->org_entry.size;
+    }
+
+    int get_num_chips() const {
+        uint64_t chip_capacity_bytes = (uint64_t(get_chip_size()) * 1024 * 1024) / 8; // MegaBits to Bytes
+        return uint64_t(max_address) / chip_capacity_bytes;
+    }
+
+    int get_chip_row_buffer_size() const {
+        return spec->org_entry.count[int(T::Level::Column)] * spec->org_entry.dq;
+    }
+
+private:
+    struct Access {
+        Request req;
+        int channel;
+        long seq;  // keeps same-cycle completions in arrival order
+
+        bool operator>(const Access& other) const {
+            if (req.depart != other.req.depart)
+                return req.depart > other.req.depart;
+            return seq > other.seq;
+        }
+    };
+
+    priority_queue<Access, vector<Access>, greater<Access>> in_flight;
+    long clk = 0;
+    long seq = 0;
+    long num_reads = 0;
+
+    vector<int> addr_bits;
+    int tx_bits;
+    long max_address;
+    bool use_rest_of_addr_as_row_addr;
+    void (*stats_callback)(int, int);
+
+    int num_channels;
+    int banks_per_channel;
+    int reqs_per_channel;
+    bool row_buffer;
+    long hit_latency, miss_latency, conflict_latency, fixed_latency;
+    int burst_cycles;
+
+    vector<long> bus_free;   // first cycle each channel's data bus is free
+    vector<int> inflight;    // requests accepted and not yet done per channel
+    vector<long> bank_free;  // first cycle each bank accepts a new row command
+    vector<long> open_row;   // open row per bank, -1 if precharged
+
+    // same RoBaRaCoCh mapping as Memory::send(); returns the row address
+    long map_address(Request& req)
+    {
+        req.addr_vec.resize(addr_bits.size());
+        long addr = req.addr >> tx_bits;
+        req.addr_vec[0] = slice_lower_bits(addr, addr_bits[0]);
+        req.addr_vec[addr_bits.size() - 1] = slice_lower_bits(addr, addr_bits[addr_bits.size() - 1]);
+        for (int i = 1; i < int(T::Level::Row); i++)
+            req.addr_vec[i] = slice_lower_bits(addr, addr_bits[i]);
+        if (use_rest_of_addr_as_row_addr)
+            return addr;
+        return slice_lower_bits(addr, addr_bits[int(T::Level::Row)]);
+    }
+
+    int bank_timing(typename T::Command from, typename T::Command to)
+    {
+        return timing_of(T::Level::Bank, from, to);
+    }
+
+    int channel_timing(typename T::Command from, typename T::Command to)
+    {
+        return timing_of(T::Level::Channel, from, to);
+    }
+
+    int timing_of(typename T::Level level, typename T::Command from, typename T::Command to)
+    {
+        for (const auto& t : spec->timing[int(level)][int(from)])
+            if (t.cmd == to && t.dist == 1 && !t.sibling)
+                return t.val;
+        return 0;
+    }
+
+    int calc_log2(int val){
+        int n = 0;
+        while ((val >>= 1))
+            n ++;
+        return n;
+    }
+
+    int slice_lower_bits(long& addr, int bits)
+    {
+        int lbits = addr & ((1<<bits) - 1);
+        addr >>= bits;
+        return lbits;
+    }
+};
+
+} /*namespace ramulator*/
+
+#endif /*__FAST_MEMORY_H*/
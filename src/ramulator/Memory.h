@@ -27,6 +27,7 @@
 #include "Request.h"
 #include "Controller.h"
 #include "SpeedyController.h"
+#include "ChannelTicker.h"
 #include "Statistics.h"
 #include "GDDR5.h"
 #include "HBM.h"
@@ -42,6 +43,7 @@
 #include <cassert>
 #include <tuple>
 #include <limits.h>
+#include <memory>
 
 using namespace std;
 
@@ -54,6 +56,10 @@ public:
     virtual ~MemoryBase() {}
     virtual double clk_ns() const = 0;
     virtual void tick() = 0;
+    // Ticks from now on that would change nothing, and a way to pass them
+    // all at once. Models without idle skipping never report any.
+    virtual long idle_cycles() { return 0; }
+    virtual void skip(long cycles) {}
     virtual bool send(Request req) = 0;
     virtual int pending_requests() = 0;
     virtual void finish(void) = 0;
@@ -103,6 +109,10 @@ protected:
   ScalarStat in_queue_read_req_num_avg;
   ScalarStat in_queue_write_req_num_avg;
 
+  // tick-path counters behind num_dram_cycles and ramulator_active_cycles
+  long num_dram_cycles_total = 0;
+  long ramulator_active_cycles_total = 0;
+
 #ifndef INTEGRATED_WITH_GEM5
   VectorStat record_read_requests;
   VectorStat record_write_requests;
@@ -134,6 +144,7 @@ public:
     map<pair<int, long>, long> page_translation;
 
     vector<Controller<T>*> ctrls;
+    unique_ptr<ChannelTicker> ticker;
     T * spec;
     vector<int> addr_bits;
 
@@ -266,6 +277,14 @@ public:
             .desc("Average of write queue length per memory cycle")
             .precision(6)
             ;
+        if (!configs.queue_stats()) {
+            in_queue_req_num_sum.flags(0);
+            in_queue_read_req_num_sum.flags(0);
+            in_queue_write_req_num_sum.flags(0);
+            in_queue_req_num_avg.flags(0);
+            in_queue_read_req_num_avg.flags(0);
+            in_queue_write_req_num_avg.flags(0);
+        }
 #ifndef INTEGRATED_WITH_GEM5
         record_read_requests
             .init(configs.get_core_num())
@@ -280,10 +299,20 @@ public:
             ;
 #endif
 
+        // tick channels on a thread pool; the stdout command trace would
+        // interleave, so it keeps the serial loop
+        int tick_threads = min(configs.get_int("tick_threads"), int(ctrls.size()));
+        if (tick_threads > 1 && !configs.print_cmd_trace()) {
+            for (auto ctrl : ctrls)
+                ctrl->defer_callbacks = true;
+            ticker.reset(new ChannelTicker(tick_threads, ctrls.size(),
+                [this](int i) { this->ctrls[i]->tick(); }));
+        }
     }
 
     ~Memory()
     {
+        ticker.reset();
         for (auto ctrl: ctrls)
             delete ctrl;
         delete spec;
@@ -324,29 +353,46 @@ public:
 
     void tick()
     {
-        ++num_dram_cycles;
-        int cur_que_req_num = 0;
-        int cur_que_readreq_num = 0;
-        int cur_que_writereq_num = 0;
-        for (auto ctrl : ctrls) {
-          cur_que_req_num += ctrl->readq.size() + ctrl->writeq.size() + ctrl->pending.size();
-          cur_que_readreq_num += ctrl->readq.size() + ctrl->pending.size();
-          cur_que_writereq_num += ctrl->writeq.size();
-        }
-        in_queue_req_num_sum += cur_que_req_num;
-        in_queue_read_req_num_sum += cur_que_readreq_num;
-        in_queue_write_req_num_sum += cur_que_writereq_num;
+        // the queue length sums are the channels' own, added up in finish()
+        num_dram_cycles_total++;
 
         bool is_active = false;
-        for (auto ctrl : ctrls) {
-          is_active = is_active || ctrl->is_active();
-          ctrl->tick();
+        if (ticker) {
+          // channels only see their own state, so sampling them all before
+          // ticking matches the serial loop below
+          for (auto ctrl : ctrls)
+            is_active = is_active || ctrl->is_active();
+          ticker->run();
+          // replay callbacks in channel order to keep the run deterministic
+          for (auto ctrl : ctrls)
+            ctrl->flush_callbacks();
+        } else {
+          for (auto ctrl : ctrls) {
+            is_active = is_active || ctrl->is_active();
+            ctrl->tick();
+          }
         }
         if (is_active) {
-          ramulator_active_cycles++;
+          ramulator_active_cycles_total++;
         }
     }
 
+    long idle_cycles()
+    {
+        long idle = LONG_MAX;
+        for (auto ctrl : ctrls)
+            idle = min(idle, ctrl->next_event_clk() - ctrl->clk - 1);
+        return idle;
+    }
+
+    // an idle channel is never active, so only the cycle count moves
+    void skip(long cycles)
+    {
+        num_dram_cycles_total += cycles;
+        for (auto ctrl : ctrls)
+            ctrl->skip(cycles);
+    }
+
     bool send(Request req)
     {
         req.addr_vec.resize(addr_bits.size());
@@ -425,11 +471,20 @@ public:
       dram_capacity = max_address;
       int *sz = spec->org_entry.count;
       maximum_bandwidth = spec->speed_entry.rate * 1e6 * spec->channel_width * sz[int(T::Level::Channel)] / 8;
-      long dram_cycles = num_dram_cycles.value();
+      num_dram_cycles = num_dram_cycles_total;
+      ramulator_active_cycles = ramulator_active_cycles_total;
+      long dram_cycles = num_dram_cycles_total;
+      long queue_total = 0, read_queue_total = 0, write_queue_total = 0;
       for (auto ctrl : ctrls) {
         long read_req = long(incoming_read_reqs_per_channel[ctrl->channel->id].value());
         ctrl->finish(read_req, dram_cycles);
+        queue_total += ctrl->req_queue_length_total;
+        read_queue_total += ctrl->read_req_queue_length_total;
+        write_queue_total += ctrl->write_req_queue_length_total;
       }
+      in_queue_req_num_sum = queue_total;
+      in_queue_read_req_num_sum = read_queue_total;
+      in_queue_write_req_num_sum = write_queue_total;
 
       // finalize average queueing requests
       in_queue_req_num_avg = in_queue_req_num_sum.value() / dram_cycles;
@@ -104,6 +104,12 @@ public:
     }
   }
 
+  // The clk of the next tick_ref() that injects a refresh. The ticks before
+  // it only advance clk, so an idle controller may skip them.
+  long next_refresh_clk() const {
+    return refreshed + ctrl->channel->spec->speed_entry.nREFI;
+  }
+
 private:
   // Keeping track of refresh status of every bank: + means ahead of schedule, - means behind schedule
   vector<vector<int>*> bank_refresh_backlog;
@@ -153,6 +159,7 @@ private:
 // where to look for these definitions when controller calls them!
 template<> Refresh<DSARP>::Refresh(Controller<DSARP>* ctrl);
 template<> void Refresh<DSARP>::tick_ref();
+template<> long Refresh<DSARP>::next_refresh_clk() const;
 
 } /* namespace ramulator */
 
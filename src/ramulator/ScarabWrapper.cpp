@@ -21,6 +21,7 @@
 
 #include <map>
 
+#include "FastMemory.h"
 #include "Memory.h"
 #include "MemoryFactory.h"
 #include "Request.h"
@@ -53,14 +54,41 @@ static map<string, function<MemoryBase*(const Config&, int, void (*)(int, int))>
     {"SALP-MASA", &MemoryFactory<SALP>::create},
 };
 
+template <typename T>
+static MemoryBase* create_fast_memory(const Config& configs, int cacheline,
+                                      void (*stats_callback)(int, int)) {
+  T* spec = new T(configs);
+  MemoryFactory<T>::extend_channel_width(spec, cacheline);
+  return new FastMemory<T>(configs, spec, stats_callback);
+}
+
+// standards the analytical model supports (built from the config alone)
+static map<string, function<MemoryBase*(const Config&, int, void (*)(int, int))>>
+  name_to_fast_func = {
+    {"DDR3", &create_fast_memory<DDR3>},
+    {"DDR4", &create_fast_memory<DDR4>},
+    {"LPDDR3", &create_fast_memory<LPDDR3>},
+    {"LPDDR4", &create_fast_memory<LPDDR4>},
+    {"GDDR5", &create_fast_memory<GDDR5>},
+    {"WideIO", &create_fast_memory<WideIO>},
+    {"HBM", &create_fast_memory<HBM>},
+};
+
 
 ScarabWrapper::ScarabWrapper(const Config&      configs,
                              const unsigned int cacheline,
                              void (*stats_callback)(int,int)) {
   const string& std_name = configs["standard"];
-  assert(name_to_func.find(std_name) != name_to_func.end() &&
-         "unrecognized standard name");
-  mem = name_to_func[std_name](configs, cacheline, stats_callback);
+  if (configs["memory_model"] == "fast") {
+    assert(name_to_fast_func.find(std_name) != name_to_fast_func.end() &&
+           "standard not supported by the fast DRAM model");
+    mem = name_to_fast_func[std_name](configs, cacheline, stats_callback);
+  } else {
+    assert(name_to_func.find(std_name) != name_to_func.end() &&
+           "unrecognized standard name");
+    mem = name_to_func[std_name](configs, cacheline, stats_callback);
+  }
+  skip_idle = configs.skip_idle();
   // tCK = mem->clk_ns();
   Stats::statlist.output(configs["output_dir"] + "/ramulator.stat.out");
 }
@@ -70,15 +98,34 @@ ScarabWrapper::~ScarabWrapper() {
   delete mem;
 }
 
+void ScarabWrapper::catch_up() {
+  if (skipped_ticks) {
+    mem->skip(skipped_ticks);
+    skipped_ticks = 0;
+  }
+}
+
 void ScarabWrapper::tick() {
+  if (idle_ticks) {
+    idle_ticks--;
+    skipped_ticks++;
+    return;
+  }
+  catch_up();
   mem->tick();
+  if (skip_idle)
+    idle_ticks = mem->idle_cycles();
 }
 
 bool ScarabWrapper::send(Request req) {
+  // the request arrives at the current clk and ends the idle period
+  catch_up();
+  idle_ticks = 0;
   return mem->send(req);
 }
 
 void ScarabWrapper::finish(void) {
+  catch_up();
   mem->finish();
   Stats::statlist.printall();
 }
@@ -38,6 +38,12 @@ class ScarabWrapper
 {
 private:
     MemoryBase *mem;
+    /* With skip_idle on, the ticks that mem reported idle are only counted
+       and handed to it in one skip() before it is next used */
+    bool skip_idle;
+    long idle_ticks = 0;     // idle ticks still to come
+    long skipped_ticks = 0;  // idle ticks passed but not yet applied
+    void catch_up();
 public:
     //double tCK;
     ScarabWrapper(const Config& configs, const unsigned int cacheline, void (* stats_callback)(int, int));
@@ -94,15 +94,14 @@ FRFCFS_PriorHit"); }
         }
 
         // prepare a list of hit request
-        vector<vector<int>> hit_reqs;
+        // TODO Here it assumes all DRAM standards use PRE to close a row
+        // It's better to make it more general.
+        int pre_scope = int(ctrl->channel->spec->scope[int(T::Command::PRE)]);
+        hit_rowgroups.clear();
         for (auto itr = q.begin() ; itr != q.end() ; ++itr) {
           if (this->ctrl->is_row_hit(itr)) {
-            auto begin = itr->addr_vec.begin();
-            // TODO Here it assumes all DRAM standards use PRE to close a row
-            // It's better to make it more general.
-            auto end = begin + int(ctrl->channel->spec->scope[int(T::Command::PRE)]) + 1;
-            vector<int> rowgroup(begin, end); // bank or subarray
-            hit_reqs.push_back(rowgroup);
+            // bank or subarray
+            hit_rowgroups.push_back(ctrl->rowgroup_key(itr->addr_vec, pre_scope));
           }
         }
         // if we can't find proper request, we need to return q.end(),
@@ -112,12 +111,8 @@ FRFCFS_PriorHit"); }
           bool violate_hit = false;
           if ((!this->ctrl->is_row_hit(itr)) && this->ctrl->is_row_open(itr)) {
             // so the next instruction to be scheduled is PRE, might violate hit
-            auto begin = itr->addr_vec.begin();
-            // TODO Here it assumes all DRAM standards use PRE to close a row
-            // It's better to make it more general.
-            auto end = begin + int(ctrl->channel->spec->scope[int(T::Command::PRE)]) + 1;
-            vector<int> rowgroup(begin, end); // bank or subarray
-            for (const auto& hit_req_rowgroup : hit_reqs) {
+            long rowgroup = ctrl->rowgroup_key(itr->addr_vec, pre_scope);
+            for (long hit_req_rowgroup : hit_rowgroups) {
               if (rowgroup == hit_req_rowgroup) {
                   violate_hit = true;
                   break;
@@ -140,6 +135,9 @@ FRFCFS_PriorHit"); }
     }
 
 private:
+    // rowgroups with a pending row hit, reused across calls to get_head()
+    vector<long> hit_rowgroups;
+
     typedef list<Request>::iterator ReqIter;
     function<ReqIter(ReqIter, ReqIter)> compare[int(Policy::MAX)] = {
         // FCFS
@@ -22,6 +22,7 @@
 #ifndef __SPEEDYCONTROLLER_H
 #define __SPEEDYCONTROLLER_H
 
+#include "CmdTrace.h"
 #include "Config.h"
 #include "DRAM.h"
 #include "Request.h"
@@ -58,7 +59,7 @@ private:
 public:
     /* Command trace for DRAMPower 3.1 */
     string cmd_trace_prefix = "cmd-trace-";
-    vector<ofstream> cmd_trace_files;
+    CmdTrace* cmd_trace = nullptr;
     bool record_cmd_trace = false;
     /* Commands to stdout */
     bool print_cmd_trace = false;
@@ -91,9 +92,9 @@ public:
         print_cmd_trace = configs.print_cmd_trace();
         if (record_cmd_trace){
             string prefix = cmd_trace_prefix + "chan-" + to_string(channel->id) + "-rank-";
-            string suffix = ".cmdtrace";
-            for (unsigned int i = 0; i < channel->children.size(); i++)
-                cmd_trace_files.emplace_back(prefix + to_string(i) + suffix);
+            vector<string> names(channel->spec->command_name, channel->spec->command_name + int(T::Command::MAX));
+            cmd_trace = new CmdTrace(prefix, channel->children.size(), names, configs.cmd_trace_format() == "binary",
+                                     configs.cmd_trace_compress());
         }
         readq.reserve(queue_capacity);
         writeq.reserve(queue_capacity);
@@ -115,8 +116,7 @@ public:
 
     ~SpeedyController(){
         delete channel;
-        for (auto& file : cmd_trace_files)
-            file.close();
+        delete cmd_trace;
     }
 
     /* Member Functions */
@@ -297,19 +297,11 @@ private:
 
         if (record_cmd_trace){
             // select rank
-            auto& file = cmd_trace_files[addr_vec[1]];
-            string& cmd_name = channel->spec->command_name[int(cmd)];
-            file<<clk<<','<<cmd_name;
-            // TODO bad coding here
-            if (cmd_name == "PREA" || cmd_name == "REF")
-                file<<endl;
-            else {
-                int bank_id = addr_vec[int(T::Level::Bank)];
-                if (channel->spec->standard_name == "DDR4" || channel->spec->standard_name == "GDDR5")
-                    bank_id += addr_vec[int(T::Level::Bank) - 1] *
-                        channel->spec->org_entry.count[int(T::Level::Bank)];
-                file<<','<<bank_id<<endl;
-            }
+            int bank_id = addr_vec[int(T::Level::Bank)];
+            if (channel->spec->standard_name == "DDR4" || channel->spec->standard_name == "GDDR5")
+                bank_id += addr_vec[int(T::Level::Bank) - 1] *
+                    channel->spec->org_entry.count[int(T::Level::Bank)];
+            cmd_trace->record(addr_vec[1], clk, int(cmd), bank_id);
         }
         if (print_cmd_trace){
             printf("%5s %10ld:", channel->spec->command_name[int(cmd)].c_str(), clk);
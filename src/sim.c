@@ -29,27 +29,35 @@
 #include "sim.h"
 
 #include <fcntl.h>
+#include <math.h>
 #include <signal.h>
 #include <stdio.h>
 #include <time.h>
+#include <unistd.h>
 
 #include "globals/assert.h"
 #include "globals/global_defs.h"
 #include "globals/global_types.h"
 #include "globals/global_vars.h"
 #include "globals/utils.h"
+#include "libs/mem_footprint.h"
+#include "libs/snapshot_lib.h"
 
 #include "debug/debug.param.h"
 #include "debug/debug_macros.h"
 #include "debug/debug_print.h"
+#include "debug/host_prof.h"
 #include "debug/memview.h"
 #include "debug/pipeview.h"
+#include "debug/trace_event.h"
 
 #include "bp/bp.param.h"
 #include "core.param.h"
 #include "general.param.h"
+#include "memory/memory.param.h"
 #include "prefetcher/pref.param.h"
 
+#include "bp/bp_stream.h"
 #include "frontend/frontend.h"
 #include "frontend/frontend_intf.h"
 #include "frontend/pin_trace_fe.h"
@@ -58,12 +66,16 @@
 #include "prefetcher/fdip.h"
 
 #include "cmp_model.h"
+#include "decoupled_frontend.h"
 #include "dumb_model.h"
+#include "interval_model.h"
 #include "freq.h"
 #include "model.h"
 #include "op_pool.h"
 #include "optimizer2.h"
 #include "ramulator.h"
+#include "stat_live.h"
+#include "stat_sample.h"
 #include "stat_trace.h"
 #include "statistics.h"
 #include "thread.h"
@@ -88,7 +100,7 @@ Counter* op_count;              /* the global op counter per core*/
 Counter* inst_count;            /* the global instruction counter - retired per core */
 Counter* inst_count_fetched;    /* the global FETCHED instruction counter - retired per core */
 Counter* uop_count;             /* the global uop counter - retired per core*/
-Counter cycle_count = 0;        /* the global cycle counter */
+CORE_LOCAL Counter cycle_count = 0; /* the global cycle counter */
 Counter sim_time = 0;           /* the global time counter */
 Counter* pret_inst_count;       /* the global pseudo-retired instruction counter */
 Flag* trace_read_done;
@@ -113,6 +125,12 @@ Counter period_ID = 0;
 /* the global warmup dump flags */
 Flag* warmup_dump_done;
 
+/* PREEMPT_CHECKPOINT: set by the signal handler once the main loop can take a
+   checkpoint, and the instructions each core warmed before simulation */
+static volatile sig_atomic_t checkpoint_armed = FALSE;
+static volatile sig_atomic_t checkpoint_requested = FALSE;
+static Counter warmup_inst_count[MAX_NUM_PROCS];
+
 time_t sim_start_time; /* the time that the simulator was started */
 
 FILE* mystdout;      /* default output (can be redirected via --stdout) */
@@ -126,13 +144,12 @@ Model* model; /* pointer to the simulator model being used
        (points to an entry in the model_table array) */
 
 Thread_Data single_td;        /* cmp Only For single processor: backward compatibility issue*/
-Thread_Data* td = &single_td; /* array of tds for muti-core, all state
+CORE_LOCAL Thread_Data* td = &single_td; /* array of tds for muti-core, all state
                                  associated with the simulated thread */
 
 /**************************************************************************************/
 /* Prototypes */
 
-static void init_global_counter(void);
 static void init_model(uns mode);
 static void init_output_streams(void);
 static void process_params(void);
@@ -145,21 +162,39 @@ static inline void set_last_sim_param(uns8 proc_id);
 static inline void print_bogus_sim_param(uns8 proc_id);
 
 /**************************************************************************************/
-/* handle_SIGINT: this handler is for exiting smoothly when a SIGINT is caught
- */
+/* handle_exit_signal: this handler is for exiting smoothly when a SIGINT or
+   SIGTERM is caught. With PREEMPT_CHECKPOINT the main loop saves a checkpoint
+   before exiting. */
 
-void handle_SIGINT(int signum) {
+void handle_exit_signal(int signum) {
   uns8 proc_id;
 
-  ASSERTU(0, signum == SIGINT);
+  ASSERTU(0, signum == SIGINT || signum == SIGTERM);
 
-  fprintf(mystdout, "** Handler:  Caught SIGINT.  Exiting...\n");
+  if (checkpoint_armed) {
+    fprintf(mystdout, "** Handler:  Caught %s.  Saving a checkpoint...\n", signum == SIGINT ? "SIGINT" : "SIGTERM");
+    checkpoint_requested = TRUE;
+    return;
+  }
+  fprintf(mystdout, "** Handler:  Caught %s.  Exiting...\n", signum == SIGINT ? "SIGINT" : "SIGTERM");
 
   for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     retired_exit[proc_id] = TRUE;
   }
 }
 
+/**************************************************************************************/
+/* heartbeat_clock: monotonic host seconds, so that short heartbeat intervals
+   still get a rate */
+
+static double sim_start_clock;
+
+static double heartbeat_clock(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
 /**************************************************************************************/
 /* check_heartbeat: Determine if the heartbeat needs to happen and do it if
  * needed. */
@@ -168,7 +203,7 @@ static inline void check_heartbeat(uns8 proc_id, Flag final) {
   ASSERT(proc_id, proc_id == 0 || final);
 #define ROUND 6
   static int last_heartbeat_idx = -1;
-  static time_t heartbeat_last_time = 0;
+  static double heartbeat_last_time = 0;  // 0: since the start of the simulation
   static Counter heartbeat_last_cycle_count = 0;
   static Counter heartbeat_last_inst_count = 0;
   static Counter heartbeat_checked_inst_count = 0;
@@ -204,7 +239,7 @@ static inline void check_heartbeat(uns8 proc_id, Flag final) {
   /* dump warmup stats */
   if (FULL_WARMUP && !warmup_dump_done[proc_id] && inst_count_to_use >= FULL_WARMUP) {
     ASSERT(proc_id, !PERIODIC_DUMP);
-    dump_stats(proc_id, TRUE, global_stat_array[proc_id], NUM_GLOBAL_STATS);
+    dump_stats(proc_id, TRUE, 0, NUM_GLOBAL_STATS);
     period_last_cycle_count = cycle_count;
     // this number is used to calcute IPC, so it uses inst_count always
     period_last_inst_count[proc_id] = inst_count[proc_id];
@@ -214,7 +249,7 @@ static inline void check_heartbeat(uns8 proc_id, Flag final) {
   /* print heartbeat message if necessary */
   if ((HEARTBEAT_INTERVAL && inst_diff >= rounded_interval) || final) {
     if (PERIODIC_DUMP) {
-      dump_stats(proc_id, TRUE, global_stat_array[proc_id], NUM_GLOBAL_STATS);
+      dump_stats(proc_id, TRUE, 0, NUM_GLOBAL_STATS);
       period_last_cycle_count = cycle_count;
       // this number is used to calcute IPC, so it uses inst_count always
       period_last_inst_count[proc_id] = inst_count[proc_id];
@@ -232,18 +267,20 @@ static inline void check_heartbeat(uns8 proc_id, Flag final) {
         return;
       last_heartbeat_idx = heartbeat_idx;
     }
-    time_t cur_time = time(NULL);
+    double cur_time = heartbeat_clock();
+    double int_time = cur_time - (heartbeat_last_time ? heartbeat_last_time : sim_start_clock);
+    double cum_time = cur_time - sim_start_clock;
     double cum_ipc = (double)inst_count[proc_id] / cycle_count;
     Counter total_inst_count = 0;
     for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
       total_inst_count += USE_FETCHED_COUNT ? inst_count_fetched[proc_id] : inst_count[proc_id];
     }
 #if HEARTBEAT_PRINT_CPS
-    double int_khz = (double)HEARTBEAT_INTERVAL / (cur_time - heartbeat_last_time) / 1000;
-    double cum_khz = (double)cycle_count / (cur_time - sim_start_time) / 1000;
+    double int_khz = (double)HEARTBEAT_INTERVAL / int_time / 1000;
+    double cum_khz = (double)cycle_count / cum_time / 1000;
 #else
-    double int_khz = (double)(total_inst_count - heartbeat_last_inst_count) / (cur_time - heartbeat_last_time) / 1000;
-    double cum_khz = (double)total_inst_count / (cur_time - sim_start_time) / 1000;
+    double int_khz = (double)(total_inst_count - heartbeat_last_inst_count) / int_time / 1000;
+    double cum_khz = (double)total_inst_count / cum_time / 1000;
 #endif
 
     if (final) {
@@ -278,6 +315,7 @@ static inline void check_heartbeat(uns8 proc_id, Flag final) {
         fprintf(mystdout, "%lld ", USE_FETCHED_COUNT ? inst_count_fetched[proc_id] : inst_count[proc_id]);
       }
       fprintf(mystdout, "} -- %.2f KIPS (%.2f KIPS)\n", int_khz, cum_khz);
+      host_prof_heartbeat(mystdout);
       fflush(mystdout);
       heartbeat_last_time = cur_time;
       heartbeat_last_cycle_count = cycle_count;
@@ -300,7 +338,7 @@ static inline Counter check_forward_progress(uns8 proc_id) {
     uns8 proc_id2;
     for (proc_id2 = 0; proc_id2 < NUM_CORES; proc_id2++) {
       if (!sim_done[proc_id2])
-        dump_stats(proc_id2, TRUE, global_stat_array[proc_id2], NUM_GLOBAL_STATS);
+        dump_stats(proc_id2, TRUE, 0, NUM_GLOBAL_STATS);
     }
 
     if (cmp_model.node_stage[proc_id].node_head) {
@@ -390,12 +428,15 @@ static void init_output_streams() {
       exit(15);
     }
   }
+
+  trace_event_init();
 }
 
 /**************************************************************************************/
 /* close_output_streams */
 
 void close_output_streams(void) {
+  trace_event_done();
   if (STDOUT_FILE)
     fclose(mystdout);
   if (STDERR_FILE)
@@ -491,12 +532,41 @@ void init_global(char* argv[], char* envp[]) {
     init_global_stats(proc_id);
   process_params();
   stat_trace_init();
-  if (SIM_MODEL != DUMB_MODEL)
+  stat_sample_init();
+  stat_live_init();
+  bp_stream_init();
+  host_prof_init();
+  init_phase_done("stats");
+  if ((SIM_MODEL != DUMB_MODEL || DUMB_MODEL_FRONTEND) && SIM_MODE != DRAM_REPLAY_SIM_MODE)
     frontend_init();
+  init_phase_done("frontend");
   power_intf_init();
   init_thread(td, argv, envp);  // Remove later may be? This is here for
                                 // execution driven version
   sim_start_time = time(NULL);
+  sim_start_clock = heartbeat_clock();
+}
+
+/**************************************************************************************/
+/* init_phase_start: */
+
+static struct timespec init_phase_time;
+
+void init_phase_start(void) {
+  clock_gettime(CLOCK_MONOTONIC, &init_phase_time);
+}
+
+/**************************************************************************************/
+/* init_phase_done: */
+
+void init_phase_done(const char* phase) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (PRINT_INIT_TIMES) {
+    double ms = (now.tv_sec - init_phase_time.tv_sec) * 1e3 + (now.tv_nsec - init_phase_time.tv_nsec) * 1e-6;
+    fprintf(mystdout, "** Init %-16s %10.3f ms\n", phase, ms);
+  }
+  init_phase_time = now;
 }
 
 /**************************************************************************************/
@@ -509,6 +579,8 @@ static void init_model(uns mode) {
     ASSERT(0, DUMB_CORE < NUM_CORES);
     model_table[DUMB_MODEL].init_func(mode);
   }
+  if (REPORT_MEM_FOOTPRINT)
+    mem_footprint_report(mystdout);
 }
 
 /**************************************************************************************/
@@ -535,6 +607,189 @@ static inline void print_bogus_sim_param(uns8 proc_id) {
 /**************************************************************************************/
 /* uop_sim: This is the main loop for running in uop level simulation mode.*/
 
+/**************************************************************************************/
+/* warmup_advance_time: HACK that ensures that cache replacement works in
+   warmup, by moving time forward once per warmed instruction */
+
+static inline void warmup_advance_time(void) {
+  do {
+    freq_advance_time();
+  } while (!freq_is_ready(FREQ_DOMAIN_L1));
+  sim_time = freq_time();
+}
+
+/**************************************************************************************/
+/* warmup_op, warmup_done: the op the next warmup op is fetched into, and the end
+   of a warmup phase. A model that warms on other host threads supplies the ops
+   (or NULL for local_op) and may keep them until warmup_done, which waits for
+   that work to finish. */
+
+static inline Op* warmup_op(Op* local_op) {
+  Op* op = model->warmup_op_func ? model->warmup_op_func() : NULL;
+  return op ? op : local_op;
+}
+
+static inline void warmup_done(void) {
+  if (model->warmup_done_func)
+    model->warmup_done_func();
+}
+
+/**************************************************************************************/
+/* uop_sim_skip: the warmup of uop_sim without generating ops. warm_func (may
+   be NULL) sees one instruction of each core per step, like warmup_func; the
+   bulk skip without it still advances the time as far as a warmup would. */
+
+static void uop_sim_skip(Frontend_Skip_Warm_Func warm_func) {
+  while (inst_count[0] < WARMUP) {
+    uns64 num_insts = warm_func ? 1 : WARMUP - inst_count[0];
+    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+        continue;
+      Flag exited;
+      inst_count[proc_id] += frontend_skip(proc_id, num_insts, warm_func, &exited);
+      ASSERTM(proc_id, !exited, "Program ended before start of simulation\n");
+    }
+    for (uns64 ii = 0; ii < num_insts; ii++)
+      warmup_advance_time();
+  }
+  check_heartbeat(0, TRUE);
+}
+
+/**************************************************************************************/
+/* Uop_Sim_Ops: the ops of one core's current instruction in uop_sim, fetched
+   together through frontend_fetch_ops. Grown to the most uops seen in one
+   instruction; the ops are refetched after growing, so nothing is copied. */
+
+typedef struct Uop_Sim_Ops_struct {
+  uns size;
+  Op* ops;
+  Op** op_ptrs;
+  Table_Info* table_infos;
+  Inst_Info* inst_infos;
+} Uop_Sim_Ops;
+
+static void uop_sim_ops_reserve(Uop_Sim_Ops* buf, uns size) {
+  if (size <= buf->size)
+    return;
+  /* Op is cache-line aligned, which realloc does not guarantee */
+  free(buf->ops);
+  int error = posix_memalign((void**)&buf->ops, __alignof__(Op), size * sizeof(Op));
+  ASSERTUM(0, error == 0, "Could not allocate %u warmup ops\n", size);
+  memset(buf->ops, 0, size * sizeof(Op));
+  buf->op_ptrs = (Op**)realloc(buf->op_ptrs, size * sizeof(Op*));
+  buf->table_infos = (Table_Info*)realloc(buf->table_infos, size * sizeof(Table_Info));
+  buf->inst_infos = (Inst_Info*)realloc(buf->inst_infos, size * sizeof(Inst_Info));
+  for (uns ii = 0; ii < size; ii++) {
+    buf->ops[ii].table_info = &buf->table_infos[ii];
+    buf->ops[ii].inst_info = &buf->inst_infos[ii];
+    buf->ops[ii].mbp7_info = NULL;
+    buf->op_ptrs[ii] = &buf->ops[ii];
+  }
+  buf->size = size;
+}
+
+static void uop_sim_ops_free(Uop_Sim_Ops* buf) {
+  free(buf->ops);
+  free(buf->op_ptrs);
+  free(buf->table_infos);
+  free(buf->inst_infos);
+}
+
+/**************************************************************************************/
+/* uop_sim_fetched: the bookkeeping of every op uop_sim fetches */
+
+static inline void uop_sim_fetched(uns proc_id, Op* op) {
+  if (op->table_info->mem_type != NOT_MEM && op->oracle_info.va == 0) {
+    FATAL_ERROR(proc_id, "Access to 0x0\n");
+  }
+
+  if (DUMP_TRACE && DEBUG_RANGE_COND(proc_id))
+    print_func_op(op);
+
+  op_count[proc_id]++;
+  if (op->eom)
+    inst_count[proc_id]++;
+  if (op->exit)
+    retired_exit[proc_id] = TRUE;
+  ASSERTM(proc_id, !op->exit || operating_mode == SIMULATION_MODE, "Program ended before start of simulation\n");
+}
+
+/**************************************************************************************/
+/* uop_sim_warmup_inst: fetches and warms one instruction of proc_id. Its ops
+   come in batches from frontend_fetch_ops, unless the model supplies the op to
+   fetch into (warmup_op_func), which takes them one at a time. */
+
+static void uop_sim_warmup_inst(uns proc_id, Uop_Sim_Ops* buf) {
+  Flag eom;
+  do {
+    Op* model_op = warmup_op(NULL);
+    Op** ops = &model_op;
+    uns count = 1;
+    if (model_op) {
+      frontend_fetch_op(proc_id, model_op);
+    } else {
+      uns ready = MAX2(frontend_ready_ops(proc_id), 1);
+      uop_sim_ops_reserve(buf, ready);
+      ops = buf->op_ptrs;
+      if (ready == 1 || !(count = frontend_fetch_ops(proc_id, ops, ready))) {
+        frontend_fetch_op(proc_id, ops[0]);
+        count = 1;
+      }
+    }
+
+    for (uns ii = 0; ii < count; ii++) {
+      Op* op = ops[ii];
+      uop_sim_fetched(proc_id, op);
+      model->warmup_func(op);
+      if (op->eom)
+        frontend_retire(op->proc_id, op->inst_uid);
+    }
+    eom = ops[count - 1]->eom;
+  } while (!eom);
+}
+
+/**************************************************************************************/
+/* uop_sim_warmup: the functional warmup of uop_sim. Every turn warms up to
+   WARMUP_BLOCK instructions of one core before moving to the next. The time
+   still advances once per instruction: the i-th instruction of each core's
+   block is warmed at the same time, as when the cores take turns instruction
+   by instruction (WARMUP_BLOCK 1). */
+
+static void uop_sim_warmup(void) {
+  ASSERTM(0, WARMUP_BLOCK > 0, "WARMUP_BLOCK must be positive\n");
+  Uop_Sim_Ops* bufs = (Uop_Sim_Ops*)calloc(NUM_CORES, sizeof(Uop_Sim_Ops));
+  Counter* block_times = (Counter*)malloc(WARMUP_BLOCK * sizeof(Counter));
+
+  while (TRUE) {
+    uns block = MIN2(WARMUP_BLOCK, WARMUP - inst_count[0]);
+    for (uns ii = 0; ii < block; ii++) {
+      block_times[ii] = sim_time;
+      warmup_advance_time();
+    }
+    Counter block_end_time = sim_time;
+
+    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+        continue;
+      for (uns ii = 0; ii < block && !retired_exit[proc_id]; ii++) {
+        sim_time = block_times[ii];
+        uop_sim_warmup_inst(proc_id, &bufs[proc_id]);
+      }
+    }
+    sim_time = block_end_time;
+
+    if (inst_count[0] >= WARMUP || retired_exit[0])
+      break;
+  }
+  warmup_done();
+  check_heartbeat(0, TRUE);
+
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    uop_sim_ops_free(&bufs[proc_id]);
+  free(bufs);
+  free(block_times);
+}
+
 void uop_sim() {
   ASSERTM(0, operating_mode != SIMULATION_MODE || !strcmp(SIM_LIMIT, "none"),
           "SIM_LIMIT does not work in uop simulation mode\n");
@@ -542,86 +797,148 @@ void uop_sim() {
           model->name);
   ASSERTM(0, NUM_CORES == 1 || !FAST_FORWARD_UNTIL_ADDR, "FAST_FORWARD_UNTIL_ADDR works only for single core\n");
 
-  Op op;
+  if (operating_mode == WARMUP_MODE && (SNAPSHOT_LOAD || WARMUP_SKIP_OPS)) {
+    ASSERTM(0, SNAPSHOT_LOAD || model->warmup_skip_func, "Model %s cannot warm up without ops\n", model->name);
+    uop_sim_skip(SNAPSHOT_LOAD ? NULL : model->warmup_skip_func);
+    return;
+  }
+  if (operating_mode == WARMUP_MODE) {
+    uop_sim_warmup();
+    return;
+  }
+  ASSERTM(0, operating_mode == SIMULATION_MODE, "Unknown simulation mode\n");
+
+  Op local_op;
   Table_Info table_info;
   Inst_Info inst_info;
-  op.table_info = &table_info;
-  op.inst_info = &inst_info;
-  op.mbp7_info = NULL;
+  local_op.table_info = &table_info;
+  local_op.inst_info = &inst_info;
+  local_op.mbp7_info = NULL;
+  Op* op = &local_op;
 
   Flag uop_sim_done = FALSE;
 
   while (!uop_sim_done) {
-    if (operating_mode == SIMULATION_MODE)
-      uop_sim_done = TRUE;
+    uop_sim_done = TRUE;
     for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
       if (DUMB_CORE_ON && DUMB_CORE == proc_id)
         continue;
       if (!retired_exit[proc_id]) {
         do {
-          frontend_fetch_op(proc_id, &op);
-
-          if (op.table_info->mem_type != NOT_MEM && op.oracle_info.va == 0) {
-            FATAL_ERROR(proc_id, "Access to 0x0\n");
-          }
-
-          if (DUMP_TRACE && DEBUG_RANGE_COND(proc_id))
-            print_func_op(&op);
-
-          op_count[proc_id]++;
-          if (op.eom)
-            inst_count[proc_id]++;
-          if (op.exit)
-            retired_exit[proc_id] = TRUE;
-          // fprintf(stderr, "op mode is %x, opexit is %d\n", operating_mode,
-          // op.exit);
-          ASSERTM(proc_id, !op.exit || operating_mode == SIMULATION_MODE, "Program ended before start of simulation\n");
-
-          switch (operating_mode) {
-            case WARMUP_MODE:
-              model->warmup_func(&op);
-              break;
-            case SIMULATION_MODE:
-              if (!sim_done[proc_id]) {
-                if (retired_exit[proc_id] || (INST_LIMIT && inst_count[proc_id] == inst_limit[proc_id])) {
-                  sim_done[proc_id] = TRUE;
-                  dump_stats(proc_id, TRUE, global_stat_array[proc_id], NUM_GLOBAL_STATS);
-                  check_heartbeat(proc_id, TRUE);
-                } else {
-                  uop_sim_done = FALSE;
-                  if (proc_id == 0)
-                    check_heartbeat(0, FALSE);
-                }
-              }
-              break;
-            default:
-              FATAL_ERROR(0, "Unknown simulation mode\n");
+          frontend_fetch_op(proc_id, op);
+          uop_sim_fetched(proc_id, op);
+
+          if (!sim_done[proc_id]) {
+            if (retired_exit[proc_id] || (INST_LIMIT && inst_count[proc_id] == inst_limit[proc_id])) {
+              sim_done[proc_id] = TRUE;
+              dump_stats(proc_id, TRUE, 0, NUM_GLOBAL_STATS);
+              check_heartbeat(proc_id, TRUE);
+            } else {
+              uop_sim_done = FALSE;
+              if (proc_id == 0)
+                check_heartbeat(0, FALSE);
+            }
           }
-          if (op.eom) {
-            frontend_retire(op.proc_id, op.inst_uid);
+          if (op->eom) {
+            frontend_retire(op->proc_id, op->inst_uid);
           }
-        } while (!uop_sim_done && !op.eom);
+        } while (!uop_sim_done && !op->eom);
       }
     }
-    switch (operating_mode) {
-      case WARMUP_MODE:
-        if (inst_count[0] == WARMUP || retired_exit[0]) {
-          uop_sim_done = TRUE;
-          check_heartbeat(0, TRUE);
-        }
-        // HACK that ensures that cache replacement works in warmup
-        do {
-          freq_advance_time();
-        } while (!freq_is_ready(FREQ_DOMAIN_L1));
-        sim_time = freq_time();
-        break;
-      default:
-        ASSERT(0, operating_mode == SIMULATION_MODE);
-        break;
-    }
   }
 }
 
+/**************************************************************************************/
+/* snapshot_warmup: saves or restores the state trained by the warmup. On
+   restore, the frontend must already be past the warmup instructions. */
+
+static void snapshot_warmup(const char* file_name, Flag save) {
+  ASSERTM(0, model->snapshot_func, "Model %s does not support snapshots\n", model->name);
+  Snapshot* snap = snapshot_open(file_name, save);
+  snapshot_section(snap, "SIM");
+  snapshot_check(snap, "WARMUP", WARMUP);
+  /* warmup advances the time per instruction, so the replacement timestamps
+     restored below are only consistent with the same time */
+  snapshot_check(snap, "sim_time", sim_time);
+  model->snapshot_func(snap);
+  snapshot_close(snap);
+}
+
+/**************************************************************************************/
+/* checkpoint_sim_state: the trace position, counters and time of a checkpoint.
+   A core's position is the instructions it warmed plus those it retired. */
+
+static void checkpoint_sim_state(Snapshot* snap, Counter* saved_time) {
+  snapshot_section(snap, "CHECKPOINT");
+  snapshot_check(snap, "WARMUP", WARMUP);
+  snapshot_check(snap, "NUM_CORES", NUM_CORES);
+  snapshot_data(snap, warmup_inst_count, sizeof(Counter) * NUM_CORES);
+  snapshot_data(snap, inst_count, sizeof(Counter) * NUM_CORES);
+  snapshot_data(snap, period_last_inst_count, sizeof(Counter) * NUM_CORES);
+  SNAPSHOT_VAR(snap, period_ID);
+  SNAPSHOT_VAR(snap, *saved_time);
+}
+
+/**************************************************************************************/
+/* checkpoint_save: saves the warmed structures, the trace position and the
+   stats to PREEMPT_CHECKPOINT. The ops in flight are dropped; the resumed run
+   fetches them again. The file is replaced only once complete. */
+
+static void checkpoint_save(void) {
+  char tmp_name[MAX_STR_LENGTH + 1];
+  snprintf(tmp_name, MAX_STR_LENGTH, "%s.tmp", PREEMPT_CHECKPOINT);
+  Counter saved_time = freq_time();
+  Snapshot* snap = snapshot_open(tmp_name, TRUE);
+  checkpoint_sim_state(snap, &saved_time);
+  model->snapshot_func(snap);
+  stats_snapshot(snap);
+  snapshot_close(snap);
+  int failed = rename(tmp_name, PREEMPT_CHECKPOINT);
+  ASSERTUM(0, !failed, "Could not rename %s to %s\n", tmp_name, PREEMPT_CHECKPOINT);
+
+  fprintf(mystdout, "** Checkpoint saved to %s at insts: { ", PREEMPT_CHECKPOINT);
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    fprintf(mystdout, "%lld ", inst_count[proc_id]);
+  fprintf(mystdout, "}\n");
+  fflush(mystdout);
+}
+
+/**************************************************************************************/
+/* checkpoint_resume: takes the place of the warmup, moving the frontend to the
+   checkpoint and restoring what checkpoint_save saved */
+
+static void checkpoint_resume(void) {
+  ASSERTM(0, model->snapshot_func, "Model %s does not support snapshots\n", model->name);
+  Counter saved_time;
+  Snapshot* snap = snapshot_open(PREEMPT_CHECKPOINT, FALSE);
+  checkpoint_sim_state(snap, &saved_time);
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    if (DUMB_CORE_ON && DUMB_CORE == proc_id)
+      continue;
+    Flag exited;
+    uns64 position = warmup_inst_count[proc_id] + inst_count[proc_id];
+    uns64 skipped = frontend_skip(proc_id, position, NULL, &exited);
+    ASSERTUM(proc_id, skipped == position && !exited, "Trace ended before checkpoint position %llu\n", position);
+    inst_count_fetched[proc_id] = inst_count[proc_id];
+    op_count[proc_id] = 1;
+  }
+  model->snapshot_func(snap);
+
+  reset_stats(FALSE);
+  freq_set_time(saved_time);
+  freq_reset_cycle_counts();
+  sim_time = freq_time();
+  period_last_cycle_count = 0;
+  stats_snapshot(snap);
+  snapshot_close(snap);
+
+  fprintf(mystdout, "** Resumed from checkpoint %s at insts: { ", PREEMPT_CHECKPOINT);
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    fprintf(mystdout, "%lld ", inst_count[proc_id]);
+  fprintf(mystdout, "}\n");
+  fflush(mystdout);
+}
+
 /**************************************************************************************/
 /* full_sim: This is the main loop for running in full simulation mode.*/
 
@@ -632,10 +949,22 @@ void full_sim() {
 
   /* perform initialization  */
   init_model(WARMUP_MODE);  // make sure this happens before init_op_pool
+  init_phase_done("warmup model");
 
-  if (WARMUP) {
+  ASSERTM(0, WARMUP || (!SNAPSHOT_SAVE && !SNAPSHOT_LOAD), "Warmup snapshots require WARMUP\n");
+  if (PREEMPT_CHECKPOINT && !access(PREEMPT_CHECKPOINT, R_OK)) {
+    operating_mode = WARMUP_MODE;
+    checkpoint_resume();
+    init_phase_done("resume");
+  } else if (WARMUP) {
     operating_mode = WARMUP_MODE;
     uop_sim();
+    if (SNAPSHOT_LOAD)
+      snapshot_warmup(SNAPSHOT_LOAD, FALSE);
+    if (SNAPSHOT_SAVE)
+      snapshot_warmup(SNAPSHOT_SAVE, TRUE);
+    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+      warmup_inst_count[proc_id] = inst_count[proc_id];
     reset_uop_mode_counters();
     reset_stats(FALSE);  // ignore stats accumulated during warmup
     /* The call below resets the cycle counts of all frequency
@@ -649,21 +978,26 @@ void full_sim() {
          code is not memory-aware and assumes that the first
          simulation cycle is cycle zero). */
     freq_reset_cycle_counts();
+    init_phase_done("warmup");
   }
 
   operating_mode = SIMULATION_MODE;
   init_model(operating_mode);
+  init_phase_done("model");
 
   if (PIPEVIEW)
     pipeview_init();
   if (MEMVIEW)
     memview_init();
+  power_intf_start();
 
   init_op_pool();
   unique_count = 1;
+  init_phase_done("op pool");
 
   sim_limit = trigger_create("SIM_LIMIT", SIM_LIMIT, TRIGGER_ONCE);
   clear_stats = trigger_create("CLEAR_STATS", CLEAR_STATS, TRIGGER_ONCE);
+  checkpoint_armed = PREEMPT_CHECKPOINT && model->snapshot_func;
 
   /* main loop */
   while (!trigger_fired(sim_limit)) {
@@ -687,9 +1021,19 @@ void full_sim() {
     check_heartbeat(0, FALSE);
 
     stat_trace_cycle();
+    stat_sample_cycle();
+    stat_live_cycle();
+    power_intf_cycle();
     if (trigger_fired(clear_stats)) {
       reset_stats(TRUE);
     }
+    if (checkpoint_requested) {
+      checkpoint_save();
+      checkpoint_requested = FALSE;
+      checkpoint_armed = FALSE;
+      for (proc_id = 0; proc_id < NUM_CORES; proc_id++)
+        retired_exit[proc_id] = TRUE;
+    }
 
     all_sim_done = TRUE;
     any_sim_done = FALSE;
@@ -714,19 +1058,19 @@ void full_sim() {
           print_eip_stats(proc_id);
         }
         if (PERIODIC_DUMP == FALSE) {
-          dump_stats(proc_id, TRUE, global_stat_array[proc_id], NUM_GLOBAL_STATS);
+          dump_stats(proc_id, TRUE, 0, NUM_GLOBAL_STATS);
         }
         sim_done[proc_id] = TRUE;
         any_sim_done = TRUE;
         check_heartbeat(proc_id, TRUE);
 
-        if (retired_exit[proc_id] && FRONTEND == FE_TRACE) {
+        if (retired_exit[proc_id] && FRONTEND == FE_TRACE && SIM_MODEL == CMP_MODEL) {
           set_last_sim_param(proc_id);
           // rerun the corresponding benchmark again.
           // (reset retired_exit and reached_exit)
           cmp_init_bogus_sim(proc_id);
         }
-      } else if (sim_done[proc_id] && retired_exit[proc_id]) {
+      } else if (sim_done[proc_id] && retired_exit[proc_id] && SIM_MODEL == CMP_MODEL) {
         ASSERTM(proc_id, FRONTEND == FE_TRACE, "Unhandled case: benchmark finished in execution-driven mode\n");
         // rerun the corresponding benchmark again.
         if (FRONTEND == FE_TRACE) {
@@ -752,6 +1096,9 @@ void full_sim() {
     model_table[DUMB_MODEL].done_func();
 
   stat_trace_done();
+  stat_sample_done();
+  stat_live_done();
+  bp_stream_done();
   if (PIPEVIEW)
     pipeview_done();
   memview_done();
@@ -762,7 +1109,7 @@ void full_sim() {
   for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
     if (!sim_done[proc_id]) {
       if (PERIODIC_DUMP == FALSE) {
-        dump_stats(proc_id, TRUE, global_stat_array[proc_id], NUM_GLOBAL_STATS);
+        dump_stats(proc_id, TRUE, 0, NUM_GLOBAL_STATS);
       }
       check_heartbeat(proc_id, TRUE);
     }
@@ -774,6 +1121,334 @@ void full_sim() {
   trigger_free(clear_stats);
 }
 
+/**************************************************************************************/
+/* sampling_cycle: simulate one cycle in detail during a sampling window */
+
+static inline void sampling_cycle(void) {
+  freq_advance_time();
+  sim_time = freq_time();
+  model->cycle_func();
+  cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[0]);
+  check_heartbeat(0, FALSE);
+  stat_trace_cycle();
+  stat_sample_cycle();
+  stat_live_cycle();
+  power_intf_cycle();
+  if (cycle_count % FORWARD_PROGRESS_INTERVAL == 0)
+    check_forward_progress(0);
+}
+
+/**************************************************************************************/
+/* sampling_warm: fetch the instructions before inst_count reaches limit without
+   simulating them, functionally warming caches and predictors if warm is set,
+   else skipping them in the frontend without ops. The pipeline must be empty. */
+
+static void sampling_warm(Counter limit, Flag warm) {
+  Op local_op;
+  Table_Info table_info;
+  Inst_Info inst_info;
+  local_op.table_info = &table_info;
+  local_op.inst_info = &inst_info;
+  local_op.mbp7_info = NULL;
+  Op* op;
+
+  if (!warm && inst_count[0] < limit && !retired_exit[0]) {
+    Flag exited;
+    inst_count[0] += frontend_skip(0, limit - inst_count[0], NULL, &exited);
+    retired_exit[0] = exited;
+  }
+
+  while (inst_count[0] < limit && !retired_exit[0]) {
+    do {
+      op = warmup_op(&local_op);
+      frontend_fetch_op(0, op);
+      if (op->table_info->mem_type != NOT_MEM && op->oracle_info.va == 0) {
+        FATAL_ERROR(0, "Access to 0x0\n");
+      }
+      if (op->exit)
+        retired_exit[0] = TRUE;
+      model->warmup_func(op);
+      if (op->eom) {
+        inst_count[0]++;
+        frontend_retire(op->proc_id, op->inst_uid);
+      }
+    } while (!op->eom);
+    warmup_advance_time();
+    check_heartbeat(0, FALSE);
+  }
+  warmup_done();
+
+  // the skipped time is not a lack of forward progress
+  cycle_count = freq_cycle_count(FREQ_DOMAIN_CORES[0]);
+  last_forward_progress[0] = cycle_count;
+}
+
+/**************************************************************************************/
+/* sampling_detail: simulate in detail until inst_count reaches limit */
+
+static void sampling_detail(Counter limit) {
+  while (inst_count[0] < limit && !retired_exit[0])
+    sampling_cycle();
+}
+
+/**************************************************************************************/
+/* sampling_measure: simulate the next length instructions in detail. Returns
+   FALSE if the program ended first. */
+
+static Flag sampling_measure(Counter length, Counter* insts, Counter* cycles) {
+  Counter start_inst = inst_count[0];
+  Counter start_cycle = cycle_count;
+  sampling_detail(start_inst + length);
+  *insts = inst_count[0] - start_inst;
+  *cycles = cycle_count - start_cycle;
+  return !retired_exit[0];
+}
+
+/**************************************************************************************/
+/* sampling_drain: stop fetching and simulate until every op has left the
+   pipeline, so that functional warming can resume at the next instruction */
+
+static void sampling_drain(void) {
+  decoupled_fe_set_drain(0, TRUE);
+  while (!retired_exit[0] && (op_pool_active_ops || !decoupled_fe_is_drained(0)))
+    sampling_cycle();
+  decoupled_fe_set_drain(0, FALSE);
+}
+
+/**************************************************************************************/
+/* sampling_periodic: Every SAMPLE_PERIOD instructions are functionally warmed
+   except for a detailed window at the end of the period, whose last
+   SAMPLE_LENGTH instructions are measured. Stops when the confidence interval
+   of the sampled CPI is narrow enough. */
+
+static void sampling_periodic(FILE* sample_file) {
+  ASSERTM(0, SAMPLE_LENGTH && SAMPLE_WARMUP + SAMPLE_LENGTH <= SAMPLE_PERIOD,
+          "SAMPLE_WARMUP + SAMPLE_LENGTH must be nonzero and fit in SAMPLE_PERIOD\n");
+  fprintf(sample_file, "# sample  start_inst  insts  cycles  cpi\n");
+
+  Counter limit = INST_LIMIT ? inst_limit[0] : MAX_CTR;
+  Counter period_start = 0;
+  uns num_samples = 0;
+  double cpi_mean = 0.0;
+  double cpi_m2 = 0.0;
+  double rel_error = 0.0;
+
+  while (!retired_exit[0] && period_start + SAMPLE_PERIOD <= limit) {
+    Counter window_start = period_start + SAMPLE_PERIOD - SAMPLE_WARMUP - SAMPLE_LENGTH;
+    period_start += SAMPLE_PERIOD;
+
+    sampling_warm(window_start, TRUE);
+    sampling_detail(inst_count[0] + SAMPLE_WARMUP);
+    Counter start_inst = inst_count[0];
+    Counter insts, cycles;
+    if (!sampling_measure(SAMPLE_LENGTH, &insts, &cycles))
+      break;  // a window cut short by the end of the program is not a sample
+
+    double cpi = (double)cycles / insts;
+    fprintf(sample_file, "%u %llu %llu %llu %.4f\n", num_samples, start_inst, insts, cycles, cpi);
+
+    // Welford's running mean and variance
+    num_samples++;
+    double delta = cpi - cpi_mean;
+    cpi_mean += delta / num_samples;
+    cpi_m2 += delta * (cpi - cpi_mean);
+    if (num_samples > 1)
+      rel_error = SAMPLE_CONFIDENCE_Z * sqrt(cpi_m2 / (num_samples - 1) / num_samples) / cpi_mean;
+
+    sampling_drain();
+    if (SAMPLE_TARGET_ERROR > 0 && num_samples >= MAX2(SAMPLE_MIN_SAMPLES, 2) && rel_error <= SAMPLE_TARGET_ERROR)
+      break;
+  }
+
+  fprintf(mystdout, "** Sampling: %u samples  CPI:%.4f +- %.2f%% (z=%.2f)  insts:%-10s  cycles:%-10s\n",
+          num_samples, cpi_mean, 100.0 * rel_error, SAMPLE_CONFIDENCE_Z, unsstr64(inst_count[0]),
+          unsstr64(cycle_count));
+}
+
+/**************************************************************************************/
+/* read_sample_regions: parse SAMPLE_REGIONS, one "start warmup length weight"
+   region per line, sorted by start */
+
+typedef struct Sample_Region_struct {
+  Counter start;   // first measured instruction
+  Counter warmup;  // instructions warmed before start
+  Counter length;  // measured instructions
+  double weight;
+} Sample_Region;
+
+static uns read_sample_regions(Sample_Region** regions) {
+  FILE* file = fopen(SAMPLE_REGIONS, "r");
+  ASSERTM(0, file, "Could not open SAMPLE_REGIONS file %s\n", SAMPLE_REGIONS);
+
+  uns num_regions = 0;
+  uns max_regions = 16;
+  *regions = (Sample_Region*)malloc(max_regions * sizeof(Sample_Region));
+  char line[MAX_STR_LENGTH + 1];
+  while (fgets(line, sizeof(line), file)) {
+    Sample_Region region;
+    int matched = sscanf(line, "%llu %llu %llu %lf", &region.start, &region.warmup, &region.length, &region.weight);
+    if (matched <= 0)
+      continue;  // blank or comment line
+    ASSERTM(0, matched == 4, "Malformed region in %s: %s", SAMPLE_REGIONS, line);
+    ASSERTM(0, region.length && region.warmup <= region.start && region.weight >= 0, "Invalid region in %s: %s",
+            SAMPLE_REGIONS, line);
+    if (num_regions) {
+      Sample_Region* prev = &(*regions)[num_regions - 1];
+      ASSERTM(0, region.start >= prev->start + prev->length, "Regions in %s must be sorted and disjoint: %s",
+              SAMPLE_REGIONS, line);
+    }
+    if (num_regions == max_regions) {
+      max_regions *= 2;
+      *regions = (Sample_Region*)realloc(*regions, max_regions * sizeof(Sample_Region));
+    }
+    (*regions)[num_regions++] = region;
+  }
+  fclose(file);
+  ASSERTM(0, num_regions, "No regions in %s\n", SAMPLE_REGIONS);
+  return num_regions;
+}
+
+/**************************************************************************************/
+/* sampling_regions: simulate each region of SAMPLE_REGIONS in order, e.g. the
+   SimPoints of a trace, reusing the warm state of the previous ones. Instructions
+   between regions are skipped, the warmup of a region is functionally warmed
+   except for its last SAMPLE_WARMUP instructions. Stats of region N are dumped
+   with the .roi.N suffix, the final stats cover all regions and the weighted
+   average of every stat goes to SAMPLE_FILE. */
+
+static void sampling_regions(FILE* sample_file) {
+  Sample_Region* regions;
+  uns num_regions = read_sample_regions(&regions);
+  double* weighted_stats = (double*)calloc(NUM_GLOBAL_STATS, sizeof(double));
+  double total_weight = 0.0;
+  double weighted_cpi = 0.0;
+  uns done_regions = 0;
+
+  fprintf(sample_file, "# region  start_inst  insts  cycles  cpi  weight\n");
+
+  for (; done_regions < num_regions; done_regions++) {
+    Sample_Region* region = &regions[done_regions];
+    Counter detail_warmup = MIN2(SAMPLE_WARMUP, region->warmup);
+    sampling_warm(region->start - region->warmup, FALSE);
+    sampling_warm(region->start - detail_warmup, TRUE);
+    sampling_detail(region->start);
+
+    reset_stats(FALSE);
+    period_last_cycle_count = cycle_count;
+    period_last_inst_count[0] = inst_count[0];
+    roi_dump_began = TRUE;
+    roi_dump_ID = done_regions;
+    Counter start_inst = inst_count[0];
+    Counter insts, cycles;
+    Flag complete = sampling_measure(region->length, &insts, &cycles);
+    // dump_stats folds the interval counts into the totals, so read them first
+    for (uns ii = 0; complete && ii < NUM_GLOBAL_STATS; ii++) {
+      Stat* stat = &global_stat_array[0][ii];
+      weighted_stats[ii] += region->weight *
+                            (stat->type == FLOAT_TYPE_STAT ? GET_STAT_VALUE(0, ii) : (double)GET_STAT_EVENT(0, ii));
+    }
+    dump_stats(0, TRUE, 0, NUM_GLOBAL_STATS);
+    roi_dump_began = FALSE;
+    if (!complete) {
+      fprintf(mystdout, "** Program ended in region %u, skipping the remaining regions\n", done_regions);
+      break;
+    }
+
+    double cpi = (double)cycles / insts;
+    fprintf(sample_file, "%u %llu %llu %llu %.4f %.6f\n", done_regions, start_inst, insts, cycles, cpi,
+            region->weight);
+    total_weight += region->weight;
+    weighted_cpi += region->weight * cpi;
+
+    sampling_drain();
+  }
+  // leave only the regions in the final stats
+  reset_stats(FALSE);
+
+  if (total_weight > 0) {
+    weighted_cpi /= total_weight;
+    fprintf(sample_file, "# weighted stats over %u regions\n", done_regions);
+    for (uns ii = 0; ii < NUM_GLOBAL_STATS; ii++) {
+      Stat* stat = &global_stat_array[0][ii];
+      if (stat->type != LINE_TYPE_STAT)
+        fprintf(sample_file, "%s %.6f\n", stat->name, weighted_stats[ii] / total_weight);
+    }
+  }
+  fprintf(mystdout, "** Regions: %u of %u simulated  weighted CPI:%.4f  insts:%-10s  cycles:%-10s\n", done_regions,
+          num_regions, weighted_cpi, unsstr64(inst_count[0]), unsstr64(cycle_count));
+
+  free(weighted_stats);
+  free(regions);
+}
+
+/**************************************************************************************/
+/* sampling_sim: This is the main loop for running in sampling simulation mode,
+   either periodic or over the regions listed in SAMPLE_REGIONS. */
+
+void sampling_sim() {
+  ASSERTM(0, NUM_CORES == 1, "Sampling simulation works only for single core\n");
+  ASSERTM(0, !(SIM_MODEL != DUMB_MODEL && DUMB_CORE_ON), "Sampling simulation does not support DUMB_CORE_ON\n");
+
+  init_model(WARMUP_MODE);  // make sure this happens before init_op_pool
+  ASSERTM(0, model->warmup_func, "Model %s does not have a warmup function\n", model->name);
+  operating_mode = SIMULATION_MODE;
+  init_model(operating_mode);
+  init_phase_done("model");
+
+  if (PIPEVIEW)
+    pipeview_init();
+  if (MEMVIEW)
+    memview_init();
+  power_intf_start();
+
+  init_op_pool();
+  unique_count = 1;
+  init_phase_done("op pool");
+
+  FILE* sample_file = file_tag_fopen(OUTPUT_DIR, SAMPLE_FILE, "w");
+  ASSERTM(0, sample_file, "Could not open sample file %s\n", SAMPLE_FILE);
+  if (SAMPLE_REGIONS)
+    sampling_regions(sample_file);
+  else
+    sampling_periodic(sample_file);
+  fflush(mystdout);
+  fclose(sample_file);
+
+  if (model->done_func)
+    model->done_func();
+
+  stat_trace_done();
+  stat_sample_done();
+  stat_live_done();
+  bp_stream_done();
+  if (PIPEVIEW)
+    pipeview_done();
+  memview_done();
+  power_intf_done();
+  frontend_done(retired_exit);
+  ramulator_finish();
+
+  dump_stats(0, TRUE, 0, NUM_GLOBAL_STATS);
+  sim_done[0] = TRUE;
+  check_heartbeat(0, TRUE);
+}
+
+/**************************************************************************************/
+/* dram_replay_sim: runs only the DRAM model, fed from a request stream that an
+   earlier run recorded with RAMULATOR_RECORD_FILE */
+
+void dram_replay_sim() {
+  ramulator_replay();
+
+  stat_trace_done();
+  stat_sample_done();
+  stat_live_done();
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    dump_stats(proc_id, TRUE, 0, NUM_GLOBAL_STATS);
+    sim_done[proc_id] = TRUE;
+  }
+}
+
 /**************************************************************************************/
 #ifdef ENABLE_PT_MEMTRACE
 /* trace_bbv: This is the main loop for extracting basic block vectors from the trace.*/
@@ -37,6 +37,8 @@
 enum sim_mode_enum {
   UOP_SIM_MODE,
   FULL_SIM_MODE,
+  SAMPLING_SIM_MODE,
+  DRAM_REPLAY_SIM_MODE,
 #ifdef ENABLE_PT_MEMTRACE
   TRACE_BBV_MODE,
   TRACE_BBV_DISTRIBUTED_MODE,
@@ -65,13 +67,23 @@ extern Counter* inst_limit;
 /* Prototypes */
 
 void init_global(char*[], char*[]);
+/* Allocates the per-core instruction and op counters; called by init_global */
+void init_global_counter(void);
 void uop_sim(void);
 void monitor_sim(void);
 void sampling_sim(void);
 void full_sim(void);
-void handle_SIGINT(int);
+/* Replays a recorded DRAM request stream (RAMULATOR_REPLAY_FILE) into Ramulator alone */
+void dram_replay_sim(void);
+void handle_exit_signal(int);
 void close_output_streams(void);
 
+/* Wall time of the initialization phases, printed with PRINT_INIT_TIMES:
+   init_phase_done reports the time since the previous call or since
+   init_phase_start */
+void init_phase_start(void);
+void init_phase_done(const char* phase);
+
 #ifdef ENABLE_PT_MEMTRACE
 void extract_basic_block_vectors(void);
 #endif
@@ -37,6 +37,15 @@
 /* Defines */
 #define EXEC_PORTS_MAX_NAME_LEN 32
 
+/* Pipeline widths that the C++ stages instantiate specialized loops for when
+   built with SCARAB_SPECIALIZE_STAGE_WIDTHS (the widths of the shipped core
+   configs). Any other width falls back to the runtime-bounded loop. */
+#ifdef SPECIALIZE_STAGE_WIDTHS
+#define STAGE_SPECIALIZED_WIDTHS(X) X(4) X(5) X(6) X(8)
+#else
+#define STAGE_SPECIALIZED_WIDTHS(X)
+#endif
+
 /**************************************************************************************/
 /* Types */
 
@@ -64,6 +73,43 @@ typedef struct Stage_Data_struct {
   Op** ops;         /* array of ops in the stage */
 } Stage_Data;
 
+/**************************************************************************************/
+/* Pipelined stage latches, sds[0] the last (oldest) and sds[depth - 1] the
+   first. Bit ii of an occupancy mask is set if sds[ii] holds ops, so depth is
+   at most 64. */
+
+#define STAGE_LATCHES_MAX_DEPTH 64
+
+static inline uns64 stage_latches_occupancy(const Stage_Data* sds, uns depth) {
+  uns64 occupied = 0;
+  for (uns ii = 0; ii < depth; ii++)
+    occupied |= (uns64)(sds[ii].op_count != 0) << ii;
+  return occupied;
+}
+
+/* TRUE if no stage is empty below an occupied one, so shifting moves nothing */
+static inline Flag stage_latches_packed(uns64 occupied) {
+  return (occupied & (occupied + 1)) == 0;
+}
+
+/* Move every stage above the lowest empty one down by one, as a stage that
+   is empty takes the ops of the stage above it each cycle. Returns the new
+   occupancy. */
+static inline uns64 stage_latches_shift(Stage_Data* sds, uns depth, uns64 occupied) {
+  if (stage_latches_packed(occupied))
+    return occupied;
+  uns hole = __builtin_ctzll(~occupied);
+  for (uns ii = hole; ii < depth - 1; ii++) {
+    Op** temp = sds[ii].ops;
+    sds[ii].ops = sds[ii + 1].ops;
+    sds[ii + 1].ops = temp;
+    sds[ii].op_count = sds[ii + 1].op_count;
+    sds[ii + 1].op_count = 0;
+  }
+  uns64 below = (1ull << hole) - 1;
+  return (occupied & below) | ((occupied >> 1) & ~below);
+}
+
 /**************************************************************************************/
 
 #endif /* #ifndef __STAGE_H__ */
@@ -0,0 +1,267 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : stat_live.c
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Live stats page. The stats in LIVE_STATS are read through a
+ *                stat monitor into a file mapped shared in OUTPUT_DIR. A reader
+ *                asks for a snapshot by bumping the request word; the
+ *                simulation only looks at that word every LIVE_STATS_POLL
+ *                cycles and writes the page only when it has changed, so an
+ *                unread page costs nothing but the poll.
+ ***************************************************************************************/
+
+#include "stat_live.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_vars.h"
+
+#include "core.param.h"
+#include "general.param.h"
+
+#include "debug/host_prof.h"
+#include "stat_mon.h"
+#include "stat_trace.h"
+#include "statistics.h"
+
+/**************************************************************************************/
+/* Page Format */
+
+/* All fields are in host byte order. The page starts with a Stat_Live_Header,
+   followed by
+     uns64 inst_count[num_cores]
+     per stat: uns32 type, name (an uns32 length followed by the characters)
+   and, at data_offset, per stat
+     uns64 total[num_cores], change[num_cores] (doubles for float stats)
+   where the change is since the previous snapshot. To read it, write any new
+   value into request and wait for served to equal it; the snapshot is
+   consistent if seq is even and unchanged across the copy.
+   bin/scarab_globals/scarab_stats_bin.py reads the page. */
+
+#define STAT_LIVE_MAGIC "SCARABLV"
+#define STAT_LIVE_VERSION 1
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Stat_Live_Header_struct {
+  char magic[8];
+  uns32 version;
+  uns32 num_cores;
+  uns32 num_stats;
+  uns32 data_offset;
+  uns64 request;  // written by readers
+  uns64 served;   // the request the current snapshot answers
+  uns64 seq;      // odd while a snapshot is written
+  uns64 done;     // the simulation has ended and the snapshot is final
+  uns64 cycle_count;
+  uns64 sim_time;
+  uns64 host_ns;  // host time since stat_live_init
+} Stat_Live_Header;
+
+/**************************************************************************************/
+/* Global Variables */
+
+Counter stat_live_next = MAX_CTR;
+
+static Stat_Mon* stat_mon;
+static uns* stat_indices;
+static uns num_stats;
+static Stat_Live_Header* page;
+static size_t page_size;
+static uns64* page_inst_count;
+static uns64* page_data;
+static uns64 start_ns;
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static Flag live_stat_selected(const Stat* stat, char* const* names, uns num_names);
+static void write_snapshot(void);
+
+/**************************************************************************************/
+/* stat_live_init: */
+
+void stat_live_init(void) {
+  if (!LIVE_STATS)
+    return;
+  ASSERTM(0, LIVE_STATS_POLL > 0, "LIVE_STATS_POLL must be positive\n");
+
+  /* select the stats named directly or through their file */
+  uns num_names = num_tokens(LIVE_STATS, DELIMITERS);
+  char** names = (char**)malloc(num_names * sizeof(char*));
+  char* names_str = strdup(LIVE_STATS);
+  char* name = strtok(names_str, DELIMITERS);
+  for (uns ii = 0; name; ii++, name = strtok(NULL, DELIMITERS))
+    names[ii] = name;
+
+  stat_indices = (uns*)malloc(NUM_GLOBAL_STATS * sizeof(uns));
+  num_stats = 0;
+  for (uns ii = 0; ii < NUM_GLOBAL_STATS; ii++) {
+    if (live_stat_selected(&global_stat_array[0][ii], names, num_names))
+      stat_indices[num_stats++] = ii;
+  }
+  ASSERTM(0, num_stats, "No stats match LIVE_STATS '%s'\n", LIVE_STATS);
+  for (uns ii = 0; ii < num_names; ii++) {
+    Flag found = FALSE;
+    for (uns jj = 0; jj < num_stats && !found; jj++) {
+      const Stat* stat = &global_stat_array[0][stat_indices[jj]];
+      found = !strcmp(stat->name, names[ii]) || !strcmp(stat->file_name, names[ii]);
+    }
+    if (!found)
+      WARNINGU(0, "LIVE_STATS entry '%s' matches no stat\n", names[ii]);
+  }
+  free(names);
+  free(names_str);
+  stat_mon = stat_mon_create_from_array(stat_indices, num_stats);
+
+  /* size the page */
+  size_t names_size = 0;
+  for (uns ii = 0; ii < num_stats; ii++)
+    names_size += 2 * sizeof(uns32) + strlen(global_stat_array[0][stat_indices[ii]].name);
+  size_t data_offset = sizeof(Stat_Live_Header) + NUM_CORES * sizeof(uns64) + names_size;
+  data_offset = (data_offset + 7) & ~(size_t)7;
+  page_size = data_offset + (size_t)num_stats * NUM_CORES * 2 * sizeof(uns64);
+
+  char buf[MAX_STR_LENGTH + 1];
+  snprintf(buf, MAX_STR_LENGTH, "%s/%s%s", OUTPUT_DIR, FILE_TAG, LIVE_STATS_FILE);
+  int fd = open(buf, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  ASSERTUM(0, fd >= 0, "Could not open %s\n", buf);
+  int failed = ftruncate(fd, page_size);
+  ASSERTUM(0, !failed, "Could not size %s\n", buf);
+  page = (Stat_Live_Header*)mmap(NULL, page_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ASSERTM(0, page != MAP_FAILED, "Could not map %s\n", buf);
+  close(fd);
+
+  /* the header and names never change */
+  page_inst_count = (uns64*)(page + 1);
+  page_data = (uns64*)((char*)page + data_offset);
+  char* pos = (char*)(page_inst_count + NUM_CORES);
+  for (uns ii = 0; ii < num_stats; ii++) {
+    const Stat* stat = &global_stat_array[0][stat_indices[ii]];
+    uns32 meta[2] = {stat->type, strlen(stat->name)};
+    memcpy(pos, meta, sizeof(meta));
+    memcpy(pos + sizeof(meta), stat->name, meta[1]);
+    pos += sizeof(meta) + meta[1];
+  }
+  page->version = STAT_LIVE_VERSION;
+  page->num_cores = NUM_CORES;
+  page->num_stats = num_stats;
+  page->data_offset = data_offset;
+  start_ns = host_prof_clock_ns();
+  write_snapshot();
+  // readers only trust the page once the magic is in place
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(page->magic, STAT_LIVE_MAGIC, sizeof(page->magic));
+
+  stat_live_next = cycle_count + LIVE_STATS_POLL;
+}
+
+/**************************************************************************************/
+/* stat_live_poll: */
+
+void stat_live_poll(void) {
+  uns64 request = __atomic_load_n(&page->request, __ATOMIC_ACQUIRE);
+  if (request != page->served) {
+    write_snapshot();
+    __atomic_store_n(&page->served, request, __ATOMIC_RELEASE);
+  }
+  while (stat_live_next <= cycle_count)
+    stat_live_next += LIVE_STATS_POLL;
+}
+
+/**************************************************************************************/
+/* stat_live_done: */
+
+void stat_live_done(void) {
+  if (!LIVE_STATS)
+    return;
+
+  write_snapshot();
+  __atomic_store_n(&page->done, TRUE, __ATOMIC_RELEASE);
+  __atomic_store_n(&page->served, __atomic_load_n(&page->request, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+  stat_live_next = MAX_CTR;
+  munmap(page, page_size);
+  page = NULL;
+  stat_mon_free(stat_mon);
+  free(stat_indices);
+}
+
+/**************************************************************************************/
+/* live_stat_selected: a stat is selected by its name or its file (e.g.
+   host_prof.stat.def); whole files leave out their separator lines */
+
+static Flag live_stat_selected(const Stat* stat, char* const* names, uns num_names) {
+  for (uns ii = 0; ii < num_names; ii++) {
+    if (!strcmp(stat->name, names[ii]))
+      return TRUE;
+    if (stat->type != LINE_TYPE_STAT && !strcmp(stat->file_name, names[ii]))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+/**************************************************************************************/
+/* write_snapshot: */
+
+static void write_snapshot(void) {
+  __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  page->cycle_count = cycle_count;
+  page->sim_time = sim_time;
+  page->host_ns = host_prof_clock_ns() - start_ns;
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    page_inst_count[proc_id] = inst_count[proc_id];
+
+  uns64* data = page_data;
+  for (uns ii = 0; ii < num_stats; ii++) {
+    uns stat_idx = stat_indices[ii];
+    if (global_stat_array[0][stat_idx].type == FLOAT_TYPE_STAT) {
+      for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+        double total = GET_TOTAL_STAT_VALUE(proc_id, stat_idx);
+        double change = stat_mon_get_value(stat_mon, proc_id, stat_idx);
+        memcpy(&data[proc_id], &total, sizeof(uns64));
+        memcpy(&data[NUM_CORES + proc_id], &change, sizeof(uns64));
+      }
+    } else {
+      for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+        data[proc_id] = GET_TOTAL_STAT_EVENT(proc_id, stat_idx);
+        data[NUM_CORES + proc_id] = stat_mon_get_count(stat_mon, proc_id, stat_idx);
+      }
+    }
+    data += 2 * NUM_CORES;
+  }
+  stat_mon_reset(stat_mon);
+
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&page->seq, page->seq + 1, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,61 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : stat_live.h
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Live stats page: the current values of selected stats in a
+ *                shared-memory file that other processes can read while the
+ *                simulation runs
+ ***************************************************************************************/
+
+#ifndef __STAT_LIVE_H__
+#define __STAT_LIVE_H__
+
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+
+/**************************************************************************************/
+/* Global Variables */
+
+/* the next cycle to look for a request, MAX_CTR while the page is off */
+extern Counter stat_live_next;
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Create the page and its stat monitor */
+void stat_live_init(void);
+
+/* Answer a pending request, if any, and advance stat_live_next */
+void stat_live_poll(void);
+
+/* Write the final values and mark the page done */
+void stat_live_done(void);
+
+/* Call every cycle. Cycles between polls only do this compare. */
+static inline void stat_live_cycle(void) {
+  if (__builtin_expect(cycle_count >= stat_live_next, 0))
+    stat_live_poll();
+}
+
+#endif  // __STAT_LIVE_H__
@@ -38,13 +38,6 @@
 /**************************************************************************************/
 /* Types */
 
-typedef struct Stat_Datum_struct {
-  union {
-    Counter count;
-    double value;
-  };
-} Stat_Datum;
-
 typedef struct Stat_Info_struct {
   Stat_Enum stat_idx; /* index of the stat */
   /* value of the stat at the last reset (for each core) */
@@ -54,6 +47,10 @@ typedef struct Stat_Info_struct {
 struct Stat_Mon_struct {
   Stat_Info* stat_infos;
   uns num_stats;
+  /* stat_idx to stat_infos slot: a range monitor is offset by its first
+     stat, an array monitor looks the slot up (-1 if not monitored) */
+  uns first_stat_idx;
+  int* slots;
 };
 
 /**************************************************************************************/
@@ -69,8 +66,14 @@ Stat_Mon* stat_mon_create_from_array(uns* stat_idx_array, uns num) {
   Stat_Mon* mon = malloc(sizeof(Stat_Mon));
   mon->num_stats = num;
   mon->stat_infos = malloc(num * sizeof(Stat_Info));
+  mon->first_stat_idx = 0;
+  mon->slots = malloc(NUM_GLOBAL_STATS * sizeof(int));
+  for (uns i = 0; i < NUM_GLOBAL_STATS; i++)
+    mon->slots[i] = -1;
   for (uns i = 0; i < num; i++) {
     init_stat_info(&mon->stat_infos[i], stat_idx_array[i]);
+    if (mon->slots[stat_idx_array[i]] < 0)
+      mon->slots[stat_idx_array[i]] = i;
   }
   stat_mon_reset(mon);
   return mon;
@@ -85,6 +88,8 @@ Stat_Mon* stat_mon_create_from_range(uns first_stat_idx, uns last_stat_idx) {
   Stat_Mon* mon = malloc(sizeof(Stat_Mon));
   mon->num_stats = last_stat_idx - first_stat_idx + 1;
   mon->stat_infos = malloc(mon->num_stats * sizeof(Stat_Info));
+  mon->first_stat_idx = first_stat_idx;
+  mon->slots = NULL;
   for (uns i = 0; i < mon->num_stats; i++) {
     init_stat_info(&mon->stat_infos[i], first_stat_idx + i);
   }
@@ -101,7 +106,7 @@ Counter stat_mon_get_count(Stat_Mon* mon, uns proc_id, uns stat_idx) {
   Stat* stat = &global_stat_array[proc_id][stat_idx];
   ASSERT(proc_id, stat->type != FLOAT_TYPE_STAT);
   Stat_Info* info = find_stat_info(mon, stat_idx);
-  return stat->count + stat->total_count - info->last_data[proc_id].count;
+  return GET_TOTAL_STAT_EVENT(proc_id, stat_idx) - info->last_data[proc_id].count;
 }
 
 /**************************************************************************************/
@@ -113,7 +118,36 @@ double stat_mon_get_value(Stat_Mon* mon, uns proc_id, uns stat_idx) {
   Stat* stat = &global_stat_array[proc_id][stat_idx];
   ASSERT(proc_id, stat->type == FLOAT_TYPE_STAT);
   Stat_Info* info = find_stat_info(mon, stat_idx);
-  return stat->value + stat->total_value - info->last_data[proc_id].value;
+  return GET_TOTAL_STAT_VALUE(proc_id, stat_idx) - info->last_data[proc_id].value;
+}
+
+/**************************************************************************************/
+/* stat_mon_num_stats: */
+
+uns stat_mon_num_stats(Stat_Mon* mon) {
+  return mon->num_stats;
+}
+
+/**************************************************************************************/
+/* stat_mon_stat_idx: */
+
+uns stat_mon_stat_idx(Stat_Mon* mon, uns slot) {
+  ASSERT(0, slot < mon->num_stats);
+  return mon->stat_infos[slot].stat_idx;
+}
+
+/**************************************************************************************/
+/* stat_mon_get_all: */
+
+void stat_mon_get_all(Stat_Mon* mon, uns proc_id, Stat_Datum* deltas) {
+  ASSERT(0, proc_id < NUM_CORES);
+  for (uns i = 0; i < mon->num_stats; i++) {
+    Stat_Info* info = &mon->stat_infos[i];
+    if (global_stat_array[proc_id][info->stat_idx].type == FLOAT_TYPE_STAT)
+      deltas[i].value = GET_TOTAL_STAT_VALUE(proc_id, info->stat_idx) - info->last_data[proc_id].value;
+    else
+      deltas[i].count = GET_TOTAL_STAT_EVENT(proc_id, info->stat_idx) - info->last_data[proc_id].count;
+  }
 }
 
 /**************************************************************************************/
@@ -130,9 +164,9 @@ void stat_mon_reset(Stat_Mon* mon) {
     for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
       Stat* stat = &global_stat_array[proc_id][info->stat_idx];
       if (stat->type == FLOAT_TYPE_STAT) {
-        info->last_data[proc_id].value = stat->value + stat->total_value;
+        info->last_data[proc_id].value = GET_TOTAL_STAT_VALUE(proc_id, info->stat_idx);
       } else {
-        info->last_data[proc_id].count = stat->count + stat->total_count;
+        info->last_data[proc_id].count = GET_TOTAL_STAT_EVENT(proc_id, info->stat_idx);
       }
     }
   }
@@ -146,6 +180,7 @@ void stat_mon_free(Stat_Mon* mon) {
     free(mon->stat_infos[i].last_data);
   }
   free(mon->stat_infos);
+  free(mon->slots);
   free(mon);
 }
 
@@ -153,14 +188,10 @@ void stat_mon_free(Stat_Mon* mon) {
 /* find_stat_info: */
 
 static Stat_Info* find_stat_info(Stat_Mon* mon, uns stat_idx) {
-  /* linear search is a little slow, but stat monitors are not
-     supposed to be used often, so it should be a minor perf hit */
-  for (uns i = 0; i < mon->num_stats; i++) {
-    if (mon->stat_infos[i].stat_idx == stat_idx) {
-      return &mon->stat_infos[i];
-    }
-  }
-  FATAL_ERROR(0, "Stat %s not in stat monitor\n", global_stat_array[0][stat_idx].name);
+  uns slot = mon->slots ? (uns)mon->slots[stat_idx] : stat_idx - mon->first_stat_idx;
+  if (slot >= mon->num_stats)
+    FATAL_ERROR(0, "Stat %s not in stat monitor\n", global_stat_array[0][stat_idx].name);
+  return &mon->stat_infos[slot];
 }
 
 /**************************************************************************************/
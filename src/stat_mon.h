@@ -38,6 +38,15 @@
 struct Stat_Mon_struct;
 typedef struct Stat_Mon_struct Stat_Mon;
 
+/**************************************************************************************/
+/* Types */
+
+/* A stat's change over an interval: value for float stats, else count */
+typedef union Stat_Datum_union {
+  Counter count;
+  double value;
+} Stat_Datum;
+
 /**************************************************************************************/
 /* Prototypes */
 
@@ -53,6 +62,15 @@ Counter stat_mon_get_count(Stat_Mon* stat_mon, uns proc_id, uns stat_idx);
 /* Get the value of a stat (for float stats) since last reset */
 double stat_mon_get_value(Stat_Mon* stat_mon, uns proc_id, uns stat_idx);
 
+/* Number of stats in a monitor and the stat index in each slot. Slots are
+   in the order of the array, or of the range, the monitor was created from. */
+uns stat_mon_num_stats(Stat_Mon* stat_mon);
+uns stat_mon_stat_idx(Stat_Mon* stat_mon, uns slot);
+
+/* Get the change of every stat of a core since last reset, in one pass, into
+   deltas[stat_mon_num_stats()] */
+void stat_mon_get_all(Stat_Mon* stat_mon, uns proc_id, Stat_Datum* deltas);
+
 /* Start a new interval in a stat monitor */
 void stat_mon_reset(Stat_Mon* stat_mon);
 
@@ -0,0 +1,319 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : stat_sample.c
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Binary time series of selected stats. Every STAT_SAMPLE_INTERVAL
+ the change of each stat in STATS_TO_SAMPLE since the previous sample is read
+ through a stat monitor into an in-memory block. Full blocks are written out by a
+ background thread while the simulator fills the other block.
+ ***************************************************************************************/
+
+#include "stat_sample.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "globals/assert.h"
+#include "globals/global_defs.h"
+#include "globals/global_vars.h"
+
+#include "core.param.h"
+#include "general.param.h"
+
+#include "stat_mon.h"
+#include "stat_trace.h"
+
+/**************************************************************************************/
+/* Stream Format */
+
+/* All fields are in host byte order. The stream starts with a header:
+     "SCARABSS", uns32 version, uns32 num_cores, uns32 num_stats, interval spec
+     per stat: uns32 type, name
+   (strings are an uns32 length followed by the characters), followed by blocks:
+     uns32 num_samples, then num_samples samples of
+       uns64 clock, cycle_count, inst_count[num_cores],
+             value[num_stats][num_cores]
+   where each value is the change since the previous sample (a double for
+   float stats). bin/scarab_globals/scarab_stats_bin.py reads the stream. */
+
+#define STAT_SAMPLE_MAGIC "SCARABSS"
+#define STAT_SAMPLE_VERSION 1
+
+/**************************************************************************************/
+/* Types */
+
+typedef struct Stat_Sample_Block_struct {
+  uns64* data;
+  uns num_samples;
+  Flag full;  // handed to the writer thread and not written yet
+} Stat_Sample_Block;
+
+/**************************************************************************************/
+/* Global Variables */
+
+uns stat_sample_clock_proc = 0;
+Stat_Enum stat_sample_clock_stat = NODE_CYCLE;
+Counter stat_sample_next = MAX_CTR;
+
+static Stat_Mon* stat_mon;
+static uns* stat_indices;
+static uns num_stats;
+static uns sample_width;  // uns64 words per sample
+static Counter interval;
+static FILE* file;
+
+/* the simulator fills one block while the writer thread drains the other */
+static Stat_Sample_Block blocks[2];
+static uns cur_block;
+static pthread_t writer;
+static pthread_mutex_t mutex;
+static pthread_cond_t cond;
+static Flag writer_done;
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static void parse_interval(const char* spec);
+static void write_str(const char* str);
+static void submit_block(void);
+static void* writer_main(void* arg);
+
+/**************************************************************************************/
+/* stat_sample_init: */
+
+void stat_sample_init(void) {
+  if (!STATS_TO_SAMPLE)
+    return;
+  ASSERTM(0, STAT_SAMPLE_BLOCK > 0, "STAT_SAMPLE_BLOCK must be positive\n");
+
+  /* parse the stats to sample */
+  num_stats = num_tokens(STATS_TO_SAMPLE, DELIMITERS);
+  stat_indices = (uns*)malloc(num_stats * sizeof(uns));
+  char* stats_str = strdup(STATS_TO_SAMPLE);
+  char* stat_name = strtok(stats_str, DELIMITERS);
+  uns ii = 0;
+  while (stat_name) {
+    Stat_Enum stat_idx = get_stat_idx(stat_name);
+    ASSERTM(0, stat_idx < NUM_GLOBAL_STATS, "Stat %s not found\n", stat_name);
+    stat_indices[ii++] = stat_idx;
+    stat_name = strtok(NULL, DELIMITERS);
+  }
+  ASSERT(0, ii == num_stats);
+  free(stats_str);
+
+  parse_interval(STAT_SAMPLE_INTERVAL);
+  stat_mon = stat_mon_create_from_array(stat_indices, num_stats);
+
+  sample_width = 2 + NUM_CORES + num_stats * NUM_CORES;
+  for (uns jj = 0; jj < 2; jj++) {
+    blocks[jj].data = (uns64*)malloc(STAT_SAMPLE_BLOCK * sample_width * sizeof(uns64));
+    blocks[jj].num_samples = 0;
+    blocks[jj].full = FALSE;
+  }
+  cur_block = 0;
+
+  /* open the stream and write the header */
+  char buf[MAX_STR_LENGTH + 1];
+  snprintf(buf, MAX_STR_LENGTH, "%s/%s%s", OUTPUT_DIR, FILE_TAG, STAT_SAMPLE_FILE);
+  file = fopen(buf, "wb");
+  ASSERTM(0, file, "Could not open %s\n", buf);
+
+  uns32 head[3] = {STAT_SAMPLE_VERSION, NUM_CORES, num_stats};
+  fwrite(STAT_SAMPLE_MAGIC, 1, strlen(STAT_SAMPLE_MAGIC), file);
+  fwrite(head, sizeof(uns32), 3, file);
+  write_str(STAT_SAMPLE_INTERVAL);
+  for (ii = 0; ii < num_stats; ii++) {
+    Stat* stat = &global_stat_array[0][stat_indices[ii]];
+    uns32 type = stat->type;
+    fwrite(&type, sizeof(type), 1, file);
+    write_str(stat->name);
+  }
+
+  writer_done = FALSE;
+  pthread_mutex_init(&mutex, NULL);
+  pthread_cond_init(&cond, NULL);
+  int err = pthread_create(&writer, NULL, writer_main, NULL);
+  ASSERTM(0, !err, "Could not create the stat sample writer thread (%d)\n", err);
+
+  stat_sample_next = GET_TOTAL_STAT_EVENT(stat_sample_clock_proc, stat_sample_clock_stat) + interval;
+}
+
+/**************************************************************************************/
+/* stat_sample_take: */
+
+void stat_sample_take(void) {
+  Counter clock = GET_TOTAL_STAT_EVENT(stat_sample_clock_proc, stat_sample_clock_stat);
+  Stat_Sample_Block* block = &blocks[cur_block];
+  uns64* sample = &block->data[block->num_samples * sample_width];
+  uns ii = 0;
+
+  sample[ii++] = clock;
+  sample[ii++] = cycle_count;
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    sample[ii++] = inst_count[proc_id];
+  for (uns jj = 0; jj < num_stats; jj++) {
+    uns stat_idx = stat_indices[jj];
+    Flag is_float = global_stat_array[0][stat_idx].type == FLOAT_TYPE_STAT;
+    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+      if (is_float) {
+        double value = stat_mon_get_value(stat_mon, proc_id, stat_idx);
+        memcpy(&sample[ii++], &value, sizeof(uns64));
+      } else {
+        sample[ii++] = stat_mon_get_count(stat_mon, proc_id, stat_idx);
+      }
+    }
+  }
+  ASSERT(0, ii == sample_width);
+  stat_mon_reset(stat_mon);
+
+  block->num_samples++;
+  if (block->num_samples == STAT_SAMPLE_BLOCK)
+    submit_block();
+
+  /* the clock can step past several sample points at once (e.g. inst counts) */
+  while (stat_sample_next <= clock)
+    stat_sample_next += interval;
+}
+
+/**************************************************************************************/
+/* stat_sample_done: */
+
+void stat_sample_done(void) {
+  if (!STATS_TO_SAMPLE)
+    return;
+
+  /* sample the final partial interval */
+  stat_sample_take();
+  stat_sample_next = MAX_CTR;
+  if (blocks[cur_block].num_samples)
+    submit_block();
+
+  pthread_mutex_lock(&mutex);
+  writer_done = TRUE;
+  pthread_cond_broadcast(&cond);
+  pthread_mutex_unlock(&mutex);
+  pthread_join(writer, NULL);
+  pthread_mutex_destroy(&mutex);
+  pthread_cond_destroy(&cond);
+
+  fclose(file);
+  file = NULL;
+  for (uns jj = 0; jj < 2; jj++)
+    free(blocks[jj].data);
+  stat_mon_free(stat_mon);
+  free(stat_indices);
+}
+
+/**************************************************************************************/
+/* parse_interval: same format as triggers, "<clock>[<proc_id>]:<period>" where the
+   clock is i (instructions), c (cycles), t (time) or a counter stat name */
+
+static void parse_interval(const char* spec) {
+  char* buf = strdup(spec);
+  char* colon = strchr(buf, ':');
+  ASSERTM(0, colon, "STAT_SAMPLE_INTERVAL '%s' does not fit required format, e.g. 'c:100000'\n", spec);
+  *colon = 0;
+  interval = atoll(colon + 1);
+  ASSERTM(0, interval > 0, "STAT_SAMPLE_INTERVAL '%s' has a zero period\n", spec);
+
+  char* open_bracket = strchr(buf, '[');
+  if (open_bracket) {
+    *open_bracket = 0;
+    stat_sample_clock_proc = atoi(open_bracket + 1);
+    ASSERT(0, stat_sample_clock_proc < NUM_CORES);
+  }
+
+  switch (*buf) {
+    case 'i':
+      stat_sample_clock_stat = NODE_INST_COUNT;
+      break;
+    case 'c':
+      stat_sample_clock_stat = NODE_CYCLE;
+      break;
+    case 't':
+      stat_sample_clock_stat = EXECUTION_TIME;
+      break;
+    default:
+      stat_sample_clock_stat = get_stat_idx(buf);
+      ASSERTM(0, stat_sample_clock_stat != NUM_GLOBAL_STATS, "Clock stat '%s' of STAT_SAMPLE_INTERVAL not found\n",
+              buf);
+      ASSERTM(0, global_stat_array[0][stat_sample_clock_stat].type != FLOAT_TYPE_STAT,
+              "Clock stat '%s' of STAT_SAMPLE_INTERVAL is a float\n", buf);
+  }
+  free(buf);
+}
+
+/**************************************************************************************/
+/* write_str: */
+
+static void write_str(const char* str) {
+  uns32 len = strlen(str);
+  fwrite(&len, sizeof(len), 1, file);
+  fwrite(str, 1, len, file);
+}
+
+/**************************************************************************************/
+/* submit_block: hands the current block to the writer and switches to the other
+   one, waiting only if the writer has fallen a whole block behind */
+
+static void submit_block(void) {
+  pthread_mutex_lock(&mutex);
+  blocks[cur_block].full = TRUE;
+  pthread_cond_broadcast(&cond);
+  cur_block ^= 1;
+  while (blocks[cur_block].full)
+    pthread_cond_wait(&cond, &mutex);
+  pthread_mutex_unlock(&mutex);
+}
+
+/**************************************************************************************/
+/* writer_main: writes full blocks in the order they were submitted */
+
+static void* writer_main(void* arg) {
+  uns next = 0;
+  pthread_mutex_lock(&mutex);
+  while (TRUE) {
+    while (!blocks[next].full && !writer_done)
+      pthread_cond_wait(&cond, &mutex);
+    if (!blocks[next].full)
+      break;  // done and drained
+    pthread_mutex_unlock(&mutex);
+
+    Stat_Sample_Block* block = &blocks[next];
+    uns32 num_samples = block->num_samples;
+    fwrite(&num_samples, sizeof(num_samples), 1, file);
+    fwrite(block->data, sizeof(uns64), num_samples * sample_width, file);
+    fflush(file);
+
+    pthread_mutex_lock(&mutex);
+    block->num_samples = 0;
+    block->full = FALSE;
+    pthread_cond_broadcast(&cond);
+    next ^= 1;
+  }
+  pthread_mutex_unlock(&mutex);
+  return NULL;
+}
@@ -0,0 +1,63 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : stat_sample.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Binary time series of selected stats, sampled at a fixed interval
+ ***************************************************************************************/
+
+#ifndef __STAT_SAMPLE_H__
+#define __STAT_SAMPLE_H__
+
+#include "globals/global_types.h"
+
+#include "statistics.h"
+
+/**************************************************************************************/
+/* Global Variables */
+
+/* The sample clock is a counter stat of one core (see STAT_SAMPLE_INTERVAL).
+   stat_sample_next stays at MAX_CTR while sampling is off. */
+extern uns stat_sample_clock_proc;
+extern Stat_Enum stat_sample_clock_stat;
+extern Counter stat_sample_next;
+
+/**************************************************************************************/
+/* Prototypes */
+
+/* Initialize the sampler and start its writer thread */
+void stat_sample_init(void);
+
+/* Record one sample and advance stat_sample_next */
+void stat_sample_take(void);
+
+/* Write the remaining samples and stop the writer thread */
+void stat_sample_done(void);
+
+/* Call every cycle. Cycles that are not sample points only do this compare. */
+static inline void stat_sample_cycle(void) {
+  if (__builtin_expect(GET_TOTAL_STAT_EVENT(stat_sample_clock_proc, stat_sample_clock_stat) >= stat_sample_next, 0))
+    stat_sample_take();
+}
+
+#endif  // __STAT_SAMPLE_H__
@@ -31,6 +31,7 @@ working on this (ob).
 #include "statistics.h"
 
 #include <math.h>
+#include <pthread.h>
 
 #include "globals/assert.h"
 #include "globals/global_defs.h"
@@ -38,15 +39,19 @@ working on this (ob).
 #include "globals/global_vars.h"
 #include "globals/utils.h"
 
+#include "debug/host_prof.h"
+#include "libs/snapshot_lib.h"
+
 #include "core.param.h"
 #include "general.param.h"
 
 #include "optimizer2.h"
+#include "topdown.h"
 
 /**************************************************************************************/
 /* Global Variables */
 
-#define DEF_STAT(name, type, ratio) {type##_TYPE_STAT, #name, {0}, {0}, ratio, __FILE__, FALSE},
+#define DEF_STAT(name, type, ratio) {type##_TYPE_STAT, #name, {0}, ratio, __FILE__, FALSE},
 
 Stat global_stat_sample[] = {
 #include "stat_files.def"
@@ -55,6 +60,83 @@ Stat global_stat_sample[] = {
 #undef DEF_STAT
 
 Stat** global_stat_array;
+Stat_Count* global_stat_counts;
+Stat_Count* stat_bank_sets[MAX_STAT_BANK_SETS];
+uns num_stat_bank_sets = 0;
+CORE_LOCAL Stat_Count* thread_stat_counts = NULL;
+
+static pthread_mutex_t stat_bank_sets_mutex = PTHREAD_MUTEX_INITIALIZER;
+static Stat_Count* stat_snapshot = NULL;  // one core bank summed over all sets
+
+/* Binary stats stream, appended to on every dump when DUMP_STATS_BIN is set.
+   It starts with a header that names every stat once:
+     "SCARABST", uns32 version, uns32 num_stats, file tag
+     per stat: uns32 type, uns32 ratio_stat, name, file_name
+   (strings are an uns32 length followed by the characters). Every dump then
+   appends one fixed-width record:
+     uns32 proc_id, flags (STATS_BIN_*), first_stat, num_stats
+     uns64 period_ID, roi_dump_ID, cycle_count, inst_count,
+           period_last_cycle_count, period_last_inst_count,
+           pret_inst_count[proc_id], pret_inst_count[0]
+     uns64 count[num_stats], total[num_stats] (doubles for float stats)
+   All fields are in host byte order. bin/scarab_globals/scarab_stats_bin.py
+   reads the stream and regenerates the text and CSV files. */
+#define STATS_BIN_MAGIC "SCARABST"
+#define STATS_BIN_VERSION 1
+#define STATS_BIN_PERIODIC 0x1
+#define STATS_BIN_WARMUP 0x2
+#define STATS_BIN_ROI 0x4
+
+static FILE* stats_bin_stream = NULL;
+static uns64* stats_bin_totals = NULL;
+
+/* One dump of a core's stats: everything the text and binary writers read,
+   so that they can run on the dump thread while the simulation goes on */
+typedef struct Stats_Dump_struct {
+  uns8 proc_id;
+  uns first_stat;
+  uns num_stats;
+  Flag warmup;  // the FULL_WARMUP dump
+  Flag roi;
+  uns64 period_ID;
+  uns64 roi_dump_ID;
+  uns64 cycle_count;
+  uns64 inst_count;
+  uns64 period_last_cycle_count;
+  uns64 period_last_inst_count;
+  uns64 pret_inst_count;
+  uns64 pret_inst_count0;  // of core 0
+  const Stat* stats;       // all NUM_GLOBAL_STATS, ratio and dist stats reach outside the range
+  const Stat_Count* counts;
+} Stats_Dump;
+
+/* With DUMP_STATS_ASYNC, dump_stats copies the stats into one of two slots
+   and the dump thread formats and writes them, in the order they were
+   submitted. The simulation waits only when the thread is a whole dump
+   behind. */
+typedef struct Stats_Dump_Slot_struct {
+  Stats_Dump dump;
+  Stat* stats;
+  Stat_Count* counts;
+  Flag full;  // handed to the dump thread and not written yet
+} Stats_Dump_Slot;
+
+static Stats_Dump_Slot stats_dump_slots[2];
+static uns stats_dump_cur_slot;
+static Flag stats_dump_started = FALSE;
+static Flag stats_dump_exiting = FALSE;
+static pthread_t stats_dump_thread;
+static pthread_mutex_t stats_dump_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t stats_dump_cond = PTHREAD_COND_INITIALIZER;
+
+/**************************************************************************************/
+/* Local Prototypes */
+
+static Stat_Count* alloc_stat_banks(uns num_banks);
+static const Stat_Count* snapshot_stat_counts(uns8 proc_id);
+static void stats_dump_write(const Stats_Dump* d);
+static void stats_dump_submit(const Stats_Dump* d);
+static void stats_dump_finish(void);
 
 /**************************************************************************************/
 // init_global_stats_array:
@@ -78,12 +160,107 @@ void init_global_stats_array() {
     global_stat_array[ii] = (Stat*)malloc(NUM_GLOBAL_STATS * sizeof(Stat));
     memcpy(global_stat_array[ii], global_stat_sample, NUM_GLOBAL_STATS * sizeof(Stat));
   }
+
+  // All per-core count banks live in one zeroed allocation
+  global_stat_counts = alloc_stat_banks(NUM_CORES);
+  stat_snapshot = alloc_stat_banks(1);
+  stat_bank_sets[0] = global_stat_counts;
+  __atomic_store_n(&num_stat_bank_sets, 1, __ATOMIC_RELEASE);
+  thread_stat_counts = global_stat_counts;
 }
 
 /**************************************************************************************/
-// gen_stat_output_file:
+/* alloc_stat_banks: a zeroed run of core banks. Each bank is a whole number of
+   cache lines, so the run must start on one for no bank to straddle a line. */
+
+static Stat_Count* alloc_stat_banks(uns num_banks) {
+  const size_t size = num_banks * STAT_BANK_SIZE * sizeof(Stat_Count);
+  Stat_Count* banks;
+  int error = posix_memalign((void**)&banks, 64, size);
+  ASSERTUM(0, error == 0, "Could not allocate %u stat banks\n", num_banks);
+  memset(banks, 0, size);
+  return banks;
+}
 
-void gen_stat_output_file(char* buf, uns8 proc_id, Stat* stat, char csv) {
+/**************************************************************************************/
+/* attach_thread_stat_counts: gives the calling thread its own zeroed set of
+   core banks, on its first stat update */
+
+Stat_Count* attach_thread_stat_counts(void) {
+  Stat_Count* counts = alloc_stat_banks(NUM_CORES);
+  pthread_mutex_lock(&stat_bank_sets_mutex);
+  ASSERTM(0, num_stat_bank_sets < MAX_STAT_BANK_SETS, "More than %d threads update stats\n", MAX_STAT_BANK_SETS);
+  stat_bank_sets[num_stat_bank_sets] = counts;
+  // readers see the new set only once its pointer is in place
+  __atomic_store_n(&num_stat_bank_sets, num_stat_bank_sets + 1, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&stat_bank_sets_mutex);
+  thread_stat_counts = counts;
+  return counts;
+}
+
+/**************************************************************************************/
+/* snapshot_stat_counts: the current-interval counts of a core summed over all
+   bank sets. With one set this is the core's bank itself. */
+
+static const Stat_Count* snapshot_stat_counts(uns8 proc_id) {
+  const Stat_Count* bank = &global_stat_counts[proc_id * STAT_BANK_SIZE];
+  const uns num_sets = __atomic_load_n(&num_stat_bank_sets, __ATOMIC_ACQUIRE);
+  if (num_sets == 1)
+    return bank;
+
+  for (uns ii = 0; ii < NUM_GLOBAL_STATS; ii++) {
+    if (global_stat_array[proc_id][ii].type == FLOAT_TYPE_STAT)
+      stat_snapshot[ii].value = get_stat_value(proc_id, ii);
+    else
+      stat_snapshot[ii].count = get_stat_count(proc_id, ii);
+  }
+  return stat_snapshot;
+}
+
+/**************************************************************************************/
+/* set_stat_count: makes the current-interval count of a stat equal to count */
+
+void set_stat_count(uns8 proc_id, Stat_Enum stat, Counter count) {
+  global_stat_counts[proc_id * STAT_BANK_SIZE + stat].count += count - get_stat_count(proc_id, stat);
+}
+
+/**************************************************************************************/
+/* stats_dump_capture: describes a dump of the current state of a core */
+
+static void stats_dump_capture(Stats_Dump* d, uns8 proc_id, const Stat_Count* counts, uns first_stat,
+                               uns num_stats) {
+  d->proc_id = proc_id;
+  d->first_stat = first_stat;
+  d->num_stats = num_stats;
+  d->warmup = FULL_WARMUP && !warmup_dump_done[proc_id];
+  d->roi = roi_dump_began;
+  d->period_ID = period_ID;
+  d->roi_dump_ID = roi_dump_ID;
+  d->cycle_count = cycle_count;
+  d->inst_count = inst_count[proc_id];
+  d->period_last_cycle_count = period_last_cycle_count;
+  d->period_last_inst_count = period_last_inst_count[proc_id];
+  d->pret_inst_count = pret_inst_count[proc_id];
+  d->pret_inst_count0 = pret_inst_count[0];
+  d->stats = global_stat_array[proc_id];
+  d->counts = counts;
+}
+
+/**************************************************************************************/
+/* stat_str64: unsstr64 with buffers of the calling thread */
+
+static char* stat_str64(uns64 value) {
+  static CORE_LOCAL char bufs[4][24];
+  static CORE_LOCAL uns next = 0;
+  char* buf = bufs[next++ & 3];
+  sprintf(buf, "%llu", value);
+  return buf;
+}
+
+/**************************************************************************************/
+/* stats_dump_file_name: the .out or .csv file of a stat group in a dump */
+
+static void stats_dump_file_name(char* buf, const Stats_Dump* d, const Stat* stat, char csv) {
   char temp[MAX_STR_LENGTH + 1];
   char temp2[16];  // assuming proc id can not be more than 15 bytes
 
@@ -91,7 +268,7 @@ void gen_stat_output_file(char* buf, uns8 proc_id, Stat* stat, char csv) {
   // strncpy(temp, stat->file_name, strlen(stat->file_name) - 3);
   strncpy(temp, stat->file_name, MAX_STR_LENGTH);
   temp[strlen(stat->file_name) - 3] = '\0';
-  sprintf(temp2, "%u", proc_id);
+  sprintf(temp2, "%u", d->proc_id);
   strncat(temp, temp2, MAX_STR_LENGTH);
 
   if (csv)
@@ -101,17 +278,17 @@ void gen_stat_output_file(char* buf, uns8 proc_id, Stat* stat, char csv) {
 
   if (PERIODIC_DUMP) {
     char temp3[24];
-    sprintf(temp3, ".period.%llu", period_ID);
+    sprintf(temp3, ".period.%llu", d->period_ID);
     strncat(temp, temp3, 24);
   }
-  if (FULL_WARMUP && !warmup_dump_done[proc_id]) {
+  if (d->warmup) {
     char temp3[24];
     sprintf(temp3, ".warmup");
     strncat(temp, temp3, 24);
   }
-  if (roi_dump_began) {
+  if (d->roi) {
     char temp3[24];
-    sprintf(temp3, ".roi.%llu", roi_dump_ID);
+    sprintf(temp3, ".roi.%llu", d->roi_dump_ID);
     strncat(temp, temp3, 24);
   }
   strncpy(buf, OUTPUT_DIR, MAX_STR_LENGTH);
@@ -120,6 +297,15 @@ void gen_stat_output_file(char* buf, uns8 proc_id, Stat* stat, char csv) {
   strncat(buf, temp, MAX_STR_LENGTH + 1);
 }
 
+/**************************************************************************************/
+// gen_stat_output_file:
+
+void gen_stat_output_file(char* buf, uns8 proc_id, Stat* stat, char csv) {
+  Stats_Dump d;
+  stats_dump_capture(&d, proc_id, NULL, 0, 0);
+  stats_dump_file_name(buf, &d, stat, csv);
+}
+
 /**************************************************************************************/
 /* init_stats: */
 
@@ -146,28 +332,88 @@ void fprint_line(FILE* file) {
 }
 
 /**************************************************************************************/
-/* dump_stats: */
+/* stats_bin_write_str: */
+
+static void stats_bin_write_str(const char* str) {
+  uns32 len = strlen(str);
+  fwrite(&len, sizeof(len), 1, stats_bin_stream);
+  fwrite(str, 1, len, stats_bin_stream);
+}
+
+/**************************************************************************************/
+/* stats_bin_open: creates the stream and writes the header naming all stats */
+
+static void stats_bin_open(void) {
+  char buf[MAX_STR_LENGTH + 1];
+  snprintf(buf, MAX_STR_LENGTH, "%s/%s%s", OUTPUT_DIR, FILE_TAG, STATS_BIN_FILE);
+  stats_bin_stream = fopen(buf, "wb");
+  ASSERTUM(0, stats_bin_stream, "Couldn't open binary statistic output file '%s'.\n", buf);
+
+  uns32 version = STATS_BIN_VERSION;
+  uns32 num_stats = NUM_GLOBAL_STATS;
+  fwrite(STATS_BIN_MAGIC, 1, strlen(STATS_BIN_MAGIC), stats_bin_stream);
+  fwrite(&version, sizeof(version), 1, stats_bin_stream);
+  fwrite(&num_stats, sizeof(num_stats), 1, stats_bin_stream);
+  stats_bin_write_str(FILE_TAG);
+  for (uns ii = 0; ii < NUM_GLOBAL_STATS; ii++) {
+    Stat* s = &global_stat_array[0][ii];
+    uns32 meta[2] = {s->type, s->ratio_stat};
+    fwrite(meta, sizeof(uns32), 2, stats_bin_stream);
+    stats_bin_write_str(s->name);
+    stats_bin_write_str(s->file_name);
+  }
+  stats_bin_totals = (uns64*)malloc(NUM_GLOBAL_STATS * sizeof(uns64));
+}
+
+/**************************************************************************************/
+/* stats_bin_dump: appends one snapshot of the given stats of a core */
+
+static void stats_bin_dump(const Stats_Dump* d) {
+  if (!stats_bin_stream)
+    stats_bin_open();
+
+  uns32 flags = 0;
+  if (PERIODIC_DUMP)
+    flags |= STATS_BIN_PERIODIC;
+  if (d->warmup)
+    flags |= STATS_BIN_WARMUP;
+  if (d->roi)
+    flags |= STATS_BIN_ROI;
+
+  uns32 head[4] = {d->proc_id, flags, d->first_stat, d->num_stats};
+  uns64 cycles[8] = {d->period_ID,
+                     d->roi_dump_ID,
+                     d->cycle_count,
+                     d->inst_count,
+                     d->period_last_cycle_count,
+                     d->period_last_inst_count,
+                     d->pret_inst_count,
+                     d->pret_inst_count0};
+  fwrite(head, sizeof(uns32), 4, stats_bin_stream);
+  fwrite(cycles, sizeof(uns64), 8, stats_bin_stream);
+
+  /* the interval counts are already contiguous in the core's bank */
+  fwrite(&d->counts[d->first_stat], sizeof(Stat_Count), d->num_stats, stats_bin_stream);
+  for (uns ii = 0; ii < d->num_stats; ii++) {
+    const Stat* s = &d->stats[d->first_stat + ii];
+    memcpy(&stats_bin_totals[ii], &s->total_count, sizeof(uns64));
+  }
+  fwrite(stats_bin_totals, sizeof(uns64), d->num_stats, stats_bin_stream);
+  fflush(stats_bin_stream);
+}
+
+/**************************************************************************************/
+/* dump_stats_text: rewrites the .out and .csv file of every stat group */
 
-void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
+static void dump_stats_text(const Stats_Dump* d) {
+  const Stat* stat_array = d->stats;
+  const Stat_Count* counts = d->counts;
   Flag in_dist = FALSE;
 
   uns64 dist_sum = 0, total_dist_sum = 0, dist_vtotal = 0, total_dist_vtotal = 0;
   double dist_variance = 0, total_dist_variance = 0;
   uns ii;
 
-  if (!DUMP_STATS)
-    return;
-
-  for (ii = 0; ii < num_stats; ii++) {
-    Stat* s = &stat_array[ii];
-
-    /* update the total counter for this interval */
-    if (s->type == FLOAT_TYPE_STAT)
-      s->total_value += s->value;
-    else
-      s->total_count += s->count;
-  }
-
   const char* last_file_name = NULL;
   FILE* file_stream = NULL;
   FILE* csv_file_stream = NULL;
@@ -175,8 +421,9 @@ void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
   uns stat_groupname = 0;
   const static uns STATISTICS_CSV_NO_GROUP = 0;
 
-  for (ii = 0; ii < num_stats; ii++) {
-    Stat* s = &stat_array[ii];
+  for (ii = d->first_stat; ii < d->first_stat + d->num_stats; ii++) {
+    const Stat* s = &stat_array[ii];
+    const Stat_Count* c = &counts[ii];
 
     if (!last_file_name || s->file_name != last_file_name) {
       if (last_file_name) {
@@ -193,45 +440,45 @@ void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
       last_file_name = s->file_name;
       ASSERT(0, !file_stream);
       char buf[MAX_STR_LENGTH + 2];
-      gen_stat_output_file(buf, proc_id, s, 0);
+      stats_dump_file_name(buf, d, s, 0);
       file_stream = fopen(buf, "w");
       ASSERTUM(0, file_stream, "Couldn't open statistic output file '%s'.\n", buf);
 
       ASSERT(0, !csv_file_stream);
       char csv_buf[MAX_STR_LENGTH + 2];
-      gen_stat_output_file(csv_buf, proc_id, s, 1);
+      stats_dump_file_name(csv_buf, d, s, 1);
       csv_file_stream = fopen(csv_buf, "w");
       ASSERTUM(0, csv_file_stream, "Couldn't open statistic output file '%s'.\n", csv_buf);
 
       // .out file
       fprintf(file_stream, "/* -*- Mode: c -*- */\n");
       fprint_line(file_stream);
-      fprintf(file_stream, "Core %u\n", proc_id);
+      fprintf(file_stream, "Core %u\n", d->proc_id);
       fprint_line(file_stream);
 
       fprintf(file_stream,
               "Cumulative:        Cycles: %-20llu  Instructions: %-20llu  IPC: "
               "%.5f\n",
-              cycle_count, inst_count[proc_id], (double)inst_count[proc_id] / cycle_count);
+              d->cycle_count, d->inst_count, (double)d->inst_count / d->cycle_count);
       fprintf(file_stream, "\n");
 
       fprintf(
           file_stream,
           "Periodic:          Cycles: %-20llu  Instructions: %-20llu  IPC: "
           "%.5f\n",
-          cycle_count - period_last_cycle_count, inst_count[proc_id] - period_last_inst_count[proc_id],
-          (double)(inst_count[proc_id] - period_last_inst_count[proc_id]) / (cycle_count - period_last_cycle_count));
+          d->cycle_count - d->period_last_cycle_count, d->inst_count - d->period_last_inst_count,
+          (double)(d->inst_count - d->period_last_inst_count) / (d->cycle_count - d->period_last_cycle_count));
       fprintf(file_stream, "\n");
 
       //.csv file
-      fprintf(csv_file_stream, "Core, %d, %u\n", STATISTICS_CSV_NO_GROUP, proc_id);
+      fprintf(csv_file_stream, "Core, %d, %u\n", STATISTICS_CSV_NO_GROUP, d->proc_id);
 
       fprintf(csv_file_stream, "Cumulative_Cycles, %d, %-20llu\nCumulative_Instructions, %d, %-20llu\n",
-              STATISTICS_CSV_NO_GROUP, cycle_count, STATISTICS_CSV_NO_GROUP, inst_count[proc_id]);
+              STATISTICS_CSV_NO_GROUP, d->cycle_count, STATISTICS_CSV_NO_GROUP, d->inst_count);
 
       fprintf(csv_file_stream, "Periodic_Cycles, %d, %-20llu\nPeriodic_Instructions, %d, %-20llu\n",
-              STATISTICS_CSV_NO_GROUP, cycle_count - period_last_cycle_count, STATISTICS_CSV_NO_GROUP,
-              inst_count[proc_id] - period_last_inst_count[proc_id]);
+              STATISTICS_CSV_NO_GROUP, d->cycle_count - d->period_last_cycle_count, STATISTICS_CSV_NO_GROUP,
+              d->inst_count - d->period_last_inst_count);
     }
 
     if (s->type == LINE_TYPE_STAT) {
@@ -244,26 +491,26 @@ void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
     switch (s->type) {
       case COUNT_TYPE_STAT:
         if (!in_dist) {
-          fprintf(file_stream, "%13s %13s    %13s %13s\n", unsstr64(s->count), "", unsstr64(s->total_count), "");
+          fprintf(file_stream, "%13s %13s    %13s %13s\n", stat_str64(c->count), "", stat_str64(s->total_count), "");
 
-          fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, unsstr64(s->count));
+          fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, stat_str64(c->count));
           fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP,
-                  unsstr64(s->total_count));
+                  stat_str64(s->total_count));
         } else {
-          fprintf(file_stream, "%13s %12.3f%%    %13s %12.3f%%", unsstr64(s->count), (double)s->count / dist_sum * 100,
-                  unsstr64(s->total_count), (double)s->total_count / total_dist_sum * 100);
+          fprintf(file_stream, "%13s %12.3f%%    %13s %12.3f%%", stat_str64(c->count), (double)c->count / dist_sum * 100,
+                  stat_str64(s->total_count), (double)s->total_count / total_dist_sum * 100);
 
           // Dist percentages calculation offloaded to python
-          fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, stat_groupname, unsstr64(s->count));
-          fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, stat_groupname, unsstr64(s->total_count));
+          fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, stat_groupname, stat_str64(c->count));
+          fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, stat_groupname, stat_str64(s->total_count));
         }
         break;
 
       case FLOAT_TYPE_STAT:
         ASSERTM(0, !in_dist, "Distributions not supported for float stats\n");
-        fprintf(file_stream, "%13lf %13s    %13lf %13s\n", s->value, "", s->total_value, "");
+        fprintf(file_stream, "%13lf %13s    %13lf %13s\n", c->value, "", s->total_value, "");
 
-        fprintf(csv_file_stream, "%s_value, %d, %13lf\n", s->name, STATISTICS_CSV_NO_GROUP, s->value);
+        fprintf(csv_file_stream, "%s_value, %d, %13lf\n", s->name, STATISTICS_CSV_NO_GROUP, c->value);
         fprintf(csv_file_stream, "%s_total_value, %d, %13lf\n", s->name, STATISTICS_CSV_NO_GROUP, s->total_value);
         break;
 
@@ -274,55 +521,55 @@ void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
           uns jj;
 
           in_dist = TRUE;
-          dist_sum = s->count;
+          dist_sum = c->count;
           total_dist_sum = s->total_count;
           dist_vtotal = 0;
           total_dist_vtotal = 0;
 
           for (jj = ii + 1; stat_array[jj].type != DIST_TYPE_STAT; jj++) {
-            dist_sum += stat_array[jj].count;
+            dist_sum += counts[jj].count;
             total_dist_sum += stat_array[jj].total_count;
-            dist_vtotal += (jj - ii) * stat_array[jj].count;
+            dist_vtotal += (jj - ii) * counts[jj].count;
             total_dist_vtotal += (jj - ii) * stat_array[jj].total_count;
           }
-          dist_sum += stat_array[jj].count;
+          dist_sum += counts[jj].count;
           total_dist_sum += stat_array[jj].total_count;
-          dist_vtotal += (jj - ii) * stat_array[jj].count;
+          dist_vtotal += (jj - ii) * counts[jj].count;
           total_dist_vtotal += (jj - ii) * stat_array[jj].total_count;
 
-          dist_variance = pow((0.0 - ((double)dist_vtotal / dist_sum)), 2) * stat_array[jj].count;
+          dist_variance = pow((0.0 - ((double)dist_vtotal / dist_sum)), 2) * counts[jj].count;
           total_dist_variance =
               pow((0.0 - ((double)total_dist_vtotal / total_dist_sum)), 2) * stat_array[jj].total_count;
           for (jj = ii + 1; stat_array[jj].type != DIST_TYPE_STAT; jj++) {
-            dist_variance += pow((jj - ii - ((double)dist_vtotal / dist_sum)), 2) * stat_array[jj].count;
+            dist_variance += pow((jj - ii - ((double)dist_vtotal / dist_sum)), 2) * counts[jj].count;
             total_dist_variance +=
                 pow((jj - ii - ((double)total_dist_vtotal / total_dist_sum)), 2) * stat_array[jj].total_count;
           }
-          dist_variance += pow((jj - ii - ((double)dist_vtotal / dist_sum)), 2) * stat_array[jj].count;
+          dist_variance += pow((jj - ii - ((double)dist_vtotal / dist_sum)), 2) * counts[jj].count;
           total_dist_variance +=
               pow((jj - ii - ((double)total_dist_vtotal / total_dist_sum)), 2) * stat_array[jj].total_count;
           dist_variance /= dist_sum - 1;
           total_dist_variance /= total_dist_sum - 1;
 
-          fprintf(file_stream, "%13s %12.3f%%    %13s %12.3f%%", unsstr64(s->count), (double)s->count / dist_sum * 100,
-                  unsstr64(s->total_count), (double)s->total_count / total_dist_sum * 100);
+          fprintf(file_stream, "%13s %12.3f%%    %13s %12.3f%%", stat_str64(c->count), (double)c->count / dist_sum * 100,
+                  stat_str64(s->total_count), (double)s->total_count / total_dist_sum * 100);
 
           // DIST pct offloaded to python
-          fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, stat_groupname, unsstr64(s->count));
-          fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, stat_groupname, unsstr64(s->total_count));
+          fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, stat_groupname, stat_str64(c->count));
+          fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, stat_groupname, stat_str64(s->total_count));
         } else {
           in_dist = FALSE;
-          fprintf(file_stream, "%13s %12.3f%%    %13s %12.3f%%\n", unsstr64(s->count),
-                  (double)s->count / dist_sum * 100, unsstr64(s->total_count),
+          fprintf(file_stream, "%13s %12.3f%%    %13s %12.3f%%\n", stat_str64(c->count),
+                  (double)c->count / dist_sum * 100, stat_str64(s->total_count),
                   (double)s->total_count / total_dist_sum * 100);
 
           // DIST pct offloaded to python
-          fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, stat_groupname, unsstr64(s->count));
-          fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, stat_groupname, unsstr64(s->total_count));
+          fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, stat_groupname, stat_str64(c->count));
+          fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, stat_groupname, stat_str64(s->total_count));
 
           // print sum information
-          fprintf(file_stream, "%-40s %13s %12.3f%%    %13s %12.3f%%\n", "", unsstr64(dist_sum),
-                  (double)dist_sum / dist_sum * 100, unsstr64(total_dist_sum),
+          fprintf(file_stream, "%-40s %13s %12.3f%%    %13s %12.3f%%\n", "", stat_str64(dist_sum),
+                  (double)dist_sum / dist_sum * 100, stat_str64(total_dist_sum),
                   (double)total_dist_sum / total_dist_sum * 100);
 
           // print index amean and stddev
@@ -332,84 +579,84 @@ void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
         break;
 
       case PER_INST_TYPE_STAT:
-        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", unsstr64(s->count),
-                (double)s->count / (double)inst_count[proc_id], unsstr64(s->total_count),
-                (double)s->total_count / (double)inst_count[proc_id]);
+        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", stat_str64(c->count),
+                (double)c->count / (double)d->inst_count, stat_str64(s->total_count),
+                (double)s->total_count / (double)d->inst_count);
 
-        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, unsstr64(s->count));
+        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, stat_str64(c->count));
         fprintf(csv_file_stream, "%s_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)s->count / (double)inst_count[proc_id]);
+                (double)c->count / (double)d->inst_count);
         fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP,
-                unsstr64(s->total_count));
+                stat_str64(s->total_count));
         fprintf(csv_file_stream, "%s_total_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)s->total_count / (double)inst_count[proc_id]);
+                (double)s->total_count / (double)d->inst_count);
         break;
 
       case PER_1000_INST_TYPE_STAT:
-        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", unsstr64(s->count),
-                (double)1000.0 * (double)s->count / (double)inst_count[proc_id], unsstr64(s->total_count),
-                (double)1000.0 * (double)s->total_count / (double)inst_count[proc_id]);
+        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", stat_str64(c->count),
+                (double)1000.0 * (double)c->count / (double)d->inst_count, stat_str64(s->total_count),
+                (double)1000.0 * (double)s->total_count / (double)d->inst_count);
 
-        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, unsstr64(s->count));
+        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, stat_str64(c->count));
         fprintf(csv_file_stream, "%s_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)1000.0 * (double)s->count / (double)inst_count[proc_id]);
+                (double)1000.0 * (double)c->count / (double)d->inst_count);
         fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP,
-                unsstr64(s->total_count));
+                stat_str64(s->total_count));
         fprintf(csv_file_stream, "%s_total_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)1000.0 * (double)s->total_count / (double)inst_count[proc_id]);
+                (double)1000.0 * (double)s->total_count / (double)d->inst_count);
         break;
 
       case PER_1000_PRET_INST_TYPE_STAT:
-        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", unsstr64(s->count),
-                (double)1000.0 * (double)s->count / (double)pret_inst_count[proc_id], unsstr64(s->total_count),
-                (double)1000.0 * (double)s->total_count / (double)pret_inst_count[0]);
+        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", stat_str64(c->count),
+                (double)1000.0 * (double)c->count / (double)d->pret_inst_count, stat_str64(s->total_count),
+                (double)1000.0 * (double)s->total_count / (double)d->pret_inst_count0);
 
-        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, unsstr64(s->count));
+        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, stat_str64(c->count));
         fprintf(csv_file_stream, "%s_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)1000.0 * (double)s->count / (double)pret_inst_count[proc_id]);
+                (double)1000.0 * (double)c->count / (double)d->pret_inst_count);
         fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP,
-                unsstr64(s->total_count));
+                stat_str64(s->total_count));
         fprintf(csv_file_stream, "%s_total_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)1000.0 * (double)s->total_count / (double)pret_inst_count[0]);
+                (double)1000.0 * (double)s->total_count / (double)d->pret_inst_count0);
         break;
 
       case PER_CYCLE_TYPE_STAT:
-        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", unsstr64(s->count), (double)s->count / (double)cycle_count,
-                unsstr64(s->total_count), (double)s->total_count / (double)cycle_count);
+        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", stat_str64(c->count), (double)c->count / (double)d->cycle_count,
+                stat_str64(s->total_count), (double)s->total_count / (double)d->cycle_count);
 
-        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, unsstr64(s->count));
+        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, stat_str64(c->count));
         fprintf(csv_file_stream, "%s_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)s->count / (double)cycle_count);
+                (double)c->count / (double)d->cycle_count);
         fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP,
-                unsstr64(s->total_count));
+                stat_str64(s->total_count));
         fprintf(csv_file_stream, "%s_total_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)s->total_count / (double)cycle_count);
+                (double)s->total_count / (double)d->cycle_count);
         break;
 
       case RATIO_TYPE_STAT:
-        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", unsstr64(s->count),
-                (double)s->count / (double)(stat_array[s->ratio_stat].count), unsstr64(s->total_count),
+        fprintf(file_stream, "%13s %13.4f    %13s %13.4f\n", stat_str64(c->count),
+                (double)c->count / (double)(counts[s->ratio_stat].count), stat_str64(s->total_count),
                 (double)s->total_count / (double)stat_array[s->ratio_stat].total_count);
 
-        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, unsstr64(s->count));
+        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, stat_str64(c->count));
         fprintf(csv_file_stream, "%s_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)s->count / (double)(stat_array[s->ratio_stat].count));
+                (double)c->count / (double)(counts[s->ratio_stat].count));
         fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP,
-                unsstr64(s->total_count));
+                stat_str64(s->total_count));
         fprintf(csv_file_stream, "%s_total_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
                 (double)s->total_count / (double)stat_array[s->ratio_stat].total_count);
         break;
 
       case PERCENT_TYPE_STAT:
-        fprintf(file_stream, "%13s %12.3f%%    %13s %12.3f%%\n", unsstr64(s->count),
-                (double)s->count * 100 / (double)(stat_array[s->ratio_stat].count), unsstr64(s->total_count),
+        fprintf(file_stream, "%13s %12.3f%%    %13s %12.3f%%\n", stat_str64(c->count),
+                (double)c->count * 100 / (double)(counts[s->ratio_stat].count), stat_str64(s->total_count),
                 (double)s->total_count * 100 / (double)stat_array[s->ratio_stat].total_count);
 
-        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, unsstr64(s->count));
+        fprintf(csv_file_stream, "%s_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP, stat_str64(c->count));
         fprintf(csv_file_stream, "%s_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
-                (double)s->count * 100 / (double)(stat_array[s->ratio_stat].count));
+                (double)c->count * 100 / (double)(counts[s->ratio_stat].count));
         fprintf(csv_file_stream, "%s_total_count, %d, %13s\n", s->name, STATISTICS_CSV_NO_GROUP,
-                unsstr64(s->total_count));
+                stat_str64(s->total_count));
         fprintf(csv_file_stream, "%s_total_pct, %d, %12.3f\n", s->name, STATISTICS_CSV_NO_GROUP,
                 (double)s->total_count * 100 / (double)stat_array[s->ratio_stat].total_count);
         break;
@@ -425,8 +672,6 @@ void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
 
     fprintf(file_stream, "\n");
     fprintf(csv_file_stream, "\n");
-    fflush(file_stream);
-    fflush(csv_file_stream);
   }
 
   if (last_file_name) {
@@ -440,15 +685,133 @@ void dump_stats(uns8 proc_id, Flag final, Stat stat_array[], uns num_stats) {
     fclose(csv_file_stream);
     csv_file_stream = NULL;
   }
+}
+
+/**************************************************************************************/
+/* stats_dump_write: */
+
+static void stats_dump_write(const Stats_Dump* d) {
+  if (DUMP_STATS_BIN)
+    stats_bin_dump(d);
+  if (DUMP_STATS_TEXT)
+    dump_stats_text(d);
+}
+
+/**************************************************************************************/
+/* stats_dump_main: writes full slots in the order they were submitted */
+
+static void* stats_dump_main(void* arg) {
+  uns next = 0;
+  pthread_mutex_lock(&stats_dump_mutex);
+  while (TRUE) {
+    while (!stats_dump_slots[next].full && !stats_dump_exiting)
+      pthread_cond_wait(&stats_dump_cond, &stats_dump_mutex);
+    if (!stats_dump_slots[next].full)
+      break;  // exiting and drained
+    pthread_mutex_unlock(&stats_dump_mutex);
+
+    stats_dump_write(&stats_dump_slots[next].dump);
+
+    pthread_mutex_lock(&stats_dump_mutex);
+    stats_dump_slots[next].full = FALSE;
+    pthread_cond_broadcast(&stats_dump_cond);
+    next ^= 1;
+  }
+  pthread_mutex_unlock(&stats_dump_mutex);
+  return NULL;
+}
+
+/**************************************************************************************/
+/* stats_dump_submit: copies a dump into the current slot, hands it to the dump
+   thread and switches to the other slot, waiting only if that one is still
+   being written */
+
+static void stats_dump_submit(const Stats_Dump* d) {
+  if (!stats_dump_started) {
+    for (uns ii = 0; ii < 2; ii++) {
+      stats_dump_slots[ii].stats = (Stat*)malloc(NUM_GLOBAL_STATS * sizeof(Stat));
+      stats_dump_slots[ii].counts = (Stat_Count*)malloc(NUM_GLOBAL_STATS * sizeof(Stat_Count));
+    }
+    int err = pthread_create(&stats_dump_thread, NULL, stats_dump_main, NULL);
+    ASSERTM(0, !err, "Could not create the stats dump thread (%d)\n", err);
+    stats_dump_started = TRUE;
+    atexit(stats_dump_finish);  // also covers the exit() paths of the frontends
+  }
+
+  Stats_Dump_Slot* slot = &stats_dump_slots[stats_dump_cur_slot];
+  memcpy(slot->stats, d->stats, NUM_GLOBAL_STATS * sizeof(Stat));
+  memcpy(slot->counts, d->counts, NUM_GLOBAL_STATS * sizeof(Stat_Count));
+  slot->dump = *d;
+  slot->dump.stats = slot->stats;
+  slot->dump.counts = slot->counts;
+
+  pthread_mutex_lock(&stats_dump_mutex);
+  slot->full = TRUE;
+  pthread_cond_broadcast(&stats_dump_cond);
+  stats_dump_cur_slot ^= 1;
+  while (stats_dump_slots[stats_dump_cur_slot].full)
+    pthread_cond_wait(&stats_dump_cond, &stats_dump_mutex);
+  pthread_mutex_unlock(&stats_dump_mutex);
+}
+
+/**************************************************************************************/
+/* stats_dump_finish: waits for the dump thread to write the submitted dumps */
+
+static void stats_dump_finish(void) {
+  if (!stats_dump_started || pthread_equal(pthread_self(), stats_dump_thread))
+    return;  // a failing write exits from the dump thread itself
+  pthread_mutex_lock(&stats_dump_mutex);
+  stats_dump_exiting = TRUE;
+  pthread_cond_broadcast(&stats_dump_cond);
+  pthread_mutex_unlock(&stats_dump_mutex);
+  pthread_join(stats_dump_thread, NULL);
+  stats_dump_started = FALSE;
+}
+
+/**************************************************************************************/
+/* dump_stats: */
+
+void dump_stats(uns8 proc_id, Flag final, uns first_stat, uns num_stats) {
+  Stat* stat_array = global_stat_array[proc_id];
+  Stat_Count* bank = &global_stat_counts[proc_id * STAT_BANK_SIZE];
+  uns ii;
+
+  if (!DUMP_STATS)
+    return;
+
+  topdown_flush(proc_id);
+  uns64 prof_start = HOST_PROF ? host_prof_ticks() : 0;
+  const Stat_Count* counts = snapshot_stat_counts(proc_id);
+
+  for (ii = first_stat; ii < first_stat + num_stats; ii++) {
+    Stat* s = &stat_array[ii];
+    const Stat_Count* c = &counts[ii];
+
+    /* update the total counter for this interval */
+    if (s->type == FLOAT_TYPE_STAT)
+      s->total_value += c->value;
+    else
+      s->total_count += c->count;
+  }
 
-  /* reset the interval counters */
-  for (ii = 0; ii < num_stats; ii++) {
+  Stats_Dump d;
+  stats_dump_capture(&d, proc_id, counts, first_stat, num_stats);
+  if (DUMP_STATS_ASYNC)
+    stats_dump_submit(&d);
+  else
+    stats_dump_write(&d);
+
+  /* reset the interval counters; with one bank set counts is the bank */
+  for (ii = first_stat; ii < first_stat + num_stats; ii++) {
     Stat* s = &stat_array[ii];
     if (s->type == FLOAT_TYPE_STAT)
-      s->value = 0.0;
+      bank[ii].value -= counts[ii].value;
     else
-      s->count = 0;
+      bank[ii].count -= counts[ii].count;
   }
+
+  if (HOST_PROF)
+    host_prof_add(proc_id, HOST_PROF_DUMP_STATS, prof_start);
 }
 
 /**************************************************************************************/
@@ -464,22 +827,62 @@ void reset_stats(Flag keep_total) {
     fflush(mystdout);
   }
 
-  for (ii = 0; ii < NUM_GLOBAL_STATS; ii++) {
-    for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+  for (proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    topdown_flush(proc_id);
+    const Stat_Count* counts = snapshot_stat_counts(proc_id);
+    Stat_Count* bank = &global_stat_counts[proc_id * STAT_BANK_SIZE];
+    for (ii = 0; ii < NUM_GLOBAL_STATS; ii++) {
       Stat* stat = &global_stat_array[proc_id][ii];
       if (stat->type == FLOAT_TYPE_STAT) {
         if (keep_total || stat->noreset)
-          stat->total_value += stat->value;
-        stat->value = 0.0;
+          stat->total_value += counts[ii].value;
+        bank[ii].value -= counts[ii].value;
       } else {
         if (keep_total || stat->noreset)
-          stat->total_count += stat->count;
-        stat->count = 0ULL;
+          stat->total_count += counts[ii].count;
+        bank[ii].count -= counts[ii].count;
       }
     }
   }
 }
 
+/**************************************************************************************/
+/* stats_snapshot: the totals are stored as is; on restore the main thread's
+   bank absorbs the difference so the current interval sums to the saved one */
+
+void stats_snapshot(Snapshot* snap) {
+  Stat_Count* interval = (Stat_Count*)malloc(NUM_GLOBAL_STATS * sizeof(Stat_Count));
+  uns64* totals = (uns64*)malloc(NUM_GLOBAL_STATS * sizeof(uns64));
+  snapshot_section(snap, "STATS");
+  snapshot_check(snap, "NUM_GLOBAL_STATS", NUM_GLOBAL_STATS);
+
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) {
+    Stat* stat_array = global_stat_array[proc_id];
+    Stat_Count* bank = &global_stat_counts[proc_id * STAT_BANK_SIZE];
+    if (snap->save) {
+      topdown_flush(proc_id);
+      memcpy(interval, snapshot_stat_counts(proc_id), NUM_GLOBAL_STATS * sizeof(Stat_Count));
+      for (uns ii = 0; ii < NUM_GLOBAL_STATS; ii++)
+        memcpy(&totals[ii], &stat_array[ii].total_count, sizeof(uns64));
+    }
+    snapshot_data(snap, interval, NUM_GLOBAL_STATS * sizeof(Stat_Count));
+    snapshot_data(snap, totals, NUM_GLOBAL_STATS * sizeof(uns64));
+    if (snap->save)
+      continue;
+
+    const Stat_Count* counts = snapshot_stat_counts(proc_id);
+    for (uns ii = 0; ii < NUM_GLOBAL_STATS; ii++) {
+      memcpy(&stat_array[ii].total_count, &totals[ii], sizeof(uns64));
+      if (stat_array[ii].type == FLOAT_TYPE_STAT)
+        bank[ii].value += interval[ii].value - counts[ii].value;
+      else
+        bank[ii].count += interval[ii].count - counts[ii].count;
+    }
+  }
+  free(interval);
+  free(totals);
+}
+
 /**************************************************************************************/
 /* get_stat_idx: */
 
@@ -73,13 +73,19 @@ typedef enum Stat_Type_enum {
   NUM_STAT_TYPES,
 } Stat_Type;
 
+/* The current-interval counts are kept apart from the rest of the Stat
+   struct. Each core has one dense bank of Stat_Count entries, and the banks
+   are laid out back to back in global_stat_counts, so a STAT_EVENT touches a
+   single 8-byte word instead of a 64-byte struct. The per-core Stat structs
+   hold the cold metadata and the totals carried across intervals. */
+typedef union Stat_Count_union {
+  Counter count;  // count during the current stat interval
+  double value;   // value during the current stat interval
+} Stat_Count;
+
 typedef struct Stat_struct {
   Stat_Type type;    // see types above
   const char* name;  // name of stat
-  union {
-    Counter count;  // count during the current stat interval
-    double value;   // value during the current stat interval
-  };
   union {
     Counter total_count;  // total count from beginning of run
     double total_value;   // total value from beginning of run
@@ -89,50 +95,155 @@ typedef struct Stat_struct {
   Flag noreset;           // this stat does not get reset (name has prefix "NORESET")
 } Stat;
 
+/* entries per core bank, rounded up to a whole number of cache lines */
+#define STAT_BANK_SIZE ((NUM_GLOBAL_STATS + 7) & ~7)
+
+/* Every host thread that updates stats gets its own set of core banks,
+   attached on its first update, so STAT_EVENT from core threads (including
+   STAT_EVENT(0, ...) on shared memory system paths and the *_ALL forms) never
+   writes a line another thread writes. The main thread's set is
+   global_stat_counts, which also serves as the accumulator: the current-
+   interval count of a stat is the sum over all sets, and dump_stats and
+   reset_stats subtract what they consume from global_stat_counts instead of
+   zeroing the other threads' counters. Only the main thread, while the core
+   threads are parked, may dump, reset or set stats. */
+#define MAX_STAT_BANK_SETS 256
+
+/**************************************************************************************/
+/* Stat Groups */
+
+/* Every .stat.def file included by stat_files.def is a stat group. Building
+   with -DNO_<GROUP>_STATS (e.g. -DNO_POWER_STATS, or through the
+   SCARAB_DISABLE_STAT_GROUPS environment variable at cmake time) compiles the
+   STAT_EVENT and INC_STAT_* updates of that group out. Its stats are still
+   dumped, as zeros. Readers such as triggers and stat monitors see zeros too,
+   so groups whose stats drive the simulation (e.g. NODE_CYCLE in core) should
+   be left in. */
+
+#ifdef NO_FETCH_STATS
+#define FETCH_STATS_ON 0
+#else
+#define FETCH_STATS_ON 1
+#endif
+#ifdef NO_BP_STATS
+#define BP_STATS_ON 0
+#else
+#define BP_STATS_ON 1
+#endif
+#ifdef NO_MEMORY_STATS
+#define MEMORY_STATS_ON 0
+#else
+#define MEMORY_STATS_ON 1
+#endif
+#ifdef NO_CORE_STATS
+#define CORE_STATS_ON 0
+#else
+#define CORE_STATS_ON 1
+#endif
+#ifdef NO_INST_STATS
+#define INST_STATS_ON 0
+#else
+#define INST_STATS_ON 1
+#endif
+#ifdef NO_STREAM_STATS
+#define STREAM_STATS_ON 0
+#else
+#define STREAM_STATS_ON 1
+#endif
+#ifdef NO_L2L1PREF_STATS
+#define L2L1PREF_STATS_ON 0
+#else
+#define L2L1PREF_STATS_ON 1
+#endif
+#ifdef NO_POWER_STATS
+#define POWER_STATS_ON 0
+#else
+#define POWER_STATS_ON 1
+#endif
+#ifdef NO_PREF_STATS
+#define PREF_STATS_ON 0
+#else
+#define PREF_STATS_ON 1
+#endif
+#ifdef NO_HOST_PROF_STATS
+#define HOST_PROF_STATS_ON 0
+#else
+#define HOST_PROF_STATS_ON 1
+#endif
+
+#define STAT_GROUP_ON_(group) group##_ON
+#define STAT_GROUP_ON(group) STAT_GROUP_ON_(group)
+
+#if FETCH_STATS_ON && BP_STATS_ON && MEMORY_STATS_ON && CORE_STATS_ON && INST_STATS_ON && STREAM_STATS_ON && \
+    L2L1PREF_STATS_ON && POWER_STATS_ON && PREF_STATS_ON && HOST_PROF_STATS_ON
+#define STAT_ON(stat) 1
+#else
+/* STAT_GROUP is redefined by stat_files.def before each group is included */
+#define DEF_STAT(name, type, ratio) STAT_GROUP_ON(STAT_GROUP),
+static const Flag stat_on[NUM_GLOBAL_STATS] = {
+#include "stat_files.def"
+};
+#undef DEF_STAT
+#define STAT_ON(stat) (stat_on[stat])
+#endif
+
 /**************************************************************************************/
 /* Macros */
 
 #ifndef NO_STAT
-#define STAT_EVENT(proc_id, stat)             \
-  do {                                        \
-    global_stat_array[proc_id][stat].count++; \
+#define STAT_BANKS() \
+  (__builtin_expect(thread_stat_counts != NULL, 1) ? thread_stat_counts : attach_thread_stat_counts())
+/* the calling thread's counter, for updates; read stats with GET_STAT_EVENT */
+#define STAT_COUNT(proc_id, stat) (STAT_BANKS()[(proc_id) * STAT_BANK_SIZE + (stat)])
+
+#define STAT_EVENT(proc_id, stat)        \
+  do {                                   \
+    if (STAT_ON(stat))                   \
+      STAT_COUNT(proc_id, stat).count++; \
   } while (0)
 
-#define STAT_EVENT_ALL(stat)                              \
-  do {                                                    \
-    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
-      global_stat_array[proc_id][stat].count++;           \
+#define STAT_EVENT_ALL(stat)                                \
+  do {                                                      \
+    if (STAT_ON(stat))                                      \
+      for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
+        STAT_COUNT(proc_id, stat).count++;                  \
   } while (0)
 
-#define INC_STAT_EVENT(proc_id, stat, inc)           \
-  do {                                               \
-    global_stat_array[proc_id][stat].count += (inc); \
+#define INC_STAT_EVENT(proc_id, stat, inc)      \
+  do {                                          \
+    if (STAT_ON(stat))                          \
+      STAT_COUNT(proc_id, stat).count += (inc); \
   } while (0)
 
-#define INC_STAT_EVENT_ALL(stat, inc)                     \
-  do {                                                    \
-    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
-      global_stat_array[proc_id][stat].count += (inc);    \
+#define INC_STAT_EVENT_ALL(stat, inc)                       \
+  do {                                                      \
+    if (STAT_ON(stat))                                      \
+      for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
+        STAT_COUNT(proc_id, stat).count += (inc);           \
   } while (0)
 
-#define INC_STAT_VALUE(proc_id, stat, inc)           \
-  do {                                               \
-    global_stat_array[proc_id][stat].value += (inc); \
+#define INC_STAT_VALUE(proc_id, stat, inc)      \
+  do {                                          \
+    if (STAT_ON(stat))                          \
+      STAT_COUNT(proc_id, stat).value += (inc); \
   } while (0)
 
-#define INC_STAT_VALUE_ALL(stat, inc)                     \
-  do {                                                    \
-    for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
-      global_stat_array[proc_id][stat].value += (inc);    \
+#define INC_STAT_VALUE_ALL(stat, inc)                       \
+  do {                                                      \
+    if (STAT_ON(stat))                                      \
+      for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++) \
+        STAT_COUNT(proc_id, stat).value += (inc);           \
   } while (0)
 
-#define GET_STAT_EVENT(proc_id, stat) (global_stat_array[proc_id][stat].count)
+#define GET_STAT_EVENT(proc_id, stat) get_stat_count(proc_id, stat)
+#define GET_STAT_VALUE(proc_id, stat) get_stat_value(proc_id, stat)
 #define GET_TOTAL_STAT_EVENT(proc_id, stat) \
-  (global_stat_array[proc_id][stat].count + global_stat_array[proc_id][stat].total_count)
+  (get_stat_count(proc_id, stat) + global_stat_array[proc_id][stat].total_count)
 #define GET_TOTAL_STAT_VALUE(proc_id, stat) \
-  (global_stat_array[proc_id][stat].value + global_stat_array[proc_id][stat].total_value)
+  (get_stat_value(proc_id, stat) + global_stat_array[proc_id][stat].total_value)
 #define GET_ACCUM_STAT_EVENT(stat) get_accum_stat_event(stat)
-#define RESET_STAT(proc_id, stat) (global_stat_array[proc_id][stat].count = 0)
+#define SET_STAT_EVENT(proc_id, stat, count) set_stat_count(proc_id, stat, count)
+#define RESET_STAT(proc_id, stat) set_stat_count(proc_id, stat, 0)
 
 #define NO_RATIO NUM_GLOBAL_STATS
 
@@ -145,9 +256,11 @@ typedef struct Stat_struct {
 #define INC_STAT_VALUE(proc_id, stat, inc)
 #define INC_STAT_VALUE_ALL(stat, inc)
 #define GET_STAT_EVENT(proc_id, stat) 0
+#define GET_STAT_VALUE(proc_id, stat) 0
 #define GET_TOTAL_STAT_EVENT(proc_id, stat) 0
 #define GET_TOTAL_STAT_VALUE(proc_id, stat)
 #define GET_ACCUM_STAT_EVENT(stat)
+#define SET_STAT_EVENT(proc_id, stat, count)
 #define RESET_STAT(proc_id, stat)
 #define NO_RATIO
 
@@ -158,8 +271,14 @@ typedef struct Stat_struct {
 
 #ifndef NO_STAT
 extern Stat** global_stat_array;
+extern Stat_Count* global_stat_counts;
+extern Stat_Count* stat_bank_sets[MAX_STAT_BANK_SETS];  // [0] is global_stat_counts
+extern uns num_stat_bank_sets;
+extern CORE_LOCAL Stat_Count* thread_stat_counts;  // NULL until the thread's first update
 #endif
 
+struct Snapshot_struct;
+
 /**************************************************************************************/
 /* Prototypes */
 #ifdef __cplusplus
@@ -169,16 +288,46 @@ extern "C" {
 void init_global_stats_array(void);
 void gen_stat_output_file(char*, uns8, Stat*, char);
 void init_global_stats(uns8);
-void dump_stats(uns8, Flag, Stat[], uns);
+void dump_stats(uns8, Flag, uns, uns);
 void reset_stats(Flag);
 void fprint_line(FILE*);
 Stat_Enum get_stat_idx(const char* name);
 const Stat* get_stat(uns8, const char*);
 Counter get_accum_stat_event(Stat_Enum name);
+Stat_Count* attach_thread_stat_counts(void);
+void set_stat_count(uns8 proc_id, Stat_Enum stat, Counter count);
+/* Saves or restores the totals and current interval counts of all stats */
+void stats_snapshot(struct Snapshot_struct* snap);
 
 #ifdef __cplusplus
 }
 #endif
+
+#ifndef NO_STAT
+/* Current-interval count of a stat, summed over the bank sets of all threads.
+   A set written concurrently by a running core thread may be read a few
+   updates behind. */
+static inline Counter get_stat_count(uns proc_id, uns stat) {
+  const uns num_sets = __atomic_load_n(&num_stat_bank_sets, __ATOMIC_ACQUIRE);
+  const uns idx = proc_id * STAT_BANK_SIZE + stat;
+  Counter sum = 0;
+  for (uns ii = 0; ii < num_sets; ii++)
+    sum += __atomic_load_n(&stat_bank_sets[ii][idx].count, __ATOMIC_RELAXED);
+  return sum;
+}
+
+static inline double get_stat_value(uns proc_id, uns stat) {
+  const uns num_sets = __atomic_load_n(&num_stat_bank_sets, __ATOMIC_ACQUIRE);
+  const uns idx = proc_id * STAT_BANK_SIZE + stat;
+  double sum = 0.0;
+  for (uns ii = 0; ii < num_sets; ii++) {
+    double value;
+    __atomic_load(&stat_bank_sets[ii][idx].value, &value, __ATOMIC_RELAXED);
+    sum += value;
+  }
+  return sum;
+}
+#endif
 /**************************************************************************************/
 
 #endif /* #ifndef __STATISTICS_H__ */
@@ -128,6 +128,17 @@ typedef enum Bar_Type_enum {
   BAR_ISSUE = 0x2,  // causes issue to serialize around the instruction
 } Bar_Type;
 
+/* Elim_Class tells rename which instructions it can resolve without waiting on their sources. It is looked up by
+ * opcode when the instruction is decoded and kept only if the operands fit (e.g. both sources of a xor are the same
+ * register). */
+typedef enum Elim_Class_enum {
+  ELIM_NONE,             // depends on its sources
+  ELIM_MOVE,             // register-to-register move, the destination can share the source's physical register
+  ELIM_ZERO_IDIOM,       // always produces zero (xor/sub/pxor reg,reg)
+  ELIM_DEP_BREAK_IDIOM,  // always produces all ones (pcmpeq reg,reg)
+  NUM_ELIM_CLASSES,
+} Elim_Class;
+
 /**************************************************************************************/
 /* The 'Table_Info' type is the static information associated with an
  * instruction. */
@@ -143,6 +154,7 @@ struct Table_Info_struct {
   Cf_Type cf_type;     // type of control flow instruction
   Bar_Type bar_type;   // type of barrier caused by instruction
   uns16 true_op_type;  // type of opcode from PIN. Should not be used for Scarab timing.
+  uns8 elim_class;     // Elim_Class, how rename can resolve the instruction
 
   uns num_dest_regs;  // number of destination registers written
   uns num_src_regs;   // number of source registers read
@@ -0,0 +1,104 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : test/bench/bench.h
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Minimal google-benchmark style harness for the simulator's hot
+ *                paths (scarab_bench target). A benchmark does its setup, then
+ *                runs the timed loop while state.keep_running() is true:
+ *
+ *                  SCARAB_BENCH(hash_lib_access) {
+ *                    ... setup ...
+ *                    while (state.keep_running())
+ *                      ... one iteration ...
+ *                  }
+ *
+ *                The harness calls it with growing iteration counts until a
+ *                run lasts --benchmark_min_time.
+ ***************************************************************************************/
+
+#ifndef __BENCH_H__
+#define __BENCH_H__
+
+#include <stdint.h>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+class Bench_State {
+ public:
+  explicit Bench_State(uint64_t iterations) : iterations_(iterations) {}
+
+  /* Starts the clock on the first call; false once every iteration ran */
+  bool keep_running() {
+    if (done_ == 0)
+      start_ = std::chrono::steady_clock::now();
+    if (done_ == iterations_) {
+      elapsed_ = std::chrono::steady_clock::now() - start_;
+      return false;
+    }
+    done_++;
+    return true;
+  }
+
+  uint64_t iterations() const { return iterations_; }
+  double elapsed_seconds() const { return elapsed_.count(); }
+
+  /* Work items per iteration, reported as items_per_second */
+  void set_items_per_iteration(uint64_t items) { items_per_iteration_ = items; }
+  uint64_t items_per_iteration() const { return items_per_iteration_; }
+
+ private:
+  uint64_t iterations_;
+  uint64_t done_ = 0;
+  uint64_t items_per_iteration_ = 1;
+  std::chrono::steady_clock::time_point start_;
+  std::chrono::duration<double> elapsed_{0};
+};
+
+typedef std::function<void(Bench_State&)> Bench_Func;
+
+struct Bench_Info {
+  std::string name;
+  Bench_Func func;
+};
+
+std::vector<Bench_Info>& bench_registry();
+
+struct Bench_Registrar {
+  Bench_Registrar(const std::string& name, Bench_Func func) { bench_registry().push_back({name, func}); }
+};
+
+/* Keeps the compiler from dropping a result that is otherwise unused */
+template <class T>
+inline void bench_do_not_optimize(const T& value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+#define SCARAB_BENCH(name)                                                \
+  static void bench_##name(Bench_State& state);                           \
+  static Bench_Registrar bench_registrar_##name(#name, bench_##name);     \
+  static void bench_##name(Bench_State& state)
+
+#endif  // __BENCH_H__
@@ -0,0 +1,92 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : test/bench/bench_bp.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : TAGE-SC-L predict, recover and update, in the order Scarab
+ *                drives bp/tagescl.cc for one conditional branch.
+ ***************************************************************************************/
+
+#include <memory>
+#include <vector>
+
+#include "test/bench/bench.h"
+
+extern "C" {
+#include "globals/assert.h"
+}
+
+#include "bp/template_lib/tagescl.h"
+
+#define BENCH_BP_NUM_BRANCHES 4096
+#define BENCH_BP_STREAM_LENGTH (1 << 16)
+#define BENCH_BP_MAX_IN_FLIGHT 1024
+
+namespace {
+
+struct Bench_Branch {
+  uint64_t pc;
+  bool dir;
+};
+
+/* Branches with fixed per-pc biases, so the predictor has something to learn */
+std::vector<Bench_Branch> bench_branch_stream() {
+  std::vector<Bench_Branch> stream(BENCH_BP_STREAM_LENGTH);
+  uint64_t x = 3;
+  for (Bench_Branch& br : stream) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    uint64_t site = x % BENCH_BP_NUM_BRANCHES;
+    br.pc = 0x400000 + site * 16;
+    br.dir = ((x >> 20) & 0xff) < (site * 37 & 0xff);
+  }
+  return stream;
+}
+
+template <class CONFIG>
+void bench_tagescl(Bench_State& state) {
+  static std::unique_ptr<Tage_SC_L_Base> predictor;
+  if (!predictor)
+    predictor = std::make_unique<Tage_SC_L<CONFIG>>(BENCH_BP_MAX_IN_FLIGHT);
+  static const std::vector<Bench_Branch> stream = bench_branch_stream();
+  const Branch_Type br_type = {true, false};
+
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    const Bench_Branch& br = stream[ii++ & (BENCH_BP_STREAM_LENGTH - 1)];
+    uint64_t target = br.pc + 0x40;
+    int64_t id = predictor->get_new_branch_id();
+    bool pred = predictor->get_prediction(id, br.pc);
+    predictor->update_speculative_state(id, br.pc, br_type, pred, target);
+    if (pred != br.dir)
+      predictor->flush_branch_and_repair_state(id, br.pc, br_type, br.dir, target);
+    predictor->commit_state(id, br.pc, br_type, br.dir);
+    predictor->commit_state_at_retire(id, br.pc, br_type, br.dir, target);
+  }
+}
+
+Bench_Registrar bench_tagescl_64kb("tagescl_predict_update/64kb", bench_tagescl<TAGE_SC_L_CONFIG_64KB>);
+Bench_Registrar bench_tagescl_80kb("tagescl_predict_update/80kb", bench_tagescl<TAGE_SC_L_CONFIG_80KB>);
+
+}  // namespace
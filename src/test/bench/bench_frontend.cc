@@ -0,0 +1,149 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : test/bench/bench_frontend.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : uop_generator on the instructions of a recorded pin trace
+ *                (test/simple_loop.trace.bz2, or $SCARAB_BENCH_TRACE), and the
+ *                exec-driven frontend's request/op-buffer exchange over the
+ *                message-queue socket transport.
+ ***************************************************************************************/
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "test/bench/bench.h"
+
+#include "pin/pin_lib/message_queue_interface_lib.h"
+#include "pin/pin_lib/pin_scarab_common_lib.h"
+
+extern "C" {
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+#include "frontend/pin_trace_read.h"
+#include "pin/pin_lib/uop_generator.h"
+
+#include "op.h"
+}
+
+#ifndef SCARAB_BENCH_TRACE
+#define SCARAB_BENCH_TRACE "test/simple_loop.trace.bz2"
+#endif
+
+#define BENCH_FE_MAX_INSTS (1 << 16)
+#define BENCH_MQ_OPS_PER_BUFFER 64
+
+namespace {
+
+/* Reads the first BENCH_FE_MAX_INSTS instructions of the trace once */
+const std::vector<ctype_pin_inst>& bench_trace_insts() {
+  static std::vector<ctype_pin_inst> insts;
+  static bool loaded = false;
+  if (loaded)
+    return insts;
+  loaded = true;
+
+  const char* name = getenv("SCARAB_BENCH_TRACE");
+  if (!name)
+    name = SCARAB_BENCH_TRACE;
+  if (access(name, R_OK) != 0) {
+    fprintf(stderr, "scarab_bench: cannot read trace %s, skipping uop_generator\n", name);
+    return insts;
+  }
+  pin_trace_file_pointer_init(1);
+  pin_trace_open(0, name);
+  ctype_pin_inst inst;
+  while (insts.size() < BENCH_FE_MAX_INSTS && pin_trace_read(0, &inst))
+    insts.push_back(inst);
+  pin_trace_close(0);
+  return insts;
+}
+
+SCARAB_BENCH(uop_generator_extract_op) {
+  static bool generator_ready = false;
+  if (!generator_ready) {
+    uop_generator_init(NUM_CORES);
+    generator_ready = true;
+  }
+  const std::vector<ctype_pin_inst>& insts = bench_trace_insts();
+  if (insts.empty()) {
+    while (state.keep_running()) {
+    }
+    return;
+  }
+
+  /* the generator only reads the instruction, the copy keeps the trace intact */
+  ctype_pin_inst inst;
+  Op op;
+  memset(&op, 0, sizeof(op));
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    inst = insts[ii++ % insts.size()];
+    while (!uop_generator_extract_op(0, &op, &inst)) {
+    }
+    bench_do_not_optimize(op.inst_info);
+  }
+}
+
+/* The PIN side of the exchange: answers every request with an op buffer */
+void* bench_mq_client(void* arg) {
+  Client client(*(const std::string*)arg);
+  ScarabOpBuffer_type buffer(BENCH_MQ_OPS_PER_BUFFER);
+  for (uint32_t ii = 0; ii < BENCH_MQ_OPS_PER_BUFFER; ii++)
+    buffer[ii].instruction_addr = 0x400000 + ii * 4;
+  for (;;) {
+    client.receive<uint32_t>();
+    client.send(Message<ScarabOpBuffer_type>(buffer));
+  }
+  return NULL;
+}
+
+SCARAB_BENCH(message_queue_op_buffer) {
+  /* the client thread blocks in receive between runs; both ends are left
+     open until the process exits */
+  static Server* server = NULL;
+  static std::string socket_path;
+  if (!server) {
+    socket_path = "/tmp/scarab_bench_" + std::to_string(getpid()) + ".sock";
+    pthread_t client_thread;
+    pthread_create(&client_thread, NULL, bench_mq_client, &socket_path);
+    pthread_detach(client_thread);
+    server = new Server(socket_path, 1);
+    unlink(socket_path.c_str());
+  }
+  state.set_items_per_iteration(BENCH_MQ_OPS_PER_BUFFER);
+
+  while (state.keep_running()) {
+    server->send(0, Message<uint32_t>(0));
+    ScarabOpBuffer_type buffer = server->receive<ScarabOpBuffer_type>(0);
+    bench_do_not_optimize(buffer.size());
+  }
+}
+
+}  // namespace
@@ -0,0 +1,321 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : test/bench/bench_libs.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : cache_lib access/insert for every replacement policy that
+ *                runs without a memory system behind it, with and without the
+ *                lookup memo, hash_lib for both table implementations,
+ *                smalloc/sfree, list_lib against deque_lib, the double
+ *                perceptron table against the fixed-point one, and the
+ *                generic bloom filter against the blocked one.
+ ***************************************************************************************/
+
+#include <vector>
+
+#include "test/bench/bench.h"
+
+#include "libs/blocked_bloom_filter.hpp"
+#include "libs/bloom_filter.hpp"
+#include "libs/perceptron.hpp"
+
+extern "C" {
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+#include "libs/cache_lib.h"
+#include "libs/deque_lib.h"
+#include "libs/hash_lib.h"
+#include "libs/list_lib.h"
+#include "libs/malloc_lib.h"
+
+#include "statistics.h"
+}
+
+#define BENCH_CACHE_SIZE (1 << 20)
+#define BENCH_CACHE_ASSOC 16
+#define BENCH_CACHE_LINE 64
+/* addresses cycle over 4x the cache, a mix of hits and capacity misses */
+#define BENCH_CACHE_FOOTPRINT (4 * BENCH_CACHE_SIZE)
+#define BENCH_NUM_ADDRS (1 << 16)
+#define BENCH_HASH_KEYS (1 << 16)
+
+namespace {
+
+/* A fixed xorshift stream, so every run and every policy sees the same input */
+std::vector<uint64_t> bench_random_stream(uint64_t count, uint64_t range, uint64_t seed) {
+  std::vector<uint64_t> stream(count);
+  uint64_t x = seed;
+  for (uint64_t& value : stream) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    value = x % range;
+  }
+  return stream;
+}
+
+/* cache_lib and hash_lib have no destructors, so each structure is built on
+   the first run and stays warm for the longer ones */
+void bench_cache(Bench_State& state, Repl_Policy policy) {
+  static Cache caches[NUM_REPL];
+  static bool cache_ready[NUM_REPL];
+  Cache& cache = caches[policy];
+  if (!cache_ready[policy]) {
+    init_cache(&cache, "BENCH_CACHE", BENCH_CACHE_SIZE, BENCH_CACHE_ASSOC, BENCH_CACHE_LINE, sizeof(uint64_t), policy);
+    cache_ready[policy] = true;
+  }
+  std::vector<uint64_t> addrs = bench_random_stream(BENCH_NUM_ADDRS, BENCH_CACHE_FOOTPRINT / BENCH_CACHE_LINE, 1);
+  for (uint64_t& addr : addrs)
+    addr *= BENCH_CACHE_LINE;
+
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    Addr addr = addrs[ii++ & (BENCH_NUM_ADDRS - 1)];
+    Addr line_addr, repl_line_addr;
+    void* data = cache_access(&cache, addr, &line_addr, TRUE);
+    if (!data)
+      data = cache_insert(&cache, 0, addr, &line_addr, &repl_line_addr);
+    bench_do_not_optimize(data);
+  }
+}
+
+/* A prefetch filter probe followed by the demand access to the same line, then
+   an insert on a miss, the pattern the lookup memo is for */
+void bench_cache_probe(Bench_State& state, uns memo_entries) {
+  static Cache caches[2];
+  static bool cache_ready[2];
+  Cache& cache = caches[memo_entries != 0];
+  if (!cache_ready[memo_entries != 0]) {
+    init_cache(&cache, "BENCH_CACHE", BENCH_CACHE_SIZE, BENCH_CACHE_ASSOC, BENCH_CACHE_LINE, sizeof(uint64_t),
+               REPL_TRUE_LRU);
+    cache_enable_lookup_memo(&cache, memo_entries, 0, L1_LOOKUP_MEMO_MISS);
+    cache_ready[memo_entries != 0] = true;
+  }
+  std::vector<uint64_t> addrs = bench_random_stream(BENCH_NUM_ADDRS, BENCH_CACHE_FOOTPRINT / BENCH_CACHE_LINE, 3);
+  for (uint64_t& addr : addrs)
+    addr *= BENCH_CACHE_LINE;
+
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    Addr addr = addrs[ii++ & (BENCH_NUM_ADDRS - 1)];
+    Addr line_addr, repl_line_addr;
+    void* data = cache_access(&cache, addr, &line_addr, FALSE);
+    data = cache_access(&cache, addr, &line_addr, TRUE);
+    if (!data)
+      data = cache_insert(&cache, 0, addr, &line_addr, &repl_line_addr);
+    bench_do_not_optimize(data);
+  }
+}
+
+void bench_hash(Bench_State& state, Hash_Table_Impl impl) {
+  static Hash_Table tables[NUM_HASH_TABLE_IMPLS];
+  static bool table_ready[NUM_HASH_TABLE_IMPLS];
+  Hash_Table& table = tables[impl];
+  if (!table_ready[impl]) {
+    init_hash_table_impl(&table, "BENCH_HASH", BENCH_HASH_KEYS, sizeof(uint64_t), impl);
+    table_ready[impl] = true;
+  }
+  std::vector<uint64_t> keys = bench_random_stream(BENCH_HASH_KEYS, 4 * BENCH_HASH_KEYS, 2);
+
+  /* access_create on a random key, deleting every fourth one to keep the
+     table from filling up */
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    int64 key = keys[ii++ & (BENCH_HASH_KEYS - 1)];
+    Flag new_entry;
+    uint64_t* data = (uint64_t*)hash_table_access_create(&table, key, &new_entry);
+    (*data)++;
+    if ((ii & 3) == 0)
+      hash_table_access_delete(&table, key);
+  }
+}
+
+/* Allocates a window of objects of mixed sizes and frees the oldest, so the
+   free lists of several classes stay busy */
+void bench_smalloc(Bench_State& state) {
+  const uint64_t window = 1024;
+  std::vector<void*> objs(window, nullptr);
+  std::vector<uint64_t> sizes = bench_random_stream(window, 256, 4);
+
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    uint64_t slot = ii++ & (window - 1);
+    int nbytes = 8 + (int)sizes[slot];
+    if (objs[slot])
+      sfree(nbytes, objs[slot]);
+    objs[slot] = smalloc(nbytes);
+    bench_do_not_optimize(objs[slot]);
+  }
+  for (uint64_t slot = 0; slot < window; slot++) {
+    if (objs[slot])
+      sfree(8 + (int)sizes[slot], objs[slot]);
+  }
+}
+
+/* The seq_op_list pattern: a window of pointers added at the tail, retired at
+   the head, and walked from the tail on every step */
+#define BENCH_SEQ_WINDOW 256
+#define BENCH_SEQ_WALK 8
+
+void bench_list_seq(Bench_State& state) {
+  List list;
+  init_list(&list, (char*)"bench", sizeof(uint64_t), TRUE);
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    *(uint64_t*)dl_list_add_tail(&list) = ii++;
+    if (list.count > BENCH_SEQ_WINDOW)
+      bench_do_not_optimize(dl_list_remove_head(&list));
+    uint64_t* value = (uint64_t*)list_start_tail_traversal(&list);
+    for (int jj = 0; value && jj < BENCH_SEQ_WALK; jj++)
+      value = (uint64_t*)list_prev_element(&list);
+    bench_do_not_optimize(value);
+  }
+  clear_list(&list);
+}
+
+void bench_deque_seq(Bench_State& state) {
+  Deque deque;
+  init_deque(&deque, "bench", sizeof(uint64_t), BENCH_SEQ_WINDOW);
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    *(uint64_t*)deque_add_tail(&deque) = ii++;
+    if (deque.count > BENCH_SEQ_WINDOW)
+      bench_do_not_optimize(deque_remove_head(&deque));
+    uint64_t* value = (uint64_t*)deque_start_tail_traversal(&deque);
+    for (int jj = 0; value && jj < BENCH_SEQ_WALK; jj++)
+      value = (uint64_t*)deque_prev_element(&deque);
+    bench_do_not_optimize(value);
+  }
+  clear_deque(&deque);
+}
+
+/* One lookup per iteration: extract the features of a random input, predict,
+   and train on the outcome */
+#define BENCH_PERCEPTRON_FEATURES 32
+#define BENCH_PERCEPTRON_ENTRIES 1024
+#define BENCH_PERCEPTRON_WEIGHT_WIDTH 6
+
+void bench_perceptron_double(Bench_State& state) {
+  PerceptronTable<> table(BENCH_PERCEPTRON_FEATURES, BENCH_PERCEPTRON_ENTRIES, 1.0, 0.0,
+                          BENCH_PERCEPTRON_WEIGHT_WIDTH, 0.0);
+  std::vector<double> features(BENCH_PERCEPTRON_FEATURES);
+  std::vector<uint64_t> inputs = bench_random_stream(BENCH_NUM_ADDRS, 1ULL << 40, 5);
+
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    uint64_t input = inputs[ii++ & (BENCH_NUM_ADDRS - 1)];
+    PerceptronTable<>::extract_bipolar_features((int)input, features.data(), BENCH_PERCEPTRON_FEATURES);
+    double sum;
+    bool prediction;
+    table.predict(features, sum, prediction, input >> 32, 0);
+    table.train(features, prediction, (input ^ (input >> 7)) & 1, sum, input >> 32, 0);
+    bench_do_not_optimize(sum);
+  }
+}
+
+template <typename Weight_Type>
+void bench_perceptron_fixed(Bench_State& state) {
+  typedef FixedPerceptronTable<PCBasedIndex, Weight_Type> Table;
+  Table table(BENCH_PERCEPTRON_FEATURES, BENCH_PERCEPTRON_ENTRIES, BENCH_PERCEPTRON_WEIGHT_WIDTH, 0);
+  std::vector<Weight_Type> features = table.new_features();
+  std::vector<uint64_t> inputs = bench_random_stream(BENCH_NUM_ADDRS, 1ULL << 40, 5);
+
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    uint64_t input = inputs[ii++ & (BENCH_NUM_ADDRS - 1)];
+    Table::extract_bipolar_features((int)input, features.data(), BENCH_PERCEPTRON_FEATURES);
+    int32_t sum;
+    bool prediction;
+    table.predict(features, sum, prediction, input >> 32, 0);
+    table.train(features, (input ^ (input >> 7)) & 1, sum, input >> 32, 0);
+    bench_do_not_optimize(sum);
+  }
+}
+
+/* Lookups of random lines against a filter holding as many lines as the FDIP
+   bloom filter does before it is cleared */
+#define BENCH_BLOOM_ENTRIES 4000
+
+void bench_bloom_generic(Bench_State& state) {
+  bloom_parameters parameters;
+  parameters.projected_element_count = BENCH_BLOOM_ENTRIES;
+  parameters.false_positive_probability = 0.005;
+  parameters.compute_optimal_parameters();
+  bloom_filter filter(parameters);
+  std::vector<uint64_t> lines = bench_random_stream(BENCH_NUM_ADDRS, 1ULL << 20, 11);
+  for (uint64_t ii = 0; ii < BENCH_BLOOM_ENTRIES; ii++)
+    filter.insert(lines[ii]);
+
+  uint64_t ii = 0;
+  while (state.keep_running())
+    bench_do_not_optimize(filter.contains(lines[ii++ & (BENCH_NUM_ADDRS - 1)]));
+}
+
+void bench_bloom_blocked(Bench_State& state) {
+  Blocked_Bloom_Filter filter(BENCH_BLOOM_ENTRIES, 0.005);
+  std::vector<uint64_t> lines = bench_random_stream(BENCH_NUM_ADDRS, 1ULL << 20, 11);
+  for (uint64_t ii = 0; ii < BENCH_BLOOM_ENTRIES; ii++)
+    filter.insert(lines[ii]);
+
+  uint64_t ii = 0;
+  while (state.keep_running())
+    bench_do_not_optimize(filter.contains(lines[ii++ & (BENCH_NUM_ADDRS - 1)]));
+}
+
+struct Bench_Repl_Policy {
+  const char* name;
+  Repl_Policy policy;
+};
+
+const Bench_Repl_Policy bench_repl_policies[] = {
+    {"true_lru", REPL_TRUE_LRU}, {"random", REPL_RANDOM}, {"not_mru", REPL_NOT_MRU},
+    {"round_robin", REPL_ROUND_ROBIN}, {"lru_ref", REPL_LRU_REF}, {"nru", REPL_NRU},
+    {"srrip", REPL_SRRIP}, {"brrip", REPL_BRRIP}, {"drrip", REPL_DRRIP},
+    {"ship", REPL_SHIP},
+};
+
+bool bench_register_libs() {
+  for (const Bench_Repl_Policy& repl : bench_repl_policies) {
+    Repl_Policy policy = repl.policy;
+    Bench_Registrar(std::string("cache_access_insert/") + repl.name,
+                    [policy](Bench_State& state) { bench_cache(state, policy); });
+  }
+  Bench_Registrar("cache_probe_access/memo_off", [](Bench_State& state) { bench_cache_probe(state, 0); });
+  Bench_Registrar("cache_probe_access/memo_4", [](Bench_State& state) { bench_cache_probe(state, 4); });
+  Bench_Registrar("hash_lib_access_create/chained", [](Bench_State& state) { bench_hash(state, HASH_TABLE_CHAINED); });
+  Bench_Registrar("hash_lib_access_create/open", [](Bench_State& state) { bench_hash(state, HASH_TABLE_OPEN); });
+  Bench_Registrar("smalloc_sfree", bench_smalloc);
+  Bench_Registrar("seq_list/list", bench_list_seq);
+  Bench_Registrar("seq_list/deque", bench_deque_seq);
+  Bench_Registrar("perceptron_lookup/double", bench_perceptron_double);
+  Bench_Registrar("perceptron_lookup/int16", bench_perceptron_fixed<int16_t>);
+  Bench_Registrar("perceptron_lookup/int8", bench_perceptron_fixed<int8_t>);
+  Bench_Registrar("bloom_lookup/generic", bench_bloom_generic);
+  Bench_Registrar("bloom_lookup/blocked", bench_bloom_blocked);
+  return true;
+}
+
+const bool bench_libs_registered = bench_register_libs();
+
+}  // namespace
@@ -0,0 +1,194 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : test/bench/bench_main.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Runs the registered benchmarks and reports them on stdout and,
+ *                with --benchmark_out, as google-benchmark JSON.
+ *
+ *                Simulator parameters keep their defaults; the global counters
+ *                and stats are set up the way init_global() does so that the
+ *                libraries under test can count events.
+ ***************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <regex>
+
+#include "test/bench/bench.h"
+
+extern "C" {
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+#include "globals/global_vars.h"
+
+#include "general.param.h"
+
+#include "sim.h"
+#include "statistics.h"
+}
+
+#define BENCH_MAX_ITERATIONS 1000000000ULL
+
+std::vector<Bench_Info>& bench_registry() {
+  static std::vector<Bench_Info> registry;
+  return registry;
+}
+
+namespace {
+
+struct Bench_Result {
+  std::string name;
+  uint64_t iterations;
+  double real_ns;
+  double cpu_ns;
+  double items_per_second;
+};
+
+double cpu_seconds() {
+  struct timespec now;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/* Grows the iteration count geometrically until one run lasts min_time */
+Bench_Result run_bench(const Bench_Info& bench, double min_time) {
+  uint64_t iterations = 1;
+  for (;;) {
+    Bench_State state(iterations);
+    double cpu_start = cpu_seconds();
+    bench.func(state);
+    double cpu = cpu_seconds() - cpu_start;
+    double real = state.elapsed_seconds();
+    if (real >= min_time || iterations >= BENCH_MAX_ITERATIONS) {
+      double items = (double)iterations * state.items_per_iteration();
+      return {bench.name, iterations, real * 1e9 / iterations, cpu * 1e9 / iterations, real > 0 ? items / real : 0.0};
+    }
+    double scale = real > 0 ? 1.4 * min_time / real : 10.0;
+    iterations = (uint64_t)(iterations * std::min(std::max(scale, 2.0), 10.0));
+  }
+}
+
+void write_json(FILE* out, const std::vector<Bench_Result>& results) {
+  char host[256] = "";
+  gethostname(host, sizeof(host) - 1);
+  time_t now = time(NULL);
+  char date[64];
+  strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", localtime(&now));
+
+  fprintf(out, "{\n  \"context\": {\n");
+  fprintf(out, "    \"date\": \"%s\",\n", date);
+  fprintf(out, "    \"host_name\": \"%s\",\n", host);
+  fprintf(out, "    \"executable\": \"scarab_bench\",\n");
+  fprintf(out, "    \"num_cpus\": %ld,\n", sysconf(_SC_NPROCESSORS_ONLN));
+#ifdef NO_DEBUG
+  fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+  fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+  fprintf(out, "  },\n  \"benchmarks\": [\n");
+  for (size_t ii = 0; ii < results.size(); ii++) {
+    const Bench_Result& r = results[ii];
+    fprintf(out, "    {\n");
+    fprintf(out, "      \"name\": \"%s\",\n", r.name.c_str());
+    fprintf(out, "      \"run_name\": \"%s\",\n", r.name.c_str());
+    fprintf(out, "      \"run_type\": \"iteration\",\n");
+    fprintf(out, "      \"iterations\": %llu,\n", (unsigned long long)r.iterations);
+    fprintf(out, "      \"real_time\": %.4f,\n", r.real_ns);
+    fprintf(out, "      \"cpu_time\": %.4f,\n", r.cpu_ns);
+    fprintf(out, "      \"time_unit\": \"ns\",\n");
+    fprintf(out, "      \"items_per_second\": %.4f\n", r.items_per_second);
+    fprintf(out, "    }%s\n", ii + 1 < results.size() ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+void usage(const char* prog) {
+  fprintf(stderr,
+          "usage: %s [--benchmark_filter=<regex>] [--benchmark_min_time=<seconds>]\n"
+          "          [--benchmark_out=<file.json>] [--benchmark_list_tests]\n",
+          prog);
+  exit(1);
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  const char* filter = ".";
+  const char* out_name = NULL;
+  double min_time = 0.5;
+  bool list = false;
+  for (int ii = 1; ii < argc; ii++) {
+    if (!strncmp(argv[ii], "--benchmark_filter=", 19))
+      filter = argv[ii] + 19;
+    else if (!strncmp(argv[ii], "--benchmark_min_time=", 21))
+      min_time = atof(argv[ii] + 21);
+    else if (!strncmp(argv[ii], "--benchmark_out=", 16))
+      out_name = argv[ii] + 16;
+    else if (!strcmp(argv[ii], "--benchmark_list_tests"))
+      list = true;
+    else
+      usage(argv[0]);
+  }
+
+  mystdout = stdout;
+  mystderr = stderr;
+  mystatus = NULL;
+  init_global_counter();
+  init_global_stats_array();
+  for (uns proc_id = 0; proc_id < NUM_CORES; proc_id++)
+    init_global_stats(proc_id);
+
+  std::regex filter_re(filter);
+  std::vector<Bench_Result> results;
+  if (!list)
+    printf("%-48s %14s %14s %12s\n", "Benchmark", "Time (ns)", "CPU (ns)", "Iterations");
+  for (const Bench_Info& bench : bench_registry()) {
+    if (!std::regex_search(bench.name, filter_re))
+      continue;
+    if (list) {
+      printf("%s\n", bench.name.c_str());
+      continue;
+    }
+    Bench_Result result = run_bench(bench, min_time);
+    printf("%-48s %14.1f %14.1f %12llu\n", result.name.c_str(), result.real_ns, result.cpu_ns,
+           (unsigned long long)result.iterations);
+    fflush(stdout);
+    results.push_back(result);
+  }
+
+  if (out_name) {
+    FILE* out = fopen(out_name, "w");
+    if (!out) {
+      fprintf(stderr, "Cannot open %s\n", out_name);
+      return 1;
+    }
+    write_json(out, results);
+    fclose(out);
+  }
+  return 0;
+}
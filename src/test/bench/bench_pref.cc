@@ -0,0 +1,210 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/***************************************************************************************
+ * File         : test/bench/bench_pref.cc
+ * Author       : HPS Research Group
+ * Date         : 10/15/2026
+ * Description  : Per-miss cost of the GHB, Markov, Bingo and stream data prefetchers,
+ *                replaying an L1 miss stream into each one's hooks. The stream
+ *                is the UL1_MISS / UL1_EVICT records of a prefetcher trace
+ *                ($SCARAB_BENCH_MISS_STREAM, written with --pref_trace_on), or
+ *                by default the misses and evictions of a 32KB L1 on a fixed mix
+ *                of strided, pointer-chasing and page-footprint accesses.
+ ***************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "test/bench/bench.h"
+
+extern "C" {
+#include "globals/global_defs.h"
+#include "globals/global_types.h"
+
+#include "libs/cache_lib.h"
+
+#include "prefetcher/pref.param.h"
+#include "prefetcher/pref_bingo.h"
+#include "prefetcher/pref_bingo.param.h"
+#include "prefetcher/pref_common.h"
+#include "prefetcher/pref_ghb.h"
+#include "prefetcher/pref_ghb.param.h"
+#include "prefetcher/pref_markov.h"
+#include "prefetcher/pref_markov.param.h"
+#include "prefetcher/pref_stream.h"
+#include "prefetcher/stream.param.h"
+}
+
+#define BENCH_PREF_L1_SIZE (32 << 10)
+#define BENCH_PREF_L1_ASSOC 8
+#define BENCH_PREF_LINE 64
+#define BENCH_PREF_NUM_ACCESSES (1 << 18)
+#define BENCH_PREF_MAX_EVENTS (1 << 20)
+
+namespace {
+
+struct Bench_Miss_Event {
+  uint64_t pc;
+  uint64_t line_addr;
+  bool evict;
+};
+
+/* Reads the UL1 misses and evictions of a prefetcher trace:
+   "<cycle> \t <pc> \t <line addr> \t <event>" in hex */
+bool bench_read_miss_stream(const char* name, std::vector<Bench_Miss_Event>& events) {
+  FILE* file = fopen(name, "r");
+  if (!file) {
+    fprintf(stderr, "scarab_bench: cannot read miss stream %s, using the generated one\n", name);
+    return false;
+  }
+  char line[256];
+  while (events.size() < BENCH_PREF_MAX_EVENTS && fgets(line, sizeof(line), file)) {
+    unsigned long long cycle, pc, addr;
+    char kind[32];
+    if (sscanf(line, "%llx %llx %llx %31s", &cycle, &pc, &addr, kind) != 4)
+      continue;
+    if (!strcmp(kind, "UL1_MISS"))
+      events.push_back({pc, addr & ~(uint64_t)(BENCH_PREF_LINE - 1), false});
+    else if (!strcmp(kind, "UL1_EVICT"))
+      events.push_back({0, addr & ~(uint64_t)(BENCH_PREF_LINE - 1), true});
+  }
+  fclose(file);
+  return !events.empty();
+}
+
+/* Strided array walks, a pointer chase over a fixed permutation and per-pc
+   footprints within 4KB pages, run through an LRU L1 */
+void bench_generate_miss_stream(std::vector<Bench_Miss_Event>& events) {
+  Cache l1;
+  init_cache(&l1, "BENCH_PREF_L1", BENCH_PREF_L1_SIZE, BENCH_PREF_L1_ASSOC, BENCH_PREF_LINE, sizeof(uint64_t),
+             REPL_TRUE_LRU);
+
+  const uint64_t chase_lines = 1 << 14;
+  std::vector<uint64_t> chase(chase_lines);
+  for (uint64_t ii = 0; ii < chase_lines; ii++)
+    chase[ii] = ii;
+  uint64_t x = 7;
+  for (uint64_t ii = chase_lines - 1; ii > 0; ii--) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    std::swap(chase[ii], chase[x % (ii + 1)]);
+  }
+
+  uint64_t stride_pos[3] = {0, 0, 0};
+  uint64_t chase_pos = 0;
+  uint64_t page = 0;
+  for (uint64_t ii = 0; ii < BENCH_PREF_NUM_ACCESSES; ii++) {
+    uint64_t pc, addr;
+    switch (ii % 4) {
+      case 0:
+      case 1: {  // unit, 2 and 3 line strides through separate 64MB arrays
+        const uint64_t stream = (ii >> 1) % 3;
+        pc = 0x401000 + stream * 0x10;
+        addr = ((stream + 1) << 26) + (stride_pos[stream]++ * (stream + 1) % (1 << 20)) * BENCH_PREF_LINE;
+        break;
+      }
+      case 2:  // the same linked list over and over
+        pc = 0x402000;
+        chase_pos = chase[chase_pos];
+        addr = (1ULL << 30) + chase_pos * BENCH_PREF_LINE;
+        break;
+      default: {  // eight lines of a new page in a pc-specific pattern
+        const uint64_t site = (ii >> 5) % 16;
+        pc = 0x403000 + site * 0x10;
+        if ((ii >> 2) % 8 == 0)
+          page++;
+        addr = (1ULL << 32) + (page % (1 << 16)) * 4096 + (((ii >> 2) % 8) * (site + 3) % 64) * BENCH_PREF_LINE;
+        break;
+      }
+    }
+    Addr line_addr, repl_line_addr;
+    if (cache_access(&l1, addr, &line_addr, TRUE))
+      continue;
+    events.push_back({pc, line_addr, false});
+    cache_insert(&l1, 0, addr, &line_addr, &repl_line_addr);
+    if (repl_line_addr)
+      events.push_back({0, repl_line_addr, true});
+  }
+}
+
+const std::vector<Bench_Miss_Event>& bench_miss_stream() {
+  static std::vector<Bench_Miss_Event> events;
+  if (events.empty()) {
+    const char* name = getenv("SCARAB_BENCH_MISS_STREAM");
+    if (!name || !bench_read_miss_stream(name, events))
+      bench_generate_miss_stream(events);
+  }
+  return events;
+}
+
+/* The prefetchers train and queue their requests in the UL1 queue, which
+   nothing drains here, so it is allowed to wrap */
+void bench_pref_init() {
+  static bool pref_ready = false;
+  if (pref_ready)
+    return;
+  PREF_FRAMEWORK_ON = TRUE;
+  PREF_UL1_ON = TRUE;
+  PREF_UL1REQ_QUEUE_OVERWRITE_ON_FULL = TRUE;
+  PREF_GHB_ON = TRUE;
+  PREF_MARKOV_ON = TRUE;
+  PREF_BINGO_ON = TRUE;
+  PREF_STREAM_ON = TRUE;
+  DEBUG_PREF_BINGO = FALSE;
+  pref_init();
+  pref_ready = true;
+}
+
+typedef void (*Bench_Pref_Miss_Func)(uns8, Addr, Addr, uns32);
+typedef void (*Bench_Pref_Evict_Func)(uns8, Addr);
+
+void bench_pref_replay(Bench_State& state, Bench_Pref_Miss_Func miss_func, Bench_Pref_Evict_Func evict_func) {
+  bench_pref_init();
+  const std::vector<Bench_Miss_Event>& events = bench_miss_stream();
+  uint64_t ii = 0;
+  while (state.keep_running()) {
+    const Bench_Miss_Event& event = events[ii++ % events.size()];
+    if (!event.evict)
+      miss_func(0, event.line_addr, event.pc, 0);
+    else if (evict_func)
+      evict_func(0, event.line_addr);
+  }
+}
+
+Bench_Registrar bench_pref_ghb("pref_replay_l1_misses/ghb", [](Bench_State& state) {
+  bench_pref_replay(state, pref_ghb_ul1_miss, NULL);
+});
+Bench_Registrar bench_pref_markov("pref_replay_l1_misses/markov", [](Bench_State& state) {
+  bench_pref_replay(state, pref_markov_ul1_miss, NULL);
+});
+Bench_Registrar bench_pref_bingo("pref_replay_l1_misses/bingo", [](Bench_State& state) {
+  bench_pref_replay(state, pref_bingo_ul1_miss, pref_bingo_ul1_cache_evict);
+});
+Bench_Registrar bench_pref_stream("pref_replay_l1_misses/stream", [](Bench_State& state) {
+  bench_pref_replay(state, pref_stream_ul1_miss, NULL);
+});
+
+}  // namespace
@@ -27,7 +27,7 @@ FILE* mystdout = stdout;
 FILE* mystderr = stderr;
 FILE* mystatus = stdout;
 
-Counter  cycle_count  = 0;
+CORE_LOCAL Counter cycle_count = 0;
 Counter  unique_count = 0;
 Counter* op_count;
 Counter* inst_count;
@@ -35,6 +35,6 @@ Counter* unique_count_per_core;
 Flag*    trace_read_done;
 
 // const char* PIN_EXEC_DRIVEN_FE_SOCKET = "./temp.socket";
-const char* FILE_TAG             = "";
-uns         INST_HASH_TABLE_SIZE = 500021;
+char*       FILE_TAG             = (char*)"";
+const uns   INST_HASH_TABLE_SIZE = 500021;
 int         op_type_delays[NUM_OP_TYPES];
@@ -0,0 +1,222 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*
+ * Drives Flat_Cache and a reference cache with the same random stream of accesses,
+ * fills and invalidations and checks that they hit and evict the same lines. True
+ * LRU is checked against Cpp_Cache; Cpp_Cache has no tree-PLRU or RRIP policy, so
+ * those are checked against the straightforward models below.
+ */
+
+#include <random>
+#include <vector>
+
+#include "../libs/cpp_cache.h"
+#include "../libs/flat_cache.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+const uns NUM_LINES = 64;
+const uns ASSOC = 8;
+const uns NUM_KEYS = 3 * NUM_LINES;
+const uns NUM_STEPS = 100000;
+
+struct Key_Hash {
+  uns64 operator()(uns64 key) const { return key; }
+};
+
+class Lru_Cpp_Cache : public Cpp_Cache<uns64, uns64> {
+ public:
+  Lru_Cpp_Cache() : Cpp_Cache<uns64, uns64>(NUM_LINES, ASSOC, 1, REPL_TRUE_LRU) {}
+
+ protected:
+  uns set_idx_hash(uns64 key) override { return set_idx_from_hash(key); }
+};
+
+// Tree pseudo-LRU kept as one bool per node; a node set to true sends the victim
+// search to the upper half of the ways below it.
+class Ref_PLRU {
+ public:
+  void init(uns num_sets, uns num_ways) {
+    ways = num_ways;
+    trees.assign(num_sets, std::vector<bool>(ways, false));
+  }
+  void touch(uns set, uns way) {
+    uns node = 1, lo = 0, hi = ways;
+    while (hi - lo > 1) {
+      const uns mid = (lo + hi) / 2;
+      const bool upper = way >= mid;
+      trees[set][node] = !upper;
+      node = 2 * node + upper;
+      (upper ? lo : hi) = mid;
+    }
+  }
+  void insert(uns set, uns way) { touch(set, way); }
+  uns victim(uns set) {
+    uns node = 1, lo = 0, hi = ways;
+    while (hi - lo > 1) {
+      const uns mid = (lo + hi) / 2;
+      const bool upper = trees[set][node];
+      node = 2 * node + upper;
+      (upper ? lo : hi) = mid;
+    }
+    return lo;
+  }
+
+ private:
+  uns ways;
+  std::vector<std::vector<bool>> trees;
+};
+
+// 2-bit SRRIP as in the paper: age the whole set one step at a time until some
+// line is predicted distant, then evict the first such line.
+class Ref_RRIP {
+ public:
+  void init(uns num_sets, uns num_ways) {
+    ways = num_ways;
+    rrpvs.assign(num_sets, std::vector<uns>(ways, 3));
+  }
+  void touch(uns set, uns way) { rrpvs[set][way] = 0; }
+  void insert(uns set, uns way) { rrpvs[set][way] = 2; }
+  uns victim(uns set) {
+    while (true) {
+      for (uns ii = 0; ii < ways; ii++) {
+        if (rrpvs[set][ii] == 3)
+          return ii;
+      }
+      for (uns ii = 0; ii < ways; ii++)
+        rrpvs[set][ii]++;
+    }
+  }
+
+ private:
+  uns ways;
+  std::vector<std::vector<uns>> rrpvs;
+};
+
+// Set-associative cache around a reference policy, filling the lowest invalid way first
+template <typename Ref_Policy>
+class Ref_Cache {
+ public:
+  Ref_Cache() : entries(NUM_LINES) { policy.init(NUM_LINES / ASSOC, ASSOC); }
+
+  uns64* access(uns64 key, bool update_repl) {
+    const uns set = key % (NUM_LINES / ASSOC);
+    for (uns ii = 0; ii < ASSOC; ii++) {
+      Entry<uns64, uns64>& entry = entries[set * ASSOC + ii];
+      if (entry.valid && entry.key == key) {
+        if (update_repl)
+          policy.touch(set, ii);
+        return &entry.data;
+      }
+    }
+    return NULL;
+  }
+  Entry<uns64, uns64> insert(uns64 key, uns64 data) {
+    const uns set = key % (NUM_LINES / ASSOC);
+    uns way = ASSOC;
+    for (uns ii = 0; ii < ASSOC && way == ASSOC; ii++) {
+      if (!entries[set * ASSOC + ii].valid)
+        way = ii;
+    }
+    if (way == ASSOC)
+      way = policy.victim(set);
+    Entry<uns64, uns64> evicted_entry = entries[set * ASSOC + way];
+    entries[set * ASSOC + way] = Entry<uns64, uns64>{TRUE, key, data, 0};
+    policy.insert(set, way);
+    return evicted_entry;
+  }
+  Entry<uns64, uns64> invalidate(uns64 key) {
+    const uns set = key % (NUM_LINES / ASSOC);
+    for (uns ii = 0; ii < ASSOC; ii++) {
+      Entry<uns64, uns64>& entry = entries[set * ASSOC + ii];
+      if (entry.valid && entry.key == key) {
+        Entry<uns64, uns64> invalidated_entry = entry;
+        entry.valid = FALSE;
+        return invalidated_entry;
+      }
+    }
+    return Entry<uns64, uns64>{};
+  }
+
+ private:
+  std::vector<Entry<uns64, uns64>> entries;
+  Ref_Policy policy;
+};
+
+// Accesses a random key in both caches, filling it on a miss; one step in 16
+// invalidates it instead. Every access is on a new cycle so Cpp_Cache's LRU
+// timestamps never tie.
+template <typename Test_Cache, typename Ref>
+void compare_victims(Test_Cache& test_cache, Ref& ref_cache) {
+  std::mt19937 rng(0);
+  Counter evictions = 0;
+  for (uns step = 0; step < NUM_STEPS; step++) {
+    cycle_count++;
+    const uns64 key = rng() % NUM_KEYS;
+    if (rng() % 16 == 0) {
+      const Entry<uns64, uns64> test_entry = test_cache.invalidate(key);
+      const Entry<uns64, uns64> ref_entry = ref_cache.invalidate(key);
+      ASSERT_EQ(test_entry.valid, ref_entry.valid) << "step " << step;
+      continue;
+    }
+
+    const bool update_repl = rng() % 8 != 0;
+    uns64* test_data = test_cache.access(key, update_repl);
+    uns64* ref_data = ref_cache.access(key, update_repl);
+    ASSERT_EQ(test_data == NULL, ref_data == NULL) << "step " << step;
+    if (test_data) {
+      EXPECT_EQ(*test_data, *ref_data);
+      continue;
+    }
+
+    const Entry<uns64, uns64> test_entry = test_cache.insert(key, key * 3);
+    const Entry<uns64, uns64> ref_entry = ref_cache.insert(key, key * 3);
+    ASSERT_EQ(test_entry.valid, ref_entry.valid) << "step " << step;
+    if (test_entry.valid) {
+      ASSERT_EQ(test_entry.key, ref_entry.key) << "step " << step;
+      evictions++;
+    }
+  }
+  // the stream is only useful if it exercises victim selection
+  EXPECT_GT(evictions, NUM_STEPS / 4);
+}
+
+}  // namespace
+
+TEST(FlatCacheTest, LruMatchesCppCache) {
+  Flat_Cache<uns64, uns64, Flat_Cache_LRU, Key_Hash> flat_cache(NUM_LINES, ASSOC);
+  Lru_Cpp_Cache cpp_cache;
+  compare_victims(flat_cache, cpp_cache);
+}
+
+TEST(FlatCacheTest, PlruMatchesReference) {
+  Flat_Cache<uns64, uns64, Flat_Cache_PLRU, Key_Hash> flat_cache(NUM_LINES, ASSOC);
+  Ref_Cache<Ref_PLRU> ref_cache;
+  compare_victims(flat_cache, ref_cache);
+}
+
+TEST(FlatCacheTest, RripMatchesReference) {
+  Flat_Cache<uns64, uns64, Flat_Cache_RRIP, Key_Hash> flat_cache(NUM_LINES, ASSOC);
+  Ref_Cache<Ref_RRIP> ref_cache;
+  compare_victims(flat_cache, ref_cache);
+}
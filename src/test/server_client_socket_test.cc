@@ -61,6 +61,8 @@ class ServerTest : public ::testing::Test {
 
   void TearDown() override {}
 
+  void server_poll_test();
+  void server_receive_into_test();
   void server_bandwidth_test();
 
   Server*         server;
@@ -135,9 +137,51 @@ TEST_F(ServerTest, ServerSendRecvTest) {
     EXPECT_EQ(message_test.expected_deque_message, test_deque_message);
   }
 
+  server_poll_test();
+  server_receive_into_test();
   server_bandwidth_test();
 }
 
+// Send to every client first, then take the replies in arrival order
+void ServerTest::server_poll_test() {
+  std::vector<uint32_t> waiting;
+  for(uint32_t i = 0; i < NUM_CLIENTS; ++i) {
+    server->send(i, message_test.int_message);
+    waiting.push_back(i);
+  }
+
+  while(!waiting.empty()) {
+    std::vector<uint32_t> ready = server->poll_clients(waiting);
+    EXPECT_FALSE(ready.empty());
+    for(uint32_t id : ready) {
+      int32_t test_int_message = server->receive<int32_t>(id);
+      EXPECT_EQ(message_test.expected_int_message, test_int_message);
+      waiting.erase(std::find(waiting.begin(), waiting.end(), id));
+    }
+  }
+
+  std::vector<uint32_t> all_clients;
+  for(uint32_t i = 0; i < NUM_CLIENTS; ++i) {
+    all_clients.push_back(i);
+  }
+  EXPECT_TRUE(server->poll_clients(all_clients, 0).empty());
+}
+
+// Clients send with send_elements, straight from the container's storage
+void ServerTest::server_receive_into_test() {
+  for(uint32_t i = 0; i < NUM_CLIENTS; ++i) {
+    server->send(i, message_test.char_message);
+    std::vector<uint32_t> test_vector_message(1, 0);
+    server->receive_into(i, &test_vector_message);
+    EXPECT_EQ(message_test.expected_vector_message, test_vector_message);
+    server->send(i, message_test.char_message);
+
+    std::deque<uint32_t> test_deque_message(1, 0);
+    server->receive_into(i, &test_deque_message);
+    EXPECT_EQ(message_test.expected_deque_message, test_deque_message);
+  }
+}
+
 // TEST_F(ServerTest, ServerBandwidthTest) {
 void ServerTest::server_bandwidth_test() {
   std::chrono::duration<double> elapsed_time = std::chrono::duration<double>(
@@ -187,6 +231,8 @@ class ClientTest : public ::testing::Test {
 
   void TearDown() override {}
 
+  void client_poll_test();
+  void client_send_elements_test();
   void client_bandwidth_test();
 
   Client*         client;
@@ -237,9 +283,26 @@ TEST_F(ClientTest, ClientSendRecvTest) {
 
   client->send(message_test.deque_message);
 
+  client_poll_test();
+  client_send_elements_test();
   client_bandwidth_test();
 }
 
+void ClientTest::client_poll_test() {
+  int32_t test_int_message = client->receive<int32_t>();
+  EXPECT_EQ(message_test.expected_int_message, test_int_message);
+
+  client->send(message_test.int_message);
+}
+
+void ClientTest::client_send_elements_test() {
+  // Wait for the server before each send, the socket does not frame messages
+  client->receive<char>();
+  client->send_elements(message_test.expected_vector_message);
+  client->receive<char>();
+  client->send_elements(message_test.expected_deque_message);
+}
+
 // TEST_F(ClientTest, ClientBandwidthTest) {
 void ClientTest::client_bandwidth_test() {
   for(uint32_t j = 0; j < NUM_REPEAT; ++j) {
@@ -66,7 +66,7 @@ void set_thread_data(Thread_Data* new_td) {
 void init_thread(Thread_Data* td, char* argv[], char* envp[]) {
   set_map_data(&td->map_data);
   init_map(0);
-  init_list(&td->seq_op_list, "SEQ_OP_LIST", sizeof(Op*), TRUE);
+  init_deque(&td->seq_op_list, "SEQ_OP_LIST", sizeof(Op*), SEQ_OP_LIST_SIZE);
 }
 
 /**************************************************************************************/
@@ -86,17 +86,17 @@ void add_to_seq_op_list(Thread_Data* td, Op* op) {
   ASSERT(td->proc_id, op);
   ASSERT(td->proc_id, td->proc_id == op->proc_id);
   ASSERT(td->proc_id, op->op_pool_valid);
-  op_p = dl_list_add_tail(&td->seq_op_list);
+  op_p = deque_add_tail(&td->seq_op_list);
   *op_p = op;
   DEBUG(td->proc_id, "Adding to seq op list  op:%s  count:%d\n", unsstr64(op->op_num), td->seq_op_list.count);
-  ASSERT(td->proc_id, (td->seq_op_list.count < 8193));
+  ASSERT(td->proc_id, td->seq_op_list.count <= SEQ_OP_LIST_SIZE);
 }
 
 /**************************************************************************************/
 /* remove_from_seq_op_list: */
 
 void remove_from_seq_op_list(Thread_Data* td, Op* op) {
-  Op** op_p = dl_list_remove_head(&td->seq_op_list);
+  Op** op_p = deque_remove_head(&td->seq_op_list);
   ASSERT(td->proc_id, op_p);
   ASSERT(td->proc_id, td->proc_id == (*op_p)->proc_id);
   ASSERT(td->proc_id, *op_p);
@@ -110,25 +110,41 @@ void remove_from_seq_op_list(Thread_Data* td, Op* op) {
 /**************************************************************************************/
 /* recover_seq_op_list: */
 
+static inline Counter seq_op_num(Deque* list, int ii) {
+  return (*(Op**)deque_get(list, ii))->op_num;
+}
+
 void recover_seq_op_list(Thread_Data* td, Counter op_num) {
-  // Traverse the sequential op list and remove everything younger than the
-  // recovering op
-  Op** op_p = (Op**)list_start_head_traversal(&td->seq_op_list);
+  // Remove everything younger than the recovering op
+  Deque* list = &td->seq_op_list;
+  Op** op_p = (Op**)deque_get_head(list);
   if (op_p) {
     ASSERT(td->proc_id, *op_p);
     ASSERT(td->proc_id, td->proc_id == (*op_p)->proc_id);
-    if ((*op_p)->op_num > op_num) {
-      ASSERTM(td->proc_id, (*op_p)->op_num == op_num + 1, "Oldest in-flight op_num:%lld, recovery op_num:%lld\n",
-              (*op_p)->op_num, op_num + 1);
-      clear_list(&td->seq_op_list);
+    Counter head_op_num = (*op_p)->op_num;
+    if (head_op_num > op_num) {
+      ASSERTM(td->proc_id, head_op_num == op_num + 1, "Oldest in-flight op_num:%lld, recovery op_num:%lld\n",
+              head_op_num, op_num + 1);
+      clear_deque(list);
     } else {
-      for (; op_p; op_p = (Op**)list_next_element(&td->seq_op_list)) {
-        ASSERT(td->proc_id, (*op_p)->op_num <= op_num);
-        if ((*op_p)->op_num == op_num) {
-          clip_list_at_current(&td->seq_op_list);
-          break;
+      // op_nums in the list are consecutive (fetch restarts numbering after
+      // the recovering op), so its position follows from the head's; fall
+      // back to a binary search should that ever not hold
+      int count = deque_get_count(list);
+      int keep = op_num - head_op_num < (Counter)count ? (int)(op_num - head_op_num) + 1 : count;
+      if (seq_op_num(list, keep - 1) > op_num || (keep < count && seq_op_num(list, keep) <= op_num)) {
+        int lo = 1, hi = count;  // the first keep elements are not younger
+        while (lo < hi) {
+          int mid = (lo + hi) / 2;
+          if (seq_op_num(list, mid) <= op_num)
+            lo = mid + 1;
+          else
+            hi = mid;
         }
+        keep = lo;
       }
+      ASSERT(td->proc_id, keep == count || seq_op_num(list, keep - 1) == op_num);
+      clip_deque(list, keep);
     }
   }
 
@@ -163,7 +179,7 @@ void thread_map_mem_dep(Op* op) {
 /* remove_next_from_seq_op_list: */
 
 Op* remove_next_from_seq_op_list(Thread_Data* td) {
-  Op** op_p = dl_list_remove_head(&td->seq_op_list);
+  Op** op_p = deque_remove_head(&td->seq_op_list);
   DEBUG(td->proc_id, "Removing op from seq op list  op:%s  count:%d\n", unsstr64((*op_p)->op_num),
         td->seq_op_list.count);
   return *op_p;
@@ -174,12 +190,12 @@ Op* remove_next_from_seq_op_list(Thread_Data* td) {
 
 void reset_seq_op_list(Thread_Data* td) {
   // Traverse the sequential op list and remove and free every op
-  Op** op_p = (Op**)list_start_head_traversal(&td->seq_op_list);
-  for (; op_p; op_p = (Op**)list_next_element(&td->seq_op_list)) {
+  Op** op_p = (Op**)deque_start_head_traversal(&td->seq_op_list);
+  for (; op_p; op_p = (Op**)deque_next_element(&td->seq_op_list)) {
     ASSERT(td->proc_id, td->proc_id == (*op_p)->proc_id);
     ft_free_op(*op_p);
   }
-  clear_list(&td->seq_op_list);
+  clear_deque(&td->seq_op_list);
 
   DEBUG(td->proc_id, "Reseting seq op list   count:%d\n", td->seq_op_list.count);
 }
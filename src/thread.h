@@ -31,10 +31,16 @@
 
 #include "globals/global_types.h"
 
-#include "libs/list_lib.h"
+#include "libs/deque_lib.h"
 
 #include "map.h"
 
+/**************************************************************************************/
+/* Defines */
+
+/* The seq_op_list ring is allocated at its maximum size, so it never grows */
+#define SEQ_OP_LIST_SIZE 8192
+
 /**************************************************************************************/
 /* Types */
 
@@ -57,7 +63,7 @@ typedef struct Thread_Info_struct {
 typedef struct Thread_struct {
   uns8 proc_id;
   Map_Data map_data;
-  List seq_op_list;
+  Deque seq_op_list;  // in-flight ops in op_num order, at most SEQ_OP_LIST_SIZE
   ///////////////////////////////////////////////////
   // Pipeline Gating
   Thread_Info td_info;
@@ -67,7 +73,7 @@ typedef struct Thread_struct {
 /**************************************************************************************/
 /* External variables */
 
-extern Thread_Data* td; /* here for now, variable declared in sim.c */
+extern CORE_LOCAL Thread_Data* td; /* here for now, variable declared in sim.c */
 /* if we ever go MT, this will turn into an array */
 
 /**************************************************************************************/
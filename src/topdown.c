@@ -31,12 +31,16 @@
 
 #include "topdown.h"
 
+#include <string.h>
+
 #include "globals/assert.h"
 #include "globals/global_defs.h"
 #include "globals/global_types.h"
 #include "globals/global_vars.h"
 #include "globals/utils.h"
 
+#include "core.param.h"
+
 #include "dcache_stage.h"
 #include "idq_stage.h"
 #include "lsq.h"
@@ -47,6 +51,39 @@
 const static uns64 TOPDOWN_SCALE_FACTOR = 10000;
 const static int TOPDOWN_RECOVERY_DEPTH = 2;
 
+/**************************************************************************************/
+/* Types */
+
+#define TOPDOWN_BACKEND_STALL 0x01
+#define TOPDOWN_MEM_LOAD_STALL 0x02
+#define TOPDOWN_MEM_STORE_STALL 0x04
+#define TOPDOWN_EXEC_STALL 0x08
+#define TOPDOWN_FETCH_BUBBLES_GT_MIW 0x10
+
+/* The events of one core cycle. The exec stage runs before the IDQ in a core
+   cycle, so the IDQ update closes the cycle. */
+typedef struct Topdown_Cycle_struct {
+  uns16 issued_slots;
+  uns16 retired_slots;
+  uns16 fetch_bubble_slots;
+  uns16 recovery_bubble_slots;
+  uns16 flags;  // TOPDOWN_* cycle events
+} Topdown_Cycle;
+
+/* Stalls repeat the same cycle for long stretches, so a core keeps the run of
+   identical cycles it is in and only adds it to the stats once a different
+   cycle ends it (or the stats are about to be read, see topdown_flush()) */
+typedef struct Topdown_Core_struct {
+  Topdown_Cycle cycle;  // the cycle in progress
+  Topdown_Cycle run;    // the cycles of the current run
+  Counter run_length;
+} Topdown_Core;
+
+/**************************************************************************************/
+/* Global variables */
+
+static Topdown_Core topdown_cores[MAX_NUM_PROCS];
+
 /**************************************************************************************/
 /* Events Update */
 
@@ -87,41 +124,89 @@ void topdown_bp_recovery(uns proc_id, Op* op) {
   idq_stage_set_recovery_cycle(TOPDOWN_RECOVERY_DEPTH);
 }
 
-void topdown_idq_update(uns proc_id, int count_available, int count_issued, int count_issued_on_path) {
-  INC_STAT_EVENT(proc_id, TOPDOWN_TOTAL_SLOTS, ISSUE_WIDTH);
-  INC_STAT_EVENT(proc_id, TOPDOWN_ISSUED_SLOTS, count_issued);
-  INC_STAT_EVENT(proc_id, TOPDOWN_RETIRED_SLOTS, count_issued_on_path);
+static void topdown_classify_idq(uns proc_id, Topdown_Cycle* cycle, int count_available, int count_issued,
+                                 int count_issued_on_path) {
+  cycle->issued_slots = count_issued;
+  cycle->retired_slots = count_issued_on_path;
 
   int recovery_cycle = idq_stage_get_recovery_cycle();
   if (recovery_cycle != 0) {
     ASSERT(proc_id, recovery_cycle > 0);
     idq_stage_set_recovery_cycle(recovery_cycle - 1);
-    INC_STAT_EVENT(proc_id, TOPDOWN_RECOVERY_BUBBLES_SLOTS, ISSUE_WIDTH - count_available);
+    cycle->recovery_bubble_slots = ISSUE_WIDTH - count_available;
     return;
   }
 
   // only increment frontend-stall when there is no backend-stall
   if (count_issued == 0 && idq_stage_get_stage_data()->op_count > 0) {
-    STAT_EVENT(proc_id, TOPDOWN_BACKEND_STALLS_CYCLES);
-    if (lsq_get_in_flight_load_num() > 0) {
-      STAT_EVENT(proc_id, TOPDOWN_MEM_LOAD_STALLS_CYCLES);
+    cycle->flags |= TOPDOWN_BACKEND_STALL;
+    if (lsq_has_in_flight_load()) {
+      cycle->flags |= TOPDOWN_MEM_LOAD_STALL;
     } else if (!lsq_available(MEM_ST)) {
-      STAT_EVENT(proc_id, TOPDOWN_MEM_STORE_STALLS_CYCLES);
+      cycle->flags |= TOPDOWN_MEM_STORE_STALL;
     }
     return;
   }
 
-  INC_STAT_EVENT(proc_id, TOPDOWN_FETCH_BUBBLES_SLOTS, ISSUE_WIDTH - count_available);
+  cycle->fetch_bubble_slots = ISSUE_WIDTH - count_available;
   if (count_available == 0)
-    STAT_EVENT(proc_id, TOPDOWN_FETCH_BUBBLES_GT_MIW_CYCLES);
+    cycle->flags |= TOPDOWN_FETCH_BUBBLES_GT_MIW;
+}
+
+void topdown_idq_update(uns proc_id, int count_available, int count_issued, int count_issued_on_path) {
+  Topdown_Core* core = &topdown_cores[proc_id];
+  topdown_classify_idq(proc_id, &core->cycle, count_available, count_issued, count_issued_on_path);
+
+  if (memcmp(&core->cycle, &core->run, sizeof(Topdown_Cycle))) {
+    topdown_flush(proc_id);
+    core->run = core->cycle;
+  }
+  core->run_length++;
+  memset(&core->cycle, 0, sizeof(Topdown_Cycle));
 }
 
 void topdown_exec_update(uns proc_id, uns8 fus_busy) {
   if (fus_busy <= TOPDOWN_FU_EXEC_FEW && node->node_count != 0) {
-    STAT_EVENT(proc_id, TOPDOWN_EXEC_STALLS_CYCLES);
+    topdown_cores[proc_id].cycle.flags |= TOPDOWN_EXEC_STALL;
   }
 }
 
+void topdown_idle_cycle(uns proc_id) {
+  topdown_cores[proc_id].run_length++;
+}
+
+uns64 topdown_idle_signature(uns proc_id) {
+  const Topdown_Cycle* run = &topdown_cores[proc_id].run;
+  uns64 slots = (uns64)run->issued_slots << 48 | (uns64)run->retired_slots << 32 |
+                (uns64)run->fetch_bubble_slots << 16 | run->recovery_bubble_slots;
+  return slots ^ ((uns64)run->flags << 8 | idq_stage_get_recovery_cycle()) * 0x100000001b3ULL;
+}
+
+void topdown_flush(uns proc_id) {
+  Topdown_Core* core = &topdown_cores[proc_id];
+  const Topdown_Cycle* run = &core->run;
+  Counter n = core->run_length;
+  if (!n)
+    return;
+
+  INC_STAT_EVENT(proc_id, TOPDOWN_TOTAL_SLOTS, n * ISSUE_WIDTH);
+  INC_STAT_EVENT(proc_id, TOPDOWN_ISSUED_SLOTS, n * run->issued_slots);
+  INC_STAT_EVENT(proc_id, TOPDOWN_RETIRED_SLOTS, n * run->retired_slots);
+  INC_STAT_EVENT(proc_id, TOPDOWN_RECOVERY_BUBBLES_SLOTS, n * run->recovery_bubble_slots);
+  INC_STAT_EVENT(proc_id, TOPDOWN_FETCH_BUBBLES_SLOTS, n * run->fetch_bubble_slots);
+  if (run->flags & TOPDOWN_BACKEND_STALL)
+    INC_STAT_EVENT(proc_id, TOPDOWN_BACKEND_STALLS_CYCLES, n);
+  if (run->flags & TOPDOWN_MEM_LOAD_STALL)
+    INC_STAT_EVENT(proc_id, TOPDOWN_MEM_LOAD_STALLS_CYCLES, n);
+  if (run->flags & TOPDOWN_MEM_STORE_STALL)
+    INC_STAT_EVENT(proc_id, TOPDOWN_MEM_STORE_STALLS_CYCLES, n);
+  if (run->flags & TOPDOWN_EXEC_STALL)
+    INC_STAT_EVENT(proc_id, TOPDOWN_EXEC_STALLS_CYCLES, n);
+  if (run->flags & TOPDOWN_FETCH_BUBBLES_GT_MIW)
+    INC_STAT_EVENT(proc_id, TOPDOWN_FETCH_BUBBLES_GT_MIW_CYCLES, n);
+  core->run_length = 0;
+}
+
 /**************************************************************************************/
 /*
  * Metrics Update
@@ -162,6 +247,8 @@ void topdown_exec_update(uns proc_id, uns8 fus_busy) {
  */
 
 void topdown_done(uns proc_id) {
+  topdown_flush(proc_id);
+
   /* Top-Level Breakdown */
   uns64 frontend_bound = GET_STAT_EVENT(proc_id, TOPDOWN_FETCH_BUBBLES_SLOTS) * TOPDOWN_SCALE_FACTOR /
                          GET_STAT_EVENT(proc_id, TOPDOWN_TOTAL_SLOTS);
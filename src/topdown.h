@@ -40,6 +40,12 @@
 void topdown_bp_recovery(uns proc_id, Op* op);
 void topdown_idq_update(uns proc_id, int count_available, int count_issued, int count_issued_on_path);
 void topdown_exec_update(uns proc_id, uns8 fus_busy);
+/* The slot and cycle events are accumulated per core and reach the TOPDOWN_*
+   stats only when flushed. dump_stats() and reset_stats() flush first. */
+void topdown_flush(uns proc_id);
+/* An idle chip cycle skipped by idle_skip.c repeats the last core cycle */
+void topdown_idle_cycle(uns proc_id);
+uns64 topdown_idle_signature(uns proc_id);
 void topdown_done(uns proc_id);
 
 #endif /* #ifndef __TOPDOWN_H__ */
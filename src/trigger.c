@@ -38,18 +38,6 @@
 
 #include "statistics.h"
 
-/**************************************************************************************/
-/* Types */
-
-struct Trigger_struct {
-  Flag armed;
-  const Stat* stat;
-  char* name;
-  Trigger_Type type;
-  Counter period;
-  Counter next_threshold;
-};
-
 /**************************************************************************************/
 /* Implementation */
 
@@ -92,24 +80,28 @@ Trigger* trigger_create(const char* name, const char* spec, Trigger_Type type) {
     *open_bracket = 0;
   }
 
+  Stat_Enum stat_idx;
   switch (*stat_str) {
     case 'i':
-      trigger->stat = &global_stat_array[proc_id][NODE_INST_COUNT];
+      stat_idx = NODE_INST_COUNT;
       break;
     case 'c':
-      trigger->stat = &global_stat_array[proc_id][NODE_CYCLE];
+      stat_idx = NODE_CYCLE;
       break;
     case 't':
-      trigger->stat = &global_stat_array[proc_id][EXECUTION_TIME];
+      stat_idx = EXECUTION_TIME;
       break;
     default:
-      trigger->stat = get_stat(proc_id, stat_str);
-      ASSERTM(0, trigger->stat, "Stat '%s' for trigger '%s' not found\n", stat_str, name);
-      ASSERTM(0, trigger->stat->type != FLOAT_TYPE_STAT,
+      stat_idx = get_stat_idx(stat_str);
+      ASSERTM(0, stat_idx != NUM_GLOBAL_STATS, "Stat '%s' for trigger '%s' not found\n", stat_str, name);
+      ASSERTM(0, global_stat_array[proc_id][stat_idx].type != FLOAT_TYPE_STAT,
               "Stat '%s' for trigger '%s' is a float (triggers support counter "
               "stats only)\n",
               stat_str, name);
   }
+  trigger->stat = &global_stat_array[proc_id][stat_idx];
+  trigger->proc_id = proc_id;
+  trigger->stat_idx = stat_idx;
 
   trigger->period = atoll(number_str);
   if (trigger->period == 0 && trigger->type == TRIGGER_REPEAT) {
@@ -121,19 +113,13 @@ Trigger* trigger_create(const char* name, const char* spec, Trigger_Type type) {
   return trigger;
 }
 
-Flag trigger_fired(Trigger* trigger) {
-  // common (false) case first
-  if (!trigger->armed || (trigger->stat->count + trigger->stat->total_count) < trigger->next_threshold) {
-    return FALSE;
-  }
-
-  // trigger fired
+void trigger_fire(Trigger* trigger) {
   if (trigger->type == TRIGGER_ONCE) {
     trigger->armed = FALSE;
   } else {
     trigger->next_threshold += trigger->period;
     uns skipped = 0;
-    while (trigger->stat->count + trigger->stat->total_count >= trigger->next_threshold) {
+    while (GET_TOTAL_STAT_EVENT(trigger->proc_id, trigger->stat_idx) >= trigger->next_threshold) {
       trigger->next_threshold += trigger->period;
       skipped++;
     }
@@ -141,7 +127,6 @@ Flag trigger_fired(Trigger* trigger) {
       ERROR(0, "Trigger '%s' skipped %d firings\n", trigger->name, skipped);
     }
   }
-  return TRUE;
 }
 
 Flag trigger_on(Trigger* trigger) {
@@ -156,7 +141,7 @@ double trigger_progress(Trigger* trigger) {
     return 1.0;
 
   ASSERT(0, trigger->next_threshold >= trigger->period);
-  Counter stat_count = trigger->stat->count + trigger->stat->total_count;
+  Counter stat_count = GET_TOTAL_STAT_EVENT(trigger->proc_id, trigger->stat_idx);
   ASSERT(0, stat_count >= trigger->next_threshold - trigger->period);
   if (stat_count >= trigger->next_threshold)
     return 1.0;
@@ -33,6 +33,8 @@
 
 #include "globals/global_types.h"
 
+#include "statistics.h"
+
 /**************************************************************************************/
 /* Types */
 
@@ -42,15 +44,36 @@ typedef enum Trigger_Type_enum {
   TRIGGER_NUM_ELEMS
 } Trigger_Type;
 
-struct Trigger_struct;
-typedef struct Trigger_struct Trigger;
+/* Visible only so that trigger_fired can be inlined into the per-cycle
+   callers; use the functions below instead of the fields. */
+typedef struct Trigger_struct {
+  Flag armed;
+  const Stat* stat;
+  uns8 proc_id;
+  Stat_Enum stat_idx;
+  char* name;
+  Trigger_Type type;
+  Counter period;
+  Counter next_threshold;
+} Trigger;
 
 /**************************************************************************************/
 /* Prototypes */
 
 Trigger* trigger_create(const char* name, const char* spec, Trigger_Type type);
 
-Flag trigger_fired(Trigger* trigger);
+/* Rearm (or disarm) a trigger whose threshold was reached */
+void trigger_fire(Trigger* trigger);
+
+/* TRUE once per crossing of the threshold. Called every cycle from several
+   places, so the common case is the armed flag and one compare inline. */
+static inline Flag trigger_fired(Trigger* trigger) {
+  if (__builtin_expect(!trigger->armed, 1) ||
+      __builtin_expect(GET_TOTAL_STAT_EVENT(trigger->proc_id, trigger->stat_idx) < trigger->next_threshold, 1))
+    return FALSE;
+  trigger_fire(trigger);
+  return TRUE;
+}
 
 Flag trigger_on(Trigger* trigger);
 
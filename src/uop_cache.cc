@@ -91,8 +91,8 @@ class Uop_Cache : public Cpp_Cache<Uop_Cache_Key, Uop_Cache_Data> {
 };
 
 uns Uop_Cache::set_idx_hash(Uop_Cache_Key key) {
-  // use % instead of masking to support num_sets that is not a power of 2
-  return (key.first >> offset_bits) % num_sets;
+  // masks for power-of-2 num_sets, takes the modulo otherwise
+  return set_idx_from_hash(key.first >> offset_bits);
 }
 
 typedef struct Uop_Cache_Stage_Cpp_struct {
@@ -119,7 +119,7 @@ typedef struct Uop_Cache_Stage_Cpp_struct {
 /* Global Variables */
 
 static std::vector<Uop_Cache_Stage_Cpp> per_core_uc_stage;
-Uop_Cache_Stage* uc = NULL;
+CORE_LOCAL Uop_Cache_Stage* uc = NULL;
 
 /**************************************************************************************/
 /* Operator Overload */
@@ -177,6 +177,11 @@ void init_uop_cache_stage(uns8 proc_id, const char* name) {
   // The cache library computes the number of entries from cache_size_bytes/cache_line_size_bytes
   per_core_uc_stage[proc_id].uop_cache =
       new Uop_Cache(UOP_CACHE_LINES, UOP_CACHE_ASSOC, UOP_CACHE_LINE_SIZE, (Repl_Policy)UOP_CACHE_REPL);
+
+  // an insertable FT spans at most UOP_CACHE_ASSOC lines; clearing keeps the capacity, so the buffers
+  // are only reallocated for FTs too big to insert
+  per_core_uc_stage[proc_id].lookup_buffer.reserve(UOP_CACHE_ASSOC);
+  per_core_uc_stage[proc_id].accumulation_buffer.reserve(UOP_CACHE_ASSOC + 1);
 }
 
 void recover_uop_cache(void) {
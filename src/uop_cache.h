@@ -44,7 +44,7 @@ typedef struct Uop_Cache_Stage_struct {
 /**************************************************************************************/
 /* External Variables */
 
-extern Uop_Cache_Stage* uc;
+extern CORE_LOCAL Uop_Cache_Stage* uc;
 
 /**************************************************************************************/
 /* Prototypes */
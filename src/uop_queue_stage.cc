@@ -3,6 +3,7 @@
 #include "uop_queue_stage.h"
 
 #include <deque>
+#include <vector>
 
 extern "C" {
 #include "globals/assert.h"
@@ -30,9 +31,31 @@ extern "C" {
 #define STAGE_MAX_OP_COUNT UOP_CACHE_WIDTH
 
 // Uop Queue Variables
-std::deque<Stage_Data*> q{};
-std::deque<Stage_Data*> free_sds{};
-bool uopq_off_path;
+struct Uop_Queue_Stage {
+  std::deque<Stage_Data*> q{};
+  std::deque<Stage_Data*> free_sds{};
+  bool off_path = false;
+};
+
+/* Per-core uop queues; uopq points to the one of the core being simulated */
+static std::vector<Uop_Queue_Stage> per_core_uopq;
+CORE_LOCAL Uop_Queue_Stage* uopq = nullptr;
+
+/* Stage loops specialized for the uop cache width, selected at init */
+template <int WIDTH>
+static void update_uop_queue_stage_width(Stage_Data* src_sd);
+template <int WIDTH>
+static void recover_uop_queue_stage_width(void);
+static void (*update_uop_queue_stage_func)(Stage_Data* src_sd) = update_uop_queue_stage_width<0>;
+static void (*recover_uop_queue_stage_func)(void) = recover_uop_queue_stage_width<0>;
+
+void alloc_mem_uop_queue_stage(uns num_cores) {
+  per_core_uopq.resize(num_cores);
+}
+
+void set_uop_queue_stage(uns proc_id) {
+  uopq = &per_core_uopq[proc_id];
+}
 
 void init_uop_queue_stage() {
   char tmp_name[MAX_STR_LENGTH + 1];
@@ -43,8 +66,23 @@ void init_uop_queue_stage() {
     sd->max_op_count = STAGE_MAX_OP_COUNT;
     sd->op_count = 0;
     sd->ops = (Op**)calloc(STAGE_MAX_OP_COUNT, sizeof(Op*));
-    free_sds.push_back(sd);
+    uopq->free_sds.push_back(sd);
   }
+
+#define UOP_QUEUE_STAGE_WIDTH_CASE(width)                                \
+  case width:                                                            \
+    update_uop_queue_stage_func = update_uop_queue_stage_width<width>;   \
+    recover_uop_queue_stage_func = recover_uop_queue_stage_width<width>; \
+    break;
+
+  switch (STAGE_MAX_OP_COUNT) {
+    STAGE_SPECIALIZED_WIDTHS(UOP_QUEUE_STAGE_WIDTH_CASE)
+    default:
+      update_uop_queue_stage_func = update_uop_queue_stage_width<0>;
+      recover_uop_queue_stage_func = recover_uop_queue_stage_width<0>;
+      break;
+  }
+#undef UOP_QUEUE_STAGE_WIDTH_CASE
 }
 
 // Get ops from the uop cache.
@@ -52,35 +90,58 @@ void update_uop_queue_stage(Stage_Data* src_sd) {
   if (!UOP_CACHE_ENABLE)
     return;
 
-  // If the front of the queue was consumed, remove that stage.
-  if (q.size() && q.front()->op_count == 0) {
-    free_sds.push_back(q.front());
-    q.pop_front();
-    ASSERT(0, !q.size() || q.front()->op_count > 0);  // Only one stage is consumed per cycle
-  }
+  update_uop_queue_stage_func(src_sd);
+}
+
+// The queue is stalled while it is full and its front has not been consumed.
+Counter uop_queue_stage_next_event_cycle() {
+  if (UOP_CACHE_ENABLE && uopq->q.size() >= UOP_QUEUE_STAGE_LENGTH && uopq->q.front()->op_count)
+    return MAX_CTR;
+  return cycle_count + 1;
+}
 
-  if (uopq_off_path) {
+// Counts a stalled cycle; stands in for update_uop_queue_stage when
+// uop_queue_stage_next_event_cycle() says the queue is stalled.
+void skip_uop_queue_stage() {
+  if (uopq->off_path) {
     STAT_EVENT(dec->proc_id, UOPQ_STAGE_OFF_PATH);
+  } else {
+    STAT_EVENT(dec->proc_id, UOPQ_STAGE_STALLED);
   }
+}
+
+template <int WIDTH>
+static void update_uop_queue_stage_width(Stage_Data* src_sd) {
+  const int width = WIDTH ? WIDTH : (int)STAGE_MAX_OP_COUNT;
+
+  // If the front of the queue was consumed, remove that stage.
+  if (uopq->q.size() && uopq->q.front()->op_count == 0) {
+    uopq->free_sds.push_back(uopq->q.front());
+    uopq->q.pop_front();
+    ASSERT(0, !uopq->q.size() || uopq->q.front()->op_count > 0);  // Only one stage is consumed per cycle
+  }
+
   // If the queue cannot accomodate more ops, stall.
-  if (q.size() >= UOP_QUEUE_STAGE_LENGTH) {
+  if (uopq->q.size() >= UOP_QUEUE_STAGE_LENGTH) {
     // Backend stalls may force fetch to stall.
-    if (!uopq_off_path) {
-      STAT_EVENT(dec->proc_id, UOPQ_STAGE_STALLED);
-    }
+    skip_uop_queue_stage();
     return;
-  } else if (!uopq_off_path) {
+  }
+  if (uopq->off_path) {
+    STAT_EVENT(dec->proc_id, UOPQ_STAGE_OFF_PATH);
+  } else {
     STAT_EVENT(dec->proc_id, UOPQ_STAGE_NOT_STALLED);
   }
 
   // Build a new sd and place new ops into the queue.
-  Stage_Data* new_sd = free_sds.front();
+  Stage_Data* new_sd = uopq->free_sds.front();
   ASSERT(0, src_sd->op_count <= (int)STAGE_MAX_OP_COUNT);
   if (src_sd->op_count) {
-    if (!uopq_off_path) {
+    if (!uopq->off_path) {
       STAT_EVENT(dec->proc_id, UOPQ_STAGE_NOT_STARVED);
     }
-    for (int i = 0; i < src_sd->max_op_count; i++) {
+    ASSERT(0, src_sd->max_op_count == width);
+    for (int i = 0; i < width; i++) {
       Op* src_op = src_sd->ops[i];
       if (src_op) {
         ASSERT(src_op->proc_id, src_op->fetched_from_uop_cache);
@@ -91,25 +152,32 @@ void update_uop_queue_stage(Stage_Data* src_sd) {
         decode_stage_process_op(src_op);
         DEBUG(0, "Fetching opnum=%llu\n", src_op->op_num);
         if (src_op->off_path)
-          uopq_off_path = true;
+          uopq->off_path = true;
       }
     }
-  } else if (!uopq_off_path) {
+  } else if (!uopq->off_path) {
     STAT_EVENT(dec->proc_id, UOPQ_STAGE_STARVED);
   }
 
   if (new_sd->op_count > 0) {
-    free_sds.pop_front();
-    q.push_back(new_sd);
+    uopq->free_sds.pop_front();
+    uopq->q.push_back(new_sd);
   }
 }
 
 void recover_uop_queue_stage(void) {
-  uopq_off_path = false;
-  for (std::deque<Stage_Data*>::iterator it = q.begin(); it != q.end();) {
+  recover_uop_queue_stage_func();
+}
+
+template <int WIDTH>
+static void recover_uop_queue_stage_width(void) {
+  const uns width = WIDTH ? WIDTH : STAGE_MAX_OP_COUNT;
+
+  uopq->off_path = false;
+  for (std::deque<Stage_Data*>::iterator it = uopq->q.begin(); it != uopq->q.end();) {
     Stage_Data* sd = *it;
     sd->op_count = 0;
-    for (uns op_idx = 0; op_idx < STAGE_MAX_OP_COUNT; op_idx++) {
+    for (uns op_idx = 0; op_idx < width; op_idx++) {
       Op* op = sd->ops[op_idx];
       if (op && FLUSH_OP(op)) {
         ASSERT(op->proc_id, op->off_path);
@@ -122,8 +190,8 @@ void recover_uop_queue_stage(void) {
     }
 
     if (sd->op_count == 0) {  // entire stage data was off-path
-      free_sds.push_back(sd);
-      it = q.erase(it);
+      uopq->free_sds.push_back(sd);
+      it = uopq->q.erase(it);
     } else {
       ++it;
     }
@@ -131,13 +199,13 @@ void recover_uop_queue_stage(void) {
 }
 
 Stage_Data* uop_queue_stage_get_latest_sd(void) {
-  if (q.size()) {
-    return q.front();
+  if (uopq->q.size()) {
+    return uopq->q.front();
   }
-  ASSERT(0, free_sds.size() == UOP_QUEUE_STAGE_LENGTH);
-  return free_sds.front();
+  ASSERT(0, uopq->free_sds.size() == UOP_QUEUE_STAGE_LENGTH);
+  return uopq->free_sds.front();
 };
 
 int get_uop_queue_stage_length(void) {
-  return q.size();
+  return uopq->q.size();
 }
\ No newline at end of file
@@ -14,8 +14,12 @@ extern "C" {
 #include "stage_data.h"
 #include "uop_cache.h"
 
+void alloc_mem_uop_queue_stage(uns num_cores);
+void set_uop_queue_stage(uns proc_id);
 void init_uop_queue_stage(void);
 void update_uop_queue_stage(Stage_Data* src_sd);
+Counter uop_queue_stage_next_event_cycle(void);
+void skip_uop_queue_stage(void);
 void recover_uop_queue_stage(void);
 Stage_Data* uop_queue_stage_get_latest_sd(void);
 // Returns length of queue in terms of number of stages
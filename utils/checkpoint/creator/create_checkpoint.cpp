@@ -32,6 +32,7 @@
 #include <zlib.h>
 
 #include "../loader/cpuinfo.h"
+#include "../loader/page_store.h"
 #include "control_manager.H"
 #include "instlib.H"
 #include "pin.H"
@@ -42,6 +43,9 @@ using namespace CONTROLLER;
 KNOB<string> KnobOutputDir(KNOB_MODE_WRITEONCE, "pintool", "o", "checkpoint",
                            "Checkpoint dir name");
 KNOB<bool>   KnobDebug(KNOB_MODE_WRITEONCE, "pintool", "d", "0", "Debug mode");
+KNOB<string> KnobPageStore(KNOB_MODE_WRITEONCE, "pintool", "page_store", "",
+                           "Store memory as page manifests into this shared, "
+                           "content-addressed page directory");
 
 #define DEBUG(...)                  \
   do {                              \
@@ -82,6 +86,7 @@ int  nextDataFileId = 0;
 void dumpMemory(FILE* out, UINT pid);
 void processMapsLine(FILE* out, const std::string& line);
 int  dumpMemoryData(const char* path, UINT8* start, UINT8* end);
+int  dumpMemoryPages(const char* path, UINT8* start, UINT8* end);
 
 /* Signal dumping functions */
 void dumpSignals(FILE* out);
@@ -215,6 +220,9 @@ void dumpProcessInfo(FILE* out, CONTEXT* ctxt) {
   dumpProcFileRawContent(out, "cmdline", PIN_GetPid());
   dumpOSinfo(out);
   dumpCPUinfo(out);
+  if(!KnobPageStore.Value().empty()) {
+    INLINE_CHILD(out, "page_store", "%s", KnobPageStore.Value().c_str());
+  }
   dumpMemory(out, PIN_GetPid());
   endChild(out);
   DEBUG("End of Dumping process %d\n", PIN_GetPid());
@@ -368,9 +376,12 @@ void processMapsLine(FILE* out, const std::string& line) {
     return;
   }
 
-  if(dumpMemoryData(
-       (KnobOutputDir.Value() + "/" + dataIdSS.str() + ".dat").c_str(),
-       (UINT8*)addr1, (UINT8*)addr2)) {
+  bool        usePageStore = !KnobPageStore.Value().empty();
+  std::string dataPath     = KnobOutputDir.Value() + "/" + dataIdSS.str() +
+                         (usePageStore ? ".pages" : ".dat");
+  if(usePageStore ?
+       dumpMemoryPages(dataPath.c_str(), (UINT8*)addr1, (UINT8*)addr2) :
+       dumpMemoryData(dataPath.c_str(), (UINT8*)addr1, (UINT8*)addr2)) {
     startChild(out, "range");
     INLINE_CHILD(out, "start", "0x%lx", addr1);
     INLINE_CHILD(out, "end", "0x%lx", addr2);
@@ -390,7 +401,11 @@ void processMapsLine(FILE* out, const std::string& line) {
       INLINE_CHILD(out, "offset", "0x%lx", offset);
       endChild(out);
     }
-    INLINE_CHILD(out, "data", "%d.dat", nextDataFileId);
+    if(usePageStore) {
+      INLINE_CHILD(out, "pages", "%d.pages", nextDataFileId);
+    } else {
+      INLINE_CHILD(out, "data", "%d.dat", nextDataFileId);
+    }
     nextDataFileId++;
     endChild(out);
   } else {
@@ -440,6 +455,40 @@ int dumpMemoryData(const char* path, UINT8* start, UINT8* end) {
   return 1;
 }
 
+// Writes one page_store key per page of [start, end) to path, adding new
+// pages to the page store.
+int dumpMemoryPages(const char* path, UINT8* start, UINT8* end) {
+  ASSERTX((end - start) % PAGE_STORE_PAGE_SIZE == 0);
+  FILE* out = fopen(path, "wb");
+  if(!out) {
+    perror(path);
+    exit(1);
+  }
+
+  char page[PAGE_STORE_PAGE_SIZE];
+  for(UINT8* addr = start; addr < end; addr += PAGE_STORE_PAGE_SIZE) {
+    EXCEPTION_INFO ex;
+    UINT64 bytes_copied = PIN_SafeCopyEx(page, addr, PAGE_STORE_PAGE_SIZE,
+                                         &ex);
+    if(bytes_copied != PAGE_STORE_PAGE_SIZE) {
+      std::cerr << "Could not copy data at " << start << ": "
+                << PIN_ExceptionToString(&ex) << std::endl;
+      fclose(out);
+      unlink(path);
+      return 0;
+    }
+    uint64_t key;
+    if(!page_store::put(KnobPageStore.Value(), page, &key) ||
+       fwrite(&key, sizeof(key), 1, out) != 1) {
+      std::cerr << "ERROR: Saving page " << (void*)addr << " to "
+                << KnobPageStore.Value() << " failed!" << std::endl;
+      exit(1);
+    }
+  }
+  fclose(out);
+  return 1;
+}
+
 void dumpFDs(FILE* out, UINT pid) {
   DEBUG("Dumping file descriptors\n");
   startChild(out, "file_descriptors");
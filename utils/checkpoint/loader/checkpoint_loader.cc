@@ -44,7 +44,8 @@ void usage(const char* name_of_loader_exe, int longest_option_length);
 void parse_options(int argc, char* const argv[], int& run_natively_without_pin,
                    int& run_external_pintool, int& print_argv_envp,
                    int& force_even_if_wrong_kernel,
-                   int& force_even_if_wrong_cpu, int& longest_option_length);
+                   int& force_even_if_wrong_cpu, int& map_region_images,
+                   int& longest_option_length);
 void parse_positional_arguments(int argc, char* const argv[],
                                 int run_natively_without_pin,
                                 int run_external_pintool,
@@ -117,6 +118,7 @@ static const char* print_argv_envp_option          = "print_argv_envp";
 static const char* force_even_if_wrong_kernel_option =
   "force_even_if_wrong_kernel";
 static const char* force_even_if_wrong_cpu_option = "force_even_if_wrong_cpu";
+static const char* map_region_images_option       = "map_region_images";
 static const char* pintool_args_option            = "pintool_args";
 
 namespace {
@@ -227,6 +229,11 @@ void usage(const char* name_of_loader_exe, int longest_option_length) {
             << "try loading the checkpoint anyways, even if certain CPU "
                "features (e.g., avx512f) were available"
                " during checkpoint creation, but not on the current machine \n";
+  std::cerr << std::left << std::setw(text_width)
+            << option_prefix + map_region_images_option
+            << "map uncompressed region images into the process instead of "
+               "copying them in; images are created next to the dat files "
+               "on first use\n";
 
   exit(EXIT_FAILURE);
 }
@@ -234,7 +241,8 @@ void usage(const char* name_of_loader_exe, int longest_option_length) {
 void parse_options(int argc, char* const argv[], int& run_natively_without_pin,
                    int& run_external_pintool, int& print_argv_envp,
                    int& force_even_if_wrong_kernel,
-                   int& force_even_if_wrong_cpu, int& longest_option_length) {
+                   int& force_even_if_wrong_cpu, int& map_region_images,
+                   int& longest_option_length) {
   static struct option long_options[] = {
     {run_natively_without_pin_option, no_argument, &run_natively_without_pin,
      true},
@@ -244,6 +252,7 @@ void parse_options(int argc, char* const argv[], int& run_natively_without_pin,
      &force_even_if_wrong_kernel, true},
     {force_even_if_wrong_cpu_option, no_argument, &force_even_if_wrong_cpu,
      true},
+    {map_region_images_option, no_argument, &map_region_images, true},
     {pintool_args_option, required_argument, NULL, 'p'},
     {"help", no_argument, NULL, 'h'},
     {0, 0, 0, 0}};
@@ -406,11 +415,14 @@ int main(int argc, char* const argv[], char* const envp[]) {
   int print_argv_envp            = false;
   int force_even_if_wrong_kernel = false;
   int force_even_if_wrong_cpu    = false;
+  int map_region_images          = false;
   int longest_option_length      = -1;
 
   parse_options(argc, argv, run_natively_without_pin, run_external_pintool,
                 print_argv_envp, force_even_if_wrong_kernel,
-                force_even_if_wrong_cpu, longest_option_length);
+                force_even_if_wrong_cpu, map_region_images,
+                longest_option_length);
+  set_map_region_images(map_region_images);
   parse_positional_arguments(argc, argv, run_natively_without_pin,
                              run_external_pintool, longest_option_length);
 
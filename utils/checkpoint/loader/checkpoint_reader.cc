@@ -23,10 +23,13 @@
 
 #include <cassert>
 #include <fcntl.h>
+#include <functional>
 #include <iostream>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <vector>
 
+#include "page_store.h"
 #include "ptrace_interface.h"
 #include "read_mem_map.h"
 
@@ -34,15 +37,17 @@ static const int MAX_MEMORY_REGIONS = 256;
 
 const hconfig_t* process_config;
 
-std::string  checkpoint_dir;
-static pid_t child_pid = 0;
+std::string        checkpoint_dir;
+static std::string page_store_dir;
+static pid_t       child_pid = 0;
 
 char fpstate_buffer[FPSTATE_SIZE];
 
 struct Checkpoint_Memory_Region {
   RegionInfo  region_info;
   bool        already_mapped;
-  std::string data_file;
+  std::string data_file;   // bzip2 stream of the region
+  std::string pages_file;  // page_store manifest of the region, if not empty
 };
 
 static Checkpoint_Memory_Region memory_regions[MAX_MEMORY_REGIONS];
@@ -92,6 +97,8 @@ static const char* exe_path;
 
 static const char* HEX_PREFIX = "0x";
 
+static bool map_region_images = false;
+
 static const char* require_str(const struct hconfig_t* config,
                                const char*             name);
 
@@ -264,8 +271,16 @@ static void read_memory_regions() {
       }
     }
 
-    memory_regions[i].data_file = std::string(
-      require_str(range_config, "data"));
+    const char* pages = hconfig_value(range_config, "pages");
+    if(pages) {
+      memory_regions[i].pages_file = std::string(pages);
+      if(page_store_dir.empty()) {
+        page_store_dir = std::string(require_str(process_config, "page_store"));
+      }
+    } else {
+      memory_regions[i].data_file = std::string(
+        require_str(range_config, "data"));
+    }
 
     num_valid_memory_regions += 1;
   }
@@ -735,6 +750,125 @@ void allocate_new_regions(pid_t child_pid) {
   }
 }
 
+void set_map_region_images(bool enable) {
+  map_region_images = enable;
+}
+
+// Calls f(page_offset, page) for every page of a page store region.
+static void for_each_region_page(
+  int i, size_t region_size,
+  const std::function<void(size_t, const char*)>& f) {
+  std::string manifest_path = checkpoint_dir + "/" +
+                              memory_regions[i].pages_file;
+  FILE* manifest = fopen(manifest_path.c_str(), "rb");
+  if(!manifest) {
+    fatal_and_kill_child(child_pid, "Error opening a pages file: %s",
+                         manifest_path.c_str());
+  }
+  if(region_size % PAGE_STORE_PAGE_SIZE) {
+    fatal_and_kill_child(child_pid, "Region size is not a multiple of %d: %s",
+                         PAGE_STORE_PAGE_SIZE, manifest_path.c_str());
+  }
+
+  char page[PAGE_STORE_PAGE_SIZE];
+  for(size_t offset = 0; offset < region_size;
+      offset += PAGE_STORE_PAGE_SIZE) {
+    uint64_t key;
+    if(fread(&key, sizeof(key), 1, manifest) != 1) {
+      fatal_and_kill_child(child_pid, "pages file has too few pages: %s",
+                           manifest_path.c_str());
+    }
+    if(!page_store::get(page_store_dir, key, page)) {
+      fatal_and_kill_child(child_pid,
+                           "Page %016" PRIx64 " of %s is missing from %s", key,
+                           manifest_path.c_str(), page_store_dir.c_str());
+    }
+    f(offset, page);
+  }
+  char temp_byte;
+  if(fread(&temp_byte, 1, 1, manifest) == 1) {
+    fatal_and_kill_child(child_pid, "pages file has too many pages: %s",
+                         manifest_path.c_str());
+  }
+  fclose(manifest);
+}
+
+// Returns the path of the uncompressed image of region i, creating it next to
+// its dat or pages file the first time. An image is reused only if it has the
+// exact region size and is not older than its source.
+static std::string get_region_image(int i, size_t region_size) {
+  bool        from_pages = !memory_regions[i].pages_file.empty();
+  std::string dat_path   = checkpoint_dir + "/" +
+                         (from_pages ? memory_regions[i].pages_file :
+                                       memory_regions[i].data_file);
+  std::string img_path = dat_path + ".img";
+
+  struct stat dat_stat, img_stat;
+  if(!stat(img_path.c_str(), &img_stat) &&
+     (size_t)img_stat.st_size == region_size &&
+     (stat(dat_path.c_str(), &dat_stat) ||
+      img_stat.st_mtime >= dat_stat.st_mtime)) {
+    return img_path;
+  }
+
+  std::cout << " Creating an image of " << dat_path << " ..." << std::endl;
+  std::string tmp_path = img_path + ".tmp";
+  bool        ok;
+  if(from_pages) {
+    FILE* img = fopen(tmp_path.c_str(), "wb");
+    ok        = img != NULL;
+    if(ok) {
+      for_each_region_page(i, region_size, [&](size_t, const char* page) {
+        ok = ok && fwrite(page, 1, PAGE_STORE_PAGE_SIZE, img) ==
+                     PAGE_STORE_PAGE_SIZE;
+      });
+      ok = !fclose(img) && ok;
+    }
+  } else {
+    std::string cmd = std::string("bzip2 -dc ") + dat_path + " > " + tmp_path;
+    DEBUG(cmd);
+    ok = system(cmd.c_str()) == 0;
+  }
+  if(!ok || stat(tmp_path.c_str(), &img_stat) ||
+     (size_t)img_stat.st_size != region_size) {
+    unlink(tmp_path.c_str());
+    fatal_and_kill_child(child_pid,
+                         "Could not create a region image from %s",
+                         dat_path.c_str());
+  }
+  if(rename(tmp_path.c_str(), img_path.c_str())) {
+    fatal_and_kill_child(child_pid, "Could not rename the region image %s",
+                         tmp_path.c_str());
+  }
+  return img_path;
+}
+
+// Maps the image of region i over the region in the tracee. MAP_PRIVATE
+// leaves the image untouched and pages are read in on first access.
+static void map_region_image(pid_t child_pid, int i, size_t region_size) {
+  const RegionInfo& checkpoint_region = memory_regions[i].region_info;
+  void*       addr     = (void*)checkpoint_region.range.inclusive_lower_bound;
+  std::string img_path = get_region_image(i, region_size);
+
+  int fd = execute_open(child_pid, img_path.c_str(), O_RDONLY);
+  if(fd < 0) {
+    fatal_and_kill_child(child_pid, "Tracee could not open region image %s",
+                         img_path.c_str());
+  }
+  void* mapped_addr = execute_mmap(child_pid, addr, region_size,
+                                   PROT_READ | PROT_WRITE | PROT_EXEC,
+                                   MAP_PRIVATE | MAP_FIXED, fd, 0);
+  if(mapped_addr != addr) {
+    std::cerr << "Checkpoint region: " << checkpoint_region << std::endl;
+    std::cerr << "mmap return value: " << mapped_addr << "\n";
+    fatal_and_kill_child(child_pid, "mmap() of a region image failed");
+  }
+  if(execute_close(child_pid, fd)) {
+    fatal_and_kill_child(child_pid,
+                         "close() failed after mapping a region image");
+  }
+}
+
 void write_data_to_regions(pid_t child_pid) {
   std::cout << "Writing data to all regions ..." << std::endl;
   auto[sharedmem_tracer_addr, sharedmem_tracee_addr] = allocate_shared_memory(
@@ -772,31 +906,47 @@ void write_data_to_regions(pid_t child_pid) {
       continue;
     }
 
-    char*       temp_buffer = new char[region_size];
-    std::string cmd         = std::string("bzip2 -dc ") + checkpoint_dir + "/" +
-                      memory_regions[i].data_file;
-    DEBUG(cmd);
-    FILE* data_file = popen(cmd.c_str(), "r");
-    if(!data_file) {
-      fatal_and_kill_child(child_pid, "Error opening a dat file: %s",
-                           memory_regions[i].data_file.c_str());
-    }
-    size_t bytes_read = fread(temp_buffer, 1, region_size, data_file);
-    if(bytes_read != region_size) {
-      fatal_and_kill_child(child_pid,
-                           "dat file did not have enough bytes: %s. "
-                           "bytes_read: %d, region_size: %d",
-                           memory_regions[i].data_file.c_str(), bytes_read,
-                           region_size);
+    // the stack keeps its MAP_GROWSDOWN mapping and vdso/vvar/vsyscall are
+    // only compared, so those are always read
+    if(map_region_images && i != stack_region_id && i != vsyscall_region_id &&
+       i != vdso_region_id && i != vvar_region_id) {
+      map_region_image(child_pid, i, region_size);
+      continue;
     }
 
-    char temp_byte;
-    bytes_read = fread(&temp_byte, 1, 1, data_file);
-    if(bytes_read == 1 || !feof(data_file)) {
-      fatal_and_kill_child(child_pid, "dat file has too many bytes: %s",
-                           memory_regions[i].data_file.c_str());
+    char* temp_buffer = new char[region_size];
+    if(!memory_regions[i].pages_file.empty()) {
+      for_each_region_page(i, region_size,
+                           [temp_buffer](size_t offset, const char* page) {
+                             memcpy(temp_buffer + offset, page,
+                                    PAGE_STORE_PAGE_SIZE);
+                           });
+    } else {
+      std::string cmd = std::string("bzip2 -dc ") + checkpoint_dir + "/" +
+                        memory_regions[i].data_file;
+      DEBUG(cmd);
+      FILE* data_file = popen(cmd.c_str(), "r");
+      if(!data_file) {
+        fatal_and_kill_child(child_pid, "Error opening a dat file: %s",
+                             memory_regions[i].data_file.c_str());
+      }
+      size_t bytes_read = fread(temp_buffer, 1, region_size, data_file);
+      if(bytes_read != region_size) {
+        fatal_and_kill_child(child_pid,
+                             "dat file did not have enough bytes: %s. "
+                             "bytes_read: %d, region_size: %d",
+                             memory_regions[i].data_file.c_str(), bytes_read,
+                             region_size);
+      }
+
+      char temp_byte;
+      bytes_read = fread(&temp_byte, 1, 1, data_file);
+      if(bytes_read == 1 || !feof(data_file)) {
+        fatal_and_kill_child(child_pid, "dat file has too many bytes: %s",
+                             memory_regions[i].data_file.c_str());
+      }
+      pclose(data_file);
     }
-    fclose(data_file);
 
     if(i == vsyscall_region_id || i == vdso_region_id || i == vvar_region_id) {
       DEBUG("asserting regions are equal: start");
@@ -55,6 +55,10 @@ const char* get_checkpoint_exe_path();
 
 void allocate_new_regions(pid_t child_pid);
 
+// Maps uncompressed region images (created next to the dat files on first
+// use) into the tracee instead of copying every byte in.
+void set_map_region_images(bool enable);
+
 void write_data_to_regions(pid_t child_pid);
 
 void update_region_protections(pid_t child_pid);
@@ -0,0 +1,132 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/*page_store.h
+ * 10/14/26
+ *
+ * Content-addressed page store shared by checkpoints. Every distinct 4KB page
+ * is stored once as <store>/<xx>/<key> and a region is described by a
+ * manifest: one little-endian uint64_t key per page. Key 0 is the zero page,
+ * which is never stored. Keys are a hash of the page; on a collision the next
+ * free key is used, so a key always names exactly one page. Header only so
+ * that the creator pintool can use it without linking the loader.
+ */
+
+#ifndef __PAGE_STORE_H__
+#define __PAGE_STORE_H__
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define PAGE_STORE_PAGE_SIZE 4096
+#define PAGE_STORE_ZERO_KEY 0
+
+namespace page_store {
+
+inline bool is_zero_page(const char* page) {
+  for(int i = 0; i < PAGE_STORE_PAGE_SIZE; ++i) {
+    if(page[i])
+      return false;
+  }
+  return true;
+}
+
+// 64 bit FNV-1a; collisions are resolved by put()
+inline uint64_t hash_page(const char* page) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for(int i = 0; i < PAGE_STORE_PAGE_SIZE; ++i) {
+    hash ^= (uint8_t)page[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash == PAGE_STORE_ZERO_KEY ? 1 : hash;
+}
+
+inline std::string page_dir(const std::string& store, uint64_t key) {
+  char name[8];
+  snprintf(name, sizeof(name), "/%02x", (unsigned)(key & 0xff));
+  return store + name;
+}
+
+inline std::string page_path(const std::string& store, uint64_t key) {
+  char name[24];
+  snprintf(name, sizeof(name), "/%016" PRIx64, key);
+  return page_dir(store, key) + name;
+}
+
+// Reads page key into page. Returns false if the page is missing.
+inline bool get(const std::string& store, uint64_t key, char* page) {
+  if(key == PAGE_STORE_ZERO_KEY) {
+    memset(page, 0, PAGE_STORE_PAGE_SIZE);
+    return true;
+  }
+  FILE* file = fopen(page_path(store, key).c_str(), "rb");
+  if(!file)
+    return false;
+  size_t bytes_read = fread(page, 1, PAGE_STORE_PAGE_SIZE, file);
+  fclose(file);
+  return bytes_read == PAGE_STORE_PAGE_SIZE;
+}
+
+// Adds page to the store if it is not there yet and returns its key, or
+// PAGE_STORE_ZERO_KEY for the zero page. Returns false on I/O errors.
+inline bool put(const std::string& store, const char* page, uint64_t* key) {
+  if(is_zero_page(page)) {
+    *key = PAGE_STORE_ZERO_KEY;
+    return true;
+  }
+  char stored_page[PAGE_STORE_PAGE_SIZE];
+  for(uint64_t probe = hash_page(page);; probe = probe + 1 ? probe + 1 : 1) {
+    if(get(store, probe, stored_page)) {
+      if(!memcmp(page, stored_page, PAGE_STORE_PAGE_SIZE)) {
+        *key = probe;
+        return true;
+      }
+      continue;
+    }
+
+    // written under a temporary name so that concurrent creators sharing the
+    // store never see a partial page
+    mkdir(store.c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    mkdir(page_dir(store, probe).c_str(), S_IRWXU | S_IRWXG | S_IROTH | S_IXOTH);
+    std::string path     = page_path(store, probe);
+    std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+    FILE*       file     = fopen(tmp_path.c_str(), "wb");
+    if(!file)
+      return false;
+    bool ok = fwrite(page, 1, PAGE_STORE_PAGE_SIZE, file) ==
+              PAGE_STORE_PAGE_SIZE;
+    ok = !fclose(file) && ok;
+    if(!ok || rename(tmp_path.c_str(), path.c_str())) {
+      unlink(tmp_path.c_str());
+      return false;
+    }
+    *key = probe;
+    return true;
+  }
+}
+
+}  // namespace page_store
+
+#endif
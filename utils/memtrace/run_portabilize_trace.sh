@@ -1,8 +1,15 @@
+#!/bin/bash
 SCRIPT=$(readlink -f "$0")
 SCRIPTDIR=$(dirname "$SCRIPT")
 
 DRIO_BUILD_DIR=${SCRIPTDIR}/../../src/build/opt/deps/dynamorio
 
+# raw2trace converts the per-thread raw files of a trace with JOBS threads
+# (default: all cores); MAX_TRACES traces are converted at a time (default: 1,
+# so every trace gets all the threads)
+JOBS=${JOBS:-$(nproc)}
+MAX_TRACES=${MAX_TRACES:-1}
+
 for dir in */; do
     echo "$dir"
     cd $dir
@@ -10,6 +17,10 @@ for dir in */; do
     cp raw/modules.log bin/modules.log
     python2 $SCRIPTDIR/portabilize_trace.py .
     cp bin/modules.log raw/modules.log
-    ${DRIO_BUILD_DIR}/clients/bin64/drraw2trace -indir ./raw/ &
+    while [ "$(jobs -rp | wc -l)" -ge "$MAX_TRACES" ]; do
+        wait -n
+    done
+    ${DRIO_BUILD_DIR}/clients/bin64/drraw2trace -indir ./raw/ -jobs $JOBS &
     cd -
 done
+wait
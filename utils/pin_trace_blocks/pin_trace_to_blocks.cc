@@ -0,0 +1,243 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : pin_trace_to_blocks.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Converts ctype_pin_inst traces (bzip2-compressed or raw) into
+ *                the seekable block-compressed container read by
+ *                frontend/pin_trace_read.cc. With -d, any number of traces
+ *                are converted concurrently into one output directory.
+ ***************************************************************************************/
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "frontend/pin_trace_block.h"
+
+struct Convert_Options {
+  uint32_t block_insts;
+  int level;
+  Pin_Trace_Block_Encoding encoding;
+};
+
+struct Convert_Job {
+  std::string in_name;
+  std::string out_name;
+  bool ok;
+  unsigned long long num_insts;
+  unsigned long long out_bytes;
+  double seconds;
+};
+
+static std::mutex print_mutex;
+
+static void usage(const char* prog) {
+  fprintf(stderr,
+          "usage: %s [-b block_insts] [-l zlib_level] [-e encoding] <input trace> <output container>\n"
+          "       %s [-b block_insts] [-l zlib_level] [-e encoding] [-j jobs] -d <output dir> <input trace>...\n"
+          "  -b  instructions per block (default %d)\n"
+          "  -l  zlib compression level 0-9 (default 6)\n"
+          "  -e  bb: one record per basic block (default), op: one delta-encoded record per\n"
+          "      instruction, raw: the raw records (readable by older Scarab builds)\n"
+          "  -d  convert every input into <output dir>/<input name without .bz2>.sbt\n"
+          "  -j  traces converted at once with -d (default: number of CPUs)\n",
+          prog, prog, PIN_TRACE_BLOCK_DEFAULT_INSTS);
+  exit(1);
+}
+
+static void report(FILE* stream, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void report(FILE* stream, const char* fmt, ...) {
+  std::lock_guard<std::mutex> lock(print_mutex);
+  va_list args;
+  va_start(args, fmt);
+  vfprintf(stream, fmt, args);
+  va_end(args);
+}
+
+static void convert(const Convert_Options& options, Convert_Job* job) {
+  const char* in_name = job->in_name.c_str();
+  const char* out_name = job->out_name.c_str();
+  auto start = std::chrono::steady_clock::now();
+  job->ok = false;
+  job->num_insts = 0;
+  job->out_bytes = 0;
+
+  FILE* in = fopen(in_name, "rb");
+  if (!in) {
+    report(stderr, "%s: %s\n", in_name, strerror(errno));
+    return;
+  }
+  char magic[3];
+  bool bzip2 = fread(magic, 1, sizeof(magic), in) == sizeof(magic) && !memcmp(magic, "BZh", sizeof(magic));
+  if (bzip2) {
+    fclose(in);
+    std::string cmdline = std::string("bzip2 -dc '") + in_name + "'";
+    in = popen(cmdline.c_str(), "r");
+    if (!in) {
+      report(stderr, "%s: %s\n", cmdline.c_str(), strerror(errno));
+      return;
+    }
+  } else {
+    rewind(in);
+  }
+
+  Pin_Trace_Block_Writer* writer =
+      pin_trace_block_writer_open(out_name, options.block_insts, options.level, options.encoding);
+  if (!writer) {
+    report(stderr, "%s: %s\n", out_name, strerror(errno));
+    bzip2 ? pclose(in) : fclose(in);
+    return;
+  }
+
+  std::vector<ctype_pin_inst> buf(options.block_insts);
+  bool write_error = false;
+  size_t num;
+  while (!write_error && (num = fread(buf.data(), sizeof(ctype_pin_inst), buf.size(), in)) > 0) {
+    write_error = pin_trace_block_writer_add(writer, buf.data(), num) != 0;
+    job->num_insts += num;
+  }
+  int in_error = ferror(in);
+  if (bzip2 ? pclose(in) != 0 : fclose(in) != 0)
+    in_error = 1;
+  if (pin_trace_block_writer_close(writer))
+    write_error = true;
+  if (in_error && !write_error) {
+    report(stderr, "%s: read failed\n", in_name);
+    return;
+  }
+  if (write_error) {
+    report(stderr, "%s: write failed\n", out_name);
+    return;
+  }
+
+  FILE* out = fopen(out_name, "rb");
+  if (out && !fseek(out, 0, SEEK_END))
+    job->out_bytes = ftell(out);
+  if (out)
+    fclose(out);
+  job->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  job->ok = true;
+  report(stdout, "%s: %llu instructions in blocks of %u, %.2f bytes/inst, %.2f Minst/s\n", out_name, job->num_insts,
+         options.block_insts, job->num_insts ? (double)job->out_bytes / job->num_insts : 0.0,
+         job->seconds > 0 ? job->num_insts / job->seconds / 1e6 : 0.0);
+}
+
+static std::string output_name(const std::string& dir, const std::string& in_name) {
+  std::string base = in_name.substr(in_name.find_last_of('/') + 1);
+  if (base.size() > 4 && base.compare(base.size() - 4, 4, ".bz2") == 0)
+    base.resize(base.size() - 4);
+  return dir + "/" + base + ".sbt";
+}
+
+int main(int argc, char* argv[]) {
+  Convert_Options options = {PIN_TRACE_BLOCK_DEFAULT_INSTS, 6, PIN_TRACE_BLOCK_BB};
+  const char* out_dir = NULL;
+  long jobs = sysconf(_SC_NPROCESSORS_ONLN);
+  int opt;
+  while ((opt = getopt(argc, argv, "b:l:e:d:j:")) != -1) {
+    switch (opt) {
+      case 'b':
+        options.block_insts = strtoul(optarg, NULL, 0);
+        break;
+      case 'l':
+        options.level = atoi(optarg);
+        break;
+      case 'e':
+        if (!strcmp(optarg, "bb"))
+          options.encoding = PIN_TRACE_BLOCK_BB;
+        else if (!strcmp(optarg, "op"))
+          options.encoding = PIN_TRACE_BLOCK_OP_DELTA;
+        else if (!strcmp(optarg, "raw"))
+          options.encoding = PIN_TRACE_BLOCK_RAW;
+        else
+          usage(argv[0]);
+        break;
+      case 'd':
+        out_dir = optarg;
+        break;
+      case 'j':
+        jobs = atol(optarg);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (!options.block_insts || options.level < 0 || options.level > 9 || jobs < 1)
+    usage(argv[0]);
+
+  std::vector<Convert_Job> todo;
+  if (out_dir) {
+    if (argc - optind < 1)
+      usage(argv[0]);
+    if (mkdir(out_dir, 0777) && errno != EEXIST) {
+      perror(out_dir);
+      return 1;
+    }
+    for (int ii = optind; ii < argc; ii++)
+      todo.push_back({argv[ii], output_name(out_dir, argv[ii]), false, 0, 0, 0.0});
+  } else {
+    if (argc - optind != 2)
+      usage(argv[0]);
+    todo.push_back({argv[optind], argv[optind + 1], false, 0, 0, 0.0});
+  }
+
+  /* every worker takes the next unconverted trace until none are left */
+  auto start = std::chrono::steady_clock::now();
+  std::atomic<size_t> next(0);
+  std::vector<std::thread> workers;
+  for (long ii = 0; ii < std::min(jobs, (long)todo.size()); ii++) {
+    workers.emplace_back([&]() {
+      for (size_t job; (job = next++) < todo.size();)
+        convert(options, &todo[job]);
+    });
+  }
+  for (std::thread& worker : workers)
+    worker.join();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  unsigned long long num_insts = 0, out_bytes = 0;
+  size_t failed = 0;
+  for (const Convert_Job& job : todo) {
+    failed += !job.ok;
+    num_insts += job.num_insts;
+    out_bytes += job.out_bytes;
+  }
+  if (todo.size() > 1) {
+    printf("%zu of %zu traces converted: %llu instructions, %llu bytes, %.2f Minst/s over %.1f s\n",
+           todo.size() - failed, todo.size(), num_insts, out_bytes, seconds > 0 ? num_insts / seconds / 1e6 : 0.0,
+           seconds);
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,145 @@
+/* Copyright 2020 HPS/SAFARI Research Groups
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+/***************************************************************************************
+ * File         : pt_trace_to_blocks.cc
+ * Author       : HPS Research Group
+ * Date         : 10/14/2026
+ * Description  : Converts gzipped text Intel PT traces ("pc  size bytes..." per
+ *                line) into the preprocessed container read by
+ *                frontend/pt_memtrace/pt_trace_reader_pt.h.
+ ***************************************************************************************/
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "frontend/pt_memtrace/pt_trace_block.h"
+
+#define LINE_BUFFER_SIZE 256
+
+static void usage(const char* prog) {
+  fprintf(stderr,
+          "usage: %s [-b block_insts] [-l zlib_level] <input trace.gz> <output container>\n"
+          "  -b  instructions per block (default %d)\n"
+          "  -l  zlib compression level 0-9 (default 6)\n",
+          prog, PT_TRACE_BLOCK_DEFAULT_INSTS);
+  exit(1);
+}
+
+/* Parses one trace line. Returns false on a malformed line. */
+static bool parse_line(const char* line, Pt_Trace_Block_Code* code) {
+  char* end;
+  code->pc = strtoull(line, &end, 16);
+  if (end == line)
+    return false;
+  const char* pos = end;
+  unsigned long size = strtoul(pos, &end, 10);
+  if (end == pos || !size || size > PT_TRACE_BLOCK_MAX_INST_BYTES)
+    return false;
+  code->size = size;
+  for (unsigned long ii = 0; ii < size; ii++) {
+    pos = end;
+    code->inst_bytes[ii] = strtoul(pos, &end, 16);
+    if (end == pos)
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  uint32_t block_insts = PT_TRACE_BLOCK_DEFAULT_INSTS;
+  int level = 6;
+  int opt;
+  while ((opt = getopt(argc, argv, "b:l:")) != -1) {
+    switch (opt) {
+      case 'b':
+        block_insts = strtoul(optarg, NULL, 0);
+        break;
+      case 'l':
+        level = atoi(optarg);
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (!block_insts || level < 0 || level > 9 || argc - optind != 2)
+    usage(argv[0]);
+  const char* in_name = argv[optind];
+  const char* out_name = argv[optind + 1];
+  auto start = std::chrono::steady_clock::now();
+
+  gzFile in = gzopen(in_name, "rb");
+  if (!in) {
+    fprintf(stderr, "%s: %s\n", in_name, strerror(errno));
+    return 1;
+  }
+  Pt_Trace_Block_Writer* writer = pt_trace_block_writer_open(out_name, block_insts, level);
+  if (!writer) {
+    fprintf(stderr, "%s: %s\n", out_name, strerror(errno));
+    gzclose(in);
+    return 1;
+  }
+
+  char line[LINE_BUFFER_SIZE];
+  unsigned long long num_insts = 0;
+  bool error = false;
+  while (!error && gzgets(in, line, sizeof(line)) != Z_NULL) {
+    Pt_Trace_Block_Code code;
+    if (!parse_line(line, &code)) {
+      fprintf(stderr, "%s: malformed line %llu\n", in_name, num_insts + 1);
+      error = true;
+    } else if (pt_trace_block_writer_add(writer, &code)) {
+      fprintf(stderr, "%s: write failed\n", out_name);
+      error = true;
+    }
+    num_insts++;
+  }
+  int gz_error;
+  gzerror(in, &gz_error);
+  if (!error && gz_error != Z_OK && gz_error != Z_STREAM_END) {
+    fprintf(stderr, "%s: read failed\n", in_name);
+    error = true;
+  }
+  gzclose(in);
+  if (pt_trace_block_writer_close(writer) && !error) {
+    fprintf(stderr, "%s: write failed\n", out_name);
+    error = true;
+  }
+  if (error)
+    return 1;
+
+  unsigned long long out_bytes = 0;
+  FILE* out = fopen(out_name, "rb");
+  if (out && !fseek(out, 0, SEEK_END))
+    out_bytes = ftell(out);
+  if (out)
+    fclose(out);
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  printf("%s: %llu instructions in blocks of %u, %.2f bytes/inst, %.2f Minst/s\n", out_name, num_insts, block_insts,
+         num_insts ? (double)out_bytes / num_insts : 0.0, seconds > 0 ? num_insts / seconds / 1e6 : 0.0);
+  return 0;
+}
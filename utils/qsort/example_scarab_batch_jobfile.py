@@ -36,4 +36,7 @@ perfect_params = baseline_params + perfect_bp_params
 ScarabRun("Baseline", suite1, baseline_params, results_dir="./results")
 ScarabRun("Perfect",  suite1, perfect_params,  results_dir="./results")
 
-BatchManager()
\ No newline at end of file
+BatchManager()
+# To pin each simulation to a sibling core pair, admit jobs by memory and resume
+# failed batches, use instead:
+#AffinityBatchManager(memory_budget="64gb", max_retries=1)
\ No newline at end of file